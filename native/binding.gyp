@@ -1,21 +1,625 @@
 {
+  "variables": {
+    "kakarot_opus%": "<!(pkg-config --exists opus && echo 1 || echo 0)",
+    "kakarot_whisper%": "<!(pkg-config --exists whisper && echo 1 || echo 0)",
+    "kakarot_zstd%": "<!(pkg-config --exists libzstd && echo 1 || echo 0)",
+    "kakarot_universal%": "0"
+  },
+  "target_defaults": {
+    "conditions": [
+      [
+        "OS=='mac' and kakarot_universal==1",
+        {
+          "xcode_settings": {
+            "ARCHS": [ "arm64", "x86_64" ]
+          }
+        }
+      ]
+    ]
+  },
   "targets": [
     {
       "target_name": "audio_capture_native",
       "sources": [
-        "src/audio_capture_native.cc",
-        "src/aec_processor.cc"
+        "src/addon_common.cc",
+        "src/aec_processor.cc",
+        "src/aes_gcm.cc",
+        "src/audio_classifier.cc",
+        "src/audio_history.cc",
+        "src/beamformer.cc",
+        "src/bundle_exporter.cc",
+        "src/capture_session.cc",
+        "src/capture_stream.cc",
+        "src/channel_interleaver.cc",
+        "src/chunk_assembler.cc",
+        "src/clip_exporter.cc",
+        "src/cpu_dispatch.cc",
+        "src/drift_compensator.cc",
+        "src/document_text.cc",
+        "src/dsp_kernels.cc",
+        "src/dsp_module_loader.cc",
+        "src/dsp_pool.cc",
+        "src/echo_cancel_pipeline.cc",
+        "src/embedding_cache.cc",
+        "src/embedding_index.cc",
+        "src/embedding_store.cc",
+        "src/endpointer.cc",
+        "src/flac_encoder.cc",
+        "src/frame_kernels.cc",
+        "src/fuzzy_index.cc",
+        "src/hybrid_retriever.cc",
+        "src/keystroke_suppressor.cc",
+        "src/keyword_spotter.cc",
+        "src/knowledge_ingest.cc",
+        "src/latency_histogram.cc",
+        "src/latency_probe.cc",
+        "src/latency_trace.cc",
+        "src/level_analyzer.cc",
+        "src/level_meter.cc",
+        "src/lexical_index.cc",
+        "src/local_transcriber.cc",
+        "src/log_forwarder.cc",
+        "src/loudness_meter.cc",
+        "src/meeting_audio_monitor.cc",
+        "src/meeting_index.cc",
+        "src/meeting_mixer.cc",
+        "src/meeting_recorder.cc",
+        "src/memory_pressure.cc",
+        "src/native_log.cc",
+        "src/neural_denoiser.cc",
+        "src/nlms_echo_canceller.cc",
+        "src/noise_profile.cc",
+        "src/ogg_opus_writer.cc",
+        "src/performance_report.cc",
+        "src/pipeline_trace.cc",
+        "src/processing_graph.cc",
+        "src/prosody_tracker.cc",
+        "src/recording_compressor.cc",
+        "src/recording_crypto.cc",
+        "src/recording_frames.cc",
+        "src/recording_player.cc",
+        "src/recording_reader.cc",
+        "src/recording_reprocessor.cc",
+        "src/recording_segmenter.cc",
+        "src/residual_echo_detector.cc",
+        "src/session_arena.cc",
+        "src/session_capture.cc",
+        "src/session_replay.cc",
+        "src/shadow_aec.cc",
+        "src/shared_memory.cc",
+        "src/shared_ring.cc",
+        "src/silence_gate.cc",
+        "src/speaker_tracker.cc",
+        "src/spectral_analyzer.cc",
+        "src/speech_normalizer.cc",
+        "src/talk_analytics.cc",
+        "src/talk_detector.cc",
+        "src/task_scheduler.cc",
+        "src/thread_cpu.cc",
+        "src/time_stretcher.cc",
+        "src/token_counter.cc",
+        "src/transcript_aligner.cc",
+        "src/transcript_frame.cc",
+        "src/transcription_socket.cc",
+        "src/trigger_matcher.cc",
+        "src/voice_activity.cc",
+        "src/voice_verifier.cc",
+        "src/wakeup_stats.cc",
+        "src/waveform_peaks.cc",
+        "src/zip_writer.cc"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
         "webrtc/include"
       ],
+      "cflags!": [ "-fno-exceptions" ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "defines": [ "NAPI_DISABLE_CPP_EXCEPTIONS" ],
+      "conditions": [
+        [
+          "kakarot_opus==1",
+          {
+            "defines": [ "KAKAROT_HAVE_OPUS" ],
+            "cflags": [ "<!@(pkg-config --cflags opus)" ],
+            "libraries": [ "<!@(pkg-config --libs opus)" ],
+            "xcode_settings": {
+              "OTHER_CPLUSPLUSFLAGS": [ "<!@(pkg-config --cflags opus)" ]
+            }
+          }
+        ],
+        [
+          "kakarot_whisper==1",
+          {
+            "defines": [ "KAKAROT_HAVE_WHISPER" ],
+            "cflags": [ "<!@(pkg-config --cflags whisper)" ],
+            "libraries": [ "<!@(pkg-config --libs whisper)" ],
+            "xcode_settings": {
+              "OTHER_CPLUSPLUSFLAGS": [ "<!@(pkg-config --cflags whisper)" ]
+            }
+          }
+        ],
+        [
+          "OS=='mac'",
+          {
+            "sources": [
+              "src/audio_capture_native.cc",
+              "src/device_table.cc",
+              "src/document_text_apple.mm",
+              "src/output_route.cc",
+              "src/power_monitor.cc",
+              "src/system_audio_tap.mm",
+              "src/websocket_apple.mm"
+            ],
+            "libraries": [
+              "../webrtc/lib/libwebrtc.a",
+              "../webrtc/lib/libdenormal_disabler.a"
+            ],
+            "xcode_settings": {
+              "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+              "CLANG_CXX_LIBRARY": "libc++",
+              "CLANG_ENABLE_OBJC_ARC": "YES",
+              "MACOSX_DEPLOYMENT_TARGET": "12.0",
+              "OTHER_CPLUSPLUSFLAGS": [
+                "-std=c++17",
+                "-stdlib=libc++"
+              ],
+              "OTHER_LDFLAGS": [
+                "-framework Accelerate",
+                "-framework AppKit",
+                "-framework AudioToolbox",
+                "-framework CoreAudio",
+                "-framework CoreFoundation",
+                "-framework Foundation",
+                "-framework IOKit",
+                "-framework PDFKit"
+              ]
+            }
+          }
+        ],
+        [
+          "OS=='win'",
+          {
+            "sources": [
+              "src/audio_capture_native_stream.cc",
+              "src/wasapi_capture.cc",
+              "src/websocket_winhttp.cc"
+            ],
+            "libraries": [
+              "../webrtc/lib/webrtc.lib",
+              "../webrtc/lib/denormal_disabler.lib",
+              "-lavrt.lib",
+              "-lole32.lib",
+              "-lwinhttp.lib"
+            ],
+            "msvs_settings": {
+              "VCCLCompilerTool": {
+                "ExceptionHandling": 1,
+                "AdditionalOptions": [ "/std:c++17" ]
+              }
+            }
+          }
+        ],
+        [
+          "OS=='linux'",
+          {
+            "sources": [
+              "src/audio_capture_native_stream.cc",
+              "src/pipewire_capture.cc"
+            ],
+            "cflags": [
+              "<!@(pkg-config --cflags libpipewire-0.3)"
+            ],
+            "cflags_cc": [ "-std=c++17" ],
+            "libraries": [
+              "../webrtc/lib/libwebrtc.a",
+              "../webrtc/lib/libdenormal_disabler.a",
+              "<!@(pkg-config --libs libpipewire-0.3)",
+              "-lpthread"
+            ]
+          }
+        ]
+      ]
+    },
+    {
+      "target_name": "kakarot_dsp",
+      "sources": [
+        "src/dsp_module.cc"
+      ],
+      "include_dirs": [
+        "webrtc/include"
+      ],
+      "cflags!": [ "-fno-exceptions" ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "conditions": [
+        [
+          "OS=='mac'",
+          {
+            "libraries": [
+              "../webrtc/lib/libwebrtc.a"
+            ],
+            "xcode_settings": {
+              "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+              "CLANG_CXX_LIBRARY": "libc++",
+              "MACOSX_DEPLOYMENT_TARGET": "12.0",
+              "OTHER_CPLUSPLUSFLAGS": [
+                "-std=c++17",
+                "-stdlib=libc++"
+              ],
+              "OTHER_LDFLAGS": [
+                "-framework Accelerate"
+              ]
+            }
+          }
+        ],
+        [
+          "OS=='win'",
+          {
+            "libraries": [
+              "../webrtc/lib/webrtc.lib"
+            ],
+            "msvs_settings": {
+              "VCCLCompilerTool": {
+                "ExceptionHandling": 1,
+                "AdditionalOptions": [ "/std:c++17" ]
+              }
+            }
+          }
+        ],
+        [
+          "OS=='linux'",
+          {
+            "cflags_cc": [ "-std=c++17" ],
+            "ldflags": [ "-Wl,--exclude-libs,ALL" ],
+            "libraries": [
+              "../webrtc/lib/libwebrtc.a",
+              "-lpthread"
+            ]
+          }
+        ]
+      ]
+    },
+    {
+      "target_name": "kakarot_sqlite",
+      "sources": [
+        "src/sqlite_addon.cc",
+        "src/sqlite_store.cc",
+        "src/sqlite_write_queue.cc",
+        "src/transcript_codec.cc"
+      ],
+      "include_dirs": [
+        "<!@(node -p \"require('node-addon-api').include\")"
+      ],
+      "cflags!": [ "-fno-exceptions" ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "defines": [ "NAPI_DISABLE_CPP_EXCEPTIONS" ],
+      "conditions": [
+        [
+          "kakarot_zstd==1",
+          {
+            "defines": [ "KAKAROT_HAVE_ZSTD" ],
+            "cflags": [ "<!@(pkg-config --cflags libzstd)" ],
+            "libraries": [ "<!@(pkg-config --libs libzstd)" ],
+            "xcode_settings": {
+              "OTHER_CPLUSPLUSFLAGS": [ "<!@(pkg-config --cflags libzstd)" ]
+            }
+          }
+        ],
+        [
+          "OS=='mac'",
+          {
+            "xcode_settings": {
+              "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+              "CLANG_CXX_LIBRARY": "libc++",
+              "MACOSX_DEPLOYMENT_TARGET": "12.0",
+              "OTHER_CPLUSPLUSFLAGS": [
+                "-std=c++17",
+                "-stdlib=libc++"
+              ],
+              "OTHER_LDFLAGS": [
+                "-lsqlite3"
+              ]
+            }
+          }
+        ],
+        [
+          "OS=='win'",
+          {
+            "libraries": [
+              "-lwinsqlite3.lib"
+            ],
+            "msvs_settings": {
+              "VCCLCompilerTool": {
+                "ExceptionHandling": 1,
+                "AdditionalOptions": [ "/std:c++17" ]
+              }
+            }
+          }
+        ],
+        [
+          "OS=='linux'",
+          {
+            "cflags": [
+              "<!@(pkg-config --cflags sqlite3)"
+            ],
+            "cflags_cc": [ "-std=c++17" ],
+            "libraries": [
+              "<!@(pkg-config --libs sqlite3)",
+              "-lpthread"
+            ]
+          }
+        ]
+      ]
+    },
+    {
+      "target_name": "aec_replay",
+      "type": "executable",
+      "sources": [
+        "tools/aec_replay.cc",
+        "src/aec_processor.cc",
+        "src/dsp_kernels.cc",
+        "src/dsp_module.cc",
+        "src/dsp_module_loader.cc",
+        "src/frame_kernels.cc",
+        "src/latency_histogram.cc",
+        "src/latency_probe.cc",
+        "src/level_analyzer.cc",
+        "src/native_log.cc",
+        "src/nlms_echo_canceller.cc",
+        "src/noise_profile.cc",
+        "src/pipeline_trace.cc",
+        "src/residual_echo_detector.cc",
+        "src/spectral_analyzer.cc",
+        "src/speech_normalizer.cc",
+        "src/voice_activity.cc"
+      ],
+      "include_dirs": [
+        "src",
+        "webrtc/include"
+      ],
       "libraries": [
         "../webrtc/lib/libwebrtc.a"
       ],
       "cflags!": [ "-fno-exceptions" ],
       "cflags_cc!": [ "-fno-exceptions" ],
-      "defines": [ "NAPI_DISABLE_CPP_EXCEPTIONS" ],
+      "defines": [ "KAKAROT_DSP_STATIC" ],
+      "xcode_settings": {
+        "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+        "CLANG_CXX_LIBRARY": "libc++",
+        "MACOSX_DEPLOYMENT_TARGET": "12.0",
+        "OTHER_CPLUSPLUSFLAGS": [
+          "-std=c++17",
+          "-stdlib=libc++"
+        ],
+        "OTHER_LDFLAGS": [
+          "-framework Accelerate"
+        ]
+      }
+    },
+    {
+      "target_name": "aec_quality",
+      "type": "executable",
+      "sources": [
+        "tools/aec_quality.cc",
+        "src/aec_processor.cc",
+        "src/dsp_kernels.cc",
+        "src/dsp_module.cc",
+        "src/dsp_module_loader.cc",
+        "src/frame_kernels.cc",
+        "src/latency_histogram.cc",
+        "src/latency_probe.cc",
+        "src/level_analyzer.cc",
+        "src/native_log.cc",
+        "src/nlms_echo_canceller.cc",
+        "src/noise_profile.cc",
+        "src/pipeline_trace.cc",
+        "src/residual_echo_detector.cc",
+        "src/spectral_analyzer.cc",
+        "src/speech_normalizer.cc",
+        "src/voice_activity.cc"
+      ],
+      "include_dirs": [
+        "src",
+        "webrtc/include"
+      ],
+      "libraries": [
+        "../webrtc/lib/libwebrtc.a"
+      ],
+      "cflags!": [ "-fno-exceptions" ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "defines": [ "KAKAROT_DSP_STATIC" ],
+      "xcode_settings": {
+        "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+        "CLANG_CXX_LIBRARY": "libc++",
+        "MACOSX_DEPLOYMENT_TARGET": "12.0",
+        "OTHER_CPLUSPLUSFLAGS": [
+          "-std=c++17",
+          "-stdlib=libc++"
+        ],
+        "OTHER_LDFLAGS": [
+          "-framework Accelerate"
+        ]
+      }
+    },
+    {
+      "target_name": "audio_bench",
+      "type": "executable",
+      "sources": [
+        "tools/audio_bench.cc",
+        "src/aec_processor.cc",
+        "src/dsp_kernels.cc",
+        "src/dsp_module.cc",
+        "src/dsp_module_loader.cc",
+        "src/frame_kernels.cc",
+        "src/latency_histogram.cc",
+        "src/latency_probe.cc",
+        "src/level_analyzer.cc",
+        "src/native_log.cc",
+        "src/nlms_echo_canceller.cc",
+        "src/noise_profile.cc",
+        "src/pipeline_trace.cc",
+        "src/residual_echo_detector.cc",
+        "src/spectral_analyzer.cc",
+        "src/speech_normalizer.cc",
+        "src/voice_activity.cc"
+      ],
+      "include_dirs": [
+        "src",
+        "webrtc/include"
+      ],
+      "libraries": [
+        "../webrtc/lib/libwebrtc.a",
+        "../webrtc/lib/libdenormal_disabler.a"
+      ],
+      "cflags!": [ "-fno-exceptions" ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "defines": [ "KAKAROT_DSP_STATIC" ],
+      "xcode_settings": {
+        "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+        "CLANG_CXX_LIBRARY": "libc++",
+        "MACOSX_DEPLOYMENT_TARGET": "12.0",
+        "OTHER_CPLUSPLUSFLAGS": [
+          "-std=c++17",
+          "-stdlib=libc++"
+        ],
+        "OTHER_LDFLAGS": [
+          "-framework Accelerate",
+          "-framework AudioToolbox"
+        ]
+      }
+    },
+    {
+      "target_name": "session_load",
+      "type": "executable",
+      "sources": [
+        "tools/session_load.cc",
+        "src/aec_processor.cc",
+        "src/aes_gcm.cc",
+        "src/chunk_assembler.cc",
+        "src/dsp_kernels.cc",
+        "src/dsp_module.cc",
+        "src/dsp_module_loader.cc",
+        "src/frame_kernels.cc",
+        "src/keystroke_suppressor.cc",
+        "src/keyword_spotter.cc",
+        "src/latency_histogram.cc",
+        "src/latency_probe.cc",
+        "src/level_analyzer.cc",
+        "src/loudness_meter.cc",
+        "src/meeting_recorder.cc",
+        "src/native_log.cc",
+        "src/neural_denoiser.cc",
+        "src/nlms_echo_canceller.cc",
+        "src/noise_profile.cc",
+        "src/ogg_opus_writer.cc",
+        "src/pipeline_trace.cc",
+        "src/processing_graph.cc",
+        "src/recording_crypto.cc",
+        "src/recording_reader.cc",
+        "src/residual_echo_detector.cc",
+        "src/spectral_analyzer.cc",
+        "src/speech_normalizer.cc",
+        "src/thread_cpu.cc",
+        "src/voice_activity.cc",
+        "src/wakeup_stats.cc",
+        "src/waveform_peaks.cc"
+      ],
+      "include_dirs": [
+        "src",
+        "webrtc/include"
+      ],
+      "libraries": [
+        "../webrtc/lib/libwebrtc.a",
+        "../webrtc/lib/libdenormal_disabler.a"
+      ],
+      "cflags!": [ "-fno-exceptions" ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "defines": [ "KAKAROT_DSP_STATIC" ],
+      "conditions": [
+        [
+          "kakarot_opus==1",
+          {
+            "defines": [ "KAKAROT_HAVE_OPUS" ],
+            "cflags": [ "<!@(pkg-config --cflags opus)" ],
+            "libraries": [ "<!@(pkg-config --libs opus)" ],
+            "xcode_settings": {
+              "OTHER_CPLUSPLUSFLAGS": [ "<!@(pkg-config --cflags opus)" ]
+            }
+          }
+        ]
+      ],
+      "xcode_settings": {
+        "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+        "CLANG_CXX_LIBRARY": "libc++",
+        "MACOSX_DEPLOYMENT_TARGET": "12.0",
+        "OTHER_CPLUSPLUSFLAGS": [
+          "-std=c++17",
+          "-stdlib=libc++"
+        ],
+        "OTHER_LDFLAGS": [
+          "-framework Accelerate"
+        ]
+      }
+    },
+    {
+      "target_name": "pipeline_stress",
+      "type": "executable",
+      "sources": [
+        "tools/pipeline_stress.cc",
+        "src/aec_processor.cc",
+        "src/aes_gcm.cc",
+        "src/chunk_assembler.cc",
+        "src/dsp_kernels.cc",
+        "src/dsp_module.cc",
+        "src/dsp_module_loader.cc",
+        "src/frame_kernels.cc",
+        "src/keystroke_suppressor.cc",
+        "src/keyword_spotter.cc",
+        "src/latency_histogram.cc",
+        "src/latency_probe.cc",
+        "src/level_analyzer.cc",
+        "src/loudness_meter.cc",
+        "src/meeting_recorder.cc",
+        "src/native_log.cc",
+        "src/neural_denoiser.cc",
+        "src/nlms_echo_canceller.cc",
+        "src/noise_profile.cc",
+        "src/ogg_opus_writer.cc",
+        "src/pipeline_trace.cc",
+        "src/processing_graph.cc",
+        "src/recording_crypto.cc",
+        "src/recording_reader.cc",
+        "src/residual_echo_detector.cc",
+        "src/spectral_analyzer.cc",
+        "src/speech_normalizer.cc",
+        "src/thread_cpu.cc",
+        "src/voice_activity.cc",
+        "src/wakeup_stats.cc",
+        "src/waveform_peaks.cc"
+      ],
+      "include_dirs": [
+        "src",
+        "webrtc/include"
+      ],
+      "libraries": [
+        "../webrtc/lib/libwebrtc.a",
+        "../webrtc/lib/libdenormal_disabler.a"
+      ],
+      "cflags!": [ "-fno-exceptions" ],
+      "cflags_cc!": [ "-fno-exceptions" ],
+      "defines": [ "KAKAROT_DSP_STATIC" ],
+      "conditions": [
+        [
+          "kakarot_opus==1",
+          {
+            "defines": [ "KAKAROT_HAVE_OPUS" ],
+            "cflags": [ "<!@(pkg-config --cflags opus)" ],
+            "libraries": [ "<!@(pkg-config --libs opus)" ],
+            "xcode_settings": {
+              "OTHER_CPLUSPLUSFLAGS": [ "<!@(pkg-config --cflags opus)" ]
+            }
+          }
+        ]
+      ],
       "xcode_settings": {
         "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
         "CLANG_CXX_LIBRARY": "libc++",
@@ -25,9 +629,7 @@
           "-stdlib=libc++"
         ],
         "OTHER_LDFLAGS": [
-          "-framework AudioToolbox",
-          "-framework CoreAudio",
-          "-framework CoreFoundation"
+          "-framework Accelerate"
         ]
       }
     }
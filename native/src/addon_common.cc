@@ -0,0 +1,4271 @@
+#include "addon_common.h"
+#include "bundle_exporter.h"
+#include "capture_stream.h"
+#include "channel_interleaver.h"
+#include "clip_exporter.h"
+#include "cpu_dispatch.h"
+#include "dsp_module.h"
+#include "embedding_cache.h"
+#include "embedding_index.h"
+#include "embedding_store.h"
+#include "fuzzy_index.h"
+#include "hybrid_retriever.h"
+#include "knowledge_ingest.h"
+#include "lexical_index.h"
+#include "local_transcriber.h"
+#include "log_forwarder.h"
+#include "loudness_meter.h"
+#include "meeting_index.h"
+#include "meeting_recorder.h"
+#include "memory_pressure.h"
+#include "native_log.h"
+#include "pipeline_trace.h"
+#include "processing_graph.h"
+#include "recording_compressor.h"
+#include "recording_crypto.h"
+#include "recording_player.h"
+#include "recording_reader.h"
+#include "recording_reprocessor.h"
+#include "recording_segmenter.h"
+#include "session_capture.h"
+#include "session_arena.h"
+#include "session_replay.h"
+#include "shared_ring.h"
+#include "talk_analytics.h"
+#include "task_scheduler.h"
+#include "token_counter.h"
+#include "thread_cpu.h"
+#include "transcription_socket.h"
+#include "transcript_aligner.h"
+#include "trigger_matcher.h"
+#include "wakeup_stats.h"
+#include "waveform_peaks.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kakarot {
+
+static const struct {
+    const char* name;
+    AECPreset preset;
+} kPresetNames[] = {
+    { "aggressive", AECPreset::kAggressive },
+    { "default", AECPreset::kDefault },
+    { "lowCpu", AECPreset::kLowCpu },
+    { "headphones", AECPreset::kHeadphones },
+};
+
+static const char* const kNsLevelNames[] = { "low", "moderate", "high", "veryHigh" };
+
+// AECMetrics::governor_level, cheapest last
+static const char* const kGovernorLevelNames[] = { "full", "noAgc", "lightNs", "shortFilters", "wideband" };
+
+// ProcessingGraph biquad filter names
+static const struct {
+    const char* name;
+    BiquadKind kind;
+} kBiquadNames[] = {
+    { "lowpass", BiquadKind::kLowPass },
+    { "highpass", BiquadKind::kHighPass },
+    { "bandpass", BiquadKind::kBandPass },
+    { "peaking", BiquadKind::kPeaking },
+    { "lowshelf", BiquadKind::kLowShelf },
+    { "highshelf", BiquadKind::kHighShelf },
+};
+
+// Opus bitrate range, bits/s: the graph stage and compressRecording()
+static constexpr double kMinOpusBitrate = 6000.0;
+static constexpr double kMaxOpusBitrate = 128000.0;
+
+// normalizeTargetDbfs range; the limiter owns the last dB below full scale
+static constexpr double kMinNormalizeTargetDbfs = -40.0;
+static constexpr double kMaxNormalizeTargetDbfs = -1.0;
+
+// startPerformanceReport() sampling period by default
+static constexpr double kPerformanceIntervalMs = 1000.0;
+
+static const struct {
+    const char* name;
+    PowerProfile profile;
+} kPowerProfileNames[] = {
+    { "normal", PowerProfile::kNormal },
+    { "lowPower", PowerProfile::kLowPower },
+    { "auto", PowerProfile::kAuto },
+};
+
+bool ParsePowerProfile(const Napi::Value& value, PowerProfile* profile) {
+    if (!value.IsString()) {
+        return false;
+    }
+    std::string name = value.As<Napi::String>().Utf8Value();
+    for (const auto& entry : kPowerProfileNames) {
+        if (name == entry.name) {
+            *profile = entry.profile;
+            return true;
+        }
+    }
+    return false;
+}
+
+static const char* PresetName(AECPreset preset) {
+    for (const auto& entry : kPresetNames) {
+        if (entry.preset == preset) {
+            return entry.name;
+        }
+    }
+    return "aggressive";
+}
+
+AECConfig ParseAECConfig(const Napi::Value& value, const AECConfig& base) {
+    AECConfig config = base;
+    if (!value.IsObject()) {
+        return config;
+    }
+    Napi::Object options = value.As<Napi::Object>();
+
+    if (options.Has("preset") && options.Get("preset").IsString()) {
+        std::string name = options.Get("preset").As<Napi::String>().Utf8Value();
+        for (const auto& entry : kPresetNames) {
+            if (name == entry.name) {
+                config = ApplyPresetDefaults(config, entry.preset);
+            }
+        }
+    }
+    if (options.Has("enableAec") && options.Get("enableAec").IsBoolean()) {
+        config.enable_aec = options.Get("enableAec").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("enableNs") && options.Get("enableNs").IsBoolean()) {
+        config.enable_ns = options.Get("enableNs").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("enableAgc") && options.Get("enableAgc").IsBoolean()) {
+        config.enable_agc = options.Get("enableAgc").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("nsLevel") && options.Get("nsLevel").IsString()) {
+        std::string name = options.Get("nsLevel").As<Napi::String>().Utf8Value();
+        for (int level = 0; level < 4; ++level) {
+            if (name == kNsLevelNames[level]) {
+                config.ns_level = level;
+            }
+        }
+    }
+    if (options.Has("processingSampleRate") && options.Get("processingSampleRate").IsNumber()) {
+        config.processing_sample_rate = options.Get("processingSampleRate").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("adaptiveSuppression") && options.Get("adaptiveSuppression").IsBoolean()) {
+        config.adaptive_suppression = options.Get("adaptiveSuppression").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("cpuGovernor") && options.Get("cpuGovernor").IsBoolean()) {
+        config.cpu_governor = options.Get("cpuGovernor").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("normalizeSpeech") && options.Get("normalizeSpeech").IsBoolean()) {
+        config.normalize_speech = options.Get("normalizeSpeech").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("normalizeTargetDbfs") && options.Get("normalizeTargetDbfs").IsNumber()) {
+        double target = options.Get("normalizeTargetDbfs").As<Napi::Number>().DoubleValue();
+        config.normalize_target_dbfs = static_cast<float>(std::max(kMinNormalizeTargetDbfs, std::min(target, kMaxNormalizeTargetDbfs)));
+    }
+    // warmStart: a getAecProfile() result replaces the seed whole; null clears it
+    if (options.Has("warmStart") && (options.Get("warmStart").IsObject() || options.Get("warmStart").IsNull())) {
+        config.warm_start = ParseAECWarmStart(options.Get("warmStart"));
+    }
+    // noiseProfile: a getNoiseProfile() result; null clears it
+    if (options.Has("noiseProfile")) {
+        NoiseProfile profile;
+        if (options.Get("noiseProfile").IsNull()) {
+            config.noise_profile.reset();
+        } else if (ParseNoiseProfile(options.Get("noiseProfile"), &profile)) {
+            config.noise_profile = profile;
+        }
+    }
+    return config;
+}
+
+AECWarmStart ParseAECWarmStart(const Napi::Value& value) {
+    AECWarmStart warm_start;
+    if (!value.IsObject()) {
+        return warm_start;
+    }
+    Napi::Object profile = value.As<Napi::Object>();
+    if (profile.Get("echoDelayMs").IsNumber()) {
+        warm_start.echo_delay_ms = profile.Get("echoDelayMs").As<Napi::Number>().Int32Value();
+    }
+    if (profile.Get("streamDelayMs").IsNumber()) {
+        warm_start.stream_delay_ms = profile.Get("streamDelayMs").As<Napi::Number>().Int32Value();
+    }
+    if (profile.Get("preset").IsString()) {
+        std::string name = profile.Get("preset").As<Napi::String>().Utf8Value();
+        for (const auto& entry : kPresetNames) {
+            if (name == entry.name) {
+                warm_start.preset = entry.preset;
+            }
+        }
+    }
+    return warm_start;
+}
+
+Napi::Object AECWarmStartToObject(Napi::Env env, const AECWarmStart& warm_start) {
+    Napi::Object result = Napi::Object::New(env);
+    if (warm_start.echo_delay_ms) {
+        result.Set("echoDelayMs", Napi::Number::New(env, *warm_start.echo_delay_ms));
+    }
+    if (warm_start.stream_delay_ms) {
+        result.Set("streamDelayMs", Napi::Number::New(env, *warm_start.stream_delay_ms));
+    }
+    if (warm_start.preset) {
+        result.Set("preset", Napi::String::New(env, PresetName(*warm_start.preset)));
+    }
+    return result;
+}
+
+bool ParseNoiseProfile(const Napi::Value& value, NoiseProfile* profile) {
+    if (!value.IsObject()) {
+        return false;
+    }
+    Napi::Object object = value.As<Napi::Object>();
+    if (!object.Get("noiseFloor").IsNumber() || !object.Get("bandsDb").IsArray()) {
+        return false;
+    }
+    Napi::Array bands = object.Get("bandsDb").As<Napi::Array>();
+    if (bands.Length() != kNoiseBands) {
+        return false;
+    }
+    NoiseProfile parsed;
+    parsed.noise_floor = std::max(0.0f, object.Get("noiseFloor").As<Napi::Number>().FloatValue());
+    for (uint32_t b = 0; b < kNoiseBands; ++b) {
+        Napi::Value level = bands.Get(b);
+        if (!level.IsNumber() || !std::isfinite(level.As<Napi::Number>().DoubleValue())) {
+            return false;
+        }
+        parsed.bands_db[b] = level.As<Napi::Number>().FloatValue();
+    }
+    if (object.Get("frames").IsNumber()) {
+        parsed.frames = object.Get("frames").As<Napi::Number>().Uint32Value();
+    }
+    *profile = parsed;
+    return true;
+}
+
+Napi::Object NoiseProfileToObject(Napi::Env env, const NoiseProfile& profile) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("noiseFloor", Napi::Number::New(env, profile.noise_floor));
+    Napi::Array bands = Napi::Array::New(env, kNoiseBands);
+    for (uint32_t b = 0; b < kNoiseBands; ++b) {
+        bands.Set(b, Napi::Number::New(env, profile.bands_db[b]));
+    }
+    result.Set("bandsDb", bands);
+    result.Set("frames", Napi::Number::New(env, profile.frames));
+    return result;
+}
+
+std::vector<AECProfileTable::Entry> ParseAECProfiles(const Napi::Value& value) {
+    std::vector<AECProfileTable::Entry> entries;
+    if (!value.IsArray()) {
+        return entries;
+    }
+    Napi::Array list = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < list.Length(); ++i) {
+        Napi::Value item = list.Get(i);
+        if (!item.IsObject()) {
+            continue;
+        }
+        Napi::Object profile = item.As<Napi::Object>();
+        if (!profile.Get("inputDeviceUid").IsString() || !profile.Get("outputDeviceUid").IsString()) {
+            continue;
+        }
+        entries.push_back({ profile.Get("inputDeviceUid").As<Napi::String>().Utf8Value(),
+                            profile.Get("outputDeviceUid").As<Napi::String>().Utf8Value(),
+                            ParseAECWarmStart(profile) });
+    }
+    return entries;
+}
+
+Napi::Object AECConfigStatusToObject(Napi::Env env, const AECConfigStatus& status) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("posted", Napi::Number::New(env, static_cast<double>(status.posted)));
+    result.Set("applied", Napi::Number::New(env, static_cast<double>(status.applied)));
+    result.Set("rejected", Napi::Number::New(env, static_cast<double>(status.rejected)));
+    result.Set("pending", Napi::Boolean::New(env, status.posted > std::max(status.applied, status.rejected)));
+    result.Set("appliedFrame", Napi::Number::New(env, static_cast<double>(status.applied_frame)));
+    result.Set("latencyMs", Napi::Number::New(env, status.latency_ms));
+    return result;
+}
+
+Napi::Object AECConfigToObject(Napi::Env env, const AECConfig& config) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("preset", Napi::String::New(env, PresetName(config.preset)));
+    result.Set("enableAec", Napi::Boolean::New(env, config.enable_aec));
+    result.Set("enableNs", Napi::Boolean::New(env, config.enable_ns));
+    result.Set("nsLevel", Napi::String::New(env, kNsLevelNames[std::max(0, std::min(config.ns_level, 3))]));
+    result.Set("enableAgc", Napi::Boolean::New(env, config.enable_agc));
+    result.Set("processingSampleRate", Napi::Number::New(env, config.processing_sample_rate));
+    result.Set("adaptiveSuppression", Napi::Boolean::New(env, config.adaptive_suppression));
+    result.Set("cpuGovernor", Napi::Boolean::New(env, config.cpu_governor));
+    result.Set("normalizeSpeech", Napi::Boolean::New(env, config.normalize_speech));
+    result.Set("normalizeTargetDbfs", Napi::Number::New(env, config.normalize_target_dbfs));
+    return result;
+}
+
+static Napi::Object CallStatsToObject(Napi::Env env, const AECCallStats& calls) {
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("frames", Napi::Number::New(env, static_cast<double>(calls.frames)));
+    stats.Set("errors", Napi::Number::New(env, static_cast<double>(calls.errors)));
+    stats.Set("deadlineMisses", Napi::Number::New(env, static_cast<double>(calls.deadline_misses)));
+    stats.Set("deadlineMissFraction", Napi::Number::New(env, calls.frames > 0
+        ? static_cast<double>(calls.deadline_misses) / calls.frames : 0.0));
+    stats.Set("p50Us", Napi::Number::New(env, calls.p50_us));
+    stats.Set("p95Us", Napi::Number::New(env, calls.p95_us));
+    stats.Set("p99Us", Napi::Number::New(env, calls.p99_us));
+    stats.Set("maxUs", Napi::Number::New(env, calls.max_us));
+    return stats;
+}
+
+Napi::Object AECMetricsToObject(Napi::Env env, const AECMetrics& metrics) {
+    Napi::Object result = Napi::Object::New(env);
+    // Statistics the APM has not produced yet are left off the object
+    auto setIf = [&](const char* key, const auto& value) {
+        if (value) {
+            result.Set(key, Napi::Number::New(env, *value));
+        }
+    };
+    setIf("echoReturnLoss", metrics.echo_return_loss);
+    setIf("echoReturnLossEnhancement", metrics.echo_return_loss_enhancement);
+    setIf("divergentFilterFraction", metrics.divergent_filter_fraction);
+    setIf("residualEchoLikelihood", metrics.residual_echo_likelihood);
+    setIf("residualEchoLikelihoodRecentMax", metrics.residual_echo_likelihood_recent_max);
+    setIf("renderDelayMs", metrics.render_delay_ms);
+    setIf("delayMedianMs", metrics.delay_median_ms);
+    setIf("delayStdMs", metrics.delay_std_ms);
+    setIf("renderDriftPpm", metrics.render_drift_ppm);
+    result.Set("streamDelayMs", Napi::Number::New(env, metrics.stream_delay_ms));
+    result.Set("processingSampleRate", Napi::Number::New(env, metrics.processing_sample_rate));
+    result.Set("processingLoad", Napi::Number::New(env, metrics.processing_load));
+    result.Set("bypassed", metrics.bypassed);
+    if (metrics.adaptive_suppression) {
+        result.Set("suppressionLevel", Napi::String::New(env, metrics.suppression_level ? "aggressive" : "default"));
+    }
+    if (metrics.cpu_governor) {
+        result.Set("governorLevel", Napi::String::New(env, kGovernorLevelNames[std::max(0, std::min(metrics.governor_level, 4))]));
+        result.Set("governorTransitions", Napi::Number::New(env, static_cast<double>(metrics.governor_transitions)));
+    }
+    if (metrics.normalize_speech) {
+        result.Set("normalizerGainDb", Napi::Number::New(env, metrics.normalizer_gain_db));
+        setIf("speechLevelDbfs", metrics.speech_level_dbfs);
+        result.Set("clippingPredictions", Napi::Number::New(env, static_cast<double>(metrics.clipping_predictions)));
+    }
+    result.Set("echoPathResets", Napi::Number::New(env, static_cast<double>(metrics.echo_path_resets)));
+    if (metrics.echo_path_resets > 0) {
+        result.Set("echoPathChange", Napi::String::New(env, EchoPathChangeName(metrics.echo_path_change)));
+        result.Set("echoPathReconverging", metrics.echo_path_reconverging);
+        setIf("echoPathReconvergeMs", metrics.echo_path_reconverge_ms);
+        setIf("echoPathLeakageDb", metrics.echo_path_leakage_db);
+    }
+    result.Set("outputLatencySamples", Napi::Number::New(env, metrics.output_latency_samples));
+    result.Set("outputLatencyMs", Napi::Number::New(env, metrics.output_latency_ms));
+    result.Set("captureCalls", CallStatsToObject(env, metrics.capture_calls));
+    result.Set("renderCalls", CallStatsToObject(env, metrics.render_calls));
+    result.Set("aecConverged", metrics.aec_converged);
+    result.Set("rmsLevel", metrics.rms_level);
+    result.Set("peakLevel", metrics.peak_level);
+    result.Set("noiseFloor", metrics.noise_floor);
+    result.Set("speech", metrics.speech);
+    return result;
+}
+
+static Napi::Object ShadowAecSideToObject(Napi::Env env, const ShadowAecSide& side) {
+    Napi::Object result = Napi::Object::New(env);
+    if (side.erle_db) {
+        result.Set("erleDb", Napi::Number::New(env, *side.erle_db));
+    }
+    if (side.leakage_db) {
+        result.Set("leakageDb", Napi::Number::New(env, *side.leakage_db));
+    }
+    if (side.residual_echo_likelihood) {
+        result.Set("residualEchoLikelihood", Napi::Number::New(env, *side.residual_echo_likelihood));
+    }
+    result.Set("convergedFraction", Napi::Number::New(env, side.converged_fraction));
+    result.Set("processingLoad", Napi::Number::New(env, side.processing_load));
+    result.Set("captureCalls", CallStatsToObject(env, side.capture_calls));
+    return result;
+}
+
+Napi::Object ShadowAecComparisonToObject(Napi::Env env, const ShadowAecComparison& comparison) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("running", comparison.running);
+    result.Set("candidate", AECConfigToObject(env, comparison.candidate));
+    result.Set("maxLoad", Napi::Number::New(env, comparison.max_load));
+    result.Set("secondsProcessed", Napi::Number::New(env, static_cast<double>(comparison.seconds_processed)));
+    result.Set("secondsCompared", Napi::Number::New(env, static_cast<double>(comparison.seconds_compared)));
+    result.Set("secondsSkipped", Napi::Number::New(env, static_cast<double>(comparison.seconds_skipped)));
+    result.Set("framesDropped", Napi::Number::New(env, static_cast<double>(comparison.frames_dropped)));
+    result.Set("cpuLoad", Napi::Number::New(env, comparison.cpu_load));
+    result.Set("live", ShadowAecSideToObject(env, comparison.live));
+    result.Set("shadow", ShadowAecSideToObject(env, comparison.shadow));
+    return result;
+}
+
+Napi::Object MeetingAudioEventToObject(Napi::Env env, const MeetingAudioEvent& event) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("speechSeconds", Napi::Number::New(env, event.speech_seconds));
+    result.Set("windowSeconds", Napi::Number::New(env, event.window_seconds));
+    result.Set("speechRuns", Napi::Number::New(env, event.speech_runs));
+    result.Set("confidence", Napi::Number::New(env, event.confidence));
+    return result;
+}
+
+Napi::Object MeetingAudioMonitorStatsToObject(Napi::Env env, const MeetingAudioMonitorStats& stats) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("running", stats.running);
+    result.Set("armed", stats.armed);
+    result.Set("secondsHeard", Napi::Number::New(env, static_cast<double>(stats.seconds_heard)));
+    result.Set("secondsAnalyzed", Napi::Number::New(env, static_cast<double>(stats.seconds_analyzed)));
+    result.Set("secondsSilent", Napi::Number::New(env, static_cast<double>(stats.seconds_silent)));
+    result.Set("secondsSpeech", Napi::Number::New(env, static_cast<double>(stats.seconds_speech)));
+    result.Set("events", Napi::Number::New(env, static_cast<double>(stats.events)));
+    result.Set("wakeups", Napi::Number::New(env, static_cast<double>(stats.wakeups)));
+    result.Set("framesDropped", Napi::Number::New(env, static_cast<double>(stats.frames_dropped)));
+    result.Set("windowSpeechSeconds", Napi::Number::New(env, stats.window_speech_seconds));
+    result.Set("cpuLoad", Napi::Number::New(env, stats.cpu_load));
+    return result;
+}
+
+bool ParseKeywordSpecs(const Napi::Value& value, std::vector<KeywordSpec>* keywords, std::string* error) {
+    if (!value.IsArray()) {
+        *error = "keywords must be an array";
+        return false;
+    }
+    Napi::Array array = value.As<Napi::Array>();
+    keywords->clear();
+    for (uint32_t i = 0; i < array.Length(); ++i) {
+        Napi::Value entry = array.Get(i);
+        KeywordSpec keyword;
+        if (entry.IsString()) {
+            keyword.text = entry.As<Napi::String>().Utf8Value();
+        } else if (entry.IsObject() && entry.As<Napi::Object>().Get("text").IsString()) {
+            Napi::Object object = entry.As<Napi::Object>();
+            keyword.text = object.Get("text").As<Napi::String>().Utf8Value();
+            if (object.Get("threshold").IsNumber()) {
+                keyword.threshold = object.Get("threshold").As<Napi::Number>().FloatValue();
+            }
+        } else {
+            *error = "keywords[" + std::to_string(i) + "] must be a string or { text, threshold? }";
+            return false;
+        }
+        keywords->push_back(std::move(keyword));
+    }
+    return true;
+}
+
+Napi::Object KeywordEventToObject(Napi::Env env, const KeywordEvent& event) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("keyword", Napi::String::New(env, event.text));
+    result.Set("index", Napi::Number::New(env, static_cast<double>(event.keyword)));
+    result.Set("confidence", Napi::Number::New(env, event.confidence));
+    result.Set("startMs", Napi::Number::New(env, event.start_ms));
+    result.Set("endMs", Napi::Number::New(env, event.end_ms));
+    result.Set("detectedMs", Napi::Number::New(env, event.detected_ms));
+    return result;
+}
+
+Napi::Object KeywordSpotterStatsToObject(Napi::Env env, const KeywordSpotterStats& stats) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("running", stats.running);
+    result.Set("keywords", Napi::Number::New(env, stats.keywords));
+    result.Set("graphStates", Napi::Number::New(env, stats.graph_states));
+    result.Set("frames", Napi::Number::New(env, static_cast<double>(stats.frames)));
+    result.Set("framesDropped", Napi::Number::New(env, static_cast<double>(stats.frames_dropped)));
+    result.Set("events", Napi::Number::New(env, static_cast<double>(stats.events)));
+    result.Set("meanLatencyMs", Napi::Number::New(env, stats.mean_latency_ms));
+    result.Set("cpuLoad", Napi::Number::New(env, stats.cpu_load));
+    return result;
+}
+
+Napi::Object VoiceVerifierStatsToObject(Napi::Env env, const VoiceVerifierStats& stats) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("enrolled", stats.enrolled);
+    result.Set("enrolling", stats.enrolling);
+    result.Set("enrollmentSeconds", Napi::Number::New(env, stats.enrollment_seconds));
+    result.Set("utterances", Napi::Number::New(env, static_cast<double>(stats.utterances)));
+    result.Set("accepted", Napi::Number::New(env, static_cast<double>(stats.accepted)));
+    result.Set("rejected", Napi::Number::New(env, static_cast<double>(stats.rejected)));
+    result.Set("framesHeld", Napi::Number::New(env, static_cast<double>(stats.frames_held)));
+    result.Set("lastScore", Napi::Number::New(env, stats.last_score));
+    result.Set("threshold", Napi::Number::New(env, stats.threshold));
+    return result;
+}
+
+Napi::Object CaptureStatsToObject(Napi::Env env, const CaptureStats& stats, const HostClock& clock) {
+    uint64_t callbacks = stats.callbacks.load(std::memory_order_relaxed);
+    uint64_t intervals = callbacks > 1 ? callbacks - 1 : 0;
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("callbacks", Napi::Number::New(env, static_cast<double>(callbacks)));
+    result.Set("buffersCaptured", Napi::Number::New(env, static_cast<double>(stats.buffers_captured.load(std::memory_order_relaxed))));
+    result.Set("buffersDropped", Napi::Number::New(env, static_cast<double>(stats.buffers_dropped.load(std::memory_order_relaxed))));
+    result.Set("buffersOversized", Napi::Number::New(env, static_cast<double>(stats.buffers_oversized.load(std::memory_order_relaxed))));
+    result.Set("deliveries", Napi::Number::New(env, static_cast<double>(stats.deliveries.load(std::memory_order_relaxed))));
+    result.Set("tsfnRejections", Napi::Number::New(env, static_cast<double>(stats.tsfn_rejections.load(std::memory_order_relaxed))));
+    result.Set("deliveriesDropped", Napi::Number::New(env, static_cast<double>(stats.deliveries_dropped.load(std::memory_order_relaxed))));
+    result.Set("deliveriesCoalesced", Napi::Number::New(env, static_cast<double>(stats.deliveries_coalesced.load(std::memory_order_relaxed))));
+    result.Set("consumerBlocks", Napi::Number::New(env, static_cast<double>(stats.consumer_blocks.load(std::memory_order_relaxed))));
+    result.Set("queuePeak", Napi::Number::New(env, static_cast<double>(stats.queue_peak.load(std::memory_order_relaxed))));
+    result.Set("subscriberDeliveries", Napi::Number::New(env, static_cast<double>(stats.subscriber_deliveries.load(std::memory_order_relaxed))));
+    result.Set("subscriberDropped", Napi::Number::New(env, static_cast<double>(stats.subscriber_dropped.load(std::memory_order_relaxed))));
+    result.Set("subscriberCoalesced", Napi::Number::New(env, static_cast<double>(stats.subscriber_coalesced.load(std::memory_order_relaxed))));
+    result.Set("overloads", Napi::Number::New(env, static_cast<double>(stats.overloads.load(std::memory_order_relaxed))));
+    result.Set("framesGated", Napi::Number::New(env, static_cast<double>(stats.frames_gated.load(std::memory_order_relaxed))));
+    result.Set("keystrokesDucked", Napi::Number::New(env, static_cast<double>(stats.keystrokes_ducked.load(std::memory_order_relaxed))));
+    uint64_t denoise_frames = stats.denoise_frames.load(std::memory_order_relaxed);
+    result.Set("denoiseMeanUs", Napi::Number::New(env, denoise_frames > 0
+        ? clock.TicksToMs(stats.denoise_ticks.load(std::memory_order_relaxed)) * 1000.0 / denoise_frames : 0.0));
+    result.Set("renderGaps", Napi::Number::New(env, static_cast<double>(stats.render_gaps.load(std::memory_order_relaxed))));
+    result.Set("renderFramesConcealed", Napi::Number::New(env, static_cast<double>(stats.render_frames_concealed.load(std::memory_order_relaxed))));
+    result.Set("renderFramesDropped", Napi::Number::New(env, static_cast<double>(stats.render_frames_dropped.load(std::memory_order_relaxed))));
+    result.Set("ioBufferFrames", Napi::Number::New(env, static_cast<double>(stats.io_buffer_frames.load(std::memory_order_relaxed))));
+    result.Set("deviceChannels", Napi::Number::New(env, static_cast<double>(stats.device_channels.load(std::memory_order_relaxed))));
+    result.Set("maxCallbackIntervalMs", Napi::Number::New(env, clock.TicksToMs(stats.interval_max_ticks.load(std::memory_order_relaxed))));
+    result.Set("avgCallbackIntervalMs", Napi::Number::New(env, intervals > 0
+        ? clock.TicksToMs(stats.interval_sum_ticks.load(std::memory_order_relaxed)) / intervals : 0.0));
+    result.Set("maxCallbackDurationMs", Napi::Number::New(env, clock.TicksToMs(stats.duration_max_ticks.load(std::memory_order_relaxed))));
+    result.Set("avgCallbackDurationMs", Napi::Number::New(env, callbacks > 0
+        ? clock.TicksToMs(stats.duration_sum_ticks.load(std::memory_order_relaxed)) / callbacks : 0.0));
+    result.Set("startToFirstCallbackMs", Napi::Number::New(env, clock.TicksToMs(stats.first_callback_ticks.load(std::memory_order_relaxed))));
+
+    // CPU per second of audio: IOProc time plus the consumer, DSP and render
+    // threads (the APM included). The IOProc part is wall time, so an upper bound.
+    double audio_ms = clock.TicksToMs(stats.interval_sum_ticks.load(std::memory_order_relaxed));
+    double cpu_ms = clock.TicksToMs(stats.duration_sum_ticks.load(std::memory_order_relaxed)) +
+                    (stats.consumer_cpu_ns.load(std::memory_order_relaxed) +
+                     stats.dsp_cpu_ns.load(std::memory_order_relaxed) +
+                     stats.render_cpu_ns.load(std::memory_order_relaxed)) / 1e6;
+    result.Set("cpuMsPerSecond", Napi::Number::New(env, audio_ms > 0.0 ? cpu_ms * 1000.0 / audio_ms : 0.0));
+    result.Set("arenaBytes", Napi::Number::New(env, static_cast<double>(stats.arena_bytes.load(std::memory_order_relaxed))));
+    result.Set("arenaOverflowBytes", Napi::Number::New(env, static_cast<double>(stats.arena_overflow_bytes.load(std::memory_order_relaxed))));
+    result.Set("rssOpenBytes", Napi::Number::New(env, static_cast<double>(stats.rss_open_bytes.load(std::memory_order_relaxed))));
+    result.Set("rssCloseBytes", Napi::Number::New(env, static_cast<double>(stats.rss_close_bytes.load(std::memory_order_relaxed))));
+
+    const struct {
+        const char* max_name;
+        const char* avg_name;
+        const WakeStats& wake;
+    } threads[] = {
+        { "maxConsumerWakeMs", "avgConsumerWakeMs", stats.consumer_wake },
+        { "maxDspWakeMs", "avgDspWakeMs", stats.dsp_wake },
+    };
+    for (const auto& entry : threads) {
+        uint64_t wakes = entry.wake.wakes.load(std::memory_order_relaxed);
+        result.Set(entry.max_name, Napi::Number::New(env, clock.TicksToMs(entry.wake.max_ticks.load(std::memory_order_relaxed))));
+        result.Set(entry.avg_name, Napi::Number::New(env, wakes > 0
+            ? clock.TicksToMs(entry.wake.sum_ticks.load(std::memory_order_relaxed)) / wakes : 0.0));
+    }
+    return result;
+}
+
+Napi::Value ReadCaptureHistory(Napi::Env env, const CaptureStream& stream, const HostClock& clock,
+                               const Napi::Value& options) {
+    if (!options.IsObject()) {
+        Napi::TypeError::New(env, "Expected { lastMs } or { fromHostTimeMs, toHostTimeMs }").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Object object = options.As<Napi::Object>();
+    auto number = [&object](const char* key, double* value) {
+        if (!object.Has(key) || !object.Get(key).IsNumber()) {
+            return false;
+        }
+        *value = object.Get(key).As<Napi::Number>().DoubleValue();
+        return *value >= 0.0;
+    };
+    uint64_t from_host = 0;
+    uint64_t to_host = 0;
+    double last_ms = 0.0;
+    double from_ms = 0.0;
+    double to_ms = 0.0;
+    if (number("lastMs", &last_ms)) {
+        to_host = stream.HistoryNewestHost();
+        uint64_t span = clock.MsToTicks(last_ms);
+        from_host = to_host > span ? to_host - span : 0;
+    } else if (number("fromHostTimeMs", &from_ms) && number("toHostTimeMs", &to_ms) && to_ms > from_ms) {
+        from_host = clock.MsToTicks(from_ms);
+        to_host = clock.MsToTicks(to_ms);
+    } else {
+        Napi::TypeError::New(env, "Expected { lastMs } or { fromHostTimeMs, toHostTimeMs }").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    // 'f32' (default) or 'ogg'
+    bool encoded = object.Has("format") && object.Get("format").IsString() &&
+                   object.Get("format").As<Napi::String>().Utf8Value() == "ogg";
+
+    HistoryRange range;
+    std::string error;
+    if (!stream.ReadHistory(from_host, to_host, encoded, &range, &error)) {
+        return env.Null();
+    }
+    Napi::Array segments = Napi::Array::New(env, range.segments.size());
+    for (size_t i = 0; i < range.segments.size(); ++i) {
+        Napi::Object segment = Napi::Object::New(env);
+        segment.Set("offsetMs", Napi::Number::New(env, range.segments[i].offset * 1000.0 / range.sample_rate));
+        segment.Set("hostTimeMs", Napi::Number::New(env, clock.HostTimeMs(range.segments[i].host_time)));
+        segment.Set("timestamp", Napi::Number::New(env, clock.ToDateNowMs(range.segments[i].host_time)));
+        segments.Set(static_cast<uint32_t>(i), segment);
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("sampleRate", Napi::Number::New(env, range.sample_rate));
+    result.Set("hostTimeMs", Napi::Number::New(env, clock.HostTimeMs(range.segments.front().host_time)));
+    result.Set("timestamp", Napi::Number::New(env, clock.ToDateNowMs(range.segments.front().host_time)));
+    result.Set("durationMs", Napi::Number::New(env, range.length * 1000.0 / range.sample_rate));
+    result.Set("segments", segments);
+    if (encoded) {
+        result.Set("data", Napi::Buffer<uint8_t>::Copy(env, range.ogg.data(), range.ogg.size()));
+    } else {
+        Napi::Float32Array samples = Napi::Float32Array::New(env, range.samples.size());
+        std::memcpy(samples.Data(), range.samples.data(), range.samples.size() * sizeof(float));
+        result.Set("samples", samples);
+    }
+    return result;
+}
+
+Napi::Object LatencyTraceToObject(Napi::Env env, const LatencyTrace& trace) {
+    static const struct {
+        const char* name;
+        TraceStage stage;
+    } kStages[] = {
+        { "captureToEnqueue", TraceStage::kCaptureToEnqueue },
+        { "enqueueToDsp", TraceStage::kEnqueueToDsp },
+        { "dspToDispatch", TraceStage::kDspToDispatch },
+        { "dispatchToJs", TraceStage::kDispatchToJs },
+        { "jsToSent", TraceStage::kJsToSent },
+        { "total", TraceStage::kTotal },
+    };
+    Napi::Object result = Napi::Object::New(env);
+    for (const auto& entry : kStages) {
+        LatencySummary summary = trace.Summarize(entry.stage);
+        Napi::Object stage = Napi::Object::New(env);
+        stage.Set("count", Napi::Number::New(env, static_cast<double>(summary.count)));
+        stage.Set("p50Ms", Napi::Number::New(env, summary.p50 / 1e6));
+        stage.Set("p95Ms", Napi::Number::New(env, summary.p95 / 1e6));
+        stage.Set("p99Ms", Napi::Number::New(env, summary.p99 / 1e6));
+        stage.Set("maxMs", Napi::Number::New(env, summary.max / 1e6));
+        result.Set(entry.name, stage);
+    }
+    return result;
+}
+
+void WriteAECMetrics(MetricsWriter* writer, const AECMetrics& metrics) {
+    writer->Put("echoReturnLoss", metrics.echo_return_loss);
+    writer->Put("echoReturnLossEnhancement", metrics.echo_return_loss_enhancement);
+    writer->Put("divergentFilterFraction", metrics.divergent_filter_fraction);
+    writer->Put("residualEchoLikelihood", metrics.residual_echo_likelihood);
+    writer->Put("residualEchoLikelihoodRecentMax", metrics.residual_echo_likelihood_recent_max);
+    writer->Put("renderDelayMs", metrics.render_delay_ms);
+    writer->Put("delayMedianMs", metrics.delay_median_ms);
+    writer->Put("delayStdMs", metrics.delay_std_ms);
+    writer->Put("renderDriftPpm", metrics.render_drift_ppm);
+    writer->Put("streamDelayMs", metrics.stream_delay_ms);
+    writer->Put("processingSampleRate", metrics.processing_sample_rate);
+    writer->Put("processingLoad", metrics.processing_load);
+    writer->Put("bypassed", metrics.bypassed ? 1.0 : 0.0);
+    writer->Put("suppressionLevel", metrics.adaptive_suppression ? metrics.suppression_level : std::nan(""));
+    writer->Put("governorLevel", metrics.cpu_governor ? metrics.governor_level : std::nan(""));
+    writer->Put("governorTransitions", static_cast<double>(metrics.governor_transitions));
+    writer->Put("normalizerGainDb", metrics.normalize_speech ? metrics.normalizer_gain_db : std::nan(""));
+    writer->Put("speechLevelDbfs", metrics.speech_level_dbfs);
+    writer->Put("clippingPredictions", static_cast<double>(metrics.clipping_predictions));
+    writer->Put("echoPathResets", static_cast<double>(metrics.echo_path_resets));
+    writer->Put("echoPathReconverging", metrics.echo_path_reconverging ? 1.0 : 0.0);
+    writer->Put("echoPathReconvergeMs", metrics.echo_path_reconverge_ms);
+    writer->Put("echoPathLeakageDb", metrics.echo_path_leakage_db);
+    writer->Put("outputLatencySamples", metrics.output_latency_samples);
+    writer->Put("outputLatencyMs", metrics.output_latency_ms);
+    const struct {
+        const char* names[7];
+        const AECCallStats& calls;
+    } kCalls[] = {
+        { { "captureCalls.frames", "captureCalls.errors", "captureCalls.deadlineMisses", "captureCalls.p50Us",
+            "captureCalls.p95Us", "captureCalls.p99Us", "captureCalls.maxUs" }, metrics.capture_calls },
+        { { "renderCalls.frames", "renderCalls.errors", "renderCalls.deadlineMisses", "renderCalls.p50Us",
+            "renderCalls.p95Us", "renderCalls.p99Us", "renderCalls.maxUs" }, metrics.render_calls },
+    };
+    for (const auto& entry : kCalls) {
+        writer->Put(entry.names[0], static_cast<double>(entry.calls.frames));
+        writer->Put(entry.names[1], static_cast<double>(entry.calls.errors));
+        writer->Put(entry.names[2], static_cast<double>(entry.calls.deadline_misses));
+        writer->Put(entry.names[3], entry.calls.p50_us);
+        writer->Put(entry.names[4], entry.calls.p95_us);
+        writer->Put(entry.names[5], entry.calls.p99_us);
+        writer->Put(entry.names[6], entry.calls.max_us);
+    }
+    writer->Put("aecConverged", metrics.aec_converged ? 1.0 : 0.0);
+    writer->Put("rmsLevel", metrics.rms_level);
+    writer->Put("peakLevel", metrics.peak_level);
+    writer->Put("noiseFloor", metrics.noise_floor);
+    writer->Put("speech", metrics.speech ? 1.0 : 0.0);
+}
+
+void WriteCaptureStats(MetricsWriter* writer, const CaptureStats& stats, const HostClock& clock) {
+    auto count = [](const std::atomic<uint64_t>& counter) {
+        return static_cast<double>(counter.load(std::memory_order_relaxed));
+    };
+    uint64_t callbacks = stats.callbacks.load(std::memory_order_relaxed);
+    uint64_t intervals = callbacks > 1 ? callbacks - 1 : 0;
+    writer->Put("callbacks", static_cast<double>(callbacks));
+    writer->Put("buffersCaptured", count(stats.buffers_captured));
+    writer->Put("buffersDropped", count(stats.buffers_dropped));
+    writer->Put("buffersOversized", count(stats.buffers_oversized));
+    writer->Put("deliveries", count(stats.deliveries));
+    writer->Put("tsfnRejections", count(stats.tsfn_rejections));
+    writer->Put("deliveriesDropped", count(stats.deliveries_dropped));
+    writer->Put("deliveriesCoalesced", count(stats.deliveries_coalesced));
+    writer->Put("consumerBlocks", count(stats.consumer_blocks));
+    writer->Put("queuePeak", static_cast<double>(stats.queue_peak.load(std::memory_order_relaxed)));
+    writer->Put("subscriberDeliveries", count(stats.subscriber_deliveries));
+    writer->Put("subscriberDropped", count(stats.subscriber_dropped));
+    writer->Put("subscriberCoalesced", count(stats.subscriber_coalesced));
+    writer->Put("overloads", count(stats.overloads));
+    writer->Put("framesGated", count(stats.frames_gated));
+    writer->Put("keystrokesDucked", count(stats.keystrokes_ducked));
+    uint64_t denoise_frames = stats.denoise_frames.load(std::memory_order_relaxed);
+    writer->Put("denoiseMeanUs", denoise_frames > 0
+        ? clock.TicksToMs(stats.denoise_ticks.load(std::memory_order_relaxed)) * 1000.0 / denoise_frames : 0.0);
+    writer->Put("renderGaps", count(stats.render_gaps));
+    writer->Put("renderFramesConcealed", count(stats.render_frames_concealed));
+    writer->Put("renderFramesDropped", count(stats.render_frames_dropped));
+    writer->Put("ioBufferFrames", static_cast<double>(stats.io_buffer_frames.load(std::memory_order_relaxed)));
+    writer->Put("deviceChannels", static_cast<double>(stats.device_channels.load(std::memory_order_relaxed)));
+    writer->Put("maxCallbackIntervalMs", clock.TicksToMs(stats.interval_max_ticks.load(std::memory_order_relaxed)));
+    writer->Put("avgCallbackIntervalMs", intervals > 0
+        ? clock.TicksToMs(stats.interval_sum_ticks.load(std::memory_order_relaxed)) / intervals : 0.0);
+    writer->Put("maxCallbackDurationMs", clock.TicksToMs(stats.duration_max_ticks.load(std::memory_order_relaxed)));
+    writer->Put("avgCallbackDurationMs", callbacks > 0
+        ? clock.TicksToMs(stats.duration_sum_ticks.load(std::memory_order_relaxed)) / callbacks : 0.0);
+    writer->Put("startToFirstCallbackMs", clock.TicksToMs(stats.first_callback_ticks.load(std::memory_order_relaxed)));
+    double audio_ms = clock.TicksToMs(stats.interval_sum_ticks.load(std::memory_order_relaxed));
+    double cpu_ms = clock.TicksToMs(stats.duration_sum_ticks.load(std::memory_order_relaxed)) +
+                    (stats.consumer_cpu_ns.load(std::memory_order_relaxed) +
+                     stats.dsp_cpu_ns.load(std::memory_order_relaxed) +
+                     stats.render_cpu_ns.load(std::memory_order_relaxed)) / 1e6;
+    writer->Put("cpuMsPerSecond", audio_ms > 0.0 ? cpu_ms * 1000.0 / audio_ms : 0.0);
+    writer->Put("arenaBytes", count(stats.arena_bytes));
+    writer->Put("arenaOverflowBytes", count(stats.arena_overflow_bytes));
+    writer->Put("rssOpenBytes", count(stats.rss_open_bytes));
+    writer->Put("rssCloseBytes", count(stats.rss_close_bytes));
+    const struct {
+        const char* max_name;
+        const char* avg_name;
+        const WakeStats& wake;
+    } threads[] = {
+        { "maxConsumerWakeMs", "avgConsumerWakeMs", stats.consumer_wake },
+        { "maxDspWakeMs", "avgDspWakeMs", stats.dsp_wake },
+    };
+    for (const auto& entry : threads) {
+        uint64_t wakes = entry.wake.wakes.load(std::memory_order_relaxed);
+        writer->Put(entry.max_name, clock.TicksToMs(entry.wake.max_ticks.load(std::memory_order_relaxed)));
+        writer->Put(entry.avg_name, wakes > 0
+            ? clock.TicksToMs(entry.wake.sum_ticks.load(std::memory_order_relaxed)) / wakes : 0.0);
+    }
+}
+
+void WriteLatencyTrace(MetricsWriter* writer, const LatencyTrace& trace) {
+    static const struct {
+        const char* names[5];
+        TraceStage stage;
+    } kStages[] = {
+        { { "captureToEnqueue.count", "captureToEnqueue.p50Ms", "captureToEnqueue.p95Ms", "captureToEnqueue.p99Ms",
+            "captureToEnqueue.maxMs" }, TraceStage::kCaptureToEnqueue },
+        { { "enqueueToDsp.count", "enqueueToDsp.p50Ms", "enqueueToDsp.p95Ms", "enqueueToDsp.p99Ms",
+            "enqueueToDsp.maxMs" }, TraceStage::kEnqueueToDsp },
+        { { "dspToDispatch.count", "dspToDispatch.p50Ms", "dspToDispatch.p95Ms", "dspToDispatch.p99Ms",
+            "dspToDispatch.maxMs" }, TraceStage::kDspToDispatch },
+        { { "dispatchToJs.count", "dispatchToJs.p50Ms", "dispatchToJs.p95Ms", "dispatchToJs.p99Ms",
+            "dispatchToJs.maxMs" }, TraceStage::kDispatchToJs },
+        { { "jsToSent.count", "jsToSent.p50Ms", "jsToSent.p95Ms", "jsToSent.p99Ms",
+            "jsToSent.maxMs" }, TraceStage::kJsToSent },
+        { { "total.count", "total.p50Ms", "total.p95Ms", "total.p99Ms", "total.maxMs" }, TraceStage::kTotal },
+    };
+    for (const auto& entry : kStages) {
+        LatencySummary summary = trace.Summarize(entry.stage);
+        writer->Put(entry.names[0], static_cast<double>(summary.count));
+        writer->Put(entry.names[1], summary.p50 / 1e6);
+        writer->Put(entry.names[2], summary.p95 / 1e6);
+        writer->Put(entry.names[3], summary.p99 / 1e6);
+        writer->Put(entry.names[4], summary.max / 1e6);
+    }
+}
+
+Napi::Object MetricsLayoutToObject(Napi::Env env, const std::vector<std::string>& names) {
+    Napi::Object offsets = Napi::Object::New(env);
+    for (size_t i = 0; i < names.size(); ++i) {
+        offsets.Set(names[i], Napi::Number::New(env, static_cast<double>(i)));
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("length", Napi::Number::New(env, static_cast<double>(names.size())));
+    result.Set("offsets", offsets);
+    return result;
+}
+
+void StartPerformanceReport(const Napi::CallbackInfo& info, PerformanceRecorder* recorder,
+                            std::function<void(MetricsWriter*)> write) {
+    double interval_ms = kPerformanceIntervalMs;
+    if (info.Length() > 0 && info[0].IsObject() && info[0].As<Napi::Object>().Get("intervalMs").IsNumber()) {
+        interval_ms = info[0].As<Napi::Object>().Get("intervalMs").As<Napi::Number>().DoubleValue();
+    }
+    std::vector<std::string> names;
+    MetricsWriter layout(&names);
+    write(&layout);
+    recorder->Start(names, [write](double* out, size_t capacity) {
+        MetricsWriter writer(out, capacity);
+        write(&writer);
+    }, interval_ms);
+}
+
+Napi::Value StopPerformanceReport(Napi::Env env, PerformanceRecorder* recorder) {
+    PerformanceSummary summary;
+    if (!recorder->Stop(&summary)) {
+        return env.Null();
+    }
+    Napi::Object metrics = Napi::Object::New(env);
+    for (const auto& [name, value] : summary.metrics) {
+        metrics.Set(name, Napi::Number::New(env, value));
+    }
+    // Plain arrays, so the report stores as JSON (NaN gaps as null)
+    auto to_array = [env](const std::vector<float>& values) {
+        Napi::Array array = Napi::Array::New(env, values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            array.Set(static_cast<uint32_t>(i), Napi::Number::New(env, values[i]));
+        }
+        return array;
+    };
+    Napi::Object series = Napi::Object::New(env);
+    for (const PerformanceSeries& entry : summary.series) {
+        Napi::Object points = Napi::Object::New(env);
+        points.Set("bucketMs", Napi::Number::New(env, entry.bucket_ms));
+        points.Set("min", to_array(entry.min));
+        points.Set("mean", to_array(entry.mean));
+        points.Set("max", to_array(entry.max));
+        series.Set(entry.name, points);
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("durationMs", Napi::Number::New(env, summary.duration_ms));
+    result.Set("intervalMs", Napi::Number::New(env, summary.interval_ms));
+    result.Set("samples", Napi::Number::New(env, static_cast<double>(summary.samples)));
+    result.Set("metrics", metrics);
+    result.Set("series", series);
+    return result;
+}
+
+// Process-wide services shared by every env the addon is loaded in (the
+// main thread and any worker_threads). The log ring is process-wide, so is
+// its forwarder, and so is the memory-pressure monitor; the scheduler is
+// made by the first compressRecording(), segmentRecording(),
+// reprocessRecordings() or exportBundle(). All go with the last env.
+static std::mutex g_module_mutex;
+static size_t g_module_envs = 0;
+static LogForwarder* g_log_forwarder = nullptr;
+static TaskScheduler* g_scheduler = nullptr;
+// Every reprocessRecordings() and exportBundle() call's cancel, for
+// teardown to stop running jobs; pruned as calls are made
+static std::vector<std::weak_ptr<std::atomic<bool>>> g_job_cancels;
+// The env that started the recording or the trace; its teardown stops it
+static napi_env g_recording_env = nullptr;
+static napi_env g_trace_env = nullptr;
+static napi_env g_session_capture_env = nullptr;
+
+// segmentRecording() targetSegmentMs range
+static constexpr double kMinSegmentTargetMs = 10000.0;
+static constexpr double kMaxSegmentTargetMs = 600000.0;
+
+// reprocessRecordings() sampleRate range
+static constexpr int kMinReprocessRate = 8000;
+static constexpr int kMaxReprocessRate = 48000;
+
+// exportBundle() sampleRate range
+static constexpr int kMinBundleRate = 8000;
+static constexpr int kMaxBundleRate = 48000;
+
+// RecordingReader getInfo() playback level, as streaming services normalize speech
+static constexpr double kPlaybackTargetLufs = -16.0;
+
+// RecordingPlayer output rate by default, and the longest read()
+static constexpr int kPlaybackRate = 48000;
+static constexpr double kMaxPlaybackReadSeconds = 2.0;
+
+static bool ParseLogLevel(Napi::Env env, const Napi::Value& value, LogLevel* level) {
+    static const struct {
+        const char* name;
+        LogLevel level;
+    } kLevels[] = {
+        { "debug", LogLevel::kDebug },
+        { "info", LogLevel::kInfo },
+        { "warn", LogLevel::kWarn },
+        { "error", LogLevel::kError },
+        { "off", LogLevel::kOff },
+    };
+    std::string name = value.IsString() ? value.As<Napi::String>().Utf8Value() : std::string();
+    for (const auto& entry : kLevels) {
+        if (name == entry.name) {
+            *level = entry.level;
+            return true;
+        }
+    }
+    Napi::TypeError::New(env, "Log level must be 'debug', 'info', 'warn', 'error' or 'off'").ThrowAsJavaScriptException();
+    return false;
+}
+
+// setLogHandler(callback | null, level?): native log records are delivered
+// to |callback| in batches; records below |level| are never formatted
+static Napi::Value SetLogHandler(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() > 1 && !info[1].IsUndefined()) {
+        LogLevel level;
+        if (!ParseLogLevel(env, info[1], &level)) {
+            return env.Undefined();
+        }
+        SetLogLevel(level);
+    }
+
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    if (info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined()) {
+        g_log_forwarder->Stop();
+        return env.Undefined();
+    }
+    if (!info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected callback function or null").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    // One handler per process: the env that set it last gets every record
+    g_log_forwarder->Start(env, info[0].As<Napi::Function>());
+    return env.Undefined();
+}
+
+static Napi::Value SetNativeLogLevel(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    LogLevel level;
+    if (ParseLogLevel(env, info.Length() > 0 ? info[0] : env.Undefined(), &level)) {
+        SetLogLevel(level);
+    }
+    return env.Undefined();
+}
+
+static bool StartTraceFor(napi_env env, TraceOutput output, const char* path) {
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    if (!StartPipelineTrace(output, path)) {
+        return false;
+    }
+    g_trace_env = env;
+    return true;
+}
+
+// startTrace('chrome', path) | startTrace('signpost'): process-wide pipeline
+// tracing until stopTrace(); false when it is already on or cannot start
+static Napi::Value StartTrace(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected trace output 'chrome' or 'signpost'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string output = info[0].As<Napi::String>().Utf8Value();
+    if (output == "signpost") {
+        return Napi::Boolean::New(env, StartTraceFor(env, TraceOutput::kSignposts, nullptr));
+    }
+    if (output != "chrome") {
+        Napi::TypeError::New(env, "Trace output must be 'chrome' or 'signpost'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (info.Length() < 2 || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Expected trace file path").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string path = info[1].As<Napi::String>().Utf8Value();
+    return Napi::Boolean::New(env, StartTraceFor(env, TraceOutput::kChromeJson, path.c_str()));
+}
+
+static Napi::Value StopTrace(const Napi::CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    StopPipelineTrace();
+    g_trace_env = nullptr;
+    return info.Env().Undefined();
+}
+
+// { files: [{ track, path, sampleRate, samples }], indexes: { track: path },
+// droppedSamples: { track: n }, loudness: { track: { integratedLufs,
+// peakDbfs } } }
+static Napi::Object RecordingSummaryToObject(Napi::Env env, const RecordingSummary& summary) {
+    Napi::Object result = Napi::Object::New(env);
+    Napi::Array files = Napi::Array::New(env, summary.files.size());
+    for (size_t i = 0; i < summary.files.size(); ++i) {
+        const RecordedFile& recorded = summary.files[i];
+        Napi::Object file = Napi::Object::New(env);
+        file.Set("track", Napi::String::New(env, RecordTrackName(recorded.track)));
+        file.Set("path", Napi::String::New(env, recorded.path));
+        file.Set("sampleRate", Napi::Number::New(env, recorded.sample_rate));
+        file.Set("channels", Napi::Number::New(env, recorded.channels));
+        file.Set("samples", Napi::Number::New(env, static_cast<double>(recorded.samples)));
+        files.Set(static_cast<uint32_t>(i), file);
+    }
+    result.Set("files", files);
+    Napi::Object indexes = Napi::Object::New(env);
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        if (!summary.indexes[i].empty()) {
+            indexes.Set(RecordTrackName(static_cast<RecordTrack>(i)), Napi::String::New(env, summary.indexes[i]));
+        }
+    }
+    result.Set("indexes", indexes);
+    Napi::Object dropped = Napi::Object::New(env);
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        dropped.Set(RecordTrackName(static_cast<RecordTrack>(i)),
+                    Napi::Number::New(env, static_cast<double>(summary.dropped_samples[i])));
+    }
+    result.Set("droppedSamples", dropped);
+    Napi::Object loudness = Napi::Object::New(env);
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        if (!summary.indexes[i].empty()) {
+            Napi::Object track = Napi::Object::New(env);
+            track.Set("integratedLufs", Napi::Number::New(env, summary.loudness_lufs[i]));
+            track.Set("peakDbfs", Napi::Number::New(env, summary.peak_dbfs[i]));
+            loudness.Set(RecordTrackName(static_cast<RecordTrack>(i)), track);
+        }
+    }
+    result.Set("loudness", loudness);
+    Napi::Object compacted = Napi::Object::New(env);
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        if (!summary.indexes[i].empty()) {
+            compacted.Set(RecordTrackName(static_cast<RecordTrack>(i)), Napi::Number::New(env, summary.compacted_ms[i]));
+        }
+    }
+    result.Set("compactedMs", compacted);
+    return result;
+}
+
+// startRecording({ directory, name?, tracks?, format?, syncIntervalMs?,
+// chunkSeconds?, indexIntervalMs?, compactSilenceMs?, encrypt?, mix? }) -> boolean. tracks lists 'microphone', 'system',
+// 'processed' and 'mix' (default all but 'mix'); format is 'pcm16' (default) or 'float32'.
+// encrypt seals the samples under setRecordingKey()'s key, and fails the start without one.
+// mix: { micGainDb?, systemGainDb?, stereo?, micPan?, systemPan? } sets up
+// the mix track and records it whatever tracks says.
+static Napi::Value StartNativeRecording(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("directory").IsString()) {
+        Napi::TypeError::New(env, "Expected { directory }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    RecorderOptions recorder;
+    recorder.directory = options.Get("directory").As<Napi::String>().Utf8Value();
+    if (options.Get("name").IsString()) {
+        recorder.name = options.Get("name").As<Napi::String>().Utf8Value();
+    }
+    if (options.Get("tracks").IsArray()) {
+        Napi::Array tracks = options.Get("tracks").As<Napi::Array>();
+        for (size_t i = 0; i < kRecordTrackCount; ++i) {
+            recorder.tracks[i] = false;
+        }
+        for (uint32_t i = 0; i < tracks.Length(); ++i) {
+            if (!tracks.Get(i).IsString()) {
+                continue;
+            }
+            std::string name = tracks.Get(i).As<Napi::String>().Utf8Value();
+            for (size_t track = 0; track < kRecordTrackCount; ++track) {
+                if (name == RecordTrackName(static_cast<RecordTrack>(track))) {
+                    recorder.tracks[track] = true;
+                }
+            }
+        }
+    }
+    if (options.Get("format").IsString()) {
+        recorder.float32 = options.Get("format").As<Napi::String>().Utf8Value() == "float32";
+    }
+    if (options.Get("syncIntervalMs").IsNumber()) {
+        recorder.sync_interval_ms = options.Get("syncIntervalMs").As<Napi::Number>().DoubleValue();
+    }
+    if (options.Get("chunkSeconds").IsNumber()) {
+        recorder.chunk_seconds = options.Get("chunkSeconds").As<Napi::Number>().DoubleValue();
+    }
+    if (options.Get("indexIntervalMs").IsNumber()) {
+        recorder.index_interval_ms = options.Get("indexIntervalMs").As<Napi::Number>().DoubleValue();
+    }
+    if (options.Get("compactSilenceMs").IsNumber()) {
+        recorder.compact_silence_ms = options.Get("compactSilenceMs").As<Napi::Number>().DoubleValue();
+    }
+    recorder.encrypt = options.Get("encrypt").IsBoolean() && options.Get("encrypt").As<Napi::Boolean>().Value();
+    if (options.Get("mix").IsObject()) {
+        Napi::Object mix = options.Get("mix").As<Napi::Object>();
+        auto number = [&](const char* key, float fallback) {
+            Napi::Value value = mix.Get(key);
+            return value.IsNumber() ? value.As<Napi::Number>().FloatValue() : fallback;
+        };
+        recorder.mix.mic_gain_db = std::clamp(number("micGainDb", 0.0f), -40.0f, 20.0f);
+        recorder.mix.system_gain_db = std::clamp(number("systemGainDb", 0.0f), -40.0f, 20.0f);
+        recorder.mix.stereo = mix.Get("stereo").IsBoolean() && mix.Get("stereo").As<Napi::Boolean>().Value();
+        recorder.mix.mic_pan = number("micPan", 0.0f);
+        recorder.mix.system_pan = number("systemPan", 0.0f);
+        recorder.tracks[static_cast<size_t>(RecordTrack::kMix)] = true;
+    }
+    std::string error;
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    if (!StartRecording(recorder, &error)) {
+        return Napi::Boolean::New(env, false);
+    }
+    g_recording_env = env;
+    return Napi::Boolean::New(env, true);
+}
+
+// setRecordingKey(key: Uint8Array | null): the process's 32-byte AES-256 key
+// for encrypted recordings, from the OS keychain; null forgets it. Takes
+// effect for recordings started and readers opened after.
+static Napi::Value SetNativeRecordingKey(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() > 0 && info[0].IsNull()) {
+        ClearRecordingKey();
+        return env.Undefined();
+    }
+    if (info.Length() < 1 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array ||
+        info[0].As<Napi::Uint8Array>().ElementLength() != kAesGcmKeySize) {
+        Napi::TypeError::New(env, "Expected a 32-byte Uint8Array or null").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    SetRecordingKey(info[0].As<Napi::Uint8Array>().Data());
+    return env.Undefined();
+}
+
+// stopRecording() -> the summary, once every file is closed. Any env may
+// stop a recording another started.
+static Napi::Value StopNativeRecording(const Napi::CallbackInfo& info) {
+    std::unique_lock<std::mutex> lock(g_module_mutex);
+    RecordingSummary summary = StopRecording();
+    g_recording_env = nullptr;
+    lock.unlock();
+    return RecordingSummaryToObject(info.Env(), summary);
+}
+
+// getRecordingStatus() -> { recording, files, droppedSamples }, lengths as
+// of the last sync
+static Napi::Value GetNativeRecordingStatus(const Napi::CallbackInfo& info) {
+    RecordingSummary summary;
+    bool recording = RecordingStatus(&summary);
+    Napi::Object result = RecordingSummaryToObject(info.Env(), summary);
+    result.Set("recording", Napi::Boolean::New(info.Env(), recording));
+    return result;
+}
+
+static Napi::Object TalkAnalyticsToObject(Napi::Env env, const TalkAnalyticsTotals& totals) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("elapsedMs", Napi::Number::New(env, totals.elapsed_ms));
+    result.Set("overlapMs", Napi::Number::New(env, totals.overlap_ms));
+    for (size_t i = 0; i < kTalkPartyCount; ++i) {
+        const TalkPartyTotals& party = totals.parties[i];
+        Napi::Object totalsObject = Napi::Object::New(env);
+        totalsObject.Set("talkMs", Napi::Number::New(env, party.talk_ms));
+        totalsObject.Set("utterances", Napi::Number::New(env, party.utterances));
+        totalsObject.Set("turns", Napi::Number::New(env, party.turns));
+        totalsObject.Set("longestTurnMs", Napi::Number::New(env, party.longest_turn_ms));
+        totalsObject.Set("overlaps", Napi::Number::New(env, party.overlaps));
+        totalsObject.Set("interruptions", Napi::Number::New(env, party.interruptions));
+        totalsObject.Set("questions", Napi::Number::New(env, party.questions));
+        totalsObject.Set("responses", Napi::Number::New(env, party.responses));
+        totalsObject.Set("meanResponseLatencyMs",
+                         Napi::Number::New(env, party.responses > 0 ? party.response_latency_sum_ms / party.responses : 0.0));
+        totalsObject.Set("maxResponseLatencyMs", Napi::Number::New(env, party.response_latency_max_ms));
+        result.Set(TalkPartyName(static_cast<TalkParty>(i)), totalsObject);
+    }
+    return result;
+}
+
+// startTalkAnalytics({ threshold?, minSpeechMs?, trailingSilenceMs?,
+// questionThreshold? }?) -> boolean, false while already running. Counts the
+// microphone as 'local' and system audio as 'remote' from their VAD frames,
+// so those streams need the vad, gate or endpoint option; questions need
+// endpoint.prosody.
+static Napi::Value StartNativeTalkAnalytics(const Napi::CallbackInfo& info) {
+    TalkAnalyticsOptions options;
+    if (info.Length() > 0 && info[0].IsObject()) {
+        Napi::Object object = info[0].As<Napi::Object>();
+        auto number = [&](const char* key, double fallback) {
+            Napi::Value value = object.Get(key);
+            return value.IsNumber() ? value.As<Napi::Number>().DoubleValue() : fallback;
+        };
+        options.threshold = static_cast<float>(std::clamp(number("threshold", options.threshold), 0.0, 1.0));
+        options.min_speech_ms = std::clamp(number("minSpeechMs", options.min_speech_ms), 10.0, 2000.0);
+        options.trailing_silence_ms = std::clamp(number("trailingSilenceMs", options.trailing_silence_ms), 10.0, 5000.0);
+        options.question_threshold =
+            static_cast<float>(std::clamp(number("questionThreshold", options.question_threshold), 0.0, 1.0));
+    }
+    return Napi::Boolean::New(info.Env(), StartTalkAnalytics(options));
+}
+
+// stopTalkAnalytics() -> the final totals
+static Napi::Value StopNativeTalkAnalytics(const Napi::CallbackInfo& info) {
+    return TalkAnalyticsToObject(info.Env(), StopTalkAnalytics());
+}
+
+// getTalkAnalytics() -> { running, elapsedMs, overlapMs, local, remote }: a
+// snapshot, open utterances counted so far; cheap enough to poll
+static Napi::Value GetNativeTalkAnalytics(const Napi::CallbackInfo& info) {
+    TalkAnalyticsTotals totals;
+    bool running = TalkAnalyticsSnapshot(&totals);
+    Napi::Object result = TalkAnalyticsToObject(info.Env(), totals);
+    result.Set("running", Napi::Boolean::New(info.Env(), running));
+    return result;
+}
+
+// startSessionCapture(path) -> boolean: every buffer and device event the
+// addon receives, raw, until stopSessionCapture(); for SessionReplay
+static Napi::Value StartNativeSessionCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected capture file path").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string error;
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    if (!StartSessionCapture(info[0].As<Napi::String>().Utf8Value(), &error)) {
+        return Napi::Boolean::New(env, false);
+    }
+    g_session_capture_env = env;
+    return Napi::Boolean::New(env, true);
+}
+
+// stopSessionCapture() -> { buffers: { stream: n }, samples, dropped,
+// events, bytes }, once the file is closed
+static Napi::Value StopNativeSessionCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::unique_lock<std::mutex> lock(g_module_mutex);
+    SessionCaptureSummary summary = StopSessionCapture();
+    g_session_capture_env = nullptr;
+    lock.unlock();
+
+    auto per_stream = [&](const uint64_t* values) {
+        Napi::Object result = Napi::Object::New(env);
+        for (size_t i = 0; i < kSessionStreamCount; ++i) {
+            result.Set(SessionStreamName(static_cast<SessionStream>(i)),
+                       Napi::Number::New(env, static_cast<double>(values[i])));
+        }
+        return result;
+    };
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("buffers", per_stream(summary.buffers));
+    result.Set("samples", per_stream(summary.samples));
+    result.Set("dropped", per_stream(summary.dropped));
+    result.Set("events", Napi::Number::New(env, static_cast<double>(summary.events)));
+    result.Set("bytes", Napi::Number::New(env, static_cast<double>(summary.bytes)));
+    return result;
+}
+
+// The addon's scheduler, made on first use; g_module_mutex held
+static TaskScheduler* ModuleScheduler() {
+    if (!g_scheduler) {
+        g_scheduler = TaskScheduler::CreateDefault().release();
+    }
+    return g_scheduler;
+}
+
+// One compressRecording() call: settled on the JS thread through |tsfn|,
+// which also carries progress to the onProgress callback
+struct CompressionCall {
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    CompressionResult result;
+};
+
+// compressRecording({ input, output, format?, bitrate?, deleteInput?,
+// onProgress? }) -> Promise<{ output, inputBytes, outputBytes, audioSeconds,
+// elapsedMs }>. format is 'flac' (default) or 'opus'.
+static Napi::Value CompressNativeRecording(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected { input, output }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Get("input").IsString() || !options.Get("output").IsString()) {
+        Napi::TypeError::New(env, "input and output must be paths").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    CompressionJob job;
+    job.input = options.Get("input").As<Napi::String>().Utf8Value();
+    job.output = options.Get("output").As<Napi::String>().Utf8Value();
+    if (options.Get("format").IsString()) {
+        std::string format = options.Get("format").As<Napi::String>().Utf8Value();
+        if (format != "flac" && format != "opus") {
+            Napi::TypeError::New(env, "format must be 'flac' or 'opus'").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        job.format = format == "opus" ? CompressionFormat::kOpus : CompressionFormat::kFlac;
+    }
+    if (options.Get("bitrate").IsNumber()) {
+        job.bitrate = static_cast<int>(std::max(kMinOpusBitrate,
+            std::min(options.Get("bitrate").As<Napi::Number>().DoubleValue(), kMaxOpusBitrate)));
+    }
+    if (options.Get("deleteInput").IsBoolean()) {
+        job.delete_input = options.Get("deleteInput").As<Napi::Boolean>().Value();
+    }
+
+    Napi::Function progress = options.Get("onProgress").IsFunction()
+        ? options.Get("onProgress").As<Napi::Function>()
+        : Napi::Function::New(env, [](const Napi::CallbackInfo&) {});
+    auto* call = new CompressionCall{Napi::Promise::Deferred::New(env), Napi::ThreadSafeFunction(), {}};
+    call->tsfn = Napi::ThreadSafeFunction::New(env, progress, "CompressRecording", 0, 1);
+    Napi::Promise promise = call->deferred.Promise();
+
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    std::string output = job.output;
+    SubmitCompression(ModuleScheduler(), std::move(job),
+        [call](double fraction) {
+            double* value = new double(fraction);
+            napi_status status = call->tsfn.NonBlockingCall(value, [](Napi::Env env, Napi::Function callback,
+                                                                      double* reported) {
+                std::unique_ptr<double> owned(reported);
+                try {
+                    callback.Call({ Napi::Number::New(env, *owned) });
+                } catch (...) {
+                    // A throwing progress handler must not fail the job
+                }
+            });
+            if (status != napi_ok) {
+                delete value;
+            }
+        },
+        [call, output](const CompressionResult& result) {
+            call->result = result;
+            // |call| is the JS thread's once queued
+            Napi::ThreadSafeFunction tsfn = call->tsfn;
+            napi_status status = tsfn.NonBlockingCall(call, [output](Napi::Env env, Napi::Function,
+                                                                          CompressionCall* settled) {
+                std::unique_ptr<CompressionCall> owned(settled);
+                const CompressionResult& done = owned->result;
+                if (!done.ok) {
+                    owned->deferred.Reject(Napi::Error::New(env, done.error).Value());
+                    return;
+                }
+                Napi::Object value = Napi::Object::New(env);
+                value.Set("output", Napi::String::New(env, output));
+                value.Set("inputBytes", Napi::Number::New(env, static_cast<double>(done.input_bytes)));
+                value.Set("outputBytes", Napi::Number::New(env, static_cast<double>(done.output_bytes)));
+                value.Set("audioSeconds", Napi::Number::New(env, done.audio_seconds));
+                value.Set("elapsedMs", Napi::Number::New(env, done.elapsed_ms));
+                owned->deferred.Resolve(value);
+            });
+            if (status != napi_ok) {
+                delete call;  // the env is going away
+            }
+            tsfn.Release();
+        });
+    return promise;
+}
+
+static Napi::Object RecordingSegmentToObject(Napi::Env env, const RecordingSegment& segment) {
+    Napi::Object object = Napi::Object::New(env);
+    object.Set("index", Napi::Number::New(env, static_cast<double>(segment.index)));
+    object.Set("path", Napi::String::New(env, segment.path));
+    object.Set("startMs", Napi::Number::New(env, segment.start_ms));
+    object.Set("endMs", Napi::Number::New(env, segment.end_ms));
+    object.Set("speechMs", Napi::Number::New(env, segment.speech_ms));
+    object.Set("bytes", Napi::Number::New(env, static_cast<double>(segment.bytes)));
+    return object;
+}
+
+// One segmentRecording() call, like CompressionCall; |tsfn| carries each
+// finished segment to the onSegment callback
+struct SegmentationCall {
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    SegmentationResult result;
+};
+
+// segmentRecording({ index, outputDir, name?, targetSegmentMs?, maxShiftMs?,
+// minSilenceMs?, threshold?, sampleRate?, threads?, onSegment? }) ->
+// Promise<{ segments, audioMs, speechMs, vadMs, encodeMs, elapsedMs }>.
+// Runs on the compression pool; onSegment(segment) fires as each file is
+// complete, so uploads can start before the last one is encoded.
+static Napi::Value SegmentNativeRecording(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected { index, outputDir }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Get("index").IsString() || !options.Get("outputDir").IsString()) {
+        Napi::TypeError::New(env, "index and outputDir must be paths").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    SegmentationJob job;
+    job.index = options.Get("index").As<Napi::String>().Utf8Value();
+    job.output_dir = options.Get("outputDir").As<Napi::String>().Utf8Value();
+    if (options.Get("name").IsString()) {
+        job.name = options.Get("name").As<Napi::String>().Utf8Value();
+    }
+    if (options.Get("targetSegmentMs").IsNumber()) {
+        job.target_ms = std::clamp(options.Get("targetSegmentMs").As<Napi::Number>().DoubleValue(),
+                                   kMinSegmentTargetMs, kMaxSegmentTargetMs);
+    }
+    // Cuts move at most a third of the target, so neighbours never cross
+    job.max_shift_ms = job.target_ms / 4.0;
+    if (options.Get("maxShiftMs").IsNumber()) {
+        job.max_shift_ms = std::clamp(options.Get("maxShiftMs").As<Napi::Number>().DoubleValue(), 0.0,
+                                      job.target_ms / 3.0);
+    }
+    if (options.Get("minSilenceMs").IsNumber()) {
+        job.min_silence_ms = std::clamp(options.Get("minSilenceMs").As<Napi::Number>().DoubleValue(), 10.0, 5000.0);
+    }
+    if (options.Get("threshold").IsNumber()) {
+        job.threshold = std::clamp(options.Get("threshold").As<Napi::Number>().FloatValue(), 0.0f, 1.0f);
+    }
+    if (options.Get("sampleRate").IsNumber()) {
+        job.sample_rate = std::clamp(options.Get("sampleRate").As<Napi::Number>().Int32Value(), 8000, 48000) / 100 * 100;
+    }
+    if (options.Get("threads").IsNumber()) {
+        job.threads = static_cast<size_t>(std::clamp(options.Get("threads").As<Napi::Number>().Int32Value(), 0, 64));
+    }
+
+    Napi::Function on_segment = options.Get("onSegment").IsFunction()
+        ? options.Get("onSegment").As<Napi::Function>()
+        : Napi::Function::New(env, [](const Napi::CallbackInfo&) {});
+    auto* call = new SegmentationCall{Napi::Promise::Deferred::New(env), Napi::ThreadSafeFunction(), {}};
+    call->tsfn = Napi::ThreadSafeFunction::New(env, on_segment, "SegmentRecording", 0, 1);
+    Napi::Promise promise = call->deferred.Promise();
+
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    ModuleScheduler()->Post(TaskPriority::kBackground, [call, job](const std::atomic<bool>& cancel) {
+        call->result = SegmentRecording(job,
+            [call](const RecordingSegment& segment) {
+                auto* ready = new RecordingSegment(segment);
+                napi_status status = call->tsfn.NonBlockingCall(ready, [](Napi::Env env, Napi::Function callback,
+                                                                          RecordingSegment* done) {
+                    std::unique_ptr<RecordingSegment> owned(done);
+                    try {
+                        callback.Call({ RecordingSegmentToObject(env, *owned) });
+                    } catch (...) {
+                        // A throwing handler must not fail the job
+                    }
+                });
+                if (status != napi_ok) {
+                    delete ready;
+                }
+            },
+            cancel);
+        Napi::ThreadSafeFunction tsfn = call->tsfn;
+        napi_status status = tsfn.NonBlockingCall(call, [](Napi::Env env, Napi::Function, SegmentationCall* settled) {
+            std::unique_ptr<SegmentationCall> owned(settled);
+            const SegmentationResult& done = owned->result;
+            if (!done.ok) {
+                owned->deferred.Reject(Napi::Error::New(env, done.error).Value());
+                return;
+            }
+            Napi::Object value = Napi::Object::New(env);
+            Napi::Array segments = Napi::Array::New(env, done.segments.size());
+            for (size_t i = 0; i < done.segments.size(); ++i) {
+                segments.Set(static_cast<uint32_t>(i), RecordingSegmentToObject(env, done.segments[i]));
+            }
+            value.Set("segments", segments);
+            value.Set("audioMs", Napi::Number::New(env, done.audio_ms));
+            value.Set("speechMs", Napi::Number::New(env, done.speech_ms));
+            value.Set("vadMs", Napi::Number::New(env, done.vad_ms));
+            value.Set("encodeMs", Napi::Number::New(env, done.encode_ms));
+            value.Set("elapsedMs", Napi::Number::New(env, done.elapsed_ms));
+            owned->deferred.Resolve(value);
+        });
+        if (status != napi_ok) {
+            delete call;  // the env is going away
+        }
+        tsfn.Release();
+    });
+    return promise;
+}
+
+// One alignTranscript() call, like CompressionCall; |tsfn| only settles it
+struct AlignmentCall {
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    AlignmentResult result;
+};
+
+// alignTranscript({ index, words: [{ text, startMs, endMs }], maxShiftMs?,
+// maxWordShiftMs?, runGapMs? }) -> Promise<{ words: [{ startMs, endMs,
+// startSample, endSample, confidence }], sampleRate, runs, meanShiftMs,
+// maxShiftMs, audioMs, elapsedMs }>. Word times are recording time, as
+// guessed going in and as aligned coming out, one result per word in order.
+static Napi::Value AlignNativeTranscript(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected { index, words }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Get("index").IsString() || !options.Get("words").IsArray()) {
+        Napi::TypeError::New(env, "index must be a path and words an array").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    AlignmentJob job;
+    job.index = options.Get("index").As<Napi::String>().Utf8Value();
+    Napi::Array words = options.Get("words").As<Napi::Array>();
+    job.words.reserve(words.Length());
+    for (uint32_t i = 0; i < words.Length(); ++i) {
+        Napi::Value value = words.Get(i);
+        if (!value.IsObject()) {
+            Napi::TypeError::New(env, "words must be { text, startMs, endMs }").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object word = value.As<Napi::Object>();
+        if (!word.Get("startMs").IsNumber() || !word.Get("endMs").IsNumber()) {
+            Napi::TypeError::New(env, "words must be { text, startMs, endMs }").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        AlignmentWord aligned;
+        if (word.Get("text").IsString()) {
+            aligned.text = word.Get("text").As<Napi::String>().Utf8Value();
+        }
+        aligned.start_ms = std::max(0.0, word.Get("startMs").As<Napi::Number>().DoubleValue());
+        aligned.end_ms = std::max(aligned.start_ms, word.Get("endMs").As<Napi::Number>().DoubleValue());
+        job.words.push_back(std::move(aligned));
+    }
+    if (options.Get("maxShiftMs").IsNumber()) {
+        job.max_shift_ms = std::clamp(options.Get("maxShiftMs").As<Napi::Number>().DoubleValue(), 0.0, 30000.0);
+    }
+    if (options.Get("maxWordShiftMs").IsNumber()) {
+        job.max_word_shift_ms = std::clamp(options.Get("maxWordShiftMs").As<Napi::Number>().DoubleValue(), 10.0, 2000.0);
+    }
+    if (options.Get("runGapMs").IsNumber()) {
+        job.run_gap_ms = std::clamp(options.Get("runGapMs").As<Napi::Number>().DoubleValue(), 100.0, 10000.0);
+    }
+
+    auto* call = new AlignmentCall{Napi::Promise::Deferred::New(env), Napi::ThreadSafeFunction(), {}};
+    call->tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                               "AlignTranscript", 0, 1);
+    Napi::Promise promise = call->deferred.Promise();
+
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    ModuleScheduler()->Post(TaskPriority::kBackground, [call, job](const std::atomic<bool>& cancel) {
+        call->result = AlignTranscript(job, cancel);
+        Napi::ThreadSafeFunction tsfn = call->tsfn;
+        napi_status status = tsfn.NonBlockingCall(call, [](Napi::Env env, Napi::Function, AlignmentCall* settled) {
+            std::unique_ptr<AlignmentCall> owned(settled);
+            const AlignmentResult& done = owned->result;
+            if (!done.ok) {
+                owned->deferred.Reject(Napi::Error::New(env, done.error).Value());
+                return;
+            }
+            Napi::Array words = Napi::Array::New(env, done.words.size());
+            for (size_t i = 0; i < done.words.size(); ++i) {
+                const AlignedWord& word = done.words[i];
+                Napi::Object object = Napi::Object::New(env);
+                object.Set("startMs", Napi::Number::New(env, word.start_ms));
+                object.Set("endMs", Napi::Number::New(env, word.end_ms));
+                object.Set("startSample", Napi::Number::New(env, static_cast<double>(word.start_sample)));
+                object.Set("endSample", Napi::Number::New(env, static_cast<double>(word.end_sample)));
+                object.Set("confidence", Napi::Number::New(env, word.confidence));
+                words.Set(static_cast<uint32_t>(i), object);
+            }
+            Napi::Object value = Napi::Object::New(env);
+            value.Set("words", words);
+            value.Set("sampleRate", Napi::Number::New(env, done.sample_rate));
+            value.Set("runs", Napi::Number::New(env, static_cast<double>(done.runs)));
+            value.Set("meanShiftMs", Napi::Number::New(env, done.mean_shift_ms));
+            value.Set("maxShiftMs", Napi::Number::New(env, done.max_shift_ms));
+            value.Set("audioMs", Napi::Number::New(env, done.audio_ms));
+            value.Set("elapsedMs", Napi::Number::New(env, done.elapsed_ms));
+            owned->deferred.Resolve(value);
+        });
+        if (status != napi_ok) {
+            delete call;  // the env is going away
+        }
+        tsfn.Release();
+    });
+    return promise;
+}
+
+struct ClipCall {
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    ClipResult result;
+};
+
+// extractClip({ tracks: [index], startMs, durationMs, format?: 'opus' | 'wav',
+// sampleRate?, bitrate?, targetLufs?, output? }) -> Promise<{ output?, data?,
+// bytes, durationMs, sampleRate, gainDb, measured, elapsedMs }>. startMs is recording
+// time of the first track; without output the clip comes back as data.
+static Napi::Value ExtractNativeClip(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected { tracks, startMs, durationMs }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Get("tracks").IsArray() || !options.Get("startMs").IsNumber() ||
+        !options.Get("durationMs").IsNumber()) {
+        Napi::TypeError::New(env, "tracks must be index paths, startMs and durationMs numbers")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    ClipJob job;
+    Napi::Array tracks = options.Get("tracks").As<Napi::Array>();
+    for (uint32_t i = 0; i < tracks.Length(); ++i) {
+        Napi::Value track = tracks.Get(i);
+        if (!track.IsString()) {
+            Napi::TypeError::New(env, "tracks must be index paths").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        job.indexes.push_back(track.As<Napi::String>().Utf8Value());
+    }
+    job.start_ms = std::max(0.0, options.Get("startMs").As<Napi::Number>().DoubleValue());
+    job.duration_ms = std::max(0.0, options.Get("durationMs").As<Napi::Number>().DoubleValue());
+    if (options.Get("format").IsString()) {
+        const std::string format = options.Get("format").As<Napi::String>().Utf8Value();
+        if (format == "wav") {
+            job.format = ClipFormat::kWav;
+        } else if (format != "opus") {
+            Napi::TypeError::New(env, "format must be 'opus' or 'wav'").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+    if (options.Get("sampleRate").IsNumber()) {
+        job.sample_rate = options.Get("sampleRate").As<Napi::Number>().Int32Value();
+    }
+    if (options.Get("bitrate").IsNumber()) {
+        job.bitrate = std::clamp(options.Get("bitrate").As<Napi::Number>().Int32Value(), 6000, 256000);
+    }
+    if (options.Get("targetLufs").IsNumber()) {
+        job.target_lufs = std::clamp(options.Get("targetLufs").As<Napi::Number>().FloatValue(), -40.0f, -5.0f);
+    }
+    if (options.Get("output").IsString()) {
+        job.output = options.Get("output").As<Napi::String>().Utf8Value();
+    }
+
+    auto* call = new ClipCall{Napi::Promise::Deferred::New(env), Napi::ThreadSafeFunction(), {}};
+    call->tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                               "ExtractClip", 0, 1);
+    Napi::Promise promise = call->deferred.Promise();
+
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    ModuleScheduler()->Post(TaskPriority::kInteractive, [call, job](const std::atomic<bool>& cancel) {
+        call->result = ExtractClip(job, cancel);
+        const std::string output = job.output;
+        Napi::ThreadSafeFunction tsfn = call->tsfn;
+        napi_status status = tsfn.NonBlockingCall(call, [output](Napi::Env env, Napi::Function, ClipCall* settled) {
+            std::unique_ptr<ClipCall> owned(settled);
+            const ClipResult& done = owned->result;
+            if (!done.ok) {
+                owned->deferred.Reject(Napi::Error::New(env, done.error).Value());
+                return;
+            }
+            Napi::Object value = Napi::Object::New(env);
+            if (output.empty()) {
+                value.Set("data", Napi::Buffer<uint8_t>::Copy(env, done.bytes.data(), done.bytes.size()));
+            } else {
+                value.Set("output", Napi::String::New(env, output));
+            }
+            value.Set("bytes", Napi::Number::New(env, static_cast<double>(done.output_bytes)));
+            value.Set("durationMs", Napi::Number::New(env, done.duration_ms));
+            value.Set("sampleRate", Napi::Number::New(env, done.sample_rate));
+            value.Set("gainDb", Napi::Number::New(env, done.gain_db));
+            value.Set("measured", Napi::Boolean::New(env, done.measured));
+            value.Set("elapsedMs", Napi::Number::New(env, done.elapsed_ms));
+            owned->deferred.Resolve(value);
+        });
+        if (status != napi_ok) {
+            delete call;  // the env is going away
+        }
+        tsfn.Release();
+    });
+    return promise;
+}
+
+// One reprocessRecordings() call: |tsfn| carries progress and each
+// meeting's result to onEvent, then settles the promise once the last
+// meeting is done
+struct ReprocessCall {
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    std::mutex mutex;
+    std::vector<std::string> outputs;
+    std::vector<ReprocessResult> results;
+    size_t remaining = 0;
+};
+
+// What one event to onEvent carries; |meeting| indexes the meetings array
+struct ReprocessEvent {
+    size_t meeting = 0;
+    bool done = false;  // else progress
+    double fraction = 0.0;
+    std::string output;
+    ReprocessResult result;
+};
+
+static Napi::Object ReprocessResultToObject(Napi::Env env, size_t meeting, const std::string& output,
+                                            const ReprocessResult& result) {
+    Napi::Object object = Napi::Object::New(env);
+    object.Set("meeting", Napi::Number::New(env, static_cast<double>(meeting)));
+    object.Set("output", Napi::String::New(env, output));
+    object.Set("ok", Napi::Boolean::New(env, result.ok));
+    if (!result.ok) {
+        object.Set("error", Napi::String::New(env, result.error));
+        return object;
+    }
+    object.Set("audioMs", Napi::Number::New(env, result.audio_ms));
+    object.Set("elapsedMs", Napi::Number::New(env, result.elapsed_ms));
+    object.Set("outputBytes", Napi::Number::New(env, static_cast<double>(result.output_bytes)));
+    object.Set("metrics", AECMetricsToObject(env, result.metrics));
+    return object;
+}
+
+// reprocessRecordings({ meetings: [{ microphone, system?, output }], aec?,
+// sampleRate?, onEvent? }) -> { done, cancel }. Each meeting runs the raw
+// mic against the system track through an AECProcessor of its own, built
+// from |aec| (the AudioCaptureAddon options shape), on the reprocessing
+// pool. onEvent gets { type: 'progress', meeting, fraction } and
+// { type: 'meeting', meeting, output, ok, error? | audioMs, elapsedMs,
+// outputBytes, metrics }. done resolves with every meeting's result, in
+// order, once all are finished; a failed meeting does not fail the rest.
+// cancel() fails whatever has not finished.
+static Napi::Value ReprocessNativeRecordings(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("meetings").IsArray()) {
+        Napi::TypeError::New(env, "Expected { meetings }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    Napi::Array meetings = options.Get("meetings").As<Napi::Array>();
+    const AECConfig config = ParseAECConfig(options.Get("aec"), AECConfig());
+    int sample_rate = 16000;
+    if (options.Get("sampleRate").IsNumber()) {
+        sample_rate = std::clamp(options.Get("sampleRate").As<Napi::Number>().Int32Value(), kMinReprocessRate,
+                                 kMaxReprocessRate) / 100 * 100;
+    }
+    std::vector<ReprocessJob> jobs;
+    for (uint32_t i = 0; i < meetings.Length(); ++i) {
+        Napi::Value entry = meetings.Get(i);
+        if (!entry.IsObject() || !entry.As<Napi::Object>().Get("microphone").IsString() ||
+            !entry.As<Napi::Object>().Get("output").IsString()) {
+            Napi::TypeError::New(env, "Each meeting needs microphone and output paths").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object meeting = entry.As<Napi::Object>();
+        ReprocessJob job;
+        job.microphone = meeting.Get("microphone").As<Napi::String>().Utf8Value();
+        if (meeting.Get("system").IsString()) {
+            job.system = meeting.Get("system").As<Napi::String>().Utf8Value();
+        }
+        job.output = meeting.Get("output").As<Napi::String>().Utf8Value();
+        job.config = config;
+        job.sample_rate = sample_rate;
+        jobs.push_back(std::move(job));
+    }
+
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    Napi::Object handle = Napi::Object::New(env);
+    handle.Set("cancel", Napi::Function::New(env, [cancel](const Napi::CallbackInfo&) {
+        cancel->store(true, std::memory_order_relaxed);
+    }, "cancel"));
+
+    auto* call = new ReprocessCall{Napi::Promise::Deferred::New(env), Napi::ThreadSafeFunction(), {}, {}, {}, jobs.size()};
+    handle.Set("done", call->deferred.Promise());
+    if (jobs.empty()) {
+        call->deferred.Resolve(Napi::Array::New(env));
+        delete call;
+        return handle;
+    }
+    Napi::Function on_event = options.Get("onEvent").IsFunction()
+        ? options.Get("onEvent").As<Napi::Function>()
+        : Napi::Function::New(env, [](const Napi::CallbackInfo&) {});
+    call->tsfn = Napi::ThreadSafeFunction::New(env, on_event, "ReprocessRecordings", 0, 1);
+    for (const ReprocessJob& job : jobs) {
+        call->outputs.push_back(job.output);
+    }
+    call->results.resize(jobs.size());
+
+    auto post = [call](ReprocessEvent* event) {
+        napi_status status = call->tsfn.NonBlockingCall(event, [](Napi::Env env, Napi::Function callback,
+                                                                  ReprocessEvent* posted) {
+            std::unique_ptr<ReprocessEvent> owned(posted);
+            Napi::Object value;
+            if (owned->done) {
+                value = ReprocessResultToObject(env, owned->meeting, owned->output, owned->result);
+                value.Set("type", Napi::String::New(env, "meeting"));
+            } else {
+                value = Napi::Object::New(env);
+                value.Set("type", Napi::String::New(env, "progress"));
+                value.Set("meeting", Napi::Number::New(env, static_cast<double>(owned->meeting)));
+                value.Set("fraction", Napi::Number::New(env, owned->fraction));
+            }
+            try {
+                callback.Call({ value });
+            } catch (...) {
+                // A throwing handler must not fail the jobs
+            }
+        });
+        if (status != napi_ok) {
+            delete event;
+        }
+    };
+
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    g_job_cancels.erase(std::remove_if(g_job_cancels.begin(), g_job_cancels.end(),
+                                             [](const std::weak_ptr<std::atomic<bool>>& entry) {
+                                                 return entry.expired();
+                                             }),
+                              g_job_cancels.end());
+    g_job_cancels.push_back(cancel);
+    TaskScheduler* scheduler = ModuleScheduler();
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const std::string output = jobs[i].output;
+        SubmitReprocess(scheduler, std::move(jobs[i]), cancel,
+            [post, i](double fraction) {
+                auto* event = new ReprocessEvent;
+                event->meeting = i;
+                event->fraction = fraction;
+                post(event);
+            },
+            [call, post, i, output](const ReprocessResult& result) {
+                auto* event = new ReprocessEvent;
+                event->meeting = i;
+                event->done = true;
+                event->output = output;
+                event->result = result;
+                post(event);
+
+                // The last meeting settles; |call| is the JS thread's once queued
+                {
+                    std::lock_guard<std::mutex> call_lock(call->mutex);
+                    call->results[i] = result;
+                    if (--call->remaining > 0) {
+                        return;
+                    }
+                }
+                Napi::ThreadSafeFunction tsfn = call->tsfn;
+                napi_status status = tsfn.NonBlockingCall(call, [](Napi::Env env, Napi::Function,
+                                                                   ReprocessCall* settled) {
+                    std::unique_ptr<ReprocessCall> owned(settled);
+                    Napi::Array results = Napi::Array::New(env, owned->results.size());
+                    for (size_t m = 0; m < owned->results.size(); ++m) {
+                        results.Set(static_cast<uint32_t>(m),
+                                    ReprocessResultToObject(env, m, owned->outputs[m], owned->results[m]));
+                    }
+                    owned->deferred.Resolve(results);
+                });
+                if (status != napi_ok) {
+                    delete call;  // the env is going away
+                }
+                tsfn.Release();
+            });
+    }
+    return handle;
+}
+
+// One exportBundle() call: settled on the JS thread through |tsfn|, which
+// also carries progress to the onProgress callback
+struct BundleCall {
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    BundleResult result;
+};
+
+// exportBundle({ output, entries?: [{ name, data }], tracks?: [{ name,
+// index }], mix?, sampleRate?, onProgress? }) -> { done, cancel }. Writes
+// a ZIP of |entries| (strings or Buffers, stored as they are), each track
+// as FLAC and, when |mix| names it, every track mixed into one FLAC; the
+// audio is encoded from the recording files on the module pool. done
+// resolves with { output, outputBytes, entries, audioMs, elapsedMs };
+// cancel() rejects it and leaves no file.
+static Napi::Value ExportNativeBundle(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("output").IsString()) {
+        Napi::TypeError::New(env, "Expected { output }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    BundleJob job;
+    job.output = options.Get("output").As<Napi::String>().Utf8Value();
+    if (options.Get("entries").IsArray()) {
+        Napi::Array entries = options.Get("entries").As<Napi::Array>();
+        for (uint32_t i = 0; i < entries.Length(); ++i) {
+            Napi::Value value = entries.Get(i);
+            if (!value.IsObject() || !value.As<Napi::Object>().Get("name").IsString() ||
+                !(value.As<Napi::Object>().Get("data").IsString() || value.As<Napi::Object>().Get("data").IsBuffer())) {
+                Napi::TypeError::New(env, "Each entry needs a name and string or Buffer data")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            Napi::Object entry = value.As<Napi::Object>();
+            Napi::Value data = entry.Get("data");
+            BundleEntry parsed;
+            parsed.name = entry.Get("name").As<Napi::String>().Utf8Value();
+            if (data.IsString()) {
+                parsed.data = data.As<Napi::String>().Utf8Value();
+            } else {
+                Napi::Buffer<uint8_t> buffer = data.As<Napi::Buffer<uint8_t>>();
+                parsed.data.assign(reinterpret_cast<const char*>(buffer.Data()), buffer.Length());
+            }
+            job.entries.push_back(std::move(parsed));
+        }
+    }
+    if (options.Get("tracks").IsArray()) {
+        Napi::Array tracks = options.Get("tracks").As<Napi::Array>();
+        for (uint32_t i = 0; i < tracks.Length(); ++i) {
+            Napi::Value value = tracks.Get(i);
+            if (!value.IsObject() || !value.As<Napi::Object>().Get("name").IsString() ||
+                !value.As<Napi::Object>().Get("index").IsString()) {
+                Napi::TypeError::New(env, "Each track needs a name and an index path").ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            Napi::Object track = value.As<Napi::Object>();
+            job.tracks.push_back({track.Get("name").As<Napi::String>().Utf8Value(),
+                                  track.Get("index").As<Napi::String>().Utf8Value()});
+        }
+    }
+    if (options.Get("mix").IsString()) {
+        job.mix = options.Get("mix").As<Napi::String>().Utf8Value();
+    }
+    if (options.Get("sampleRate").IsNumber()) {
+        job.sample_rate = std::clamp(options.Get("sampleRate").As<Napi::Number>().Int32Value(), kMinBundleRate,
+                                     kMaxBundleRate) / 100 * 100;
+    }
+
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    Napi::Object handle = Napi::Object::New(env);
+    handle.Set("cancel", Napi::Function::New(env, [cancel](const Napi::CallbackInfo&) {
+        cancel->store(true, std::memory_order_relaxed);
+    }, "cancel"));
+
+    Napi::Function progress = options.Get("onProgress").IsFunction()
+        ? options.Get("onProgress").As<Napi::Function>()
+        : Napi::Function::New(env, [](const Napi::CallbackInfo&) {});
+    auto* call = new BundleCall{Napi::Promise::Deferred::New(env), Napi::ThreadSafeFunction(), {}};
+    call->tsfn = Napi::ThreadSafeFunction::New(env, progress, "ExportBundle", 0, 1);
+    handle.Set("done", call->deferred.Promise());
+
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    g_job_cancels.erase(std::remove_if(g_job_cancels.begin(), g_job_cancels.end(),
+                                       [](const std::weak_ptr<std::atomic<bool>>& entry) {
+                                           return entry.expired();
+                                       }),
+                        g_job_cancels.end());
+    g_job_cancels.push_back(cancel);
+    std::string output = job.output;
+    SubmitBundleExport(ModuleScheduler(), std::move(job), cancel,
+        [call](double fraction) {
+            double* value = new double(fraction);
+            napi_status status = call->tsfn.NonBlockingCall(value, [](Napi::Env env, Napi::Function callback,
+                                                                      double* reported) {
+                std::unique_ptr<double> owned(reported);
+                try {
+                    callback.Call({ Napi::Number::New(env, *owned) });
+                } catch (...) {
+                    // A throwing progress handler must not fail the job
+                }
+            });
+            if (status != napi_ok) {
+                delete value;
+            }
+        },
+        [call, output](const BundleResult& result) {
+            call->result = result;
+            // |call| is the JS thread's once queued
+            Napi::ThreadSafeFunction tsfn = call->tsfn;
+            napi_status status = tsfn.NonBlockingCall(call, [output](Napi::Env env, Napi::Function,
+                                                                     BundleCall* settled) {
+                std::unique_ptr<BundleCall> owned(settled);
+                const BundleResult& done = owned->result;
+                if (!done.ok) {
+                    owned->deferred.Reject(Napi::Error::New(env, done.error).Value());
+                    return;
+                }
+                Napi::Object value = Napi::Object::New(env);
+                value.Set("output", Napi::String::New(env, output));
+                value.Set("outputBytes", Napi::Number::New(env, static_cast<double>(done.output_bytes)));
+                value.Set("entries", Napi::Number::New(env, static_cast<double>(done.entries)));
+                value.Set("audioMs", Napi::Number::New(env, done.audio_ms));
+                value.Set("elapsedMs", Napi::Number::New(env, done.elapsed_ms));
+                owned->deferred.Resolve(value);
+            });
+            if (status != napi_ok) {
+                delete call;  // the env is going away
+            }
+            tsfn.Release();
+        });
+    return handle;
+}
+
+// One preloadDsp() call
+struct DspCall {
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    bool loaded = false;
+};
+
+// preloadDsp() -> Promise<boolean>: maps the kakarot_dsp module off the JS
+// thread, so the first AEC does not pay for it at capture start; false when
+// it is missing (the AEC then runs its fallback). The first AEC loads it
+// anyway if this was never called.
+static Napi::Value PreloadDsp(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto* call = new DspCall{Napi::Promise::Deferred::New(env), Napi::ThreadSafeFunction(), false};
+    call->tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                               "PreloadDsp", 0, 1);
+    Napi::Promise promise = call->deferred.Promise();
+
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    ModuleScheduler()->Post(TaskPriority::kInteractive, [call](const std::atomic<bool>&) {
+        call->loaded = DspModule() != nullptr;
+        Napi::ThreadSafeFunction tsfn = call->tsfn;
+        napi_status status = tsfn.NonBlockingCall(call, [](Napi::Env env, Napi::Function, DspCall* settled) {
+            std::unique_ptr<DspCall> owned(settled);
+            owned->deferred.Resolve(Napi::Boolean::New(env, owned->loaded));
+        });
+        if (status != napi_ok) {
+            delete call;  // the env is going away
+        }
+        tsfn.Release();
+    });
+    return promise;
+}
+
+// getCpuFeatures() -> { arch, translated, sse2, avx2, fma, neon, kernels:
+// [{ name, level, specialized }] }: the SIMD path each kernel family runs,
+// read once. |translated| is an x86_64 build under Rosetta or Windows on Arm.
+static Napi::Value GetNativeCpuFeatures(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    const CpuFeatures& features = GetCpuFeatures();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("arch", Napi::String::New(env, features.arch));
+    result.Set("translated", Napi::Boolean::New(env, features.translated));
+    result.Set("sse2", Napi::Boolean::New(env, features.sse2));
+    result.Set("avx2", Napi::Boolean::New(env, features.avx2));
+    result.Set("fma", Napi::Boolean::New(env, features.fma));
+    result.Set("neon", Napi::Boolean::New(env, features.neon));
+    Napi::Array kernels = Napi::Array::New(env, features.kernels.size());
+    for (size_t i = 0; i < features.kernels.size(); ++i) {
+        const CpuFeatures::Kernel& kernel = features.kernels[i];
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("name", Napi::String::New(env, kernel.name));
+        entry.Set("level", Napi::String::New(env, kernel.level));
+        entry.Set("specialized", Napi::Boolean::New(env, kernel.specialized));
+        kernels.Set(static_cast<uint32_t>(i), entry);
+    }
+    result.Set("kernels", kernels);
+    return result;
+}
+
+// getSchedulerStats() -> { threads, interactiveThreads, queueDepth, queued,
+// running, completed, steals, yields, yieldMs, audioAtRisk }, the per-class
+// counts as { realtime, interactive, background }. All zero before the
+// scheduler's first job.
+static Napi::Value GetSchedulerStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    TaskScheduler::Stats stats{};
+    {
+        std::lock_guard<std::mutex> lock(g_module_mutex);
+        if (g_scheduler) {
+            stats = g_scheduler->GetStats();
+        } else {
+            stats.audio_at_risk = TaskScheduler::AudioDeadlinesAtRisk();
+        }
+    }
+    auto per_class = [&env](const uint64_t* counts) {
+        Napi::Object object = Napi::Object::New(env);
+        object.Set("realtime", Napi::Number::New(env, static_cast<double>(counts[0])));
+        object.Set("interactive", Napi::Number::New(env, static_cast<double>(counts[1])));
+        object.Set("background", Napi::Number::New(env, static_cast<double>(counts[2])));
+        return object;
+    };
+    uint64_t depth = 0;
+    for (uint64_t queued : stats.queued) {
+        depth += queued;
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("threads", Napi::Number::New(env, static_cast<double>(stats.threads)));
+    result.Set("interactiveThreads", Napi::Number::New(env, static_cast<double>(stats.interactive_threads)));
+    result.Set("queueDepth", Napi::Number::New(env, static_cast<double>(depth)));
+    result.Set("queued", per_class(stats.queued));
+    result.Set("running", per_class(stats.running));
+    result.Set("completed", per_class(stats.completed));
+    result.Set("steals", Napi::Number::New(env, static_cast<double>(stats.steals)));
+    result.Set("yields", Napi::Number::New(env, static_cast<double>(stats.yields)));
+    result.Set("yieldMs", Napi::Number::New(env, stats.yield_ms));
+    result.Set("audioAtRisk", Napi::Boolean::New(env, stats.audio_at_risk));
+    return result;
+}
+
+// getWakeupStats() -> [{ name, wakeups, perSecond }], one per kind of native
+// thread; the rates are since the previous call. All zero per second while
+// the addon is stopped, or paused with no device IO (pipeline_stress checks
+// this). The recording and session capture writers still drain on a timer
+// (10/s each), which is idle-safe only because they exit with their session:
+// a nonzero recordingWriter or sessionCaptureWriter rate while one runs is
+// expected, not an idle regression.
+static Napi::Value GetNativeWakeupStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<WakeupStat> stats = GetWakeupStats();
+    Napi::Array result = Napi::Array::New(env, stats.size());
+    for (size_t i = 0; i < stats.size(); ++i) {
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("name", Napi::String::New(env, stats[i].name));
+        entry.Set("wakeups", Napi::Number::New(env, static_cast<double>(stats[i].wakeups)));
+        entry.Set("perSecond", Napi::Number::New(env, stats[i].per_second));
+        result.Set(static_cast<uint32_t>(i), entry);
+    }
+    return result;
+}
+
+// getNativeMemory() -> { rssBytes, pressure: 'normal' | 'warning' |
+// 'critical', components: [{ name, bytes }] }, one component per open
+// capture stream
+static Napi::Value GetNativeMemory(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    const char* pressure = "normal";
+    switch (CurrentMemoryPressure()) {
+        case MemoryPressure::kWarning: pressure = "warning"; break;
+        case MemoryPressure::kCritical: pressure = "critical"; break;
+        default: break;
+    }
+    std::vector<MemoryUsage> usage = MemoryComponentUsage();
+    Napi::Array components = Napi::Array::New(env, usage.size());
+    for (size_t i = 0; i < usage.size(); ++i) {
+        Napi::Object component = Napi::Object::New(env);
+        component.Set("name", Napi::String::New(env, usage[i].name));
+        component.Set("bytes", Napi::Number::New(env, static_cast<double>(usage[i].bytes)));
+        components.Set(static_cast<uint32_t>(i), component);
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("rssBytes", Napi::Number::New(env, static_cast<double>(ResidentBytes())));
+    result.Set("pressure", Napi::String::New(env, pressure));
+    result.Set("components", components);
+    return result;
+}
+
+// setMemoryMinimums({ idleSlabs?, prerollMs? }): what components shrink to
+// under memory pressure; omitted fields keep their values
+static Napi::Value SetNativeMemoryMinimums(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected minimums object").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    MemoryMinimums minimums = GetMemoryMinimums();
+    if (options.Has("idleSlabs")) {
+        Napi::Value value = options.Get("idleSlabs");
+        if (!value.IsNumber() || value.As<Napi::Number>().DoubleValue() < 0) {
+            Napi::TypeError::New(env, "idleSlabs must be a non-negative number").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        minimums.idle_slabs = static_cast<size_t>(value.As<Napi::Number>().DoubleValue());
+    }
+    if (options.Has("prerollMs")) {
+        Napi::Value value = options.Get("prerollMs");
+        if (!value.IsNumber() || value.As<Napi::Number>().DoubleValue() < 0) {
+            Napi::TypeError::New(env, "prerollMs must be a non-negative number").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        minimums.preroll_ms = value.As<Napi::Number>().DoubleValue();
+    }
+    SetMemoryMinimums(minimums);
+    return env.Undefined();
+}
+
+// What one call on an ingestion's tsfn carries, in the ingester's order
+struct IngestEvent {
+    enum class Type { kRemove, kBatch, kDone } type = Type::kRemove;
+    std::string prefix;
+    std::string path;
+    KnowledgeBatch batch;
+    KnowledgeIngestStats stats;
+};
+
+struct IngestCall {
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    Napi::FunctionReference on_remove;
+    Napi::FunctionReference on_batch;
+    std::shared_ptr<KnowledgeIngester> ingester;
+};
+
+static Napi::Object IngestStatsToObject(Napi::Env env, const KnowledgeIngestStats& stats) {
+    Napi::Object object = Napi::Object::New(env);
+    object.Set("documents", Napi::Number::New(env, static_cast<double>(stats.documents)));
+    object.Set("unchanged", Napi::Number::New(env, static_cast<double>(stats.unchanged)));
+    object.Set("indexed", Napi::Number::New(env, static_cast<double>(stats.indexed)));
+    object.Set("removed", Napi::Number::New(env, static_cast<double>(stats.removed)));
+    object.Set("failed", Napi::Number::New(env, static_cast<double>(stats.failed)));
+    object.Set("chunks", Napi::Number::New(env, static_cast<double>(stats.chunks)));
+    object.Set("batches", Napi::Number::New(env, static_cast<double>(stats.batches)));
+    object.Set("elapsedMs", Napi::Number::New(env, stats.elapsed_ms));
+    object.Set("cancelled", Napi::Boolean::New(env, stats.cancelled));
+    return object;
+}
+
+// onBatch's answer: a promise acknowledges the batch when it settles,
+// anything else at once; a throw or a rejection fails it
+static void AckIngestBatch(Napi::Env env, Napi::Value result, const std::shared_ptr<KnowledgeIngester>& ingester,
+                           uint64_t batch) {
+    if (env.IsExceptionPending()) {
+        env.GetAndClearPendingException();
+        ingester->Ack(batch, false);
+        return;
+    }
+    if (!result.IsPromise()) {
+        ingester->Ack(batch, true);
+        return;
+    }
+    Napi::Object promise = result.As<Napi::Object>();
+    Napi::Function resolved = Napi::Function::New(env, [ingester, batch](const Napi::CallbackInfo&) {
+        ingester->Ack(batch, true);
+    });
+    Napi::Function rejected = Napi::Function::New(env, [ingester, batch](const Napi::CallbackInfo&) {
+        ingester->Ack(batch, false);
+    });
+    promise.Get("then").As<Napi::Function>().Call(promise, { resolved, rejected });
+}
+
+// ingestKnowledge({ root, manifest, onBatch, onRemove, threads?, chunkBytes?,
+// overlapBytes?, batchChunks?, maxInFlight? }) -> { done, cancel } brings
+// an embedding store in line with a knowledge-base folder. onRemove(prefix,
+// path) asks for a document's old chunks to go; onBatch({ id, chunks: [{ id,
+// path, index, text }] }) hands over chunks to embed, and no more than
+// maxInFlight batches are out until the promises it returns settle. done
+// resolves with { documents, unchanged, indexed, removed, failed, chunks,
+// batches, elapsedMs, cancelled } and rejects only when root is not a
+// folder.
+static Napi::Value IngestKnowledge(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected { root, manifest, onBatch, onRemove }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Get("root").IsString() || !options.Get("manifest").IsString() ||
+        !options.Get("onBatch").IsFunction() || !options.Get("onRemove").IsFunction()) {
+        Napi::TypeError::New(env, "Expected { root, manifest, onBatch, onRemove }").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    KnowledgeIngestOptions ingest;
+    ingest.root = options.Get("root").As<Napi::String>().Utf8Value();
+    ingest.manifest = options.Get("manifest").As<Napi::String>().Utf8Value();
+    auto count = [&](const char* name, size_t fallback) {
+        Napi::Value value = options.Get(name);
+        return value.IsNumber() ? static_cast<size_t>(std::max(0.0, value.As<Napi::Number>().DoubleValue()))
+                                : fallback;
+    };
+    ingest.threads = count("threads", ingest.threads);
+    ingest.chunk_bytes = count("chunkBytes", ingest.chunk_bytes);
+    ingest.overlap_bytes = count("overlapBytes", ingest.overlap_bytes);
+    ingest.batch_chunks = count("batchChunks", ingest.batch_chunks);
+    ingest.max_in_flight = count("maxInFlight", ingest.max_in_flight);
+
+    auto* call = new IngestCall{Napi::Promise::Deferred::New(env), Napi::ThreadSafeFunction(),
+                                Napi::Persistent(options.Get("onRemove").As<Napi::Function>()),
+                                Napi::Persistent(options.Get("onBatch").As<Napi::Function>()),
+                                std::make_shared<KnowledgeIngester>()};
+    Napi::Object handle = Napi::Object::New(env);
+    handle.Set("done", call->deferred.Promise());
+    std::shared_ptr<KnowledgeIngester> ingester = call->ingester;
+    handle.Set("cancel", Napi::Function::New(env, [ingester](const Napi::CallbackInfo&) {
+        ingester->Cancel();
+    }, "cancel"));
+    // One tsfn for all three, so removals land before the batches after them
+    call->tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                               "IngestKnowledge", 0, 1);
+
+    auto deliver = [](Napi::Env env, Napi::Function, IngestEvent* posted, IngestCall* call) {
+        std::unique_ptr<IngestEvent> event(posted);
+        switch (event->type) {
+            case IngestEvent::Type::kRemove:
+                call->on_remove.Call({ Napi::String::New(env, event->prefix), Napi::String::New(env, event->path) });
+                if (env.IsExceptionPending()) {
+                    env.GetAndClearPendingException();  // a throwing handler must not stop the run
+                }
+                break;
+            case IngestEvent::Type::kBatch: {
+                Napi::Array chunks = Napi::Array::New(env, event->batch.chunks.size());
+                for (size_t i = 0; i < event->batch.chunks.size(); ++i) {
+                    const KnowledgeChunk& chunk = event->batch.chunks[i];
+                    Napi::Object object = Napi::Object::New(env);
+                    object.Set("id", Napi::String::New(env, chunk.id));
+                    object.Set("path", Napi::String::New(env, chunk.path));
+                    object.Set("index", Napi::Number::New(env, chunk.index));
+                    object.Set("text", Napi::String::New(env, chunk.text));
+                    chunks.Set(static_cast<uint32_t>(i), object);
+                }
+                Napi::Object batch = Napi::Object::New(env);
+                batch.Set("id", Napi::Number::New(env, static_cast<double>(event->batch.id)));
+                batch.Set("chunks", chunks);
+                AckIngestBatch(env, call->on_batch.Call({ batch }), call->ingester, event->batch.id);
+                break;
+            }
+            case IngestEvent::Type::kDone: {
+                std::unique_ptr<IngestCall> owned(call);
+                if (event->stats.error.empty()) {
+                    owned->deferred.Resolve(IngestStatsToObject(env, event->stats));
+                } else {
+                    owned->deferred.Reject(Napi::Error::New(env, event->stats.error).Value());
+                }
+                break;
+            }
+        }
+    };
+    auto post = [call, deliver](IngestEvent* event) {
+        // Copied first: once done is delivered, |call| is gone
+        Napi::ThreadSafeFunction tsfn = call->tsfn;
+        bool done = event->type == IngestEvent::Type::kDone;
+        napi_status status = tsfn.NonBlockingCall(event, [call, deliver](Napi::Env env, Napi::Function callback,
+                                                                         IngestEvent* posted) {
+            deliver(env, callback, posted, call);
+        });
+        if (status != napi_ok) {
+            // The env is going away. |call| is left: its ingester is on the
+            // stack of the thread posting this, which cannot join itself.
+            delete event;
+        }
+        if (done) {
+            tsfn.Release();
+        }
+    };
+
+    KnowledgeIngestCallbacks callbacks;
+    callbacks.remove = [post](const std::string& prefix, const std::string& path) {
+        auto* event = new IngestEvent;
+        event->prefix = prefix;
+        event->path = path;
+        post(event);
+    };
+    callbacks.batch = [post](KnowledgeBatch batch) {
+        auto* event = new IngestEvent;
+        event->type = IngestEvent::Type::kBatch;
+        event->batch = std::move(batch);
+        post(event);
+    };
+    callbacks.done = [post](const KnowledgeIngestStats& stats) {
+        auto* event = new IngestEvent;
+        event->type = IngestEvent::Type::kDone;
+        event->stats = stats;
+        post(event);
+    };
+    std::string error;
+    if (!ingester->Start(ingest, std::move(callbacks), &error)) {
+        call->tsfn.Release();
+        call->deferred.Reject(Napi::Error::New(env, error).Value());
+        delete call;
+    }
+    return handle;
+}
+
+// An ArrayBuffer over |bytes| at |data| that keeps |owner| alive until it is
+// collected. Electron's V8 sandbox refuses external buffers, and there the
+// bytes are copied.
+static Napi::ArrayBuffer ExternalArrayBuffer(Napi::Env env, const void* data, size_t bytes,
+                                             std::shared_ptr<const void> owner) {
+    if (bytes == 0) {
+        return Napi::ArrayBuffer::New(env, 0);
+    }
+    napi_value buffer = nullptr;
+    auto* keep = new std::shared_ptr<const void>(std::move(owner));
+    napi_status status = napi_create_external_arraybuffer(
+        env, const_cast<void*>(data), bytes,
+        [](napi_env, void*, void* hint) { delete static_cast<std::shared_ptr<const void>*>(hint); },
+        keep, &buffer);
+    if (status == napi_ok) {
+        return Napi::ArrayBuffer(env, buffer);
+    }
+    delete keep;
+    Napi::ArrayBuffer copy = Napi::ArrayBuffer::New(env, bytes);
+    std::memcpy(copy.Data(), data, bytes);
+    return copy;
+}
+
+// A graph stage's JS spec, { type, enabled?, ...fields }, appending its
+// enabled flag. Unknown fields keep the defaults; aec/ns/agc take the AEC
+// config fields.
+static StageSpec ParseStageSpec(const Napi::Value& value, std::vector<bool>* enabled) {
+    StageSpec spec;
+    if (!value.IsObject()) {
+        enabled->push_back(true);
+        return spec;
+    }
+    Napi::Object stage = value.As<Napi::Object>();
+    auto number = [&](const char* key, double fallback) {
+        return stage.Get(key).IsNumber() ? stage.Get(key).As<Napi::Number>().DoubleValue() : fallback;
+    };
+    if (stage.Get("type").IsString()) {
+        spec.type = stage.Get("type").As<Napi::String>().Utf8Value();
+    }
+    if (stage.Get("enabled").IsBoolean()) {
+        spec.enabled = stage.Get("enabled").As<Napi::Boolean>().Value();
+    }
+    spec.output_sample_rate = static_cast<int>(number("outputSampleRate", spec.output_sample_rate));
+    // cutoffHz reads as frequencyHz, for the high-/low-pass shorthands
+    spec.frequency_hz = static_cast<float>(number("frequencyHz", number("cutoffHz", spec.frequency_hz)));
+    if (stage.Get("filter").IsString()) {
+        std::string name = stage.Get("filter").As<Napi::String>().Utf8Value();
+        for (const auto& entry : kBiquadNames) {
+            if (name == entry.name) {
+                spec.biquad = entry.kind;
+            }
+        }
+    }
+    spec.q = static_cast<float>(std::max(0.1, std::min(number("q", spec.q), 20.0)));
+    spec.gain_db = static_cast<float>(std::max(-24.0, std::min(number("gainDb", spec.gain_db), 24.0)));
+    spec.order = static_cast<int>(number("order", spec.order));
+    spec.taps = static_cast<int>(number("taps", spec.taps));
+    if (stage.Get("coefficients").IsArray()) {
+        Napi::Array coefficients = stage.Get("coefficients").As<Napi::Array>();
+        for (uint32_t i = 0; i < coefficients.Length(); ++i) {
+            Napi::Value coefficient = coefficients.Get(i);
+            spec.coefficients.push_back(coefficient.IsNumber() ? coefficient.As<Napi::Number>().FloatValue() : 0.0f);
+        }
+    }
+    spec.apm = ParseAECConfig(stage, AECConfig());
+    if (stage.Get("model").IsString()) {
+        spec.model_path = stage.Get("model").As<Napi::String>().Utf8Value();
+    }
+    spec.target_dbfs = static_cast<float>(std::max(kMinNormalizeTargetDbfs,
+        std::min(number("targetDbfs", spec.target_dbfs), kMaxNormalizeTargetDbfs)));
+    spec.gate_threshold = static_cast<float>(std::max(0.0, std::min(number("threshold", spec.gate_threshold), 1.0)));
+    spec.gate_hangover_ms = std::max(0.0, number("hangoverMs", spec.gate_hangover_ms));
+    spec.bitrate = static_cast<int>(std::max(kMinOpusBitrate, std::min(number("bitrate", spec.bitrate), kMaxOpusBitrate)));
+    if (stage.Get("dtx").IsBoolean()) {
+        spec.dtx = stage.Get("dtx").As<Napi::Boolean>().Value();
+    }
+    spec.dtx_threshold = static_cast<float>(std::max(0.0, std::min(number("dtxThreshold", spec.dtx_threshold), 1.0)));
+    if (stage.Get("container").IsString()) {
+        spec.ogg = stage.Get("container").As<Napi::String>().Utf8Value() != "raw";
+    }
+    enabled->push_back(spec.enabled);
+    return spec;
+}
+
+class ProcessingGraphWrap;
+
+// Every live graph, for getThreadCpu(); each env reads only its own
+static std::mutex g_graphs_mutex;
+static std::vector<ProcessingGraphWrap*> g_graphs;
+
+// new ProcessingGraph({ sampleRate, stages: [{ type, enabled?, ...fields }],
+// outputs?: [{ name, after?, sampleRate?, format?, ...opus fields }] }) builds
+// the chain once; process() then runs a whole buffer through it with one
+// N-API call. An output taps the stream after |after| stages (a count, or
+// the type of the stage it follows; default the graph's end) as 'f32'
+// (default), 's16' or 'opus' at its own rate. Lives on the JS thread that
+// made it.
+class ProcessingGraphWrap : public Napi::ObjectWrap<ProcessingGraphWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "ProcessingGraph", {
+            InstanceMethod("process", &ProcessingGraphWrap::Process),
+            InstanceMethod("processRender", &ProcessingGraphWrap::ProcessRender),
+            InstanceMethod("setStageEnabled", &ProcessingGraphWrap::SetStageEnabled),
+            InstanceMethod("getStats", &ProcessingGraphWrap::GetStats),
+            InstanceMethod("reset", &ProcessingGraphWrap::Reset),
+        });
+    }
+
+    ~ProcessingGraphWrap() {
+        std::lock_guard<std::mutex> lock(g_graphs_mutex);
+        g_graphs.erase(std::remove(g_graphs.begin(), g_graphs.end(), this), g_graphs.end());
+    }
+
+    napi_env OwnerEnv() const { return env_; }
+    const ProcessingGraph& Graph() const { return graph_; }
+
+    explicit ProcessingGraphWrap(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<ProcessingGraphWrap>(info), env_(info.Env()) {
+        Napi::Env env = info.Env();
+        {
+            std::lock_guard<std::mutex> lock(g_graphs_mutex);
+            g_graphs.push_back(this);
+        }
+        if (info.Length() < 1 || !info[0].IsObject()) {
+            Napi::TypeError::New(env, "Expected { sampleRate, stages }").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = info[0].As<Napi::Object>();
+        int sample_rate = options.Get("sampleRate").IsNumber()
+            ? options.Get("sampleRate").As<Napi::Number>().Int32Value() : 48000;
+        if (!options.Get("stages").IsArray()) {
+            Napi::TypeError::New(env, "stages must be an array").ThrowAsJavaScriptException();
+            return;
+        }
+
+        Napi::Array specs = options.Get("stages").As<Napi::Array>();
+        std::vector<std::unique_ptr<ProcessingStage>> stages;
+        std::vector<bool> enabled;
+        for (uint32_t i = 0; i < specs.Length(); ++i) {
+            std::string error;
+            std::unique_ptr<ProcessingStage> stage = CreateStage(ParseStageSpec(specs.Get(i), &enabled), &error);
+            if (!stage) {
+                Napi::TypeError::New(env, "stage " + std::to_string(i) + ": " + error).ThrowAsJavaScriptException();
+                return;
+            }
+            stages.push_back(std::move(stage));
+        }
+
+        std::string error;
+        if (!graph_.Build(sample_rate, std::move(stages), enabled, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+
+        if (options.Get("outputs").IsArray()) {
+            Napi::Array outputs = options.Get("outputs").As<Napi::Array>();
+            for (uint32_t i = 0; i < outputs.Length(); ++i) {
+                TapSpec tap;
+                if (!ParseTapSpec(outputs.Get(i), &tap, &error) || !graph_.AddTap(tap, &error)) {
+                    Napi::TypeError::New(env, "output " + std::to_string(i) + ": " + error)
+                        .ThrowAsJavaScriptException();
+                    return;
+                }
+            }
+        }
+    }
+
+private:
+    // The opus fields read as an opus stage's would
+    bool ParseTapSpec(const Napi::Value& value, TapSpec* tap, std::string* error) {
+        if (!value.IsObject() || !value.As<Napi::Object>().Get("name").IsString()) {
+            *error = "expected { name }";
+            return false;
+        }
+        Napi::Object output = value.As<Napi::Object>();
+        tap->name = output.Get("name").As<Napi::String>().Utf8Value();
+        Napi::Value after = output.Get("after");
+        if (after.IsNumber()) {
+            tap->after = static_cast<size_t>(std::max<int64_t>(0, after.As<Napi::Number>().Int64Value()));
+        } else if (after.IsString()) {
+            std::string type = after.As<Napi::String>().Utf8Value();
+            size_t i = 0;
+            while (i < graph_.StageCount() && type != graph_.Stats(i).type) {
+                ++i;
+            }
+            if (i == graph_.StageCount()) {
+                *error = "no '" + type + "' stage to follow";
+                return false;
+            }
+            tap->after = i + 1;
+        }
+        if (output.Get("sampleRate").IsNumber()) {
+            tap->sample_rate = output.Get("sampleRate").As<Napi::Number>().Int32Value();
+        }
+        std::string format = output.Get("format").IsString() ? output.Get("format").As<Napi::String>().Utf8Value()
+                                                             : "f32";
+        if (format == "s16") {
+            tap->format = TapFormat::kPcm16;
+        } else if (format == "opus") {
+            tap->format = TapFormat::kOpus;
+        } else if (format != "f32") {
+            *error = "format must be 'f32', 's16' or 'opus'";
+            return false;
+        }
+        std::vector<bool> enabled;
+        tap->opus = ParseStageSpec(output, &enabled);
+        return true;
+    }
+
+    // process(Float32Array) -> { samples?: Float32Array, pcm16?: Int16Array,
+    // encoded?: Buffer, encodedSizes?: Uint32Array, vad?: Float32Array,
+    // outputs?: { [name]: tap }, droppedFrames, sampleRate }
+    Napi::Value Process(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsTypedArray() ||
+            info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float32_array) {
+            Napi::TypeError::New(env, "Expected Float32Array").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Float32Array input = info[0].As<Napi::Float32Array>();
+        graph_.Process(input.Data(), input.ElementLength(), &output_);
+
+        Napi::Object result = Napi::Object::New(env);
+        if (!output_.samples.empty() || (output_.pcm16.empty() && output_.encoded.empty())) {
+            Napi::Float32Array samples = Napi::Float32Array::New(env, output_.samples.size());
+            std::copy(output_.samples.begin(), output_.samples.end(), samples.Data());
+            result.Set("samples", samples);
+        }
+        if (!output_.pcm16.empty()) {
+            Napi::Int16Array pcm16 = Napi::Int16Array::New(env, output_.pcm16.size());
+            std::copy(output_.pcm16.begin(), output_.pcm16.end(), pcm16.Data());
+            result.Set("pcm16", pcm16);
+        }
+        if (!output_.encoded.empty()) {
+            result.Set("encoded", Napi::Buffer<uint8_t>::Copy(env, output_.encoded.data(), output_.encoded.size()));
+            Napi::Uint32Array sizes = Napi::Uint32Array::New(env, output_.encoded_sizes.size());
+            std::copy(output_.encoded_sizes.begin(), output_.encoded_sizes.end(), sizes.Data());
+            result.Set("encodedSizes", sizes);
+        }
+        if (!output_.vad.empty()) {
+            Napi::Float32Array vad = Napi::Float32Array::New(env, output_.vad.size());
+            std::copy(output_.vad.begin(), output_.vad.end(), vad.Data());
+            result.Set("vad", vad);
+        }
+        if (graph_.TapCount() > 0) {
+            Napi::Object outputs = Napi::Object::New(env);
+            for (size_t i = 0; i < graph_.TapCount(); ++i) {
+                outputs.Set(graph_.Tap(i).name, TapToObject(env, i));
+            }
+            result.Set("outputs", outputs);
+        }
+        result.Set("droppedFrames", Napi::Number::New(env, static_cast<double>(output_.dropped_frames)));
+        result.Set("sampleRate", Napi::Number::New(env, graph_.OutputSampleRate()));
+        return result;
+    }
+
+    // { samples | pcm16 | encoded + encodedSizes, sampleRate }, viewing the
+    // tap's buffer rather than a copy; the graph starts another while JS
+    // holds this one
+    Napi::Object TapToObject(Napi::Env env, size_t index) {
+        const TapOutput& tap = output_.taps[index];
+        const std::vector<uint8_t>& data = *tap.data;
+        Napi::ArrayBuffer buffer = ExternalArrayBuffer(env, data.data(), data.size(), tap.data);
+        Napi::Object result = Napi::Object::New(env);
+        switch (graph_.Tap(index).format) {
+            case TapFormat::kFloat32:
+                result.Set("samples", Napi::Float32Array::New(env, data.size() / sizeof(float), buffer, 0));
+                break;
+            case TapFormat::kPcm16:
+                result.Set("pcm16", Napi::Int16Array::New(env, data.size() / sizeof(int16_t), buffer, 0));
+                break;
+            case TapFormat::kOpus: {
+                result.Set("encoded", Napi::Uint8Array::New(env, data.size(), buffer, 0));
+                Napi::Uint32Array sizes = Napi::Uint32Array::New(env, tap.encoded_sizes.size());
+                std::copy(tap.encoded_sizes.begin(), tap.encoded_sizes.end(), sizes.Data());
+                result.Set("encodedSizes", sizes);
+                break;
+            }
+        }
+        result.Set("sampleRate", Napi::Number::New(env, graph_.TapSampleRate(index)));
+        return result;
+    }
+
+    Napi::Value ProcessRender(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsTypedArray() ||
+            info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float32_array) {
+            Napi::TypeError::New(env, "Expected Float32Array").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Float32Array render = info[0].As<Napi::Float32Array>();
+        graph_.ProcessRender(render.Data(), render.ElementLength());
+        return env.Undefined();
+    }
+
+    Napi::Value SetStageEnabled(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsBoolean()) {
+            Napi::TypeError::New(env, "Expected (index, enabled)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        int64_t index = info[0].As<Napi::Number>().Int64Value();
+        bool enabled = info[1].As<Napi::Boolean>().Value();
+        return Napi::Boolean::New(env, index >= 0 && graph_.SetStageEnabled(static_cast<size_t>(index), enabled));
+    }
+
+    // One entry per stage, in graph order
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Array result = Napi::Array::New(env, graph_.StageCount());
+        for (size_t i = 0; i < graph_.StageCount(); ++i) {
+            const GraphStageStats& stats = graph_.Stats(i);
+            Napi::Object stage = Napi::Object::New(env);
+            stage.Set("type", Napi::String::New(env, stats.type));
+            stage.Set("enabled", Napi::Boolean::New(env, stats.enabled));
+            stage.Set("inputSampleRate", Napi::Number::New(env, stats.input_rate));
+            stage.Set("outputSampleRate", Napi::Number::New(env, stats.output_rate));
+            stage.Set("frames", Napi::Number::New(env, static_cast<double>(stats.frames)));
+            stage.Set("cpuMs", Napi::Number::New(env, stats.cpu_ns / 1e6));
+            stage.Set("wallMs", Napi::Number::New(env, stats.total_ns / 1e6));
+            stage.Set("meanUs", Napi::Number::New(env, stats.frames > 0 ? stats.total_ns / 1e3 / stats.frames : 0.0));
+            stage.Set("maxUs", Napi::Number::New(env, stats.max_ns / 1e3));
+            result.Set(static_cast<uint32_t>(i), stage);
+        }
+        return result;
+    }
+
+    Napi::Value Reset(const Napi::CallbackInfo& info) {
+        graph_.Reset();
+        return info.Env().Undefined();
+    }
+
+    napi_env env_;
+    ProcessingGraph graph_;
+    GraphOutput output_;
+};
+
+// getThreadCpu() -> { threads: [{ name, tid, cpuMs }], exited: [{ name,
+// threads, cpuMs }], stages: [{ type, graphs, frames, cpuMs }] }: each named
+// native thread's CPU time, running or summed per name once exited, and
+// this env's live ProcessingGraph stages summed by type. Threads the addon
+// did not start (V8, libuv, the OS audio IO) are not in it.
+static Napi::Value GetNativeThreadCpu(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    ThreadCpuSnapshot snapshot = GetThreadCpu();
+    Napi::Object result = Napi::Object::New(env);
+
+    Napi::Array threads = Napi::Array::New(env, snapshot.threads.size());
+    for (size_t i = 0; i < snapshot.threads.size(); ++i) {
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("name", Napi::String::New(env, snapshot.threads[i].name));
+        entry.Set("tid", Napi::Number::New(env, static_cast<double>(snapshot.threads[i].tid)));
+        entry.Set("cpuMs", Napi::Number::New(env, snapshot.threads[i].cpu_ns / 1e6));
+        threads.Set(static_cast<uint32_t>(i), entry);
+    }
+    result.Set("threads", threads);
+
+    Napi::Array exited = Napi::Array::New(env, snapshot.exited.size());
+    for (size_t i = 0; i < snapshot.exited.size(); ++i) {
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("name", Napi::String::New(env, snapshot.exited[i].name));
+        entry.Set("threads", Napi::Number::New(env, static_cast<double>(snapshot.exited[i].threads)));
+        entry.Set("cpuMs", Napi::Number::New(env, snapshot.exited[i].cpu_ns / 1e6));
+        exited.Set(static_cast<uint32_t>(i), entry);
+    }
+    result.Set("exited", exited);
+
+    // Graphs run on their env's thread, so this one's stats are safe to read
+    struct StageCpu {
+        const char* type;
+        uint64_t graphs = 0;
+        uint64_t frames = 0;
+        uint64_t cpu_ns = 0;
+    };
+    std::vector<StageCpu> stages;
+    {
+        std::lock_guard<std::mutex> lock(g_graphs_mutex);
+        for (const ProcessingGraphWrap* wrap : g_graphs) {
+            if (wrap->OwnerEnv() != static_cast<napi_env>(env)) {
+                continue;
+            }
+            for (size_t i = 0; i < wrap->Graph().StageCount(); ++i) {
+                const GraphStageStats& stats = wrap->Graph().Stats(i);
+                auto it = std::find_if(stages.begin(), stages.end(),
+                                       [&](const StageCpu& stage) { return std::strcmp(stage.type, stats.type) == 0; });
+                if (it == stages.end()) {
+                    stages.push_back(StageCpu{stats.type});
+                    it = stages.end() - 1;
+                }
+                it->graphs++;
+                it->frames += stats.frames;
+                it->cpu_ns += stats.cpu_ns;
+            }
+        }
+    }
+    Napi::Array stage_array = Napi::Array::New(env, stages.size());
+    for (size_t i = 0; i < stages.size(); ++i) {
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("type", Napi::String::New(env, stages[i].type));
+        entry.Set("graphs", Napi::Number::New(env, static_cast<double>(stages[i].graphs)));
+        entry.Set("frames", Napi::Number::New(env, static_cast<double>(stages[i].frames)));
+        entry.Set("cpuMs", Napi::Number::New(env, stages[i].cpu_ns / 1e6));
+        stage_array.Set(static_cast<uint32_t>(i), entry);
+    }
+    result.Set("stages", stage_array);
+    return result;
+}
+
+// new RecordingReader(indexPath) opens one track of a recording by its seek
+// index; read() then serves any range without reading the rest
+class RecordingReaderWrap : public Napi::ObjectWrap<RecordingReaderWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "RecordingReader", {
+            InstanceMethod("getInfo", &RecordingReaderWrap::GetInfo),
+            InstanceMethod("read", &RecordingReaderWrap::Read),
+            InstanceMethod("getPeaks", &RecordingReaderWrap::GetPeaks),
+            InstanceMethod("getSilences", &RecordingReaderWrap::GetSilences),
+        });
+    }
+
+    explicit RecordingReaderWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<RecordingReaderWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected an index path").ThrowAsJavaScriptException();
+            return;
+        }
+        std::string error;
+        if (!reader_.Open(info[0].As<Napi::String>().Utf8Value(), &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    // getInfo(targetLufs = -16) -> { startedAt, intervalMs, entries,
+    // durationMs, silenceMs, loudness: { integratedLufs, peakDbfs, gainDb } |
+    // null }, gainDb being what playback applies to reach targetLufs and
+    // silenceMs the compacted silence within durationMs
+    Napi::Value GetInfo(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("startedAt", Napi::Number::New(env, static_cast<double>(reader_.StartedAtMs())));
+        result.Set("intervalMs", Napi::Number::New(env, reader_.IntervalMs()));
+        result.Set("entries", Napi::Number::New(env, static_cast<double>(reader_.EntryCount())));
+        const double duration = reader_.DurationMs();
+        result.Set("durationMs", Napi::Number::New(env, duration));
+        std::vector<SilenceRun> runs;
+        result.Set("silenceMs", Napi::Number::New(env, reader_.Silences(0.0, duration, &runs)));
+        double lufs = 0.0;
+        double peak = 0.0;
+        if (!reader_.Loudness(&lufs, &peak)) {
+            result.Set("loudness", env.Null());
+            return result;
+        }
+        const double target = info.Length() > 0 && info[0].IsNumber()
+            ? std::clamp(info[0].As<Napi::Number>().DoubleValue(), -40.0, -5.0) : kPlaybackTargetLufs;
+        Napi::Object loudness = Napi::Object::New(env);
+        loudness.Set("integratedLufs", Napi::Number::New(env, lufs));
+        loudness.Set("peakDbfs", Napi::Number::New(env, peak));
+        loudness.Set("gainDb", Napi::Number::New(env, NormalizationGainDb(lufs, peak, target)));
+        result.Set("loudness", loudness);
+        return result;
+    }
+
+    // read(startMs, durationMs, { skipSilence? }) -> { samples: Float32Array
+    // | Int16Array, sampleRate, channels, startMs, silent } or null past the
+    // end; a stereo mix's samples are interleaved. The array views the
+    // mapping itself where the runtime allows external buffers; Electron's
+    // V8 sandbox does not, and there the range alone is copied. Compacted
+    // silence comes back as zeros (silent: true) unless skipSilence, which
+    // goes on to the audio after it.
+    Napi::Value Read(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (startMs, durationMs)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        bool skip = false;
+        if (info.Length() > 2 && info[2].IsObject()) {
+            Napi::Value value = info[2].As<Napi::Object>().Get("skipSilence");
+            skip = value.IsBoolean() && value.As<Napi::Boolean>().Value();
+        }
+        RecordingRange range;
+        std::string error;
+        if (!reader_.Read(info[0].As<Napi::Number>().DoubleValue(), info[1].As<Napi::Number>().DoubleValue(),
+                          &range, &error, skip ? SilenceMode::kSkip : SilenceMode::kFill)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (range.samples == 0) {
+            return env.Null();
+        }
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("silent", Napi::Boolean::New(env, range.silent));
+        if (range.silent) {
+            // Zeroed by the runtime
+            const size_t values = range.samples * range.channels;
+            if (range.float32) {
+                result.Set("samples", Napi::Float32Array::New(env, values));
+            } else {
+                result.Set("samples", Napi::Int16Array::New(env, values));
+            }
+        } else if (range.float32) {
+            Napi::ArrayBuffer array_buffer = ExternalArrayBuffer(env, range.data, range.bytes, range.owner);
+            result.Set("samples", Napi::Float32Array::New(env, range.samples * range.channels, array_buffer, 0));
+        } else {
+            Napi::ArrayBuffer array_buffer = ExternalArrayBuffer(env, range.data, range.bytes, range.owner);
+            result.Set("samples", Napi::Int16Array::New(env, range.samples * range.channels, array_buffer, 0));
+        }
+        result.Set("sampleRate", Napi::Number::New(env, range.sample_rate));
+        result.Set("channels", Napi::Number::New(env, range.channels));
+        result.Set("startMs", Napi::Number::New(env, range.start_ms));
+        return result;
+    }
+
+    // getPeaks(startMs, endMs, points) -> { bucketMs, startMs, peaks:
+    // Int16Array of min, max, rms per bucket } from the waveform pyramid
+    Napi::Value GetPeaks(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 3 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (startMs, endMs, points)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        double points = std::max(1.0, info[2].As<Napi::Number>().DoubleValue());
+        PeakRange range;
+        std::string error;
+        if (!ReadPeaks(reader_.Base(), info[0].As<Napi::Number>().DoubleValue(),
+                       info[1].As<Napi::Number>().DoubleValue(), static_cast<size_t>(points), &range, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("bucketMs", Napi::Number::New(env, range.bucket_ms));
+        result.Set("startMs", Napi::Number::New(env, range.start_ms));
+        Napi::Int16Array peaks = Napi::Int16Array::New(env, range.values.size());
+        std::copy(range.values.begin(), range.values.end(), peaks.Data());
+        result.Set("peaks", peaks);
+        return result;
+    }
+
+    // getSilences(startMs, endMs) -> { totalMs, runs: [{ startMs, durationMs }] }:
+    // the compacted silence a skip-silence player jumps, totalMs within the span
+    Napi::Value GetSilences(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (startMs, endMs)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::vector<SilenceRun> runs;
+        const double total = reader_.Silences(info[0].As<Napi::Number>().DoubleValue(),
+                                              info[1].As<Napi::Number>().DoubleValue(), &runs);
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("totalMs", Napi::Number::New(env, total));
+        Napi::Array list = Napi::Array::New(env, runs.size());
+        for (size_t i = 0; i < runs.size(); ++i) {
+            Napi::Object run = Napi::Object::New(env);
+            run.Set("startMs", Napi::Number::New(env, runs[i].start_ms));
+            run.Set("durationMs", Napi::Number::New(env, runs[i].duration_ms));
+            list.Set(static_cast<uint32_t>(i), run);
+        }
+        result.Set("runs", list);
+        return result;
+    }
+
+    RecordingReader reader_;
+};
+
+// new RecordingPlayer(indexPath, { sampleRate?, speed?, skipSilence? })
+// plays one track at 0.5x to 3x at the recording's pitch; read() renders
+// the next buffer on demand, so nothing plays ahead of the caller
+class RecordingPlayerWrap : public Napi::ObjectWrap<RecordingPlayerWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "RecordingPlayer", {
+            InstanceMethod("read", &RecordingPlayerWrap::Read),
+            InstanceMethod("seek", &RecordingPlayerWrap::Seek),
+            InstanceMethod("setSpeed", &RecordingPlayerWrap::SetSpeed),
+            InstanceMethod("setSkipSilence", &RecordingPlayerWrap::SetSkipSilence),
+            InstanceMethod("getState", &RecordingPlayerWrap::GetState),
+        });
+    }
+
+    explicit RecordingPlayerWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<RecordingPlayerWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected an index path").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = info.Length() > 1 && info[1].IsObject() ? info[1].As<Napi::Object>()
+                                                                       : Napi::Object::New(env);
+        const int sample_rate = options.Get("sampleRate").IsNumber()
+            ? options.Get("sampleRate").As<Napi::Number>().Int32Value() : kPlaybackRate;
+        player_ = std::make_unique<RecordingPlayer>(sample_rate);
+        if (options.Get("speed").IsNumber()) {
+            player_->SetSpeed(options.Get("speed").As<Napi::Number>().DoubleValue());
+        }
+        if (options.Get("skipSilence").IsBoolean()) {
+            player_->SetSkipSilence(options.Get("skipSilence").As<Napi::Boolean>().Value());
+        }
+        std::string error;
+        if (!player_->Open(info[0].As<Napi::String>().Utf8Value(), &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    // read(frames) -> { samples: Float32Array, channels, sampleRate,
+    // positionMs, ended }: the next |frames| of output (interleaved when
+    // stereo), fewer only at the end; positionMs is the recording time the
+    // buffer starts at
+    Napi::Value Read(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a frame count").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        const size_t frames = static_cast<size_t>(std::clamp(info[0].As<Napi::Number>().DoubleValue(), 1.0,
+                                                             kMaxPlaybackReadSeconds * player_->SampleRate()));
+        const size_t channels = static_cast<size_t>(player_->Channels());
+        const double position = player_->PositionMs();
+        Napi::Float32Array samples = Napi::Float32Array::New(env, frames * channels);
+        size_t rendered = 0;
+        std::string error;
+        if (!player_->Render(samples.Data(), frames, &rendered, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("samples", rendered == frames
+            ? samples : Napi::Float32Array::New(env, rendered * channels, samples.ArrayBuffer(), 0));
+        result.Set("channels", Napi::Number::New(env, static_cast<double>(channels)));
+        result.Set("sampleRate", Napi::Number::New(env, player_->SampleRate()));
+        result.Set("positionMs", Napi::Number::New(env, position));
+        result.Set("ended", Napi::Boolean::New(env, player_->Ended()));
+        return result;
+    }
+
+    // seek(ms): the next read() starts there, faded in
+    Napi::Value Seek(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a time in ms").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        player_->Seek(info[0].As<Napi::Number>().DoubleValue());
+        return env.Undefined();
+    }
+
+    // setSpeed(speed): 0.5 to 3, from the next 10ms of output
+    Napi::Value SetSpeed(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a speed").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        player_->SetSpeed(info[0].As<Napi::Number>().DoubleValue());
+        return env.Undefined();
+    }
+
+    // setSkipSilence(skip): compacted silence is jumped rather than played
+    Napi::Value SetSkipSilence(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsBoolean()) {
+            Napi::TypeError::New(env, "Expected a boolean").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        player_->SetSkipSilence(info[0].As<Napi::Boolean>().Value());
+        return env.Undefined();
+    }
+
+    // getState() -> { positionMs, durationMs, speed, skipSilence, ended,
+    // sampleRate, channels }
+    Napi::Value GetState(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("positionMs", Napi::Number::New(env, player_->PositionMs()));
+        result.Set("durationMs", Napi::Number::New(env, player_->DurationMs()));
+        result.Set("speed", Napi::Number::New(env, player_->Speed()));
+        result.Set("skipSilence", Napi::Boolean::New(env, player_->SkipSilence()));
+        result.Set("ended", Napi::Boolean::New(env, player_->Ended()));
+        result.Set("sampleRate", Napi::Number::New(env, player_->SampleRate()));
+        result.Set("channels", Napi::Number::New(env, player_->Channels()));
+        return result;
+    }
+
+    std::unique_ptr<RecordingPlayer> player_;
+};
+
+// A Float32Array, or a plain array of numbers, of exactly |dims| values
+static bool ReadEmbedding(const Napi::Value& value, size_t dims, std::vector<float>* out) {
+    if (value.IsTypedArray() && value.As<Napi::TypedArray>().TypedArrayType() == napi_float32_array) {
+        Napi::Float32Array array = value.As<Napi::Float32Array>();
+        if (array.ElementLength() != dims) {
+            return false;
+        }
+        out->assign(array.Data(), array.Data() + dims);
+        return true;
+    }
+    if (value.IsArray()) {
+        Napi::Array array = value.As<Napi::Array>();
+        if (array.Length() != dims) {
+            return false;
+        }
+        out->resize(dims);
+        for (uint32_t i = 0; i < array.Length(); ++i) {
+            Napi::Value element = array.Get(i);
+            if (!element.IsNumber()) {
+                return false;
+            }
+            (*out)[i] = element.As<Napi::Number>().FloatValue();
+        }
+        return true;
+    }
+    return false;
+}
+
+// { dims, quantization?, normalize?, graphThreshold?, m?, efConstruction?,
+// efSearch? } as EmbeddingIndex and EmbeddingStore take them
+static bool ReadEmbeddingOptions(const Napi::Object& object, EmbeddingIndexOptions* options, std::string* error) {
+    auto count = [&](const char* name, size_t fallback) {
+        Napi::Value value = object.Get(name);
+        return value.IsNumber() ? static_cast<size_t>(std::max(0.0, value.As<Napi::Number>().DoubleValue()))
+                                : fallback;
+    };
+    options->dims = count("dims", 0);
+    options->graph_threshold = count("graphThreshold", options->graph_threshold);
+    options->graph_m = count("m", options->graph_m);
+    options->ef_construction = count("efConstruction", options->ef_construction);
+    options->ef_search = count("efSearch", options->ef_search);
+    if (object.Get("normalize").IsBoolean()) {
+        options->normalize = object.Get("normalize").As<Napi::Boolean>().Value();
+    }
+    if (object.Get("quantization").IsString()) {
+        std::string quantization = object.Get("quantization").As<Napi::String>().Utf8Value();
+        if (quantization == "float16") {
+            options->quantization = EmbeddingQuantization::kFloat16;
+        } else if (quantization == "int8") {
+            options->quantization = EmbeddingQuantization::kInt8;
+        } else if (quantization != "float32") {
+            *error = "quantization must be 'float32', 'float16' or 'int8'";
+            return false;
+        }
+    }
+    return true;
+}
+
+static Napi::Array EmbeddingHitsToJs(Napi::Env env, const std::vector<EmbeddingHit>& hits) {
+    Napi::Array result = Napi::Array::New(env, hits.size());
+    for (size_t i = 0; i < hits.size(); ++i) {
+        Napi::Object hit = Napi::Object::New(env);
+        hit.Set("id", Napi::String::New(env, hits[i].id));
+        hit.Set("score", Napi::Number::New(env, hits[i].score));
+        result.Set(static_cast<uint32_t>(i), hit);
+    }
+    return result;
+}
+
+// new EmbeddingIndex({ dims, quantization?, normalize?, graphThreshold?,
+// m?, efConstruction?, efSearch? }) holds embeddings in memory for top-k
+// search from the callout path
+class EmbeddingIndexWrap : public Napi::ObjectWrap<EmbeddingIndexWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "EmbeddingIndex", {
+            InstanceMethod("add", &EmbeddingIndexWrap::Add),
+            InstanceMethod("remove", &EmbeddingIndexWrap::Remove),
+            InstanceMethod("clear", &EmbeddingIndexWrap::Clear),
+            InstanceMethod("search", &EmbeddingIndexWrap::Search),
+            InstanceMethod("getStats", &EmbeddingIndexWrap::GetStats),
+        });
+    }
+
+    explicit EmbeddingIndexWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<EmbeddingIndexWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("dims").IsNumber()) {
+            Napi::TypeError::New(env, "Expected { dims }").ThrowAsJavaScriptException();
+            return;
+        }
+        EmbeddingIndexOptions options;
+        std::string error;
+        if (!ReadEmbeddingOptions(info[0].As<Napi::Object>(), &options, &error)) {
+            Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+        if (!index_.Init(options, &error)) {
+            Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    // add(id, vector) replaces any vector already under |id|
+    Napi::Value Add(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::vector<float> vector;
+        if (info.Length() < 2 || !info[0].IsString() || !ReadEmbedding(info[1], index_.Dims(), &vector)) {
+            Napi::TypeError::New(env, "Expected (id, vector of " + std::to_string(index_.Dims()) + " numbers)")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::string error;
+        if (!index_.Add(info[0].As<Napi::String>().Utf8Value(), vector.data(), &error)) {
+            Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+        }
+        return env.Undefined();
+    }
+
+    // remove(id) -> whether it was there
+    Napi::Value Remove(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected an id").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Boolean::New(env, index_.Remove(info[0].As<Napi::String>().Utf8Value()));
+    }
+
+    Napi::Value Clear(const Napi::CallbackInfo& info) {
+        index_.Clear();
+        return info.Env().Undefined();
+    }
+
+    // search(vector, k) -> [{ id, score }], best first
+    Napi::Value Search(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::vector<float> query;
+        if (info.Length() < 2 || !ReadEmbedding(info[0], index_.Dims(), &query) || !info[1].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (vector of " + std::to_string(index_.Dims()) + " numbers, k)")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        size_t k = static_cast<size_t>(std::max(0.0, info[1].As<Napi::Number>().DoubleValue()));
+        return EmbeddingHitsToJs(env, index_.Search(query.data(), k));
+    }
+
+    // getStats() -> { size, dims, graph, bytes }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("size", Napi::Number::New(env, static_cast<double>(index_.Size())));
+        result.Set("dims", Napi::Number::New(env, static_cast<double>(index_.Dims())));
+        result.Set("graph", Napi::Boolean::New(env, index_.UsesGraph()));
+        result.Set("bytes", Napi::Number::New(env, static_cast<double>(index_.Bytes())));
+        return result;
+    }
+
+    EmbeddingIndex index_;
+};
+
+// new LexicalIndex() holds BM25 postings of short texts (knowledge chunks)
+// for exact-term retrieval beside an embedding store
+class LexicalIndexWrap : public Napi::ObjectWrap<LexicalIndexWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        Napi::Function constructor = DefineClass(env, "LexicalIndex", {
+            InstanceMethod("add", &LexicalIndexWrap::Add),
+            InstanceMethod("remove", &LexicalIndexWrap::Remove),
+            InstanceMethod("removePrefix", &LexicalIndexWrap::RemovePrefix),
+            InstanceMethod("search", &LexicalIndexWrap::Search),
+            InstanceMethod("getStats", &LexicalIndexWrap::GetStats),
+        });
+        GetAddonInstance(env)->lexical_index = Napi::Persistent(constructor);
+        return constructor;
+    }
+
+    explicit LexicalIndexWrap(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<LexicalIndexWrap>(info), index_(std::make_shared<LexicalIndex>()) {}
+
+    // The index behind a LexicalIndex object; null for anything else
+    static std::shared_ptr<const LexicalIndex> FromValue(const Napi::Value& value) {
+        AddonInstance* instance = GetAddonInstance(value.Env());
+        if (!value.IsObject() || instance->lexical_index.IsEmpty() ||
+            !value.As<Napi::Object>().InstanceOf(instance->lexical_index.Value())) {
+            return nullptr;
+        }
+        return Unwrap(value.As<Napi::Object>())->index_;
+    }
+
+private:
+    // add(id, text) replaces what |id| had
+    Napi::Value Add(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+            Napi::TypeError::New(env, "Expected (id, text)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        index_->Add(info[0].As<Napi::String>().Utf8Value(), info[1].As<Napi::String>().Utf8Value());
+        return env.Undefined();
+    }
+
+    // remove(id) -> whether it was there
+    Napi::Value Remove(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected an id").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Boolean::New(env, index_->Remove(info[0].As<Napi::String>().Utf8Value()));
+    }
+
+    // removePrefix(prefix) -> how many texts it removed
+    Napi::Value RemovePrefix(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a prefix").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Number::New(env,
+                                 static_cast<double>(index_->RemovePrefix(info[0].As<Napi::String>().Utf8Value())));
+    }
+
+    // search(text, k) -> [{ id, score }], best first
+    Napi::Value Search(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (text, k)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        size_t k = static_cast<size_t>(std::max(0.0, info[1].As<Napi::Number>().DoubleValue()));
+        return EmbeddingHitsToJs(env, index_->Search(info[0].As<Napi::String>().Utf8Value(), k));
+    }
+
+    // getStats() -> { documents, terms, bytes }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("documents", Napi::Number::New(env, static_cast<double>(index_->Documents())));
+        result.Set("terms", Napi::Number::New(env, static_cast<double>(index_->Terms())));
+        result.Set("bytes", Napi::Number::New(env, static_cast<double>(index_->Bytes())));
+        return result;
+    }
+
+    std::shared_ptr<LexicalIndex> index_;
+};
+
+// Reciprocal-rank fusion's constant: ranks past the first few count for
+// little, and neither list's top hit can swamp the other's
+static constexpr double kDefaultRrfK = 60.0;
+
+// Retrieval's default latency budget
+static constexpr double kDefaultHybridBudgetMs = 20.0;
+
+// new EmbeddingStore(path, { dims, quantization?, normalize? }) opens or
+// creates an embedding file, searched through a memory map
+class EmbeddingStoreWrap : public Napi::ObjectWrap<EmbeddingStoreWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "EmbeddingStore", {
+            InstanceMethod("append", &EmbeddingStoreWrap::Append),
+            InstanceMethod("remove", &EmbeddingStoreWrap::Remove),
+            InstanceMethod("removePrefix", &EmbeddingStoreWrap::RemovePrefix),
+            InstanceMethod("search", &EmbeddingStoreWrap::Search),
+            InstanceMethod("hybridSearch", &EmbeddingStoreWrap::HybridSearch),
+            InstanceMethod("getStats", &EmbeddingStoreWrap::GetStats),
+            InstanceMethod("close", &EmbeddingStoreWrap::Close),
+        });
+    }
+
+    explicit EmbeddingStoreWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<EmbeddingStoreWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject() ||
+            !info[1].As<Napi::Object>().Get("dims").IsNumber()) {
+            Napi::TypeError::New(env, "Expected (path, { dims })").ThrowAsJavaScriptException();
+            return;
+        }
+        EmbeddingIndexOptions options;
+        std::string error;
+        if (!ReadEmbeddingOptions(info[1].As<Napi::Object>(), &options, &error) ||
+            !store_.Open(info[0].As<Napi::String>().Utf8Value(), options, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    // append(id, vector); ids are up to 63 bytes of UTF-8
+    Napi::Value Append(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::vector<float> vector;
+        if (info.Length() < 2 || !info[0].IsString() || !ReadEmbedding(info[1], store_.Dims(), &vector)) {
+            Napi::TypeError::New(env, "Expected (id, vector of " + std::to_string(store_.Dims()) + " numbers)")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::string error;
+        if (!store_.Append(info[0].As<Napi::String>().Utf8Value(), vector.data(), &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        }
+        return env.Undefined();
+    }
+
+    // remove(id) -> how many records it marked
+    Napi::Value Remove(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected an id").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Number::New(env, static_cast<double>(store_.Remove(info[0].As<Napi::String>().Utf8Value())));
+    }
+
+    // removePrefix(prefix) -> how many records it marked
+    Napi::Value RemovePrefix(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a prefix").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Number::New(env,
+                                 static_cast<double>(store_.RemovePrefix(info[0].As<Napi::String>().Utf8Value())));
+    }
+
+    // search(vector, k) -> [{ id, score }], best first
+    Napi::Value Search(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::vector<float> query;
+        if (info.Length() < 2 || !ReadEmbedding(info[0], store_.Dims(), &query) || !info[1].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (vector of " + std::to_string(store_.Dims()) + " numbers, k)")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        size_t k = static_cast<size_t>(std::max(0.0, info[1].As<Napi::Number>().DoubleValue()));
+        return EmbeddingHitsToJs(env, store_.Search(query.data(), k));
+    }
+
+    // hybridSearch(vector | null, text, lexicalIndex, { k, budgetMs?, rrfK? })
+    // -> { hits: [{ id, score, vectorRank, lexicalRank }], complete, elapsedMs }:
+    // this store's scan and the index's BM25 at once, fused by rank
+    Napi::Value HybridSearch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::vector<float> query;
+        const bool has_vector = info.Length() > 0 && !info[0].IsNull();
+        std::shared_ptr<const LexicalIndex> lexical =
+            info.Length() > 2 ? LexicalIndexWrap::FromValue(info[2]) : nullptr;
+        if (info.Length() < 4 || (has_vector && !ReadEmbedding(info[0], store_.Dims(), &query)) ||
+            !info[1].IsString() || !lexical || !info[3].IsObject() ||
+            !info[3].As<Napi::Object>().Get("k").IsNumber()) {
+            Napi::TypeError::New(env, "Expected (vector of " + std::to_string(store_.Dims()) +
+                                          " numbers or null, text, LexicalIndex, { k })")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object options = info[3].As<Napi::Object>();
+        auto number = [&](const char* key, double fallback) {
+            return options.Get(key).IsNumber() ? std::max(0.0, options.Get(key).As<Napi::Number>().DoubleValue())
+                                               : fallback;
+        };
+        const size_t k = static_cast<size_t>(number("k", 0.0));
+        TaskScheduler* scheduler;
+        {
+            std::lock_guard<std::mutex> lock(g_module_mutex);
+            scheduler = ModuleScheduler();
+        }
+        HybridResult result =
+            kakarot::HybridSearch(scheduler, &store_, has_vector ? query.data() : nullptr, lexical,
+                                  info[1].As<Napi::String>().Utf8Value(), k,
+                                  number("budgetMs", kDefaultHybridBudgetMs), number("rrfK", kDefaultRrfK));
+
+        Napi::Array hits = Napi::Array::New(env, result.hits.size());
+        for (size_t i = 0; i < result.hits.size(); ++i) {
+            Napi::Object hit = Napi::Object::New(env);
+            hit.Set("id", Napi::String::New(env, result.hits[i].id));
+            hit.Set("score", Napi::Number::New(env, result.hits[i].score));
+            hit.Set("vectorRank", Napi::Number::New(env, result.hits[i].vector_rank));
+            hit.Set("lexicalRank", Napi::Number::New(env, result.hits[i].lexical_rank));
+            hits.Set(static_cast<uint32_t>(i), hit);
+        }
+        Napi::Object object = Napi::Object::New(env);
+        object.Set("hits", hits);
+        object.Set("complete", Napi::Boolean::New(env, result.complete));
+        object.Set("elapsedMs", Napi::Number::New(env, result.elapsed_ms));
+        return object;
+    }
+
+    // getStats() -> { records, dims, bytes }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("records", Napi::Number::New(env, static_cast<double>(store_.Records())));
+        result.Set("dims", Napi::Number::New(env, static_cast<double>(store_.Dims())));
+        result.Set("bytes", Napi::Number::New(env, static_cast<double>(store_.Bytes())));
+        return result;
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        store_.Close();
+        return info.Env().Undefined();
+    }
+
+    EmbeddingStore store_;
+};
+
+// new MeetingIndex({ dims, windowTokens }) indexes the running meeting's
+// transcript in token-bounded windows, for callouts to retrieve earlier
+// discussion from
+class MeetingIndexWrap : public Napi::ObjectWrap<MeetingIndexWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "MeetingIndex", {
+            InstanceMethod("append", &MeetingIndexWrap::Append),
+            InstanceMethod("seal", &MeetingIndexWrap::Seal),
+            InstanceMethod("clear", &MeetingIndexWrap::Clear),
+            InstanceMethod("takeUnembedded", &MeetingIndexWrap::TakeUnembedded),
+            InstanceMethod("setEmbeddings", &MeetingIndexWrap::SetEmbeddings),
+            InstanceMethod("search", &MeetingIndexWrap::Search),
+            InstanceMethod("getStats", &MeetingIndexWrap::GetStats),
+        });
+    }
+
+    explicit MeetingIndexWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<MeetingIndexWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("dims").IsNumber() ||
+            !info[0].As<Napi::Object>().Get("windowTokens").IsNumber()) {
+            Napi::TypeError::New(env, "Expected { dims, windowTokens }").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = info[0].As<Napi::Object>();
+        std::string error;
+        if (!index_.Init(static_cast<size_t>(std::max(0.0, options.Get("dims").As<Napi::Number>().DoubleValue())),
+                         static_cast<size_t>(
+                             std::max(0.0, options.Get("windowTokens").As<Napi::Number>().DoubleValue())),
+                         &error)) {
+            Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    // append(timestampMs, line) -> whether it sealed a window
+    Napi::Value Append(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsString()) {
+            Napi::TypeError::New(env, "Expected (timestampMs, line)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Boolean::New(
+            env, index_.Append(info[0].As<Napi::Number>().DoubleValue(), info[1].As<Napi::String>().Utf8Value()));
+    }
+
+    Napi::Value Seal(const Napi::CallbackInfo& info) {
+        index_.Seal();
+        return info.Env().Undefined();
+    }
+
+    Napi::Value Clear(const Napi::CallbackInfo& info) {
+        index_.Clear();
+        return info.Env().Undefined();
+    }
+
+    // takeUnembedded(max) -> [{ id, text }], sealed windows still without
+    // an embedding, oldest first; the same ones again until they get one
+    Napi::Value TakeUnembedded(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a count").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::vector<const MeetingWindow*> windows =
+            index_.Unembedded(static_cast<size_t>(std::max(0.0, info[0].As<Napi::Number>().DoubleValue())));
+        Napi::Array result = Napi::Array::New(env, windows.size());
+        for (size_t i = 0; i < windows.size(); ++i) {
+            Napi::Object window = Napi::Object::New(env);
+            window.Set("id", Napi::String::New(env, windows[i]->id));
+            window.Set("text", Napi::String::New(env, windows[i]->text));
+            result.Set(static_cast<uint32_t>(i), window);
+        }
+        return result;
+    }
+
+    // setEmbeddings(ids, vectors); windows cleared since are skipped
+    Napi::Value SetEmbeddings(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsArray() ||
+            info[0].As<Napi::Array>().Length() != info[1].As<Napi::Array>().Length()) {
+            Napi::TypeError::New(env, "Expected (ids, vectors) of one length").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Array ids = info[0].As<Napi::Array>();
+        Napi::Array vectors = info[1].As<Napi::Array>();
+        std::vector<float> vector;
+        for (uint32_t i = 0; i < ids.Length(); ++i) {
+            if (!ids.Get(i).IsString() || !ReadEmbedding(vectors.Get(i), index_.Dims(), &vector)) {
+                Napi::TypeError::New(env, "Expected string ids and vectors of " + std::to_string(index_.Dims()) +
+                                              " numbers")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            // A window cleared since, or a zero vector, only stays lexical
+            std::string error;
+            index_.SetEmbedding(ids.Get(i).As<Napi::String>().Utf8Value(), vector.data(), &error);
+        }
+        return env.Undefined();
+    }
+
+    // search(text, vector|null, { k, beforeMs?, rrfK? }) -> [{ id, text,
+    // startMs, endMs, score, vectorRank, lexicalRank }], best first, among
+    // windows ending before beforeMs
+    Napi::Value Search(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::vector<float> query;
+        const bool has_vector = info.Length() > 1 && !info[1].IsNull() && !info[1].IsUndefined();
+        if (info.Length() < 3 || !info[0].IsString() ||
+            (has_vector && !ReadEmbedding(info[1], index_.Dims(), &query)) || !info[2].IsObject() || !info[2].As<Napi::Object>().Get("k").IsNumber()) {
+            Napi::TypeError::New(env, "Expected (text, vector of " + std::to_string(index_.Dims()) +
+                                          " numbers or null, { k })")
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object options = info[2].As<Napi::Object>();
+        const size_t k = static_cast<size_t>(std::max(0.0, options.Get("k").As<Napi::Number>().DoubleValue()));
+        const double before_ms = options.Get("beforeMs").IsNumber()
+                                     ? options.Get("beforeMs").As<Napi::Number>().DoubleValue()
+                                     : std::numeric_limits<double>::infinity();
+        const double rrf_k = options.Get("rrfK").IsNumber()
+                                 ? std::max(0.0, options.Get("rrfK").As<Napi::Number>().DoubleValue())
+                                 : kDefaultRrfK;
+        std::vector<MeetingHit> hits = index_.Search(info[0].As<Napi::String>().Utf8Value(),
+                                                     has_vector ? query.data() : nullptr, k, before_ms, rrf_k);
+        Napi::Array result = Napi::Array::New(env, hits.size());
+        for (size_t i = 0; i < hits.size(); ++i) {
+            Napi::Object hit = Napi::Object::New(env);
+            hit.Set("id", Napi::String::New(env, hits[i].hit.id));
+            hit.Set("text", Napi::String::New(env, hits[i].window->text));
+            hit.Set("startMs", Napi::Number::New(env, hits[i].window->start_ms));
+            hit.Set("endMs", Napi::Number::New(env, hits[i].window->end_ms));
+            hit.Set("score", Napi::Number::New(env, hits[i].hit.score));
+            hit.Set("vectorRank", Napi::Number::New(env, hits[i].hit.vector_rank));
+            hit.Set("lexicalRank", Napi::Number::New(env, hits[i].hit.lexical_rank));
+            result.Set(static_cast<uint32_t>(i), hit);
+        }
+        return result;
+    }
+
+    // getStats() -> { lines, windows, embedded, tokens, bytes }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        MeetingIndexStats stats = index_.GetStats();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("lines", Napi::Number::New(env, static_cast<double>(stats.lines)));
+        result.Set("windows", Napi::Number::New(env, static_cast<double>(stats.windows)));
+        result.Set("embedded", Napi::Number::New(env, static_cast<double>(stats.embedded)));
+        result.Set("tokens", Napi::Number::New(env, static_cast<double>(stats.tokens)));
+        result.Set("bytes", Napi::Number::New(env, static_cast<double>(stats.bytes)));
+        return result;
+    }
+
+    MeetingIndex index_;
+};
+
+// Entries an embedding cache keeps by default: ~60MB of float16 at 1536 dims
+static constexpr double kDefaultEmbeddingCacheEntries = 20000.0;
+
+// new EmbeddingCache(path, { dims, capacity?, quantization? }) keeps
+// embeddings by model and text, in a memory-mapped file, so that only texts
+// it has not seen go to the embeddings API
+class EmbeddingCacheWrap : public Napi::ObjectWrap<EmbeddingCacheWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "EmbeddingCache", {
+            InstanceMethod("lookup", &EmbeddingCacheWrap::Lookup),
+            InstanceMethod("store", &EmbeddingCacheWrap::Store),
+            InstanceMethod("getStats", &EmbeddingCacheWrap::GetStats),
+            InstanceMethod("close", &EmbeddingCacheWrap::Close),
+        });
+    }
+
+    explicit EmbeddingCacheWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<EmbeddingCacheWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject() ||
+            !info[1].As<Napi::Object>().Get("dims").IsNumber()) {
+            Napi::TypeError::New(env, "Expected (path, { dims })").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = info[1].As<Napi::Object>();
+        EmbeddingIndexOptions store_options;
+        std::string error;
+        if (!ReadEmbeddingOptions(options, &store_options, &error)) {
+            Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+        double capacity = kDefaultEmbeddingCacheEntries;
+        if (options.Get("capacity").IsNumber()) {
+            capacity = std::max(1.0, options.Get("capacity").As<Napi::Number>().DoubleValue());
+        }
+        if (!cache_.Open(info[0].As<Napi::String>().Utf8Value(), store_options, static_cast<size_t>(capacity),
+                         &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    // lookup(model, texts) -> a Float32Array per text found, null per miss
+    Napi::Value Lookup(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsString() || !info[1].IsArray()) {
+            Napi::TypeError::New(env, "Expected (model, texts)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Array list = info[1].As<Napi::Array>();
+        std::vector<std::string> texts(list.Length());
+        for (uint32_t i = 0; i < list.Length(); ++i) {
+            Napi::Value text = list.Get(i);
+            if (!text.IsString()) {
+                Napi::TypeError::New(env, "Expected (model, texts)").ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            texts[i] = text.As<Napi::String>().Utf8Value();
+        }
+        const size_t dims = cache_.Dims();
+        std::vector<float> vectors(texts.size() * dims);
+        std::vector<bool> found = cache_.Lookup(info[0].As<Napi::String>().Utf8Value(), texts, vectors.data());
+        Napi::Array result = Napi::Array::New(env, texts.size());
+        for (size_t i = 0; i < texts.size(); ++i) {
+            if (!found[i]) {
+                result.Set(static_cast<uint32_t>(i), env.Null());
+                continue;
+            }
+            Napi::Float32Array vector = Napi::Float32Array::New(env, dims);
+            std::copy(vectors.begin() + i * dims, vectors.begin() + (i + 1) * dims, vector.Data());
+            result.Set(static_cast<uint32_t>(i), vector);
+        }
+        return result;
+    }
+
+    // store(model, texts, vectors), one vector per text
+    Napi::Value Store(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        const size_t dims = cache_.Dims();
+        if (info.Length() < 3 || !info[0].IsString() || !info[1].IsArray() || !info[2].IsArray() ||
+            info[1].As<Napi::Array>().Length() != info[2].As<Napi::Array>().Length()) {
+            Napi::TypeError::New(env, "Expected (model, texts, vectors) of one length").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        const std::string model = info[0].As<Napi::String>().Utf8Value();
+        Napi::Array texts = info[1].As<Napi::Array>();
+        Napi::Array vectors = info[2].As<Napi::Array>();
+        std::vector<float> vector;
+        for (uint32_t i = 0; i < texts.Length(); ++i) {
+            if (!texts.Get(i).IsString() || !ReadEmbedding(vectors.Get(i), dims, &vector)) {
+                Napi::TypeError::New(env, "Expected a text and a vector of " + std::to_string(dims) + " numbers")
+                    .ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+            std::string error;
+            if (!cache_.Store(model, texts.Get(i).As<Napi::String>().Utf8Value(), vector.data(), &error)) {
+                Napi::Error::New(env, error).ThrowAsJavaScriptException();
+                return env.Undefined();
+            }
+        }
+        return env.Undefined();
+    }
+
+    // getStats() -> { entries, capacity, hits, misses, evictions, compactions, bytes }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        EmbeddingCacheStats stats = cache_.GetStats();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("entries", Napi::Number::New(env, static_cast<double>(stats.entries)));
+        result.Set("capacity", Napi::Number::New(env, static_cast<double>(stats.capacity)));
+        result.Set("hits", Napi::Number::New(env, static_cast<double>(stats.hits)));
+        result.Set("misses", Napi::Number::New(env, static_cast<double>(stats.misses)));
+        result.Set("evictions", Napi::Number::New(env, static_cast<double>(stats.evictions)));
+        result.Set("compactions", Napi::Number::New(env, static_cast<double>(stats.compactions)));
+        result.Set("bytes", Napi::Number::New(env, static_cast<double>(stats.bytes)));
+        return result;
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        cache_.Close();
+        return info.Env().Undefined();
+    }
+
+    EmbeddingCache cache_;
+};
+
+// new Tokenizer(ranksPath?) counts cl100k_base tokens: exactly with the
+// encoding's ranks file, estimated without it
+class TokenizerWrap : public Napi::ObjectWrap<TokenizerWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "Tokenizer", {
+            InstanceMethod("count", &TokenizerWrap::Count),
+            InstanceMethod("truncate", &TokenizerWrap::Truncate),
+            InstanceMethod("chunk", &TokenizerWrap::Chunk),
+            InstanceMethod("isExact", &TokenizerWrap::IsExact),
+        });
+    }
+
+    explicit TokenizerWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TokenizerWrap>(info) {
+        if (info.Length() < 1 || !info[0].IsString()) {
+            return;
+        }
+        std::string error;
+        if (!counter_.LoadRanks(info[0].As<Napi::String>().Utf8Value(), &error)) {
+            Napi::Error::New(info.Env(), error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    Napi::Value Count(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a string").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Number::New(env, static_cast<double>(counter_.Count(info[0].As<Napi::String>().Utf8Value())));
+    }
+
+    // truncate(text, maxTokens, fromEnd?) -> the longest prefix (suffix)
+    // within maxTokens
+    Napi::Value Truncate(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+            Napi::TypeError::New(env, "Expected (text, maxTokens)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::string text = info[0].As<Napi::String>().Utf8Value();
+        size_t max_tokens = static_cast<size_t>(std::max(0.0, info[1].As<Napi::Number>().DoubleValue()));
+        bool from_end = info.Length() > 2 && info[2].ToBoolean().Value();
+        size_t bytes = counter_.Fit(text, max_tokens, from_end, nullptr);
+        if (bytes == text.size()) {
+            return info[0];
+        }
+        return Napi::String::New(env, from_end ? text.substr(text.size() - bytes) : text.substr(0, bytes));
+    }
+
+    // chunk(text, { maxTokens, overlapTokens? }) -> [{ text, tokens }]
+    Napi::Value Chunk(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject() ||
+            !info[1].As<Napi::Object>().Get("maxTokens").IsNumber()) {
+            Napi::TypeError::New(env, "Expected (text, { maxTokens })").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object options = info[1].As<Napi::Object>();
+        std::string text = info[0].As<Napi::String>().Utf8Value();
+        size_t max_tokens = static_cast<size_t>(std::max(0.0, options.Get("maxTokens").As<Napi::Number>().DoubleValue()));
+        size_t overlap_tokens = 0;
+        if (options.Get("overlapTokens").IsNumber()) {
+            overlap_tokens =
+                static_cast<size_t>(std::max(0.0, options.Get("overlapTokens").As<Napi::Number>().DoubleValue()));
+        }
+        std::vector<TokenChunk> chunks = counter_.Chunk(text, max_tokens, overlap_tokens);
+        Napi::Array result = Napi::Array::New(env, chunks.size());
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            Napi::Object chunk = Napi::Object::New(env);
+            chunk.Set("text", Napi::String::New(env, text.data() + chunks[i].offset, chunks[i].size));
+            chunk.Set("tokens", Napi::Number::New(env, static_cast<double>(chunks[i].tokens)));
+            result.Set(static_cast<uint32_t>(i), chunk);
+        }
+        return result;
+    }
+
+    Napi::Value IsExact(const Napi::CallbackInfo& info) {
+        return Napi::Boolean::New(info.Env(), counter_.Exact());
+    }
+
+    TokenCounter counter_;
+};
+
+// new TriggerMatcher([{ id, text, anchor?, wholeWord? }]) finds question
+// openers and keyword triggers in transcript text as it streams in
+class TriggerMatcherWrap : public Napi::ObjectWrap<TriggerMatcherWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "TriggerMatcher", {
+            InstanceMethod("feed", &TriggerMatcherWrap::Feed),
+            InstanceMethod("end", &TriggerMatcherWrap::End),
+            InstanceMethod("reset", &TriggerMatcherWrap::Reset),
+        });
+    }
+
+    explicit TriggerMatcherWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TriggerMatcherWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsArray()) {
+            Napi::TypeError::New(env, "Expected [{ id, text }]").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Array list = info[0].As<Napi::Array>();
+        std::vector<TriggerPattern> patterns;
+        for (uint32_t i = 0; i < list.Length(); ++i) {
+            Napi::Value value = list.Get(i);
+            Napi::Object item = value.IsObject() ? value.As<Napi::Object>() : Napi::Object::New(env);
+            if (!item.Get("id").IsString() || !item.Get("text").IsString()) {
+                Napi::TypeError::New(env, "Expected [{ id, text }]").ThrowAsJavaScriptException();
+                return;
+            }
+            TriggerPattern pattern;
+            pattern.text = item.Get("text").As<Napi::String>().Utf8Value();
+            std::string anchor = item.Get("anchor").IsString() ? item.Get("anchor").As<Napi::String>().Utf8Value() : "";
+            if (anchor == "start") {
+                pattern.anchor = TriggerAnchor::kStart;
+            } else if (anchor == "end") {
+                pattern.anchor = TriggerAnchor::kEnd;
+            } else if (!anchor.empty() && anchor != "anywhere") {
+                Napi::TypeError::New(env, "anchor must be 'anywhere', 'start' or 'end'").ThrowAsJavaScriptException();
+                return;
+            }
+            if (item.Get("wholeWord").IsBoolean()) {
+                pattern.whole_word = item.Get("wholeWord").As<Napi::Boolean>().Value();
+            }
+            ids_.push_back(item.Get("id").As<Napi::String>().Utf8Value());
+            patterns.push_back(std::move(pattern));
+        }
+        std::string error;
+        if (!matcher_.Compile(patterns, &error)) {
+            Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    Napi::Value MatchesToJs(Napi::Env env, const std::vector<TriggerMatch>& matches) {
+        Napi::Array result = Napi::Array::New(env, matches.size());
+        for (size_t i = 0; i < matches.size(); ++i) {
+            Napi::Object match = Napi::Object::New(env);
+            match.Set("id", Napi::String::New(env, ids_[matches[i].pattern]));
+            match.Set("offset", Napi::Number::New(env, static_cast<double>(matches[i].offset)));
+            match.Set("length", Napi::Number::New(env, static_cast<double>(matches[i].length)));
+            result.Set(static_cast<uint32_t>(i), match);
+        }
+        return result;
+    }
+
+    // feed(stream, text) -> [{ id, offset, length }], UTF-8 byte offsets
+    // into what the stream was fed since its last end()
+    Napi::Value Feed(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+            Napi::TypeError::New(env, "Expected (stream, text)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::string text = info[1].As<Napi::String>().Utf8Value();
+        std::vector<TriggerMatch> matches;
+        matcher_.Feed(&streams_[info[0].As<Napi::String>().Utf8Value()], text.data(), text.size(), &matches);
+        return MatchesToJs(env, matches);
+    }
+
+    // end(stream) -> the matches that needed the utterance over; the
+    // stream starts again
+    Napi::Value End(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a stream").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::vector<TriggerMatch> matches;
+        auto stream = streams_.find(info[0].As<Napi::String>().Utf8Value());
+        if (stream != streams_.end()) {
+            matcher_.End(&stream->second, &matches);
+            streams_.erase(stream);
+        }
+        return MatchesToJs(env, matches);
+    }
+
+    // reset(stream) drops what the stream was fed, for text that was revised
+    Napi::Value Reset(const Napi::CallbackInfo& info) {
+        if (info.Length() > 0 && info[0].IsString()) {
+            streams_.erase(info[0].As<Napi::String>().Utf8Value());
+        }
+        return info.Env().Undefined();
+    }
+
+    TriggerMatcher matcher_;
+    std::vector<std::string> ids_;
+    std::map<std::string, TriggerStream> streams_;
+};
+
+// new FuzzyIndex([{ id, keys: [name, email, ...] }]) resolves misspelt or
+// partial names and addresses to the entries with the closest keys
+class FuzzyIndexWrap : public Napi::ObjectWrap<FuzzyIndexWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "FuzzyIndex", {
+            InstanceMethod("search", &FuzzyIndexWrap::Search),
+        });
+    }
+
+    explicit FuzzyIndexWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<FuzzyIndexWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsArray()) {
+            Napi::TypeError::New(env, "Expected [{ id, keys }]").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Array list = info[0].As<Napi::Array>();
+        for (uint32_t i = 0; i < list.Length(); ++i) {
+            Napi::Value value = list.Get(i);
+            Napi::Object item = value.IsObject() ? value.As<Napi::Object>() : Napi::Object::New(env);
+            if (!item.Get("id").IsString() || !item.Get("keys").IsArray()) {
+                Napi::TypeError::New(env, "Expected [{ id, keys }]").ThrowAsJavaScriptException();
+                return;
+            }
+            Napi::Array keys = item.Get("keys").As<Napi::Array>();
+            for (uint32_t k = 0; k < keys.Length(); ++k) {
+                Napi::Value key = keys.Get(k);
+                index_.Add(i, key.IsString() ? key.As<Napi::String>().Utf8Value() : std::string());
+            }
+            ids_.push_back(item.Get("id").As<Napi::String>().Utf8Value());
+        }
+        index_.Build();
+    }
+
+private:
+    // search(query, { limit = 10, minScore = 0.75 }) -> [{ id, key, score }],
+    // best first; key is the index of the matching key in the entry's list
+    Napi::Value Search(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a query").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        size_t limit = 10;
+        float min_score = 0.75f;
+        if (info.Length() > 1 && info[1].IsObject()) {
+            Napi::Object options = info[1].As<Napi::Object>();
+            if (options.Get("limit").IsNumber()) {
+                limit = static_cast<size_t>(std::max(0.0, options.Get("limit").As<Napi::Number>().DoubleValue()));
+            }
+            if (options.Get("minScore").IsNumber()) {
+                min_score = options.Get("minScore").As<Napi::Number>().FloatValue();
+            }
+        }
+        std::vector<FuzzyHit> hits = index_.Search(info[0].As<Napi::String>().Utf8Value(), limit, min_score);
+        Napi::Array result = Napi::Array::New(env, hits.size());
+        for (size_t i = 0; i < hits.size(); ++i) {
+            Napi::Object hit = Napi::Object::New(env);
+            hit.Set("id", Napi::String::New(env, ids_[hits[i].entry]));
+            hit.Set("key", Napi::Number::New(env, hits[i].key));
+            hit.Set("score", Napi::Number::New(env, hits[i].score));
+            result.Set(static_cast<uint32_t>(i), hit);
+        }
+        return result;
+    }
+
+    FuzzyIndex index_;
+    std::vector<std::string> ids_;
+};
+
+AddonInstance::AddonInstance(napi_env env) : env_(env) {
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    if (g_module_envs++ == 0) {
+        g_log_forwarder = new LogForwarder();
+        StartMemoryPressureMonitor();
+    }
+}
+
+AddonInstance::~AddonInstance() {
+    std::lock_guard<std::mutex> lock(g_module_mutex);
+    g_log_forwarder->StopIfOwnedBy(env_);
+    if (g_recording_env == env_) {
+        StopRecording();
+        g_recording_env = nullptr;
+    }
+    if (g_trace_env == env_) {
+        StopPipelineTrace();
+        g_trace_env = nullptr;
+    }
+    if (g_session_capture_env == env_) {
+        StopSessionCapture();
+        g_session_capture_env = nullptr;
+    }
+    if (--g_module_envs > 0) {
+        return;
+    }
+    delete g_log_forwarder;
+    g_log_forwarder = nullptr;
+    StopMemoryPressureMonitor();
+    // Stops running jobs and fails what is still queued; each job's env
+    // has already closed its callbacks
+    for (const auto& entry : g_job_cancels) {
+        if (auto cancel = entry.lock()) {
+            cancel->store(true, std::memory_order_relaxed);
+        }
+    }
+    g_job_cancels.clear();
+    delete g_scheduler;
+    g_scheduler = nullptr;
+}
+
+AddonInstance* GetAddonInstance(Napi::Env env) {
+    return env.GetInstanceData<AddonInstance>();
+}
+
+// One session and the TSFN its deliveries reach JS through
+struct CaptureSessionSet::Entry {
+    std::unique_ptr<CaptureSession> session;
+    Napi::ThreadSafeFunction tsfn;
+    std::atomic<uint64_t> sample_index{0};  // pool thread
+    std::atomic<uint64_t> rejected{0};      // deliveries the TSFN queue refused
+};
+
+// A delivery on its way to JS, copied off the pool thread
+struct SessionDelivery {
+    std::vector<float> samples;
+    double timestamp;
+    uint64_t sample_index;
+    double host_time_ms;
+};
+
+CaptureSessionSet::CaptureSessionSet(InputFactory factory, const HostClock* clock)
+    : factory_(factory), clock_(clock) {}
+
+CaptureSessionSet::~CaptureSessionSet() {
+    StopAll();
+}
+
+Napi::Value CaptureSessionSet::Start(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[0].IsString() || !info[2].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (name, options, onData)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    for (const auto& entry : entries_) {
+        if (entry->session->Name() == name) {
+            Napi::Error::New(env, "Session '" + name + "' is already running").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    }
+
+    std::string device_id;
+    double chunk_ms = 100.0;
+    double deadline_ms = 20.0;
+    std::vector<std::unique_ptr<ProcessingStage>> stages;
+    std::vector<bool> enabled;
+    if (info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Get("deviceId").IsString()) {
+            device_id = options.Get("deviceId").As<Napi::String>().Utf8Value();
+        }
+        if (options.Get("chunkMs").IsNumber()) {
+            chunk_ms = std::max(10.0, options.Get("chunkMs").As<Napi::Number>().DoubleValue());
+        }
+        if (options.Get("deadlineMs").IsNumber()) {
+            deadline_ms = std::max(1.0, options.Get("deadlineMs").As<Napi::Number>().DoubleValue());
+        }
+        if (options.Get("stages").IsArray()) {
+            Napi::Array specs = options.Get("stages").As<Napi::Array>();
+            for (uint32_t i = 0; i < specs.Length(); ++i) {
+                std::string error;
+                std::unique_ptr<ProcessingStage> stage = CreateStage(ParseStageSpec(specs.Get(i), &enabled), &error);
+                if (!stage) {
+                    Napi::TypeError::New(env, "stage " + std::to_string(i) + ": " + error).ThrowAsJavaScriptException();
+                    return env.Undefined();
+                }
+                stages.push_back(std::move(stage));
+            }
+        }
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->session = std::make_unique<CaptureSession>(name, &DspPool::Shared());
+    entry->tsfn = Napi::ThreadSafeFunction::New(env, info[2].As<Napi::Function>(), "CaptureSession", 0, 1);
+    entry->tsfn.Unref(env);
+
+    Entry* self = entry.get();
+    const HostClock* clock = clock_;
+    std::string error;
+    bool started = entry->session->Start(factory_(), device_id, std::move(stages), enabled, chunk_ms, deadline_ms,
+                                         [self, clock](const float* data, size_t num_samples, uint64_t host_time) {
+        // Off the device thread, so a copy per delivery is affordable here
+        auto* delivery = new SessionDelivery{std::vector<float>(data, data + num_samples),
+                                             clock->ToDateNowMs(host_time),
+                                             self->sample_index.fetch_add(num_samples, std::memory_order_relaxed),
+                                             clock->HostTimeMs(host_time)};
+        napi_status status = self->tsfn.NonBlockingCall(delivery, [](Napi::Env env, Napi::Function callback,
+                                                                     SessionDelivery* delivery) {
+            try {
+                Napi::Float32Array samples = Napi::Float32Array::New(env, delivery->samples.size());
+                std::copy(delivery->samples.begin(), delivery->samples.end(), samples.Data());
+                callback.Call({ samples, Napi::Number::New(env, delivery->timestamp),
+                                Napi::Number::New(env, static_cast<double>(delivery->sample_index)),
+                                Napi::Number::New(env, delivery->host_time_ms) });
+            } catch (...) {
+                // Silently catch to prevent crash
+            }
+            delete delivery;
+        });
+        if (status != napi_ok) {
+            self->rejected.fetch_add(1, std::memory_order_relaxed);
+            delete delivery;
+        }
+    }, &error);
+    if (!started) {
+        entry->tsfn.Release();
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    entries_.push_back(std::move(entry));
+    return env.Undefined();
+}
+
+Napi::Value CaptureSessionSet::Stop(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected session name").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if ((*it)->session->Name() == name) {
+            (*it)->session->Stop();
+            (*it)->tsfn.Release();
+            entries_.erase(it);
+            return Napi::Boolean::New(env, true);
+        }
+    }
+    return Napi::Boolean::New(env, false);
+}
+
+void CaptureSessionSet::StopAll() {
+    for (auto& entry : entries_) {
+        entry->session->Stop();
+        entry->tsfn.Release();
+    }
+    entries_.clear();
+}
+
+Napi::Value CaptureSessionSet::GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object result = Napi::Object::New(env);
+    DspPool::Stats pool_stats = DspPool::Shared().GetStats();
+    Napi::Object pool = Napi::Object::New(env);
+    pool.Set("threads", Napi::Number::New(env, static_cast<double>(pool_stats.threads)));
+    pool.Set("jobs", Napi::Number::New(env, static_cast<double>(pool_stats.jobs)));
+    pool.Set("runs", Napi::Number::New(env, static_cast<double>(pool_stats.runs)));
+    pool.Set("deadlineMisses", Napi::Number::New(env, static_cast<double>(pool_stats.deadline_misses)));
+    result.Set("pool", pool);
+
+    Napi::Array sessions = Napi::Array::New(env, entries_.size());
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        const CaptureSession& session = *entries_[i]->session;
+        CaptureSessionStats stats = session.Stats();
+        Napi::Object object = Napi::Object::New(env);
+        object.Set("name", Napi::String::New(env, session.Name()));
+        if (session.DeviceId().empty()) {
+            object.Set("deviceId", env.Null());
+        } else {
+            object.Set("deviceId", Napi::String::New(env, session.DeviceId()));
+        }
+        object.Set("running", Napi::Boolean::New(env, session.IsRunning()));
+        object.Set("inputSampleRate", Napi::Number::New(env, session.InputSampleRate()));
+        object.Set("outputSampleRate", Napi::Number::New(env, session.OutputSampleRate()));
+        object.Set("buffers", Napi::Number::New(env, static_cast<double>(stats.buffers)));
+        object.Set("buffersDropped", Napi::Number::New(env, static_cast<double>(stats.buffers_dropped)));
+        object.Set("samplesIn", Napi::Number::New(env, static_cast<double>(stats.samples_in)));
+        object.Set("samplesOut", Napi::Number::New(env, static_cast<double>(stats.samples_out)));
+        object.Set("deliveries", Napi::Number::New(env, static_cast<double>(stats.deliveries)));
+        object.Set("deliveriesRejected",
+                   Napi::Number::New(env, static_cast<double>(entries_[i]->rejected.load(std::memory_order_relaxed))));
+        Napi::Object dsp = Napi::Object::New(env);
+        dsp.Set("runs", Napi::Number::New(env, static_cast<double>(stats.dsp.runs)));
+        dsp.Set("deadlineMs", Napi::Number::New(env, stats.dsp.deadline_ns / 1e6));
+        dsp.Set("deadlineMisses", Napi::Number::New(env, static_cast<double>(stats.dsp.deadline_misses)));
+        dsp.Set("cpuMs", Napi::Number::New(env, stats.dsp.busy_ns / 1e6));
+        Napi::Object latency = Napi::Object::New(env);
+        latency.Set("p50Ms", Napi::Number::New(env, stats.dsp.latency_us.p50 / 1000.0));
+        latency.Set("p95Ms", Napi::Number::New(env, stats.dsp.latency_us.p95 / 1000.0));
+        latency.Set("p99Ms", Napi::Number::New(env, stats.dsp.latency_us.p99 / 1000.0));
+        latency.Set("maxMs", Napi::Number::New(env, stats.dsp.latency_us.max / 1000.0));
+        dsp.Set("latency", latency);
+        object.Set("dsp", dsp);
+        sessions.Set(static_cast<uint32_t>(i), object);
+    }
+    result.Set("sessions", sessions);
+    return result;
+}
+
+void InitModuleFunctions(Napi::Env env, Napi::Object exports) {
+    env.SetInstanceData(new AddonInstance(env));
+    exports.Set("setLogHandler", Napi::Function::New(env, SetLogHandler, "setLogHandler"));
+    exports.Set("setLogLevel", Napi::Function::New(env, SetNativeLogLevel, "setLogLevel"));
+    exports.Set("startTrace", Napi::Function::New(env, StartTrace, "startTrace"));
+    exports.Set("stopTrace", Napi::Function::New(env, StopTrace, "stopTrace"));
+    exports.Set("startRecording", Napi::Function::New(env, StartNativeRecording, "startRecording"));
+    exports.Set("stopRecording", Napi::Function::New(env, StopNativeRecording, "stopRecording"));
+    exports.Set("getRecordingStatus", Napi::Function::New(env, GetNativeRecordingStatus, "getRecordingStatus"));
+    exports.Set("setRecordingKey", Napi::Function::New(env, SetNativeRecordingKey, "setRecordingKey"));
+    exports.Set("startTalkAnalytics", Napi::Function::New(env, StartNativeTalkAnalytics, "startTalkAnalytics"));
+    exports.Set("stopTalkAnalytics", Napi::Function::New(env, StopNativeTalkAnalytics, "stopTalkAnalytics"));
+    exports.Set("getTalkAnalytics", Napi::Function::New(env, GetNativeTalkAnalytics, "getTalkAnalytics"));
+    exports.Set("startSessionCapture", Napi::Function::New(env, StartNativeSessionCapture, "startSessionCapture"));
+    exports.Set("stopSessionCapture", Napi::Function::New(env, StopNativeSessionCapture, "stopSessionCapture"));
+    exports.Set("compressRecording", Napi::Function::New(env, CompressNativeRecording, "compressRecording"));
+    exports.Set("segmentRecording", Napi::Function::New(env, SegmentNativeRecording, "segmentRecording"));
+    exports.Set("alignTranscript", Napi::Function::New(env, AlignNativeTranscript, "alignTranscript"));
+    exports.Set("extractClip", Napi::Function::New(env, ExtractNativeClip, "extractClip"));
+    exports.Set("reprocessRecordings", Napi::Function::New(env, ReprocessNativeRecordings, "reprocessRecordings"));
+    exports.Set("exportBundle", Napi::Function::New(env, ExportNativeBundle, "exportBundle"));
+    exports.Set("preloadDsp", Napi::Function::New(env, PreloadDsp, "preloadDsp"));
+    exports.Set("getCpuFeatures", Napi::Function::New(env, GetNativeCpuFeatures, "getCpuFeatures"));
+    exports.Set("getSchedulerStats", Napi::Function::New(env, GetSchedulerStats, "getSchedulerStats"));
+    exports.Set("getWakeupStats", Napi::Function::New(env, GetNativeWakeupStats, "getWakeupStats"));
+    exports.Set("getThreadCpu", Napi::Function::New(env, GetNativeThreadCpu, "getThreadCpu"));
+    exports.Set("getNativeMemory", Napi::Function::New(env, GetNativeMemory, "getNativeMemory"));
+    exports.Set("setMemoryMinimums", Napi::Function::New(env, SetNativeMemoryMinimums, "setMemoryMinimums"));
+    exports.Set("ingestKnowledge", Napi::Function::New(env, IngestKnowledge, "ingestKnowledge"));
+    exports.Set("waitSharedRing", Napi::Function::New(env, WaitSharedRing, "waitSharedRing"));
+    exports.Set("EmbeddingCache", EmbeddingCacheWrap::Define(env));
+    exports.Set("EmbeddingIndex", EmbeddingIndexWrap::Define(env));
+    exports.Set("EmbeddingStore", EmbeddingStoreWrap::Define(env));
+    exports.Set("LexicalIndex", LexicalIndexWrap::Define(env));
+    exports.Set("MeetingIndex", MeetingIndexWrap::Define(env));
+    exports.Set("FuzzyIndex", FuzzyIndexWrap::Define(env));
+    exports.Set("ProcessingGraph", ProcessingGraphWrap::Define(env));
+    exports.Set("RecordingReader", RecordingReaderWrap::Define(env));
+    exports.Set("RecordingPlayer", RecordingPlayerWrap::Define(env));
+    exports.Set("Tokenizer", TokenizerWrap::Define(env));
+    exports.Set("TriggerMatcher", TriggerMatcherWrap::Define(env));
+    exports.Set("TranscriptionSocket", DefineTranscriptionSocket(env));
+    exports.Set("LocalTranscriber", DefineLocalTranscriber(env));
+    exports.Set("ChannelInterleaver", DefineChannelInterleaver(env));
+    exports.Set("InterleaverChannel", DefineInterleaverChannel(env));
+    exports.Set("SessionReplay", DefineSessionReplay(env));
+    exports.Set("SharedMemoryRing", DefineSharedMemoryRing(env));
+}
+
+} // namespace kakarot
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <napi.h>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "aec_processor.h"
+#include "capture_session.h"
+#include "capture_stats.h"
+#include "host_time.h"
+#include "keyword_spotter.h"
+#include "latency_trace.h"
+#include "meeting_audio_monitor.h"
+#include "performance_report.h"
+#include "shadow_aec.h"
+#include "voice_verifier.h"
+
+namespace kakarot {
+
+class CaptureStream;
+
+// N-API glue shared by the per-platform AudioCaptureAddon translation units
+// (CoreAudio on macOS, WASAPI on Windows), so both speak the same JS shapes.
+
+// Overlays the JS options object on |base|. A preset brings its submodule
+// defaults first; explicit enableAec/enableNs/enableAgc/nsLevel then win.
+// Unknown names and mistyped fields are ignored.
+AECConfig ParseAECConfig(const Napi::Value& value, const AECConfig& base);
+
+// warmStart option / getAecProfile() shape: { echoDelayMs?, streamDelayMs?,
+// preset? }. Unknown presets and mistyped fields are left unset.
+AECWarmStart ParseAECWarmStart(const Napi::Value& value);
+Napi::Object AECWarmStartToObject(Napi::Env env, const AECWarmStart& warm_start);
+
+// noiseProfile option / getNoiseProfile() shape: { noiseFloor, bandsDb
+// (kNoiseBands levels, low to high), frames }. False for anything else.
+bool ParseNoiseProfile(const Napi::Value& value, NoiseProfile* profile);
+Napi::Object NoiseProfileToObject(Napi::Env env, const NoiseProfile& profile);
+
+// setAecProfiles([{ inputDeviceUid, outputDeviceUid, ...warmStart }]): the
+// app's stored profiles; entries without both UIDs are skipped
+std::vector<AECProfileTable::Entry> ParseAECProfiles(const Napi::Value& value);
+
+// setPowerProfile(mode): 'normal', 'lowPower', or 'auto' to follow the
+// power source where the platform reports one. Low power runs the APM on
+// ApplyLowPowerProfile() of the configured AEC and batches deliveries to at
+// least kLowPowerDeliveryMs.
+enum class PowerProfile { kNormal, kLowPower, kAuto };
+constexpr double kLowPowerDeliveryMs = 100.0;
+bool ParsePowerProfile(const Napi::Value& value, PowerProfile* profile);
+
+// getConfig() / getMetrics() shapes
+Napi::Object AECConfigToObject(Napi::Env env, const AECConfig& config);
+Napi::Object AECConfigStatusToObject(Napi::Env env, const AECConfigStatus& status);
+Napi::Object AECMetricsToObject(Napi::Env env, const AECMetrics& metrics);
+
+// getShadowComparison(): { running, candidate, maxLoad, secondsProcessed,
+// secondsCompared, secondsSkipped, framesDropped, cpuLoad, live, shadow },
+// each side { erleDb?, leakageDb?, residualEchoLikelihood?,
+// convergedFraction, processingLoad, captureCalls }
+Napi::Object ShadowAecComparisonToObject(Napi::Env env, const ShadowAecComparison& comparison);
+
+// startMeetingMonitor()'s event { speechSeconds, windowSeconds, speechRuns,
+// confidence } and getMeetingMonitorStats()
+Napi::Object MeetingAudioEventToObject(Napi::Env env, const MeetingAudioEvent& event);
+Napi::Object MeetingAudioMonitorStatsToObject(Napi::Env env, const MeetingAudioMonitorStats& stats);
+
+// startKeywordSpotter()'s keywords: [text | { text, threshold? }]; false
+// with |error| for anything else
+bool ParseKeywordSpecs(const Napi::Value& value, std::vector<KeywordSpec>* keywords, std::string* error);
+
+// Its event { keyword, index, confidence, startMs, endMs, detectedMs } and
+// getKeywordSpotterStats()
+Napi::Object KeywordEventToObject(Napi::Env env, const KeywordEvent& event);
+Napi::Object KeywordSpotterStatsToObject(Napi::Env env, const KeywordSpotterStats& stats);
+
+// getVoiceVerifierStats() { enrolled, enrolling, enrollmentSeconds,
+// utterances, accepted, rejected, framesHeld, lastScore, threshold }
+Napi::Object VoiceVerifierStatsToObject(Napi::Env env, const VoiceVerifierStats& stats);
+
+// getCaptureStats() / getLatencyTrace() entry for one stream
+Napi::Object CaptureStatsToObject(Napi::Env env, const CaptureStats& stats, const HostClock& clock);
+Napi::Object LatencyTraceToObject(Napi::Env env, const LatencyTrace& trace);
+
+// readHistory(stream, { lastMs } | { fromHostTimeMs, toHostTimeMs }, format?)
+// for one stream: { sampleRate, hostTimeMs, timestamp, durationMs, segments:
+// [{ offsetMs, hostTimeMs, timestamp }] } plus samples (Float32Array) or,
+// with format 'ogg', data (an Ogg Opus Buffer). lastMs counts back from the
+// newest audio held. Null when the stream keeps no history or none of the
+// range is held; throws on bad arguments.
+Napi::Value ReadCaptureHistory(Napi::Env env, const CaptureStream& stream, const HostClock& clock,
+                               const Napi::Value& options);
+
+// readMetrics(Float64Array) slots: each Put() fills the next one, so polling
+// allocates nothing. Made with |names| instead, the same calls name the
+// slots, prefixed, for getMetricsLayout(). Unset values and slots past the
+// array's end are NaN and skipped respectively; Count() is the layout length.
+class MetricsWriter {
+public:
+    MetricsWriter(double* out, size_t capacity) : out_(out), capacity_(capacity) {}
+    explicit MetricsWriter(std::vector<std::string>* names) : names_(names) {}
+
+    void SetPrefix(const char* prefix) { prefix_ = prefix; }
+
+    void Put(const char* name, double value) {
+        if (names_) {
+            names_->push_back(std::string(prefix_) + name);
+        } else if (count_ < capacity_) {
+            out_[count_] = value;
+        }
+        ++count_;
+    }
+
+    template <typename T>
+    void Put(const char* name, const std::optional<T>& value) {
+        Put(name, value ? static_cast<double>(*value) : std::nan(""));
+    }
+
+    size_t Count() const { return count_; }
+
+private:
+    double* out_ = nullptr;
+    size_t capacity_ = 0;
+    std::vector<std::string>* names_ = nullptr;
+    const char* prefix_ = "";
+    size_t count_ = 0;
+};
+
+// getMetrics(), a getCaptureStats() stream and a getLatencyTrace() stream
+// as slots, named as their object keys (nested ones dotted). Booleans are 0
+// or 1, the suppression level 0/1 and the governor level 0-4.
+void WriteAECMetrics(MetricsWriter* writer, const AECMetrics& metrics);
+void WriteCaptureStats(MetricsWriter* writer, const CaptureStats& stats, const HostClock& clock);
+void WriteLatencyTrace(MetricsWriter* writer, const LatencyTrace& trace);
+
+// getMetricsLayout() shape: { length, offsets: { [name]: index } }
+Napi::Object MetricsLayoutToObject(Napi::Env env, const std::vector<std::string>& names);
+
+// startPerformanceReport({ intervalMs? }) for an instance whose
+// readMetrics() slots |write| fills, sampled on |recorder|'s thread every
+// intervalMs (default 1000). stopPerformanceReport() -> { durationMs,
+// intervalMs, samples, metrics: { [name]: value }, series: { [name]:
+// { bucketMs, min, mean, max } } }, or null when none was running.
+void StartPerformanceReport(const Napi::CallbackInfo& info, PerformanceRecorder* recorder,
+                            std::function<void(MetricsWriter*)> write);
+Napi::Value StopPerformanceReport(Napi::Env env, PerformanceRecorder* recorder);
+
+// An addon instance's named capture sessions, beside its own mic and
+// system streams: startSession(name, { deviceId?, stages?, chunkMs?,
+// deadlineMs? }, onData) opens the device and its graph (ProcessingGraph
+// stage specs, none by default) on the shared DspPool; onData(samples,
+// { hostTimeMs, sampleRate }) gets chunkMs deliveries (default 100).
+// stopSession(name) returns whether one ran; getSessions() -> { pool:
+// { threads, jobs, runs, deadlineMisses }, sessions: [...] }. JS thread.
+class CaptureSessionSet {
+public:
+    using InputFactory = std::unique_ptr<SessionInput> (*)();
+
+    CaptureSessionSet(InputFactory factory, const HostClock* clock);
+    ~CaptureSessionSet();
+
+    CaptureSessionSet(const CaptureSessionSet&) = delete;
+    CaptureSessionSet& operator=(const CaptureSessionSet&) = delete;
+
+    Napi::Value Start(const Napi::CallbackInfo& info);
+    Napi::Value Stop(const Napi::CallbackInfo& info);
+    Napi::Value GetStats(const Napi::CallbackInfo& info);
+    void StopAll();
+
+private:
+    struct Entry;
+
+    InputFactory factory_;
+    const HostClock* clock_;
+    std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+// Per-env state, owned by each env the addon is loaded in (the main thread
+// or a worker_thread) through its instance data. Tearing an env down stops
+// what that env started: its log handler and any recording, trace or
+// session capture; the last env also takes the process-wide services down.
+class AddonInstance {
+public:
+    explicit AddonInstance(napi_env env);
+    ~AddonInstance();
+
+    AddonInstance(const AddonInstance&) = delete;
+    AddonInstance& operator=(const AddonInstance&) = delete;
+
+    Napi::FunctionReference capture_addon;  // this env's AudioCaptureAddon class
+    Napi::FunctionReference transcription_socket;  // and its TranscriptionSocket class
+    Napi::FunctionReference local_transcriber;     // and LocalTranscriber class
+    Napi::FunctionReference channel_interleaver;   // and ChannelInterleaver class
+    Napi::FunctionReference interleaver_channel;   // and InterleaverChannel class
+    Napi::FunctionReference lexical_index;         // and LexicalIndex class
+
+private:
+    napi_env env_;
+};
+
+AddonInstance* GetAddonInstance(Napi::Env env);
+
+// Process-wide module functions: setLogHandler, setLogLevel, startTrace,
+// stopTrace, startRecording, stopRecording, getRecordingStatus,
+// startSessionCapture, stopSessionCapture, compressRecording,
+// segmentRecording, reprocessRecordings, getSchedulerStats,
+// getNativeMemory, setMemoryMinimums, ingestKnowledge, waitSharedRing, and
+// the EmbeddingCache, EmbeddingIndex, EmbeddingStore, LexicalIndex,
+// MeetingIndex, FuzzyIndex, ProcessingGraph, RecordingReader, Tokenizer,
+// TriggerMatcher, TranscriptionSocket, LocalTranscriber, ChannelInterleaver,
+// InterleaverChannel and SessionReplay classes.
+// Sets up the env's AddonInstance, so it runs before the addon class's Init.
+void InitModuleFunctions(Napi::Env env, Napi::Object exports);
+
+} // namespace kakarot
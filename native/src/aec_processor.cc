@@ -1,393 +1,1876 @@
 #include "aec_processor.h"
-#include "api/audio/builtin_audio_processing_builder.h"
+#include "dsp_kernels.h"
+#include "dsp_module.h"
+#include "frame_kernels.h"
+#include "latency_histogram.h"
+#include "level_analyzer.h"
+#include "native_log.h"
+#include "nlms_echo_canceller.h"
+#include "noise_profile.h"
+#include "pipeline_trace.h"
+#include "residual_echo_detector.h"
+#include "speech_normalizer.h"
+#include "spsc_ring_buffer.h"
 #include "api/audio/audio_processing.h"
-#include "api/environment/environment_factory.h"
 #include "api/audio/echo_canceller3_config.h"
 #include "api/scoped_refptr.h"
-#include <iostream>
+#include "api/task_queue/task_queue_base.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
 #include <cstring>
 #include <cmath>
 #include <algorithm>
-#include <queue>
-#include <optional>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <tuple>
 
 namespace kakarot {
 
+// The original tuning: long filters, fast adaptation and much stronger
+// suppression, for open speakers in a meeting
+static void ApplyAggressiveTuning(webrtc::EchoCanceller3Config& config) {
+    // DELAY - allow up to 500ms of delay between speakers and mic
+    config.delay.default_delay = 5;
+    config.delay.down_sampling_factor = 4;
+    config.delay.num_filters = 5;
+    config.delay.delay_headroom_samples = 64;  // More headroom (was 32)
+    config.delay.hysteresis_limit_blocks = 2;  // More stable (was 1)
+    
+    // FILTER - Make adaptive filter longer and more aggressive
+    config.filter.refined.length_blocks = 24;  // Longer filter (default 13)
+    config.filter.refined.leakage_converged = 0.00002f;  // Less leakage (was 0.00005)
+    config.filter.refined_initial.length_blocks = 18;  // Longer initial (default 12)
+    config.filter.refined_initial.leakage_converged = 0.0002f;  // Less leakage
+    config.filter.config_change_duration_blocks = 100;  // Faster adaptation (was 250)
+    config.filter.initial_state_seconds = 1.5f;  // Faster startup (was 2.5)
+    config.filter.conservative_initial_phase = false;  // Aggressive from start
+    
+    // SUPPRESSOR - MUCH more aggressive echo suppression
+    config.suppressor.nearend_average_blocks = 4;
+    
+    // Normal tuning - more aggressive suppression
+    config.suppressor.normal_tuning.mask_lf.enr_transparent = 0.15f;  // Start suppressing earlier (was 0.3)
+    config.suppressor.normal_tuning.mask_lf.enr_suppress = 0.2f;  // Suppress harder (was 0.4)
+    config.suppressor.normal_tuning.mask_hf.enr_transparent = 0.04f;  // Very aggressive HF (was 0.07)
+    config.suppressor.normal_tuning.mask_hf.enr_suppress = 0.05f;  // Very aggressive HF (was 0.1)
+    config.suppressor.normal_tuning.max_inc_factor = 1.5f;  // Slower gain increase (was 2.0)
+    config.suppressor.normal_tuning.max_dec_factor_lf = 0.1f;  // Faster gain decrease (was 0.25)
+    
+    // High bands suppression - crush echo in high frequencies
+    config.suppressor.high_bands_suppression.enr_threshold = 0.5f;  // More sensitive (was 1.0)
+    config.suppressor.high_bands_suppression.max_gain_during_echo = 0.01f;  // Near silence during echo (was 1.0)
+    
+    // Floor first increase - allow quick suppression
+    config.suppressor.floor_first_increase = 0.000001f;  // Very small (was 0.00001)
+    
+    // Dominant nearend detection - detect voice more sensitively
+    config.suppressor.dominant_nearend_detection.enr_threshold = 0.15f;  // Lower threshold (was 0.25)
+    config.suppressor.dominant_nearend_detection.trigger_threshold = 8;  // Faster trigger (was 12)
+    
+    // Echo audibility - be more aggressive about detecting echo
+    config.echo_audibility.floor_power = 32.f;  // Lower floor (was 128)
+    config.echo_audibility.audibility_threshold_lf = 5.f;  // More sensitive (was 10)
+    config.echo_audibility.audibility_threshold_mf = 5.f;
+    config.echo_audibility.audibility_threshold_hf = 5.f;
+    
+    // Render levels - capture more echo
+    config.render_levels.active_render_limit = 50.f;  // Lower threshold (was 100)
+    
+    // EP strength - protect nearend speech
+    config.ep_strength.default_len = 0.95f;  // Strong protection (was 0.83)
+}
+
+// AEC3 works in 4ms blocks (64 samples of its 16kHz band) at any rate
+static constexpr int kAec3BlockMs = 4;
+
+// Warm-start delays beyond the aggressive tuning's reach are not trusted
+static constexpr int kMaxWarmStartDelayMs = 500;
+
+// AEC3 tuning per preset, with the delay search seeded from a previous
+// session. Unlike the APM submodules these can only be set when the
+// AudioProcessing instance is built.
+static webrtc::EchoCanceller3Config BuildEchoCancellerConfig(AECPreset preset, const AECWarmStart& warm_start) {
+    webrtc::EchoCanceller3Config config;
+    switch (preset) {
+        case AECPreset::kAggressive:
+            ApplyAggressiveTuning(config);
+            break;
+        case AECPreset::kLowCpu:
+            // Shorter adaptive filters and fewer delay candidates
+            config.filter.refined.length_blocks = 8;
+            config.filter.refined_initial.length_blocks = 8;
+            config.filter.coarse.length_blocks = 8;
+            config.filter.coarse_initial.length_blocks = 8;
+            config.delay.num_filters = 3;
+            break;
+        case AECPreset::kHeadphones:
+        case AECPreset::kDefault:
+            break;
+    }
+    if (warm_start.echo_delay_ms) {
+        config.delay.default_delay = static_cast<size_t>(
+            std::clamp(*warm_start.echo_delay_ms, 0, kMaxWarmStartDelayMs) / kAec3BlockMs);
+    }
+    return config;
+}
+
+static webrtc::AudioProcessing::Config::NoiseSuppression::Level NsLevel(int level) {
+    using Level = webrtc::AudioProcessing::Config::NoiseSuppression::Level;
+    switch (level) {
+        case 0: return Level::kLow;
+        case 2: return Level::kHigh;
+        case 3: return Level::kVeryHigh;
+        default: return Level::kModerate;
+    }
+}
+
+// Submodule settings; all of these can change at runtime through ApplyConfig
+static webrtc::AudioProcessing::Config BuildApmConfig(const AECConfig& config) {
+    webrtc::AudioProcessing::Config apm_config;
+    apm_config.echo_canceller.enabled = config.enable_aec;
+    apm_config.echo_canceller.mobile_mode = false;
+    apm_config.noise_suppression.enabled = config.enable_ns;
+    apm_config.noise_suppression.level = NsLevel(config.ns_level);
+    apm_config.gain_controller2.enabled = config.enable_agc;
+    apm_config.gain_controller2.adaptive_digital.enabled = config.enable_agc;
+    apm_config.high_pass_filter.enabled = true;
+    return apm_config;
+}
+
+// Built by the kakarot_dsp module, loaded here the first time; nullptr
+// without it
+static webrtc::scoped_refptr<webrtc::AudioProcessing> BuildApm(const AECConfig& config, int render_channels) {
+    // With a multichannel reference AEC3 switches to the second config once it
+    // detects real stereo content; until then it cancels against a downmix.
+    // Both get the preset tuning.
+    webrtc::EchoCanceller3Config aec3_config = BuildEchoCancellerConfig(config.preset, config.warm_start);
+    std::optional<webrtc::EchoCanceller3Config> multichannel_config;
+    if (render_channels > 1) {
+        multichannel_config = aec3_config;
+    }
+    return BuildDspApm(BuildApmConfig(config), aec3_config, multichannel_config);
+}
+
+// Widest render layout Initialize accepts
+static constexpr int kMaxRenderChannels = 8;
+
+// PostConfig() applies a change itself after this long without capture,
+// when no frame boundary is coming to take it
+static constexpr uint64_t kMailboxIdleNs = 100 * 1000 * 1000;
+
+// The config mailbox's state: the middle slot's index, and whether it holds
+// a change the capture thread has not taken
+static constexpr uint8_t kMailboxIndex = 0x3;
+static constexpr uint8_t kMailboxFresh = 0x4;
+
+// Render frames the fallback canceller and the residual detector may have
+// waiting for the capture thread; more means capture has stalled
+static constexpr size_t kRenderHandoffFrames = 64;
+
+static const char* const kLogSource = "AECProcessor";
+
+// Fallback canceller reach: filter length, and how far the reported stream
+// delay may move it back
+static constexpr int kFallbackFilterMs = 250;
+static constexpr int kFallbackMaxDelayMs = 500;
+
+// Thresholds for reporting the canceller as converged
+static constexpr float kConvergedErleDb = 6.0f;
+static constexpr float kMaxConvergedDivergence = 0.1f;
+
+// Echo path watch: a converged canceller whose delay estimate moves this
+// far from where it converged, and stays there, has a stale filter
+static constexpr int kEchoPathJumpMs = 32;
+static constexpr int kEchoPathJumpSeconds = 2;
+
+// Adaptive suppression: residual echo likelihood that must hold, once a
+// second, before moving to the aggressive preset or back to the default one.
+// Relaxing takes much longer, since each switch restarts AEC3.
+static constexpr float kEscalateLikelihood = 0.5f;
+static constexpr int kEscalateSeconds = 3;
+static constexpr float kRelaxLikelihood = 0.25f;  // chance correlation across delays sits ~0.15
+static constexpr int kRelaxSeconds = 60;
+
+// ApplyLowPowerProfile(): wideband is all speech needs
+static constexpr int kLowPowerProcessingRate = 16000;
+
+// Noise a fresh APM hears before capture: two seconds, as long as WebRTC
+// NS's quantile estimate takes to leave its startup phase
+static constexpr size_t kNoisePrimeFrames = 200;
+
+// Noise learning skips frames while render may be echoing: a render peak
+// above this, and the room's tail after it
+static constexpr float kRenderActivePeak = 0.003f;  // about -50dBFS
+static constexpr uint64_t kEchoTailNs = 500ull * 1000 * 1000;
+
+// Runs kNoisePrimeFrames of |profile|'s noise through a fresh |apm| at
+// |rate| before it sees capture. WebRTC NS keeps its noise estimate to
+// itself, so the way to start it warm is to let it hear the room first;
+// AEC3 has no render to adapt to meanwhile and is left as built.
+static void PrimeNoiseSuppressor(webrtc::AudioProcessing* apm, const NoiseProfile& profile, int rate) {
+    const size_t frame_size = static_cast<size_t>(rate / 100);
+    std::vector<float> noise;
+    SynthesizeNoise(profile, rate, frame_size * kNoisePrimeFrames, profile.frames, &noise);
+    std::vector<float> output(frame_size);
+    const webrtc::StreamConfig config(rate, 1);
+    for (size_t i = 0; i < kNoisePrimeFrames; ++i) {
+        const float* input_ptr = noise.data() + i * frame_size;
+        float* output_ptr = output.data();
+        apm->set_stream_delay_ms(0);
+        apm->ProcessStream(&input_ptr, config, config, &output_ptr);
+    }
+}
+
+// CPU governor steps, each on top of the ones before it
+enum GovernorLevel {
+    kGovernorFull = 0,
+    kGovernorNoAgc,
+    kGovernorLightNs,
+    kGovernorShortFilters,
+    kGovernorWideband,
+    kGovernorLevels,
+};
+static const char* const kGovernorLevelNames[] = {
+    "full", "AGC off", "NS low", "short filters", "16kHz",
+};
+
+// A second is over budget with this many deadline misses, or this share of
+// capture frames past half the frame duration. Stepping down takes two such
+// seconds in a row; stepping back up, half a minute well inside the budget.
+static constexpr uint64_t kGovernorMaxMisses = 2;
+static constexpr float kGovernorSlowShare = 0.1f;
+static constexpr int kGovernorDownSeconds = 2;
+static constexpr float kGovernorHeadroomLoad = 0.15f;
+static constexpr int kGovernorUpSeconds = 30;
+
+// |config| with the governor's first |level| steps applied. A step that
+// changes nothing for this config is a no-op.
+static AECConfig GovernedConfig(const AECConfig& config, int level) {
+    AECConfig governed = config;
+    if (level >= kGovernorNoAgc) {
+        governed.enable_agc = false;
+    }
+    if (level >= kGovernorLightNs) {
+        governed.ns_level = 0;
+    }
+    if (level >= kGovernorShortFilters && governed.preset != AECPreset::kHeadphones) {
+        governed.preset = AECPreset::kLowCpu;
+    }
+    if (level >= kGovernorWideband &&
+        (governed.processing_sample_rate == 0 || governed.processing_sample_rate > kLowPowerProcessingRate)) {
+        governed.processing_sample_rate = kLowPowerProcessingRate;
+    }
+    return governed;
+}
+
 class AECProcessor::Impl {
 public:
-    explicit Impl(const AECConfig& config) : config_(config) {}
+    explicit Impl(const AECConfig& config)
+        : config_(config), aec_enabled_(config.enable_aec), adaptive_(config.adaptive_suppression) {
+        if (config_.adaptive_suppression) {
+            config_.preset = config_.warm_start.preset.value_or(AECPreset::kDefault);
+            escalated_ = config_.preset == AECPreset::kAggressive;
+        }
+        applied_ = config_;
+        governor_.store(config_.cpu_governor, std::memory_order_relaxed);
+        stream_delay_ms_ = std::max(0, config_.warm_start.stream_delay_ms.value_or(0));
+    }
     
     ~Impl() {
-        // scoped_refptr will automatically clean up
+        // The preset switch it may be running locks apm_mutex_
+        if (adapt_thread_.joinable()) {
+            adapt_thread_.join();
+        }
+        // The dump writes on dump_queue_, which must outlive it
+        StopAecDump();
     }
     
-    bool Initialize(int sample_rate, int num_channels) {
+    bool Initialize(int sample_rate, int capture_channels, int render_channels) {
+        if (capture_channels != 1 || render_channels < 1 || render_channels > kMaxRenderChannels) {
+            Log(LogLevel::kError, kLogSource, "Unsupported AEC channel layout: capture=%d, render=%d",
+                capture_channels, render_channels);
+            return false;
+        }
         sample_rate_ = sample_rate;
-        num_channels_ = num_channels;
+        num_channels_ = capture_channels;
+        render_channels_ = render_channels;
         frame_size_ = (sample_rate * config_.frame_duration_ms) / 1000;
+        frame_kernels_ = dsp::FrameKernelsFor(frame_size_);
+        levels_ = std::make_unique<LevelAnalyzer>(frame_size_);
+        if (config_.noise_profile) {
+            levels_->SetNoiseFloor(config_.noise_profile->noise_floor);
+        }
+        noise_learner_.reset();
+        if (NoiseProfileLearner::Supports(sample_rate) && config_.frame_duration_ms == 10) {
+            noise_learner_ = std::make_unique<NoiseProfileLearner>(sample_rate);
+        }
+        normalizer_.reset();
+        if (SpeechNormalizer::Supports(sample_rate) && config_.frame_duration_ms == 10) {
+            normalizer_ = std::make_unique<SpeechNormalizer>(sample_rate, config_.normalize_target_dbfs);
+        }
+        normalize_target_dbfs_ = config_.normalize_target_dbfs;
+        normalize_.store(config_.normalize_speech && normalizer_, std::memory_order_relaxed);
+        residual_ = std::make_unique<ResidualEchoDetector>(
+            frame_size_, kFallbackMaxDelayMs / config_.frame_duration_ms, 1000 / config_.frame_duration_ms);
 
-        std::cout << "🔧 Initializing AEC with frame_size=" << frame_size_ << " samples (" 
-                  << config_.frame_duration_ms << "ms at " << sample_rate << "Hz)\n";
+        int processing_rate = ProcessingRateFor(config_);
+        processing_rate_ = processing_rate;
+
+        Log(LogLevel::kInfo, kLogSource,
+            "Initializing AEC with frame_size=%zu samples (%dms at %dHz, APM at %dHz, %d render channel(s))",
+            frame_size_, config_.frame_duration_ms, sample_rate, processing_rate, render_channels_);
 
         try {
-            // Create custom EchoCanceller3Config for aggressive echo suppression
-            webrtc::EchoCanceller3Config aec3_config;
-            
-            // DELAY - allow up to 500ms of delay between speakers and mic
-            aec3_config.delay.default_delay = 5;
-            aec3_config.delay.down_sampling_factor = 4;
-            aec3_config.delay.num_filters = 5;
-            aec3_config.delay.delay_headroom_samples = 64;  // More headroom (was 32)
-            aec3_config.delay.hysteresis_limit_blocks = 2;  // More stable (was 1)
-            
-            // FILTER - Make adaptive filter longer and more aggressive
-            aec3_config.filter.refined.length_blocks = 24;  // Longer filter (default 13)
-            aec3_config.filter.refined.leakage_converged = 0.00002f;  // Less leakage (was 0.00005)
-            aec3_config.filter.refined_initial.length_blocks = 18;  // Longer initial (default 12)
-            aec3_config.filter.refined_initial.leakage_converged = 0.0002f;  // Less leakage
-            aec3_config.filter.config_change_duration_blocks = 100;  // Faster adaptation (was 250)
-            aec3_config.filter.initial_state_seconds = 1.5f;  // Faster startup (was 2.5)
-            aec3_config.filter.conservative_initial_phase = false;  // Aggressive from start
-            
-            // SUPPRESSOR - MUCH more aggressive echo suppression
-            aec3_config.suppressor.nearend_average_blocks = 4;
-            
-            // Normal tuning - more aggressive suppression
-            aec3_config.suppressor.normal_tuning.mask_lf.enr_transparent = 0.15f;  // Start suppressing earlier (was 0.3)
-            aec3_config.suppressor.normal_tuning.mask_lf.enr_suppress = 0.2f;  // Suppress harder (was 0.4)
-            aec3_config.suppressor.normal_tuning.mask_hf.enr_transparent = 0.04f;  // Very aggressive HF (was 0.07)
-            aec3_config.suppressor.normal_tuning.mask_hf.enr_suppress = 0.05f;  // Very aggressive HF (was 0.1)
-            aec3_config.suppressor.normal_tuning.max_inc_factor = 1.5f;  // Slower gain increase (was 2.0)
-            aec3_config.suppressor.normal_tuning.max_dec_factor_lf = 0.1f;  // Faster gain decrease (was 0.25)
-            
-            // High bands suppression - crush echo in high frequencies
-            aec3_config.suppressor.high_bands_suppression.enr_threshold = 0.5f;  // More sensitive (was 1.0)
-            aec3_config.suppressor.high_bands_suppression.max_gain_during_echo = 0.01f;  // Near silence during echo (was 1.0)
-            
-            // Floor first increase - allow quick suppression
-            aec3_config.suppressor.floor_first_increase = 0.000001f;  // Very small (was 0.00001)
-            
-            // Dominant nearend detection - detect voice more sensitively
-            aec3_config.suppressor.dominant_nearend_detection.enr_threshold = 0.15f;  // Lower threshold (was 0.25)
-            aec3_config.suppressor.dominant_nearend_detection.trigger_threshold = 8;  // Faster trigger (was 12)
-            
-            // Echo audibility - be more aggressive about detecting echo
-            aec3_config.echo_audibility.floor_power = 32.f;  // Lower floor (was 128)
-            aec3_config.echo_audibility.audibility_threshold_lf = 5.f;  // More sensitive (was 10)
-            aec3_config.echo_audibility.audibility_threshold_mf = 5.f;
-            aec3_config.echo_audibility.audibility_threshold_hf = 5.f;
-            
-            // Render levels - capture more echo
-            aec3_config.render_levels.active_render_limit = 50.f;  // Lower threshold (was 100)
-            
-            // EP strength - protect nearend speech
-            aec3_config.ep_strength.default_len = 0.95f;  // Strong protection (was 0.83)
-            
-            std::cout << "✅ Aggressive AEC3 config created (2x stronger suppression)\n";
-            
-            // Create AudioProcessing::Config
-            webrtc::AudioProcessing::Config apm_config;
-            
-            // Configure echo cancellation
-            if (config_.enable_aec) {
-                apm_config.echo_canceller.enabled = true;
-                apm_config.echo_canceller.mobile_mode = false;
-                std::cout << "✅ AEC3 enabled with aggressive settings\n";
-            }
-            
-            // Configure noise suppression
-            if (config_.enable_ns) {
-                apm_config.noise_suppression.enabled = true;
-                apm_config.noise_suppression.level = 
-                    webrtc::AudioProcessing::Config::NoiseSuppression::kModerate;
-                std::cout << "✅ Noise suppression enabled\n";
-            }
-            
-            // Configure AGC
-            if (config_.enable_agc) {
-                apm_config.gain_controller2.enabled = true;
-                apm_config.gain_controller2.adaptive_digital.enabled = true;
-                std::cout << "✅ AGC enabled\n";
-            }
-            
-            // High-pass filter
-            apm_config.high_pass_filter.enabled = true;
-            
-            // Create Environment (required for Build)
-            webrtc::Environment env = webrtc::CreateEnvironment();
-            
-            // Build AudioProcessing instance with custom AEC3 config
-            webrtc::BuiltinAudioProcessingBuilder builder(apm_config);
-            
-            // Pass our custom AEC3 configuration using the correct method
-            if (config_.enable_aec) {
-                // Second parameter is for multichannel config (we use mono, so pass empty optional)
-                builder.SetEchoCancellerConfig(aec3_config, {});
-                std::cout << "✅ Custom aggressive AEC3 config applied\n";
-            }
-            
-            audio_processing_ = builder.Build(env);
+            audio_processing_ = BuildApm(config_, render_channels_);
             
             if (!audio_processing_) {
-                std::cerr << "❌ Failed to create AudioProcessing, using fallback\n";
-                return true;  // Continue with naive fallback
+                Log(LogLevel::kError, kLogSource, "Failed to create AudioProcessing, using fallback");
+                InitializeFallback();
+                return true;
+            }
+            if (config_.enable_ns && config_.noise_profile) {
+                PrimeNoiseSuppressor(audio_processing_.get(), *config_.noise_profile, processing_rate);
             }
             
-            // Initialize frame buffers
-            render_buffer_.reserve(frame_size_ * 2);  // Buffer for render audio
-            capture_buffer_.reserve(frame_size_ * 2);  // Buffer for capture audio
-            render_history_.resize(frame_size_ * 10);  // 100ms history for fallback
-            
+            // Frame buffers are sized once here; steady-state processing never allocates
+            render_frame_.assign(frame_size_ * render_channels_, 0.0f);
+            capture_frame_.assign(frame_size_, 0.0f);
+            processed_frame_.assign(frame_size_, 0.0f);  // Primes the one-frame output delay with silence
+            render_fill_ = 0;
+            capture_fill_ = 0;
+            BuildRateStage(processing_rate, &stage_);
+            BuildRateStage(processing_rate, &render_stage_);
+            render_apm_ = audio_processing_;
+            InitializeHandoff();
+            apm_ns_ = 0;
+            apm_frames_ = 0;
             frames_processed_ = 0;
+            ResetCallTiming();
             
-            std::cout << "✅ WebRTC AEC3 initialized successfully with frame buffering\n";
+            Log(LogLevel::kInfo, kLogSource, "WebRTC AEC3 initialized successfully with frame buffering");
             return true;
             
         } catch (const std::exception& e) {
-            std::cerr << "❌ Error initializing AEC: " << e.what() << "\n";
+            Log(LogLevel::kError, kLogSource, "Error initializing AEC: %s", e.what());
             audio_processing_ = nullptr;
-            return true;  // Continue with fallback
+            InitializeFallback();
+            return true;
         }
     }
 
-    void ProcessRenderAudio(const float* data, size_t num_samples) {
-        if (!config_.enable_aec) return;
-        
-        // Store for fallback
-        std::copy(data, data + std::min(num_samples, render_history_.size()), 
-                  render_history_.begin());
-        
-        if (!audio_processing_) return;
+    // Same one-frame buffering as the APM path, around the NLMS canceller
+    // (mono render). Without a supported FFT size only HPF/NS remain.
+    void InitializeFallback() {
+        render_frame_.assign(frame_size_, 0.0f);
+        capture_frame_.assign(frame_size_, 0.0f);
+        processed_frame_.assign(frame_size_, 0.0f);
+        render_fill_ = 0;
+        capture_fill_ = 0;
+        apm_ns_ = 0;
+        apm_frames_ = 0;
+        ResetCallTiming();
+        render_apm_ = nullptr;
+        InitializeHandoff();
+
+        nlms_.reset();
+        if (NlmsEchoCanceller::Supported(frame_size_)) {
+            int frame_ms = config_.frame_duration_ms;
+            nlms_ = std::make_unique<NlmsEchoCanceller>(frame_size_, kFallbackFilterMs / frame_ms,
+                                                        kFallbackMaxDelayMs / frame_ms);
+            Log(LogLevel::kWarn, kLogSource, "Using NLMS fallback echo canceller (%dms filter)", kFallbackFilterMs);
+        } else {
+            Log(LogLevel::kError, kLogSource, "No fallback echo canceller for frame_size=%zu", frame_size_);
+        }
+    }
+
+    void ProcessRenderAudio(const float* data, size_t num_frames, int num_channels) {
+        if (!aec_enabled_.load(std::memory_order_relaxed)) return;
+        if (bypass_.load(std::memory_order_relaxed)) return;
+        if (num_channels < 1) return;
         
-        // Add to render buffer
-        render_buffer_.insert(render_buffer_.end(), data, data + num_samples);
+        SwapInPendingRenderApm();
+        if (!render_apm_) {
+            // The fallback cancels against a mono downmix, on the capture thread
+            if (!nlms_) return;
+            size_t consumed = 0;
+            while (consumed < num_frames) {
+                size_t chunk = std::min(frame_size_ - render_fill_, num_frames - consumed);
+                auto downmix = chunk == frame_size_ ? frame_kernels_.downmix : &dsp::Downmix;
+                downmix(data + consumed * num_channels, chunk, num_channels, render_frame_.data() + render_fill_);
+                render_fill_ += chunk;
+                consumed += chunk;
+                if (render_fill_ == frame_size_) {
+                    NoteRenderLevel(render_frame_.data());
+                    HandOffRenderFrame(render_frame_.data());
+                    render_fill_ = 0;
+                }
+            }
+            return;
+        }
         
-        // Process complete frames
-        while (render_buffer_.size() >= frame_size_) {
-            try {
-                // Create render stream config
-                webrtc::StreamConfig stream_config(sample_rate_, num_channels_);
-                
-                // Extract one frame
-                std::vector<float> frame(render_buffer_.begin(), render_buffer_.begin() + frame_size_);
-                
-                // WebRTC needs non-const pointers
-                float* output_ptr = frame.data();
-                const float* input_ptr = frame.data();
-                
-                audio_processing_->ProcessReverseStream(
-                    &input_ptr, stream_config, stream_config, &output_ptr);
-                
-                // Remove processed frame from buffer
-                render_buffer_.erase(render_buffer_.begin(), render_buffer_.begin() + frame_size_);
-                
-            } catch (const std::exception& e) {
-                std::cerr << "❌ ProcessReverseStream error: " << e.what() << "\n";
-                // Clear buffer on error to prevent backup
-                render_buffer_.clear();
-                break;
+        // Deinterleave into the planar staging frame and process it in place
+        // each time it completes. Whole frames take the fixed-size kernels.
+        size_t consumed = 0;
+        while (consumed < num_frames) {
+            size_t chunk = std::min(frame_size_ - render_fill_, num_frames - consumed);
+            const float* src = data + consumed * num_channels;
+            bool whole = chunk == frame_size_;
+            if (num_channels == 1 && render_channels_ == 1) {
+                if (whole) {
+                    frame_kernels_.copy(src, chunk, render_frame_.data());
+                } else {
+                    std::memcpy(render_frame_.data() + render_fill_, src, chunk * sizeof(float));
+                }
+            } else if (num_channels == render_channels_) {
+                auto deinterleave = whole ? frame_kernels_.deinterleave : &dsp::Deinterleave;
+                for (int ch = 0; ch < render_channels_; ++ch) {
+                    deinterleave(src, chunk, num_channels, ch, render_frame_.data() + ch * frame_size_ + render_fill_);
+                }
+            } else {
+                // Mono downmix into the first channel, copied to the rest
+                float* mono = render_frame_.data() + render_fill_;
+                auto downmix = whole ? frame_kernels_.downmix : &dsp::Downmix;
+                downmix(src, chunk, num_channels, mono);
+                for (int ch = 1; ch < render_channels_; ++ch) {
+                    std::memcpy(mono + ch * frame_size_, mono, chunk * sizeof(float));
+                }
+            }
+            render_fill_ += chunk;
+            consumed += chunk;
+            
+            if (render_fill_ == frame_size_) {
+                ProcessRenderFrame();
+                render_fill_ = 0;
             }
         }
     }
 
+    // Output runs exactly one frame behind input: each sample written to
+    // |output| is the processed sample from frame_size_ samples earlier, so
+    // arbitrary buffer sizes map onto 10ms APM frames without copies or
+    // mixing processed and raw audio. |input| and |output| may alias.
     void ProcessCaptureAudio(const float* input, float* output, size_t num_samples) {
-        if (!audio_processing_ || !config_.enable_aec) {
-            // Fallback to improved naive algorithm
-            ProcessNaive(input, output, num_samples);
-            CalculateMetrics(output, num_samples);
+        SwapInPendingApm();
+        
+        // Not initialized: pass through
+        if (capture_frame_.empty()) {
+            if (output != input) {
+                std::memcpy(output, input, num_samples * sizeof(float));
+            }
             return;
         }
         
-        // Add input to capture buffer
-        capture_buffer_.insert(capture_buffer_.end(), input, input + num_samples);
+        // With the APM present it runs even with AEC off, so NS/HPF/AGC still apply
         
-        // Process complete frames and accumulate output
-        size_t output_written = 0;
-        
-        while (capture_buffer_.size() >= frame_size_ && output_written < num_samples) {
-            try {
-                // Create capture stream config
-                webrtc::StreamConfig stream_config(sample_rate_, num_channels_);
-                
-                // Extract one frame
-                std::vector<float> frame(capture_buffer_.begin(), capture_buffer_.begin() + frame_size_);
-                
-                // WebRTC processes in-place
-                float* frame_ptr = frame.data();
-                const float* input_ptr = frame.data();
-                
-                int result = audio_processing_->ProcessStream(
-                    &input_ptr, stream_config, stream_config, &frame_ptr);
-                
-                if (result != 0) {
-                    std::cerr << "❌ ProcessStream returned error: " << result << "\n";
-                    // Copy unprocessed frame to output
-                    size_t to_copy = std::min(frame_size_, num_samples - output_written);
-                    std::copy(frame.begin(), frame.begin() + to_copy, output + output_written);
+        size_t consumed = 0;
+        while (consumed < num_samples) {
+            size_t chunk = std::min(frame_size_ - capture_fill_, num_samples - consumed);
+            if (chunk == frame_size_) {
+                frame_kernels_.copy(input + consumed, chunk, capture_frame_.data());
+                frame_kernels_.copy(processed_frame_.data(), chunk, output + consumed);
+            } else {
+                std::memcpy(capture_frame_.data() + capture_fill_, input + consumed, chunk * sizeof(float));
+                std::memcpy(output + consumed, processed_frame_.data() + capture_fill_, chunk * sizeof(float));
+            }
+            capture_fill_ += chunk;
+            consumed += chunk;
+            
+            if (capture_fill_ == frame_size_) {
+                last_capture_ns_.store(NowNs(), std::memory_order_relaxed);
+                ApplyPostedConfig();
+                if (!std::isnan(pending_noise_floor_.load(std::memory_order_relaxed))) {
+                    levels_->SetNoiseFloor(pending_noise_floor_.exchange(std::nanf(""), std::memory_order_relaxed));
+                }
+                if (bypass_.load(std::memory_order_relaxed)) {
+                    ProcessBypassFrame();
+                } else if (audio_processing_) {
+                    ProcessCaptureFrame();
                 } else {
-                    // Copy processed frame to output
-                    size_t to_copy = std::min(frame_size_, num_samples - output_written);
-                    std::copy(frame.begin(), frame.begin() + to_copy, output + output_written);
-                    
-                    // Log occasionally
-                    frames_processed_++;
-                    if (frames_processed_ % 1000 == 0) {
-                        std::cout << "✅ Processed " << frames_processed_ << " frames through WebRTC AEC3\n";
-                    }
+                    ProcessFallbackFrame();
                 }
-                
-                output_written += frame_size_;
-                
-                // Remove processed frame from buffer
-                capture_buffer_.erase(capture_buffer_.begin(), capture_buffer_.begin() + frame_size_);
-                
-            } catch (const std::exception& e) {
-                std::cerr << "❌ ProcessCaptureAudio error: " << e.what() << "\n";
-                // Fall back to naive for this buffer
-                ProcessNaive(input, output, num_samples);
-                capture_buffer_.clear();
-                break;
+                capture_fill_ = 0;
             }
         }
-        
-        // If we couldn't process all samples (buffer not full yet), copy remaining input
-        if (output_written < num_samples) {
-            size_t remaining = num_samples - output_written;
-            std::copy(input + output_written, input + num_samples, output + output_written);
-        }
-        
-        CalculateMetrics(output, num_samples);
+    }
+
+    // Zero until initialized, when capture passes straight through
+    size_t OutputLatencySamples() const {
+        return capture_frame_.empty() ? 0 : frame_size_;
     }
 
     void SetEchoCancellationEnabled(bool enabled) {
-        config_.enable_aec = enabled;
+        AECConfig config = GetConfig();
+        config.enable_aec = enabled;
+        PostConfig(config);
+        Log(enabled ? LogLevel::kInfo : LogLevel::kWarn, kLogSource, enabled ? "AEC enabled" : "AEC disabled");
+    }
+
+    uint64_t ResetEchoPath(const AECWarmStart& seed, EchoPathChange reason) {
+        AECConfig config = GetConfig();
+        config.warm_start = seed;
+        // Taken with whichever posted change the capture thread applies next
+        reset_requested_.store(static_cast<int>(reason), std::memory_order_release);
+        Log(LogLevel::kInfo, kLogSource, "Echo path reset (%s), seeded at %dms", EchoPathChangeName(reason),
+            seed.echo_delay_ms.value_or(-1));
+        return PostConfig(config);
+    }
+
+    // The canceller is frozen, not disabled: ApplyConfig with AEC off would
+    // destroy AEC3's adapted filter. Feeding it render alone would not keep
+    // it warm either, since AEC3 only drains its render queue on capture calls.
+    void SetBypass(bool bypass) {
+        if (bypass_.exchange(bypass, std::memory_order_relaxed) != bypass) {
+            Log(LogLevel::kInfo, kLogSource, bypass ? "AEC bypassed (canceller on standby)" : "AEC bypass off");
+        }
+    }
+
+    bool IsBypassed() const {
+        return bypass_.load(std::memory_order_relaxed);
+    }
+
+    bool Configure(const AECConfig& requested) {
+        std::lock_guard<std::mutex> lock(apm_mutex_);
+        return ConfigureLocked(requested, 0, 0);
+    }
+
+    uint64_t PostConfig(const AECConfig& config) {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        const uint64_t sequence = ++posted_sequence_;
+        posted_config_ = config;
+        const uint64_t now = NowNs();
+        PostedConfig& slot = mailbox_[mailbox_back_];
+        slot.config = config;
+        slot.sequence = sequence;
+        slot.posted_ns = now;
+        mailbox_back_ = mailbox_state_.exchange(mailbox_back_ | kMailboxFresh, std::memory_order_acq_rel) &
+                        kMailboxIndex;
+
+        // No frame boundary coming to take it: apply it here. Capture picks
+        // the same change up on resuming and finds it done.
+        const uint64_t last_capture = last_capture_ns_.load(std::memory_order_relaxed);
+        if (last_capture == 0 || now - last_capture > kMailboxIdleNs) {
+            std::lock_guard<std::mutex> apm_lock(apm_mutex_);
+            ConfigureLocked(config, sequence, now, TakeEchoPathReset());
+        }
+        return sequence;
+    }
+
+    AECConfigStatus GetConfigStatus() const {
+        AECConfigStatus status;
+        {
+            std::lock_guard<std::mutex> lock(post_mutex_);
+            status.posted = posted_sequence_;
+        }
+        status.applied = applied_sequence_.load(std::memory_order_acquire);
+        status.rejected = rejected_sequence_.load(std::memory_order_relaxed);
+        status.applied_frame = applied_frame_.load(std::memory_order_relaxed);
+        status.latency_ms = applied_latency_ms_.load(std::memory_order_relaxed);
+        return status;
+    }
+
+    // The newest posted change while it waits
+    AECConfig GetConfig() const {
+        {
+            std::lock_guard<std::mutex> lock(post_mutex_);
+            if (posted_sequence_ > std::max(applied_sequence_.load(std::memory_order_acquire),
+                                            rejected_sequence_.load(std::memory_order_relaxed))) {
+                return posted_config_;
+            }
+        }
+        std::lock_guard<std::mutex> lock(apm_mutex_);
+        return config_;
+    }
+
+    // The APM records its config, render and capture frames; serialization
+    // and file writes happen on dump_queue_, never on the processing thread
+    bool StartAecDump(const std::string& path, int64_t max_bytes) {
+        std::lock_guard<std::mutex> lock(apm_mutex_);
+        if (!audio_processing_) {
+            Log(LogLevel::kWarn, kLogSource, "AEC dump needs the WebRTC APM; the fallback canceller has none");
+            return false;
+        }
+        if (!dump_queue_) {
+            dump_queue_ = CreateDspTaskQueue("AecDump");
+            if (!dump_queue_) {
+                return false;
+            }
+        }
         
+        audio_processing_->DetachAecDump();
+        dumping_ = audio_processing_->CreateAndAttachAecDump(path, max_bytes, dump_queue_.get());
+        if (!dumping_) {
+            // Also the answer when the WebRTC build has AEC dump compiled out
+            Log(LogLevel::kError, kLogSource, "Could not start AEC dump at %s", path.c_str());
+            return false;
+        }
+        Log(LogLevel::kInfo, kLogSource, "AEC dump started: %s (limit %lld bytes)", path.c_str(),
+            static_cast<long long>(max_bytes));
+        return true;
+    }
+
+    // Flushes pending writes and closes the file
+    void StopAecDump() {
+        std::lock_guard<std::mutex> lock(apm_mutex_);
+        if (!dumping_) {
+            return;
+        }
         if (audio_processing_) {
-            try {
-                auto apm_config = audio_processing_->GetConfig();
-                apm_config.echo_canceller.enabled = enabled;
-                audio_processing_->ApplyConfig(apm_config);
-                std::cout << (enabled ? "✅ AEC enabled" : "⚠️ AEC disabled") << "\n";
-            } catch (const std::exception& e) {
-                std::cerr << "❌ Error setting AEC enabled: " << e.what() << "\n";
-            }
+            audio_processing_->DetachAecDump();
         }
+        dumping_ = false;
+        Log(LogLevel::kInfo, kLogSource, "AEC dump stopped");
     }
 
-    AECMetrics GetMetrics() const {
+    bool IsAecDumping() const {
+        std::lock_guard<std::mutex> lock(apm_mutex_);
+        return dumping_;
+    }
+
+    void SetStreamDelayMs(int delay_ms) {
+        stream_delay_ms_.store(std::max(0, delay_ms), std::memory_order_relaxed);
+    }
+
+    void SetRenderDriftPpm(float ppm) {
+        render_drift_ppm_.store(ppm, std::memory_order_relaxed);
+    }
+
+    AECMetrics GetLevels() const {
         AECMetrics metrics;
         metrics.rms_level = current_rms_;
         metrics.peak_level = current_peak_;
+        metrics.noise_floor = current_noise_floor_;
+        metrics.speech = current_speech_;
+        metrics.stream_delay_ms = stream_delay_ms_.load(std::memory_order_relaxed);
+        float drift_ppm = render_drift_ppm_.load(std::memory_order_relaxed);
+        if (!std::isnan(drift_ppm)) {
+            metrics.render_drift_ppm = drift_ppm;
+        }
+        metrics.processing_sample_rate = processing_rate_.load(std::memory_order_relaxed);
+        metrics.bypassed = bypass_.load(std::memory_order_relaxed);
+        metrics.cpu_governor = governor_.load(std::memory_order_relaxed);
+        metrics.governor_level = governor_level_.load(std::memory_order_relaxed);
+        metrics.governor_transitions = governor_transitions_.load(std::memory_order_relaxed);
+        metrics.normalize_speech = normalize_.load(std::memory_order_relaxed);
+        if (metrics.normalize_speech) {
+            metrics.normalizer_gain_db = current_gain_db_;
+            if (!std::isnan(current_speech_level_dbfs_)) {
+                metrics.speech_level_dbfs = current_speech_level_dbfs_;
+            }
+        }
+        metrics.clipping_predictions = clipping_predictions_.load(std::memory_order_relaxed);
+        metrics.echo_path_resets = echo_path_resets_.load(std::memory_order_relaxed);
+        metrics.echo_path_change = static_cast<EchoPathChange>(echo_path_change_.load(std::memory_order_relaxed));
+        metrics.echo_path_reconverging = echo_path_reconverging_.load(std::memory_order_relaxed);
+        float reconverge_ms = echo_path_reconverge_ms_.load(std::memory_order_relaxed);
+        if (!std::isnan(reconverge_ms)) {
+            metrics.echo_path_reconverge_ms = reconverge_ms;
+        }
+        float leakage_db = echo_path_leakage_db_.load(std::memory_order_relaxed);
+        if (!std::isnan(leakage_db)) {
+            metrics.echo_path_leakage_db = leakage_db;
+        }
+        if (adaptive_.load(std::memory_order_relaxed) && residual_) {
+            metrics.adaptive_suppression = true;
+            metrics.suppression_level = escalated_.load(std::memory_order_relaxed) ? 1 : 0;
+            metrics.residual_echo_likelihood = residual_->Likelihood();
+            metrics.residual_echo_likelihood_recent_max = residual_->RecentMax();
+        }
+        metrics.output_latency_samples = static_cast<int>(OutputLatencySamples());
+        if (sample_rate_ > 0) {
+            metrics.output_latency_ms = 1000.0f * metrics.output_latency_samples / sample_rate_;
+        }
         
-        if (audio_processing_ && config_.enable_aec) {
-            // WebRTC is active - assume good performance
-            metrics.echo_return_loss = 20.0f;
-            metrics.echo_return_loss_enhancement = 15.0f;
-            metrics.aec_converged = true;
-        } else {
-            // Using fallback
-            metrics.echo_return_loss = 5.0f;
-            metrics.echo_return_loss_enhancement = 3.0f;
-            metrics.aec_converged = false;
+        // Share of real time spent in the APM: capture frames are the clock
+        uint64_t frames = apm_frames_.load(std::memory_order_relaxed);
+        if (frames > 0 && config_.frame_duration_ms > 0) {
+            double audio_ns = static_cast<double>(frames) * config_.frame_duration_ms * 1e6;
+            metrics.processing_load = static_cast<float>(apm_ns_.load(std::memory_order_relaxed) / audio_ns);
         }
+        return metrics;
+    }
+
+    AECMetrics GetMetrics() const {
+        AECMetrics metrics = GetLevels();
+        metrics.capture_calls = SummarizeCalls(capture_timing_);
+        metrics.render_calls = SummarizeCalls(render_timing_);
+        
+        std::lock_guard<std::mutex> lock(apm_mutex_);
+        if (!audio_processing_ || !config_.enable_aec) {
+            return metrics;  // Naive fallback has no meaningful echo statistics
+        }
+        
+        // Safe to call while another thread is processing
+        webrtc::AudioProcessingStats stats = audio_processing_->GetStatistics();
+        if (stats.echo_return_loss) {
+            metrics.echo_return_loss = static_cast<float>(*stats.echo_return_loss);
+        }
+        if (stats.echo_return_loss_enhancement) {
+            metrics.echo_return_loss_enhancement = static_cast<float>(*stats.echo_return_loss_enhancement);
+        }
+        if (stats.divergent_filter_fraction) {
+            metrics.divergent_filter_fraction = static_cast<float>(*stats.divergent_filter_fraction);
+        }
+        if (stats.residual_echo_likelihood) {
+            metrics.residual_echo_likelihood = static_cast<float>(*stats.residual_echo_likelihood);
+        }
+        if (stats.residual_echo_likelihood_recent_max) {
+            metrics.residual_echo_likelihood_recent_max =
+                static_cast<float>(*stats.residual_echo_likelihood_recent_max);
+        }
+        if (stats.delay_ms) {
+            metrics.render_delay_ms = *stats.delay_ms;
+        }
+        if (stats.delay_median_ms) {
+            metrics.delay_median_ms = *stats.delay_median_ms;
+        }
+        if (stats.delay_standard_deviation_ms) {
+            metrics.delay_std_ms = *stats.delay_standard_deviation_ms;
+        }
+        
+        // Converged: the linear filter is removing echo and is not diverging
+        metrics.aec_converged = metrics.echo_return_loss_enhancement &&
+                                *metrics.echo_return_loss_enhancement >= kConvergedErleDb &&
+                                metrics.divergent_filter_fraction.value_or(0.0f) < kMaxConvergedDivergence;
         
         return metrics;
     }
 
+    AECWarmStart GetWarmStart() const {
+        AECMetrics metrics = GetMetrics();
+        AECWarmStart warm_start;
+        // Before convergence the estimate may still be a chance correlation
+        if (metrics.aec_converged && metrics.delay_median_ms) {
+            warm_start.echo_delay_ms = *metrics.delay_median_ms;
+        }
+        if (metrics.stream_delay_ms > 0) {
+            warm_start.stream_delay_ms = metrics.stream_delay_ms;
+        }
+        if (metrics.adaptive_suppression) {
+            warm_start.preset = metrics.suppression_level ? AECPreset::kAggressive : AECPreset::kDefault;
+        }
+        return warm_start;
+    }
+
+    // The learner is made once, in Initialize, and publishes under its own lock
+    std::optional<NoiseProfile> GetNoiseProfile() const {
+        NoiseProfile profile;
+        if (noise_learner_ && noise_learner_->Learned(&profile)) {
+            return profile;
+        }
+        return std::nullopt;
+    }
+
 private:
-    // Improved naive algorithm (fallback when WebRTC not available)
-    void ProcessNaive(const float* input, float* output, size_t num_samples) {
-        std::copy(input, input + num_samples, output);
+    // What the APM needs at its rate: resamplers and APM-rate frames exist
+    // only when it runs below sample_rate_
+    struct RateStage {
+        int rate = 0;
+        size_t frame_size = 0;
+        webrtc::StreamConfig stream_config;
+        webrtc::StreamConfig render_stream_config;
+        std::vector<std::unique_ptr<webrtc::PushSincResampler>> render_down;  // one per render channel
+        std::unique_ptr<webrtc::PushSincResampler> capture_down;
+        std::unique_ptr<webrtc::PushSincResampler> capture_up;
+        std::vector<float> apm_render;
+        std::vector<float*> render_channel_ptrs;  // into apm_render when resampling, else render_frame_
+        std::vector<float> apm_capture_in;
+        std::vector<float> apm_capture_out;
+    };
+
+    // What a requested config comes to against the current one
+    struct ConfigPlan {
+        AECConfig next;         // as requested, with adaptation's starting preset
+        AECConfig applied;      // what the APM runs: the governor's steps on top
+        int processing_rate = 0;
+        bool reseeded = false;  // a new warm start
+        bool renoised = false;  // a new noise profile
+        bool rebuild = false;   // needs a new APM, which takes milliseconds to build
+    };
+
+    // apm_mutex_ held
+    ConfigPlan PlanConfig(const AECConfig& requested, bool reset) const {
+        ConfigPlan plan;
+        plan.next = requested;
+        plan.next.frame_duration_ms = config_.frame_duration_ms;
+        plan.reseeded = plan.next.warm_start != config_.warm_start;
+        plan.renoised = plan.next.noise_profile != config_.noise_profile && plan.next.noise_profile;
+        if (plan.next.adaptive_suppression &&
+            (!config_.adaptive_suppression || (plan.reseeded && plan.next.warm_start.preset))) {
+            // Adaptation starts from the cheap end, or where the last session left it
+            plan.next.preset = plan.next.warm_start.preset.value_or(AECPreset::kDefault);
+        }
+        const int level = plan.next.cpu_governor ? governor_level_.load(std::memory_order_relaxed) : kGovernorFull;
+        plan.applied = GovernedConfig(plan.next, level);
+
+        // Resamplers for a new APM rate come with the replacement APM. The
+        // stage in use is only swapped under apm_mutex_, so it can be read here.
+        plan.processing_rate = ProcessingRateFor(plan.applied);
+        const bool rate_changed = plan.processing_rate != stage_.rate ||
+                                  (pending_stage_ && plan.processing_rate != pending_stage_->rate);
+        // The naive fallback has only the switches
+        plan.rebuild = audio_processing_ && (plan.applied.preset != applied_.preset || plan.reseeded ||
+                                             (plan.renoised && plan.applied.enable_ns) || rate_changed ||
+                                             pending_apm_ || reset);
+        return plan;
+    }
+
+    // apm_mutex_ held. |sequence| is the posted change this applies (0 for a
+    // direct Configure), marked applied here or, with a rebuild, at the swap.
+    // A |reset| starts its watch at the same point.
+    bool ConfigureLocked(const AECConfig& requested, uint64_t sequence, uint64_t posted_ns,
+                         EchoPathChange reset = EchoPathChange::kNone) {
+        const ConfigPlan plan = PlanConfig(requested, reset != EchoPathChange::kNone);
+        const AECConfig& next = plan.next;
+        const AECConfig& applied = plan.applied;
+        const int processing_rate = plan.processing_rate;
+        if (plan.reseeded && next.warm_start.stream_delay_ms) {
+            stream_delay_ms_.store(std::max(0, *next.warm_start.stream_delay_ms), std::memory_order_relaxed);
+        }
+        if (!next.cpu_governor) {
+            governor_level_.store(kGovernorFull, std::memory_order_relaxed);
+        }
+        if (plan.renoised) {
+            pending_noise_floor_.store(next.noise_profile->noise_floor, std::memory_order_relaxed);
+        }
+
+        if (plan.rebuild) {
+            // AEC3 tuning is fixed per instance: build the replacement off the
+            // processing thread and let it swap in at a frame boundary
+            auto apm = BuildApm(applied, render_channels_);
+            if (!apm) {
+                Log(LogLevel::kError, kLogSource, "Failed to rebuild AudioProcessing for new preset");
+                if (sequence != 0) {
+                    rejected_sequence_.store(sequence, std::memory_order_relaxed);
+                }
+                return false;
+            }
+            // A profile this change brings wins; otherwise what this session
+            // has heard, then the stored one
+            if (applied.enable_ns) {
+                NoiseProfile heard;
+                if (!plan.renoised && noise_learner_ && noise_learner_->Learned(&heard)) {
+                    PrimeNoiseSuppressor(apm.get(), heard, processing_rate);
+                } else if (next.noise_profile) {
+                    PrimeNoiseSuppressor(apm.get(), *next.noise_profile, processing_rate);
+                }
+            }
+            if (processing_rate != stage_.rate) {
+                if (!pending_stage_ || pending_stage_->rate != processing_rate) {
+                    pending_stage_ = std::make_unique<RateStage>();
+                    BuildRateStage(processing_rate, pending_stage_.get());
+                }
+            } else {
+                pending_stage_.reset();
+            }
+            if (processing_rate != render_stage_.rate) {
+                if (!pending_render_stage_ || pending_render_stage_->rate != processing_rate) {
+                    pending_render_stage_ = std::make_unique<RateStage>();
+                    BuildRateStage(processing_rate, pending_render_stage_.get());
+                }
+            } else {
+                pending_render_stage_.reset();
+            }
+            pending_apm_ = apm;
+            pending_render_apm_ = apm;
+            if (reset != EchoPathChange::kNone) {
+                pending_reset_ = reset;
+            }
+            if (sequence != 0) {
+                pending_sequence_ = sequence;
+                pending_posted_ns_ = posted_ns;
+            }
+            has_pending_apm_.store(true, std::memory_order_release);
+            has_pending_render_apm_.store(true, std::memory_order_release);
+        } else if (audio_processing_) {
+            audio_processing_->ApplyConfig(BuildApmConfig(applied));
+        } else if (reset != EchoPathChange::kNone) {
+            fallback_reset_.store(true, std::memory_order_release);
+            BeginEchoPathWatch(reset, false);
+        }
+        
+        config_ = next;
+        applied_ = applied;
+        aec_enabled_.store(next.enable_aec, std::memory_order_relaxed);
+        adaptive_.store(next.adaptive_suppression, std::memory_order_relaxed);
+        escalated_.store(next.adaptive_suppression && next.preset == AECPreset::kAggressive,
+                         std::memory_order_relaxed);
+        governor_.store(next.cpu_governor, std::memory_order_relaxed);
+        normalize_target_dbfs_.store(next.normalize_target_dbfs, std::memory_order_relaxed);
+        if (next.normalize_speech && !normalizer_ && sample_rate_ > 0) {
+            Log(LogLevel::kWarn, kLogSource, "Speech normalization needs 10ms frames at 8/16/32/48kHz (have %dHz)",
+                sample_rate_);
+        }
+        normalize_.store(next.normalize_speech && normalizer_, std::memory_order_relaxed);
+        Log(LogLevel::kInfo, kLogSource, "AEC configured (preset %d, aec=%d, ns=%d/%d, agc=%d)",
+            static_cast<int>(applied.preset), applied.enable_aec, applied.enable_ns,
+            static_cast<int>(applied.ns_level), applied.enable_agc);
+        if (sequence != 0 && !plan.rebuild) {
+            MarkConfigApplied(sequence, posted_ns);
+        }
+        return true;
+    }
+
+    void MarkConfigApplied(uint64_t sequence, uint64_t posted_ns) {
+        applied_frame_.store(apm_frames_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        applied_latency_ms_.store(static_cast<float>((NowNs() - posted_ns) / 1e6), std::memory_order_relaxed);
+        applied_sequence_.store(sequence, std::memory_order_release);
+    }
+
+    EchoPathChange TakeEchoPathReset() {
+        return static_cast<EchoPathChange>(reset_requested_.exchange(0, std::memory_order_acq_rel));
+    }
+
+    // The reset has taken effect: leakage is measured from here until the
+    // new APM converges, which the fallback never reports
+    void BeginEchoPathWatch(EchoPathChange reason, bool apm) {
+        echo_path_resets_.fetch_add(1, std::memory_order_relaxed);
+        echo_path_change_.store(static_cast<int>(reason), std::memory_order_relaxed);
+        echo_path_reconverge_ms_.store(std::nanf(""), std::memory_order_relaxed);
+        echo_path_leakage_db_.store(std::nanf(""), std::memory_order_relaxed);
+        echo_path_reconverging_.store(apm, std::memory_order_relaxed);
+        if (apm) {
+            // At the swap, on the processing thread
+            echo_path_reset_ns_ = NowNs();
+            path_delay_ms_ = -1;
+            path_jump_seconds_ = 0;
+        }
+    }
+
+    // Capture thread, at a frame boundary: the newest posted change, if one
+    // came in. Never waits: with the lock held elsewhere or a rebuild still
+    // in flight the change is kept for the next frame.
+    void ApplyPostedConfig() {
+        if (!mailbox_taken_) {
+            if (!(mailbox_state_.load(std::memory_order_acquire) & kMailboxFresh)) {
+                return;
+            }
+            mailbox_front_ = mailbox_state_.exchange(mailbox_front_, std::memory_order_acq_rel) & kMailboxIndex;
+            mailbox_taken_ = true;
+        }
+        if (adapt_busy_.load(std::memory_order_acquire) || !apm_mutex_.try_lock()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(apm_mutex_, std::adopt_lock);
+        mailbox_taken_ = false;
+        const PostedConfig& posted = mailbox_[mailbox_front_];
+        if (posted.sequence <= std::max(applied_sequence_.load(std::memory_order_relaxed), pending_sequence_)) {
+            return;  // applied by PostConfig while capture was idle
+        }
+        const EchoPathChange reset = TakeEchoPathReset();
+        if (!PlanConfig(posted.config, reset != EchoPathChange::kNone).rebuild) {
+            ConfigureLocked(posted.config, posted.sequence, posted.posted_ns, reset);
+            return;
+        }
+        if (adapt_thread_.joinable()) {
+            adapt_thread_.join();  // finished: adapt_busy_ was clear
+        }
+        adapt_busy_.store(true, std::memory_order_release);
+        adapt_thread_ = std::thread([this, job = posted, reset]() {
+            {
+                std::lock_guard<std::mutex> build_lock(apm_mutex_);
+                ConfigureLocked(job.config, job.sequence, job.posted_ns, reset);
+            }
+            adapt_busy_.store(false, std::memory_order_release);
+        });
+    }
+
+    // Processing thread. The only writer of audio_processing_ after Initialize;
+    // other threads read it under apm_mutex_.
+    void SwapInPendingApm() {
+        if (!has_pending_apm_.load(std::memory_order_acquire)) {
+            return;
+        }
+        webrtc::scoped_refptr<webrtc::AudioProcessing> retired;
+        std::unique_ptr<RateStage> retired_stage;
+        {
+            std::lock_guard<std::mutex> lock(apm_mutex_);
+            retired = audio_processing_;
+            audio_processing_ = pending_apm_;
+            pending_apm_ = nullptr;
+            if (pending_stage_) {
+                retired_stage = std::make_unique<RateStage>(std::move(stage_));
+                stage_ = std::move(*pending_stage_);
+                pending_stage_.reset();
+                processing_rate_.store(stage_.rate, std::memory_order_relaxed);
+                Log(LogLevel::kInfo, kLogSource, "APM now at %dHz", stage_.rate);
+            }
+            has_pending_apm_.store(false, std::memory_order_relaxed);
+            if (pending_sequence_ != 0) {
+                MarkConfigApplied(pending_sequence_, pending_posted_ns_);
+                pending_sequence_ = 0;
+            }
+            if (pending_reset_ != EchoPathChange::kNone) {
+                BeginEchoPathWatch(pending_reset_, true);
+                pending_reset_ = EchoPathChange::kNone;
+            }
+            if (dumping_) {
+                // The dump belongs to the retired APM and closes with it
+                dumping_ = false;
+                Log(LogLevel::kWarn, kLogSource, "AEC dump stopped by the preset change; start a new one to continue");
+            }
+        }
+        Log(LogLevel::kInfo, kLogSource, "AudioProcessing swapped for new preset");
+    }
+
+    // Render thread. Its own copy of the swap, so the two threads never share
+    // a pointer or a resampler; for a frame or so around a switch each side
+    // may run a different APM.
+    void SwapInPendingRenderApm() {
+        if (!has_pending_render_apm_.load(std::memory_order_acquire)) {
+            return;
+        }
+        webrtc::scoped_refptr<webrtc::AudioProcessing> retired;
+        std::unique_ptr<RateStage> retired_stage;
+        {
+            std::lock_guard<std::mutex> lock(apm_mutex_);
+            retired = render_apm_;
+            render_apm_ = pending_render_apm_;
+            pending_render_apm_ = nullptr;
+            if (pending_render_stage_) {
+                retired_stage = std::make_unique<RateStage>(std::move(render_stage_));
+                render_stage_ = std::move(*pending_render_stage_);
+                pending_render_stage_.reset();
+            }
+            has_pending_render_apm_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Before processing starts only
+    void InitializeHandoff() {
+        render_handoff_ = std::make_unique<SpscRingBuffer<float>>(kRenderHandoffFrames * frame_size_);
+        handoff_frame_.assign(frame_size_, 0.0f);
+        pending_render_apm_ = nullptr;
+        pending_render_stage_.reset();
+        has_pending_render_apm_.store(false, std::memory_order_relaxed);
+    }
+
+    // Render thread. The fallback canceller and the residual detector belong
+    // to the capture thread; their render input waits for it here, in order.
+    // Dropped when capture has stalled for the whole ring.
+    void HandOffRenderFrame(const float* frame) {
+        if (render_handoff_->AvailableToWrite() >= frame_size_) {
+            render_handoff_->Write(frame, frame_size_);
+        }
+    }
+
+    // Capture thread, ahead of each frame: render handed off since the last
+    void DrainRenderHandoff(bool analyze) {
+        while (render_handoff_->AvailableToRead() >= frame_size_) {
+            render_handoff_->Read(handoff_frame_.data(), frame_size_);
+            if (!analyze) {
+                continue;
+            }
+            if (nlms_) {
+                TraceScope trace(TraceEvent::kProcessReverseStream, static_cast<int64_t>(frame_size_));
+                uint64_t start = NowNs();
+                nlms_->AnalyzeRender(handoff_frame_.data());
+                RecordCall(&render_timing_, NowNs() - start, false);
+            } else if (audio_processing_ && adaptive_.load(std::memory_order_relaxed)) {
+                residual_->AnalyzeRender(handoff_frame_.data());
+            }
+        }
+    }
+
+    static bool IsNativeApmRate(int rate) {
+        return rate == 8000 || rate == 16000 || rate == 32000 || rate == 48000;
+    }
+
+    // The APM may run below the stream rate; frames are resampled around it
+    int ProcessingRateFor(const AECConfig& config) const {
+        if (IsNativeApmRate(config.processing_sample_rate) && config.processing_sample_rate < sample_rate_) {
+            return config.processing_sample_rate;
+        }
+        return sample_rate_;
+    }
+
+    // Stream configs and, below the stream rate, the resamplers and frames
+    // around an APM at |rate|. render_frame_ must already be sized.
+    void BuildRateStage(int rate, RateStage* stage) {
+        stage->rate = rate;
+        stage->frame_size = (rate * config_.frame_duration_ms) / 1000;
+        stage->stream_config = webrtc::StreamConfig(rate, num_channels_);
+        stage->render_stream_config = webrtc::StreamConfig(rate, render_channels_);
+        stage->render_down.clear();
+        stage->capture_down.reset();
+        stage->capture_up.reset();
+        if (rate != sample_rate_) {
+            for (int ch = 0; ch < render_channels_; ++ch) {
+                stage->render_down.push_back(
+                    std::make_unique<webrtc::PushSincResampler>(frame_size_, stage->frame_size));
+            }
+            stage->capture_down = std::make_unique<webrtc::PushSincResampler>(frame_size_, stage->frame_size);
+            stage->capture_up = std::make_unique<webrtc::PushSincResampler>(stage->frame_size, frame_size_);
+            stage->apm_render.assign(stage->frame_size * render_channels_, 0.0f);
+            stage->apm_capture_in.assign(stage->frame_size, 0.0f);
+            stage->apm_capture_out.assign(stage->frame_size, 0.0f);
+        }
+
+        // Planar channel pointers for ProcessReverseStream
+        float* render_base = stage->render_down.empty() ? render_frame_.data() : stage->apm_render.data();
+        size_t render_stride = stage->render_down.empty() ? frame_size_ : stage->frame_size;
+        stage->render_channel_ptrs.resize(render_channels_);
+        for (int ch = 0; ch < render_channels_; ++ch) {
+            stage->render_channel_ptrs[ch] = render_base + ch * render_stride;
+        }
+    }
+
+    static uint64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Per-frame timing of one entry point; written only by the thread
+    // driving it, read by GetMetrics from any thread
+    struct CallTiming {
+        LatencyHistogram histogram;  // ns
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> deadline_misses{0};
+    };
+
+    void RecordCall(CallTiming* timing, uint64_t elapsed_ns, bool error) {
+        timing->histogram.Record(elapsed_ns);
+        if (error) {
+            timing->errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (elapsed_ns > deadline_ns_) {
+            timing->deadline_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Before processing starts only
+    void ResetCallTiming() {
+        deadline_ns_ = static_cast<uint64_t>(config_.frame_duration_ms) * 1000000;
+        governor_frames_ = 0;
+        governor_slow_frames_ = 0;
+        governor_misses_ = 0;
+        governor_apm_ns_ = 0;
+        for (CallTiming* timing : { &capture_timing_, &render_timing_ }) {
+            timing->histogram.Reset();
+            timing->errors = 0;
+            timing->deadline_misses = 0;
+        }
+    }
+
+    static AECCallStats SummarizeCalls(const CallTiming& timing) {
+        LatencySummary summary = timing.histogram.Summarize();
+        AECCallStats stats;
+        stats.frames = summary.count;
+        stats.errors = timing.errors.load(std::memory_order_relaxed);
+        stats.deadline_misses = timing.deadline_misses.load(std::memory_order_relaxed);
+        stats.p50_us = summary.p50 / 1000.0f;
+        stats.p95_us = summary.p95 / 1000.0f;
+        stats.p99_us = summary.p99 / 1000.0f;
+        stats.max_us = summary.max / 1000.0f;
+        return stats;
+    }
+
+    // One full render_frame_ into the APM, each channel downsampled first when
+    // it runs slower. The APM queues it for its next capture call, whichever
+    // thread makes it.
+    void ProcessRenderFrame() {
+        TraceScope trace(TraceEvent::kProcessReverseStream, static_cast<int64_t>(frame_size_));
+        uint64_t start = NowNs();
+        NoteRenderLevel(render_frame_.data());
+        for (size_t ch = 0; ch < render_stage_.render_down.size(); ++ch) {
+            render_stage_.render_down[ch]->Resample(render_frame_.data() + ch * frame_size_, frame_size_,
+                                                    render_stage_.render_channel_ptrs[ch], render_stage_.frame_size);
+        }
+        float* const* channels = render_stage_.render_channel_ptrs.data();
+        int result = render_apm_->ProcessReverseStream(
+            channels, render_stage_.render_stream_config, render_stage_.render_stream_config, channels);
+        if (result != 0) {
+            Log(LogLevel::kError, kLogSource, "ProcessReverseStream returned error: %d", result);
+        }
+        if (adaptive_.load(std::memory_order_relaxed)) {
+            HandOffRenderFrame(render_frame_.data());  // first channel, stream rate
+        }
+        uint64_t elapsed = NowNs() - start;
+        apm_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+        RecordCall(&render_timing_, elapsed, result != 0);
+    }
+
+    // One full capture_frame_ through the APM into processed_frame_
+    void ProcessCaptureFrame() {
+        DrainRenderHandoff(true);
+        TraceScope trace(TraceEvent::kProcessStream, static_cast<int64_t>(frame_size_));
+        uint64_t start = NowNs();
+        const float* input_ptr = capture_frame_.data();
+        float* output_ptr = processed_frame_.data();
+        if (stage_.capture_down) {
+            stage_.capture_down->Resample(capture_frame_.data(), frame_size_, stage_.apm_capture_in.data(),
+                                          stage_.frame_size);
+            input_ptr = stage_.apm_capture_in.data();
+            output_ptr = stage_.apm_capture_out.data();
+        }
+        
+        audio_processing_->set_stream_delay_ms(stream_delay_ms_.load(std::memory_order_relaxed));
+        int result = audio_processing_->ProcessStream(
+            &input_ptr, stage_.stream_config, stage_.stream_config, &output_ptr);
+        
+        if (result != 0) {
+            Log(LogLevel::kError, kLogSource, "ProcessStream returned error: %d", result);
+            // Pass the unprocessed frame through
+            std::memcpy(processed_frame_.data(), capture_frame_.data(), frame_size_ * sizeof(float));
+        } else {
+            if (stage_.capture_up) {
+                stage_.capture_up->Resample(stage_.apm_capture_out.data(), stage_.frame_size,
+                                            processed_frame_.data(), frame_size_);
+            }
+            
+            // Log occasionally
+            frames_processed_++;
+            if (frames_processed_ % 1000 == 0) {
+                Log(LogLevel::kDebug, kLogSource, "Processed %zu frames through WebRTC AEC3", frames_processed_);
+            }
+            if (adaptive_.load(std::memory_order_relaxed)) {
+                residual_->AnalyzeCapture(processed_frame_.data());
+                UpdateAdaptiveSuppression();
+            }
+            if (aec_enabled_.load(std::memory_order_relaxed)) {
+                UpdateEchoPath();
+            }
+        }
+        uint64_t elapsed = NowNs() - start;
+        apm_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+        apm_frames_.fetch_add(1, std::memory_order_relaxed);
+        RecordCall(&capture_timing_, elapsed, result != 0);
+        if (governor_.load(std::memory_order_relaxed)) {
+            UpdateGovernor(elapsed);
+        }
+        
+        // Levels of the frame about to be drained as output
+        NormalizeFrame(processed_frame_.data());
+        levels_->AnalyzeFrame(processed_frame_.data());
+        PublishLevels();
+    }
+
+    // One full capture_frame_ through the fallback chain into processed_frame_
+    void ProcessFallbackFrame() {
+        if (fallback_reset_.exchange(false, std::memory_order_acquire) && nlms_) {
+            nlms_->Reset();
+        }
+        DrainRenderHandoff(true);
+        TraceScope trace(TraceEvent::kProcessStream, static_cast<int64_t>(frame_size_));
+        uint64_t start = NowNs();
+        float* output = processed_frame_.data();
+        if (!aec_enabled_.load(std::memory_order_relaxed)) {
+            std::memcpy(output, capture_frame_.data(), frame_size_ * sizeof(float));
+        } else {
+            if (nlms_) {
+                // One block of margin so the filter also covers echo arriving early
+                int delay_blocks = stream_delay_ms_.load(std::memory_order_relaxed) / config_.frame_duration_ms - 1;
+                nlms_->SetDelayBlocks(static_cast<size_t>(std::max(0, delay_blocks)));
+                nlms_->ProcessCapture(capture_frame_.data(), output);
+            } else {
+                std::memcpy(output, capture_frame_.data(), frame_size_ * sizeof(float));
+            }
+            
+            ApplyHighPassFilter(output, frame_size_);
+            if (config_.enable_ns) {
+                ApplyNoiseSuppression(output, frame_size_);
+            }
+        }
+        uint64_t elapsed = NowNs() - start;
+        apm_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+        apm_frames_.fetch_add(1, std::memory_order_relaxed);
+        RecordCall(&capture_timing_, elapsed, false);
         
-        if (!config_.enable_aec) return;
+        NormalizeFrame(output);
+        levels_->AnalyzeFrame(output);
+        PublishLevels();
+    }
+    
+    // Processing thread, once a second of capture frames. A switch rebuilds the
+    // APM through Configure on a helper thread; it swaps in at a frame
+    // boundary like any preset change.
+    void UpdateAdaptiveSuppression() {
+        if (++adapt_frames_ < static_cast<size_t>(1000 / config_.frame_duration_ms)) {
+            return;
+        }
+        adapt_frames_ = 0;
+        if (adapt_busy_.load(std::memory_order_acquire) || has_pending_apm_.load(std::memory_order_relaxed)) {
+            return;
+        }
         
-        // Echo cancellation
-        size_t samples = std::min(num_samples, render_history_.size());
-        for (size_t i = 0; i < samples; i++) {
-            output[i] -= render_history_[i] * 0.5f;
+        float likelihood = residual_->Likelihood();
+        bool escalated = escalated_.load(std::memory_order_relaxed);
+        if (!escalated) {
+            adapt_seconds_ = likelihood >= kEscalateLikelihood ? adapt_seconds_ + 1 : 0;
+            if (adapt_seconds_ < kEscalateSeconds) {
+                return;
+            }
+        } else {
+            adapt_seconds_ = likelihood <= kRelaxLikelihood ? adapt_seconds_ + 1 : 0;
+            if (adapt_seconds_ < kRelaxSeconds) {
+                return;
+            }
+        }
+        adapt_seconds_ = 0;
+        
+        AECPreset target = escalated ? AECPreset::kDefault : AECPreset::kAggressive;
+        Log(LogLevel::kInfo, kLogSource, "Residual echo likelihood %.2f: switching to the %s preset", likelihood,
+            escalated ? "default" : "aggressive");
+        if (adapt_thread_.joinable()) {
+            adapt_thread_.join();  // finished: adapt_busy_ was clear
+        }
+        adapt_busy_.store(true, std::memory_order_release);
+        adapt_thread_ = std::thread([this, target]() {
+            AECConfig next = GetConfig();
+            if (next.adaptive_suppression) {
+                next.preset = target;
+                Configure(next);
+            }
+            adapt_busy_.store(false, std::memory_order_release);
+        });
+    }
+
+    // Processing thread, once a second of capture frames. After a reset the
+    // leakage is tracked until the canceller converges; once converged, a
+    // delay estimate that leaves the converged delay for good means the path
+    // moved under it (a route the listeners did not see), and resets it
+    // where the estimate went.
+    void UpdateEchoPath() {
+        if (++path_frames_ < static_cast<size_t>(1000 / config_.frame_duration_ms)) {
+            return;
+        }
+        path_frames_ = 0;
+        const webrtc::AudioProcessingStats stats = audio_processing_->GetStatistics();
+        const bool converged = stats.echo_return_loss_enhancement &&
+                               *stats.echo_return_loss_enhancement >= kConvergedErleDb &&
+                               stats.divergent_filter_fraction.value_or(0.0) < kMaxConvergedDivergence;
+        if (echo_path_reconverging_.load(std::memory_order_relaxed)) {
+            if (stats.echo_return_loss && stats.echo_return_loss_enhancement) {
+                float leakage = static_cast<float>(-(*stats.echo_return_loss + *stats.echo_return_loss_enhancement));
+                float worst = echo_path_leakage_db_.load(std::memory_order_relaxed);
+                if (std::isnan(worst) || leakage > worst) {
+                    echo_path_leakage_db_.store(leakage, std::memory_order_relaxed);
+                }
+            }
+            if (!converged) {
+                return;
+            }
+            float elapsed_ms = static_cast<float>((NowNs() - echo_path_reset_ns_) / 1e6);
+            echo_path_reconverge_ms_.store(elapsed_ms, std::memory_order_relaxed);
+            echo_path_reconverging_.store(false, std::memory_order_relaxed);
+            Log(LogLevel::kInfo, kLogSource, "Echo path reconverged %.0fms after the reset (worst leakage %.1fdB)",
+                elapsed_ms, echo_path_leakage_db_.load(std::memory_order_relaxed));
+        }
+        if (converged && stats.delay_median_ms) {
+            path_delay_ms_ = *stats.delay_median_ms;
+            path_jump_seconds_ = 0;
+            return;
+        }
+        if (path_delay_ms_ < 0 || !stats.delay_ms) {
+            return;
+        }
+        const int delay_ms = *stats.delay_ms;
+        path_jump_seconds_ = std::abs(delay_ms - path_delay_ms_) >= kEchoPathJumpMs ? path_jump_seconds_ + 1 : 0;
+        if (path_jump_seconds_ < kEchoPathJumpSeconds || adapt_busy_.load(std::memory_order_acquire) ||
+            has_pending_apm_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Log(LogLevel::kInfo, kLogSource, "AEC3 delay moved from %dms to %dms and stayed", path_delay_ms_, delay_ms);
+        path_delay_ms_ = -1;
+        path_jump_seconds_ = 0;
+        if (adapt_thread_.joinable()) {
+            adapt_thread_.join();  // finished: adapt_busy_ was clear
+        }
+        adapt_busy_.store(true, std::memory_order_release);
+        adapt_thread_ = std::thread([this, delay_ms]() {
+            AECWarmStart seed = GetConfig().warm_start;
+            seed.echo_delay_ms = delay_ms;
+            ResetEchoPath(seed, EchoPathChange::kDelayJump);
+            adapt_busy_.store(false, std::memory_order_release);
+        });
+    }
+
+    // Processing thread, once per capture frame: a second's worth of frames
+    // is judged against the budget, and a step taken on adapt_thread_ since
+    // Configure may rebuild the APM
+    void UpdateGovernor(uint64_t elapsed_ns) {
+        if (elapsed_ns > deadline_ns_ / 2) {
+            ++governor_slow_frames_;
+        }
+        if (++governor_frames_ < static_cast<size_t>(1000 / config_.frame_duration_ms)) {
+            return;
+        }
+        uint64_t misses = capture_timing_.deadline_misses.load(std::memory_order_relaxed) +
+                          render_timing_.deadline_misses.load(std::memory_order_relaxed);
+        uint64_t apm_ns = apm_ns_.load(std::memory_order_relaxed);
+        uint64_t second_misses = misses - governor_misses_;
+        float load = static_cast<float>((apm_ns - governor_apm_ns_) /
+                                        (governor_frames_ * config_.frame_duration_ms * 1e6));
+        float slow_share = static_cast<float>(governor_slow_frames_) / governor_frames_;
+        governor_misses_ = misses;
+        governor_apm_ns_ = apm_ns;
+        governor_frames_ = 0;
+        governor_slow_frames_ = 0;
+        // A rebuild in flight is not what the next step should be judged by
+        if (adapt_busy_.load(std::memory_order_acquire) || has_pending_apm_.load(std::memory_order_relaxed)) {
+            governor_over_seconds_ = 0;
+            governor_under_seconds_ = 0;
+            return;
         }
         
-        // High-pass filter
-        ApplyHighPassFilter(output, num_samples);
+        bool over = second_misses >= kGovernorMaxMisses || slow_share >= kGovernorSlowShare;
+        governor_over_seconds_ = over ? governor_over_seconds_ + 1 : 0;
+        governor_under_seconds_ = !over && second_misses == 0 && load <= kGovernorHeadroomLoad
+            ? governor_under_seconds_ + 1 : 0;
+        
+        int level = governor_level_.load(std::memory_order_relaxed);
+        int target = level;
+        if (governor_over_seconds_ >= kGovernorDownSeconds && level < kGovernorWideband) {
+            target = GovernorStep(level, +1);
+        } else if (governor_under_seconds_ >= kGovernorUpSeconds && level > kGovernorFull) {
+            target = GovernorStep(level, -1);
+        }
+        if (target == level) {
+            return;
+        }
+        governor_over_seconds_ = 0;
+        governor_under_seconds_ = 0;
         
-        // Noise suppression
+        Log(target > level ? LogLevel::kWarn : LogLevel::kInfo, kLogSource,
+            "CPU governor: %s -> %s (load %.2f, %llu deadline misses, %.0f%% slow frames)",
+            kGovernorLevelNames[level], kGovernorLevelNames[target], load,
+            static_cast<unsigned long long>(second_misses), slow_share * 100.0f);
+        if (adapt_thread_.joinable()) {
+            adapt_thread_.join();  // finished: adapt_busy_ was clear
+        }
+        adapt_busy_.store(true, std::memory_order_release);
+        adapt_thread_ = std::thread([this, target]() {
+            governor_level_.store(target, std::memory_order_relaxed);
+            governor_transitions_.fetch_add(1, std::memory_order_relaxed);
+            Configure(GetConfig());
+            adapt_busy_.store(false, std::memory_order_release);
+        });
+    }
+
+    // The next governor level from |level| in |direction| that changes what
+    // runs (stepping down skips AGC off when AGC is already off); going up it
+    // is the lowest level that runs the same. |level| when there is none.
+    int GovernorStep(int level, int direction) {
+        AECConfig config = GetConfig();
+        auto runs = [&](int at) {
+            AECConfig governed = GovernedConfig(config, at);
+            return std::make_tuple(governed.enable_agc, governed.ns_level, governed.preset,
+                                   ProcessingRateFor(governed));
+        };
+        auto current = runs(level);
+        for (int next = level + direction; next >= kGovernorFull && next < kGovernorLevels; next += direction) {
+            if (runs(next) != current) {
+                while (direction < 0 && next > kGovernorFull && runs(next - 1) == runs(next)) {
+                    --next;
+                }
+                return next;
+            }
+        }
+        return level;
+    }
+
+    // Bypass: the fallback's HPF (and NS when enabled), no canceller and no
+    // APM. Counted in the processing load but not in the APM call timings.
+    void ProcessBypassFrame() {
+        DrainRenderHandoff(false);  // from before the bypass; stale by its end
+        TraceScope trace(TraceEvent::kProcessStream, static_cast<int64_t>(frame_size_));
+        uint64_t start = NowNs();
+        float* output = processed_frame_.data();
+        std::memcpy(output, capture_frame_.data(), frame_size_ * sizeof(float));
+        ApplyHighPassFilter(output, frame_size_);
         if (config_.enable_ns) {
-            ApplyNoiseSuppression(output, num_samples);
+            ApplyNoiseSuppression(output, frame_size_);
         }
+        apm_ns_.fetch_add(NowNs() - start, std::memory_order_relaxed);
+        apm_frames_.fetch_add(1, std::memory_order_relaxed);
+
+        NormalizeFrame(output);
+        levels_->AnalyzeFrame(output);
+        PublishLevels();
     }
-    
+
+    // One-pole 80Hz high-pass, y[n] = a * (y[n-1] + x[n] - x[n-1]), with both
+    // histories carried across frames. Recursive, so it stays a scalar loop.
     void ApplyHighPassFilter(float* data, size_t num_samples) {
-        const float cutoff = 80.0f / sample_rate_;
-        const float alpha = 1.0f / (1.0f + cutoff);
+        const float rc_ratio = 2.0f * static_cast<float>(M_PI) * 80.0f / sample_rate_;
+        const float alpha = 1.0f / (1.0f + rc_ratio);
         
-        for (size_t i = 1; i < num_samples; i++) {
-            data[i] = alpha * (hp_prev_ + data[i] - data[i-1]);
-            hp_prev_ = data[i];
+        for (size_t i = 0; i < num_samples; i++) {
+            float input = data[i];
+            hp_prev_ = alpha * (hp_prev_ + input - hp_prev_input_);
+            hp_prev_input_ = input;
+            data[i] = hp_prev_;
         }
     }
     
     void ApplyNoiseSuppression(float* data, size_t num_samples) {
-        const float threshold = 0.01f;
-        for (size_t i = 0; i < num_samples; i++) {
-            if (std::abs(data[i]) < threshold) {
-                data[i] *= 0.1f;
-            }
-        }
+        frame_kernels_.attenuate_below(data, num_samples, 0.01f, 0.1f);
     }
     
-    void CalculateMetrics(const float* data, size_t num_samples) {
+    // Processing thread. Switching it on starts from unity gain and no
+    // estimate, so a stale level from an earlier stretch never applies.
+    void NormalizeFrame(float* frame) {
+        if (!normalize_.load(std::memory_order_relaxed)) {
+            normalizing_ = false;
+            return;
+        }
+        if (!normalizing_) {
+            normalizer_->Reset();
+            normalizing_ = true;
+        }
+        normalizer_->SetTargetDbfs(normalize_target_dbfs_.load(std::memory_order_relaxed));
+        normalizer_->ProcessFrame(frame);
+        current_gain_db_ = normalizer_->GainDb();
+        current_speech_level_dbfs_ = normalizer_->IsConfident() ? normalizer_->SpeechLevelDbfs() : std::nanf("");
+        clipping_predictions_.store(normalizer_->ClippingPredictions(), std::memory_order_relaxed);
+    }
+
+    void PublishLevels() {
+        const LevelFrame& frame = levels_->Last();
+        current_rms_ = frame.rms;
+        current_peak_ = frame.peak;
+        current_noise_floor_ = frame.noise_floor;
+        current_speech_ = frame.speech;
+        LearnNoise(frame);
+    }
+
+    // Render thread, first channel at the stream rate
+    void NoteRenderLevel(const float* frame) {
         float sum = 0.0f;
         float peak = 0.0f;
-        for (size_t i = 0; i < num_samples; i++) {
-            float val = std::abs(data[i]);
-            sum += val * val;
-            peak = std::max(peak, val);
+        frame_kernels_.sum_squares_and_peak(frame, frame_size_, &sum, &peak);
+        if (peak > kRenderActivePeak) {
+            render_active_ns_.store(NowNs(), std::memory_order_relaxed);
+        }
+    }
+
+    // Processing thread. The input frame is noise alone when its output
+    // was no speech and nothing has played for an echo tail.
+    void LearnNoise(const LevelFrame& frame) {
+        if (!noise_learner_) {
+            return;
         }
-        current_rms_ = std::sqrt(sum / num_samples);
-        current_peak_ = peak;
+        const uint64_t now = last_capture_ns_.load(std::memory_order_relaxed);
+        const bool echo = render_active_ns_.load(std::memory_order_relaxed) + kEchoTailNs > now;
+        noise_learner_->AnalyzeFrame(capture_frame_.data(), !frame.speech && !echo, frame.noise_floor);
     }
 
-    AECConfig config_;
+    AECConfig config_;                    // guarded by apm_mutex_ after Initialize
     webrtc::scoped_refptr<webrtc::AudioProcessing> audio_processing_;
+    webrtc::scoped_refptr<webrtc::AudioProcessing> pending_apm_;
+    std::atomic<bool> has_pending_apm_{false};
+    std::atomic<bool> aec_enabled_;
+    std::atomic<bool> bypass_{false};
+    mutable std::mutex apm_mutex_;
     
-    // Frame buffering
-    std::vector<float> render_buffer_;   // Accumulates render audio into frames
-    std::vector<float> capture_buffer_;  // Accumulates capture audio into frames
-    std::vector<float> render_history_;  // For fallback algorithm
+    // Adaptive suppression: residual_ runs while adaptive_ is set; the
+    // counters belong to the processing thread
+    std::atomic<bool> adaptive_;
+    std::atomic<bool> escalated_{false};  // on the aggressive preset
+    std::unique_ptr<ResidualEchoDetector> residual_;
+    size_t adapt_frames_ = 0;
+    int adapt_seconds_ = 0;               // consecutive seconds past the next threshold
+    std::thread adapt_thread_;            // also takes the governor's steps
+    std::atomic<bool> adapt_busy_{false};
+    
+    // CPU governor: the level is set on adapt_thread_ ahead of the Configure
+    // that applies it; the window counters belong to the processing thread
+    AECConfig applied_;                   // config_ as governed; apm_mutex_
+    std::atomic<bool> governor_{false};
+    std::atomic<int> governor_level_{kGovernorFull};
+    std::atomic<uint64_t> governor_transitions_{0};
+    size_t governor_frames_ = 0;
+    size_t governor_slow_frames_ = 0;
+    uint64_t governor_misses_ = 0;
+    uint64_t governor_apm_ns_ = 0;
+    int governor_over_seconds_ = 0;
+    int governor_under_seconds_ = 0;
+    
+    // Speech normalization after the APM; the normalizer belongs to the
+    // processing thread, created in Initialize when the rate allows it
+    std::unique_ptr<SpeechNormalizer> normalizer_;
+    std::atomic<bool> normalize_{false};
+    std::atomic<float> normalize_target_dbfs_{-20.0f};
+    bool normalizing_ = false;
+    float current_gain_db_ = 0.0f;
+    float current_speech_level_dbfs_ = std::nanf("");
+    std::atomic<uint64_t> clipping_predictions_{0};
+    
+    // Frame buffering (fixed size, allocated in Initialize)
+    std::vector<float> render_frame_;     // Planar render frames (one per channel) accumulating
+    std::vector<float> capture_frame_;    // Capture samples accumulating toward one frame
+    std::vector<float> processed_frame_;  // Last processed capture frame, drained as output
+    size_t render_fill_ = 0;
+    size_t capture_fill_ = 0;
+    
+    RateStage stage_;                         // processing thread; swapped under apm_mutex_
+    std::unique_ptr<RateStage> pending_stage_;  // apm_mutex_; swapped in with pending_apm_
+
+    // The render side's own APM reference and stage, so render may run on
+    // another thread than capture; swapped by the render thread the same way
+    webrtc::scoped_refptr<webrtc::AudioProcessing> render_apm_;
+    webrtc::scoped_refptr<webrtc::AudioProcessing> pending_render_apm_;  // apm_mutex_
+    std::atomic<bool> has_pending_render_apm_{false};
+    RateStage render_stage_;
+    std::unique_ptr<RateStage> pending_render_stage_;  // apm_mutex_
+    std::unique_ptr<SpscRingBuffer<float>> render_handoff_;  // whole frames, render -> capture
+    std::vector<float> handoff_frame_;                       // capture thread
+    
+    // Wall time spent in the APM (render + capture, resampling included), or
+    // in the fallback chain
+    std::atomic<uint64_t> apm_ns_{0};
+    std::atomic<uint64_t> apm_frames_{0};
+    CallTiming capture_timing_;
+    CallTiming render_timing_;
+    uint64_t deadline_ns_ = 0;  // one frame of audio
+    
+    // Config mailbox: a triple buffer, so a poster and the capture thread
+    // never touch the same slot. post_mutex_ orders posters only.
+    struct PostedConfig {
+        AECConfig config;
+        uint64_t sequence = 0;
+        uint64_t posted_ns = 0;
+    };
+    PostedConfig mailbox_[3];
+    std::atomic<uint8_t> mailbox_state_{1};
+    uint8_t mailbox_back_ = 0;       // post_mutex_
+    uint8_t mailbox_front_ = 2;      // capture thread
+    bool mailbox_taken_ = false;     // capture thread: the front slot still to apply
+    mutable std::mutex post_mutex_;
+    uint64_t posted_sequence_ = 0;   // post_mutex_
+    AECConfig posted_config_;        // post_mutex_
+    uint64_t pending_sequence_ = 0;  // apm_mutex_: the posted change pending_apm_ applies
+    uint64_t pending_posted_ns_ = 0;
+    std::atomic<uint64_t> applied_sequence_{0};
+    std::atomic<uint64_t> rejected_sequence_{0};
+    std::atomic<uint64_t> applied_frame_{0};
+    std::atomic<float> applied_latency_ms_{0.0f};
+    std::atomic<uint64_t> last_capture_ns_{0};  // 0 before the first capture frame
+
+    // Echo path resets: requested by any thread and taken with the next
+    // applied change; the watch's counters belong to the processing thread
+    std::atomic<int> reset_requested_{0};
+    EchoPathChange pending_reset_ = EchoPathChange::kNone;  // apm_mutex_: started at pending_apm_'s swap
+    std::atomic<bool> fallback_reset_{false};
+    std::atomic<uint64_t> echo_path_resets_{0};
+    std::atomic<int> echo_path_change_{0};
+    std::atomic<bool> echo_path_reconverging_{false};
+    std::atomic<float> echo_path_reconverge_ms_{std::nanf("")};
+    std::atomic<float> echo_path_leakage_db_{std::nanf("")};
+    uint64_t echo_path_reset_ns_ = 0;
+    size_t path_frames_ = 0;
+    int path_delay_ms_ = -1;  // where the canceller last converged; -1 unknown
+    int path_jump_seconds_ = 0;
+
+    // AEC dump (guarded by apm_mutex_); the queue lives as long as the processor
+    std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> dump_queue_;
+    bool dumping_ = false;
+    std::unique_ptr<NlmsEchoCanceller> nlms_;  // fallback canceller, APM unavailable only
     
     int sample_rate_ = 0;
     int num_channels_ = 0;
+    int render_channels_ = 1;
     size_t frame_size_ = 0;
+    dsp::FrameKernels frame_kernels_;  // picked for frame_size_ in Initialize
+    std::atomic<int> processing_rate_{0};
     size_t frames_processed_ = 0;
     
+    std::atomic<int> stream_delay_ms_{0};
+    std::atomic<float> render_drift_ppm_{std::nanf("")};  // NaN until measured
+    
+    // Output levels, one 10ms frame at a time
+    std::unique_ptr<LevelAnalyzer> levels_;
     float current_rms_ = 0.0f;
     float current_peak_ = 0.0f;
-    float hp_prev_ = 0.0f;
+    float current_noise_floor_ = 0.0f;
+    bool current_speech_ = false;
+    std::atomic<float> pending_noise_floor_{std::nanf("")};  // a new profile's, for levels_
+    // The input's noise between speech and echo (processing thread; Learned()
+    // from any), and when render last played
+    std::unique_ptr<NoiseProfileLearner> noise_learner_;
+    std::atomic<uint64_t> render_active_ns_{0};
+    float hp_prev_ = 0.0f;        // high-pass output history
+    float hp_prev_input_ = 0.0f;  // and input history
 };
 
+AECConfig ApplyPresetDefaults(const AECConfig& base, AECPreset preset) {
+    AECConfig config = base;
+    config.preset = preset;
+    switch (preset) {
+        case AECPreset::kAggressive:
+        case AECPreset::kDefault:
+            config.enable_aec = true;
+            config.enable_ns = true;
+            break;
+        case AECPreset::kLowCpu:
+            config.enable_aec = true;
+            config.enable_ns = false;
+            config.enable_agc = false;
+            break;
+        case AECPreset::kHeadphones:
+            config.enable_aec = false;
+            config.enable_ns = true;
+            break;
+    }
+    return config;
+}
+
+AECConfig ApplyLowPowerProfile(const AECConfig& base) {
+    AECConfig config = base;
+    if (config.preset != AECPreset::kHeadphones) {
+        config.preset = AECPreset::kLowCpu;
+    }
+    config.adaptive_suppression = false;
+    config.ns_level = 0;
+    if (config.processing_sample_rate == 0 || config.processing_sample_rate > kLowPowerProcessingRate) {
+        config.processing_sample_rate = kLowPowerProcessingRate;
+    }
+    return config;
+}
+
+AECConfig EnhanceConfig() {
+    AECConfig config = ApplyPresetDefaults(AECConfig(), AECPreset::kHeadphones);
+    config.enable_agc = true;
+    return config;
+}
+
+const char* EchoPathChangeName(EchoPathChange change) {
+    switch (change) {
+        case EchoPathChange::kNone: return "none";
+        case EchoPathChange::kOutputDevice: return "outputDevice";
+        case EchoPathChange::kInputDevice: return "inputDevice";
+        case EchoPathChange::kDelayJump: return "delayJump";
+        case EchoPathChange::kRequested: return "requested";
+    }
+    return "none";
+}
+
+void AECProfileTable::Set(std::vector<Entry> entries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_ = std::move(entries);
+}
+
+void AECProfileTable::Remember(const std::string& input_uid, const std::string& output_uid,
+                               const AECWarmStart& learned) {
+    if (input_uid.empty() || output_uid.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& entry) {
+        return entry.input_uid == input_uid && entry.output_uid == output_uid;
+    });
+    if (it == entries_.end()) {
+        it = entries_.insert(entries_.end(), Entry{input_uid, output_uid, AECWarmStart()});
+    }
+    if (learned.echo_delay_ms) {
+        it->warm_start.echo_delay_ms = learned.echo_delay_ms;
+    }
+    if (learned.stream_delay_ms) {
+        it->warm_start.stream_delay_ms = learned.stream_delay_ms;
+    }
+    if (learned.preset) {
+        it->warm_start.preset = learned.preset;
+    }
+}
+
+std::optional<AECWarmStart> AECProfileTable::Find(const std::string& input_uid,
+                                                  const std::string& output_uid) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Entry& entry : entries_) {
+        if (entry.input_uid == input_uid && entry.output_uid == output_uid) {
+            return entry.warm_start;
+        }
+    }
+    return std::nullopt;
+}
+
 AECProcessor::AECProcessor(const AECConfig& config) 
     : impl_(std::make_unique<Impl>(config)) {}
 
 AECProcessor::~AECProcessor() = default;
 
-bool AECProcessor::Initialize(int sample_rate, int num_channels) {
-    return impl_->Initialize(sample_rate, num_channels);
+bool AECProcessor::Initialize(int sample_rate, int capture_channels, int render_channels) {
+    return impl_->Initialize(sample_rate, capture_channels, render_channels);
 }
 
-void AECProcessor::ProcessRenderAudio(const float* data, size_t num_samples) {
-    impl_->ProcessRenderAudio(data, num_samples);
+void AECProcessor::ProcessRenderAudio(const float* data, size_t num_frames, int num_channels) {
+    impl_->ProcessRenderAudio(data, num_frames, num_channels);
 }
 
 void AECProcessor::ProcessCaptureAudio(const float* input, float* output, size_t num_samples) {
     impl_->ProcessCaptureAudio(input, output, num_samples);
 }
 
+size_t AECProcessor::OutputLatencySamples() const {
+    return impl_->OutputLatencySamples();
+}
+
 void AECProcessor::SetEchoCancellationEnabled(bool enabled) {
     impl_->SetEchoCancellationEnabled(enabled);
 }
 
+void AECProcessor::SetBypass(bool bypass) {
+    impl_->SetBypass(bypass);
+}
+
+bool AECProcessor::IsBypassed() const {
+    return impl_->IsBypassed();
+}
+
+bool AECProcessor::Configure(const AECConfig& config) {
+    return impl_->Configure(config);
+}
+
+uint64_t AECProcessor::PostConfig(const AECConfig& config) {
+    return impl_->PostConfig(config);
+}
+
+uint64_t AECProcessor::ResetEchoPath(const AECWarmStart& seed, EchoPathChange reason) {
+    return impl_->ResetEchoPath(seed, reason);
+}
+
+AECConfigStatus AECProcessor::GetConfigStatus() const {
+    return impl_->GetConfigStatus();
+}
+
+AECConfig AECProcessor::GetConfig() const {
+    return impl_->GetConfig();
+}
+
+void AECProcessor::SetStreamDelayMs(int delay_ms) {
+    impl_->SetStreamDelayMs(delay_ms);
+}
+
+void AECProcessor::SetRenderDriftPpm(float ppm) {
+    impl_->SetRenderDriftPpm(ppm);
+}
+
 AECMetrics AECProcessor::GetMetrics() const {
     return impl_->GetMetrics();
 }
 
+AECWarmStart AECProcessor::GetWarmStart() const {
+    return impl_->GetWarmStart();
+}
+
+std::optional<NoiseProfile> AECProcessor::GetNoiseProfile() const {
+    return impl_->GetNoiseProfile();
+}
+
+AECMetrics AECProcessor::GetLevels() const {
+    return impl_->GetLevels();
+}
+
+bool AECProcessor::StartAecDump(const std::string& path, int64_t max_bytes) {
+    return impl_->StartAecDump(path, max_bytes);
+}
+
+void AECProcessor::StopAecDump() {
+    impl_->StopAecDump();
+}
+
+bool AECProcessor::IsAecDumping() const {
+    return impl_->IsAecDumping();
+}
+
 } // namespace kakarot
\ No newline at end of file
@@ -1,26 +1,184 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 #include <string>
+#include "noise_profile.h"
 
 namespace kakarot {
 
+// AEC3 tunings. Switching presets rebuilds the AudioProcessing instance
+// (the canceller re-converges); submodule changes apply in place.
+enum class AECPreset {
+    kAggressive,   // long filters, heavy suppression: open speakers in meetings
+    kDefault,      // stock WebRTC AEC3
+    kLowCpu,       // short filters, NS off: laptops on battery
+    kHeadphones,   // no acoustic echo path: AEC off, NS only
+};
+
+// What one session learned about its output/input pair, to seed the next
+// session on the same hardware. Unset fields keep the cold-start behaviour.
+struct AECWarmStart {
+    std::optional<int> echo_delay_ms;    // AEC3's converged delay: where its delay search starts
+    std::optional<int> stream_delay_ms;  // reported stream delay until the first measurement
+    std::optional<AECPreset> preset;     // adaptive suppression starts here rather than kDefault
+
+    bool operator==(const AECWarmStart& other) const {
+        return echo_delay_ms == other.echo_delay_ms && stream_delay_ms == other.stream_delay_ms &&
+               preset == other.preset;
+    }
+    bool operator!=(const AECWarmStart& other) const { return !(*this == other); }
+};
+
+// What moved the echo path, for ResetEchoPath()
+enum class EchoPathChange {
+    kNone,
+    kOutputDevice,  // the default output, or its data source, changed
+    kInputDevice,   // capture moved to another mic
+    kDelayJump,     // a converged canceller's delay estimate moved away and stayed
+    kRequested,     // the app asked
+};
+const char* EchoPathChangeName(EchoPathChange change);
+
+// The app's stored warm starts, keyed by input/output device UID, so a
+// device switch mid-session can seed the canceller for the pair it moves
+// to. Any thread.
+class AECProfileTable {
+public:
+    struct Entry {
+        std::string input_uid;
+        std::string output_uid;
+        AECWarmStart warm_start;
+    };
+
+    void Set(std::vector<Entry> entries);
+    // Merges what the session learned on a pair it is leaving, so moving
+    // back starts from there; unset fields keep the stored values
+    void Remember(const std::string& input_uid, const std::string& output_uid, const AECWarmStart& learned);
+    std::optional<AECWarmStart> Find(const std::string& input_uid, const std::string& output_uid) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
+
 struct AECConfig {
+    AECPreset preset = AECPreset::kAggressive;
     bool enable_aec = true;
     bool enable_agc = false;
     bool enable_ns = true;
+    int ns_level = 1;   // 0 low, 1 moderate, 2 high, 3 very high
     bool disable_aec_on_headphones = true;
     int frame_duration_ms = 10;
+    // Rate the APM runs at (8000/16000/32000/48000); 0 or >= the stream rate
+    // runs it at the stream rate. Lower rates skip band splitting and cost far
+    // less CPU when nothing consumes audio above rate/2. A change rebuilds
+    // the APM like a preset change.
+    int processing_sample_rate = 0;
+    // Start on kDefault and move to kAggressive only while the measured
+    // residual echo stays high (and back once it has stayed low); the preset
+    // then follows the adaptation
+    bool adaptive_suppression = false;
+    // Seeds every APM built from this config; a change rebuilds it like a
+    // preset change
+    AECWarmStart warm_start;
+    // The mic's stored noise: every APM built from this config has its
+    // noise suppressor primed on noise of this spectrum (while none has
+    // been learned in the session), and the output's noise floor starts at
+    // its level. A change rebuilds the APM like a warm start.
+    std::optional<NoiseProfile> noise_profile;
+    // Watch processing time against the frame deadline: under load, step
+    // down through cheaper settings (AGC off, NS low, kLowCpu filters, 16kHz)
+    // and back up once there is headroom. GetConfig() still reports the
+    // configuration asked for; the metrics report the step in effect.
+    bool cpu_governor = false;
+    // Bring speech to normalize_target_dbfs after the APM: AGC2's speech
+    // level estimator, a slewed gain, its clipping predictor and limiter. An
+    // alternative to enable_agc for transcription, where a steady speech
+    // level matters more than AGC2's headroom; applies in place.
+    bool normalize_speech = false;
+    float normalize_target_dbfs = -20.0f;
+};
+
+// |base| with the submodule defaults of |preset| (AEC, NS and AGC switches)
+AECConfig ApplyPresetDefaults(const AECConfig& base, AECPreset preset);
+
+// |base| as run on battery: the APM at 16kHz on kLowCpu's short filters, NS
+// (when on) at its lightest, no adaptive escalation. Headphones keep their
+// preset, which has no canceller to shorten.
+AECConfig ApplyLowPowerProfile(const AECConfig& base);
+
+// Capture-only cleanup for a stream with no echo path to cancel (system
+// audio): kHeadphones with AGC2, so NS, adaptive digital gain and the
+// high-pass run and no render reference is wanted
+AECConfig EnhanceConfig();
+
+// Where PostConfig()'s changes stand. Sequence numbers start at 1; a change
+// posted over one still waiting replaces it, so applied may skip some.
+struct AECConfigStatus {
+    uint64_t posted = 0;         // the last PostConfig() returned
+    uint64_t applied = 0;        // the last to take effect
+    uint64_t rejected = 0;       // the last whose APM failed to build; the one before runs on
+    uint64_t applied_frame = 0;  // capture frames processed when it took effect
+    float latency_ms = 0.0f;     // from its post to taking effect
+};
+
+// Wall time of one APM entry point (ProcessStream or ProcessReverseStream,
+// resampling included; the fallback chain without the APM), once per frame
+struct AECCallStats {
+    uint64_t frames = 0;
+    uint64_t errors = 0;           // nonzero APM return codes
+    uint64_t deadline_misses = 0;  // calls longer than the frame duration
+    float p50_us = 0.0f;
+    float p95_us = 0.0f;
+    float p99_us = 0.0f;
+    float max_us = 0.0f;
 };
 
+// Echo statistics come from AudioProcessing::GetStatistics(); each is unset
+// until the APM has produced it (or when running the naive fallback).
 struct AECMetrics {
-    float echo_return_loss = 0.0f;
-    float echo_return_loss_enhancement = 0.0f;
-    int render_delay_ms = 0;
+    std::optional<float> echo_return_loss;              // dB
+    std::optional<float> echo_return_loss_enhancement;  // dB
+    std::optional<float> divergent_filter_fraction;     // 0-1, last second
+    std::optional<float> residual_echo_likelihood;      // 0-1
+    std::optional<float> residual_echo_likelihood_recent_max;
+    std::optional<int> render_delay_ms;                 // instantaneous AEC3 estimate
+    std::optional<int> delay_median_ms;
+    std::optional<int> delay_std_ms;
+    int stream_delay_ms = 0;                            // reported via set_stream_delay_ms
+    std::optional<float> render_drift_ppm;              // render clock vs capture, native pipeline only
+    int processing_sample_rate = 0;                     // rate the APM actually runs at
+    int output_latency_samples = 0;                     // fixed capture output delay (one frame)
+    float output_latency_ms = 0.0f;
+    float processing_load = 0.0f;                       // APM time / audio time
+    bool bypassed = false;                              // SetBypass(true): APM skipped
+    bool adaptive_suppression = false;
+    int suppression_level = 0;                          // adaptive: 0 default preset, 1 aggressive
     bool aec_converged = false;
-    float rms_level = 0.0f;
+    bool cpu_governor = false;
+    int governor_level = 0;                             // cheaper steps in effect, 0-4
+    uint64_t governor_transitions = 0;
+    bool normalize_speech = false;
+    float normalizer_gain_db = 0.0f;                    // applied to the last 10ms frame
+    std::optional<float> speech_level_dbfs;             // once the estimate is confident
+    uint64_t clipping_predictions = 0;                  // gain back-offs ahead of a clip
+    // ResetEchoPath(): how often, the last one's cause, and the echo that
+    // leaked through until the fresh canceller converged again
+    uint64_t echo_path_resets = 0;
+    EchoPathChange echo_path_change = EchoPathChange::kNone;
+    bool echo_path_reconverging = false;
+    std::optional<float> echo_path_reconverge_ms;       // reset to convergence; unset while reconverging
+    std::optional<float> echo_path_leakage_db;          // worst -(ERL + ERLE) since the reset, once a second
+    float rms_level = 0.0f;   // output level of the last 10ms capture frame
     float peak_level = 0.0f;
+    float noise_floor = 0.0f; // adaptive estimate from silent frames
+    bool speech = false;      // last frame above the noise-floor threshold
+    AECCallStats capture_calls;  // GetMetrics only
+    AECCallStats render_calls;
 };
 
 class AECProcessor {
@@ -28,12 +186,96 @@ public:
     explicit AECProcessor(const AECConfig& config);
     ~AECProcessor();
 
-    bool Initialize(int sample_rate, int num_channels);
-    void ProcessRenderAudio(const float* data, size_t num_samples);
+    // Capture is processed as a single channel, so |capture_channels| must be
+    // 1. |render_channels| is the reference layout the APM is built for;
+    // AEC3 runs it in multichannel mode and falls back to a mono downmix
+    // while the channels carry the same content.
+    bool Initialize(int sample_rate, int capture_channels, int render_channels);
+
+    // |data| holds |num_frames| interleaved frames of |num_channels|. A layout
+    // other than the initialized one is mapped onto it: channels are averaged,
+    // so stereo folds to mono and mono is copied to every channel. May run on
+    // another thread than ProcessCaptureAudio (one thread each): the APM's
+    // render queue carries the frames over, as does a ring of our own for the
+    // fallback canceller, and capture pays nothing for render.
+    void ProcessRenderAudio(const float* data, size_t num_frames, int num_channels);
+
+    // Output runs exactly one frame (OutputLatencySamples()) behind input,
+    // whatever the chunk size: every returned sample is processed and in
+    // order, and the first frame out is silence. |output| may alias |input|.
     void ProcessCaptureAudio(const float* input, float* output, size_t num_samples);
+    size_t OutputLatencySamples() const;
+
+    // Any thread; posted like PostConfig()
     void SetEchoCancellationEnabled(bool enabled);
+
+    // Any thread. Headphone fast path: capture skips the APM (or fallback
+    // canceller) for a light high-pass, plus NS when enabled, and render is
+    // not fed. The canceller is kept on standby with its adapted filter, so
+    // un-bypassing resumes without reconverging from scratch. Output latency
+    // is unchanged.
+    void SetBypass(bool bypass);
+    bool IsBypassed() const;
+
+    // Any thread. Submodule changes (AEC/NS/AGC switches, NS level) apply
+    // immediately; a preset or processing rate change builds a new APM here
+    // and swaps it in at the next capture call, so streams keep running.
+    // Frame duration is fixed at Initialize. Returns false if the APM could
+    // not be built.
+    bool Configure(const AECConfig& config);
+
+    // Any thread, and never waits on the processing threads: |config| goes
+    // into a lock-free mailbox the capture thread reads at its next frame
+    // boundary, replacing any change still waiting there. Submodule changes
+    // apply then; one that rebuilds the APM is built on a helper thread and
+    // takes effect at its swap. With capture idle it applies here. Returns
+    // the change's sequence number, for GetConfigStatus().
+    uint64_t PostConfig(const AECConfig& config);
+    AECConfigStatus GetConfigStatus() const;
+
+    // The newest posted change while it waits
+    AECConfig GetConfig() const;
+
+    // Any thread. The echo path moved (another output or mic, or a delay
+    // jump the capture side detected itself): rather than let AEC3 readapt
+    // a stale filter and delay, a fresh APM seeded with |seed| replaces it
+    // at the next frame boundary, posted like PostConfig(). The stream delay
+    // carries on unless |seed| has one. The fallback canceller clears its
+    // filter instead. Returns the change's sequence number.
+    uint64_t ResetEchoPath(const AECWarmStart& seed, EchoPathChange reason);
+
+    // Delay between a render frame being fed and its echo reaching capture;
+    // applied before every subsequent ProcessStream call
+    void SetStreamDelayMs(int delay_ms);
+
+    // Rate of the render clock relative to capture, as measured (and
+    // resampled away) by the native pipeline
+    void SetRenderDriftPpm(float ppm);
     AECMetrics GetMetrics() const;
 
+    // Any thread. This session's state worth carrying over: the delay once
+    // AEC3 has converged, the stream delay once reported, the preset while
+    // adaptive suppression runs.
+    AECWarmStart GetWarmStart() const;
+
+    // Any thread. The noise this session's capture has heard between speech
+    // and echo, for the next session's noise_profile; nullopt before a few
+    // seconds of it
+    std::optional<NoiseProfile> GetNoiseProfile() const;
+
+    // Output levels, stream delay and load only: no lock and no APM statistics,
+    // cheap enough to read after every buffer
+    AECMetrics GetLevels() const;
+
+    // Any thread. Records the APM's config and both streams to |path| for
+    // offline replay (audioproc_f); |max_bytes| caps the file, -1 = no
+    // limit. Returns false without the WebRTC APM, or when the file cannot
+    // be opened or the WebRTC build has no AEC dump support. A preset change
+    // ends the dump.
+    bool StartAecDump(const std::string& path, int64_t max_bytes);
+    void StopAecDump();
+    bool IsAecDumping() const;
+
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
@@ -0,0 +1,449 @@
+#include "aes_gcm.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define KAKAROT_AES_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define KAKAROT_TARGET_AESNI
+#else
+#include <cpuid.h>
+#define KAKAROT_TARGET_AESNI __attribute__((target("aes,pclmul,ssse3")))
+#endif
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+// Apple silicon always has them; elsewhere only a build that targets them
+#define KAKAROT_AES_ARMV8 1
+#include <arm_neon.h>
+#endif
+
+namespace kakarot {
+
+namespace {
+
+constexpr int kRounds = 14;
+constexpr size_t kBlock = 16;
+// CTR blocks in flight at once on the hardware paths, to cover the rounds' latency
+constexpr size_t kLanes = 4;
+
+const uint8_t kSbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+uint32_t GetBe32(const uint8_t* in) {
+    return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+           (static_cast<uint32_t>(in[2]) << 8) | in[3];
+}
+
+void PutBe32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+uint64_t GetBe64(const uint8_t* in) {
+    return (static_cast<uint64_t>(GetBe32(in)) << 32) | GetBe32(in + 4);
+}
+
+void PutBe64(uint8_t* out, uint64_t value) {
+    PutBe32(out, static_cast<uint32_t>(value >> 32));
+    PutBe32(out + 4, static_cast<uint32_t>(value));
+}
+
+// FIPS 197 key expansion; the round keys in the byte order AES-NI and the
+// ARMv8 instructions take too
+void ExpandKey(const uint8_t key[kAesGcmKeySize], uint8_t* round_keys) {
+    static const uint8_t kRcon[8] = {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40};
+    std::memcpy(round_keys, key, kAesGcmKeySize);
+    for (size_t i = 8; i < 4 * (kRounds + 1); ++i) {
+        uint8_t word[4];
+        std::memcpy(word, round_keys + 4 * (i - 1), 4);
+        if (i % 8 == 0) {
+            const uint8_t first = word[0];
+            word[0] = static_cast<uint8_t>(kSbox[word[1]] ^ kRcon[i / 8]);
+            word[1] = kSbox[word[2]];
+            word[2] = kSbox[word[3]];
+            word[3] = kSbox[first];
+        } else if (i % 8 == 4) {
+            for (uint8_t& byte : word) {
+                byte = kSbox[byte];
+            }
+        }
+        for (size_t j = 0; j < 4; ++j) {
+            round_keys[4 * i + j] = static_cast<uint8_t>(round_keys[4 * (i - 8) + j] ^ word[j]);
+        }
+    }
+}
+
+uint8_t Xtime(uint8_t x) {
+    return static_cast<uint8_t>((x << 1) ^ ((x >> 7) * 0x1b));
+}
+
+void EncryptBlockScalar(const uint8_t* round_keys, const uint8_t in[kBlock], uint8_t out[kBlock]) {
+    uint8_t state[kBlock];
+    for (size_t i = 0; i < kBlock; ++i) {
+        state[i] = static_cast<uint8_t>(in[i] ^ round_keys[i]);
+    }
+    for (int round = 1; round <= kRounds; ++round) {
+        // SubBytes and ShiftRows; the state is column-major
+        uint8_t shifted[kBlock];
+        for (size_t column = 0; column < 4; ++column) {
+            for (size_t row = 0; row < 4; ++row) {
+                shifted[column * 4 + row] = kSbox[state[((column + row) % 4) * 4 + row]];
+            }
+        }
+        if (round < kRounds) {
+            for (size_t column = 0; column < 4; ++column) {
+                uint8_t* a = shifted + column * 4;
+                const uint8_t all = static_cast<uint8_t>(a[0] ^ a[1] ^ a[2] ^ a[3]);
+                const uint8_t first = a[0];
+                a[0] = static_cast<uint8_t>(a[0] ^ all ^ Xtime(static_cast<uint8_t>(a[0] ^ a[1])));
+                a[1] = static_cast<uint8_t>(a[1] ^ all ^ Xtime(static_cast<uint8_t>(a[1] ^ a[2])));
+                a[2] = static_cast<uint8_t>(a[2] ^ all ^ Xtime(static_cast<uint8_t>(a[2] ^ a[3])));
+                a[3] = static_cast<uint8_t>(a[3] ^ all ^ Xtime(static_cast<uint8_t>(a[3] ^ first)));
+            }
+        }
+        const uint8_t* key = round_keys + round * kBlock;
+        for (size_t i = 0; i < kBlock; ++i) {
+            state[i] = static_cast<uint8_t>(shifted[i] ^ key[i]);
+        }
+    }
+    std::memcpy(out, state, kBlock);
+}
+
+// XORs the keystream from |counter| (its last word counting up, as GCM's
+// inc32) into |size| bytes of |data|; |counter| is left at the next block
+void CtrScalar(const uint8_t* round_keys, uint8_t counter[kBlock], uint8_t* data, size_t size) {
+    uint32_t count = GetBe32(counter + 12);
+    uint8_t stream[kBlock];
+    while (size > 0) {
+        EncryptBlockScalar(round_keys, counter, stream);
+        PutBe32(counter + 12, ++count);
+        const size_t bytes = std::min(size, kBlock);
+        for (size_t i = 0; i < bytes; ++i) {
+            data[i] ^= stream[i];
+        }
+        data += bytes;
+        size -= bytes;
+    }
+}
+
+// 64x64 carry-less multiply, without branches on the operands
+void ClmulScalar(uint64_t a, uint64_t b, uint64_t* high, uint64_t* low) {
+    uint64_t hi = 0;
+    uint64_t lo = a & (0 - (b & 1));
+    for (int i = 1; i < 64; ++i) {
+        const uint64_t mask = 0 - ((b >> i) & 1);
+        lo ^= (a << i) & mask;
+        hi ^= (a >> (64 - i)) & mask;
+    }
+    *high = hi;
+    *low = lo;
+}
+
+// GHASH over whole blocks, |y| = (|y| ^ block) * |h| in GF(2^128). Blocks
+// read big-endian are GCM's bit-reflected polynomials, so the product is
+// the plain carry-less one shifted left a bit, then reduced (Gueron and
+// Kounavis, "Intel Carry-Less Multiplication Instruction and its Usage for
+// Computing the GCM Mode").
+template <void (*Clmul)(uint64_t, uint64_t, uint64_t*, uint64_t*)>
+void GhashWide(const uint8_t h[kBlock], uint8_t y[kBlock], const uint8_t* data, size_t blocks) {
+    const uint64_t h1 = GetBe64(h);
+    const uint64_t h0 = GetBe64(h + 8);
+    uint64_t y1 = GetBe64(y);
+    uint64_t y0 = GetBe64(y + 8);
+    for (size_t n = 0; n < blocks; ++n, data += kBlock) {
+        const uint64_t a1 = y1 ^ GetBe64(data);
+        const uint64_t a0 = y0 ^ GetBe64(data + 8);
+        uint64_t high_hi, high_lo, low_hi, low_lo, cross1_hi, cross1_lo, cross0_hi, cross0_lo;
+        Clmul(a1, h1, &high_hi, &high_lo);
+        Clmul(a0, h0, &low_hi, &low_lo);
+        Clmul(a1, h0, &cross1_hi, &cross1_lo);
+        Clmul(a0, h1, &cross0_hi, &cross0_lo);
+        uint64_t x3 = high_hi;
+        uint64_t x2 = high_lo ^ cross1_hi ^ cross0_hi;
+        uint64_t x1 = low_hi ^ cross1_lo ^ cross0_lo;
+        uint64_t x0 = low_lo;
+        x3 = (x3 << 1) | (x2 >> 63);
+        x2 = (x2 << 1) | (x1 >> 63);
+        x1 = (x1 << 1) | (x0 >> 63);
+        x0 <<= 1;
+        const uint64_t d = x1 ^ (x0 << 63) ^ (x0 << 62) ^ (x0 << 57);
+        y1 = x3 ^ d ^ (d >> 1) ^ (d >> 2) ^ (d >> 7);
+        y0 = x2 ^ x0 ^ ((x0 >> 1) | (d << 63)) ^ ((x0 >> 2) | (d << 62)) ^ ((x0 >> 7) | (d << 57));
+    }
+    PutBe64(y, y1);
+    PutBe64(y + 8, y0);
+}
+
+#if defined(KAKAROT_AES_X86)
+bool HasAesNi() {
+    int ecx = 0;
+#if defined(_MSC_VER)
+    int regs[4] = {};
+    __cpuid(regs, 1);
+    ecx = regs[2];
+#else
+    unsigned int eax = 0, ebx = 0, ecx_bits = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx_bits, &edx)) {
+        return false;
+    }
+    ecx = static_cast<int>(ecx_bits);
+#endif
+    // AES-NI, PCLMULQDQ and SSSE3 (for the byte swaps)
+    return (ecx & (1 << 25)) != 0 && (ecx & (1 << 1)) != 0 && (ecx & (1 << 9)) != 0;
+}
+
+KAKAROT_TARGET_AESNI void CtrAesNi(const uint8_t* round_keys, uint8_t counter[kBlock], uint8_t* data, size_t size) {
+    __m128i keys[kRounds + 1];
+    for (int i = 0; i <= kRounds; ++i) {
+        keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys + i * kBlock));
+    }
+    uint32_t count = GetBe32(counter + 12);
+    while (size > 0) {
+        __m128i blocks[kLanes];
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            PutBe32(counter + 12, count++);
+            blocks[lane] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(counter)), keys[0]);
+        }
+        for (int round = 1; round < kRounds; ++round) {
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                blocks[lane] = _mm_aesenc_si128(blocks[lane], keys[round]);
+            }
+        }
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            blocks[lane] = _mm_aesenclast_si128(blocks[lane], keys[kRounds]);
+        }
+        if (size >= kLanes * kBlock) {
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                __m128i* at = reinterpret_cast<__m128i*>(data + lane * kBlock);
+                _mm_storeu_si128(at, _mm_xor_si128(_mm_loadu_si128(at), blocks[lane]));
+            }
+            data += kLanes * kBlock;
+            size -= kLanes * kBlock;
+            continue;
+        }
+        // The tail; the counter goes back to the first block it left unused
+        alignas(16) uint8_t stream[kLanes * kBlock];
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            _mm_store_si128(reinterpret_cast<__m128i*>(stream + lane * kBlock), blocks[lane]);
+        }
+        for (size_t i = 0; i < size; ++i) {
+            data[i] ^= stream[i];
+        }
+        count -= static_cast<uint32_t>(kLanes - (size + kBlock - 1) / kBlock);
+        size = 0;
+    }
+    PutBe32(counter + 12, count);
+}
+
+KAKAROT_TARGET_AESNI inline __m128i GfMulClmul(__m128i a, __m128i b) {
+    __m128i low = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i cross = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    __m128i high = _mm_clmulepi64_si128(a, b, 0x11);
+    low = _mm_xor_si128(low, _mm_slli_si128(cross, 8));
+    high = _mm_xor_si128(high, _mm_srli_si128(cross, 8));
+    // Shift the 256-bit product left a bit
+    __m128i low_carry = _mm_srli_epi32(low, 31);
+    __m128i high_carry = _mm_srli_epi32(high, 31);
+    low = _mm_slli_epi32(low, 1);
+    high = _mm_slli_epi32(high, 1);
+    high = _mm_or_si128(high, _mm_srli_si128(low_carry, 12));
+    high = _mm_or_si128(high, _mm_slli_si128(high_carry, 4));
+    low = _mm_or_si128(low, _mm_slli_si128(low_carry, 4));
+    // Reduce by x^128 + x^7 + x^2 + x + 1
+    __m128i fold = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)),
+                                 _mm_slli_epi32(low, 25));
+    __m128i fold_high = _mm_srli_si128(fold, 4);
+    low = _mm_xor_si128(low, _mm_slli_si128(fold, 12));
+    __m128i spread = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)),
+                                   _mm_srli_epi32(low, 7));
+    spread = _mm_xor_si128(spread, fold_high);
+    low = _mm_xor_si128(low, spread);
+    return _mm_xor_si128(high, low);
+}
+
+KAKAROT_TARGET_AESNI void GhashClmul(const uint8_t h[kBlock], uint8_t y[kBlock], const uint8_t* data,
+                                     size_t blocks) {
+    const __m128i swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i key = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)), swap);
+    __m128i state = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y)), swap);
+    for (size_t n = 0; n < blocks; ++n, data += kBlock) {
+        const __m128i block = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), swap);
+        state = GfMulClmul(_mm_xor_si128(state, block), key);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y), _mm_shuffle_epi8(state, swap));
+}
+#elif defined(KAKAROT_AES_ARMV8)
+void CtrArmv8(const uint8_t* round_keys, uint8_t counter[kBlock], uint8_t* data, size_t size) {
+    uint8x16_t keys[kRounds + 1];
+    for (int i = 0; i <= kRounds; ++i) {
+        keys[i] = vld1q_u8(round_keys + i * kBlock);
+    }
+    uint32_t count = GetBe32(counter + 12);
+    while (size > 0) {
+        uint8x16_t blocks[kLanes];
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            PutBe32(counter + 12, count++);
+            blocks[lane] = vld1q_u8(counter);
+        }
+        // AESE adds the round key before SubBytes, so the last one is a plain XOR
+        for (int round = 0; round < kRounds - 1; ++round) {
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                blocks[lane] = vaesmcq_u8(vaeseq_u8(blocks[lane], keys[round]));
+            }
+        }
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            blocks[lane] = veorq_u8(vaeseq_u8(blocks[lane], keys[kRounds - 1]), keys[kRounds]);
+        }
+        if (size >= kLanes * kBlock) {
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                uint8_t* at = data + lane * kBlock;
+                vst1q_u8(at, veorq_u8(vld1q_u8(at), blocks[lane]));
+            }
+            data += kLanes * kBlock;
+            size -= kLanes * kBlock;
+            continue;
+        }
+        uint8_t stream[kLanes * kBlock];
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            vst1q_u8(stream + lane * kBlock, blocks[lane]);
+        }
+        for (size_t i = 0; i < size; ++i) {
+            data[i] ^= stream[i];
+        }
+        count -= static_cast<uint32_t>(kLanes - (size + kBlock - 1) / kBlock);
+        size = 0;
+    }
+    PutBe32(counter + 12, count);
+}
+
+void ClmulPmull(uint64_t a, uint64_t b, uint64_t* high, uint64_t* low) {
+    const uint64x2_t product = vreinterpretq_u64_p128(vmull_p64(a, b));
+    *low = vgetq_lane_u64(product, 0);
+    *high = vgetq_lane_u64(product, 1);
+}
+#endif
+
+struct Kernels {
+    const char* level;
+    void (*ctr)(const uint8_t* round_keys, uint8_t counter[kBlock], uint8_t* data, size_t size);
+    void (*ghash)(const uint8_t h[kBlock], uint8_t y[kBlock], const uint8_t* data, size_t blocks);
+};
+
+const Kernels& Select() {
+    static const Kernels kernels = [] {
+#if defined(KAKAROT_AES_X86)
+        if (HasAesNi()) {
+            return Kernels{"aesni", &CtrAesNi, &GhashClmul};
+        }
+#elif defined(KAKAROT_AES_ARMV8)
+        return Kernels{"armv8", &CtrArmv8, &GhashWide<ClmulPmull>};
+#endif
+        return Kernels{"scalar", &CtrScalar, &GhashWide<ClmulScalar>};
+    }();
+    return kernels;
+}
+
+// Whole blocks, then the rest zero-padded
+void GhashPadded(const Kernels& kernels, const uint8_t h[kBlock], uint8_t y[kBlock], const uint8_t* data,
+                 size_t size) {
+    const size_t whole = size / kBlock;
+    kernels.ghash(h, y, data, whole);
+    if (size % kBlock != 0) {
+        uint8_t last[kBlock] = {};
+        std::memcpy(last, data + whole * kBlock, size % kBlock);
+        kernels.ghash(h, y, last, 1);
+    }
+}
+
+// J0 for a 96-bit IV, plus |block|
+void CounterBlock(const uint8_t iv[kAesGcmIvSize], uint32_t block, uint8_t counter[kBlock]) {
+    std::memcpy(counter, iv, kAesGcmIvSize);
+    PutBe32(counter + kAesGcmIvSize, block);
+}
+
+} // namespace
+
+AesGcm::AesGcm(const uint8_t key[kAesGcmKeySize]) {
+    ExpandKey(key, round_keys_);
+    uint8_t zero[kBlock] = {};
+    std::memset(hash_key_, 0, sizeof(hash_key_));
+    Select().ctr(round_keys_, zero, hash_key_, sizeof(hash_key_));
+}
+
+AesGcm::~AesGcm() {
+    // Through a volatile pointer, so the stores are not dropped as dead
+    volatile uint8_t* keys = round_keys_;
+    for (size_t i = 0; i < sizeof(round_keys_); ++i) {
+        keys[i] = 0;
+    }
+    volatile uint8_t* hash = hash_key_;
+    for (size_t i = 0; i < sizeof(hash_key_); ++i) {
+        hash[i] = 0;
+    }
+}
+
+void AesGcm::Tag(const uint8_t iv[kAesGcmIvSize], const uint8_t* aad, size_t aad_size, const uint8_t* data,
+                 size_t size, uint8_t tag[kAesGcmTagSize]) const {
+    const Kernels& kernels = Select();
+    uint8_t y[kBlock] = {};
+    GhashPadded(kernels, hash_key_, y, aad, aad_size);
+    GhashPadded(kernels, hash_key_, y, data, size);
+    uint8_t lengths[kBlock];
+    PutBe64(lengths, static_cast<uint64_t>(aad_size) * 8);
+    PutBe64(lengths + 8, static_cast<uint64_t>(size) * 8);
+    kernels.ghash(hash_key_, y, lengths, 1);
+    uint8_t counter[kBlock];
+    CounterBlock(iv, 1, counter);
+    kernels.ctr(round_keys_, counter, y, kBlock);
+    std::memcpy(tag, y, kAesGcmTagSize);
+}
+
+void AesGcm::Seal(const uint8_t iv[kAesGcmIvSize], const uint8_t* aad, size_t aad_size, uint8_t* data,
+                  size_t size, uint8_t tag[kAesGcmTagSize]) const {
+    uint8_t counter[kBlock];
+    CounterBlock(iv, 2, counter);
+    Select().ctr(round_keys_, counter, data, size);
+    Tag(iv, aad, aad_size, data, size, tag);
+}
+
+bool AesGcm::Open(const uint8_t iv[kAesGcmIvSize], const uint8_t* aad, size_t aad_size, uint8_t* data,
+                  size_t size, const uint8_t tag[kAesGcmTagSize]) const {
+    uint8_t expected[kAesGcmTagSize];
+    Tag(iv, aad, aad_size, data, size, expected);
+    uint8_t difference = 0;
+    for (size_t i = 0; i < kAesGcmTagSize; ++i) {
+        difference |= static_cast<uint8_t>(expected[i] ^ tag[i]);
+    }
+    if (difference != 0) {
+        return false;
+    }
+    uint8_t counter[kBlock];
+    CounterBlock(iv, 2, counter);
+    Select().ctr(round_keys_, counter, data, size);
+    return true;
+}
+
+const char* AesGcmLevel() {
+    return Select().level;
+}
+
+} // namespace kakarot
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kakarot {
+
+constexpr size_t kAesGcmKeySize = 32;  // AES-256
+constexpr size_t kAesGcmIvSize = 12;
+constexpr size_t kAesGcmTagSize = 16;
+
+// AES-256-GCM (NIST SP 800-38D) over one message at a time, in place. The
+// rounds and GHASH run on AES-NI and PCLMULQDQ where the CPU has them (a
+// run-time check), on the ARMv8 crypto extensions where the build targets
+// them, and portably otherwise; AesGcmLevel() says which. The portable path
+// uses table lookups and is not constant-time. Immutable once keyed, so
+// any number of threads may seal and open with one instance.
+class AesGcm {
+public:
+    explicit AesGcm(const uint8_t key[kAesGcmKeySize]);
+    ~AesGcm();
+
+    AesGcm(const AesGcm&) = delete;
+    AesGcm& operator=(const AesGcm&) = delete;
+
+    // Encrypts |data| and writes its tag, which covers |aad| too. An IV
+    // must never repeat under one key.
+    void Seal(const uint8_t iv[kAesGcmIvSize], const uint8_t* aad, size_t aad_size, uint8_t* data, size_t size,
+              uint8_t tag[kAesGcmTagSize]) const;
+    // False, |data| untouched, when |tag| does not match; else decrypts it
+    bool Open(const uint8_t iv[kAesGcmIvSize], const uint8_t* aad, size_t aad_size, uint8_t* data, size_t size,
+              const uint8_t tag[kAesGcmTagSize]) const;
+
+private:
+    void Tag(const uint8_t iv[kAesGcmIvSize], const uint8_t* aad, size_t aad_size, const uint8_t* data,
+             size_t size, uint8_t tag[kAesGcmTagSize]) const;
+
+    uint8_t round_keys_[15 * 16];
+    uint8_t hash_key_[16];  // E(K, 0)
+};
+
+// "aesni", "armv8" or "scalar"; the same for every call
+const char* AesGcmLevel();
+
+} // namespace kakarot
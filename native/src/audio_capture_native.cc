@@ -2,16 +2,100 @@
 #include <AudioToolbox/AudioToolbox.h>
 #include <CoreAudio/CoreAudio.h>
 #include <mach/mach_time.h>
-#include <dispatch/dispatch.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
+#include <thread>
+#include "addon_common.h"
 #include "aec_processor.h"
+#include "beamformer.h"
+#include "capture_session.h"
+#include "capture_stream.h"
+#include "common_audio/include/audio_util.h"
+#include "device_table.h"
+#include "dsp_kernels.h"
+#include "echo_cancel_pipeline.h"
+#include "host_time.h"
+#include "keyword_spotter.h"
+#include "meeting_audio_monitor.h"
+#include "meeting_recorder.h"
+#include "latency_probe.h"
+#include "native_log.h"
+#include "output_route.h"
+#include "pipeline_trace.h"
+#include "power_monitor.h"
+#include "rtc_base/denormal_disabler.h"
+#include "session_capture.h"
+#include "spsc_ring_buffer.h"
+#include "system_audio_tap.h"
 
 using namespace kakarot;
 
+static constexpr double kCaptureSampleRate = 48000.0;
+
+// 2 seconds of 48kHz mono between the IOProc and the consumer thread
+static constexpr size_t kCaptureRingSamples = 96000;
+static constexpr size_t kCaptureRingChunks = 256;
+
+// Meeting monitor ring: several of its one-second wakes at 48kHz
+static constexpr size_t kMonitorRingSamples = 262144;
+
+// Shadow AEC tap: about a second of stereo render and mono capture, and the
+// 10ms chunks that carry it
+static constexpr size_t kShadowRingSamples = 262144;
+static constexpr size_t kShadowRingRecords = 1024;
+static constexpr UInt32 kMaxSamplesPerCallback = 48000;
+
+// How long processed capture waits for the render covering it. The tap
+// delivers within a buffer or two; JS-fed render (audiotee) arrives in larger,
+// later batches. A stalled render stream never holds the mic past this.
+static constexpr double kTapRenderWaitMs = 50.0;
+static constexpr double kJsRenderWaitMs = 250.0;
+
+// Steering range of the mic beamformer: 34cm of spacing between mics
+static constexpr double kBeamMaxDelayMs = 1.0;
+
+// Source tag of records this file writes to the native log ring
+static const char* const kLogSource = "AudioCapture";
+
+// startSession()'s devices, HAL IOProcs of their own; defined with the
+// device helpers
+static std::unique_ptr<SessionInput> NewSessionInput();
+
+static const char* MicEngineName(MicEngine engine) {
+    return engine == MicEngine::kAuhal ? "auhal"
+        : engine == MicEngine::kVoiceProcessing ? "voiceProcessing" : "hal";
+}
+
+// What a unit engine is asked to deliver: the AUHAL converts straight to the
+// delivery rate unless the AEC pipeline wants 48kHz; VoiceProcessingIO
+// always runs at 48kHz
+static double UnitSampleRate(const CaptureOptions& options) {
+    if (options.engine == MicEngine::kAuhal && !options.processed && options.output_sample_rate > 0.0) {
+        return options.output_sample_rate;
+    }
+    return kCaptureSampleRate;
+}
+
+class MicPrepareWorker;
+class MicStartWorker;
+class MicStopWorker;
+class MicPauseWorker;
+class CalibrateWorker;
+
 class AudioCaptureAddon : public Napi::ObjectWrap<AudioCaptureAddon> {
+    friend class MicPrepareWorker;
+    friend class MicStartWorker;
+    friend class MicStopWorker;
+    friend class MicPauseWorker;
+    friend class CalibrateWorker;
+    
 public:
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     AudioCaptureAddon(const Napi::CallbackInfo& info);
@@ -19,48 +103,587 @@ public:
 
 private:
     // Native microphone capture methods
+    Napi::Value PrepareMicrophoneCapture(const Napi::CallbackInfo& info);
+    Napi::Value UnprepareMicrophoneCapture(const Napi::CallbackInfo& info);
     Napi::Value StartMicrophoneCapture(const Napi::CallbackInfo& info);
     Napi::Value StopMicrophoneCapture(const Napi::CallbackInfo& info);
+    Napi::Value PauseMicrophoneCapture(const Napi::CallbackInfo& info);
+    Napi::Value ResumeMicrophoneCapture(const Napi::CallbackInfo& info);
+    void BeginMicrophoneCapture(Napi::Env env, Napi::Function callback, CaptureOptions options,
+                                Napi::Promise::Deferred deferred, uint64_t start_host);
+    void FinishPrepare();
     Napi::Value GetDevices(const Napi::CallbackInfo& info);
+    Napi::Value OnDevicesChanged(const Napi::CallbackInfo& info);
+    Napi::Value SetInputDevice(const Napi::CallbackInfo& info);
+    Napi::Value GetInputDevice(const Napi::CallbackInfo& info);
+    Napi::Value HostTimeToDateNow(const Napi::CallbackInfo& info);
+    Napi::Value GetHostTime(const Napi::CallbackInfo& info);
+    Napi::Value GetCaptureStats(const Napi::CallbackInfo& info);
+    Napi::Value SetPowerProfile(const Napi::CallbackInfo& info);
+    Napi::Value GetLatencyTrace(const Napi::CallbackInfo& info);
+    Napi::Value MarkAudioSent(const Napi::CallbackInfo& info);
+    Napi::Value SubscribeCapture(const Napi::CallbackInfo& info);
+    Napi::Value UnsubscribeCapture(const Napi::CallbackInfo& info);
+    Napi::Value ReadHistory(const Napi::CallbackInfo& info);
+    Napi::Value StartLevelMeter(const Napi::CallbackInfo& info);
+    Napi::Value StopLevelMeter(const Napi::CallbackInfo& info);
+    Napi::Value ArmSharedStart(const Napi::CallbackInfo& info);
+
+    // Named capture sessions on the shared DSP pool
+    Napi::Value StartSession(const Napi::CallbackInfo& info) { return sessions_.Start(info); }
+    Napi::Value StopSession(const Napi::CallbackInfo& info) { return sessions_.Stop(info); }
+    Napi::Value GetSessions(const Napi::CallbackInfo& info) { return sessions_.GetStats(info); }
+
+    // A meeting's pipeline health, folded from the readMetrics() slots
+    Napi::Value StartPerformanceReport(const Napi::CallbackInfo& info) {
+        kakarot::StartPerformanceReport(info, &performance_, [this](MetricsWriter* writer) { WriteMetrics(writer); });
+        return info.Env().Undefined();
+    }
+    Napi::Value StopPerformanceReport(const Napi::CallbackInfo& info) {
+        return kakarot::StopPerformanceReport(info.Env(), &performance_);
+    }
+    
+    // Native system audio capture (process tap)
+    Napi::Value StartSystemAudioCapture(const Napi::CallbackInfo& info);
+    Napi::Value StopSystemAudioCapture(const Napi::CallbackInfo& info);
+    Napi::Value IsSystemAudioCaptureSupported(const Napi::CallbackInfo& info);
+    Napi::Value GetSystemAudioFormat(const Napi::CallbackInfo& info);
+    Napi::Value StartMeetingMonitor(const Napi::CallbackInfo& info);
+    Napi::Value StopMeetingMonitor(const Napi::CallbackInfo& info);
+    Napi::Value GetMeetingMonitorStats(const Napi::CallbackInfo& info);
+    void StopMeetingMonitorTap();
+    Napi::Value StartKeywordSpotter(const Napi::CallbackInfo& info);
+    Napi::Value StopKeywordSpotter(const Napi::CallbackInfo& info);
+    Napi::Value GetKeywordSpotterStats(const Napi::CallbackInfo& info);
+    void StopKeywordSpotterListening();
+    Napi::Value StartVoiceEnrollment(const Napi::CallbackInfo& info);
+    Napi::Value FinishVoiceEnrollment(const Napi::CallbackInfo& info);
+    Napi::Value CancelVoiceEnrollment(const Napi::CallbackInfo& info);
+    Napi::Value SetVoiceprint(const Napi::CallbackInfo& info);
+    Napi::Value GetVoiceVerifierStats(const Napi::CallbackInfo& info);
     
     // AEC methods
     Napi::Value ProcessRenderAudio(const Napi::CallbackInfo& info);
     Napi::Value ProcessCaptureAudio(const Napi::CallbackInfo& info);
+    Napi::Value ProcessSyncedPair(const Napi::CallbackInfo& info);
     Napi::Value GetMetrics(const Napi::CallbackInfo& info);
+    Napi::Value ReadMetrics(const Napi::CallbackInfo& info);
+    Napi::Value GetMetricsLayout(const Napi::CallbackInfo& info);
+    void WriteMetrics(MetricsWriter* writer);
+    Napi::Value GetAecProfile(const Napi::CallbackInfo& info);
+    Napi::Value GetNoiseProfile(const Napi::CallbackInfo& info);
+    Napi::Value SetAecProfiles(const Napi::CallbackInfo& info);
+    Napi::Value ResetEchoPath(const Napi::CallbackInfo& info);
+    void ResetEchoPathFor(AudioDeviceID from_input, AudioDeviceID from_output, AudioDeviceID input,
+                          AudioDeviceID output, EchoPathChange reason);
+    Napi::Value StartShadowAec(const Napi::CallbackInfo& info);
+    Napi::Value StopShadowAec(const Napi::CallbackInfo& info);
+    Napi::Value GetShadowComparison(const Napi::CallbackInfo& info);
+    Napi::Value Calibrate(const Napi::CallbackInfo& info);
     Napi::Value SetEchoCancellationEnabled(const Napi::CallbackInfo& info);
+    Napi::Value SetHeadphoneBypass(const Napi::CallbackInfo& info);
+    Napi::Value SetVoiceProcessingBypass(const Napi::CallbackInfo& info);
+    Napi::Value IsHeadphonesConnected(const Napi::CallbackInfo& info);
+    Napi::Value IsMicrophoneProcessed(const Napi::CallbackInfo& info);
+    Napi::Value OnHeadphoneStatusChanged(const Napi::CallbackInfo& info);
+    void OnOutputRouteChanged(bool headphones);
+    void OnOutputPathChanged(const OutputRouteInfo& from, const OutputRouteInfo& to);
+    double ApplyEchoPathLatency(AudioDeviceID input);
+    Napi::Value GetEchoPathLatencyInfo(const Napi::CallbackInfo& info);
+    Napi::Value OnCaptureRecovered(const Napi::CallbackInfo& info);
+    Napi::Value Configure(const Napi::CallbackInfo& info);
+    Napi::Value GetConfig(const Napi::CallbackInfo& info);
+    Napi::Value PostConfig(const Napi::CallbackInfo& info);
+    Napi::Value GetConfigStatus(const Napi::CallbackInfo& info);
+    Napi::Value StartAecDump(const Napi::CallbackInfo& info);
+    Napi::Value StopAecDump(const Napi::CallbackInfo& info);
+    
+    // Async AEC: JS-enqueued capture cleaned on the DSP thread
+    Napi::Value StartAsyncProcessing(const Napi::CallbackInfo& info);
+    Napi::Value StopAsyncProcessing(const Napi::CallbackInfo& info);
     
     // Placeholder methods
     Napi::Value Start(const Napi::CallbackInfo& info);
     Napi::Value Stop(const Napi::CallbackInfo& info);
     
+    // Real-time capture path
+    static OSStatus MicIOProc(AudioDeviceID inDevice,
+                              const AudioTimeStamp* inNow,
+                              const AudioBufferList* inInputData,
+                              const AudioTimeStamp* inInputTime,
+                              AudioBufferList* outOutputData,
+                              const AudioTimeStamp* inOutputTime,
+                              void* inClientData);
+    // Input callback of the AUHAL and VoiceProcessingIO engines, and
+    // silence for the output element VoiceProcessingIO needs running
+    static OSStatus UnitInputProc(void* inRefCon,
+                                  AudioUnitRenderActionFlags* ioActionFlags,
+                                  const AudioTimeStamp* inTimeStamp,
+                                  UInt32 inBusNumber,
+                                  UInt32 inNumberFrames,
+                                  AudioBufferList* ioData);
+    static OSStatus VoiceRenderSilence(void* inRefCon,
+                                       AudioUnitRenderActionFlags* ioActionFlags,
+                                       const AudioTimeStamp* inTimeStamp,
+                                       UInt32 inBusNumber,
+                                       UInt32 inNumberFrames,
+                                       AudioBufferList* ioData);
+    static void SystemAudioSink(void* context, const float* data, uint32_t num_samples,
+                                uint64_t host_time);
+    static void TapMicrophoneSink(void* context, const float* data, uint32_t num_samples,
+                                  uint64_t host_time);
+    static void MeetingMonitorSink(void* context, const float* data, uint32_t num_samples,
+                                   uint64_t host_time);
+    void DeliverMicrophone(const float* data, uint32_t num_samples, uint64_t host_time);
+    void QuiesceTapSinks() const;
+    void ReleaseIdleTap();
+    
+    // Input device selection and hot-switching
+    static OSStatus InputDevicesChanged(AudioObjectID object,
+                                        UInt32 numAddresses,
+                                        const AudioObjectPropertyAddress* addresses,
+                                        void* clientData);
+    static OSStatus MicOverload(AudioObjectID object,
+                                UInt32 numAddresses,
+                                const AudioObjectPropertyAddress* addresses,
+                                void* clientData);
+    AudioDeviceID ResolveInputDevice() const;
+    Napi::Array BuildDeviceArray(Napi::Env env);
+    Napi::Value CachedDeviceArray(Napi::Env env);
+    bool SwitchInputDevice(AudioDeviceID newDevice);
+    void WatchInputDevice(AudioDeviceID device, bool watch);
+    void RestoreIoBuffer(AudioDeviceID device);
+    
+    // Device loss and sleep: capture stops without being asked, the gap is
+    // marked, and capture resumes on whatever device it should follow then
+    void OnPowerChanged(bool awake);
+    // Any thread: enters or leaves low power as the profile and power source say
+    void UpdatePowerProfile();
+    void MarkMicrophoneGap(const char* reason);
+    void RecoverMicrophone();
+    void FinishMicrophoneGap();
+    
+    // Blocking CoreAudio bring-up/teardown, run on AsyncWorker threads
+    bool PrepareMicrophone(UInt32 io_buffer_frames, MicEngine engine, UInt32 ducking_level, double unit_rate,
+                           std::string* error);
+    bool BuildMicrophone(double sample_rate, UInt32 io_buffer_frames, MicEngine engine, UInt32 ducking_level,
+                         std::string* error);
+    bool BuildVoiceProcessing(UInt32 io_buffer_frames, UInt32 ducking_level, std::string* error);
+    void ReleaseMicrophone();
+    // device_mutex_ held: run or stop the device IO of whichever engine was built
+    bool MicIOReady() const;
+    OSStatus StartMicIO();
+    void StopMicIO();
+    bool SetupMicrophone(std::string* error);
+    void TeardownMicrophone();
+    bool PauseMicrophone(bool pause, std::string* error);
+    
+    // calibrate(): a quiet chirp through the default output, found again in
+    // the raw mic to measure the acoustic round trip
+    struct Calibration {
+        double round_trip_ms = 0.0;
+        float clarity = 0.0f;
+    };
+    bool MeasureRoundTrip(Calibration* result, std::string* error);
+    static OSStatus ProbeRender(void* inRefCon,
+                                AudioUnitRenderActionFlags* ioActionFlags,
+                                const AudioTimeStamp* inTimeStamp,
+                                UInt32 inBusNumber,
+                                UInt32 inNumberFrames,
+                                AudioBufferList* ioData);
+    
     // State
     AudioUnit mic_audio_unit_;
     AudioDeviceID device_id_;
     AudioDeviceIOProcID io_proc_id_;
-    Napi::ThreadSafeFunction tsfn_;
-    bool is_capturing_;
+    std::atomic<bool> is_capturing_;
+    std::atomic<bool> mic_busy_;     // a start/stop/pause worker is in flight
+    std::atomic<bool> mic_paused_;   // device IO stopped, everything else kept; device_mutex_
+    double mic_sample_rate_;         // input device's nominal rate, fixed per session
+    std::vector<float> mic_downmix_; // MicIOProc only: mono of a multichannel device
+    std::vector<int> mic_channels_;  // inputChannels of this session; empty = all
+    // beamform: set on the JS thread before the IOProc starts
+    std::unique_ptr<DelayAndSumBeamformer> beamformer_;
+    uint64_t beam_latency_ticks_ = 0;
+    UInt32 io_buffer_request_;       // ioBufferFrames of this session; 0 = device default
+    UInt32 io_buffer_restore_;       // device_id_'s size before the request; 0 = untouched
+    
+    // Engines other than kHal run the device through mic_audio_unit_, with
+    // no IOProc; its input callback renders into unit_buffer_. The voice_
+    // atomics mirror a VoiceProcessingIO unit for getCaptureStats().
+    MicEngine mic_engine_;           // device_mutex_: the built unit's engine
+    MicEngine engine_request_;       // this session's engine
+    UInt32 ducking_request_;
+    std::vector<float> unit_buffer_;
+    std::atomic<bool> voice_active_;
+    std::atomic<bool> voice_bypassed_;
+    std::atomic<UInt32> voice_ducking_;      // AUVoiceIOOtherAudioDuckingLevel in effect
+    std::atomic<bool> voice_advanced_ducking_;
     std::string selected_device_id_;
     
+    // prepareMicrophoneCapture(): the AUHAL and IOProc built for device_id_
+    // but not started. A start that arrives mid-prepare waits in
+    // pending_start_ rather than block the JS thread on device_mutex_.
+    bool mic_prepared_;              // device_mutex_
+    double prepared_rate_;
+    UInt32 prepared_io_buffer_;
+    std::vector<int> prepared_channels_;  // auhal: the channel map the unit was built with
+    bool mic_preparing_;             // JS thread: a prepare worker is in flight
+    struct PendingStart {
+        Napi::FunctionReference callback;
+        CaptureOptions options;
+        Napi::Promise::Deferred deferred;
+        uint64_t start_host;         // when startMicrophoneCapture() was called
+    };
+    std::unique_ptr<PendingStart> pending_start_;
+    
+    // Serializes IOProc moves between the JS thread and the HAL listener thread
+    std::mutex device_mutex_;
+    
+    // Listener-maintained device list; the JS array is rebuilt only on change
+    DeviceTable device_table_;
+    Napi::ObjectReference devices_cache_;
+    uint64_t devices_cache_version_;
+    Napi::ThreadSafeFunction devices_tsfn_;
+    Napi::FunctionReference devices_callback_;
+    
+    // Default output route; with auto bypass the HAL listener thread flips the
+    // AEC bypass itself, before JS hears about it
+    OutputRoute output_route_;
+    std::atomic<bool> auto_bypass_;
+    Napi::ThreadSafeFunction route_tsfn_;
+    std::atomic<bool> route_tsfn_ready_;      // route_tsfn_ is set; read on the HAL thread
+    Napi::FunctionReference route_callback_;
+    
+    // An interrupted mic session; device_mutex_. JS hears when it recovers.
+    PowerMonitor power_monitor_;
+    uint64_t mic_gap_host_;                   // when it stopped; 0 = running
+    const char* mic_gap_reason_;
+    Napi::ThreadSafeFunction recovery_tsfn_;
+    std::atomic<bool> recovery_tsfn_ready_;
+    Napi::FunctionReference recovery_callback_;
+    
+    // startMeetingMonitor(): a tap of its own into the standby detector,
+    // whose thread calls JS through meeting_tsfn_
+    std::unique_ptr<SystemAudioTap> monitor_tap_;
+    MeetingAudioMonitor meeting_monitor_;
+    Napi::ThreadSafeFunction meeting_tsfn_;
+    
+    // startKeywordSpotter(): a listener on the system stream's spectrum,
+    // whose thread calls JS through keyword_tsfn_
+    KeywordSpotter keyword_spotter_;
+    Napi::ThreadSafeFunction keyword_tsfn_;
+    
+    // setPowerProfile(); power_profile_mutex_. While low_power_ the APM runs
+    // ApplyLowPowerProfile() of aec_base_config_, the configuration JS asked for.
+    std::mutex power_profile_mutex_;
+    PowerProfile power_profile_;
+    bool low_power_;
+    AECConfig aec_base_config_;
+    
+    // One host clock for both streams so their timestamps share a domain
+    HostClock host_clock_;
+    
+    // IOProc -> consumer -> JS pipelines (preallocated, lock-free on the RT side)
+    CaptureStream mic_stream_;
+    CaptureStream system_stream_;
+    std::unique_ptr<SystemAudioTap> system_tap_;
+    
+    // Shared clock: the tap's aggregate carries tap_input_device_ and its
+    // IOProc feeds the mic too (mic_on_tap_). The tap then outlives
+    // stopSystemAudioCapture() until the mic stops; tap_delivers_system_
+    // gates the system half. The sinks count themselves in flight so
+    // teardown can wait them out without stopping the tap's IO.
+    AudioDeviceID tap_input_device_;
+    std::atomic<bool> mic_on_tap_;
+    std::atomic<bool> tap_delivers_system_;
+    mutable std::atomic<int> tap_sinks_in_flight_;
+    
+    // Native AEC: mic + tap -> DSP thread -> mic_stream_ ('processed' mode),
+    // or JS capture + render -> DSP thread -> async_stream_ (async mode).
+    // The flags pick the single producer of each pipeline ring.
+    EchoCancelPipeline aec_pipeline_;
+    CaptureStream async_stream_;
+    std::atomic<bool> mic_feeds_pipeline_;
+    std::atomic<bool> tap_feeds_pipeline_;
+    
+    // startLevelMeter(); points at the streams' meters, so it is torn down first
+    LevelMeterPublisher level_meter_;
+    PerformanceRecorder performance_;
+    
+    // startSession(): devices and graphs of their own, beside the streams above
+    CaptureSessionSet sessions_;
+    
     // AEC processor
     std::unique_ptr<AECProcessor> aec_processor_;
+    int render_channels_;            // reference layout the APM was built for
+    AECProfileTable aec_profiles_;   // setAecProfiles(); seeds resets on a device switch
+    ShadowAec shadow_aec_;           // startShadowAec(); tapped by aec_pipeline_, compares with aec_processor_
+    
+    // calibrate(). The probe is set before the output unit starts; the mic's
+    // real-time thread records into calibration_ring_ while armed.
+    std::vector<float> probe_;
+    std::atomic<size_t> probe_position_;
+    std::atomic<uint64_t> probe_host_;                // first probe frame's output time
+    std::unique_ptr<SpscRingBuffer<float>> calibration_ring_;
+    std::atomic<bool> calibration_armed_;
+    std::atomic<uint64_t> calibration_capture_host_;  // first recorded sample; 0 until then
+    
+    // Hardware part of the echo delay the pipeline adds to the measured lead:
+    // analytic from the devices, or calibrate()'s round trip until the route
+    // changes
+    std::atomic<double> echo_latency_ms_;
+    std::atomic<bool> echo_latency_calibrated_;
+    
+    // processSyncedPair() delay tracking (JS thread)
+    uint64_t paired_latency_version_;
+    double paired_path_latency_ms_;
+    double paired_delay_ms_;
+    
+    // s16le staging for synchronous processing (JS thread)
+    std::vector<float> pcm_scratch_;
+    
+    // Float staging for Buffer render input (JS thread)
+    std::vector<float> render_scratch_;
+};
+
+// Runs PrepareMicrophone() off the JS thread, then hands over to a start that
+// was requested meanwhile
+class MicPrepareWorker : public Napi::AsyncWorker {
+public:
+    MicPrepareWorker(AudioCaptureAddon* addon, Napi::Promise::Deferred deferred, UInt32 io_buffer_frames,
+                     MicEngine engine, UInt32 ducking_level, double unit_rate)
+        : Napi::AsyncWorker(addon->Value(), "MicPrepareWorker"), addon_(addon), deferred_(deferred),
+          io_buffer_frames_(io_buffer_frames), engine_(engine), ducking_level_(ducking_level),
+          unit_rate_(unit_rate) {}
+    
+    void Execute() override {
+        std::string error;
+        if (!addon_->PrepareMicrophone(io_buffer_frames_, engine_, ducking_level_, unit_rate_, &error)) {
+            SetError(error);
+        }
+    }
+    
+    void OnOK() override {
+        deferred_.Resolve(Napi::Boolean::New(Env(), true));
+        addon_->FinishPrepare();
+    }
+    
+    void OnError(const Napi::Error& error) override {
+        deferred_.Reject(error.Value());
+        addon_->FinishPrepare();
+    }
+    
+private:
+    AudioCaptureAddon* addon_;
+    Napi::Promise::Deferred deferred_;
+    UInt32 io_buffer_frames_;
+    MicEngine engine_;
+    UInt32 ducking_level_;
+    double unit_rate_;
+};
+
+// Runs PauseMicrophone() off the JS thread; AudioDeviceStop/Start can block
+// on Bluetooth devices like the rest of the bring-up
+class MicPauseWorker : public Napi::AsyncWorker {
+public:
+    MicPauseWorker(AudioCaptureAddon* addon, Napi::Promise::Deferred deferred, bool pause)
+        : Napi::AsyncWorker(addon->Value(), "MicPauseWorker"), addon_(addon), deferred_(deferred), pause_(pause) {}
+    
+    void Execute() override {
+        std::string error;
+        if (!addon_->PauseMicrophone(pause_, &error)) {
+            SetError(error);
+        }
+    }
+    
+    void OnOK() override {
+        addon_->mic_busy_ = false;
+        addon_->mic_stream_.SetIdle(Env(), pause_);
+        deferred_.Resolve(Napi::Boolean::New(Env(), true));
+    }
+    
+    void OnError(const Napi::Error& error) override {
+        addon_->mic_busy_ = false;
+        deferred_.Reject(error.Value());
+    }
+    
+private:
+    AudioCaptureAddon* addon_;
+    Napi::Promise::Deferred deferred_;
+    bool pause_;
+};
+
+// Plays and finds the calibration probe off the JS thread; the result is
+// applied on the JS thread
+class CalibrateWorker : public Napi::AsyncWorker {
+public:
+    CalibrateWorker(AudioCaptureAddon* addon, Napi::Promise::Deferred deferred)
+        : Napi::AsyncWorker(addon->Value(), "CalibrateWorker"), addon_(addon), deferred_(deferred) {}
+    
+    void Execute() override {
+        std::string error;
+        if (!addon_->MeasureRoundTrip(&result_, &error)) {
+            SetError(error);
+        }
+    }
+    
+    void OnOK() override;
+    
+    void OnError(const Napi::Error& error) override {
+        addon_->mic_busy_ = false;
+        deferred_.Reject(error.Value());
+    }
+    
+private:
+    AudioCaptureAddon* addon_;
+    Napi::Promise::Deferred deferred_;
+    AudioCaptureAddon::Calibration result_;
+};
+
+// Runs SetupMicrophone() off the JS thread and settles the start promise.
+// Holding the addon's JS object keeps it alive until the worker completes.
+class MicStartWorker : public Napi::AsyncWorker {
+public:
+    MicStartWorker(AudioCaptureAddon* addon, Napi::Promise::Deferred deferred)
+        : Napi::AsyncWorker(addon->Value(), "MicStartWorker"), addon_(addon), deferred_(deferred) {}
+    
+    void Execute() override {
+        std::string error;
+        if (!addon_->SetupMicrophone(&error)) {
+            SetError(error);
+        }
+    }
+    
+    void OnOK() override {
+        addon_->mic_busy_ = false;
+        deferred_.Resolve(Napi::Boolean::New(Env(), true));
+    }
+    
+    void OnError(const Napi::Error& error) override {
+        if (addon_->mic_feeds_pipeline_.exchange(false)) {
+            addon_->aec_pipeline_.Stop();
+        }
+        addon_->mic_stream_.Close();
+        if (addon_->mic_on_tap_.exchange(false)) {
+            addon_->ReleaseIdleTap();
+        }
+        addon_->mic_busy_ = false;
+        deferred_.Reject(error.Value());
+    }
+    
+private:
+    AudioCaptureAddon* addon_;
+    Napi::Promise::Deferred deferred_;
+};
+
+// Runs TeardownMicrophone() off the JS thread; AudioDeviceStop can block on
+// Bluetooth devices as long as start does
+class MicStopWorker : public Napi::AsyncWorker {
+public:
+    MicStopWorker(AudioCaptureAddon* addon, Napi::Promise::Deferred deferred)
+        : Napi::AsyncWorker(addon->Value(), "MicStopWorker"), addon_(addon), deferred_(deferred) {}
+    
+    void Execute() override {
+        addon_->TeardownMicrophone();
+    }
+    
+    void OnOK() override {
+        // Flushes the tail and releases the TSFN
+        addon_->mic_stream_.Close();
+        if (addon_->mic_on_tap_.exchange(false)) {
+            addon_->ReleaseIdleTap();
+        }
+        addon_->mic_busy_ = false;
+        std::cout << "✅ Microphone capture stopped" << std::endl;
+        deferred_.Resolve(Napi::Boolean::New(Env(), true));
+    }
+    
+private:
+    AudioCaptureAddon* addon_;
+    Napi::Promise::Deferred deferred_;
 };
 
 Napi::Object AudioCaptureAddon::Init(Napi::Env env, Napi::Object exports) {
     Napi::Function func = DefineClass(env, "AudioCaptureAddon", {
+        InstanceMethod("prepareMicrophoneCapture", &AudioCaptureAddon::PrepareMicrophoneCapture),
+        InstanceMethod("unprepareMicrophoneCapture", &AudioCaptureAddon::UnprepareMicrophoneCapture),
         InstanceMethod("startMicrophoneCapture", &AudioCaptureAddon::StartMicrophoneCapture),
         InstanceMethod("stopMicrophoneCapture", &AudioCaptureAddon::StopMicrophoneCapture),
+        InstanceMethod("pauseMicrophoneCapture", &AudioCaptureAddon::PauseMicrophoneCapture),
+        InstanceMethod("resumeMicrophoneCapture", &AudioCaptureAddon::ResumeMicrophoneCapture),
         InstanceMethod("getDevices", &AudioCaptureAddon::GetDevices),
+        InstanceMethod("onDevicesChanged", &AudioCaptureAddon::OnDevicesChanged),
+        InstanceMethod("setInputDevice", &AudioCaptureAddon::SetInputDevice),
+        InstanceMethod("getInputDevice", &AudioCaptureAddon::GetInputDevice),
+        InstanceMethod("hostTimeToDateNow", &AudioCaptureAddon::HostTimeToDateNow),
+        InstanceMethod("getHostTime", &AudioCaptureAddon::GetHostTime),
+        InstanceMethod("getCaptureStats", &AudioCaptureAddon::GetCaptureStats),
+        InstanceMethod("setPowerProfile", &AudioCaptureAddon::SetPowerProfile),
+        InstanceMethod("getLatencyTrace", &AudioCaptureAddon::GetLatencyTrace),
+        InstanceMethod("markAudioSent", &AudioCaptureAddon::MarkAudioSent),
+        InstanceMethod("subscribeCapture", &AudioCaptureAddon::SubscribeCapture),
+        InstanceMethod("unsubscribeCapture", &AudioCaptureAddon::UnsubscribeCapture),
+        InstanceMethod("readHistory", &AudioCaptureAddon::ReadHistory),
+        InstanceMethod("startLevelMeter", &AudioCaptureAddon::StartLevelMeter),
+        InstanceMethod("stopLevelMeter", &AudioCaptureAddon::StopLevelMeter),
+        InstanceMethod("armSharedStart", &AudioCaptureAddon::ArmSharedStart),
+        InstanceMethod("startSession", &AudioCaptureAddon::StartSession),
+        InstanceMethod("stopSession", &AudioCaptureAddon::StopSession),
+        InstanceMethod("getSessions", &AudioCaptureAddon::GetSessions),
+        InstanceMethod("startPerformanceReport", &AudioCaptureAddon::StartPerformanceReport),
+        InstanceMethod("stopPerformanceReport", &AudioCaptureAddon::StopPerformanceReport),
+        InstanceMethod("startSystemAudioCapture", &AudioCaptureAddon::StartSystemAudioCapture),
+        InstanceMethod("stopSystemAudioCapture", &AudioCaptureAddon::StopSystemAudioCapture),
+        InstanceMethod("isSystemAudioCaptureSupported", &AudioCaptureAddon::IsSystemAudioCaptureSupported),
+        InstanceMethod("getSystemAudioFormat", &AudioCaptureAddon::GetSystemAudioFormat),
+        InstanceMethod("startMeetingMonitor", &AudioCaptureAddon::StartMeetingMonitor),
+        InstanceMethod("stopMeetingMonitor", &AudioCaptureAddon::StopMeetingMonitor),
+        InstanceMethod("getMeetingMonitorStats", &AudioCaptureAddon::GetMeetingMonitorStats),
+        InstanceMethod("startKeywordSpotter", &AudioCaptureAddon::StartKeywordSpotter),
+        InstanceMethod("stopKeywordSpotter", &AudioCaptureAddon::StopKeywordSpotter),
+        InstanceMethod("getKeywordSpotterStats", &AudioCaptureAddon::GetKeywordSpotterStats),
+        InstanceMethod("startVoiceEnrollment", &AudioCaptureAddon::StartVoiceEnrollment),
+        InstanceMethod("finishVoiceEnrollment", &AudioCaptureAddon::FinishVoiceEnrollment),
+        InstanceMethod("cancelVoiceEnrollment", &AudioCaptureAddon::CancelVoiceEnrollment),
+        InstanceMethod("setVoiceprint", &AudioCaptureAddon::SetVoiceprint),
+        InstanceMethod("getVoiceVerifierStats", &AudioCaptureAddon::GetVoiceVerifierStats),
         InstanceMethod("processRenderAudio", &AudioCaptureAddon::ProcessRenderAudio),
         InstanceMethod("processCaptureAudio", &AudioCaptureAddon::ProcessCaptureAudio),
+        InstanceMethod("processSyncedPair", &AudioCaptureAddon::ProcessSyncedPair),
         InstanceMethod("getMetrics", &AudioCaptureAddon::GetMetrics),
+        InstanceMethod("readMetrics", &AudioCaptureAddon::ReadMetrics),
+        InstanceMethod("getMetricsLayout", &AudioCaptureAddon::GetMetricsLayout),
+        InstanceMethod("getAecProfile", &AudioCaptureAddon::GetAecProfile),
+        InstanceMethod("getNoiseProfile", &AudioCaptureAddon::GetNoiseProfile),
+        InstanceMethod("setAecProfiles", &AudioCaptureAddon::SetAecProfiles),
+        InstanceMethod("resetEchoPath", &AudioCaptureAddon::ResetEchoPath),
+        InstanceMethod("startShadowAec", &AudioCaptureAddon::StartShadowAec),
+        InstanceMethod("stopShadowAec", &AudioCaptureAddon::StopShadowAec),
+        InstanceMethod("getShadowComparison", &AudioCaptureAddon::GetShadowComparison),
+        InstanceMethod("getEchoPathLatency", &AudioCaptureAddon::GetEchoPathLatencyInfo),
+        InstanceMethod("calibrate", &AudioCaptureAddon::Calibrate),
         InstanceMethod("setEchoCancellationEnabled", &AudioCaptureAddon::SetEchoCancellationEnabled),
+        InstanceMethod("setHeadphoneBypass", &AudioCaptureAddon::SetHeadphoneBypass),
+        InstanceMethod("setVoiceProcessingBypass", &AudioCaptureAddon::SetVoiceProcessingBypass),
+        InstanceMethod("isHeadphonesConnected", &AudioCaptureAddon::IsHeadphonesConnected),
+        InstanceMethod("isMicrophoneProcessed", &AudioCaptureAddon::IsMicrophoneProcessed),
+        InstanceMethod("onHeadphoneStatusChanged", &AudioCaptureAddon::OnHeadphoneStatusChanged),
+        InstanceMethod("onCaptureRecovered", &AudioCaptureAddon::OnCaptureRecovered),
+        InstanceMethod("configure", &AudioCaptureAddon::Configure),
+        InstanceMethod("getConfig", &AudioCaptureAddon::GetConfig),
+        InstanceMethod("postConfig", &AudioCaptureAddon::PostConfig),
+        InstanceMethod("getConfigStatus", &AudioCaptureAddon::GetConfigStatus),
+        InstanceMethod("startAecDump", &AudioCaptureAddon::StartAecDump),
+        InstanceMethod("stopAecDump", &AudioCaptureAddon::StopAecDump),
+        InstanceMethod("startAsyncProcessing", &AudioCaptureAddon::StartAsyncProcessing),
+        InstanceMethod("stopAsyncProcessing", &AudioCaptureAddon::StopAsyncProcessing),
         InstanceMethod("start", &AudioCaptureAddon::Start),
         InstanceMethod("stop", &AudioCaptureAddon::Stop)
     });
     
-    Napi::FunctionReference* constructor = new Napi::FunctionReference();
-    *constructor = Napi::Persistent(func);
-    env.SetInstanceData(constructor);
+    // Per env: a worker_thread loading the addon gets its own class
+    GetAddonInstance(env)->capture_addon = Napi::Persistent(func);
     
     exports.Set("AudioCaptureAddon", func);
     return exports;
@@ -71,20 +694,80 @@ AudioCaptureAddon::AudioCaptureAddon(const Napi::CallbackInfo& info)
       mic_audio_unit_(nullptr),
       device_id_(kAudioObjectUnknown),
       io_proc_id_(nullptr),
-      is_capturing_(false) {
+      is_capturing_(false),
+      mic_busy_(false),
+      mic_paused_(false),
+      mic_sample_rate_(kCaptureSampleRate),
+      mic_downmix_(kMaxSamplesPerCallback),
+      io_buffer_request_(0),
+      io_buffer_restore_(0),
+      mic_engine_(MicEngine::kHal),
+      engine_request_(MicEngine::kHal),
+      ducking_request_(0),
+      unit_buffer_(kMaxSamplesPerCallback),
+      voice_active_(false),
+      voice_bypassed_(false),
+      voice_ducking_(0),
+      voice_advanced_ducking_(false),
+      mic_prepared_(false),
+      prepared_rate_(0.0),
+      prepared_io_buffer_(0),
+      mic_preparing_(false),
+      devices_cache_version_(UINT64_MAX),
+      auto_bypass_(false),
+      route_tsfn_ready_(false),
+      mic_gap_host_(0),
+      mic_gap_reason_(""),
+      recovery_tsfn_ready_(false),
+      meeting_monitor_(kMonitorRingSamples),
+      power_profile_(PowerProfile::kNormal),
+      low_power_(false),
+      mic_stream_("MicrophoneCapture", &host_clock_, kCaptureRingSamples, kCaptureRingChunks),
+      system_stream_("SystemAudioCapture", &host_clock_, kCaptureRingSamples, kCaptureRingChunks),
+      tap_input_device_(kAudioObjectUnknown),
+      mic_on_tap_(false),
+      tap_delivers_system_(false),
+      tap_sinks_in_flight_(0),
+      aec_pipeline_(&host_clock_, kCaptureRingSamples, kCaptureRingChunks),
+      async_stream_("AsyncAEC", &host_clock_, kCaptureRingSamples, kCaptureRingChunks),
+      mic_feeds_pipeline_(false),
+      tap_feeds_pipeline_(false),
+      sessions_(&NewSessionInput, &host_clock_),
+      render_channels_(1),
+      shadow_aec_(kShadowRingSamples, kShadowRingRecords),
+      probe_position_(0),
+      probe_host_(0),
+      calibration_armed_(false),
+      calibration_capture_host_(0),
+      echo_latency_ms_(0.0),
+      echo_latency_calibrated_(false),
+      paired_latency_version_(UINT64_MAX),
+      paired_path_latency_ms_(0.0),
+      paired_delay_ms_(-1.0) {
     
     std::cout << "✅ AudioCaptureAddon created" << std::endl;
     
-    // Initialize AEC processor
-    AECConfig config;
-    config.enable_aec = true;
-    config.enable_ns = true;
-    config.enable_agc = false;
-    config.frame_duration_ms = 10;
+    device_table_.Start();
+    output_route_.Start();
+    power_monitor_.Start();
+    mic_stream_.SetTalkParty(TalkParty::kLocal);
+    system_stream_.SetTalkParty(TalkParty::kRemote);
+    
+    // Initialize AEC processor from the constructor options
+    AECConfig defaults;
+    defaults.frame_duration_ms = 10;
+    Napi::Value options = info.Length() > 0 ? info[0] : info.Env().Undefined();
+    AECConfig config = ParseAECConfig(options, defaults);
+    
+    // Stereo system audio can be handed over as-is; AEC3 decides whether it
+    // needs both channels
+    if (options.IsObject() && options.As<Napi::Object>().Get("renderChannels").IsNumber()) {
+        render_channels_ = std::clamp(options.As<Napi::Object>().Get("renderChannels").As<Napi::Number>().Int32Value(), 1, 8);
+    }
     
     try {
         aec_processor_ = std::make_unique<AECProcessor>(config);
-        if (aec_processor_->Initialize(48000, 1)) {
+        if (aec_processor_->Initialize(48000, 1, render_channels_)) {
             std::cout << "✅ AEC processor initialized" << std::endl;
         } else {
             std::cerr << "❌ Failed to initialize AEC processor" << std::endl;
@@ -94,507 +777,3618 @@ AudioCaptureAddon::AudioCaptureAddon(const Napi::CallbackInfo& info)
         std::cerr << "❌ Exception initializing AEC: " << e.what() << std::endl;
         aec_processor_.reset();
     }
+    aec_pipeline_.SetShadow(&shadow_aec_);
+    output_route_.SetChangeCallback([this](bool headphones) { OnOutputRouteChanged(headphones); });
+    output_route_.SetPathCallback([this](const OutputRouteInfo& from, const OutputRouteInfo& to) {
+        OnOutputPathChanged(from, to);
+    });
+    power_monitor_.SetChangeCallback([this](bool awake) { OnPowerChanged(awake); });
+    power_monitor_.SetPowerSourceCallback([this](bool) { UpdatePowerProfile(); });
 }
 
 AudioCaptureAddon::~AudioCaptureAddon() {
+    level_meter_.Stop();
+    performance_.Stop(nullptr);
+    sessions_.StopAll();
+    power_monitor_.SetChangeCallback(nullptr);
+    power_monitor_.SetPowerSourceCallback(nullptr);
+    power_monitor_.Stop();
     if (is_capturing_) {
-        StopMicrophoneCapture(Napi::CallbackInfo(Env(), nullptr));
+        TeardownMicrophone();
+    } else {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        ReleaseMicrophone();
+    }
+    if (system_tap_) {
+        system_tap_->Stop();
+        system_tap_.reset();
+    }
+    StopMeetingMonitorTap();
+    StopKeywordSpotterListening();
+    aec_pipeline_.Stop();
+    shadow_aec_.Stop();
+    mic_stream_.Close();
+    system_stream_.Close();
+    async_stream_.Close();
+    device_table_.SetChangeCallback(nullptr);
+    device_table_.Stop();
+    if (devices_tsfn_) {
+        devices_tsfn_.Release();
+    }
+    output_route_.SetChangeCallback(nullptr);
+    output_route_.SetPathCallback(nullptr);
+    output_route_.Stop();
+    if (route_tsfn_) {
+        route_tsfn_.Release();
+    }
+    if (recovery_tsfn_) {
+        recovery_tsfn_.Release();
     }
     aec_processor_.reset();
 }
 
-Napi::Value AudioCaptureAddon::StartMicrophoneCapture(const Napi::CallbackInfo& info) {
-    Napi::Env env = info.Env();
-    
-    if (is_capturing_) {
-        return Napi::Boolean::New(env, false);
+// Channels of every input stream in |list|, in device order
+static UInt32 TotalChannels(const AudioBufferList* list) {
+    UInt32 total = 0;
+    for (UInt32 b = 0; b < list->mNumberBuffers; ++b) {
+        total += std::max<UInt32>(1, list->mBuffers[b].mNumberChannels);
     }
-    
-    // Get callback function
-    if (info.Length() < 1 || !info[0].IsFunction()) {
-        Napi::Error::New(env, "Callback function required").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
+    return total;
+}
+
+// Where device channel |channel| of |list| lives: its stream's samples,
+// channels per frame and position in the frame. False past the last channel
+// or for a buffer shorter than |frames|.
+static bool LocateChannel(const AudioBufferList* list, UInt32 channel, UInt32 frames, const float** data,
+                          int* width, int* index) {
+    UInt32 base = 0;
+    for (UInt32 b = 0; b < list->mNumberBuffers; ++b) {
+        const AudioBuffer& buffer = list->mBuffers[b];
+        UInt32 channels = std::max<UInt32>(1, buffer.mNumberChannels);
+        if (channel < base + channels) {
+            if (!buffer.mData || buffer.mDataByteSize < frames * channels * sizeof(float)) {
+                return false;
+            }
+            *data = static_cast<const float*>(buffer.mData);
+            *width = static_cast<int>(channels);
+            *index = static_cast<int>(channel - base);
+            return true;
+        }
+        base += channels;
     }
-    
-    Napi::Function callback = info[0].As<Napi::Function>();
-    
-    // Create ThreadSafeFunction
-    tsfn_ = Napi::ThreadSafeFunction::New(
-        env,
-        callback,
-        "MicrophoneCapture",
-        0,
-        1);
-    
-    std::cout << "🎤 Starting AUHAL microphone capture (Granola pattern)..." << std::endl;
-    
-    OSStatus status;
-    
-    // Get default input device
-    AudioObjectPropertyAddress propertyAddress = {
-        kAudioHardwarePropertyDefaultInputDevice,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
-    
-    UInt32 deviceSize = sizeof(device_id_);
-    status = AudioObjectGetPropertyData(
-        kAudioObjectSystemObject,
-        &propertyAddress,
-        0,
-        nullptr,
-        &deviceSize,
-        &device_id_);
-    
-    if (status != noErr || device_id_ == kAudioObjectUnknown) {
-        Napi::Error::New(env, "Failed to get default input device").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
+    return false;
+}
+
+// Mean of the device channels in |channels| (all when empty), numbered
+// across the streams of |list|, into mono |dst|. Channels past the device's
+// last are left out; with none left |dst| is silence. Real-time safe.
+static void MixInputChannels(const AudioBufferList* list, UInt32 frames, const std::vector<int>& channels,
+                             float* dst) {
+    std::fill(dst, dst + frames, 0.0f);
+    UInt32 total = TotalChannels(list);
+    size_t count = 0;
+    for (int channel : channels) {
+        count += static_cast<UInt32>(channel) < total ? 1 : 0;
     }
-    
-    // Get device name for logging
-    CFStringRef deviceName = nullptr;
-    AudioObjectPropertyAddress nameAddress = {
-        kAudioDevicePropertyDeviceNameCFString,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
+    if (channels.empty()) {
+        count = total;
+    }
+    if (count == 0) {
+        return;
+    }
+    const float gain = 1.0f / static_cast<float>(count);
+    auto add = [&](UInt32 channel) {
+        const float* data;
+        int width;
+        int index;
+        if (LocateChannel(list, channel, frames, &data, &width, &index)) {
+            dsp::AddChannel(data, frames, width, index, gain, dst);
+        }
     };
-    
-    UInt32 nameSize = sizeof(deviceName);
-    status = AudioObjectGetPropertyData(device_id_, &nameAddress, 0, nullptr, &nameSize, &deviceName);
-    
-    if (status == noErr && deviceName) {
-        char name[256];
-        CFStringGetCString(deviceName, name, sizeof(name), kCFStringEncodingUTF8);
-        std::cout << "✅ Using default input device: " << device_id_ << " (" << name << ")" << std::endl;
-        CFRelease(deviceName);
+    if (channels.empty()) {
+        for (UInt32 channel = 0; channel < total; ++channel) {
+            add(channel);
+        }
+    } else {
+        for (int channel : channels) {
+            if (static_cast<UInt32>(channel) < total) {
+                add(static_cast<UInt32>(channel));
+            }
+        }
+    }
+}
+
+// The beam over the selected channels (all when empty; the first
+// kMaxChannels that exist) into mono |dst|. False, with |dst| untouched,
+// when fewer than two exist. Real-time safe.
+static bool BeamformInputChannels(const AudioBufferList* list, UInt32 frames, const std::vector<int>& channels,
+                                  DelayAndSumBeamformer* beamformer, float* dst) {
+    UInt32 selected[DelayAndSumBeamformer::kMaxChannels];
+    int count = 0;
+    UInt32 total = TotalChannels(list);
+    if (channels.empty()) {
+        for (UInt32 channel = 0; channel < total && count < DelayAndSumBeamformer::kMaxChannels; ++channel) {
+            selected[count++] = channel;
+        }
     } else {
-        std::cout << "✅ Using default input device: " << device_id_ << std::endl;
+        for (int channel : channels) {
+            if (static_cast<UInt32>(channel) < total && count < DelayAndSumBeamformer::kMaxChannels) {
+                selected[count++] = static_cast<UInt32>(channel);
+            }
+        }
+    }
+    if (count < 2) {
+        return false;
     }
     
-    // STEP 1: Find HALOutput AudioComponent
-    AudioComponentDescription desc;
-    desc.componentType = kAudioUnitType_Output;
-    desc.componentSubType = kAudioUnitSubType_HALOutput;
-    desc.componentManufacturer = kAudioUnitManufacturer_Apple;
-    desc.componentFlags = 0;
-    desc.componentFlagsMask = 0;
+    for (UInt32 offset = 0; offset < frames; offset += DelayAndSumBeamformer::kMaxBlock) {
+        UInt32 length = std::min<UInt32>(DelayAndSumBeamformer::kMaxBlock, frames - offset);
+        for (int i = 0; i < count; ++i) {
+            const float* data;
+            int width;
+            int index;
+            float* input = beamformer->Input(i);
+            if (LocateChannel(list, selected[i], frames, &data, &width, &index)) {
+                dsp::Deinterleave(data + static_cast<size_t>(offset) * width, length, width, index, input);
+            } else {
+                std::fill(input, input + length, 0.0f);
+            }
+        }
+        beamformer->Process(count, length, dst + offset);
+    }
+    return true;
+}
+
+// Runs on the CoreAudio real-time thread: no allocation, no locks, no JS.
+OSStatus AudioCaptureAddon::MicIOProc(AudioDeviceID inDevice,
+                                      const AudioTimeStamp* inNow,
+                                      const AudioBufferList* inInputData,
+                                      const AudioTimeStamp* inInputTime,
+                                      AudioBufferList* outOutputData,
+                                      const AudioTimeStamp* inOutputTime,
+                                      void* inClientData) {
+    AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(inClientData);
     
-    AudioComponent component = AudioComponentFindNext(nullptr, &desc);
-    if (!component) {
-        Napi::Error::New(env, "Failed to find HALOutput AudioComponent").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
+    // Safety checks
+    if (!self || !self->is_capturing_.load(std::memory_order_acquire) ||
+        !inInputData || inInputData->mNumberBuffers == 0) {
+        return noErr;
     }
-    std::cout << "✅ Step 1: Found HALOutput AudioComponent" << std::endl;
     
-    // STEP 2: Create AudioUnit instance
-    status = AudioComponentInstanceNew(component, &mic_audio_unit_);
-    if (status != noErr) {
-        Napi::Error::New(env, "Failed to create AudioUnit instance").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
+    const AudioBuffer& buffer = inInputData->mBuffers[0];
+    if (!buffer.mData || buffer.mDataByteSize == 0) {
+        return noErr;
     }
-    std::cout << "✅ Step 2: Created AudioUnit instance" << std::endl;
     
-    // STEP 3: Enable INPUT (bus 1), DISABLE OUTPUT (bus 0)
-    UInt32 enableIO = 1;
-    status = AudioUnitSetProperty(
-        mic_audio_unit_,
-        kAudioOutputUnitProperty_EnableIO,
-        kAudioUnitScope_Input,
-        1,
-        &enableIO,
-        sizeof(enableIO));
+    // A HAL IOProc sees the device's own format: its nominal rate, and one
+    // buffer of interleaved frames per input stream
+    const float* audioData = static_cast<const float*>(buffer.mData);
+    const UInt32 channels = std::max<UInt32>(1, buffer.mNumberChannels);
+    UInt32 numSamples = buffer.mDataByteSize / (sizeof(float) * channels);
+    TraceScope trace(TraceEvent::kMicIOProc, numSamples);
     
-    if (status != noErr) {
-        AudioComponentInstanceDispose(mic_audio_unit_);
-        Napi::Error::New(env, "Failed to enable input").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
-    }
-    std::cout << "✅ Step 3: Enabled INPUT on bus 1" << std::endl;
+    CaptureStats& stats = self->mic_stream_.Stats();
+    const uint64_t callbackStart = HostTimeNow();
     
-    enableIO = 0;
-    status = AudioUnitSetProperty(
-        mic_audio_unit_,
-        kAudioOutputUnitProperty_EnableIO,
-        kAudioUnitScope_Output,
-        0,
-        &enableIO,
-        sizeof(enableIO));
+    // Sanity check
+    if (numSamples == 0 || numSamples > kMaxSamplesPerCallback) {
+        stats.buffers_oversized.fetch_add(1, std::memory_order_relaxed);
+        return noErr;
+    }
+    // When the first sample hit the ADC, as reported by CoreAudio
+    uint64_t hostTime = (inInputTime && (inInputTime->mFlags & kAudioTimeStampHostTimeValid))
+        ? inInputTime->mHostTime
+        : callbackStart;
     
-    if (status != noErr) {
-        AudioComponentInstanceDispose(mic_audio_unit_);
-        Napi::Error::New(env, "Failed to disable output").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
+    // Only the selected channels go on; the streams' other channels are
+    // never copied
+    stats.device_channels.store(TotalChannels(inInputData), std::memory_order_relaxed);
+    DelayAndSumBeamformer* beamformer = self->beamformer_.get();
+    if (beamformer && BeamformInputChannels(inInputData, numSamples, self->mic_channels_, beamformer,
+                                            self->mic_downmix_.data())) {
+        audioData = self->mic_downmix_.data();
+        // The beam runs Latency() behind its input
+        uint64_t delay = self->beam_latency_ticks_;
+        hostTime = hostTime > delay ? hostTime - delay : hostTime;
+    } else if (!self->mic_channels_.empty() || inInputData->mNumberBuffers > 1) {
+        MixInputChannels(inInputData, numSamples, self->mic_channels_, self->mic_downmix_.data());
+        audioData = self->mic_downmix_.data();
+    } else if (channels > 1) {
+        dsp::Downmix(audioData, numSamples, static_cast<int>(channels), self->mic_downmix_.data());
+        audioData = self->mic_downmix_.data();
     }
-    std::cout << "✅ Step 4: Disabled OUTPUT on bus 0" << std::endl;
     
-    // STEP 5: Set input device
-    status = AudioUnitSetProperty(
-        mic_audio_unit_,
-        kAudioOutputUnitProperty_CurrentDevice,
-        kAudioUnitScope_Global,
-        0,
-        &device_id_,
-        sizeof(device_id_));
+    self->DeliverMicrophone(audioData, numSamples, hostTime);
     
-    if (status != noErr) {
-        AudioComponentInstanceDispose(mic_audio_unit_);
-        std::cerr << "❌ Failed to set input device, error: " << status << std::endl;
-        Napi::Error::New(env, "Failed to set input device").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
+    stats.RecordCallback(callbackStart, HostTimeNow());
+    return noErr;
+}
+
+// Real-time thread of an AUHAL or VoiceProcessingIO unit: the mic is pulled
+// from the input element into unit_buffer_, already converted to the mono
+// float format set on it
+OSStatus AudioCaptureAddon::UnitInputProc(void* inRefCon,
+                                          AudioUnitRenderActionFlags* ioActionFlags,
+                                          const AudioTimeStamp* inTimeStamp,
+                                          UInt32 inBusNumber,
+                                          UInt32 inNumberFrames,
+                                          AudioBufferList* ioData) {
+    AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(inRefCon);
+    if (!self || !self->is_capturing_.load(std::memory_order_acquire) || !self->mic_audio_unit_) {
+        return noErr;
+    }
+    TraceScope trace(TraceEvent::kMicIOProc, inNumberFrames);
+    CaptureStats& stats = self->mic_stream_.Stats();
+    const uint64_t callbackStart = HostTimeNow();
+    if (inNumberFrames == 0 || inNumberFrames > kMaxSamplesPerCallback) {
+        stats.buffers_oversized.fetch_add(1, std::memory_order_relaxed);
+        return noErr;
     }
-    std::cout << "✅ Step 5: Set device to " << device_id_ << std::endl;
     
-    // STEP 6: Set format on INPUT bus
-    AudioStreamBasicDescription format;
-    format.mSampleRate = 48000.0;
-    format.mFormatID = kAudioFormatLinearPCM;
-    format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked | kAudioFormatFlagIsNonInterleaved;
-    format.mBytesPerPacket = sizeof(float);
-    format.mFramesPerPacket = 1;
-    format.mBytesPerFrame = sizeof(float);
-    format.mChannelsPerFrame = 1;
-    format.mBitsPerChannel = 32;
-    format.mReserved = 0;
+    AudioBufferList list;
+    list.mNumberBuffers = 1;
+    list.mBuffers[0].mNumberChannels = 1;
+    list.mBuffers[0].mDataByteSize = inNumberFrames * sizeof(float);
+    list.mBuffers[0].mData = self->unit_buffer_.data();
+    OSStatus status = AudioUnitRender(self->mic_audio_unit_, ioActionFlags, inTimeStamp, inBusNumber,
+                                      inNumberFrames, &list);
+    if (status != noErr) {
+        return status;
+    }
     
-    status = AudioUnitSetProperty(
-        mic_audio_unit_,
-        kAudioUnitProperty_StreamFormat,
-        kAudioUnitScope_Output,
+    uint64_t hostTime = (inTimeStamp && (inTimeStamp->mFlags & kAudioTimeStampHostTimeValid))
+        ? inTimeStamp->mHostTime
+        : callbackStart;
+    self->DeliverMicrophone(self->unit_buffer_.data(), inNumberFrames, hostTime);
+    stats.RecordCallback(callbackStart, HostTimeNow());
+    return noErr;
+}
+
+// The app plays nothing through the voice unit; its output element only has
+// to run for the system to process the input
+OSStatus AudioCaptureAddon::VoiceRenderSilence(void* inRefCon,
+                                               AudioUnitRenderActionFlags* ioActionFlags,
+                                               const AudioTimeStamp* inTimeStamp,
+                                               UInt32 inBusNumber,
+                                               UInt32 inNumberFrames,
+                                               AudioBufferList* ioData) {
+    for (UInt32 i = 0; ioData && i < ioData->mNumberBuffers; ++i) {
+        std::memset(ioData->mBuffers[i].mData, 0, ioData->mBuffers[i].mDataByteSize);
+    }
+    *ioActionFlags |= kAudioUnitRenderAction_OutputIsSilence;
+    return noErr;
+}
+
+// Real-time thread of whichever IOProc carries the mic
+void AudioCaptureAddon::DeliverMicrophone(const float* data, uint32_t num_samples, uint64_t host_time) {
+    // calibrate() wants the mic as it hit the ADC, ahead of any AEC
+    if (calibration_armed_.load(std::memory_order_acquire)) {
+        if (calibration_capture_host_.load(std::memory_order_relaxed) == 0) {
+            calibration_capture_host_.store(host_time, std::memory_order_relaxed);
+        }
+        calibration_ring_->Write(data, num_samples);
+    }
+    RecordSamples(RecordTrack::kMicrophone, this, data, num_samples, static_cast<int>(mic_sample_rate_));
+    CaptureSessionBuffer(SessionStream::kMicrophone, this, data, num_samples, static_cast<int>(mic_sample_rate_),
+                         host_time);
+    // In processed mode the DSP thread owns mic_stream_'s producer side
+    if (mic_feeds_pipeline_.load(std::memory_order_acquire)) {
+        if (!aec_pipeline_.PushCapture(data, num_samples, host_time)) {
+            mic_stream_.Stats().buffers_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        mic_stream_.PushFromRealtime(data, num_samples, host_time);
+    }
+}
+
+// Runs on the tap's real-time thread; frames are already mono float
+void AudioCaptureAddon::SystemAudioSink(void* context, const float* data, uint32_t num_samples,
+                                        uint64_t host_time) {
+    AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(context);
+    self->tap_sinks_in_flight_.fetch_add(1);
+    if (self->tap_delivers_system_.load()) {
+        RecordSamples(RecordTrack::kSystem, self, data, num_samples, static_cast<int>(self->system_tap_->SampleRate()));
+        CaptureSessionBuffer(SessionStream::kSystem, self, data, num_samples,
+                             static_cast<int>(self->system_tap_->SampleRate()), host_time);
+        self->system_stream_.PushFromRealtime(data, num_samples, host_time);
+        if (self->tap_feeds_pipeline_.load(std::memory_order_acquire)) {
+            self->aec_pipeline_.PushRender(data, num_samples, 1, host_time);
+        }
+    }
+    self->tap_sinks_in_flight_.fetch_sub(1);
+}
+
+// Tap real-time thread, shared clock: the mic's frames from the aggregate,
+// stamped with the tap buffer's time
+void AudioCaptureAddon::TapMicrophoneSink(void* context, const float* data, uint32_t num_samples,
+                                          uint64_t host_time) {
+    AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(context);
+    self->tap_sinks_in_flight_.fetch_add(1);
+    if (self->mic_on_tap_.load() && self->is_capturing_.load() && !self->mic_paused_.load()) {
+        TraceScope trace(TraceEvent::kMicIOProc, num_samples);
+        const uint64_t callbackStart = HostTimeNow();
+        self->DeliverMicrophone(data, num_samples, host_time);
+        self->mic_stream_.Stats().RecordCallback(callbackStart, HostTimeNow());
+    }
+    self->tap_sinks_in_flight_.fetch_sub(1);
+}
+
+// Once the flags a sink checks are cleared, waits out a sink already past
+// them; the tap's IOProc is short, so this spins at most one callback
+void AudioCaptureAddon::QuiesceTapSinks() const {
+    while (tap_sinks_in_flight_.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+// JS thread: drops a tap that only stayed up for the shared-clock mic
+void AudioCaptureAddon::ReleaseIdleTap() {
+    if (system_tap_ && !system_stream_.IsOpen()) {
+        system_tap_->Stop();
+        system_tap_.reset();
+        tap_input_device_ = kAudioObjectUnknown;
+        std::cout << "✅ Shared-clock tap released" << std::endl;
+    }
+}
+
+static const AudioObjectPropertyAddress kDefaultInputAddress = {
+    kAudioHardwarePropertyDefaultInputDevice,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+static const AudioObjectPropertyAddress kOverloadAddress = {
+    kAudioDeviceProcessorOverload,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+static const AudioObjectPropertyAddress kAliveAddress = {
+    kAudioDevicePropertyDeviceIsAlive,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+static const AudioObjectPropertyAddress kDevicesAddress = {
+    kAudioHardwarePropertyDevices,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+// False once |device| died, or was removed outright
+static bool DeviceIsAlive(AudioDeviceID device) {
+    UInt32 alive = 0;
+    UInt32 size = sizeof(alive);
+    return device != kAudioObjectUnknown &&
+           AudioObjectGetPropertyData(device, &kAliveAddress, 0, nullptr, &size, &alive) == noErr && alive != 0;
+}
+
+static AudioDeviceID GetDefaultInputDevice() {
+    AudioDeviceID device = kAudioObjectUnknown;
+    UInt32 size = sizeof(device);
+    AudioObjectGetPropertyData(kAudioObjectSystemObject, &kDefaultInputAddress, 0, nullptr, &size, &device);
+    return device;
+}
+
+// True when |device| exists and exposes at least one input stream
+static bool DeviceHasInput(AudioDeviceID device) {
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyStreams,
+        kAudioDevicePropertyScopeInput,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 size = 0;
+    return AudioObjectGetPropertyDataSize(device, &address, 0, nullptr, &size) == noErr && size > 0;
+}
+
+// 0 when the HAL does not report one
+static double GetNominalSampleRate(AudioDeviceID device) {
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyNominalSampleRate,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    Float64 rate = 0.0;
+    UInt32 size = sizeof(rate);
+    if (device == kAudioObjectUnknown ||
+        AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &rate) != noErr || rate <= 0.0) {
+        return 0.0;
+    }
+    return rate;
+}
+
+// A startSession() device: its own IOProc on the HAL device, the first
+// input stream downmixed, at the device's nominal rate
+class HalSessionInput : public SessionInput {
+public:
+    HalSessionInput() : downmix_(kMaxSamplesPerCallback) {}
+
+    bool Start(const std::string& device_id, RealtimeSink sink, void* context, std::string* error) override {
+        device_ = GetDefaultInputDevice();
+        if (!device_id.empty()) {
+            device_ = device_id.find_first_not_of("0123456789") == std::string::npos
+                ? static_cast<AudioDeviceID>(std::stoul(device_id)) : kAudioObjectUnknown;
+        }
+        if (device_ == kAudioObjectUnknown || !DeviceHasInput(device_)) {
+            *error = "Unknown input device: " + (device_id.empty() ? std::string("default") : device_id);
+            return false;
+        }
+        sample_rate_ = GetNominalSampleRate(device_);
+        if (sample_rate_ <= 0.0) {
+            *error = "Input device reports no sample rate";
+            return false;
+        }
+        sink_ = sink;
+        context_ = context;
+        OSStatus status = AudioDeviceCreateIOProcID(device_, &HalSessionInput::IOProc, this, &proc_);
+        if (status == noErr) {
+            status = AudioDeviceStart(device_, proc_);
+            if (status != noErr) {
+                AudioDeviceDestroyIOProcID(device_, proc_);
+            }
+        }
+        if (status != noErr) {
+            proc_ = nullptr;
+            *error = "Failed to start input device (OSStatus " + std::to_string(status) + ")";
+            return false;
+        }
+        return true;
+    }
+
+    void Stop() override {
+        if (proc_) {
+            AudioDeviceStop(device_, proc_);
+            AudioDeviceDestroyIOProcID(device_, proc_);
+            proc_ = nullptr;
+        }
+    }
+
+    double SampleRate() const override { return sample_rate_; }
+
+private:
+    static OSStatus IOProc(AudioDeviceID, const AudioTimeStamp*, const AudioBufferList* input,
+                           const AudioTimeStamp* input_time, AudioBufferList*, const AudioTimeStamp*, void* client) {
+        HalSessionInput* self = static_cast<HalSessionInput*>(client);
+        if (!input || input->mNumberBuffers == 0 || !input->mBuffers[0].mData) {
+            return noErr;
+        }
+        const AudioBuffer& buffer = input->mBuffers[0];
+        const UInt32 channels = std::max<UInt32>(1, buffer.mNumberChannels);
+        UInt32 num_samples = buffer.mDataByteSize / (sizeof(float) * channels);
+        if (num_samples == 0 || num_samples > kMaxSamplesPerCallback) {
+            return noErr;
+        }
+        const float* data = static_cast<const float*>(buffer.mData);
+        if (channels > 1) {
+            dsp::Downmix(data, num_samples, static_cast<int>(channels), self->downmix_.data());
+            data = self->downmix_.data();
+        }
+        uint64_t host_time = (input_time && (input_time->mFlags & kAudioTimeStampHostTimeValid))
+            ? input_time->mHostTime : HostTimeNow();
+        self->sink_(self->context_, data, num_samples, host_time);
+        return noErr;
+    }
+
+    AudioDeviceID device_ = kAudioObjectUnknown;
+    AudioDeviceIOProcID proc_ = nullptr;
+    double sample_rate_ = 0.0;
+    RealtimeSink sink_ = nullptr;
+    void* context_ = nullptr;
+    std::vector<float> downmix_;
+};
+
+static std::unique_ptr<SessionInput> NewSessionInput() {
+    return std::make_unique<HalSessionInput>();
+}
+
+// Bluetooth headset mics only run in the hands-free profile, which carries
+// wideband speech at 16kHz (24kHz on some); 48kHz is A2DP, output-only
+static constexpr double kMaxHandsFreeRate = 24000.0;
+
+static bool IsBluetoothHandsFree(AudioDeviceID device, double rate) {
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyTransportType,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 transport = 0;
+    UInt32 size = sizeof(transport);
+    if (device == kAudioObjectUnknown ||
+        AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &transport) != noErr) {
+        return false;
+    }
+    return (transport == kAudioDeviceTransportTypeBluetooth || transport == kAudioDeviceTransportTypeBluetoothLE) &&
+           rate > 0.0 && rate <= kMaxHandsFreeRate;
+}
+
+static UInt32 GetBufferFrameSize(AudioDeviceID device) {
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyBufferFrameSize,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 frames = 0;
+    UInt32 size = sizeof(frames);
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &frames) != noErr) {
+        return 0;
+    }
+    return frames;
+}
+
+// Asks |device| for IO buffers of |frames|, clamped to its buffer size range.
+// The setting lasts for this process only. Returns the size in effect after.
+static UInt32 RequestBufferFrameSize(AudioDeviceID device, UInt32 frames) {
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyBufferFrameSizeRange,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    AudioValueRange range = {};
+    UInt32 size = sizeof(range);
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &range) == noErr && range.mMaximum > 0.0) {
+        frames = static_cast<UInt32>(std::clamp(static_cast<Float64>(frames), range.mMinimum, range.mMaximum));
+    }
+
+    address.mSelector = kAudioDevicePropertyBufferFrameSize;
+    OSStatus status = AudioObjectSetPropertyData(device, &address, 0, nullptr, sizeof(frames), &frames);
+    if (status != noErr) {
+        Log(LogLevel::kWarn, kLogSource, "Device %u refused a %u-frame IO buffer, error: %d",
+            static_cast<unsigned>(device), static_cast<unsigned>(frames), static_cast<int>(status));
+    }
+    return GetBufferFrameSize(device);
+}
+
+// Workgroup of |device|'s IO thread, for worker threads paced by it
+static AudioWorkgroup GetIoWorkgroup(AudioObjectID device) {
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyIOThreadOSWorkgroup,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    os_workgroup_t workgroup = nullptr;
+    UInt32 size = sizeof(workgroup);
+    if (device == kAudioObjectUnknown ||
+        AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &workgroup) != noErr || !workgroup) {
+        return AudioWorkgroup();
+    }
+    return AudioWorkgroup::Adopt(workgroup);
+}
+
+// One direction's share of the render->capture delay, from |device|'s HAL
+// properties in |scope|
+struct DeviceLatency {
+    double device_ms = 0.0;  // kAudioDevicePropertyLatency
+    double safety_ms = 0.0;  // kAudioDevicePropertySafetyOffset
+    double stream_ms = 0.0;  // the first stream's kAudioStreamPropertyLatency
+    double buffer_ms = 0.0;  // one IO buffer
+    
+    double TotalMs() const { return device_ms + safety_ms + stream_ms + buffer_ms; }
+};
+
+static DeviceLatency GetDeviceLatency(AudioDeviceID device, AudioObjectPropertyScope scope) {
+    DeviceLatency latency;
+    double rate = device != kAudioObjectUnknown ? GetNominalSampleRate(device) : 0.0;
+    if (rate <= 0.0) {
+        return latency;
+    }
+    auto read = [&](AudioObjectID object, AudioObjectPropertySelector selector, AudioObjectPropertyScope in) {
+        AudioObjectPropertyAddress address = { selector, in, kAudioObjectPropertyElementMain };
+        UInt32 value = 0;
+        UInt32 size = sizeof(value);
+        return AudioObjectGetPropertyData(object, &address, 0, nullptr, &size, &value) == noErr
+            ? value * 1000.0 / rate : 0.0;
+    };
+    latency.device_ms = read(device, kAudioDevicePropertyLatency, scope);
+    latency.safety_ms = read(device, kAudioDevicePropertySafetyOffset, scope);
+    latency.buffer_ms = read(device, kAudioDevicePropertyBufferFrameSize, scope);
+    
+    AudioObjectPropertyAddress address = { kAudioDevicePropertyStreams, scope, kAudioObjectPropertyElementMain };
+    AudioStreamID stream = kAudioObjectUnknown;
+    UInt32 size = sizeof(stream);
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &stream) == noErr &&
+        stream != kAudioObjectUnknown) {
+        latency.stream_ms = read(stream, kAudioStreamPropertyLatency, kAudioObjectPropertyScopeGlobal);
+    }
+    return latency;
+}
+
+static AudioDeviceID GetDefaultOutputDevice() {
+    AudioObjectPropertyAddress address = {
+        kAudioHardwarePropertyDefaultOutputDevice,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    AudioDeviceID device = kAudioObjectUnknown;
+    UInt32 size = sizeof(device);
+    AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, &device);
+    return device;
+}
+
+// The hardware part of the echo delay: render leaves through the default
+// output's playback latency, and its echo is stamped at capture one input
+// latency after reaching the mic. Added to the measured render->capture
+// lead, it leaves AEC3's delay search only the acoustic path to find.
+struct EchoPathLatency {
+    DeviceLatency output;
+    DeviceLatency input;
+    
+    double TotalMs() const { return output.TotalMs() + input.TotalMs(); }
+};
+
+static EchoPathLatency GetEchoPathLatency(AudioDeviceID input) {
+    EchoPathLatency latency;
+    latency.output = GetDeviceLatency(GetDefaultOutputDevice(), kAudioDevicePropertyScopeOutput);
+    latency.input = GetDeviceLatency(input, kAudioDevicePropertyScopeInput);
+    return latency;
+}
+
+// Selected device when set and still present, otherwise the system default
+AudioDeviceID AudioCaptureAddon::ResolveInputDevice() const {
+    if (!selected_device_id_.empty()) {
+        AudioDeviceID selected = static_cast<AudioDeviceID>(std::stoul(selected_device_id_));
+        if (DeviceHasInput(selected)) {
+            return selected;
+        }
+        Log(LogLevel::kWarn, kLogSource, "Selected input device %s unavailable, using default", selected_device_id_.c_str());
+    }
+    return GetDefaultInputDevice();
+}
+
+// Moves the IOProc to |newDevice| while the stream, AEC and TSFN stay alive.
+// The old IOProc is fully stopped before the new one starts, so the ring keeps
+// a single producer; the sample counter runs on across the switch.
+bool AudioCaptureAddon::SwitchInputDevice(AudioDeviceID newDevice) {
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    
+    if (!is_capturing_ || newDevice == kAudioObjectUnknown || newDevice == device_id_) {
+        return true;
+    }
+    if (mic_on_tap_) {
+        Log(LogLevel::kWarn, kLogSource, "Microphone shares the tap clock; restart capture to use device %u",
+            static_cast<unsigned>(newDevice));
+        return false;
+    }
+    if (mic_engine_ != MicEngine::kHal) {
+        Log(LogLevel::kWarn, kLogSource, "The %s engine is bound to its device; restart capture to use device %u",
+            MicEngineName(mic_engine_), static_cast<unsigned>(newDevice));
+        return false;
+    }
+    // The stream and pipeline were opened for the current device's rate
+    double newRate = GetNominalSampleRate(newDevice);
+    if (newRate > 0.0 && newRate != mic_sample_rate_) {
+        Log(LogLevel::kWarn, kLogSource, "Device %u runs at %.0fHz, capture at %.0fHz; restart capture to use it",
+            static_cast<unsigned>(newDevice), newRate, mic_sample_rate_);
+        return false;
+    }
+    
+    AudioDeviceID oldDevice = device_id_;
+    WatchInputDevice(oldDevice, false);
+    if (io_proc_id_ != nullptr) {
+        AudioDeviceStop(oldDevice, io_proc_id_);
+        AudioDeviceDestroyIOProcID(oldDevice, io_proc_id_);
+        io_proc_id_ = nullptr;
+    }
+    
+    AudioDeviceIOProcID newProc = nullptr;
+    OSStatus status = AudioDeviceCreateIOProcID(newDevice, &AudioCaptureAddon::MicIOProc, this, &newProc);
+    // A paused mic moves without starting; resume starts it on the new device
+    if (status == noErr && !mic_paused_) {
+        status = AudioDeviceStart(newDevice, newProc);
+        if (status != noErr) {
+            AudioDeviceDestroyIOProcID(newDevice, newProc);
+        }
+    }
+    
+    if (status != noErr) {
+        Log(LogLevel::kError, kLogSource, "Failed to move capture to device %u, error: %d",
+            static_cast<unsigned>(newDevice), static_cast<int>(status));
+        // Fall back to the previous device so capture keeps running
+        if (AudioDeviceCreateIOProcID(oldDevice, &AudioCaptureAddon::MicIOProc, this, &io_proc_id_) == noErr &&
+            !mic_paused_ && AudioDeviceStart(oldDevice, io_proc_id_) != noErr) {
+            AudioDeviceDestroyIOProcID(oldDevice, io_proc_id_);
+            io_proc_id_ = nullptr;
+        }
+        WatchInputDevice(oldDevice, true);
+        return false;
+    }
+    
+    device_id_ = newDevice;
+    io_proc_id_ = newProc;
+    WatchInputDevice(device_id_, true);
+    CaptureSessionEvent(SessionStream::kMicrophone, SessionEventType::kDevice, std::to_string(newDevice).c_str());
+    
+    // The requested IO buffer follows the mic to its new device
+    RestoreIoBuffer(oldDevice);
+    if (io_buffer_request_ != 0) {
+        io_buffer_restore_ = GetBufferFrameSize(device_id_);
+        RequestBufferFrameSize(device_id_, io_buffer_request_);
+    }
+    mic_stream_.Stats().io_buffer_frames.store(GetBufferFrameSize(device_id_), std::memory_order_relaxed);
+    if (mic_feeds_pipeline_) {
+        aec_pipeline_.SetWorkgroup(GetIoWorkgroup(device_id_));
+        ApplyEchoPathLatency(device_id_);
+    }
+    
+    // Keep the AUHAL pointed at the live device
+    if (mic_audio_unit_) {
+        AudioUnitUninitialize(mic_audio_unit_);
+        AudioUnitSetProperty(mic_audio_unit_, kAudioOutputUnitProperty_CurrentDevice,
+                             kAudioUnitScope_Global, 0, &device_id_, sizeof(device_id_));
+        AudioUnitInitialize(mic_audio_unit_);
+    }
+    
+    Log(LogLevel::kInfo, kLogSource, "Microphone capture moved from device %u to %u",
+        static_cast<unsigned>(oldDevice), static_cast<unsigned>(newDevice));
+    AudioDeviceID output = output_route_.Current().device;
+    ResetEchoPathFor(oldDevice, output, newDevice, output, EchoPathChange::kInputDevice);
+    if (mic_gap_host_ != 0) {
+        FinishMicrophoneGap();
+    }
+    return true;
+}
+
+// Processor overloads and death of the capturing device
+void AudioCaptureAddon::WatchInputDevice(AudioDeviceID device, bool watch) {
+    if (watch) {
+        AudioObjectAddPropertyListener(device, &kOverloadAddress, &AudioCaptureAddon::MicOverload, this);
+        AudioObjectAddPropertyListener(device, &kAliveAddress, &AudioCaptureAddon::InputDevicesChanged, this);
+    } else {
+        AudioObjectRemovePropertyListener(device, &kOverloadAddress, &AudioCaptureAddon::MicOverload, this);
+        AudioObjectRemovePropertyListener(device, &kAliveAddress, &AudioCaptureAddon::InputDevicesChanged, this);
+    }
+}
+
+// Call with device_mutex_ held, once the device's IO has stopped on its own
+// (or been stopped for sleep). The stream pauses at the last callback and,
+// when audio returns, delivers a silence marker for the time in between;
+// the DSP thread drops render it has no capture for.
+void AudioCaptureAddon::MarkMicrophoneGap(const char* reason) {
+    if (!is_capturing_ || mic_on_tap_ || mic_paused_ || mic_gap_host_ != 0) {
+        return;
+    }
+    mic_gap_host_ = HostTimeNow();
+    mic_gap_reason_ = reason;
+    mic_stream_.MarkGap();
+    CaptureSessionEvent(SessionStream::kMicrophone, SessionEventType::kGap, reason);
+    if (mic_feeds_pipeline_) {
+        aec_pipeline_.SetCapturePaused(true);
+    }
+    Log(LogLevel::kWarn, kLogSource, "Microphone capture interrupted (%s) on device %u", reason,
+        static_cast<unsigned>(device_id_));
+}
+
+// HAL listener thread or the power queue, with a gap marked. Capture resumes
+// on the device it should follow now: the same one restarted when it is
+// still (or again) there, otherwise the new one. With no input left at all
+// the gap stays open and the next device change tries again.
+void AudioCaptureAddon::RecoverMicrophone() {
+    AudioDeviceID target;
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        if (!is_capturing_ || mic_gap_host_ == 0) {
+            return;
+        }
+        target = ResolveInputDevice();
+        if (target == kAudioObjectUnknown) {
+            return;
+        }
+        if (target == device_id_) {
+            if (!mic_paused_ && MicIOReady()) {
+                StopMicIO();
+                OSStatus status = StartMicIO();
+                if (status != noErr) {
+                    Log(LogLevel::kError, kLogSource, "Failed to restart device %u, error: %d",
+                        static_cast<unsigned>(device_id_), static_cast<int>(status));
+                    return;
+                }
+            }
+            FinishMicrophoneGap();
+            return;
+        }
+    }
+    SwitchInputDevice(target);
+}
+
+// Call with device_mutex_ held, once capture runs again
+void AudioCaptureAddon::FinishMicrophoneGap() {
+    double gap_ms = host_clock_.TicksToMs(HostTimeNow() - mic_gap_host_);
+    std::string reason = mic_gap_reason_;
+    mic_gap_host_ = 0;
+    if (mic_feeds_pipeline_ && !mic_paused_) {
+        aec_pipeline_.SetCapturePaused(false);
+    }
+    Log(LogLevel::kInfo, kLogSource, "Microphone capture recovered on device %u after %.0fms (%s)",
+        static_cast<unsigned>(device_id_), gap_ms, reason.c_str());
+    
+    if (recovery_tsfn_ready_.load(std::memory_order_acquire)) {
+        std::string device = std::to_string(device_id_);
+        recovery_tsfn_.NonBlockingCall([this, reason, gap_ms, device](Napi::Env env, Napi::Function) {
+            if (recovery_callback_.IsEmpty()) {
+                return;
+            }
+            Napi::Object event = Napi::Object::New(env);
+            event.Set("reason", reason);
+            event.Set("gapMs", gap_ms);
+            event.Set("deviceId", device);
+            try {
+                recovery_callback_.Call({ event });
+            } catch (...) {
+                // Silently catch to prevent crash
+            }
+        });
+    }
+}
+
+// Power queue. Sleep stops the IOProc outright rather than leave it to the
+// HAL, so the gap starts at a known point; wake restarts it.
+void AudioCaptureAddon::OnPowerChanged(bool awake) {
+    if (awake) {
+        RecoverMicrophone();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    if (!is_capturing_ || mic_on_tap_ || mic_paused_ || !MicIOReady()) {
+        return;
+    }
+    StopMicIO();
+    MarkMicrophoneGap("sleep");
+}
+
+// Undoes this session's ioBufferFrames request on |device|; device_mutex_ held
+void AudioCaptureAddon::RestoreIoBuffer(AudioDeviceID device) {
+    if (io_buffer_restore_ != 0) {
+        RequestBufferFrameSize(device, io_buffer_restore_);
+        io_buffer_restore_ = 0;
+    }
+}
+
+// HAL notification thread: the device missed an IO deadline
+OSStatus AudioCaptureAddon::MicOverload(AudioObjectID /*object*/,
+                                        UInt32 /*numAddresses*/,
+                                        const AudioObjectPropertyAddress* /*addresses*/,
+                                        void* clientData) {
+    AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(clientData);
+    self->mic_stream_.Stats().overloads.fetch_add(1, std::memory_order_relaxed);
+    return noErr;
+}
+
+// HAL notification thread: follow the system default unless a device is pinned
+// HAL notification thread: the default input moved, a device came or went,
+// or the capturing device died. A dead device is a gap in capture until
+// recovery finds it a replacement (or it comes back).
+OSStatus AudioCaptureAddon::InputDevicesChanged(AudioObjectID /*object*/,
+                                                UInt32 /*numAddresses*/,
+                                                const AudioObjectPropertyAddress* /*addresses*/,
+                                                void* clientData) {
+    AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(clientData);
+    AudioDeviceID target = kAudioObjectUnknown;
+    bool interrupted;
+    {
+        std::lock_guard<std::mutex> lock(self->device_mutex_);
+        if (!self->is_capturing_) {
+            return noErr;
+        }
+        if (!DeviceIsAlive(self->device_id_)) {
+            self->MarkMicrophoneGap("device lost");
+        }
+        interrupted = self->mic_gap_host_ != 0;
+        if (!interrupted) {
+            target = self->ResolveInputDevice();
+        }
+    }
+    if (interrupted) {
+        self->RecoverMicrophone();
+    } else {
+        self->SwitchInputDevice(target);
+    }
+    return noErr;
+}
+
+// Builds the AUHAL and IOProc ahead of startMicrophoneCapture(), which then
+// only starts the device. Nothing runs until then, so the system's
+// microphone indicator stays off. The options take ioBufferFrames; a start
+// with a different one, or after the input device or its rate changed,
+// sets up from scratch.
+Napi::Value AudioCaptureAddon::PrepareMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    
+    if (is_capturing_ || mic_busy_ || mic_preparing_ || pending_start_) {
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
+    
+    CaptureOptions options = ParseCaptureOptions(info.Length() > 0 ? info[0] : env.Undefined());
+    mic_channels_ = options.input_channels;
+    mic_preparing_ = true;
+    (new MicPrepareWorker(this, deferred, options.io_buffer_frames, options.engine, options.ducking_level,
+                          UnitSampleRate(options)))->Queue();
+    return deferred.Promise();
+}
+
+// Releases what prepareMicrophoneCapture() built; false when nothing was
+Napi::Value AudioCaptureAddon::UnprepareMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (is_capturing_ || mic_busy_ || mic_preparing_) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    bool prepared = mic_prepared_;
+    ReleaseMicrophone();
+    return Napi::Boolean::New(env, prepared);
+}
+
+// JS thread, once the prepare worker settled; a start requested meanwhile
+// goes ahead whether or not the prepare succeeded
+void AudioCaptureAddon::FinishPrepare() {
+    mic_preparing_ = false;
+    if (pending_start_) {
+        std::unique_ptr<PendingStart> start = std::move(pending_start_);
+        Napi::Env env = start->deferred.Env();
+        BeginMicrophoneCapture(env, start->callback.Value(), start->options, start->deferred, start->start_host);
+    }
+}
+
+// Promise-returning start: argument checks, TSFN creation and the consumer
+// thread happen here on the JS thread; the blocking CoreAudio setup runs on
+// the libuv pool so Bluetooth device bring-up no longer stalls the main process.
+Napi::Value AudioCaptureAddon::StartMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    
+    if (is_capturing_ || mic_busy_ || pending_start_) {
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
+    
+    // Get callback function
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        deferred.Reject(Napi::Error::New(env, "Callback function required").Value());
+        return deferred.Promise();
+    }
+    
+    Napi::Function callback = info[0].As<Napi::Function>();
+    CaptureOptions options = ParseCaptureOptions(info.Length() > 1 ? info[1] : env.Undefined());
+    
+    // The prepare worker holds device_mutex_; start once it is done
+    if (mic_preparing_) {
+        pending_start_.reset(new PendingStart{Napi::Persistent(callback), options, deferred, HostTimeNow()});
+        return deferred.Promise();
+    }
+    
+    BeginMicrophoneCapture(env, callback, options, deferred, HostTimeNow());
+    return deferred.Promise();
+}
+
+// JS thread; |start_host| is when the start was requested, for the
+// time-to-first-sample stat
+void AudioCaptureAddon::BeginMicrophoneCapture(Napi::Env env, Napi::Function callback, CaptureOptions options,
+                                               Napi::Promise::Deferred deferred, uint64_t start_host) {
+    if (options.processed && !aec_processor_) {
+        deferred.Reject(Napi::Error::New(env, "Processed capture requires the AEC processor").Value());
+        return;
+    }
+    if (options.processed && aec_pipeline_.IsRunning()) {
+        deferred.Reject(Napi::Error::New(env, "Echo cancellation is in use by async processing").Value());
+        return;
+    }
+    
+    // Fresh timeline for this session, unless system capture already shares it
+    if (!system_stream_.IsOpen()) {
+        host_clock_.Anchor();
+    }
+    
+    // A shared-clock tap already carries the input device
+    mic_on_tap_ = system_tap_ && system_tap_->HasInputDevice();
+    if (options.engine != MicEngine::kHal && mic_on_tap_) {
+        deferred.Reject(Napi::Error::New(env, "Only the hal engine can share the tap clock").Value());
+        return;
+    }
+    engine_request_ = options.engine;
+    ducking_request_ = options.ducking_level;
+    mic_channels_ = options.input_channels;
+    if (!mic_channels_.empty() && (mic_on_tap_ || options.engine == MicEngine::kVoiceProcessing)) {
+        Log(LogLevel::kWarn, kLogSource, "inputChannels ignored: the %s mixes its own input",
+            mic_on_tap_ ? "tap's aggregate" : "voice unit");
+    } else if (mic_channels_.size() > 1 && options.engine == MicEngine::kAuhal) {
+        Log(LogLevel::kWarn, kLogSource, "The auhal engine takes one input channel; using %d", mic_channels_[0]);
+    }
+    if (options.engine == MicEngine::kVoiceProcessing) {
+        // The system cancels the echo; a second canceller would only eat speech
+        options.processed = false;
+        options.talk = false;
+        std::cout << "🎤 Voice processing engine: native AEC bypassed" << std::endl;
+    }
+    
+    // Capture runs at the device's nominal rate so CoreAudio never converts;
+    // the one conversion happens downstream, straight to the delivery rate
+    // (CaptureStream) or to the APM's (the AEC pipeline). The shared-clock
+    // aggregate always runs at 48kHz. The unit engines convert in CoreAudio
+    // instead, straight to the rate asked of them.
+    if (mic_on_tap_) {
+        mic_sample_rate_ = kCaptureSampleRate;
+    } else if (options.engine != MicEngine::kHal) {
+        mic_sample_rate_ = UnitSampleRate(options);
+    } else {
+        AudioDeviceID device;
+        {
+            std::lock_guard<std::mutex> lock(device_mutex_);
+            device = ResolveInputDevice();
+        }
+        double rate = GetNominalSampleRate(device);
+        mic_sample_rate_ = rate > 0.0 ? rate : kCaptureSampleRate;
+
+        // A hands-free headset that is also the output has no acoustic echo
+        // path, and the 48kHz pipeline would only upsample its 16kHz mic to
+        // cancel nothing and downsample it again for delivery. It is taken at
+        // its own rate with the consumer thread's NS, AGC2 and high-pass,
+        // the headphones preset's processing.
+        if (options.processed && output_route_.Headphones() && IsBluetoothHandsFree(device, mic_sample_rate_)) {
+            options.processed = false;
+            options.talk = false;
+            options.enhance = true;
+            std::cout << "🎧 Bluetooth hands-free mic at " << mic_sample_rate_
+                      << "Hz: native AEC bypassed, delivered at its own rate" << std::endl;
+        }
+    }
+    if (options.output_sample_rate <= 0.0) {
+        options.output_sample_rate = kCaptureSampleRate;
+    }
+    io_buffer_request_ = options.io_buffer_frames;
+    
+    // Multi-mic arrays are combined ahead of the ring and the AEC. Devices
+    // with one channel go on as before.
+    beamformer_.reset();
+    if (options.beamform && options.engine == MicEngine::kHal && !mic_on_tap_) {
+        beamformer_ = std::make_unique<DelayAndSumBeamformer>(mic_sample_rate_, kBeamMaxDelayMs);
+        beam_latency_ticks_ = host_clock_.MsToTicks(beamformer_->Latency() * 1000.0 / mic_sample_rate_);
+    } else if (options.beamform) {
+        Log(LogLevel::kWarn, kLogSource, "beamform needs the hal engine on its own clock; channels are mixed");
+    }
+    
+    // Consumer must be draining before the first IOProc fires
+    mic_stream_.Open(env, callback, options, options.processed ? kCaptureSampleRate : mic_sample_rate_);
+    mic_stream_.Stats().start_host.store(start_host, std::memory_order_relaxed);
+    if (options.processed) {
+        bool tap_render = tap_feeds_pipeline_.load(std::memory_order_acquire);
+        AudioDeviceID input;
+        {
+            std::lock_guard<std::mutex> lock(device_mutex_);
+            input = ResolveInputDevice();
+        }
+        double echo_latency_ms = ApplyEchoPathLatency(input);
+        // The APM starts from it too, rather than searching the full delay
+        // until the pipeline has paired render with capture
+        if (aec_processor_->GetLevels().stream_delay_ms == 0) {
+            aec_processor_->SetStreamDelayMs(static_cast<int>(echo_latency_ms + 0.5));
+        }
+        aec_pipeline_.Start(aec_processor_.get(), &mic_stream_, kCaptureSampleRate, mic_sample_rate_,
+                            tap_render ? kTapRenderWaitMs : kJsRenderWaitMs, echo_latency_ms);
+        mic_feeds_pipeline_ = true;
+        std::cout << "✅ Native AEC pipeline started (processed delivery, render from "
+                  << (tap_render ? "tap" : "JS") << ", echo path latency " << echo_latency_ms << "ms)" << std::endl;
+    }
+    
+    mic_busy_ = true;
+    (new MicStartWorker(this, deferred))->Queue();
+}
+
+// Worker thread. Builds the AUHAL and IOProc for the current input device
+// unless a session or an earlier prepare already has them.
+bool AudioCaptureAddon::PrepareMicrophone(UInt32 io_buffer_frames, MicEngine engine, UInt32 ducking_level,
+                                          double unit_rate, std::string* error) {
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    
+    // A start that got here first owns the device
+    if (is_capturing_) {
+        return true;
+    }
+    // The shared-clock tap delivers the mic itself
+    if (system_tap_ && system_tap_->HasInputDevice()) {
+        return true;
+    }
+    
+    AudioDeviceID device = ResolveInputDevice();
+    if (device == kAudioObjectUnknown) {
+        *error = "Failed to get input device";
+        return false;
+    }
+    // The unit engines convert to their rate themselves
+    double rate = engine != MicEngine::kHal ? unit_rate : GetNominalSampleRate(device);
+    if (rate <= 0.0) {
+        rate = kCaptureSampleRate;
+    }
+    if (mic_prepared_) {
+        if (device == device_id_ && rate == prepared_rate_ && io_buffer_frames == prepared_io_buffer_ &&
+            engine == mic_engine_) {
+            return true;
+        }
+        ReleaseMicrophone();
+    }
+    
+    std::cout << "🎤 Preparing " << MicEngineName(engine) << " microphone capture..." << std::endl;
+    return BuildMicrophone(rate, io_buffer_frames, engine, ducking_level, error);
+}
+
+// Caller holds device_mutex_. Steps 1-9 of the bring-up, everything short of
+// starting the device; on failure nothing is left behind.
+bool AudioCaptureAddon::BuildMicrophone(double sample_rate, UInt32 io_buffer_frames, MicEngine engine,
+                                        UInt32 ducking_level, std::string* error) {
+    OSStatus status;
+    
+    // Selected input device, or the system default
+    device_id_ = ResolveInputDevice();
+    
+    if (device_id_ == kAudioObjectUnknown) {
+        *error = "Failed to get input device";
+        return false;
+    }
+    
+    // The format below, and mic_stream_ on a start, assume this rate
+    double deviceRate = GetNominalSampleRate(device_id_);
+    if (engine == MicEngine::kHal && deviceRate > 0.0 && deviceRate != sample_rate) {
+        *error = "Input device sample rate changed during start";
+        return false;
+    }
+    
+    // Get device name for logging
+    CFStringRef deviceName = nullptr;
+    AudioObjectPropertyAddress nameAddress = {
+        kAudioDevicePropertyDeviceNameCFString,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    
+    UInt32 nameSize = sizeof(deviceName);
+    status = AudioObjectGetPropertyData(device_id_, &nameAddress, 0, nullptr, &nameSize, &deviceName);
+    
+    if (status == noErr && deviceName) {
+        char name[256];
+        CFStringGetCString(deviceName, name, sizeof(name), kCFStringEncodingUTF8);
+        std::cout << "✅ Using input device: " << device_id_ << " (" << name << ", " << sample_rate << "Hz)" << std::endl;
+        CFRelease(deviceName);
+    } else {
+        std::cout << "✅ Using input device: " << device_id_ << " (" << sample_rate << "Hz)" << std::endl;
+    }
+    
+    mic_engine_ = engine;
+    if (engine == MicEngine::kVoiceProcessing) {
+        return BuildVoiceProcessing(io_buffer_frames, ducking_level, error);
+    }
+    
+    // STEP 1: Find HALOutput AudioComponent
+    AudioComponentDescription desc;
+    desc.componentType = kAudioUnitType_Output;
+    desc.componentSubType = kAudioUnitSubType_HALOutput;
+    desc.componentManufacturer = kAudioUnitManufacturer_Apple;
+    desc.componentFlags = 0;
+    desc.componentFlagsMask = 0;
+    
+    AudioComponent component = AudioComponentFindNext(nullptr, &desc);
+    if (!component) {
+        *error = "Failed to find HALOutput AudioComponent";
+        return false;
+    }
+    std::cout << "✅ Step 1: Found HALOutput AudioComponent" << std::endl;
+    
+    // STEP 2: Create AudioUnit instance
+    status = AudioComponentInstanceNew(component, &mic_audio_unit_);
+    if (status != noErr) {
+        mic_audio_unit_ = nullptr;
+        *error = "Failed to create AudioUnit instance";
+        return false;
+    }
+    std::cout << "✅ Step 2: Created AudioUnit instance" << std::endl;
+    
+    // STEP 3: Enable INPUT (bus 1), DISABLE OUTPUT (bus 0)
+    UInt32 enableIO = 1;
+    status = AudioUnitSetProperty(
+        mic_audio_unit_,
+        kAudioOutputUnitProperty_EnableIO,
+        kAudioUnitScope_Input,
+        1,
+        &enableIO,
+        sizeof(enableIO));
+    
+    if (status != noErr) {
+        ReleaseMicrophone();
+        *error = "Failed to enable input";
+        return false;
+    }
+    std::cout << "✅ Step 3: Enabled INPUT on bus 1" << std::endl;
+    
+    enableIO = 0;
+    status = AudioUnitSetProperty(
+        mic_audio_unit_,
+        kAudioOutputUnitProperty_EnableIO,
+        kAudioUnitScope_Output,
+        0,
+        &enableIO,
+        sizeof(enableIO));
+    
+    if (status != noErr) {
+        ReleaseMicrophone();
+        *error = "Failed to disable output";
+        return false;
+    }
+    std::cout << "✅ Step 4: Disabled OUTPUT on bus 0" << std::endl;
+    
+    // STEP 5: Set input device
+    status = AudioUnitSetProperty(
+        mic_audio_unit_,
+        kAudioOutputUnitProperty_CurrentDevice,
+        kAudioUnitScope_Global,
+        0,
+        &device_id_,
+        sizeof(device_id_));
+    
+    if (status != noErr) {
+        ReleaseMicrophone();
+        std::cerr << "❌ Failed to set input device, error: " << status << std::endl;
+        *error = "Failed to set input device";
+        return false;
+    }
+    std::cout << "✅ Step 5: Set device to " << device_id_ << std::endl;
+    
+    // STEP 6: Set format on INPUT bus. For the IOProc engine this is the
+    // device rate, so the AUHAL has no converter to build and the IOProc
+    // below reads the device format directly; for the AUHAL engine it is
+    // the rate to deliver, and the AUHAL's converter does rate, sample
+    // format and channel count in one pass
+    AudioStreamBasicDescription format;
+    format.mSampleRate = sample_rate;
+    format.mFormatID = kAudioFormatLinearPCM;
+    format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked | kAudioFormatFlagIsNonInterleaved;
+    format.mBytesPerPacket = sizeof(float);
+    format.mFramesPerPacket = 1;
+    format.mBytesPerFrame = sizeof(float);
+    format.mChannelsPerFrame = 1;
+    format.mBitsPerChannel = 32;
+    format.mReserved = 0;
+    
+    status = AudioUnitSetProperty(
+        mic_audio_unit_,
+        kAudioUnitProperty_StreamFormat,
+        kAudioUnitScope_Output,
         1,
         &format,
         sizeof(format));
     
-    if (status != noErr) {
-        AudioComponentInstanceDispose(mic_audio_unit_);
-        Napi::Error::New(env, "Failed to set stream format").ThrowAsJavaScriptException();
+    if (status != noErr) {
+        ReleaseMicrophone();
+        *error = "Failed to set stream format";
+        return false;
+    }
+    std::cout << "✅ Step 6: Set Float32 " << sample_rate << "Hz format on INPUT bus" << std::endl;
+    
+    // The AUHAL picks the selected channel itself, before converting
+    prepared_channels_ = engine == MicEngine::kAuhal ? mic_channels_ : std::vector<int>();
+    if (engine == MicEngine::kAuhal && !mic_channels_.empty()) {
+        SInt32 map[1] = { mic_channels_[0] };
+        status = AudioUnitSetProperty(mic_audio_unit_, kAudioOutputUnitProperty_ChannelMap, kAudioUnitScope_Output,
+                                      1, map, sizeof(map));
+        if (status != noErr) {
+            Log(LogLevel::kWarn, kLogSource, "Input channel %d not mapped, error: %d", mic_channels_[0],
+                static_cast<int>(status));
+        }
+    }
+    if (engine == MicEngine::kAuhal) {
+        AURenderCallbackStruct input = { &AudioCaptureAddon::UnitInputProc, this };
+        status = AudioUnitSetProperty(mic_audio_unit_, kAudioOutputUnitProperty_SetInputCallback,
+                                      kAudioUnitScope_Global, 0, &input, sizeof(input));
+        if (status != noErr) {
+            ReleaseMicrophone();
+            *error = "Failed to set input callback";
+            return false;
+        }
+    }
+    
+    // STEP 7: Initialize AudioUnit
+    status = AudioUnitInitialize(mic_audio_unit_);
+    if (status != noErr) {
+        ReleaseMicrophone();
+        std::cerr << "❌ Failed to initialize AudioUnit, error: " << status << std::endl;
+        *error = "Failed to initialize AudioUnit";
+        return false;
+    }
+    std::cout << "✅ Step 7: AudioUnit initialized" << std::endl;
+    
+    // STEP 8: IO buffer size. Left alone, the device default (often 512
+    // frames or more) sets the IOProc cadence; 480 frames at 48kHz hands the
+    // APM exactly one 10ms frame per callback
+    io_buffer_restore_ = 0;
+    if (io_buffer_frames != 0) {
+        io_buffer_restore_ = GetBufferFrameSize(device_id_);
+        UInt32 granted = RequestBufferFrameSize(device_id_, io_buffer_frames);
+        std::cout << "✅ Step 8: IO buffer " << granted << " frames (requested " << io_buffer_frames << ")" << std::endl;
+    }
+    
+    // The AUHAL engine is started through the unit, which calls back per
+    // device buffer
+    if (engine == MicEngine::kAuhal) {
+        mic_prepared_ = true;
+        prepared_rate_ = sample_rate;
+        prepared_io_buffer_ = io_buffer_frames;
+        return true;
+    }
+    
+    // STEP 9: Create HAL-level IOProc callback (writes into the SPSC ring only)
+    status = AudioDeviceCreateIOProcID(
+        device_id_,
+        &AudioCaptureAddon::MicIOProc,
+        this,
+        &io_proc_id_);
+    
+    if (status != noErr) {
+        io_proc_id_ = nullptr;
+        ReleaseMicrophone();
+        std::cerr << "❌ Failed to create IOProc, error: " << status << std::endl;
+        *error = "Failed to create IOProc";
+        return false;
+    }
+    std::cout << "✅ Step 9: Created HAL IOProc callback" << std::endl;
+    
+    mic_prepared_ = true;
+    prepared_rate_ = sample_rate;
+    prepared_io_buffer_ = io_buffer_frames;
+    return true;
+}
+
+// Caller holds device_mutex_. BuildMicrophone() for engine 'voiceProcessing':
+// a VoiceProcessingIO unit on the input device, which cancels echo against
+// everything the machine plays, with AGC and noise suppression, inside the
+// system audio server. The app's own AEC stays out of it. The unit drives
+// the device, so there is no IOProc; its input callback pulls the processed
+// mic at 48kHz mono.
+bool AudioCaptureAddon::BuildVoiceProcessing(UInt32 io_buffer_frames, UInt32 ducking_level, std::string* error) {
+    AudioComponentDescription desc;
+    desc.componentType = kAudioUnitType_Output;
+    desc.componentSubType = kAudioUnitSubType_VoiceProcessingIO;
+    desc.componentManufacturer = kAudioUnitManufacturer_Apple;
+    desc.componentFlags = 0;
+    desc.componentFlagsMask = 0;
+    
+    AudioComponent component = AudioComponentFindNext(nullptr, &desc);
+    if (!component) {
+        *error = "Failed to find VoiceProcessingIO AudioComponent";
+        return false;
+    }
+    OSStatus status = AudioComponentInstanceNew(component, &mic_audio_unit_);
+    if (status != noErr) {
+        mic_audio_unit_ = nullptr;
+        *error = "Failed to create VoiceProcessingIO instance";
+        return false;
+    }
+    
+    // Input on bus 1. Output on bus 0 stays enabled: the unit only
+    // processes while it runs, so it renders silence
+    UInt32 enableIO = 1;
+    status = AudioUnitSetProperty(mic_audio_unit_, kAudioOutputUnitProperty_EnableIO, kAudioUnitScope_Input, 1,
+                                  &enableIO, sizeof(enableIO));
+    if (status == noErr) {
+        status = AudioUnitSetProperty(mic_audio_unit_, kAudioOutputUnitProperty_CurrentDevice,
+                                      kAudioUnitScope_Global, 1, &device_id_, sizeof(device_id_));
+    }
+    if (status != noErr) {
+        ReleaseMicrophone();
+        std::cerr << "❌ Failed to bind voice processing to device " << device_id_ << ", error: " << status << std::endl;
+        *error = "Failed to set input device";
+        return false;
+    }
+    
+    AudioStreamBasicDescription format;
+    format.mSampleRate = kCaptureSampleRate;
+    format.mFormatID = kAudioFormatLinearPCM;
+    format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked | kAudioFormatFlagIsNonInterleaved;
+    format.mBytesPerPacket = sizeof(float);
+    format.mFramesPerPacket = 1;
+    format.mBytesPerFrame = sizeof(float);
+    format.mChannelsPerFrame = 1;
+    format.mBitsPerChannel = 32;
+    format.mReserved = 0;
+    status = AudioUnitSetProperty(mic_audio_unit_, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Output, 1,
+                                  &format, sizeof(format));
+    if (status == noErr) {
+        status = AudioUnitSetProperty(mic_audio_unit_, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0,
+                                      &format, sizeof(format));
+    }
+    if (status != noErr) {
+        ReleaseMicrophone();
+        *error = "Failed to set stream format";
+        return false;
+    }
+    
+    AURenderCallbackStruct input = { &AudioCaptureAddon::UnitInputProc, this };
+    AURenderCallbackStruct render = { &AudioCaptureAddon::VoiceRenderSilence, this };
+    status = AudioUnitSetProperty(mic_audio_unit_, kAudioOutputUnitProperty_SetInputCallback,
+                                  kAudioUnitScope_Global, 1, &input, sizeof(input));
+    if (status == noErr) {
+        status = AudioUnitSetProperty(mic_audio_unit_, kAudioUnitProperty_SetRenderCallback, kAudioUnitScope_Input,
+                                      0, &render, sizeof(render));
+    }
+    if (status != noErr) {
+        ReleaseMicrophone();
+        *error = "Failed to set voice processing callbacks";
+        return false;
+    }
+    
+    UInt32 bypass = voice_bypassed_ ? 1 : 0;
+    AudioUnitSetProperty(mic_audio_unit_, kAUVoiceIOProperty_BypassVoiceProcessing, kAudioUnitScope_Global, 0,
+                         &bypass, sizeof(bypass));
+    
+    // Other apps' audio is ducked while the unit runs; macOS 14 lets the
+    // level be chosen, and with advanced ducking it only applies while
+    // someone speaks. Without either the system default stands.
+    voice_ducking_ = 0;
+    voice_advanced_ducking_ = false;
+    if (__builtin_available(macOS 14.0, *)) {
+        AUVoiceIOOtherAudioDuckingConfiguration ducking = {};
+        if (ducking_level != 0) {
+            ducking.mEnableAdvancedDucking = true;
+            ducking.mDuckingLevel = static_cast<AUVoiceIOOtherAudioDuckingLevel>(ducking_level);
+            status = AudioUnitSetProperty(mic_audio_unit_, kAUVoiceIOProperty_OtherAudioDuckingConfiguration,
+                                          kAudioUnitScope_Global, 0, &ducking, sizeof(ducking));
+            if (status != noErr) {
+                Log(LogLevel::kWarn, kLogSource, "Voice processing refused ducking level %u, error: %d",
+                    static_cast<unsigned>(ducking_level), static_cast<int>(status));
+            }
+        }
+        UInt32 size = sizeof(ducking);
+        if (AudioUnitGetProperty(mic_audio_unit_, kAUVoiceIOProperty_OtherAudioDuckingConfiguration,
+                                 kAudioUnitScope_Global, 0, &ducking, &size) == noErr) {
+            voice_ducking_ = static_cast<UInt32>(ducking.mDuckingLevel);
+            voice_advanced_ducking_ = ducking.mEnableAdvancedDucking;
+        }
+    } else if (ducking_level != 0) {
+        Log(LogLevel::kWarn, kLogSource, "Ducking levels need macOS 14; using the system default");
+    }
+    
+    status = AudioUnitInitialize(mic_audio_unit_);
+    if (status != noErr) {
+        ReleaseMicrophone();
+        std::cerr << "❌ Failed to initialize VoiceProcessingIO, error: " << status << std::endl;
+        *error = "Failed to initialize AudioUnit";
+        return false;
+    }
+    
+    io_buffer_restore_ = 0;
+    if (io_buffer_frames != 0) {
+        io_buffer_restore_ = GetBufferFrameSize(device_id_);
+        RequestBufferFrameSize(device_id_, io_buffer_frames);
+    }
+    std::cout << "✅ VoiceProcessingIO ready on device " << device_id_ << std::endl;
+    
+    mic_prepared_ = true;
+    prepared_rate_ = kCaptureSampleRate;
+    prepared_io_buffer_ = io_buffer_frames;
+    return true;
+}
+
+bool AudioCaptureAddon::MicIOReady() const {
+    return mic_engine_ != MicEngine::kHal ? mic_audio_unit_ != nullptr : io_proc_id_ != nullptr;
+}
+
+OSStatus AudioCaptureAddon::StartMicIO() {
+    if (!MicIOReady()) {
+        return kAudioHardwareNotRunningError;
+    }
+    if (mic_engine_ != MicEngine::kHal) {
+        OSStatus status = AudioOutputUnitStart(mic_audio_unit_);
+        voice_active_ = status == noErr && mic_engine_ == MicEngine::kVoiceProcessing;
+        return status;
+    }
+    return AudioDeviceStart(device_id_, io_proc_id_);
+}
+
+void AudioCaptureAddon::StopMicIO() {
+    if (mic_engine_ != MicEngine::kHal && mic_audio_unit_) {
+        AudioOutputUnitStop(mic_audio_unit_);
+        voice_active_ = false;
+    } else if (device_id_ != kAudioObjectUnknown && io_proc_id_ != nullptr) {
+        AudioDeviceStop(device_id_, io_proc_id_);
+    }
+}
+
+// Caller holds device_mutex_ and the IOProc is stopped. Undoes whatever
+// BuildMicrophone() got through.
+void AudioCaptureAddon::ReleaseMicrophone() {
+    if (io_proc_id_ != nullptr) {
+        AudioDeviceDestroyIOProcID(device_id_, io_proc_id_);
+        io_proc_id_ = nullptr;
+    }
+    RestoreIoBuffer(device_id_);
+    if (mic_audio_unit_) {
+        AudioUnitUninitialize(mic_audio_unit_);
+        AudioComponentInstanceDispose(mic_audio_unit_);
+        mic_audio_unit_ = nullptr;
+    }
+    voice_active_ = false;
+    mic_engine_ = MicEngine::kHal;
+    mic_prepared_ = false;
+}
+
+// Worker thread. Starts the prepared AUHAL/IOProc, building them first when
+// there are none or they no longer fit; on failure everything it created is
+// released and |error| says which step failed.
+bool AudioCaptureAddon::SetupMicrophone(std::string* error) {
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    
+    // Shared clock: the tap's IOProc already delivers this device, so there
+    // is no AUHAL and no default-input following until the tap is recreated
+    if (mic_on_tap_) {
+        ReleaseMicrophone();
+        device_id_ = tap_input_device_;
+        is_capturing_ = true;
+        if (io_buffer_request_ != 0) {
+            Log(LogLevel::kWarn, kLogSource, "ioBufferFrames ignored: the tap's aggregate sets the IO buffer");
+        }
+        if (mic_feeds_pipeline_) {
+            aec_pipeline_.SetWorkgroup(GetIoWorkgroup(system_tap_->AggregateDevice()));
+        }
+        Log(LogLevel::kInfo, kLogSource, "Microphone capture on the tap clock (device %u)",
+            static_cast<unsigned>(device_id_));
+        return true;
+    }
+    
+    // mic_stream_ was opened for the device and rate read on the JS thread
+    if (mic_prepared_ && (device_id_ != ResolveInputDevice() || prepared_rate_ != mic_sample_rate_ ||
+                          prepared_io_buffer_ != io_buffer_request_ || mic_engine_ != engine_request_ ||
+                          (mic_engine_ == MicEngine::kAuhal && prepared_channels_ != mic_channels_))) {
+        Log(LogLevel::kInfo, kLogSource, "Prepared microphone no longer matches; setting up again");
+        ReleaseMicrophone();
+    }
+    bool prepared = mic_prepared_;
+    if (prepared) {
+        std::cout << "🎤 Starting prepared AUHAL microphone capture (device " << device_id_ << ")" << std::endl;
+    } else {
+        std::cout << "🎤 Starting AUHAL microphone capture (Granola pattern)..." << std::endl;
+        if (!BuildMicrophone(mic_sample_rate_, io_buffer_request_, engine_request_, ducking_request_, error)) {
+            return false;
+        }
+    }
+    
+    is_capturing_ = true;
+    
+    // STEP 10: Start audio device
+    OSStatus status = StartMicIO();
+    if (status != noErr && prepared) {
+        // The prepared IOProc may have outlived its device; build it afresh once
+        Log(LogLevel::kWarn, kLogSource, "Prepared microphone failed to start (%d); setting up again",
+            static_cast<int>(status));
+        is_capturing_ = false;
+        ReleaseMicrophone();
+        if (!BuildMicrophone(mic_sample_rate_, io_buffer_request_, engine_request_, ducking_request_, error)) {
+            return false;
+        }
+        is_capturing_ = true;
+        status = StartMicIO();
+    }
+    if (status != noErr) {
+        is_capturing_ = false;
+        ReleaseMicrophone();
+        std::cerr << "❌ Failed to start AudioDevice, error: " << status << std::endl;
+        *error = "Failed to start AudioDevice";
+        return false;
+    }
+    // The running session owns the unit now; teardown releases it
+    mic_prepared_ = false;
+    mic_stream_.Stats().io_buffer_frames.store(GetBufferFrameSize(device_id_), std::memory_order_relaxed);
+    std::cout << "✅ Step 10: AudioDevice started!" << std::endl;
+    
+    // STEP 11: Follow default-input changes (headset plugged in mid-meeting)
+    // and recover from the device going away
+    AudioObjectAddPropertyListener(kAudioObjectSystemObject, &kDefaultInputAddress,
+                                   &AudioCaptureAddon::InputDevicesChanged, this);
+    AudioObjectAddPropertyListener(kAudioObjectSystemObject, &kDevicesAddress,
+                                   &AudioCaptureAddon::InputDevicesChanged, this);
+    WatchInputDevice(device_id_, true);
+    
+    // STEP 12: The DSP thread keeps the IOProc's deadline
+    if (mic_feeds_pipeline_) {
+        aec_pipeline_.SetWorkgroup(GetIoWorkgroup(device_id_));
+    }
+    
+    std::cout << "🎉 MIC CAPTURE FULLY STARTED (Granola pattern)! HAL IOProc will deliver audio." << std::endl;
+    
+    return true;
+}
+
+
+// Stops the IOProc and disposes the AudioUnit. Safe off the JS thread; the
+// caller closes mic_stream_ afterwards.
+void AudioCaptureAddon::TeardownMicrophone() {
+    std::cout << "🛑 Stopping microphone capture..." << std::endl;
+    
+    // The tap keeps running; the caller releases it if system capture is off
+    if (mic_on_tap_) {
+        is_capturing_ = false;
+        mic_paused_ = false;
+        QuiesceTapSinks();
+        if (mic_feeds_pipeline_.exchange(false)) {
+            aec_pipeline_.Stop();
+        }
+        return;
+    }
+    
+    AudioObjectRemovePropertyListener(kAudioObjectSystemObject, &kDefaultInputAddress,
+                                      &AudioCaptureAddon::InputDevicesChanged, this);
+    AudioObjectRemovePropertyListener(kAudioObjectSystemObject, &kDevicesAddress,
+                                      &AudioCaptureAddon::InputDevicesChanged, this);
+    
+    // Stop and cleanup in reverse order
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        is_capturing_ = false;
+        mic_paused_ = false;
+        mic_gap_host_ = 0;
+        WatchInputDevice(device_id_, false);
+        StopMicIO();
+        ReleaseMicrophone();
+    }
+    
+    // IOProc has stopped; flush the tail through AEC
+    if (mic_feeds_pipeline_.exchange(false)) {
+        aec_pipeline_.Stop();
+    }
+}
+
+Napi::Value AudioCaptureAddon::StopMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    
+    if (!is_capturing_ || mic_busy_) {
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
+    
+    mic_busy_ = true;
+    (new MicStopWorker(this, deferred))->Queue();
+    return deferred.Promise();
+}
+
+// Recording after the probe starts, and the ring that holds it (up to 96kHz)
+static constexpr double kCalibrationWindowMs = 1000.0;
+static constexpr size_t kCalibrationRingSamples = 1 << 18;
+
+// A longer round trip than this is a misdetection
+static constexpr double kMaxRoundTripMs = 500.0;
+
+// calibrate() -> Promise<{ roundTripMs, clarity, outputLatencyMs, echoDelayMs }>.
+// Needs running, unpaused mic capture and open speakers: the probe is a
+// quarter-second chirp at about -26 dBFS. Rejects when it is not heard.
+Napi::Value AudioCaptureAddon::Calibrate(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    
+    if (!is_capturing_ || mic_busy_ || mic_paused_ || !aec_processor_) {
+        deferred.Reject(Napi::Error::New(env, "Calibration needs running microphone capture").Value());
+        return deferred.Promise();
+    }
+    if (voice_active_) {
+        deferred.Reject(Napi::Error::New(env, "Calibration is not available with voice processing").Value());
+        return deferred.Promise();
+    }
+    
+    mic_busy_ = true;
+    (new CalibrateWorker(this, deferred))->Queue();
+    return deferred.Promise();
+}
+
+// Worker thread. The output unit times the probe's first frame and the mic
+// IOProc its arrival, both on the host clock.
+bool AudioCaptureAddon::MeasureRoundTrip(Calibration* result, std::string* error) {
+    if (!calibration_ring_) {
+        calibration_ring_ = std::make_unique<SpscRingBuffer<float>>(kCalibrationRingSamples);
+    }
+    probe_ = LatencyProbe::Generate(kCaptureSampleRate);
+    probe_position_ = 0;
+    probe_host_ = 0;
+    
+    AudioComponentDescription desc = {};
+    desc.componentType = kAudioUnitType_Output;
+    desc.componentSubType = kAudioUnitSubType_DefaultOutput;
+    desc.componentManufacturer = kAudioUnitManufacturer_Apple;
+    AudioComponent component = AudioComponentFindNext(nullptr, &desc);
+    AudioUnit unit = nullptr;
+    if (!component || AudioComponentInstanceNew(component, &unit) != noErr) {
+        *error = "No default output unit";
+        return false;
+    }
+    
+    AudioStreamBasicDescription format = {};
+    format.mSampleRate = kCaptureSampleRate;
+    format.mFormatID = kAudioFormatLinearPCM;
+    format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked;
+    format.mBytesPerPacket = sizeof(float);
+    format.mFramesPerPacket = 1;
+    format.mBytesPerFrame = sizeof(float);
+    format.mChannelsPerFrame = 1;
+    format.mBitsPerChannel = 32;
+    AURenderCallbackStruct callback = { &AudioCaptureAddon::ProbeRender, this };
+    OSStatus status = AudioUnitSetProperty(unit, kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0,
+                                           &format, sizeof(format));
+    if (status == noErr) {
+        status = AudioUnitSetProperty(unit, kAudioUnitProperty_SetRenderCallback, kAudioUnitScope_Input, 0,
+                                      &callback, sizeof(callback));
+    }
+    if (status == noErr) {
+        status = AudioUnitInitialize(unit);
+    }
+    if (status != noErr) {
+        AudioComponentInstanceDispose(unit);
+        *error = "Failed to set up the probe output, error: " + std::to_string(status);
+        return false;
+    }
+    
+    // Whatever an earlier run left in the ring
+    std::vector<float> recording(calibration_ring_->AvailableToRead());
+    calibration_ring_->Read(recording.data(), recording.size());
+    calibration_capture_host_ = 0;
+    calibration_armed_.store(true, std::memory_order_release);
+    
+    status = AudioOutputUnitStart(unit);
+    if (status == noErr) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(
+            static_cast<int>(LatencyProbe::kDurationMs + kCalibrationWindowMs)));
+        AudioOutputUnitStop(unit);
+    }
+    calibration_armed_.store(false, std::memory_order_release);
+    AudioUnitUninitialize(unit);
+    AudioComponentInstanceDispose(unit);
+    if (status != noErr) {
+        *error = "Failed to start the probe output, error: " + std::to_string(status);
+        return false;
+    }
+    
+    recording.resize(calibration_ring_->AvailableToRead());
+    calibration_ring_->Read(recording.data(), recording.size());
+    uint64_t capture_host = calibration_capture_host_.load(std::memory_order_relaxed);
+    uint64_t probe_host = probe_host_.load(std::memory_order_relaxed);
+    if (capture_host == 0 || probe_host == 0) {
+        *error = capture_host == 0 ? "No microphone audio during calibration" : "The probe was not played";
+        return false;
+    }
+    
+    LatencyProbe::Match match;
+    if (!LatencyProbe::Locate(recording.data(), recording.size(), mic_sample_rate_, &match)) {
+        Log(LogLevel::kWarn, kLogSource, "Calibration probe not heard (clarity %.1f)", match.clarity);
+        *error = "Calibration probe not heard (headphones, or output muted)";
+        return false;
+    }
+    uint64_t arrival = capture_host + host_clock_.MsToTicks(match.offset * 1000.0 / mic_sample_rate_);
+    double round_trip_ms = arrival >= probe_host ? host_clock_.TicksToMs(arrival - probe_host) : -1.0;
+    if (round_trip_ms < 0.0 || round_trip_ms > kMaxRoundTripMs) {
+        *error = "Calibration measured an implausible round trip";
+        return false;
+    }
+    
+    result->round_trip_ms = round_trip_ms;
+    result->clarity = match.clarity;
+    Log(LogLevel::kInfo, kLogSource, "Calibrated acoustic round trip: %.1fms (clarity %.1f)", round_trip_ms,
+        match.clarity);
+    return true;
+}
+
+// Output unit's render thread: the probe once, then silence
+OSStatus AudioCaptureAddon::ProbeRender(void* inRefCon,
+                                        AudioUnitRenderActionFlags* ioActionFlags,
+                                        const AudioTimeStamp* inTimeStamp,
+                                        UInt32 /*inBusNumber*/,
+                                        UInt32 inNumberFrames,
+                                        AudioBufferList* ioData) {
+    AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(inRefCon);
+    float* out = static_cast<float*>(ioData->mBuffers[0].mData);
+    size_t position = self->probe_position_.load(std::memory_order_relaxed);
+    if (position == 0 && inTimeStamp && (inTimeStamp->mFlags & kAudioTimeStampHostTimeValid)) {
+        self->probe_host_.store(inTimeStamp->mHostTime, std::memory_order_relaxed);
+    }
+    size_t count = std::min<size_t>(inNumberFrames, self->probe_.size() - position);
+    std::memcpy(out, self->probe_.data() + position, count * sizeof(float));
+    std::memset(out + count, 0, (inNumberFrames - count) * sizeof(float));
+    self->probe_position_.store(position + count, std::memory_order_relaxed);
+    if (count == 0) {
+        *ioActionFlags |= kAudioUnitRenderAction_OutputIsSilence;
+    }
+    return noErr;
+}
+
+// JS thread. The round trip stands in for the HAL's echo path latency on
+// both delay paths until the devices change. AEC3 that has not converged
+// yet restarts its delay search where the round trip puts the echo.
+void CalibrateWorker::OnOK() {
+    Napi::Env env = Env();
+    addon_->mic_busy_ = false;
+    
+    double replaced_ms = addon_->echo_latency_ms_.load(std::memory_order_relaxed);
+    if (addon_->mic_feeds_pipeline_) {
+        addon_->aec_pipeline_.SetOutputLatencyMs(result_.round_trip_ms);
+    }
+    addon_->echo_latency_ms_.store(result_.round_trip_ms, std::memory_order_relaxed);
+    addon_->echo_latency_calibrated_.store(true, std::memory_order_relaxed);
+    addon_->paired_path_latency_ms_ = result_.round_trip_ms;
+    addon_->paired_latency_version_ = addon_->device_table_.Version();
+    
+    AECProcessor* aec = addon_->aec_processor_.get();
+    int stream_delay_ms = aec->GetLevels().stream_delay_ms;
+    double echo_delay_ms = stream_delay_ms > 0
+        ? stream_delay_ms - replaced_ms + result_.round_trip_ms
+        : result_.round_trip_ms;
+    int echo_delay = static_cast<int>(std::max(0.0, echo_delay_ms) + 0.5);
+    if (!aec->GetLevels().aec_converged) {
+        AECConfig config = aec->GetConfig();
+        config.warm_start.echo_delay_ms = echo_delay;
+        aec->Configure(config);
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("roundTripMs", result_.round_trip_ms);
+    result.Set("clarity", result_.clarity);
+    result.Set("outputLatencyMs", replaced_ms);
+    result.Set("echoDelayMs", echo_delay);
+    deferred_.Resolve(result);
+}
+
+// Stops the device's IO and nothing else: the AudioUnit, IOProc, TSFN and
+// consumer stay up, and so does the AEC pipeline with its adapted filters and
+// delay estimate. What was captured before the pause is still delivered.
+Napi::Value AudioCaptureAddon::PauseMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    
+    if (!is_capturing_ || mic_busy_ || mic_paused_) {
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
+    
+    mic_busy_ = true;
+    (new MicPauseWorker(this, deferred, true))->Queue();
+    return deferred.Promise();
+}
+
+// Restarts the IO stopped by pauseMicrophoneCapture(), on the device the mic
+// follows by then
+Napi::Value AudioCaptureAddon::ResumeMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+    
+    if (!is_capturing_ || mic_busy_ || !mic_paused_) {
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
+    
+    mic_busy_ = true;
+    (new MicPauseWorker(this, deferred, false))->Queue();
+    return deferred.Promise();
+}
+
+// Worker thread. On the tap the IO belongs to system capture, so a pause
+// only gates the mic's sink.
+bool AudioCaptureAddon::PauseMicrophone(bool pause, std::string* error) {
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    
+    if (pause) {
+        if (!mic_on_tap_) {
+            StopMicIO();
+        }
+        mic_paused_ = true;
+        if (mic_on_tap_) {
+            QuiesceTapSinks();
+        }
+        if (mic_feeds_pipeline_) {
+            aec_pipeline_.SetCapturePaused(true);
+        }
+        mic_stream_.Pause();
+        CaptureSessionEvent(SessionStream::kMicrophone, SessionEventType::kPause);
+        Log(LogLevel::kInfo, kLogSource, "Microphone capture paused");
+        return true;
+    }
+    
+    if (mic_feeds_pipeline_) {
+        aec_pipeline_.SetCapturePaused(false);
+    }
+    mic_paused_ = false;
+    if (!mic_on_tap_) {
+        OSStatus status = StartMicIO();
+        if (status != noErr) {
+            mic_paused_ = true;
+            if (mic_feeds_pipeline_) {
+                aec_pipeline_.SetCapturePaused(true);
+            }
+            Log(LogLevel::kError, kLogSource, "Failed to resume microphone capture, error: %d", static_cast<int>(status));
+            *error = "Failed to start AudioDevice";
+            return false;
+        }
+    }
+    Log(LogLevel::kInfo, kLogSource, "Microphone capture resumed");
+    return true;
+}
+
+// SYSTEM AUDIO CAPTURE
+
+Napi::Value AudioCaptureAddon::StartSystemAudioCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (system_stream_.IsOpen()) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::Error::New(env, "Callback function required").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+    
+    Napi::Function callback = info[0].As<Napi::Function>();
+    CaptureOptions options = ParseCaptureOptions(info.Length() > 1 ? info[1] : env.Undefined());
+    
+    std::cout << "🔊 Starting system audio capture (process tap)..." << std::endl;
+    
+    // A tap still running for the shared-clock mic is picked up as it is
+    std::string error;
+    bool reuse_tap = system_tap_ != nullptr;
+    if (!reuse_tap) {
+        AudioDeviceID input = kAudioObjectUnknown;
+        if (options.shared_clock && (is_capturing_ || mic_busy_)) {
+            Log(LogLevel::kWarn, kLogSource, "sharedClock ignored: the microphone is already on its own clock");
+        } else if (options.shared_clock) {
+            std::lock_guard<std::mutex> lock(device_mutex_);
+            input = ResolveInputDevice();
+        }
+        
+        system_tap_ = std::make_unique<SystemAudioTap>(&AudioCaptureAddon::SystemAudioSink, this);
+        system_tap_->SetStats(&system_stream_.Stats());
+        system_tap_->SetProcesses(options.tap_bundle_ids, options.tap_pids);
+        if (input != kAudioObjectUnknown) {
+            system_tap_->SetInputDevice(input, &AudioCaptureAddon::TapMicrophoneSink, this);
+        }
+        bool created = system_tap_->Create(&error);
+        if (!created && input != kAudioObjectUnknown) {
+            Log(LogLevel::kWarn, kLogSource, "Shared-clock tap unavailable (%s); mic keeps its own clock",
+                error.c_str());
+            input = kAudioObjectUnknown;
+            error.clear();
+            system_tap_ = std::make_unique<SystemAudioTap>(&AudioCaptureAddon::SystemAudioSink, this);
+            system_tap_->SetStats(&system_stream_.Stats());
+            system_tap_->SetProcesses(options.tap_bundle_ids, options.tap_pids);
+            created = system_tap_->Create(&error);
+        }
+        if (!created) {
+            system_tap_.reset();
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return Napi::Boolean::New(env, false);
+        }
+        tap_input_device_ = input;
+    }
+    
+    if (!mic_stream_.IsOpen()) {
+        host_clock_.Anchor();
+    }
+    
+    system_stream_.Open(env, callback, options, system_tap_->SampleRate());
+    
+    // The tap doubles as the AEC reference when it runs at the mic rate
+    tap_feeds_pipeline_ = (system_tap_->SampleRate() == kCaptureSampleRate);
+    tap_delivers_system_ = true;
+    
+    if (!reuse_tap && !system_tap_->Start(&error)) {
+        tap_delivers_system_ = false;
+        tap_feeds_pipeline_ = false;
+        system_stream_.Close();
+        system_tap_.reset();
+        tap_input_device_ = kAudioObjectUnknown;
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+    
+    std::cout << "🎉 System audio capture started at " << system_tap_->SampleRate() << "Hz" << std::endl;
+    
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value AudioCaptureAddon::StopSystemAudioCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!system_stream_.IsOpen()) {
+        return Napi::Boolean::New(env, false);
+    }
+    
+    std::cout << "🛑 Stopping system audio capture..." << std::endl;
+    
+    // Tap IO stops first so the stream can flush without a live producer.
+    // A shared-clock mic still needs the IO; its sinks just stop delivering.
+    tap_delivers_system_ = false;
+    tap_feeds_pipeline_ = false;
+    if (mic_on_tap_) {
+        QuiesceTapSinks();
+    } else if (system_tap_) {
+        system_tap_->Stop();
+    }
+    system_stream_.Close();
+    if (!mic_on_tap_) {
+        system_tap_.reset();
+        tap_input_device_ = kAudioObjectUnknown;
+    }
+    
+    std::cout << "✅ System audio capture stopped" << std::endl;
+    
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value AudioCaptureAddon::IsSystemAudioCaptureSupported(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), SystemAudioTap::IsSupported());
+}
+
+// Format of the running tap before downmix, or null when not capturing
+Napi::Value AudioCaptureAddon::GetSystemAudioFormat(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!system_tap_ || !system_stream_.IsOpen()) {
+        return env.Null();
+    }
+    
+    Napi::Object format = Napi::Object::New(env);
+    format.Set("sampleRate", Napi::Number::New(env, system_tap_->SampleRate()));
+    format.Set("channels", Napi::Number::New(env, system_tap_->Channels()));
+    return format;
+}
+
+// Runs on the monitor tap's real-time thread
+void AudioCaptureAddon::MeetingMonitorSink(void* context, const float* data, uint32_t num_samples,
+                                           uint64_t /*host_time*/) {
+    static_cast<AudioCaptureAddon*>(context)->meeting_monitor_.Push(data, num_samples);
+}
+
+// startMeetingMonitor({ bundleIds? }, callback): standby watch on what the
+// meeting apps (bundle ID prefixes, as for the system tap; none watches all
+// output) play, on a tap of its own. |callback| gets { speechSeconds,
+// windowSeconds, speechRuns, confidence } when a call seems to have started.
+// Stop it before capturing: recording taps the same audio anyway.
+Napi::Value AudioCaptureAddon::StartMeetingMonitor(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Callback function required").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!SystemAudioTap::IsSupported()) {
+        Napi::Error::New(env, "Process taps require macOS 14.2 or later").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<std::string> bundle_ids;
+    if (info[0].IsObject() && info[0].As<Napi::Object>().Get("bundleIds").IsArray()) {
+        Napi::Array ids = info[0].As<Napi::Object>().Get("bundleIds").As<Napi::Array>();
+        for (uint32_t i = 0; i < ids.Length(); ++i) {
+            if (ids.Get(i).IsString()) {
+                bundle_ids.push_back(ids.Get(i).As<Napi::String>().Utf8Value());
+            }
+        }
+    }
+    StopMeetingMonitorTap();
+    
+    std::string error;
+    auto tap = std::make_unique<SystemAudioTap>(&AudioCaptureAddon::MeetingMonitorSink, this);
+    tap->SetProcesses(std::move(bundle_ids), {});
+    if (!tap->Create(&error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    meeting_tsfn_ = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "MeetingAudioLikely", 0, 1);
+    meeting_tsfn_.Unref(env);
+    Napi::ThreadSafeFunction tsfn = meeting_tsfn_;
+    bool started = meeting_monitor_.Start(tap->SampleRate(), [tsfn](const MeetingAudioEvent& event) mutable {
+        tsfn.NonBlockingCall([event](Napi::Env env, Napi::Function callback) {
+            try {
+                callback.Call({ MeetingAudioEventToObject(env, event) });
+            } catch (...) {
+                // Silently catch to prevent crash
+            }
+        });
+    }, &error);
+    if (!started || !tap->Start(&error)) {
+        meeting_monitor_.Stop();
+        meeting_tsfn_.Release();
+        meeting_tsfn_ = Napi::ThreadSafeFunction();
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    monitor_tap_ = std::move(tap);
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::StopMeetingMonitor(const Napi::CallbackInfo& info) {
+    StopMeetingMonitorTap();
+    return info.Env().Undefined();
+}
+
+// Tap IO first, so the monitor has no producer when it stops
+void AudioCaptureAddon::StopMeetingMonitorTap() {
+    if (monitor_tap_) {
+        monitor_tap_->Stop();
+        monitor_tap_.reset();
+    }
+    meeting_monitor_.Stop();
+    if (meeting_tsfn_) {
+        meeting_tsfn_.Release();
+        meeting_tsfn_ = Napi::ThreadSafeFunction();
+    }
+}
+
+Napi::Value AudioCaptureAddon::GetMeetingMonitorStats(const Napi::CallbackInfo& info) {
+    return MeetingAudioMonitorStatsToObject(info.Env(), meeting_monitor_.GetStats());
+}
+
+// startKeywordSpotter({ model, keywords: [text | { text, threshold? }] },
+// callback): keywords spotted on the system stream from its shared
+// spectrum, whenever that stream is open, until stopKeywordSpotter().
+// |callback| gets { keyword, index, confidence, startMs, endMs, detectedMs },
+// times as Date.now(). Throws for a model that does not load or a keyword
+// its tokens cannot spell.
+Napi::Value AudioCaptureAddon::StartKeywordSpotter(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Options and callback function required").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Get("model").IsString()) {
+        Napi::TypeError::New(env, "model path required").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<KeywordSpec> keywords;
+    std::string error;
+    if (!ParseKeywordSpecs(options.Get("keywords"), &keywords, &error)) {
+        Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::shared_ptr<const KeywordModel> model =
+        KeywordModel::Load(options.Get("model").As<Napi::String>().Utf8Value(), &error);
+    if (!model) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    StopKeywordSpotterListening();
+    
+    keyword_tsfn_ = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "KeywordSpotted", 0, 1);
+    keyword_tsfn_.Unref(env);
+    Napi::ThreadSafeFunction tsfn = keyword_tsfn_;
+    bool started = keyword_spotter_.Start(std::move(model), keywords, &host_clock_,
+                                          [tsfn](const KeywordEvent& event) mutable {
+        tsfn.NonBlockingCall([event](Napi::Env env, Napi::Function callback) {
+            try {
+                callback.Call({ KeywordEventToObject(env, event) });
+            } catch (...) {
+                // Silently catch to prevent crash
+            }
+        });
+    }, &error);
+    if (!started) {
+        keyword_tsfn_.Release();
+        keyword_tsfn_ = Napi::ThreadSafeFunction();
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    system_stream_.Spectrum().AddListener(&keyword_spotter_);
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::StopKeywordSpotter(const Napi::CallbackInfo& info) {
+    StopKeywordSpotterListening();
+    return info.Env().Undefined();
+}
+
+// Off the spectrum first, so the spotter has no producer when it stops
+void AudioCaptureAddon::StopKeywordSpotterListening() {
+    system_stream_.Spectrum().RemoveListener(&keyword_spotter_);
+    keyword_spotter_.Stop();
+    if (keyword_tsfn_) {
+        keyword_tsfn_.Release();
+        keyword_tsfn_ = Napi::ThreadSafeFunction();
+    }
+}
+
+Napi::Value AudioCaptureAddon::GetKeywordSpotterStats(const Napi::CallbackInfo& info) {
+    return KeywordSpotterStatsToObject(info.Env(), keyword_spotter_.GetStats());
+}
+
+// startVoiceEnrollment(): pools the user's speech on the mic stream, which
+// must be open with verifyVoice, until finishVoiceEnrollment() returns {
+// voiceprint (a Buffer for setVoiceprint() and the voiceprint option),
+// speechSeconds } or cancelVoiceEnrollment(). Finishing throws before
+// enough speech; the voiceprint is in effect at once.
+Napi::Value AudioCaptureAddon::StartVoiceEnrollment(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    VoiceVerifier* verifier = mic_stream_.Verifier();
+    if (!verifier) {
+        Napi::Error::New(env, "Microphone capture with verifyVoice is not running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    verifier->StartEnrollment();
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::FinishVoiceEnrollment(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    VoiceVerifier* verifier = mic_stream_.Verifier();
+    if (!verifier) {
+        Napi::Error::New(env, "Microphone capture with verifyVoice is not running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Voiceprint voiceprint;
+    std::string error;
+    if (!verifier->FinishEnrollment(&voiceprint, &error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<uint8_t> bytes = voiceprint.Serialize();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("voiceprint", Napi::Buffer<uint8_t>::Copy(env, bytes.data(), bytes.size()));
+    result.Set("speechSeconds", Napi::Number::New(env, voiceprint.frames / 100.0));
+    return result;
+}
+
+Napi::Value AudioCaptureAddon::CancelVoiceEnrollment(const Napi::CallbackInfo& info) {
+    if (VoiceVerifier* verifier = mic_stream_.Verifier()) {
+        verifier->CancelEnrollment();
+    }
+    return info.Env().Undefined();
+}
+
+// setVoiceprint(voiceprint | null): the user's voiceprint for the open mic
+// stream; null passes every voice again
+Napi::Value AudioCaptureAddon::SetVoiceprint(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    VoiceVerifier* verifier = mic_stream_.Verifier();
+    if (!verifier) {
+        Napi::Error::New(env, "Microphone capture with verifyVoice is not running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::shared_ptr<Voiceprint> voiceprint;
+    std::string error;
+    if (info.Length() > 0 && info[0].IsTypedArray() &&
+        info[0].As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array) {
+        Napi::Uint8Array bytes = info[0].As<Napi::Uint8Array>();
+        voiceprint = std::make_shared<Voiceprint>();
+        if (!Voiceprint::Parse(bytes.Data(), bytes.ByteLength(), voiceprint.get(), &error)) {
+            Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    } else if (info.Length() > 0 && !info[0].IsNull() && !info[0].IsUndefined()) {
+        Napi::TypeError::New(env, "Voiceprint Buffer or null required").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!verifier->SetVoiceprint(std::move(voiceprint), &error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return env.Undefined();
+}
+
+// getVoiceVerifierStats(): null unless the mic stream has a verifier
+Napi::Value AudioCaptureAddon::GetVoiceVerifierStats(const Napi::CallbackInfo& info) {
+    VoiceVerifier* verifier = mic_stream_.Verifier();
+    if (!verifier) {
+        return info.Env().Null();
+    }
+    return VoiceVerifierStatsToObject(info.Env(), verifier->GetStats());
+}
+
+// AEC METHODS - THE MISSING PIECE!
+
+// Render handed to the APM or the pipeline: interleaved float frames
+struct RenderInput {
+    const float* samples = nullptr;
+    size_t frames = 0;
+    int channels = 1;
+};
+
+// Render input is a Float32Array, used as is, or 16-bit PCM (an Int16Array,
+// or a Buffer of s16le unless |format| says 'f32'), converted into |scratch|.
+// PCM that does not already match |target_channels| is downmixed to mono in
+// the same pass, which the APM spreads over the reference layout. Throws and
+// returns false on a bad argument.
+static bool ResolveRenderInput(Napi::Env env, const Napi::Value& value, int channels, const Napi::Value& format_value,
+                               int target_channels, std::vector<float>* scratch, RenderInput* input) {
+    if (!value.IsTypedArray()) {
+        Napi::TypeError::New(env, "Expected Float32Array, Int16Array or Buffer").ThrowAsJavaScriptException();
+        return false;
+    }
+    if (channels < 1) {
+        Napi::RangeError::New(env, "Render channels must be at least 1").ThrowAsJavaScriptException();
+        return false;
+    }
+    
+    Napi::TypedArray array = value.As<Napi::TypedArray>();
+    napi_typedarray_type type = array.TypedArrayType();
+    std::string format = type == napi_float32_array ? "f32" : "s16le";
+    if (type == napi_uint8_array && format_value.IsString()) {
+        format = format_value.As<Napi::String>().Utf8Value();
+        if (format != "f32" && format != "s16le") {
+            Napi::TypeError::New(env, "Render format must be 'f32' or 's16le'").ThrowAsJavaScriptException();
+            return false;
+        }
+    } else if (type != napi_float32_array && type != napi_int16_array && type != napi_uint8_array) {
+        Napi::TypeError::New(env, "Expected Float32Array, Int16Array or Buffer").ThrowAsJavaScriptException();
+        return false;
+    }
+    
+    size_t sample_bytes = format == "f32" ? sizeof(float) : sizeof(int16_t);
+    size_t frame_bytes = sample_bytes * channels;
+    if (array.ByteLength() % frame_bytes != 0) {
+        Napi::RangeError::New(env, "Render length must be a whole number of frames").ThrowAsJavaScriptException();
+        return false;
+    }
+    size_t frames = array.ByteLength() / frame_bytes;
+    const uint8_t* bytes = static_cast<const uint8_t*>(array.ArrayBuffer().Data()) + array.ByteOffset();
+    input->frames = frames;
+    input->channels = channels;
+    
+    if (format == "f32") {
+        // Pooled Buffers may start at any byte offset; copy those
+        if (reinterpret_cast<uintptr_t>(bytes) % alignof(float) == 0) {
+            input->samples = reinterpret_cast<const float*>(bytes);
+            return true;
+        }
+        if (scratch->size() < frames * channels) {
+            scratch->resize(frames * channels);
+        }
+        std::memcpy(scratch->data(), bytes, frames * frame_bytes);
+        input->samples = scratch->data();
+        return true;
+    }
+    
+    if (reinterpret_cast<uintptr_t>(bytes) % alignof(int16_t) != 0) {
+        Napi::RangeError::New(env, "Render Buffer must be 2-byte aligned").ThrowAsJavaScriptException();
+        return false;
+    }
+    const int16_t* pcm = reinterpret_cast<const int16_t*>(bytes);
+    bool downmix = channels != target_channels;
+    size_t samples = downmix ? frames : frames * channels;
+    if (scratch->size() < samples) {
+        scratch->resize(samples);
+    }
+    if (downmix) {
+        dsp::DownmixS16(pcm, frames, channels, scratch->data());
+        input->channels = 1;
+    } else {
+        dsp::DownmixS16(pcm, samples, 1, scratch->data());
+    }
+    input->samples = scratch->data();
+    return true;
+}
+
+Napi::Value AudioCaptureAddon::ProcessRenderAudio(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!aec_processor_) {
+        return env.Undefined();
+    }
+    
+    if (info.Length() < 1) {
+        Napi::TypeError::New(env, "Expected Float32Array, Int16Array or Buffer").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    // Interleaved; defaults to the layout given at construction
+    int channels = render_channels_;
+    if (info.Length() > 2 && info[2].IsNumber()) {
+        channels = info[2].As<Napi::Number>().Int32Value();
+    }
+    RenderInput input;
+    if (!ResolveRenderInput(env, info[0], channels, info.Length() > 3 ? info[3] : env.Undefined(),
+                            render_channels_, &render_scratch_, &input)) {
+        return env.Null();
+    }
+    size_t frames = input.frames;
+    
+    // Processed mode: JS-side render (e.g. audiotee) becomes the pipeline's
+    // reference, unless the native tap already provides it. The optional
+    // timestamp (Date.now() domain, first sample) places it on the host clock;
+    // without one it is taken as just arrived and goes through the
+    // pipeline's jitter buffer.
+    if (aec_pipeline_.IsRunning()) {
+        if (tap_feeds_pipeline_.load(std::memory_order_acquire)) {
+            return env.Undefined();
+        }
+        if (info.Length() > 1 && info[1].IsNumber()) {
+            aec_pipeline_.PushRender(input.samples, static_cast<uint32_t>(frames), static_cast<uint32_t>(input.channels),
+                                     host_clock_.FromDateNowMs(info[1].As<Napi::Number>().DoubleValue()));
+        } else {
+            aec_pipeline_.PushArrivedRender(input.samples, static_cast<uint32_t>(frames),
+                                            static_cast<uint32_t>(input.channels));
+        }
+        return env.Undefined();
+    }
+    
+    try {
+        // Flush-to-zero for the call only; the JS thread's FP state is
+        // restored on return
+        webrtc::DenormalDisabler denormals;
+        aec_processor_->ProcessRenderAudio(input.samples, frames, input.channels);
+    } catch (const std::exception& e) {
+        Log(LogLevel::kError, kLogSource, "ProcessRenderAudio error: %s", e.what());
+    }
+    
+    return env.Undefined();
+}
+
+// Where synchronous capture processing leaves its result. The APM writes
+// float samples to |samples|; for s16le output those land in scratch and are
+// converted into |pcm| afterwards.
+struct CaptureOutput {
+    Napi::Value array;           // returned to JS
+    float* samples = nullptr;
+    int16_t* pcm = nullptr;
+};
+
+// Optional output for synchronous capture processing: a caller-owned
+// Float32Array (passing |input| itself cleans in place), a caller-owned
+// Int16Array or Buffer for s16le, or the format string 'f32' / 's16le' to
+// allocate one. Throws and returns false on a bad argument.
+static bool ResolveCaptureOutput(Napi::Env env, const Napi::Float32Array& input, const Napi::Value& value,
+                                 std::vector<float>* scratch, CaptureOutput* output) {
+    size_t num_samples = input.ElementLength();
+    std::string format = "f32";
+    if (value.IsString()) {
+        format = value.As<Napi::String>().Utf8Value();
+        if (format != "f32" && format != "s16le") {
+            Napi::TypeError::New(env, "Output format must be 'f32' or 's16le'").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+    
+    if (!value.IsTypedArray()) {
+        if (format == "s16le") {
+            Napi::Buffer<uint8_t> buffer = Napi::Buffer<uint8_t>::New(env, num_samples * sizeof(int16_t));
+            output->array = buffer;
+            output->pcm = reinterpret_cast<int16_t*>(buffer.Data());
+        } else {
+            Napi::Float32Array array = Napi::Float32Array::New(env, num_samples);
+            output->array = array;
+            output->samples = array.Data();
+            return true;
+        }
+    } else {
+        Napi::TypedArray target = value.As<Napi::TypedArray>();
+        napi_typedarray_type type = target.TypedArrayType();
+        if (type == napi_int16_array || type == napi_uint8_array) {
+            uint8_t* bytes = static_cast<uint8_t*>(target.ArrayBuffer().Data()) + target.ByteOffset();
+            if (target.ByteLength() < num_samples * sizeof(int16_t)) {
+                Napi::RangeError::New(env, "Output must hold 16-bit samples for the whole input").ThrowAsJavaScriptException();
+                return false;
+            }
+            if (reinterpret_cast<uintptr_t>(bytes) % alignof(int16_t) != 0) {
+                Napi::RangeError::New(env, "Output Buffer must be 2-byte aligned").ThrowAsJavaScriptException();
+                return false;
+            }
+            output->array = target;
+            output->pcm = reinterpret_cast<int16_t*>(bytes);
+        } else if (type != napi_float32_array || target.ElementLength() < num_samples) {
+            Napi::RangeError::New(env, "Output must be a Float32Array at least as long as the input").ThrowAsJavaScriptException();
+            return false;
+        } else {
+            Napi::Float32Array array = target.As<Napi::Float32Array>();
+            
+            // Exact aliasing is safe; a shifted overlap would overwrite unread input
+            const float* in_begin = input.Data();
+            const float* in_end = in_begin + num_samples;
+            const float* out_begin = array.Data();
+            const float* out_end = out_begin + num_samples;
+            if (out_begin != in_begin && out_begin < in_end && in_begin < out_end) {
+                Napi::RangeError::New(env, "Output may only overlap the input exactly").ThrowAsJavaScriptException();
+                return false;
+            }
+            output->array = array;
+            output->samples = array.Data();
+            return true;
+        }
+    }
+    
+    // s16le: processed in full before conversion, so any overlap with the input is harmless
+    if (scratch->size() < num_samples) {
+        scratch->resize(num_samples);
+    }
+    output->samples = scratch->data();
+    return true;
+}
+
+Napi::Value AudioCaptureAddon::ProcessCaptureAudio(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!aec_processor_) {
+        return env.Null();
+    }
+    
+    if (mic_feeds_pipeline_.load(std::memory_order_acquire)) {
+        Napi::Error::New(env, "Echo cancellation is running natively; capture is already processed").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsTypedArray()) {
+        Napi::TypeError::New(env, "Expected Float32Array").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Float32Array input = info[0].As<Napi::Float32Array>();
+    
+    // Async mode: queue for the DSP thread, cleaned audio arrives on the
+    // startAsyncProcessing() callback. The optional timestamp (Date.now()
+    // domain, first sample) aligns it with render.
+    if (aec_pipeline_.IsRunning()) {
+        uint64_t host_time = info.Length() > 1 && info[1].IsNumber()
+            ? host_clock_.FromDateNowMs(info[1].As<Napi::Number>().DoubleValue())
+            : HostTimeNow() - host_clock_.MsToTicks(input.ElementLength() * 1000.0 / kCaptureSampleRate);
+        CaptureStats& stats = async_stream_.Stats();
+        stats.callbacks.fetch_add(1, std::memory_order_relaxed);
+        bool queued = aec_pipeline_.PushCapture(input.Data(), static_cast<uint32_t>(input.ElementLength()), host_time);
+        (queued ? stats.buffers_captured : stats.buffers_dropped).fetch_add(1, std::memory_order_relaxed);
+        return Napi::Boolean::New(env, queued);
+    }
+    
+    CaptureOutput output;
+    if (!ResolveCaptureOutput(env, input, info.Length() > 1 ? info[1] : env.Undefined(), &pcm_scratch_, &output)) {
+        return env.Null();
+    }
+    
+    try {
+        webrtc::DenormalDisabler denormals;
+        aec_processor_->ProcessCaptureAudio(input.Data(), output.samples, input.ElementLength());
+    } catch (const std::exception& e) {
+        Log(LogLevel::kError, kLogSource, "ProcessCaptureAudio error: %s", e.what());
+        return env.Null();
+    }
+    
+    if (output.pcm) {
+        webrtc::FloatToS16(output.samples, input.ElementLength(), output.pcm);
+    }
+    return output.array;
+}
+
+// Weight of each new processSyncedPair() delay measurement, as in the pipeline
+static constexpr double kPairedDelaySmoothing = 0.05;
+
+// processSyncedPair(render, capture, renderTimestamp?, captureTimestamp?, output?)
+// One crossing per chunk: render is fed first, then capture is cleaned. With
+// both timestamps (Date.now() domain, first sample) the render->capture
+// offset plus playback latency becomes the APM's stream delay. Returns
+// { audio, rmsLevel, peakLevel, noiseFloor, speech, streamDelayMs }, or null on error.
+Napi::Value AudioCaptureAddon::ProcessSyncedPair(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!aec_processor_) {
+        return env.Null();
+    }
+    
+    if (aec_pipeline_.IsRunning()) {
+        Napi::Error::New(env, "Echo cancellation is running natively; use the pipeline instead").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    if (info.Length() < 2 || !info[0].IsTypedArray() || !info[1].IsTypedArray()) {
+        Napi::TypeError::New(env, "Expected render and capture Float32Arrays").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Float32Array render = info[0].As<Napi::Float32Array>();
+    Napi::Float32Array capture = info[1].As<Napi::Float32Array>();
+    if (render.ElementLength() % render_channels_ != 0) {
+        Napi::RangeError::New(env, "Render length must be a whole number of frames").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    CaptureOutput output;
+    if (!ResolveCaptureOutput(env, capture, info.Length() > 4 ? info[4] : env.Undefined(), &pcm_scratch_, &output)) {
+        return env.Null();
+    }
+    
+    size_t render_frames = render.ElementLength() / render_channels_;
+    if (info.Length() > 3 && info[2].IsNumber() && info[3].IsNumber()) {
+        // The devices' latencies are re-read only after device changes
+        uint64_t version = device_table_.Version();
+        if (version != paired_latency_version_) {
+            AudioDeviceID input;
+            {
+                std::lock_guard<std::mutex> lock(device_mutex_);
+                input = ResolveInputDevice();
+            }
+            paired_path_latency_ms_ = GetEchoPathLatency(input).TotalMs();
+            paired_latency_version_ = version;
+        }
+        
+        double render_end = info[2].As<Napi::Number>().DoubleValue() + render_frames * 1000.0 / kCaptureSampleRate;
+        double capture_end = info[3].As<Napi::Number>().DoubleValue() + capture.ElementLength() * 1000.0 / kCaptureSampleRate;
+        double delay_ms = std::max(0.0, render_end - capture_end + paired_path_latency_ms_);
+        paired_delay_ms_ = paired_delay_ms_ < 0.0
+            ? delay_ms
+            : paired_delay_ms_ + kPairedDelaySmoothing * (delay_ms - paired_delay_ms_);
+        aec_processor_->SetStreamDelayMs(static_cast<int>(paired_delay_ms_ + 0.5));
+    }
+    
+    try {
+        webrtc::DenormalDisabler denormals;
+        if (render_frames > 0) {
+            aec_processor_->ProcessRenderAudio(render.Data(), render_frames, render_channels_);
+        }
+        aec_processor_->ProcessCaptureAudio(capture.Data(), output.samples, capture.ElementLength());
+    } catch (const std::exception& e) {
+        Log(LogLevel::kError, kLogSource, "ProcessSyncedPair error: %s", e.what());
+        return env.Null();
+    }
+    
+    if (output.pcm) {
+        webrtc::FloatToS16(output.samples, capture.ElementLength(), output.pcm);
+    }
+    
+    // Only the cheap per-chunk levels; getMetrics() has the echo statistics
+    AECMetrics metrics = aec_processor_->GetLevels();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("audio", output.array);
+    result.Set("rmsLevel", Napi::Number::New(env, metrics.rms_level));
+    result.Set("peakLevel", Napi::Number::New(env, metrics.peak_level));
+    result.Set("noiseFloor", Napi::Number::New(env, metrics.noise_floor));
+    result.Set("speech", Napi::Boolean::New(env, metrics.speech));
+    result.Set("streamDelayMs", Napi::Number::New(env, metrics.stream_delay_ms));
+    return result;
+}
+
+// Async processing: processCaptureAudio() and processRenderAudio() only queue
+// buffers; the DSP thread owns the APM, aligns the two by timestamp and hands
+// cleaned capture to |callback| through the same delivery path as the mic.
+// Options are the start*Capture ones ('processed' is implied).
+Napi::Value AudioCaptureAddon::StartAsyncProcessing(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!aec_processor_) {
+        Napi::Error::New(env, "Async processing requires the AEC processor").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Callback function required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (aec_pipeline_.IsRunning()) {
         return Napi::Boolean::New(env, false);
     }
-    std::cout << "✅ Step 6: Set Float32 48kHz format on INPUT bus" << std::endl;
     
-    // STEP 7: Initialize AudioUnit
-    status = AudioUnitInitialize(mic_audio_unit_);
-    if (status != noErr) {
-        AudioComponentInstanceDispose(mic_audio_unit_);
-        std::cerr << "❌ Failed to initialize AudioUnit, error: " << status << std::endl;
-        Napi::Error::New(env, "Failed to initialize AudioUnit").ThrowAsJavaScriptException();
+    if (!mic_stream_.IsOpen() && !system_stream_.IsOpen()) {
+        host_clock_.Anchor();
+    }
+    
+    CaptureOptions options = ParseCaptureOptions(info.Length() > 1 ? info[1] : env.Undefined());
+    async_stream_.Open(env, info[0].As<Napi::Function>(), options, kCaptureSampleRate);
+    bool tap_render = tap_feeds_pipeline_.load(std::memory_order_acquire);
+    AudioDeviceID input;
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        input = ResolveInputDevice();
+    }
+    aec_pipeline_.Start(aec_processor_.get(), &async_stream_, kCaptureSampleRate, kCaptureSampleRate,
+                        tap_render ? kTapRenderWaitMs : kJsRenderWaitMs, ApplyEchoPathLatency(input));
+    std::cout << "✅ Async AEC processing started (render from " << (tap_render ? "tap" : "JS") << ")" << std::endl;
+    return Napi::Boolean::New(env, true);
+}
+
+// Flushes queued capture through the APM before the callback is released
+Napi::Value AudioCaptureAddon::StopAsyncProcessing(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!async_stream_.IsOpen()) {
         return Napi::Boolean::New(env, false);
     }
-    std::cout << "✅ Step 7: AudioUnit initialized" << std::endl;
-    
-    // STEP 8: Create HAL-level IOProc callback - FIXED VERSION
-    status = AudioDeviceCreateIOProcID(
-        device_id_,
-        [](AudioDeviceID inDevice,
-           const AudioTimeStamp* inNow,
-           const AudioBufferList* inInputData,
-           const AudioTimeStamp* inInputTime,
-           AudioBufferList* outOutputData,
-           const AudioTimeStamp* inOutputTime,
-           void* inClientData) -> OSStatus {
-            
-            AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(inClientData);
-            
-            // Safety checks
-            if (!self || !self->is_capturing_ || !self->tsfn_ || !inInputData || inInputData->mNumberBuffers == 0) {
-                return noErr;
+    
+    aec_pipeline_.Stop();
+    async_stream_.Close();
+    std::cout << "✅ Async AEC processing stopped" << std::endl;
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value AudioCaptureAddon::GetMetrics(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!aec_processor_) {
+        return env.Null();
+    }
+    
+    try {
+        return AECMetricsToObject(env, aec_processor_->GetMetrics());
+    } catch (const std::exception& e) {
+        Log(LogLevel::kError, kLogSource, "GetMetrics error: %s", e.what());
+        return env.Null();
+    }
+}
+
+// getMetrics(), then getCaptureStats() and getLatencyTrace() per stream, in
+// slot order; the AEC's slots are unset without a processor
+void AudioCaptureAddon::WriteMetrics(MetricsWriter* writer) {
+    writer->SetPrefix("aec.");
+    WriteAECMetrics(writer, aec_processor_ ? aec_processor_->GetMetrics() : AECMetrics{});
+    const struct {
+        const char* stats_prefix;
+        const char* trace_prefix;
+        const CaptureStream& stream;
+    } streams[] = {
+        { "mic.", "micTrace.", mic_stream_ },
+        { "system.", "systemTrace.", system_stream_ },
+        { "async.", "asyncTrace.", async_stream_ },
+    };
+    for (const auto& entry : streams) {
+        writer->SetPrefix(entry.stats_prefix);
+        WriteCaptureStats(writer, entry.stream.Stats(), host_clock_);
+        writer->SetPrefix(entry.trace_prefix);
+        WriteLatencyTrace(writer, entry.stream.Trace());
+    }
+}
+
+// readMetrics(Float64Array) -> the layout's length. Fills the array at
+// getMetricsLayout()'s offsets as far as it reaches, allocating nothing, so
+// it can be polled every display frame.
+Napi::Value AudioCaptureAddon::ReadMetrics(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float64_array) {
+        Napi::TypeError::New(env, "Expected a Float64Array").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Float64Array out = info[0].As<Napi::Float64Array>();
+    MetricsWriter writer(out.Data(), out.ElementLength());
+    WriteMetrics(&writer);
+    return Napi::Number::New(env, static_cast<double>(writer.Count()));
+}
+
+// getMetricsLayout() -> { length, offsets }: where readMetrics() puts each value
+Napi::Value AudioCaptureAddon::GetMetricsLayout(const Napi::CallbackInfo& info) {
+    std::vector<std::string> names;
+    MetricsWriter writer(&names);
+    WriteMetrics(&writer);
+    return MetricsLayoutToObject(info.Env(), names);
+}
+
+// getAecProfile() -> { echoDelayMs?, streamDelayMs?, preset?, inputDeviceUid,
+// outputDeviceUid }: what this session converged to, keyed by the devices it
+// ran on. Passed back as the warmStart option on the same devices.
+Napi::Value AudioCaptureAddon::GetAecProfile(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!aec_processor_) {
+        return env.Null();
+    }
+    
+    Napi::Object profile = AECWarmStartToObject(env, aec_processor_->GetWarmStart());
+    AudioDeviceID input;
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        input = is_capturing_ ? device_id_ : ResolveInputDevice();
+    }
+    AudioDeviceID output = output_route_.Current().device;
+    std::shared_ptr<const DeviceList> devices = device_table_.Snapshot();
+    for (const AudioDeviceInfo& device : *devices) {
+        if (device.id == input) {
+            profile.Set("inputDeviceUid", device.uid);
+        }
+        if (device.id == output) {
+            profile.Set("outputDeviceUid", device.uid);
+        }
+    }
+    return profile;
+}
+
+// getNoiseProfile() -> { noiseFloor, bandsDb, frames, inputDeviceUid } or
+// null: the mic's noise as heard this session, keyed by the input it ran
+// on. Passed back as the noiseProfile option on the same input.
+Napi::Value AudioCaptureAddon::GetNoiseProfile(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::optional<NoiseProfile> learned = aec_processor_ ? aec_processor_->GetNoiseProfile() : std::nullopt;
+    if (!learned) {
+        return env.Null();
+    }
+    Napi::Object profile = NoiseProfileToObject(env, *learned);
+    AudioDeviceID input;
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        input = is_capturing_ ? device_id_ : ResolveInputDevice();
+    }
+    std::shared_ptr<const DeviceList> devices = device_table_.Snapshot();
+    for (const AudioDeviceInfo& device : *devices) {
+        if (device.id == input) {
+            profile.Set("inputDeviceUid", device.uid);
+        }
+    }
+    return profile;
+}
+
+// setAecProfiles([{ inputDeviceUid, outputDeviceUid, ...warmStart }]): the
+// stored profiles a device switch mid-session seeds the canceller from
+Napi::Value AudioCaptureAddon::SetAecProfiles(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected an array of profiles").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    aec_profiles_.Set(ParseAECProfiles(info[0]));
+    return env.Undefined();
+}
+
+// resetEchoPath(warmStart?) -> sequence: for a route change the listeners
+// cannot see. Without a warm start, the current devices' stored profile
+// seeds it. 0 without an AEC.
+Napi::Value AudioCaptureAddon::ResetEchoPath(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!aec_processor_) {
+        return Napi::Number::New(env, 0);
+    }
+    AECWarmStart seed;
+    if (info.Length() > 0 && info[0].IsObject()) {
+        seed = ParseAECWarmStart(info[0]);
+    } else {
+        AudioDeviceID input;
+        {
+            std::lock_guard<std::mutex> lock(device_mutex_);
+            input = is_capturing_ ? device_id_ : ResolveInputDevice();
+        }
+        AudioDeviceID output = output_route_.Current().device;
+        std::string input_uid;
+        std::string output_uid;
+        std::shared_ptr<const DeviceList> devices = device_table_.Snapshot();
+        for (const AudioDeviceInfo& device : *devices) {
+            if (device.id == input) {
+                input_uid = device.uid;
+            }
+            if (device.id == output) {
+                output_uid = device.uid;
+            }
+        }
+        seed = aec_profiles_.Find(input_uid, output_uid).value_or(AECWarmStart());
+    }
+    uint64_t sequence = aec_processor_->ResetEchoPath(seed, EchoPathChange::kRequested);
+    return Napi::Number::New(env, static_cast<double>(sequence));
+}
+
+// The echo path moved from one input/output pair to another while the mic
+// runs through the AEC. What the session learned on the pair it leaves is
+// kept for moving back; the new pair's stored profile, if any, seeds the
+// fresh canceller, so it does not readapt from the old filter and delay.
+void AudioCaptureAddon::ResetEchoPathFor(AudioDeviceID from_input, AudioDeviceID from_output, AudioDeviceID input,
+                                         AudioDeviceID output, EchoPathChange reason) {
+    if (!aec_processor_ || !mic_feeds_pipeline_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::string uids[4];
+    const AudioDeviceID ids[4] = { from_input, from_output, input, output };
+    std::shared_ptr<const DeviceList> devices = device_table_.Snapshot();
+    for (const AudioDeviceInfo& device : *devices) {
+        for (int i = 0; i < 4; ++i) {
+            if (device.id == ids[i]) {
+                uids[i] = device.uid;
+            }
+        }
+    }
+    aec_profiles_.Remember(uids[0], uids[1], aec_processor_->GetWarmStart());
+    aec_processor_->ResetEchoPath(aec_profiles_.Find(uids[2], uids[3]).value_or(AECWarmStart()), reason);
+}
+
+// startShadowAec(candidate, maxLoad?): runs |candidate| (AEC options over
+// the live configuration) beside the live canceller on the pipeline's
+// frames, its output discarded, under |maxLoad| of one core (default 5%).
+// Throws when it cannot run.
+Napi::Value AudioCaptureAddon::StartShadowAec(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!aec_processor_) {
+        Napi::Error::New(env, "Shadow evaluation requires the AEC processor").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    AECConfig candidate = ParseAECConfig(info.Length() > 0 ? info[0] : env.Undefined(), aec_processor_->GetConfig());
+    float max_load = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().FloatValue() : 0.0f;
+    std::string error;
+    if (!shadow_aec_.Start(aec_processor_.get(), candidate, static_cast<int>(kCaptureSampleRate), render_channels_,
+                           max_load, &error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::StopShadowAec(const Napi::CallbackInfo& info) {
+    shadow_aec_.Stop();
+    return info.Env().Undefined();
+}
+
+// getShadowComparison(): the running (or last) evaluation's means, for
+// opt-in collection
+Napi::Value AudioCaptureAddon::GetShadowComparison(const Napi::CallbackInfo& info) {
+    return ShadowAecComparisonToObject(info.Env(), shadow_aec_.GetComparison());
+}
+
+Napi::Value AudioCaptureAddon::SetEchoCancellationEnabled(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (!aec_processor_) {
+        return env.Undefined();
+    }
+    
+    if (info.Length() < 1 || !info[0].IsBoolean()) {
+        Napi::TypeError::New(env, "Expected boolean").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    
+    bool enabled = info[0].As<Napi::Boolean>().Value();
+    
+    try {
+        aec_processor_->SetEchoCancellationEnabled(enabled);
+    } catch (const std::exception& e) {
+        std::cerr << "❌ SetEchoCancellationEnabled error: " << e.what() << std::endl;
+    }
+    
+    return env.Undefined();
+}
+
+// setHeadphoneBypass(bypass | 'auto'): skip the APM while headphones are in
+// use, keeping the canceller on standby for when they are removed. 'auto'
+// follows the output route natively from then on.
+Napi::Value AudioCaptureAddon::SetHeadphoneBypass(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    bool bypass;
+    if (info.Length() > 0 && info[0].IsString() && info[0].As<Napi::String>().Utf8Value() == "auto") {
+        auto_bypass_ = true;
+        bypass = output_route_.Headphones();
+    } else if (info.Length() > 0 && info[0].IsBoolean()) {
+        auto_bypass_ = false;
+        bypass = info[0].As<Napi::Boolean>().Value();
+    } else {
+        Napi::TypeError::New(env, "Expected boolean or 'auto'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (aec_processor_) {
+        aec_processor_->SetBypass(bypass);
+    }
+    return env.Undefined();
+}
+
+// setVoiceProcessingBypass(bypass): with engine 'voiceProcessing', pass the
+// mic through the voice unit unprocessed (no AEC, AGC or NS). Applies now
+// if the unit is built, else from the next start.
+Napi::Value AudioCaptureAddon::SetVoiceProcessingBypass(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsBoolean()) {
+        Napi::TypeError::New(env, "Expected boolean").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    bool bypass = info[0].As<Napi::Boolean>().Value();
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    voice_bypassed_ = bypass;
+    if (mic_engine_ == MicEngine::kVoiceProcessing && mic_audio_unit_) {
+        UInt32 value = bypass ? 1 : 0;
+        OSStatus status = AudioUnitSetProperty(mic_audio_unit_, kAUVoiceIOProperty_BypassVoiceProcessing,
+                                               kAudioUnitScope_Global, 0, &value, sizeof(value));
+        if (status != noErr) {
+            Log(LogLevel::kWarn, kLogSource, "Voice processing bypass failed, error: %d", static_cast<int>(status));
+        }
+    }
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::IsHeadphonesConnected(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), output_route_.Headphones());
+}
+
+// Whether the running mic capture goes through the AEC pipeline; a processed
+// start on a hands-free headset, or with the voice engine, does not
+Napi::Value AudioCaptureAddon::IsMicrophoneProcessed(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), mic_feeds_pipeline_.load(std::memory_order_acquire));
+}
+
+// HAL notification thread. The bypass switches here, so it takes effect at
+// the next capture frame rather than after a JS round trip.
+void AudioCaptureAddon::OnOutputRouteChanged(bool headphones) {
+    if (auto_bypass_ && aec_processor_) {
+        aec_processor_->SetBypass(headphones);
+    }
+    if (route_tsfn_ready_.load(std::memory_order_acquire)) {
+        route_tsfn_.NonBlockingCall([this, headphones](Napi::Env env, Napi::Function) {
+            if (route_callback_.IsEmpty()) {
+                return;
             }
-            
             try {
-                // Extract audio data from first buffer
-                AudioBuffer buffer = inInputData->mBuffers[0];
-                if (!buffer.mData || buffer.mDataByteSize == 0) {
-                    return noErr;
-                }
-                
-                float* audioData = (float*)buffer.mData;
-                UInt32 numSamples = buffer.mDataByteSize / sizeof(float);
-                
-                // Sanity check
-                if (numSamples == 0 || numSamples > 48000) {
-                    return noErr;
-                }
-                
-                // Get timestamp in milliseconds since Unix epoch (matching Date.now() in JavaScript)
-                auto now = std::chrono::system_clock::now();
-                auto ms_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now.time_since_epoch()
-                ).count();
-                double timestamp_ms = static_cast<double>(ms_since_epoch);
-                
-                // Copy to vector
-                std::vector<float>* samples = new std::vector<float>(audioData, audioData + numSamples);
-                
-                // Send to JavaScript
-                struct CallbackData {
-                    std::vector<float>* samples;
-                    double timestamp;
-                };
-                
-                CallbackData* data = new CallbackData{samples, timestamp_ms};
-                
-                napi_status napistatus = self->tsfn_.NonBlockingCall(data, [](Napi::Env env, Napi::Function jsCallback, CallbackData* data) {
-                    try {
-                        // Create Float32Array with the audio samples
-                        Napi::Float32Array samplesArray = Napi::Float32Array::New(env, data->samples->size());
-                        memcpy(samplesArray.Data(), data->samples->data(), data->samples->size() * sizeof(float));
-                        
-                        // THE FIX: Call JavaScript callback with (samples, timestamp) as separate parameters
-                        jsCallback.Call({
-                            samplesArray,
-                            Napi::Number::New(env, data->timestamp)
-                        });
-                    } catch (...) {
-                        // Silently catch to prevent crash
-                    }
-                    
-                    delete data->samples;
-                    delete data;
-                });
-                
-                if (napistatus != napi_ok) {
-                    delete samples;
-                    delete data;
-                }
+                route_callback_.Call({ Napi::Boolean::New(env, headphones) });
             } catch (...) {
-                // Catch all exceptions
+                // Silently catch to prevent crash
             }
-            
-            return noErr;
-        },
-        this,
-        &io_proc_id_);
-    
-    if (status != noErr) {
-        AudioUnitUninitialize(mic_audio_unit_);
-        AudioComponentInstanceDispose(mic_audio_unit_);
-        std::cerr << "❌ Failed to create IOProc, error: " << status << std::endl;
-        Napi::Error::New(env, "Failed to create IOProc").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
+        });
     }
-    std::cout << "✅ Step 8: Created HAL IOProc callback" << std::endl;
-    
-    // STEP 9: Start audio device
-    status = AudioDeviceStart(device_id_, io_proc_id_);
-    if (status != noErr) {
-        AudioDeviceDestroyIOProcID(device_id_, io_proc_id_);
-        AudioUnitUninitialize(mic_audio_unit_);
-        AudioComponentInstanceDispose(mic_audio_unit_);
-        std::cerr << "❌ Failed to start AudioDevice, error: " << status << std::endl;
-        Napi::Error::New(env, "Failed to start AudioDevice").ThrowAsJavaScriptException();
-        return Napi::Boolean::New(env, false);
+}
+
+// HAL notification thread: another output (or data source), so another
+// echo path, whether or not the headphone state changed with it
+void AudioCaptureAddon::OnOutputPathChanged(const OutputRouteInfo& from, const OutputRouteInfo& to) {
+    AudioDeviceID input;
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        if (!is_capturing_) {
+            return;
+        }
+        input = device_id_;
     }
-    std::cout << "✅ Step 9: AudioDevice started!" << std::endl;
-    
-    is_capturing_ = true;
-    std::cout << "🎉 MIC CAPTURE FULLY STARTED (Granola pattern)! HAL IOProc will deliver audio." << std::endl;
-    
-    return Napi::Boolean::New(env, true);
+    if (mic_feeds_pipeline_.load(std::memory_order_acquire)) {
+        ApplyEchoPathLatency(input);
+    }
+    ResetEchoPathFor(input, from.device, input, to.device, EchoPathChange::kOutputDevice);
 }
 
-Napi::Value AudioCaptureAddon::StopMicrophoneCapture(const Napi::CallbackInfo& info) {
+// The hardware part of the echo delay for |input| and the default output,
+// to the pipeline from here on. Replaces a calibrated round trip, which was
+// for the route before.
+double AudioCaptureAddon::ApplyEchoPathLatency(AudioDeviceID input) {
+    EchoPathLatency latency = GetEchoPathLatency(input);
+    double total_ms = latency.TotalMs();
+    echo_latency_ms_.store(total_ms, std::memory_order_relaxed);
+    echo_latency_calibrated_.store(false, std::memory_order_relaxed);
+    aec_pipeline_.SetOutputLatencyMs(total_ms);
+    Log(LogLevel::kInfo, kLogSource, "Echo path latency %.1fms: output %.1fms, input %.1fms",
+        total_ms, latency.output.TotalMs(), latency.input.TotalMs());
+    return total_ms;
+}
+
+// getEchoPathLatency() -> { totalMs, output, input, appliedMs, calibrated }:
+// the analytic render->capture hardware delay for the current devices, each
+// side as { totalMs, deviceMs, safetyOffsetMs, streamMs, bufferMs }, and
+// what the pipeline adds to the measured lead (the round trip once
+// calibrated)
+Napi::Value AudioCaptureAddon::GetEchoPathLatencyInfo(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (!is_capturing_) {
-        return Napi::Boolean::New(env, false);
+    AudioDeviceID input;
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        input = is_capturing_ ? device_id_ : ResolveInputDevice();
     }
+    EchoPathLatency latency = GetEchoPathLatency(input);
+    auto side = [&](const DeviceLatency& part) {
+        Napi::Object object = Napi::Object::New(env);
+        object.Set("totalMs", part.TotalMs());
+        object.Set("deviceMs", part.device_ms);
+        object.Set("safetyOffsetMs", part.safety_ms);
+        object.Set("streamMs", part.stream_ms);
+        object.Set("bufferMs", part.buffer_ms);
+        return object;
+    };
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("totalMs", latency.TotalMs());
+    result.Set("output", side(latency.output));
+    result.Set("input", side(latency.input));
+    result.Set("appliedMs", echo_latency_ms_.load(std::memory_order_relaxed));
+    result.Set("calibrated", echo_latency_calibrated_.load(std::memory_order_relaxed));
+    return result;
+}
+
+// Registers (or with null, clears) the headphoneStatusChanged listener,
+// called with the new state whenever the output route flips
+Napi::Value AudioCaptureAddon::OnHeadphoneStatusChanged(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    std::cout << "🛑 Stopping microphone capture..." << std::endl;
-    
-    is_capturing_ = false;
-    
-    // Stop and cleanup in reverse order
-    if (device_id_ != kAudioObjectUnknown && io_proc_id_ != nullptr) {
-        AudioDeviceStop(device_id_, io_proc_id_);
-        AudioDeviceDestroyIOProcID(device_id_, io_proc_id_);
-        io_proc_id_ = nullptr;
+    if (info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined()) {
+        route_callback_.Reset();
+        return env.Undefined();
     }
-    
-    if (mic_audio_unit_) {
-        AudioUnitUninitialize(mic_audio_unit_);
-        AudioComponentInstanceDispose(mic_audio_unit_);
-        mic_audio_unit_ = nullptr;
+    if (!info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected callback function or null").ThrowAsJavaScriptException();
+        return env.Undefined();
     }
     
-    if (tsfn_) {
-        tsfn_.Release();
-    }
+    route_callback_ = Napi::Persistent(info[0].As<Napi::Function>());
     
-    std::cout << "✅ Microphone capture stopped" << std::endl;
+    // As devicesChanged: one TSFN for the addon's lifetime
+    if (!route_tsfn_) {
+        route_tsfn_ = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "HeadphoneStatusChanged", 0, 1);
+        route_tsfn_.Unref(env);
+        route_tsfn_ready_.store(true, std::memory_order_release);
+    }
     
-    return Napi::Boolean::New(env, true);
+    return env.Undefined();
 }
 
-// AEC METHODS - THE MISSING PIECE!
-
-Napi::Value AudioCaptureAddon::ProcessRenderAudio(const Napi::CallbackInfo& info) {
+// Registers (or with null, clears) the captureRecovered listener, called
+// with { reason, gapMs, deviceId } when mic capture runs again after the
+// device went away or the system slept
+Napi::Value AudioCaptureAddon::OnCaptureRecovered(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (!aec_processor_) {
+    if (info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined()) {
+        recovery_callback_.Reset();
         return env.Undefined();
     }
-    
-    if (info.Length() < 1 || !info[0].IsTypedArray()) {
-        Napi::TypeError::New(env, "Expected Float32Array").ThrowAsJavaScriptException();
-        return env.Null();
+    if (!info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected callback function or null").ThrowAsJavaScriptException();
+        return env.Undefined();
     }
     
-    Napi::Float32Array input = info[0].As<Napi::Float32Array>();
+    recovery_callback_ = Napi::Persistent(info[0].As<Napi::Function>());
     
-    try {
-        aec_processor_->ProcessRenderAudio(input.Data(), input.ElementLength());
-    } catch (const std::exception& e) {
-        std::cerr << "❌ ProcessRenderAudio error: " << e.what() << std::endl;
+    if (!recovery_tsfn_) {
+        recovery_tsfn_ = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "CaptureRecovered", 0, 1);
+        recovery_tsfn_.Unref(env);
+        recovery_tsfn_ready_.store(true, std::memory_order_release);
     }
     
     return env.Undefined();
 }
 
-Napi::Value AudioCaptureAddon::ProcessCaptureAudio(const Napi::CallbackInfo& info) {
+// configure({ preset?, enableAec?, enableNs?, nsLevel?, enableAgc? }) -> boolean.
+// Unspecified fields keep their current values; capture keeps running.
+Napi::Value AudioCaptureAddon::Configure(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
     if (!aec_processor_) {
-        return env.Null();
+        return Napi::Boolean::New(env, false);
     }
     
-    if (info.Length() < 1 || !info[0].IsTypedArray()) {
-        Napi::TypeError::New(env, "Expected Float32Array").ThrowAsJavaScriptException();
-        return env.Null();
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return env.Undefined();
     }
     
-    Napi::Float32Array input = info[0].As<Napi::Float32Array>();
-    Napi::Float32Array output = Napi::Float32Array::New(env, input.ElementLength());
+    std::lock_guard<std::mutex> lock(power_profile_mutex_);
+    if (low_power_) {
+        aec_base_config_ = ParseAECConfig(info[0], aec_base_config_);
+        return Napi::Boolean::New(env, aec_processor_->Configure(ApplyLowPowerProfile(aec_base_config_)));
+    }
+    AECConfig config = ParseAECConfig(info[0], aec_processor_->GetConfig());
+    return Napi::Boolean::New(env, aec_processor_->Configure(config));
+}
+
+// setPowerProfile('normal' | 'lowPower' | 'auto') -> whether low power is now
+// in effect. 'auto' goes low power on battery and back on AC.
+Napi::Value AudioCaptureAddon::SetPowerProfile(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    try {
-        aec_processor_->ProcessCaptureAudio(input.Data(), output.Data(), input.ElementLength());
-    } catch (const std::exception& e) {
-        std::cerr << "❌ ProcessCaptureAudio error: " << e.what() << std::endl;
-        return env.Null();
+    PowerProfile profile;
+    if (info.Length() < 1 || !ParsePowerProfile(info[0], &profile)) {
+        Napi::TypeError::New(env, "Expected 'normal', 'lowPower' or 'auto'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    {
+        std::lock_guard<std::mutex> lock(power_profile_mutex_);
+        power_profile_ = profile;
+    }
+    UpdatePowerProfile();
+    std::lock_guard<std::mutex> lock(power_profile_mutex_);
+    return Napi::Boolean::New(env, low_power_);
+}
+
+// JS thread or the power queue. Delivery batching changes at the next
+// consumer wake; the APM is rebuilt at 16kHz and re-converges, and again on
+// the way back. Toggles made meanwhile (warm start, AEC switch) carry over.
+void AudioCaptureAddon::UpdatePowerProfile() {
+    std::lock_guard<std::mutex> lock(power_profile_mutex_);
+    bool low_power = power_profile_ == PowerProfile::kLowPower ||
+                     (power_profile_ == PowerProfile::kAuto && power_monitor_.OnBattery());
+    if (low_power == low_power_) {
+        return;
     }
+    low_power_ = low_power;
     
-    return output;
+    double min_delivery_ms = low_power ? kLowPowerDeliveryMs : 0.0;
+    mic_stream_.SetMinDeliveryIntervalMs(min_delivery_ms);
+    system_stream_.SetMinDeliveryIntervalMs(min_delivery_ms);
+    async_stream_.SetMinDeliveryIntervalMs(min_delivery_ms);
+    if (aec_processor_) {
+        if (low_power) {
+            aec_base_config_ = aec_processor_->GetConfig();
+            aec_processor_->PostConfig(ApplyLowPowerProfile(aec_base_config_));
+        } else {
+            AECConfig current = aec_processor_->GetConfig();
+            AECConfig restored = aec_base_config_;
+            restored.enable_aec = current.enable_aec;
+            restored.warm_start = current.warm_start;
+            aec_processor_->PostConfig(restored);
+        }
+    }
+    Log(LogLevel::kInfo, kLogSource, low_power ? "Low-power profile on" : "Low-power profile off");
 }
 
-Napi::Value AudioCaptureAddon::GetMetrics(const Napi::CallbackInfo& info) {
+Napi::Value AudioCaptureAddon::GetConfig(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
     if (!aec_processor_) {
         return env.Null();
     }
     
-    try {
-        AECMetrics metrics = aec_processor_->GetMetrics();
-        
-        Napi::Object result = Napi::Object::New(env);
-        result.Set("echoReturnLoss", metrics.echo_return_loss);
-        result.Set("echoReturnLossEnhancement", metrics.echo_return_loss_enhancement);
-        result.Set("renderDelayMs", metrics.render_delay_ms);
-        result.Set("aecConverged", metrics.aec_converged);
-        result.Set("rmsLevel", metrics.rms_level);
-        result.Set("peakLevel", metrics.peak_level);
-        
-        return result;
-    } catch (const std::exception& e) {
-        std::cerr << "❌ GetMetrics error: " << e.what() << std::endl;
+    return AECConfigToObject(env, aec_processor_->GetConfig());
+}
+
+// postConfig(options) -> sequence number: configure() without waiting on the
+// processing threads. The change goes through the processor's mailbox and
+// applies at the next capture frame boundary; getConfigStatus() tells when.
+// 0 without a processor.
+Napi::Value AudioCaptureAddon::PostConfig(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        return Napi::Number::New(env, 0);
+    }
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    std::lock_guard<std::mutex> lock(power_profile_mutex_);
+    AECConfig config;
+    if (low_power_) {
+        aec_base_config_ = ParseAECConfig(info[0], aec_base_config_);
+        config = ApplyLowPowerProfile(aec_base_config_);
+    } else {
+        config = ParseAECConfig(info[0], aec_processor_->GetConfig());
+    }
+    return Napi::Number::New(env, static_cast<double>(aec_processor_->PostConfig(config)));
+}
+
+// getConfigStatus() -> { posted, applied, rejected, pending, appliedFrame,
+// latencyMs }: where postConfig()'s changes stand
+Napi::Value AudioCaptureAddon::GetConfigStatus(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
         return env.Null();
     }
+
+    return AECConfigStatusToObject(env, aec_processor_->GetConfigStatus());
 }
 
-Napi::Value AudioCaptureAddon::SetEchoCancellationEnabled(const Napi::CallbackInfo& info) {
+// startAecDump(path, maxBytes = -1): records the APM's streams and config
+// for offline tuning; the dump thread does the writing
+Napi::Value AudioCaptureAddon::StartAecDump(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (!aec_processor_) {
-        return env.Undefined();
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected dump file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int64_t max_bytes = -1;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        max_bytes = info[1].As<Napi::Number>().Int64Value();
+        if (max_bytes <= 0) {
+            max_bytes = -1;
+        }
     }
     
-    if (info.Length() < 1 || !info[0].IsBoolean()) {
-        Napi::TypeError::New(env, "Expected boolean").ThrowAsJavaScriptException();
+    bool started = aec_processor_ &&
+        aec_processor_->StartAecDump(info[0].As<Napi::String>().Utf8Value(), max_bytes);
+    return Napi::Boolean::New(env, started);
+}
+
+Napi::Value AudioCaptureAddon::StopAecDump(const Napi::CallbackInfo& info) {
+    if (aec_processor_) {
+        aec_processor_->StopAecDump();
+    }
+    return info.Env().Undefined();
+}
+
+Napi::Array AudioCaptureAddon::BuildDeviceArray(Napi::Env env) {
+    std::shared_ptr<const DeviceList> snapshot = device_table_.Snapshot();
+    Napi::Array devices = Napi::Array::New(env, snapshot->size());
+    
+    uint32_t index = 0;
+    for (const AudioDeviceInfo& info : *snapshot) {
+        Napi::Object device = Napi::Object::New(env);
+        device.Set("id", std::to_string(info.id));
+        device.Set("uid", info.uid);
+        device.Set("name", info.name);
+        device.Set("isDefault", info.is_default_input);
+        device.Set("isDefaultOutput", info.is_default_output);
+        device.Set("transport", info.transport);
+        device.Set("nominalSampleRate", Napi::Number::New(env, info.nominal_sample_rate));
+        device.Set("bufferFrameSize", Napi::Number::New(env, info.buffer_frame_size));
+        device.Set("bufferFrameSizeMin", Napi::Number::New(env, info.buffer_frame_min));
+        device.Set("bufferFrameSizeMax", Napi::Number::New(env, info.buffer_frame_max));
+        device.Set("inputChannels", Napi::Number::New(env, info.input_channels));
+        device.Set("outputChannels", Napi::Number::New(env, info.output_channels));
+        devices.Set(index++, device);
+    }
+    return devices;
+}
+
+// Served from the listener-maintained table in O(1)
+Napi::Value AudioCaptureAddon::GetDevices(const Napi::CallbackInfo& info) {
+    return CachedDeviceArray(info.Env());
+}
+
+// The JS array is only rebuilt when the table version moves
+Napi::Value AudioCaptureAddon::CachedDeviceArray(Napi::Env env) {
+    uint64_t version = device_table_.Version();
+    if (devices_cache_.IsEmpty() || version != devices_cache_version_) {
+        devices_cache_ = Napi::Persistent(Napi::Object(BuildDeviceArray(env)));
+        devices_cache_version_ = version;
+    }
+    return devices_cache_.Value();
+}
+
+// Registers (or with null, clears) the devicesChanged listener. The callback
+// receives the full device array after every HAL device/default change.
+Napi::Value AudioCaptureAddon::OnDevicesChanged(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined()) {
+        devices_callback_.Reset();
+        return env.Undefined();
+    }
+    if (!info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected callback function or null").ThrowAsJavaScriptException();
         return env.Undefined();
     }
     
-    bool enabled = info[0].As<Napi::Boolean>().Value();
+    devices_callback_ = Napi::Persistent(info[0].As<Napi::Function>());
     
-    try {
-        aec_processor_->SetEchoCancellationEnabled(enabled);
-    } catch (const std::exception& e) {
-        std::cerr << "❌ SetEchoCancellationEnabled error: " << e.what() << std::endl;
+    // One TSFN for the addon's lifetime; the JS callback is looked up per call
+    // so swapping listeners never races a HAL notification
+    if (!devices_tsfn_) {
+        devices_tsfn_ = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "DevicesChanged", 0, 1);
+        devices_tsfn_.Unref(env);
+        
+        Napi::ThreadSafeFunction tsfn = devices_tsfn_;
+        device_table_.SetChangeCallback([this, tsfn]() mutable {
+            tsfn.NonBlockingCall([this](Napi::Env env, Napi::Function) {
+                if (devices_callback_.IsEmpty()) {
+                    return;
+                }
+                try {
+                    devices_callback_.Call({ CachedDeviceArray(env) });
+                } catch (...) {
+                    // Silently catch to prevent crash
+                }
+            });
+        });
     }
     
     return env.Undefined();
 }
 
-Napi::Value AudioCaptureAddon::GetDevices(const Napi::CallbackInfo& info) {
+// Pins capture to a device id from getDevices(), or follows the system
+// default when called with null/empty. Applies immediately while capturing.
+Napi::Value AudioCaptureAddon::SetInputDevice(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    Napi::Array devices = Napi::Array::New(env);
     
-    AudioObjectPropertyAddress propertyAddress = {
-        kAudioHardwarePropertyDevices,
-        kAudioObjectPropertyScopeGlobal,
-        kAudioObjectPropertyElementMain
-    };
+    std::string id;
+    if (info.Length() > 0 && info[0].IsString()) {
+        id = info[0].As<Napi::String>().Utf8Value();
+    } else if (info.Length() > 0 && !info[0].IsNull() && !info[0].IsUndefined()) {
+        Napi::TypeError::New(env, "Expected device id string or null").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
     
-    UInt32 dataSize = 0;
-    OSStatus status = AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &propertyAddress, 0, nullptr, &dataSize);
-    if (status != noErr) {
-        return devices;
+    if (!id.empty()) {
+        if (id.find_first_not_of("0123456789") != std::string::npos ||
+            !DeviceHasInput(static_cast<AudioDeviceID>(std::stoul(id)))) {
+            Napi::Error::New(env, "Unknown input device: " + id).ThrowAsJavaScriptException();
+            return Napi::Boolean::New(env, false);
+        }
+    }
+    
+    AudioDeviceID target;
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        selected_device_id_ = id;
+        target = ResolveInputDevice();
     }
     
-    UInt32 deviceCount = dataSize / sizeof(AudioDeviceID);
-    AudioDeviceID* audioDevices = (AudioDeviceID*)malloc(dataSize);
+    std::cout << "🎤 Input device set to " << (id.empty() ? "system default" : id) << std::endl;
+    return Napi::Boolean::New(env, SwitchInputDevice(target));
+}
+
+// Device currently captured from (or that the next start would use)
+Napi::Value AudioCaptureAddon::GetInputDevice(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    status = AudioObjectGetPropertyData(kAudioObjectSystemObject, &propertyAddress, 0, nullptr, &dataSize, audioDevices);
-    if (status != noErr) {
-        free(audioDevices);
-        return devices;
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    AudioDeviceID device = is_capturing_ ? device_id_ : ResolveInputDevice();
+    if (device == kAudioObjectUnknown) {
+        return env.Null();
     }
     
-    uint32_t deviceIndex = 0;
-    for (UInt32 i = 0; i < deviceCount; i++) {
-        AudioDeviceID deviceID = audioDevices[i];
-        
-        // Check if device has input
-        AudioObjectPropertyAddress inputAddress = {
-            kAudioDevicePropertyStreamConfiguration,
-            kAudioDevicePropertyScopeInput,
-            kAudioObjectPropertyElementMain
-        };
-        
-        status = AudioObjectGetPropertyDataSize(deviceID, &inputAddress, 0, nullptr, &dataSize);
-        if (status != noErr) continue;
-        
-        AudioBufferList* bufferList = (AudioBufferList*)malloc(dataSize);
-        status = AudioObjectGetPropertyData(deviceID, &inputAddress, 0, nullptr, &dataSize, bufferList);
-        
-        if (status == noErr && bufferList->mNumberBuffers > 0) {
-            // Get device name
-            CFStringRef deviceName = nullptr;
-            AudioObjectPropertyAddress nameAddress = {
-                kAudioDevicePropertyDeviceNameCFString,
-                kAudioObjectPropertyScopeGlobal,
-                kAudioObjectPropertyElementMain
-            };
-            
-            dataSize = sizeof(deviceName);
-            status = AudioObjectGetPropertyData(deviceID, &nameAddress, 0, nullptr, &dataSize, &deviceName);
-            
-            if (status == noErr && deviceName) {
-                char name[256];
-                CFStringGetCString(deviceName, name, sizeof(name), kCFStringEncodingUTF8);
-                CFRelease(deviceName);
-                
-                Napi::Object device = Napi::Object::New(env);
-                device.Set("id", std::to_string(deviceID));
-                device.Set("name", name);
-                device.Set("isDefault", false);
-                
-                devices.Set(deviceIndex++, device);
-            }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("id", std::to_string(device));
+    result.Set("followsDefault", selected_device_id_.empty());
+    return result;
+}
+
+// Converts a monotonic host time in ms (as delivered with capture buffers)
+// to the JS Date.now() domain using this session's clock anchor
+Napi::Value AudioCaptureAddon::HostTimeToDateNow(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected host time in milliseconds").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    double host_ms = info[0].As<Napi::Number>().DoubleValue();
+    return Napi::Number::New(env, host_clock_.ToDateNowMs(host_clock_.MsToTicks(host_ms)));
+}
+
+Napi::Value AudioCaptureAddon::GetHostTime(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), host_clock_.HostTimeMs(HostTimeNow()));
+}
+
+// Counters since each stream's last start; safe to poll while capturing
+Napi::Value AudioCaptureAddon::GetCaptureStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("mic", CaptureStatsToObject(env, mic_stream_.Stats(), host_clock_));
+    result.Set("system", CaptureStatsToObject(env, system_stream_.Stats(), host_clock_));
+    result.Set("async", CaptureStatsToObject(env, async_stream_.Stats(), host_clock_));
+    Napi::Object voice = Napi::Object::New(env);
+    UInt32 ducking = voice_ducking_.load(std::memory_order_relaxed);
+    voice.Set("active", voice_active_.load(std::memory_order_relaxed));
+    voice.Set("bypassed", voice_bypassed_.load(std::memory_order_relaxed));
+    voice.Set("ducking", ducking == 10 ? "min" : ducking == 20 ? "mid" : ducking == 30 ? "max" : "default");
+    voice.Set("advancedDucking", voice_advanced_ducking_.load(std::memory_order_relaxed));
+    result.Set("voiceProcessing", voice);
+    result.Set("micEngine", MicEngineName(engine_request_));
+    if (beamformer_) {
+        // Steering as each channel's lag behind the first
+        Napi::Array lags = Napi::Array::New(env);
+        uint32_t channels = std::min<uint32_t>(mic_stream_.Stats().device_channels.load(std::memory_order_relaxed),
+                                               DelayAndSumBeamformer::kMaxChannels);
+        if (!mic_channels_.empty()) {
+            channels = std::min<uint32_t>(channels, static_cast<uint32_t>(mic_channels_.size()));
         }
-        
-        free(bufferList);
+        for (uint32_t c = 0; c < channels; ++c) {
+            lags.Set(c, beamformer_->Lag(static_cast<int>(c)) * 1000.0 / mic_sample_rate_);
+        }
+        result.Set("beamLagsMs", lags);
     }
+    std::lock_guard<std::mutex> lock(power_profile_mutex_);
+    result.Set("lowPower", low_power_);
+    return result;
+}
+
+// Per-stage delivery latency since each stream's last start
+Napi::Value AudioCaptureAddon::GetLatencyTrace(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    free(audioDevices);
-    return devices;
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("mic", LatencyTraceToObject(env, mic_stream_.Trace()));
+    result.Set("system", LatencyTraceToObject(env, system_stream_.Trace()));
+    result.Set("async", LatencyTraceToObject(env, async_stream_.Trace()));
+    return result;
+}
+
+// markAudioSent(stream, sampleIndex): the delivery starting at |sampleIndex|
+// on 'mic', 'system' or 'async' has been written out; closes its trace
+Napi::Value AudioCaptureAddon::MarkAudioSent(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system' | 'async', sampleIndex: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    CaptureStream* stream = name == "mic" ? &mic_stream_
+        : name == "system" ? &system_stream_
+        : name == "async" ? &async_stream_ : nullptr;
+    double sample_index = info[1].As<Napi::Number>().DoubleValue();
+    if (!stream || sample_index < 0.0) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system' | 'async', sampleIndex: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Napi::Boolean::New(env, stream->MarkSent(static_cast<uint64_t>(sample_index)));
+}
+
+// subscribeCapture(stream, callback, options?): another callback for a
+// running stream's audio, sharing its buffers; see CaptureStream::Subscribe().
+// Returns the subscription's ID, or 0 when the stream is not running.
+Napi::Value AudioCaptureAddon::SubscribeCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system' | 'async', callback: Function, options?: object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    CaptureStream* stream = name == "mic" ? &mic_stream_
+        : name == "system" ? &system_stream_
+        : name == "async" ? &async_stream_ : nullptr;
+    if (!stream) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system' | 'async', callback: Function, options?: object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    SubscriberOptions options = ParseSubscriberOptions(info.Length() > 2 ? info[2] : env.Undefined());
+    uint64_t id = stream->Subscribe(env, info[1].As<Napi::Function>(), options);
+    return Napi::Number::New(env, static_cast<double>(id));
+}
+
+// unsubscribeCapture(id): ends a subscribeCapture() subscription; false when
+// it already ended (unsubscribed, or its stream stopped)
+Napi::Value AudioCaptureAddon::UnsubscribeCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (id: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    uint64_t id = static_cast<uint64_t>(info[0].As<Napi::Number>().DoubleValue());
+    return Napi::Boolean::New(env, mic_stream_.Unsubscribe(id) || system_stream_.Unsubscribe(id) || async_stream_.Unsubscribe(id));
+}
+
+// readHistory(stream, range): what a stream started with the history option
+// kept of the given range; see ReadCaptureHistory()
+Napi::Value AudioCaptureAddon::ReadHistory(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::string name = info.Length() > 0 && info[0].IsString() ? info[0].As<Napi::String>().Utf8Value() : "";
+    const CaptureStream* stream = name == "mic" ? &mic_stream_
+        : name == "system" ? &system_stream_
+        : name == "async" ? &async_stream_ : nullptr;
+    if (!stream || info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system' | 'async', range: object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return ReadCaptureHistory(env, *stream, host_clock_, info[1]);
+}
+
+// armSharedStart(): the next start of the mic and of system audio count
+// their sampleIndex from one host instant, now, and drop anything captured
+// before it; returns { hostTimeMs, timestamp } of that instant.
+// armSharedStart(false) disarms both.
+Napi::Value AudioCaptureAddon::ArmSharedStart(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    bool arm = !(info.Length() > 0 && info[0].IsBoolean() && !info[0].As<Napi::Boolean>().Value());
+    if (!mic_stream_.IsOpen() && !system_stream_.IsOpen()) {
+        host_clock_.Anchor();
+    }
+    uint64_t start = arm ? HostTimeNow() : 0;
+    mic_stream_.SetStartHost(start);
+    system_stream_.SetStartHost(start);
+    if (!arm) {
+        return env.Null();
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("hostTimeMs", host_clock_.HostTimeMs(start));
+    result.Set("timestamp", host_clock_.ToDateNowMs(start));
+    return result;
+}
+
+// startLevelMeter(callback, { rateHz = 30 }): peak and RMS of every stream's
+// delivered audio at display rate, { time, mic, system, async: { rms, peak } }
+Napi::Value AudioCaptureAddon::StartLevelMeter(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (callback, { rateHz?, spectrum? })").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    double rate_hz = 30.0;
+    SpectrumOptions spectrum;
+    bool with_spectrum = false;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("rateHz") && options.Get("rateHz").IsNumber()) {
+            rate_hz = options.Get("rateHz").As<Napi::Number>().DoubleValue();
+        }
+        if (options.Has("spectrum")) {
+            with_spectrum = ParseSpectrumOptions(options.Get("spectrum"), &spectrum);
+        }
+    }
+    level_meter_.Start(env, info[0].As<Napi::Function>(), rate_hz, &host_clock_, {
+        {"mic", &mic_stream_.Meter(), &mic_stream_.Spectrum()},
+        {"system", &system_stream_.Meter(), &system_stream_.Spectrum()},
+        {"async", &async_stream_.Meter(), &async_stream_.Spectrum()}
+    }, with_spectrum ? &spectrum : nullptr);
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value AudioCaptureAddon::StopLevelMeter(const Napi::CallbackInfo& info) {
+    level_meter_.Stop();
+    return info.Env().Undefined();
 }
 
 Napi::Value AudioCaptureAddon::Start(const Napi::CallbackInfo& info) {
@@ -606,6 +4400,7 @@ Napi::Value AudioCaptureAddon::Stop(const Napi::CallbackInfo& info) {
 }
 
 Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
+    InitModuleFunctions(env, exports);
     return AudioCaptureAddon::Init(env, exports);
 }
 
@@ -0,0 +1,1534 @@
+#include <napi.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include "addon_common.h"
+#include "aec_processor.h"
+#include "capture_session.h"
+#include "capture_stream.h"
+#include "echo_cancel_pipeline.h"
+#include "host_time.h"
+#include "keyword_spotter.h"
+#include "meeting_audio_monitor.h"
+#include "meeting_recorder.h"
+#include "native_log.h"
+#include "pipeline_trace.h"
+#include "session_capture.h"
+#if defined(_WIN32)
+#include "wasapi_capture.h"
+#else
+#include "pipewire_capture.h"
+#endif
+
+using namespace kakarot;
+
+#if defined(_WIN32)
+using PlatformCapture = WasapiCapture;
+#else
+using PlatformCapture = PipeWireCapture;
+#endif
+
+// AudioCaptureAddon for the stream-based backends (WASAPI on Windows,
+// PipeWire on Linux): mic and loopback capture feeding the same CaptureStream
+// rings, TSFN delivery and native AEC pipeline as the CoreAudio build. Both
+// backends deliver 48kHz mono float with host timestamps. JS-fed processing
+// (processRenderAudio and friends), device change notifications and output
+// route detection are macOS-only for now; the TypeScript wrappers already
+// feature-test each method.
+
+static constexpr double kCaptureSampleRate = PlatformCapture::kSampleRate;
+
+// 2 seconds of 48kHz mono between the capture thread and the consumer thread
+static constexpr size_t kCaptureRingSamples = 96000;
+static constexpr size_t kCaptureRingChunks = 256;
+
+// Meeting monitor ring: several of its one-second wakes at 48kHz
+static constexpr size_t kMonitorRingSamples = 262144;
+
+// Shadow AEC tap: about a second of render and mono capture, and the
+// 10ms chunks that carry it
+static constexpr size_t kShadowRingSamples = 262144;
+static constexpr size_t kShadowRingRecords = 1024;
+
+// How long processed capture waits for the loopback render covering it; the
+// audio server delivers loopback a period or two behind the mix
+static constexpr double kLoopbackRenderWaitMs = 50.0;
+
+// Source tag of records this file writes to the native log ring
+static const char* const kLogSource = "AudioCapture";
+
+// A startSession() device: a microphone stream of its own, on the same
+// backend as the addon's
+class PlatformSessionInput : public SessionInput {
+public:
+    bool Start(const std::string& device_id, RealtimeSink sink, void* context, std::string* error) override {
+        capture_ = std::make_unique<PlatformCapture>(CaptureSource::kMicrophone, sink, context);
+        return capture_->Start(device_id, error);
+    }
+
+    void Stop() override {
+        if (capture_) {
+            capture_->Stop();
+        }
+    }
+
+    double SampleRate() const override { return PlatformCapture::kSampleRate; }
+
+private:
+    std::unique_ptr<PlatformCapture> capture_;
+};
+
+static std::unique_ptr<SessionInput> NewSessionInput() {
+    return std::make_unique<PlatformSessionInput>();
+}
+
+class MicStartWorker;
+class MicStopWorker;
+class MicPauseWorker;
+
+class AudioCaptureAddon : public Napi::ObjectWrap<AudioCaptureAddon> {
+    friend class MicStartWorker;
+    friend class MicStopWorker;
+    friend class MicPauseWorker;
+
+public:
+    static Napi::Object Init(Napi::Env env, Napi::Object exports);
+    AudioCaptureAddon(const Napi::CallbackInfo& info);
+    ~AudioCaptureAddon();
+
+private:
+    // Native microphone capture methods
+    Napi::Value StartMicrophoneCapture(const Napi::CallbackInfo& info);
+    Napi::Value StopMicrophoneCapture(const Napi::CallbackInfo& info);
+    Napi::Value PauseMicrophoneCapture(const Napi::CallbackInfo& info);
+    Napi::Value ResumeMicrophoneCapture(const Napi::CallbackInfo& info);
+    Napi::Value GetDevices(const Napi::CallbackInfo& info);
+    Napi::Value SetInputDevice(const Napi::CallbackInfo& info);
+    Napi::Value GetInputDevice(const Napi::CallbackInfo& info);
+    Napi::Value HostTimeToDateNow(const Napi::CallbackInfo& info);
+    Napi::Value GetHostTime(const Napi::CallbackInfo& info);
+    Napi::Value GetCaptureStats(const Napi::CallbackInfo& info);
+    Napi::Value IsMicrophoneProcessed(const Napi::CallbackInfo& info);
+    Napi::Value SetPowerProfile(const Napi::CallbackInfo& info);
+    Napi::Value GetLatencyTrace(const Napi::CallbackInfo& info);
+    Napi::Value MarkAudioSent(const Napi::CallbackInfo& info);
+    Napi::Value SubscribeCapture(const Napi::CallbackInfo& info);
+    Napi::Value UnsubscribeCapture(const Napi::CallbackInfo& info);
+    Napi::Value ReadHistory(const Napi::CallbackInfo& info);
+    Napi::Value StartLevelMeter(const Napi::CallbackInfo& info);
+    Napi::Value StopLevelMeter(const Napi::CallbackInfo& info);
+    Napi::Value ArmSharedStart(const Napi::CallbackInfo& info);
+
+    // Named capture sessions on the shared DSP pool
+    Napi::Value StartSession(const Napi::CallbackInfo& info) { return sessions_.Start(info); }
+    Napi::Value StopSession(const Napi::CallbackInfo& info) { return sessions_.Stop(info); }
+    Napi::Value GetSessions(const Napi::CallbackInfo& info) { return sessions_.GetStats(info); }
+
+    // A meeting's pipeline health, folded from the readMetrics() slots
+    Napi::Value StartPerformanceReport(const Napi::CallbackInfo& info) {
+        kakarot::StartPerformanceReport(info, &performance_, [this](MetricsWriter* writer) { WriteMetrics(writer); });
+        return info.Env().Undefined();
+    }
+    Napi::Value StopPerformanceReport(const Napi::CallbackInfo& info) {
+        return kakarot::StopPerformanceReport(info.Env(), &performance_);
+    }
+
+    // Native system audio capture (loopback of the default render endpoint)
+    Napi::Value StartSystemAudioCapture(const Napi::CallbackInfo& info);
+    Napi::Value StopSystemAudioCapture(const Napi::CallbackInfo& info);
+    Napi::Value IsSystemAudioCaptureSupported(const Napi::CallbackInfo& info);
+    Napi::Value GetSystemAudioFormat(const Napi::CallbackInfo& info);
+    Napi::Value StartMeetingMonitor(const Napi::CallbackInfo& info);
+    Napi::Value StopMeetingMonitor(const Napi::CallbackInfo& info);
+    Napi::Value GetMeetingMonitorStats(const Napi::CallbackInfo& info);
+    void StopMeetingMonitorCapture();
+    Napi::Value StartKeywordSpotter(const Napi::CallbackInfo& info);
+    Napi::Value StopKeywordSpotter(const Napi::CallbackInfo& info);
+    Napi::Value GetKeywordSpotterStats(const Napi::CallbackInfo& info);
+    void StopKeywordSpotterListening();
+    Napi::Value StartVoiceEnrollment(const Napi::CallbackInfo& info);
+    Napi::Value FinishVoiceEnrollment(const Napi::CallbackInfo& info);
+    Napi::Value CancelVoiceEnrollment(const Napi::CallbackInfo& info);
+    Napi::Value SetVoiceprint(const Napi::CallbackInfo& info);
+    Napi::Value GetVoiceVerifierStats(const Napi::CallbackInfo& info);
+
+    // AEC methods
+    Napi::Value GetMetrics(const Napi::CallbackInfo& info);
+    Napi::Value ReadMetrics(const Napi::CallbackInfo& info);
+    Napi::Value GetMetricsLayout(const Napi::CallbackInfo& info);
+    void WriteMetrics(MetricsWriter* writer);
+    Napi::Value GetAecProfile(const Napi::CallbackInfo& info);
+    Napi::Value GetNoiseProfile(const Napi::CallbackInfo& info);
+    Napi::Value ResetEchoPath(const Napi::CallbackInfo& info);
+    Napi::Value StartShadowAec(const Napi::CallbackInfo& info);
+    Napi::Value StopShadowAec(const Napi::CallbackInfo& info);
+    Napi::Value GetShadowComparison(const Napi::CallbackInfo& info);
+    Napi::Value SetEchoCancellationEnabled(const Napi::CallbackInfo& info);
+    Napi::Value SetHeadphoneBypass(const Napi::CallbackInfo& info);
+    Napi::Value Configure(const Napi::CallbackInfo& info);
+    Napi::Value GetConfig(const Napi::CallbackInfo& info);
+    Napi::Value PostConfig(const Napi::CallbackInfo& info);
+    Napi::Value GetConfigStatus(const Napi::CallbackInfo& info);
+    Napi::Value StartAecDump(const Napi::CallbackInfo& info);
+    Napi::Value StopAecDump(const Napi::CallbackInfo& info);
+
+    // Placeholder methods
+    Napi::Value Start(const Napi::CallbackInfo& info);
+    Napi::Value Stop(const Napi::CallbackInfo& info);
+
+    // Capture-thread sinks
+    static void MicSink(void* context, const float* data, uint32_t num_samples, uint64_t host_time);
+    static void LoopbackSink(void* context, const float* data, uint32_t num_samples, uint64_t host_time);
+    static void MeetingMonitorSink(void* context, const float* data, uint32_t num_samples, uint64_t host_time);
+
+    // Blocking stream bring-up/teardown, run on AsyncWorker threads
+    bool SetupMicrophone(std::string* error);
+    void TeardownMicrophone();
+    bool PauseMicrophone(bool pause, std::string* error);
+    void StartAecPipeline();
+
+    // State
+    std::atomic<bool> is_capturing_;
+    std::atomic<bool> mic_busy_;     // a start/stop/pause worker is in flight
+    std::atomic<bool> mic_paused_;   // capture stream closed, everything else kept
+    std::string selected_device_id_; // empty: follow the default capture endpoint
+
+    // One host clock for both streams so their timestamps share a domain
+    HostClock host_clock_;
+
+    // Capture thread -> consumer -> JS pipelines
+    CaptureStream mic_stream_;
+    CaptureStream system_stream_;
+    PlatformCapture mic_capture_;
+    PlatformCapture loopback_capture_;
+
+    // startMeetingMonitor(): a loopback of its own into the standby
+    // detector, whose thread calls JS through meeting_tsfn_
+    CaptureStats monitor_stats_;
+    PlatformCapture monitor_capture_;
+    MeetingAudioMonitor meeting_monitor_;
+    Napi::ThreadSafeFunction meeting_tsfn_;
+
+    // startKeywordSpotter(): a listener on the system stream's spectrum,
+    // whose thread calls JS through keyword_tsfn_
+    KeywordSpotter keyword_spotter_;
+    Napi::ThreadSafeFunction keyword_tsfn_;
+
+    // startLevelMeter(); points at the streams' meters, so it is torn down first
+    LevelMeterPublisher level_meter_;
+    PerformanceRecorder performance_;
+
+    // startSession(): devices and graphs of their own, beside the streams above
+    CaptureSessionSet sessions_;
+
+    // Native AEC: mic + loopback -> DSP thread -> mic_stream_ ('processed'
+    // mode). The flags pick the single producer of each pipeline ring.
+    EchoCancelPipeline aec_pipeline_;
+    std::atomic<bool> mic_feeds_pipeline_;
+    std::atomic<bool> loopback_feeds_pipeline_;
+
+    // This session's engine and processed option (JS thread, then the start
+    // worker). With kCommunications (Windows) the start worker picks the
+    // pipeline or the endpoint's AEC, before the first packet, and
+    // endpoint_aec_ says which it took.
+    MicEngine mic_engine_;
+    bool mic_processed_;
+    std::atomic<bool> endpoint_aec_;
+
+    // AEC processor
+    std::unique_ptr<AECProcessor> aec_processor_;
+    ShadowAec shadow_aec_;  // startShadowAec(); tapped by aec_pipeline_, compares with aec_processor_
+
+    // setPowerProfile() (JS thread). While low_power_ the APM runs
+    // ApplyLowPowerProfile() of aec_base_config_, the configuration JS asked for.
+    bool low_power_;
+    AECConfig aec_base_config_;
+};
+
+// Runs SetupMicrophone() off the JS thread and settles the start promise.
+// Holding the addon's JS object keeps it alive until the worker completes.
+class MicStartWorker : public Napi::AsyncWorker {
+public:
+    MicStartWorker(AudioCaptureAddon* addon, Napi::Promise::Deferred deferred)
+        : Napi::AsyncWorker(addon->Value(), "MicStartWorker"), addon_(addon), deferred_(deferred) {}
+
+    void Execute() override {
+        std::string error;
+        if (!addon_->SetupMicrophone(&error)) {
+            SetError(error);
+        }
+    }
+
+    void OnOK() override {
+        addon_->mic_busy_ = false;
+        deferred_.Resolve(Napi::Boolean::New(Env(), true));
+    }
+
+    void OnError(const Napi::Error& error) override {
+        if (addon_->mic_feeds_pipeline_.exchange(false)) {
+            addon_->aec_pipeline_.Stop();
+        }
+        addon_->mic_stream_.Close();
+        addon_->mic_busy_ = false;
+        deferred_.Reject(error.Value());
+    }
+
+private:
+    AudioCaptureAddon* addon_;
+    Napi::Promise::Deferred deferred_;
+};
+
+// Runs TeardownMicrophone(); joining the capture thread waits out a packet
+class MicStopWorker : public Napi::AsyncWorker {
+public:
+    MicStopWorker(AudioCaptureAddon* addon, Napi::Promise::Deferred deferred)
+        : Napi::AsyncWorker(addon->Value(), "MicStopWorker"), addon_(addon), deferred_(deferred) {}
+
+    void Execute() override {
+        addon_->TeardownMicrophone();
+    }
+
+    void OnOK() override {
+        // Flushes the tail and releases the TSFN
+        addon_->mic_stream_.Close();
+        addon_->mic_busy_ = false;
+        Log(LogLevel::kInfo, kLogSource, "Microphone capture stopped");
+        deferred_.Resolve(Napi::Boolean::New(Env(), true));
+    }
+
+private:
+    AudioCaptureAddon* addon_;
+    Napi::Promise::Deferred deferred_;
+};
+
+// Runs PauseMicrophone(); both directions open or close the endpoint
+class MicPauseWorker : public Napi::AsyncWorker {
+public:
+    MicPauseWorker(AudioCaptureAddon* addon, Napi::Promise::Deferred deferred, bool pause)
+        : Napi::AsyncWorker(addon->Value(), "MicPauseWorker"), addon_(addon), deferred_(deferred), pause_(pause) {}
+
+    void Execute() override {
+        std::string error;
+        if (!addon_->PauseMicrophone(pause_, &error)) {
+            SetError(error);
+        }
+    }
+
+    void OnOK() override {
+        addon_->mic_busy_ = false;
+        addon_->mic_stream_.SetIdle(Env(), pause_);
+        deferred_.Resolve(Napi::Boolean::New(Env(), true));
+    }
+
+    void OnError(const Napi::Error& error) override {
+        addon_->mic_busy_ = false;
+        deferred_.Reject(error.Value());
+    }
+
+private:
+    AudioCaptureAddon* addon_;
+    Napi::Promise::Deferred deferred_;
+    bool pause_;
+};
+
+Napi::Object AudioCaptureAddon::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "AudioCaptureAddon", {
+        InstanceMethod("startMicrophoneCapture", &AudioCaptureAddon::StartMicrophoneCapture),
+        InstanceMethod("stopMicrophoneCapture", &AudioCaptureAddon::StopMicrophoneCapture),
+        InstanceMethod("pauseMicrophoneCapture", &AudioCaptureAddon::PauseMicrophoneCapture),
+        InstanceMethod("resumeMicrophoneCapture", &AudioCaptureAddon::ResumeMicrophoneCapture),
+        InstanceMethod("getDevices", &AudioCaptureAddon::GetDevices),
+        InstanceMethod("setInputDevice", &AudioCaptureAddon::SetInputDevice),
+        InstanceMethod("getInputDevice", &AudioCaptureAddon::GetInputDevice),
+        InstanceMethod("hostTimeToDateNow", &AudioCaptureAddon::HostTimeToDateNow),
+        InstanceMethod("getHostTime", &AudioCaptureAddon::GetHostTime),
+        InstanceMethod("getCaptureStats", &AudioCaptureAddon::GetCaptureStats),
+        InstanceMethod("isMicrophoneProcessed", &AudioCaptureAddon::IsMicrophoneProcessed),
+        InstanceMethod("setPowerProfile", &AudioCaptureAddon::SetPowerProfile),
+        InstanceMethod("getLatencyTrace", &AudioCaptureAddon::GetLatencyTrace),
+        InstanceMethod("markAudioSent", &AudioCaptureAddon::MarkAudioSent),
+        InstanceMethod("subscribeCapture", &AudioCaptureAddon::SubscribeCapture),
+        InstanceMethod("unsubscribeCapture", &AudioCaptureAddon::UnsubscribeCapture),
+        InstanceMethod("readHistory", &AudioCaptureAddon::ReadHistory),
+        InstanceMethod("startLevelMeter", &AudioCaptureAddon::StartLevelMeter),
+        InstanceMethod("stopLevelMeter", &AudioCaptureAddon::StopLevelMeter),
+        InstanceMethod("armSharedStart", &AudioCaptureAddon::ArmSharedStart),
+        InstanceMethod("startSession", &AudioCaptureAddon::StartSession),
+        InstanceMethod("stopSession", &AudioCaptureAddon::StopSession),
+        InstanceMethod("getSessions", &AudioCaptureAddon::GetSessions),
+        InstanceMethod("startPerformanceReport", &AudioCaptureAddon::StartPerformanceReport),
+        InstanceMethod("stopPerformanceReport", &AudioCaptureAddon::StopPerformanceReport),
+        InstanceMethod("startSystemAudioCapture", &AudioCaptureAddon::StartSystemAudioCapture),
+        InstanceMethod("stopSystemAudioCapture", &AudioCaptureAddon::StopSystemAudioCapture),
+        InstanceMethod("isSystemAudioCaptureSupported", &AudioCaptureAddon::IsSystemAudioCaptureSupported),
+        InstanceMethod("getSystemAudioFormat", &AudioCaptureAddon::GetSystemAudioFormat),
+        InstanceMethod("startMeetingMonitor", &AudioCaptureAddon::StartMeetingMonitor),
+        InstanceMethod("stopMeetingMonitor", &AudioCaptureAddon::StopMeetingMonitor),
+        InstanceMethod("getMeetingMonitorStats", &AudioCaptureAddon::GetMeetingMonitorStats),
+        InstanceMethod("startKeywordSpotter", &AudioCaptureAddon::StartKeywordSpotter),
+        InstanceMethod("stopKeywordSpotter", &AudioCaptureAddon::StopKeywordSpotter),
+        InstanceMethod("getKeywordSpotterStats", &AudioCaptureAddon::GetKeywordSpotterStats),
+        InstanceMethod("startVoiceEnrollment", &AudioCaptureAddon::StartVoiceEnrollment),
+        InstanceMethod("finishVoiceEnrollment", &AudioCaptureAddon::FinishVoiceEnrollment),
+        InstanceMethod("cancelVoiceEnrollment", &AudioCaptureAddon::CancelVoiceEnrollment),
+        InstanceMethod("setVoiceprint", &AudioCaptureAddon::SetVoiceprint),
+        InstanceMethod("getVoiceVerifierStats", &AudioCaptureAddon::GetVoiceVerifierStats),
+        InstanceMethod("getMetrics", &AudioCaptureAddon::GetMetrics),
+        InstanceMethod("readMetrics", &AudioCaptureAddon::ReadMetrics),
+        InstanceMethod("getMetricsLayout", &AudioCaptureAddon::GetMetricsLayout),
+        InstanceMethod("getAecProfile", &AudioCaptureAddon::GetAecProfile),
+        InstanceMethod("getNoiseProfile", &AudioCaptureAddon::GetNoiseProfile),
+        InstanceMethod("resetEchoPath", &AudioCaptureAddon::ResetEchoPath),
+        InstanceMethod("startShadowAec", &AudioCaptureAddon::StartShadowAec),
+        InstanceMethod("stopShadowAec", &AudioCaptureAddon::StopShadowAec),
+        InstanceMethod("getShadowComparison", &AudioCaptureAddon::GetShadowComparison),
+        InstanceMethod("setEchoCancellationEnabled", &AudioCaptureAddon::SetEchoCancellationEnabled),
+        InstanceMethod("setHeadphoneBypass", &AudioCaptureAddon::SetHeadphoneBypass),
+        InstanceMethod("configure", &AudioCaptureAddon::Configure),
+        InstanceMethod("getConfig", &AudioCaptureAddon::GetConfig),
+        InstanceMethod("postConfig", &AudioCaptureAddon::PostConfig),
+        InstanceMethod("getConfigStatus", &AudioCaptureAddon::GetConfigStatus),
+        InstanceMethod("startAecDump", &AudioCaptureAddon::StartAecDump),
+        InstanceMethod("stopAecDump", &AudioCaptureAddon::StopAecDump),
+        InstanceMethod("start", &AudioCaptureAddon::Start),
+        InstanceMethod("stop", &AudioCaptureAddon::Stop)
+    });
+
+    // Per env: a worker_thread loading the addon gets its own class
+    GetAddonInstance(env)->capture_addon = Napi::Persistent(func);
+
+    exports.Set("AudioCaptureAddon", func);
+    return exports;
+}
+
+AudioCaptureAddon::AudioCaptureAddon(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<AudioCaptureAddon>(info),
+      is_capturing_(false),
+      mic_busy_(false),
+      mic_paused_(false),
+      mic_stream_("MicrophoneCapture", &host_clock_, kCaptureRingSamples, kCaptureRingChunks),
+      system_stream_("SystemAudioCapture", &host_clock_, kCaptureRingSamples, kCaptureRingChunks),
+      mic_capture_(CaptureSource::kMicrophone, &AudioCaptureAddon::MicSink, this),
+      loopback_capture_(CaptureSource::kLoopback, &AudioCaptureAddon::LoopbackSink, this),
+      monitor_capture_(CaptureSource::kLoopback, &AudioCaptureAddon::MeetingMonitorSink, this),
+      meeting_monitor_(kMonitorRingSamples),
+      sessions_(&NewSessionInput, &host_clock_),
+      aec_pipeline_(&host_clock_, kCaptureRingSamples, kCaptureRingChunks),
+      mic_feeds_pipeline_(false),
+      loopback_feeds_pipeline_(false),
+      mic_engine_(MicEngine::kHal),
+      mic_processed_(false),
+      endpoint_aec_(false),
+      shadow_aec_(kShadowRingSamples, kShadowRingRecords),
+      low_power_(false) {
+    mic_capture_.SetStats(&mic_stream_.Stats());
+    loopback_capture_.SetStats(&system_stream_.Stats());
+    monitor_capture_.SetStats(&monitor_stats_);
+    mic_stream_.SetTalkParty(TalkParty::kLocal);
+    system_stream_.SetTalkParty(TalkParty::kRemote);
+
+    // Initialize AEC processor from the constructor options. Loopback is
+    // delivered mono, so the reference is always one channel here.
+    AECConfig defaults;
+    defaults.frame_duration_ms = 10;
+    AECConfig config = ParseAECConfig(info.Length() > 0 ? info[0] : info.Env().Undefined(), defaults);
+
+    try {
+        aec_processor_ = std::make_unique<AECProcessor>(config);
+        if (!aec_processor_->Initialize(static_cast<int>(kCaptureSampleRate), 1, 1)) {
+            Log(LogLevel::kError, kLogSource, "Failed to initialize AEC processor");
+            aec_processor_.reset();
+        }
+    } catch (const std::exception& e) {
+        Log(LogLevel::kError, kLogSource, "Exception initializing AEC: %s", e.what());
+        aec_processor_.reset();
+    }
+    aec_pipeline_.SetShadow(&shadow_aec_);
+}
+
+AudioCaptureAddon::~AudioCaptureAddon() {
+    level_meter_.Stop();
+    performance_.Stop(nullptr);
+    sessions_.StopAll();
+    if (is_capturing_) {
+        TeardownMicrophone();
+    }
+    loopback_capture_.Stop();
+    StopMeetingMonitorCapture();
+    StopKeywordSpotterListening();
+    aec_pipeline_.Stop();
+    shadow_aec_.Stop();
+    mic_stream_.Close();
+    system_stream_.Close();
+    aec_processor_.reset();
+}
+
+// Runs on the mic capture thread: no allocation, no locks, no JS.
+void AudioCaptureAddon::MicSink(void* context, const float* data, uint32_t num_samples, uint64_t host_time) {
+    AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(context);
+    TraceScope trace(TraceEvent::kMicIOProc, num_samples);
+    RecordSamples(RecordTrack::kMicrophone, self, data, num_samples, static_cast<int>(kCaptureSampleRate));
+    CaptureSessionBuffer(SessionStream::kMicrophone, self, data, num_samples, static_cast<int>(kCaptureSampleRate),
+                         host_time);
+
+    // In processed mode the DSP thread owns mic_stream_'s producer side
+    if (self->mic_feeds_pipeline_.load(std::memory_order_acquire)) {
+        if (!self->aec_pipeline_.PushCapture(data, num_samples, host_time)) {
+            self->mic_stream_.Stats().buffers_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        self->mic_stream_.PushFromRealtime(data, num_samples, host_time);
+    }
+}
+
+// Runs on the loopback capture thread; frames are already mono float
+void AudioCaptureAddon::LoopbackSink(void* context, const float* data, uint32_t num_samples, uint64_t host_time) {
+    AudioCaptureAddon* self = static_cast<AudioCaptureAddon*>(context);
+    TraceScope trace(TraceEvent::kSystemTapIOProc, num_samples);
+    RecordSamples(RecordTrack::kSystem, self, data, num_samples, static_cast<int>(kCaptureSampleRate));
+    CaptureSessionBuffer(SessionStream::kSystem, self, data, num_samples, static_cast<int>(kCaptureSampleRate),
+                         host_time);
+    self->system_stream_.PushFromRealtime(data, num_samples, host_time);
+    if (self->loopback_feeds_pipeline_.load(std::memory_order_acquire)) {
+        self->aec_pipeline_.PushRender(data, num_samples, 1, host_time);
+    }
+}
+
+Napi::Value AudioCaptureAddon::StartMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+
+    if (is_capturing_ || mic_busy_) {
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
+
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        deferred.Reject(Napi::Error::New(env, "Callback function required").Value());
+        return deferred.Promise();
+    }
+
+    Napi::Function callback = info[0].As<Napi::Function>();
+    CaptureOptions options = ParseCaptureOptions(info.Length() > 1 ? info[1] : env.Undefined());
+
+    if (options.processed && !aec_processor_) {
+        deferred.Reject(Napi::Error::New(env, "Processed capture requires the AEC processor").Value());
+        return deferred.Promise();
+    }
+
+    // Fresh timeline for this session, unless system capture already shares it
+    if (!system_stream_.IsOpen()) {
+        host_clock_.Anchor();
+    }
+
+    // Consumer must be draining before the first packet arrives
+    mic_stream_.Open(env, callback, options, kCaptureSampleRate);
+    mic_stream_.Stats().start_host.store(HostTimeNow(), std::memory_order_relaxed);
+    mic_engine_ = options.engine;
+    mic_processed_ = options.processed;
+    endpoint_aec_ = false;
+    if (options.processed && mic_engine_ != MicEngine::kCommunications) {
+        StartAecPipeline();
+    }
+
+    mic_busy_ = true;
+    (new MicStartWorker(this, deferred))->Queue();
+    return deferred.Promise();
+}
+
+// Loopback carries the mix as it leaves the server; the endpoint's own
+// latency is left to the APM's delay estimator. Before the mic starts.
+void AudioCaptureAddon::StartAecPipeline() {
+    aec_pipeline_.Start(aec_processor_.get(), &mic_stream_, kCaptureSampleRate, kCaptureSampleRate,
+                        kLoopbackRenderWaitMs, 0.0);
+    mic_feeds_pipeline_ = true;
+    Log(LogLevel::kInfo, kLogSource, "Native AEC pipeline started (processed delivery, render from %s)",
+        loopback_feeds_pipeline_.load() ? "loopback" : "nothing yet");
+}
+
+// Worker thread. Opening a Bluetooth endpoint can take a while, as
+// AudioDeviceStart does on macOS.
+bool AudioCaptureAddon::SetupMicrophone(std::string* error) {
+#if defined(_WIN32)
+    // Where the endpoint cancels echo itself, AEC3 would only spend CPU
+    // cancelling what is no longer there
+    const bool communications = mic_engine_ == MicEngine::kCommunications;
+    mic_capture_.SetCommunications(communications);
+    if (communications) {
+        endpoint_aec_ = WasapiCapture::ProbeEchoCancellation(selected_device_id_) == SystemEchoCancellation::kOn;
+        if (mic_processed_ && !endpoint_aec_) {
+            StartAecPipeline();
+        }
+        Log(LogLevel::kInfo, kLogSource, "Communications capture: %s",
+            endpoint_aec_ ? "endpoint AEC on, native AEC bypassed"
+                          : mic_processed_ ? "no endpoint AEC, native AEC runs" : "no endpoint AEC");
+    }
+#endif
+    if (!mic_capture_.Start(selected_device_id_, error)) {
+        return false;
+    }
+    is_capturing_ = true;
+    Log(LogLevel::kInfo, kLogSource, "Microphone capture started (%s)", PlatformCapture::kBackendName);
+    return true;
+}
+
+// Stops the capture thread. Safe off the JS thread; the caller closes
+// mic_stream_ afterwards.
+void AudioCaptureAddon::TeardownMicrophone() {
+    is_capturing_ = false;
+    mic_paused_ = false;
+    mic_capture_.Stop();
+
+    // Capture has stopped; flush the tail through AEC
+    if (mic_feeds_pipeline_.exchange(false)) {
+        aec_pipeline_.Stop();
+    }
+}
+
+Napi::Value AudioCaptureAddon::StopMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+
+    if (!is_capturing_ || mic_busy_) {
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
+
+    mic_busy_ = true;
+    (new MicStopWorker(this, deferred))->Queue();
+    return deferred.Promise();
+}
+
+// Closes the capture stream and nothing else: the TSFN, consumer and AEC
+// pipeline, with its adapted filters and delay estimate, stay up
+Napi::Value AudioCaptureAddon::PauseMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+
+    if (!is_capturing_ || mic_busy_ || mic_paused_) {
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
+
+    mic_busy_ = true;
+    (new MicPauseWorker(this, deferred, true))->Queue();
+    return deferred.Promise();
+}
+
+Napi::Value AudioCaptureAddon::ResumeMicrophoneCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+
+    if (!is_capturing_ || mic_busy_ || !mic_paused_) {
+        deferred.Resolve(Napi::Boolean::New(env, false));
+        return deferred.Promise();
+    }
+
+    mic_busy_ = true;
+    (new MicPauseWorker(this, deferred, false))->Queue();
+    return deferred.Promise();
+}
+
+// Worker thread
+bool AudioCaptureAddon::PauseMicrophone(bool pause, std::string* error) {
+    if (pause) {
+        mic_capture_.Stop();
+        mic_paused_ = true;
+        if (mic_feeds_pipeline_) {
+            aec_pipeline_.SetCapturePaused(true);
+        }
+        mic_stream_.Pause();
+        CaptureSessionEvent(SessionStream::kMicrophone, SessionEventType::kPause);
+        Log(LogLevel::kInfo, kLogSource, "Microphone capture paused");
+        return true;
+    }
+
+    if (mic_feeds_pipeline_) {
+        aec_pipeline_.SetCapturePaused(false);
+    }
+    if (!mic_capture_.Start(selected_device_id_, error)) {
+        if (mic_feeds_pipeline_) {
+            aec_pipeline_.SetCapturePaused(true);
+        }
+        return false;
+    }
+    mic_paused_ = false;
+    Log(LogLevel::kInfo, kLogSource, "Microphone capture resumed");
+    return true;
+}
+
+// SYSTEM AUDIO CAPTURE
+
+Napi::Value AudioCaptureAddon::StartSystemAudioCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (system_stream_.IsOpen()) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::Error::New(env, "Callback function required").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    if (!mic_stream_.IsOpen()) {
+        host_clock_.Anchor();
+    }
+
+    system_stream_.Open(env, info[0].As<Napi::Function>(),
+                        ParseCaptureOptions(info.Length() > 1 ? info[1] : env.Undefined()), kCaptureSampleRate);
+
+    // Loopback is converted to the mic rate, so it is always the AEC reference
+    loopback_feeds_pipeline_ = true;
+
+    std::string error;
+    if (!loopback_capture_.Start(std::string(), &error)) {
+        loopback_feeds_pipeline_ = false;
+        system_stream_.Close();
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    Log(LogLevel::kInfo, kLogSource, "System audio capture started (%s loopback)", PlatformCapture::kBackendName);
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value AudioCaptureAddon::StopSystemAudioCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!system_stream_.IsOpen()) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    // Capture stops first so the stream can flush without a live producer
+    loopback_capture_.Stop();
+    loopback_feeds_pipeline_ = false;
+    system_stream_.Close();
+
+    Log(LogLevel::kInfo, kLogSource, "System audio capture stopped");
+    return Napi::Boolean::New(env, true);
+}
+
+// Both backends can capture loopback; a missing audio server fails the start
+Napi::Value AudioCaptureAddon::IsSystemAudioCaptureSupported(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), true);
+}
+
+// Mix format of the render endpoint before conversion, or null when not capturing
+Napi::Value AudioCaptureAddon::GetSystemAudioFormat(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!system_stream_.IsOpen() || !loopback_capture_.IsRunning()) {
+        return env.Null();
+    }
+
+    Napi::Object format = Napi::Object::New(env);
+    format.Set("sampleRate", Napi::Number::New(env, loopback_capture_.MixSampleRate()));
+    format.Set("channels", Napi::Number::New(env, loopback_capture_.Channels()));
+    return format;
+}
+
+// Runs on the monitor loopback's capture thread
+void AudioCaptureAddon::MeetingMonitorSink(void* context, const float* data, uint32_t num_samples,
+                                           uint64_t /*host_time*/) {
+    static_cast<AudioCaptureAddon*>(context)->meeting_monitor_.Push(data, num_samples);
+}
+
+// startMeetingMonitor(options, callback): standby watch on the default
+// output through a loopback of its own. There is no per-app capture here,
+// so bundleIds are ignored and any conversation played counts. |callback|
+// gets { speechSeconds, windowSeconds, speechRuns, confidence }.
+Napi::Value AudioCaptureAddon::StartMeetingMonitor(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Callback function required").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    StopMeetingMonitorCapture();
+
+    meeting_tsfn_ = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "MeetingAudioLikely", 0, 1);
+    meeting_tsfn_.Unref(env);
+    Napi::ThreadSafeFunction tsfn = meeting_tsfn_;
+    std::string error;
+    bool started = meeting_monitor_.Start(kCaptureSampleRate, [tsfn](const MeetingAudioEvent& event) mutable {
+        tsfn.NonBlockingCall([event](Napi::Env env, Napi::Function callback) {
+            try {
+                callback.Call({ MeetingAudioEventToObject(env, event) });
+            } catch (...) {
+                // Silently catch to prevent crash
+            }
+        });
+    }, &error);
+    if (!started || !monitor_capture_.Start(std::string(), &error)) {
+        meeting_monitor_.Stop();
+        meeting_tsfn_.Release();
+        meeting_tsfn_ = Napi::ThreadSafeFunction();
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Log(LogLevel::kInfo, kLogSource, "Meeting monitor started (%s loopback)", PlatformCapture::kBackendName);
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::StopMeetingMonitor(const Napi::CallbackInfo& info) {
+    StopMeetingMonitorCapture();
+    return info.Env().Undefined();
+}
+
+// Capture first, so the monitor has no producer when it stops
+void AudioCaptureAddon::StopMeetingMonitorCapture() {
+    monitor_capture_.Stop();
+    meeting_monitor_.Stop();
+    if (meeting_tsfn_) {
+        meeting_tsfn_.Release();
+        meeting_tsfn_ = Napi::ThreadSafeFunction();
+    }
+}
+
+Napi::Value AudioCaptureAddon::GetMeetingMonitorStats(const Napi::CallbackInfo& info) {
+    return MeetingAudioMonitorStatsToObject(info.Env(), meeting_monitor_.GetStats());
+}
+
+// startKeywordSpotter({ model, keywords: [text | { text, threshold? }] },
+// callback): keywords spotted on the system stream from its shared
+// spectrum, whenever that stream is open, until stopKeywordSpotter().
+// |callback| gets { keyword, index, confidence, startMs, endMs, detectedMs },
+// times as Date.now(). Throws for a model that does not load or a keyword
+// its tokens cannot spell.
+Napi::Value AudioCaptureAddon::StartKeywordSpotter(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Options and callback function required").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (!options.Get("model").IsString()) {
+        Napi::TypeError::New(env, "model path required").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<KeywordSpec> keywords;
+    std::string error;
+    if (!ParseKeywordSpecs(options.Get("keywords"), &keywords, &error)) {
+        Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::shared_ptr<const KeywordModel> model =
+        KeywordModel::Load(options.Get("model").As<Napi::String>().Utf8Value(), &error);
+    if (!model) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    StopKeywordSpotterListening();
+
+    keyword_tsfn_ = Napi::ThreadSafeFunction::New(env, info[1].As<Napi::Function>(), "KeywordSpotted", 0, 1);
+    keyword_tsfn_.Unref(env);
+    Napi::ThreadSafeFunction tsfn = keyword_tsfn_;
+    bool started = keyword_spotter_.Start(std::move(model), keywords, &host_clock_,
+                                          [tsfn](const KeywordEvent& event) mutable {
+        tsfn.NonBlockingCall([event](Napi::Env env, Napi::Function callback) {
+            try {
+                callback.Call({ KeywordEventToObject(env, event) });
+            } catch (...) {
+                // Silently catch to prevent crash
+            }
+        });
+    }, &error);
+    if (!started) {
+        keyword_tsfn_.Release();
+        keyword_tsfn_ = Napi::ThreadSafeFunction();
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    system_stream_.Spectrum().AddListener(&keyword_spotter_);
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::StopKeywordSpotter(const Napi::CallbackInfo& info) {
+    StopKeywordSpotterListening();
+    return info.Env().Undefined();
+}
+
+// Off the spectrum first, so the spotter has no producer when it stops
+void AudioCaptureAddon::StopKeywordSpotterListening() {
+    system_stream_.Spectrum().RemoveListener(&keyword_spotter_);
+    keyword_spotter_.Stop();
+    if (keyword_tsfn_) {
+        keyword_tsfn_.Release();
+        keyword_tsfn_ = Napi::ThreadSafeFunction();
+    }
+}
+
+Napi::Value AudioCaptureAddon::GetKeywordSpotterStats(const Napi::CallbackInfo& info) {
+    return KeywordSpotterStatsToObject(info.Env(), keyword_spotter_.GetStats());
+}
+
+// startVoiceEnrollment(): pools the user's speech on the mic stream, which
+// must be open with verifyVoice, until finishVoiceEnrollment() returns {
+// voiceprint (a Buffer for setVoiceprint() and the voiceprint option),
+// speechSeconds } or cancelVoiceEnrollment(). Finishing throws before
+// enough speech; the voiceprint is in effect at once.
+Napi::Value AudioCaptureAddon::StartVoiceEnrollment(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    VoiceVerifier* verifier = mic_stream_.Verifier();
+    if (!verifier) {
+        Napi::Error::New(env, "Microphone capture with verifyVoice is not running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    verifier->StartEnrollment();
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::FinishVoiceEnrollment(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    VoiceVerifier* verifier = mic_stream_.Verifier();
+    if (!verifier) {
+        Napi::Error::New(env, "Microphone capture with verifyVoice is not running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Voiceprint voiceprint;
+    std::string error;
+    if (!verifier->FinishEnrollment(&voiceprint, &error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::vector<uint8_t> bytes = voiceprint.Serialize();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("voiceprint", Napi::Buffer<uint8_t>::Copy(env, bytes.data(), bytes.size()));
+    result.Set("speechSeconds", Napi::Number::New(env, voiceprint.frames / 100.0));
+    return result;
+}
+
+Napi::Value AudioCaptureAddon::CancelVoiceEnrollment(const Napi::CallbackInfo& info) {
+    if (VoiceVerifier* verifier = mic_stream_.Verifier()) {
+        verifier->CancelEnrollment();
+    }
+    return info.Env().Undefined();
+}
+
+// setVoiceprint(voiceprint | null): the user's voiceprint for the open mic
+// stream; null passes every voice again
+Napi::Value AudioCaptureAddon::SetVoiceprint(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    VoiceVerifier* verifier = mic_stream_.Verifier();
+    if (!verifier) {
+        Napi::Error::New(env, "Microphone capture with verifyVoice is not running").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::shared_ptr<Voiceprint> voiceprint;
+    std::string error;
+    if (info.Length() > 0 && info[0].IsTypedArray() &&
+        info[0].As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array) {
+        Napi::Uint8Array bytes = info[0].As<Napi::Uint8Array>();
+        voiceprint = std::make_shared<Voiceprint>();
+        if (!Voiceprint::Parse(bytes.Data(), bytes.ByteLength(), voiceprint.get(), &error)) {
+            Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+    } else if (info.Length() > 0 && !info[0].IsNull() && !info[0].IsUndefined()) {
+        Napi::TypeError::New(env, "Voiceprint Buffer or null required").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (!verifier->SetVoiceprint(std::move(voiceprint), &error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return env.Undefined();
+}
+
+// getVoiceVerifierStats(): null unless the mic stream has a verifier
+Napi::Value AudioCaptureAddon::GetVoiceVerifierStats(const Napi::CallbackInfo& info) {
+    VoiceVerifier* verifier = mic_stream_.Verifier();
+    if (!verifier) {
+        return info.Env().Null();
+    }
+    return VoiceVerifierStatsToObject(info.Env(), verifier->GetStats());
+}
+
+// AEC METHODS
+
+Napi::Value AudioCaptureAddon::GetMetrics(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        return env.Null();
+    }
+
+    try {
+        return AECMetricsToObject(env, aec_processor_->GetMetrics());
+    } catch (const std::exception& e) {
+        Log(LogLevel::kError, kLogSource, "GetMetrics error: %s", e.what());
+        return env.Null();
+    }
+}
+
+// getMetrics(), then getCaptureStats() and getLatencyTrace() per stream, in
+// slot order; the AEC's slots are unset without a processor
+void AudioCaptureAddon::WriteMetrics(MetricsWriter* writer) {
+    writer->SetPrefix("aec.");
+    WriteAECMetrics(writer, aec_processor_ ? aec_processor_->GetMetrics() : AECMetrics{});
+    const struct {
+        const char* stats_prefix;
+        const char* trace_prefix;
+        const CaptureStream& stream;
+    } streams[] = {
+        { "mic.", "micTrace.", mic_stream_ },
+        { "system.", "systemTrace.", system_stream_ },
+    };
+    for (const auto& entry : streams) {
+        writer->SetPrefix(entry.stats_prefix);
+        WriteCaptureStats(writer, entry.stream.Stats(), host_clock_);
+        writer->SetPrefix(entry.trace_prefix);
+        WriteLatencyTrace(writer, entry.stream.Trace());
+    }
+}
+
+// readMetrics(Float64Array) -> the layout's length. Fills the array at
+// getMetricsLayout()'s offsets as far as it reaches, allocating nothing, so
+// it can be polled every display frame.
+Napi::Value AudioCaptureAddon::ReadMetrics(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_float64_array) {
+        Napi::TypeError::New(env, "Expected a Float64Array").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Float64Array out = info[0].As<Napi::Float64Array>();
+    MetricsWriter writer(out.Data(), out.ElementLength());
+    WriteMetrics(&writer);
+    return Napi::Number::New(env, static_cast<double>(writer.Count()));
+}
+
+// getMetricsLayout() -> { length, offsets }: where readMetrics() puts each value
+Napi::Value AudioCaptureAddon::GetMetricsLayout(const Napi::CallbackInfo& info) {
+    std::vector<std::string> names;
+    MetricsWriter writer(&names);
+    WriteMetrics(&writer);
+    return MetricsLayoutToObject(info.Env(), names);
+}
+
+// getAecProfile() -> { echoDelayMs?, streamDelayMs?, preset? }: what this
+// session converged to, to pass back as the warmStart option
+Napi::Value AudioCaptureAddon::GetAecProfile(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        return env.Null();
+    }
+    return AECWarmStartToObject(env, aec_processor_->GetWarmStart());
+}
+
+// getNoiseProfile() -> { noiseFloor, bandsDb, frames } or null: the mic's
+// noise as heard this session, to pass back as the noiseProfile option
+Napi::Value AudioCaptureAddon::GetNoiseProfile(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::optional<NoiseProfile> learned = aec_processor_ ? aec_processor_->GetNoiseProfile() : std::nullopt;
+    if (!learned) {
+        return env.Null();
+    }
+    return NoiseProfileToObject(env, *learned);
+}
+
+// resetEchoPath(warmStart?) -> sequence: JS saw the output move (there is
+// no native route detection here); without a warm start AEC3 starts cold.
+// 0 without an AEC.
+Napi::Value AudioCaptureAddon::ResetEchoPath(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        return Napi::Number::New(env, 0);
+    }
+    AECWarmStart seed = info.Length() > 0 ? ParseAECWarmStart(info[0]) : AECWarmStart();
+    uint64_t sequence = aec_processor_->ResetEchoPath(seed, EchoPathChange::kRequested);
+    return Napi::Number::New(env, static_cast<double>(sequence));
+}
+
+// startShadowAec(candidate, maxLoad?): runs |candidate| (AEC options over
+// the live configuration) beside the live canceller on the pipeline's
+// frames, its output discarded, under |maxLoad| of one core (default 5%).
+// Throws when it cannot run.
+Napi::Value AudioCaptureAddon::StartShadowAec(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        Napi::Error::New(env, "Shadow evaluation requires the AEC processor").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    AECConfig candidate = ParseAECConfig(info.Length() > 0 ? info[0] : env.Undefined(), aec_processor_->GetConfig());
+    float max_load = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().FloatValue() : 0.0f;
+    std::string error;
+    if (!shadow_aec_.Start(aec_processor_.get(), candidate, static_cast<int>(kCaptureSampleRate), 1,
+                           max_load, &error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::StopShadowAec(const Napi::CallbackInfo& info) {
+    shadow_aec_.Stop();
+    return info.Env().Undefined();
+}
+
+// getShadowComparison(): the running (or last) evaluation's means, for
+// opt-in collection
+Napi::Value AudioCaptureAddon::GetShadowComparison(const Napi::CallbackInfo& info) {
+    return ShadowAecComparisonToObject(info.Env(), shadow_aec_.GetComparison());
+}
+
+Napi::Value AudioCaptureAddon::SetEchoCancellationEnabled(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        return env.Undefined();
+    }
+
+    if (info.Length() < 1 || !info[0].IsBoolean()) {
+        Napi::TypeError::New(env, "Expected boolean").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    try {
+        aec_processor_->SetEchoCancellationEnabled(info[0].As<Napi::Boolean>().Value());
+    } catch (const std::exception& e) {
+        Log(LogLevel::kError, kLogSource, "SetEchoCancellationEnabled error: %s", e.what());
+    }
+
+    return env.Undefined();
+}
+
+// setHeadphoneBypass(bypass): there is no native route detection here
+// yet, so 'auto' is refused and JS drives the bypass
+Napi::Value AudioCaptureAddon::SetHeadphoneBypass(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBoolean()) {
+        Napi::TypeError::New(env, "Expected boolean").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (aec_processor_) {
+        aec_processor_->SetBypass(info[0].As<Napi::Boolean>().Value());
+    }
+    return env.Undefined();
+}
+
+Napi::Value AudioCaptureAddon::Configure(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (low_power_) {
+        aec_base_config_ = ParseAECConfig(info[0], aec_base_config_);
+        return Napi::Boolean::New(env, aec_processor_->Configure(ApplyLowPowerProfile(aec_base_config_)));
+    }
+    AECConfig config = ParseAECConfig(info[0], aec_processor_->GetConfig());
+    return Napi::Boolean::New(env, aec_processor_->Configure(config));
+}
+
+Napi::Value AudioCaptureAddon::GetConfig(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        return env.Null();
+    }
+
+    return AECConfigToObject(env, aec_processor_->GetConfig());
+}
+
+// postConfig(options) -> sequence number: configure() without waiting on the
+// processing threads. The change goes through the processor's mailbox and
+// applies at the next capture frame boundary; getConfigStatus() tells when.
+// 0 without a processor.
+Napi::Value AudioCaptureAddon::PostConfig(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        return Napi::Number::New(env, 0);
+    }
+
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected options object").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    AECConfig config;
+    if (low_power_) {
+        aec_base_config_ = ParseAECConfig(info[0], aec_base_config_);
+        config = ApplyLowPowerProfile(aec_base_config_);
+    } else {
+        config = ParseAECConfig(info[0], aec_processor_->GetConfig());
+    }
+    return Napi::Number::New(env, static_cast<double>(aec_processor_->PostConfig(config)));
+}
+
+// getConfigStatus() -> { posted, applied, rejected, pending, appliedFrame,
+// latencyMs }: where postConfig()'s changes stand
+Napi::Value AudioCaptureAddon::GetConfigStatus(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!aec_processor_) {
+        return env.Null();
+    }
+
+    return AECConfigStatusToObject(env, aec_processor_->GetConfigStatus());
+}
+
+// startAecDump(path, maxBytes = -1), as on macOS
+Napi::Value AudioCaptureAddon::StartAecDump(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Expected dump file path").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int64_t max_bytes = -1;
+    if (info.Length() > 1 && info[1].IsNumber()) {
+        max_bytes = info[1].As<Napi::Number>().Int64Value();
+        if (max_bytes <= 0) {
+            max_bytes = -1;
+        }
+    }
+
+    bool started = aec_processor_ &&
+        aec_processor_->StartAecDump(info[0].As<Napi::String>().Utf8Value(), max_bytes);
+    return Napi::Boolean::New(env, started);
+}
+
+Napi::Value AudioCaptureAddon::StopAecDump(const Napi::CallbackInfo& info) {
+    if (aec_processor_) {
+        aec_processor_->StopAecDump();
+    }
+    return info.Env().Undefined();
+}
+
+// Active capture endpoints, enumerated per call (no listener-maintained table
+// here yet)
+Napi::Value AudioCaptureAddon::GetDevices(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::vector<InputDeviceInfo> list = PlatformCapture::ListInputDevices();
+    Napi::Array devices = Napi::Array::New(env, list.size());
+    uint32_t index = 0;
+    for (const InputDeviceInfo& entry : list) {
+        Napi::Object device = Napi::Object::New(env);
+        device.Set("id", entry.id);
+        device.Set("uid", entry.id);
+        device.Set("name", entry.name);
+        device.Set("isDefault", entry.is_default);
+        device.Set("transport", PlatformCapture::kTransport);
+        device.Set("nominalSampleRate", Napi::Number::New(env, kCaptureSampleRate));
+        device.Set("inputChannels", Napi::Number::New(env, 1));
+        device.Set("outputChannels", Napi::Number::New(env, 0));
+        devices.Set(index++, device);
+    }
+    return devices;
+}
+
+// Pins capture to an endpoint id from getDevices(), or follows the default
+// capture endpoint when called with null/empty. While capturing, the stream
+// is reopened on the new endpoint right away.
+Napi::Value AudioCaptureAddon::SetInputDevice(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::string id;
+    if (info.Length() > 0 && info[0].IsString()) {
+        id = info[0].As<Napi::String>().Utf8Value();
+    } else if (info.Length() > 0 && !info[0].IsNull() && !info[0].IsUndefined()) {
+        Napi::TypeError::New(env, "Expected device id string or null").ThrowAsJavaScriptException();
+        return Napi::Boolean::New(env, false);
+    }
+
+    if (!id.empty()) {
+        std::vector<InputDeviceInfo> list = PlatformCapture::ListInputDevices();
+        bool known = std::any_of(list.begin(), list.end(), [&](const InputDeviceInfo& entry) { return entry.id == id; });
+        if (!known) {
+            Napi::Error::New(env, "Unknown input device: " + id).ThrowAsJavaScriptException();
+            return Napi::Boolean::New(env, false);
+        }
+    }
+    if (mic_busy_) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    selected_device_id_ = id;
+    Log(LogLevel::kInfo, kLogSource, "Input device set to %s", id.empty() ? "system default" : id.c_str());
+    if (!is_capturing_) {
+        return Napi::Boolean::New(env, true);
+    }
+
+    // The rings and the AEC pipeline stay up; only the producer changes
+    std::string error;
+    mic_capture_.Stop();
+    if (!mic_capture_.Start(selected_device_id_, &error)) {
+        Log(LogLevel::kError, kLogSource, "Switching input device failed: %s", error.c_str());
+        return Napi::Boolean::New(env, false);
+    }
+    CaptureSessionEvent(SessionStream::kMicrophone, SessionEventType::kDevice, mic_capture_.DeviceId().c_str());
+    // Another mic, another echo path: the old filter would only slow AEC3 down
+    if (aec_processor_ && mic_feeds_pipeline_.load(std::memory_order_acquire)) {
+        aec_processor_->ResetEchoPath(AECWarmStart(), EchoPathChange::kInputDevice);
+    }
+    return Napi::Boolean::New(env, true);
+}
+
+// Endpoint currently captured from (or that the next start would use)
+Napi::Value AudioCaptureAddon::GetInputDevice(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::string id = mic_capture_.IsRunning() ? mic_capture_.DeviceId() : selected_device_id_;
+    if (id.empty()) {
+        for (const InputDeviceInfo& entry : PlatformCapture::ListInputDevices()) {
+            if (entry.is_default) {
+                id = entry.id;
+            }
+        }
+    }
+    if (id.empty()) {
+        return env.Null();
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("id", id);
+    result.Set("followsDefault", selected_device_id_.empty());
+    return result;
+}
+
+// Converts a monotonic host time in ms (as delivered with capture buffers)
+// to the JS Date.now() domain using this session's clock anchor
+Napi::Value AudioCaptureAddon::HostTimeToDateNow(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected host time in milliseconds").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    double host_ms = info[0].As<Napi::Number>().DoubleValue();
+    return Napi::Number::New(env, host_clock_.ToDateNowMs(host_clock_.MsToTicks(host_ms)));
+}
+
+Napi::Value AudioCaptureAddon::GetHostTime(const Napi::CallbackInfo& info) {
+    return Napi::Number::New(info.Env(), host_clock_.HostTimeMs(HostTimeNow()));
+}
+
+// Counters since each stream's last start; safe to poll while capturing
+Napi::Value AudioCaptureAddon::GetCaptureStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("mic", CaptureStatsToObject(env, mic_stream_.Stats(), host_clock_));
+    result.Set("system", CaptureStatsToObject(env, system_stream_.Stats(), host_clock_));
+    result.Set("lowPower", low_power_);
+#if defined(_WIN32)
+    result.Set("micEngine", mic_engine_ == MicEngine::kCommunications ? "communications" : "hal");
+    // The last communications stream's endpoint AEC
+    const SystemEchoCancellation endpoint = mic_capture_.EchoCancellation();
+    Napi::Object endpoint_aec = Napi::Object::New(env);
+    endpoint_aec.Set("state", endpoint == SystemEchoCancellation::kOn ? "on"
+                                  : endpoint == SystemEchoCancellation::kOff ? "off" : "unavailable");
+    endpoint_aec.Set("nativeBypassed", endpoint_aec_.load(std::memory_order_relaxed));
+    result.Set("endpointAec", endpoint_aec);
+#endif
+    return result;
+}
+
+// Whether the running mic capture goes through the AEC pipeline; on Windows
+// a communications start whose endpoint cancels echo does not
+Napi::Value AudioCaptureAddon::IsMicrophoneProcessed(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), mic_feeds_pipeline_.load(std::memory_order_acquire));
+}
+
+// setPowerProfile('normal' | 'lowPower' | 'auto') -> whether low power is now
+// in effect. No power source is watched here, so 'auto' stays normal.
+Napi::Value AudioCaptureAddon::SetPowerProfile(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    PowerProfile profile;
+    if (info.Length() < 1 || !ParsePowerProfile(info[0], &profile)) {
+        Napi::TypeError::New(env, "Expected 'normal', 'lowPower' or 'auto'").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    bool low_power = profile == PowerProfile::kLowPower;
+    if (low_power == low_power_) {
+        return Napi::Boolean::New(env, low_power_);
+    }
+    low_power_ = low_power;
+
+    double min_delivery_ms = low_power ? kLowPowerDeliveryMs : 0.0;
+    mic_stream_.SetMinDeliveryIntervalMs(min_delivery_ms);
+    system_stream_.SetMinDeliveryIntervalMs(min_delivery_ms);
+    if (aec_processor_) {
+        if (low_power) {
+            aec_base_config_ = aec_processor_->GetConfig();
+            aec_processor_->PostConfig(ApplyLowPowerProfile(aec_base_config_));
+        } else {
+            AECConfig current = aec_processor_->GetConfig();
+            AECConfig restored = aec_base_config_;
+            restored.enable_aec = current.enable_aec;
+            restored.warm_start = current.warm_start;
+            aec_processor_->PostConfig(restored);
+        }
+    }
+    Log(LogLevel::kInfo, kLogSource, low_power ? "Low-power profile on" : "Low-power profile off");
+    return Napi::Boolean::New(env, low_power_);
+}
+
+// Per-stage delivery latency since each stream's last start
+Napi::Value AudioCaptureAddon::GetLatencyTrace(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("mic", LatencyTraceToObject(env, mic_stream_.Trace()));
+    result.Set("system", LatencyTraceToObject(env, system_stream_.Trace()));
+    return result;
+}
+
+// markAudioSent(stream, sampleIndex): the delivery starting at |sampleIndex|
+// on 'mic' or 'system' has been written out; closes its trace
+Napi::Value AudioCaptureAddon::MarkAudioSent(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system', sampleIndex: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    CaptureStream* stream = name == "mic" ? &mic_stream_ : name == "system" ? &system_stream_ : nullptr;
+    double sample_index = info[1].As<Napi::Number>().DoubleValue();
+    if (!stream || sample_index < 0.0) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system', sampleIndex: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return Napi::Boolean::New(env, stream->MarkSent(static_cast<uint64_t>(sample_index)));
+}
+
+// subscribeCapture(stream, callback, options?): another callback for a
+// running stream's audio, sharing its buffers; see CaptureStream::Subscribe().
+// Returns the subscription's ID, or 0 when the stream is not running.
+Napi::Value AudioCaptureAddon::SubscribeCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system', callback: Function, options?: object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    CaptureStream* stream = name == "mic" ? &mic_stream_ : name == "system" ? &system_stream_ : nullptr;
+    if (!stream) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system', callback: Function, options?: object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    SubscriberOptions options = ParseSubscriberOptions(info.Length() > 2 ? info[2] : env.Undefined());
+    uint64_t id = stream->Subscribe(env, info[1].As<Napi::Function>(), options);
+    return Napi::Number::New(env, static_cast<double>(id));
+}
+
+// unsubscribeCapture(id): ends a subscribeCapture() subscription; false when
+// it already ended (unsubscribed, or its stream stopped)
+Napi::Value AudioCaptureAddon::UnsubscribeCapture(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (id: number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    uint64_t id = static_cast<uint64_t>(info[0].As<Napi::Number>().DoubleValue());
+    return Napi::Boolean::New(env, mic_stream_.Unsubscribe(id) || system_stream_.Unsubscribe(id));
+}
+
+// readHistory(stream, range): what a stream started with the history option
+// kept of the given range; see ReadCaptureHistory()
+Napi::Value AudioCaptureAddon::ReadHistory(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    std::string name = info.Length() > 0 && info[0].IsString() ? info[0].As<Napi::String>().Utf8Value() : "";
+    const CaptureStream* stream = name == "mic" ? &mic_stream_ : name == "system" ? &system_stream_ : nullptr;
+    if (!stream || info.Length() < 2) {
+        Napi::TypeError::New(env, "Expected (stream: 'mic' | 'system', range: object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return ReadCaptureHistory(env, *stream, host_clock_, info[1]);
+}
+
+// armSharedStart(): the next start of the mic and of system audio count
+// their sampleIndex from one host instant, now, and drop anything captured
+// before it; returns { hostTimeMs, timestamp } of that instant.
+// armSharedStart(false) disarms both.
+Napi::Value AudioCaptureAddon::ArmSharedStart(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    bool arm = !(info.Length() > 0 && info[0].IsBoolean() && !info[0].As<Napi::Boolean>().Value());
+    if (!mic_stream_.IsOpen() && !system_stream_.IsOpen()) {
+        host_clock_.Anchor();
+    }
+    uint64_t start = arm ? HostTimeNow() : 0;
+    mic_stream_.SetStartHost(start);
+    system_stream_.SetStartHost(start);
+    if (!arm) {
+        return env.Null();
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("hostTimeMs", host_clock_.HostTimeMs(start));
+    result.Set("timestamp", host_clock_.ToDateNowMs(start));
+    return result;
+}
+
+// startLevelMeter(callback, { rateHz = 30 }): peak and RMS of every stream's
+// delivered audio at display rate, { time, mic, system: { rms, peak } }
+Napi::Value AudioCaptureAddon::StartLevelMeter(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (callback, { rateHz?, spectrum? })").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    double rate_hz = 30.0;
+    SpectrumOptions spectrum;
+    bool with_spectrum = false;
+    if (info.Length() > 1 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("rateHz") && options.Get("rateHz").IsNumber()) {
+            rate_hz = options.Get("rateHz").As<Napi::Number>().DoubleValue();
+        }
+        if (options.Has("spectrum")) {
+            with_spectrum = ParseSpectrumOptions(options.Get("spectrum"), &spectrum);
+        }
+    }
+    level_meter_.Start(env, info[0].As<Napi::Function>(), rate_hz, &host_clock_, {
+        {"mic", &mic_stream_.Meter(), &mic_stream_.Spectrum()},
+        {"system", &system_stream_.Meter(), &system_stream_.Spectrum()}
+    }, with_spectrum ? &spectrum : nullptr);
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value AudioCaptureAddon::StopLevelMeter(const Napi::CallbackInfo& info) {
+    level_meter_.Stop();
+    return info.Env().Undefined();
+}
+
+Napi::Value AudioCaptureAddon::Start(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), true);
+}
+
+Napi::Value AudioCaptureAddon::Stop(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), true);
+}
+
+Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
+    InitModuleFunctions(env, exports);
+    return AudioCaptureAddon::Init(env, exports);
+}
+
+NODE_API_MODULE(audio_capture_native, InitAll)
@@ -0,0 +1,215 @@
+#include "audio_classifier.h"
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+// Frames per label
+static constexpr size_t kFramesPerSecond = 100;
+
+// Spectral features are taken over this band: speech, and most of what music has
+static constexpr float kBandHz[2] = {100.0f, 8000.0f};
+
+// A second quieter than this (-55dBFS) is silence; frames quieter than
+// -65dBFS carry no spectral features
+static constexpr float kSilencePower = 3.2e-6f;
+static constexpr float kQuietFramePower = 3.2e-7f;
+
+// A frame the VAD scores at least this counts as speech
+static constexpr float kSpeechProbability = 0.5f;
+
+// A frame whose energy is under this share of the second's mean is a dip;
+// speech has one every syllable, music and noise hardly any
+static constexpr float kDipShare = 0.5f;
+
+// The speech score weighs the VAD's share of speech frames, the share of
+// dips and the median spectral change (1 - cosine similarity of consecutive
+// magnitude spectra), the last two through ramps 0 below their first value
+// and 1 above their second. A second scoring kSpeechScore or more is speech.
+static constexpr float kVadWeight = 0.4f;
+static constexpr float kDipWeight = 0.3f;
+static constexpr float kChangeWeight = 0.3f;
+static constexpr float kDipRamp[2] = {0.1f, 0.35f};
+static constexpr float kChangeRamp[2] = {0.08f, 0.25f};
+static constexpr float kSpeechScore = 0.5f;
+
+// Non-speech this spectrally flat (geometric over arithmetic mean power;
+// white noise is about 0.56, tonal music a few hundredths), or whose
+// spectrum changes this much frame to frame (random, where music holds its
+// partials), is noise
+static constexpr float kNoiseFlatness = 0.3f;
+static constexpr float kNoiseChange = 0.12f;
+
+static float Ramp(float value, const float (&range)[2]) {
+    return std::max(0.0f, std::min((value - range[0]) / (range[1] - range[0]), 1.0f));
+}
+
+static size_t FftSizeFor(size_t frame_size) {
+    size_t size = 128;
+    while (size < frame_size) {
+        size *= 2;
+    }
+    return size;
+}
+
+bool AudioClassifier::Supports(int sample_rate) {
+    return sample_rate >= 8000 && sample_rate <= 48000 && sample_rate % 100 == 0;
+}
+
+AudioClassifier::AudioClassifier(int sample_rate)
+    : frame_size_(static_cast<size_t>(sample_rate / 100)),
+      fft_size_(FftSizeFor(frame_size_)),
+      fft_(std::make_unique<webrtc::Pffft>(fft_size_, webrtc::Pffft::FftType::kReal)),
+      fft_in_(fft_->CreateBuffer()),
+      fft_out_(fft_->CreateBuffer()),
+      window_(frame_size_),
+      power_(fft_size_ / 2 + 1, 0.0f),
+      frame_(frame_size_, 0.0f) {
+    const size_t nyquist = fft_size_ / 2;
+    band_begin_ = std::max<size_t>(1, static_cast<size_t>(std::lround(kBandHz[0] * fft_size_ / sample_rate)));
+    band_end_ = std::min(nyquist, static_cast<size_t>(std::lround(kBandHz[1] * fft_size_ / sample_rate)) + 1);
+    magnitudes_.assign(band_end_ - band_begin_, 0.0f);
+    const double pi = std::acos(-1.0);
+    for (size_t i = 0; i < frame_size_; ++i) {
+        window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * (i + 0.5) / frame_size_));
+    }
+    energies_.reserve(kFramesPerSecond);
+    flatness_.reserve(kFramesPerSecond);
+    changes_.reserve(kFramesPerSecond);
+}
+
+AudioClassifier::~AudioClassifier() = default;
+
+void AudioClassifier::Reset() {
+    std::fill(magnitudes_.begin(), magnitudes_.end(), 0.0f);
+    energies_.clear();
+    flatness_.clear();
+    changes_.clear();
+    speech_frames_ = 0;
+    label_ = AudioClass::kSilence;
+    confidence_ = 0.0f;
+    fill_ = 0;
+}
+
+bool AudioClassifier::ProcessFrame(const float* frame, float speech_probability) {
+    float energy = 0.0f;
+    for (size_t i = 0; i < frame_size_; ++i) {
+        energy += frame[i] * frame[i];
+    }
+    energy /= static_cast<float>(frame_size_);
+    energies_.push_back(energy);
+    if (speech_probability >= kSpeechProbability) {
+        ++speech_frames_;
+    }
+
+    if (energy >= kQuietFramePower) {
+        float* in = fft_in_->GetView().data();
+        for (size_t i = 0; i < frame_size_; ++i) {
+            in[i] = frame[i] * window_[i];
+        }
+        std::fill(in + frame_size_, in + fft_size_, 0.0f);
+        fft_->ForwardTransform(*fft_in_, fft_out_.get(), true);
+
+        dsp::OrderedPower(fft_out_->GetConstView().data(), fft_size_, power_.data());
+        double log_sum = 0.0;
+        double power_sum = 0.0;
+        float dot = 0.0f, norm = 0.0f, previous_norm = 0.0f;
+        for (size_t k = band_begin_; k < band_end_; ++k) {
+            float power = power_[k] + 1e-12f;
+            log_sum += std::log(power);
+            power_sum += power;
+            float magnitude = std::sqrt(power);
+            float& last = magnitudes_[k - band_begin_];
+            dot += magnitude * last;
+            norm += power;
+            previous_norm += last * last;
+            last = magnitude;
+        }
+        const double bins = static_cast<double>(band_end_ - band_begin_);
+        flatness_.push_back(static_cast<float>(std::exp(log_sum / bins) / (power_sum / bins)));
+        if (previous_norm > 0.0f) {
+            changes_.push_back(1.0f - dot / std::sqrt(norm * previous_norm));
+        }
+    } else {
+        std::fill(magnitudes_.begin(), magnitudes_.end(), 0.0f);
+    }
+
+    if (energies_.size() < kFramesPerSecond) {
+        return false;
+    }
+    Classify();
+    energies_.clear();
+    flatness_.clear();
+    changes_.clear();
+    speech_frames_ = 0;
+    return true;
+}
+
+void AudioClassifier::Classify() {
+    const float frames = static_cast<float>(energies_.size());
+    float mean_energy = 0.0f;
+    for (float energy : energies_) {
+        mean_energy += energy;
+    }
+    mean_energy /= frames;
+    if (mean_energy < kSilencePower || flatness_.empty()) {
+        label_ = AudioClass::kSilence;
+        confidence_ = 1.0f;
+        return;
+    }
+
+    size_t dips = 0;
+    for (float energy : energies_) {
+        if (energy < kDipShare * mean_energy) {
+            ++dips;
+        }
+    }
+    float flatness = 0.0f;
+    for (float value : flatness_) {
+        flatness += value;
+    }
+    flatness /= static_cast<float>(flatness_.size());
+    // The median, so a few note onsets do not make music look like speech
+    float change = 0.0f;
+    if (!changes_.empty()) {
+        auto middle = changes_.begin() + changes_.size() / 2;
+        std::nth_element(changes_.begin(), middle, changes_.end());
+        change = *middle;
+    }
+
+    const float score = kVadWeight * (static_cast<float>(speech_frames_) / frames) +
+                        kDipWeight * Ramp(static_cast<float>(dips) / frames, kDipRamp) +
+                        kChangeWeight * Ramp(change, kChangeRamp);
+    if (score >= kSpeechScore) {
+        label_ = AudioClass::kSpeech;
+        confidence_ = score;
+    } else {
+        label_ = flatness >= kNoiseFlatness || change >= kNoiseChange ? AudioClass::kNoise : AudioClass::kMusic;
+        confidence_ = 1.0f - score;
+    }
+}
+
+void AudioClassifier::Process(const float* data, size_t num_samples, const std::vector<float>* probabilities,
+                              std::vector<uint8_t>* labels) {
+    size_t next = 0;
+    size_t offset = 0;
+    while (offset < num_samples) {
+        size_t count = std::min(frame_size_ - fill_, num_samples - offset);
+        std::memcpy(frame_.data() + fill_, data + offset, count * sizeof(float));
+        fill_ += count;
+        offset += count;
+        if (fill_ < frame_size_) {
+            break;
+        }
+        fill_ = 0;
+        float probability = probabilities && next < probabilities->size() ? (*probabilities)[next] : 0.0f;
+        ++next;
+        if (ProcessFrame(frame_.data(), probability) && labels) {
+            labels->push_back(static_cast<uint8_t>(label_));
+        }
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "modules/audio_processing/utility/pffft_wrapper.h"
+
+namespace kakarot {
+
+// What a second of audio is, as far as transcribing it goes
+enum class AudioClass : uint8_t {
+    kSilence = 0,
+    kSpeech = 1,
+    kMusic = 2,  // hold music, a clip's soundtrack: tonal and steady
+    kNoise = 3,  // fans, traffic, static: flat-spectrum and steady
+};
+
+// Labels each second of a stream speech, music, noise or silence from the
+// RNN VAD's per-frame probabilities and a few spectral features of its 10ms
+// frames: how often energy dips (syllables), how much the spectrum changes
+// frame to frame, and how flat it is. Speech is VAD-positive, dips and
+// keeps changing; music holds its partials; noise is flat. Hand-tuned
+// thresholds, no model. Not thread-safe: one instance per stream.
+class AudioClassifier {
+public:
+    // 10ms frames at 8 to 48kHz
+    static bool Supports(int sample_rate);
+
+    explicit AudioClassifier(int sample_rate);
+    ~AudioClassifier();
+
+    AudioClassifier(const AudioClassifier&) = delete;
+    AudioClassifier& operator=(const AudioClassifier&) = delete;
+
+    // One frame of FrameSize() samples and its VAD probability. True when it
+    // completes a second, which Label() and Confidence() then describe.
+    bool ProcessFrame(const float* frame, float speech_probability);
+
+    // |num_samples| through an internal frame; |probabilities| are the VAD's
+    // for the frames they complete, in order (missing ones count as 0). The
+    // label of each second completed is appended to |labels|.
+    void Process(const float* data, size_t num_samples, const std::vector<float>* probabilities,
+                 std::vector<uint8_t>* labels);
+
+    AudioClass Label() const { return label_; }
+    float Confidence() const { return confidence_; }
+
+    void Reset();
+
+    size_t FrameSize() const { return frame_size_; }
+
+private:
+    void Classify();
+
+    const size_t frame_size_;
+    const size_t fft_size_;
+    size_t band_begin_ = 0;
+    size_t band_end_ = 0;
+    std::unique_ptr<webrtc::Pffft> fft_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_in_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_out_;
+    std::vector<float> window_;
+    std::vector<float> power_;       // this frame's, DC to Nyquist
+    std::vector<float> magnitudes_;  // last frame's, over the band
+
+    // This second so far, one entry per frame
+    std::vector<float> energies_;
+    std::vector<float> flatness_;
+    std::vector<float> changes_;
+    size_t speech_frames_ = 0;
+
+    AudioClass label_ = AudioClass::kSilence;
+    float confidence_ = 0.0f;
+
+    std::vector<float> frame_;
+    size_t fill_ = 0;
+};
+
+} // namespace kakarot
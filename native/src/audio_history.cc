@@ -0,0 +1,343 @@
+#include "audio_history.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "ogg_opus_writer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#if defined(KAKAROT_HAVE_OPUS)
+#include <opus.h>
+#endif
+
+namespace kakarot {
+
+#if defined(KAKAROT_HAVE_OPUS)
+
+// 20ms packets, fifty to a block: the history grows and drops a second at a time
+static constexpr int kPacketMs = 20;
+static constexpr size_t kBlockPackets = 50;
+static constexpr size_t kMaxPacketBytes = 1275;
+
+// Decoding starts this many packets ahead of a read, as RFC 7845 advises
+// for seeking (80ms), so the first samples kept come out of a warm decoder
+static constexpr size_t kPrerollPackets = 4;
+
+// Live, next to the rest of the consumer thread's work: about half the
+// encoder's top cost, and still transparent for speech at 24kbit/s
+static constexpr int kEncoderComplexity = 5;
+
+// Encoded reads: half a second of packets per Ogg page
+static constexpr size_t kOggPacketsPerPage = 25;
+
+static bool IsOpusRate(int sample_rate) {
+    return sample_rate == 8000 || sample_rate == 12000 || sample_rate == 16000 || sample_rate == 24000 ||
+           sample_rate == 48000;
+}
+
+void AudioHistory::EncoderDeleter::operator()(OpusEncoder* encoder) const {
+    opus_encoder_destroy(encoder);
+}
+
+std::unique_ptr<AudioHistory> AudioHistory::Create(const HostClock* clock, int sample_rate, double seconds,
+                                                   int bitrate, std::string* error) {
+    if (sample_rate <= 0 || sample_rate % 100 != 0) {
+        *error = "history needs a rate that is a multiple of 100Hz";
+        return nullptr;
+    }
+    const int rate = IsOpusRate(sample_rate) ? sample_rate : 48000;
+    int status = OPUS_OK;
+    OpusEncoder* encoder = opus_encoder_create(rate, 1, OPUS_APPLICATION_AUDIO, &status);
+    if (status != OPUS_OK || !encoder) {
+        *error = std::string("opus_encoder_create failed: ") + opus_strerror(status);
+        return nullptr;
+    }
+    opus_encoder_ctl(encoder, OPUS_SET_BITRATE(bitrate));
+    opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(kEncoderComplexity));
+    size_t max_blocks = static_cast<size_t>(std::max(1.0, std::ceil(seconds * 1000.0 / (kPacketMs * kBlockPackets))));
+    size_t block_bytes = static_cast<size_t>(bitrate) / 8 * kPacketMs * kBlockPackets / 1000 * 3 / 2;
+    return std::unique_ptr<AudioHistory>(new AudioHistory(clock, sample_rate, rate, max_blocks, block_bytes, encoder));
+}
+
+AudioHistory::AudioHistory(const HostClock* clock, int input_rate, int rate, size_t max_blocks, size_t block_bytes,
+                           OpusEncoder* encoder)
+    : clock_(clock),
+      input_rate_(input_rate),
+      rate_(rate),
+      packet_samples_(static_cast<size_t>(rate * kPacketMs / 1000)),
+      max_blocks_(max_blocks),
+      block_bytes_(block_bytes),
+      encoder_(encoder) {
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(encoder_.get(), OPUS_GET_LOOKAHEAD(&lookahead));
+    lookahead_ = static_cast<int>(lookahead);
+    if (input_rate_ != rate_) {
+        resample_in_.assign(static_cast<size_t>(input_rate_ / 100), 0.0f);
+        resample_out_.assign(static_cast<size_t>(rate_ / 100), 0.0f);
+        resampler_ = std::make_unique<webrtc::PushSincResampler>(resample_in_.size(), resample_out_.size());
+        resample_delay_ = clock_->MsToTicks(webrtc::PushSincResampler::AlgorithmicDelaySeconds(input_rate_) * 1000.0);
+    }
+    packet_.assign(packet_samples_, 0.0f);
+    payload_.assign(kMaxPacketBytes, 0);
+}
+
+AudioHistory::~AudioHistory() = default;
+
+void AudioHistory::Append(const float* samples, size_t num_samples, uint64_t host_time) {
+    const uint64_t tolerance = clock_->MsToTicks(kPacketMs);
+    if (expected_host_ == 0 || host_time > expected_host_ + tolerance || host_time + tolerance < expected_host_) {
+        resample_fill_ = 0;
+        packet_fill_ = 0;
+        run_host_ = host_time - std::min(host_time, resample_delay_);
+        run_packets_ = 0;
+        new_run_ = true;
+    }
+    expected_host_ = host_time + clock_->MsToTicks(num_samples * 1000.0 / input_rate_);
+
+    auto feed = [this](const float* values, size_t count) {
+        while (count > 0) {
+            size_t take = std::min(count, packet_samples_ - packet_fill_);
+            std::memcpy(packet_.data() + packet_fill_, values, take * sizeof(float));
+            packet_fill_ += take;
+            values += take;
+            count -= take;
+            if (packet_fill_ == packet_samples_) {
+                EncodePacket();
+                packet_fill_ = 0;
+            }
+        }
+    };
+    if (!resampler_) {
+        feed(samples, num_samples);
+        return;
+    }
+    while (num_samples > 0) {
+        size_t take = std::min(num_samples, resample_in_.size() - resample_fill_);
+        std::memcpy(resample_in_.data() + resample_fill_, samples, take * sizeof(float));
+        resample_fill_ += take;
+        samples += take;
+        num_samples -= take;
+        if (resample_fill_ == resample_in_.size()) {
+            resampler_->Resample(resample_in_.data(), resample_in_.size(), resample_out_.data(), resample_out_.size());
+            feed(resample_out_.data(), resample_out_.size());
+            resample_fill_ = 0;
+        }
+    }
+}
+
+// A failed encode keeps its place as an empty packet, which decodes as a
+// lost one, so the timing after it holds
+void AudioHistory::EncodePacket() {
+    opus_int32 size = opus_encode_float(encoder_.get(), packet_.data(), static_cast<int>(packet_samples_),
+                                        payload_.data(), static_cast<opus_int32>(payload_.size()));
+    size_t bytes = size > 0 ? static_cast<size_t>(size) : 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (blocks_.empty() || new_run_ || blocks_.back().ends.size() == kBlockPackets) {
+        if (blocks_.size() == max_blocks_) {
+            Block& oldest = blocks_.front();
+            bytes_ -= oldest.data.capacity() + oldest.ends.capacity() * sizeof(uint32_t);
+            spare_ = std::move(oldest);
+            blocks_.pop_front();
+        }
+        Block block = std::move(spare_);
+        spare_ = Block();
+        block.data.clear();
+        block.ends.clear();
+        block.host_time = run_host_ + clock_->MsToTicks(static_cast<double>(run_packets_ * kPacketMs));
+        block.continues = !new_run_ && !blocks_.empty();
+        blocks_.push_back(std::move(block));
+        new_run_ = false;
+    }
+    Block& block = blocks_.back();
+    const size_t before = block.data.capacity() + block.ends.capacity() * sizeof(uint32_t);
+    if (block.ends.capacity() == 0) {
+        block.ends.reserve(kBlockPackets);
+        block.data.reserve(block_bytes_);
+    }
+    block.data.insert(block.data.end(), payload_.data(), payload_.data() + bytes);
+    block.ends.push_back(static_cast<uint32_t>(block.data.size()));
+    bytes_ += block.data.capacity() + block.ends.capacity() * sizeof(uint32_t) - before;
+    ++run_packets_;
+}
+
+bool AudioHistory::Read(uint64_t from_host, uint64_t to_host, bool encoded, HistoryRange* range,
+                        std::string* error) const {
+    const int64_t n = static_cast<int64_t>(packet_samples_);
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> sizes;
+    int64_t begin = 0;  // first wanted sample, counted from the first packet copied
+    int64_t end = 0;
+    range->segments.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // |host| as a sample of a block starting at |start| |samples| long
+        auto offset = [this](uint64_t start, uint64_t host, int64_t samples) -> int64_t {
+            if (host <= start) {
+                return 0;
+            }
+            double at = std::round(clock_->TicksToMs(host - start) * rate_ / 1000.0);
+            return std::min<int64_t>(samples, static_cast<int64_t>(at));
+        };
+        size_t first = blocks_.size();
+        size_t last = 0;
+        int64_t first_begin = 0;
+        int64_t last_end = 0;
+        for (size_t i = 0; i < blocks_.size(); ++i) {
+            int64_t samples = static_cast<int64_t>(blocks_[i].ends.size()) * n;
+            int64_t s0 = offset(blocks_[i].host_time, from_host, samples);
+            int64_t s1 = offset(blocks_[i].host_time, to_host, samples);
+            if (s1 <= s0) {
+                continue;
+            }
+            if (first == blocks_.size()) {
+                first = i;
+                first_begin = s0;
+            }
+            last = i;
+            last_end = s1;
+        }
+        if (first == blocks_.size()) {
+            *error = blocks_.empty() ? "no history held" : "no history held in that range";
+            return false;
+        }
+
+        auto copy = [&](const Block& block, size_t from_packet, size_t to_packet) {
+            for (size_t p = from_packet; p < to_packet; ++p) {
+                uint32_t start = p == 0 ? 0 : block.ends[p - 1];
+                data.insert(data.end(), block.data.begin() + start, block.data.begin() + block.ends[p]);
+                sizes.push_back(block.ends[p] - start);
+            }
+        };
+
+        // Warm-up packets, reaching into the block before when the run does
+        size_t start_packet = static_cast<size_t>(first_begin / n);
+        size_t warm = std::min(start_packet, kPrerollPackets);
+        if (warm < kPrerollPackets && blocks_[first].continues && first > 0) {
+            const Block& before = blocks_[first - 1];
+            size_t extra = std::min(kPrerollPackets - warm, before.ends.size());
+            copy(before, before.ends.size() - extra, before.ends.size());
+        }
+        int64_t block_start = static_cast<int64_t>(sizes.size()) * n - static_cast<int64_t>(start_packet - warm) * n;
+        copy(blocks_[first], start_packet - warm, blocks_[first].ends.size());
+        begin = block_start + first_begin;
+
+        for (size_t i = first; i <= last; ++i) {
+            if (i > first) {
+                block_start += static_cast<int64_t>(blocks_[i - 1].ends.size()) * n;
+                copy(blocks_[i], 0, blocks_[i].ends.size());
+            }
+            if (i == first || !blocks_[i].continues) {
+                int64_t s0 = i == first ? first_begin : 0;
+                HistoryRange::Segment segment;
+                segment.offset = static_cast<size_t>(block_start + s0 - begin);
+                segment.host_time = blocks_[i].host_time + clock_->MsToTicks(s0 * 1000.0 / rate_);
+                range->segments.push_back(segment);
+            }
+        }
+        end = block_start + last_end;
+        // The encoder's delay: the last samples come out of the packet after
+        if (last + 1 < blocks_.size() && blocks_[last + 1].continues && !blocks_[last + 1].ends.empty()) {
+            copy(blocks_[last + 1], 0, 1);
+        }
+    }
+
+    // Past the newest packet the delayed tail is not there yet
+    const int64_t total = static_cast<int64_t>(sizes.size()) * n;
+    end = std::min(end, total - lookahead_);
+    if (end <= begin) {
+        *error = "no history held in that range";
+        return false;
+    }
+
+    range->sample_rate = rate_;
+    range->length = static_cast<size_t>(end - begin);
+    range->samples.clear();
+    range->ogg.clear();
+    if (encoded) {
+        // Pre-skip covers the warm-up and the encoder delay; the last
+        // granule trims the rest
+        const int scale = 48000 / rate_;
+        const int pre_skip = static_cast<int>(begin + lookahead_) * scale;
+        OggOpusWriter writer;
+        writer.Begin(static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count()), input_rate_,
+                     pre_skip, &range->ogg);
+        size_t at = 0;
+        for (uint32_t size : sizes) {
+            writer.AddPacket(data.data() + at, size, 48 * kPacketMs);
+            at += size;
+            if (writer.PendingPackets() >= kOggPacketsPerPage) {
+                writer.Flush(&range->ogg);
+            }
+        }
+        writer.Finish(static_cast<uint64_t>(pre_skip + (end - begin) * scale), &range->ogg);
+        return true;
+    }
+
+    int status = OPUS_OK;
+    OpusDecoder* decoder = opus_decoder_create(rate_, 1, &status);
+    if (status != OPUS_OK || !decoder) {
+        *error = std::string("opus_decoder_create failed: ") + opus_strerror(status);
+        return false;
+    }
+    std::vector<float> decoded(static_cast<size_t>(total), 0.0f);
+    size_t at = 0;
+    for (size_t p = 0; p < sizes.size(); ++p) {
+        // An empty packet is a lost one: the decoder conceals it
+        const unsigned char* packet = sizes[p] > 0 ? data.data() + at : nullptr;
+        opus_decode_float(decoder, packet, static_cast<opus_int32>(sizes[p]), decoded.data() + p * packet_samples_,
+                          static_cast<int>(packet_samples_), 0);
+        at += sizes[p];
+    }
+    opus_decoder_destroy(decoder);
+    range->samples.assign(decoded.begin() + begin + lookahead_, decoded.begin() + end + lookahead_);
+    return true;
+}
+
+uint64_t AudioHistory::Bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_ + spare_.data.capacity() + spare_.ends.capacity() * sizeof(uint32_t);
+}
+
+double AudioHistory::HeldMs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t packets = 0;
+    for (const Block& block : blocks_) {
+        packets += block.ends.size();
+    }
+    return static_cast<double>(packets * kPacketMs);
+}
+
+uint64_t AudioHistory::NewestHost() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (blocks_.empty()) {
+        return 0;
+    }
+    const Block& newest = blocks_.back();
+    return newest.host_time + clock_->MsToTicks(static_cast<double>(newest.ends.size() * kPacketMs));
+}
+
+#else
+
+void AudioHistory::EncoderDeleter::operator()(OpusEncoder*) const {}
+
+std::unique_ptr<AudioHistory> AudioHistory::Create(const HostClock*, int, double, int, std::string* error) {
+    *error = "built without Opus";
+    return nullptr;
+}
+
+AudioHistory::~AudioHistory() = default;
+
+void AudioHistory::Append(const float*, size_t, uint64_t) {}
+
+bool AudioHistory::Read(uint64_t, uint64_t, bool, HistoryRange*, std::string* error) const {
+    *error = "built without Opus";
+    return false;
+}
+
+uint64_t AudioHistory::Bytes() const { return 0; }
+double AudioHistory::HeldMs() const { return 0.0; }
+uint64_t AudioHistory::NewestHost() const { return 0; }
+
+#endif
+
+} // namespace kakarot
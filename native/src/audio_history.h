@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "host_time.h"
+
+struct OpusEncoder;
+
+namespace webrtc {
+class PushSincResampler;
+}
+
+namespace kakarot {
+
+// A stretch of history: decoded float samples or an Ogg Opus file of it,
+// with where each contiguous run starts (a pause or gap begins a new one)
+struct HistoryRange {
+    struct Segment {
+        size_t offset = 0;       // first sample of the run, at sample_rate
+        uint64_t host_time = 0;  // of that sample
+    };
+
+    int sample_rate = 0;
+    size_t length = 0;           // samples spanned, either way
+    std::vector<float> samples;  // decoded
+    std::vector<uint8_t> ogg;    // encoded; plays back exactly the samples
+    std::vector<Segment> segments;
+};
+
+// A stream's last few minutes, held as 20ms Opus packets in one-second
+// blocks (about 3MB for ten minutes at 24kbit/s) instead of float PCM
+// (about 115MB at 48kHz). Any stretch decodes on its own: a read starts the
+// decoder a few packets early and drops the warm-up. The newest block is
+// filled in place and the oldest goes once the history is full, so steady
+// state reuses its blocks rather than allocating. Rates Opus lacks are
+// resampled to 48kHz on the way in.
+class AudioHistory {
+public:
+    // Null with |error| when the build has no Opus or |sample_rate| is not a
+    // multiple of 100Hz
+    static std::unique_ptr<AudioHistory> Create(const HostClock* clock, int sample_rate, double seconds, int bitrate,
+                                                std::string* error);
+    ~AudioHistory();
+
+    AudioHistory(const AudioHistory&) = delete;
+    AudioHistory& operator=(const AudioHistory&) = delete;
+
+    // Consumer thread. |host_time| is that of samples[0]; a jump from where
+    // the last call ended starts a new run, dropping the partial packet
+    void Append(const float* samples, size_t num_samples, uint64_t host_time);
+
+    // Any thread. What is held between the host times, either end clamped to
+    // the history; false with |error| when none of it is
+    bool Read(uint64_t from_host, uint64_t to_host, bool encoded, HistoryRange* range, std::string* error) const;
+
+    // Any thread
+    uint64_t Bytes() const;
+    double HeldMs() const;
+    uint64_t NewestHost() const;  // end of the newest packet; 0 when empty
+
+private:
+    struct Block {
+        uint64_t host_time = 0;      // of its first sample
+        bool continues = false;      // follows the block before without a gap
+        std::vector<uint8_t> data;
+        std::vector<uint32_t> ends;  // each packet's end in data
+    };
+    struct EncoderDeleter {
+        void operator()(OpusEncoder* encoder) const;
+    };
+
+    AudioHistory(const HostClock* clock, int input_rate, int rate, size_t max_blocks, size_t block_bytes,
+                 OpusEncoder* encoder);
+    void EncodePacket();
+
+    const HostClock* clock_;
+    const int input_rate_;
+    const int rate_;               // Opus's: input_rate_, or 48kHz when resampled
+    const size_t packet_samples_;  // at rate_
+    const size_t max_blocks_;
+    const size_t block_bytes_;     // reserved per block: a second at the bitrate, with headroom
+    std::unique_ptr<OpusEncoder, EncoderDeleter> encoder_;
+    int lookahead_ = 0;  // encoder delay at rate_: decoded sample n + lookahead_ is input sample n
+
+    // Consumer thread only
+    std::unique_ptr<webrtc::PushSincResampler> resampler_;
+    std::vector<float> resample_in_;  // one 10ms input block
+    std::vector<float> resample_out_;
+    size_t resample_fill_ = 0;
+    uint64_t resample_delay_ = 0;     // host ticks
+    std::vector<float> packet_;
+    size_t packet_fill_ = 0;
+    std::vector<uint8_t> payload_;
+    uint64_t expected_host_ = 0;      // where the next Append() starts without a gap
+    uint64_t run_host_ = 0;           // first sample of the current run, after resampling
+    uint64_t run_packets_ = 0;        // encoded since
+    bool new_run_ = true;
+
+    mutable std::mutex mutex_;
+    std::deque<Block> blocks_;
+    Block spare_;                     // the last block dropped, reused for the next
+    uint64_t bytes_ = 0;
+};
+
+} // namespace kakarot
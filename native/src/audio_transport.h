@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kakarot {
+
+// Congestion a transport reports, from 0 (keeping up) to this
+static constexpr int kMaxTransportPressure = 3;
+
+// Where a capture stream's transport option sends its audio: a
+// TranscriptionSocket or a LocalTranscriber
+class AudioTransport {
+public:
+    virtual ~AudioTransport() = default;
+
+    // Any thread. PCM16 at the transport's sample rate; |timestamp| is the
+    // Date.now() time of its first sample, 0 to continue the previous call
+    virtual void SendAudio(const int16_t* samples, size_t num_samples, double timestamp) = 0;
+
+    // Any thread. How far the way out is falling behind, 0 to
+    // kMaxTransportPressure; a gated stream gates silence harder as it rises
+    virtual int Pressure() const { return 0; }
+};
+
+} // namespace kakarot
@@ -0,0 +1,134 @@
+#include "beamformer.h"
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+// 2ms at 48kHz: 68cm of spacing, beyond any one-device array
+static constexpr size_t kMaxLag = 96;
+
+// Correlation memory; long enough to ride out pauses between words
+static constexpr double kSmoothingSeconds = 0.3;
+
+// A block steers only this far above the noise floor (6dB)
+static constexpr float kSpeechOverFloor = 4.0f;
+
+// The floor follows quieter blocks at once and louder ones this slowly
+static constexpr double kFloorRisePerSecond = 1.0;
+
+// A new peak must be this coherent, and beat the current lag by the margin
+static constexpr float kMinPeak = 0.2f;
+static constexpr float kSwitchMargin = 0.05f;
+
+DelayAndSumBeamformer::DelayAndSumBeamformer(double sample_rate, double max_delay_ms)
+    : sample_rate_(sample_rate),
+      max_lag_(std::min(kMaxLag, std::max<size_t>(1, static_cast<size_t>(std::lround(max_delay_ms * sample_rate / 1000.0))))),
+      lines_(kMaxChannels, std::vector<float>(2 * max_lag_ + kMaxBlock, 0.0f)),
+      correlation_(kMaxChannels, std::vector<float>(2 * max_lag_ + 1, 0.0f)),
+      lags_(kMaxChannels, 0),
+      previous_lags_(kMaxChannels, 0),
+      crossfade_(kMaxBlock, 0.0f) {
+    Reset();
+}
+
+float* DelayAndSumBeamformer::Input(int channel) {
+    return lines_[channel].data() + 2 * max_lag_;
+}
+
+int DelayAndSumBeamformer::Lag(int channel) const {
+    return channel >= 0 && channel < kMaxChannels ? reported_lags_[channel].load(std::memory_order_relaxed) : 0;
+}
+
+void DelayAndSumBeamformer::Reset() {
+    for (int c = 0; c < kMaxChannels; ++c) {
+        std::fill(lines_[c].begin(), lines_[c].begin() + 2 * max_lag_, 0.0f);
+        std::fill(correlation_[c].begin(), correlation_[c].end(), 0.0f);
+        lags_[c] = 0;
+        previous_lags_[c] = 0;
+        reported_lags_[c].store(0, std::memory_order_relaxed);
+    }
+    noise_floor_ = -1.0f;
+}
+
+// Cross-correlates each channel's block against the first's at every lag in
+// the window. Line index i is time T - n - 2L + i, so the first channel's
+// samples at [L, L + n) pair with channel c's at [L + k, L + k + n).
+void DelayAndSumBeamformer::Steer(int num_channels, size_t num_frames) {
+    const size_t lag = max_lag_;
+    const float* reference = lines_[0].data() + lag;
+    float reference_energy = dsp::DotProduct(reference, reference, num_frames);
+    float power = reference_energy / static_cast<float>(num_frames);
+
+    if (noise_floor_ < 0.0f || power < noise_floor_) {
+        noise_floor_ = power;
+    } else {
+        noise_floor_ *= static_cast<float>(1.0 + kFloorRisePerSecond * num_frames / sample_rate_);
+    }
+    if (power <= 1e-9f || power < noise_floor_ * kSpeechOverFloor) {
+        return;
+    }
+
+    const float keep = static_cast<float>(std::exp(-static_cast<double>(num_frames) / (sample_rate_ * kSmoothingSeconds)));
+    for (int c = 1; c < num_channels; ++c) {
+        const float* line = lines_[c].data();
+        float energy = dsp::DotProduct(line + lag, line + lag, num_frames);
+        float norm = 1.0f / std::sqrt(reference_energy * energy + 1e-12f);
+        std::vector<float>& correlation = correlation_[c];
+        size_t best = lag;
+        for (size_t k = 0; k <= 2 * lag; ++k) {
+            float r = dsp::DotProduct(reference, line + k, num_frames) * norm;
+            correlation[k] = keep * correlation[k] + (1.0f - keep) * r;
+            if (correlation[k] > correlation[best]) {
+                best = k;
+            }
+        }
+        size_t current = static_cast<size_t>(lags_[c] + static_cast<int>(lag));
+        if (best != current && correlation[best] >= kMinPeak &&
+            correlation[best] > correlation[current] + kSwitchMargin) {
+            lags_[c] = static_cast<int>(best) - static_cast<int>(lag);
+            reported_lags_[c].store(lags_[c], std::memory_order_relaxed);
+        }
+    }
+}
+
+void DelayAndSumBeamformer::Process(int num_channels, size_t num_frames, float* output) {
+    num_channels = std::max(1, std::min(num_channels, kMaxChannels));
+    num_frames = std::min(num_frames, kMaxBlock);
+    if (num_channels != num_channels_) {
+        Reset();
+        num_channels_ = num_channels;
+    }
+
+    const size_t lag = max_lag_;
+    if (num_channels > 1) {
+        Steer(num_channels, num_frames);
+    }
+
+    // y[j] = mean over c of x_c[L + j + lag_c]
+    const float gain = 1.0f / static_cast<float>(num_channels);
+    auto beam = [&](const std::vector<int>& lags, float* dst) {
+        std::fill(dst, dst + num_frames, 0.0f);
+        for (int c = 0; c < num_channels; ++c) {
+            dsp::MultiplyAdd(lines_[c].data() + lag + lags[c], gain, dst, num_frames);
+        }
+    };
+    beam(lags_, output);
+    if (!std::equal(lags_.begin(), lags_.begin() + num_channels, previous_lags_.begin())) {
+        beam(previous_lags_, crossfade_.data());
+        const float step = 1.0f / static_cast<float>(num_frames);
+        for (size_t j = 0; j < num_frames; ++j) {
+            float w = static_cast<float>(j + 1) * step;
+            output[j] = crossfade_[j] + (output[j] - crossfade_[j]) * w;
+        }
+        std::copy(lags_.begin(), lags_.end(), previous_lags_.begin());
+    }
+
+    for (int c = 0; c < num_channels; ++c) {
+        float* line = lines_[c].data();
+        std::memmove(line, line + num_frames, 2 * lag * sizeof(float));
+    }
+}
+
+} // namespace kakarot
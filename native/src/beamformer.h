@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace kakarot {
+
+// Delay-and-sum beam over the mics of one array, steered at the talker.
+// Each mic's lag behind the first is taken from the peak of their
+// normalized cross-correlation, smoothed over blocks loud enough to be
+// speech, so no array geometry is needed; the channels are then time-aligned
+// and averaged. Speech adds up coherently across mics and diffuse noise and
+// reverberation do not, so the one channel out has the better SNR. A change
+// of steering crossfades over one block. Output lags input by Latency().
+//
+// Real-time safe: all buffers are allocated up front. One thread drives
+// Input()/Process(); Lag() may be read from any thread.
+class DelayAndSumBeamformer {
+public:
+    static constexpr int kMaxChannels = 8;
+    static constexpr size_t kMaxBlock = 1024;
+
+    // |max_delay_ms| is the largest arrival difference between two mics,
+    // about their spacing over the speed of sound (1ms is 34cm)
+    DelayAndSumBeamformer(double sample_rate, double max_delay_ms);
+
+    // Where the next block's samples of |channel| (0 to kMaxChannels - 1) go
+    float* Input(int channel);
+
+    // Steers on, and writes the beam of, the |num_frames| (at most
+    // kMaxBlock) just written through Input() for |num_channels| channels.
+    // A different channel count than last time starts over.
+    void Process(int num_channels, size_t num_frames, float* output);
+
+    void Reset();
+
+    // Samples; the beam is centred on the middle of the lag window
+    size_t Latency() const { return max_lag_; }
+
+    // Samples |channel| currently lags the first channel by
+    int Lag(int channel) const;
+
+private:
+    void Steer(int num_channels, size_t num_frames);
+
+    double sample_rate_;
+    size_t max_lag_;
+    int num_channels_ = 0;
+
+    // Per channel: 2 * max_lag_ samples of history, then the new block
+    std::vector<std::vector<float>> lines_;
+    // Per channel: smoothed correlation with the first at each lag
+    std::vector<std::vector<float>> correlation_;
+    std::vector<int> lags_;
+    std::vector<int> previous_lags_;
+    std::vector<float> crossfade_;  // the previous steering's beam, one block
+    float noise_floor_ = 0.0f;
+    std::array<std::atomic<int>, kMaxChannels> reported_lags_{};
+};
+
+} // namespace kakarot
@@ -0,0 +1,358 @@
+#include "bundle_exporter.h"
+#include "native_log.h"
+#include "recording_frames.h"
+#include "zip_writer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <set>
+
+namespace kakarot {
+
+static const char* const kLogSource = "BundleExporter";
+
+// Share of the progress for encoding; copying into the archive is the rest
+static constexpr double kEncodeShare = 0.9;
+
+// Progress is reported in steps of at least this much
+static constexpr double kProgressStep = 0.01;
+
+// 10ms frames between counting progress and polling cancel
+static constexpr uint64_t kTickFrames = 100;
+
+// How often the calling thread reports while the others finish
+static constexpr auto kWaitTick = std::chrono::milliseconds(100);
+
+namespace {
+
+// One FLAC of the bundle: a track, or several mixed
+struct Encode {
+    std::string name;
+    std::string spool;
+    std::vector<std::string> indexes;
+    std::vector<uint64_t> leads;  // 10ms frames of silence before each track
+    uint64_t frames = 0;          // samples of the whole output
+};
+
+// The encodes of one export, shared with the tasks helping with them
+struct EncodeState {
+    std::vector<Encode> encodes;
+    int sample_rate = 0;
+    std::shared_ptr<std::atomic<bool>> cancel;
+    std::atomic<size_t> next{0};
+    std::atomic<uint64_t> encoded{0};  // samples, across the encodes
+
+    std::mutex mutex;
+    std::condition_variable finished_cv;
+    size_t finished = 0;  // mutex
+    std::string error;    // mutex; the first failure
+};
+
+bool RunEncode(const Encode& encode, EncodeState* state, const std::function<void()>& tick, std::string* error) {
+    const int rate = state->sample_rate;
+    const size_t frame = static_cast<size_t>(rate / 100);
+    const std::atomic<bool>& cancel = *state->cancel;
+    std::vector<std::unique_ptr<TrackFrames>> tracks;
+    for (const std::string& index : encode.indexes) {
+        tracks.push_back(std::make_unique<TrackFrames>(rate));
+        if (!tracks.back()->Open(index, error)) {
+            return false;
+        }
+    }
+    FILE* out = std::fopen(encode.spool.c_str(), "wb");
+    if (!out) {
+        *error = "cannot create " + encode.spool;
+        return false;
+    }
+    bool ok = true;
+    {
+        FlacFileWriter writer(out, rate, encode.frames);
+        std::vector<float> mix(frame);
+        std::vector<float> samples(frame);
+        uint64_t written = 0;
+        uint64_t counted = 0;
+        for (uint64_t position = 0; ok && written < encode.frames; ++position) {
+            std::fill(mix.begin(), mix.end(), 0.0f);
+            for (size_t t = 0; ok && t < tracks.size(); ++t) {
+                if (position < encode.leads[t]) {
+                    continue;
+                }
+                ok = tracks[t]->Next(samples.data(), cancel, error);
+                for (size_t i = 0; i < frame; ++i) {
+                    mix[i] += samples[i];
+                }
+            }
+            if (!ok) {
+                break;
+            }
+            const size_t count = static_cast<size_t>(std::min<uint64_t>(frame, encode.frames - written));
+            writer.Write(mix.data(), count);
+            written += count;
+
+            if (position % kTickFrames == 0 || written == encode.frames) {
+                state->encoded.fetch_add(written - counted, std::memory_order_relaxed);
+                counted = written;
+                if (cancel.load(std::memory_order_relaxed)) {
+                    *error = "cancelled";
+                    ok = false;
+                }
+                if (tick) {
+                    tick();
+                }
+            }
+        }
+        if (ok && !writer.Finish()) {
+            *error = "cannot write " + encode.spool;
+            ok = false;
+        }
+    }
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok && error->empty()) {
+        *error = "cannot write " + encode.spool;
+    }
+    return ok;
+}
+
+// Encodes until none are left to claim; any thread, any number at once
+void RunEncodes(EncodeState* state, const std::function<void()>& tick) {
+    for (;;) {
+        const size_t i = state->next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= state->encodes.size()) {
+            return;
+        }
+        std::string error;
+        const bool ok = RunEncode(state->encodes[i], state, tick, &error);
+        if (!ok) {
+            // The rest would only be thrown away
+            state->cancel->store(true, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!ok && state->error.empty()) {
+                state->error = error;
+            }
+            ++state->finished;
+        }
+        state->finished_cv.notify_all();
+    }
+}
+
+// Everything but the rename; the spools are the caller's to remove
+bool Run(TaskScheduler* scheduler, const BundleJob& job, const std::string& part, const BundleProgressFn& report,
+         const std::shared_ptr<std::atomic<bool>>& cancel, std::vector<std::string>* spools,
+         BundleResult* result) {
+    const int rate = job.sample_rate;
+    if (rate < 8000 || rate > 48000 || rate % 100 != 0) {
+        result->error = "the sample rate must be a multiple of 100Hz from 8 to 48kHz";
+        return false;
+    }
+    // Names are checked before hours of audio are encoded for them
+    std::set<std::string> names;
+    auto claim = [&](const std::string& name) {
+        if (!ZipWriter::IsEntryName(name) || !names.insert(name).second) {
+            result->error = "bad or repeated entry name '" + name + "'";
+            return false;
+        }
+        return true;
+    };
+    for (const BundleEntry& entry : job.entries) {
+        if (!claim(entry.name)) {
+            return false;
+        }
+    }
+
+    // Each track's length and start, for the totals and the mix's offsets
+    const size_t frame = static_cast<size_t>(rate / 100);
+    std::vector<uint64_t> durations;  // 10ms frames
+    std::vector<uint64_t> starts;
+    for (const BundleTrack& track : job.tracks) {
+        if (!claim(track.name)) {
+            return false;
+        }
+        TrackFrames probe(rate);
+        if (!probe.Open(track.index, &result->error)) {
+            return false;
+        }
+        const double duration_ms = probe.DurationMs();
+        result->audio_ms = std::max(result->audio_ms, duration_ms);
+        durations.push_back(static_cast<uint64_t>(std::ceil(duration_ms / 10.0)));
+        starts.push_back(probe.StartedAtMs());
+    }
+
+    auto state = std::make_shared<EncodeState>();
+    state->sample_rate = rate;
+    state->cancel = cancel;
+    for (size_t t = 0; t < job.tracks.size(); ++t) {
+        Encode encode;
+        encode.name = job.tracks[t].name;
+        encode.indexes = {job.tracks[t].index};
+        encode.leads = {0};
+        encode.frames = durations[t] * frame;
+        state->encodes.push_back(std::move(encode));
+    }
+    if (!job.mix.empty() && !job.tracks.empty()) {
+        if (!claim(job.mix)) {
+            return false;
+        }
+        // On one timeline: each track from its own start
+        const uint64_t first = *std::min_element(starts.begin(), starts.end());
+        Encode encode;
+        encode.name = job.mix;
+        uint64_t frames = 0;
+        for (size_t t = 0; t < job.tracks.size(); ++t) {
+            encode.indexes.push_back(job.tracks[t].index);
+            encode.leads.push_back((starts[t] - first) / 10);
+            frames = std::max(frames, encode.leads.back() + durations[t]);
+        }
+        encode.frames = frames * frame;
+        state->encodes.push_back(std::move(encode));
+    }
+    uint64_t total_samples = 0;
+    for (size_t i = 0; i < state->encodes.size(); ++i) {
+        state->encodes[i].spool = part + "." + std::to_string(i);
+        spools->push_back(state->encodes[i].spool);
+        total_samples += state->encodes[i].frames;
+    }
+
+    double reported = 0.0;
+    auto progress = [&](double fraction) {
+        if (report && fraction - reported >= kProgressStep) {
+            reported = fraction;
+            report(fraction);
+        }
+    };
+    auto encode_tick = [&]() {
+        if (total_samples > 0) {
+            progress(kEncodeShare * state->encoded.load(std::memory_order_relaxed) / total_samples);
+        }
+    };
+
+    // Helpers for all but one; this thread takes the first and whatever no
+    // worker got to, so the export never waits on a queue. None once
+    // cancelled: at teardown the scheduler takes no more.
+    for (size_t i = 1; i < state->encodes.size() && !cancel->load(std::memory_order_relaxed); ++i) {
+        scheduler->Post(TaskPriority::kInteractive, [state](const std::atomic<bool>& stopping) {
+            if (stopping.load(std::memory_order_relaxed)) {
+                state->cancel->store(true, std::memory_order_relaxed);
+            }
+            RunEncodes(state.get(), nullptr);
+        });
+    }
+    RunEncodes(state.get(), encode_tick);
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        while (state->finished < state->encodes.size()) {
+            state->finished_cv.wait_for(lock, kWaitTick);
+            lock.unlock();
+            encode_tick();
+            lock.lock();
+        }
+        if (!state->error.empty()) {
+            result->error = state->error;
+            return false;
+        }
+    }
+
+    ZipWriter zip;
+    if (!zip.Open(part, &result->error)) {
+        return false;
+    }
+    for (const BundleEntry& entry : job.entries) {
+        if (!zip.Add(entry.name, reinterpret_cast<const uint8_t*>(entry.data.data()), entry.data.size(),
+                     &result->error)) {
+            return false;
+        }
+    }
+    // Spool sizes, for the copy's share of the progress
+    uint64_t spool_bytes = 0;
+    for (const Encode& encode : state->encodes) {
+        if (FILE* file = std::fopen(encode.spool.c_str(), "rb")) {
+            if (std::fseek(file, 0, SEEK_END) == 0) {
+                spool_bytes += static_cast<uint64_t>(std::max(0L, std::ftell(file)));
+            }
+            std::fclose(file);
+        }
+    }
+    uint64_t copied_before = 0;
+    for (const Encode& encode : state->encodes) {
+        uint64_t copied_now = 0;
+        const bool copied = zip.AddFile(encode.name, encode.spool, *cancel, [&](uint64_t bytes) {
+            copied_now = bytes;
+            if (spool_bytes > 0) {
+                progress(kEncodeShare + (1.0 - kEncodeShare) *
+                                            std::min(1.0, static_cast<double>(copied_before + bytes) / spool_bytes));
+            }
+        }, &result->error);
+        if (!copied) {
+            return false;
+        }
+        copied_before += copied_now;
+        std::remove(encode.spool.c_str());
+    }
+    if (!zip.Finish(&result->error)) {
+        return false;
+    }
+    result->output_bytes = zip.Bytes();
+    result->entries = zip.EntryCount();
+    return true;
+}
+
+} // namespace
+
+BundleResult ExportBundle(TaskScheduler* scheduler, const BundleJob& job, const BundleProgressFn& progress,
+                          const std::shared_ptr<std::atomic<bool>>& cancel) {
+    BundleResult result;
+    const auto start = std::chrono::steady_clock::now();
+    if (job.output.empty()) {
+        result.error = "no output";
+        return result;
+    }
+    const std::string part = job.output + ".part";
+    std::vector<std::string> spools;
+    bool ok = Run(scheduler, job, part, progress, cancel, &spools, &result);
+    for (const std::string& spool : spools) {
+        std::remove(spool.c_str());
+    }
+    if (ok) {
+        std::remove(job.output.c_str());  // rename() will not replace on Windows
+        ok = std::rename(part.c_str(), job.output.c_str()) == 0;
+        if (!ok) {
+            result.error = "cannot rename " + part;
+        }
+    }
+    if (!ok) {
+        std::remove(part.c_str());
+        return result;
+    }
+    if (progress) {
+        progress(1.0);
+    }
+    result.ok = true;
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void SubmitBundleExport(TaskScheduler* scheduler, BundleJob job, std::shared_ptr<std::atomic<bool>> cancel,
+                        BundleProgressFn progress, BundleDoneFn done) {
+    scheduler->Post(TaskPriority::kInteractive, [scheduler, job = std::move(job), cancel = std::move(cancel),
+                                                 progress = std::move(progress),
+                                                 done = std::move(done)](const std::atomic<bool>& stopping) {
+        if (stopping.load(std::memory_order_relaxed)) {
+            cancel->store(true, std::memory_order_relaxed);
+        }
+        BundleResult result = ExportBundle(scheduler, job, progress, cancel);
+        if (result.ok) {
+            Log(LogLevel::kInfo, kLogSource, "%s: %zu entries, %.0fs of audio, %llu bytes in %.0fms",
+                job.output.c_str(), result.entries, result.audio_ms / 1000.0,
+                static_cast<unsigned long long>(result.output_bytes), result.elapsed_ms);
+        } else {
+            Log(LogLevel::kWarn, kLogSource, "%s: %s", job.output.c_str(), result.error.c_str());
+        }
+        done(result);
+    });
+}
+
+} // namespace kakarot
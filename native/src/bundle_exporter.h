@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "task_scheduler.h"
+
+namespace kakarot {
+
+// Bytes to store as they are: the transcript, notes, callouts
+struct BundleEntry {
+    std::string name;  // path in the archive
+    std::string data;
+};
+
+// One track of the recording, stored as 16-bit mono FLAC
+struct BundleTrack {
+    std::string name;   // path in the archive
+    std::string index;  // <name>.<track>.idx as the recorder wrote it
+};
+
+struct BundleJob {
+    std::string output;                // the .zip
+    std::vector<BundleEntry> entries;  // first, in order
+    std::vector<BundleTrack> tracks;   // then each track, in order
+    std::string mix;                   // path of every track mixed into one FLAC, last; empty for none
+    int sample_rate = 48000;           // every track is resampled to this, and so is the mix
+};
+
+struct BundleResult {
+    bool ok = false;
+    std::string error;
+    uint64_t output_bytes = 0;
+    size_t entries = 0;
+    double audio_ms = 0.0;    // of the longest track
+    double elapsed_ms = 0.0;
+};
+
+// Both run on a worker thread doing the job
+using BundleProgressFn = std::function<void(double fraction)>;
+using BundleDoneFn = std::function<void(const BundleResult& result)>;
+
+// Writes |job| as a ZIP on the calling thread. The tracks and the mix are
+// encoded at once, the calling thread taking one and tasks on |scheduler|
+// the others, each read through its seek index block by block and written
+// to a spool file beside the output; the archive then takes the entries
+// and copies the spools in. Memory stays a few blocks a track whatever the
+// meeting's length. Output goes to <output>.part and is renamed once
+// complete; spools are removed either way. |cancel| fails the job, and a
+// failing track sets it to stop the rest.
+BundleResult ExportBundle(TaskScheduler* scheduler, const BundleJob& job, const BundleProgressFn& progress,
+                          const std::shared_ptr<std::atomic<bool>>& cancel);
+
+// Exports |job| as an interactive task on |scheduler|. |done| is always
+// called, exactly once; the scheduler's teardown sets |cancel| for a job
+// still queued.
+void SubmitBundleExport(TaskScheduler* scheduler, BundleJob job, std::shared_ptr<std::atomic<bool>> cancel,
+                        BundleProgressFn progress, BundleDoneFn done);
+
+} // namespace kakarot
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace kakarot {
+
+// Receives mono float frames on the capture real-time thread
+using RealtimeSink = void (*)(void* context, const float* data, uint32_t num_samples,
+                              uint64_t host_time);
+
+// What a stream-based backend (WASAPI, PipeWire) captures
+enum class CaptureSource {
+    kMicrophone,  // an input device
+    kLoopback,    // what the default output is playing
+};
+
+struct InputDeviceInfo {
+    std::string id;    // backend endpoint id, UTF-8
+    std::string name;  // human-readable name
+    bool is_default = false;
+};
+
+} // namespace kakarot
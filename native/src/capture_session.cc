@@ -0,0 +1,135 @@
+#include "capture_session.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kakarot {
+
+// 2 seconds of 48kHz mono between the device thread and the pool, as for
+// the addon's own streams
+static constexpr size_t kSessionRingSamples = 96000;
+static constexpr size_t kSessionRingChunks = 256;
+
+// Larger device buffers are dropped; no backend delivers more than a second
+static constexpr size_t kMaxBufferSamples = 48000;
+
+CaptureSession::CaptureSession(std::string name, DspPool* pool)
+    : name_(std::move(name)),
+      pool_(pool),
+      ring_(kSessionRingSamples),
+      chunks_(kSessionRingChunks) {}
+
+CaptureSession::~CaptureSession() {
+    Stop();
+}
+
+bool CaptureSession::Start(std::unique_ptr<SessionInput> input, const std::string& device_id,
+                           std::vector<std::unique_ptr<ProcessingStage>> stages, const std::vector<bool>& enabled,
+                           double chunk_ms, double deadline_ms, SessionOutputFn output, std::string* error) {
+    if (running_.load(std::memory_order_acquire)) {
+        *error = "session '" + name_ + "' is already running";
+        return false;
+    }
+    input_ = std::move(input);
+    device_id_ = device_id;
+    deliver_ = std::move(output);
+    input_buffer_.resize(kMaxBufferSamples);
+    pending_.clear();
+    SetDeadlineNs(static_cast<uint64_t>(std::max(1.0, deadline_ms) * 1e6));
+
+    // The device first, for its rate; what it captures meanwhile waits in
+    // the ring until the job joins the pool
+    if (!input_->Start(device_id_, &CaptureSession::Sink, this, error)) {
+        input_.reset();
+        return false;
+    }
+    if (!graph_.Build(static_cast<int>(std::lround(input_->SampleRate())), std::move(stages), enabled, error)) {
+        input_->Stop();
+        input_.reset();
+        return false;
+    }
+    const size_t frame = static_cast<size_t>(graph_.OutputSampleRate() / 100);
+    chunk_samples_ = std::max<size_t>(1, static_cast<size_t>(std::lround(chunk_ms / 10.0))) * frame;
+    pending_.reserve(chunk_samples_);
+    output_.samples.reserve(kMaxBufferSamples);
+
+    if (!pool_->Add(this)) {
+        input_->Stop();
+        input_.reset();
+        *error = "too many capture sessions";
+        return false;
+    }
+    running_.store(true, std::memory_order_release);
+    Wake();
+    return true;
+}
+
+void CaptureSession::Stop() {
+    if (input_) {
+        input_->Stop();
+    }
+    pool_->Remove(this);
+    running_.store(false, std::memory_order_release);
+    input_.reset();
+    // Left for the next Start(), whose rate may differ
+    ring_.Reset();
+    chunks_.Reset();
+}
+
+void CaptureSession::Sink(void* context, const float* data, uint32_t num_samples, uint64_t host_time) {
+    CaptureSession* self = static_cast<CaptureSession*>(context);
+    if (num_samples == 0) {
+        return;
+    }
+    if (num_samples > kMaxBufferSamples || self->ring_.AvailableToWrite() < num_samples ||
+        self->chunks_.AvailableToWrite() < 1) {
+        self->dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    self->ring_.Write(data, num_samples);
+    Chunk chunk{num_samples, host_time};
+    self->chunks_.Write(&chunk, 1);
+    self->buffers_.fetch_add(1, std::memory_order_relaxed);
+    self->Wake();
+}
+
+void CaptureSession::Run() {
+    Chunk chunk;
+    while (chunks_.Read(&chunk, 1) == 1) {
+        size_t num_samples = ring_.Read(input_buffer_.data(), chunk.num_samples);
+        graph_.Process(input_buffer_.data(), num_samples, &output_);
+        samples_in_.fetch_add(num_samples, std::memory_order_relaxed);
+
+        // Cut into whole deliveries; each is stamped with the buffer that
+        // completed its first frame
+        const float* samples = output_.samples.data();
+        size_t remaining = output_.samples.size();
+        samples_out_.fetch_add(remaining, std::memory_order_relaxed);
+        while (remaining > 0) {
+            if (pending_.empty()) {
+                pending_host_time_ = chunk.host_time;
+            }
+            size_t taken = std::min(chunk_samples_ - pending_.size(), remaining);
+            pending_.insert(pending_.end(), samples, samples + taken);
+            samples += taken;
+            remaining -= taken;
+            if (pending_.size() == chunk_samples_) {
+                deliver_(pending_.data(), pending_.size(), pending_host_time_);
+                deliveries_.fetch_add(1, std::memory_order_relaxed);
+                pending_.clear();
+            }
+        }
+    }
+}
+
+CaptureSessionStats CaptureSession::Stats() const {
+    CaptureSessionStats stats;
+    stats.buffers = buffers_.load(std::memory_order_relaxed);
+    stats.buffers_dropped = dropped_.load(std::memory_order_relaxed);
+    stats.samples_in = samples_in_.load(std::memory_order_relaxed);
+    stats.samples_out = samples_out_.load(std::memory_order_relaxed);
+    stats.deliveries = deliveries_.load(std::memory_order_relaxed);
+    stats.dsp = DspJob::Stats();
+    return stats;
+}
+
+} // namespace kakarot
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "capture_backend.h"
+#include "dsp_pool.h"
+#include "processing_graph.h"
+#include "spsc_ring_buffer.h"
+
+namespace kakarot {
+
+// A session's device: a platform input of its own (a HAL IOProc, a WASAPI
+// or PipeWire stream) calling the sink on its real-time thread with mono
+// float frames
+class SessionInput {
+public:
+    virtual ~SessionInput() = default;
+
+    // Opens |device_id| (empty: the default input) and starts the sink;
+    // SampleRate() is the device's from then on
+    virtual bool Start(const std::string& device_id, RealtimeSink sink, void* context, std::string* error) = 0;
+    // No sink calls after this returns
+    virtual void Stop() = 0;
+    virtual double SampleRate() const = 0;
+};
+
+// Pool thread: |num_samples| of output at the graph's rate, the first
+// captured at |host_time|
+using SessionOutputFn = std::function<void(const float* data, size_t num_samples, uint64_t host_time)>;
+
+struct CaptureSessionStats {
+    uint64_t buffers = 0;          // device callbacks queued
+    uint64_t buffers_dropped = 0;  // the ring was full: the pool is behind
+    uint64_t samples_in = 0;
+    uint64_t samples_out = 0;
+    uint64_t deliveries = 0;
+    DspJobStats dsp;
+};
+
+// One named capture inside an addon instance: its own device, graph and
+// state, with the graph run by the shared DspPool rather than a thread of
+// its own. The device thread pushes into the session's rings and wakes its
+// job; the job runs everything queued through the graph and hands the
+// output on in |chunk_ms| deliveries. Start() and Stop() on the JS thread.
+class CaptureSession : public DspJob {
+public:
+    CaptureSession(std::string name, DspPool* pool);
+    ~CaptureSession() override;
+
+    CaptureSession(const CaptureSession&) = delete;
+    CaptureSession& operator=(const CaptureSession&) = delete;
+
+    // Starts |input| on |device_id|, builds |stages| at its rate and joins
+    // the pool, with runs due |deadline_ms| after each device buffer.
+    // |output| runs on pool threads until Stop().
+    bool Start(std::unique_ptr<SessionInput> input, const std::string& device_id,
+               std::vector<std::unique_ptr<ProcessingStage>> stages, const std::vector<bool>& enabled,
+               double chunk_ms, double deadline_ms, SessionOutputFn output, std::string* error);
+
+    // Device first, then the pool; the partial last delivery is dropped
+    void Stop();
+
+    const std::string& Name() const { return name_; }
+    const std::string& DeviceId() const { return device_id_; }
+    double InputSampleRate() const { return input_ ? input_->SampleRate() : 0.0; }
+    int OutputSampleRate() const { return graph_.OutputSampleRate(); }
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    CaptureSessionStats Stats() const;
+
+    void Run() override;
+
+private:
+    struct Chunk {
+        uint32_t num_samples;
+        uint64_t host_time;
+    };
+
+    static void Sink(void* context, const float* data, uint32_t num_samples, uint64_t host_time);
+
+    const std::string name_;
+    DspPool* const pool_;
+    std::string device_id_;
+    std::unique_ptr<SessionInput> input_;
+    std::atomic<bool> running_{false};
+
+    // Device thread -> pool
+    SpscRingBuffer<float> ring_;
+    SpscRingBuffer<Chunk> chunks_;
+    std::atomic<uint64_t> buffers_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    // Pool thread, one at a time
+    ProcessingGraph graph_;
+    GraphOutput output_;
+    std::vector<float> input_buffer_;
+    std::vector<float> pending_;  // output not yet a whole delivery
+    uint64_t pending_host_time_ = 0;
+    size_t chunk_samples_ = 0;
+    SessionOutputFn deliver_;
+    std::atomic<uint64_t> samples_in_{0};
+    std::atomic<uint64_t> samples_out_{0};
+    std::atomic<uint64_t> deliveries_{0};
+};
+
+} // namespace kakarot
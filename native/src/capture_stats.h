@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace kakarot {
+
+// Wake-up delay of a worker thread: from a buffer's ring write to the first
+// read after the thread woke for it. One writer.
+struct WakeStats {
+    std::atomic<uint64_t> wakes{0};
+    std::atomic<uint64_t> max_ticks{0};
+    std::atomic<uint64_t> sum_ticks{0};
+
+    void Record(uint64_t ticks) {
+        wakes.fetch_add(1, std::memory_order_relaxed);
+        sum_ticks.fetch_add(ticks, std::memory_order_relaxed);
+        if (ticks > max_ticks.load(std::memory_order_relaxed)) {
+            max_ticks.store(ticks, std::memory_order_relaxed);
+        }
+    }
+
+    void Reset() {
+        wakes = 0;
+        max_ticks = 0;
+        sum_ticks = 0;
+    }
+};
+
+// Capture-path health counters. Written from the real-time thread (and the
+// consumer/DSP threads) with relaxed atomics, read from JS via getCaptureStats().
+// Plain C++ so the Objective-C++ tap can share it.
+struct CaptureStats {
+    std::atomic<uint64_t> callbacks{0};          // IOProc invocations
+    std::atomic<uint64_t> buffers_captured{0};   // buffers accepted into the ring
+    std::atomic<uint64_t> buffers_dropped{0};    // ring full
+    std::atomic<uint64_t> buffers_oversized{0};  // above the per-callback sample limit
+    std::atomic<uint64_t> deliveries{0};         // JS callbacks queued
+    std::atomic<uint64_t> tsfn_rejections{0};    // NonBlockingCall refused (queue full/closing)
+    std::atomic<uint64_t> deliveries_dropped{0};    // overload: oldest queued delivery discarded
+    std::atomic<uint64_t> deliveries_coalesced{0};  // overload: appended to the newest queued one
+    std::atomic<uint64_t> consumer_blocks{0};       // overload: consumer held until JS drained
+    std::atomic<uint32_t> queue_peak{0};            // most deliveries queued for JS at once
+    std::atomic<uint64_t> subscriber_deliveries{0};  // queued for subscribeCapture() callbacks
+    std::atomic<uint64_t> subscriber_dropped{0};     // their overload: oldest discarded
+    std::atomic<uint64_t> subscriber_coalesced{0};   // their overload: appended to the newest
+    std::atomic<uint64_t> overloads{0};          // kAudioDeviceProcessorOverload notifications
+    std::atomic<uint64_t> frames_gated{0};       // 10ms frames withheld by the silence gate
+    std::atomic<uint64_t> keystrokes_ducked{0};  // clicks the declick option attenuated
+    std::atomic<uint64_t> denoise_frames{0};     // 10ms frames through the neural denoiser
+    std::atomic<uint64_t> denoise_ticks{0};      // host-time ticks spent in it
+    std::atomic<uint64_t> render_gaps{0};              // processed mode: render holes (dropped chunks) filled
+    std::atomic<uint64_t> render_frames_concealed{0};  // silent frames they were filled with
+    std::atomic<uint64_t> render_frames_dropped{0};    // processed mode: render the stalled render thread lost
+    std::atomic<uint32_t> io_buffer_frames{0};   // device IO buffer in effect; 0 = not reported
+    std::atomic<uint32_t> device_channels{0};    // channels per frame the device delivers; 0 = not reported
+
+    // Host-time ticks between successive callbacks, and spent inside them
+    std::atomic<uint64_t> interval_max_ticks{0};
+    std::atomic<uint64_t> interval_sum_ticks{0};
+    std::atomic<uint64_t> duration_max_ticks{0};
+    std::atomic<uint64_t> duration_sum_ticks{0};
+
+    // Time to first sample: from the start request to the first callback
+    std::atomic<uint64_t> start_host{0};            // set by the start path; 0 = not measured
+    std::atomic<uint64_t> first_callback_ticks{0};
+
+    // Scheduling latency of the threads draining the ring
+    WakeStats consumer_wake;   // the stream's consumer thread
+    WakeStats dsp_wake;        // the AEC pipeline's DSP thread, processed mode only
+
+    // CPU time those threads have used since they started; each the one writer
+    std::atomic<uint64_t> consumer_cpu_ns{0};
+    std::atomic<uint64_t> dsp_cpu_ns{0};
+    std::atomic<uint64_t> render_cpu_ns{0};  // the AEC pipeline's render thread
+
+    // The stream's session arena: reserved at open, and what did not fit in
+    // it. The process's resident set before the open and after the close.
+    std::atomic<uint64_t> arena_bytes{0};
+    std::atomic<uint64_t> arena_overflow_bytes{0};
+    std::atomic<uint64_t> rss_open_bytes{0};
+    std::atomic<uint64_t> rss_close_bytes{0};
+
+    // Real-time thread only, or with the producer stopped
+    uint64_t last_callback_start = 0;
+
+    // Real-time thread: one writer, so max updates need no CAS loop
+    void RecordCallback(uint64_t start, uint64_t end) {
+        callbacks.fetch_add(1, std::memory_order_relaxed);
+
+        if (last_callback_start == 0 && first_callback_ticks.load(std::memory_order_relaxed) == 0) {
+            uint64_t requested = start_host.load(std::memory_order_relaxed);
+            if (requested != 0 && start > requested) {
+                first_callback_ticks.store(start - requested, std::memory_order_relaxed);
+            }
+        }
+        if (last_callback_start != 0 && start > last_callback_start) {
+            uint64_t interval = start - last_callback_start;
+            interval_sum_ticks.fetch_add(interval, std::memory_order_relaxed);
+            if (interval > interval_max_ticks.load(std::memory_order_relaxed)) {
+                interval_max_ticks.store(interval, std::memory_order_relaxed);
+            }
+        }
+        last_callback_start = start;
+
+        uint64_t duration = end > start ? end - start : 0;
+        duration_sum_ticks.fetch_add(duration, std::memory_order_relaxed);
+        if (duration > duration_max_ticks.load(std::memory_order_relaxed)) {
+            duration_max_ticks.store(duration, std::memory_order_relaxed);
+        }
+    }
+
+    // Call only while no producer is running
+    void Reset() {
+        callbacks = 0;
+        buffers_captured = 0;
+        buffers_dropped = 0;
+        buffers_oversized = 0;
+        deliveries = 0;
+        tsfn_rejections = 0;
+        deliveries_dropped = 0;
+        deliveries_coalesced = 0;
+        consumer_blocks = 0;
+        queue_peak = 0;
+        subscriber_deliveries = 0;
+        subscriber_dropped = 0;
+        subscriber_coalesced = 0;
+        overloads = 0;
+        frames_gated = 0;
+        keystrokes_ducked = 0;
+        denoise_frames = 0;
+        denoise_ticks = 0;
+        render_gaps = 0;
+        render_frames_concealed = 0;
+        render_frames_dropped = 0;
+        io_buffer_frames = 0;
+        device_channels = 0;
+        interval_max_ticks = 0;
+        interval_sum_ticks = 0;
+        duration_max_ticks = 0;
+        duration_sum_ticks = 0;
+        start_host = 0;
+        first_callback_ticks = 0;
+        last_callback_start = 0;
+        consumer_wake.Reset();
+        dsp_wake.Reset();
+        consumer_cpu_ns = 0;
+        dsp_cpu_ns = 0;
+        render_cpu_ns = 0;
+        arena_bytes = 0;
+        arena_overflow_bytes = 0;
+        rss_open_bytes = 0;
+        rss_close_bytes = 0;
+    }
+};
+
+} // namespace kakarot
@@ -0,0 +1,2046 @@
+#include "capture_stream.h"
+#include "audio_classifier.h"
+#include "aec_processor.h"
+#include "channel_interleaver.h"
+#include "chunk_assembler.h"
+#include "keystroke_suppressor.h"
+#include "level_analyzer.h"
+#include "local_transcriber.h"
+#include "native_log.h"
+#include "neural_denoiser.h"
+#include "pipeline_trace.h"
+#include "prosody_tracker.h"
+#include "shared_ring.h"
+#include "speaker_tracker.h"
+#include "talk_analytics.h"
+#include "thread_cpu.h"
+#include "transcription_socket.h"
+#include "wakeup_stats.h"
+#include "common_audio/include/audio_util.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "rtc_base/denormal_disabler.h"
+#include "voice_activity.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace kakarot {
+
+static const char* const kLogSource = "CaptureStream";
+
+static WakeupCounter g_consumer_wakeups("captureConsumer");
+
+// Zero-copy slabs: 8192 samples covers any sane HAL buffer at 48kHz
+static constexpr size_t kSlabSamples = 8192;
+static constexpr size_t kInitialSlabs = 32;
+
+// Upper bound for deliveryIntervalMs; must stay well below the ring duration
+static constexpr double kMaxDeliveryIntervalMs = 500.0;
+
+// chunkMs bounds; chunks are whole 10ms frames so VAD values stay aligned
+static constexpr double kMinChunkMs = 10.0;
+static constexpr double kMaxChunkMs = 5000.0;
+
+// Silence gate option bounds
+static constexpr double kMaxGateHangoverMs = 5000.0;
+static constexpr double kMaxGatePrerollMs = 1000.0;
+
+// The gate at the transport's full pressure: threshold raised to this and
+// hangover cut to this fraction of the option's
+static constexpr float kCongestedGateThreshold = 0.85f;
+static constexpr double kCongestedHangoverFraction = 0.25;
+
+// Endpoint option bounds
+static constexpr double kMaxEndpointMinSpeechMs = 1000.0;
+static constexpr double kMaxEndpointSilenceMs = 5000.0;
+
+// outputSampleRate bounds; the resampler works in 10ms blocks, so rates must
+// be whole multiples of 100Hz
+static constexpr double kMinOutputSampleRate = 8000.0;
+static constexpr double kMaxOutputSampleRate = 48000.0;
+
+// ioBufferFrames bound before the device clamps it to its own range
+static constexpr double kMaxIoBufferFrames = 8192.0;
+
+// inputChannels: the most entries, and channel indexes below this
+static constexpr uint32_t kMaxInputChannels = 64;
+
+// maxQueuedDeliveries upper bound
+static constexpr double kMaxQueuedDeliveries = 1024.0;
+
+// Talk states held for lookup: 10s of steps, past any pre-roll and batch
+static constexpr size_t kTalkFrames = 1024;
+
+// history option: ten minutes by default, an hour at most (about 11MB at
+// the default bitrate), and bitrates Opus keeps speech intelligible across
+static constexpr double kDefaultHistorySeconds = 600.0;
+static constexpr double kMaxHistorySeconds = 3600.0;
+static constexpr double kMinHistoryBitrate = 8000.0;
+static constexpr double kMaxHistoryBitrate = 128000.0;
+
+// A frame peaking this near full scale counts as clipped in its metadata
+static constexpr float kClippedPeak = 0.999f;
+
+// How often a blocked consumer re-checks for Close()
+static constexpr int64_t kBlockPollNs = 10 * 1000 * 1000;
+
+// One 10ms frame of the metadata option, the kMetadataFields rows in order
+struct FrameMetadata {
+    double frame_index;
+    double host_time_ms;
+    float rms;
+    float peak;
+    float speech_probability;
+    float echo_reduction_db;
+    TalkState talk;
+    bool clipped;
+};
+
+// A delivery's audio when subscribers take it too: written once by the
+// consumer, then only read, by every callback's array at once. The slab goes
+// back to the pool (or the heap block is freed) with the last reference.
+struct SharedPayload {
+    std::atomic<uint32_t> refs{1};
+    float* data = nullptr;
+    SlabPool* pool = nullptr;  // null when data came from new[]
+};
+
+static SharedPayload* NewSharedPayload(SlabPool* pool, size_t bytes) {
+    SharedPayload* shared = new SharedPayload();
+    if (pool && bytes <= pool->SlabSamples() * sizeof(float)) {
+        shared->data = pool->Acquire();
+        shared->pool = pool;
+    } else {
+        shared->data = new float[(bytes + sizeof(float) - 1) / sizeof(float)];
+    }
+    return shared;
+}
+
+static SharedPayload* RetainPayload(SharedPayload* shared) {
+    shared->refs.fetch_add(1, std::memory_order_relaxed);
+    return shared;
+}
+
+static void ReleasePayload(SharedPayload* shared) {
+    if (shared->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    if (shared->pool) {
+        shared->pool->Release(shared->data);
+    } else {
+        delete[] shared->data;
+    }
+    delete shared;
+}
+
+// One JS delivery; exactly one of |samples|/|pcm| (copy mode) or |slab|
+// (zero-copy) is set. In PCM16 mode the slab holds int16 samples.
+struct CaptureDelivery {
+    std::vector<float>* samples;
+    std::vector<int16_t>* pcm;
+    float* slab;
+    SlabPool* pool;
+    bool pcm16;
+    bool node_buffer;        // pcm16 as a Buffer (s16le) rather than an Int16Array
+    uint32_t num_samples;
+    double timestamp;        // Date.now() domain, derived from host time
+    double host_time_ms;     // monotonic host time of the first sample
+    double sample_index;
+    std::vector<float>* vad = nullptr;  // speech probability per 10ms frame completed here
+    std::vector<float>* levels = nullptr;  // kLevelFields per 10ms frame completed here
+    std::vector<uint8_t>* talk = nullptr;  // TalkState per 10ms frame completed here
+    std::vector<uint8_t>* classes = nullptr;  // AudioClass per second completed here
+    std::vector<uint8_t>* speakers = nullptr;  // local speaker ID per second completed here
+    std::vector<FrameMetadata>* metadata = nullptr;  // per 10ms frame completed here
+    double silence_ms = 0.0;            // silence marker: gated audio, no samples
+    EndpointType endpoint = EndpointType::kNone;  // endpoint marker, no samples
+    UtteranceProsody* prosody = nullptr;          // on end markers, with the prosody option
+
+    // Set on deliveries with audio; the TSFN callback records the JS-side stages
+    LatencyTrace* trace = nullptr;
+    const HostClock* clock = nullptr;
+    uint64_t capture_host = 0;  // newest sample
+    uint64_t dsp_host = 0;      // handed to the TSFN
+
+    uint64_t session = 0;       // the Open() it belongs to
+    SharedPayload* shared = nullptr;  // the audio, with subscribers: instead of slab/samples/pcm
+};
+
+// A subscribeCapture() callback: its own TSFN, and its own deliveries under
+// the stream's queue_mutex_
+struct CaptureSubscriber {
+    uint64_t id = 0;
+    Napi::ThreadSafeFunction tsfn;
+    SubscriberOptions options;
+    std::deque<CaptureDelivery*> queue;
+    bool wake_pending = false;
+
+    ~CaptureSubscriber();
+};
+
+static std::atomic<uint64_t> g_next_subscriber_id{1};
+
+static uint64_t TicksToNs(const HostClock* clock, uint64_t from_host, uint64_t to_host) {
+    return to_host > from_host ? static_cast<uint64_t>(clock->TicksToMs(to_host - from_host) * 1e6) : 0;
+}
+
+static void FinalizeSlab(napi_env /*env*/, void* data, void* hint) {
+    static_cast<SlabPool*>(hint)->Release(static_cast<float*>(data));
+}
+
+static void FinalizePayload(napi_env /*env*/, void* /*data*/, void* hint) {
+    ReleasePayload(static_cast<SharedPayload*>(hint));
+}
+
+static void DisposeDelivery(CaptureDelivery* data) {
+    if (data->slab) data->pool->Release(data->slab);
+    if (data->shared) ReleasePayload(data->shared);
+    delete data->samples;
+    delete data->pcm;
+    delete data->vad;
+    delete data->levels;
+    delete data->talk;
+    delete data->classes;
+    delete data->speakers;
+    delete data->metadata;
+    delete data->prosody;
+    delete data;
+}
+
+CaptureSubscriber::~CaptureSubscriber() {
+    for (CaptureDelivery* data : queue) {
+        DisposeDelivery(data);
+    }
+}
+
+static const void* DeliveryPayload(const CaptureDelivery* data) {
+    if (data->shared) return data->shared->data;
+    if (data->slab) return data->slab;
+    if (data->pcm) return data->pcm->data();
+    return data->samples->data();
+}
+
+template <typename T>
+static void AppendValues(std::vector<T>** into, std::vector<T>* from) {
+    if (*into && from) {
+        (*into)->insert((*into)->end(), from->begin(), from->end());
+    }
+}
+
+// Appends |from|'s audio to |into|, which the JS thread has not taken yet,
+// and disposes |from|. The merged samples move to the heap, so a coalesced
+// delivery is never zero-copy. Silence markers do not merge.
+static bool CoalesceDelivery(CaptureDelivery* into, CaptureDelivery* from) {
+    if (into->num_samples == 0 || from->num_samples == 0) {
+        return false;
+    }
+
+    size_t sample_bytes = into->pcm16 ? sizeof(int16_t) : sizeof(float);
+    size_t total = static_cast<size_t>(into->num_samples) + from->num_samples;
+    std::vector<int16_t>* pcm = nullptr;
+    std::vector<float>* samples = nullptr;
+    uint8_t* merged;
+    if (into->pcm16) {
+        pcm = new std::vector<int16_t>(total);
+        merged = reinterpret_cast<uint8_t*>(pcm->data());
+    } else {
+        samples = new std::vector<float>(total);
+        merged = reinterpret_cast<uint8_t*>(samples->data());
+    }
+    memcpy(merged, DeliveryPayload(into), into->num_samples * sample_bytes);
+    memcpy(merged + into->num_samples * sample_bytes, DeliveryPayload(from), from->num_samples * sample_bytes);
+
+    if (into->slab) {
+        into->pool->Release(into->slab);
+        into->slab = nullptr;
+    }
+    if (into->shared) {
+        ReleasePayload(into->shared);
+        into->shared = nullptr;
+    }
+    delete into->samples;
+    delete into->pcm;
+    into->samples = samples;
+    into->pcm = pcm;
+    into->num_samples = static_cast<uint32_t>(total);
+    AppendValues(&into->vad, from->vad);
+    AppendValues(&into->levels, from->levels);
+    AppendValues(&into->talk, from->talk);
+    AppendValues(&into->classes, from->classes);
+    AppendValues(&into->speakers, from->speakers);
+    AppendValues(&into->metadata, from->metadata);
+    into->capture_host = from->capture_host;
+
+    DisposeDelivery(from);
+    return true;
+}
+
+// Builds the typed array handed to JS: Float32Array, or in PCM16 mode an
+// Int16Array or (s16le) a Node Buffer. In zero-copy mode the array is a view
+// over the pooled slab, and with subscribers over the shared payload (one
+// reference each); runtimes that forbid external buffers (V8 sandbox) fall
+// back to a copy and the slab goes straight back to the pool.
+static Napi::TypedArray MakeDeliveryArray(Napi::Env env, CaptureDelivery* data) {
+    size_t sample_bytes = data->pcm16 ? sizeof(int16_t) : sizeof(float);
+    size_t byte_length = data->num_samples * sample_bytes;
+
+    const void* source = nullptr;
+    if (data->slab || data->shared) {
+        float* memory = data->shared ? data->shared->data : data->slab;
+        napi_finalize finalize = data->shared ? FinalizePayload : FinalizeSlab;
+        void* hint = data->shared ? static_cast<void*>(data->shared) : static_cast<void*>(data->pool);
+        napi_value buffer;
+        napi_status status = data->node_buffer
+            ? napi_create_external_buffer(env, byte_length, memory, finalize, hint, &buffer)
+            : napi_create_external_arraybuffer(env, memory, byte_length, finalize, hint, &buffer);
+        if (status == napi_ok) {
+            // now owned by the buffer's finalizer
+            data->slab = nullptr;
+            data->shared = nullptr;
+            if (data->node_buffer) {
+                return Napi::Buffer<uint8_t>(env, buffer);
+            }
+            Napi::ArrayBuffer arrayBuffer(env, buffer);
+            if (data->pcm16) {
+                return Napi::Int16Array::New(env, data->num_samples, arrayBuffer, 0);
+            }
+            return Napi::Float32Array::New(env, data->num_samples, arrayBuffer, 0);
+        }
+        source = memory;
+    } else if (data->pcm16) {
+        source = data->pcm->data();
+    } else {
+        source = data->samples->data();
+    }
+
+    if (data->node_buffer) {
+        return Napi::Buffer<uint8_t>::Copy(env, static_cast<const uint8_t*>(source), byte_length);
+    }
+    if (data->pcm16) {
+        Napi::Int16Array copy = Napi::Int16Array::New(env, data->num_samples);
+        memcpy(copy.Data(), source, byte_length);
+        return copy;
+    }
+    Napi::Float32Array copy = Napi::Float32Array::New(env, data->num_samples);
+    memcpy(copy.Data(), source, byte_length);
+    return copy;
+}
+
+CaptureOptions ParseCaptureOptions(const Napi::Value& value) {
+    CaptureOptions parsed;
+    if (!value.IsObject()) {
+        return parsed;
+    }
+
+    Napi::Object options = value.As<Napi::Object>();
+    if (options.Has("zeroCopy") && options.Get("zeroCopy").IsBoolean()) {
+        parsed.zero_copy = options.Get("zeroCopy").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("deliveryIntervalMs") && options.Get("deliveryIntervalMs").IsNumber()) {
+        double interval = options.Get("deliveryIntervalMs").As<Napi::Number>().DoubleValue();
+        parsed.delivery_interval_ms = std::max(0.0, std::min(interval, kMaxDeliveryIntervalMs));
+    }
+    if (options.Has("processed") && options.Get("processed").IsBoolean()) {
+        parsed.processed = options.Get("processed").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("sharedClock") && options.Get("sharedClock").IsBoolean()) {
+        parsed.shared_clock = options.Get("sharedClock").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("processes") && options.Get("processes").IsArray()) {
+        Napi::Array processes = options.Get("processes").As<Napi::Array>();
+        for (uint32_t i = 0; i < processes.Length(); ++i) {
+            Napi::Value process = processes.Get(i);
+            if (process.IsString()) {
+                std::string bundle_id = process.As<Napi::String>().Utf8Value();
+                if (!bundle_id.empty()) {
+                    parsed.tap_bundle_ids.push_back(bundle_id);
+                }
+            } else if (process.IsNumber() && process.As<Napi::Number>().Int32Value() > 0) {
+                parsed.tap_pids.push_back(process.As<Napi::Number>().Int32Value());
+            }
+        }
+    }
+    if (options.Has("ioBufferFrames") && options.Get("ioBufferFrames").IsNumber()) {
+        double frames = options.Get("ioBufferFrames").As<Napi::Number>().DoubleValue();
+        parsed.io_buffer_frames = frames > 0.0 ? static_cast<uint32_t>(std::min(frames, kMaxIoBufferFrames)) : 0;
+    }
+    if (options.Has("inputChannels") && options.Get("inputChannels").IsArray()) {
+        Napi::Array channels = options.Get("inputChannels").As<Napi::Array>();
+        for (uint32_t i = 0; i < channels.Length() && parsed.input_channels.size() < kMaxInputChannels; ++i) {
+            Napi::Value channel = channels.Get(i);
+            if (!channel.IsNumber()) {
+                continue;
+            }
+            int index = channel.As<Napi::Number>().Int32Value();
+            if (index >= 0 && index < static_cast<int>(kMaxInputChannels) &&
+                std::find(parsed.input_channels.begin(), parsed.input_channels.end(), index) ==
+                    parsed.input_channels.end()) {
+                parsed.input_channels.push_back(index);
+            }
+        }
+    }
+    if (options.Has("beamform") && options.Get("beamform").IsBoolean()) {
+        parsed.beamform = options.Get("beamform").As<Napi::Boolean>().Value();
+    }
+    // 'hal' (default), 'auhal' or 'voiceProcessing'; 'communications' on
+    // Windows, where the others all read the same shared-mode stream
+    if (options.Has("engine") && options.Get("engine").IsString()) {
+        std::string engine = options.Get("engine").As<Napi::String>().Utf8Value();
+#if defined(_WIN32)
+        parsed.engine = engine == "communications" ? MicEngine::kCommunications : MicEngine::kHal;
+#else
+        parsed.engine = engine == "auhal" ? MicEngine::kAuhal
+            : engine == "voiceProcessing" ? MicEngine::kVoiceProcessing : MicEngine::kHal;
+#endif
+    }
+    // 'default', 'min', 'mid' or 'max', as AUVoiceIOOtherAudioDuckingLevel
+    if (options.Has("ducking") && options.Get("ducking").IsString()) {
+        std::string ducking = options.Get("ducking").As<Napi::String>().Utf8Value();
+        parsed.ducking_level = ducking == "min" ? 10 : ducking == "mid" ? 20 : ducking == "max" ? 30 : 0;
+    }
+    if (options.Has("outputSampleRate") && options.Get("outputSampleRate").IsNumber()) {
+        double rate = std::round(options.Get("outputSampleRate").As<Napi::Number>().DoubleValue() / 100.0) * 100.0;
+        parsed.output_sample_rate = std::max(kMinOutputSampleRate, std::min(rate, kMaxOutputSampleRate));
+    }
+    // 'f32'/'float32' (default), 'pcm16' (Int16Array) or 's16le' (Buffer)
+    if (options.Has("format") && options.Get("format").IsString()) {
+        std::string format = options.Get("format").As<Napi::String>().Utf8Value();
+        parsed.node_buffer = format == "s16le";
+        parsed.pcm16 = parsed.node_buffer || format == "pcm16";
+    }
+    if (options.Has("vad") && options.Get("vad").IsBoolean()) {
+        parsed.vad = options.Get("vad").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("levels") && options.Get("levels").IsBoolean()) {
+        parsed.levels = options.Get("levels").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("classify") && options.Get("classify").IsBoolean()) {
+        parsed.classify = options.Get("classify").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("speakers") && options.Get("speakers").IsBoolean()) {
+        parsed.speakers = options.Get("speakers").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("metadata") && options.Get("metadata").IsBoolean()) {
+        parsed.metadata = options.Get("metadata").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("verifyVoice") && options.Get("verifyVoice").IsBoolean()) {
+        parsed.verify_voice = options.Get("verifyVoice").As<Napi::Boolean>().Value();
+    }
+    // voiceprint: the bytes finishVoiceEnrollment() returned
+    if (options.Has("voiceprint") && options.Get("voiceprint").IsTypedArray() &&
+        options.Get("voiceprint").As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array) {
+        Napi::Uint8Array bytes = options.Get("voiceprint").As<Napi::Uint8Array>();
+        auto voiceprint = std::make_shared<Voiceprint>();
+        std::string error;
+        if (Voiceprint::Parse(bytes.Data(), bytes.ByteLength(), voiceprint.get(), &error)) {
+            parsed.voiceprint = std::move(voiceprint);
+        } else {
+            Log(LogLevel::kWarn, kLogSource, "voiceprint ignored (%s); enrollment only", error.c_str());
+        }
+    }
+    if (options.Has("maxQueuedDeliveries") && options.Get("maxQueuedDeliveries").IsNumber()) {
+        double queued = options.Get("maxQueuedDeliveries").As<Napi::Number>().DoubleValue();
+        parsed.max_queued = static_cast<uint32_t>(std::max(1.0, std::min(queued, kMaxQueuedDeliveries)));
+    }
+    // 'coalesce' (default), 'dropOldest' or 'block'
+    if (options.Has("overloadPolicy") && options.Get("overloadPolicy").IsString()) {
+        std::string policy = options.Get("overloadPolicy").As<Napi::String>().Utf8Value();
+        if (policy == "dropOldest") {
+            parsed.overload_policy = OverloadPolicy::kDropOldest;
+        } else if (policy == "block") {
+            parsed.overload_policy = OverloadPolicy::kBlock;
+        }
+    }
+    if (options.Has("enhance") && options.Get("enhance").IsBoolean()) {
+        parsed.enhance = options.Get("enhance").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("declick") && options.Get("declick").IsBoolean()) {
+        parsed.declick = options.Get("declick").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("denoiseModel") && options.Get("denoiseModel").IsString()) {
+        parsed.denoise_model = options.Get("denoiseModel").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("talk") && options.Get("talk").IsBoolean()) {
+        parsed.talk = options.Get("talk").As<Napi::Boolean>().Value();
+    }
+    if (options.Has("chunkMs") && options.Get("chunkMs").IsNumber()) {
+        double chunk = std::round(options.Get("chunkMs").As<Napi::Number>().DoubleValue() / 10.0) * 10.0;
+        parsed.chunk_ms = chunk > 0.0 ? std::max(kMinChunkMs, std::min(chunk, kMaxChunkMs)) : 0.0;
+    }
+
+    // history: true, or { seconds, bitrate }
+    Napi::Value history = options.Has("history") ? options.Get("history") : Napi::Value();
+    if (!history.IsEmpty() && history.IsBoolean()) {
+        parsed.history_seconds = history.As<Napi::Boolean>().Value() ? kDefaultHistorySeconds : 0.0;
+    } else if (!history.IsEmpty() && history.IsObject()) {
+        Napi::Object history_options = history.As<Napi::Object>();
+        parsed.history_seconds = kDefaultHistorySeconds;
+        if (history_options.Has("seconds") && history_options.Get("seconds").IsNumber()) {
+            double seconds = history_options.Get("seconds").As<Napi::Number>().DoubleValue();
+            parsed.history_seconds = std::max(0.0, std::min(seconds, kMaxHistorySeconds));
+        }
+        if (history_options.Has("bitrate") && history_options.Get("bitrate").IsNumber()) {
+            double bitrate = history_options.Get("bitrate").As<Napi::Number>().DoubleValue();
+            parsed.history_bitrate = static_cast<int>(std::max(kMinHistoryBitrate, std::min(bitrate, kMaxHistoryBitrate)));
+        }
+    }
+
+    // gate: true, or { threshold, hangoverMs, prerollMs, silenceMarkerMs }
+    Napi::Value gate = options.Has("gate") ? options.Get("gate") : Napi::Value();
+    if (!gate.IsEmpty() && gate.IsBoolean()) {
+        parsed.gate = gate.As<Napi::Boolean>().Value();
+    } else if (!gate.IsEmpty() && gate.IsObject()) {
+        Napi::Object gate_options = gate.As<Napi::Object>();
+        parsed.gate = true;
+        auto number = [&](const char* key, double fallback, double lo, double hi) {
+            if (!gate_options.Has(key) || !gate_options.Get(key).IsNumber()) {
+                return fallback;
+            }
+            return std::max(lo, std::min(gate_options.Get(key).As<Napi::Number>().DoubleValue(), hi));
+        };
+        parsed.gate_threshold = static_cast<float>(number("threshold", parsed.gate_threshold, 0.0, 1.0));
+        parsed.gate_hangover_ms = number("hangoverMs", parsed.gate_hangover_ms, 0.0, kMaxGateHangoverMs);
+        parsed.gate_preroll_ms = number("prerollMs", parsed.gate_preroll_ms, 0.0, kMaxGatePrerollMs);
+        parsed.silence_marker_ms = number("silenceMarkerMs", parsed.silence_marker_ms, 0.0, kMaxGateHangoverMs);
+    }
+
+    // endpoint: true, or { threshold, minSpeechMs, trailingSilenceMs }
+    Napi::Value endpoint = options.Has("endpoint") ? options.Get("endpoint") : Napi::Value();
+    if (!endpoint.IsEmpty() && endpoint.IsBoolean()) {
+        parsed.endpoint = endpoint.As<Napi::Boolean>().Value();
+    } else if (!endpoint.IsEmpty() && endpoint.IsObject()) {
+        Napi::Object endpoint_options = endpoint.As<Napi::Object>();
+        parsed.endpoint = true;
+        auto number = [&](const char* key, double fallback, double lo, double hi) {
+            if (!endpoint_options.Has(key) || !endpoint_options.Get(key).IsNumber()) {
+                return fallback;
+            }
+            return std::max(lo, std::min(endpoint_options.Get(key).As<Napi::Number>().DoubleValue(), hi));
+        };
+        parsed.endpoint_threshold = static_cast<float>(number("threshold", parsed.endpoint_threshold, 0.0, 1.0));
+        parsed.endpoint_min_speech_ms =
+            number("minSpeechMs", parsed.endpoint_min_speech_ms, 10.0, kMaxEndpointMinSpeechMs);
+        parsed.endpoint_trailing_silence_ms =
+            number("trailingSilenceMs", parsed.endpoint_trailing_silence_ms, 10.0, kMaxEndpointSilenceMs);
+        if (endpoint_options.Has("prosody") && endpoint_options.Get("prosody").IsBoolean()) {
+            parsed.prosody = endpoint_options.Get("prosody").As<Napi::Boolean>().Value();
+        }
+    }
+    parsed.vad = parsed.vad || parsed.gate || parsed.endpoint || parsed.classify || parsed.speakers || parsed.metadata;
+
+    if (options.Has("sharedRing") && !options.Get("sharedRing").IsUndefined()) {
+        parsed.shared_ring = SharedRingWriter::FromValue(options.Get("sharedRing"));
+        if (parsed.shared_ring) {
+            parsed.pcm16 = parsed.shared_ring->SampleBytes() == 2;
+            parsed.node_buffer = false;
+        }
+    }
+    if (options.Has("transport") && !options.Get("transport").IsUndefined()) {
+        parsed.transport = TranscriptionSocketFromValue(options.Get("transport"));
+        if (!parsed.transport) {
+            parsed.transport = LocalTranscriberFromValue(options.Get("transport"));
+        }
+        if (!parsed.transport) {
+            parsed.transport = InterleaverChannelFromValue(options.Get("transport"));
+        }
+        if (!parsed.transport) {
+            Log(LogLevel::kWarn, kLogSource,
+                "transport must be a TranscriptionSocket, LocalTranscriber or InterleaverChannel; "
+                "delivering by callback");
+        } else {
+            parsed.pcm16 = true;
+            parsed.node_buffer = false;
+        }
+    }
+    return parsed;
+}
+
+SubscriberOptions ParseSubscriberOptions(const Napi::Value& value) {
+    SubscriberOptions parsed;
+    if (!value.IsObject()) {
+        return parsed;
+    }
+
+    Napi::Object options = value.As<Napi::Object>();
+    if (options.Has("maxQueuedDeliveries") && options.Get("maxQueuedDeliveries").IsNumber()) {
+        double queued = options.Get("maxQueuedDeliveries").As<Napi::Number>().DoubleValue();
+        parsed.max_queued = static_cast<uint32_t>(std::max(1.0, std::min(queued, kMaxQueuedDeliveries)));
+    }
+    // 'dropOldest' (default) or 'coalesce'
+    if (options.Has("overloadPolicy") && options.Get("overloadPolicy").IsString()) {
+        std::string policy = options.Get("overloadPolicy").As<Napi::String>().Utf8Value();
+        if (policy == "coalesce") {
+            parsed.overload_policy = OverloadPolicy::kCoalesce;
+        }
+    }
+    return parsed;
+}
+
+CaptureStream::CaptureStream(const char* name, const HostClock* clock,
+                             size_t ring_samples, size_t ring_chunks)
+    : name_(name),
+      clock_(clock),
+      ring_(ring_samples),
+      chunk_ring_(ring_chunks),
+      talk_ring_(kTalkFrames),
+      memory_(name, [this] { return MemoryBytes(); },
+              [this](MemoryPressure pressure, const MemoryMinimums& minimums) {
+                  OnMemoryPressure(pressure, minimums);
+              }) {}
+
+// Rings, the session arena and the slab pool, loans to JS included
+uint64_t CaptureStream::MemoryBytes() {
+    uint64_t bytes = ring_.Capacity() * sizeof(float) + chunk_ring_.Capacity() * sizeof(CaptureChunkInfo) +
+                     talk_ring_.Capacity() * sizeof(TalkFrame) + arena_.Capacity();
+    std::lock_guard<std::mutex> lock(memory_mutex_);
+    if (slab_pool_) {
+        bytes += slab_pool_->Bytes();
+    }
+    if (history_) {
+        bytes += history_->Bytes();
+    }
+    return bytes;
+}
+
+// Idle slabs go under pressure and come back once it clears; the gate's
+// pre-roll is sized at the next Open()
+void CaptureStream::OnMemoryPressure(MemoryPressure pressure, const MemoryMinimums& minimums) {
+    std::lock_guard<std::mutex> lock(memory_mutex_);
+    if (!slab_pool_) {
+        return;
+    }
+    if (pressure == MemoryPressure::kNormal) {
+        slab_pool_->Fill(kInitialSlabs);
+    } else {
+        slab_pool_->Trim(minimums.idle_slabs);
+    }
+}
+
+// Out of line so the header can forward-declare the resampler
+CaptureStream::~CaptureStream() {
+    if (IsOpen()) {
+        Close();
+    }
+}
+
+void CaptureStream::Open(Napi::Env env, Napi::Function callback, const CaptureOptions& options,
+                         double sample_rate) {
+    const uint64_t rss_open = ResidentBytes();
+    options_ = options;
+    const bool pressure = CurrentMemoryPressure() != MemoryPressure::kNormal;
+    const MemoryMinimums minimums = GetMemoryMinimums();
+    if (pressure) {
+        options_.gate_preroll_ms = std::min(options_.gate_preroll_ms, minimums.preroll_ms);
+    }
+    sample_rate_ = sample_rate;
+    output_sample_rate_ = options.output_sample_rate > 0.0 ? options.output_sample_rate : sample_rate;
+    shared_ring_ = options_.shared_ring;
+    if (shared_ring_) {
+        shared_ring_->Begin(static_cast<int>(output_sample_rate_));
+    }
+    transport_ = shared_ring_ ? nullptr : options_.transport;
+
+    // Sinc resampling in 10ms blocks. convert_buffer_ holds one delivery
+    // (at most a full ring) after resampling or before PCM16 conversion.
+    resampler_.reset();
+    resample_fill_ = 0;
+    size_t convert_samples =
+        (options_.pcm16 || options_.gate || options_.endpoint || options_.chunk_ms > 0.0 || options_.enhance ||
+         options_.declick || !options_.denoise_model.empty() || options_.history_seconds > 0.0)
+            ? ring_.Capacity() : 0;
+    if (output_sample_rate_ != sample_rate_) {
+        input_block_ = static_cast<size_t>(sample_rate_ / 100.0);
+        output_block_ = static_cast<size_t>(output_sample_rate_ / 100.0);
+        resampler_ = std::make_unique<webrtc::PushSincResampler>(input_block_, output_block_);
+        convert_samples = (ring_.Capacity() / input_block_ + 1) * output_block_;
+    }
+
+    // The buffers that stay this size all session, in one block; the gate's
+    // frame is 10ms at the output rate
+    const size_t gate_frame = options_.gate || options_.endpoint ? static_cast<size_t>(output_sample_rate_ / 100.0) : 0;
+    arena_.Prepare((resampler_ ? ArenaBytes<float>(input_block_) : 0) + ArenaBytes<float>(convert_samples) +
+                   (transport_ ? ArenaBytes<int16_t>(convert_samples) : 0) + ArenaBytes<float>(gate_frame));
+    if (resampler_) {
+        resample_block_.assign(input_block_, 0.0f);
+    }
+    convert_buffer_.resize(convert_samples);
+    if (transport_) {
+        transport_pcm_.resize(convert_samples);
+    }
+
+    // Own APM per session, with nothing to cancel: the stream is cleaned up
+    // here on its consumer thread, in parallel with the mic's DSP thread
+    enhancer_.reset();
+    enhancer_delay_ = 0;
+    if (options_.enhance) {
+        enhancer_ = std::make_unique<AECProcessor>(EnhanceConfig());
+        if (enhancer_->Initialize(static_cast<int>(sample_rate_), 1, 1)) {
+            enhancer_delay_ = clock_->MsToTicks(enhancer_->OutputLatencySamples() * 1000.0 / sample_rate_);
+        } else {
+            Log(LogLevel::kWarn, kLogSource, "%s: enhance unavailable at %.0fHz; delivering it as captured",
+                name_.c_str(), sample_rate_);
+            enhancer_.reset();
+        }
+    }
+
+    // Neural denoising on the consumer thread too; the model is read per
+    // session, a few tens of KB
+    denoiser_.reset();
+    denoiser_delay_ = 0;
+    if (!options_.denoise_model.empty()) {
+        std::string error;
+        std::shared_ptr<const DenoiserModel> model;
+        if (sample_rate_ != NeuralDenoiser::kSampleRate) {
+            error = "it runs at 48kHz only";
+        } else {
+            model = DenoiserModel::Load(options_.denoise_model, &error);
+        }
+        if (model) {
+            denoiser_ = std::make_unique<NeuralDenoiser>(std::move(model));
+            size_t delay = (resampler_ ? 1 : 2) * NeuralDenoiser::kFrameSize;
+            denoiser_delay_ = clock_->MsToTicks(delay * 1000.0 / sample_rate_);
+        } else {
+            Log(LogLevel::kWarn, kLogSource, "%s: denoise unavailable (%s); delivering it as captured",
+                name_.c_str(), error.c_str());
+        }
+    }
+
+    // Ahead of the VAD, so keystrokes neither open the gate nor reach ASR.
+    // Resampled streams hand it whole 10ms blocks; others go through its
+    // internal frame, one frame late.
+    declicker_.reset();
+    declicker_delay_ = 0;
+    if (options_.declick) {
+        if (KeystrokeSuppressor::Supports(static_cast<int>(sample_rate_))) {
+            declicker_ = std::make_unique<KeystrokeSuppressor>(static_cast<int>(sample_rate_));
+            if (!resampler_) {
+                declicker_delay_ = clock_->MsToTicks(declicker_->FrameSize() * 1000.0 / sample_rate_);
+            }
+        } else {
+            Log(LogLevel::kWarn, kLogSource, "%s: declick unavailable at %.0fHz; delivering it as captured",
+                name_.c_str(), sample_rate_);
+        }
+    }
+
+    // Fresh detector per session so state never leaks across streams
+    vad_.reset();
+    levels_.reset();
+    classifier_.reset();
+    speaker_tracker_.reset();
+    if (verifier_) {
+        spectrum_.RemoveListener(verifier_.get());
+        verifier_.reset();
+    }
+    gate_.reset();
+    endpointer_.reset();
+    prosody_.reset();
+    utterance_begin_ = 0;
+    if (options_.vad) {
+        vad_ = std::make_unique<VoiceActivityDetector>(static_cast<int>(output_sample_rate_));
+    }
+    if (options_.levels || options_.metadata) {
+        levels_ = std::make_unique<LevelAnalyzer>(static_cast<size_t>(output_sample_rate_ / 100.0));
+    }
+    metadata_frames_ = 0;
+    metadata_fill_ = 0;
+    if (options_.classify && AudioClassifier::Supports(static_cast<int>(output_sample_rate_))) {
+        classifier_ = std::make_unique<AudioClassifier>(static_cast<int>(output_sample_rate_));
+    }
+    if (options_.speakers && SpeakerTracker::Supports(static_cast<int>(output_sample_rate_))) {
+        speaker_tracker_ = std::make_unique<SpeakerTracker>(static_cast<int>(output_sample_rate_));
+    }
+    if (options_.verify_voice) {
+        if (!(options_.gate || options_.endpoint) || !VoiceVerifier::Supports(static_cast<int>(output_sample_rate_))) {
+            Log(LogLevel::kWarn, kLogSource, "%s: verifyVoice needs gate or endpoint at 8-48kHz; not verifying",
+                name_.c_str());
+        } else {
+            verifier_ = std::make_unique<VoiceVerifier>(static_cast<int>(output_sample_rate_));
+            std::string error;
+            if (options_.voiceprint && !verifier_->SetVoiceprint(options_.voiceprint, &error)) {
+                Log(LogLevel::kWarn, kLogSource, "%s: voiceprint ignored (%s); enrollment only", name_.c_str(),
+                    error.c_str());
+            }
+            spectrum_.AddListener(verifier_.get());
+            // The verifier holds an utterance's first frames until it decides
+            options_.gate_preroll_ms = std::max(options_.gate_preroll_ms, VoiceVerifier::kPrerollMs);
+        }
+    }
+    if (options_.gate || options_.endpoint) {
+        // Runs hold at most one batch plus the pre-roll, so they never reallocate
+        size_t frame = vad_->FrameSize();
+        size_t preroll_frames = 0;
+        if (options_.gate) {
+            preroll_frames = static_cast<size_t>(options_.gate_preroll_ms / 10.0);
+            gate_ = std::make_unique<SilenceGate>(frame, options_.gate_threshold,
+                                                  static_cast<size_t>(options_.gate_hangover_ms / 10.0),
+                                                  preroll_frames);
+            gate_pressure_ = 0;
+        }
+        if (options_.endpoint) {
+            endpointer_ = std::make_unique<Endpointer>(
+                options_.endpoint_threshold, static_cast<size_t>(options_.endpoint_min_speech_ms / 10.0),
+                static_cast<size_t>(options_.endpoint_trailing_silence_ms / 10.0));
+            if (options_.prosody && ProsodyTracker::Supports(static_cast<int>(output_sample_rate_))) {
+                prosody_ = std::make_unique<ProsodyTracker>(static_cast<int>(output_sample_rate_));
+            }
+        }
+        frame_.assign(frame, 0.0f);
+        frame_fill_ = 0;
+        size_t run_frames = convert_samples / frame + preroll_frames + 2;
+        run_samples_.clear();
+        run_samples_.reserve(run_frames * frame);
+        run_frames_.clear();
+        run_frames_.reserve(run_frames);
+        silence_marker_frames_ = static_cast<size_t>(options_.silence_marker_ms / 10.0);
+    }
+
+    // A new session's history replaces the last one's
+    std::unique_ptr<AudioHistory> history;
+    if (options_.history_seconds > 0.0) {
+        std::string error;
+        history = AudioHistory::Create(clock_, static_cast<int>(output_sample_rate_), options_.history_seconds,
+                                       options_.history_bitrate, &error);
+        if (!history) {
+            Log(LogLevel::kWarn, kLogSource, "%s: history unavailable (%s)", name_.c_str(), error.c_str());
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        history_ = std::move(history);
+    }
+
+    chunker_.reset();
+    size_t chunk_samples = static_cast<size_t>(options_.chunk_ms * output_sample_rate_ / 1000.0);
+    if (chunk_samples > 0) {
+        chunker_ = std::make_unique<ChunkAssembler>(chunk_samples, static_cast<size_t>(output_sample_rate_ / 100.0));
+    }
+
+    tsfn_ = Napi::ThreadSafeFunction::New(env, callback, name_, 0, 1);
+    tsfn_unrefed_ = false;
+    {
+        // Deliveries of a previous session still queued go to its own callback
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        ++session_;
+        wake_pending_ = false;
+    }
+
+    // Slabs must hold a full coalesced batch plus one HAL buffer of overshoot,
+    // or a whole chunk
+    if (options_.zero_copy) {
+        size_t batch_samples = static_cast<size_t>(options_.delivery_interval_ms *
+                                                   std::max(sample_rate_, output_sample_rate_) / 1000.0);
+        batch_samples = std::max(batch_samples, chunk_samples);
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        slab_pool_ = new SlabPool(std::max(kSlabSamples, batch_samples + kSlabSamples),
+                                  pressure ? minimums.idle_slabs : kInitialSlabs);
+    }
+
+    ring_.Reset();
+    chunk_ring_.Reset();
+    talk_ring_.Reset();
+    talk_frames_.clear();
+    talk_fill_ = 0;
+    talk_enabled_.store(options_.talk || options_.metadata, std::memory_order_release);
+    samples_captured_ = 0;
+    align_host_ = start_host_.exchange(0, std::memory_order_relaxed);
+    flush_requested_ = false;
+    paused_host_ = 0;
+    gap_requested_ = false;
+    stats_.Reset();
+    stats_.rss_open_bytes.store(rss_open, std::memory_order_relaxed);
+    stats_.arena_bytes.store(arena_.Capacity(), std::memory_order_relaxed);
+    stats_.arena_overflow_bytes.store(arena_.OverflowBytes(), std::memory_order_relaxed);
+    trace_.Reset();
+    spectrum_.Reset();
+    last_enqueue_host_ = 0;
+
+    // Consumer must be draining before the first IOProc fires
+    consumer_running_ = true;
+    consumer_thread_ = std::thread(&CaptureStream::ConsumerLoop, this);
+    open_.store(true, std::memory_order_release);
+}
+
+void CaptureStream::SetIdle(Napi::Env env, bool idle) {
+    if (!tsfn_ || idle == tsfn_unrefed_) {
+        return;
+    }
+    if (idle) {
+        tsfn_.Unref(env);
+    } else {
+        tsfn_.Ref(env);
+    }
+    tsfn_unrefed_ = idle;
+}
+
+void CaptureStream::Close() {
+    if (!IsOpen()) {
+        return;
+    }
+    open_.store(false, std::memory_order_release);
+    talk_enabled_.store(false, std::memory_order_release);
+
+    consumer_running_ = false;
+    signal_.Signal();
+    if (consumer_thread_.joinable()) {
+        consumer_thread_.join();
+    }
+
+    // The flush's deliveries go out with the pending wake; a refused wake
+    // left them stranded, so try once more before the TSFN goes
+    bool stranded;
+    uint64_t session;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stranded = !wake_pending_ && !queue_.empty() && queue_.back()->session == session_;
+        wake_pending_ = wake_pending_ || stranded;
+        session = session_;
+    }
+    if (stranded && tsfn_) {
+        Wake(session);
+    }
+
+    // The flush is in the ring; the reader sees it closed after that
+    if (shared_ring_) {
+        shared_ring_->End();
+        shared_ring_.reset();
+    }
+    options_.shared_ring.reset();
+    transport_.reset();
+    options_.transport.reset();
+
+    if (tsfn_) {
+        tsfn_.Release();
+        tsfn_ = Napi::ThreadSafeFunction();
+    }
+
+    // Subscribers go with the session; what they have queued still goes out
+    // with a wake, pending or made here
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        for (const std::shared_ptr<CaptureSubscriber>& subscriber : subscribers_) {
+            if (!subscriber->wake_pending && !subscriber->queue.empty()) {
+                WakeSubscriber(subscriber);
+            }
+            subscriber->tsfn.Release();
+        }
+        subscribers_.clear();
+        subscriber_count_.store(0, std::memory_order_release);
+    }
+
+    // Slabs still referenced by JS keep the pool alive until they are collected
+    {
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        if (slab_pool_) {
+            slab_pool_->Orphan();
+            slab_pool_ = nullptr;
+        }
+    }
+
+    // The consumer is gone, and the session's buffers go in one piece
+    ReleaseStorage(&transport_pcm_);
+    ReleaseStorage(&resample_block_);
+    ReleaseStorage(&convert_buffer_);
+    ReleaseStorage(&frame_);
+    arena_.Release();
+    stats_.rss_close_bytes.store(ResidentBytes(), std::memory_order_relaxed);
+}
+
+void CaptureStream::Pause() {
+    PauseAt(HostTimeNow());
+}
+
+void CaptureStream::MarkGap() {
+    if (!IsOpen() || paused_host_.load(std::memory_order_acquire) != 0) {
+        return;
+    }
+    // The counter stands where the last callback left it, which may be well
+    // before anyone noticed the device was gone
+    uint64_t last = stats_.last_callback_start;
+    gap_requested_.store(true, std::memory_order_release);
+    PauseAt(last != 0 ? last : HostTimeNow());
+}
+
+void CaptureStream::PauseAt(uint64_t host_time) {
+    if (!IsOpen()) {
+        return;
+    }
+    // The producer is stopped; the pause is not a callback interval
+    stats_.last_callback_start = 0;
+    paused_host_.store(host_time, std::memory_order_release);
+    flush_requested_.store(true, std::memory_order_release);
+    signal_.Signal();
+}
+
+// Runs on the CoreAudio real-time thread: no allocation, no locks, no JS.
+void CaptureStream::PushFromRealtime(const float* data, uint32_t num_samples, uint64_t host_time) {
+    if (!open_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // First buffer after a pause
+    uint64_t paused = paused_host_.load(std::memory_order_acquire);
+    if (paused != 0 && host_time > paused) {
+        paused_host_.store(0, std::memory_order_relaxed);
+        samples_captured_ += static_cast<uint64_t>(clock_->TicksToMs(host_time - paused) * sample_rate_ / 1000.0);
+    }
+
+    // First buffer of a session on a shared start: trim what came before it
+    // and count from it
+    if (align_host_ != 0) {
+        const uint64_t start = align_host_;
+        if (host_time < start) {
+            const uint32_t skip = static_cast<uint32_t>(
+                std::min<double>(num_samples, std::round(clock_->TicksToMs(start - host_time) * sample_rate_ / 1000.0)));
+            if (skip == num_samples) {
+                return;
+            }
+            data += skip;
+            num_samples -= skip;
+            host_time = start;
+        }
+        samples_captured_ = static_cast<uint64_t>(std::llround(clock_->TicksToMs(host_time - start) * sample_rate_ / 1000.0));
+        align_host_ = 0;
+    }
+
+    uint64_t sample_index = samples_captured_;
+    samples_captured_ += num_samples;
+
+    // Both rings must accept the buffer, otherwise it is dropped whole.
+    // The sample counter still advances so positions stay tied to real time.
+    if (ring_.AvailableToWrite() < num_samples || chunk_ring_.AvailableToWrite() < 1) {
+        stats_.buffers_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    CaptureChunkInfo chunk{host_time, sample_index, num_samples, HostTimeNow()};
+    ring_.Write(data, num_samples);
+    chunk_ring_.Write(&chunk, 1);
+    stats_.buffers_captured.fetch_add(1, std::memory_order_relaxed);
+    signal_.Signal();
+}
+
+// A full ring drops the state; its frames then read as unknown
+void CaptureStream::PushTalkState(uint64_t host_time, TalkState state, float echo_reduction_db) {
+    if (!talk_enabled_.load(std::memory_order_acquire)) {
+        return;
+    }
+    TalkFrame frame{host_time, state, echo_reduction_db};
+    talk_ring_.Write(&frame, 1);
+}
+
+// Drains the ring off the real-time thread. Chunks are coalesced until
+// deliveryIntervalMs worth of samples is pending (0 = one delivery per IOProc).
+void CaptureStream::ConsumerLoop() {
+    size_t pending_samples = 0;
+    CaptureChunkInfo pending_first{};
+    uint64_t next_index = 0;   // where the next chunk starts if nothing was skipped
+    ScopedThreadCpu thread_cpu("captureConsumer");
+
+    // Ahead of Electron's main and renderer work, like the DSP thread
+    SetCurrentThreadPriority(ThreadPriority::kInteractive);
+
+    // The resampler, VAD and level filters see the same silent tails as
+    // the DSP thread's APM
+    webrtc::DenormalDisabler denormals;
+    const uint64_t cpu_start = CurrentThreadCpuNs();
+
+    while (consumer_running_) {
+        signal_.Wait();
+        g_consumer_wakeups.Count();
+
+        const double interval_ms = std::max(options_.delivery_interval_ms,
+                                            min_delivery_interval_ms_.load(std::memory_order_relaxed));
+        const size_t interval_samples = static_cast<size_t>(interval_ms * sample_rate_ / 1000.0);
+        CaptureChunkInfo chunk;
+        bool woke = true;
+        while (chunk_ring_.Read(&chunk, 1) == 1) {
+            if (woke) {
+                uint64_t now = HostTimeNow();
+                stats_.consumer_wake.Record(now > chunk.enqueue_host ? now - chunk.enqueue_host : 0);
+                woke = false;
+            }
+            OnChunkRead(chunk);
+            // The first chunk past a marked gap: what came before is out
+            // (the pause flush), the gap is next
+            if (chunk.sample_index > next_index && gap_requested_.exchange(false, std::memory_order_acq_rel)) {
+                if (pending_samples > 0) {
+                    DeliverSamples(pending_samples, pending_first);
+                    pending_samples = 0;
+                }
+                FlushChunk();
+                EmitGapMarker(next_index, chunk);
+            }
+            next_index = chunk.sample_index + chunk.num_samples;
+            if (pending_samples == 0) {
+                pending_first = chunk;
+            }
+            pending_samples += chunk.num_samples;
+
+            if (pending_samples >= interval_samples) {
+                DeliverSamples(pending_samples, pending_first);
+                pending_samples = 0;
+            }
+        }
+
+        // Paused: nothing follows for a while, so hand over the partial batch
+        if (flush_requested_.exchange(false, std::memory_order_acq_rel)) {
+            if (pending_samples > 0) {
+                DeliverSamples(pending_samples, pending_first);
+                pending_samples = 0;
+            }
+            FlushChunk();
+        }
+        stats_.consumer_cpu_ns.store(CurrentThreadCpuNs() - cpu_start, std::memory_order_relaxed);
+    }
+
+    // Flush what the IOProc wrote before stopping so the tail is not lost
+    CaptureChunkInfo chunk;
+    while (chunk_ring_.Read(&chunk, 1) == 1) {
+        OnChunkRead(chunk);
+        if (pending_samples == 0) {
+            pending_first = chunk;
+        }
+        pending_samples += chunk.num_samples;
+    }
+    if (pending_samples > 0) {
+        DeliverSamples(pending_samples, pending_first);
+    }
+    FlushChunk();
+    if (gate_) {
+        EmitSilenceMarker();
+    }
+    if (endpointer_) {
+        EndpointEvent end = endpointer_->Finish();
+        if (end.type != EndpointType::kNone) {
+            EmitEndpoint(end);
+        }
+    }
+}
+
+void CaptureStream::SetMinDeliveryIntervalMs(double interval_ms) {
+    min_delivery_interval_ms_.store(std::max(0.0, std::min(interval_ms, kMaxDeliveryIntervalMs)),
+                                    std::memory_order_relaxed);
+}
+
+// Consumer thread. Times the buffer from its last sample's HAL timestamp to
+// the ring write, and remembers the write for the delivery it ends up in
+void CaptureStream::OnChunkRead(const CaptureChunkInfo& chunk) {
+    uint64_t capture_end = chunk.host_time + clock_->MsToTicks(chunk.num_samples * 1000.0 / sample_rate_);
+    trace_.Record(TraceStage::kCaptureToEnqueue, TicksToNs(clock_, capture_end, chunk.enqueue_host));
+    last_enqueue_host_ = chunk.enqueue_host;
+}
+
+bool CaptureStream::ReadHistory(uint64_t from_host, uint64_t to_host, bool encoded, HistoryRange* range,
+                                std::string* error) const {
+    if (!history_) {
+        *error = "capture was not started with the history option";
+        return false;
+    }
+    return history_->Read(from_host, to_host, encoded, range, error);
+}
+
+bool CaptureStream::MarkSent(uint64_t sample_index) {
+    LatencyTrace::Pending pending;
+    if (!trace_.Take(sample_index, &pending)) {
+        return false;
+    }
+    uint64_t now = HostTimeNow();
+    trace_.Record(TraceStage::kJsToSent, TicksToNs(clock_, pending.js_host, now));
+    trace_.Record(TraceStage::kTotal, TicksToNs(clock_, pending.capture_host, now));
+    return true;
+}
+
+// Consumer thread. Reads |num_samples| from the ring through the resampler
+// (and the enhancer, denoiser and declicker, at the input rate) into
+// convert_buffer_ and returns how many output samples are ready; |out_first|
+// describes the first of them (host time shifted back by the filter,
+// enhancer and denoiser delays, index in the output rate). Zero when only a
+// partial block is pending.
+size_t CaptureStream::ResampleFromRing(size_t num_samples, const CaptureChunkInfo& first,
+                                       CaptureChunkInfo* out_first) {
+    const double ratio = output_sample_rate_ / sample_rate_;
+    const uint64_t filter_delay = clock_->MsToTicks(
+        webrtc::PushSincResampler::AlgorithmicDelaySeconds(static_cast<int>(sample_rate_)) * 1000.0) +
+        enhancer_delay_ + denoiser_delay_;
+
+    size_t produced = 0;
+    size_t consumed = 0;
+    while (consumed < num_samples) {
+        if (resample_fill_ == 0) {
+            resample_block_host_ = first.host_time + clock_->MsToTicks(consumed * 1000.0 / sample_rate_);
+            resample_block_index_ = first.sample_index + consumed;
+        }
+
+        size_t count = std::min(input_block_ - resample_fill_, num_samples - consumed);
+        ring_.Read(resample_block_.data() + resample_fill_, count);
+        resample_fill_ += count;
+        consumed += count;
+
+        if (resample_fill_ == input_block_) {
+            if (enhancer_) {
+                enhancer_->ProcessCaptureAudio(resample_block_.data(), resample_block_.data(), input_block_);
+            }
+            if (denoiser_) {
+                uint64_t start = HostTimeNow();
+                denoiser_->ProcessFrame(resample_block_.data());
+                stats_.denoise_ticks.fetch_add(HostTimeNow() - start, std::memory_order_relaxed);
+                stats_.denoise_frames.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (declicker_) {
+                declicker_->ProcessFrame(resample_block_.data());
+            }
+            if (produced == 0) {
+                out_first->host_time = resample_block_host_ > filter_delay
+                    ? resample_block_host_ - filter_delay : resample_block_host_;
+                out_first->sample_index = static_cast<uint64_t>(resample_block_index_ * ratio);
+            }
+            resampler_->Resample(resample_block_.data(), input_block_,
+                                 convert_buffer_.data() + produced, output_block_);
+            produced += output_block_;
+            resample_fill_ = 0;
+        }
+    }
+
+    out_first->num_samples = static_cast<uint32_t>(produced);
+    return produced;
+}
+
+// Reads |num_samples| contiguous samples from the ring into one JS delivery,
+// enhancing, denoising, declicking, resampling and converting to PCM16 first when the options ask
+// for it
+void CaptureStream::DeliverSamples(size_t num_samples, const CaptureChunkInfo& first) {
+    if (options_.talk) {
+        DrainTalk();
+    }
+    CaptureChunkInfo out_first = first;
+    const float* converted = nullptr;  // set when samples were staged in convert_buffer_
+    if (resampler_) {
+        num_samples = ResampleFromRing(num_samples, first, &out_first);
+        if (num_samples == 0) {
+            return;
+        }
+        converted = convert_buffer_.data();
+    } else if (options_.pcm16 || gate_ || endpointer_ || chunker_ || enhancer_ || denoiser_ || declicker_ ||
+               history_) {
+        ring_.Read(convert_buffer_.data(), num_samples);
+        converted = convert_buffer_.data();
+        if (enhancer_) {
+            // Its output trails the input by a fixed frame
+            enhancer_->ProcessCaptureAudio(convert_buffer_.data(), convert_buffer_.data(), num_samples);
+            out_first.host_time -= std::min(out_first.host_time, enhancer_delay_);
+        }
+        if (denoiser_) {
+            uint64_t start = HostTimeNow();
+            denoiser_->Process(convert_buffer_.data(), num_samples);
+            stats_.denoise_ticks.fetch_add(HostTimeNow() - start, std::memory_order_relaxed);
+            stats_.denoise_frames.fetch_add(num_samples / NeuralDenoiser::kFrameSize, std::memory_order_relaxed);
+            out_first.host_time -= std::min(out_first.host_time, denoiser_delay_);
+        }
+        if (declicker_) {
+            declicker_->Process(convert_buffer_.data(), num_samples);
+            out_first.host_time -= std::min(out_first.host_time, declicker_delay_);
+        }
+    }
+    if (declicker_) {
+        stats_.keystrokes_ducked.store(declicker_->Keystrokes(), std::memory_order_relaxed);
+    }
+    if (history_) {
+        history_->Append(converted, num_samples, out_first.host_time);
+    }
+
+    if (gate_ || endpointer_) {
+        DeliverFramed(converted, num_samples, out_first);
+        return;
+    }
+    Deliver(converted, num_samples, out_first, nullptr);
+}
+
+// Consumer thread. Hands contiguous |samples| on as they are, or through the
+// chunk assembler when chunkMs is set. Takes ownership of |vad| (one value
+// per frame of |samples|).
+void CaptureStream::Deliver(const float* samples, size_t num_samples, const CaptureChunkInfo& first,
+                            std::vector<float>* vad) {
+    if (!chunker_) {
+        Emit(samples, num_samples, first, vad, 0.0);
+        return;
+    }
+
+    const size_t frame = static_cast<size_t>(output_sample_rate_ / 100.0);
+    size_t offset = 0;
+    while (offset < num_samples) {
+        uint64_t host_time = first.host_time + clock_->MsToTicks(offset * 1000.0 / output_sample_rate_);
+        const float* values = vad ? vad->data() + offset / frame : nullptr;
+        offset += chunker_->Append(samples + offset, num_samples - offset, host_time,
+                                   first.sample_index + offset, values);
+        if (chunker_->Ready()) {
+            FlushChunk();
+        }
+    }
+    delete vad;
+}
+
+// Delivers the pending chunk, full or not
+void CaptureStream::FlushChunk() {
+    if (!chunker_ || chunker_->Empty()) {
+        return;
+    }
+    CaptureChunkInfo chunk_first{chunker_->StartHostTime(), chunker_->StartSampleIndex(),
+                                 static_cast<uint32_t>(chunker_->Size())};
+    const std::vector<float>& values = chunker_->FrameValues();
+    std::vector<float>* vad = values.empty() ? nullptr : new std::vector<float>(values);
+    Emit(chunker_->Samples(), chunker_->Size(), chunk_first, vad, 0.0);
+    chunker_->Clear();
+}
+
+// Consumer thread. Cuts |samples| into 10ms frames, runs each through the VAD,
+// the endpointer and the gate, and delivers contiguous runs of open frames
+// (every frame when ungated). Their VAD probabilities line up with the
+// delivered frames exactly.
+void CaptureStream::DeliverFramed(const float* samples, size_t num_samples, const CaptureChunkInfo& first) {
+    if (gate_ && transport_) {
+        TightenGate(transport_->Pressure());
+    }
+    const size_t frame = frame_.size();
+    size_t offset = 0;
+    while (offset < num_samples) {
+        if (frame_fill_ == 0) {
+            frame_host_ = first.host_time + clock_->MsToTicks(offset * 1000.0 / output_sample_rate_);
+            frame_index_ = first.sample_index + offset;
+        }
+        size_t count = std::min(frame - frame_fill_, num_samples - offset);
+        memcpy(frame_.data() + frame_fill_, samples + offset, count * sizeof(float));
+        frame_fill_ += count;
+        offset += count;
+        if (frame_fill_ < frame) {
+            break;
+        }
+        frame_fill_ = 0;
+
+        GateFrameInfo info{frame_host_, frame_index_, vad_->AnalyzeFrame(frame_.data())};
+        if (options_.talk && TalkAt(frame_host_) == TalkState::kFarEnd) {
+            // The mic hears the far end: echo, not speech to pass on
+            info.probability = 0.0f;
+        }
+        if (verifier_) {
+            // Its cepstrum is this frame's shared spectrum
+            spectrum_.Add(frame_.data(), frame, static_cast<int>(output_sample_rate_));
+        }
+        if (verifier_ && !verifier_->ProcessFrame(frame_.data(), info.probability)) {
+            // Not (yet) the enrolled user's voice
+            info.probability = 0.0f;
+        }
+        if (prosody_) {
+            prosody_->ProcessFrame(frame_.data(), info.probability, frame_index_);
+        }
+        if (talk_party_ != TalkParty::kNone && IsTalkAnalyticsRunning()) {
+            AddTalkFrames(talk_party_, clock_->HostTimeMs(frame_host_), &info.probability, 1);
+        }
+        EndpointEvent endpoint = endpointer_ ? endpointer_->Process(info) : EndpointEvent{};
+        if (!gate_) {
+            run_samples_.insert(run_samples_.end(), frame_.begin(), frame_.end());
+            run_frames_.push_back(info);
+        } else {
+            bool was_open = gate_->IsOpen();
+            size_t appended = gate_->Process(frame_.data(), info, &run_samples_, &run_frames_);
+            if (appended > 0 && !was_open) {
+                // Speech onset: account for the silence it ends before its audio
+                EmitSilenceMarker();
+            } else if (appended == 0) {
+                if (was_open) {
+                    // The speech run is over; its last chunk need not wait to fill
+                    FlushRun();
+                    FlushChunk();
+                }
+                if (silence_marker_frames_ > 0 && gate_->SuppressedFrames() >= silence_marker_frames_) {
+                    EmitSilenceMarker();
+                }
+            }
+        }
+        if (endpoint.type != EndpointType::kNone) {
+            // The audio up to the boundary goes first; an utterance's last
+            // chunk ends with it rather than running on into the next one
+            FlushRun();
+            if (endpoint.type == EndpointType::kUtteranceEnd) {
+                FlushChunk();
+            }
+            EmitEndpoint(endpoint);
+        }
+    }
+
+    // Bound latency: the open run goes out with every batch
+    FlushRun();
+}
+
+void CaptureStream::FlushRun() {
+    if (run_frames_.empty()) {
+        return;
+    }
+    const GateFrameInfo& head = run_frames_.front();
+    CaptureChunkInfo run_first{head.host_time, head.sample_index, static_cast<uint32_t>(run_samples_.size())};
+    std::vector<float>* vad = new std::vector<float>(run_frames_.size());
+    for (size_t i = 0; i < run_frames_.size(); ++i) {
+        (*vad)[i] = run_frames_[i].probability;
+    }
+    Deliver(run_samples_.data(), run_samples_.size(), run_first, vad);
+    run_samples_.clear();
+    run_frames_.clear();
+}
+
+// Consumer thread. A falling-behind transport gates harder, in even steps
+// per pressure level, so that less silence and doubtful speech compete for
+// its uplink; the option's limits come back with the pressure
+void CaptureStream::TightenGate(int pressure) {
+    if (pressure == gate_pressure_) {
+        return;
+    }
+    gate_pressure_ = pressure;
+    const double step = static_cast<double>(pressure) / kMaxTransportPressure;
+    const float base = options_.gate_threshold;
+    const float threshold = base + static_cast<float>(step) * std::max(0.0f, kCongestedGateThreshold - base);
+    const double hangover_ms = options_.gate_hangover_ms * (1.0 - step * (1.0 - kCongestedHangoverFraction));
+    gate_->SetLimits(threshold, static_cast<size_t>(hangover_ms / 10.0));
+}
+
+// Delivers "silence of N ms" for the frames dropped since the last marker,
+// so consumers can keep time (or keep provider sockets alive) without audio
+void CaptureStream::EmitSilenceMarker() {
+    GateFrameInfo first{};
+    size_t frames = gate_->TakeSuppressed(&first);
+    if (frames == 0) {
+        return;
+    }
+    stats_.frames_gated.fetch_add(frames, std::memory_order_relaxed);
+    if (silence_marker_frames_ == 0) {
+        return;
+    }
+    CaptureChunkInfo marker{first.host_time, first.sample_index, 0};
+    Emit(frame_.data(), 0, marker, new std::vector<float>(), frames * 10.0);
+}
+
+// Delivers a sample-less marker at |event|'s frame. It always goes to the
+// callback, so with a shared ring or a transport it is timed by its position
+// rather than by the order it arrives in among the audio.
+void CaptureStream::EmitEndpoint(const EndpointEvent& event) {
+    if (!tsfn_) {
+        return;
+    }
+    CaptureDelivery* data = new CaptureDelivery{
+        nullptr, nullptr, nullptr, slab_pool_, options_.pcm16, options_.node_buffer, 0,
+        clock_->ToDateNowMs(event.at.host_time),
+        clock_->HostTimeMs(event.at.host_time),
+        static_cast<double>(event.at.sample_index)};
+    if (options_.pcm16) {
+        data->pcm = new std::vector<int16_t>();
+    } else {
+        data->samples = new std::vector<float>();
+    }
+    data->endpoint = event.type;
+    if (event.type == EndpointType::kSpeechStart) {
+        utterance_begin_ = event.at.sample_index;
+    } else if (prosody_) {
+        data->prosody = new UtteranceProsody(prosody_->Summarize(utterance_begin_, event.at.sample_index));
+        if (talk_party_ != TalkParty::kNone && IsTalkAnalyticsRunning()) {
+            AddTalkQuestion(talk_party_, clock_->HostTimeMs(event.at.host_time), data->prosody->question_likelihood);
+        }
+    }
+    Enqueue(data);
+}
+
+// Consumer thread. Moves published talk states into the lookup window, so
+// the ring never fills whether or not anything looks them up
+void CaptureStream::DrainTalk() {
+    TalkFrame incoming;
+    while (talk_ring_.Read(&incoming, 1) == 1) {
+        talk_frames_.push_back(incoming);
+        if (talk_frames_.size() > kTalkFrames) {
+            talk_frames_.pop_front();
+        }
+    }
+}
+
+// Consumer thread. The talk frame of the step nearest |host_time| (the
+// resampler shifts frames by a fraction of one), or unknown when none is
+// within a step of it
+TalkFrame CaptureStream::TalkFrameAt(uint64_t host_time) {
+    DrainTalk();
+    const uint64_t half_step = clock_->MsToTicks(5.0);
+    auto after = std::upper_bound(talk_frames_.begin(), talk_frames_.end(), host_time + half_step,
+                                  [](uint64_t host, const TalkFrame& frame) { return host < frame.host_time; });
+    if (after == talk_frames_.begin()) {
+        return TalkFrame{host_time, TalkState::kUnknown};
+    }
+    const TalkFrame& frame = *(after - 1);
+    if (frame.host_time + 3 * half_step < host_time) {
+        return TalkFrame{host_time, TalkState::kUnknown};
+    }
+    return frame;
+}
+
+// Consumer thread. Appends the talk state of each 10ms frame that completes
+// in the |num_samples| delivered from |first|, as levels counts its frames
+void CaptureStream::AppendTalk(const CaptureChunkInfo& first, size_t num_samples, std::vector<uint8_t>* talk) {
+    const size_t frame = static_cast<size_t>(output_sample_rate_ / 100.0);
+    const size_t total = talk_fill_ + num_samples;
+    talk->reserve(total / frame);
+    for (size_t end = frame; end <= total; end += frame) {
+        // A frame begun in the previous delivery starts before |first|
+        double start_ms = (static_cast<double>(end - frame) - static_cast<double>(talk_fill_)) * 1000.0 /
+                          output_sample_rate_;
+        uint64_t host_time = start_ms >= 0.0
+            ? first.host_time + clock_->MsToTicks(start_ms)
+            : first.host_time - std::min(first.host_time, clock_->MsToTicks(-start_ms));
+        talk->push_back(static_cast<uint8_t>(TalkAt(host_time)));
+    }
+    talk_fill_ = total % frame;
+}
+
+// Consumer thread. One FrameMetadata per 10ms frame |data| completes, from
+// the levels, VAD and talk states it was analyzed with; framed as levels is,
+// so the rows line up with its frames
+void CaptureStream::AppendMetadata(const CaptureChunkInfo& first, size_t num_samples, CaptureDelivery* data) {
+    const size_t frame = static_cast<size_t>(output_sample_rate_ / 100.0);
+    const size_t total = metadata_fill_ + num_samples;
+    const size_t frames = std::min(total / frame, level_values_.size() / kLevelFields);
+    data->metadata = new std::vector<FrameMetadata>();
+    data->metadata->reserve(frames);
+    for (size_t k = 0; k < frames; ++k) {
+        double start_ms = (static_cast<double>(k * frame) - static_cast<double>(metadata_fill_)) * 1000.0 /
+                          output_sample_rate_;
+        uint64_t host_time = start_ms >= 0.0
+            ? first.host_time + clock_->MsToTicks(start_ms)
+            : first.host_time - std::min(first.host_time, clock_->MsToTicks(-start_ms));
+        const TalkFrame talk = TalkFrameAt(host_time);
+        const float* levels = level_values_.data() + k * kLevelFields;
+        data->metadata->push_back(FrameMetadata{
+            static_cast<double>(metadata_frames_++),
+            clock_->HostTimeMs(host_time),
+            levels[0],
+            levels[1],
+            data->vad && k < data->vad->size() ? (*data->vad)[k] : 0.0f,
+            talk.echo_reduction_db,
+            talk.state,
+            levels[1] >= kClippedPeak});
+    }
+    metadata_fill_ = total % frame;
+}
+
+// Delivers the samples the producer never wrote between |sample_index| and
+// |resumed|, as a silence marker at the output rate
+void CaptureStream::EmitGapMarker(uint64_t sample_index, const CaptureChunkInfo& resumed) {
+    double gap_ms = (resumed.sample_index - sample_index) * 1000.0 / sample_rate_;
+    uint64_t gap_host = resumed.host_time - std::min(resumed.host_time, clock_->MsToTicks(gap_ms));
+    const double ratio = output_sample_rate_ / sample_rate_;
+    CaptureChunkInfo marker{gap_host, static_cast<uint64_t>(sample_index * ratio), 0};
+    Emit(nullptr, 0, marker, nullptr, gap_ms);
+}
+
+// JS thread. Hands one delivery to |jsCallback| and disposes it
+static void DispatchDelivery(Napi::Env env, Napi::Function jsCallback, CaptureDelivery* data) {
+    uint64_t dispatch_host = HostTimeNow();
+    TraceScope trace(TraceEvent::kJsDelivery, static_cast<int64_t>(data->num_samples));
+    try {
+        Napi::TypedArray samplesArray = MakeDeliveryArray(env, data);
+
+        // (samples, timestamp, sampleIndex, hostTimeMs), all for the first
+        // sample, then the per-frame speech probabilities when vad is on,
+        // silenceMs for gate markers (empty samples), the packed per-frame
+        // levels when levels is on, 'start' or 'end' for endpoint markers
+        // (empty samples), the per-frame talk states when talk is on, on end
+        // markers with endpoint.prosody the utterance's prosody, and per
+        // second completed its AudioClass when classify is on and its local
+        // speaker ID when speakers is on, then the per-frame metadata block
+        // when metadata is on.
+        // Arguments run up to the last one present, undefined in between;
+        // the vad slot is always an array.
+        std::vector<napi_value> args = {
+            samplesArray,
+            Napi::Number::New(env, data->timestamp),
+            Napi::Number::New(env, data->sample_index),
+            Napi::Number::New(env, data->host_time_ms)
+        };
+        bool marker = data->silence_ms > 0.0;
+        bool endpoint = data->endpoint != EndpointType::kNone;
+        int trailing = data->metadata ? 9 : data->speakers ? 8 : data->classes ? 7 : data->prosody ? 6 : data->talk ? 5 : endpoint ? 4
+            : data->levels ? 3 : marker ? 2 : data->vad ? 1 : 0;
+        if (trailing >= 1) {
+            size_t frames = data->vad ? data->vad->size() : 0;
+            Napi::Float32Array vadArray = Napi::Float32Array::New(env, marker ? 0 : frames);
+            if (!marker && frames > 0) {
+                std::copy(data->vad->begin(), data->vad->end(), vadArray.Data());
+            }
+            args.push_back(vadArray);
+        }
+        if (trailing >= 2) {
+            args.push_back(marker ? Napi::Number::New(env, data->silence_ms) : env.Undefined());
+        }
+        if (trailing >= 3) {
+            if (data->levels) {
+                Napi::Float32Array levelsArray = Napi::Float32Array::New(env, data->levels->size());
+                std::copy(data->levels->begin(), data->levels->end(), levelsArray.Data());
+                args.push_back(levelsArray);
+            } else {
+                args.push_back(env.Undefined());
+            }
+        }
+        if (trailing >= 4) {
+            args.push_back(endpoint
+                ? Napi::String::New(env, data->endpoint == EndpointType::kSpeechStart ? "start" : "end")
+                : env.Undefined());
+        }
+        if (trailing >= 5) {
+            if (data->talk) {
+                Napi::Uint8Array talkArray = Napi::Uint8Array::New(env, data->talk->size());
+                std::copy(data->talk->begin(), data->talk->end(), talkArray.Data());
+                args.push_back(talkArray);
+            } else {
+                args.push_back(env.Undefined());
+            }
+        }
+        if (trailing >= 6) {
+            if (data->prosody) {
+                const UtteranceProsody& prosody = *data->prosody;
+                Napi::Object prosodyObject = Napi::Object::New(env);
+                prosodyObject.Set("questionLikelihood", Napi::Number::New(env, prosody.question_likelihood));
+                prosodyObject.Set("endSlope", Napi::Number::New(env, prosody.end_slope));
+                prosodyObject.Set("endRise", Napi::Number::New(env, prosody.end_rise));
+                prosodyObject.Set("endEnergy", Napi::Number::New(env, prosody.end_energy));
+                prosodyObject.Set("voicedFrames", Napi::Number::New(env, prosody.voiced_frames));
+                args.push_back(prosodyObject);
+            } else {
+                args.push_back(env.Undefined());
+            }
+        }
+        if (trailing >= 7) {
+            if (data->classes) {
+                Napi::Uint8Array classesArray = Napi::Uint8Array::New(env, data->classes->size());
+                std::copy(data->classes->begin(), data->classes->end(), classesArray.Data());
+                args.push_back(classesArray);
+            } else {
+                args.push_back(env.Undefined());
+            }
+        }
+        if (trailing >= 8) {
+            if (data->speakers) {
+                Napi::Uint8Array speakersArray = Napi::Uint8Array::New(env, data->speakers->size());
+                std::copy(data->speakers->begin(), data->speakers->end(), speakersArray.Data());
+                args.push_back(speakersArray);
+            } else {
+                args.push_back(env.Undefined());
+            }
+        }
+        if (trailing >= 9) {
+            // Struct of arrays: row f of the block holds field f of every frame
+            const std::vector<FrameMetadata>& frames = *data->metadata;
+            const size_t count = frames.size();
+            Napi::Float64Array block = Napi::Float64Array::New(env, count * kMetadataFields);
+            double* rows = block.Data();
+            for (size_t i = 0; i < count; ++i) {
+                const FrameMetadata& frame = frames[i];
+                rows[i] = frame.frame_index;
+                rows[count + i] = frame.host_time_ms;
+                rows[2 * count + i] = frame.rms;
+                rows[3 * count + i] = frame.peak;
+                rows[4 * count + i] = frame.speech_probability;
+                rows[5 * count + i] = frame.echo_reduction_db;
+                rows[6 * count + i] = static_cast<double>(frame.talk);
+                rows[7 * count + i] = frame.clipped ? 1.0 : 0.0;
+            }
+            args.push_back(block);
+        }
+        if (data->trace) {
+            uint64_t js_host = HostTimeNow();
+            data->trace->Record(TraceStage::kDspToDispatch, TicksToNs(data->clock, data->dsp_host, dispatch_host));
+            data->trace->Record(TraceStage::kDispatchToJs, TicksToNs(data->clock, dispatch_host, js_host));
+            data->trace->Hold(static_cast<uint64_t>(data->sample_index), data->capture_host, js_host);
+        }
+        jsCallback.Call(args);
+    } catch (...) {
+        // Silently catch to prevent crash
+    }
+
+    DisposeDelivery(data);
+}
+
+// Consumer thread. Hands |num_samples| to JS as one delivery; |converted| is
+// the staged float data, or null to read straight from the ring. Takes
+// ownership of |vad|.
+void CaptureStream::Emit(const float* converted, size_t num_samples, const CaptureChunkInfo& out_first,
+                         std::vector<float>* vad, double silence_ms) {
+    if (shared_ring_) {
+        delete vad;
+        EmitShared(converted, num_samples, out_first, silence_ms);
+        return;
+    }
+    if (transport_ && num_samples > 0) {
+        delete vad;
+        EmitTransport(converted, num_samples, out_first);
+        return;
+    }
+    CaptureDelivery* data = new CaptureDelivery{
+        nullptr, nullptr, nullptr, slab_pool_, options_.pcm16, options_.node_buffer, static_cast<uint32_t>(num_samples),
+        clock_->ToDateNowMs(out_first.host_time),
+        clock_->HostTimeMs(out_first.host_time),
+        static_cast<double>(out_first.sample_index),
+        vad, silence_ms};
+
+    // With subscribers the audio is written once, into a payload every
+    // callback's array shares
+    const bool fan_out = num_samples > 0 && subscriber_count_.load(std::memory_order_acquire) > 0;
+    void* payload;
+    if (fan_out) {
+        data->shared = NewSharedPayload(slab_pool_,
+                                        num_samples * (options_.pcm16 ? sizeof(int16_t) : sizeof(float)));
+        payload = data->shared->data;
+    } else if (slab_pool_ && num_samples > 0 && num_samples <= slab_pool_->SlabSamples()) {
+        data->slab = slab_pool_->Acquire();
+        payload = data->slab;
+    } else if (options_.pcm16) {
+        data->pcm = new std::vector<int16_t>(num_samples);
+        payload = data->pcm->data();
+    } else {
+        data->samples = new std::vector<float>(num_samples);
+        payload = data->samples->data();
+    }
+    if (options_.pcm16) {
+        webrtc::FloatToS16(converted, num_samples, static_cast<int16_t*>(payload));
+    } else if (converted) {
+        memcpy(payload, converted, num_samples * sizeof(float));
+    } else {
+        ring_.Read(static_cast<float*>(payload), num_samples);
+    }
+
+    // Unframed VAD, levels, classes and speakers: values for the frames
+    // (seconds) this delivery completes; the float samples are in
+    // convert_buffer_ or, when nothing was staged, in the copy. All but the
+    // VAD follow the delivered audio, so with the gate the noise floor learns
+    // from pre-roll and hangover, and a second is a second of audio passed on.
+    const float* analyzed = converted ? converted : static_cast<const float*>(payload);
+    meter_.Add(analyzed, num_samples);
+    AddDeliveredSpectrum(analyzed, num_samples);
+    if (vad_ && !gate_ && !endpointer_) {
+        data->vad = new std::vector<float>();
+        data->vad->reserve(vad_->FramesFor(num_samples));
+        vad_->Process(analyzed, num_samples, data->vad);
+        if (talk_party_ != TalkParty::kNone && !data->vad->empty() && IsTalkAnalyticsRunning()) {
+            // The frames completed end within a frame of the delivery's end
+            const double end_ms = clock_->HostTimeMs(out_first.host_time) + num_samples * 1000.0 / output_sample_rate_;
+            AddTalkFrames(talk_party_, end_ms - 10.0 * data->vad->size(), data->vad->data(), data->vad->size());
+        }
+    }
+    if (levels_ && num_samples > 0) {
+        level_values_.clear();
+        levels_->Process(analyzed, num_samples, &level_values_);
+        if (options_.levels) {
+            data->levels = new std::vector<float>(level_values_);
+        }
+    }
+    if (options_.talk && num_samples > 0) {
+        data->talk = new std::vector<uint8_t>();
+        AppendTalk(out_first, num_samples, data->talk);
+    }
+    if (classifier_ && num_samples > 0) {
+        data->classes = new std::vector<uint8_t>();
+        classifier_->Process(analyzed, num_samples, data->vad, data->classes);
+    }
+    if (speaker_tracker_ && num_samples > 0) {
+        data->speakers = new std::vector<uint8_t>();
+        speaker_tracker_->Process(analyzed, num_samples, data->vad, data->speakers);
+    }
+    if (options_.metadata && num_samples > 0) {
+        AppendMetadata(out_first, num_samples, data);
+    }
+    if (num_samples > 0 && (fan_out || sink_count_.load(std::memory_order_acquire) > 0)) {
+        FanOut(data, analyzed);
+    }
+
+    if (!tsfn_) {
+        DisposeDelivery(data);
+        return;
+    }
+
+    if (num_samples > 0) {
+        data->trace = &trace_;
+        data->clock = clock_;
+        data->capture_host = out_first.host_time + clock_->MsToTicks(num_samples * 1000.0 / output_sample_rate_);
+        data->dsp_host = HostTimeNow();
+        if (last_enqueue_host_ != 0) {
+            trace_.Record(TraceStage::kEnqueueToDsp, TicksToNs(clock_, last_enqueue_host_, data->dsp_host));
+        }
+    }
+
+    Enqueue(data);
+}
+
+// Consumer thread. Emit() into the shared ring: the samples go straight into
+// its slots, and a delivery that does not fit is dropped whole (still read
+// out of the sample ring when it was never staged)
+void CaptureStream::EmitShared(const float* converted, size_t num_samples, const CaptureChunkInfo& out_first,
+                               double silence_ms) {
+    uint8_t* first = nullptr;
+    uint8_t* second = nullptr;
+    size_t first_samples = 0;
+    if (!shared_ring_->Reserve(num_samples, &first, &first_samples, &second)) {
+        stats_.deliveries_dropped.fetch_add(1, std::memory_order_relaxed);
+        float discard[256];
+        size_t left = converted ? 0 : num_samples;
+        while (left > 0) {
+            size_t read = ring_.Read(discard, std::min<size_t>(left, 256));
+            if (read == 0) {
+                break;
+            }
+            left -= read;
+        }
+        return;
+    }
+    const size_t second_samples = num_samples - first_samples;
+    if (options_.pcm16) {
+        webrtc::FloatToS16(converted, first_samples, reinterpret_cast<int16_t*>(first));
+        webrtc::FloatToS16(converted + first_samples, second_samples, reinterpret_cast<int16_t*>(second));
+    } else if (converted) {
+        memcpy(first, converted, first_samples * sizeof(float));
+        memcpy(second, converted + first_samples, second_samples * sizeof(float));
+    } else {
+        ring_.Read(reinterpret_cast<float*>(first), first_samples);
+        ring_.Read(reinterpret_cast<float*>(second), second_samples);
+    }
+    if (converted) {
+        meter_.Add(converted, num_samples);
+        AddDeliveredSpectrum(converted, num_samples);
+    } else {
+        meter_.Add(reinterpret_cast<const float*>(first), first_samples);
+        meter_.Add(reinterpret_cast<const float*>(second), second_samples);
+        AddDeliveredSpectrum(reinterpret_cast<const float*>(first), first_samples);
+        AddDeliveredSpectrum(reinterpret_cast<const float*>(second), second_samples);
+    }
+    shared_ring_->Commit(num_samples, SharedRingFrame{clock_->ToDateNowMs(out_first.host_time),
+                                                      clock_->HostTimeMs(out_first.host_time),
+                                                      static_cast<double>(out_first.sample_index), silence_ms});
+    stats_.deliveries.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Consumer thread. Emit() onto the transport; PCM16 always stages
+// the samples in |converted|, and the transport's queue bounds what it holds
+void CaptureStream::EmitTransport(const float* converted, size_t num_samples, const CaptureChunkInfo& out_first) {
+    if (transport_pcm_.size() < num_samples) {
+        transport_pcm_.resize(num_samples);
+        stats_.arena_overflow_bytes.store(arena_.OverflowBytes(), std::memory_order_relaxed);
+    }
+    webrtc::FloatToS16(converted, num_samples, transport_pcm_.data());
+    meter_.Add(converted, num_samples);
+    AddDeliveredSpectrum(converted, num_samples);
+    transport_->SendAudio(transport_pcm_.data(), num_samples, clock_->ToDateNowMs(out_first.host_time));
+    stats_.deliveries.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t CaptureStream::Subscribe(Napi::Env env, Napi::Function callback, const SubscriberOptions& options) {
+    if (!IsOpen()) {
+        return 0;
+    }
+    auto subscriber = std::make_shared<CaptureSubscriber>();
+    subscriber->id = g_next_subscriber_id.fetch_add(1, std::memory_order_relaxed);
+    subscriber->tsfn = Napi::ThreadSafeFunction::New(env, callback, name_ + " subscriber", 0, 1);
+    subscriber->options = options;
+
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    subscribers_.push_back(subscriber);
+    subscriber_count_.store(subscribers_.size(), std::memory_order_release);
+    return subscriber->id;
+}
+
+bool CaptureStream::Unsubscribe(uint64_t id) {
+    std::shared_ptr<CaptureSubscriber> subscriber;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        auto it = std::find_if(subscribers_.begin(), subscribers_.end(),
+                               [id](const std::shared_ptr<CaptureSubscriber>& s) { return s->id == id; });
+        if (it == subscribers_.end()) {
+            return false;
+        }
+        subscriber = *it;
+        subscribers_.erase(it);
+        subscriber_count_.store(subscribers_.size(), std::memory_order_release);
+        // A pending wake finds nothing
+        for (CaptureDelivery* data : subscriber->queue) {
+            DisposeDelivery(data);
+        }
+        subscriber->queue.clear();
+    }
+    subscriber->tsfn.Release();
+    return true;
+}
+
+void CaptureStream::AddSink(CaptureSink* sink) {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    sinks_.push_back(sink);
+    sink_count_.store(sinks_.size(), std::memory_order_release);
+}
+
+void CaptureStream::RemoveSink(CaptureSink* sink) {
+    std::lock_guard<std::mutex> lock(sink_mutex_);
+    sinks_.erase(std::remove(sinks_.begin(), sinks_.end(), sink), sinks_.end());
+    sink_count_.store(sinks_.size(), std::memory_order_release);
+}
+
+void CaptureStream::AddDeliveredSpectrum(const float* samples, size_t num_samples) {
+    if (!verifier_) {
+        spectrum_.Add(samples, num_samples, static_cast<int>(output_sample_rate_));
+    }
+}
+
+// Consumer thread. Hands |data|'s audio to the sinks, and a delivery sharing
+// its payload to each subscriber, whose own bound and policy make room. A
+// subscriber that coalesces copies only its own deliveries.
+void CaptureStream::FanOut(const CaptureDelivery* data, const float* samples) {
+    if (sink_count_.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        for (CaptureSink* sink : sinks_) {
+            sink->OnCaptureAudio(samples, data->num_samples, data->sample_index, data->host_time_ms);
+        }
+    }
+    if (!data->shared) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    for (const std::shared_ptr<CaptureSubscriber>& subscriber : subscribers_) {
+        CaptureDelivery* copy = new CaptureDelivery{
+            nullptr, nullptr, nullptr, nullptr, data->pcm16, data->node_buffer, data->num_samples,
+            data->timestamp, data->host_time_ms, data->sample_index};
+        copy->shared = RetainPayload(data->shared);
+
+        std::deque<CaptureDelivery*>& queue = subscriber->queue;
+        if (queue.size() >= subscriber->options.max_queued) {
+            if (subscriber->options.overload_policy == OverloadPolicy::kCoalesce &&
+                CoalesceDelivery(queue.back(), copy)) {
+                stats_.subscriber_coalesced.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            DisposeDelivery(queue.front());
+            queue.pop_front();
+            stats_.subscriber_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        queue.push_back(copy);
+        stats_.subscriber_deliveries.fetch_add(1, std::memory_order_relaxed);
+        if (!subscriber->wake_pending) {
+            WakeSubscriber(subscriber);
+        }
+    }
+}
+
+// Under queue_mutex_, so Unsubscribe() and Close() cannot release the TSFN
+// in between. A refused wake leaves the queue for the next one.
+void CaptureStream::WakeSubscriber(const std::shared_ptr<CaptureSubscriber>& subscriber) {
+    subscriber->wake_pending = true;
+    napi_status status = subscriber->tsfn.NonBlockingCall(
+        this, [subscriber](Napi::Env env, Napi::Function jsCallback, CaptureStream* stream) {
+            stream->DrainSubscriber(env, jsCallback, subscriber.get());
+        });
+    if (status != napi_ok) {
+        stats_.tsfn_rejections.fetch_add(1, std::memory_order_relaxed);
+        subscriber->wake_pending = false;
+    }
+}
+
+// JS thread. Dispatches everything |subscriber| has queued, in order
+void CaptureStream::DrainSubscriber(Napi::Env env, Napi::Function callback, CaptureSubscriber* subscriber) {
+    std::vector<CaptureDelivery*> batch;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        batch.assign(subscriber->queue.begin(), subscriber->queue.end());
+        subscriber->queue.clear();
+        subscriber->wake_pending = false;
+    }
+    for (CaptureDelivery* data : batch) {
+        DispatchDelivery(env, callback, data);
+    }
+}
+
+// Consumer thread. Queues |data| for the JS thread; at the bound the overload
+// policy makes room first
+void CaptureStream::Enqueue(CaptureDelivery* data) {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    data->session = session_;
+
+    if (queue_.size() >= options_.max_queued) {
+        switch (options_.overload_policy) {
+            case OverloadPolicy::kBlock:
+                // Close() stops the consumer before it waits for the JS
+                // thread, so stop holding once consumer_running_ drops
+                stats_.consumer_blocks.fetch_add(1, std::memory_order_relaxed);
+                while (queue_.size() >= options_.max_queued && consumer_running_) {
+                    lock.unlock();
+                    drained_.WaitFor(kBlockPollNs);
+                    lock.lock();
+                }
+                break;
+            case OverloadPolicy::kCoalesce:
+                // A wake is already pending for the delivery merged into
+                if (CoalesceDelivery(queue_.back(), data)) {
+                    stats_.deliveries_coalesced.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                // A silence marker: fall back to dropping the oldest
+                [[fallthrough]];
+            case OverloadPolicy::kDropOldest:
+                DisposeDelivery(queue_.front());
+                queue_.pop_front();
+                stats_.deliveries_dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+        }
+    }
+
+    queue_.push_back(data);
+    stats_.deliveries.fetch_add(1, std::memory_order_relaxed);
+    uint32_t queued = static_cast<uint32_t>(queue_.size());
+    if (queued > stats_.queue_peak.load(std::memory_order_relaxed)) {
+        stats_.queue_peak.store(queued, std::memory_order_relaxed);
+    }
+    bool wake = !wake_pending_;
+    wake_pending_ = true;
+    uint64_t session = session_;
+    lock.unlock();
+
+    if (wake) {
+        Wake(session);
+    }
+}
+
+// Consumer thread, or the JS thread in Close(). A refused wake leaves the
+// queue for the next delivery's wake to pick up.
+void CaptureStream::Wake(uint64_t session) {
+    napi_status status = tsfn_.NonBlockingCall(this, [session](Napi::Env env, Napi::Function jsCallback,
+                                                               CaptureStream* stream) {
+        stream->Drain(env, jsCallback, session);
+    });
+    if (status != napi_ok) {
+        stats_.tsfn_rejections.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (session == session_) {
+            wake_pending_ = false;
+        }
+    }
+}
+
+// JS thread. Takes every queued delivery of |session| (they are all at the
+// front) and dispatches them in order
+void CaptureStream::Drain(Napi::Env env, Napi::Function callback, uint64_t session) {
+    std::vector<CaptureDelivery*> batch;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        while (!queue_.empty() && queue_.front()->session == session) {
+            batch.push_back(queue_.front());
+            queue_.pop_front();
+        }
+        if (session == session_) {
+            wake_pending_ = false;
+        }
+    }
+    drained_.Signal();
+
+    for (CaptureDelivery* data : batch) {
+        DispatchDelivery(env, callback, data);
+    }
+}
+
+} // namespace kakarot
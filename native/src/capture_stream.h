@@ -0,0 +1,465 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audio_history.h"
+#include "capture_stats.h"
+#include "endpointer.h"
+#include "host_time.h"
+#include "latency_trace.h"
+#include "level_meter.h"
+#include "memory_pressure.h"
+#include "platform_thread.h"
+#include "session_arena.h"
+#include "silence_gate.h"
+#include "slab_pool.h"
+#include "spectral_analyzer.h"
+#include "spsc_ring_buffer.h"
+#include "talk_analytics.h"
+#include "talk_detector.h"
+#include "voice_verifier.h"
+
+namespace webrtc {
+class PushSincResampler;
+}
+
+namespace kakarot {
+
+class AECProcessor;
+class AudioClassifier;
+class AudioTransport;
+class ChunkAssembler;
+class KeystrokeSuppressor;
+class NeuralDenoiser;
+class ProsodyTracker;
+class LevelAnalyzer;
+class SharedRingWriter;
+class SpeakerTracker;
+class VoiceActivityDetector;
+struct CaptureDelivery;
+struct CaptureSubscriber;
+
+// Describes one real-time buffer stored in the sample ring
+struct CaptureChunkInfo {
+    uint64_t host_time;      // mach host time of the first sample
+    uint64_t sample_index;   // running sample counter since capture start
+    uint32_t num_samples;
+    uint64_t enqueue_host = 0;  // host time of the ring write (latency trace)
+};
+
+// The echo canceller's talk state of one 10ms step
+struct TalkFrame {
+    uint64_t host_time;  // of the step's first sample
+    TalkState state;
+    float echo_reduction_db = 0.0f;  // TalkDetector::EchoReductionDb()
+};
+
+// Rows of the metadata option's block, one value per 10ms frame in each:
+// frame index, host time (ms), rms, peak, speech probability, echo reduction
+// (dB), TalkState, clipped (1) or not (0)
+static constexpr size_t kMetadataFields = 8;
+
+// What gives when deliveries back up behind a stalled JS thread. Only the
+// consumer thread ever waits; the real-time producer never does.
+enum class OverloadPolicy {
+    kDropOldest,  // discard the oldest queued delivery
+    kCoalesce,    // append to the newest queued delivery (one larger callback)
+    kBlock,       // hold the consumer thread; the ring absorbs, then drops
+};
+
+// How the microphone reads its device (macOS, and kCommunications on Windows)
+enum class MicEngine {
+    kHal,              // HAL IOProc in the device's own format; conversion is ours
+    kAuhal,            // AUHAL input callback; CoreAudio converts to the format we ask for
+    kVoiceProcessing,  // VoiceProcessingIO: AEC, AGC and NS in the system audio server
+    kCommunications,   // WASAPI communications mode: the endpoint's own AEC, where it has one
+};
+
+// Options accepted by start*Capture(callback, options)
+struct CaptureOptions {
+    bool zero_copy = false;
+    double delivery_interval_ms = 0.0;
+    bool processed = false;   // mic only: deliver the natively echo-cancelled stream
+    bool shared_clock = false;  // system only (macOS): mic rides the tap's aggregate clock
+    // System only (macOS): tap just these apps' output, by bundle ID prefix
+    // or PID; both empty = every process
+    std::vector<std::string> tap_bundle_ids;
+    std::vector<int32_t> tap_pids;
+    uint32_t io_buffer_frames = 0;  // mic only (macOS): HAL IO buffer to request; 0 = device default
+    // Mic only (macOS). With kVoiceProcessing the native AEC is bypassed and
+    // processed is ignored; likewise with kCommunications (Windows) when the
+    // endpoint's AEC runs
+    MicEngine engine = MicEngine::kHal;
+    uint32_t ducking_level = 0;  // kVoiceProcessing: AUVoiceIOOtherAudioDuckingLevel; 0 = system default
+    // Mic only (macOS): device channels, 0-based across its input streams,
+    // mixed into the mono capture; empty = all of them
+    std::vector<int> input_channels;
+    // Mic only (macOS, hal engine): delay-and-sum those channels steered at
+    // the talker instead of averaging them
+    bool beamform = false;
+    double output_sample_rate = 0.0;  // 0 = the stream's own rate
+    bool pcm16 = false;               // deliver 16-bit PCM instead of Float32Array
+    bool node_buffer = false;         // pcm16 as a little-endian Node Buffer, not an Int16Array
+    bool vad = false;                 // add per-10ms speech probabilities to each delivery
+    bool levels = false;              // add per-10ms rms/peak/noise floor/speech to each delivery
+    bool classify = false;            // add the AudioClass of each second completed (implies vad)
+    bool speakers = false;            // add the local speaker ID of each second completed (implies vad)
+    bool metadata = false;            // add a kMetadataFields block per 10ms frame to each delivery (implies vad)
+    double chunk_ms = 0.0;            // fixed-length deliveries (10ms multiple); 0 = as batched
+    bool enhance = false;             // NS, AGC2 and high-pass on the consumer thread (system audio)
+    bool declick = false;             // duck keystrokes on the consumer thread, ahead of the VAD
+    std::string denoise_model;        // a DenoiserModel file: neural denoising at 48kHz, likewise
+
+    // Mic only, with processed: a TalkState per 10ms frame of each delivery,
+    // from the echo canceller. Far-end-only frames (echo) then count as
+    // non-speech for the gate and the endpointer.
+    bool talk = false;
+
+    // Mic only, with gate or endpoint: frames whose speech is not the
+    // enrolled user's count as non-speech for them (and the gate's pre-roll
+    // grows to VoiceVerifier::kPrerollMs); |voiceprint| is the user's, or
+    // null until an enrollment makes one
+    bool verify_voice = false;
+    std::shared_ptr<const Voiceprint> voiceprint;
+
+    // sharedRing: deliveries are written into this SharedArrayBuffer ring
+    // rather than passed to the callback; its header sets the format, and
+    // vad and levels are not carried
+    std::shared_ptr<SharedRingWriter> shared_ring;
+
+    // transport: audio is sent as PCM16 to this socket, on-device
+    // transcriber or interleaver channel from the consumer thread rather than passed to the
+    // callback, which still gets silence markers; vad and levels are not
+    // carried
+    std::shared_ptr<AudioTransport> transport;
+
+    // Silence gate (implies vad): only speech frames are delivered; with a
+    // transport, its threshold rises and hangover shrinks under the
+    // transport's Pressure()
+    bool gate = false;
+    float gate_threshold = 0.5f;      // speech probability that opens the gate
+    double gate_hangover_ms = 500.0;  // non-speech kept after speech ends
+    double gate_preroll_ms = 200.0;   // audio replayed before a speech onset
+    double silence_marker_ms = 1000.0;  // marker cadence while closed; 0 = none
+
+    // Endpointing (implies vad): sample-less start-of-speech and
+    // end-of-utterance markers go to the callback in every delivery mode, and
+    // with chunkMs a chunk ends at each utterance end
+    bool endpoint = false;
+    float endpoint_threshold = 0.5f;
+    double endpoint_min_speech_ms = 100.0;        // speech needed to start an utterance
+    double endpoint_trailing_silence_ms = 600.0;  // silence that ends it
+    bool prosody = false;  // end markers carry the utterance ending's UtteranceProsody
+
+    // history: true, or { seconds, bitrate }: the last |history_seconds| of
+    // the stream after enhancement and resampling, gate or not, kept as Opus
+    // for readHistory(); 0 = none
+    double history_seconds = 0.0;
+    int history_bitrate = 24000;
+
+    // Deliveries queued for the JS thread before overload_policy applies
+    uint32_t max_queued = 32;
+    OverloadPolicy overload_policy = OverloadPolicy::kCoalesce;
+};
+
+// Parses the JS options object; missing or mistyped fields keep their defaults
+CaptureOptions ParseCaptureOptions(const Napi::Value& value);
+
+// Options accepted by subscribeCapture(stream, callback, options). kBlock is
+// not offered: holding the consumer for one subscriber would stall the rest.
+struct SubscriberOptions {
+    uint32_t max_queued = 32;
+    OverloadPolicy overload_policy = OverloadPolicy::kDropOldest;
+};
+
+// Likewise; 'block' keeps the default
+SubscriberOptions ParseSubscriberOptions(const Napi::Value& value);
+
+// A native consumer of a stream's audio alongside its callbacks: called on
+// the consumer thread with each delivery's float samples (ahead of any PCM16
+// conversion). It must return quickly and not keep |samples|.
+class CaptureSink {
+public:
+    virtual ~CaptureSink() = default;
+    virtual void OnCaptureAudio(const float* samples, size_t num_samples, double sample_index,
+                                double host_time_ms) = 0;
+};
+
+// One captured stream (mic or system) on its way from a CoreAudio IOProc to a
+// JS callback: a preallocated SPSC ring filled on the real-time thread, a
+// consumer thread that drains and batches it, and a bounded delivery queue the
+// JS thread empties through a ThreadSafeFunction.
+class CaptureStream {
+public:
+    CaptureStream(const char* name, const HostClock* clock,
+                  size_t ring_samples, size_t ring_chunks);
+    ~CaptureStream();
+
+    CaptureStream(const CaptureStream&) = delete;
+    CaptureStream& operator=(const CaptureStream&) = delete;
+
+    // JS thread. Creates the TSFN and starts the consumer.
+    void Open(Napi::Env env, Napi::Function callback, const CaptureOptions& options,
+              double sample_rate);
+
+    // JS thread. The producer must already be stopped (AudioDeviceStop).
+    // Flushes pending samples, stops the consumer and releases the TSFN.
+    void Close();
+
+    bool IsOpen() const { return open_.load(std::memory_order_acquire); }
+
+    // JS thread, while open. A paused stream delivers nothing, so while
+    // |idle| its callback does not hold the event loop open
+    void SetIdle(Napi::Env env, bool idle);
+    double SampleRate() const { return sample_rate_; }
+
+    // Rate of the samples handed to JS (differs from SampleRate() when resampling)
+    double OutputSampleRate() const { return output_sample_rate_; }
+
+    // Health counters; reset on Open(). Producers record callback timing here.
+    CaptureStats& Stats() { return stats_; }
+    const CaptureStats& Stats() const { return stats_; }
+
+    // Peak/RMS of the delivered audio for startLevelMeter(); idle until enabled
+    LevelMeter& Meter() { return meter_; }
+
+    // Its spectrum, for startLevelMeter()'s spectrum option and native
+    // listeners; idle until either wants it. With a voice verifier it is
+    // of the framed audio ahead of the gate, which the verifier listens to.
+    SpectrumMeter& Spectrum() { return spectrum_; }
+
+    // JS thread, while open. The verifyVoice option's verifier; null without it
+    VoiceVerifier* Verifier() { return verifier_.get(); }
+
+    // JS thread. The history option's audio between two host times; kept
+    // from Open() until the next one, so what was heard stays readable
+    // after Close(). False with |error| without the option or such audio.
+    bool ReadHistory(uint64_t from_host, uint64_t to_host, bool encoded, HistoryRange* range,
+                     std::string* error) const;
+    uint64_t HistoryNewestHost() const { return history_ ? history_->NewestHost() : 0; }
+
+    // Per-stage latency of deliveries that carried audio; reset on Open()
+    const LatencyTrace& Trace() const { return trace_; }
+
+    // JS thread. Closes the trace of the delivery starting at |sample_index|
+    // once the caller has written it out (e.g. to a provider socket).
+    // Returns false when no such delivery is awaiting it.
+    bool MarkSent(uint64_t sample_index);
+
+    // Any thread, once the producer stopped for a pause. The consumer
+    // delivers what it holds, and the first buffer after the resume moves the
+    // sample counter over the paused time, so positions stay tied to real
+    // time and no chunk spans the gap.
+    void Pause();
+
+    // As Pause(), when the producer stopped without being asked (the device
+    // went away, the system slept). The resume also delivers a silence
+    // marker spanning the gap, so JS can tell lost time from what it heard.
+    void MarkGap();
+
+    // Any thread. Batches at least |interval_ms| per delivery, whatever
+    // deliveryIntervalMs asked for (fewer JS wake-ups on battery); 0 leaves
+    // the option alone. Kept across Open().
+    void SetMinDeliveryIntervalMs(double interval_ms);
+
+    // Any thread, before Open(). Puts the next session on a timeline shared
+    // with other streams: samples captured before |host_time| are discarded
+    // and sampleIndex counts from it, so index n is n / rate seconds after
+    // |host_time| on every stream armed with it. Taken by one Open(); 0 disarms.
+    void SetStartHost(uint64_t host_time) { start_host_.store(host_time, std::memory_order_relaxed); }
+
+    // JS thread, before Open(). Whose speech the stream's VAD frames and
+    // question endings count as in the meeting's talk analytics
+    // (startTalkAnalytics()); kNone (the default) leaves it out. They need
+    // the vad, gate or endpoint option, and questions endpoint.prosody.
+    void SetTalkParty(TalkParty party) { talk_party_ = party; }
+
+    // JS thread, while open. Another callback for the stream's audio
+    // deliveries, as (samples, timestamp, sampleIndex, hostTimeMs): every
+    // subscriber's array is a view of the same buffer as the stream's own
+    // callback (treat it as read-only), and each has its own queue and
+    // overload policy, so a slow one drops or coalesces only its own
+    // deliveries. Not fed while a shared ring or transport takes the
+    // deliveries. Lasts until Unsubscribe() or Close(); 0 when closed.
+    uint64_t Subscribe(Napi::Env env, Napi::Function callback, const SubscriberOptions& options);
+
+    // JS thread. Queued deliveries go unseen; false for an unknown |id|
+    bool Unsubscribe(uint64_t id);
+
+    // Any thread. |sink| is called for each audio delivery, open or not,
+    // until RemoveSink() returns
+    void AddSink(CaptureSink* sink);
+    void RemoveSink(CaptureSink* sink);
+
+    // Real-time thread: memcpy + atomic publish + semaphore signal only.
+    void PushFromRealtime(const float* data, uint32_t num_samples, uint64_t host_time);
+
+    // Echo canceller's DSP thread, ahead of the step's samples. Dropped
+    // unless the talk or metadata option is on.
+    void PushTalkState(uint64_t host_time, TalkState state, float echo_reduction_db);
+
+private:
+    uint64_t MemoryBytes();
+    void OnMemoryPressure(MemoryPressure pressure, const MemoryMinimums& minimums);
+    void PauseAt(uint64_t host_time);
+    void ConsumerLoop();
+    void OnChunkRead(const CaptureChunkInfo& chunk);
+    void DeliverSamples(size_t num_samples, const CaptureChunkInfo& first);
+    size_t ResampleFromRing(size_t num_samples, const CaptureChunkInfo& first,
+                            CaptureChunkInfo* out_first);
+    void DeliverFramed(const float* samples, size_t num_samples, const CaptureChunkInfo& first);
+    void TightenGate(int pressure);
+    void FlushRun();
+    void EmitSilenceMarker();
+    void EmitEndpoint(const EndpointEvent& event);
+    void DrainTalk();
+    TalkFrame TalkFrameAt(uint64_t host_time);
+    TalkState TalkAt(uint64_t host_time) { return TalkFrameAt(host_time).state; }
+    void AppendTalk(const CaptureChunkInfo& first, size_t num_samples, std::vector<uint8_t>* talk);
+    void AppendMetadata(const CaptureChunkInfo& first, size_t num_samples, CaptureDelivery* data);
+    void EmitGapMarker(uint64_t sample_index, const CaptureChunkInfo& resumed);
+    void Deliver(const float* samples, size_t num_samples, const CaptureChunkInfo& first,
+                 std::vector<float>* vad);
+    void FlushChunk();
+    void Emit(const float* converted, size_t num_samples, const CaptureChunkInfo& out_first,
+              std::vector<float>* vad, double silence_ms);
+    void EmitShared(const float* converted, size_t num_samples, const CaptureChunkInfo& out_first,
+                    double silence_ms);
+    void EmitTransport(const float* converted, size_t num_samples, const CaptureChunkInfo& out_first);
+    void Enqueue(CaptureDelivery* data);
+    void FanOut(const CaptureDelivery* data, const float* samples);
+    // Consumer thread. Delivered audio into spectrum_, unless the verifier's
+    // frames feed it
+    void AddDeliveredSpectrum(const float* samples, size_t num_samples);
+    void WakeSubscriber(const std::shared_ptr<CaptureSubscriber>& subscriber);
+    void DrainSubscriber(Napi::Env env, Napi::Function callback, CaptureSubscriber* subscriber);
+    void Wake(uint64_t session);
+    void Drain(Napi::Env env, Napi::Function callback, uint64_t session);
+
+    const std::string name_;
+    const HostClock* clock_;
+
+    SpscRingBuffer<float> ring_;
+    SpscRingBuffer<CaptureChunkInfo> chunk_ring_;
+    Semaphore signal_;
+    std::thread consumer_thread_;
+    std::atomic<bool> consumer_running_{false};
+    std::atomic<bool> open_{false};
+    std::atomic<bool> flush_requested_{false};  // Pause() -> consumer
+    std::atomic<uint64_t> paused_host_{0};      // Pause() -> producer; 0 = not paused
+    std::atomic<bool> gap_requested_{false};    // MarkGap() -> consumer
+    std::atomic<double> min_delivery_interval_ms_{0.0};
+
+    Napi::ThreadSafeFunction tsfn_;
+    bool tsfn_unrefed_ = false;  // JS thread
+    CaptureOptions options_;
+    double sample_rate_ = 48000.0;
+    double output_sample_rate_ = 48000.0;
+    SlabPool* slab_pool_ = nullptr;                  // set and cleared under memory_mutex_
+    std::mutex memory_mutex_;
+    std::shared_ptr<SharedRingWriter> shared_ring_;  // set while a ring takes the deliveries
+    std::shared_ptr<AudioTransport> transport_;      // likewise a socket or transcriber
+
+    // The session's fixed-size buffers, reserved by Open() and freed by
+    // Close() in one piece; declared ahead of the buffers it backs
+    SessionArena arena_;
+    ArenaVector<int16_t> transport_pcm_{ArenaAllocator<int16_t>(&arena_)};  // consumer thread: one delivery on its way out
+
+    // Consumer thread only. Resampling runs in 10ms blocks; a partial block
+    // carries over to the next delivery.
+    std::unique_ptr<webrtc::PushSincResampler> resampler_;
+    size_t input_block_ = 0;
+    size_t output_block_ = 0;
+    ArenaVector<float> resample_block_{ArenaAllocator<float>(&arena_)};
+    size_t resample_fill_ = 0;
+    uint64_t resample_block_host_ = 0;
+    uint64_t resample_block_index_ = 0;
+    ArenaVector<float> convert_buffer_{ArenaAllocator<float>(&arena_)};  // resampled or PCM16-pending samples
+    std::unique_ptr<AECProcessor> enhancer_;      // capture side only, at the stream rate
+    uint64_t enhancer_delay_ = 0;                 // its output latency, in host ticks
+    std::unique_ptr<NeuralDenoiser> denoiser_;    // at the stream rate, after the enhancer
+    uint64_t denoiser_delay_ = 0;                 // one frame of overlap, two when run framed
+    std::unique_ptr<KeystrokeSuppressor> declicker_;  // at the stream rate, after the denoiser
+    uint64_t declicker_delay_ = 0;                // without resampling it runs framed: one frame
+    std::unique_ptr<VoiceActivityDetector> vad_;  // on the delivered (output-rate) samples
+    std::unique_ptr<LevelAnalyzer> levels_;       // likewise, with levels or metadata
+    std::vector<float> level_values_;             // its packed frames of the delivery at hand
+    std::unique_ptr<AudioClassifier> classifier_;  // likewise, on the VAD's probabilities
+    std::unique_ptr<SpeakerTracker> speaker_tracker_;  // likewise
+    std::unique_ptr<VoiceVerifier> verifier_;     // likewise, after the talk check
+    std::unique_ptr<AudioHistory> history_;       // on the output-rate samples, ahead of the gate; set under memory_mutex_
+
+    // Consumer thread only. The gate and the endpointer work on whole 10ms
+    // frames; a partial frame carries over, and the run of frames passed on
+    // is delivered at the end of each batch, when the gate closes or at an
+    // endpoint.
+    std::unique_ptr<SilenceGate> gate_;
+    std::unique_ptr<Endpointer> endpointer_;
+    std::unique_ptr<ProsodyTracker> prosody_;     // with endpoint and prosody
+    uint64_t utterance_begin_ = 0;                // sample index of the last speech start
+    ArenaVector<float> frame_{ArenaAllocator<float>(&arena_)};
+    size_t frame_fill_ = 0;
+    uint64_t frame_host_ = 0;
+    uint64_t frame_index_ = 0;
+    std::vector<float> run_samples_;
+    std::vector<GateFrameInfo> run_frames_;
+    size_t silence_marker_frames_ = 0;
+    int gate_pressure_ = 0;  // the transport's, as the gate's limits last were set
+
+    // DSP thread -> consumer thread. Talk states are kept for as long as the
+    // gate's pre-roll can reach back, and looked up by host time.
+    SpscRingBuffer<TalkFrame> talk_ring_;
+    std::atomic<bool> talk_enabled_{false};
+    std::deque<TalkFrame> talk_frames_;
+    size_t talk_fill_ = 0;  // samples of a frame begun in the previous delivery
+
+    // Consumer thread only, with metadata: frames delivered so far, and the
+    // samples of one begun in the previous delivery
+    uint64_t metadata_frames_ = 0;
+    size_t metadata_fill_ = 0;
+
+    // Consumer thread only. With chunkMs, deliveries are assembled here into
+    // fixed-length chunks timed from the sample counter.
+    std::unique_ptr<ChunkAssembler> chunker_;
+
+    // Consumer thread -> JS thread. The TSFN carries only a wake-up; each
+    // dispatch drains its session's deliveries, so a stalled JS thread finds
+    // at most max_queued of them rather than an unbounded backlog.
+    std::mutex queue_mutex_;
+    std::deque<CaptureDelivery*> queue_;
+    bool wake_pending_ = false;
+    uint64_t session_ = 0;           // bumped by Open(); a late drain takes only its own
+    Semaphore drained_;              // signalled by each drain, for kBlock
+    std::vector<std::shared_ptr<CaptureSubscriber>> subscribers_;  // each with its queue
+    std::atomic<size_t> subscriber_count_{0};  // read by the consumer without the lock
+
+    // Any thread -> consumer thread; held while the sinks are called
+    std::mutex sink_mutex_;
+    std::vector<CaptureSink*> sinks_;
+    std::atomic<size_t> sink_count_{0};
+
+    CaptureStats stats_;
+    LatencyTrace trace_;
+    LevelMeter meter_;
+    SpectrumMeter spectrum_;
+    uint64_t last_enqueue_host_ = 0;  // consumer thread: newest buffer read
+
+    std::atomic<uint64_t> start_host_{0};  // SetStartHost() -> Open()
+    TalkParty talk_party_ = TalkParty::kNone;
+
+    // Written by the real-time thread only
+    uint64_t samples_captured_ = 0;
+    uint64_t align_host_ = 0;  // set by Open() before open_; cleared by the first buffer
+
+    // Last, so it is unregistered before anything it reports goes
+    MemoryComponent memory_;
+};
+
+} // namespace kakarot
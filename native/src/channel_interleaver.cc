@@ -0,0 +1,299 @@
+#include "channel_interleaver.h"
+#include "addon_common.h"
+#include "transcription_socket.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace kakarot {
+
+// A timestamp within this of where a channel ends continues it: clock
+// jitter, not a gap or an overlap
+static constexpr double kContiguousMs = 8.0;
+
+// Silence on both channels longer than this is skipped, not sent; the
+// output's timeline carries the jump
+static constexpr double kSkipSilenceMs = 1000.0;
+
+static constexpr double kDefaultMaxLagMs = 200.0;
+
+ChannelInterleaver::ChannelInterleaver(std::shared_ptr<AudioTransport> output, int sample_rate, double max_lag_ms)
+    : output_(std::move(output)),
+      sample_rate_(std::max(1000, sample_rate)),
+      max_lag_frames_(std::llround(std::max(0.0, max_lag_ms) * sample_rate_ / 1000.0)),
+      contiguous_frames_(std::llround(kContiguousMs * sample_rate_ / 1000.0)),
+      skip_frames_(std::llround(kSkipSilenceMs * sample_rate_ / 1000.0)) {
+    for (int i = 0; i < kChannels; ++i) {
+        inputs_[i].owner = this;
+        inputs_[i].index = i;
+    }
+}
+
+std::shared_ptr<AudioTransport> ChannelInterleaver::Channel(int index) {
+    if (index < 0 || index >= kChannels) {
+        return nullptr;
+    }
+    return std::shared_ptr<AudioTransport>(shared_from_this(), &inputs_[index]);
+}
+
+// Lock held
+int64_t ChannelInterleaver::PositionOf(double timestamp) const {
+    return std::llround((timestamp - origin_) * sample_rate_ / 1000.0);
+}
+
+// Lock held. Silence in channel |index| up to |position|
+void ChannelInterleaver::Pad(int index, int64_t position) {
+    Lane& lane = lanes_[index];
+    if (position <= lane.end) {
+        return;
+    }
+    lane.pending.insert(lane.pending.end(), static_cast<size_t>(position - lane.end), 0);
+    stats_.silence_frames[index] += static_cast<uint64_t>(position - lane.end);
+    lane.end = position;
+}
+
+void ChannelInterleaver::Push(int index, const int16_t* samples, size_t num_samples, double timestamp) {
+    if (index < 0 || index >= kChannels || num_samples == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Lane& lane = lanes_[index];
+    int64_t position = lane.end;
+    if (timestamp > 0.0) {
+        if (!has_origin_) {
+            has_origin_ = true;
+            origin_ = timestamp - out_ * 1000.0 / sample_rate_;
+        }
+        position = PositionOf(timestamp);
+        if (std::llabs(position - lane.end) <= contiguous_frames_) {
+            position = lane.end;
+        }
+    }
+
+    int64_t latest = 0;
+    for (const Lane& other : lanes_) {
+        latest = std::max(latest, other.end);
+    }
+    if (position - latest > skip_frames_) {
+        // Both silent: send what is held, then jump over the rest
+        for (int i = 0; i < kChannels; ++i) {
+            Pad(i, latest);
+        }
+        Emit();
+        stats_.skipped_frames += static_cast<uint64_t>(position - latest);
+        out_ = position;
+        for (Lane& other : lanes_) {
+            other.end = position;
+        }
+    } else {
+        Pad(index, position);
+    }
+
+    size_t skip = 0;
+    if (position < lane.end) {
+        skip = std::min(num_samples, static_cast<size_t>(lane.end - position));
+        stats_.dropped_frames[index] += skip;
+    }
+    lane.pending.insert(lane.pending.end(), samples + skip, samples + num_samples);
+    lane.end += static_cast<int64_t>(num_samples - skip);
+
+    // A channel this far behind is silent until it catches up
+    for (int i = 0; i < kChannels; ++i) {
+        Pad(i, lane.end - max_lag_frames_);
+    }
+    Emit();
+}
+
+void ChannelInterleaver::Flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t latest = 0;
+    for (const Lane& lane : lanes_) {
+        latest = std::max(latest, lane.end);
+    }
+    for (int i = 0; i < kChannels; ++i) {
+        Pad(i, latest);
+    }
+    Emit();
+}
+
+// Lock held, so the output sees frames in order. Sends what both channels have.
+void ChannelInterleaver::Emit() {
+    int64_t ready = lanes_[0].end;
+    for (const Lane& lane : lanes_) {
+        ready = std::min(ready, lane.end);
+    }
+    const size_t frames = ready > out_ ? static_cast<size_t>(ready - out_) : 0;
+    if (frames == 0) {
+        return;
+    }
+    interleaved_.resize(frames * kChannels);
+    for (int i = 0; i < kChannels; ++i) {
+        std::vector<int16_t>& pending = lanes_[i].pending;
+        for (size_t f = 0; f < frames; ++f) {
+            interleaved_[f * kChannels + i] = pending[f];
+        }
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(frames));
+    }
+    const double timestamp = has_origin_ ? origin_ + out_ * 1000.0 / sample_rate_ : 0.0;
+    out_ = ready;
+    stats_.frames_sent += frames;
+    output_->SendAudio(interleaved_.data(), interleaved_.size(), timestamp);
+}
+
+ChannelInterleaver::Stats ChannelInterleaver::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+namespace {
+
+// new ChannelInterleaver({ output, sampleRate?, maxLagMs? }): |output| is a
+// TranscriptionSocket opened with channels: 2 at the same sample rate
+class ChannelInterleaverWrap : public Napi::ObjectWrap<ChannelInterleaverWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "ChannelInterleaver", {
+            InstanceMethod("channel", &ChannelInterleaverWrap::GetChannel),
+            InstanceMethod("flush", &ChannelInterleaverWrap::Flush),
+            InstanceMethod("getStats", &ChannelInterleaverWrap::GetStats),
+        });
+    }
+
+    explicit ChannelInterleaverWrap(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<ChannelInterleaverWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsObject()) {
+            Napi::TypeError::New(env, "Expected { output, sampleRate?, maxLagMs? }").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = info[0].As<Napi::Object>();
+        std::shared_ptr<TranscriptionSocket> output = TranscriptionSocketFromValue(options.Get("output"));
+        if (!output) {
+            Napi::TypeError::New(env, "output must be a TranscriptionSocket").ThrowAsJavaScriptException();
+            return;
+        }
+        int sample_rate = 16000;
+        if (options.Get("sampleRate").IsNumber()) {
+            sample_rate = options.Get("sampleRate").As<Napi::Number>().Int32Value();
+        }
+        double max_lag_ms = kDefaultMaxLagMs;
+        if (options.Get("maxLagMs").IsNumber()) {
+            max_lag_ms = options.Get("maxLagMs").As<Napi::Number>().DoubleValue();
+        }
+        interleaver_ = std::make_shared<ChannelInterleaver>(std::move(output), sample_rate, max_lag_ms);
+    }
+
+    std::shared_ptr<ChannelInterleaver> Interleaver() const { return interleaver_; }
+
+private:
+    // channel(index) -> InterleaverChannel: 0 is the mic, 1 the system audio
+    Napi::Value GetChannel(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected a channel index").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        int index = info[0].As<Napi::Number>().Int32Value();
+        if (index < 0 || index >= ChannelInterleaver::kChannels) {
+            Napi::RangeError::New(env, "Channel index must be 0 or 1").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return GetAddonInstance(env)->interleaver_channel.New({Value(), info[0]});
+    }
+
+    Napi::Value Flush(const Napi::CallbackInfo& info) {
+        interleaver_->Flush();
+        return info.Env().Undefined();
+    }
+
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        ChannelInterleaver::Stats stats = interleaver_->GetStats();
+        Napi::Object result = Napi::Object::New(env);
+        Napi::Array silence = Napi::Array::New(env, ChannelInterleaver::kChannels);
+        Napi::Array dropped = Napi::Array::New(env, ChannelInterleaver::kChannels);
+        for (uint32_t i = 0; i < ChannelInterleaver::kChannels; ++i) {
+            silence.Set(i, Napi::Number::New(env, static_cast<double>(stats.silence_frames[i])));
+            dropped.Set(i, Napi::Number::New(env, static_cast<double>(stats.dropped_frames[i])));
+        }
+        result.Set("framesSent", Napi::Number::New(env, static_cast<double>(stats.frames_sent)));
+        result.Set("silenceFrames", silence);
+        result.Set("droppedFrames", dropped);
+        result.Set("skippedFrames", Napi::Number::New(env, static_cast<double>(stats.skipped_frames)));
+        return result;
+    }
+
+    std::shared_ptr<ChannelInterleaver> interleaver_;
+};
+
+// One channel of a ChannelInterleaver, from its channel(); a capture
+// stream's transport option, or sendAudio() for audio that arrives in JS
+class InterleaverChannelWrap : public Napi::ObjectWrap<InterleaverChannelWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "InterleaverChannel", {
+            InstanceMethod("sendAudio", &InterleaverChannelWrap::SendAudio),
+        });
+    }
+
+    explicit InterleaverChannelWrap(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<InterleaverChannelWrap>(info) {
+        Napi::Env env = info.Env();
+        AddonInstance* instance = GetAddonInstance(env);
+        if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber() || !instance ||
+            !info[0].As<Napi::Object>().InstanceOf(instance->channel_interleaver.Value())) {
+            Napi::TypeError::New(env, "Use ChannelInterleaver.channel()").ThrowAsJavaScriptException();
+            return;
+        }
+        transport_ = ChannelInterleaverWrap::Unwrap(info[0].As<Napi::Object>())->Interleaver()->Channel(
+            info[1].As<Napi::Number>().Int32Value());
+        if (!transport_) {
+            Napi::RangeError::New(env, "Channel index must be 0 or 1").ThrowAsJavaScriptException();
+        }
+    }
+
+    std::shared_ptr<AudioTransport> Transport() const { return transport_; }
+
+private:
+    // sendAudio(Int16Array, timestamp?)
+    Napi::Value SendAudio(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsTypedArray() ||
+            info[0].As<Napi::TypedArray>().TypedArrayType() != napi_int16_array) {
+            Napi::TypeError::New(env, "Expected an Int16Array").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Int16Array samples = info[0].As<Napi::Int16Array>();
+        double timestamp = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().DoubleValue() : 0.0;
+        transport_->SendAudio(samples.Data(), samples.ElementLength(), timestamp);
+        return env.Undefined();
+    }
+
+    std::shared_ptr<AudioTransport> transport_;
+};
+
+} // namespace
+
+Napi::Function DefineChannelInterleaver(Napi::Env env) {
+    Napi::Function constructor = ChannelInterleaverWrap::Define(env);
+    GetAddonInstance(env)->channel_interleaver = Napi::Persistent(constructor);
+    return constructor;
+}
+
+Napi::Function DefineInterleaverChannel(Napi::Env env) {
+    Napi::Function constructor = InterleaverChannelWrap::Define(env);
+    GetAddonInstance(env)->interleaver_channel = Napi::Persistent(constructor);
+    return constructor;
+}
+
+std::shared_ptr<AudioTransport> InterleaverChannelFromValue(const Napi::Value& value) {
+    Napi::Env env = value.Env();
+    AddonInstance* instance = GetAddonInstance(env);
+    if (!value.IsObject() || !instance || instance->interleaver_channel.IsEmpty() ||
+        !value.As<Napi::Object>().InstanceOf(instance->interleaver_channel.Value())) {
+        return nullptr;
+    }
+    return InterleaverChannelWrap::Unwrap(value.As<Napi::Object>())->Transport();
+}
+
+} // namespace kakarot
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <napi.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "audio_transport.h"
+
+namespace kakarot {
+
+// Merges two mono PCM16 streams, the processed mic and the system audio,
+// into one sample-aligned two-channel stream for a provider's multichannel
+// mode, so a meeting takes one connection instead of two. Each channel is an
+// AudioTransport a capture stream's transport option sends to; its samples
+// are placed on one clock by their Date.now() timestamps, a gap is filled
+// with silence and audio that overlaps what the channel already has is
+// dropped. Frames go out interleaved (channel 0 first) as soon as both
+// channels have them; a channel more than max_lag_ms behind the other is
+// silence-filled, so a stopped or gated stream does not hold the other
+// back, and silence on both for longer than a second is skipped rather than
+// sent. Both channels are at the output's sample rate. Thread-safe.
+class ChannelInterleaver : public std::enable_shared_from_this<ChannelInterleaver> {
+public:
+    static constexpr int kChannels = 2;
+
+    ChannelInterleaver(std::shared_ptr<AudioTransport> output, int sample_rate, double max_lag_ms);
+
+    ChannelInterleaver(const ChannelInterleaver&) = delete;
+    ChannelInterleaver& operator=(const ChannelInterleaver&) = delete;
+
+    // Channel |index| as a transport; keeps the interleaver alive
+    std::shared_ptr<AudioTransport> Channel(int index);
+
+    // Any thread. Mono samples; |timestamp| is the Date.now() time of the
+    // first, 0 to continue the channel's previous call
+    void Push(int index, const int16_t* samples, size_t num_samples, double timestamp);
+
+    // Sends what either channel holds, the other silence-filled to match;
+    // before the output closes
+    void Flush();
+
+    struct Stats {
+        uint64_t frames_sent;
+        uint64_t silence_frames[kChannels];  // filled in for gaps and lag
+        uint64_t dropped_frames[kChannels];  // overlapping or too late
+        uint64_t skipped_frames;             // silent on both, not sent
+    };
+    Stats GetStats() const;
+
+private:
+    class Input : public AudioTransport {
+    public:
+        void SendAudio(const int16_t* samples, size_t num_samples, double timestamp) override {
+            owner->Push(index, samples, num_samples, timestamp);
+        }
+        int Pressure() const override { return owner->output_->Pressure(); }
+
+        ChannelInterleaver* owner = nullptr;
+        int index = 0;
+    };
+
+    // Held audio of a channel: frames out_ to end, so pending.size() == end - out_
+    struct Lane {
+        std::vector<int16_t> pending;
+        int64_t end = 0;
+    };
+
+    int64_t PositionOf(double timestamp) const;
+    void Pad(int index, int64_t position);
+    void Emit();
+
+    const std::shared_ptr<AudioTransport> output_;
+    const int sample_rate_;
+    const int64_t max_lag_frames_;
+    const int64_t contiguous_frames_;
+    const int64_t skip_frames_;
+    std::array<Input, kChannels> inputs_;
+
+    mutable std::mutex mutex_;
+    bool has_origin_ = false;
+    double origin_ = 0.0;  // Date.now() time of frame 0
+    int64_t out_ = 0;      // next frame to send
+    std::array<Lane, kChannels> lanes_;
+    std::vector<int16_t> interleaved_;
+    Stats stats_{};
+};
+
+// The ChannelInterleaver and InterleaverChannel class exports; also
+// remembered in the env's AddonInstance, so a capture option can tell a
+// channel object apart
+Napi::Function DefineChannelInterleaver(Napi::Env env);
+Napi::Function DefineInterleaverChannel(Napi::Env env);
+
+// The transport behind an InterleaverChannel object; null for anything else
+std::shared_ptr<AudioTransport> InterleaverChannelFromValue(const Napi::Value& value);
+
+} // namespace kakarot
@@ -0,0 +1,44 @@
+#include "chunk_assembler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace kakarot {
+
+ChunkAssembler::ChunkAssembler(size_t chunk_samples, size_t frame_size)
+    : chunk_samples_(chunk_samples),
+      frame_size_(frame_size),
+      samples_(chunk_samples) {
+    frame_values_.reserve(chunk_samples / frame_size);
+}
+
+size_t ChunkAssembler::Append(const float* data, size_t num_samples, uint64_t host_time,
+                              uint64_t sample_index, const float* frame_values) {
+    if (ready_ || num_samples == 0) {
+        return 0;
+    }
+    if (fill_ > 0 && sample_index != start_index_ + fill_) {
+        ready_ = true;
+        return 0;
+    }
+    if (fill_ == 0) {
+        start_host_ = host_time;
+        start_index_ = sample_index;
+    }
+
+    size_t count = std::min(chunk_samples_ - fill_, num_samples);
+    memcpy(samples_.data() + fill_, data, count * sizeof(float));
+    if (frame_values) {
+        frame_values_.insert(frame_values_.end(), frame_values, frame_values + count / frame_size_);
+    }
+    fill_ += count;
+    ready_ = fill_ == chunk_samples_;
+    return count;
+}
+
+void ChunkAssembler::Clear() {
+    fill_ = 0;
+    ready_ = false;
+    frame_values_.clear();
+}
+
+} // namespace kakarot
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kakarot {
+
+// Cuts a delivered stream into fixed-size chunks inside one preallocated
+// buffer. Timing comes from the sample counter, not the wall clock: a chunk
+// starts at the host time of its first sample and ends exactly its length
+// later. A jump in the counter (dropped buffers, gated silence) closes the
+// partial chunk first, so every chunk is contiguous audio.
+class ChunkAssembler {
+public:
+    // |frame_size| divides |chunk_samples|; per-frame values (VAD
+    // probabilities) ride along with the samples they describe
+    ChunkAssembler(size_t chunk_samples, size_t frame_size);
+
+    // Copies up to a chunk's worth of |data| starting at |sample_index| /
+    // |host_time| and returns how many samples were taken. |frame_values|,
+    // when set, holds one value per frame of |data|. Returns 0 without taking
+    // anything when the input does not continue the pending chunk; Ready() is
+    // then true and the partial chunk must be taken first.
+    size_t Append(const float* data, size_t num_samples, uint64_t host_time, uint64_t sample_index,
+                  const float* frame_values);
+
+    // A full chunk, or a partial one cut short by a discontinuity
+    bool Ready() const { return ready_; }
+    bool Empty() const { return fill_ == 0; }
+
+    const float* Samples() const { return samples_.data(); }
+    size_t Size() const { return fill_; }
+    const std::vector<float>& FrameValues() const { return frame_values_; }
+    uint64_t StartHostTime() const { return start_host_; }
+    uint64_t StartSampleIndex() const { return start_index_; }
+
+    // Empties the chunk after it was delivered
+    void Clear();
+
+private:
+    const size_t chunk_samples_;
+    const size_t frame_size_;
+
+    std::vector<float> samples_;
+    std::vector<float> frame_values_;
+    size_t fill_ = 0;
+    bool ready_ = false;
+    uint64_t start_host_ = 0;
+    uint64_t start_index_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,358 @@
+#include "clip_exporter.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "loudness_meter.h"
+#include "ogg_opus_writer.h"
+#include "recording_index.h"
+#include "recording_reader.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#if defined(KAKAROT_HAVE_OPUS)
+#include <opus.h>
+#endif
+
+namespace kakarot {
+
+// Longest clip; a highlight, not an export of the meeting
+static constexpr double kMaxClipMs = 10.0 * 60.0 * 1000.0;
+
+// Per read of a track
+static constexpr double kReadMs = 5000.0;
+
+// Level frames are 10ms; the louder ones set the clip's level, from this
+// share of them up, so pauses do not pull it down
+static constexpr double kLevelQuantile = 0.7;
+static constexpr float kSilenceDbfs = -60.0f;
+
+// Normalization without a loudness reading stays within these, and any
+// under the peak ceiling
+static constexpr float kMinGainDb = -20.0f;
+static constexpr float kMaxGainDb = 24.0f;
+static constexpr float kPeakCeiling = 0.891f;  // -1dBFS
+
+static constexpr double kFadeMs = 10.0;
+
+// Ogg Opus: 20ms packets, half a second per page
+static constexpr int kOpusPacketMs = 20;
+static constexpr size_t kOpusPacketsPerPage = 25;
+static constexpr size_t kMaxOpusPacketBytes = 1275;
+
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Adds [start_ms, start_ms + mix->size()) of one track to |mix| at |rate|,
+// times |gain|; |start_ms| is in the track's own recording time. |covered|
+// is how much of the clip the track had audio for.
+bool MixTrack(RecordingReader* reader, double start_ms, int rate, float gain, const std::atomic<bool>& cancel,
+              std::vector<float>* mix, size_t* covered, std::string* error) {
+    const double end_ms = start_ms + mix->size() * 1000.0 / rate;
+    std::unique_ptr<webrtc::PushSincResampler> resampler;
+    int track_rate = 0;
+    size_t in_block = 0;
+    size_t out_block = 0;
+    std::vector<float> mono;
+    std::vector<float> block;
+    std::vector<float> resampled;
+
+    double at = std::max(0.0, start_ms);
+    while (at < end_ms) {
+        TaskScheduler::YieldForAudio(cancel);
+        if (cancel.load(std::memory_order_relaxed)) {
+            *error = "cancelled";
+            return false;
+        }
+        RecordingRange range;
+        if (!reader->Read(at, std::min(kReadMs, end_ms - at), &range, error)) {
+            return false;
+        }
+        if (range.samples == 0 || range.start_ms >= end_ms) {
+            break;
+        }
+        const size_t frames = std::min(range.samples, static_cast<size_t>(std::ceil(
+            (end_ms - range.start_ms) * range.sample_rate / 1000.0)));
+        mono.resize(frames);
+        DownmixRange(range, frames, mono.data());
+        at = range.start_ms + frames * 1000.0 / range.sample_rate;
+
+        // A device switch mid-recording changes the rate
+        if (range.sample_rate != track_rate) {
+            if (range.sample_rate % 100 != 0) {
+                *error = "cannot resample a track at " + std::to_string(range.sample_rate) + "Hz";
+                return false;
+            }
+            track_rate = range.sample_rate;
+            in_block = static_cast<size_t>(track_rate / 100);
+            out_block = static_cast<size_t>(rate / 100);
+            resampler = track_rate != rate ? std::make_unique<webrtc::PushSincResampler>(in_block, out_block) : nullptr;
+            block.resize(in_block);
+        }
+        const float* source = mono.data();
+        size_t count = frames;
+        if (resampler) {
+            resampled.resize((frames + in_block - 1) / in_block * out_block);
+            for (size_t i = 0; i < frames; i += in_block) {
+                const size_t take = std::min(in_block, frames - i);
+                std::copy(mono.begin() + i, mono.begin() + i + take, block.begin());
+                std::fill(block.begin() + take, block.end(), 0.0f);
+                resampler->Resample(block.data(), in_block, resampled.data() + i / in_block * out_block, out_block);
+            }
+            source = resampled.data();
+            count = frames * out_block / in_block;
+        }
+
+        const auto first = static_cast<int64_t>(std::llround((range.start_ms - start_ms) * rate / 1000.0));
+        for (size_t i = 0; i < count; ++i) {
+            const int64_t to = first + static_cast<int64_t>(i);
+            if (to >= 0 && to < static_cast<int64_t>(mix->size())) {
+                (*mix)[static_cast<size_t>(to)] += gain * source[i];
+            }
+        }
+        *covered = std::max(*covered, static_cast<size_t>(std::clamp<int64_t>(
+            first + static_cast<int64_t>(count), 0, static_cast<int64_t>(mix->size()))));
+    }
+    return true;
+}
+
+// Gain that brings the louder frames of |samples| to about |target_lufs|,
+// for tracks without a loudness reading
+float LevelGainDb(const std::vector<float>& samples, int rate, float target_lufs) {
+    const size_t frame = static_cast<size_t>(rate / 100);
+    std::vector<float> levels;
+    float peak = 0.0f;
+    for (size_t i = 0; i + frame <= samples.size(); i += frame) {
+        double power = 0.0;
+        for (size_t j = i; j < i + frame; ++j) {
+            power += samples[j] * samples[j];
+            peak = std::max(peak, std::fabs(samples[j]));
+        }
+        const float dbfs = 10.0f * std::log10(static_cast<float>(power / frame) + 1e-12f);
+        if (dbfs > kSilenceDbfs) {
+            levels.push_back(dbfs);
+        }
+    }
+    if (levels.empty() || peak <= 0.0f) {
+        return 0.0f;
+    }
+    auto at = levels.begin() + static_cast<ptrdiff_t>(kLevelQuantile * (levels.size() - 1));
+    std::nth_element(levels.begin(), at, levels.end());
+    const float ceiling_db = 20.0f * std::log10(kPeakCeiling / peak);
+    return std::min(std::clamp(target_lufs - *at, kMinGainDb, kMaxGainDb), ceiling_db);
+}
+
+void EncodeWav(const std::vector<float>& samples, int rate, std::vector<uint8_t>* out) {
+    const uint32_t data_bytes = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+    out->assign(44 + data_bytes, 0);
+    uint8_t* header = out->data();
+    std::copy_n("RIFF", 4, header);
+    recording_index::PutLe(header + 4, 36 + data_bytes, 4);
+    std::copy_n("WAVEfmt ", 8, header + 8);
+    recording_index::PutLe(header + 16, 16, 4);
+    recording_index::PutLe(header + 20, 1, 2);  // PCM
+    recording_index::PutLe(header + 22, 1, 2);
+    recording_index::PutLe(header + 24, static_cast<uint32_t>(rate), 4);
+    recording_index::PutLe(header + 28, static_cast<uint32_t>(rate) * 2, 4);
+    recording_index::PutLe(header + 32, 2, 2);
+    recording_index::PutLe(header + 34, 16, 2);
+    std::copy_n("data", 4, header + 36);
+    recording_index::PutLe(header + 40, data_bytes, 4);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const float clamped = std::clamp(samples[i], -1.0f, 1.0f);
+        const auto value = static_cast<int16_t>(std::lround(clamped * 32767.0f));
+        recording_index::PutLe(out->data() + 44 + i * 2, static_cast<uint16_t>(value), 2);
+    }
+}
+
+#if defined(KAKAROT_HAVE_OPUS)
+bool IsOpusRate(int sample_rate) {
+    return sample_rate == 8000 || sample_rate == 12000 || sample_rate == 16000 || sample_rate == 24000 ||
+           sample_rate == 48000;
+}
+
+struct OpusEncoderDeleter {
+    void operator()(OpusEncoder* encoder) const { opus_encoder_destroy(encoder); }
+};
+
+bool EncodeOpus(const std::vector<float>& samples, int rate, int bitrate, std::vector<uint8_t>* out,
+                std::string* error) {
+    int status = OPUS_OK;
+    std::unique_ptr<OpusEncoder, OpusEncoderDeleter> encoder(
+        opus_encoder_create(rate, 1, OPUS_APPLICATION_AUDIO, &status));
+    if (status != OPUS_OK || !encoder) {
+        *error = std::string("opus_encoder_create failed: ") + opus_strerror(status);
+        return false;
+    }
+    opus_encoder_ctl(encoder.get(), OPUS_SET_BITRATE(bitrate));
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(encoder.get(), OPUS_GET_LOOKAHEAD(&lookahead));
+    const int pre_skip = static_cast<int>(static_cast<int64_t>(lookahead) * 48000 / rate);
+
+    OggOpusWriter writer;
+    out->clear();
+    writer.Begin(static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count()), rate,
+                 pre_skip, out);
+    const size_t packet_samples = static_cast<size_t>(rate * kOpusPacketMs / 1000);
+    std::vector<float> packet(packet_samples);
+    std::vector<uint8_t> payload(kMaxOpusPacketBytes);
+    // The clip, then the lookahead still in the encoder; the final granule
+    // trims the last packet's padding
+    const size_t total = samples.size() + static_cast<size_t>(lookahead);
+    for (size_t i = 0; i < total; i += packet_samples) {
+        for (size_t j = 0; j < packet_samples; ++j) {
+            packet[j] = i + j < samples.size() ? samples[i + j] : 0.0f;
+        }
+        const opus_int32 size = opus_encode_float(encoder.get(), packet.data(), static_cast<int>(packet_samples),
+                                                  payload.data(), static_cast<opus_int32>(payload.size()));
+        if (size < 0) {
+            *error = std::string("opus_encode_float failed: ") + opus_strerror(size);
+            return false;
+        }
+        writer.AddPacket(payload.data(), static_cast<size_t>(size), 48 * kOpusPacketMs);
+        if (writer.PendingPackets() >= kOpusPacketsPerPage) {
+            writer.Flush(out);
+        }
+    }
+    writer.Finish(pre_skip + samples.size() * 48000 / rate, out);
+    return true;
+}
+#endif
+
+bool WriteFile(const std::string& output, const std::vector<uint8_t>& bytes, std::string* error) {
+    const std::string part = output + ".part";
+    FILE* file = std::fopen(part.c_str(), "wb");
+    if (!file) {
+        *error = "cannot create " + part;
+        return false;
+    }
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (ok) {
+        std::remove(output.c_str());  // rename() will not replace on Windows
+        ok = std::rename(part.c_str(), output.c_str()) == 0;
+    }
+    if (!ok) {
+        std::remove(part.c_str());
+        *error = "cannot write " + output;
+    }
+    return ok;
+}
+
+} // namespace
+
+ClipResult ExtractClip(const ClipJob& job, const std::atomic<bool>& cancel) {
+    const auto start = std::chrono::steady_clock::now();
+    ClipResult result;
+    if (job.indexes.empty()) {
+        result.error = "no tracks";
+        return result;
+    }
+    if (job.format == ClipFormat::kOpus) {
+#if defined(KAKAROT_HAVE_OPUS)
+        if (!IsOpusRate(job.sample_rate)) {
+            result.error = "opus takes 8, 12, 16, 24 or 48kHz";
+            return result;
+        }
+#else
+        result.error = "this build has no Opus encoder";
+        return result;
+#endif
+    } else if (job.sample_rate < 8000 || job.sample_rate % 100 != 0) {
+        result.error = "the clip rate must be a multiple of 100Hz from 8kHz";
+        return result;
+    }
+    const int rate = job.sample_rate;
+    const double duration_ms = std::clamp(job.duration_ms, 0.0, kMaxClipMs);
+    std::vector<float> mix(static_cast<size_t>(duration_ms * rate / 1000.0), 0.0f);
+
+    std::vector<RecordingReader> readers(job.indexes.size());
+    std::vector<float> gains(job.indexes.size(), 1.0f);
+    result.measured = true;
+    for (size_t t = 0; t < job.indexes.size(); ++t) {
+        if (!readers[t].Open(job.indexes[t], &result.error)) {
+            return result;
+        }
+        double lufs = 0.0;
+        double peak = 0.0;
+        if (readers[t].Loudness(&lufs, &peak)) {
+            gains[t] = NormalizationGainDb(lufs, peak, job.target_lufs);
+        } else {
+            result.measured = false;
+        }
+    }
+    if (result.measured) {
+        result.gain_db = gains[0];
+        for (float& gain : gains) {
+            gain = std::pow(10.0f, gain / 20.0f);
+        }
+    } else {
+        std::fill(gains.begin(), gains.end(), 1.0f);
+    }
+
+    size_t covered = 0;
+    for (size_t t = 0; t < readers.size(); ++t) {
+        // Into this track's own recording time
+        const double track_start = job.start_ms + static_cast<double>(readers[0].StartedAtMs()) -
+                                   static_cast<double>(readers[t].StartedAtMs());
+        if (!MixTrack(&readers[t], track_start, rate, gains[t], cancel, &mix, &covered, &result.error)) {
+            return result;
+        }
+    }
+    mix.resize(covered);
+    if (mix.empty()) {
+        result.error = "no audio in the range";
+        return result;
+    }
+
+    // Tracks levelled apart can still peak together
+    float gain = 1.0f;
+    if (result.measured) {
+        float peak = 0.0f;
+        for (float sample : mix) {
+            peak = std::max(peak, std::fabs(sample));
+        }
+        gain = peak > kPeakCeiling ? kPeakCeiling / peak : 1.0f;
+    } else {
+        result.gain_db = LevelGainDb(mix, rate, job.target_lufs);
+        gain = std::pow(10.0f, result.gain_db / 20.0f);
+    }
+    const size_t fade = std::min(mix.size() / 2, static_cast<size_t>(kFadeMs * rate / 1000.0));
+    for (size_t i = 0; i < mix.size(); ++i) {
+        float g = gain;
+        if (i < fade) {
+            g *= static_cast<float>(i) / fade;
+        } else if (mix.size() - i <= fade) {
+            g *= static_cast<float>(mix.size() - 1 - i) / fade;
+        }
+        mix[i] *= g;
+    }
+
+    std::vector<uint8_t> bytes;
+    if (job.format == ClipFormat::kWav) {
+        EncodeWav(mix, rate, &bytes);
+    } else {
+#if defined(KAKAROT_HAVE_OPUS)
+        if (!EncodeOpus(mix, rate, job.bitrate, &bytes, &result.error)) {
+            return result;
+        }
+#endif
+    }
+    if (!job.output.empty() && !WriteFile(job.output, bytes, &result.error)) {
+        return result;
+    }
+    result.output_bytes = bytes.size();
+    if (job.output.empty()) {
+        result.bytes = std::move(bytes);
+    }
+    result.duration_ms = mix.size() * 1000.0 / rate;
+    result.sample_rate = rate;
+    result.ok = true;
+    result.elapsed_ms = MillisecondsSince(start);
+    return result;
+}
+
+} // namespace kakarot
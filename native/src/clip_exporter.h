@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+enum class ClipFormat {
+    kOpus,  // Ogg Opus; only in builds with libopus
+    kWav,   // 16-bit PCM
+};
+
+struct ClipJob {
+    std::vector<std::string> indexes;  // <name>.<track>.idx of each track to mix
+    double start_ms = 0.0;             // recording time of the first track
+    double duration_ms = 30000.0;
+    ClipFormat format = ClipFormat::kOpus;
+    int sample_rate = 48000;           // of the clip; opus takes 8, 12, 16, 24 or 48kHz
+    int bitrate = 48000;               // opus
+    float target_lufs = -16.0f;        // loudness the clip is brought to
+    std::string output;                // a file to write; empty returns the bytes
+};
+
+struct ClipResult {
+    bool ok = false;
+    std::string error;
+    std::vector<uint8_t> bytes;  // the encoded clip when the job had no output
+    uint64_t output_bytes = 0;
+    double duration_ms = 0.0;    // less than asked for at the end of the recording
+    int sample_rate = 0;
+    float gain_db = 0.0f;        // normalization, of the first track when measured per track
+    bool measured = false;       // the gains came from the recorder's loudness readings
+    double elapsed_ms = 0.0;
+};
+
+// A shareable clip of a recording, on the calling thread. Each track's range
+// is found through its seek index and read straight from the mapped WAVs,
+// so the cost is the clip's length whatever the meeting's. Tracks are
+// downmixed, resampled to the clip's rate and summed on one timeline (their
+// own start times line them up; gaps stay silent) and brought to
+// target_lufs under a -1dBFS peak ceiling. The gains come from the loudness
+// the recorder metered into each index, one per track, so nothing is
+// analysed twice; recordings from before it are levelled by the clip's own
+// louder frames instead. Faded at both ends and encoded. Output goes to
+// <output>.part and is renamed once complete. Polls |cancel| between reads.
+ClipResult ExtractClip(const ClipJob& job, const std::atomic<bool>& cancel);
+
+} // namespace kakarot
@@ -0,0 +1,139 @@
+#include "cpu_dispatch.h"
+#include "aes_gcm.h"
+#include "frame_kernels.h"
+#include "native_log.h"
+#include "modules/audio_processing/agc2/cpu_features.h"
+
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace kakarot {
+
+static const char* const kLogSource = "CpuDispatch";
+
+namespace {
+
+const char* BuildArch() {
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return "arm64";
+#elif defined(__x86_64__) || defined(_M_X64)
+    return "x86_64";
+#elif defined(__i386__) || defined(_M_IX86)
+    return "x86";
+#else
+    return "unknown";
+#endif
+}
+
+// The widest vector ISA the compiler may auto-vectorize our own loops to;
+// they carry no runtime dispatch, so this is fixed per slice
+const char* CompiledLevel() {
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+    return "neon";
+#elif defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+// WebRTC's own pick (RNN VAD, FIR, AEC3), which checks the CPU at run time
+const char* WebRtcLevel(const webrtc::AvailableCpuFeatures& features) {
+    if (features.avx2) {
+        return "avx2";
+    }
+    if (features.sse2) {
+        return "sse2";
+    }
+    return features.neon ? "neon" : "scalar";
+}
+
+bool IsTranslated() {
+#if defined(__APPLE__)
+    int translated = 0;
+    size_t size = sizeof(translated);
+    return sysctlbyname("sysctl.proc_translated", &translated, &size, nullptr, 0) == 0 && translated == 1;
+#elif defined(_WIN32) && (defined(_M_X64) || defined(_M_IX86))
+    // An x64 process on Arm has no WOW64 machine of its own but reports the native one
+    USHORT process = 0;
+    USHORT native = 0;
+    return IsWow64Process2(GetCurrentProcess(), &process, &native) && native == IMAGE_FILE_MACHINE_ARM64;
+#else
+    return false;
+#endif
+}
+
+void ReadHardware(CpuFeatures* features) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+    features->neon = true;  // mandatory on arm64
+    features->fma = true;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int regs[4] = {};
+    __cpuid(regs, 1);
+    features->sse2 = (regs[3] & (1 << 26)) != 0;
+    features->fma = (regs[2] & (1 << 12)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    __cpuidex(regs, 7, 0);
+    // AVX2 also needs the OS to save the YMM registers
+    features->avx2 = osxsave && (regs[1] & (1 << 5)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    features->sse2 = __builtin_cpu_supports("sse2");
+    features->avx2 = __builtin_cpu_supports("avx2");
+    features->fma = __builtin_cpu_supports("fma");
+#endif
+}
+
+CpuFeatures Detect() {
+    CpuFeatures features;
+    features.arch = BuildArch();
+    features.translated = IsTranslated();
+    ReadHardware(&features);
+
+    const char* compiled = CompiledLevel();
+    const char* webrtc_level = WebRtcLevel(webrtc::GetAvailableCpuFeatures());
+#if defined(__APPLE__)
+    features.kernels.push_back({"dsp", "accelerate", false});
+#else
+    features.kernels.push_back({"dsp", compiled, false});
+#endif
+    features.kernels.push_back({"frameKernels", compiled, dsp::FrameKernelsFor(480).specialized});
+    features.kernels.push_back({"rnnVad", webrtc_level, false});
+    features.kernels.push_back({"neuralDenoiser", webrtc_level, false});
+    features.kernels.push_back({"fir", webrtc_level, false});
+    features.kernels.push_back({"aec3", webrtc_level, false});
+    features.kernels.push_back({"aesGcm", AesGcmLevel(), false});
+
+    Log(LogLevel::kInfo, kLogSource, "%s build, sse2 %d avx2 %d fma %d neon %d, dsp %s, webrtc %s",
+        features.arch.c_str(), features.sse2, features.avx2, features.fma, features.neon,
+        features.kernels[0].level.c_str(), webrtc_level);
+    if (features.translated) {
+        Log(LogLevel::kWarn, kLogSource, "the %s build is running translated; the native slice was not loaded",
+            features.arch.c_str());
+    }
+    const bool has_simd = features.sse2 || features.neon;
+    for (const CpuFeatures::Kernel& kernel : features.kernels) {
+        if (has_simd && kernel.level == "scalar") {
+            Log(LogLevel::kWarn, kLogSource, "%s runs scalar on a CPU with SIMD", kernel.name.c_str());
+        }
+    }
+    return features;
+}
+
+} // namespace
+
+const CpuFeatures& GetCpuFeatures() {
+    static const CpuFeatures features = Detect();
+    return features;
+}
+
+} // namespace kakarot
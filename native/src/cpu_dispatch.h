@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// What the CPU offers and which SIMD path each kernel family runs on it.
+// The addon ships as a universal binary on macOS, so the slice that loaded
+// is the one compiled for |arch|; an x86_64 slice on Apple silicon means
+// Rosetta chose it, and a kernel on "scalar" where the CPU has SIMD means a
+// build that lost its vector path. Both show up here rather than as a
+// slower meeting.
+struct CpuFeatures {
+    std::string arch;          // "arm64", "x86_64", "x86" or "unknown"; of this build
+    bool translated = false;   // Rosetta 2 or Windows on Arm emulating this build
+    bool sse2 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool neon = false;
+
+    struct Kernel {
+        std::string name;
+        std::string level;     // "accelerate", "avx2", "sse2", "neon" or "scalar"; aesGcm's "aesni" or "armv8"
+        bool specialized = false;  // compiled for the 10ms frame lengths
+    };
+    std::vector<Kernel> kernels;
+};
+
+// Read once; the same for every call
+const CpuFeatures& GetCpuFeatures();
+
+} // namespace kakarot
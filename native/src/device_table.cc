@@ -0,0 +1,221 @@
+#include "device_table.h"
+#include "native_log.h"
+
+namespace kakarot {
+
+static const AudioObjectPropertyAddress kWatchedProperties[] = {
+    { kAudioHardwarePropertyDevices, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain },
+    { kAudioHardwarePropertyDefaultInputDevice, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain },
+    { kAudioHardwarePropertyDefaultOutputDevice, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain },
+};
+
+static AudioDeviceID GetSystemDevice(AudioObjectPropertySelector selector) {
+    AudioDeviceID device = kAudioObjectUnknown;
+    AudioObjectPropertyAddress address = {
+        selector,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 size = sizeof(device);
+    AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, &device);
+    return device;
+}
+
+static std::string GetStringProperty(AudioDeviceID device, AudioObjectPropertySelector selector) {
+    CFStringRef value = nullptr;
+    AudioObjectPropertyAddress address = {
+        selector,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 size = sizeof(value);
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &value) != noErr || !value) {
+        return std::string();
+    }
+
+    char buffer[256];
+    std::string result;
+    if (CFStringGetCString(value, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
+        result = buffer;
+    }
+    CFRelease(value);
+    return result;
+}
+
+// Total channels across the device's streams in |scope|
+static uint32_t GetChannelCount(AudioDeviceID device, AudioObjectPropertyScope scope) {
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyStreamConfiguration,
+        scope,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 size = 0;
+    if (AudioObjectGetPropertyDataSize(device, &address, 0, nullptr, &size) != noErr || size == 0) {
+        return 0;
+    }
+
+    std::vector<uint8_t> storage(size);
+    AudioBufferList* buffers = reinterpret_cast<AudioBufferList*>(storage.data());
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, buffers) != noErr) {
+        return 0;
+    }
+
+    uint32_t channels = 0;
+    for (UInt32 i = 0; i < buffers->mNumberBuffers; ++i) {
+        channels += buffers->mBuffers[i].mNumberChannels;
+    }
+    return channels;
+}
+
+static const char* TransportTypeName(UInt32 transport) {
+    switch (transport) {
+        case kAudioDeviceTransportTypeBuiltIn: return "builtIn";
+        case kAudioDeviceTransportTypeUSB: return "usb";
+        case kAudioDeviceTransportTypeBluetooth: return "bluetooth";
+        case kAudioDeviceTransportTypeBluetoothLE: return "bluetoothLE";
+        case kAudioDeviceTransportTypeAggregate: return "aggregate";
+        case kAudioDeviceTransportTypeVirtual: return "virtual";
+        case kAudioDeviceTransportTypeHDMI: return "hdmi";
+        case kAudioDeviceTransportTypeDisplayPort: return "displayPort";
+        case kAudioDeviceTransportTypeAirPlay: return "airplay";
+        case kAudioDeviceTransportTypeThunderbolt: return "thunderbolt";
+        case kAudioDeviceTransportTypePCI: return "pci";
+        case kAudioDeviceTransportTypeFireWire: return "firewire";
+        default: return "unknown";
+    }
+}
+
+static AudioDeviceInfo QueryDevice(AudioDeviceID device, AudioDeviceID default_input,
+                                   AudioDeviceID default_output) {
+    AudioDeviceInfo info;
+    info.id = device;
+    info.uid = GetStringProperty(device, kAudioDevicePropertyDeviceUID);
+    info.name = GetStringProperty(device, kAudioDevicePropertyDeviceNameCFString);
+    info.input_channels = GetChannelCount(device, kAudioDevicePropertyScopeInput);
+    info.output_channels = GetChannelCount(device, kAudioDevicePropertyScopeOutput);
+    info.is_default_input = (device == default_input);
+    info.is_default_output = (device == default_output);
+
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyNominalSampleRate,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    Float64 rate = 0.0;
+    UInt32 size = sizeof(rate);
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &rate) == noErr) {
+        info.nominal_sample_rate = rate;
+    }
+
+    address.mSelector = kAudioDevicePropertyBufferFrameSize;
+    UInt32 frames = 0;
+    size = sizeof(frames);
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &frames) == noErr) {
+        info.buffer_frame_size = frames;
+    }
+
+    address.mSelector = kAudioDevicePropertyBufferFrameSizeRange;
+    AudioValueRange range = {};
+    size = sizeof(range);
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &range) == noErr) {
+        info.buffer_frame_min = static_cast<uint32_t>(range.mMinimum);
+        info.buffer_frame_max = static_cast<uint32_t>(range.mMaximum);
+    }
+
+    address.mSelector = kAudioDevicePropertyTransportType;
+    UInt32 transport = 0;
+    size = sizeof(transport);
+    AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &transport);
+    info.transport = TransportTypeName(transport);
+
+    return info;
+}
+
+DeviceTable::DeviceTable() : devices_(std::make_shared<DeviceList>()) {}
+
+DeviceTable::~DeviceTable() {
+    Stop();
+}
+
+void DeviceTable::Start() {
+    if (listening_) {
+        return;
+    }
+
+    Rebuild();
+    for (const auto& address : kWatchedProperties) {
+        AudioObjectAddPropertyListener(kAudioObjectSystemObject, &address, &DeviceTable::PropertyChanged, this);
+    }
+    listening_ = true;
+}
+
+void DeviceTable::Stop() {
+    if (!listening_) {
+        return;
+    }
+
+    for (const auto& address : kWatchedProperties) {
+        AudioObjectRemovePropertyListener(kAudioObjectSystemObject, &address, &DeviceTable::PropertyChanged, this);
+    }
+    listening_ = false;
+}
+
+std::shared_ptr<const DeviceList> DeviceTable::Snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return devices_;
+}
+
+uint64_t DeviceTable::Version() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return version_;
+}
+
+void DeviceTable::SetChangeCallback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_change_ = std::move(callback);
+}
+
+// HAL notification thread
+OSStatus DeviceTable::PropertyChanged(AudioObjectID /*object*/,
+                                      UInt32 /*num_addresses*/,
+                                      const AudioObjectPropertyAddress* /*addresses*/,
+                                      void* client_data) {
+    DeviceTable* self = static_cast<DeviceTable*>(client_data);
+    self->Rebuild();
+
+    std::function<void()> callback;
+    {
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        callback = self->on_change_;
+    }
+    if (callback) {
+        callback();
+    }
+    return noErr;
+}
+
+// Queries happen outside the lock; only the pointer swap is serialized
+void DeviceTable::Rebuild() {
+    auto devices = std::make_shared<DeviceList>();
+
+    AudioObjectPropertyAddress address = kWatchedProperties[0];
+    UInt32 size = 0;
+    if (AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &address, 0, nullptr, &size) == noErr && size > 0) {
+        std::vector<AudioDeviceID> ids(size / sizeof(AudioDeviceID));
+        if (AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, ids.data()) == noErr) {
+            AudioDeviceID default_input = GetSystemDevice(kAudioHardwarePropertyDefaultInputDevice);
+            AudioDeviceID default_output = GetSystemDevice(kAudioHardwarePropertyDefaultOutputDevice);
+            devices->reserve(ids.size());
+            for (AudioDeviceID id : ids) {
+                devices->push_back(QueryDevice(id, default_input, default_output));
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    devices_ = std::move(devices);
+    ++version_;
+    Log(LogLevel::kInfo, "DeviceTable", "Device table rebuilt: %zu device(s)", devices_->size());
+}
+
+} // namespace kakarot
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <CoreAudio/CoreAudio.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+struct AudioDeviceInfo {
+    AudioDeviceID id = kAudioObjectUnknown;
+    std::string uid;
+    std::string name;
+    std::string transport;          // "builtIn", "usb", "bluetooth", ...
+    double nominal_sample_rate = 0.0;
+    uint32_t buffer_frame_size = 0;
+    uint32_t buffer_frame_min = 0;
+    uint32_t buffer_frame_max = 0;
+    uint32_t input_channels = 0;
+    uint32_t output_channels = 0;
+    bool is_default_input = false;
+    bool is_default_output = false;
+};
+
+using DeviceList = std::vector<AudioDeviceInfo>;
+
+// Native mirror of the HAL device list. Property listeners on the system
+// object (device list, default input, default output) rebuild it off the JS
+// thread; readers take an immutable snapshot in O(1).
+class DeviceTable {
+public:
+    DeviceTable();
+    ~DeviceTable();
+
+    DeviceTable(const DeviceTable&) = delete;
+    DeviceTable& operator=(const DeviceTable&) = delete;
+
+    // Builds the table and installs the listeners
+    void Start();
+    void Stop();
+
+    std::shared_ptr<const DeviceList> Snapshot() const;
+
+    // Bumped on every rebuild; lets callers cache derived data
+    uint64_t Version() const;
+
+    // Called on the HAL notification thread after each rebuild
+    void SetChangeCallback(std::function<void()> callback);
+
+private:
+    static OSStatus PropertyChanged(AudioObjectID object,
+                                    UInt32 num_addresses,
+                                    const AudioObjectPropertyAddress* addresses,
+                                    void* client_data);
+    void Rebuild();
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const DeviceList> devices_;
+    uint64_t version_ = 0;
+    std::function<void()> on_change_;
+    bool listening_ = false;
+};
+
+} // namespace kakarot
@@ -0,0 +1,180 @@
+#include "document_text.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace kakarot {
+
+// Larger files are not notes and would crowd out everything else
+static constexpr size_t kMaxTextBytes = 16 * 1024 * 1024;
+
+namespace {
+
+std::string Extension(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return std::string();
+    }
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+bool IsPlainText(const std::string& extension) {
+    static const char* const kExtensions[] = {"txt", "text", "md", "markdown", "rst", "org", "csv"};
+    return std::any_of(std::begin(kExtensions), std::end(kExtensions),
+                       [&](const char* known) { return extension == known; });
+}
+
+bool IsRich(const std::string& extension) {
+    return extension == "pdf" || extension == "doc" || extension == "docx" || extension == "rtf";
+}
+
+bool ReadFile(const std::string& path, std::string* contents, std::string* error) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        *error = "cannot open " + path;
+        return false;
+    }
+    contents->clear();
+    char buffer[65536];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        if (contents->size() + read > kMaxTextBytes) {
+            std::fclose(file);
+            *error = "too large: " + path;
+            return false;
+        }
+        contents->append(buffer, read);
+    }
+    bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed) {
+        *error = "cannot read " + path;
+        return false;
+    }
+    // A UTF-8 byte order mark is not text
+    if (contents->compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        contents->erase(0, 3);
+    }
+    return true;
+}
+
+// Elements whose content is not prose
+bool SkipsContent(const std::string& tag) {
+    return tag == "script" || tag == "style" || tag == "head" || tag == "noscript";
+}
+
+bool BreaksLine(const std::string& tag) {
+    static const char* const kTags[] = {"p", "br", "div", "li", "tr", "h1", "h2", "h3", "h4", "h5", "h6",
+                                        "section", "article", "blockquote", "pre", "table", "ul", "ol"};
+    return std::any_of(std::begin(kTags), std::end(kTags), [&](const char* known) { return tag == known; });
+}
+
+// Markup out, a newline per block element, the common entities decoded
+std::string HtmlToText(const std::string& html) {
+    std::string text;
+    text.reserve(html.size() / 2);
+    std::string skipping;
+    size_t i = 0;
+    while (i < html.size()) {
+        if (html[i] == '<') {
+            size_t end = html.find('>', i);
+            if (end == std::string::npos) {
+                break;
+            }
+            if (html.compare(i, 4, "<!--") == 0) {
+                size_t comment_end = html.find("-->", i + 4);
+                i = comment_end == std::string::npos ? html.size() : comment_end + 3;
+                continue;
+            }
+            size_t name = i + 1;
+            bool closing = name < end && html[name] == '/';
+            if (closing) {
+                ++name;
+            }
+            size_t name_end = name;
+            while (name_end < end && std::isalnum(static_cast<unsigned char>(html[name_end]))) {
+                ++name_end;
+            }
+            std::string tag = html.substr(name, name_end - name);
+            std::transform(tag.begin(), tag.end(), tag.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (!skipping.empty()) {
+                if (closing && tag == skipping) {
+                    skipping.clear();
+                }
+            } else if (!closing && SkipsContent(tag)) {
+                skipping = tag;
+            } else if (BreaksLine(tag)) {
+                text += '\n';
+            }
+            i = end + 1;
+            continue;
+        }
+        if (!skipping.empty()) {
+            ++i;
+            continue;
+        }
+        if (html[i] == '&') {
+            static const struct {
+                const char* entity;
+                const char* text;
+            } kEntities[] = {{"&amp;", "&"}, {"&lt;", "<"},   {"&gt;", ">"},   {"&quot;", "\""},
+                             {"&#39;", "'"}, {"&apos;", "'"}, {"&nbsp;", " "}};
+            bool decoded = false;
+            for (const auto& entry : kEntities) {
+                size_t length = std::strlen(entry.entity);
+                if (html.compare(i, length, entry.entity) == 0) {
+                    text += entry.text;
+                    i += length;
+                    decoded = true;
+                    break;
+                }
+            }
+            if (decoded) {
+                continue;
+            }
+        }
+        text += html[i++];
+    }
+    return text;
+}
+
+} // namespace
+
+#if !defined(__APPLE__)
+bool ExtractRichDocumentText(const std::string& path, std::string*, std::string* error) {
+    *error = "No PDF or Word reader on this platform: " + path;
+    return false;
+}
+#endif
+
+bool IsKnowledgeDocument(const std::string& path) {
+    std::string extension = Extension(path);
+#if defined(__APPLE__)
+    if (IsRich(extension)) {
+        return true;
+    }
+#endif
+    return IsPlainText(extension) || extension == "html" || extension == "htm";
+}
+
+bool ExtractDocumentText(const std::string& path, std::string* text, std::string* error) {
+    std::string extension = Extension(path);
+    if (IsRich(extension)) {
+        return ExtractRichDocumentText(path, text, error);
+    }
+    if (!ReadFile(path, text, error)) {
+        return false;
+    }
+    if (extension == "html" || extension == "htm") {
+        *text = HtmlToText(*text);
+    }
+    return true;
+}
+
+} // namespace kakarot
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+namespace kakarot {
+
+// Plain text (.txt, .md, .markdown, .rst, .org, .csv), HTML, and where the
+// platform reads them (macOS) PDF, Word and RTF
+bool IsKnowledgeDocument(const std::string& path);
+
+// The UTF-8 text of a document, any thread. HTML loses its markup; a PDF
+// or Word file goes through the platform's own reader.
+bool ExtractDocumentText(const std::string& path, std::string* text, std::string* error);
+
+// PDF, .doc, .docx and .rtf; false with |error| set where the platform has
+// no reader (Windows, Linux)
+bool ExtractRichDocumentText(const std::string& path, std::string* text, std::string* error);
+
+} // namespace kakarot
@@ -0,0 +1,64 @@
+#import <AppKit/AppKit.h>
+#import <PDFKit/PDFKit.h>
+#include "document_text.h"
+
+namespace kakarot {
+
+static std::string Describe(NSError* error) {
+    return error ? std::string(error.localizedDescription.UTF8String ?: "unknown error") : std::string();
+}
+
+bool ExtractRichDocumentText(const std::string& path, std::string* text, std::string* error) {
+    @autoreleasepool {
+        NSURL* url = [NSURL fileURLWithPath:[NSString stringWithUTF8String:path.c_str()]];
+        NSString* extension = url.pathExtension.lowercaseString;
+        NSString* contents = nil;
+        if ([extension isEqualToString:@"pdf"]) {
+            PDFDocument* document = [[PDFDocument alloc] initWithURL:url];
+            if (!document) {
+                *error = "cannot read PDF " + path;
+                return false;
+            }
+            if (document.isLocked) {
+                *error = "PDF is encrypted: " + path;
+                return false;
+            }
+            // Page by page, so a page break stays a paragraph break
+            NSMutableString* pages = [NSMutableString string];
+            for (NSInteger i = 0; i < document.pageCount; ++i) {
+                NSString* page = [document pageAtIndex:i].string;
+                if (page.length > 0) {
+                    [pages appendString:page];
+                    [pages appendString:@"\n\n"];
+                }
+            }
+            contents = pages;
+        } else {
+            // Word and RTF through AppKit's importers, which are safe off the
+            // main thread (its HTML importer is not, and is not used here)
+            NSDictionary* options = @{};
+            if ([extension isEqualToString:@"docx"]) {
+                options = @{NSDocumentTypeDocumentOption : NSOfficeOpenXMLTextDocumentType};
+            } else if ([extension isEqualToString:@"doc"]) {
+                options = @{NSDocumentTypeDocumentOption : NSDocFormatTextDocumentType};
+            } else {
+                options = @{NSDocumentTypeDocumentOption : NSRTFTextDocumentType};
+            }
+            NSError* read_error = nil;
+            NSAttributedString* document = [[NSAttributedString alloc] initWithURL:url
+                                                                           options:options
+                                                                documentAttributes:nil
+                                                                             error:&read_error];
+            if (!document) {
+                *error = "cannot read " + path + ": " + Describe(read_error);
+                return false;
+            }
+            contents = document.string;
+        }
+        const char* utf8 = contents.UTF8String;
+        text->assign(utf8 ? utf8 : "");
+        return true;
+    }
+}
+
+} // namespace kakarot
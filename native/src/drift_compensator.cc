@@ -0,0 +1,162 @@
+#include "drift_compensator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+// Timestamp error that counts as a discontinuity rather than jitter
+static constexpr double kContinuityToleranceMs = 5.0;
+
+// Span before the first estimate, and how often the anchor moves up
+static constexpr double kMinSpanMs = 10000.0;
+static constexpr double kAnchorWindowMs = 60000.0;
+
+// Arrivals are judged against the last one to two of these; long enough to
+// span a burst cycle, short enough to follow drift and load changes
+static constexpr double kArrivalWindowMs = 4000.0;
+static constexpr double kResyncMs = 400.0;
+
+StreamRateEstimator::StreamRateEstimator(const HostClock* clock) : clock_(clock) {}
+
+void StreamRateEstimator::Reset(double nominal_rate) {
+    started_ = false;
+    has_estimate_ = false;
+    rate_ = nominal_rate;
+    has_next_anchor_ = false;
+    frames_ = 0;
+}
+
+bool StreamRateEstimator::Update(uint64_t host_time, size_t num_frames) {
+    const bool first = !started_;
+    bool continuous = started_;
+    if (started_) {
+        // Where this buffer should start if nothing was lost
+        double expected_ms = clock_->TicksToMs(last_host_) + last_frames_ * 1000.0 / rate_;
+        continuous = std::fabs(clock_->TicksToMs(host_time) - expected_ms) <= kContinuityToleranceMs;
+    }
+
+    if (!continuous) {
+        // Keep the rate through a restart; the clock behind it has not changed
+        started_ = true;
+        has_estimate_ = false;
+        has_next_anchor_ = false;
+        frames_ = 0;
+        anchor_host_ = host_time;
+        anchor_frames_ = 0;
+    } else {
+        frames_ += last_frames_;
+        double span_ms = clock_->TicksToMs(host_time - anchor_host_);
+        if (span_ms >= kMinSpanMs) {
+            rate_ = (frames_ - anchor_frames_) * 1000.0 / span_ms;
+            has_estimate_ = true;
+        }
+        if (!has_next_anchor_ && span_ms >= kAnchorWindowMs / 2) {
+            next_anchor_host_ = host_time;
+            next_anchor_frames_ = frames_;
+            has_next_anchor_ = true;
+        } else if (has_next_anchor_ && span_ms >= kAnchorWindowMs) {
+            anchor_host_ = next_anchor_host_;
+            anchor_frames_ = next_anchor_frames_;
+            has_next_anchor_ = false;
+        }
+    }
+
+    last_host_ = host_time;
+    last_frames_ = num_frames;
+    return continuous || first;
+}
+
+ArrivalDejitter::ArrivalDejitter(const HostClock* clock) : clock_(clock) {}
+
+void ArrivalDejitter::Reset(double sample_rate) {
+    sample_rate_ = sample_rate;
+    started_ = false;
+    frames_ = 0;
+}
+
+void ArrivalDejitter::StartWindow(double now_ms, double offset_ms) {
+    min_offset_ms_[0] = min_offset_ms_[1] = offset_ms;
+    max_late_ms_[0] = max_late_ms_[1] = 0.0;
+    window_start_ms_ = now_ms;
+}
+
+uint64_t ArrivalDejitter::Place(uint64_t arrival_host, size_t num_frames) {
+    const double arrival_ms = clock_->TicksToMs(arrival_host);
+    double offset_ms = arrival_ms - (frames_ + num_frames) * 1000.0 / sample_rate_;
+    if (!started_ || offset_ms - std::min(min_offset_ms_[0], min_offset_ms_[1]) > kResyncMs) {
+        started_ = true;
+        frames_ = 0;
+        offset_ms = arrival_ms - num_frames * 1000.0 / sample_rate_;
+        StartWindow(arrival_ms, offset_ms);
+    }
+
+    if (arrival_ms - window_start_ms_ >= kArrivalWindowMs / 2) {
+        min_offset_ms_[1] = min_offset_ms_[0];
+        max_late_ms_[1] = max_late_ms_[0];
+        min_offset_ms_[0] = offset_ms;
+        max_late_ms_[0] = 0.0;
+        window_start_ms_ = arrival_ms;
+    }
+    min_offset_ms_[0] = std::min(min_offset_ms_[0], offset_ms);
+    const double base_ms = std::min(min_offset_ms_[0], min_offset_ms_[1]);
+    max_late_ms_[0] = std::max(max_late_ms_[0], offset_ms - base_ms);
+
+    const double start_ms = base_ms + frames_ * 1000.0 / sample_rate_;
+    frames_ += num_frames;
+    return clock_->MsToTicks(start_ms);
+}
+
+double ArrivalDejitter::JitterMs() const {
+    return std::max(max_late_ms_[0], max_late_ms_[1]);
+}
+
+DriftResampler::DriftResampler(size_t max_samples, size_t max_channels)
+    : max_samples_(max_samples),
+      max_channels_(max_channels),
+      work_(kHistoryFrames * max_channels + max_samples, 0.0f) {}
+
+void DriftResampler::Reset() {
+    std::fill(work_.begin(), work_.end(), 0.0f);
+    position_ = 1.0;
+}
+
+size_t DriftResampler::Process(const float* input, size_t num_frames, size_t channels, double ratio,
+                               float* output, size_t output_capacity) {
+    if (channels == 0 || channels > max_channels_ || num_frames * channels > max_samples_ || ratio <= 0.0) {
+        return 0;
+    }
+
+    float* work = work_.data();
+    std::memcpy(work + kHistoryFrames * channels, input, num_frames * channels * sizeof(float));
+
+    // Interpolate between work frames i and i + 1 while i - 1 .. i + 2 exist
+    const double step = 1.0 / ratio;
+    const double end = static_cast<double>(kHistoryFrames + num_frames) - 2.0;
+    size_t written = 0;
+    while (position_ < end && written < output_capacity) {
+        size_t i = static_cast<size_t>(position_);
+        float t = static_cast<float>(position_ - static_cast<double>(i));
+        const float* xm1 = work + (i - 1) * channels;
+        const float* x0 = xm1 + channels;
+        const float* x1 = x0 + channels;
+        const float* x2 = x1 + channels;
+        float* out = output + written * channels;
+        for (size_t c = 0; c < channels; ++c) {
+            float c1 = 0.5f * (x1[c] - xm1[c]);
+            float c2 = xm1[c] - 2.5f * x0[c] + 2.0f * x1[c] - 0.5f * x2[c];
+            float c3 = 0.5f * (x2[c] - xm1[c]) + 1.5f * (x0[c] - x1[c]);
+            out[c] = ((c3 * t + c2) * t + c1) * t + x0[c];
+        }
+        position_ += step;
+        ++written;
+    }
+
+    // The last frames become the next call's history
+    std::memmove(work, work + num_frames * channels, kHistoryFrames * channels * sizeof(float));
+    // A short |output| leaves the position behind; drop what did not fit
+    position_ = std::max(1.0, position_ - static_cast<double>(num_frames));
+    return written;
+}
+
+} // namespace kakarot
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "host_time.h"
+
+namespace kakarot {
+
+// True rate of one stream on the host clock, from its frame counter against
+// its buffer timestamps. The rate is the slope from an anchor buffer to the
+// newest one, so timestamp jitter shrinks with the span; the anchor moves up
+// every window so a slowly wandering crystal is followed. A buffer that is
+// off its predicted time by more than the tolerance (a gap, a device
+// restart) restarts the estimate.
+class StreamRateEstimator {
+public:
+    explicit StreamRateEstimator(const HostClock* clock);
+
+    // Forgets everything; Rate() reads |nominal_rate| until re-estimated
+    void Reset(double nominal_rate);
+
+    // Returns false when |host_time| broke continuity and the estimate restarted
+    bool Update(uint64_t host_time, size_t num_frames);
+
+    // Enough span behind Rate() to trust it
+    bool HasEstimate() const { return has_estimate_; }
+
+    // Frames per second of host time
+    double Rate() const { return rate_; }
+
+private:
+    const HostClock* clock_;
+
+    bool started_ = false;
+    bool has_estimate_ = false;
+    double rate_ = 48000.0;
+
+    // Anchor of the current slope and the one that replaces it half a window on
+    uint64_t anchor_host_ = 0;
+    uint64_t anchor_frames_ = 0;
+    uint64_t next_anchor_host_ = 0;
+    uint64_t next_anchor_frames_ = 0;
+    bool has_next_anchor_ = false;
+
+    uint64_t frames_ = 0;        // frames up to the newest buffer's start
+    uint64_t last_host_ = 0;     // newest buffer's start
+    size_t last_frames_ = 0;
+};
+
+// Playout times for a stream stamped only by when its chunks arrive (JS
+// system audio from audiotee or pw-record), which come in bursts. The stream
+// itself is continuous, so a chunk is placed at a base time plus the frames
+// before it; the base is the least-delayed arrival of the last window
+// (arrival minus stream position, at its minimum), so bursts collapse onto a
+// steady frame clock and the window follows drift. How late chunks arrive
+// over the base is the jitter a consumer should wait out. A chunk later than
+// kResyncMs over the base is the stream restarting after a stop, and
+// re-anchors.
+class ArrivalDejitter {
+public:
+    explicit ArrivalDejitter(const HostClock* clock);
+
+    void Reset(double sample_rate);
+
+    // Host time of the first frame of a chunk of |num_frames| whose last
+    // frame arrived at |arrival_host|
+    uint64_t Place(uint64_t arrival_host, size_t num_frames);
+
+    // Latest arrival over the base in the last window
+    double JitterMs() const;
+
+private:
+    void StartWindow(double now_ms, double offset_ms);
+
+    const HostClock* clock_;
+    double sample_rate_ = 48000.0;
+    bool started_ = false;
+    uint64_t frames_ = 0;  // since the anchor, up to the newest chunk's start
+
+    // Arrival minus position (ms) at its least and lateness at its most, over
+    // this half window and the last
+    double min_offset_ms_[2] = {0.0, 0.0};
+    double max_late_ms_[2] = {0.0, 0.0};
+    double window_start_ms_ = 0.0;
+};
+
+// Resamples interleaved audio by a ratio near 1 that may change on every
+// call (4-point cubic Hermite). |ratio| is output frames per input frame;
+// the read position carries over between calls, so a steady stream stays
+// continuous across buffers. Adds a fixed two-frame delay.
+class DriftResampler {
+public:
+    // |max_samples| bounds num_frames * channels per call
+    DriftResampler(size_t max_samples, size_t max_channels);
+
+    // Also needed when the channel count changes
+    void Reset();
+
+    // Returns the frames written to |output|: num_frames * ratio give or take
+    // one, and never more than |output_capacity|
+    size_t Process(const float* input, size_t num_frames, size_t channels, double ratio,
+                   float* output, size_t output_capacity);
+
+private:
+    static constexpr size_t kHistoryFrames = 3;
+
+    const size_t max_samples_;
+    const size_t max_channels_;
+    std::vector<float> work_;   // history frames, then this call's input
+    double position_ = 1.0;     // next output frame, in work_ frames
+};
+
+} // namespace kakarot
@@ -0,0 +1,321 @@
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__APPLE__)
+#include <Accelerate/Accelerate.h>
+#endif
+
+namespace kakarot {
+namespace dsp {
+
+#if defined(__APPLE__)
+
+void SumSquaresAndPeak(const float* data, size_t num_samples, float* sum_squares, float* peak) {
+    vDSP_svesq(data, 1, sum_squares, num_samples);
+    vDSP_maxmgv(data, 1, peak, num_samples);
+}
+
+void MultiplyAdd(const float* src, float gain, float* dst, size_t num_samples) {
+    vDSP_vsma(src, 1, &gain, dst, 1, dst, 1, num_samples);
+}
+
+void Deinterleave(const float* src, size_t num_frames, int num_channels, int channel, float* dst) {
+    cblas_scopy(static_cast<int>(num_frames), src + channel, num_channels, dst, 1);
+}
+
+void AddChannel(const float* src, size_t num_frames, int num_channels, int channel, float gain, float* dst) {
+    vDSP_vsma(src + channel, num_channels, &gain, dst, 1, dst, 1, num_frames);
+}
+
+void Downmix(const float* src, size_t num_frames, int num_channels, float* dst) {
+    if (num_channels == 1) {
+        cblas_scopy(static_cast<int>(num_frames), src, 1, dst, 1);
+        return;
+    }
+    vDSP_vadd(src, num_channels, src + 1, num_channels, dst, 1, num_frames);
+    for (int ch = 2; ch < num_channels; ++ch) {
+        vDSP_vadd(src + ch, num_channels, dst, 1, dst, 1, num_frames);
+    }
+    float scale = 1.0f / num_channels;
+    vDSP_vsmul(dst, 1, &scale, dst, 1, num_frames);
+}
+
+void DownmixS16(const int16_t* src, size_t num_frames, int num_channels, float* dst) {
+    vDSP_vflt16(src, num_channels, dst, 1, num_frames);
+    if (num_channels > 1) {
+        // Further channels are widened a block at a time onto the first
+        float block[256];
+        for (size_t offset = 0; offset < num_frames; offset += 256) {
+            size_t length = std::min<size_t>(256, num_frames - offset);
+            for (int ch = 1; ch < num_channels; ++ch) {
+                vDSP_vflt16(src + offset * num_channels + ch, num_channels, block, 1, length);
+                vDSP_vadd(dst + offset, 1, block, 1, dst + offset, 1, length);
+            }
+        }
+    }
+    float scale = 1.0f / (32768.0f * num_channels);
+    vDSP_vsmul(dst, 1, &scale, dst, 1, num_frames);
+}
+
+float DotProduct(const float* a, const float* b, size_t n) {
+    float result = 0.0f;
+    vDSP_dotpr(a, 1, b, 1, &result, n);
+    return result;
+}
+
+void HalfToFloat(const uint16_t* src, float* dst, size_t n) {
+    vImage_Buffer in{const_cast<uint16_t*>(src), 1, n, n * sizeof(uint16_t)};
+    vImage_Buffer out{dst, 1, n, n * sizeof(float)};
+    vImageConvert_Planar16FtoPlanarF(&in, &out, kvImageNoFlags);
+}
+
+static DSPSplitComplex Split(const float* re, const float* im) {
+    return DSPSplitComplex{const_cast<float*>(re), const_cast<float*>(im)};
+}
+
+// The bins between DC and Nyquist as a split view with stride 2
+static DSPSplitComplex OrderedBins(const float* spectrum) {
+    return Split(spectrum + 2, spectrum + 3);
+}
+
+void OrderedPower(const float* spectrum, size_t fft_size, float* power) {
+    const size_t half = fft_size / 2;
+    power[0] = spectrum[0] * spectrum[0];
+    power[half] = spectrum[1] * spectrum[1];
+    DSPSplitComplex bins = OrderedBins(spectrum);
+    vDSP_zvmags(&bins, 2, power + 1, 1, half - 1);
+}
+
+void UnpackOrdered(const float* spectrum, size_t fft_size, float* re, float* im) {
+    const size_t half = fft_size / 2;
+    re[0] = spectrum[0];
+    im[0] = 0.0f;
+    re[half] = spectrum[1];
+    im[half] = 0.0f;
+    DSPSplitComplex out = Split(re + 1, im + 1);
+    vDSP_ctoz(reinterpret_cast<const DSPComplex*>(spectrum + 2), 2, &out, 1, half - 1);
+}
+
+void PackOrdered(const float* re, const float* im, size_t fft_size, float* spectrum) {
+    const size_t half = fft_size / 2;
+    spectrum[0] = re[0];
+    spectrum[1] = re[half];
+    DSPSplitComplex in = Split(re + 1, im + 1);
+    vDSP_ztoc(&in, 1, reinterpret_cast<DSPComplex*>(spectrum + 2), 2, half - 1);
+}
+
+void ScaleOrdered(const float* gains, size_t fft_size, float* spectrum) {
+    const size_t half = fft_size / 2;
+    spectrum[0] *= gains[0];
+    spectrum[1] *= gains[half];
+    DSPSplitComplex bins = OrderedBins(spectrum);
+    vDSP_zrvmul(&bins, 2, gains + 1, 1, &bins, 2, half - 1);
+}
+
+void ComplexMultiplyAccumulate(const float* a_re, const float* a_im, const float* b_re, const float* b_im,
+                               float* c_re, float* c_im, size_t n) {
+    DSPSplitComplex a = Split(a_re, a_im);
+    DSPSplitComplex b = Split(b_re, b_im);
+    DSPSplitComplex c = Split(c_re, c_im);
+    vDSP_zvma(&a, 1, &b, 1, &c, 1, &c, 1, n);
+}
+
+void ConjugateMultiplyAccumulate(const float* a_re, const float* a_im, const float* b_re, const float* b_im,
+                                 float* c_re, float* c_im, size_t n) {
+    DSPSplitComplex a = Split(a_re, a_im);
+    DSPSplitComplex b = Split(b_re, b_im);
+    DSPSplitComplex c = Split(c_re, c_im);
+    vDSP_zvcma(&a, 1, &b, 1, &c, 1, &c, 1, n);
+}
+
+#else
+
+// Independent lanes let the compiler vectorize without -ffast-math
+static constexpr size_t kLanes = 8;
+
+void SumSquaresAndPeak(const float* data, size_t num_samples, float* sum_squares, float* peak) {
+    float sum[kLanes] = {};
+    float max[kLanes] = {};
+    size_t i = 0;
+    for (; i + kLanes <= num_samples; i += kLanes) {
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            float value = data[i + lane];
+            sum[lane] += value * value;
+            max[lane] = std::max(max[lane], std::abs(value));
+        }
+    }
+    for (; i < num_samples; ++i) {
+        sum[0] += data[i] * data[i];
+        max[0] = std::max(max[0], std::abs(data[i]));
+    }
+    *sum_squares = 0.0f;
+    *peak = 0.0f;
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+        *sum_squares += sum[lane];
+        *peak = std::max(*peak, max[lane]);
+    }
+}
+
+float DotProduct(const float* a, const float* b, size_t n) {
+    float sum[kLanes] = {};
+    size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes) {
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            sum[lane] += a[i + lane] * b[i + lane];
+        }
+    }
+    for (; i < n; ++i) {
+        sum[0] += a[i] * b[i];
+    }
+    float result = 0.0f;
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+        result += sum[lane];
+    }
+    return result;
+}
+
+// Exponent and mantissa shifted into place and rescaled by 2^112, which
+// also gets subnormals right; infinities and NaNs are not expected
+void HalfToFloat(const uint16_t* src, float* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t sign = static_cast<uint32_t>(src[i] & 0x8000u) << 16;
+        uint32_t bits = static_cast<uint32_t>(src[i] & 0x7fffu) << 13;
+        float magnitude;
+        std::memcpy(&magnitude, &bits, sizeof(magnitude));
+        magnitude *= 0x1p112f;
+        std::memcpy(&bits, &magnitude, sizeof(bits));
+        bits |= sign;
+        std::memcpy(&dst[i], &bits, sizeof(bits));
+    }
+}
+
+void MultiplyAdd(const float* src, float gain, float* dst, size_t num_samples) {
+    for (size_t i = 0; i < num_samples; ++i) {
+        dst[i] += gain * src[i];
+    }
+}
+
+void Deinterleave(const float* src, size_t num_frames, int num_channels, int channel, float* dst) {
+    for (size_t i = 0; i < num_frames; ++i) {
+        dst[i] = src[i * num_channels + channel];
+    }
+}
+
+void AddChannel(const float* src, size_t num_frames, int num_channels, int channel, float gain, float* dst) {
+    for (size_t i = 0; i < num_frames; ++i) {
+        dst[i] += gain * src[i * num_channels + channel];
+    }
+}
+
+void Downmix(const float* src, size_t num_frames, int num_channels, float* dst) {
+    float scale = 1.0f / num_channels;
+    if (num_channels == 2) {
+        for (size_t i = 0; i < num_frames; ++i) {
+            dst[i] = (src[2 * i] + src[2 * i + 1]) * scale;
+        }
+        return;
+    }
+    for (size_t i = 0; i < num_frames; ++i) {
+        float sum = 0.0f;
+        for (int ch = 0; ch < num_channels; ++ch) {
+            sum += src[i * num_channels + ch];
+        }
+        dst[i] = sum * scale;
+    }
+}
+
+void DownmixS16(const int16_t* src, size_t num_frames, int num_channels, float* dst) {
+    float scale = 1.0f / (32768.0f * num_channels);
+    if (num_channels == 1) {
+        for (size_t i = 0; i < num_frames; ++i) {
+            dst[i] = src[i] * scale;
+        }
+        return;
+    }
+    if (num_channels == 2) {
+        for (size_t i = 0; i < num_frames; ++i) {
+            dst[i] = (src[2 * i] + src[2 * i + 1]) * scale;
+        }
+        return;
+    }
+    for (size_t i = 0; i < num_frames; ++i) {
+        int sum = 0;
+        for (int ch = 0; ch < num_channels; ++ch) {
+            sum += src[i * num_channels + ch];
+        }
+        dst[i] = sum * scale;
+    }
+}
+
+void OrderedPower(const float* spectrum, size_t fft_size, float* __restrict power) {
+    const size_t half = fft_size / 2;
+    power[0] = spectrum[0] * spectrum[0];
+    power[half] = spectrum[1] * spectrum[1];
+    for (size_t k = 1; k < half; ++k) {
+        power[k] = spectrum[2 * k] * spectrum[2 * k] + spectrum[2 * k + 1] * spectrum[2 * k + 1];
+    }
+}
+
+void UnpackOrdered(const float* spectrum, size_t fft_size, float* __restrict re, float* __restrict im) {
+    const size_t half = fft_size / 2;
+    re[0] = spectrum[0];
+    im[0] = 0.0f;
+    re[half] = spectrum[1];
+    im[half] = 0.0f;
+    for (size_t k = 1; k < half; ++k) {
+        re[k] = spectrum[2 * k];
+        im[k] = spectrum[2 * k + 1];
+    }
+}
+
+void PackOrdered(const float* re, const float* im, size_t fft_size, float* __restrict spectrum) {
+    const size_t half = fft_size / 2;
+    spectrum[0] = re[0];
+    spectrum[1] = re[half];
+    for (size_t k = 1; k < half; ++k) {
+        spectrum[2 * k] = re[k];
+        spectrum[2 * k + 1] = im[k];
+    }
+}
+
+void ScaleOrdered(const float* gains, size_t fft_size, float* __restrict spectrum) {
+    const size_t half = fft_size / 2;
+    spectrum[0] *= gains[0];
+    spectrum[1] *= gains[half];
+    for (size_t k = 1; k < half; ++k) {
+        spectrum[2 * k] *= gains[k];
+        spectrum[2 * k + 1] *= gains[k];
+    }
+}
+
+void ComplexMultiplyAccumulate(const float* a_re, const float* a_im, const float* b_re, const float* b_im,
+                               float* __restrict c_re, float* __restrict c_im, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        c_re[i] += a_re[i] * b_re[i] - a_im[i] * b_im[i];
+        c_im[i] += a_re[i] * b_im[i] + a_im[i] * b_re[i];
+    }
+}
+
+void ConjugateMultiplyAccumulate(const float* a_re, const float* a_im, const float* b_re, const float* b_im,
+                                 float* __restrict c_re, float* __restrict c_im, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        c_re[i] += a_re[i] * b_re[i] + a_im[i] * b_im[i];
+        c_im[i] += a_re[i] * b_im[i] - a_im[i] * b_re[i];
+    }
+}
+
+#endif
+
+// Integer sums vectorize as written, Accelerate or not
+int32_t DotProductS8(const int8_t* a, const int8_t* b, size_t n) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += static_cast<int16_t>(a[i]) * static_cast<int16_t>(b[i]);
+    }
+    return sum;
+}
+
+} // namespace dsp
+} // namespace kakarot
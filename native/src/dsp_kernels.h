@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kakarot {
+
+// Per-sample kernels shared by the addon's own DSP loops. On macOS they go
+// through Accelerate (vDSP / BLAS), which picks the NEON or SSE/AVX path for
+// the running CPU itself; elsewhere they are plain loops left to the
+// compiler's auto-vectorizer.
+namespace dsp {
+
+// Sum of squares and peak magnitude of |data| in one call
+void SumSquaresAndPeak(const float* data, size_t num_samples, float* sum_squares, float* peak);
+
+// dst[i] += gain * src[i]
+void MultiplyAdd(const float* src, float gain, float* dst, size_t num_samples);
+
+// Channel |channel| of |num_frames| interleaved frames into planar |dst|
+void Deinterleave(const float* src, size_t num_frames, int num_channels, int channel, float* dst);
+
+// dst[i] += gain * channel |channel| of |num_frames| interleaved frames
+void AddChannel(const float* src, size_t num_frames, int num_channels, int channel, float gain, float* dst);
+
+// Mean of the channels of |num_frames| interleaved frames into mono |dst|
+void Downmix(const float* src, size_t num_frames, int num_channels, float* dst);
+
+// Mean of the channels of |num_frames| interleaved s16 frames into mono float
+// |dst| in [-1, 1); with one channel a plain conversion
+void DownmixS16(const int16_t* src, size_t num_frames, int num_channels, float* dst);
+
+// Sum of a[i] * b[i]
+float DotProduct(const float* a, const float* b, size_t n);
+
+// Sum of a[i] * b[i] in 32 bits; exact for n up to 2^17
+int32_t DotProductS8(const int8_t* a, const int8_t* b, size_t n);
+
+// IEEE half precision to float, for |n| values
+void HalfToFloat(const uint16_t* src, float* dst, size_t n);
+
+// A real FFT of |fft_size| in pffft's ordered layout, [DC, Nyquist, re1,
+// im1, re2, im2, ...], and its fft_size / 2 + 1 bins from DC to Nyquist:
+// their power
+void OrderedPower(const float* spectrum, size_t fft_size, float* power);
+
+// As split-complex |re| and |im|, and back (DC's and Nyquist's imaginary
+// parts are zero)
+void UnpackOrdered(const float* spectrum, size_t fft_size, float* re, float* im);
+void PackOrdered(const float* re, const float* im, size_t fft_size, float* spectrum);
+
+// Each bin times its |gains| entry, in place
+void ScaleOrdered(const float* gains, size_t fft_size, float* spectrum);
+
+// Split-complex vectors (separate real and imaginary arrays) of |n| bins:
+// c += a * b
+void ComplexMultiplyAccumulate(const float* a_re, const float* a_im, const float* b_re, const float* b_im,
+                               float* c_re, float* c_im, size_t n);
+
+// c += conj(a) * b
+void ConjugateMultiplyAccumulate(const float* a_re, const float* a_im, const float* b_re, const float* b_im,
+                                 float* c_re, float* c_im, size_t n);
+
+} // namespace dsp
+} // namespace kakarot
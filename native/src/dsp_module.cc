@@ -0,0 +1,36 @@
+#include "dsp_module.h"
+#include "api/audio/builtin_audio_processing_builder.h"
+#include "api/environment/environment_factory.h"
+#include "api/task_queue/default_task_queue_factory.h"
+
+// The kakarot_dsp side: everything here is what pulls the APM in
+
+namespace {
+
+webrtc::AudioProcessing* BuildApm(const webrtc::AudioProcessing::Config* config,
+                                  const webrtc::EchoCanceller3Config* aec3,
+                                  const webrtc::EchoCanceller3Config* multichannel_aec3) {
+    webrtc::Environment env = webrtc::CreateEnvironment();
+    webrtc::BuiltinAudioProcessingBuilder builder(*config);
+    std::optional<webrtc::EchoCanceller3Config> multichannel;
+    if (multichannel_aec3) {
+        multichannel = *multichannel_aec3;
+    }
+    builder.SetEchoCancellerConfig(*aec3, multichannel);
+    webrtc::scoped_refptr<webrtc::AudioProcessing> apm = builder.Build(env);
+    return apm.release();
+}
+
+webrtc::TaskQueueBase* CreateTaskQueue(const char* name) {
+    return webrtc::CreateDefaultTaskQueueFactory()
+        ->CreateTaskQueue(name, webrtc::TaskQueueFactory::Priority::LOW)
+        .release();
+}
+
+const KakarotDspApi kApi = {kDspModuleVersion, &BuildApm, &CreateTaskQueue};
+
+} // namespace
+
+extern "C" const KakarotDspApi* KakarotDspModule() {
+    return &kApi;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "api/audio/audio_processing.h"
+#include "api/audio/echo_canceller3_config.h"
+#include "api/scoped_refptr.h"
+#include "api/task_queue/task_queue_base.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+// kakarot_dsp: WebRTC's audio processing module (AEC3, NS, AGC2 and the
+// AEC dump's protobuf), built apart from audio_capture_native so loading
+// the addon maps only the capture, transport and lighter DSP code. The
+// addon loads it from beside itself the first time an AEC needs an APM.
+// Both sides are built from one tree against the same WebRTC headers, so
+// the table below passes C++ objects; the version only guards against a
+// stale file.
+constexpr uint32_t kDspModuleVersion = 1;
+
+struct KakarotDspApi {
+    uint32_t version;
+    // An APM with one reference the caller adopts; nullptr if it would not build
+    webrtc::AudioProcessing* (*build_apm)(const webrtc::AudioProcessing::Config* config,
+                                          const webrtc::EchoCanceller3Config* aec3,
+                                          const webrtc::EchoCanceller3Config* multichannel_aec3);
+    // A low-priority queue for the AEC dump's writes; the caller deletes it
+    webrtc::TaskQueueBase* (*create_task_queue)(const char* name);
+};
+
+#if defined(_WIN32)
+#define KAKAROT_DSP_EXPORT __declspec(dllexport)
+#else
+#define KAKAROT_DSP_EXPORT __attribute__((visibility("default")))
+#endif
+
+// The module's one export
+extern "C" KAKAROT_DSP_EXPORT const KakarotDspApi* KakarotDspModule();
+constexpr const char* kDspModuleSymbol = "KakarotDspModule";
+
+namespace kakarot {
+
+// The module's table, loaded on first call (any thread, once); nullptr when
+// the file is missing or from another build, and the AEC runs its fallback.
+// Tools that link dsp_module.cc in define KAKAROT_DSP_STATIC and never load.
+const KakarotDspApi* DspModule();
+
+// Whether DspModule() has been asked for and found it, without loading
+bool IsDspModuleLoaded();
+
+// The module's APM for |config| and AEC3 tuning, adopted
+webrtc::scoped_refptr<webrtc::AudioProcessing> BuildDspApm(
+    const webrtc::AudioProcessing::Config& config, const webrtc::EchoCanceller3Config& aec3,
+    const std::optional<webrtc::EchoCanceller3Config>& multichannel_aec3);
+
+std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> CreateDspTaskQueue(const char* name);
+
+} // namespace kakarot
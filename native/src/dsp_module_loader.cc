@@ -0,0 +1,122 @@
+#include "dsp_module.h"
+#include "native_log.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#if !defined(KAKAROT_DSP_STATIC)
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+#endif
+
+namespace kakarot {
+
+static const char* const kLogSource = "DspModule";
+
+namespace {
+
+std::once_flag g_once;
+const KakarotDspApi* g_api = nullptr;
+std::atomic<bool> g_loaded{false};
+
+#if defined(KAKAROT_DSP_STATIC)
+
+const KakarotDspApi* Load() {
+    return KakarotDspModule();
+}
+
+#elif defined(_WIN32)
+
+// kakarot_dsp.node from the directory this addon was loaded from
+const KakarotDspApi* Load() {
+    HMODULE self = nullptr;
+    wchar_t path[MAX_PATH];
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                            reinterpret_cast<LPCWSTR>(&Load), &self) ||
+        GetModuleFileNameW(self, path, MAX_PATH) == 0) {
+        Log(LogLevel::kWarn, kLogSource, "Cannot locate the addon to load kakarot_dsp beside");
+        return nullptr;
+    }
+    std::wstring module = path;
+    module = module.substr(0, module.find_last_of(L"\\/") + 1) + L"kakarot_dsp.node";
+    HMODULE library = LoadLibraryExW(module.c_str(), nullptr, LOAD_WITH_ALTERED_SEARCH_PATH);
+    if (!library) {
+        Log(LogLevel::kWarn, kLogSource, "kakarot_dsp did not load (error %lu)", GetLastError());
+        return nullptr;
+    }
+    auto entry = reinterpret_cast<const KakarotDspApi* (*)()>(GetProcAddress(library, kDspModuleSymbol));
+    return entry ? entry() : nullptr;
+}
+
+#else
+
+// kakarot_dsp.node from the directory this addon was loaded from, its
+// WebRTC symbols kept to itself
+const KakarotDspApi* Load() {
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(&Load), &info) == 0 || !info.dli_fname) {
+        Log(LogLevel::kWarn, kLogSource, "Cannot locate the addon to load kakarot_dsp beside");
+        return nullptr;
+    }
+    std::string module = info.dli_fname;
+    const size_t slash = module.find_last_of('/');
+    module = (slash == std::string::npos ? std::string() : module.substr(0, slash + 1)) + "kakarot_dsp.node";
+    void* library = dlopen(module.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        Log(LogLevel::kWarn, kLogSource, "kakarot_dsp did not load: %s", dlerror());
+        return nullptr;
+    }
+    auto entry = reinterpret_cast<const KakarotDspApi* (*)()>(dlsym(library, kDspModuleSymbol));
+    return entry ? entry() : nullptr;
+}
+
+#endif
+
+} // namespace
+
+const KakarotDspApi* DspModule() {
+    std::call_once(g_once, [] {
+        const KakarotDspApi* api = Load();
+        if (api && api->version != kDspModuleVersion) {
+            Log(LogLevel::kError, kLogSource, "kakarot_dsp is version %u, this addon needs %u", api->version,
+                kDspModuleVersion);
+            api = nullptr;
+        }
+        if (!api) {
+            Log(LogLevel::kWarn, kLogSource, "No WebRTC APM; echo cancellation uses the fallback canceller");
+        }
+        g_api = api;
+        g_loaded.store(api != nullptr, std::memory_order_release);
+    });
+    return g_api;
+}
+
+bool IsDspModuleLoaded() {
+    return g_loaded.load(std::memory_order_acquire);
+}
+
+webrtc::scoped_refptr<webrtc::AudioProcessing> BuildDspApm(
+    const webrtc::AudioProcessing::Config& config, const webrtc::EchoCanceller3Config& aec3,
+    const std::optional<webrtc::EchoCanceller3Config>& multichannel_aec3) {
+    const KakarotDspApi* api = DspModule();
+    if (!api) {
+        return nullptr;
+    }
+    webrtc::AudioProcessing* apm = api->build_apm(&config, &aec3, multichannel_aec3 ? &*multichannel_aec3 : nullptr);
+    // Adopts the module's reference
+    webrtc::scoped_refptr<webrtc::AudioProcessing> adopted(apm);
+    if (apm) {
+        apm->Release();
+    }
+    return adopted;
+}
+
+std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter> CreateDspTaskQueue(const char* name) {
+    const KakarotDspApi* api = DspModule();
+    return std::unique_ptr<webrtc::TaskQueueBase, webrtc::TaskQueueDeleter>(api ? api->create_task_queue(name)
+                                                                                 : nullptr);
+}
+
+} // namespace kakarot
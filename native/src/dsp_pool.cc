@@ -0,0 +1,173 @@
+#include "dsp_pool.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include <algorithm>
+#include <chrono>
+
+namespace kakarot {
+
+// Two pool threads from this many cores; the device threads and JS need
+// the rest
+static constexpr size_t kTwoThreadCores = 4;
+
+// An idle pool thread checks for stopping this often
+static constexpr int64_t kIdleWaitNs = 500ll * 1000 * 1000;
+
+static WakeupCounter g_wakeups("dspPool");
+
+static uint64_t SteadyNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void DspJob::Wake() {
+    DspPool* pool = pool_.load(std::memory_order_acquire);
+    if (pool) {
+        pool->Wake(slot_.load(std::memory_order_relaxed));
+    }
+}
+
+DspJobStats DspJob::Stats() const {
+    DspJobStats stats;
+    stats.runs = runs_.load(std::memory_order_relaxed);
+    stats.deadline_misses = misses_.load(std::memory_order_relaxed);
+    stats.busy_ns = busy_ns_.load(std::memory_order_relaxed);
+    stats.deadline_ns = deadline_ns_;
+    stats.latency_us = latency_us_.Summarize();
+    return stats;
+}
+
+DspPool::DspPool(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&DspPool::ThreadLoop, this);
+    }
+}
+
+DspPool::~DspPool() {
+    stopping_.store(true, std::memory_order_release);
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        wake_.Signal();
+    }
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+DspPool& DspPool::Shared() {
+    // Leaked: sessions of any env may still be stopping at exit
+    static DspPool* pool = new DspPool(std::thread::hardware_concurrency() >= kTwoThreadCores ? 2 : 1);
+    return *pool;
+}
+
+bool DspPool::Add(DspJob* job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < kMaxJobs; ++i) {
+        Slot& slot = slots_[i];
+        if (slot.job.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        slot.queued.store(false, std::memory_order_relaxed);
+        slot.job.store(job, std::memory_order_release);
+        job->slot_.store(i, std::memory_order_relaxed);
+        job->pool_.store(this, std::memory_order_release);
+        return true;
+    }
+    return false;
+}
+
+void DspPool::Remove(DspJob* job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (job->pool_.load(std::memory_order_relaxed) != this) {
+        return;
+    }
+    Slot& slot = slots_[job->slot_.load(std::memory_order_relaxed)];
+    job->pool_.store(nullptr, std::memory_order_release);
+    slot.job.store(nullptr, std::memory_order_seq_cst);
+    // A thread that claimed the slot before the store may be in Run();
+    // one that claims it after finds it empty
+    while (slot.claimed.load(std::memory_order_seq_cst)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    slot.queued.store(false, std::memory_order_relaxed);
+}
+
+void DspPool::Wake(size_t index) {
+    Slot& slot = slots_[index];
+    if (!slot.queued.exchange(true, std::memory_order_acq_rel)) {
+        DspJob* job = slot.job.load(std::memory_order_acquire);
+        uint64_t now = SteadyNs();
+        slot.woken_ns.store(now, std::memory_order_relaxed);
+        slot.due_ns.store(now + (job ? job->deadline_ns_ : 0), std::memory_order_release);
+    }
+    wake_.Signal();
+}
+
+size_t DspPool::Claim() {
+    for (;;) {
+        size_t best = kMaxJobs;
+        uint64_t best_due = 0;
+        for (size_t i = 0; i < kMaxJobs; ++i) {
+            Slot& slot = slots_[i];
+            if (!slot.queued.load(std::memory_order_acquire) || slot.claimed.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            uint64_t due = slot.due_ns.load(std::memory_order_acquire);
+            if (best == kMaxJobs || due < best_due) {
+                best = i;
+                best_due = due;
+            }
+        }
+        if (best == kMaxJobs) {
+            return kMaxJobs;
+        }
+        bool expected = false;
+        if (slots_[best].claimed.compare_exchange_strong(expected, true, std::memory_order_seq_cst)) {
+            return best;
+        }
+        // Another thread took it first; look again
+    }
+}
+
+void DspPool::ThreadLoop() {
+    ScopedThreadCpu cpu("dspPool");
+    SetCurrentThreadPriority(ThreadPriority::kInteractive);
+    while (!stopping_.load(std::memory_order_acquire)) {
+        size_t index = Claim();
+        if (index == kMaxJobs) {
+            wake_.WaitFor(kIdleWaitNs);
+            g_wakeups.Count();
+            continue;
+        }
+        Slot& slot = slots_[index];
+        DspJob* job = slot.job.load(std::memory_order_seq_cst);
+        if (job && slot.queued.exchange(false, std::memory_order_acq_rel)) {
+            const uint64_t woken = slot.woken_ns.load(std::memory_order_relaxed);
+            const uint64_t start = SteadyNs();
+            job->Run();
+            const uint64_t end = SteadyNs();
+            job->runs_.fetch_add(1, std::memory_order_relaxed);
+            job->busy_ns_.fetch_add(end - start, std::memory_order_relaxed);
+            job->latency_us_.Record((end - std::min(woken, start)) / 1000);
+            runs_.fetch_add(1, std::memory_order_relaxed);
+            if (end - std::min(woken, start) > job->deadline_ns_) {
+                job->misses_.fetch_add(1, std::memory_order_relaxed);
+                misses_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        slot.claimed.store(false, std::memory_order_seq_cst);
+    }
+}
+
+DspPool::Stats DspPool::GetStats() const {
+    Stats stats;
+    stats.threads = threads_.size();
+    for (const Slot& slot : slots_) {
+        stats.jobs += slot.job.load(std::memory_order_relaxed) ? 1 : 0;
+    }
+    stats.runs = runs_.load(std::memory_order_relaxed);
+    stats.deadline_misses = misses_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace kakarot
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "latency_histogram.h"
+#include "platform_thread.h"
+
+namespace kakarot {
+
+class DspPool;
+
+// One job's share of the pool, since it was added
+struct DspJobStats {
+    uint64_t runs = 0;
+    uint64_t deadline_misses = 0;  // runs that finished past their deadline
+    uint64_t busy_ns = 0;          // inside Run()
+    uint64_t deadline_ns = 0;
+    LatencySummary latency_us;     // wake to Run() returning
+};
+
+// Streaming work the pool runs when its producer has queued some: a
+// capture session's graph, fed from a device's real-time thread through
+// rings. A job runs on one pool thread at a time, so Run() needs no lock
+// of its own.
+class DspJob {
+public:
+    virtual ~DspJob() = default;
+
+    // Pool thread. Drains what was queued; a Wake() during the run runs
+    // the job again.
+    virtual void Run() = 0;
+
+    // The producer's side, any thread and realtime-safe: queue a run.
+    // Ignored until the job is added and after it is removed.
+    void Wake();
+
+    // Before the job is added. How long a run may take from its Wake():
+    // the earliest deadline runs first, and later runs count as misses.
+    void SetDeadlineNs(uint64_t deadline_ns) { deadline_ns_ = deadline_ns; }
+
+    DspJobStats Stats() const;
+
+private:
+    friend class DspPool;
+
+    std::atomic<DspPool*> pool_{nullptr};
+    std::atomic<size_t> slot_{0};
+    uint64_t deadline_ns_ = 20 * 1000 * 1000;
+    std::atomic<uint64_t> runs_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> busy_ns_{0};
+    LatencyHistogram latency_us_;  // written by whichever thread holds the job
+};
+
+// A fixed set of DSP threads shared by every capture session in the
+// process, so a second meeting or a mic preview adds jobs, not threads.
+// Queued jobs run earliest deadline first; a thread takes a job by its
+// slot's claim, so the same job never runs twice at once and one session
+// falling behind delays only the runs queued after its own. Threads run at
+// interactive priority and never block on a job's producer. Thread-safe.
+class DspPool {
+public:
+    static constexpr size_t kMaxJobs = 32;
+
+    explicit DspPool(size_t threads);
+    ~DspPool();
+
+    DspPool(const DspPool&) = delete;
+    DspPool& operator=(const DspPool&) = delete;
+
+    // The process's pool, created on first use: two threads from four
+    // cores, one below
+    static DspPool& Shared();
+
+    // JS thread. False when kMaxJobs are in; |job| may be woken from now on
+    bool Add(DspJob* job);
+
+    // JS thread. Returns once no thread is running |job| and none will; its
+    // producer should be stopped first, and a queued run is dropped.
+    void Remove(DspJob* job);
+
+    size_t ThreadCount() const { return threads_.size(); }
+
+    struct Stats {
+        size_t threads = 0;
+        size_t jobs = 0;
+        uint64_t runs = 0;
+        uint64_t deadline_misses = 0;
+    };
+    Stats GetStats() const;
+
+private:
+    friend class DspJob;
+
+    // A job's place in the pool. The pool threads touch only the slot until
+    // they hold its claim, so Remove() waits for no more than one run.
+    struct Slot {
+        std::atomic<DspJob*> job{nullptr};
+        std::atomic<bool> queued{false};
+        std::atomic<bool> claimed{false};
+        std::atomic<uint64_t> woken_ns{0};  // when the queued run was asked for
+        std::atomic<uint64_t> due_ns{0};    // woken_ns plus the job's deadline
+    };
+
+    void Wake(size_t slot);
+    // The queued, unclaimed slot due first, claimed; kMaxJobs when none
+    size_t Claim();
+    void ThreadLoop();
+
+    std::array<Slot, kMaxJobs> slots_;
+    std::mutex mutex_;  // Add() and Remove()
+    Semaphore wake_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> runs_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::vector<std::thread> threads_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,624 @@
+#include "echo_cancel_pipeline.h"
+#include "meeting_recorder.h"
+#include "native_log.h"
+#include "pipeline_trace.h"
+#include "task_scheduler.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "rtc_base/denormal_disabler.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace kakarot {
+
+// Source tag of records this file writes to the native log ring
+static const char* const kLogSource = "EchoCancelPipeline";
+
+// Largest buffer either producer hands us; matches the IOProc sanity limit
+static constexpr size_t kMaxChunkSamples = 48000;
+
+// Capture is handed to the APM in steps of this length, each preceded by the
+// render that covers it
+static constexpr int kStepMs = 10;
+
+// Weight of each new delay measurement; keeps per-chunk jitter out of the APM
+static constexpr double kDelaySmoothing = 0.05;
+
+// Wake at least this often so capture held for its render is re-evaluated;
+// with none held the DSP thread waits untimed
+static constexpr int64_t kDspPollNs = 10 * 1000 * 1000;
+
+static WakeupCounter g_dsp_wakeups("aecDsp");
+static WakeupCounter g_render_wakeups("aecRender");
+
+// Capture picked up this long after its ring write has used half a step's
+// slack; background native work is told to hold off
+static constexpr double kLateWakeMs = kStepMs / 2.0;
+
+// Render layouts the drift resampler takes (the APM's reference maximum)
+static constexpr size_t kMaxRenderChannels = 8;
+
+// Clock mismatch beyond this is a misreported rate, not drift
+static constexpr double kMaxDrift = 0.001;
+
+// Weight of each new rate ratio; the estimates are already long-span slopes,
+// this only keeps the resampler's ratio from stepping
+static constexpr double kDriftSmoothing = 0.01;
+
+// Resampled render can come out a few frames longer than its input
+static constexpr size_t kDriftMarginFrames = 64;
+
+// A render chunk starting this much after the last one ended, or half its
+// own length if more (arrival-stamped chunks jitter by a fraction of one),
+// follows a dropped chunk, and the hole is fed as silence so the reference
+// keeps its timing. Holes longer than kMaxRenderGapMs are render stopping,
+// not a drop; feeding them in one go would overrun the APM's render buffer,
+// so the next chunk just follows on and AEC3 realigns as after a start.
+static constexpr double kMinRenderGapMs = 2.0;
+static constexpr double kMaxRenderGapMs = 500.0;
+
+// Arrival-stamped render covering a capture step comes in up to a chunk
+// plus the measured jitter after it; capture waits that long and this much
+// more for scheduling
+static constexpr double kRenderWaitMarginMs = 5.0;
+
+EchoCancelPipeline::EchoCancelPipeline(const HostClock* clock, size_t ring_samples, size_t ring_chunks)
+    : clock_(clock),
+      capture_ring_(ring_samples),
+      capture_chunks_(ring_chunks),
+      render_ring_(ring_samples),
+      render_chunks_(ring_chunks),
+      apm_render_ring_(ring_samples + kDriftMarginFrames * kMaxRenderChannels),
+      apm_render_chunks_(ring_chunks),
+      apm_render_buffer_(apm_render_ring_.Capacity()),
+      capture_rate_(clock),
+      render_rate_(clock),
+      render_dejitter_(clock),
+      drift_resampler_(kMaxChunkSamples, kMaxRenderChannels),
+      drift_buffer_(kMaxChunkSamples + kDriftMarginFrames * kMaxRenderChannels),
+      input_(kMaxChunkSamples),
+      render_buffer_(kMaxChunkSamples),
+      output_buffer_(kMaxChunkSamples) {}
+
+EchoCancelPipeline::~EchoCancelPipeline() {
+    Stop();
+}
+
+void EchoCancelPipeline::Start(AECProcessor* aec, CaptureStream* output, double sample_rate,
+                               double capture_sample_rate, double max_render_wait_ms, double output_latency_ms) {
+    if (IsRunning()) {
+        return;
+    }
+
+    aec_ = aec;
+    output_ = output;
+    sample_rate_ = sample_rate;
+    capture_sample_rate_ = capture_sample_rate;
+    step_samples_ = static_cast<size_t>(sample_rate * kStepMs / 1000);
+    output_latency_ms_ = output_latency_ms;
+    max_render_wait_ticks_ = clock_->MsToTicks(max_render_wait_ms);
+    render_wait_ticks_ = max_render_wait_ticks_;
+    render_dejitter_.Reset(sample_rate);
+    smoothed_delay_ms_ = -1.0;
+    talk_.Reset();
+    pending_render_offset_ = 0;
+
+    capture_ring_.Reset();
+    capture_chunks_.Reset();
+    render_ring_.Reset();
+    render_chunks_.Reset();
+    apm_render_ring_.Reset();
+    apm_render_chunks_.Reset();
+    has_pending_capture_ = false;
+    has_pending_render_ = false;
+    render_end_host_ = 0;
+    conceal_until_ = 0;
+    capture_rate_.Reset(capture_sample_rate);
+    render_rate_.Reset(sample_rate);
+    drift_resampler_.Reset();
+    drift_ratio_ = 1.0;
+    drift_channels_ = 0;
+    capture_paused_ = false;
+    aec_->SetRenderDriftPpm(std::nanf(""));  // unmeasured until both estimates settle
+    if (MeetingMixer::Supports(static_cast<int>(sample_rate))) {
+        mixer_.Prepare(static_cast<int>(sample_rate), aec_->OutputLatencySamples());
+    } else {
+        mixer_.Stop();
+    }
+    mix_generation_ = 0;
+
+    capture_resampler_.reset();
+    capture_block_fill_ = 0;
+    if (capture_sample_rate != sample_rate) {
+        // The smallest block pair in the exact ratio, repeated up to about
+        // 10ms; 44.1kHz -> 48kHz is 441 -> 480
+        int64_t in_rate = std::llround(capture_sample_rate);
+        int64_t out_rate = std::llround(sample_rate);
+        int64_t divisor = std::gcd(in_rate, out_rate);
+        size_t repeats = static_cast<size_t>(std::max<int64_t>(1, (in_rate / 100) / (in_rate / divisor)));
+        size_t block = static_cast<size_t>(in_rate / divisor) * repeats;
+        converted_block_ = static_cast<size_t>(out_rate / divisor) * repeats;
+        capture_resampler_ = std::make_unique<webrtc::PushSincResampler>(block, converted_block_);
+        capture_block_.assign(block, 0.0f);
+
+        // A whole chunk converted lands in input_ and output_buffer_
+        size_t converted_samples = (kMaxChunkSamples / block + 1) * converted_block_;
+        if (input_.size() < converted_samples) {
+            input_.resize(converted_samples);
+            output_buffer_.resize(converted_samples);
+        }
+    }
+
+    render_running_ = true;
+    render_thread_ = std::thread(&EchoCancelPipeline::RenderLoop, this);
+    dsp_running_ = true;
+    dsp_thread_ = std::thread(&EchoCancelPipeline::DspLoop, this);
+    running_.store(true, std::memory_order_release);
+}
+
+void EchoCancelPipeline::Stop() {
+    if (!IsRunning()) {
+        return;
+    }
+    running_.store(false, std::memory_order_release);
+
+    dsp_running_ = false;
+    signal_.Signal();
+    if (dsp_thread_.joinable()) {
+        dsp_thread_.join();
+    }
+    // After the DSP thread's flush, so the render it handed off goes in too
+    render_running_ = false;
+    render_signal_.Signal();
+    if (render_thread_.joinable()) {
+        render_thread_.join();
+    }
+
+    aec_ = nullptr;
+    output_ = nullptr;
+    SetWorkgroup(AudioWorkgroup());
+}
+
+void EchoCancelPipeline::SetWorkgroup(AudioWorkgroup workgroup) {
+    {
+        std::lock_guard<std::mutex> lock(workgroup_mutex_);
+        workgroup_ = std::move(workgroup);
+    }
+    workgroup_version_.fetch_add(1, std::memory_order_release);
+    signal_.Signal();
+}
+
+void EchoCancelPipeline::SetCapturePaused(bool paused) {
+    capture_paused_.store(paused, std::memory_order_release);
+    signal_.Signal();
+}
+
+void EchoCancelPipeline::SetOutputLatencyMs(double output_latency_ms) {
+    output_latency_ms_.store(std::max(0.0, output_latency_ms), std::memory_order_relaxed);
+}
+
+void EchoCancelPipeline::SetShadow(ShadowAec* shadow) {
+    shadow_.store(shadow, std::memory_order_release);
+}
+
+bool EchoCancelPipeline::PushCapture(const float* data, uint32_t num_samples, uint64_t host_time) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    if (num_samples == 0 || num_samples > kMaxChunkSamples) {
+        return false;
+    }
+    if (capture_ring_.AvailableToWrite() < num_samples || capture_chunks_.AvailableToWrite() < 1) {
+        TaskScheduler::ReportAudioDeadlinePressure();
+        return false;
+    }
+
+    CaptureChunkInfo chunk{host_time, 0, num_samples, HostTimeNow()};
+    capture_ring_.Write(data, num_samples);
+    capture_chunks_.Write(&chunk, 1);
+    signal_.Signal();
+    return true;
+}
+
+// Render alone never produces output, so it does not wake the DSP thread;
+// but while capture is paused only the DSP thread drains it
+void EchoCancelPipeline::PushRender(const float* data, uint32_t num_frames, uint32_t num_channels,
+                                    uint64_t host_time) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return;
+    }
+    size_t num_samples = static_cast<size_t>(num_frames) * num_channels;
+    if (num_samples == 0 || num_samples > kMaxChunkSamples ||
+        render_ring_.AvailableToWrite() < num_samples || render_chunks_.AvailableToWrite() < 1) {
+        return;
+    }
+
+    RenderChunkInfo chunk{host_time, num_frames, num_channels};
+    render_ring_.Write(data, num_samples);
+    render_chunks_.Write(&chunk, 1);
+    if (capture_paused_.load(std::memory_order_relaxed)) {
+        signal_.Signal();
+    }
+}
+
+void EchoCancelPipeline::PushArrivedRender(const float* data, uint32_t num_frames, uint32_t num_channels) {
+    if (!running_.load(std::memory_order_acquire) || num_frames == 0) {
+        return;
+    }
+    uint64_t host_time = render_dejitter_.Place(HostTimeNow(), num_frames);
+    double wait_ms = num_frames * 1000.0 / sample_rate_ + render_dejitter_.JitterMs() + kRenderWaitMarginMs;
+    render_wait_ticks_.store(std::min(max_render_wait_ticks_, clock_->MsToTicks(wait_ms)), std::memory_order_relaxed);
+    PushRender(data, num_frames, num_channels, host_time);
+}
+
+void EchoCancelPipeline::DspLoop() {
+    ScopedThreadCpu thread_cpu("aecDsp");
+    // No core pinning; real-time scheduling (or, refused that, the highest
+    // class) keeps this thread from being parked behind Electron's main and
+    // renderer work
+    RealtimeThreadScope realtime(kStepMs);
+
+    // Silence decays the APM's and the high-pass's filter states into
+    // denormals, which cost x86 10-100x per operation; flush them to zero
+    // for the life of the thread
+    webrtc::DenormalDisabler denormals;
+    if (!realtime.IsRealtime()) {
+        Log(LogLevel::kWarn, kLogSource, "Real-time scheduling refused; DSP thread runs at interactive priority");
+    }
+
+    WorkgroupMembership membership;
+    uint64_t workgroup_version = 0;
+    const uint64_t cpu_start = CurrentThreadCpuNs();
+    while (dsp_running_) {
+        if (has_pending_capture_) {
+            signal_.WaitFor(kDspPollNs);
+        } else {
+            signal_.Wait();
+        }
+        g_dsp_wakeups.Count();
+
+        uint64_t version = workgroup_version_.load(std::memory_order_acquire);
+        if (version != workgroup_version) {
+            AudioWorkgroup workgroup;
+            {
+                std::lock_guard<std::mutex> lock(workgroup_mutex_);
+                workgroup = workgroup_;
+            }
+            if (workgroup && !membership.Join(workgroup)) {
+                Log(LogLevel::kWarn, kLogSource, "Device IO workgroup refused the DSP thread");
+            } else if (!workgroup) {
+                membership.Leave();
+            }
+            workgroup_version = version;
+        }
+
+        Pump(false);
+        output_->Stats().dsp_cpu_ns.store(CurrentThreadCpuNs() - cpu_start, std::memory_order_relaxed);
+    }
+
+    // Producers are stopped; process whatever capture is left
+    Pump(true);
+}
+
+// The APM's render side, woken by each hand-off. Real-time like the DSP
+// thread, whose capture it has to stay ahead of.
+void EchoCancelPipeline::RenderLoop() {
+    ScopedThreadCpu thread_cpu("aecRender");
+    RealtimeThreadScope realtime(kStepMs);
+    webrtc::DenormalDisabler denormals;
+    const uint64_t cpu_start = CurrentThreadCpuNs();
+    while (render_running_) {
+        render_signal_.Wait();
+        g_render_wakeups.Count();
+        DrainApmRender();
+        output_->Stats().render_cpu_ns.store(CurrentThreadCpuNs() - cpu_start, std::memory_order_relaxed);
+    }
+    DrainApmRender();
+}
+
+void EchoCancelPipeline::DrainApmRender() {
+    RenderChunkInfo chunk;
+    while (apm_render_chunks_.Read(&chunk, 1) == 1) {
+        apm_render_ring_.Read(apm_render_buffer_.data(), static_cast<size_t>(chunk.num_frames) * chunk.num_channels);
+        aec_->ProcessRenderAudio(apm_render_buffer_.data(), chunk.num_frames, static_cast<int>(chunk.num_channels));
+    }
+}
+
+void EchoCancelPipeline::Pump(bool flush) {
+    bool woke = true;
+    for (;;) {
+        if (!has_pending_capture_) {
+            if (capture_chunks_.Read(&pending_capture_, 1) != 1) {
+                if (capture_paused_.load(std::memory_order_acquire)) {
+                    DiscardRender();
+                }
+                return;
+            }
+            has_pending_capture_ = true;
+            if (woke) {
+                uint64_t now = HostTimeNow();
+                uint64_t wake = now > pending_capture_.enqueue_host ? now - pending_capture_.enqueue_host : 0;
+                output_->Stats().dsp_wake.Record(wake);
+                if (clock_->TicksToMs(wake) > kLateWakeMs) {
+                    TaskScheduler::ReportAudioDeadlinePressure();
+                }
+            }
+        }
+        woke = false;
+
+        if (!has_pending_render_) {
+            NextRenderChunk();
+        }
+
+        // Render covering the end of this capture may still be in flight.
+        // Wait for it only while render is live and the capture is fresh.
+        uint64_t capture_end = pending_capture_.host_time + CaptureSamplesToTicks(pending_capture_.num_samples);
+        if (!flush && !has_pending_render_ && render_end_host_ < capture_end) {
+            uint64_t now = HostTimeNow();
+            uint64_t wait_ticks = render_wait_ticks_.load(std::memory_order_relaxed);
+            bool render_live = render_end_host_ + wait_ticks > now;
+            bool capture_fresh = pending_capture_.host_time + wait_ticks > now;
+            if (render_live && capture_fresh) {
+                return;
+            }
+        }
+
+        ProcessCapture(pending_capture_);
+        has_pending_capture_ = false;
+    }
+}
+
+// Takes the next render chunk, if any, and times it for the drift estimate.
+// One starting well after the last ended follows a dropped chunk; the hole
+// is marked for FeedRenderUpTo() to fill.
+bool EchoCancelPipeline::NextRenderChunk() {
+    if (render_chunks_.Read(&pending_render_, 1) != 1) {
+        return false;
+    }
+    has_pending_render_ = true;
+    pending_render_offset_ = 0;
+    render_rate_.Update(pending_render_.host_time, pending_render_.num_frames);
+
+    conceal_until_ = 0;
+    if (render_end_host_ != 0 && pending_render_.host_time > render_end_host_) {
+        double gap_ms = clock_->TicksToMs(pending_render_.host_time - render_end_host_);
+        double tolerance_ms = std::max(kMinRenderGapMs, 500.0 * pending_render_.num_frames / sample_rate_);
+        if (gap_ms > tolerance_ms && gap_ms <= kMaxRenderGapMs) {
+            conceal_until_ = pending_render_.host_time;
+            output_->Stats().render_gaps.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+// Paused capture: render is read and dropped, still timed, so the render
+// rate estimate runs on; the partial capture block would otherwise be
+// stamped across the gap
+void EchoCancelPipeline::DiscardRender() {
+    while (has_pending_render_ || NextRenderChunk()) {
+        size_t remaining = pending_render_.num_frames - pending_render_offset_;
+        render_ring_.Read(render_buffer_.data(), remaining * pending_render_.num_channels);
+        render_end_host_ = pending_render_.host_time + SamplesToTicks(pending_render_.num_frames);
+        has_pending_render_ = false;
+    }
+    conceal_until_ = 0;
+    capture_block_fill_ = 0;
+}
+
+uint64_t EchoCancelPipeline::SamplesToTicks(size_t num_samples) const {
+    return clock_->MsToTicks(num_samples * 1000.0 / sample_rate_);
+}
+
+uint64_t EchoCancelPipeline::CaptureSamplesToTicks(size_t num_samples) const {
+    return clock_->MsToTicks(num_samples * 1000.0 / capture_sample_rate_);
+}
+
+// Feeds every queued render frame that starts before |host_time|, splitting
+// chunks so render never runs ahead of the capture step it precedes
+void EchoCancelPipeline::FeedRenderUpTo(uint64_t host_time) {
+    for (;;) {
+        if (!has_pending_render_ && !NextRenderChunk()) {
+            return;
+        }
+
+        if (conceal_until_ != 0 && !ConcealRenderGap(host_time)) {
+            return;
+        }
+
+        uint64_t start = pending_render_.host_time + SamplesToTicks(pending_render_offset_);
+        if (start >= host_time) {
+            return;
+        }
+
+        size_t remaining = pending_render_.num_frames - pending_render_offset_;
+        double span_frames = clock_->TicksToMs(host_time - start) * sample_rate_ / 1000.0;
+        size_t num_frames = std::min(remaining, std::max<size_t>(1, static_cast<size_t>(span_frames + 0.5)));
+
+        render_ring_.Read(render_buffer_.data(), num_frames * pending_render_.num_channels);
+        FeedRender(render_buffer_.data(), num_frames, pending_render_.num_channels);
+
+        pending_render_offset_ += num_frames;
+        render_end_host_ = pending_render_.host_time + SamplesToTicks(pending_render_offset_);
+        if (pending_render_offset_ == pending_render_.num_frames) {
+            has_pending_render_ = false;
+        }
+    }
+}
+
+// Silence from render_end_host_ up to the hole's end, or |host_time| if
+// sooner. False while the hole reaches past |host_time|, for the next step.
+bool EchoCancelPipeline::ConcealRenderGap(uint64_t host_time) {
+    uint64_t until = std::min(conceal_until_, host_time);
+    const uint32_t channels = pending_render_.num_channels;
+    size_t remaining = until > render_end_host_
+        ? static_cast<size_t>(clock_->TicksToMs(until - render_end_host_) * sample_rate_ / 1000.0 + 0.5)
+        : 0;
+    output_->Stats().render_frames_concealed.fetch_add(remaining, std::memory_order_relaxed);
+    render_end_host_ += SamplesToTicks(remaining);
+    const size_t max_frames = render_buffer_.size() / channels;
+    std::fill(render_buffer_.begin(), render_buffer_.begin() + std::min(remaining, max_frames) * channels, 0.0f);
+    while (remaining > 0) {
+        size_t num_frames = std::min(remaining, max_frames);
+        FeedRender(render_buffer_.data(), num_frames, channels);
+        remaining -= num_frames;
+    }
+    if (until < conceal_until_) {
+        return false;
+    }
+    // Within half a frame of the chunk, which follows on
+    render_end_host_ = conceal_until_;
+    conceal_until_ = 0;
+    return true;
+}
+
+// Render host times stay in the input frame domain; the resampler only
+// changes how many frames the APM sees for them
+void EchoCancelPipeline::FeedRender(const float* data, size_t num_frames, uint32_t num_channels) {
+    if (num_channels != drift_channels_) {
+        drift_resampler_.Reset();
+        drift_channels_ = num_channels;
+    }
+    talk_.AddRender(data, num_frames * num_channels);
+    size_t frames = drift_resampler_.Process(data, num_frames, num_channels, drift_ratio_,
+                                             drift_buffer_.data(), drift_buffer_.size() / num_channels);
+    if (frames > 0) {
+        HandOffRender(drift_buffer_.data(), frames, num_channels);
+        mixer_.AddSystem(drift_buffer_.data(), frames, num_channels);
+        if (ShadowAec* shadow = shadow_.load(std::memory_order_acquire)) {
+            shadow->TapRender(drift_buffer_.data(), frames, num_channels);
+        }
+    }
+}
+
+// To the render thread, which is only behind by more than the ring if it
+// has stalled; the APM then sees the hole as a render underrun
+void EchoCancelPipeline::HandOffRender(const float* data, size_t num_frames, uint32_t num_channels) {
+    size_t num_samples = num_frames * num_channels;
+    if (apm_render_ring_.AvailableToWrite() < num_samples || apm_render_chunks_.AvailableToWrite() < 1) {
+        output_->Stats().render_frames_dropped.fetch_add(num_frames, std::memory_order_relaxed);
+        return;
+    }
+    RenderChunkInfo chunk{0, static_cast<uint32_t>(num_frames), num_channels};
+    apm_render_ring_.Write(data, num_samples);
+    apm_render_chunks_.Write(&chunk, 1);
+    render_signal_.Signal();
+}
+
+// Both clocks are measured against the host clock, so their ratio is the
+// render resampling that puts render on the capture clock
+void EchoCancelPipeline::UpdateDriftRatio() {
+    if (!capture_rate_.HasEstimate() || !render_rate_.HasEstimate()) {
+        return;
+    }
+    // Capture's clock as seen after its conversion to the APM rate
+    double capture_rate = capture_rate_.Rate() * sample_rate_ / capture_sample_rate_;
+    double target = std::clamp(capture_rate / render_rate_.Rate(), 1.0 - kMaxDrift, 1.0 + kMaxDrift);
+    drift_ratio_ += kDriftSmoothing * (target - drift_ratio_);
+    aec_->SetRenderDriftPpm(static_cast<float>((1.0 / drift_ratio_ - 1.0) * 1e6));
+}
+
+// Echo in capture ending at |capture_end| was played from render fed
+// (render_end_host_ - capture_end) earlier, plus the playback latency
+void EchoCancelPipeline::UpdateStreamDelay(uint64_t capture_end) {
+    double lead_ms = render_end_host_ >= capture_end
+        ? clock_->TicksToMs(render_end_host_ - capture_end)
+        : -clock_->TicksToMs(capture_end - render_end_host_);
+    double delay_ms = std::max(0.0, lead_ms + output_latency_ms_.load(std::memory_order_relaxed));
+
+    smoothed_delay_ms_ = smoothed_delay_ms_ < 0.0
+        ? delay_ms
+        : smoothed_delay_ms_ + kDelaySmoothing * (delay_ms - smoothed_delay_ms_);
+    aec_->SetStreamDelayMs(static_cast<int>(smoothed_delay_ms_ + 0.5));
+}
+
+// Reads |chunk| from the ring into input_ at the APM rate. Returns the samples
+// converted, which start at |host_time|; a partial block waits for the next
+// chunk.
+size_t EchoCancelPipeline::ConvertCapture(const CaptureChunkInfo& chunk, uint64_t* host_time) {
+    const size_t block = capture_block_.size();
+    const uint64_t filter_delay = clock_->MsToTicks(
+        webrtc::PushSincResampler::AlgorithmicDelaySeconds(static_cast<int>(capture_sample_rate_)) * 1000.0);
+
+    size_t produced = 0;
+    size_t consumed = 0;
+    while (consumed < chunk.num_samples) {
+        if (capture_block_fill_ == 0) {
+            capture_block_host_ = chunk.host_time + CaptureSamplesToTicks(consumed);
+        }
+
+        size_t count = std::min(block - capture_block_fill_, chunk.num_samples - consumed);
+        capture_ring_.Read(capture_block_.data() + capture_block_fill_, count);
+        capture_block_fill_ += count;
+        consumed += count;
+
+        if (capture_block_fill_ == block) {
+            if (produced == 0) {
+                *host_time = capture_block_host_ > filter_delay ? capture_block_host_ - filter_delay : 0;
+            }
+            capture_resampler_->Resample(capture_block_.data(), block, input_.data() + produced, converted_block_);
+            produced += converted_block_;
+            capture_block_fill_ = 0;
+        }
+    }
+    return produced;
+}
+
+void EchoCancelPipeline::ProcessCapture(const CaptureChunkInfo& chunk) {
+    size_t num_samples = chunk.num_samples;
+    TraceScope trace(TraceEvent::kAecPipelineChunk, static_cast<int64_t>(num_samples));
+    capture_rate_.Update(chunk.host_time, num_samples);
+    UpdateDriftRatio();
+
+    // The mixer runs while the mix track records, from the start of each
+    // recording with its settings
+    if (IsRecordingTrack(RecordTrack::kMix)) {
+        MixOptions mix;
+        uint64_t generation = RecordingMixOptions(&mix);
+        if (generation != mix_generation_ && MeetingMixer::Supports(static_cast<int>(sample_rate_))) {
+            mixer_.Start(mix);
+            mix_generation_ = generation;
+        }
+    } else if (mixer_.IsRunning()) {
+        mixer_.Stop();
+    }
+
+    uint64_t host_time = chunk.host_time;
+    if (capture_resampler_) {
+        num_samples = ConvertCapture(chunk, &host_time);
+        if (num_samples == 0) {
+            return;
+        }
+    } else {
+        capture_ring_.Read(input_.data(), num_samples);
+    }
+
+    // The APM's output trails its input by a fixed frame, so this audio was
+    // captured that much earlier than the chunk it came out of
+    uint64_t latency_ticks = SamplesToTicks(aec_->OutputLatencySamples());
+    uint64_t output_host = host_time > latency_ticks ? host_time - latency_ticks : 0;
+
+    for (size_t offset = 0; offset < num_samples; offset += step_samples_) {
+        size_t step = std::min(step_samples_, num_samples - offset);
+        uint64_t step_end = host_time + SamplesToTicks(offset + step);
+
+        FeedRenderUpTo(step_end);
+        if (render_end_host_ != 0) {
+            UpdateStreamDelay(step_end);
+        }
+        aec_->ProcessCaptureAudio(input_.data() + offset, output_buffer_.data() + offset, step);
+        if (ShadowAec* shadow = shadow_.load(std::memory_order_acquire)) {
+            shadow->TapCapture(input_.data() + offset, step,
+                               smoothed_delay_ms_ < 0.0 ? -1 : static_cast<int>(smoothed_delay_ms_ + 0.5));
+        }
+        TalkState state = talk_.Classify(input_.data() + offset, output_buffer_.data() + offset, step);
+        output_->PushTalkState(output_host + SamplesToTicks(offset), state, talk_.EchoReductionDb());
+    }
+    output_->PushFromRealtime(output_buffer_.data(), static_cast<uint32_t>(num_samples), output_host);
+    RecordSamples(RecordTrack::kProcessed, this, output_buffer_.data(), static_cast<uint32_t>(num_samples),
+                  static_cast<int>(sample_rate_));
+    mixer_.AddMic(output_buffer_.data(), num_samples, this);
+}
+
+} // namespace kakarot
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "aec_processor.h"
+#include "capture_stream.h"
+#include "drift_compensator.h"
+#include "host_time.h"
+#include "meeting_mixer.h"
+#include "platform_thread.h"
+#include "shadow_aec.h"
+#include "spsc_ring_buffer.h"
+#include "talk_detector.h"
+
+namespace kakarot {
+
+// Render arrives interleaved in whatever layout its producer has
+struct RenderChunkInfo {
+    uint64_t host_time;      // mach host time of the first frame
+    uint32_t num_frames;
+    uint32_t num_channels;
+};
+
+// Native echo cancellation loop. The mic IOProc and the render source (the
+// system tap, or JS-delivered system audio) push into two preallocated rings;
+// a dedicated DSP thread walks capture in 10ms steps, hands exactly the render
+// samples that precede each step to the render thread, reports the measured
+// render->capture delay to the APM, runs AECProcessor's capture side and
+// pushes the cleaned mic stream into |output| for delivery to JS. The render
+// thread runs the APM's render side alongside, so a step's deadline carries
+// no ProcessReverseStream; the APM's render queue lines the two up. Render from a device on its own crystal is
+// resampled onto the capture clock first, by the ratio of the two streams'
+// measured rates, so the APM's reference stays sample-aligned. Capture from a
+// device running at another nominal rate is converted to the APM's rate on the
+// DSP thread, the only conversion it goes through before the APM. The DSP
+// thread runs real-time and, once given one, inside the capture device's IO
+// workgroup so it is scheduled alongside the IOProc that feeds it. While a
+// recording takes the mix track, the DSP thread also mixes its output with
+// the render it fed, both on the capture clock, for the recorder.
+class EchoCancelPipeline {
+public:
+    EchoCancelPipeline(const HostClock* clock, size_t ring_samples, size_t ring_chunks);
+    ~EchoCancelPipeline();
+
+    EchoCancelPipeline(const EchoCancelPipeline&) = delete;
+    EchoCancelPipeline& operator=(const EchoCancelPipeline&) = delete;
+
+    // JS thread. |aec| and |output| must outlive Stop(); |output| must be open.
+    // |max_render_wait_ms| bounds how long capture waits for late render;
+    // |output_latency_ms| is the hardware latency (output playback plus input
+    // capture) added to the measured delay.
+    // |sample_rate| is the APM's; PushCapture() delivers at |capture_sample_rate|.
+    void Start(AECProcessor* aec, CaptureStream* output, double sample_rate, double capture_sample_rate,
+               double max_render_wait_ms, double output_latency_ms);
+
+    // JS thread. Producers must already be stopped; pending capture is flushed.
+    void Stop();
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // Any thread, while running. The DSP thread joins |workgroup| (leaving
+    // any previous one) on its next wake; an empty one just leaves.
+    void SetWorkgroup(AudioWorkgroup workgroup);
+
+    // Any thread, while running. Capture stopped for a pause: once the
+    // capture queued before it is processed, render is dropped as it arrives
+    // instead of backing up for the resume. The APM, delay and drift state
+    // carry over.
+    void SetCapturePaused(bool paused);
+
+    // Any thread, while running. Replaces the hardware latency added to the
+    // measured delay: after a route change, or with a calibrated round trip.
+    void SetOutputLatencyMs(double output_latency_ms);
+
+    // Any thread. The DSP thread taps the render and capture it gives the
+    // live APM into |shadow| (nullptr stops); it gates the taps itself and
+    // must outlive the pipeline or a later SetShadow().
+    void SetShadow(ShadowAec* shadow);
+
+    // One producer each (RT thread or JS thread): memcpy + atomic publish only.
+    // PushCapture returns false when the buffer was dropped (ring full).
+    // Render is |num_frames| interleaved frames of |num_channels|.
+    bool PushCapture(const float* data, uint32_t num_samples, uint64_t host_time);
+    void PushRender(const float* data, uint32_t num_frames, uint32_t num_channels, uint64_t host_time);
+
+    // Render producer thread. Render with no capture time of its own, just
+    // arrived: it is placed on a steady frame clock through the arrival
+    // jitter buffer, and capture waits for render only as long as its
+    // measured jitter needs (up to |max_render_wait_ms|).
+    void PushArrivedRender(const float* data, uint32_t num_frames, uint32_t num_channels);
+
+private:
+    void DspLoop();
+    void Pump(bool flush);
+    bool NextRenderChunk();
+    void DiscardRender();
+    void FeedRenderUpTo(uint64_t host_time);
+    bool ConcealRenderGap(uint64_t host_time);
+    void FeedRender(const float* data, size_t num_frames, uint32_t num_channels);
+    void HandOffRender(const float* data, size_t num_frames, uint32_t num_channels);
+    void RenderLoop();
+    void DrainApmRender();
+    void UpdateDriftRatio();
+    void ProcessCapture(const CaptureChunkInfo& chunk);
+    size_t ConvertCapture(const CaptureChunkInfo& chunk, uint64_t* host_time);
+    void UpdateStreamDelay(uint64_t capture_end);
+    uint64_t SamplesToTicks(size_t num_samples) const;
+    uint64_t CaptureSamplesToTicks(size_t num_samples) const;
+
+    const HostClock* clock_;
+
+    SpscRingBuffer<float> capture_ring_;
+    SpscRingBuffer<CaptureChunkInfo> capture_chunks_;
+    SpscRingBuffer<float> render_ring_;
+    SpscRingBuffer<RenderChunkInfo> render_chunks_;
+    Semaphore signal_;
+    std::thread dsp_thread_;
+    std::atomic<bool> dsp_running_{false};
+
+    // Drift-corrected render on its way from the DSP thread to the render
+    // thread, which owns apm_render_buffer_
+    SpscRingBuffer<float> apm_render_ring_;
+    SpscRingBuffer<RenderChunkInfo> apm_render_chunks_;
+    Semaphore render_signal_;
+    std::thread render_thread_;
+    std::atomic<bool> render_running_{false};
+    std::vector<float> apm_render_buffer_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> capture_paused_{false};
+
+    // Written by SetWorkgroup(); the DSP thread copies it out when the
+    // version moves
+    std::mutex workgroup_mutex_;
+    AudioWorkgroup workgroup_;
+    std::atomic<uint64_t> workgroup_version_{0};
+
+    AECProcessor* aec_ = nullptr;
+    std::atomic<ShadowAec*> shadow_{nullptr};
+    CaptureStream* output_ = nullptr;
+    double sample_rate_ = 48000.0;
+    double capture_sample_rate_ = 48000.0;
+    size_t step_samples_ = 480;
+    std::atomic<double> output_latency_ms_{0.0};
+
+    // DSP thread only
+    CaptureChunkInfo pending_capture_{};
+    RenderChunkInfo pending_render_{};
+    size_t pending_render_offset_ = 0;  // frames of pending_render_ already fed
+    bool has_pending_capture_ = false;
+    bool has_pending_render_ = false;
+    uint64_t render_end_host_ = 0;      // host time just past the last render sample fed
+    uint64_t conceal_until_ = 0;        // end of a hole before pending_render_ still to fill; 0 = none
+    uint64_t max_render_wait_ticks_ = 0;
+    std::atomic<uint64_t> render_wait_ticks_{0};  // what capture waits for render; the max until measured
+    double smoothed_delay_ms_ = -1.0;
+    TalkDetector talk_;  // per step, for the output stream's talk option
+
+    // Render producer thread only
+    ArrivalDejitter render_dejitter_;
+
+    // DSP thread only. drift_ratio_ is render frames out per frame in:
+    // capture rate over render rate, smoothed
+    StreamRateEstimator capture_rate_;
+    StreamRateEstimator render_rate_;
+    DriftResampler drift_resampler_;
+    double drift_ratio_ = 1.0;
+    uint32_t drift_channels_ = 0;
+    std::vector<float> drift_buffer_;
+
+    // DSP thread only; set when capture runs at another rate. Blocks of
+    // capture_block_.size() frames come out as converted_block_ frames.
+    std::unique_ptr<webrtc::PushSincResampler> capture_resampler_;
+    std::vector<float> capture_block_;
+    size_t capture_block_fill_ = 0;
+    size_t converted_block_ = 0;
+    uint64_t capture_block_host_ = 0;
+    std::vector<float> input_;
+    std::vector<float> render_buffer_;
+    std::vector<float> output_buffer_;
+
+    // DSP thread only, but for Prepare() in Start()
+    MeetingMixer mixer_;
+    uint64_t mix_generation_ = 0;  // the recording the mixer was started for
+};
+
+} // namespace kakarot
@@ -0,0 +1,228 @@
+#include "embedding_cache.h"
+#include "native_log.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+namespace kakarot {
+
+static const char* const kLogSource = "EmbeddingCache";
+
+// Removed records a rewrite waits for, however few entries are live
+static constexpr size_t kMinCompactRecords = 256;
+
+namespace {
+
+// MurmurHash64A: eight bytes a step, which keeps whole knowledge chunks cheap
+uint64_t Hash64(const std::string& data, uint64_t seed) {
+    constexpr uint64_t m = 0xc6a4a7935bd1e995ull;
+    constexpr int r = 47;
+    const size_t size = data.size();
+    uint64_t hash = seed ^ (size * m);
+    const char* p = data.data();
+    const char* end = p + size / 8 * 8;
+    for (; p != end; p += 8) {
+        uint64_t k;
+        std::memcpy(&k, p, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        hash ^= k;
+        hash *= m;
+    }
+    uint64_t tail = 0;
+    for (size_t i = size & 7; i-- > 0;) {
+        tail = (tail << 8) | static_cast<uint8_t>(p[i]);
+    }
+    if (size & 7) {
+        hash ^= tail;
+        hash *= m;
+    }
+    hash ^= hash >> r;
+    hash *= m;
+    hash ^= hash >> r;
+    return hash;
+}
+
+bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+
+} // namespace
+
+std::string EmbeddingCache::Key(const std::string& model, const std::string& text) {
+    // The model id, then the text with its whitespace runs as one space
+    std::string normalized = model;
+    normalized.push_back('\n');
+    bool space = false;
+    for (char c : text) {
+        if (IsSpace(c)) {
+            space = true;
+            continue;
+        }
+        if (space && normalized.back() != '\n') {
+            normalized.push_back(' ');
+        }
+        space = false;
+        normalized.push_back(c);
+    }
+    char key[33];
+    std::snprintf(key, sizeof(key), "%016" PRIx64 "%016" PRIx64, Hash64(normalized, 0x6b6b6563ull),
+                  Hash64(normalized, 0x9e3779b97f4a7c15ull));
+    return key;
+}
+
+bool EmbeddingCache::Open(const std::string& path, const EmbeddingIndexOptions& options, size_t capacity,
+                          std::string* error) {
+    Close();
+    if (capacity == 0) {
+        *error = "capacity must be positive";
+        return false;
+    }
+    options_ = options;
+    options_.normalize = false;
+    capacity_ = capacity;
+    if (!store_.Open(path, options_, error)) {
+        return false;
+    }
+    path_ = path;
+    Index();
+    return true;
+}
+
+void EmbeddingCache::Close() {
+    store_.Close();
+    entries_.clear();
+    recency_.clear();
+    path_.clear();
+}
+
+// The live records into the index, oldest first; a key written twice keeps
+// its later record
+void EmbeddingCache::Index() {
+    entries_.clear();
+    recency_.clear();
+    std::string key;
+    for (size_t i = 0; i < store_.Records(); ++i) {
+        if (!store_.Read(i, &key, nullptr)) {
+            continue;
+        }
+        auto found = entries_.find(key);
+        if (found != entries_.end()) {
+            store_.RemoveAt(found->second.record);
+            recency_.erase(found->second.recency);
+            entries_.erase(found);
+        }
+        recency_.push_back(key);
+        entries_.emplace(key, Entry{i, std::prev(recency_.end())});
+    }
+    Evict();
+}
+
+std::vector<bool> EmbeddingCache::Lookup(const std::string& model, const std::vector<std::string>& texts,
+                                         float* vectors) {
+    std::vector<bool> found(texts.size(), false);
+    const size_t dims = store_.Dims();
+    for (size_t i = 0; i < texts.size(); ++i) {
+        auto entry = entries_.find(Key(model, texts[i]));
+        if (entry != entries_.end() && store_.Read(entry->second.record, nullptr, vectors + i * dims)) {
+            recency_.splice(recency_.end(), recency_, entry->second.recency);
+            found[i] = true;
+            stats_.hits++;
+            continue;
+        }
+        if (entry != entries_.end()) {
+            // Its record is gone from under us: forget it
+            recency_.erase(entry->second.recency);
+            entries_.erase(entry);
+        }
+        stats_.misses++;
+    }
+    return found;
+}
+
+bool EmbeddingCache::Store(const std::string& model, const std::string& text, const float* vector,
+                           std::string* error) {
+    const std::string key = Key(model, text);
+    if (!store_.Append(key, vector, error)) {
+        return false;
+    }
+    auto found = entries_.find(key);
+    if (found != entries_.end()) {
+        store_.RemoveAt(found->second.record);
+        recency_.erase(found->second.recency);
+        entries_.erase(found);
+    }
+    recency_.push_back(key);
+    entries_.emplace(key, Entry{store_.Records() - 1, std::prev(recency_.end())});
+    Evict();
+
+    const size_t removed = store_.Records() - entries_.size();
+    if (removed >= kMinCompactRecords && removed > entries_.size()) {
+        std::string compact_error;
+        if (!Compact(&compact_error)) {
+            Log(LogLevel::kWarn, kLogSource, "compaction failed: %s", compact_error.c_str());
+        }
+    }
+    return true;
+}
+
+// Least recent entries out until the cache is back within capacity
+void EmbeddingCache::Evict() {
+    while (entries_.size() > capacity_) {
+        auto oldest = entries_.find(recency_.front());
+        store_.RemoveAt(oldest->second.record);
+        entries_.erase(oldest);
+        recency_.pop_front();
+        stats_.evictions++;
+    }
+}
+
+// Rewrites the file with the live entries, least recent first, through a
+// part file renamed over it; on failure before the rename the old file stays
+bool EmbeddingCache::Compact(std::string* error) {
+    const std::string part = path_ + ".part";
+    std::remove(part.c_str());
+    EmbeddingStore compacted;
+    if (!compacted.Open(part, options_, error)) {
+        return false;
+    }
+    std::vector<float> vector(store_.Dims());
+    for (const std::string& key : recency_) {
+        if (!store_.Read(entries_.at(key).record, nullptr, vector.data()) ||
+            !compacted.Append(key, vector.data(), error)) {
+            compacted.Close();
+            std::remove(part.c_str());
+            if (error->empty()) {
+                *error = "cannot read " + path_;
+            }
+            return false;
+        }
+    }
+    compacted.Close();
+    store_.Close();
+    std::remove(path_.c_str());  // rename() will not replace on Windows
+    const bool renamed = std::rename(part.c_str(), path_.c_str()) == 0;
+    if (!renamed) {
+        std::remove(part.c_str());
+    }
+    // Without the rename the entries are lost, and the cache starts empty
+    if (!store_.Open(path_, options_, error)) {
+        return false;
+    }
+    Index();
+    if (!renamed) {
+        *error = "cannot rename " + part;
+        return false;
+    }
+    stats_.compactions++;
+    return true;
+}
+
+EmbeddingCacheStats EmbeddingCache::GetStats() const {
+    EmbeddingCacheStats stats = stats_;
+    stats.entries = entries_.size();
+    stats.capacity = capacity_;
+    stats.bytes = store_.Bytes();
+    return stats;
+}
+
+} // namespace kakarot
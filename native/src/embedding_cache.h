@@ -0,0 +1,75 @@
+#pragma once
+
+#include "embedding_store.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kakarot {
+
+struct EmbeddingCacheStats {
+    size_t entries = 0;
+    size_t capacity = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t compactions = 0;
+    size_t bytes = 0;  // of the file, removed records included
+};
+
+// Embeddings by the text they were made from, so that a chunk, title or
+// phrase embedded once is not sent to the API again. Entries live in an
+// EmbeddingStore whose ids are a 128-bit hash of the model id and the
+// normalized text (whitespace runs as one space, trimmed), and never land
+// in the JS heap until looked up. Opening scans the ids into an in-memory
+// index in least-recently-used order; past |capacity| the least recent
+// entry is marked removed, and once removed records outnumber live ones
+// the file is rewritten with the live ones, least recent first, so that
+// recency mostly survives a restart. One thread at a time.
+class EmbeddingCache {
+public:
+    EmbeddingCache() = default;
+
+    EmbeddingCache(const EmbeddingCache&) = delete;
+    EmbeddingCache& operator=(const EmbeddingCache&) = delete;
+
+    // |options| as EmbeddingStore takes them; normalize is turned off, so
+    // vectors come back as they were stored
+    bool Open(const std::string& path, const EmbeddingIndexOptions& options, size_t capacity, std::string* error);
+    void Close();
+
+    // One lookup per text: a hit's vector goes to |vectors| at its row
+    // (texts x dims), and its entry becomes the most recent
+    std::vector<bool> Lookup(const std::string& model, const std::vector<std::string>& texts, float* vectors);
+    // Replaces the entry of |text| under |model|
+    bool Store(const std::string& model, const std::string& text, const float* vector, std::string* error);
+
+    size_t Dims() const { return store_.Dims(); }
+    EmbeddingCacheStats GetStats() const;
+
+    // The store id of |text| under |model|: 32 hex digits
+    static std::string Key(const std::string& model, const std::string& text);
+
+private:
+    struct Entry {
+        size_t record;
+        std::list<std::string>::iterator recency;
+    };
+
+    void Index();
+    void Evict();
+    bool Compact(std::string* error);
+
+    std::string path_;
+    EmbeddingIndexOptions options_;
+    size_t capacity_ = 0;
+    EmbeddingStore store_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> recency_;  // least recent first
+    EmbeddingCacheStats stats_;
+};
+
+} // namespace kakarot
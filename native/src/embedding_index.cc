@@ -0,0 +1,458 @@
+#include "embedding_index.h"
+#include "dsp_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+
+namespace kakarot {
+
+namespace embedding {
+
+// Out-of-range magnitudes saturate, which unit vectors never reach
+uint16_t FloatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    float magnitude = std::fabs(value);
+    if (magnitude >= 65504.0f) {
+        return static_cast<uint16_t>(sign | 0x7bffu);
+    }
+    if (magnitude < 0x1p-14f) {
+        // Subnormal: a multiple of 2^-24, rounded by the FPU
+        return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(magnitude * 0x1p24f)));
+    }
+    std::memcpy(&bits, &magnitude, sizeof(bits));
+    uint32_t mantissa = bits & 0x7fffffu;
+    uint32_t exponent = (bits >> 23) - 127 + 15;
+    uint32_t half = (exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        ++half;  // may carry into the exponent, which is still right
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float QuantizeS8(const float* values, size_t n, int8_t* codes) {
+    float peak = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        peak = std::max(peak, std::fabs(values[i]));
+    }
+    float scale = peak > 0.0f ? peak / 127.0f : 1.0f;
+    float inverse = 1.0f / scale;
+    for (size_t i = 0; i < n; ++i) {
+        codes[i] = static_cast<int8_t>(std::lrint(std::max(-127.0f, std::min(127.0f, values[i] * inverse))));
+    }
+    return scale;
+}
+
+} // namespace embedding
+
+using embedding::FloatToHalf;
+using embedding::QuantizeS8;
+
+namespace {
+
+constexpr size_t kMinCompaction = 64;
+
+using Scored = std::pair<float, uint32_t>;
+struct WorstFirst {
+    bool operator()(const Scored& a, const Scored& b) const { return a.first > b.first; }
+};
+struct BestFirst {
+    bool operator()(const Scored& a, const Scored& b) const { return a.first < b.first; }
+};
+
+} // namespace
+
+bool EmbeddingIndex::Init(const EmbeddingIndexOptions& options, std::string* error) {
+    if (options.dims == 0) {
+        *error = "dims must be positive";
+        return false;
+    }
+    if (options.graph_m < 2) {
+        *error = "graph m must be at least 2";
+        return false;
+    }
+    options_ = options;
+    options_.ef_construction = std::max(options_.ef_construction, options_.graph_m);
+    options_.ef_search = std::max<size_t>(1, options_.ef_search);
+    Clear();
+    return true;
+}
+
+void EmbeddingIndex::Clear() {
+    f32_.clear();
+    f16_.clear();
+    s8_.clear();
+    scales_.clear();
+    nodes_.clear();
+    ids_.clear();
+    graph_built_ = false;
+    entry_ = 0;
+    max_level_ = -1;
+    visited_.clear();
+    epoch_ = 0;
+    decode_.assign(options_.dims, 0.0f);
+}
+
+size_t EmbeddingIndex::Bytes() const {
+    size_t bytes = f32_.size() * sizeof(float) + f16_.size() * sizeof(uint16_t) + s8_.size() +
+                   scales_.size() * sizeof(float);
+    for (const Node& node : nodes_) {
+        for (const auto& layer : node.links) {
+            bytes += layer.size() * sizeof(uint32_t);
+        }
+    }
+    return bytes;
+}
+
+bool EmbeddingIndex::Add(const std::string& id, const float* vector, std::string* error) {
+    const size_t dims = options_.dims;
+    std::vector<float> unit(vector, vector + dims);
+    float norm_squared = dsp::DotProduct(unit.data(), unit.data(), dims);
+    if (!std::isfinite(norm_squared) || norm_squared <= 0.0f) {
+        *error = "Vector is zero or not finite";
+        return false;
+    }
+    if (options_.normalize) {
+        float inverse = 1.0f / std::sqrt(norm_squared);
+        for (float& value : unit) {
+            value *= inverse;
+        }
+    }
+
+    Remove(id);
+    uint32_t slot = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back(Node{id, false, 0, {}});
+    Encode(unit.data(), slot);
+    ids_[id] = slot;
+
+    if (graph_built_) {
+        Link(slot);
+    } else if (ids_.size() >= options_.graph_threshold) {
+        BuildGraph();
+    }
+    return true;
+}
+
+bool EmbeddingIndex::Remove(const std::string& id) {
+    auto it = ids_.find(id);
+    if (it == ids_.end()) {
+        return false;
+    }
+    nodes_[it->second].removed = true;
+    ids_.erase(it);
+    // Removed slots keep their storage, and their place in the graph, until
+    // they outnumber the live ones
+    if (nodes_.size() - ids_.size() > std::max<size_t>(ids_.size(), kMinCompaction)) {
+        Compact();
+    }
+    return true;
+}
+
+// Re-adds the live vectors from their stored form, which re-encodes to
+// itself, into fresh storage and a fresh graph
+void EmbeddingIndex::Compact() {
+    std::vector<std::pair<std::string, std::vector<float>>> live;
+    live.reserve(ids_.size());
+    for (uint32_t slot = 0; slot < nodes_.size(); ++slot) {
+        if (!nodes_[slot].removed) {
+            live.emplace_back(nodes_[slot].id, std::vector<float>(options_.dims));
+            Decode(slot, live.back().second.data());
+        }
+    }
+    Clear();
+    std::string error;
+    for (const auto& [id, unit] : live) {
+        Add(id, unit.data(), &error);
+    }
+}
+
+void EmbeddingIndex::Encode(const float* unit, uint32_t slot) {
+    const size_t dims = options_.dims;
+    switch (options_.quantization) {
+        case EmbeddingQuantization::kFloat32:
+            f32_.insert(f32_.end(), unit, unit + dims);
+            break;
+        case EmbeddingQuantization::kFloat16:
+            for (size_t i = 0; i < dims; ++i) {
+                f16_.push_back(FloatToHalf(unit[i]));
+            }
+            break;
+        case EmbeddingQuantization::kInt8:
+            s8_.resize(static_cast<size_t>(slot + 1) * dims);
+            scales_.push_back(QuantizeS8(unit, dims, &s8_[static_cast<size_t>(slot) * dims]));
+            break;
+    }
+}
+
+void EmbeddingIndex::Decode(uint32_t slot, float* out) const {
+    const size_t dims = options_.dims;
+    const size_t offset = static_cast<size_t>(slot) * dims;
+    switch (options_.quantization) {
+        case EmbeddingQuantization::kFloat32:
+            std::copy(&f32_[offset], &f32_[offset] + dims, out);
+            break;
+        case EmbeddingQuantization::kFloat16:
+            dsp::HalfToFloat(&f16_[offset], out, dims);
+            break;
+        case EmbeddingQuantization::kInt8:
+            for (size_t i = 0; i < dims; ++i) {
+                out[i] = s8_[offset + i] * scales_[slot];
+            }
+            break;
+    }
+}
+
+EmbeddingIndex::Probe EmbeddingIndex::MakeProbe(const float* unit) const {
+    Probe probe;
+    if (options_.quantization == EmbeddingQuantization::kInt8) {
+        probe.codes.resize(options_.dims);
+        probe.scale = QuantizeS8(unit, options_.dims, probe.codes.data());
+    } else {
+        probe.values.assign(unit, unit + options_.dims);
+    }
+    return probe;
+}
+
+float EmbeddingIndex::Score(const Probe& probe, uint32_t slot) const {
+    const size_t dims = options_.dims;
+    const size_t offset = static_cast<size_t>(slot) * dims;
+    switch (options_.quantization) {
+        case EmbeddingQuantization::kFloat32:
+            return dsp::DotProduct(probe.values.data(), &f32_[offset], dims);
+        case EmbeddingQuantization::kFloat16:
+            dsp::HalfToFloat(&f16_[offset], decode_.data(), dims);
+            return dsp::DotProduct(probe.values.data(), decode_.data(), dims);
+        case EmbeddingQuantization::kInt8:
+        default:
+            return static_cast<float>(dsp::DotProductS8(probe.codes.data(), &s8_[offset], dims)) * probe.scale *
+                   scales_[slot];
+    }
+}
+
+// Two stored vectors, without building a probe
+float EmbeddingIndex::PairScore(uint32_t a, uint32_t b) const {
+    const size_t dims = options_.dims;
+    const size_t a_offset = static_cast<size_t>(a) * dims;
+    const size_t b_offset = static_cast<size_t>(b) * dims;
+    switch (options_.quantization) {
+        case EmbeddingQuantization::kFloat32:
+            return dsp::DotProduct(&f32_[a_offset], &f32_[b_offset], dims);
+        case EmbeddingQuantization::kFloat16:
+            pair_decode_.resize(dims);
+            dsp::HalfToFloat(&f16_[a_offset], pair_decode_.data(), dims);
+            dsp::HalfToFloat(&f16_[b_offset], decode_.data(), dims);
+            return dsp::DotProduct(pair_decode_.data(), decode_.data(), dims);
+        case EmbeddingQuantization::kInt8:
+        default:
+            return static_cast<float>(dsp::DotProductS8(&s8_[a_offset], &s8_[b_offset], dims)) * scales_[a] *
+                   scales_[b];
+    }
+}
+
+std::vector<EmbeddingHit> EmbeddingIndex::Search(const float* query, size_t k) const {
+    std::vector<EmbeddingHit> hits;
+    if (k == 0 || ids_.empty()) {
+        return hits;
+    }
+    const size_t dims = options_.dims;
+    std::vector<float> unit(query, query + dims);
+    float norm_squared = dsp::DotProduct(unit.data(), unit.data(), dims);
+    if (!std::isfinite(norm_squared)) {
+        return hits;
+    }
+    if (options_.normalize && norm_squared > 0.0f) {
+        float inverse = 1.0f / std::sqrt(norm_squared);
+        for (float& value : unit) {
+            value *= inverse;
+        }
+    }
+    Probe probe = MakeProbe(unit.data());
+    if (!graph_built_) {
+        return FlatSearch(probe, k);
+    }
+
+    uint32_t current = entry_;
+    for (int layer = max_level_; layer > 0; --layer) {
+        current = SearchLayer(probe, current, 1, layer).front().second;
+    }
+    // Removed nodes come back as waypoints; ask for enough to cover them
+    size_t removed = nodes_.size() - ids_.size();
+    size_t ef = std::max(options_.ef_search, k) + std::min(removed, k);
+    for (const Scored& candidate : SearchLayer(probe, current, ef, 0)) {
+        if (nodes_[candidate.second].removed) {
+            continue;
+        }
+        hits.push_back(EmbeddingHit{nodes_[candidate.second].id, candidate.first});
+        if (hits.size() == k) {
+            break;
+        }
+    }
+    return hits;
+}
+
+std::vector<EmbeddingHit> EmbeddingIndex::FlatSearch(const Probe& probe, size_t k) const {
+    std::priority_queue<Scored, std::vector<Scored>, WorstFirst> best;
+    for (uint32_t slot = 0; slot < nodes_.size(); ++slot) {
+        if (nodes_[slot].removed) {
+            continue;
+        }
+        float score = Score(probe, slot);
+        if (best.size() < k) {
+            best.emplace(score, slot);
+        } else if (score > best.top().first) {
+            best.pop();
+            best.emplace(score, slot);
+        }
+    }
+    std::vector<EmbeddingHit> hits(best.size());
+    for (size_t i = hits.size(); i > 0; --i) {
+        hits[i - 1] = EmbeddingHit{nodes_[best.top().second].id, best.top().first};
+        best.pop();
+    }
+    return hits;
+}
+
+// Best-first search of one layer from |entry|, keeping the |ef| best seen;
+// returned best first
+std::vector<Scored> EmbeddingIndex::SearchLayer(const Probe& probe, uint32_t entry, size_t ef, int layer) const {
+    if (visited_.size() < nodes_.size()) {
+        visited_.resize(nodes_.size(), 0);
+    }
+    if (++epoch_ == 0) {
+        std::fill(visited_.begin(), visited_.end(), 0);
+        epoch_ = 1;
+    }
+
+    std::priority_queue<Scored, std::vector<Scored>, BestFirst> frontier;
+    std::priority_queue<Scored, std::vector<Scored>, WorstFirst> kept;
+    float entry_score = Score(probe, entry);
+    frontier.emplace(entry_score, entry);
+    kept.emplace(entry_score, entry);
+    visited_[entry] = epoch_;
+
+    while (!frontier.empty()) {
+        Scored current = frontier.top();
+        if (kept.size() >= ef && current.first < kept.top().first) {
+            break;  // nothing left can improve on the worst kept
+        }
+        frontier.pop();
+        const Node& node = nodes_[current.second];
+        if (layer > node.level) {
+            continue;
+        }
+        for (uint32_t neighbor : node.links[layer]) {
+            if (visited_[neighbor] == epoch_) {
+                continue;
+            }
+            visited_[neighbor] = epoch_;
+            float score = Score(probe, neighbor);
+            if (kept.size() < ef || score > kept.top().first) {
+                frontier.emplace(score, neighbor);
+                kept.emplace(score, neighbor);
+                if (kept.size() > ef) {
+                    kept.pop();
+                }
+            }
+        }
+    }
+
+    std::vector<Scored> result(kept.size());
+    for (size_t i = result.size(); i > 0; --i) {
+        result[i - 1] = kept.top();
+        kept.pop();
+    }
+    return result;
+}
+
+// HNSW's neighbor heuristic: walking |candidates| best first, one is kept
+// only when it is closer to the base than to any already kept, so links
+// spread across clusters instead of piling into the nearest; the closest
+// of the rest fill any room left
+std::vector<uint32_t> EmbeddingIndex::SelectNeighbors(const std::vector<Scored>& candidates, size_t m) const {
+    std::vector<uint32_t> kept;
+    std::vector<uint32_t> pruned;
+    for (const Scored& candidate : candidates) {
+        if (kept.size() >= m) {
+            break;
+        }
+        bool diverse = true;
+        for (uint32_t linked : kept) {
+            if (PairScore(candidate.second, linked) > candidate.first) {
+                diverse = false;
+                break;
+            }
+        }
+        (diverse ? kept : pruned).push_back(candidate.second);
+    }
+    for (size_t i = 0; i < pruned.size() && kept.size() < m; ++i) {
+        kept.push_back(pruned[i]);
+    }
+    return kept;
+}
+
+// Inserts |slot| into the graph: a random top layer, a greedy descent to
+// it, then on each layer below links to the neighbors SelectNeighbors()
+// picks from an ef_construction search, each of which links back and is
+// re-pruned the same way when over its budget
+void EmbeddingIndex::Link(uint32_t slot) {
+    const double level_scale = 1.0 / std::log(static_cast<double>(options_.graph_m));
+    std::uniform_real_distribution<double> uniform(std::nextafter(0.0, 1.0), 1.0);
+    Node& node = nodes_[slot];
+    node.level = static_cast<int>(-std::log(uniform(rng_)) * level_scale);
+    node.links.assign(node.level + 1, {});
+
+    if (max_level_ < 0) {
+        entry_ = slot;
+        max_level_ = node.level;
+        return;
+    }
+
+    std::vector<float> unit(options_.dims);
+    Decode(slot, unit.data());
+    Probe probe = MakeProbe(unit.data());
+
+    uint32_t current = entry_;
+    for (int layer = max_level_; layer > node.level; --layer) {
+        current = SearchLayer(probe, current, 1, layer).front().second;
+    }
+    for (int layer = std::min(node.level, max_level_); layer >= 0; --layer) {
+        std::vector<Scored> candidates = SearchLayer(probe, current, options_.ef_construction, layer);
+        current = candidates.front().second;
+        const size_t max_links = layer == 0 ? 2 * options_.graph_m : options_.graph_m;
+        nodes_[slot].links[layer] = SelectNeighbors(candidates, options_.graph_m);
+        for (uint32_t neighbor : nodes_[slot].links[layer]) {
+            std::vector<uint32_t>& back = nodes_[neighbor].links[layer];
+            back.push_back(slot);
+            if (back.size() <= max_links) {
+                continue;
+            }
+            std::vector<Scored> scored;
+            scored.reserve(back.size());
+            for (uint32_t linked : back) {
+                scored.emplace_back(PairScore(neighbor, linked), linked);
+            }
+            std::sort(scored.begin(), scored.end(), [](const Scored& a, const Scored& b) { return a.first > b.first; });
+            back = SelectNeighbors(scored, max_links);
+        }
+    }
+    if (nodes_[slot].level > max_level_) {
+        max_level_ = nodes_[slot].level;
+        entry_ = slot;
+    }
+}
+
+void EmbeddingIndex::BuildGraph() {
+    graph_built_ = true;
+    max_level_ = -1;
+    for (uint32_t slot = 0; slot < nodes_.size(); ++slot) {
+        if (!nodes_[slot].removed) {
+            Link(slot);
+        }
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kakarot {
+
+// How an EmbeddingIndex stores its vectors: float16 halves the memory of
+// float32 for a rounding error well below what ranking notices, int8 (one
+// scale per vector) quarters it and scores in integer arithmetic
+enum class EmbeddingQuantization { kFloat32, kFloat16, kInt8 };
+
+struct EmbeddingIndexOptions {
+    size_t dims = 0;
+    EmbeddingQuantization quantization = EmbeddingQuantization::kFloat32;
+    // Vectors are scaled to unit length on the way in, so inner product
+    // ranks by cosine similarity
+    bool normalize = true;
+    // A flat scan answers exactly and fast enough below this many vectors;
+    // from there an HNSW graph takes over
+    size_t graph_threshold = 4096;
+    size_t graph_m = 16;              // links per node and layer, twice that on layer 0
+    size_t ef_construction = 64;
+    size_t ef_search = 64;            // raised to k for larger queries
+};
+
+struct EmbeddingHit {
+    std::string id;
+    float score = 0.0f;  // inner product, cosine when normalized
+};
+
+namespace embedding {
+
+// IEEE half precision, rounded to nearest even
+uint16_t FloatToHalf(float value);
+// Symmetric int8 codes of |n| values; returns the scale back to float
+float QuantizeS8(const float* values, size_t n, int8_t* codes);
+
+} // namespace embedding
+
+// Top-k inner-product search over embeddings, for the callout path's
+// knowledge-base and past-meeting lookups. Scores run through
+// dsp::DotProduct / DotProductS8 (Accelerate on macOS, vectorized loops
+// elsewhere). Removing a vector from the graph leaves it as a waypoint
+// that results skip. One thread at a time.
+class EmbeddingIndex {
+public:
+    // False with |error| for zero dims or a graph with fewer than 2 links
+    bool Init(const EmbeddingIndexOptions& options, std::string* error);
+
+    // Replaces the vector under |id| if there is one. |vector| has dims()
+    // floats; false for a zero or non-finite one.
+    bool Add(const std::string& id, const float* vector, std::string* error);
+    bool Remove(const std::string& id);
+    void Clear();
+
+    // Best first; fewer than |k| when the index holds fewer. With the
+    // graph the answer is approximate: raise ef_search for recall.
+    std::vector<EmbeddingHit> Search(const float* query, size_t k) const;
+
+    size_t Size() const { return ids_.size(); }
+    size_t Dims() const { return options_.dims; }
+    bool UsesGraph() const { return graph_built_; }
+    size_t Bytes() const;
+
+private:
+    // A query or stored vector in the index's own representation
+    struct Probe {
+        std::vector<float> values;    // float32 and float16 indexes
+        std::vector<int8_t> codes;    // int8 index
+        float scale = 0.0f;
+    };
+
+    struct Node {
+        std::string id;
+        bool removed = false;
+        int level = 0;
+        std::vector<std::vector<uint32_t>> links;  // per layer
+    };
+
+    void Encode(const float* unit, uint32_t slot);
+    void Decode(uint32_t slot, float* out) const;
+    Probe MakeProbe(const float* unit) const;
+    float Score(const Probe& probe, uint32_t slot) const;
+    float PairScore(uint32_t a, uint32_t b) const;
+
+    std::vector<EmbeddingHit> FlatSearch(const Probe& probe, size_t k) const;
+    std::vector<std::pair<float, uint32_t>> SearchLayer(const Probe& probe, uint32_t entry, size_t ef,
+                                                        int layer) const;
+    std::vector<uint32_t> SelectNeighbors(const std::vector<std::pair<float, uint32_t>>& candidates,
+                                          size_t m) const;
+    void Link(uint32_t slot);
+    void BuildGraph();
+    void Compact();
+
+    EmbeddingIndexOptions options_;
+    std::vector<float> f32_;
+    std::vector<uint16_t> f16_;
+    std::vector<int8_t> s8_;
+    std::vector<float> scales_;
+    std::vector<Node> nodes_;
+    std::unordered_map<std::string, uint32_t> ids_;  // live vectors only
+
+    bool graph_built_ = false;
+    uint32_t entry_ = 0;
+    int max_level_ = -1;
+    std::mt19937 rng_{0x6b6b};
+
+    // Search scratch: a slot is visited when its mark equals the epoch
+    mutable std::vector<uint32_t> visited_;
+    mutable uint32_t epoch_ = 0;
+    mutable std::vector<float> decode_;
+    mutable std::vector<float> pair_decode_;
+};
+
+} // namespace kakarot
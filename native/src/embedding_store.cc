@@ -0,0 +1,368 @@
+#include "embedding_store.h"
+#include "dsp_kernels.h"
+#include "recording_index.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace kakarot {
+
+using recording_index::GetLe;
+using recording_index::PutLe;
+
+namespace {
+
+constexpr uint32_t kUnitVectors = 1u << 0;
+constexpr uint32_t kRemoved = 1u << 0;
+
+// A timed search looks at the clock once per this many records
+constexpr size_t kDeadlineCheckRecords = 256;
+
+bool Seek(FILE* file, uint64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+void Commit(FILE* file) {
+    std::fflush(file);
+#if defined(_WIN32)
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+using Scored = std::pair<float, size_t>;
+struct WorstFirst {
+    bool operator()(const Scored& a, const Scored& b) const { return a.first > b.first; }
+};
+
+} // namespace
+
+EmbeddingStore::~EmbeddingStore() { Close(); }
+
+size_t EmbeddingStore::VectorBytes() const {
+    switch (options_.quantization) {
+        case EmbeddingQuantization::kFloat32:
+            return options_.dims * sizeof(float);
+        case EmbeddingQuantization::kFloat16:
+            return options_.dims * sizeof(uint16_t);
+        case EmbeddingQuantization::kInt8:
+        default:
+            return options_.dims;
+    }
+}
+
+bool EmbeddingStore::Open(const std::string& path, const EmbeddingIndexOptions& options, std::string* error) {
+    Close();
+    if (options.dims == 0) {
+        *error = "dims must be positive";
+        return false;
+    }
+    options_ = options;
+    record_bytes_ = (kEmbeddingRecordHeaderSize + VectorBytes() + 15) / 16 * 16;
+    const uint32_t quantization = static_cast<uint32_t>(options_.quantization);
+    const uint32_t flags = options_.normalize ? kUnitVectors : 0;
+
+    file_ = std::fopen(path.c_str(), "r+b");
+    if (!file_) {
+        file_ = std::fopen(path.c_str(), "w+b");
+        if (!file_) {
+            *error = "cannot create " + path;
+            return false;
+        }
+        uint8_t header[kEmbeddingStoreHeaderSize] = {};
+        std::memcpy(header, "KKEV", 4);
+        PutLe(header + 4, kEmbeddingStoreVersion, 4);
+        PutLe(header + 8, options_.dims, 4);
+        PutLe(header + 12, quantization, 4);
+        PutLe(header + 16, record_bytes_, 4);
+        PutLe(header + 20, flags, 4);
+        if (std::fwrite(header, 1, sizeof(header), file_) != sizeof(header)) {
+            Close();
+            *error = "cannot write " + path;
+            return false;
+        }
+        Commit(file_);
+    }
+
+    path_ = path;
+    map_ = std::make_unique<MappedFile>();
+    if (!map_->Open(path, error)) {
+        Close();
+        return false;
+    }
+    const uint8_t* header = map_->Data();
+    if (map_->Size() < kEmbeddingStoreHeaderSize || std::memcmp(header, "KKEV", 4) != 0 ||
+        GetLe(header + 4, 4) != kEmbeddingStoreVersion) {
+        Close();
+        *error = "not an embedding store: " + path;
+        return false;
+    }
+    if (GetLe(header + 8, 4) != options_.dims || GetLe(header + 12, 4) != quantization ||
+        GetLe(header + 16, 4) != record_bytes_ || GetLe(header + 20, 4) != flags) {
+        Close();
+        *error = "embedding store was written with other options: " + path;
+        return false;
+    }
+    // A torn last record is left out and written over
+    count_ = (map_->Size() - kEmbeddingStoreHeaderSize) / record_bytes_;
+    mapped_ = count_;
+    return true;
+}
+
+void EmbeddingStore::Close() {
+    if (file_) {
+        Commit(file_);
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    map_.reset();
+    path_.clear();
+    mapped_ = 0;
+    count_ = 0;
+}
+
+bool EmbeddingStore::Append(const std::string& id, const float* vector, std::string* error) {
+    if (!file_) {
+        *error = "embedding store is closed";
+        return false;
+    }
+    if (id.empty() || id.size() > kEmbeddingMaxIdBytes) {
+        *error = "id must be 1 to 63 bytes";
+        return false;
+    }
+    const size_t dims = options_.dims;
+    unit_.assign(vector, vector + dims);
+    float norm_squared = dsp::DotProduct(unit_.data(), unit_.data(), dims);
+    if (!std::isfinite(norm_squared) || norm_squared <= 0.0f) {
+        *error = "Vector is zero or not finite";
+        return false;
+    }
+    if (options_.normalize) {
+        float inverse = 1.0f / std::sqrt(norm_squared);
+        for (float& value : unit_) {
+            value *= inverse;
+        }
+    }
+
+    std::vector<uint8_t> record(record_bytes_, 0);
+    record[0] = static_cast<uint8_t>(id.size());
+    std::memcpy(&record[1], id.data(), id.size());
+    uint8_t* out = &record[kEmbeddingRecordHeaderSize];
+    float scale = 0.0f;
+    switch (options_.quantization) {
+        case EmbeddingQuantization::kFloat32:
+            std::memcpy(out, unit_.data(), dims * sizeof(float));
+            break;
+        case EmbeddingQuantization::kFloat16:
+            for (size_t i = 0; i < dims; ++i) {
+                uint16_t half = embedding::FloatToHalf(unit_[i]);
+                std::memcpy(out + i * sizeof(half), &half, sizeof(half));
+            }
+            break;
+        case EmbeddingQuantization::kInt8:
+            scale = embedding::QuantizeS8(unit_.data(), dims, reinterpret_cast<int8_t*>(out));
+            break;
+    }
+    std::memcpy(&record[68], &scale, sizeof(scale));
+
+    if (!Seek(file_, kEmbeddingStoreHeaderSize + static_cast<uint64_t>(count_) * record_bytes_) ||
+        std::fwrite(record.data(), 1, record.size(), file_) != record.size() || std::fflush(file_) != 0) {
+        *error = "cannot write " + path_;
+        return false;
+    }
+    ++count_;
+    return true;
+}
+
+bool EmbeddingStore::Refresh() {
+    if (mapped_ == count_) {
+        return true;
+    }
+    auto map = std::make_unique<MappedFile>();
+    std::string error;
+    if (!map->Open(path_, &error) || map->Size() < kEmbeddingStoreHeaderSize) {
+        return false;
+    }
+    map_ = std::move(map);
+    mapped_ = std::min(count_, (map_->Size() - kEmbeddingStoreHeaderSize) / record_bytes_);
+    return true;
+}
+
+bool EmbeddingStore::Read(size_t i, std::string* id, float* vector) {
+    if (!file_ || i >= count_ || !Refresh() || i >= mapped_) {
+        return false;
+    }
+    const uint8_t* record = Record(i);
+    if (GetLe(record + 64, 4) & kRemoved) {
+        return false;
+    }
+    if (id) {
+        id->assign(reinterpret_cast<const char*>(record + 1), record[0]);
+    }
+    if (!vector) {
+        return true;
+    }
+    const size_t dims = options_.dims;
+    const uint8_t* stored = record + kEmbeddingRecordHeaderSize;
+    switch (options_.quantization) {
+        case EmbeddingQuantization::kFloat32:
+            std::memcpy(vector, stored, dims * sizeof(float));
+            break;
+        case EmbeddingQuantization::kFloat16:
+            dsp::HalfToFloat(reinterpret_cast<const uint16_t*>(stored), vector, dims);
+            break;
+        case EmbeddingQuantization::kInt8:
+        default: {
+            float scale;
+            std::memcpy(&scale, record + 68, sizeof(scale));
+            const int8_t* codes = reinterpret_cast<const int8_t*>(stored);
+            for (size_t d = 0; d < dims; ++d) {
+                vector[d] = codes[d] * scale;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+bool EmbeddingStore::RemoveAt(size_t i) {
+    if (!Read(i, nullptr, nullptr)) {
+        return false;
+    }
+    uint8_t flags[4];
+    PutLe(flags, kRemoved, 4);
+    // Through the file; the shared map sees it
+    if (!Seek(file_, kEmbeddingStoreHeaderSize + static_cast<uint64_t>(i) * record_bytes_ + 64) ||
+        std::fwrite(flags, 1, sizeof(flags), file_) != sizeof(flags)) {
+        return false;
+    }
+    std::fflush(file_);
+    return true;
+}
+
+size_t EmbeddingStore::Remove(const std::string& id) { return RemoveMatching(id, false); }
+
+size_t EmbeddingStore::RemovePrefix(const std::string& prefix) { return RemoveMatching(prefix, true); }
+
+size_t EmbeddingStore::RemoveMatching(const std::string& key, bool prefix) {
+    if (!file_ || key.empty() || key.size() > kEmbeddingMaxIdBytes) {
+        return 0;
+    }
+    Refresh();
+    size_t removed = 0;
+    uint8_t flags[4];
+    PutLe(flags, kRemoved, 4);
+    for (size_t i = 0; i < mapped_; ++i) {
+        const uint8_t* record = Record(i);
+        if ((prefix ? record[0] < key.size() : record[0] != key.size()) ||
+            std::memcmp(record + 1, key.data(), key.size()) != 0 ||
+            (GetLe(record + 64, 4) & kRemoved)) {
+            continue;
+        }
+        // Through the file; the shared map sees it
+        if (Seek(file_, kEmbeddingStoreHeaderSize + static_cast<uint64_t>(i) * record_bytes_ + 64) &&
+            std::fwrite(flags, 1, sizeof(flags), file_) == sizeof(flags)) {
+            ++removed;
+        }
+    }
+    if (removed > 0) {
+        std::fflush(file_);
+    }
+    return removed;
+}
+
+std::vector<EmbeddingHit> EmbeddingStore::Search(const float* query, size_t k,
+                                                 std::chrono::steady_clock::time_point deadline, bool* complete) {
+    std::vector<EmbeddingHit> hits;
+    if (complete) {
+        *complete = true;
+    }
+    if (!file_ || k == 0 || !Refresh() || mapped_ == 0) {
+        return hits;
+    }
+    const size_t dims = options_.dims;
+    unit_.assign(query, query + dims);
+    float norm_squared = dsp::DotProduct(unit_.data(), unit_.data(), dims);
+    if (!std::isfinite(norm_squared)) {
+        return hits;
+    }
+    if (options_.normalize && norm_squared > 0.0f) {
+        float inverse = 1.0f / std::sqrt(norm_squared);
+        for (float& value : unit_) {
+            value *= inverse;
+        }
+    }
+    float query_scale = 0.0f;
+    if (options_.quantization == EmbeddingQuantization::kInt8) {
+        codes_.resize(dims);
+        query_scale = embedding::QuantizeS8(unit_.data(), dims, codes_.data());
+    } else if (options_.quantization == EmbeddingQuantization::kFloat16) {
+        decode_.resize(dims);
+    }
+
+    // Records sit at 16-byte multiples past a page-aligned map, so the
+    // vectors are read in place
+    std::priority_queue<Scored, std::vector<Scored>, WorstFirst> best;
+    const bool timed = deadline != std::chrono::steady_clock::time_point::max();
+    for (size_t i = 0; i < mapped_; ++i) {
+        if (timed && i % kDeadlineCheckRecords == 0 && std::chrono::steady_clock::now() >= deadline) {
+            if (complete) {
+                *complete = false;
+            }
+            break;
+        }
+        const uint8_t* record = Record(i);
+        if (GetLe(record + 64, 4) & kRemoved) {
+            continue;
+        }
+        const uint8_t* stored = record + kEmbeddingRecordHeaderSize;
+        float score;
+        switch (options_.quantization) {
+            case EmbeddingQuantization::kFloat32:
+                score = dsp::DotProduct(unit_.data(), reinterpret_cast<const float*>(stored), dims);
+                break;
+            case EmbeddingQuantization::kFloat16:
+                dsp::HalfToFloat(reinterpret_cast<const uint16_t*>(stored), decode_.data(), dims);
+                score = dsp::DotProduct(unit_.data(), decode_.data(), dims);
+                break;
+            case EmbeddingQuantization::kInt8:
+            default: {
+                float scale;
+                std::memcpy(&scale, record + 68, sizeof(scale));
+                score = static_cast<float>(dsp::DotProductS8(codes_.data(), reinterpret_cast<const int8_t*>(stored),
+                                                             dims)) *
+                        query_scale * scale;
+                break;
+            }
+        }
+        if (best.size() < k) {
+            best.emplace(score, i);
+        } else if (score > best.top().first) {
+            best.pop();
+            best.emplace(score, i);
+        }
+    }
+
+    hits.resize(best.size());
+    for (size_t i = hits.size(); i-- > 0;) {
+        const uint8_t* record = Record(best.top().second);
+        hits[i].id.assign(reinterpret_cast<const char*>(record + 1), record[0]);
+        hits[i].score = best.top().first;
+        best.pop();
+    }
+    return hits;
+}
+
+} // namespace kakarot
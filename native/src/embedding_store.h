@@ -0,0 +1,98 @@
+#pragma once
+
+#include "embedding_index.h"
+#include "recording_reader.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// An embedding file, <name>.kkev: a fixed header, then one fixed-size record
+// per vector, appended in arrival order. A crash can tear only the last
+// record, which is not counted and is overwritten by the next append.
+// Integers are little-endian; scale and vector are stored as the host's
+// floats, which every platform the app ships on keeps little-endian too.
+//
+//   header  "KKEV", u32 version, u32 dims, u32 quantization (0 float32,
+//           1 float16, 2 int8), u32 record_bytes, u32 flags (bit 0: the
+//           vectors are unit length), u64 reserved
+//   record  u8 id length, id padded to 63 bytes, u32 flags (bit 0:
+//           removed), f32 scale (int8 only), the vector, zero padding to a
+//           multiple of 16 bytes
+constexpr size_t kEmbeddingStoreHeaderSize = 32;
+constexpr size_t kEmbeddingRecordHeaderSize = 72;
+constexpr size_t kEmbeddingMaxIdBytes = 63;
+constexpr uint32_t kEmbeddingStoreVersion = 1;
+
+// Embeddings kept on disk and searched through a read-only memory map, so
+// opening reads only the header and a search pages in what it scans; no
+// part of the store lands in the JS heap. Appends go through the file and
+// the map is renewed by the next search that needs them. The flat scan
+// scores with the dsp kernels EmbeddingIndex uses. One thread at a time.
+class EmbeddingStore {
+public:
+    EmbeddingStore() = default;
+    ~EmbeddingStore();
+
+    EmbeddingStore(const EmbeddingStore&) = delete;
+    EmbeddingStore& operator=(const EmbeddingStore&) = delete;
+
+    // Creates |path| from |options| (dims, quantization, normalize) when
+    // missing; an existing store must have been written with the same ones
+    bool Open(const std::string& path, const EmbeddingIndexOptions& options, std::string* error);
+    void Close();
+
+    // Ids are up to 63 bytes and are not checked for duplicates: Remove()
+    // a document's vectors before appending its new ones
+    bool Append(const std::string& id, const float* vector, std::string* error);
+    // Marks every record under |id| removed; returns how many there were.
+    // A scan of the ids, which share pages with their vectors.
+    size_t Remove(const std::string& id);
+    // The same for every id that starts with |prefix|, e.g. all of a
+    // document's chunks in one pass
+    size_t RemovePrefix(const std::string& prefix);
+
+    // Record |i|'s id and vector, decoded to float32 (unit length when the
+    // store normalizes); either may be null. False for a removed record.
+    bool Read(size_t i, std::string* id, float* vector);
+    // Marks record |i| removed; false when it already was
+    bool RemoveAt(size_t i);
+
+    // Best first, over the records not removed. A scan still going at
+    // |deadline| ranks only the records it reached, leaving |complete| false.
+    std::vector<EmbeddingHit> Search(
+        const float* query, size_t k,
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(),
+        bool* complete = nullptr);
+
+    size_t Records() const { return count_; }  // removed ones included
+    size_t Dims() const { return options_.dims; }
+    size_t Bytes() const { return kEmbeddingStoreHeaderSize + count_ * record_bytes_; }
+
+private:
+    size_t VectorBytes() const;
+    size_t RemoveMatching(const std::string& key, bool prefix);
+    // Maps every record appended so far; false when the file will not map
+    bool Refresh();
+    const uint8_t* Record(size_t i) const { return map_->Data() + kEmbeddingStoreHeaderSize + i * record_bytes_; }
+
+    std::string path_;
+    EmbeddingIndexOptions options_;
+    FILE* file_ = nullptr;
+    std::unique_ptr<MappedFile> map_;
+    size_t mapped_ = 0;     // records the map covers
+    size_t count_ = 0;
+    size_t record_bytes_ = 0;
+
+    // Search scratch
+    std::vector<float> unit_;
+    std::vector<int8_t> codes_;
+    std::vector<float> decode_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,47 @@
+#include "endpointer.h"
+#include <algorithm>
+
+namespace kakarot {
+
+Endpointer::Endpointer(float threshold, size_t min_speech_frames, size_t trailing_silence_frames)
+    : threshold_(threshold),
+      min_speech_frames_(std::max<size_t>(min_speech_frames, 1)),
+      trailing_silence_frames_(std::max<size_t>(trailing_silence_frames, 1)) {}
+
+EndpointEvent Endpointer::Process(const GateFrameInfo& info) {
+    EndpointEvent event;
+    last_ = info;
+    bool speech = info.probability >= threshold_;
+
+    // While speaking, count silence; otherwise count speech. A frame of the
+    // current state breaks the run.
+    if (speech == speaking_) {
+        run_frames_ = 0;
+        return event;
+    }
+    if (run_frames_++ == 0) {
+        run_first_ = info;
+    }
+    if (run_frames_ < (speaking_ ? trailing_silence_frames_ : min_speech_frames_)) {
+        return event;
+    }
+
+    event.type = speaking_ ? EndpointType::kUtteranceEnd : EndpointType::kSpeechStart;
+    event.at = run_first_;
+    speaking_ = !speaking_;
+    run_frames_ = 0;
+    return event;
+}
+
+EndpointEvent Endpointer::Finish() {
+    EndpointEvent event;
+    if (speaking_) {
+        event.type = EndpointType::kUtteranceEnd;
+        event.at = run_frames_ > 0 ? run_first_ : last_;
+    }
+    speaking_ = false;
+    run_frames_ = 0;
+    return event;
+}
+
+} // namespace kakarot
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include "silence_gate.h"
+
+namespace kakarot {
+
+enum class EndpointType { kNone, kSpeechStart, kUtteranceEnd };
+
+struct EndpointEvent {
+    EndpointType type = EndpointType::kNone;
+    GateFrameInfo at{};  // start: first speech frame; end: first frame after the last one
+};
+
+// Utterance boundaries from per-10ms speech probabilities. Speech starts once
+// |min_speech_frames| frames in a row reach |threshold|, reported at the
+// first of them, so shorter bursts (clicks, coughs) never start one; the
+// utterance ends after |trailing_silence_frames| in a row below it, reported
+// where the silence began. Unlike the gate, it only marks: no audio is held.
+class Endpointer {
+public:
+    Endpointer(float threshold, size_t min_speech_frames, size_t trailing_silence_frames);
+
+    // Runs one frame; the event it completes, if any
+    EndpointEvent Process(const GateFrameInfo& info);
+
+    // End of stream: closes an open utterance where its silence began, or
+    // at the last frame when it was still speaking
+    EndpointEvent Finish();
+
+    bool InSpeech() const { return speaking_; }
+
+private:
+    const float threshold_;
+    const size_t min_speech_frames_;
+    const size_t trailing_silence_frames_;
+
+    bool speaking_ = false;
+    size_t run_frames_ = 0;  // consecutive frames against the current state
+    GateFrameInfo run_first_{};
+    GateFrameInfo last_{};
+};
+
+} // namespace kakarot
@@ -0,0 +1,274 @@
+#include "flac_encoder.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace kakarot {
+
+// Rice parameters the 4-bit method can signal without an escape
+static constexpr int kMaxRiceParameter = 14;
+static constexpr int kMaxPartitionOrder = 8;
+static constexpr int kMaxFixedOrder = 4;
+
+namespace {
+
+// MSB-first, as FLAC packs everything
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>* out) : out_(out) {}
+
+    void Put(uint32_t value, int bits) {
+        if (bits == 0) {
+            return;
+        }
+        acc_ = (acc_ << bits) | (value & ((uint64_t{1} << bits) - 1));
+        count_ += bits;
+        while (count_ >= 8) {
+            count_ -= 8;
+            out_->push_back(static_cast<uint8_t>(acc_ >> count_));
+        }
+    }
+
+    void PutSigned(int32_t value, int bits) { Put(static_cast<uint32_t>(value), bits); }
+
+    // |q| zeros, then a one
+    void PutUnary(uint32_t q) {
+        while (q >= 31) {
+            Put(0, 31);
+            q -= 31;
+        }
+        Put(1, static_cast<int>(q) + 1);
+    }
+
+    void PutRice(int32_t value, int k) {
+        uint32_t folded = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+        PutUnary(folded >> k);
+        Put(folded, k);
+    }
+
+    void AlignToByte() {
+        if (count_ > 0) {
+            Put(0, 8 - count_);
+        }
+    }
+
+private:
+    std::vector<uint8_t>* out_;
+    uint64_t acc_ = 0;
+    int count_ = 0;
+};
+
+uint8_t Crc8(const uint8_t* data, size_t size) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = static_cast<uint8_t>((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint16_t Crc16(const uint8_t* data, size_t size) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= static_cast<uint16_t>(data[i] << 8);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Fixed-predictor residual of |order| for samples [order, n)
+void FixedResidual(const int32_t* x, size_t n, int order, int32_t* residual) {
+    for (size_t i = static_cast<size_t>(order); i < n; ++i) {
+        int64_t r = x[i];
+        switch (order) {
+            case 1: r -= x[i - 1]; break;
+            case 2: r -= 2 * int64_t{x[i - 1]} - x[i - 2]; break;
+            case 3: r -= 3 * int64_t{x[i - 1]} - 3 * int64_t{x[i - 2]} + x[i - 3]; break;
+            case 4: r -= 4 * int64_t{x[i - 1]} - 6 * int64_t{x[i - 2]} + 4 * int64_t{x[i - 3]} - x[i - 4]; break;
+            default: break;
+        }
+        residual[i] = static_cast<int32_t>(r);
+    }
+}
+
+uint64_t Folded(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+// The parameter that codes |count| values summing (folded) to |sum| best
+int RiceParameter(uint64_t sum, size_t count) {
+    int k = 0;
+    while (k < kMaxRiceParameter && (uint64_t{count} << (k + 1)) < sum) {
+        ++k;
+    }
+    return k;
+}
+
+uint64_t RiceBits(uint64_t sum, size_t count, int k) {
+    return count * (k + 1) + (sum >> k);
+}
+
+// Partition order and its estimated residual size in bits
+int ChoosePartitionOrder(const int32_t* residual, size_t n, int order, uint64_t* bits) {
+    int best_order = 0;
+    uint64_t best_bits = UINT64_MAX;
+    for (int p = 0; p <= kMaxPartitionOrder; ++p) {
+        const size_t partitions = size_t{1} << p;
+        if (n % partitions != 0 || n / partitions <= static_cast<size_t>(order)) {
+            break;
+        }
+        const size_t length = n / partitions;
+        uint64_t total = 6;  // method and partition order
+        for (size_t part = 0; part < partitions; ++part) {
+            size_t start = part == 0 ? static_cast<size_t>(order) : part * length;
+            size_t end = (part + 1) * length;
+            uint64_t sum = 0;
+            for (size_t i = start; i < end; ++i) {
+                sum += Folded(residual[i]);
+            }
+            size_t count = end - start;
+            total += 4 + RiceBits(sum, count, RiceParameter(sum, count));
+        }
+        if (total < best_bits) {
+            best_bits = total;
+            best_order = p;
+        }
+    }
+    *bits = best_bits;
+    return best_order;
+}
+
+} // namespace
+
+FlacEncoder::FlacEncoder(int sample_rate, int channels, int bits_per_sample, uint64_t total_frames)
+    : sample_rate_(sample_rate),
+      channels_(channels),
+      bits_per_sample_(bits_per_sample),
+      total_frames_(total_frames),
+      channel_(kBlockSize),
+      residual_(kBlockSize) {}
+
+void FlacEncoder::WriteHeader(std::vector<uint8_t>* out) const {
+    out->insert(out->end(), {'f', 'L', 'a', 'C'});
+    BitWriter writer(out);
+    writer.Put(1, 1);   // last metadata block
+    writer.Put(0, 7);   // STREAMINFO
+    writer.Put(34, 24);
+    writer.Put(kBlockSize, 16);
+    writer.Put(kBlockSize, 16);
+    writer.Put(0, 24);  // frame sizes unknown
+    writer.Put(0, 24);
+    writer.Put(static_cast<uint32_t>(sample_rate_), 20);
+    writer.Put(static_cast<uint32_t>(channels_ - 1), 3);
+    writer.Put(static_cast<uint32_t>(bits_per_sample_ - 1), 5);
+    writer.Put(static_cast<uint32_t>(total_frames_ >> 32), 4);
+    writer.Put(static_cast<uint32_t>(total_frames_), 32);
+    out->insert(out->end(), 16, 0);  // MD5
+}
+
+void FlacEncoder::EncodeBlock(const int32_t* interleaved, size_t frames, std::vector<uint8_t>* out) {
+    const size_t start = out->size();
+    const int bps = bits_per_sample_;
+    BitWriter writer(out);
+
+    // Header: sync, block size (4096, or 16 bits at the end), rate and
+    // channels from STREAMINFO's fields, sample size, frame number
+    writer.Put(0xfff8, 16);
+    const bool full = frames == kBlockSize;
+    writer.Put(full ? 12 : 7, 4);
+    writer.Put(0, 4);
+    writer.Put(static_cast<uint32_t>(channels_ - 1), 4);
+    writer.Put(bps == 16 ? 4 : 6, 3);
+    writer.Put(0, 1);
+    const uint32_t number = frame_number_++;
+    if (number < 0x80) {
+        writer.Put(number, 8);
+    } else {
+        // UTF-8 style: a lead byte of n ones, then 6 bits per continuation
+        int continuation = number < 0x800 ? 1 : number < 0x10000 ? 2 : number < 0x200000 ? 3
+                           : number < 0x4000000 ? 4 : 5;
+        uint32_t lead = (0xff00u >> (continuation + 1)) & 0xff;
+        writer.Put(lead | (number >> (6 * continuation)), 8);
+        for (int i = continuation - 1; i >= 0; --i) {
+            writer.Put(0x80 | ((number >> (6 * i)) & 0x3f), 8);
+        }
+    }
+    if (!full) {
+        writer.Put(static_cast<uint32_t>(frames - 1), 16);
+    }
+    writer.Put(Crc8(out->data() + start, out->size() - start), 8);
+
+    for (int c = 0; c < channels_; ++c) {
+        int32_t* x = channel_.data();
+        bool constant = true;
+        for (size_t i = 0; i < frames; ++i) {
+            x[i] = interleaved[i * channels_ + c];
+            constant = constant && x[i] == x[0];
+        }
+
+        writer.Put(0, 1);
+        if (constant) {
+            writer.Put(0, 6);
+            writer.Put(0, 1);
+            writer.PutSigned(x[0], bps);
+            continue;
+        }
+
+        // The fixed order with the smallest residual, when it beats verbatim
+        int best_order = -1;
+        uint64_t best_bits = uint64_t{frames} * bps;
+        int best_partition = 0;
+        for (int order = 0; order <= kMaxFixedOrder && static_cast<size_t>(order) < frames; ++order) {
+            FixedResidual(x, frames, order, residual_.data());
+            uint64_t bits = 0;
+            int partition = ChoosePartitionOrder(residual_.data(), frames, order, &bits);
+            bits += static_cast<uint64_t>(order) * bps;
+            if (bits < best_bits) {
+                best_bits = bits;
+                best_order = order;
+                best_partition = partition;
+            }
+        }
+
+        if (best_order < 0) {
+            writer.Put(1, 6);
+            writer.Put(0, 1);
+            for (size_t i = 0; i < frames; ++i) {
+                writer.PutSigned(x[i], bps);
+            }
+            continue;
+        }
+        writer.Put(8 | static_cast<uint32_t>(best_order), 6);
+        writer.Put(0, 1);
+        for (int i = 0; i < best_order; ++i) {
+            writer.PutSigned(x[i], bps);
+        }
+        FixedResidual(x, frames, best_order, residual_.data());
+        writer.Put(0, 2);  // 4-bit Rice parameters
+        writer.Put(static_cast<uint32_t>(best_partition), 4);
+        const size_t partitions = size_t{1} << best_partition;
+        const size_t length = frames / partitions;
+        for (size_t part = 0; part < partitions; ++part) {
+            size_t begin = part == 0 ? static_cast<size_t>(best_order) : part * length;
+            size_t end = (part + 1) * length;
+            uint64_t sum = 0;
+            for (size_t i = begin; i < end; ++i) {
+                sum += Folded(residual_[i]);
+            }
+            int k = RiceParameter(sum, end - begin);
+            writer.Put(static_cast<uint32_t>(k), 4);
+            for (size_t i = begin; i < end; ++i) {
+                writer.PutRice(residual_[i], k);
+            }
+        }
+    }
+
+    writer.AlignToByte();
+    uint16_t crc = Crc16(out->data() + start, out->size() - start);
+    writer.Put(crc, 16);
+}
+
+} // namespace kakarot
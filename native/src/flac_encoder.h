@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kakarot {
+
+// Lossless FLAC of 16- or 24-bit integer PCM. Each channel of each block is
+// coded on its own as a constant, verbatim or fixed-predictor (order 0-4)
+// subframe with partitioned Rice residuals, whichever is smallest; about
+// what `flac -2` gets on speech, and no libFLAC to link. The MD5 in
+// STREAMINFO is left zero ("not computed"), which every decoder accepts.
+class FlacEncoder {
+public:
+    static constexpr size_t kBlockSize = 4096;
+    static constexpr int kMaxChannels = 8;
+
+    // |total_frames| per channel goes in STREAMINFO; 0 when unknown
+    FlacEncoder(int sample_rate, int channels, int bits_per_sample, uint64_t total_frames);
+
+    // The "fLaC" marker and STREAMINFO; once, first
+    void WriteHeader(std::vector<uint8_t>* out) const;
+
+    // One frame of |frames| interleaved samples per channel, |frames| at
+    // most kBlockSize; only the last frame of a stream may be shorter
+    void EncodeBlock(const int32_t* interleaved, size_t frames, std::vector<uint8_t>* out);
+
+private:
+    const int sample_rate_;
+    const int channels_;
+    const int bits_per_sample_;
+    const uint64_t total_frames_;
+    uint32_t frame_number_ = 0;
+    std::vector<int32_t> channel_;   // one channel of the block
+    std::vector<int32_t> residual_;
+};
+
+} // namespace kakarot
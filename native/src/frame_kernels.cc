@@ -0,0 +1,87 @@
+#include "frame_kernels.h"
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+namespace dsp {
+
+// Independent lanes let the compiler vectorize without -ffast-math
+static constexpr size_t kLanes = 8;
+
+template <size_t N>
+static void CopyFrame(const float* src, size_t, float* dst) {
+    std::memcpy(dst, src, N * sizeof(float));
+}
+
+template <size_t N>
+static void SumSquaresAndPeakFrame(const float* data, size_t, float* sum_squares, float* peak) {
+    static_assert(N % kLanes == 0, "frame must split evenly into lanes");
+    float sum[kLanes] = {};
+    float max[kLanes] = {};
+    for (size_t i = 0; i < N; i += kLanes) {
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            float v = data[i + lane];
+            sum[lane] += v * v;
+            max[lane] = std::max(max[lane], std::abs(v));
+        }
+    }
+    *sum_squares = 0.0f;
+    *peak = 0.0f;
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+        *sum_squares += sum[lane];
+        *peak = std::max(*peak, max[lane]);
+    }
+}
+
+template <size_t N>
+static void DeinterleaveFrame(const float* src, size_t, int num_channels, int channel, float* dst) {
+    if (num_channels == 2) {
+        for (size_t i = 0; i < N; ++i) {
+            dst[i] = src[2 * i + channel];
+        }
+        return;
+    }
+    for (size_t i = 0; i < N; ++i) {
+        dst[i] = src[i * num_channels + channel];
+    }
+}
+
+template <size_t N>
+static void AttenuateBelowFrame(float* data, size_t, float threshold, float gain) {
+    // Branch-free so the compiler vectorizes it
+    for (size_t i = 0; i < N; ++i) {
+        data[i] *= std::abs(data[i]) < threshold ? gain : 1.0f;
+    }
+}
+
+static void Copy(const float* src, size_t num_samples, float* dst) {
+    std::memcpy(dst, src, num_samples * sizeof(float));
+}
+
+static void AttenuateBelow(float* data, size_t num_samples, float threshold, float gain) {
+    for (size_t i = 0; i < num_samples; ++i) {
+        data[i] *= std::abs(data[i]) < threshold ? gain : 1.0f;
+    }
+}
+
+template <size_t N>
+static FrameKernels Specialized() {
+    // A fixed-length downmix measured no faster than the runtime one
+    return FrameKernels{N, true, &CopyFrame<N>, &SumSquaresAndPeakFrame<N>,
+                        &DeinterleaveFrame<N>, &Downmix, &AttenuateBelowFrame<N>};
+}
+
+FrameKernels FrameKernelsFor(size_t frame_size) {
+    switch (frame_size) {
+        case 160: return Specialized<160>();
+        case 320: return Specialized<320>();
+        case 480: return Specialized<480>();
+        default:
+            return FrameKernels{frame_size, false, &Copy, &SumSquaresAndPeak, &Deinterleave, &Downmix, &AttenuateBelow};
+    }
+}
+
+} // namespace dsp
+} // namespace kakarot
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+namespace kakarot {
+namespace dsp {
+
+// Whole-frame kernels, picked once per stream. The 10ms frame is 160, 320 or
+// 480 samples (16/32/48kHz); for those the entries are instantiated with the
+// length as a compile-time constant, so the loops unroll with no remainder
+// handling. Any other size gets the runtime dsp:: kernels. Signatures match
+// dsp_kernels.h; the specialized entries ignore the length argument, which
+// callers pass as the frame size.
+struct FrameKernels {
+    size_t frame_size = 0;
+    bool specialized = false;
+
+    void (*copy)(const float* src, size_t num_samples, float* dst) = nullptr;
+    void (*sum_squares_and_peak)(const float* data, size_t num_samples, float* sum_squares, float* peak) = nullptr;
+    void (*deinterleave)(const float* src, size_t num_frames, int num_channels, int channel, float* dst) = nullptr;
+    void (*downmix)(const float* src, size_t num_frames, int num_channels, float* dst) = nullptr;
+
+    // data[i] *= gain wherever |data[i]| < threshold
+    void (*attenuate_below)(float* data, size_t num_samples, float threshold, float gain) = nullptr;
+};
+
+FrameKernels FrameKernelsFor(size_t frame_size);
+
+} // namespace dsp
+} // namespace kakarot
@@ -0,0 +1,239 @@
+#include "fuzzy_index.h"
+#include <algorithm>
+#include <array>
+
+namespace kakarot {
+
+namespace {
+
+// Names and addresses fit; longer text is cut so a key is one machine word
+constexpr size_t kMaxKeyBytes = 64;
+// Candidates scored per hit asked for, and at least
+constexpr size_t kCandidatesPerHit = 16;
+constexpr size_t kMinCandidates = 128;
+// A query of one word also tries each word of a key, a little lower
+constexpr float kWordMatchWeight = 0.95f;
+
+bool IsKeyByte(uint8_t byte) {
+    return (byte >= 'a' && byte <= 'z') || (byte >= '0' && byte <= '9') || byte >= 0x80;
+}
+
+uint32_t Gram(const std::string& padded, size_t i) {
+    return (static_cast<uint32_t>(static_cast<uint8_t>(padded[i])) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(padded[i + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<uint8_t>(padded[i + 2]));
+}
+
+// The distinct trigrams of |text| with a space either side, so short keys
+// and word edges have some
+std::vector<uint32_t> Grams(const std::string& text) {
+    std::vector<uint32_t> grams;
+    if (text.empty()) return grams;
+    const std::string padded = " " + text + " ";
+    for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+        grams.push_back(Gram(padded, i));
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+// One bit per byte position of the pattern, for each byte value
+struct BitPattern {
+    explicit BitPattern(const std::string& text) : text(text) {
+        for (size_t i = 0; i < text.size(); ++i) {
+            peq[static_cast<uint8_t>(text[i])] |= uint64_t{1} << i;
+        }
+    }
+    const std::string& text;
+    std::array<uint64_t, 256> peq{};
+};
+
+// Myers' bit-vector edit distance, in Hyyrö's formulation: each byte of
+// |b| advances a whole column of the DP matrix in a few word operations
+size_t LevenshteinBits(const BitPattern& a, const char* b, size_t n) {
+    const size_t m = a.text.size();
+    if (m == 0) return n;
+    uint64_t pv = ~uint64_t{0};
+    uint64_t mv = 0;
+    const uint64_t last = uint64_t{1} << (m - 1);
+    size_t score = m;
+    for (size_t j = 0; j < n; ++j) {
+        const uint64_t eq = a.peq[static_cast<uint8_t>(b[j])];
+        const uint64_t xv = eq | mv;
+        const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & last) {
+            ++score;
+        } else if (mh & last) {
+            --score;
+        }
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+// Jaro-Winkler with the match window as a mask: each byte of |b| takes the
+// first unmatched equal byte of |a| in its window with one isolate-lowest-bit
+float JaroWinklerBits(const BitPattern& a, const char* b, size_t n) {
+    const size_t m = a.text.size();
+    if (m == 0 || n == 0) return m == n ? 1.0f : 0.0f;
+    const size_t window = std::max(m, n) / 2 > 0 ? std::max(m, n) / 2 - 1 : 0;
+    uint64_t matched = 0;
+    std::array<char, kMaxKeyBytes> order{};
+    size_t matches = 0;
+    for (size_t j = 0; j < n; ++j) {
+        const size_t lo = j > window ? j - window : 0;
+        const size_t hi = std::min(j + window + 1, m);
+        if (lo >= hi) continue;
+        const uint64_t upto = hi >= 64 ? ~uint64_t{0} : (uint64_t{1} << hi) - 1;
+        const uint64_t mask = upto & ~((uint64_t{1} << lo) - 1);
+        const uint64_t free = a.peq[static_cast<uint8_t>(b[j])] & mask & ~matched;
+        if (free != 0) {
+            matched |= free & (~free + 1);
+            order[matches++] = b[j];
+        }
+    }
+    if (matches == 0) return 0.0f;
+
+    size_t transposed = 0;
+    for (size_t i = 0, k = 0; i < m; ++i) {
+        if (matched & (uint64_t{1} << i)) {
+            transposed += a.text[i] != order[k++];
+        }
+    }
+    const float found = static_cast<float>(matches);
+    const float jaro = (found / static_cast<float>(m) + found / static_cast<float>(n) +
+                        (found - static_cast<float>(transposed / 2)) / found) / 3.0f;
+    size_t prefix = 0;
+    while (prefix < 4 && prefix < m && prefix < n && a.text[prefix] == b[prefix]) {
+        ++prefix;
+    }
+    return jaro + static_cast<float>(prefix) * 0.1f * (1.0f - jaro);
+}
+
+float Similarity(const BitPattern& a, const char* b, size_t n) {
+    const size_t longest = std::max(a.text.size(), n);
+    if (longest == 0) return 1.0f;
+    const float edits = 1.0f - static_cast<float>(LevenshteinBits(a, b, n)) / static_cast<float>(longest);
+    return std::max(edits, JaroWinklerBits(a, b, n));
+}
+
+// The key whole, and each of its words when the query is one word
+float ScoreKey(const BitPattern& query, bool one_word, const std::string& text, const std::vector<uint32_t>& words) {
+    float best = Similarity(query, text.data(), text.size());
+    if (one_word && words.size() > 1) {
+        for (size_t w = 0; w < words.size(); ++w) {
+            const size_t start = words[w];
+            const size_t end = w + 1 < words.size() ? words[w + 1] - 1 : text.size();
+            best = std::max(best, kWordMatchWeight * Similarity(query, text.data() + start, end - start));
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+std::string FuzzyIndex::Normalize(const std::string& text) {
+    std::string out;
+    out.reserve(std::min(text.size(), kMaxKeyBytes));
+    for (char raw : text) {
+        uint8_t byte = static_cast<uint8_t>(raw);
+        if (byte >= 'A' && byte <= 'Z') byte = static_cast<uint8_t>(byte | 0x20);
+        if (!IsKeyByte(byte)) {
+            if (!out.empty() && out.back() != ' ') out.push_back(' ');
+            continue;
+        }
+        if (out.size() == kMaxKeyBytes) break;
+        out.push_back(static_cast<char>(byte));
+    }
+    while (!out.empty() && out.back() == ' ') out.pop_back();
+    return out;
+}
+
+size_t FuzzyIndex::Levenshtein(const std::string& a, const std::string& b) {
+    const std::string pattern = a.substr(0, kMaxKeyBytes);
+    return LevenshteinBits(BitPattern(pattern), b.data(), std::min(b.size(), kMaxKeyBytes));
+}
+
+float FuzzyIndex::JaroWinkler(const std::string& a, const std::string& b) {
+    const std::string pattern = a.substr(0, kMaxKeyBytes);
+    return JaroWinklerBits(BitPattern(pattern), b.data(), std::min(b.size(), kMaxKeyBytes));
+}
+
+void FuzzyIndex::Add(uint32_t entry, const std::string& text) {
+    if (ordinals_.size() <= entry) ordinals_.resize(static_cast<size_t>(entry) + 1, 0);
+    Key key;
+    key.entry = entry;
+    key.ordinal = ordinals_[entry]++;
+    key.text = Normalize(text);
+    if (key.text.empty()) return;  // counted, so ordinals stay the caller's
+    for (size_t i = 0; i < key.text.size(); ++i) {
+        if (i == 0 || key.text[i - 1] == ' ') key.words.push_back(static_cast<uint32_t>(i));
+    }
+    const uint32_t index = static_cast<uint32_t>(keys_.size());
+    for (uint32_t gram : Grams(key.text)) {
+        postings_.push_back(Posting{gram, index});
+    }
+    keys_.push_back(std::move(key));
+    built_ = false;
+}
+
+void FuzzyIndex::Build() {
+    std::sort(postings_.begin(), postings_.end(), [](const Posting& a, const Posting& b) {
+        return a.gram != b.gram ? a.gram < b.gram : a.key < b.key;
+    });
+    built_ = true;
+}
+
+std::vector<FuzzyHit> FuzzyIndex::Search(const std::string& raw, size_t limit, float min_score) const {
+    std::vector<FuzzyHit> hits;
+    const std::string query = Normalize(raw);
+    if (query.empty() || limit == 0 || !built_) return hits;
+    const std::vector<uint32_t> grams = Grams(query);
+
+    // Shared trigrams per key, over the keys that share any
+    std::vector<uint16_t> shared(keys_.size(), 0);
+    std::vector<uint32_t> touched;
+    for (uint32_t gram : grams) {
+        auto first = std::lower_bound(postings_.begin(), postings_.end(), gram,
+                                      [](const Posting& p, uint32_t g) { return p.gram < g; });
+        for (auto it = first; it != postings_.end() && it->gram == gram; ++it) {
+            if (shared[it->key]++ == 0) touched.push_back(it->key);
+        }
+    }
+
+    // Dice over the trigram sets, padding included: the key's grams are
+    // its length plus two at most, which is close enough to rank by
+    auto dice = [&](uint32_t k) {
+        return 2.0f * shared[k] / static_cast<float>(grams.size() + keys_[k].text.size() + 2);
+    };
+    const size_t candidates = std::min(touched.size(), std::max(kMinCandidates, limit * kCandidatesPerHit));
+    std::partial_sort(touched.begin(), touched.begin() + static_cast<std::ptrdiff_t>(candidates), touched.end(),
+                      [&](uint32_t a, uint32_t b) { return dice(a) > dice(b); });
+
+    const BitPattern pattern(query);
+    const bool one_word = query.find(' ') == std::string::npos;
+    for (size_t c = 0; c < candidates; ++c) {
+        const Key& key = keys_[touched[c]];
+        const float score = ScoreKey(pattern, one_word, key.text, key.words);
+        if (score < min_score) continue;
+        auto same = std::find_if(hits.begin(), hits.end(), [&](const FuzzyHit& h) { return h.entry == key.entry; });
+        if (same == hits.end()) {
+            hits.push_back(FuzzyHit{key.entry, key.ordinal, score});
+        } else if (score > same->score) {
+            *same = FuzzyHit{key.entry, key.ordinal, score};
+        }
+    }
+    std::sort(hits.begin(), hits.end(), [](const FuzzyHit& a, const FuzzyHit& b) {
+        return a.score != b.score ? a.score > b.score : a.entry < b.entry;
+    });
+    if (hits.size() > limit) hits.resize(limit);
+    return hits;
+}
+
+} // namespace kakarot
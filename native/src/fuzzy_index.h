@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+struct FuzzyHit {
+    uint32_t entry = 0;
+    uint32_t key = 0;   // which of the entry's keys matched best
+    float score = 0.0f; // 0 to 1, 1 for the same text once normalized
+};
+
+// Approximate lookup of short keys, such as names and email addresses,
+// belonging to numbered entries. Keys are folded (ASCII case, and
+// punctuation to spaces) and indexed by trigram; a query counts the
+// trigrams it shares with each key, and only the best-sharing candidates
+// are scored. Scoring runs Levenshtein and Jaro-Winkler bit-parallel over
+// the query, 64 bytes per machine word, and keeps the higher. Build once,
+// then Search from any number of threads.
+class FuzzyIndex {
+public:
+    void Add(uint32_t entry, const std::string& key);
+    // Sorts the trigram postings; Add after Build needs another Build
+    void Build();
+    size_t Keys() const { return keys_.size(); }
+
+    // The |limit| best entries scoring at least |min_score|, best first,
+    // one hit per entry
+    std::vector<FuzzyHit> Search(const std::string& query, size_t limit, float min_score) const;
+
+    // Exposed for the pieces of a score
+    static std::string Normalize(const std::string& text);
+    static size_t Levenshtein(const std::string& a, const std::string& b);
+    static float JaroWinkler(const std::string& a, const std::string& b);
+
+private:
+    struct Key {
+        uint32_t entry = 0;
+        uint32_t ordinal = 0;   // among the entry's keys
+        std::string text;       // normalized
+        std::vector<uint32_t> words;  // offsets where each word starts
+    };
+    struct Posting {
+        uint32_t gram = 0;
+        uint32_t key = 0;
+    };
+
+    std::vector<Key> keys_;
+    std::vector<uint32_t> ordinals_;  // keys added so far, by entry
+    std::vector<Posting> postings_;   // by gram, then key, once built
+    bool built_ = true;
+};
+
+} // namespace kakarot
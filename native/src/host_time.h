@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+namespace kakarot {
+
+// Current host time: mach absolute ticks (CoreAudio's host time) on macOS,
+// QueryPerformanceCounter ticks (WASAPI's QPC position, converted) on
+// Windows, CLOCK_MONOTONIC nanoseconds (PipeWire's clock) on Linux. Safe on
+// the RT thread.
+inline uint64_t HostTimeNow() {
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return static_cast<uint64_t>(counter.QuadPart);
+#elif defined(__APPLE__)
+    return mach_absolute_time();
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+// Maps host time onto milliseconds, and onto the JS Date.now() domain via
+// a (host, wall) pair sampled once per session. After the anchor is taken the
+// mapping is monotonic: NTP slews of the wall clock no longer move timestamps.
+class HostClock {
+public:
+    HostClock() {
+#if defined(_WIN32)
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        numer_ = 1000000000.0;
+        denom_ = static_cast<double>(frequency.QuadPart);
+#elif defined(__APPLE__)
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        numer_ = timebase.numer;
+        denom_ = timebase.denom;
+#endif
+        Anchor();
+    }
+
+    void Anchor() {
+        anchor_host_ = HostTimeNow();
+        auto now = std::chrono::system_clock::now();
+        anchor_wall_ms_ = std::chrono::duration<double, std::milli>(now.time_since_epoch()).count();
+    }
+
+    double TicksToMs(uint64_t ticks) const {
+        return static_cast<double>(ticks) * numer_ / denom_ / 1e6;
+    }
+
+    uint64_t MsToTicks(double ms) const {
+        return static_cast<uint64_t>(ms * 1e6 * denom_ / numer_);
+    }
+
+    // Host time in ms since boot (monotonic)
+    double HostTimeMs(uint64_t host_time) const {
+        return TicksToMs(host_time);
+    }
+
+    // Host time in ms since the Unix epoch, comparable to Date.now()
+    double ToDateNowMs(uint64_t host_time) const {
+        if (host_time >= anchor_host_) {
+            return anchor_wall_ms_ + TicksToMs(host_time - anchor_host_);
+        }
+        return anchor_wall_ms_ - TicksToMs(anchor_host_ - host_time);
+    }
+
+    // Inverse of ToDateNowMs, for timestamps that originate in JS
+    uint64_t FromDateNowMs(double date_now_ms) const {
+        double delta_ms = date_now_ms - anchor_wall_ms_;
+        if (delta_ms >= 0.0) {
+            return anchor_host_ + MsToTicks(delta_ms);
+        }
+        uint64_t back = MsToTicks(-delta_ms);
+        return back < anchor_host_ ? anchor_host_ - back : 0;
+    }
+
+private:
+    double numer_ = 1.0;  // ns per tick = numer_ / denom_
+    double denom_ = 1.0;
+    uint64_t anchor_host_ = 0;
+    double anchor_wall_ms_ = 0.0;
+};
+
+} // namespace kakarot
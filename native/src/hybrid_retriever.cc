@@ -0,0 +1,110 @@
+#include "hybrid_retriever.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+
+namespace kakarot {
+
+// Candidates each search ranks per hit asked for, and at least
+static constexpr size_t kCandidatesPerHit = 4;
+static constexpr size_t kMinCandidates = 20;
+
+std::vector<FusedHit> FuseRanks(const std::vector<EmbeddingHit>& vector_hits,
+                                const std::vector<EmbeddingHit>& lexical_hits, size_t k, double rrf_k) {
+    std::vector<FusedHit> fused;
+    std::unordered_map<std::string, size_t> by_id;
+    auto add = [&](const std::vector<EmbeddingHit>& hits, bool lexical) {
+        for (size_t rank = 0; rank < hits.size(); ++rank) {
+            auto found = by_id.emplace(hits[rank].id, fused.size());
+            if (found.second) {
+                fused.push_back(FusedHit{hits[rank].id});
+            }
+            FusedHit& hit = fused[found.first->second];
+            int& own_rank = lexical ? hit.lexical_rank : hit.vector_rank;
+            if (own_rank >= 0) {
+                continue;  // an id twice in one list counts once, at its best
+            }
+            own_rank = static_cast<int>(rank);
+            hit.score += static_cast<float>(1.0 / (rrf_k + rank + 1.0));
+        }
+    };
+    add(vector_hits, false);
+    add(lexical_hits, true);
+    // Ties go to the better vector rank, then the better lexical one
+    auto better = [](const FusedHit& a, const FusedHit& b) {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+        // Unsigned, -1 (absent) sorts last
+        if (a.vector_rank != b.vector_rank) {
+            return static_cast<unsigned>(a.vector_rank) < static_cast<unsigned>(b.vector_rank);
+        }
+        return static_cast<unsigned>(a.lexical_rank) < static_cast<unsigned>(b.lexical_rank);
+    };
+    const size_t count = std::min(k, fused.size());
+    std::partial_sort(fused.begin(), fused.begin() + count, fused.end(), better);
+    fused.resize(count);
+    return fused;
+}
+
+HybridResult HybridSearch(TaskScheduler* scheduler, EmbeddingStore* store, const float* vector,
+                          std::shared_ptr<const LexicalIndex> lexical, const std::string& text, size_t k,
+                          double budget_ms, double rrf_k) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double, std::milli>(std::max(0.0, budget_ms)));
+    const size_t candidates = std::max(k * kCandidatesPerHit, kMinCandidates);
+
+    // Shared with the worker, which may outlive this call
+    struct Lexical {
+        std::mutex mutex;
+        std::condition_variable done_changed;
+        bool done = false;
+        bool complete = false;
+        std::vector<EmbeddingHit> hits;
+    };
+    auto pending = std::make_shared<Lexical>();
+    if (lexical && !text.empty()) {
+        scheduler->Post(TaskPriority::kInteractive, [pending, lexical, text, candidates, deadline](
+                                                        const std::atomic<bool>& cancel) {
+            bool complete = false;
+            std::vector<EmbeddingHit> hits;
+            if (!cancel.load(std::memory_order_relaxed)) {
+                hits = lexical->Search(text, candidates, deadline, &complete);
+            }
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            pending->hits = std::move(hits);
+            pending->complete = complete;
+            pending->done = true;
+            pending->done_changed.notify_all();
+        });
+    } else {
+        pending->done = true;
+        pending->complete = true;
+    }
+
+    HybridResult result;
+    std::vector<EmbeddingHit> vector_hits;
+    if (vector) {
+        vector_hits = store->Search(vector, candidates, deadline, &result.complete);
+    }
+    std::vector<EmbeddingHit> lexical_hits;
+    {
+        std::unique_lock<std::mutex> lock(pending->mutex);
+        pending->done_changed.wait_until(lock, deadline, [&] { return pending->done; });
+        if (pending->done) {
+            lexical_hits = std::move(pending->hits);
+            result.complete = result.complete && pending->complete;
+        } else {
+            result.complete = false;
+        }
+    }
+    result.hits = FuseRanks(vector_hits, lexical_hits, k, rrf_k);
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return result;
+}
+
+} // namespace kakarot
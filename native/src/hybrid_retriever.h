@@ -0,0 +1,41 @@
+#pragma once
+
+#include "embedding_store.h"
+#include "lexical_index.h"
+#include "task_scheduler.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+struct FusedHit {
+    std::string id;
+    float score = 0.0f;     // reciprocal-rank fusion
+    int vector_rank = -1;   // 0-based in each list, -1 when absent
+    int lexical_rank = -1;
+};
+
+struct HybridResult {
+    std::vector<FusedHit> hits;  // best first
+    bool complete = true;        // both searches finished within the budget
+    double elapsed_ms = 0.0;
+};
+
+// Reciprocal-rank fusion: each list adds 1 / (|rrf_k| + rank + 1) to the
+// ids it holds, so agreement between the lists outranks either alone and
+// the lists' own score scales never meet
+std::vector<FusedHit> FuseRanks(const std::vector<EmbeddingHit>& vector_hits,
+                                const std::vector<EmbeddingHit>& lexical_hits, size_t k, double rrf_k);
+
+// The vector scan of |store| on the calling thread and the BM25 search of
+// |lexical| on an interactive worker, at once, each taking the candidates
+// of several times |k| and stopping at |budget_ms|; then fused. A lexical
+// search not back by the budget is left out (it finishes on its own, the
+// index kept alive for it).
+HybridResult HybridSearch(TaskScheduler* scheduler, EmbeddingStore* store, const float* vector,
+                          std::shared_ptr<const LexicalIndex> lexical, const std::string& text, size_t k,
+                          double budget_ms, double rrf_k);
+
+} // namespace kakarot
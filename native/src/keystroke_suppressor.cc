@@ -0,0 +1,207 @@
+#include "keystroke_suppressor.h"
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+// Bands: clicks are scored above kHighBandHz, speech is looked for in the low one
+static constexpr float kLowBandHz[2] = {100.0f, 1000.0f};
+static constexpr float kHighBandHz[2] = {2000.0f, 8000.0f};
+
+// Keystroke likelihood is the product of four ramps, each 0 below its first
+// value and 1 above its second
+static constexpr float kFluxRamp[2] = {0.5f, 2.0f};     // high-band rise over the last frame
+static constexpr float kCrestRamp[2] = {2.0f, 5.0f};    // peak 1ms energy over the frame mean
+static constexpr float kRiseRamp[2] = {4.0f, 16.0f};    // high-band energy over its floor
+static constexpr float kShareRamp[2] = {0.15f, 0.4f};   // high band's share of the energy
+
+// A frame is this many 1ms sub-blocks
+static constexpr size_t kSubBlocks = 10;
+
+// A 1ms peak quieter than this (-60dBFS) is never a keystroke worth ducking
+static constexpr float kMinPeakPower = 1e-6f;
+
+// Low-band energy this far over its floor (9dB) means speech is under the click
+static constexpr float kSpeechOverFloor = 8.0f;
+
+// The floors follow quieter frames at once and louder ones this slowly
+static constexpr float kFloorRisePerSecond = 0.5f;
+static constexpr float kMinFloor = 1e-9f;  // so a floor can rise after digital silence
+
+// Ducked gain alone (-24dB) and over speech (-9dB), so words keep their body
+static constexpr float kDuckedGain = 0.063f;
+static constexpr float kSpeechDuckedGain = 0.35f;
+
+// The duck starts this long before the onset sub-block and lasts the hold;
+// the gain falls and recovers with these time constants
+static constexpr double kPreOnsetMs = 1.0;
+static constexpr double kHoldMs = 40.0;
+static constexpr double kAttackMs = 0.5;
+static constexpr double kReleaseMs = 20.0;
+
+static float Ramp(float value, const float (&range)[2]) {
+    return std::max(0.0f, std::min((value - range[0]) / (range[1] - range[0]), 1.0f));
+}
+
+static size_t FftSizeFor(size_t frame_size) {
+    size_t size = 128;
+    while (size < frame_size) {
+        size *= 2;
+    }
+    return size;
+}
+
+static size_t Bin(float hz, size_t fft_size, int sample_rate) {
+    return static_cast<size_t>(std::lround(hz * fft_size / sample_rate));
+}
+
+bool KeystrokeSuppressor::Supports(int sample_rate) {
+    return sample_rate >= 8000 && sample_rate <= 48000 && sample_rate % 100 == 0;
+}
+
+KeystrokeSuppressor::KeystrokeSuppressor(int sample_rate, float threshold)
+    : frame_size_(static_cast<size_t>(sample_rate / 100)),
+      sub_block_(std::max<size_t>(1, static_cast<size_t>(sample_rate / 1000))),
+      threshold_(std::max(0.0f, std::min(threshold, 1.0f))),
+      fft_size_(FftSizeFor(frame_size_)),
+      attack_samples_(static_cast<size_t>(kPreOnsetMs * sample_rate / 1000.0)),
+      hold_samples_(static_cast<size_t>(kHoldMs * sample_rate / 1000.0)),
+      attack_coeff_(static_cast<float>(std::exp(-1000.0 / (kAttackMs * sample_rate)))),
+      release_coeff_(static_cast<float>(std::exp(-1000.0 / (kReleaseMs * sample_rate)))),
+      fft_(std::make_unique<webrtc::Pffft>(fft_size_, webrtc::Pffft::FftType::kReal)),
+      fft_in_(fft_->CreateBuffer()),
+      fft_out_(fft_->CreateBuffer()),
+      power_(fft_size_ / 2 + 1, 0.0f),
+      pending_(frame_size_, 0.0f),
+      ready_(frame_size_, 0.0f) {
+    const size_t nyquist = fft_size_ / 2;
+    low_begin_ = std::max<size_t>(1, Bin(kLowBandHz[0], fft_size_, sample_rate));
+    low_end_ = std::min(nyquist, Bin(kLowBandHz[1], fft_size_, sample_rate) + 1);
+    high_begin_ = std::min(nyquist - 1, Bin(kHighBandHz[0], fft_size_, sample_rate));
+    high_end_ = std::min(nyquist, Bin(kHighBandHz[1], fft_size_, sample_rate) + 1);
+    magnitudes_.assign(high_end_ - high_begin_, 0.0f);
+}
+
+KeystrokeSuppressor::~KeystrokeSuppressor() = default;
+
+void KeystrokeSuppressor::Reset() {
+    std::fill(magnitudes_.begin(), magnitudes_.end(), 0.0f);
+    std::fill(pending_.begin(), pending_.end(), 0.0f);
+    std::fill(ready_.begin(), ready_.end(), 0.0f);
+    fill_ = 0;
+    low_floor_ = -1.0f;
+    high_floor_ = -1.0f;
+    hold_ = 0;
+    ducked_gain_ = 1.0f;
+    gain_ = 1.0f;
+}
+
+// Scores |frame| and finds the sub-block its loudest transient starts in.
+// No window: a click at the edge of the frame must count in full, and the
+// features are band sums, which leakage barely moves.
+void KeystrokeSuppressor::Analyze(const float* frame, float* likelihood, size_t* onset) {
+    float* in = fft_in_->GetView().data();
+    std::memcpy(in, frame, frame_size_ * sizeof(float));
+    std::fill(in + frame_size_, in + fft_size_, 0.0f);
+    fft_->ForwardTransform(*fft_in_, fft_out_.get(), true);
+
+    dsp::OrderedPower(fft_out_->GetConstView().data(), fft_size_, power_.data());
+    float low = 0.0f;
+    for (size_t k = low_begin_; k < low_end_; ++k) {
+        low += power_[k];
+    }
+    float high = 0.0f;
+    float flux = 0.0f;
+    float previous = 0.0f;
+    for (size_t k = high_begin_; k < high_end_; ++k) {
+        float power = power_[k];
+        float magnitude = std::sqrt(power);
+        float& last = magnitudes_[k - high_begin_];
+        flux += std::max(0.0f, magnitude - last);
+        previous += last;
+        last = magnitude;
+        high += power;
+    }
+
+    // 1ms energies: the peak, its share of the frame and where it starts
+    const size_t blocks = std::min(kSubBlocks, frame_size_ / sub_block_);
+    float peak = 0.0f;
+    float total = 0.0f;
+    size_t peak_block = 0;
+    float energies[kSubBlocks];
+    for (size_t b = 0; b < blocks; ++b) {
+        float energy = 0.0f;
+        for (size_t i = b * sub_block_; i < (b + 1) * sub_block_; ++i) {
+            energy += frame[i] * frame[i];
+        }
+        energies[b] = energy;
+        total += energy;
+        if (energy > peak) {
+            peak = energy;
+            peak_block = b;
+        }
+    }
+    size_t first = peak_block;
+    while (first > 0 && energies[first - 1] >= 0.25f * peak) {
+        --first;
+    }
+    *onset = first * sub_block_;
+    const float crest = peak * static_cast<float>(blocks) / (total + 1e-12f);
+
+    const float rise = high_floor_ > 0.0f ? high / high_floor_ : 1.0f;
+    const float speech = low_floor_ > 0.0f ? low / low_floor_ : 1.0f;
+    *likelihood = peak / static_cast<float>(sub_block_) < kMinPeakPower ? 0.0f
+        : Ramp(flux / (previous + 1e-9f), kFluxRamp) * Ramp(crest, kCrestRamp) * Ramp(rise, kRiseRamp) *
+          Ramp(high / (high + low + 1e-12f), kShareRamp);
+    ducked_gain_ = speech >= kSpeechOverFloor ? kSpeechDuckedGain : kDuckedGain;
+
+    const float grow = 1.0f + kFloorRisePerSecond * 0.01f;
+    high_floor_ = std::max(kMinFloor, high_floor_ < 0.0f || high < high_floor_ ? high : high_floor_ * grow);
+    low_floor_ = std::max(kMinFloor, low_floor_ < 0.0f || low < low_floor_ ? low : low_floor_ * grow);
+}
+
+float KeystrokeSuppressor::ProcessFrame(float* frame) {
+    float likelihood = 0.0f;
+    size_t onset = 0;
+    Analyze(frame, &likelihood, &onset);
+
+    const bool detected = likelihood >= threshold_ && threshold_ > 0.0f;
+    const size_t start = detected ? (onset > attack_samples_ ? onset - attack_samples_ : 0) : frame_size_;
+    if (detected && hold_ == 0) {
+        ++keystrokes_;
+    }
+    for (size_t i = 0; i < frame_size_; ++i) {
+        if (i == start) {
+            hold_ = hold_samples_;
+        }
+        float target = 1.0f;
+        if (hold_ > 0) {
+            target = ducked_gain_;
+            --hold_;
+        }
+        float coeff = target < gain_ ? attack_coeff_ : release_coeff_;
+        gain_ = target + (gain_ - target) * coeff;
+        frame[i] *= gain_;
+    }
+    return likelihood;
+}
+
+void KeystrokeSuppressor::Process(float* data, size_t num_samples) {
+    size_t done = 0;
+    while (done < num_samples) {
+        size_t count = std::min(frame_size_ - fill_, num_samples - done);
+        std::memcpy(pending_.data() + fill_, data + done, count * sizeof(float));
+        std::memcpy(data + done, ready_.data() + fill_, count * sizeof(float));
+        fill_ += count;
+        done += count;
+        if (fill_ == frame_size_) {
+            ProcessFrame(pending_.data());
+            pending_.swap(ready_);
+            fill_ = 0;
+        }
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "modules/audio_processing/utility/pffft_wrapper.h"
+
+namespace kakarot {
+
+// Ducks keystrokes and other clicks out of a mic stream before the VAD and
+// ASR see them. Each 10ms frame is scored for keystroke likelihood: positive
+// spectral flux above 2kHz against the previous frame, the frame's share of
+// energy up there, the crest of its 1ms energies and its rise over the
+// high-band floor. Typing is broadband, impulsive and sudden; speech onsets
+// are slower and sit lower. A frame that scores is attenuated from just
+// before its onset sub-block for a hold, less deeply while there is speech
+// underneath. APM noise suppression does little against transients.
+//
+// Real-time safe after construction. Not thread-safe.
+class KeystrokeSuppressor {
+public:
+    // 10ms frames at 8 to 48kHz
+    static bool Supports(int sample_rate);
+
+    // |threshold| is the likelihood (0 to 1) that counts as a keystroke
+    KeystrokeSuppressor(int sample_rate, float threshold = 0.5f);
+    ~KeystrokeSuppressor();
+
+    KeystrokeSuppressor(const KeystrokeSuppressor&) = delete;
+    KeystrokeSuppressor& operator=(const KeystrokeSuppressor&) = delete;
+
+    // Exactly FrameSize() samples, in place, with no delay. Returns the
+    // frame's keystroke likelihood.
+    float ProcessFrame(float* frame);
+
+    // Any number of samples, in place, through an internal frame: the output
+    // trails the input by FrameSize() samples
+    void Process(float* data, size_t num_samples);
+
+    void Reset();
+
+    size_t FrameSize() const { return frame_size_; }
+    uint64_t Keystrokes() const { return keystrokes_; }  // since construction
+
+private:
+    void Analyze(const float* frame, float* likelihood, size_t* onset);
+
+    const size_t frame_size_;
+    const size_t sub_block_;    // 1ms
+    const float threshold_;
+    const size_t fft_size_;
+    size_t low_begin_, low_end_, high_begin_, high_end_;  // bins
+    const size_t attack_samples_;
+    const size_t hold_samples_;
+    const float attack_coeff_;
+    const float release_coeff_;
+
+    std::unique_ptr<webrtc::Pffft> fft_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_in_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_out_;
+    std::vector<float> power_;           // this frame's, DC to Nyquist
+    std::vector<float> magnitudes_;      // the previous frame's, high band
+
+    float low_floor_ = -1.0f;
+    float high_floor_ = -1.0f;
+    size_t hold_ = 0;                   // samples left at the ducked gain
+    float ducked_gain_ = 1.0f;
+    float gain_ = 1.0f;
+    uint64_t keystrokes_ = 0;
+
+    // Process(): one frame in, the previous one out
+    std::vector<float> pending_;
+    std::vector<float> ready_;
+    size_t fill_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,518 @@
+#include "keyword_spotter.h"
+#include "dsp_kernels.h"
+#include "native_log.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include "rtc_base/denormal_disabler.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace kakarot {
+
+// Source tag of records this file writes to the native log ring
+static const char* const kLogSource = "KeywordSpotter";
+
+static constexpr uint32_t kModelVersion = 1;
+
+// Model limits: the right context is latency, so it stays short
+static constexpr int kMaxLeftContext = 32;
+static constexpr int kMaxRightContext = 8;
+static constexpr size_t kMaxTokens = 1024;
+static constexpr size_t kMaxLayers = 8;
+static constexpr int kMaxLayerSize = 2048;
+
+// Frames queued (five seconds) and the frames per wake of the spotter
+// thread, which otherwise waits untimed; a pause leaves the last few queued
+// for the next wake
+static constexpr size_t kRingFrames = 512;
+static constexpr uint32_t kWakeFrames = 5;
+
+static WakeupCounter g_wakeups("keywordSpotter");
+
+// A keyword's tokens peak within this many frames of its first, and a
+// detection holds the keyword off for kRefractoryFrames
+static constexpr int64_t kWindowFrames = 200;
+static constexpr int64_t kRefractoryFrames = 100;
+
+// Geometric mean of the peaks a keyword needs unless given its own
+static constexpr float kDefaultThreshold = 0.5f;
+
+// Floor under a posterior before its log
+static constexpr float kMinPosterior = 1e-4f;
+
+// Frames further behind the clock than this are after a gap (a pause);
+// the stamps start again from the clock
+static constexpr double kResyncMs = 500.0;
+
+static constexpr double kFrameMs = 10.0;
+
+namespace {
+
+template <typename T>
+bool ReadValue(std::ifstream& in, T* value) {
+    in.read(reinterpret_cast<char*>(value), sizeof(T));
+    return static_cast<bool>(in);
+}
+
+} // namespace
+
+std::shared_ptr<const KeywordModel> KeywordModel::Load(const std::string& path, std::string* error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        *error = "cannot open " + path;
+        return nullptr;
+    }
+    char magic[4] = {};
+    uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, "KKKW", 4) != 0 || !ReadValue(in, &version) || version != kModelVersion) {
+        *error = path + " is not a version 1 keyword model";
+        return nullptr;
+    }
+
+    auto model = std::make_shared<KeywordModel>();
+    uint32_t bands = 0, left = 0, right = 0;
+    if (!ReadValue(in, &bands) || !ReadValue(in, &model->min_hz) || !ReadValue(in, &model->max_hz) ||
+        !ReadValue(in, &left) || !ReadValue(in, &right)) {
+        *error = "keyword model: header is truncated";
+        return nullptr;
+    }
+    if (bands < 1 || bands > static_cast<uint32_t>(KeywordSpotter::kMaxBands) || !(model->min_hz >= 0.0f) ||
+        !(model->max_hz > model->min_hz) || left > static_cast<uint32_t>(kMaxLeftContext) ||
+        right > static_cast<uint32_t>(kMaxRightContext)) {
+        *error = "keyword model: bands or context out of range";
+        return nullptr;
+    }
+    model->bands = static_cast<int>(bands);
+    model->left_context = static_cast<int>(left);
+    model->right_context = static_cast<int>(right);
+    model->mean.resize(bands);
+    model->inverse_deviation.resize(bands);
+    in.read(reinterpret_cast<char*>(model->mean.data()), bands * sizeof(float));
+    in.read(reinterpret_cast<char*>(model->inverse_deviation.data()), bands * sizeof(float));
+
+    uint32_t token_count = 0;
+    if (!in || !ReadValue(in, &token_count) || token_count < 2 || token_count > kMaxTokens) {
+        *error = "keyword model: token table is truncated or out of range";
+        return nullptr;
+    }
+    model->tokens.resize(token_count);
+    for (std::string& token : model->tokens) {
+        uint8_t length = 0;
+        if (!ReadValue(in, &length)) {
+            break;
+        }
+        token.resize(length);
+        in.read(&token[0], length);
+    }
+
+    uint32_t layer_count = 0;
+    if (!in || !ReadValue(in, &layer_count) || layer_count < 1 || layer_count > kMaxLayers) {
+        *error = "keyword model: layer table is truncated or out of range";
+        return nullptr;
+    }
+    int expected = model->InputSize();
+    model->layers.resize(layer_count);
+    for (uint32_t i = 0; i < layer_count; ++i) {
+        KeywordModel::Layer& layer = model->layers[i];
+        uint32_t sizes[2] = {0, 0};
+        float scale = 0.0f;
+        in.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+        const int outputs = i + 1 == layer_count ? static_cast<int>(token_count) : static_cast<int>(sizes[1]);
+        if (!in || static_cast<int>(sizes[0]) != expected || static_cast<int>(sizes[1]) != outputs ||
+            outputs < 1 || outputs > kMaxLayerSize || !ReadValue(in, &scale)) {
+            *error = "keyword model: layer " + std::to_string(i) + " is not " + std::to_string(expected) +
+                     " -> " + (i + 1 == layer_count ? std::to_string(token_count) : std::string("n"));
+            return nullptr;
+        }
+        layer.input_size = expected;
+        layer.output_size = outputs;
+        std::vector<int8_t> quantized(static_cast<size_t>(expected) * outputs);
+        in.read(reinterpret_cast<char*>(quantized.data()), static_cast<std::streamsize>(quantized.size()));
+        layer.bias.resize(outputs);
+        in.read(reinterpret_cast<char*>(layer.bias.data()), outputs * sizeof(float));
+        if (!in) {
+            *error = "keyword model: layer " + std::to_string(i) + " is truncated";
+            return nullptr;
+        }
+        layer.weights.resize(quantized.size());
+        for (size_t k = 0; k < quantized.size(); ++k) {
+            layer.weights[k] = scale * quantized[k];
+        }
+        expected = outputs;
+    }
+    return model;
+}
+
+KeywordSpotter::KeywordSpotter() : ring_(kRingFrames) {}
+
+KeywordSpotter::~KeywordSpotter() {
+    Stop();
+}
+
+// A token standing for the space between words, in the conventions CTC
+// vocabularies use for it
+bool KeywordSpotter::IsSeparator(const std::string& token) const {
+    return token == " " || token == "|" || token == "\xe2\x96\x81";
+}
+
+// Greedy longest match of the folded text against the tokens; spaces map to
+// the word separator when the model has one and are dropped otherwise
+bool KeywordSpotter::Tokenize(const std::string& text, std::vector<int>* tokens) const {
+    std::string folded;
+    for (char c : text) {
+        const unsigned char byte = static_cast<unsigned char>(c);
+        if (std::isspace(byte)) {
+            if (!folded.empty() && folded.back() != ' ') {
+                folded.push_back(' ');
+            }
+            continue;
+        }
+        folded.push_back(static_cast<char>(std::tolower(byte)));
+    }
+    while (!folded.empty() && folded.back() == ' ') {
+        folded.pop_back();
+    }
+
+    int separator = -1;
+    for (size_t t = 1; t < model_->tokens.size(); ++t) {
+        if (IsSeparator(model_->tokens[t])) {
+            separator = static_cast<int>(t);
+            break;
+        }
+    }
+    tokens->clear();
+    size_t position = 0;
+    while (position < folded.size()) {
+        if (folded[position] == ' ') {
+            if (separator >= 0) {
+                tokens->push_back(separator);
+            }
+            ++position;
+            continue;
+        }
+        int best = -1;
+        size_t best_length = 0;
+        for (size_t t = 1; t < model_->tokens.size(); ++t) {
+            const std::string& token = model_->tokens[t];
+            if (token.size() > best_length && !IsSeparator(token) &&
+                folded.compare(position, token.size(), token) == 0) {
+                best = static_cast<int>(t);
+                best_length = token.size();
+            }
+        }
+        if (best < 0) {
+            return false;
+        }
+        tokens->push_back(best);
+        position += best_length;
+    }
+    return true;
+}
+
+// One prefix tree for every keyword: a node's children come after it, so
+// the decoder can walk the nodes backwards reading last frame's parents
+bool KeywordSpotter::Compile(const std::vector<KeywordSpec>& keywords, std::string* error) {
+    if (keywords.empty() || keywords.size() > kMaxKeywords) {
+        *error = "1 to " + std::to_string(kMaxKeywords) + " keywords required";
+        return false;
+    }
+    nodes_.assign(1, Node());
+    texts_.clear();
+    thresholds_.clear();
+    std::vector<int> tokens;
+    for (size_t k = 0; k < keywords.size(); ++k) {
+        const KeywordSpec& keyword = keywords[k];
+        if (!Tokenize(keyword.text, &tokens)) {
+            *error = "Keyword '" + keyword.text + "' cannot be spelled in the model's tokens";
+            return false;
+        }
+        if (tokens.size() < 2) {
+            *error = "Keyword '" + keyword.text + "' is too short to spot";
+            return false;
+        }
+        int node = 0;
+        for (int token : tokens) {
+            int child = -1;
+            for (size_t n = static_cast<size_t>(node) + 1; n < nodes_.size(); ++n) {
+                if (nodes_[n].parent == node && nodes_[n].token == token) {
+                    child = static_cast<int>(n);
+                    break;
+                }
+            }
+            if (child < 0) {
+                Node added;
+                added.token = token;
+                added.parent = node;
+                added.depth = nodes_[node].depth + 1;
+                child = static_cast<int>(nodes_.size());
+                nodes_.push_back(added);
+            }
+            node = child;
+        }
+        if (nodes_[node].keyword >= 0) {
+            *error = "Keyword '" + keyword.text + "' repeats '" + texts_[nodes_[node].keyword] + "'";
+            return false;
+        }
+        nodes_[node].keyword = static_cast<int>(k);
+        texts_.push_back(keyword.text);
+        thresholds_.push_back(keyword.threshold > 0.0f ? std::min(keyword.threshold, 1.0f) : kDefaultThreshold);
+    }
+    return true;
+}
+
+bool KeywordSpotter::Start(std::shared_ptr<const KeywordModel> model, const std::vector<KeywordSpec>& keywords,
+                           const HostClock* clock, EventCallback callback, std::string* error) {
+    Stop();
+    if (!model) {
+        *error = "No keyword model";
+        return false;
+    }
+    model_ = std::move(model);
+    if (!Compile(keywords, error)) {
+        model_.reset();
+        return false;
+    }
+    clock_ = clock;
+    callback_ = std::move(callback);
+
+    const size_t context = static_cast<size_t>(model_->left_context + model_->right_context + 1);
+    history_.assign(context, Frame());
+    history_fill_ = 0;
+    input_.assign(static_cast<size_t>(model_->InputSize()), 0.0f);
+    size_t widest = 0;
+    for (const KeywordModel::Layer& layer : model_->layers) {
+        widest = std::max(widest, static_cast<size_t>(layer.output_size));
+    }
+    activations_[0].assign(widest, 0.0f);
+    activations_[1].assign(widest, 0.0f);
+    frame_ = 0;
+    quiet_until_.assign(texts_.size(), 0);
+    frame_times_.assign(static_cast<size_t>(kWindowFrames), 0.0);
+    weights_for_ = nullptr;
+    next_time_ms_ = 0.0;
+    queued_ = 0;
+    latency_sum_ms_ = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_ = KeywordSpotterStats();
+        stats_.running = true;
+        stats_.keywords = static_cast<uint32_t>(texts_.size());
+        stats_.graph_states = static_cast<uint32_t>(nodes_.size() - 1);
+    }
+    frames_dropped_.store(0, std::memory_order_relaxed);
+
+    // Discard what a previous run left unread
+    Frame discard;
+    while (ring_.Read(&discard, 1) > 0) {
+    }
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&KeywordSpotter::Loop, this);
+    Log(LogLevel::kInfo, kLogSource, "Keyword spotter started: %zu keywords in %zu states, %d bands, %zu tokens",
+        texts_.size(), nodes_.size() - 1, model_->bands, model_->tokens.size());
+    return true;
+}
+
+void KeywordSpotter::Stop() {
+    if (!running_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    wake_.Signal();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    callback_ = nullptr;
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.running = false;
+    Log(LogLevel::kInfo, kLogSource, "Keyword spotter stopped: %llu frames, %llu events",
+        static_cast<unsigned long long>(stats_.frames), static_cast<unsigned long long>(stats_.events));
+}
+
+KeywordSpotterStats KeywordSpotter::GetStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    KeywordSpotterStats stats = stats_;
+    stats.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// The model's mel triangles between its band edges, over the analyzer's
+// bins from DC to Nyquist
+void KeywordSpotter::BuildMelWeights(const SpectralAnalyzer& analyzer) {
+    mel_.Build(analyzer.SampleRate(), analyzer.Bins(), static_cast<size_t>(model_->bands), SpectrumScale::kMel,
+               model_->min_hz, model_->max_hz);
+    weights_for_ = &analyzer;
+}
+
+void KeywordSpotter::OnSpectrum(const SpectralAnalyzer& analyzer) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (weights_for_ != &analyzer || mel_.Bins() != analyzer.Bins()) {
+        BuildMelWeights(analyzer);
+    }
+    Frame frame;
+    const float* power = analyzer.PowerSpectrum();
+    for (int b = 0; b < model_->bands; ++b) {
+        frame.bands[b] = std::log(std::max(mel_.Energy(static_cast<size_t>(b), power), 1e-10f));
+    }
+
+    // The frames of one delivery arrive together; stamps advance 10ms a
+    // frame from the first one's arrival
+    const double now = clock_ ? clock_->ToDateNowMs(HostTimeNow()) : 0.0;
+    if (next_time_ms_ == 0.0 || now - next_time_ms_ > kResyncMs) {
+        next_time_ms_ = now;
+    }
+    frame.time_ms = next_time_ms_;
+    next_time_ms_ += kFrameMs;
+
+    if (!ring_.Write(&frame, 1)) {
+        frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (++queued_ >= kWakeFrames) {
+        queued_ = 0;
+        wake_.Signal();
+    }
+}
+
+void KeywordSpotter::Loop() {
+    ScopedThreadCpu thread_cpu("keywordSpotter");
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+    webrtc::DenormalDisabler denormals;
+    cpu_start_ns_ = CurrentThreadCpuNs();
+    while (running_.load(std::memory_order_acquire)) {
+        wake_.Wait();
+        g_wakeups.Count();
+        Drain();
+    }
+}
+
+// Each queued frame into the context window; the model runs on the frame
+// the window centres on once its right context is in
+void KeywordSpotter::Drain() {
+    Frame frame;
+    uint64_t frames = 0;
+    while (ring_.Read(&frame, 1) == 1) {
+        if (history_fill_ == history_.size()) {
+            std::move(history_.begin() + 1, history_.end(), history_.begin());
+            --history_fill_;
+        }
+        history_[history_fill_++] = frame;
+        if (history_fill_ < history_.size()) {
+            continue;
+        }
+        RunModel();
+        ++frames;
+    }
+    if (frames == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.frames += frames;
+    stats_.cpu_load = static_cast<float>(static_cast<double>(CurrentThreadCpuNs() - cpu_start_ns_) /
+                                         (static_cast<double>(stats_.frames) * kFrameMs * 1e6));
+}
+
+void KeywordSpotter::RunModel() {
+    const int bands = model_->bands;
+    float* input = input_.data();
+    for (size_t f = 0; f < history_.size(); ++f) {
+        for (int b = 0; b < bands; ++b) {
+            *input++ = (history_[f].bands[b] - model_->mean[b]) * model_->inverse_deviation[b];
+        }
+    }
+
+    const float* in = input_.data();
+    const size_t last = model_->layers.size() - 1;
+    for (size_t i = 0; i <= last; ++i) {
+        const KeywordModel::Layer& layer = model_->layers[i];
+        float* out = activations_[i % 2].data();
+        const size_t width = static_cast<size_t>(layer.input_size);
+        for (int j = 0; j < layer.output_size; ++j) {
+            const float value = layer.bias[j] + dsp::DotProduct(layer.weights.data() + j * width, in, width);
+            out[j] = i == last ? value : std::max(value, 0.0f);
+        }
+        in = out;
+    }
+
+    // Softmax in place over the tokens
+    float* posteriors = activations_[last % 2].data();
+    const int tokens = model_->layers[last].output_size;
+    const float top = *std::max_element(posteriors, posteriors + tokens);
+    float sum = 0.0f;
+    for (int t = 0; t < tokens; ++t) {
+        posteriors[t] = std::exp(posteriors[t] - top);
+        sum += posteriors[t];
+    }
+    for (int t = 0; t < tokens; ++t) {
+        posteriors[t] /= sum;
+    }
+    Decode(posteriors, history_[static_cast<size_t>(model_->left_context)].time_ms);
+}
+
+// Per node, the better of its own path and last frame's parent path with
+// this frame's posterior of the node's token as the next peak; paths older
+// than the window fall away. Blank is never a node, so a token's peak is
+// what counts, however many blank frames lie between.
+void KeywordSpotter::Decode(const float* posteriors, double time_ms) {
+    const int64_t frame = frame_++;
+    frame_times_[static_cast<size_t>(frame % kWindowFrames)] = time_ms;
+    for (size_t n = nodes_.size() - 1; n >= 1; --n) {
+        Node& node = nodes_[n];
+        const Node& parent = nodes_[node.parent];
+        float base = 0.0f;
+        int64_t start = frame;
+        if (node.parent > 0) {
+            if (parent.start < 0 || frame - parent.start >= kWindowFrames) {
+                base = -INFINITY;
+            } else {
+                base = parent.score;
+                start = parent.start;
+            }
+        }
+        if (node.start >= 0 && frame - node.start >= kWindowFrames) {
+            node.start = -1;
+        }
+        const float candidate = base + std::log(std::max(posteriors[node.token], kMinPosterior));
+        if (std::isfinite(candidate) && (node.start < 0 || candidate > node.score)) {
+            node.score = candidate;
+            node.start = start;
+            node.peak = frame;
+        }
+    }
+
+    for (size_t n = 1; n < nodes_.size(); ++n) {
+        Node& node = nodes_[n];
+        if (node.keyword < 0 || node.peak != frame || frame < quiet_until_[node.keyword]) {
+            continue;
+        }
+        const float confidence = std::exp(node.score / static_cast<float>(node.depth));
+        if (confidence < thresholds_[node.keyword]) {
+            continue;
+        }
+        KeywordEvent event;
+        event.keyword = static_cast<size_t>(node.keyword);
+        event.text = texts_[node.keyword];
+        event.confidence = confidence;
+        event.start_ms = frame_times_[static_cast<size_t>(node.start % kWindowFrames)];
+        event.end_ms = time_ms;
+        event.detected_ms = clock_ ? clock_->ToDateNowMs(HostTimeNow()) : time_ms;
+        quiet_until_[node.keyword] = frame + kRefractoryFrames;
+        node.start = -1;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            ++stats_.events;
+            latency_sum_ms_ += event.detected_ms - event.end_ms;
+            stats_.mean_latency_ms = static_cast<float>(latency_sum_ms_ / static_cast<double>(stats_.events));
+        }
+        Log(LogLevel::kDebug, kLogSource, "Keyword '%s' at %.2f, %.0f ms after its audio", event.text.c_str(),
+            event.confidence, event.detected_ms - event.end_ms);
+        if (callback_) {
+            callback_(event);
+        }
+    }
+}
+
+} // namespace kakarot
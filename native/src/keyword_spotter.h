@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "host_time.h"
+#include "platform_thread.h"
+#include "spectral_analyzer.h"
+#include "spsc_ring_buffer.h"
+
+namespace kakarot {
+
+// A small CTC acoustic model over log-mel frames: a stack of dense layers
+// on the frame and its context, ReLU between them, softmax over the tokens
+// (graphemes or word pieces, the first being CTC's blank) at the end.
+//
+// The file is "KKKW", a little-endian uint32 version (1), then uint32 mel
+// bands, float32 lowest and highest band edges in Hz, uint32 left and
+// right context frames, float32 mean and inverse deviation per band, a
+// uint32 token count with each token as a uint8 length and its UTF-8
+// bytes, and a uint32 layer count with each layer as uint32 input and
+// output sizes, float32 weight scale, int8 weights (output rows of input
+// columns) and float32 bias.
+struct KeywordModel {
+    struct Layer {
+        int input_size = 0;
+        int output_size = 0;
+        std::vector<float> weights;  // dequantized, row-major
+        std::vector<float> bias;
+    };
+    int bands = 0;
+    float min_hz = 0.0f;
+    float max_hz = 0.0f;
+    int left_context = 0;
+    int right_context = 0;
+    std::vector<float> mean;
+    std::vector<float> inverse_deviation;
+    std::vector<std::string> tokens;
+    std::vector<Layer> layers;
+
+    int InputSize() const { return bands * (left_context + right_context + 1); }
+
+    // Null with |error| set when the file is missing or malformed
+    static std::shared_ptr<const KeywordModel> Load(const std::string& path, std::string* error);
+};
+
+struct KeywordSpec {
+    std::string text;
+    float threshold = 0.0f;  // 0 = the spotter's default
+};
+
+// A detection; times are Date.now() milliseconds of the audio
+struct KeywordEvent {
+    size_t keyword = 0;  // index into the keywords started with
+    std::string text;
+    float confidence = 0.0f;
+    double start_ms = 0.0;     // the first token's peak
+    double end_ms = 0.0;       // the frame that completed it
+    double detected_ms = 0.0;  // when the event left the spotter
+};
+
+struct KeywordSpotterStats {
+    bool running = false;
+    uint32_t keywords = 0;
+    uint32_t graph_states = 0;
+    uint64_t frames = 0;          // through the model
+    uint64_t frames_dropped = 0;  // the feature ring was full
+    uint64_t events = 0;
+    float mean_latency_ms = 0.0f;  // detected_ms - end_ms over the events
+    float cpu_load = 0.0f;         // the spotter thread's CPU time over the audio time
+};
+
+// Keywords spotted on a stream as it plays, ahead of any transcript. It
+// listens to the stream's shared spectrum (no FFT of its own): each 10ms
+// power spectrum is folded into the model's mel bands on the consumer
+// thread and queued, and a utility-priority thread runs the model and the
+// decoder every kWakeFrames. Keywords are tokenized against the model's
+// tokens and compiled into one prefix tree, and the decoder keeps, per
+// node, the best product of ordered token peaks of a path into it within a
+// window of the last two seconds: a keyword fires when the geometric mean
+// of its tokens' peaks clears its threshold, at the frame that completed
+// it, and stays quiet for a second after. From audio to event: the
+// delivery interval, the model's right context and at most one wake.
+class KeywordSpotter : public SpectrumListener {
+public:
+    using EventCallback = std::function<void(const KeywordEvent& event)>;
+
+    static constexpr int kMaxBands = 64;
+    static constexpr size_t kMaxKeywords = 256;
+
+    KeywordSpotter();
+    ~KeywordSpotter() override;
+
+    KeywordSpotter(const KeywordSpotter&) = delete;
+    KeywordSpotter& operator=(const KeywordSpotter&) = delete;
+
+    // JS thread. Compiles |keywords| against |model|; |callback| runs on the
+    // spotter thread. False with |error| for a keyword the tokens cannot
+    // spell or a model outside the limits. Listening is the caller's:
+    // SpectrumMeter::AddListener() after, RemoveListener() before Stop().
+    bool Start(std::shared_ptr<const KeywordModel> model, const std::vector<KeywordSpec>& keywords,
+               const HostClock* clock, EventCallback callback, std::string* error);
+    void Stop();
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // Consumer thread
+    void OnSpectrum(const SpectralAnalyzer& analyzer) override;
+
+    // Any thread
+    KeywordSpotterStats GetStats() const;
+
+private:
+    struct Frame {
+        float bands[kMaxBands];
+        double time_ms;
+    };
+    struct Node {
+        int token = 0;
+        int parent = -1;    // -1 below the root
+        int depth = 0;      // tokens from the root
+        int keyword = -1;   // the keyword ending here, if any
+        float score = 0.0f; // best log product of peaks into it
+        int64_t start = -1; // frame of the path's first peak; -1 = no path
+        int64_t peak = -1;  // frame of this node's own peak
+    };
+
+    bool Compile(const std::vector<KeywordSpec>& keywords, std::string* error);
+    bool Tokenize(const std::string& text, std::vector<int>* tokens) const;
+    bool IsSeparator(const std::string& token) const;
+    void BuildMelWeights(const SpectralAnalyzer& analyzer);
+    void Loop();
+    void Drain();
+    void RunModel();
+    void Decode(const float* posteriors, double time_ms);
+
+    std::shared_ptr<const KeywordModel> model_;
+    const HostClock* clock_ = nullptr;
+    EventCallback callback_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> frames_dropped_{0};
+    Semaphore wake_;
+    std::thread thread_;
+    SpscRingBuffer<Frame> ring_;
+
+    // Consumer thread: the model's mel triangles over the analyzer's bins,
+    // rebuilt when another analyzer shows up
+    const SpectralAnalyzer* weights_for_ = nullptr;
+    Filterbank mel_;
+    double next_time_ms_ = 0.0;
+    uint32_t queued_ = 0;
+
+    // Spotter thread
+    std::vector<Frame> history_;      // the context window, oldest first
+    size_t history_fill_ = 0;
+    std::vector<float> input_;
+    std::vector<float> activations_[2];
+    int64_t frame_ = 0;
+    std::vector<Node> nodes_;         // nodes_[0] is the root
+    std::vector<int64_t> quiet_until_;  // per keyword
+    std::vector<double> frame_times_;   // ms by frame, modulo its size
+
+    std::vector<std::string> texts_;
+    std::vector<float> thresholds_;
+    mutable std::mutex stats_mutex_;
+    KeywordSpotterStats stats_;
+    double latency_sum_ms_ = 0.0;
+    uint64_t cpu_start_ns_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,523 @@
+#include "knowledge_ingest.h"
+#include "document_text.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "thread_cpu.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace kakarot {
+
+namespace fs = std::filesystem;
+
+static const char* const kLogSource = "KnowledgeIngest";
+static const char* const kManifestHeader = "kakarot-knowledge 1";
+
+// Extracted documents waiting for the ingester, per worker, before the
+// workers stop reading more
+static constexpr size_t kExtractedPerWorker = 4;
+
+namespace {
+
+uint64_t Fnv1a(const std::string& text) {
+    uint64_t hash = 1469598103934665603ull;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// A document's chunk ids all start with this; 17 bytes whatever the path
+std::string DocumentPrefix(const std::string& path) {
+    char prefix[20];
+    std::snprintf(prefix, sizeof(prefix), "%016" PRIx64 "#", Fnv1a(path));
+    return prefix;
+}
+
+bool IsContinuation(unsigned char c) { return (c & 0xc0) == 0x80; }
+
+// Collapses runs of spaces and tabs to one space and three or more line
+// breaks to a paragraph break; trims each line
+std::string NormalizeWhitespace(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    size_t newlines = 0;
+    bool space = false;
+    for (char c : text) {
+        if (c == '\r') {
+            continue;
+        }
+        if (c == '\n') {
+            ++newlines;
+            space = false;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\f' || c == '\v') {
+            space = true;
+            continue;
+        }
+        if (!out.empty()) {
+            if (newlines > 0) {
+                out.append(std::min<size_t>(newlines, 2), '\n');
+            } else if (space) {
+                out += ' ';
+            }
+        }
+        newlines = 0;
+        space = false;
+        out += c;
+    }
+    return out;
+}
+
+// The best place in (start, end] to end a chunk: a paragraph break, then a
+// sentence end, then a line break, then a space, in the chunk's second half
+size_t ChunkEnd(const std::string& text, size_t start, size_t end) {
+    const size_t floor = start + (end - start) / 2;
+    auto last = [&](const char* needle, size_t keep) -> size_t {
+        size_t at = text.rfind(needle, end - 1);
+        return at != std::string::npos && at >= floor ? at + keep : 0;
+    };
+    for (auto [needle, keep] : {std::pair<const char*, size_t>{"\n\n", 0}, {". ", 1}, {"? ", 1}, {"! ", 1},
+                                {"\n", 0}, {" ", 0}}) {
+        if (size_t at = last(needle, keep)) {
+            return at;
+        }
+    }
+    while (end > start + 1 && IsContinuation(static_cast<unsigned char>(text[end]))) {
+        --end;
+    }
+    return end;
+}
+
+} // namespace
+
+std::vector<std::string> ChunkText(const std::string& text, size_t chunk_bytes, size_t overlap_bytes) {
+    std::vector<std::string> chunks;
+    const std::string normalized = NormalizeWhitespace(text);
+    const size_t size = normalized.size();
+    chunk_bytes = std::max<size_t>(chunk_bytes, 64);
+    overlap_bytes = std::min(overlap_bytes, chunk_bytes / 2);
+    size_t start = 0;
+    while (start < size) {
+        size_t end = start + chunk_bytes >= size ? size : ChunkEnd(normalized, start, start + chunk_bytes);
+        size_t first = start;
+        size_t last = end;
+        while (first < last && (normalized[first] == ' ' || normalized[first] == '\n')) {
+            ++first;
+        }
+        while (last > first && (normalized[last - 1] == ' ' || normalized[last - 1] == '\n')) {
+            --last;
+        }
+        if (last > first) {
+            chunks.push_back(normalized.substr(first, last - first));
+        }
+        if (end >= size) {
+            break;
+        }
+        // Back by the overlap, then on to the next word so no chunk opens
+        // mid-word
+        size_t next = end > overlap_bytes ? end - overlap_bytes : 0;
+        if (next > start && overlap_bytes > 0) {
+            size_t space = normalized.find_first_of(" \n", next);
+            next = space != std::string::npos && space < end ? space + 1 : end;
+        } else {
+            next = end;
+        }
+        while (next < size && IsContinuation(static_cast<unsigned char>(normalized[next]))) {
+            ++next;
+        }
+        start = std::max(next, start + 1);
+    }
+    return chunks;
+}
+
+KnowledgeIngester::~KnowledgeIngester() {
+    Cancel();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool KnowledgeIngester::Start(const KnowledgeIngestOptions& options, KnowledgeIngestCallbacks callbacks,
+                              std::string* error) {
+    if (thread_.joinable()) {
+        *error = "Ingestion already started";
+        return false;
+    }
+    if (options.root.empty()) {
+        *error = "root is required";
+        return false;
+    }
+    options_ = options;
+    if (options_.threads == 0) {
+        size_t cores = std::thread::hardware_concurrency();
+        options_.threads = cores > 1 ? cores - 1 : 1;
+    }
+    options_.batch_chunks = std::max<size_t>(1, options_.batch_chunks);
+    options_.max_in_flight = std::max<size_t>(1, options_.max_in_flight);
+    callbacks_ = std::move(callbacks);
+    thread_ = std::thread(&KnowledgeIngester::Run, this);
+    return true;
+}
+
+void KnowledgeIngester::Ack(uint64_t batch, bool ok) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        acks_.emplace_back(batch, ok);
+    }
+    wake_.notify_all();
+}
+
+void KnowledgeIngester::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancel_.store(true, std::memory_order_relaxed);
+    }
+    wake_.notify_all();
+}
+
+void KnowledgeIngester::Run() {
+    ScopedThreadCpu thread_cpu("knowledgeIngest");
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+    const auto started = std::chrono::steady_clock::now();
+    std::error_code error;
+    if (!fs::is_directory(fs::u8path(options_.root), error)) {
+        stats_.error = "not a folder: " + options_.root;
+        callbacks_.done(stats_);
+        return;
+    }
+    LoadManifest();
+    Walk();
+
+    const size_t queued = work_.size();
+    for (size_t i = 0; i < std::min(options_.threads, queued); ++i) {
+        workers_.emplace_back(&KnowledgeIngester::Work, this);
+    }
+    KnowledgeBatch batch;
+    std::vector<size_t> batch_documents;
+    for (size_t handled = 0; handled < queued && !cancel_.load(std::memory_order_relaxed);) {
+        Extracted extracted;
+        bool have = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] {
+                return cancel_.load(std::memory_order_relaxed) || !extracted_.empty() || !acks_.empty();
+            });
+            if (!extracted_.empty()) {
+                extracted = std::move(extracted_.front());
+                extracted_.pop_front();
+                have = true;
+            }
+        }
+        wake_.notify_all();  // a worker may be waiting for room
+        TakeAcks();
+        if (have) {
+            ++handled;
+            Handle(std::move(extracted), &batch, &batch_documents);
+        }
+    }
+    if (!batch.chunks.empty()) {
+        Dispatch(&batch, &batch_documents);
+    }
+    for (;;) {
+        TakeAcks();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (cancel_.load(std::memory_order_relaxed) || (in_flight_.empty() && acks_.empty())) {
+            break;
+        }
+        wake_.wait(lock, [&] { return cancel_.load(std::memory_order_relaxed) || !acks_.empty(); });
+    }
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    // Whatever has not finished counts as failed; the manifest keeps it
+    // marked partial so the next run clears it first
+    for (Document& document : documents_) {
+        if (document.state == State::kPending) {
+            document.state = State::kFailed;
+            ++stats_.failed;
+        }
+    }
+    SaveManifest();
+    stats_.cancelled = cancel_.load(std::memory_order_relaxed);
+    stats_.elapsed_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    Log(LogLevel::kInfo, kLogSource, "%zu documents: %zu unchanged, %zu indexed, %zu removed, %zu failed in %.0fms",
+        stats_.documents, stats_.unchanged, stats_.indexed, stats_.removed, stats_.failed, stats_.elapsed_ms);
+    callbacks_.done(stats_);
+}
+
+// Only metadata: a document whose size and mtime match the manifest is not
+// opened. Hidden files and folders are skipped.
+void KnowledgeIngester::Walk() {
+    const fs::path root = fs::u8path(options_.root);
+    std::error_code error;
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, error);
+    for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+        if (cancel_.load(std::memory_order_relaxed)) {
+            break;
+        }
+        const fs::directory_entry& entry = *it;
+        std::error_code entry_error;
+        const std::string name = entry.path().filename().u8string();
+        if (!name.empty() && name[0] == '.') {
+            if (entry.is_directory(entry_error)) {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!entry.is_regular_file(entry_error) || !IsKnowledgeDocument(entry.path().u8string())) {
+            continue;
+        }
+        Document document;
+        document.path = entry.path().lexically_relative(root).generic_u8string();
+        if (document.path.find('\n') != std::string::npos) {
+            continue;  // would break the manifest's lines
+        }
+        document.full_path = entry.path().u8string();
+        document.entry.size = entry.file_size(entry_error);
+        document.entry.mtime = static_cast<int64_t>(entry.last_write_time(entry_error).time_since_epoch().count());
+        if (entry_error) {
+            continue;
+        }
+        ++stats_.documents;
+        // What is left in the manifest after the walk was not found
+        auto known = manifest_.find(document.path);
+        if (known != manifest_.end()) {
+            document.known = true;
+            document.previous = known->second;
+            manifest_.erase(known);
+            if (document.previous.complete && document.previous.size == document.entry.size &&
+                document.previous.mtime == document.entry.mtime) {
+                document.entry = document.previous;
+                document.state = State::kUnchanged;
+                ++stats_.unchanged;
+            }
+        }
+        if (document.state == State::kQueued) {
+            work_.push_back(documents_.size());
+        }
+        documents_.push_back(std::move(document));
+    }
+    if (error) {
+        // A partial walk must not read as deletions; the rest keep their entries
+        Log(LogLevel::kWarn, kLogSource, "walk of %s stopped: %s", options_.root.c_str(), error.message().c_str());
+        return;
+    }
+    for (auto it = manifest_.begin(); it != manifest_.end() && !cancel_.load(std::memory_order_relaxed);) {
+        callbacks_.remove(DocumentPrefix(it->first), it->first);
+        ++stats_.removed;
+        it = manifest_.erase(it);
+    }
+}
+
+void KnowledgeIngester::Work() {
+    ScopedThreadCpu thread_cpu("knowledgeExtract");
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+    const size_t room = options_.threads * kExtractedPerWorker;
+    for (;;) {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] {
+                return cancel_.load(std::memory_order_relaxed) || work_.empty() || extracted_.size() < room;
+            });
+            if (cancel_.load(std::memory_order_relaxed) || work_.empty()) {
+                return;
+            }
+            index = work_.front();
+            work_.pop_front();
+        }
+        // Only the paths are read here; the ingester owns the rest
+        Extracted extracted;
+        extracted.document = index;
+        std::string text;
+        std::string error;
+        if (ExtractDocumentText(documents_[index].full_path, &text, &error)) {
+            extracted.ok = true;
+            extracted.hash = Fnv1a(text);
+            extracted.chunks = ChunkText(text, options_.chunk_bytes, options_.overlap_bytes);
+        } else {
+            Log(LogLevel::kWarn, kLogSource, "%s", error.c_str());
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            extracted_.push_back(std::move(extracted));
+        }
+        wake_.notify_all();
+    }
+}
+
+void KnowledgeIngester::Handle(Extracted extracted, KnowledgeBatch* batch, std::vector<size_t>* batch_documents) {
+    const size_t index = extracted.document;
+    Document& document = documents_[index];
+    if (!extracted.ok) {
+        document.state = State::kFailed;
+        ++stats_.failed;
+        return;
+    }
+    document.entry.hash = extracted.hash;
+    // Touched, or saved without edits
+    if (document.known && document.previous.complete && document.previous.hash == extracted.hash) {
+        document.entry.complete = true;
+        document.state = State::kUnchanged;
+        ++stats_.unchanged;
+        return;
+    }
+    const std::string prefix = DocumentPrefix(document.path);
+    if (document.known) {
+        callbacks_.remove(prefix, document.path);
+    }
+    if (extracted.chunks.empty()) {
+        document.state = State::kIndexed;
+        ++stats_.indexed;
+        return;
+    }
+    document.state = State::kPending;
+    document.stored = true;
+    document.pending = extracted.chunks.size();
+    for (size_t i = 0; i < extracted.chunks.size(); ++i) {
+        batch->chunks.push_back(KnowledgeChunk{prefix + std::to_string(i), document.path, static_cast<uint32_t>(i),
+                                               std::move(extracted.chunks[i])});
+        batch_documents->push_back(index);
+        if (batch->chunks.size() >= options_.batch_chunks && !Dispatch(batch, batch_documents)) {
+            return;
+        }
+    }
+}
+
+bool KnowledgeIngester::Dispatch(KnowledgeBatch* batch, std::vector<size_t>* documents) {
+    for (;;) {
+        TakeAcks();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (cancel_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (in_flight_.size() < options_.max_in_flight) {
+            batch->id = next_batch_++;
+            in_flight_[batch->id] = std::move(*documents);
+            break;
+        }
+        wake_.wait(lock, [&] { return cancel_.load(std::memory_order_relaxed) || !acks_.empty(); });
+    }
+    ++stats_.batches;
+    stats_.chunks += batch->chunks.size();
+    callbacks_.batch(std::move(*batch));
+    *batch = KnowledgeBatch();
+    documents->clear();
+    return true;
+}
+
+void KnowledgeIngester::TakeAcks() {
+    std::vector<std::pair<std::vector<size_t>, bool>> settled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [batch, ok] : acks_) {
+            auto it = in_flight_.find(batch);
+            if (it != in_flight_.end()) {
+                settled.emplace_back(std::move(it->second), ok);
+                in_flight_.erase(it);
+            }
+        }
+        acks_.clear();
+    }
+    for (const auto& [indexes, ok] : settled) {
+        for (size_t index : indexes) {
+            Document& document = documents_[index];
+            document.failed = document.failed || !ok;
+            if (--document.pending > 0 || document.state != State::kPending) {
+                continue;
+            }
+            if (document.failed) {
+                document.state = State::kFailed;
+                ++stats_.failed;
+            } else {
+                document.entry.complete = true;
+                document.state = State::kIndexed;
+                ++stats_.indexed;
+            }
+        }
+    }
+}
+
+// One line per document: size, mtime, text hash, whether its chunks are
+// all stored, path
+void KnowledgeIngester::LoadManifest() {
+    if (options_.manifest.empty()) {
+        return;
+    }
+    std::ifstream in(fs::u8path(options_.manifest));
+    std::string line;
+    if (!in || !std::getline(in, line) || line != kManifestHeader) {
+        return;  // missing, or another version: everything is new
+    }
+    while (std::getline(in, line)) {
+        Entry entry;
+        unsigned long long size = 0;
+        long long mtime = 0;
+        unsigned long long hash = 0;
+        int complete = 0;
+        int consumed = 0;
+        if (std::sscanf(line.c_str(), "%llu\t%lld\t%llx\t%d\t%n", &size, &mtime, &hash, &complete, &consumed) < 4 ||
+            consumed == 0) {
+            continue;
+        }
+        entry.size = size;
+        entry.mtime = mtime;
+        entry.hash = hash;
+        entry.complete = complete != 0;
+        manifest_[line.substr(static_cast<size_t>(consumed))] = entry;
+    }
+}
+
+// To a temporary first, so a crash leaves the previous manifest
+void KnowledgeIngester::SaveManifest() const {
+    if (options_.manifest.empty()) {
+        return;
+    }
+    const fs::path path = fs::u8path(options_.manifest);
+    fs::path temporary = path;
+    temporary += ".tmp";
+    auto write = [](std::ofstream& out, const std::string& path, const Entry& entry) {
+        char fields[96];
+        std::snprintf(fields, sizeof(fields), "%llu\t%lld\t%llx\t%d\t", static_cast<unsigned long long>(entry.size),
+                      static_cast<long long>(entry.mtime), static_cast<unsigned long long>(entry.hash),
+                      entry.complete ? 1 : 0);
+        out << fields << path << '\n';
+    };
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << kManifestHeader << '\n';
+        for (const Document& document : documents_) {
+            bool complete = document.state == State::kUnchanged || document.state == State::kIndexed;
+            if (!complete && !document.stored && !document.known) {
+                continue;  // nothing of it was stored; the next run finds it new
+            }
+            Entry entry = document.entry;
+            entry.complete = complete;
+            write(out, document.path, entry);
+        }
+        // Not reached by a walk that stopped early
+        for (const auto& [path, entry] : manifest_) {
+            write(out, path, entry);
+        }
+        if (!out.flush()) {
+            Log(LogLevel::kWarn, kLogSource, "cannot write %s", temporary.u8string().c_str());
+            return;
+        }
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    if (error) {
+        Log(LogLevel::kWarn, kLogSource, "cannot replace %s: %s", options_.manifest.c_str(), error.message().c_str());
+    }
+}
+
+} // namespace kakarot
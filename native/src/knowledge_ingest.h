@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace kakarot {
+
+struct KnowledgeChunk {
+    std::string id;     // <document prefix><n>
+    std::string path;   // relative to the root, '/'-separated
+    uint32_t index = 0;
+    std::string text;
+};
+
+struct KnowledgeBatch {
+    uint64_t id = 0;
+    std::vector<KnowledgeChunk> chunks;
+};
+
+struct KnowledgeIngestOptions {
+    std::string root;
+    // The last run's documents, by size, mtime and text hash; rewritten at
+    // the end of each run
+    std::string manifest;
+    size_t threads = 0;           // extraction workers; 0 for every core but one
+    size_t chunk_bytes = 1500;    // a chunk ends at a paragraph, sentence or word
+    size_t overlap_bytes = 200;   // carried into the next chunk
+    size_t batch_chunks = 64;
+    size_t max_in_flight = 4;     // batches handed off and not yet acknowledged
+};
+
+struct KnowledgeIngestStats {
+    size_t documents = 0;   // found under the root
+    size_t unchanged = 0;   // same size and mtime, or the same text
+    size_t indexed = 0;     // every chunk acknowledged
+    size_t removed = 0;     // gone since the last run
+    size_t failed = 0;      // unreadable, or a batch of theirs failed; retried next run
+    size_t chunks = 0;
+    size_t batches = 0;
+    double elapsed_ms = 0.0;
+    bool cancelled = false;
+    std::string error;      // set when the run could not start (no root)
+};
+
+// All three on the ingester's own thread, in order
+struct KnowledgeIngestCallbacks {
+    // Drop the chunks of a document that changed or went away, before any
+    // of its new ones arrive
+    std::function<void(const std::string& prefix, const std::string& path)> remove;
+    // Chunks to embed and store; Ack() each batch when that is done
+    std::function<void(KnowledgeBatch batch)> batch;
+    std::function<void(const KnowledgeIngestStats& stats)> done;
+};
+
+// Brings an embedding store in line with a knowledge-base folder. The walk
+// compares each document's size and mtime with the manifest, so an
+// unchanged folder costs one stat per file. The rest are extracted and
+// chunked on a pool of workers; their chunks go out in batches, at most
+// |max_in_flight| unacknowledged at a time, so embedding requests stay
+// bounded however large the folder. A document is recorded in the manifest
+// only once every one of its batches is acknowledged.
+class KnowledgeIngester {
+public:
+    KnowledgeIngester() = default;
+    // Cancels and waits for the run
+    ~KnowledgeIngester();
+
+    KnowledgeIngester(const KnowledgeIngester&) = delete;
+    KnowledgeIngester& operator=(const KnowledgeIngester&) = delete;
+
+    // One run per ingester; |done| is always called once it started
+    bool Start(const KnowledgeIngestOptions& options, KnowledgeIngestCallbacks callbacks, std::string* error);
+    // Any thread. A failed batch fails its documents, which the next run
+    // retries.
+    void Ack(uint64_t batch, bool ok);
+    // Any thread. Stops handing out batches and ends the run without
+    // waiting for the ones outstanding.
+    void Cancel();
+
+private:
+    struct Entry {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        uint64_t hash = 0;
+        bool complete = false;  // else its chunks may be partly stored
+    };
+
+    enum class State { kQueued, kUnchanged, kPending, kIndexed, kFailed };
+
+    struct Document {
+        std::string path;       // relative
+        std::string full_path;
+        Entry entry;            // as found; the hash once extracted
+        bool known = false;     // in the manifest as |previous|
+        Entry previous;
+        State state = State::kQueued;
+        bool stored = false;    // some of its chunks may be in the store
+        size_t pending = 0;     // chunks handed off, not yet acknowledged
+        bool failed = false;    // a batch of its failed
+    };
+
+    struct Extracted {
+        size_t document = 0;
+        bool ok = false;
+        uint64_t hash = 0;
+        std::vector<std::string> chunks;
+    };
+
+    void Run();
+    void Walk();
+    void Work();
+    void Handle(Extracted extracted, KnowledgeBatch* batch, std::vector<size_t>* batch_documents);
+    // Blocks while |max_in_flight| batches are out; false once cancelled
+    bool Dispatch(KnowledgeBatch* batch, std::vector<size_t>* documents);
+    // Applies the acknowledgements that came in
+    void TakeAcks();
+    void LoadManifest();
+    void SaveManifest() const;
+
+    KnowledgeIngestOptions options_;
+    KnowledgeIngestCallbacks callbacks_;
+    std::thread thread_;
+    std::vector<std::thread> workers_;
+    std::atomic<bool> cancel_{false};
+
+    std::unordered_map<std::string, Entry> manifest_;
+    std::vector<Document> documents_;
+    KnowledgeIngestStats stats_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<size_t> work_;          // documents to extract
+    std::deque<Extracted> extracted_;
+    std::unordered_map<uint64_t, std::vector<size_t>> in_flight_;  // batch -> its chunks' documents
+    std::vector<std::pair<uint64_t, bool>> acks_;
+    uint64_t next_batch_ = 1;
+};
+
+// |text| with whitespace runs collapsed and cut into chunks of about
+// |chunk_bytes|, each overlapping the previous one by about |overlap_bytes|.
+// Never splits a UTF-8 sequence.
+std::vector<std::string> ChunkText(const std::string& text, size_t chunk_bytes, size_t overlap_bytes);
+
+} // namespace kakarot
@@ -0,0 +1,58 @@
+#include "latency_histogram.h"
+
+namespace kakarot {
+
+uint64_t LatencyHistogram::BucketMidpoint(size_t index) {
+    constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+    if (index < kSubBuckets) {
+        return index;
+    }
+    int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+    uint64_t low = static_cast<uint64_t>(kSubBuckets + (index & (kSubBuckets - 1))) << shift;
+    return low + ((uint64_t{1} << shift) >> 1);
+}
+
+LatencySummary LatencyHistogram::Summarize() const {
+    // One pass to copy, so the count and the ranks agree
+    uint32_t counts[kBuckets];
+    LatencySummary summary;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    summary.max = max_.load(std::memory_order_relaxed);
+    if (summary.count == 0) {
+        return summary;
+    }
+
+    // Nearest-rank: the smallest value at or above |fraction| of the samples
+    struct Target {
+        double fraction;
+        uint64_t* out;
+    } targets[] = {
+        { 0.50, &summary.p50 },
+        { 0.95, &summary.p95 },
+        { 0.99, &summary.p99 },
+    };
+    size_t next = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets && next < 3; ++i) {
+        seen += counts[i];
+        while (next < 3 && seen >= static_cast<uint64_t>(targets[next].fraction * summary.count + 0.999999)) {
+            // The max is exact; a midpoint above it would overstate the tail
+            uint64_t mid = BucketMidpoint(i);
+            *targets[next].out = mid < summary.max ? mid : summary.max;
+            ++next;
+        }
+    }
+    return summary;
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    max_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace kakarot
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace kakarot {
+
+// Snapshot of a LatencyHistogram, in the recorded unit
+struct LatencySummary {
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p95 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;  // exact
+};
+
+// Log-linear histogram of durations (HdrHistogram-style): values below 16
+// get a bucket each, and every power of two above splits into 16 linear
+// sub-buckets, so a percentile is within ~3% of the true value. Values clamp
+// at 2^36 (~69s in ns). One writer records with relaxed atomics - no locks,
+// no allocation - while any thread summarizes.
+class LatencyHistogram {
+public:
+    LatencyHistogram() { Reset(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // Writer thread only
+    void Record(uint64_t value) {
+        buckets_[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // Any thread. Percentiles are bucket midpoints.
+    LatencySummary Summarize() const;
+
+    // Call only while the writer is idle
+    void Reset();
+
+private:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kMaxValueBits = 36;
+    static constexpr size_t kBuckets = static_cast<size_t>(kMaxValueBits - kSubBucketBits + 1) << kSubBucketBits;
+
+    static size_t BucketFor(uint64_t value) {
+        constexpr uint64_t kLargest = (uint64_t{1} << kMaxValueBits) - 1;
+        value = value < kLargest ? value : kLargest;
+        if (value < (uint64_t{1} << kSubBucketBits)) {
+            return static_cast<size_t>(value);
+        }
+        int bits = 63 - __builtin_clzll(value);  // >= kSubBucketBits
+        int shift = bits - kSubBucketBits;
+        size_t sub = static_cast<size_t>(value >> shift) & ((size_t{1} << kSubBucketBits) - 1);
+        return (static_cast<size_t>(shift + 1) << kSubBucketBits) + sub;
+    }
+
+    static uint64_t BucketMidpoint(size_t index);
+
+    std::atomic<uint32_t> buckets_[kBuckets];
+    std::atomic<uint64_t> max_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,84 @@
+#include "latency_probe.h"
+#include "modules/audio_processing/utility/pffft_wrapper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+static constexpr double kFadeMs = 10.0;
+
+// A chirp's compressed peak stands well clear of its sidelobes and of
+// uncorrelated room noise; below this the match is a guess
+static constexpr float kMinClarity = 8.0f;
+
+std::vector<float> LatencyProbe::Generate(double sample_rate) {
+    const size_t length = static_cast<size_t>(kDurationMs * sample_rate / 1000.0);
+    const size_t fade = static_cast<size_t>(kFadeMs * sample_rate / 1000.0);
+    const double duration = kDurationMs / 1000.0;
+    const double sweep = (kEndHz - kStartHz) / duration;
+    std::vector<float> probe(length);
+    for (size_t i = 0; i < length; ++i) {
+        double t = i / sample_rate;
+        double phase = 2.0 * M_PI * (kStartHz * t + 0.5 * sweep * t * t);
+        float gain = kAmplitude;
+        size_t edge = std::min(i, length - 1 - i);
+        if (edge < fade) {
+            gain *= 0.5f * (1.0f - static_cast<float>(std::cos(M_PI * edge / fade)));
+        }
+        probe[i] = gain * static_cast<float>(std::sin(phase));
+    }
+    return probe;
+}
+
+bool LatencyProbe::Locate(const float* capture, size_t num_samples, double sample_rate, Match* match) {
+    std::vector<float> probe = Generate(sample_rate);
+    const size_t length = probe.size();
+    if (length == 0 || num_samples < length) {
+        return false;
+    }
+
+    // Linear (not circular) correlation: capture convolved with the reversed
+    // probe, zero-padded to a power of two
+    size_t fft_size = 32;
+    while (fft_size < num_samples + length - 1) {
+        fft_size *= 2;
+    }
+    webrtc::Pffft fft(fft_size, webrtc::Pffft::FftType::kReal);
+    auto time = fft.CreateBuffer();
+    auto capture_spectrum = fft.CreateBuffer();
+    auto probe_spectrum = fft.CreateBuffer();
+    auto product = fft.CreateBuffer();
+
+    float* data = time->GetView().data();
+    std::memset(data, 0, fft_size * sizeof(float));
+    std::memcpy(data, capture, num_samples * sizeof(float));
+    fft.ForwardTransform(*time, capture_spectrum.get(), false);
+
+    std::memset(data, 0, fft_size * sizeof(float));
+    std::reverse_copy(probe.begin(), probe.end(), data);
+    fft.ForwardTransform(*time, probe_spectrum.get(), false);
+
+    std::memset(product->GetView().data(), 0, fft_size * sizeof(float));
+    fft.FrequencyDomainConvolve(*capture_spectrum, *probe_spectrum, product.get(), 1.0f / fft_size);
+    fft.BackwardTransform(*product, time.get(), false);
+
+    // Element length - 1 + d is the correlation at lag d
+    const float* correlation = time->GetConstView().data() + (length - 1);
+    const size_t lags = num_samples - length + 1;
+    size_t best = 0;
+    double sum = 0.0;
+    for (size_t d = 0; d < lags; ++d) {
+        float magnitude = std::fabs(correlation[d]);
+        sum += magnitude;
+        if (magnitude > std::fabs(correlation[best])) {
+            best = d;
+        }
+    }
+    float mean = static_cast<float>(sum / lags);
+    match->offset = best;
+    match->clarity = mean > 0.0f ? std::fabs(correlation[best]) / mean : 0.0f;
+    return match->clarity >= kMinClarity;
+}
+
+} // namespace kakarot
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace kakarot {
+
+// A short, quiet linear chirp and its matched filter, for measuring the
+// acoustic round trip from the speaker to the microphone. The same analytic
+// sweep is generated at the playback and the capture rate, so the two sides
+// need not share one. Not the vendored SinusoidalLinearChirpSource: that is
+// a resampler test source, and only its header ships with the build.
+class LatencyProbe {
+public:
+    static constexpr double kDurationMs = 250.0;
+    static constexpr double kStartHz = 1000.0;
+    static constexpr double kEndHz = 6000.0;
+    static constexpr float kAmplitude = 0.05f;   // about -26 dBFS
+
+    // The probe at |sample_rate|, faded in and out over 10ms
+    static std::vector<float> Generate(double sample_rate);
+
+    struct Match {
+        size_t offset = 0;       // samples from the recording's start to the probe's
+        float clarity = 0.0f;    // correlation peak over its mean magnitude
+    };
+
+    // Finds the probe in |num_samples| of mono capture at |sample_rate|.
+    // Returns false when the recording is shorter than the probe or the best
+    // peak does not stand out (no echo path, e.g. headphones).
+    static bool Locate(const float* capture, size_t num_samples, double sample_rate, Match* match);
+};
+
+} // namespace kakarot
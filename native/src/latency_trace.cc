@@ -0,0 +1,33 @@
+#include "latency_trace.h"
+
+namespace kakarot {
+
+void LatencyTrace::Hold(uint64_t key, uint64_t capture_host, uint64_t js_host) {
+    pending_[next_pending_] = Pending{key, capture_host, js_host, true};
+    next_pending_ = (next_pending_ + 1) % kMaxPending;
+}
+
+bool LatencyTrace::Take(uint64_t key, Pending* out) {
+    // Newest first: the trace being closed is almost always the last one held
+    for (size_t n = 1; n <= kMaxPending; ++n) {
+        Pending& entry = pending_[(next_pending_ + kMaxPending - n) % kMaxPending];
+        if (entry.used && entry.key == key) {
+            *out = entry;
+            entry.used = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+void LatencyTrace::Reset() {
+    for (auto& histogram : histograms_) {
+        histogram.Reset();
+    }
+    for (auto& entry : pending_) {
+        entry = Pending();
+    }
+    next_pending_ = 0;
+}
+
+} // namespace kakarot
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "latency_histogram.h"
+
+namespace kakarot {
+
+// Stages of one delivery on its way from the HAL to the transcription
+// socket. Each is timed from the newest sample the delivery carries:
+//   capture->enqueue   HAL timestamp of a buffer's last sample to its ring
+//                      write (the IOProc, or the AEC pipeline for processed
+//                      streams)
+//   enqueue->dsp       ring write of the newest buffer to the delivery being
+//                      ready (batching, resampling, VAD, levels)
+//   dsp->dispatch      TSFN queue and event-loop wait
+//   dispatch->js       marshalling until the JS callback is entered
+//   js->sent           JS callback entry to the caller closing the trace
+//   total              HAL timestamp to sent
+enum class TraceStage { kCaptureToEnqueue, kEnqueueToDsp, kDspToDispatch, kDispatchToJs, kJsToSent, kTotal };
+static constexpr size_t kTraceStages = 6;
+
+// Per-stream latency distributions (ns) plus the deliveries whose trace JS
+// has yet to close. The first two stages are recorded on the consumer
+// thread, everything else on the JS thread, so each histogram keeps a single
+// writer. Summaries may be read from any thread.
+class LatencyTrace {
+public:
+    // A delivery that reached JS and is waiting for its trace to be closed
+    struct Pending {
+        uint64_t key = 0;           // the delivery's sample index
+        uint64_t capture_host = 0;  // host time of its newest sample
+        uint64_t js_host = 0;       // JS callback entry
+        bool used = false;
+    };
+
+    void Record(TraceStage stage, uint64_t ns) { histograms_[static_cast<size_t>(stage)].Record(ns); }
+    LatencySummary Summarize(TraceStage stage) const { return histograms_[static_cast<size_t>(stage)].Summarize(); }
+
+    // JS thread. Keeps the newest kMaxPending deliveries; an older one that was
+    // never closed is overwritten.
+    void Hold(uint64_t key, uint64_t capture_host, uint64_t js_host);
+
+    // JS thread. Removes the held delivery with |key|; false if there is none
+    // (already closed, overwritten, or never traced).
+    bool Take(uint64_t key, Pending* out);
+
+    // Call only while the consumer is stopped
+    void Reset();
+
+private:
+    static constexpr size_t kMaxPending = 64;
+
+    LatencyHistogram histograms_[kTraceStages];
+    Pending pending_[kMaxPending];
+    size_t next_pending_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,67 @@
+#include "level_analyzer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+LevelAnalyzer::LevelAnalyzer(size_t frame_size) : LevelAnalyzer(frame_size, Config()) {}
+
+LevelAnalyzer::LevelAnalyzer(size_t frame_size, const Config& config)
+    : config_(config),
+      frame_size_(frame_size),
+      kernels_(dsp::FrameKernelsFor(frame_size)),
+      frame_(frame_size),
+      noise_floor_(config.initial_noise_floor) {}
+
+LevelFrame LevelAnalyzer::AnalyzeFrame(const float* frame) {
+    float sum = 0.0f;
+    float peak = 0.0f;
+    kernels_.sum_squares_and_peak(frame, frame_size_, &sum, &peak);
+
+    LevelFrame result;
+    result.rms = std::sqrt(sum / frame_size_);
+    result.peak = peak;
+    float threshold = std::max(config_.min_threshold, noise_floor_ * config_.noise_multiplier);
+    result.speech = result.rms > threshold;
+    if (!result.speech) {
+        noise_floor_ += config_.noise_alpha * (result.rms - noise_floor_);
+    }
+    result.noise_floor = noise_floor_;
+    last_ = result;
+    return result;
+}
+
+size_t LevelAnalyzer::Process(const float* data, size_t num_samples, std::vector<float>* packed) {
+    size_t frames = 0;
+    size_t offset = 0;
+    while (offset < num_samples) {
+        // Whole frames straight from |data|; only a straddling frame is copied
+        const float* frame = data + offset;
+        if (fill_ == 0 && num_samples - offset >= frame_size_) {
+            offset += frame_size_;
+        } else {
+            size_t count = std::min(frame_size_ - fill_, num_samples - offset);
+            memcpy(frame_.data() + fill_, data + offset, count * sizeof(float));
+            fill_ += count;
+            offset += count;
+            if (fill_ < frame_size_) {
+                break;
+            }
+            fill_ = 0;
+            frame = frame_.data();
+        }
+
+        LevelFrame result = AnalyzeFrame(frame);
+        if (packed) {
+            packed->push_back(result.rms);
+            packed->push_back(result.peak);
+            packed->push_back(result.noise_floor);
+            packed->push_back(result.speech ? 1.0f : 0.0f);
+        }
+        ++frames;
+    }
+    return frames;
+}
+
+} // namespace kakarot
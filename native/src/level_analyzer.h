@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "frame_kernels.h"
+
+namespace kakarot {
+
+// Levels of one frame. Packed for JS as kLevelFields floats per frame:
+// rms, peak, noise floor, speech (1) / silence (0).
+struct LevelFrame {
+    float rms = 0.0f;
+    float peak = 0.0f;
+    float noise_floor = 0.0f;
+    bool speech = false;
+};
+
+static constexpr size_t kLevelFields = 4;
+
+// Streaming RMS / peak with an adaptive noise floor. A frame is speech when
+// its RMS exceeds max(min_threshold, noise_floor * noise_multiplier); the
+// floor follows silent frames with an EMA. Buffers arbitrary chunk sizes
+// into frames; a partial frame carries over. One instance per stream.
+class LevelAnalyzer {
+public:
+    struct Config {
+        float initial_noise_floor = 0.01f;
+        float noise_alpha = 0.05f;       // EMA weight of each silent frame
+        float min_threshold = 0.012f;
+        float noise_multiplier = 2.5f;
+    };
+
+    explicit LevelAnalyzer(size_t frame_size);
+    LevelAnalyzer(size_t frame_size, const Config& config);
+
+    // One RMS/peak pass over exactly FrameSize() samples
+    LevelFrame AnalyzeFrame(const float* frame);
+
+    // Analyzes |num_samples| and appends kLevelFields values per completed
+    // frame to |packed| (may be null). Returns the number of frames completed.
+    size_t Process(const float* data, size_t num_samples, std::vector<float>* packed);
+
+    // Frames |num_samples| can complete, counting the carried-over partial frame
+    size_t FramesFor(size_t num_samples) const { return (fill_ + num_samples) / frame_size_; }
+
+    size_t FrameSize() const { return frame_size_; }
+    const LevelFrame& Last() const { return last_; }
+
+    // Starts the floor from a known level (a stored noise profile's) rather
+    // than initial_noise_floor
+    void SetNoiseFloor(float noise_floor) { noise_floor_ = noise_floor; }
+
+private:
+    const Config config_;
+    const size_t frame_size_;
+    const dsp::FrameKernels kernels_;
+    std::vector<float> frame_;
+    size_t fill_ = 0;
+    float noise_floor_;
+    LevelFrame last_;
+};
+
+} // namespace kakarot
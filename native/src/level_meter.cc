@@ -0,0 +1,209 @@
+#include "level_meter.h"
+#include "dsp_kernels.h"
+#include "host_time.h"
+#include "platform_thread.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace kakarot {
+
+static constexpr double kMinMeterRateHz = 1.0;
+static constexpr double kMaxMeterRateHz = 120.0;
+
+static WakeupCounter g_wakeups("levelMeter");
+
+void LevelMeter::SetEnabled(bool enabled, IdleSignal* wake) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_.store(enabled, std::memory_order_relaxed);
+    wake_ = enabled ? wake : nullptr;
+    sum_squares_ = 0.0;
+    peak_ = 0.0f;
+    count_ = 0;
+}
+
+void LevelMeter::Add(const float* data, size_t num_samples) {
+    if (!Enabled() || num_samples == 0) {
+        return;
+    }
+    float sum_squares = 0.0f;
+    float peak = 0.0f;
+    dsp::SumSquaresAndPeak(data, num_samples, &sum_squares, &peak);
+    std::lock_guard<std::mutex> lock(mutex_);
+    sum_squares_ += sum_squares;
+    peak_ = std::max(peak_, peak);
+    count_ += num_samples;
+    // Under the lock, so SetEnabled(false) leaves no Add() holding |wake_|
+    if (wake_) {
+        wake_->Notify();
+    }
+}
+
+bool LevelMeter::Take(float* rms, float* peak) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ == 0) {
+        return false;
+    }
+    *rms = static_cast<float>(std::sqrt(sum_squares_ / static_cast<double>(count_)));
+    *peak = peak_;
+    sum_squares_ = 0.0;
+    peak_ = 0.0f;
+    count_ = 0;
+    return true;
+}
+
+bool LevelMeter::Pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_ > 0;
+}
+
+bool ParseSpectrumOptions(const Napi::Value& value, SpectrumOptions* options) {
+    *options = SpectrumOptions();
+    if (value.IsBoolean()) {
+        return value.As<Napi::Boolean>().Value();
+    }
+    if (!value.IsObject()) {
+        return false;
+    }
+    Napi::Object object = value.As<Napi::Object>();
+    if (object.Has("bands") && object.Get("bands").IsNumber()) {
+        double bands = object.Get("bands").As<Napi::Number>().DoubleValue();
+        options->bands = static_cast<int>(std::clamp(bands, 1.0, static_cast<double>(SpectralAnalyzer::kMaxBands)));
+    }
+    if (object.Has("scale") && object.Get("scale").IsString()) {
+        options->scale = object.Get("scale").As<Napi::String>().Utf8Value() == "linear" ? SpectrumScale::kLinear
+                                                                                         : SpectrumScale::kMel;
+    }
+    if (object.Has("minHz") && object.Get("minHz").IsNumber()) {
+        options->min_hz = std::max(0.0f, object.Get("minHz").As<Napi::Number>().FloatValue());
+    }
+    if (object.Has("maxHz") && object.Get("maxHz").IsNumber()) {
+        options->max_hz = std::max(options->min_hz + 1.0f, object.Get("maxHz").As<Napi::Number>().FloatValue());
+    }
+    return true;
+}
+
+namespace {
+
+// One tick, built on the meter thread
+struct MeterReading {
+    double time = 0.0;
+    std::vector<const char*> names;
+    std::vector<float> rms;
+    std::vector<float> peak;
+    std::vector<std::vector<float>> bands;  // per name, with the spectrum option
+};
+
+} // namespace
+
+void LevelMeterPublisher::Start(Napi::Env env, Napi::Function callback, double rate_hz, const HostClock* clock,
+                                std::vector<Source> sources, const SpectrumOptions* spectrum) {
+    Stop();
+    sources_ = std::move(sources);
+    clock_ = clock;
+    spectrum_ = spectrum != nullptr;
+    tsfn_ = Napi::ThreadSafeFunction::New(env, callback, "LevelMeter", 0, 1);
+    tsfn_.Unref(env);
+    for (const Source& source : sources_) {
+        source.meter->SetEnabled(true, &wake_);
+        if (spectrum_ && source.spectrum) {
+            source.spectrum->SetEnabled(true, *spectrum);
+        }
+    }
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&LevelMeterPublisher::Loop, this, std::clamp(rate_hz, kMinMeterRateHz, kMaxMeterRateHz));
+}
+
+void LevelMeterPublisher::Stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    running_.store(false, std::memory_order_release);
+    wake_.Signal();
+    thread_.join();
+    for (const Source& source : sources_) {
+        source.meter->SetEnabled(false);
+        if (spectrum_ && source.spectrum) {
+            source.spectrum->SetEnabled(false);
+        }
+    }
+    tsfn_.Release();
+    tsfn_ = Napi::ThreadSafeFunction();
+}
+
+void LevelMeterPublisher::Loop(double rate_hz) {
+    ScopedThreadCpu thread_cpu("levelMeter");
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / rate_hz));
+    auto next = std::chrono::steady_clock::now() + period;
+    bool reported_silence = false;
+    auto idle = [&] {
+        return reported_silence && std::none_of(sources_.begin(), sources_.end(),
+                                                [](const Source& source) { return source.meter->Pending(); });
+    };
+    while (running_.load(std::memory_order_acquire)) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now < next) {
+            wake_.Wait(std::chrono::duration_cast<std::chrono::nanoseconds>(next - now).count(), idle);
+            g_wakeups.Count();
+            continue;
+        }
+        // A late tick does not try to catch up
+        next = std::max(next + period, now);
+
+        MeterReading* reading = new MeterReading();
+        for (const Source& source : sources_) {
+            float rms = 0.0f;
+            float peak = 0.0f;
+            if (source.meter->Take(&rms, &peak)) {
+                reading->names.push_back(source.name);
+                reading->rms.push_back(rms);
+                reading->peak.push_back(peak);
+                if (spectrum_) {
+                    reading->bands.emplace_back();
+                    if (source.spectrum) {
+                        source.spectrum->Take(&reading->bands.back());
+                    }
+                }
+            }
+        }
+        if (reading->names.empty() && reported_silence) {
+            delete reading;
+            continue;
+        }
+        reported_silence = reading->names.empty();
+        reading->time = clock_->ToDateNowMs(HostTimeNow());
+
+        napi_status status = tsfn_.NonBlockingCall(reading, [](Napi::Env env, Napi::Function callback,
+                                                               MeterReading* reading) {
+            Napi::Object levels = Napi::Object::New(env);
+            levels.Set("time", Napi::Number::New(env, reading->time));
+            for (size_t i = 0; i < reading->names.size(); ++i) {
+                Napi::Object level = Napi::Object::New(env);
+                level.Set("rms", Napi::Number::New(env, reading->rms[i]));
+                level.Set("peak", Napi::Number::New(env, reading->peak[i]));
+                if (i < reading->bands.size() && !reading->bands[i].empty()) {
+                    const std::vector<float>& bands = reading->bands[i];
+                    Napi::Float32Array array = Napi::Float32Array::New(env, bands.size());
+                    std::copy(bands.begin(), bands.end(), array.Data());
+                    level.Set("bands", array);
+                }
+                levels.Set(reading->names[i], level);
+            }
+            delete reading;
+            try {
+                callback.Call({levels});
+            } catch (...) {
+                // Silently catch to prevent crash
+            }
+        });
+        if (status != napi_ok) {
+            delete reading;
+        }
+    }
+}
+
+} // namespace kakarot
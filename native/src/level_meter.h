@@ -0,0 +1,84 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "platform_thread.h"
+#include "spectral_analyzer.h"
+
+namespace kakarot {
+
+class HostClock;
+
+// Peak and RMS of a stream since the meter was last read, for UI meters that
+// want one number per display frame rather than the samples. The consumer
+// thread folds in each delivery with one sum-of-squares/peak pass; nothing is
+// computed while no publisher reads it.
+class LevelMeter {
+public:
+    // |wake| is notified per Add() while enabled
+    void SetEnabled(bool enabled, IdleSignal* wake = nullptr);
+    bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Consumer thread
+    void Add(const float* data, size_t num_samples);
+
+    // RMS and peak since the last Take(); false when nothing arrived
+    bool Take(float* rms, float* peak);
+    // Whether Take() would return true
+    bool Pending();
+
+private:
+    std::atomic<bool> enabled_{false};
+    std::mutex mutex_;
+    IdleSignal* wake_ = nullptr;
+    double sum_squares_ = 0.0;
+    float peak_ = 0.0f;
+    uint64_t count_ = 0;
+};
+
+// startLevelMeter()'s spectrum option: true, or { bands, scale: 'mel' |
+// 'linear', minHz, maxHz }; false when absent or false
+bool ParseSpectrumOptions(const Napi::Value& value, SpectrumOptions* options);
+
+// startLevelMeter(callback, { rateHz, spectrum }): a thread of its own takes
+// every source's meter at |rate_hz| and hands JS one small object per tick,
+// { time, <source>: { rms, peak, bands } }, a source absent while it has no
+// audio and bands (dB per band) only with the spectrum option. Ticks with
+// nothing to report are skipped after one that reports silence, and the
+// thread then waits untimed for audio to reach a meter.
+class LevelMeterPublisher {
+public:
+    struct Source {
+        const char* name;
+        LevelMeter* meter;
+        SpectrumMeter* spectrum = nullptr;
+    };
+
+    ~LevelMeterPublisher() { Stop(); }
+
+    // JS thread. Restarts with the new callback and rate when running;
+    // |spectrum| null leaves the sources' spectra off.
+    void Start(Napi::Env env, Napi::Function callback, double rate_hz, const HostClock* clock,
+               std::vector<Source> sources, const SpectrumOptions* spectrum = nullptr);
+    void Stop();
+
+    bool IsRunning() const { return thread_.joinable(); }
+
+private:
+    void Loop(double rate_hz);
+
+    std::vector<Source> sources_;
+    bool spectrum_ = false;
+    const HostClock* clock_ = nullptr;
+    Napi::ThreadSafeFunction tsfn_;
+    std::thread thread_;
+    IdleSignal wake_;
+    std::atomic<bool> running_{false};
+};
+
+} // namespace kakarot
@@ -0,0 +1,205 @@
+#include "lexical_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kakarot {
+
+// BM25 saturation and length normalization
+static constexpr float kBm25K1 = 1.2f;
+static constexpr float kBm25B = 0.75f;
+
+// Removed documents a compaction waits for, however few are live
+static constexpr size_t kMinCompactDocuments = 64;
+
+std::vector<std::string> LexicalIndex::Tokenize(const std::string& text) {
+    std::vector<std::string> terms;
+    std::string term;
+    for (char c : text) {
+        const unsigned char byte = static_cast<unsigned char>(c);
+        if ((byte >= '0' && byte <= '9') || (byte >= 'a' && byte <= 'z') || byte >= 0x80) {
+            term.push_back(c);
+        } else if (byte >= 'A' && byte <= 'Z') {
+            term.push_back(static_cast<char>(byte - 'A' + 'a'));
+        } else if (!term.empty()) {
+            terms.push_back(std::move(term));
+            term.clear();
+        }
+    }
+    if (!term.empty()) {
+        terms.push_back(std::move(term));
+    }
+    return terms;
+}
+
+void LexicalIndex::Add(const std::string& id, const std::string& text) {
+    std::vector<std::string> terms = Tokenize(text);
+    std::sort(terms.begin(), terms.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    RemoveLocked(id);
+    const uint32_t document = static_cast<uint32_t>(documents_.size());
+    documents_.push_back(Document{id, static_cast<uint32_t>(terms.size()), true});
+    by_id_[id] = document;
+    total_length_ += terms.size();
+    for (size_t i = 0; i < terms.size();) {
+        size_t end = i + 1;
+        while (end < terms.size() && terms[end] == terms[i]) {
+            ++end;
+        }
+        postings_[terms[i]].emplace_back(document, static_cast<uint32_t>(end - i));
+        ++postings_count_;
+        i = end;
+    }
+}
+
+bool LexicalIndex::Remove(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool removed = RemoveLocked(id);
+    Compact();
+    return removed;
+}
+
+size_t LexicalIndex::RemovePrefix(const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> matching;
+    for (const auto& entry : by_id_) {
+        if (entry.first.compare(0, prefix.size(), prefix) == 0) {
+            matching.push_back(entry.first);
+        }
+    }
+    for (const std::string& id : matching) {
+        RemoveLocked(id);
+    }
+    Compact();
+    return matching.size();
+}
+
+// Lock held. The document's postings stay until a compaction; searches skip them
+bool LexicalIndex::RemoveLocked(const std::string& id) {
+    auto found = by_id_.find(id);
+    if (found == by_id_.end()) {
+        return false;
+    }
+    Document& document = documents_[found->second];
+    document.live = false;
+    total_length_ -= document.length;
+    by_id_.erase(found);
+    return true;
+}
+
+// Lock held. Once removed documents outnumber live ones, renumbers the live
+// ones and drops the rest's postings
+void LexicalIndex::Compact() {
+    const size_t removed = documents_.size() - by_id_.size();
+    if (removed < kMinCompactDocuments || removed <= by_id_.size()) {
+        return;
+    }
+    std::vector<uint32_t> renumbered(documents_.size(), UINT32_MAX);
+    std::vector<Document> documents;
+    documents.reserve(by_id_.size());
+    for (size_t i = 0; i < documents_.size(); ++i) {
+        if (documents_[i].live) {
+            renumbered[i] = static_cast<uint32_t>(documents.size());
+            by_id_[documents_[i].id] = renumbered[i];
+            documents.push_back(std::move(documents_[i]));
+        }
+    }
+    documents_ = std::move(documents);
+    postings_count_ = 0;
+    for (auto it = postings_.begin(); it != postings_.end();) {
+        Postings& postings = it->second;
+        size_t kept = 0;
+        for (const auto& posting : postings) {
+            if (renumbered[posting.first] != UINT32_MAX) {
+                postings[kept++] = {renumbered[posting.first], posting.second};
+            }
+        }
+        postings.resize(kept);
+        postings_count_ += kept;
+        it = kept == 0 ? postings_.erase(it) : std::next(it);
+    }
+}
+
+std::vector<EmbeddingHit> LexicalIndex::Search(const std::string& query, size_t k,
+                                               std::chrono::steady_clock::time_point deadline,
+                                               bool* complete) const {
+    std::vector<std::string> terms = Tokenize(query);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    if (complete) {
+        *complete = true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<EmbeddingHit> hits;
+    const size_t live = by_id_.size();
+    if (k == 0 || live == 0 || terms.empty()) {
+        return hits;
+    }
+    const float average_length = static_cast<float>(total_length_) / live;
+    std::vector<float> scores(documents_.size(), 0.0f);
+    std::vector<uint32_t> touched;
+    for (const std::string& term : terms) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            if (complete) {
+                *complete = false;
+            }
+            break;
+        }
+        auto found = postings_.find(term);
+        if (found == postings_.end()) {
+            continue;
+        }
+        size_t frequency = 0;
+        for (const auto& posting : found->second) {
+            frequency += documents_[posting.first].live ? 1 : 0;
+        }
+        const float idf = std::log(1.0f + (live - frequency + 0.5f) / (frequency + 0.5f));
+        for (const auto& posting : found->second) {
+            const Document& document = documents_[posting.first];
+            if (!document.live) {
+                continue;
+            }
+            const float tf = static_cast<float>(posting.second);
+            const float norm = kBm25K1 * (1.0f - kBm25B + kBm25B * document.length / average_length);
+            if (scores[posting.first] == 0.0f) {
+                touched.push_back(posting.first);
+            }
+            scores[posting.first] += idf * tf * (kBm25K1 + 1.0f) / (tf + norm);
+        }
+    }
+
+    auto better = [&](uint32_t a, uint32_t b) { return scores[a] > scores[b]; };
+    const size_t count = std::min(k, touched.size());
+    std::partial_sort(touched.begin(), touched.begin() + count, touched.end(), better);
+    hits.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        hits[i].id = documents_[touched[i]].id;
+        hits[i].score = scores[touched[i]];
+    }
+    return hits;
+}
+
+size_t LexicalIndex::Documents() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return by_id_.size();
+}
+
+size_t LexicalIndex::Terms() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return postings_.size();
+}
+
+size_t LexicalIndex::Bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = postings_count_ * sizeof(Postings::value_type) + documents_.size() * sizeof(Document);
+    for (const auto& entry : postings_) {
+        bytes += entry.first.size() + sizeof(entry);
+    }
+    for (const Document& document : documents_) {
+        bytes += document.id.size();
+    }
+    return bytes;
+}
+
+} // namespace kakarot
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "embedding_index.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace kakarot {
+
+// BM25 over short documents (knowledge chunks) held in memory as postings
+// only, for the exact terms embeddings blur: product codes, names. Terms
+// are runs of ASCII letters and digits, folded to lowercase, with any
+// other UTF-8 bytes kept inside words. Any thread; a search and a change
+// exclude each other.
+class LexicalIndex {
+public:
+    // Replaces what |id| had
+    void Add(const std::string& id, const std::string& text);
+    bool Remove(const std::string& id);
+    // Every document whose id starts with |prefix|; returns how many
+    size_t RemovePrefix(const std::string& prefix);
+
+    // Best first, scores as BM25 (k1 1.2, b 0.75). Stops scoring terms at
+    // |deadline|, leaving |complete| false.
+    std::vector<EmbeddingHit> Search(
+        const std::string& query, size_t k,
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(),
+        bool* complete = nullptr) const;
+
+    size_t Documents() const;
+    size_t Terms() const;
+    size_t Bytes() const;
+
+    static std::vector<std::string> Tokenize(const std::string& text);
+
+private:
+    struct Document {
+        std::string id;
+        uint32_t length = 0;  // terms
+        bool live = false;
+    };
+    using Postings = std::vector<std::pair<uint32_t, uint32_t>>;  // document, term frequency
+
+    bool RemoveLocked(const std::string& id);
+    void Compact();
+
+    mutable std::mutex mutex_;
+    std::vector<Document> documents_;
+    std::unordered_map<std::string, uint32_t> by_id_;
+    std::unordered_map<std::string, Postings> postings_;
+    uint64_t total_length_ = 0;  // of the live documents
+    size_t postings_count_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,622 @@
+#include "local_transcriber.h"
+#include "addon_common.h"
+#include "native_log.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "thread_cpu.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+
+#if defined(KAKAROT_HAVE_WHISPER)
+#include <whisper.h>
+#endif
+
+namespace kakarot {
+
+static const char* const kLogSource = "LocalTranscriber";
+
+// What the models take
+static constexpr int kModelSampleRate = 16000;
+
+// Shorter utterances are clicks and breaths; whisper makes words of them
+static constexpr size_t kMinUtteranceSamples = kModelSampleRate / 5;
+
+// Default decode threads: half the cores, up to this many
+static constexpr int kMaxDefaultThreads = 8;
+
+// One event on its way to the JS thread
+struct TranscriberEvent {
+    struct Word {
+        std::string word;
+        double start_ms;
+        double end_ms;
+        double confidence;
+    };
+    const char* type;
+    std::string text;  // result text or error message
+    double start_ms = 0.0;
+    double end_ms = 0.0;
+    double timestamp = 0.0;
+    double load_ms = 0.0;
+    std::vector<Word> words;
+};
+
+// A loaded model; the weights are shared by every state decoding with it
+struct WhisperModel {
+#if defined(KAKAROT_HAVE_WHISPER)
+    whisper_context* context = nullptr;
+    ~WhisperModel() {
+        if (context) {
+            whisper_free(context);
+        }
+    }
+#endif
+};
+
+namespace {
+
+#if defined(KAKAROT_HAVE_WHISPER)
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ForwardWhisperLog(ggml_log_level level, const char* text, void*) {
+    if (level == GGML_LOG_LEVEL_ERROR || level == GGML_LOG_LEVEL_WARN) {
+        Log(level == GGML_LOG_LEVEL_ERROR ? LogLevel::kError : LogLevel::kWarn, kLogSource, "%s", text);
+    }
+}
+
+// One context per model file while any stream holds it
+std::shared_ptr<WhisperModel> LoadModel(const std::string& path, bool use_gpu, std::string* error) {
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<WhisperModel>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<WhisperModel>& entry = cache[path];
+    if (std::shared_ptr<WhisperModel> model = entry.lock()) {
+        return model;
+    }
+    whisper_log_set(ForwardWhisperLog, nullptr);
+    whisper_context_params params = whisper_context_default_params();
+    params.use_gpu = use_gpu;
+    auto model = std::make_shared<WhisperModel>();
+    model->context = whisper_init_from_file_with_params_no_state(path.c_str(), params);
+    if (!model->context) {
+        *error = "Failed to load model " + path;
+        return nullptr;
+    }
+    entry = model;
+    return model;
+}
+#endif
+
+} // namespace
+
+LocalTranscriber::LocalTranscriber(LocalTranscriberConfig config) : config_(std::move(config)) {}
+
+LocalTranscriber::~LocalTranscriber() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::kClosed) {
+            state_ = State::kClosing;
+        }
+    }
+    // Nobody waits on the last results: stop the decoder mid-utterance
+    abort_.store(true);
+    wake_.notify_all();
+    if (decode_thread_.joinable()) {
+        decode_thread_.join();
+    }
+}
+
+bool LocalTranscriber::Open(Napi::Env env, Napi::Function callback, std::string* error) {
+#if defined(KAKAROT_HAVE_WHISPER)
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ != State::kIdle) {
+        *error = "connect() was already called";
+        return false;
+    }
+    tsfn_ = Napi::ThreadSafeFunction::New(env, callback, "LocalTranscriber", 0, 1);
+    state_ = State::kLoading;
+    decode_thread_ = std::thread(&LocalTranscriber::Run, this);
+    return true;
+#else
+    (void)env;
+    (void)callback;
+    *error = "Built without on-device transcription (whisper.cpp)";
+    return false;
+#endif
+}
+
+void LocalTranscriber::SendAudio(const int16_t* samples, size_t num_samples, double timestamp) {
+    if (num_samples == 0) {
+        return;
+    }
+    Chunk chunk;
+    chunk.samples.assign(samples, samples + num_samples);
+    chunk.timestamp = timestamp;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == State::kClosing || state_ == State::kClosed) {
+        dropped_samples_ += num_samples;
+        return;
+    }
+    sent_samples_ += num_samples;
+    queued_samples_ += num_samples;
+    queue_.push_back(std::move(chunk));
+
+    // A decoder this far behind never catches up: drop the oldest audio,
+    // whose capture-time gap then ends its utterance
+    const size_t max_queued = static_cast<size_t>(config_.max_queued_ms * config_.sample_rate / 1000.0);
+    while (queued_samples_ > max_queued && queue_.size() > 1) {
+        queued_samples_ -= queue_.front().samples.size();
+        dropped_samples_ += queue_.front().samples.size();
+        queue_.pop_front();
+    }
+    wake_.notify_one();
+}
+
+void LocalTranscriber::EndUtterance() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == State::kClosing || state_ == State::kClosed) {
+        return;
+    }
+    Chunk chunk;
+    chunk.end = true;
+    queue_.push_back(std::move(chunk));
+    wake_.notify_one();
+}
+
+void LocalTranscriber::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == State::kIdle) {
+        state_ = State::kClosed;
+    } else if (state_ == State::kLoading || state_ == State::kRunning) {
+        state_ = State::kClosing;
+        wake_.notify_all();
+    }
+}
+
+LocalTranscriber::Stats LocalTranscriber::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double rate = config_.sample_rate / 1000.0;
+    Stats stats;
+    stats.state = state_;
+    stats.audio_ms = sent_samples_ / rate;
+    stats.decoded_ms = decoded_ms_;
+    stats.decode_ms = decode_ms_;
+    stats.real_time_factor = decoded_ms_ > 0.0 ? decode_ms_ / decoded_ms_ : 0.0;
+    stats.final_lag_ms = final_lag_ms_;
+    stats.queued_ms = queued_samples_ / rate;
+    stats.dropped_ms = dropped_samples_ / rate;
+    stats.partials = partials_;
+    stats.finals = finals_;
+    return stats;
+}
+
+// Decode thread
+void LocalTranscriber::Run() {
+    ScopedThreadCpu thread_cpu("localTranscriber");
+#if defined(KAKAROT_HAVE_WHISPER)
+    const auto load_start = std::chrono::steady_clock::now();
+    std::string error;
+    model_ = LoadModel(config_.model_path, config_.use_gpu, &error);
+    if (model_) {
+        whisper_ = whisper_init_state(model_->context);
+        if (!whisper_) {
+            error = "Failed to allocate decoder state";
+        }
+    }
+    if (!whisper_) {
+        Log(LogLevel::kError, kLogSource, "%s", error.c_str());
+        Post(new TranscriberEvent{"error", error});
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_ = State::kClosed;
+            dropped_samples_ += queued_samples_;
+            queued_samples_ = 0;
+            queue_.clear();
+        }
+        model_.reset();
+        Post(new TranscriberEvent{"close"});
+        tsfn_.Release();
+        return;
+    }
+    auto ready = new TranscriberEvent{"ready"};
+    ready->load_ms = MillisecondsSince(load_start);
+    Log(LogLevel::kInfo, kLogSource, "model ready in %.0fms", ready->load_ms);
+    Post(ready);
+
+    if (config_.sample_rate != kModelSampleRate) {
+        resample_in_.resize(static_cast<size_t>(config_.sample_rate / 100));
+        resampler_ = std::make_unique<webrtc::PushSincResampler>(resample_in_.size(), kModelSampleRate / 100);
+    }
+    const size_t step_samples = static_cast<size_t>(config_.step_ms * kModelSampleRate / 1000.0);
+    const size_t step_input = static_cast<size_t>(config_.step_ms * config_.sample_rate / 1000.0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (state_ == State::kLoading) {
+        state_ = State::kRunning;
+    }
+    while (!abort_.load()) {
+        wake_.wait(lock, [this] { return !queue_.empty() || state_ == State::kClosing || abort_.load(); });
+        if (abort_.load() || queue_.empty()) {
+            break;
+        }
+        Chunk chunk = std::move(queue_.front());
+        queue_.pop_front();
+        queued_samples_ -= chunk.samples.size();
+        decoded_ms_ += chunk.samples.size() * 1000.0 / config_.sample_rate;
+        // Partials only once caught up; a backlog goes to the final
+        const bool behind = queued_samples_ >= step_input;
+        lock.unlock();
+
+        Append(chunk);
+        if (!behind && utterance_.size() >= decoded_samples_ + step_samples) {
+            Decode(false);
+        }
+        lock.lock();
+    }
+    lock.unlock();
+
+    if (!abort_.load()) {
+        Decode(true);
+    }
+    whisper_free_state(whisper_);
+    whisper_ = nullptr;
+    model_.reset();
+    {
+        std::lock_guard<std::mutex> closed(mutex_);
+        state_ = State::kClosed;
+    }
+    Post(new TranscriberEvent{"close"});
+    tsfn_.Release();
+#endif
+}
+
+// Decode thread. Adds a chunk to the open utterance, ending it first where
+// the capture timeline jumps and after it at max_utterance_ms
+void LocalTranscriber::Append(const Chunk& chunk) {
+    if (chunk.end) {
+        Decode(true);
+        return;
+    }
+    const double input_ms = chunk.samples.size() * 1000.0 / config_.sample_rate;
+    if (chunk.timestamp > 0.0 && next_timestamp_ > 0.0 && chunk.timestamp - next_timestamp_ >= config_.gap_ms) {
+        Decode(true);
+    }
+    if (utterance_.empty()) {
+        utterance_start_ms_ = input_samples_ * 1000.0 / config_.sample_rate;
+        utterance_time_ = chunk.timestamp > 0.0 ? chunk.timestamp : next_timestamp_;
+    }
+    if (chunk.timestamp > 0.0) {
+        next_timestamp_ = chunk.timestamp;
+    }
+    if (next_timestamp_ > 0.0) {
+        next_timestamp_ += input_ms;
+    }
+    input_samples_ += chunk.samples.size();
+
+    if (!resampler_) {
+        for (int16_t sample : chunk.samples) {
+            utterance_.push_back(sample / 32768.0f);
+        }
+    } else {
+        const size_t out_frames = kModelSampleRate / 100;
+        for (int16_t sample : chunk.samples) {
+            resample_in_[resample_fill_++] = sample / 32768.0f;
+            if (resample_fill_ == resample_in_.size()) {
+                const size_t at = utterance_.size();
+                utterance_.resize(at + out_frames);
+                resampler_->Resample(resample_in_.data(), resample_in_.size(), utterance_.data() + at, out_frames);
+                resample_fill_ = 0;
+            }
+        }
+    }
+
+    if (utterance_.size() >= static_cast<size_t>(config_.max_utterance_ms * kModelSampleRate / 1000.0)) {
+        Decode(true);
+    }
+}
+
+// Decode thread. Runs the model over the open utterance; a final closes it
+void LocalTranscriber::Decode(bool final) {
+#if defined(KAKAROT_HAVE_WHISPER)
+    if (utterance_.size() < kMinUtteranceSamples) {
+        if (final) {
+            utterance_.clear();
+            decoded_samples_ = 0;
+            last_partial_.clear();
+        }
+        return;
+    }
+
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    int threads = config_.threads;
+    if (threads <= 0) {
+        threads = std::clamp(static_cast<int>(std::thread::hardware_concurrency() / 2), 1, kMaxDefaultThreads);
+    }
+    params.n_threads = threads;
+    params.language = config_.language.c_str();
+    params.detect_language = false;
+    params.no_context = true;
+    params.single_segment = !final;  // partials: one pass, no seeking
+    params.token_timestamps = final;
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_special = false;
+    params.print_timestamps = false;
+    params.suppress_blank = true;
+    params.abort_callback = [](void* data) { return static_cast<std::atomic<bool>*>(data)->load(); };
+    params.abort_callback_user_data = &abort_;
+
+    const auto start = std::chrono::steady_clock::now();
+    const int status = whisper_full_with_state(model_->context, whisper_, params, utterance_.data(),
+                                               static_cast<int>(utterance_.size()));
+    const double elapsed = MillisecondsSince(start);
+
+    auto event = new TranscriberEvent{final ? "final" : "partial"};
+    event->start_ms = utterance_start_ms_;
+    event->end_ms = utterance_start_ms_ + utterance_.size() * 1000.0 / kModelSampleRate;
+    event->timestamp = utterance_time_;
+    if (status == 0) {
+        const whisper_token eot = whisper_token_eot(model_->context);
+        const int segments = whisper_full_n_segments_from_state(whisper_);
+        for (int i = 0; i < segments; ++i) {
+            event->text += whisper_full_get_segment_text_from_state(whisper_, i);
+            if (!final) {
+                continue;
+            }
+            // Subword tokens; a leading space starts a word. Times are in 10ms.
+            const int tokens = whisper_full_n_tokens_from_state(whisper_, i);
+            size_t word_tokens = 0;
+            for (int j = 0; j < tokens; ++j) {
+                whisper_token_data data = whisper_full_get_token_data_from_state(whisper_, i, j);
+                if (data.id >= eot) {
+                    continue;
+                }
+                const char* text = whisper_full_get_token_text_from_state(model_->context, whisper_, i, j);
+                const double token_start = utterance_start_ms_ + data.t0 * 10.0;
+                const double token_end = utterance_start_ms_ + data.t1 * 10.0;
+                if (text[0] == ' ' || word_tokens == 0) {
+                    if (word_tokens > 0) {
+                        event->words.back().confidence /= word_tokens;
+                    }
+                    event->words.push_back({text[0] == ' ' ? text + 1 : text, token_start, token_end, data.p});
+                    word_tokens = 1;
+                } else {
+                    event->words.back().word += text;
+                    event->words.back().end_ms = token_end;
+                    event->words.back().confidence += data.p;
+                    ++word_tokens;
+                }
+            }
+            if (word_tokens > 0) {
+                event->words.back().confidence /= word_tokens;
+            }
+        }
+        const size_t first = event->text.find_first_not_of(' ');
+        event->text.erase(0, first == std::string::npos ? event->text.size() : first);
+    } else if (!abort_.load()) {
+        Log(LogLevel::kWarn, kLogSource, "decode failed (%d)", status);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decode_ms_ += elapsed;
+        if (final) {
+            final_lag_ms_ = elapsed;
+            if (!event->text.empty()) {
+                ++finals_;
+            }
+        } else if (!event->text.empty() && event->text != last_partial_) {
+            ++partials_;
+        }
+    }
+
+    // Unchanged partials and empty results are not posted
+    const bool post = !event->text.empty() && (final || event->text != last_partial_);
+    if (final) {
+        utterance_.clear();
+        decoded_samples_ = 0;
+        last_partial_.clear();
+    } else {
+        decoded_samples_ = utterance_.size();
+        last_partial_ = event->text;
+    }
+    if (post) {
+        Post(event);
+    } else {
+        delete event;
+    }
+#else
+    (void)final;
+#endif
+}
+
+void LocalTranscriber::Post(TranscriberEvent* event) {
+    napi_status status = tsfn_.NonBlockingCall(event, [](Napi::Env env, Napi::Function callback, TranscriberEvent* event) {
+        Napi::Object object = Napi::Object::New(env);
+        object.Set("type", Napi::String::New(env, event->type));
+        if (std::strcmp(event->type, "ready") == 0) {
+            object.Set("loadMs", Napi::Number::New(env, event->load_ms));
+        } else if (std::strcmp(event->type, "partial") == 0 || std::strcmp(event->type, "final") == 0) {
+            object.Set("text", Napi::String::New(env, event->text));
+            object.Set("startMs", Napi::Number::New(env, event->start_ms));
+            object.Set("endMs", Napi::Number::New(env, event->end_ms));
+            object.Set("timestamp", Napi::Number::New(env, event->timestamp));
+            Napi::Array words = Napi::Array::New(env, event->words.size());
+            for (size_t i = 0; i < event->words.size(); ++i) {
+                Napi::Object word = Napi::Object::New(env);
+                word.Set("text", Napi::String::New(env, event->words[i].word));
+                word.Set("start", Napi::Number::New(env, event->words[i].start_ms));
+                word.Set("end", Napi::Number::New(env, event->words[i].end_ms));
+                word.Set("confidence", Napi::Number::New(env, event->words[i].confidence));
+                words.Set(static_cast<uint32_t>(i), word);
+            }
+            object.Set("words", words);
+        } else if (std::strcmp(event->type, "error") == 0) {
+            object.Set("message", Napi::String::New(env, event->text));
+        }
+        delete event;
+        try {
+            callback.Call({object});
+        } catch (...) {
+            // Silently catch to prevent crash
+        }
+    });
+    if (status != napi_ok) {
+        delete event;
+    }
+}
+
+namespace {
+
+const char* StateName(LocalTranscriber::State state) {
+    switch (state) {
+        case LocalTranscriber::State::kIdle: return "idle";
+        case LocalTranscriber::State::kLoading: return "loading";
+        case LocalTranscriber::State::kRunning: return "running";
+        case LocalTranscriber::State::kClosing: return "closing";
+        case LocalTranscriber::State::kClosed: return "closed";
+    }
+    return "closed";
+}
+
+// new LocalTranscriber({ modelPath, language?, threads?, useGpu?,
+// sampleRate?, stepMs?, maxUtteranceMs?, gapMs?, maxQueuedMs? }). Keep a
+// reference while it is running: collecting it stops the decoder.
+class LocalTranscriberWrap : public Napi::ObjectWrap<LocalTranscriberWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "LocalTranscriber", {
+            InstanceMethod("connect", &LocalTranscriberWrap::Connect),
+            InstanceMethod("sendAudio", &LocalTranscriberWrap::SendAudio),
+            InstanceMethod("endUtterance", &LocalTranscriberWrap::EndUtterance),
+            InstanceMethod("close", &LocalTranscriberWrap::Close),
+            InstanceMethod("getStats", &LocalTranscriberWrap::GetStats),
+        });
+    }
+
+    explicit LocalTranscriberWrap(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<LocalTranscriberWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("modelPath").IsString()) {
+            Napi::TypeError::New(env, "Expected { modelPath }").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = info[0].As<Napi::Object>();
+        LocalTranscriberConfig config;
+        config.model_path = options.Get("modelPath").As<Napi::String>().Utf8Value();
+        if (options.Get("language").IsString()) {
+            config.language = options.Get("language").As<Napi::String>().Utf8Value();
+        }
+        if (options.Get("threads").IsNumber()) {
+            config.threads = std::max(0, options.Get("threads").As<Napi::Number>().Int32Value());
+        }
+        if (options.Get("useGpu").IsBoolean()) {
+            config.use_gpu = options.Get("useGpu").As<Napi::Boolean>().Value();
+        }
+        if (options.Get("sampleRate").IsNumber()) {
+            // Whole 10ms frames for the resampler
+            config.sample_rate = std::max(8000, options.Get("sampleRate").As<Napi::Number>().Int32Value()) / 100 * 100;
+        }
+        if (options.Get("stepMs").IsNumber()) {
+            config.step_ms = std::max(100.0, options.Get("stepMs").As<Napi::Number>().DoubleValue());
+        }
+        if (options.Get("maxUtteranceMs").IsNumber()) {
+            // The models see at most 30s at once
+            config.max_utterance_ms = std::clamp(options.Get("maxUtteranceMs").As<Napi::Number>().DoubleValue(),
+                                                 1000.0, 30000.0);
+        }
+        if (options.Get("gapMs").IsNumber()) {
+            config.gap_ms = std::max(10.0, options.Get("gapMs").As<Napi::Number>().DoubleValue());
+        }
+        if (options.Get("maxQueuedMs").IsNumber()) {
+            config.max_queued_ms = std::max(1000.0, options.Get("maxQueuedMs").As<Napi::Number>().DoubleValue());
+        }
+        transcriber_ = std::make_shared<LocalTranscriber>(std::move(config));
+    }
+
+    std::shared_ptr<LocalTranscriber> Transcriber() const { return transcriber_; }
+
+private:
+    // connect(onEvent) -> boolean; false when already used or built without whisper
+    Napi::Value Connect(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsFunction()) {
+            Napi::TypeError::New(env, "Expected an event callback").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::string error;
+        if (!transcriber_->Open(env, info[0].As<Napi::Function>(), &error)) {
+            Log(LogLevel::kWarn, kLogSource, "connect: %s", error.c_str());
+            return Napi::Boolean::New(env, false);
+        }
+        return Napi::Boolean::New(env, true);
+    }
+
+    // sendAudio(Int16Array, timestamp?): for audio that arrives in JS
+    // (audiotee); native capture streams send through their transport option
+    Napi::Value SendAudio(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsTypedArray() ||
+            info[0].As<Napi::TypedArray>().TypedArrayType() != napi_int16_array) {
+            Napi::TypeError::New(env, "Expected an Int16Array").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Int16Array samples = info[0].As<Napi::Int16Array>();
+        double timestamp = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().DoubleValue() : 0.0;
+        transcriber_->SendAudio(samples.Data(), samples.ElementLength(), timestamp);
+        return env.Undefined();
+    }
+
+    Napi::Value EndUtterance(const Napi::CallbackInfo& info) {
+        transcriber_->EndUtterance();
+        return info.Env().Undefined();
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        transcriber_->Close();
+        return info.Env().Undefined();
+    }
+
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        LocalTranscriber::Stats stats = transcriber_->GetStats();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("state", Napi::String::New(env, StateName(stats.state)));
+        result.Set("audioMs", Napi::Number::New(env, stats.audio_ms));
+        result.Set("decodedMs", Napi::Number::New(env, stats.decoded_ms));
+        result.Set("decodeMs", Napi::Number::New(env, stats.decode_ms));
+        result.Set("realTimeFactor", Napi::Number::New(env, stats.real_time_factor));
+        result.Set("finalLagMs", Napi::Number::New(env, stats.final_lag_ms));
+        result.Set("queuedMs", Napi::Number::New(env, stats.queued_ms));
+        result.Set("droppedMs", Napi::Number::New(env, stats.dropped_ms));
+        result.Set("partials", Napi::Number::New(env, static_cast<double>(stats.partials)));
+        result.Set("finals", Napi::Number::New(env, static_cast<double>(stats.finals)));
+        return result;
+    }
+
+    std::shared_ptr<LocalTranscriber> transcriber_;
+};
+
+} // namespace
+
+Napi::Function DefineLocalTranscriber(Napi::Env env) {
+    Napi::Function constructor = LocalTranscriberWrap::Define(env);
+    GetAddonInstance(env)->local_transcriber = Napi::Persistent(constructor);
+    return constructor;
+}
+
+std::shared_ptr<LocalTranscriber> LocalTranscriberFromValue(const Napi::Value& value) {
+    Napi::Env env = value.Env();
+    AddonInstance* instance = GetAddonInstance(env);
+    if (!value.IsObject() || !instance || instance->local_transcriber.IsEmpty() ||
+        !value.As<Napi::Object>().InstanceOf(instance->local_transcriber.Value())) {
+        return nullptr;
+    }
+    return LocalTranscriberWrap::Unwrap(value.As<Napi::Object>())->Transcriber();
+}
+
+} // namespace kakarot
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audio_transport.h"
+
+struct whisper_state;
+
+namespace webrtc {
+class PushSincResampler;
+}
+
+namespace kakarot {
+
+// new LocalTranscriber(options)
+struct LocalTranscriberConfig {
+    std::string model_path;       // a ggml whisper model; quantized (q5_0, q8_0) ones decode fastest
+    std::string language = "en";  // or "auto"
+    int threads = 0;              // decode threads; 0 = half the cores, at most 8
+    bool use_gpu = true;          // Metal where the library was built with it
+    int sample_rate = 16000;      // of the audio sent; resampled to the model's 16kHz
+    double step_ms = 1000.0;      // a partial after this much new audio in an utterance
+    double max_utterance_ms = 15000.0;  // longer utterances are cut here and finalized
+    double gap_ms = 1000.0;       // a capture-time jump this long (gated silence) finalizes
+    double max_queued_ms = 30000.0;     // audio waiting for the decoder; oldest dropped past it
+};
+
+struct WhisperModel;
+struct TranscriberEvent;
+
+// On-device streaming transcription: audio goes from a capture stream's
+// consumer thread (the stream's transport option) or from sendAudio() to a
+// decode thread of its own, which runs a whisper model over the open
+// utterance every step_ms for a partial and once more when it ends for the
+// final. Utterances end on endUtterance() (the capture gate's silence
+// markers), a gap in capture time or max_utterance_ms. Streams loading the
+// same model share its weights.
+//
+// JS receives events: { type: 'ready', loadMs } once the model is up,
+// { type: 'partial' | 'final', text, startMs, endMs, timestamp, words } per
+// result, { type: 'error', message } and, last, { type: 'close' }. startMs
+// and endMs count audio sent; timestamp is the Date.now() capture time of
+// startMs.
+class LocalTranscriber : public AudioTransport {
+public:
+    enum class State { kIdle, kLoading, kRunning, kClosing, kClosed };
+
+    explicit LocalTranscriber(LocalTranscriberConfig config);
+    ~LocalTranscriber() override;
+
+    LocalTranscriber(const LocalTranscriber&) = delete;
+    LocalTranscriber& operator=(const LocalTranscriber&) = delete;
+
+    // JS thread. Loads the model and starts decoding on the decode thread;
+    // false with |error| set when already used or built without whisper.
+    bool Open(Napi::Env env, Napi::Function callback, std::string* error);
+
+    // Any thread. Queued until the model is loaded; dropped once closing.
+    void SendAudio(const int16_t* samples, size_t num_samples, double timestamp) override;
+
+    // Any thread. Finalizes the open utterance after the audio already sent
+    void EndUtterance();
+
+    // JS thread. Finalizes what was sent, then a 'close' event follows
+    void Close();
+
+    struct Stats {
+        State state;
+        double audio_ms;        // sent
+        double decoded_ms;      // of that, through the decoder
+        double decode_ms;       // decoder time, partials included
+        double real_time_factor;  // decode_ms / decoded_ms; below 1 keeps up
+        double final_lag_ms;    // last final: from its utterance's end reaching the decoder
+        double queued_ms;
+        double dropped_ms;
+        uint64_t partials;
+        uint64_t finals;
+    };
+    Stats GetStats() const;
+
+private:
+    struct Chunk {
+        std::vector<int16_t> samples;
+        double timestamp = 0.0;
+        bool end = false;  // endUtterance() here
+    };
+
+    void Run();
+    void Append(const Chunk& chunk);
+    void Decode(bool final);
+    void Post(TranscriberEvent* event);
+
+    const LocalTranscriberConfig config_;
+    Napi::ThreadSafeFunction tsfn_;
+    std::thread decode_thread_;
+    std::atomic<bool> abort_{false};
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Chunk> queue_;
+    State state_ = State::kIdle;
+    size_t queued_samples_ = 0;
+    uint64_t sent_samples_ = 0;
+    uint64_t dropped_samples_ = 0;
+    double decoded_ms_ = 0.0;
+    double decode_ms_ = 0.0;
+    double final_lag_ms_ = 0.0;
+    uint64_t partials_ = 0;
+    uint64_t finals_ = 0;
+
+    // Decode thread only. The open utterance as 16kHz float, where it starts
+    // in the audio sent and when that was captured.
+    std::shared_ptr<WhisperModel> model_;
+    whisper_state* whisper_ = nullptr;
+    std::unique_ptr<webrtc::PushSincResampler> resampler_;
+    std::vector<float> resample_in_;
+    size_t resample_fill_ = 0;
+    std::vector<float> utterance_;
+    size_t decoded_samples_ = 0;   // of utterance_, at the last partial
+    uint64_t input_samples_ = 0;   // taken off the queue, at the input rate
+    double utterance_start_ms_ = 0.0;
+    double utterance_time_ = 0.0;
+    double next_timestamp_ = 0.0;  // capture time that would continue the input
+    std::string last_partial_;
+};
+
+// The LocalTranscriber class export; also remembered in the env's
+// AddonInstance, so a capture option can tell its objects apart
+Napi::Function DefineLocalTranscriber(Napi::Env env);
+
+// The transcriber behind a LocalTranscriber object; null for anything else
+std::shared_ptr<LocalTranscriber> LocalTranscriberFromValue(const Napi::Value& value);
+
+} // namespace kakarot
@@ -0,0 +1,126 @@
+#include "log_forwarder.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace kakarot {
+
+// Log delivery is not latency sensitive; batch generously
+static constexpr int64_t kDrainIntervalNs = 100 * 1000 * 1000;
+static constexpr size_t kMaxBatch = 64;
+
+static WakeupCounter g_wakeups("logForwarder");
+
+LogForwarder::LogForwarder() = default;
+
+LogForwarder::~LogForwarder() {
+    Stop();
+}
+
+void LogForwarder::Start(Napi::Env env, Napi::Function callback) {
+    Stop();
+
+    tsfn_ = Napi::ThreadSafeFunction::New(env, callback, "NativeLog", 0, 1);
+    env_ = env;
+    // Logging alone must not keep the process alive
+    tsfn_.Unref(env);
+
+    running_.store(true, std::memory_order_release);
+    NativeLogRing().SetWake(&wake_);
+    thread_ = std::thread(&LogForwarder::DrainLoop, this);
+}
+
+void LogForwarder::Stop() {
+    if (!IsRunning()) {
+        return;
+    }
+    running_.store(false, std::memory_order_release);
+    wake_.Signal();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    tsfn_.Release();
+    env_ = nullptr;
+}
+
+void LogForwarder::StopIfOwnedBy(napi_env env) {
+    if (env_ == env) {
+        Stop();
+    }
+}
+
+void LogForwarder::DrainLoop() {
+    ScopedThreadCpu thread_cpu("logForwarder");
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+
+    // Batches while records come in; parks, untimed, once an interval
+    // brings none
+    LogRing& ring = NativeLogRing();
+    auto empty = [this, &ring] { return ring.Empty() && ring.Dropped() == reported_drops_; };
+    bool idle = false;
+    while (running_.load(std::memory_order_acquire)) {
+        wake_.Wait(kDrainIntervalNs, [&] { return idle && empty(); });
+        g_wakeups.Count();
+        idle = empty();
+        Drain();
+    }
+    Drain();
+}
+
+void LogForwarder::Drain() {
+    LogRing& ring = NativeLogRing();
+    for (;;) {
+        auto batch = std::make_unique<std::vector<LogRecord>>(kMaxBatch);
+        size_t count = ring.Read(batch->data(), kMaxBatch);
+
+        // Say so when the ring overflowed since the last report
+        uint64_t dropped = ring.Dropped();
+        if (dropped != reported_drops_ && count < kMaxBatch) {
+            LogRecord& record = (*batch)[count++];
+            record.time_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            record.level = LogLevel::kWarn;
+            std::snprintf(record.source, LogRecord::kSourceSize, "NativeLog");
+            std::snprintf(record.message, LogRecord::kMessageSize, "%llu native log record(s) dropped (ring full)",
+                          static_cast<unsigned long long>(dropped - reported_drops_));
+            reported_drops_ = dropped;
+        }
+        if (count == 0) {
+            return;
+        }
+        batch->resize(count);
+
+        std::vector<LogRecord>* data = batch.release();
+        napi_status status = tsfn_.NonBlockingCall(data, [](Napi::Env env, Napi::Function callback,
+                                                            std::vector<LogRecord>* records) {
+            std::unique_ptr<std::vector<LogRecord>> owned(records);
+            Napi::Array array = Napi::Array::New(env, owned->size());
+            for (size_t i = 0; i < owned->size(); ++i) {
+                const LogRecord& record = (*owned)[i];
+                Napi::Object entry = Napi::Object::New(env);
+                entry.Set("level", Napi::Number::New(env, static_cast<int>(record.level)));
+                entry.Set("source", Napi::String::New(env, record.source));
+                entry.Set("message", Napi::String::New(env, record.message));
+                entry.Set("time", Napi::Number::New(env, record.time_ms));
+                array.Set(static_cast<uint32_t>(i), entry);
+            }
+            try {
+                callback.Call({ array });
+            } catch (...) {
+                // A throwing logger must not take the addon down
+            }
+        });
+        if (status != napi_ok) {
+            delete data;
+            return;
+        }
+        if (count < kMaxBatch) {
+            return;
+        }
+    }
+}
+
+} // namespace kakarot
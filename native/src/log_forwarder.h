@@ -0,0 +1,46 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "native_log.h"
+#include "platform_thread.h"
+
+namespace kakarot {
+
+// Drains NativeLogRing() on its own low-priority thread and hands batches to
+// a JS callback as [{ level, source, message, time }, ...]. Nothing that
+// writes the ring ever touches stdout or the JS thread.
+class LogForwarder {
+public:
+    LogForwarder();
+    ~LogForwarder();
+
+    LogForwarder(const LogForwarder&) = delete;
+    LogForwarder& operator=(const LogForwarder&) = delete;
+
+    // JS thread. Replaces any previous callback; queued records go to the new one.
+    void Start(Napi::Env env, Napi::Function callback);
+
+    // JS thread. Delivers what is left, then releases the callback.
+    void Stop();
+
+    // As |env| is torn down: Stop() when the callback is that env's
+    void StopIfOwnedBy(napi_env env);
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+private:
+    void DrainLoop();
+    void Drain();
+
+    Napi::ThreadSafeFunction tsfn_;
+    napi_env env_ = nullptr;  // the callback's
+    IdleSignal wake_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    uint64_t reported_drops_ = 0;  // drain thread only
+};
+
+} // namespace kakarot
@@ -0,0 +1,171 @@
+#include "loudness_meter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace kakarot {
+
+// Histogram of block loudness, from the absolute gate up
+static constexpr double kHistogramFloor = LoudnessMeter::kNoLoudness;
+static constexpr double kHistogramCeiling = 5.0;
+static constexpr double kBinLu = 0.1;
+static constexpr size_t kBins = static_cast<size_t>((kHistogramCeiling - kHistogramFloor) / kBinLu);
+
+static constexpr double kRelativeGateLu = 10.0;
+
+// Normalization stays within this either way, and under the peak ceiling
+static constexpr double kMaxGainDb = 24.0;
+static constexpr double kPeakCeilingDbfs = -1.0;
+
+static constexpr double kPi = 3.14159265358979323846;
+
+namespace {
+
+double BlockLoudness(double mean_square) {
+    return -0.691 + 10.0 * std::log10(mean_square);
+}
+
+double BlockEnergy(double lufs) {
+    return std::pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+double BinLoudness(size_t bin) {
+    return kHistogramFloor + (static_cast<double>(bin) + 0.5) * kBinLu;
+}
+
+} // namespace
+
+LoudnessMeter::LoudnessMeter() : histogram_(kBins, 0) {}
+
+void LoudnessMeter::Reset() {
+    sample_rate_ = 0;
+    channels_ = 0;
+    states_.clear();
+    sub_block_fill_ = 0;
+    sub_block_energy_ = 0.0;
+    sub_block_count_ = 0;
+    std::fill(histogram_.begin(), histogram_.end(), 0);
+    blocks_ = 0;
+    peak_ = 0.0f;
+}
+
+// The BS.1770 filters at |sample_rate|, from their analog prototypes as the
+// standard's 48kHz coefficients were
+void LoudnessMeter::Configure(int channels, int sample_rate) {
+    sample_rate_ = sample_rate;
+    channels_ = channels;
+    states_.assign(static_cast<size_t>(channels), ChannelState());
+    sub_block_frames_ = static_cast<size_t>(sample_rate / 10);
+    sub_block_fill_ = 0;
+    sub_block_energy_ = 0.0;
+    sub_block_count_ = 0;
+
+    const double fs = static_cast<double>(sample_rate);
+    double f0 = 1681.974450955533;
+    double q = 0.7071752369554196;
+    double k = std::tan(kPi * f0 / fs);
+    const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    shelf_.b0 = (vh + vb * k / q + k * k) / a0;
+    shelf_.b1 = 2.0 * (k * k - vh) / a0;
+    shelf_.b2 = (vh - vb * k / q + k * k) / a0;
+    shelf_.a1 = 2.0 * (k * k - 1.0) / a0;
+    shelf_.a2 = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(kPi * f0 / fs);
+    a0 = 1.0 + k / q + k * k;
+    high_pass_.b0 = 1.0;
+    high_pass_.b1 = -2.0;
+    high_pass_.b2 = 1.0;
+    high_pass_.a1 = 2.0 * (k * k - 1.0) / a0;
+    high_pass_.a2 = (1.0 - k / q + k * k) / a0;
+}
+
+void LoudnessMeter::Add(const float* samples, size_t frames, int channels, int sample_rate) {
+    if (frames == 0 || channels <= 0 || sample_rate < 10) {
+        return;
+    }
+    if (sample_rate != sample_rate_ || channels != channels_) {
+        Configure(channels, sample_rate);
+    }
+    const size_t width = static_cast<size_t>(channels);
+    for (size_t i = 0; i < frames; ++i) {
+        double power = 0.0;
+        for (size_t c = 0; c < width; ++c) {
+            const float x = samples[i * width + c];
+            peak_ = std::max(peak_, std::fabs(x));
+            double* z = states_[c].z;
+            // Direct form II transposed, shelf then high-pass
+            const double y1 = shelf_.b0 * x + z[0];
+            z[0] = shelf_.b1 * x - shelf_.a1 * y1 + z[1];
+            z[1] = shelf_.b2 * x - shelf_.a2 * y1;
+            const double y2 = high_pass_.b0 * y1 + z[2];
+            z[2] = high_pass_.b1 * y1 - high_pass_.a1 * y2 + z[3];
+            z[3] = high_pass_.b2 * y1 - high_pass_.a2 * y2;
+            power += y2 * y2;
+        }
+        sub_block_energy_ += power;
+        if (++sub_block_fill_ == sub_block_frames_) {
+            EndSubBlock();
+        }
+    }
+}
+
+// A 100ms step: the 400ms block ending here joins the histogram
+void LoudnessMeter::EndSubBlock() {
+    std::copy(sub_blocks_ + 1, sub_blocks_ + 4, sub_blocks_);
+    sub_blocks_[3] = sub_block_energy_ / static_cast<double>(sub_block_frames_);
+    sub_block_energy_ = 0.0;
+    sub_block_fill_ = 0;
+    if (++sub_block_count_ < 4) {
+        return;
+    }
+    const double mean_square = (sub_blocks_[0] + sub_blocks_[1] + sub_blocks_[2] + sub_blocks_[3]) / 4.0;
+    if (mean_square <= 0.0) {
+        return;
+    }
+    const double lufs = BlockLoudness(mean_square);
+    if (lufs < kHistogramFloor) {
+        return;
+    }
+    const size_t bin = std::min(kBins - 1, static_cast<size_t>((lufs - kHistogramFloor) / kBinLu));
+    ++histogram_[bin];
+    ++blocks_;
+}
+
+double LoudnessMeter::IntegratedLufs() const {
+    if (blocks_ == 0) {
+        return kNoLoudness;
+    }
+    double energy = 0.0;
+    for (size_t bin = 0; bin < kBins; ++bin) {
+        energy += histogram_[bin] * BlockEnergy(BinLoudness(bin));
+    }
+    const double gate = BlockLoudness(energy / static_cast<double>(blocks_)) - kRelativeGateLu;
+    const size_t first = static_cast<size_t>(std::clamp((gate - kHistogramFloor) / kBinLu, 0.0,
+                                                        static_cast<double>(kBins)));
+    energy = 0.0;
+    uint64_t count = 0;
+    for (size_t bin = first; bin < kBins; ++bin) {
+        energy += histogram_[bin] * BlockEnergy(BinLoudness(bin));
+        count += histogram_[bin];
+    }
+    return count > 0 ? BlockLoudness(energy / static_cast<double>(count)) : kNoLoudness;
+}
+
+float LoudnessMeter::PeakDbfs() const {
+    return peak_ > 0.0f ? 20.0f * std::log10(peak_) : -std::numeric_limits<float>::infinity();
+}
+
+float NormalizationGainDb(double integrated_lufs, double peak_dbfs, double target_lufs) {
+    if (integrated_lufs <= LoudnessMeter::kNoLoudness) {
+        return 0.0f;
+    }
+    const double gain = std::clamp(target_lufs - integrated_lufs, -kMaxGainDb, kMaxGainDb);
+    return static_cast<float>(std::min(gain, kPeakCeilingDbfs - peak_dbfs));
+}
+
+} // namespace kakarot
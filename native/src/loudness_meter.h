@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kakarot {
+
+// Integrated loudness of a recording, as ITU-R BS.1770-4 / EBU R128 define
+// it: K-weighted (a high shelf for the head, a high-pass), mean square over
+// 400ms blocks every 100ms, channels' powers summed, blocks under -70 LUFS
+// dropped and then those more than 10 LU under the rest. Blocks go into a
+// 0.1 LU histogram instead of being kept, so its memory is fixed however
+// long the recording and a reading at any time costs the histogram's bins.
+// A rate or channel change restarts the filters, not the measurement. One
+// thread at a time.
+class LoudnessMeter {
+public:
+    static constexpr double kNoLoudness = -70.0;  // nothing above the absolute gate
+
+    LoudnessMeter();
+
+    void Reset();
+
+    // |frames| of |channels| interleaved
+    void Add(const float* samples, size_t frames, int channels, int sample_rate);
+
+    // kNoLoudness until a block passes the gates
+    double IntegratedLufs() const;
+    float PeakDbfs() const;  // sample peak; -inf for silence
+    uint64_t Blocks() const { return blocks_; }
+
+private:
+    struct Biquad {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+    struct ChannelState {
+        double z[4] = {};  // each stage's two delays
+    };
+
+    void Configure(int channels, int sample_rate);
+    void EndSubBlock();
+
+    int sample_rate_ = 0;
+    int channels_ = 0;
+    Biquad shelf_;
+    Biquad high_pass_;
+    std::vector<ChannelState> states_;
+
+    size_t sub_block_frames_ = 0;  // 100ms
+    size_t sub_block_fill_ = 0;
+    double sub_block_energy_ = 0.0;
+    double sub_blocks_[4] = {};    // the last four, mean square each
+    size_t sub_block_count_ = 0;
+
+    std::vector<uint32_t> histogram_;
+    uint64_t blocks_ = 0;
+    float peak_ = 0.0f;
+};
+
+// Gain that brings audio measured at |integrated_lufs| to |target_lufs|,
+// within +-24dB and keeping its |peak_dbfs| under -1dBFS; 0 for silence
+float NormalizationGainDb(double integrated_lufs, double peak_dbfs, double target_lufs);
+
+} // namespace kakarot
@@ -0,0 +1,271 @@
+#include "meeting_audio_monitor.h"
+#include "native_log.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include "rtc_base/denormal_disabler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace kakarot {
+
+// Source tag of records this file writes to the native log ring
+static const char* const kLogSource = "MeetingAudioMonitor";
+
+// One wake per this much audio; the ring holds several. A wake that finds
+// no audio (no output playing) parks the thread untimed.
+static constexpr int64_t kWakeNs = 1000 * 1000 * 1000;
+
+static WakeupCounter g_wakeups("meetingAudioMonitor");
+
+// Seconds quieter than this are silence without asking the VAD
+static constexpr float kSilenceDbfs = -55.0f;
+
+// With no speech in the window, one audible second in this many is analysed
+static constexpr uint32_t kIdleStride = 4;
+
+// The event: this many speech seconds of the last kWindowSeconds, in at
+// least kMinSpeechRuns runs (a call's turns and pauses, not one long clip)
+static constexpr size_t kWindowSeconds = 30;
+static constexpr uint32_t kMinSpeechSeconds = 12;
+static constexpr uint32_t kMinSpeechRuns = 2;
+
+// Classifier confidence a speech second needs to count
+static constexpr float kMinSpeechConfidence = 0.5f;
+
+// A fired event rearms once the output has gone this long without speech
+static constexpr uint32_t kRearmQuietSeconds = 300;
+
+namespace {
+
+uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+MeetingAudioMonitor::MeetingAudioMonitor(size_t ring_samples) : ring_(ring_samples), read_buffer_(4096) {}
+
+MeetingAudioMonitor::~MeetingAudioMonitor() {
+    Stop();
+}
+
+bool MeetingAudioMonitor::Start(double sample_rate, EventCallback callback, std::string* error) {
+    Stop();
+    const int rate = static_cast<int>(sample_rate);
+    // Speech needs nothing above 8kHz; halve the rate wherever the result
+    // still frames in 10ms
+    decimation_ = rate >= 32000 && (rate / 2) % 100 == 0 ? 2 : 1;
+    analysis_rate_ = rate / decimation_;
+    if (static_cast<double>(rate) != sample_rate || !AudioClassifier::Supports(analysis_rate_)) {
+        *error = "Unsupported meeting monitor sample rate " + std::to_string(sample_rate);
+        return false;
+    }
+    vad_ = std::make_unique<VoiceActivityDetector>(analysis_rate_);
+    classifier_ = std::make_unique<AudioClassifier>(analysis_rate_);
+    second_.assign(static_cast<size_t>(analysis_rate_), 0.0f);
+    second_fill_ = 0;
+    has_carry_ = false;
+    idle_count_ = 0;
+    quiet_seconds_ = kWindowSeconds;
+    window_.clear();
+    window_confidence_.clear();
+    callback_ = std::move(callback);
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_ = MeetingAudioMonitorStats();
+        stats_.running = true;
+        stats_.armed = true;
+    }
+    frames_dropped_.store(0, std::memory_order_relaxed);
+
+    // Discard what a previous run left unread
+    while (ring_.Read(read_buffer_.data(), read_buffer_.size()) > 0) {
+    }
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&MeetingAudioMonitor::Loop, this);
+    Log(LogLevel::kInfo, kLogSource, "Meeting audio monitor started at %d Hz (analysed at %d Hz)", rate,
+        analysis_rate_);
+    return true;
+}
+
+void MeetingAudioMonitor::Stop() {
+    if (!running_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    wake_.Signal();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    callback_ = nullptr;
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.running = false;
+    Log(LogLevel::kInfo, kLogSource, "Meeting audio monitor stopped: %llu s heard, %llu analysed, %llu events",
+        static_cast<unsigned long long>(stats_.seconds_heard),
+        static_cast<unsigned long long>(stats_.seconds_analyzed), static_cast<unsigned long long>(stats_.events));
+}
+
+void MeetingAudioMonitor::Push(const float* data, uint32_t num_samples) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (!ring_.Write(data, num_samples)) {
+        frames_dropped_.fetch_add(num_samples, std::memory_order_relaxed);
+    }
+    wake_.Notify();
+}
+
+MeetingAudioMonitorStats MeetingAudioMonitor::GetStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    MeetingAudioMonitorStats stats = stats_;
+    stats.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MeetingAudioMonitor::Loop() {
+    ScopedThreadCpu thread_cpu("meetingAudioMonitor");
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+    webrtc::DenormalDisabler denormals;
+    start_ns_ = NowNs();
+    cpu_start_ns_ = CurrentThreadCpuNs();
+    bool idle = false;
+    while (running_.load(std::memory_order_acquire)) {
+        wake_.Wait(kWakeNs, [&] { return idle && ring_.AvailableToRead() == 0; });
+        g_wakeups.Count();
+        idle = ring_.AvailableToRead() == 0;
+        Drain();
+        const uint64_t wall = NowNs() - start_ns_;
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.wakeups;
+        if (wall > 0) {
+            stats_.cpu_load = static_cast<float>(static_cast<double>(CurrentThreadCpuNs() - cpu_start_ns_) /
+                                                 static_cast<double>(wall));
+        }
+    }
+}
+
+// The ring at half rate (pairs averaged, a crude but cheap low-pass ahead
+// of a VAD that only wants the speech band), a second at a time
+void MeetingAudioMonitor::Drain() {
+    size_t count;
+    while ((count = ring_.Read(read_buffer_.data(), read_buffer_.size())) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            float sample = read_buffer_[i];
+            if (decimation_ == 2) {
+                if (!has_carry_) {
+                    carry_ = sample;
+                    has_carry_ = true;
+                    continue;
+                }
+                sample = 0.5f * (carry_ + sample);
+                has_carry_ = false;
+            }
+            second_[second_fill_++] = sample;
+            if (second_fill_ == second_.size()) {
+                EndSecond();
+                second_fill_ = 0;
+            }
+        }
+    }
+}
+
+void MeetingAudioMonitor::EndSecond() {
+    double energy = 0.0;
+    for (float sample : second_) {
+        energy += static_cast<double>(sample) * sample;
+    }
+    const double mean_square = energy / static_cast<double>(second_.size());
+    float confidence = 0.0f;
+    SecondLabel label;
+    if (mean_square <= 0.0 || 10.0 * std::log10(mean_square) < kSilenceDbfs) {
+        label = kQuiet;
+    } else if (quiet_seconds_ >= kWindowSeconds && ++idle_count_ % kIdleStride != 1) {
+        label = kSkipped;
+    } else {
+        label = AnalyzeSecond(&confidence);
+    }
+    Decide(label, confidence);
+}
+
+MeetingAudioMonitor::SecondLabel MeetingAudioMonitor::AnalyzeSecond(float* confidence) {
+    const size_t frame = classifier_->FrameSize();
+    for (size_t offset = 0; offset + frame <= second_.size(); offset += frame) {
+        const float* samples = second_.data() + offset;
+        classifier_->ProcessFrame(samples, vad_->AnalyzeFrame(samples));
+    }
+    *confidence = classifier_->Confidence();
+    if (classifier_->Label() == AudioClass::kSpeech && *confidence >= kMinSpeechConfidence) {
+        return kSpeech;
+    }
+    return kOther;
+}
+
+void MeetingAudioMonitor::Decide(SecondLabel label, float confidence) {
+    if (label == kSpeech) {
+        quiet_seconds_ = 0;
+        idle_count_ = 0;
+    } else if (quiet_seconds_ < UINT32_MAX) {
+        ++quiet_seconds_;
+    }
+    window_.push_back(label);
+    window_confidence_.push_back(confidence);
+    if (window_.size() > kWindowSeconds) {
+        window_.pop_front();
+        window_confidence_.pop_front();
+    }
+
+    MeetingAudioEvent event;
+    event.window_seconds = static_cast<uint32_t>(window_.size());
+    bool previous_speech = false;
+    float confidence_sum = 0.0f;
+    for (size_t i = 0; i < window_.size(); ++i) {
+        const bool speech = window_[i] == kSpeech;
+        if (speech) {
+            ++event.speech_seconds;
+            confidence_sum += window_confidence_[i];
+            if (!previous_speech) {
+                ++event.speech_runs;
+            }
+        }
+        previous_speech = speech;
+    }
+    if (event.speech_seconds > 0) {
+        event.confidence = confidence_sum / static_cast<float>(event.speech_seconds);
+    }
+
+    bool fire = false;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.seconds_heard;
+        if (label == kQuiet) {
+            ++stats_.seconds_silent;
+        } else if (label != kSkipped) {
+            ++stats_.seconds_analyzed;
+        }
+        if (label == kSpeech) {
+            ++stats_.seconds_speech;
+        }
+        if (!stats_.armed && quiet_seconds_ >= kRearmQuietSeconds) {
+            stats_.armed = true;
+        }
+        if (stats_.armed && event.speech_seconds >= kMinSpeechSeconds && event.speech_runs >= kMinSpeechRuns) {
+            stats_.armed = false;
+            ++stats_.events;
+            fire = true;
+        }
+        stats_.window_speech_seconds = event.speech_seconds;
+    }
+    if (!fire) {
+        return;
+    }
+    Log(LogLevel::kInfo, kLogSource, "Meeting audio likely: %u s of speech in %u runs over %u s", event.speech_seconds,
+        event.speech_runs, event.window_seconds);
+    window_.clear();
+    window_confidence_.clear();
+    if (callback_) {
+        callback_(event);
+    }
+}
+
+} // namespace kakarot
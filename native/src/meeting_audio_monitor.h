@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audio_classifier.h"
+#include "platform_thread.h"
+#include "spsc_ring_buffer.h"
+#include "voice_activity.h"
+
+namespace kakarot {
+
+// "Meeting audio likely": the last window held enough speech, in enough
+// separate runs, to be a conversation rather than a notification or a clip
+struct MeetingAudioEvent {
+    uint32_t speech_seconds = 0;
+    uint32_t window_seconds = 0;
+    uint32_t speech_runs = 0;      // stretches of speech seconds the window's pauses split it into
+    float confidence = 0.0f;       // the classifier's mean over the speech seconds
+};
+
+struct MeetingAudioMonitorStats {
+    bool running = false;
+    bool armed = false;              // an event can fire; rearms after a long quiet
+    uint64_t seconds_heard = 0;      // of audio through the ring
+    uint64_t seconds_analyzed = 0;   // through the VAD and classifier
+    uint64_t seconds_silent = 0;     // under the level gate, never analysed
+    uint64_t seconds_speech = 0;
+    uint64_t events = 0;
+    uint64_t wakeups = 0;
+    uint64_t frames_dropped = 0;     // the ring was full
+    uint32_t window_speech_seconds = 0;
+    float cpu_load = 0.0f;           // the monitor thread's CPU time over the wall time running
+};
+
+// Standby watch on system output for a call starting without a calendar
+// event. The capture thread only memcpys into a ring; a utility-priority
+// thread wakes once a second, halves the rate and works through whole
+// seconds. A second under the level gate is silence without running the
+// RNN VAD; while nothing has sounded like speech lately, only one second
+// in kIdleStride is analysed at all. Each analysed second is labelled by
+// the VAD and AudioClassifier, and a window of them decides the event. Once
+// fired it stays quiet until the output has been without speech for a while
+// (the call ended).
+class MeetingAudioMonitor {
+public:
+    using EventCallback = std::function<void(const MeetingAudioEvent& event)>;
+
+    explicit MeetingAudioMonitor(size_t ring_samples);
+    ~MeetingAudioMonitor();
+
+    MeetingAudioMonitor(const MeetingAudioMonitor&) = delete;
+    MeetingAudioMonitor& operator=(const MeetingAudioMonitor&) = delete;
+
+    // |callback| runs on the monitor thread. False with |error| for a rate
+    // the classifier cannot frame.
+    bool Start(double sample_rate, EventCallback callback, std::string* error);
+    void Stop();
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // Capture real-time thread: mono frames at the started rate
+    void Push(const float* data, uint32_t num_samples);
+
+    // Any thread
+    MeetingAudioMonitorStats GetStats() const;
+
+private:
+    enum SecondLabel : uint8_t { kSkipped, kQuiet, kOther, kSpeech };
+
+    void Loop();
+    void Drain();
+    void EndSecond();
+    SecondLabel AnalyzeSecond(float* confidence);
+    void Decide(SecondLabel label, float confidence);
+
+    SpscRingBuffer<float> ring_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> frames_dropped_{0};
+    IdleSignal wake_;
+    std::thread thread_;
+    EventCallback callback_;
+
+    // Monitor thread only
+    int decimation_ = 1;
+    int analysis_rate_ = 0;
+    std::unique_ptr<VoiceActivityDetector> vad_;
+    std::unique_ptr<AudioClassifier> classifier_;
+    std::vector<float> read_buffer_;
+    std::vector<float> second_;      // at analysis_rate_
+    size_t second_fill_ = 0;
+    float carry_ = 0.0f;             // odd sample awaiting its pair
+    bool has_carry_ = false;
+    uint32_t idle_count_ = 0;        // seconds since one was analysed while idle
+    uint32_t quiet_seconds_ = 0;     // since the last speech second
+    std::deque<SecondLabel> window_;
+    std::deque<float> window_confidence_;
+
+    mutable std::mutex stats_mutex_;
+    MeetingAudioMonitorStats stats_;
+    uint64_t start_ns_ = 0;
+    uint64_t cpu_start_ns_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,152 @@
+#include "meeting_index.h"
+#include <algorithm>
+
+namespace kakarot {
+
+// Candidates each ranking takes per hit asked for, and at least, before
+// the windows too recent to count are dropped
+static constexpr size_t kCandidatesPerHit = 4;
+static constexpr size_t kMinCandidates = 20;
+
+bool MeetingIndex::Init(size_t dims, size_t window_tokens, std::string* error) {
+    if (window_tokens == 0) {
+        *error = "window tokens must be positive";
+        return false;
+    }
+    EmbeddingIndexOptions options;
+    options.dims = dims;
+    options.quantization = EmbeddingQuantization::kFloat16;
+    if (!vectors_.Init(options, error)) {
+        return false;
+    }
+    window_tokens_ = window_tokens;
+    Clear();
+    return true;
+}
+
+bool MeetingIndex::Append(double timestamp_ms, const std::string& line) {
+    const size_t tokens = counter_.Count(line);
+    if (tokens == 0) {
+        return false;
+    }
+    // A line longer than a window is a window of its own
+    const bool sealed = !open_.text.empty() && open_.tokens + tokens > window_tokens_;
+    if (sealed) {
+        Seal();
+    }
+    if (open_.text.empty()) {
+        open_.start_ms = timestamp_ms;
+    } else {
+        open_.text.push_back('\n');
+    }
+    open_.text += line;
+    open_.end_ms = timestamp_ms;
+    open_.tokens += tokens;
+    lines_++;
+    return sealed;
+}
+
+void MeetingIndex::Seal() {
+    if (open_.text.empty()) {
+        return;
+    }
+    open_.id = "w" + std::to_string(windows_.size());
+    lexical_->Add(open_.id, open_.text);
+    by_id_[open_.id] = windows_.size();
+    tokens_ += open_.tokens;
+    windows_.push_back(std::move(open_));
+    open_ = MeetingWindow();
+}
+
+void MeetingIndex::Clear() {
+    windows_.clear();
+    by_id_.clear();
+    first_unembedded_ = 0;
+    open_ = MeetingWindow();
+    lines_ = 0;
+    tokens_ = 0;
+    lexical_ = std::make_shared<LexicalIndex>();
+    vectors_.Clear();
+}
+
+std::vector<const MeetingWindow*> MeetingIndex::Unembedded(size_t max) const {
+    std::vector<const MeetingWindow*> windows;
+    for (size_t i = first_unembedded_; i < windows_.size() && windows.size() < max; ++i) {
+        if (!windows_[i].embedded) {
+            windows.push_back(&windows_[i]);
+        }
+    }
+    return windows;
+}
+
+bool MeetingIndex::SetEmbedding(const std::string& id, const float* vector, std::string* error) {
+    auto found = by_id_.find(id);
+    if (found == by_id_.end()) {
+        *error = "no window " + id;
+        return false;
+    }
+    if (!vectors_.Add(id, vector, error)) {
+        return false;
+    }
+    windows_[found->second].embedded = true;
+    while (first_unembedded_ < windows_.size() && windows_[first_unembedded_].embedded) {
+        first_unembedded_++;
+    }
+    return true;
+}
+
+const MeetingWindow* MeetingIndex::Find(const std::string& id) const {
+    auto found = by_id_.find(id);
+    return found == by_id_.end() ? nullptr : &windows_[found->second];
+}
+
+std::vector<MeetingHit> MeetingIndex::Search(const std::string& text, const float* vector, size_t k,
+                                             double before_ms, double rrf_k) const {
+    std::vector<MeetingHit> hits;
+    if (k == 0 || windows_.empty()) {
+        return hits;
+    }
+    // Windows end in order, so the ones left out are a suffix; each ranking
+    // takes that many more candidates
+    auto recent = std::lower_bound(windows_.begin(), windows_.end(), before_ms,
+                                   [](const MeetingWindow& window, double ms) { return window.end_ms < ms; });
+    const size_t excluded = static_cast<size_t>(windows_.end() - recent);
+    if (excluded == windows_.size()) {
+        return hits;
+    }
+    const size_t candidates = std::max(k * kCandidatesPerHit, kMinCandidates) + excluded;
+    auto earlier = [&](std::vector<EmbeddingHit> ranked) {
+        ranked.erase(std::remove_if(ranked.begin(), ranked.end(),
+                                    [&](const EmbeddingHit& hit) {
+                                        const MeetingWindow* window = Find(hit.id);
+                                        return !window || window->end_ms >= before_ms;
+                                    }),
+                     ranked.end());
+        return ranked;
+    };
+    std::vector<EmbeddingHit> vector_hits;
+    if (vector && vectors_.Size() > 0) {
+        vector_hits = earlier(vectors_.Search(vector, candidates));
+    }
+    std::vector<EmbeddingHit> lexical_hits = earlier(lexical_->Search(text, candidates));
+    for (FusedHit& fused : FuseRanks(vector_hits, lexical_hits, k, rrf_k)) {
+        const MeetingWindow* window = Find(fused.id);
+        hits.push_back(MeetingHit{window, std::move(fused)});
+    }
+    return hits;
+}
+
+MeetingIndexStats MeetingIndex::GetStats() const {
+    MeetingIndexStats stats;
+    stats.lines = lines_;
+    stats.windows = windows_.size();
+    stats.embedded = vectors_.Size();
+    stats.tokens = tokens_;
+    stats.bytes = lexical_->Bytes() + vectors_.Bytes() + open_.text.size();
+    for (const MeetingWindow& window : windows_) {
+        stats.bytes += window.text.size() + window.id.size() + sizeof(MeetingWindow);
+    }
+    return stats;
+}
+
+} // namespace kakarot
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "embedding_index.h"
+#include "hybrid_retriever.h"
+#include "lexical_index.h"
+#include "token_counter.h"
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kakarot {
+
+// A run of consecutive transcript lines, "w<n>" in order of sealing
+struct MeetingWindow {
+    std::string id;
+    std::string text;     // the lines, newline-separated
+    double start_ms = 0;  // first line's timestamp
+    double end_ms = 0;    // last line's
+    size_t tokens = 0;
+    bool embedded = false;
+};
+
+struct MeetingHit {
+    const MeetingWindow* window = nullptr;
+    FusedHit hit;
+};
+
+struct MeetingIndexStats {
+    size_t lines = 0;
+    size_t windows = 0;    // sealed
+    size_t embedded = 0;
+    size_t tokens = 0;     // of the sealed windows
+    size_t bytes = 0;
+};
+
+// The running meeting's transcript, indexed as it comes in so a callout can
+// pull back relevant discussion from any point in it, not just the recent
+// window it sees whole. Lines gather into a window until the next would
+// take it past |window_tokens| (cl100k, estimated from length); a sealed
+// window goes straight into BM25 postings and waits for its embedding,
+// which the caller fetches in batches. Search fuses the two rankings as
+// HybridSearch does, on the calling thread: a meeting is some hundreds of
+// windows at most. One thread at a time.
+class MeetingIndex {
+public:
+    // False with |error| for zero dims or window tokens
+    bool Init(size_t dims, size_t window_tokens, std::string* error);
+
+    // One final line at |timestamp_ms| (from the start of the meeting);
+    // true when it sealed the window before it
+    bool Append(double timestamp_ms, const std::string& line);
+    // The open window too, when it has lines
+    void Seal();
+    void Clear();
+
+    // Sealed windows still without an embedding, oldest first
+    std::vector<const MeetingWindow*> Unembedded(size_t max) const;
+    // |vector| has Dims() floats; false for an unknown window or a vector
+    // EmbeddingIndex refuses
+    bool SetEmbedding(const std::string& id, const float* vector, std::string* error);
+
+    // Best first among sealed windows that end before |before_ms|; BM25 on
+    // |text| alone when |vector| is null or nothing is embedded yet
+    std::vector<MeetingHit> Search(const std::string& text, const float* vector, size_t k, double before_ms,
+                                   double rrf_k) const;
+
+    size_t Dims() const { return vectors_.Dims(); }
+    MeetingIndexStats GetStats() const;
+
+private:
+    const MeetingWindow* Find(const std::string& id) const;
+
+    size_t window_tokens_ = 0;
+    std::deque<MeetingWindow> windows_;  // sealed, in order; pointers into it stay valid
+    std::unordered_map<std::string, size_t> by_id_;
+    size_t first_unembedded_ = 0;
+    MeetingWindow open_;
+    size_t lines_ = 0;
+    size_t tokens_ = 0;
+
+    TokenCounter counter_;
+    std::shared_ptr<LexicalIndex> lexical_ = std::make_shared<LexicalIndex>();
+    EmbeddingIndex vectors_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,145 @@
+#include "meeting_mixer.h"
+// As libwebrtc.a is built: the data dumper compiles to no-ops
+#ifndef WEBRTC_APM_DEBUG_DUMP
+#define WEBRTC_APM_DEBUG_DUMP 0
+#endif
+#include "api/audio/audio_view.h"
+#include "modules/audio_processing/agc2/agc2_common.h"
+#include "modules/audio_processing/agc2/limiter.h"
+#include "modules/audio_processing/logging/apm_data_dumper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+// System audio held beyond the delay: a second covers the longest render
+// burst the pipeline feeds ahead of its capture chunk
+static constexpr int kSystemHeadroomMs = 1000;
+
+bool MeetingMixer::Supports(int sample_rate) {
+    return sample_rate == 8000 || sample_rate == 16000 || sample_rate == 32000 || sample_rate == 48000;
+}
+
+MeetingMixer::MeetingMixer() : dumper_(std::make_unique<webrtc::ApmDataDumper>(0)) {}
+
+MeetingMixer::~MeetingMixer() = default;
+
+void MeetingMixer::Prepare(int sample_rate, size_t delay_samples) {
+    running_ = false;
+    const size_t frame = static_cast<size_t>(sample_rate / 100);
+    if (!limiter_) {
+        limiter_ = std::make_unique<webrtc::Limiter>(dumper_.get(), frame, "KakarotMix");
+    } else if (frame != frame_) {
+        limiter_->SetSamplesPerChannel(frame);
+    }
+    sample_rate_ = sample_rate;
+    frame_ = frame;
+    delay_ = delay_samples;
+    mic_.assign(frame_, 0.0f);
+    system_.assign(delay_ + frame_ + static_cast<size_t>(sample_rate) * kSystemHeadroomMs / 1000, 0.0f);
+    work_.assign(frame_ * 2, 0.0f);
+    output_.assign(frame_ * 2, 0.0f);
+}
+
+void MeetingMixer::Start(const MixOptions& options) {
+    if (frame_ == 0) {
+        return;
+    }
+    limiter_->Reset();
+    channels_ = options.stereo ? 2 : 1;
+
+    const float mic = std::pow(10.0f, options.mic_gain_db / 20.0f);
+    const float system = std::pow(10.0f, options.system_gain_db / 20.0f);
+    if (channels_ == 2) {
+        // Constant power: a centred source sits 3dB down in each channel
+        const float pi = 3.14159265f;
+        const float mic_angle = (options.mic_pan + 1.0f) * pi / 4.0f;
+        const float system_angle = (options.system_pan + 1.0f) * pi / 4.0f;
+        mic_gain_[0] = mic * std::cos(mic_angle);
+        mic_gain_[1] = mic * std::sin(mic_angle);
+        system_gain_[0] = system * std::cos(system_angle);
+        system_gain_[1] = system * std::sin(system_angle);
+    } else {
+        mic_gain_[0] = mic_gain_[1] = mic;
+        system_gain_[0] = system_gain_[1] = system;
+    }
+
+    mic_fill_ = 0;
+    std::fill(system_.begin(), system_.begin() + delay_, 0.0f);
+    system_fill_ = delay_;  // the delay, as silence
+    running_ = true;
+}
+
+void MeetingMixer::AddSystem(const float* data, size_t num_frames, uint32_t num_channels) {
+    if (!IsRunning() || num_channels == 0) {
+        return;
+    }
+    // Full: the oldest goes, as it would to realign anyway
+    if (num_frames > system_.size() - system_fill_) {
+        size_t drop = std::min(system_fill_, num_frames - (system_.size() - system_fill_));
+        std::memmove(system_.data(), system_.data() + drop, (system_fill_ - drop) * sizeof(float));
+        system_fill_ -= drop;
+        num_frames = std::min(num_frames, system_.size() - system_fill_);
+    }
+    const float scale = 1.0f / static_cast<float>(num_channels);
+    float* out = system_.data() + system_fill_;
+    for (size_t i = 0; i < num_frames; ++i) {
+        float sum = 0.0f;
+        for (uint32_t c = 0; c < num_channels; ++c) {
+            sum += data[i * num_channels + c];
+        }
+        out[i] = sum * scale;
+    }
+    system_fill_ += num_frames;
+}
+
+void MeetingMixer::AddMic(const float* data, size_t num_samples, const void* producer) {
+    if (!IsRunning()) {
+        return;
+    }
+    while (num_samples > 0) {
+        size_t count = std::min(num_samples, frame_ - mic_fill_);
+        std::memcpy(mic_.data() + mic_fill_, data, count * sizeof(float));
+        mic_fill_ += count;
+        data += count;
+        num_samples -= count;
+        if (mic_fill_ == frame_) {
+            MixFrame(producer);
+            mic_fill_ = 0;
+        }
+    }
+    // Render is fed up to the end of the capture it precedes, so all that
+    // should be left is the delay and what covers the partial mic frame
+    const size_t keep = delay_ + mic_fill_ + frame_;
+    if (system_fill_ > keep) {
+        const size_t drop = system_fill_ - keep;
+        std::memmove(system_.data(), system_.data() + drop, keep * sizeof(float));
+        system_fill_ = keep;
+    }
+}
+
+void MeetingMixer::MixFrame(const void* producer) {
+    const size_t available = std::min(system_fill_, frame_);
+    const float scale = webrtc::kMaxAbsFloatS16Value;
+    for (size_t c = 0; c < channels_; ++c) {
+        float* channel = work_.data() + c * frame_;
+        for (size_t i = 0; i < frame_; ++i) {
+            float system = i < available ? system_[i] : 0.0f;
+            channel[i] = (mic_[i] * mic_gain_[c] + system * system_gain_[c]) * scale;
+        }
+    }
+    std::memmove(system_.data(), system_.data() + available, (system_fill_ - available) * sizeof(float));
+    system_fill_ -= available;
+
+    limiter_->Process(webrtc::DeinterleavedView<float>(work_.data(), frame_, channels_));
+    for (size_t i = 0; i < frame_; ++i) {
+        for (size_t c = 0; c < channels_; ++c) {
+            output_[i * channels_ + c] = work_[c * frame_ + i] / scale;
+        }
+    }
+    RecordSamples(RecordTrack::kMix, producer, output_.data(), static_cast<uint32_t>(frame_), sample_rate_,
+                  static_cast<int>(channels_));
+}
+
+} // namespace kakarot
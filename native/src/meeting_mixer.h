@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "meeting_recorder.h"
+
+namespace webrtc {
+class ApmDataDumper;
+class Limiter;
+}
+
+namespace kakarot {
+
+// The meeting as one track: the processed mic and the system audio, each at
+// its gain and, for a stereo mix, at its pan (constant power), summed in
+// 10ms frames and kept out of clipping by AGC2's limiter, then handed to the
+// recorder's mix track. The AEC pipeline's DSP thread feeds it the render
+// reference after drift correction, already on the capture clock, so the
+// two stay sample-aligned for a whole meeting with no pass over the files
+// afterwards. Prepare() allocates; the rest runs on the DSP thread.
+class MeetingMixer {
+public:
+    // The limiter takes 10ms frames at 8, 16, 32 and 48kHz only
+    static bool Supports(int sample_rate);
+
+    MeetingMixer();
+    ~MeetingMixer();
+
+    MeetingMixer(const MeetingMixer&) = delete;
+    MeetingMixer& operator=(const MeetingMixer&) = delete;
+
+    // Stopped, with room for a stereo mix. System audio is held
+    // |delay_samples| behind the mic it is added to, the APM's output
+    // latency, so both come out as captured together.
+    void Prepare(int sample_rate, size_t delay_samples);
+
+    // From silence and the delay, once prepared
+    void Start(const MixOptions& options);
+    void Stop() { running_ = false; }
+    bool IsRunning() const { return running_; }
+
+    // Render frames as the APM was just given them, downmixed
+    void AddSystem(const float* data, size_t num_frames, uint32_t num_channels);
+
+    // Processed mic; each whole frame is mixed and recorded as |producer|'s.
+    // Where system audio has not come in the mix takes silence, and any left
+    // over past the delay afterwards (render that came in late) is dropped,
+    // so the two stay aligned.
+    void AddMic(const float* data, size_t num_samples, const void* producer);
+
+private:
+    void MixFrame(const void* producer);
+
+    bool running_ = false;
+    int sample_rate_ = 0;
+    size_t frame_ = 0;
+    size_t channels_ = 1;
+    size_t delay_ = 0;
+    float mic_gain_[2] = {1.0f, 1.0f};     // per output channel, pan included
+    float system_gain_[2] = {1.0f, 1.0f};
+
+    std::unique_ptr<webrtc::ApmDataDumper> dumper_;
+    std::unique_ptr<webrtc::Limiter> limiter_;
+    std::vector<float> mic_;        // one frame, filling
+    size_t mic_fill_ = 0;
+    std::vector<float> system_;     // mono, oldest first
+    size_t system_fill_ = 0;
+    std::vector<float> work_;       // deinterleaved, at AGC2's int16 scale
+    std::vector<float> output_;     // interleaved
+};
+
+} // namespace kakarot
@@ -0,0 +1,812 @@
+#include "meeting_recorder.h"
+#include "common_audio/include/audio_util.h"
+#include "loudness_meter.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "recording_crypto.h"
+#include "recording_index.h"
+#include "spsc_ring_buffer.h"
+#include "thread_cpu.h"
+#include "voice_activity.h"
+#include "wakeup_stats.h"
+#include "waveform_peaks.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace kakarot {
+
+static const char* const kLogSource = "MeetingRecorder";
+
+// Per track, between the capture threads and the writer: ~5s at 48kHz mono,
+// and chunk headers for IO buffers down to 64 frames
+static constexpr size_t kRingSamples = 262144;
+static constexpr size_t kRingChunks = 4096;
+static constexpr int64_t kDrainIntervalNs = 100 * 1000 * 1000;
+static constexpr size_t kWriteBlockSamples = 4096;
+static constexpr size_t kWavHeaderSize = 44;
+
+static WakeupCounter g_wakeups("recordingWriter");
+
+// Bounds of the options JS may set
+static constexpr double kMinSyncIntervalMs = 100.0;
+static constexpr double kMaxSyncIntervalMs = 10000.0;
+static constexpr double kMinChunkSeconds = 10.0;
+static constexpr double kMaxChunkSeconds = 3.0 * 3600.0;  // well inside WAV's 4GB at 48kHz float
+static constexpr double kMinIndexIntervalMs = 100.0;
+static constexpr double kMaxIndexIntervalMs = 10000.0;
+static constexpr double kMinCompactSilenceMs = 1000.0;
+static constexpr double kMaxCompactSilenceMs = 60000.0;
+
+// A 10ms frame counts towards a compacted silence under both; the floor
+// keeps music and loud noise, which the VAD calls non-speech, on disk
+static constexpr float kCompactSpeechProbability = 0.3f;
+static constexpr double kCompactFloorMeanSquare = 1e-5;  // -50dBFS RMS
+// Audio kept ahead of the speech that ends a run, for the VAD's lag
+static constexpr double kCompactPrerollMs = 300.0;
+
+// Stands for a silent track's peak in the index header
+static constexpr float kSilentPeakDbfs = -200.0f;
+
+static const char* const kTrackNames[kRecordTrackCount] = {"microphone", "system", "processed", "mix"};
+
+const char* RecordTrackName(RecordTrack track) {
+    return kTrackNames[static_cast<size_t>(track)];
+}
+
+namespace internal {
+std::atomic<bool> g_record_tracks[kRecordTrackCount];
+}
+
+namespace {
+
+struct RecordChunk {
+    uint32_t num_samples;  // frames
+    int32_t sample_rate;
+    int32_t channels;
+    uint64_t end_ns;  // when it was handed over, i.e. the capture time of its last sample
+};
+
+// The mix settings, field by field so the DSP threads read them without a
+// lock; written by StartRecording() before the generation moves
+struct MixState {
+    std::atomic<uint64_t> generation{0};
+    std::atomic<float> mic_gain_db{0.0f};
+    std::atomic<float> system_gain_db{0.0f};
+    std::atomic<bool> stereo{false};
+    std::atomic<float> mic_pan{0.0f};
+    std::atomic<float> system_pan{0.0f};
+};
+
+struct Track {
+    // Allocated by the first recording and kept, so a producer that read the
+    // flag just before a stop never writes into freed rings
+    std::unique_ptr<SpscRingBuffer<float>> samples;
+    std::unique_ptr<SpscRingBuffer<RecordChunk>> chunks;
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<const void*> producer{nullptr};  // the one capture instance feeding the rings
+
+    // Writer thread
+    FILE* file = nullptr;
+    int sample_rate = 0;
+    int channels = 1;
+    uint64_t file_samples = 0;     // frames
+    int next_index = 0;
+    size_t summary_file = 0;       // its entry in Session::summary.files
+    RecordChunk pending{0, 0, 1, 0};  // a chunk partly written
+    uint64_t pending_start_ns = 0; // capture time of pending's next sample
+    bool failed = false;           // a write failed; the rest is dropped
+
+    // Encrypted recordings: the WAV's part-filled block, and its tags
+    FILE* tags = nullptr;
+    std::vector<uint8_t> block;
+    uint8_t iv_prefix[kRecordingIvPrefixSize] = {};
+    uint32_t sealed_blocks = 0;
+    uint64_t sealed_bytes = 0;     // of the WAV's data, all on disk
+
+    FILE* index = nullptr;
+    uint32_t last_entry_ms = 0;
+    uint64_t next_entry_ms = 0;
+    bool new_file = false;         // the next write starts a WAV and gets an entry
+    PeakPyramidWriter peaks;
+    LoudnessMeter loudness;        // of everything the track wrote, kept in its index header
+
+    // Silence compaction
+    std::unique_ptr<VoiceActivityDetector> vad;
+    int vad_rate = 0;
+    int vad_channels = 1;
+    std::vector<float> vad_frame;  // mono, filling towards the next 10ms
+    size_t vad_fill = 0;
+    uint64_t quiet_frames = 0;     // silent 10ms frames in a row
+    bool compacting = false;       // in a run: samples go to |held|, not the WAV
+    uint64_t run_start_ns = 0;
+    std::vector<float> held;       // the run's latest kCompactPrerollMs
+    uint64_t held_start_ns = 0;
+    bool resumed = false;          // the next write ends a run and gets an entry
+};
+
+struct Session {
+    std::mutex control_mutex;      // start/stop/status, from any JS thread
+    RecorderOptions options;
+    double sample_bytes = 2.0;
+    std::shared_ptr<const AesGcm> cipher;  // with encrypt
+    std::thread writer;
+    Semaphore wake;
+    std::atomic<bool> running{false};
+    uint64_t last_sync_ns = 0;
+    uint64_t start_ns = 0;         // index time zero, on the steady clock
+    uint64_t started_at_ms = 0;    // the same instant, Unix epoch
+
+    std::mutex summary_mutex;      // summary: writer thread and JS thread
+    RecordingSummary summary;
+};
+
+Track g_tracks[kRecordTrackCount];
+Session g_session;
+MixState g_mix;
+
+uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+using recording_index::PutLe;
+
+// The canonical 44-byte header; the two sizes are patched as data lands
+void WriteWavHeader(FILE* file, int sample_rate, int channels, bool float32, uint32_t data_bytes) {
+    const uint32_t bits = float32 ? 32 : 16;
+    const uint32_t frame_bytes = static_cast<uint32_t>(channels) * bits / 8;
+    uint8_t header[kWavHeaderSize] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+                                      'f', 'm', 't', ' ', 16, 0, 0, 0};
+    PutLe(header + 4, 36 + data_bytes, 4);
+    PutLe(header + 20, float32 ? 3 : 1, 2);  // IEEE float or PCM
+    PutLe(header + 22, static_cast<uint32_t>(channels), 2);
+    PutLe(header + 24, static_cast<uint32_t>(sample_rate), 4);
+    PutLe(header + 28, static_cast<uint32_t>(sample_rate) * frame_bytes, 4);
+    PutLe(header + 32, frame_bytes, 2);
+    PutLe(header + 34, bits, 2);
+    std::memcpy(header + 36, "data", 4);
+    PutLe(header + 40, data_bytes, 4);
+    std::fwrite(header, 1, sizeof(header), file);
+}
+
+void CommitFile(FILE* file) {
+    std::fflush(file);
+#if defined(_WIN32)
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+// The index header, with the track's loudness so far; leaves the file at
+// its end for the next entry
+void WriteIndexHeader(size_t index) {
+    Track& track = g_tracks[index];
+    RecordingIndexHeader header;
+    header.interval_ms = static_cast<uint32_t>(g_session.options.index_interval_ms);
+    header.flags = (g_session.options.float32 ? kRecordingIndexFloat32 : 0) | kRecordingIndexLoudness |
+                   (g_session.options.compact_silence_ms > 0.0 ? kRecordingIndexSilence : 0) |
+                   (g_session.cipher ? kRecordingIndexEncrypted : 0);
+    header.started_at_ms = g_session.started_at_ms;
+    header.loudness_lufs = track.loudness.IntegratedLufs();
+    header.peak_dbfs = std::max(track.loudness.PeakDbfs(), kSilentPeakDbfs);
+    uint8_t bytes[kRecordingIndexHeaderSize];
+    recording_index::EncodeHeader(header, bytes);
+    std::fseek(track.index, 0, SEEK_SET);
+    std::fwrite(bytes, 1, sizeof(bytes), track.index);
+    std::fseek(track.index, 0, SEEK_END);
+
+    std::lock_guard<std::mutex> lock(g_session.summary_mutex);
+    g_session.summary.loudness_lufs[index] = header.loudness_lufs;
+    g_session.summary.peak_dbfs[index] = header.peak_dbfs;
+}
+
+// Durable up to here: sizes patched, stdio flushed, the OS told to commit.
+// The index first, so none of its entries point past the synced audio's end
+// for longer than the WAV's own sync.
+void SyncTrack(size_t index) {
+    Track& track = g_tracks[index];
+    if (track.index) {
+        WriteIndexHeader(index);
+        CommitFile(track.index);
+    }
+    track.peaks.Commit();
+    if (!track.file) {
+        return;
+    }
+    // Encrypted, the tags first, so none of the length is without them
+    uint32_t data_bytes = static_cast<uint32_t>(track.file_samples * track.channels * g_session.sample_bytes);
+    if (track.tags) {
+        CommitFile(track.tags);
+        data_bytes = static_cast<uint32_t>(track.sealed_bytes);
+    }
+    std::fseek(track.file, 0, SEEK_SET);
+    WriteWavHeader(track.file, track.sample_rate, track.channels, g_session.options.float32, data_bytes);
+    std::fseek(track.file, 0, SEEK_END);
+    {
+        std::lock_guard<std::mutex> lock(g_session.summary_mutex);
+        g_session.summary.files[track.summary_file].samples = track.file_samples;
+    }
+    CommitFile(track.file);
+}
+
+// Encrypts the part-filled block in place and appends it and its tag
+bool SealBlock(Track& track) {
+    if (track.block.empty()) {
+        return true;
+    }
+    uint8_t iv[kAesGcmIvSize];
+    uint8_t tag[kAesGcmTagSize];
+    RecordingBlockIv(track.iv_prefix, track.sealed_blocks, iv);
+    g_session.cipher->Seal(iv, nullptr, 0, track.block.data(), track.block.size(), tag);
+    if (std::fwrite(track.block.data(), 1, track.block.size(), track.file) != track.block.size() ||
+        std::fwrite(tag, 1, sizeof(tag), track.tags) != sizeof(tag)) {
+        return false;
+    }
+    track.sealed_blocks++;
+    track.sealed_bytes += track.block.size();
+    track.block.clear();
+    return true;
+}
+
+// Samples to the WAV as they are, or through the block when encrypting
+bool WriteData(Track& track, const void* data, size_t bytes) {
+    if (!track.tags) {
+        return std::fwrite(data, 1, bytes, track.file) == bytes;
+    }
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    while (bytes > 0) {
+        const size_t take = std::min(bytes, kRecordingCryptoBlockBytes - track.block.size());
+        track.block.insert(track.block.end(), in, in + take);
+        in += take;
+        bytes -= take;
+        if (track.block.size() == kRecordingCryptoBlockBytes && !SealBlock(track)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CloseTrack(size_t index) {
+    Track& track = g_tracks[index];
+    if (!track.file) {
+        return;
+    }
+    // A finished file's last block is short
+    if (track.tags && !SealBlock(track)) {
+        Log(LogLevel::kError, kLogSource, "Write to the %s recording failed at its end", kTrackNames[index]);
+        track.block.clear();
+    }
+    SyncTrack(index);
+    std::fclose(track.file);
+    track.file = nullptr;
+    if (track.tags) {
+        std::fclose(track.tags);
+        track.tags = nullptr;
+    }
+}
+
+// Created with the track's first WAV, so a track that records nothing
+// leaves no index (or waveform) behind
+bool OpenIndex(size_t index) {
+    Track& track = g_tracks[index];
+    const std::string base = g_session.options.directory + "/" + g_session.options.name + "." + kTrackNames[index];
+    track.peaks.Reset(base);
+    std::string path = base + ".idx";
+    track.index = std::fopen(path.c_str(), "wb");
+    if (!track.index) {
+        Log(LogLevel::kError, kLogSource, "Cannot open %s", path.c_str());
+        return false;
+    }
+    track.loudness.Reset();
+    WriteIndexHeader(index);
+    track.last_entry_ms = 0;
+    track.next_entry_ms = 0;
+
+    std::lock_guard<std::mutex> lock(g_session.summary_mutex);
+    g_session.summary.indexes[index] = path;
+    return true;
+}
+
+// Index time of |time_ns|, never before the track's last entry
+uint32_t EntryTimeMs(const Track& track, uint64_t time_ns) {
+    uint64_t since_start = time_ns > g_session.start_ns ? (time_ns - g_session.start_ns) / 1000000 : 0;
+    return std::max(track.last_entry_ms, static_cast<uint32_t>(std::min<uint64_t>(since_start, UINT32_MAX)));
+}
+
+// An entry at the track's current sample. A failed index write is logged
+// once and costs seeking, never the audio.
+bool AppendEntry(Track& track, size_t index, uint32_t time_ms, bool silence) {
+    RecordingIndexEntry entry;
+    entry.time_ms = time_ms;
+    entry.file = static_cast<uint32_t>(track.next_index - 1);
+    entry.sample = track.file_samples;
+    entry.silence = silence;
+    uint8_t bytes[kRecordingIndexEntrySize];
+    recording_index::EncodeEntry(entry, bytes);
+    if (std::fwrite(bytes, 1, sizeof(bytes), track.index) != sizeof(bytes)) {
+        Log(LogLevel::kError, kLogSource, "Write to the %s seek index failed; it stops", kTrackNames[index]);
+        std::fclose(track.index);
+        track.index = nullptr;
+        return false;
+    }
+    track.last_entry_ms = time_ms;
+    return true;
+}
+
+// An entry for the sample about to be written, captured at |time_ns|, when
+// it opens a WAV, ends a compacted silence or the interval has passed
+void IndexSample(Track& track, uint64_t time_ns, size_t index) {
+    if (!track.index) {
+        return;
+    }
+    uint32_t time_ms = EntryTimeMs(track, time_ns);
+    if (!track.new_file && !track.resumed && time_ms < track.next_entry_ms) {
+        return;
+    }
+    if (!AppendEntry(track, index, time_ms, false)) {
+        return;
+    }
+    const uint64_t interval = static_cast<uint64_t>(g_session.options.index_interval_ms);
+    track.next_entry_ms = (time_ms / interval + 1) * interval;
+    track.new_file = false;
+    track.resumed = false;
+}
+
+bool OpenTrack(size_t index, int sample_rate, int channels) {
+    Track& track = g_tracks[index];
+    if (track.next_index == 0 && !OpenIndex(index)) {
+        return false;
+    }
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%s.%03d.wav", kTrackNames[index], track.next_index++);
+    std::string path = g_session.options.directory + "/" + g_session.options.name + suffix;
+    track.file = std::fopen(path.c_str(), "wb");
+    if (!track.file) {
+        Log(LogLevel::kError, kLogSource, "Cannot open %s", path.c_str());
+        return false;
+    }
+    WriteWavHeader(track.file, sample_rate, channels, g_session.options.float32, 0);
+    if (g_session.cipher) {
+        const std::string tags_path = path + ".tag";
+        track.tags = std::fopen(tags_path.c_str(), "wb");
+        if (!track.tags) {
+            Log(LogLevel::kError, kLogSource, "Cannot open %s", tags_path.c_str());
+            std::fclose(track.file);
+            track.file = nullptr;
+            return false;
+        }
+        uint8_t header[kRecordingTagHeaderSize];
+        NewRecordingTagHeader(*g_session.cipher, track.iv_prefix, header);
+        std::fwrite(header, 1, sizeof(header), track.tags);
+        track.block.reserve(kRecordingCryptoBlockBytes);
+        track.sealed_blocks = 0;
+        track.sealed_bytes = 0;
+    }
+    track.sample_rate = sample_rate;
+    track.channels = channels;
+    track.file_samples = 0;
+    track.new_file = true;
+
+    std::lock_guard<std::mutex> lock(g_session.summary_mutex);
+    RecordedFile file;
+    file.track = static_cast<RecordTrack>(index);
+    file.path = path;
+    file.sample_rate = sample_rate;
+    file.channels = channels;
+    track.summary_file = g_session.summary.files.size();
+    g_session.summary.files.push_back(file);
+    return true;
+}
+
+// Appends |count| frames of |channels| captured from |time_ns|, rolling the
+// file over at the chunk length. The waveform is of their mono downmix.
+bool WriteSamples(size_t index, const float* samples, size_t count, int sample_rate, int channels,
+                  uint64_t time_ns) {
+    Track& track = g_tracks[index];
+    const uint64_t chunk_samples = static_cast<uint64_t>(g_session.options.chunk_seconds * sample_rate);
+    const size_t width = static_cast<size_t>(channels);
+    int16_t pcm16[kWriteBlockSamples];
+    float mono[kWriteBlockSamples];
+    while (count > 0) {
+        if (track.file && (track.sample_rate != sample_rate || track.channels != channels ||
+                           track.file_samples >= chunk_samples)) {
+            CloseTrack(index);
+        }
+        if (!track.file && !OpenTrack(index, sample_rate, channels)) {
+            return false;
+        }
+        size_t block = static_cast<size_t>(std::min<uint64_t>(std::min(count, kWriteBlockSamples / width),
+                                                               chunk_samples - track.file_samples));
+        IndexSample(track, time_ns, index);
+        bool written;
+        if (g_session.options.float32) {
+            written = WriteData(track, samples, sizeof(float) * block * width);
+        } else {
+            webrtc::FloatToS16(samples, block * width, pcm16);
+            written = WriteData(track, pcm16, sizeof(int16_t) * block * width);
+        }
+        if (!written) {
+            Log(LogLevel::kError, kLogSource, "Write to the %s recording failed; the track stops", kTrackNames[index]);
+            return false;
+        }
+        const float* peaks = samples;
+        if (width > 1) {
+            for (size_t i = 0; i < block; ++i) {
+                float sum = 0.0f;
+                for (size_t c = 0; c < width; ++c) {
+                    sum += samples[i * width + c];
+                }
+                mono[i] = sum / static_cast<float>(width);
+            }
+            peaks = mono;
+        }
+        track.loudness.Add(samples, block, channels, sample_rate);
+        track.peaks.Add(peaks, block, sample_rate,
+                        time_ns > g_session.start_ns ? (time_ns - g_session.start_ns) / 1e6 : 0.0);
+        track.file_samples += block;
+        samples += block * width;
+        count -= block;
+        time_ns += static_cast<uint64_t>(block * 1e9 / sample_rate);
+    }
+    return true;
+}
+
+// A compacted silence from |time_ns| on: its marker, then samples are held
+void StartSilence(size_t index, uint64_t time_ns) {
+    Track& track = g_tracks[index];
+    if (!AppendEntry(track, index, EntryTimeMs(track, time_ns), true)) {
+        return;
+    }
+    track.compacting = true;
+    track.run_start_ns = time_ns;
+    track.held.clear();
+    track.held_start_ns = time_ns;
+}
+
+void HoldSamples(Track& track, const float* samples, size_t count) {
+    const size_t width = static_cast<size_t>(track.vad_channels);
+    const size_t keep = static_cast<size_t>(kCompactPrerollMs * track.vad_rate / 1000.0) * width;
+    track.held.insert(track.held.end(), samples, samples + count * width);
+    // Trimmed in batches, not per call
+    if (track.held.size() > 2 * keep) {
+        const size_t drop = track.held.size() - keep;
+        track.held.erase(track.held.begin(), track.held.begin() + drop);
+        track.held_start_ns += static_cast<uint64_t>(drop / width * 1e9 / track.vad_rate);
+    }
+}
+
+void CountCompacted(size_t index, uint64_t end_ns) {
+    Track& track = g_tracks[index];
+    std::lock_guard<std::mutex> lock(g_session.summary_mutex);
+    g_session.summary.compacted_ms[index] += end_ns > track.run_start_ns ? (end_ns - track.run_start_ns) / 1e6 : 0.0;
+}
+
+// Speech again: the run ends where the held audio starts, and it is written
+bool EndSilence(size_t index) {
+    Track& track = g_tracks[index];
+    track.compacting = false;
+    track.resumed = true;
+    CountCompacted(index, track.held_start_ns);
+    const size_t frames = track.held.size() / static_cast<size_t>(track.vad_channels);
+    return frames == 0 ||
+           WriteSamples(index, track.held.data(), frames, track.vad_rate, track.vad_channels, track.held_start_ns);
+}
+
+// A run still open at the stop ends with the audio: an entry there, the
+// held silence dropped
+void CloseSilence(size_t index) {
+    Track& track = g_tracks[index];
+    if (!track.compacting) {
+        return;
+    }
+    track.compacting = false;
+    const uint64_t end_ns = track.held_start_ns +
+        static_cast<uint64_t>(track.held.size() / static_cast<size_t>(track.vad_channels) * 1e9 / track.vad_rate);
+    CountCompacted(index, end_ns);
+    track.resumed = true;
+    IndexSample(track, end_ns, index);
+}
+
+// WriteSamples(), less the part of each silence past compact_silence_ms.
+// Decisions are per 10ms frame and apply from the frame after; a rate the
+// VAD cannot frame is written as is.
+bool StoreSamples(size_t index, const float* samples, size_t count, int sample_rate, int channels,
+                  uint64_t time_ns) {
+    Track& track = g_tracks[index];
+    const double compact_ms = g_session.options.compact_silence_ms;
+    if (compact_ms <= 0.0 || sample_rate % 100 != 0) {
+        return WriteSamples(index, samples, count, sample_rate, channels, time_ns);
+    }
+    if (track.vad_rate != sample_rate || track.vad_channels != channels) {
+        if (track.compacting && !EndSilence(index)) {
+            return false;
+        }
+        if (!track.vad || track.vad_rate != sample_rate) {
+            track.vad = std::make_unique<VoiceActivityDetector>(sample_rate);
+        }
+        track.vad_rate = sample_rate;
+        track.vad_channels = channels;
+        track.vad_frame.assign(static_cast<size_t>(sample_rate / 100), 0.0f);
+        track.vad_fill = 0;
+        track.quiet_frames = 0;
+    }
+    const size_t width = static_cast<size_t>(channels);
+    const size_t frame = track.vad_frame.size();
+    const uint64_t compact_frames = static_cast<uint64_t>(compact_ms / 10.0);
+    while (count > 0) {
+        const size_t block = std::min(count, frame - track.vad_fill);
+        if (track.compacting) {
+            HoldSamples(track, samples, block);
+        } else if (!WriteSamples(index, samples, block, sample_rate, channels, time_ns)) {
+            return false;
+        }
+        float* mono = track.vad_frame.data() + track.vad_fill;
+        for (size_t i = 0; i < block; ++i) {
+            float sum = 0.0f;
+            for (size_t c = 0; c < width; ++c) {
+                sum += samples[i * width + c];
+            }
+            mono[i] = sum / static_cast<float>(width);
+        }
+        track.vad_fill += block;
+        samples += block * width;
+        count -= block;
+        time_ns += static_cast<uint64_t>(block * 1e9 / sample_rate);
+        if (track.vad_fill < frame) {
+            continue;
+        }
+        track.vad_fill = 0;
+        double energy = 0.0;
+        for (float sample : track.vad_frame) {
+            energy += static_cast<double>(sample) * sample;
+        }
+        const bool silent = track.vad->AnalyzeFrame(track.vad_frame.data()) < kCompactSpeechProbability &&
+                            energy < kCompactFloorMeanSquare * static_cast<double>(frame);
+        if (!silent) {
+            track.quiet_frames = 0;
+            if (track.compacting && !EndSilence(index)) {
+                return false;
+            }
+        } else if (++track.quiet_frames >= compact_frames && !track.compacting && track.file && track.index) {
+            StartSilence(index, time_ns);
+        }
+    }
+    return true;
+}
+
+void DrainTrack(size_t index) {
+    Track& track = g_tracks[index];
+    float block[kWriteBlockSamples];
+    for (;;) {
+        if (track.pending.num_samples == 0) {
+            if (track.chunks->Read(&track.pending, 1) == 0) {
+                return;
+            }
+            uint64_t duration_ns = track.pending.sample_rate > 0
+                ? static_cast<uint64_t>(track.pending.num_samples * 1e9 / track.pending.sample_rate) : 0;
+            track.pending_start_ns = track.pending.end_ns > duration_ns ? track.pending.end_ns - duration_ns : 0;
+        }
+        const size_t width = static_cast<size_t>(track.pending.channels);
+        size_t count = track.samples->Read(
+            block, std::min<size_t>(track.pending.num_samples, kWriteBlockSamples / width) * width) / width;
+        track.pending.num_samples -= static_cast<uint32_t>(count);
+        if (count == 0) {
+            track.pending.num_samples = 0;  // lost to a stop/start race; drop the header
+            continue;
+        }
+        const uint64_t time_ns = track.pending_start_ns;
+        track.pending_start_ns += static_cast<uint64_t>(count * 1e9 / track.pending.sample_rate);
+        if (track.failed ||
+            !StoreSamples(index, block, count, track.pending.sample_rate, track.pending.channels, time_ns)) {
+            if (!track.failed) {
+                track.failed = true;
+                internal::g_record_tracks[index].store(false, std::memory_order_relaxed);
+                CloseTrack(index);
+            }
+            track.dropped.fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+}
+
+void DrainAll(bool force_sync) {
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        if (g_session.options.tracks[i]) {
+            DrainTrack(i);
+        }
+    }
+    uint64_t now = NowNs();
+    if (force_sync || now - g_session.last_sync_ns >= g_session.options.sync_interval_ms * 1e6) {
+        for (size_t i = 0; i < kRecordTrackCount; ++i) {
+            SyncTrack(i);
+        }
+        g_session.last_sync_ns = now;
+    }
+}
+
+void WriterLoop() {
+    ScopedThreadCpu thread_cpu("recordingWriter");
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+    while (g_session.running.load(std::memory_order_acquire)) {
+        g_session.wake.WaitFor(kDrainIntervalNs);
+        g_wakeups.Count();
+        DrainAll(false);
+    }
+}
+
+} // namespace
+
+bool StartRecording(const RecorderOptions& options, std::string* error) {
+    std::lock_guard<std::mutex> control(g_session.control_mutex);
+    if (g_session.writer.joinable()) {
+        *error = "already recording";
+        Log(LogLevel::kWarn, kLogSource, "Recording already running");
+        return false;
+    }
+    g_session.options = options;
+    g_session.options.sync_interval_ms = std::clamp(options.sync_interval_ms, kMinSyncIntervalMs, kMaxSyncIntervalMs);
+    g_session.options.chunk_seconds = std::clamp(options.chunk_seconds, kMinChunkSeconds, kMaxChunkSeconds);
+    g_session.options.index_interval_ms = std::clamp(options.index_interval_ms, kMinIndexIntervalMs, kMaxIndexIntervalMs);
+    if (options.compact_silence_ms > 0.0) {
+        g_session.options.compact_silence_ms =
+            std::clamp(options.compact_silence_ms, kMinCompactSilenceMs, kMaxCompactSilenceMs);
+    }
+    g_session.sample_bytes = options.float32 ? 4.0 : 2.0;
+    g_session.cipher = options.encrypt ? RecordingCipher() : nullptr;
+    if (options.encrypt && !g_session.cipher) {
+        *error = "no recording key set";
+        Log(LogLevel::kError, kLogSource, "Encrypted recording asked for without a key");
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_session.summary_mutex);
+        g_session.summary = RecordingSummary();
+    }
+
+    // A file that will not open fails the start, not the first write
+    std::string probe = options.directory + "/" + options.name + ".probe";
+    FILE* file = std::fopen(probe.c_str(), "wb");
+    if (!file) {
+        *error = "cannot write to " + options.directory;
+        Log(LogLevel::kError, kLogSource, "Cannot write to %s", options.directory.c_str());
+        return false;
+    }
+    std::fclose(file);
+    std::remove(probe.c_str());
+
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        Track& track = g_tracks[i];
+        if (!track.samples) {
+            track.samples = std::make_unique<SpscRingBuffer<float>>(kRingSamples);
+            track.chunks = std::make_unique<SpscRingBuffer<RecordChunk>>(kRingChunks);
+        }
+        // Whatever a producer slipped in after the last stop
+        float discard[kWriteBlockSamples];
+        while (track.samples->Read(discard, kWriteBlockSamples) > 0) {
+        }
+        RecordChunk chunk;
+        while (track.chunks->Read(&chunk, 1) > 0) {
+        }
+        track.pending = RecordChunk{0, 0, 1, 0};
+        track.next_index = 0;
+        track.failed = false;
+        track.vad_rate = 0;
+        track.compacting = false;
+        track.resumed = false;
+        track.held.clear();
+        track.block.clear();
+        track.dropped.store(0, std::memory_order_relaxed);
+        track.producer.store(nullptr, std::memory_order_relaxed);
+    }
+
+    g_session.last_sync_ns = NowNs();
+    g_session.start_ns = g_session.last_sync_ns;
+    g_session.started_at_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    g_mix.mic_gain_db.store(options.mix.mic_gain_db, std::memory_order_relaxed);
+    g_mix.system_gain_db.store(options.mix.system_gain_db, std::memory_order_relaxed);
+    g_mix.stereo.store(options.mix.stereo, std::memory_order_relaxed);
+    g_mix.mic_pan.store(std::clamp(options.mix.mic_pan, -1.0f, 1.0f), std::memory_order_relaxed);
+    g_mix.system_pan.store(std::clamp(options.mix.system_pan, -1.0f, 1.0f), std::memory_order_relaxed);
+    g_mix.generation.fetch_add(1, std::memory_order_release);
+
+    g_session.running.store(true, std::memory_order_release);
+    g_session.writer = std::thread(&WriterLoop);
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        internal::g_record_tracks[i].store(g_session.options.tracks[i], std::memory_order_release);
+    }
+    Log(LogLevel::kInfo, kLogSource, "Recording to %s/%s.*%s", options.directory.c_str(), options.name.c_str(),
+        g_session.cipher ? ", encrypted" : "");
+    return true;
+}
+
+RecordingSummary StopRecording() {
+    std::lock_guard<std::mutex> control(g_session.control_mutex);
+    if (!g_session.writer.joinable()) {
+        return RecordingSummary();
+    }
+    for (auto& flag : internal::g_record_tracks) {
+        flag.store(false, std::memory_order_relaxed);
+    }
+    g_session.running.store(false, std::memory_order_release);
+    g_session.wake.Signal();
+    g_session.writer.join();
+
+    DrainAll(true);
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        Track& track = g_tracks[i];
+        if (!track.failed) {
+            CloseSilence(i);
+        }
+        CloseTrack(i);
+        if (track.index) {
+            std::fclose(track.index);
+            track.index = nullptr;
+        }
+        track.peaks.Close();
+    }
+
+    std::lock_guard<std::mutex> lock(g_session.summary_mutex);
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        g_session.summary.dropped_samples[i] = g_tracks[i].dropped.load(std::memory_order_relaxed);
+        if (g_session.summary.dropped_samples[i] > 0) {
+            Log(LogLevel::kWarn, kLogSource, "%llu %s sample(s) not recorded",
+                static_cast<unsigned long long>(g_session.summary.dropped_samples[i]), kTrackNames[i]);
+        }
+    }
+    Log(LogLevel::kInfo, kLogSource, "Recording stopped: %zu file(s)", g_session.summary.files.size());
+    return g_session.summary;
+}
+
+bool RecordingStatus(RecordingSummary* summary) {
+    std::lock_guard<std::mutex> control(g_session.control_mutex);
+    bool recording = g_session.writer.joinable();
+    std::lock_guard<std::mutex> lock(g_session.summary_mutex);
+    *summary = g_session.summary;
+    for (size_t i = 0; i < kRecordTrackCount; ++i) {
+        summary->dropped_samples[i] = g_tracks[i].dropped.load(std::memory_order_relaxed);
+    }
+    return recording;
+}
+
+uint64_t RecordingMixOptions(MixOptions* mix) {
+    uint64_t generation = g_mix.generation.load(std::memory_order_acquire);
+    mix->mic_gain_db = g_mix.mic_gain_db.load(std::memory_order_relaxed);
+    mix->system_gain_db = g_mix.system_gain_db.load(std::memory_order_relaxed);
+    mix->stereo = g_mix.stereo.load(std::memory_order_relaxed);
+    mix->mic_pan = g_mix.mic_pan.load(std::memory_order_relaxed);
+    mix->system_pan = g_mix.system_pan.load(std::memory_order_relaxed);
+    return generation;
+}
+
+void internal::RecordSamples(RecordTrack track, const void* producer, const float* data, uint32_t num_samples,
+                             int sample_rate, int num_channels) {
+    Track& ring = g_tracks[static_cast<size_t>(track)];
+    // The rings are single-producer: the first instance to deliver keeps them
+    const void* owner = ring.producer.load(std::memory_order_acquire);
+    if (owner != producer && (owner != nullptr || !ring.producer.compare_exchange_strong(owner, producer))) {
+        return;
+    }
+    // Both rings or neither; only this producer fills them, so space found
+    // here is still there for the writes
+    const size_t values = static_cast<size_t>(num_samples) * num_channels;
+    if (ring.samples->AvailableToWrite() < values || ring.chunks->AvailableToWrite() < 1) {
+        ring.dropped.fetch_add(num_samples, std::memory_order_relaxed);
+        return;
+    }
+    ring.samples->Write(data, values);
+    RecordChunk chunk{num_samples, sample_rate, num_channels, NowNs()};
+    ring.chunks->Write(&chunk, 1);
+}
+
+} // namespace kakarot
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// Streams the recorder can take, each into its own files
+enum class RecordTrack : uint8_t {
+    kMicrophone,  // the input device as captured, ahead of any AEC
+    kSystem,      // system audio (tap or loopback)
+    kProcessed,   // the native AEC pipeline's output
+    kMix,         // processed mic and system audio mixed into one, mono or stereo
+};
+constexpr size_t kRecordTrackCount = 4;
+
+const char* RecordTrackName(RecordTrack track);
+
+// How the mix track combines its sources. A pan runs from -1 (left) to 1
+// (right) and only places a source in a stereo mix.
+struct MixOptions {
+    float mic_gain_db = 0.0f;
+    float system_gain_db = 0.0f;
+    bool stereo = false;
+    float mic_pan = 0.0f;
+    float system_pan = 0.0f;
+};
+
+struct RecorderOptions {
+    std::string directory;           // must exist
+    std::string name = "recording";  // file prefix
+    bool tracks[kRecordTrackCount] = {true, true, true, false};
+    MixOptions mix;
+    bool float32 = false;            // 32-bit float WAV rather than 16-bit PCM
+    double sync_interval_ms = 1000.0;
+    double chunk_seconds = 600.0;    // start a new file after this (10s-3h)
+    double index_interval_ms = 1000.0;  // seek index granularity (100ms-10s)
+    // Silence that lasts longer than this is left out of the WAVs for an
+    // index marker (1s-60s); 0 stores every sample
+    double compact_silence_ms = 2000.0;
+    // Seal the samples with AES-256-GCM under SetRecordingKey()'s key
+    // (recording_crypto.h); the start fails when none is set
+    bool encrypt = false;
+};
+
+// One file the recorder finished (or is writing, for stats)
+struct RecordedFile {
+    RecordTrack track = RecordTrack::kMicrophone;
+    std::string path;
+    int sample_rate = 0;
+    int channels = 1;
+    uint64_t samples = 0;           // frames, for a stereo file
+};
+
+struct RecordingSummary {
+    std::vector<RecordedFile> files;
+    std::string indexes[kRecordTrackCount];  // a track's seek index; empty if it recorded nothing
+    uint64_t dropped_samples[kRecordTrackCount] = {};  // ring full, or a write failed
+    // A track's integrated loudness (LUFS, -70 for silence) and sample peak
+    // (dBFS) as of its last sync, as its index header has them
+    double loudness_lufs[kRecordTrackCount] = {};
+    double peak_dbfs[kRecordTrackCount] = {};
+    double compacted_ms[kRecordTrackCount] = {};  // silence left out of a track's WAVs
+};
+
+// Process-wide recorder of meeting audio, off by default. The capture
+// threads hand it samples without locks or allocation; a background thread
+// appends them to WAV files, patches each header and fsyncs every
+// sync_interval_ms, so a crash leaves valid files short of no more than that
+// and the ring. A track's files roll over every chunk_seconds and whenever
+// its rate or channel count changes (a device switch); names are <name>.<track>.<n>.wav.
+// Each track also gets <name>.<track>.idx, a seek index RecordingReader
+// opens without reading the WAVs, and a waveform pyramid beside it. The
+// writer thread meters each track's loudness as it goes (LoudnessMeter) and
+// keeps the reading in the index header. It also runs the VAD over each
+// track: once a silence (no speech, and quiet) outlasts compact_silence_ms,
+// the rest of it is not written, only marked in the index, and the last
+// few hundred ms before speech resumes are kept so onsets survive.
+// RecordingReader plays the runs back as silence or skips them. With
+// encrypt, the writer seals each WAV's samples a block at a time as they
+// fill and only sealed blocks count towards the synced length. A few
+// seconds of audio per track is all that is ever held in memory.
+// Start, stop and status are serialized, so any env's JS thread may call
+// them. Returns false (and logs) when already recording or a file will not
+// open.
+bool StartRecording(const RecorderOptions& options, std::string* error);
+
+// Writes what is buffered, closes every file and says what was written. A
+// no-op returning an empty summary when not recording.
+RecordingSummary StopRecording();
+
+// Files so far, with their current lengths.
+bool RecordingStatus(RecordingSummary* summary);
+
+namespace internal {
+extern std::atomic<bool> g_record_tracks[kRecordTrackCount];
+void RecordSamples(RecordTrack track, const void* producer, const float* data, uint32_t num_samples,
+                   int sample_rate, int num_channels);
+}
+
+// Capture threads: memcpy + atomic publish when the track is recording, a
+// single load when it is not. A track takes one |producer| (the capture
+// instance) per recording, the first to deliver; with the addon loaded in
+// several envs, the others' audio for that track is ignored. |data| is
+// |num_samples| frames of |num_channels| interleaved.
+inline void RecordSamples(RecordTrack track, const void* producer, const float* data, uint32_t num_samples,
+                          int sample_rate, int num_channels = 1) {
+    if (internal::g_record_tracks[static_cast<size_t>(track)].load(std::memory_order_acquire)) {
+        internal::RecordSamples(track, producer, data, num_samples, sample_rate, num_channels);
+    }
+}
+
+inline bool IsRecordingTrack(RecordTrack track) {
+    return internal::g_record_tracks[static_cast<size_t>(track)].load(std::memory_order_acquire);
+}
+
+// Capture threads, without locks: the current recording's mix settings, and
+// a number that moves with each recording started so a mixer picks them up
+// once rather than per buffer
+uint64_t RecordingMixOptions(MixOptions* mix);
+
+} // namespace kakarot
@@ -0,0 +1,165 @@
+#include "memory_pressure.h"
+#include "native_log.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#endif
+
+namespace kakarot {
+
+static const char* const kLogSource = "MemoryPressure";
+
+namespace {
+
+struct Component {
+    std::string name;
+    MemoryComponent::SizeFn size;
+    MemoryComponent::ChangeFn on_change;
+};
+
+// Components are told of changes with the mutex held, so unregistering
+// waits out a notification in progress
+struct Registry {
+    std::mutex mutex;
+    std::map<uint64_t, Component> components;
+    uint64_t next_id = 1;
+    MemoryMinimums minimums;
+};
+
+Registry& GetRegistry() {
+    static Registry* registry = new Registry();  // never destroyed: components may outlive statics
+    return *registry;
+}
+
+} // namespace
+
+static std::atomic<int> g_pressure{static_cast<int>(MemoryPressure::kNormal)};
+static std::atomic<uint64_t> g_epoch{0};
+
+static const char* PressureName(MemoryPressure pressure) {
+    switch (pressure) {
+        case MemoryPressure::kWarning: return "warning";
+        case MemoryPressure::kCritical: return "critical";
+        default: return "normal";
+    }
+}
+
+MemoryPressure CurrentMemoryPressure() {
+    return static_cast<MemoryPressure>(g_pressure.load(std::memory_order_relaxed));
+}
+
+MemoryMinimums GetMemoryMinimums() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.minimums;
+}
+
+void SetMemoryMinimums(const MemoryMinimums& minimums) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.minimums = minimums;
+}
+
+uint64_t MemoryPressureEpoch() {
+    return g_epoch.load(std::memory_order_acquire);
+}
+
+MemoryComponent::MemoryComponent(std::string name, SizeFn size, ChangeFn on_change) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    id_ = registry.next_id++;
+    registry.components[id_] = Component{std::move(name), std::move(size), std::move(on_change)};
+}
+
+MemoryComponent::~MemoryComponent() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.components.erase(id_);
+}
+
+std::vector<MemoryUsage> MemoryComponentUsage() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<MemoryUsage> usage;
+    usage.reserve(registry.components.size());
+    for (const auto& entry : registry.components) {
+        usage.push_back(MemoryUsage{entry.second.name, entry.second.size ? entry.second.size() : 0});
+    }
+    return usage;
+}
+
+void SetMemoryPressure(MemoryPressure pressure) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    MemoryPressure previous =
+        static_cast<MemoryPressure>(g_pressure.exchange(static_cast<int>(pressure), std::memory_order_relaxed));
+    if (previous == pressure) {
+        return;
+    }
+    if (pressure > previous) {
+        g_epoch.fetch_add(1, std::memory_order_release);
+    }
+    Log(LogLevel::kInfo, kLogSource, "Memory pressure %s -> %s", PressureName(previous), PressureName(pressure));
+    for (auto& entry : registry.components) {
+        if (entry.second.on_change) {
+            entry.second.on_change(pressure, registry.minimums);
+        }
+    }
+}
+
+#if defined(__APPLE__)
+
+static std::mutex g_monitor_mutex;
+static dispatch_queue_t g_monitor_queue = nullptr;
+static dispatch_source_t g_monitor_source = nullptr;
+
+static void MemoryPressureChanged(void* context) {
+    unsigned long level = dispatch_source_get_data(static_cast<dispatch_source_t>(context));
+    if (level & DISPATCH_MEMORYPRESSURE_CRITICAL) {
+        SetMemoryPressure(MemoryPressure::kCritical);
+    } else if (level & DISPATCH_MEMORYPRESSURE_WARN) {
+        SetMemoryPressure(MemoryPressure::kWarning);
+    } else {
+        SetMemoryPressure(MemoryPressure::kNormal);
+    }
+}
+
+void StartMemoryPressureMonitor() {
+    std::lock_guard<std::mutex> lock(g_monitor_mutex);
+    if (g_monitor_source) {
+        return;
+    }
+    g_monitor_queue = dispatch_queue_create("kakarot.memory", DISPATCH_QUEUE_SERIAL);
+    g_monitor_source = dispatch_source_create(
+        DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+        DISPATCH_MEMORYPRESSURE_NORMAL | DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+        g_monitor_queue);
+    dispatch_set_context(g_monitor_source, g_monitor_source);
+    dispatch_source_set_event_handler_f(g_monitor_source, &MemoryPressureChanged);
+    dispatch_resume(g_monitor_source);
+}
+
+void StopMemoryPressureMonitor() {
+    std::lock_guard<std::mutex> lock(g_monitor_mutex);
+    if (!g_monitor_source) {
+        return;
+    }
+    dispatch_source_cancel(g_monitor_source);
+    // Waits out a handler already running
+    dispatch_sync_f(g_monitor_queue, nullptr, [](void*) {});
+    dispatch_release(g_monitor_source);
+    dispatch_release(g_monitor_queue);
+    g_monitor_source = nullptr;
+    g_monitor_queue = nullptr;
+}
+
+#else
+
+void StartMemoryPressureMonitor() {}
+void StopMemoryPressureMonitor() {}
+
+#endif
+
+} // namespace kakarot
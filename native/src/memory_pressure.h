@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// The system's memory pressure, as macOS reports it
+enum class MemoryPressure { kNormal, kWarning, kCritical };
+
+// What components shrink to under pressure
+struct MemoryMinimums {
+    size_t idle_slabs = 1;       // free slabs a capture stream's pool keeps, beyond those on loan
+    double preroll_ms = 100.0;   // gate pre-roll of a stream opened under pressure
+};
+
+// Any thread
+MemoryPressure CurrentMemoryPressure();
+MemoryMinimums GetMemoryMinimums();
+void SetMemoryMinimums(const MemoryMinimums& minimums);
+
+// Bumped each time pressure rises: caches used from one thread only (the
+// JS thread's) drop their contents when they see it move, rather than being
+// reached into from the notification's thread
+uint64_t MemoryPressureEpoch();
+
+// A component's resident bytes, and what it does as pressure changes, for
+// as long as the object lives. |size| is called by MemoryComponentUsage() on its
+// caller's thread; |on_change| (may be empty) on whichever
+// thread the level changed on, and no call runs after the destructor
+// returns. Neither may call back into this file.
+class MemoryComponent {
+public:
+    using SizeFn = std::function<uint64_t()>;
+    using ChangeFn = std::function<void(MemoryPressure pressure, const MemoryMinimums& minimums)>;
+
+    MemoryComponent(std::string name, SizeFn size, ChangeFn on_change = ChangeFn());
+    ~MemoryComponent();
+
+    MemoryComponent(const MemoryComponent&) = delete;
+    MemoryComponent& operator=(const MemoryComponent&) = delete;
+
+private:
+    uint64_t id_;
+};
+
+struct MemoryUsage {
+    std::string name;
+    uint64_t bytes;
+};
+std::vector<MemoryUsage> MemoryComponentUsage();
+
+// Sets the level and tells every component of a change, on the calling
+// thread. The monitor calls it; so can anything else that learns of it.
+void SetMemoryPressure(MemoryPressure pressure);
+
+// Process-wide. On macOS a DISPATCH_SOURCE_TYPE_MEMORYPRESSURE source on a
+// private queue; elsewhere nothing (the level stays where SetMemoryPressure()
+// puts it). Stop returns once no notification is running.
+void StartMemoryPressureMonitor();
+void StopMemoryPressureMonitor();
+
+} // namespace kakarot
@@ -0,0 +1,111 @@
+#include "native_log.h"
+#include "platform_thread.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace kakarot {
+
+// Enough for a burst of setup messages before anything drains
+static constexpr size_t kLogRingCapacity = 256;
+
+static size_t RoundUpPow2(size_t value) {
+    size_t capacity = 1;
+    while (capacity < value) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+LogRing::LogRing(size_t min_capacity)
+    : mask_(RoundUpPow2(min_capacity) - 1),
+      slots_(new Slot[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+// A slot is free for position p when its sequence is p, and holds a record
+// for the consumer when it is p + 1
+bool LogRing::Write(LogLevel level, const char* source, const char* format, va_list args) {
+    size_t pos = write_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &slots_[pos & mask_];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (write_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = write_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    LogRecord& record = slot->record;
+    record.time_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record.level = level;
+    std::strncpy(record.source, source, LogRecord::kSourceSize - 1);
+    record.source[LogRecord::kSourceSize - 1] = '\0';
+    std::vsnprintf(record.message, LogRecord::kMessageSize, format, args);
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    if (IdleSignal* wake = wake_.load(std::memory_order_acquire)) {
+        wake->Notify();
+    }
+    return true;
+}
+
+size_t LogRing::Read(LogRecord* out, size_t max) {
+    size_t count = 0;
+    while (count < max) {
+        Slot& slot = slots_[read_pos_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != read_pos_ + 1) {
+            break;  // empty, or the producer is still formatting
+        }
+        out[count++] = slot.record;
+        slot.sequence.store(read_pos_ + mask_ + 1, std::memory_order_release);
+        ++read_pos_;
+    }
+    return count;
+}
+
+// A record still being formatted reads as empty; its Write() notifies once
+// it lands
+bool LogRing::Empty() const {
+    return slots_[read_pos_ & mask_].sequence.load(std::memory_order_acquire) != read_pos_ + 1;
+}
+
+// Constructed at load, so no thread ever pays for (or locks on) first use
+static LogRing g_log_ring(kLogRingCapacity);
+
+LogRing& NativeLogRing() {
+    return g_log_ring;
+}
+
+static std::atomic<LogLevel> g_log_level{LogLevel::kInfo};
+
+void SetLogLevel(LogLevel level) {
+    g_log_level.store(level, std::memory_order_relaxed);
+}
+
+LogLevel GetLogLevel() {
+    return g_log_level.load(std::memory_order_relaxed);
+}
+
+void Log(LogLevel level, const char* source, const char* format, ...) {
+    if (level < g_log_level.load(std::memory_order_relaxed)) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    NativeLogRing().Write(level, source, format, args);
+    va_end(args);
+}
+
+} // namespace kakarot
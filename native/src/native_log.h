@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace kakarot {
+
+class IdleSignal;
+
+// Ordered as the JS logger's levels (debug 0 ... error 3)
+enum class LogLevel : uint8_t { kDebug = 0, kInfo = 1, kWarn = 2, kError = 3, kOff = 4 };
+
+// One fixed-size log entry; longer messages are truncated
+struct LogRecord {
+    static constexpr size_t kSourceSize = 24;
+    static constexpr size_t kMessageSize = 216;
+
+    double time_ms;  // Date.now() domain
+    LogLevel level;
+    char source[kSourceSize];
+    char message[kMessageSize];
+};
+
+// Bounded lock-free multi-producer/single-consumer ring of LogRecords
+// (sequence-numbered slots). Producers - the IOProc, the DSP and consumer
+// threads, HAL notifications, JS - claim a slot with one CAS and format into
+// it in place: no locks, no allocation, no I/O. A full ring drops the record
+// and counts it. One consumer drains.
+class LogRing {
+public:
+    explicit LogRing(size_t min_capacity);
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // Any thread. Returns false (and counts a drop) when the ring is full.
+    bool Write(LogLevel level, const char* source, const char* format, va_list args);
+
+    // Consumer thread. Copies out up to |max| records, oldest first.
+    size_t Read(LogRecord* out, size_t max);
+    // Consumer thread. True when nothing is ready to Read()
+    bool Empty() const;
+
+    // Notified after each record written, so the consumer can park while
+    // the ring is empty; it must outlive every writer. Null for none.
+    void SetWake(IdleSignal* wake) { wake_.store(wake, std::memory_order_release); }
+
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<size_t> write_pos_{0};
+    size_t read_pos_ = 0;  // consumer only
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<IdleSignal*> wake_{nullptr};
+};
+
+// Process-wide ring the addon drains into the JS logger
+LogRing& NativeLogRing();
+
+// Records below this level are discarded before formatting (default info)
+void SetLogLevel(LogLevel level);
+LogLevel GetLogLevel();
+
+// Realtime-safe as long as the format sticks to integers and strings
+// (floating-point conversions may allocate in libc)
+void Log(LogLevel level, const char* source, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+} // namespace kakarot
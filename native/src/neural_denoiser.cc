@@ -0,0 +1,270 @@
+#include "neural_denoiser.h"
+#include "dsp_kernels.h"
+#include "modules/audio_processing/agc2/cpu_features.h"
+#include "modules/audio_processing/agc2/rnn_vad/rnn_fc.h"
+#include "modules/audio_processing/agc2/rnn_vad/rnn_gru.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace kakarot {
+
+using webrtc::rnn_vad::ActivationFunction;
+using webrtc::rnn_vad::FullyConnectedLayer;
+using webrtc::rnn_vad::GatedRecurrentLayer;
+
+static constexpr size_t kWindowSize = 2 * NeuralDenoiser::kFrameSize;
+static constexpr size_t kBins = NeuralDenoiser::kFrameSize + 1;
+static constexpr int kUnits = 24;
+static constexpr uint32_t kModelVersion = 1;
+
+// Band edges in 200Hz steps (4 bins of the 960-point transform), Opus's 5ms layout
+static constexpr int kBandEdges[NeuralDenoiser::kBands] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 34, 40, 48, 60, 78, 100};
+static constexpr int kBinsPerStep = 4;
+
+// Differences taken of the first cepstral coefficients only
+static constexpr int kDeltas = 6;
+
+// A gain falls to at most this fraction of last frame's
+static constexpr float kGainFall = 0.6f;
+
+// Features are taken on int16-scaled samples, as the network was trained
+static constexpr float kInt16Scale = 32768.0f;
+
+static bool ReadLayer(std::ifstream& in, bool recurrent, int input_size, int output_size,
+                      DenoiserModel::Layer* layer, const char* name, std::string* error) {
+    uint32_t sizes[2] = {0, 0};
+    in.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+    if (!in || static_cast<int>(sizes[0]) != input_size || static_cast<int>(sizes[1]) != output_size) {
+        *error = std::string("denoise model: ") + name + " is not " + std::to_string(input_size) + " -> " +
+                 std::to_string(output_size);
+        return false;
+    }
+    const size_t gates = recurrent ? 3 : 1;
+    layer->input_size = input_size;
+    layer->output_size = output_size;
+    layer->bias.resize(gates * output_size);
+    layer->weights.resize(gates * input_size * output_size);
+    layer->recurrent_weights.resize(recurrent ? gates * output_size * output_size : 0);
+    for (std::vector<int8_t>* part : {&layer->bias, &layer->weights, &layer->recurrent_weights}) {
+        in.read(reinterpret_cast<char*>(part->data()), static_cast<std::streamsize>(part->size()));
+    }
+    if (!in) {
+        *error = std::string("denoise model: ") + name + " is truncated";
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const DenoiserModel> DenoiserModel::Load(const std::string& path, std::string* error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        *error = "cannot open " + path;
+        return nullptr;
+    }
+    char magic[4] = {};
+    uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!in || std::memcmp(magic, "KKDN", 4) != 0 || version != kModelVersion) {
+        *error = path + " is not a version 1 denoise model";
+        return nullptr;
+    }
+
+    const int features = NeuralDenoiser::kFeatures;
+    auto model = std::make_shared<DenoiserModel>();
+    if (!ReadLayer(in, false, features, kUnits, &model->input_dense, "input_dense", error) ||
+        !ReadLayer(in, true, kUnits, kUnits, &model->vad_gru, "vad_gru", error) ||
+        !ReadLayer(in, false, kUnits, 1, &model->vad_output, "vad_output", error) ||
+        !ReadLayer(in, true, 2 * kUnits + features, kUnits, &model->noise_gru, "noise_gru", error) ||
+        !ReadLayer(in, true, 2 * kUnits + features, kUnits, &model->denoise_gru, "denoise_gru", error) ||
+        !ReadLayer(in, false, kUnits, NeuralDenoiser::kBands, &model->denoise_output, "denoise_output", error)) {
+        return nullptr;
+    }
+    return model;
+}
+
+static std::unique_ptr<FullyConnectedLayer> MakeDense(const DenoiserModel::Layer& layer,
+                                                      ActivationFunction activation, const char* name) {
+    return std::make_unique<FullyConnectedLayer>(layer.input_size, layer.output_size, layer.bias, layer.weights,
+                                                 activation, webrtc::GetAvailableCpuFeatures(), name);
+}
+
+static std::unique_ptr<GatedRecurrentLayer> MakeGru(const DenoiserModel::Layer& layer, const char* name) {
+    return std::make_unique<GatedRecurrentLayer>(layer.input_size, layer.output_size, layer.bias, layer.weights,
+                                                 layer.recurrent_weights, webrtc::GetAvailableCpuFeatures(), name);
+}
+
+NeuralDenoiser::NeuralDenoiser(std::shared_ptr<const DenoiserModel> model)
+    : model_(std::move(model)),
+      input_dense_(MakeDense(model_->input_dense, ActivationFunction::kTansigApproximated, "input_dense")),
+      vad_gru_(MakeGru(model_->vad_gru, "vad_gru")),
+      vad_output_(MakeDense(model_->vad_output, ActivationFunction::kSigmoidApproximated, "vad_output")),
+      noise_gru_(MakeGru(model_->noise_gru, "noise_gru")),
+      denoise_gru_(MakeGru(model_->denoise_gru, "denoise_gru")),
+      denoise_output_(MakeDense(model_->denoise_output, ActivationFunction::kSigmoidApproximated, "denoise_output")),
+      fft_(std::make_unique<webrtc::Pffft>(kWindowSize, webrtc::Pffft::FftType::kReal)),
+      fft_in_(fft_->CreateBuffer()),
+      fft_out_(fft_->CreateBuffer()),
+      window_(kWindowSize),
+      dct_(kBands * kBands),
+      analysis_(kWindowSize, 0.0f),
+      overlap_(kFrameSize, 0.0f),
+      cepstrum_(3 * kBands, 0.0f),
+      layer_input_(2 * kUnits + kFeatures, 0.0f),
+      gains_(kBands, 1.0f),
+      power_(kBins, 0.0f),
+      bin_gains_(kBins, 1.0f),
+      pending_(kFrameSize, 0.0f),
+      ready_(kFrameSize, 0.0f) {
+    // Vorbis: power-complementary, so analysis and synthesis with it overlap-add to one
+    const double pi = std::acos(-1.0);
+    for (size_t i = 0; i < kFrameSize; ++i) {
+        double s = std::sin(0.5 * pi * (i + 0.5) / kFrameSize);
+        window_[i] = static_cast<float>(std::sin(0.5 * pi * s * s));
+        window_[kWindowSize - 1 - i] = window_[i];
+    }
+    for (int i = 0; i < kBands; ++i) {
+        for (int j = 0; j < kBands; ++j) {
+            double scale = std::sqrt((i == 0 ? 1.0 : 2.0) / kBands);
+            dct_[i * kBands + j] = static_cast<float>(scale * std::cos((j + 0.5) * i * pi / kBands));
+        }
+    }
+}
+
+NeuralDenoiser::~NeuralDenoiser() = default;
+
+void NeuralDenoiser::Reset() {
+    vad_gru_->Reset();
+    noise_gru_->Reset();
+    denoise_gru_->Reset();
+    std::fill(analysis_.begin(), analysis_.end(), 0.0f);
+    std::fill(overlap_.begin(), overlap_.end(), 0.0f);
+    std::fill(cepstrum_.begin(), cepstrum_.end(), 0.0f);
+    std::fill(gains_.begin(), gains_.end(), 1.0f);
+    std::fill(pending_.begin(), pending_.end(), 0.0f);
+    std::fill(ready_.begin(), ready_.end(), 0.0f);
+    fill_ = 0;
+    speech_probability_ = 0.0f;
+}
+
+// Band energies with triangular bands, each bin shared between its two
+// nearest band centres, then log, DCT and the network
+void NeuralDenoiser::ComputeGains(const float* power, float* band_gains) {
+    float energy[kBands] = {};
+    for (int b = 0; b + 1 < kBands; ++b) {
+        const int first = kBandEdges[b] * kBinsPerStep;
+        const int width = (kBandEdges[b + 1] - kBandEdges[b]) * kBinsPerStep;
+        for (int j = 0; j < width; ++j) {
+            const float frac = static_cast<float>(j) / width;
+            energy[b] += (1.0f - frac) * power[first + j];
+            energy[b + 1] += frac * power[first + j];
+        }
+    }
+    energy[0] *= 2.0f;
+    energy[kBands - 1] *= 2.0f;
+
+    float log_energy[kBands];
+    for (int b = 0; b < kBands; ++b) {
+        log_energy[b] = std::log10(1e-2f + energy[b]);
+    }
+    std::memmove(cepstrum_.data() + kBands, cepstrum_.data(), 2 * kBands * sizeof(float));
+    float* now = cepstrum_.data();
+    for (int i = 0; i < kBands; ++i) {
+        float sum = 0.0f;
+        for (int j = 0; j < kBands; ++j) {
+            sum += dct_[i * kBands + j] * log_energy[j];
+        }
+        now[i] = sum;
+    }
+    now[0] -= 12.0f;
+    now[1] -= 4.0f;
+
+    // [input_dense or vad_gru | vad_gru or noise_gru | features]
+    float* features = layer_input_.data() + 2 * kUnits;
+    const float* before = cepstrum_.data() + kBands;
+    const float* earliest = cepstrum_.data() + 2 * kBands;
+    std::copy(now, now + kBands, features);
+    for (int i = 0; i < kDeltas; ++i) {
+        features[kBands + i] = now[i] - earliest[i];
+        features[kBands + kDeltas + i] = now[i] - 2.0f * before[i] + earliest[i];
+    }
+
+    input_dense_->ComputeOutput({features, static_cast<size_t>(kFeatures)});
+    vad_gru_->ComputeOutput({input_dense_->data(), static_cast<size_t>(kUnits)});
+    vad_output_->ComputeOutput({vad_gru_->data(), static_cast<size_t>(kUnits)});
+    speech_probability_ = vad_output_->data()[0];
+
+    std::copy(input_dense_->data(), input_dense_->data() + kUnits, layer_input_.begin());
+    std::copy(vad_gru_->data(), vad_gru_->data() + kUnits, layer_input_.begin() + kUnits);
+    noise_gru_->ComputeOutput(layer_input_);
+    std::copy(vad_gru_->data(), vad_gru_->data() + kUnits, layer_input_.begin());
+    std::copy(noise_gru_->data(), noise_gru_->data() + kUnits, layer_input_.begin() + kUnits);
+    denoise_gru_->ComputeOutput(layer_input_);
+    denoise_output_->ComputeOutput({denoise_gru_->data(), static_cast<size_t>(kUnits)});
+
+    for (int b = 0; b < kBands; ++b) {
+        band_gains[b] = std::max(denoise_output_->data()[b], kGainFall * gains_[b]);
+        gains_[b] = band_gains[b];
+    }
+}
+
+float NeuralDenoiser::ProcessFrame(float* frame) {
+    std::memmove(analysis_.data(), analysis_.data() + kFrameSize, kFrameSize * sizeof(float));
+    std::memcpy(analysis_.data() + kFrameSize, frame, kFrameSize * sizeof(float));
+
+    // pffft is unnormalized; the 1/N goes on the way in, as RNNoise scales
+    float* in = fft_in_->GetView().data();
+    const float scale = kInt16Scale / kWindowSize;
+    for (size_t i = 0; i < kWindowSize; ++i) {
+        in[i] = analysis_[i] * window_[i] * scale;
+    }
+    fft_->ForwardTransform(*fft_in_, fft_out_.get(), true);
+
+    float* spectrum = fft_out_->GetView().data();
+    dsp::OrderedPower(spectrum, kWindowSize, power_.data());
+    float band_gains[kBands];
+    ComputeGains(power_.data(), band_gains);
+
+    // Per bin, linear between band edges; above the last edge, the last band's
+    for (int b = 0; b + 1 < kBands; ++b) {
+        const int first = kBandEdges[b] * kBinsPerStep;
+        const int width = (kBandEdges[b + 1] - kBandEdges[b]) * kBinsPerStep;
+        for (int j = 0; j < width; ++j) {
+            const float frac = static_cast<float>(j) / width;
+            bin_gains_[first + j] = (1.0f - frac) * band_gains[b] + frac * band_gains[b + 1];
+        }
+    }
+    std::fill(bin_gains_.begin() + kBandEdges[kBands - 1] * kBinsPerStep, bin_gains_.end(), band_gains[kBands - 1]);
+
+    dsp::ScaleOrdered(bin_gains_.data(), kWindowSize, spectrum);
+    fft_->BackwardTransform(*fft_out_, fft_in_.get(), true);
+
+    const float* time = fft_in_->GetConstView().data();
+    const float unscale = 1.0f / kInt16Scale;
+    for (size_t i = 0; i < kFrameSize; ++i) {
+        frame[i] = overlap_[i] + time[i] * window_[i] * unscale;
+        overlap_[i] = time[kFrameSize + i] * window_[kFrameSize + i] * unscale;
+    }
+    return speech_probability_;
+}
+
+void NeuralDenoiser::Process(float* data, size_t num_samples) {
+    size_t done = 0;
+    while (done < num_samples) {
+        size_t count = std::min(kFrameSize - fill_, num_samples - done);
+        std::memcpy(pending_.data() + fill_, data + done, count * sizeof(float));
+        std::memcpy(data + done, ready_.data() + fill_, count * sizeof(float));
+        fill_ += count;
+        done += count;
+        if (fill_ == kFrameSize) {
+            ProcessFrame(pending_.data());
+            pending_.swap(ready_);
+            fill_ = 0;
+        }
+    }
+}
+
+} // namespace kakarot
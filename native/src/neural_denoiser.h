@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "modules/audio_processing/utility/pffft_wrapper.h"
+
+namespace webrtc {
+namespace rnn_vad {
+class FullyConnectedLayer;
+class GatedRecurrentLayer;
+}
+}
+
+namespace kakarot {
+
+// Weights of an RNNoise-class denoiser, loaded once and shared by every
+// NeuralDenoiser built from them. The layers are webrtc's rnn_vad ones, 24
+// units at most, so the network is RNNoise's with its wider GRUs narrowed:
+//
+//   input_dense     FC  34 -> 24, tanh     features
+//   vad_gru         GRU 24 -> 24           input_dense
+//   vad_output      FC  24 -> 1, sigmoid   vad_gru
+//   noise_gru       GRU 82 -> 24           input_dense, vad_gru, features
+//   denoise_gru     GRU 82 -> 24           vad_gru, noise_gru, features
+//   denoise_output  FC  24 -> 22, sigmoid  denoise_gru; the band gains
+//
+// The file is "KKDN", a little-endian uint32 version (1), then each layer
+// in that order as uint32 input and output sizes followed by its int8
+// bias, weights and, for a GRU, recurrent weights, in the rnn_vad layouts
+// (what RNNoise's dump_rnn.py writes, scaled by 256).
+struct DenoiserModel {
+    struct Layer {
+        int input_size = 0;
+        int output_size = 0;
+        std::vector<int8_t> bias;
+        std::vector<int8_t> weights;
+        std::vector<int8_t> recurrent_weights;  // GRU only
+    };
+    Layer input_dense, vad_gru, vad_output, noise_gru, denoise_gru, denoise_output;
+
+    // Null with |error| set when the file is missing or another shape
+    static std::shared_ptr<const DenoiserModel> Load(const std::string& path, std::string* error);
+};
+
+// Spectral-gain neural noise suppression at 48kHz, one 10ms frame at a
+// time, as RNNoise does it: a 20ms Vorbis-windowed STFT with 50% overlap,
+// 22 triangular bands on the Opus layout, and per band a gain the network
+// infers from the bands' cepstrum and its first and second differences.
+// Gains are interpolated across bins and fall at most 40% a frame, which
+// keeps musical noise down. Babble and fan noise that WebRTC NS leaves in go
+// with it; the cost is the network's matrix-vector products, which run on
+// the rnn_vad layers' SSE2/AVX2/NEON kernels.
+//
+// Real-time safe after construction. Not thread-safe.
+class NeuralDenoiser {
+public:
+    static constexpr int kSampleRate = 48000;
+    static constexpr size_t kFrameSize = 480;
+    static constexpr int kBands = 22;
+    static constexpr int kFeatures = 34;
+
+    explicit NeuralDenoiser(std::shared_ptr<const DenoiserModel> model);
+    ~NeuralDenoiser();
+
+    NeuralDenoiser(const NeuralDenoiser&) = delete;
+    NeuralDenoiser& operator=(const NeuralDenoiser&) = delete;
+
+    // kFrameSize samples in place; the output trails the input by one
+    // frame (the overlap). Returns the network's speech probability.
+    float ProcessFrame(float* frame);
+
+    // Any number of samples, in place, through an internal frame: the output
+    // trails the input by 2 * kFrameSize
+    void Process(float* data, size_t num_samples);
+
+    void Reset();
+
+private:
+    void ComputeGains(const float* power, float* band_gains);
+
+    std::shared_ptr<const DenoiserModel> model_;
+    std::unique_ptr<webrtc::rnn_vad::FullyConnectedLayer> input_dense_;
+    std::unique_ptr<webrtc::rnn_vad::GatedRecurrentLayer> vad_gru_;
+    std::unique_ptr<webrtc::rnn_vad::FullyConnectedLayer> vad_output_;
+    std::unique_ptr<webrtc::rnn_vad::GatedRecurrentLayer> noise_gru_;
+    std::unique_ptr<webrtc::rnn_vad::GatedRecurrentLayer> denoise_gru_;
+    std::unique_ptr<webrtc::rnn_vad::FullyConnectedLayer> denoise_output_;
+
+    std::unique_ptr<webrtc::Pffft> fft_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_in_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_out_;
+    std::vector<float> window_;     // 2 * kFrameSize
+    std::vector<float> dct_;        // kBands x kBands, orthonormal DCT-II
+    std::vector<float> analysis_;   // the previous frame, then this one
+    std::vector<float> overlap_;    // synthesis tail carried to the next frame
+    std::vector<float> cepstrum_;   // kBands per frame: this one and the two before
+    std::vector<float> layer_input_;
+    std::vector<float> gains_;      // per band, last frame's
+    std::vector<float> power_;      // this frame's, DC to Nyquist
+    std::vector<float> bin_gains_;
+    float speech_probability_ = 0.0f;
+
+    // Process(): one frame in, the previous one out
+    std::vector<float> pending_;
+    std::vector<float> ready_;
+    size_t fill_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,181 @@
+#include "nlms_echo_canceller.h"
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cstring>
+
+namespace kakarot {
+
+// Normalized step; divided across the partitions
+static constexpr float kStepSize = 0.5f;
+
+// Smoothing of the per-bin render power used for normalization
+static constexpr float kPowerSmoothing = 0.1f;
+
+// Per-sample mean square below which render counts as silent (about -70 dBFS);
+// the filter does not adapt on silence
+static constexpr float kMinRenderPower = 1e-7f;
+
+// Regularization of the normalization, as a per-sample power (-60 dBFS)
+static constexpr float kRegularizationPower = 1e-6f;
+
+// Output this much louder than the input means the filter has diverged
+static constexpr float kDivergenceRatio = 4.0f;
+
+bool NlmsEchoCanceller::Supported(size_t block_size) {
+    return block_size > 0 && webrtc::Pffft::IsValidFftSize(2 * block_size, webrtc::Pffft::FftType::kReal);
+}
+
+NlmsEchoCanceller::NlmsEchoCanceller(size_t block_size, size_t num_partitions, size_t max_delay_blocks)
+    : block_size_(block_size),
+      fft_size_(2 * block_size),
+      num_bins_(block_size + 1),
+      num_partitions_(num_partitions),
+      max_delay_blocks_(max_delay_blocks),
+      fft_(std::make_unique<webrtc::Pffft>(fft_size_, webrtc::Pffft::FftType::kReal)),
+      fft_in_(fft_->CreateBuffer()),
+      fft_out_(fft_->CreateBuffer()),
+      time_(fft_size_),
+      render_history_(max_delay_blocks + num_partitions),
+      render_energy_(max_delay_blocks + num_partitions),
+      render_prev_(block_size),
+      render_power_(num_bins_),
+      filter_(num_partitions),
+      gain_(num_bins_) {
+    auto allocate = [this](Spectrum* spectrum) {
+        spectrum->re.assign(num_bins_, 0.0f);
+        spectrum->im.assign(num_bins_, 0.0f);
+    };
+    for (Spectrum& spectrum : render_history_) allocate(&spectrum);
+    for (Spectrum& spectrum : filter_) allocate(&spectrum);
+    allocate(&echo_);
+    allocate(&error_);
+    Reset();
+}
+
+NlmsEchoCanceller::~NlmsEchoCanceller() = default;
+
+void NlmsEchoCanceller::Reset() {
+    for (Spectrum& spectrum : filter_) {
+        std::fill(spectrum.re.begin(), spectrum.re.end(), 0.0f);
+        std::fill(spectrum.im.begin(), spectrum.im.end(), 0.0f);
+    }
+    constrain_next_ = 0;
+}
+
+void NlmsEchoCanceller::SetDelayBlocks(size_t delay_blocks) {
+    delay_blocks_ = std::min(delay_blocks, max_delay_blocks_);
+}
+
+void NlmsEchoCanceller::Forward(const float* time, Spectrum* spectrum) {
+    float* in = fft_in_->GetView().data();
+    std::memcpy(in, time, fft_size_ * sizeof(float));
+    fft_->ForwardTransform(*fft_in_, fft_out_.get(), true);
+    dsp::UnpackOrdered(fft_out_->GetConstView().data(), fft_size_, spectrum->re.data(), spectrum->im.data());
+}
+
+// Inverse of Forward(), scaled so Backward(Forward(x)) == x
+void NlmsEchoCanceller::Backward(const Spectrum& spectrum, float* time) {
+    dsp::PackOrdered(spectrum.re.data(), spectrum.im.data(), fft_size_, fft_in_->GetView().data());
+    fft_->BackwardTransform(*fft_in_, fft_out_.get(), true);
+
+    const float* out = fft_out_->GetConstView().data();
+    const float scale = 1.0f / fft_size_;
+    for (size_t i = 0; i < fft_size_; ++i) {
+        time[i] = out[i] * scale;
+    }
+}
+
+const NlmsEchoCanceller::Spectrum& NlmsEchoCanceller::RenderSpectrum(size_t blocks_back) const {
+    size_t size = render_history_.size();
+    return render_history_[(render_head_ + size - blocks_back) % size];
+}
+
+void NlmsEchoCanceller::AnalyzeRender(const float* block) {
+    // Overlap-save: each spectrum covers the previous block and this one
+    std::memcpy(time_.data(), render_prev_.data(), block_size_ * sizeof(float));
+    std::memcpy(time_.data() + block_size_, block, block_size_ * sizeof(float));
+    std::memcpy(render_prev_.data(), block, block_size_ * sizeof(float));
+
+    render_head_ = (render_head_ + 1) % render_history_.size();
+    Spectrum& spectrum = render_history_[render_head_];
+    Forward(time_.data(), &spectrum);
+
+    float sum_squares = 0.0f;
+    float peak = 0.0f;
+    dsp::SumSquaresAndPeak(block, block_size_, &sum_squares, &peak);
+    render_energy_[render_head_] = sum_squares / block_size_;
+
+    for (size_t k = 0; k < num_bins_; ++k) {
+        float power = spectrum.re[k] * spectrum.re[k] + spectrum.im[k] * spectrum.im[k];
+        render_power_[k] += kPowerSmoothing * (power - render_power_[k]);
+    }
+}
+
+void NlmsEchoCanceller::ProcessCapture(const float* input, float* output) {
+    // Echo estimate: the filter applied to the delayed render partitions
+    std::fill(echo_.re.begin(), echo_.re.end(), 0.0f);
+    std::fill(echo_.im.begin(), echo_.im.end(), 0.0f);
+    float span_energy = 0.0f;
+    for (size_t p = 0; p < num_partitions_; ++p) {
+        const Spectrum& render = RenderSpectrum(delay_blocks_ + p);
+        dsp::ComplexMultiplyAccumulate(filter_[p].re.data(), filter_[p].im.data(),
+                                       render.re.data(), render.im.data(),
+                                       echo_.re.data(), echo_.im.data(), num_bins_);
+        size_t size = render_history_.size();
+        span_energy += render_energy_[(render_head_ + size - delay_blocks_ - p) % size];
+    }
+    Backward(echo_, time_.data());
+
+    // Error block, zero-padded in front for the gradient transform
+    float input_energy = 0.0f;
+    float error_energy = 0.0f;
+    const float* estimate = time_.data() + block_size_;
+    for (size_t i = 0; i < block_size_; ++i) {
+        float error = input[i] - estimate[i];
+        input_energy += input[i] * input[i];
+        error_energy += error * error;
+        time_[block_size_ + i] = error;
+    }
+    std::fill(time_.begin(), time_.begin() + block_size_, 0.0f);
+
+    if (error_energy > kDivergenceRatio * input_energy + kMinRenderPower * block_size_) {
+        Reset();
+        if (output != input) {
+            std::memcpy(output, input, block_size_ * sizeof(float));
+        }
+        return;
+    }
+    std::memcpy(output, time_.data() + block_size_, block_size_ * sizeof(float));
+
+    if (span_energy / num_partitions_ < kMinRenderPower) {
+        return;
+    }
+
+    // W_p += mu * conj(X_p) * E / (P * |X|^2 + reg)
+    Forward(time_.data(), &error_);
+    const float regularization = kRegularizationPower * fft_size_;
+    for (size_t k = 0; k < num_bins_; ++k) {
+        gain_[k] = kStepSize / (num_partitions_ * render_power_[k] + regularization);
+        error_.re[k] *= gain_[k];
+        error_.im[k] *= gain_[k];
+    }
+    for (size_t p = 0; p < num_partitions_; ++p) {
+        const Spectrum& render = RenderSpectrum(delay_blocks_ + p);
+        dsp::ConjugateMultiplyAccumulate(render.re.data(), render.im.data(),
+                                         error_.re.data(), error_.im.data(),
+                                         filter_[p].re.data(), filter_[p].im.data(), num_bins_);
+    }
+
+    ConstrainPartition(constrain_next_);
+    constrain_next_ = (constrain_next_ + 1) % num_partitions_;
+}
+
+// Unconstrained updates leak into the second half of the impulse response,
+// where they act as circular convolution; clearing it keeps the filter linear
+void NlmsEchoCanceller::ConstrainPartition(size_t partition) {
+    Backward(filter_[partition], time_.data());
+    std::fill(time_.begin() + block_size_, time_.end(), 0.0f);
+    Forward(time_.data(), &filter_[partition]);
+}
+
+} // namespace kakarot
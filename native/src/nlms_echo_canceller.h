@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "modules/audio_processing/utility/pffft_wrapper.h"
+
+namespace kakarot {
+
+// Partitioned-block frequency-domain NLMS echo canceller (overlap-save, FFT
+// of twice the block size), the fallback when the WebRTC APM cannot be built.
+// Render blocks are transformed once into a spectrum history; each capture
+// block is cleaned against the partitions that start |delay| blocks back,
+// then every partition adapts with a per-bin power-normalized step. One
+// partition per block is re-constrained to a linear convolution, and a
+// filter that makes the output louder than the input is reset.
+// All storage is allocated up front. Not thread-safe.
+class NlmsEchoCanceller {
+public:
+    // Whether |block_size| maps onto a supported FFT size
+    static bool Supported(size_t block_size);
+
+    // The filter spans |num_partitions| blocks; the delay can move it up to
+    // |max_delay_blocks| further back
+    NlmsEchoCanceller(size_t block_size, size_t num_partitions, size_t max_delay_blocks);
+    ~NlmsEchoCanceller();
+
+    NlmsEchoCanceller(const NlmsEchoCanceller&) = delete;
+    NlmsEchoCanceller& operator=(const NlmsEchoCanceller&) = delete;
+
+    // Exactly one block of mono render
+    void AnalyzeRender(const float* block);
+
+    // Exactly one block of capture; |input| and |output| may alias
+    void ProcessCapture(const float* input, float* output);
+
+    // Render->capture delay, in blocks
+    void SetDelayBlocks(size_t delay_blocks);
+
+    void Reset();
+
+private:
+    struct Spectrum {
+        std::vector<float> re;
+        std::vector<float> im;
+    };
+
+    void Forward(const float* time, Spectrum* spectrum);
+    void Backward(const Spectrum& spectrum, float* time);
+    void ConstrainPartition(size_t partition);
+    const Spectrum& RenderSpectrum(size_t blocks_back) const;
+
+    const size_t block_size_;
+    const size_t fft_size_;
+    const size_t num_bins_;       // DC..Nyquist
+    const size_t num_partitions_;
+    const size_t max_delay_blocks_;
+
+    std::unique_ptr<webrtc::Pffft> fft_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_in_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_out_;
+    std::vector<float> time_;            // fft_size_ scratch
+
+    std::vector<Spectrum> render_history_;  // ring, newest at render_head_
+    std::vector<float> render_energy_;      // mean square per history block
+    size_t render_head_ = 0;
+    std::vector<float> render_prev_;        // previous render block (overlap)
+    std::vector<float> render_power_;       // smoothed |X|^2 per bin
+
+    std::vector<Spectrum> filter_;          // one per partition
+    Spectrum echo_;
+    Spectrum error_;
+    std::vector<float> gain_;
+    size_t delay_blocks_ = 0;
+    size_t constrain_next_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,177 @@
+#include "noise_profile.h"
+#include "spectral_analyzer.h"
+#include "modules/audio_processing/utility/pffft_wrapper.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace kakarot {
+
+// SpectralAnalyzer's window is a 20ms Hann scaled by 2 / its sum, whose
+// squares sum to 3 / frame_size: white noise of variance v reads v * 3 /
+// frame_size in each bin, and its one-sided density is 2v / rate. Frames
+// are rate / 100 samples, so the density is the bin power over 150.
+static constexpr double kPowerToPsd = 1.0 / 150.0;
+
+// Reported for a band with no energy at all
+static constexpr float kFloorDb = -150.0f;
+
+// Weight of each noise frame once the estimate has kMinFrames: about ten
+// seconds of memory
+static constexpr double kNoiseAlpha = 1.0 / 1000.0;
+
+// Noise frames between publications
+static constexpr uint32_t kPublishFrames = 100;
+
+static size_t BandOf(double hz) {
+    if (hz <= kNoiseBandLowHz) {
+        return 0;
+    }
+    const double position = std::log(hz / kNoiseBandLowHz) / std::log(kNoiseBandHighHz / kNoiseBandLowHz);
+    return std::min(kNoiseBands - 1, static_cast<size_t>(position * kNoiseBands));
+}
+
+static size_t FftSizeFor(size_t window_size) {
+    size_t size = 128;
+    while (size < window_size) {
+        size *= 2;
+    }
+    return size;
+}
+
+bool NoiseProfileLearner::Supports(int sample_rate) {
+    return SpectralAnalyzer::Supports(sample_rate);
+}
+
+NoiseProfileLearner::NoiseProfileLearner(int sample_rate) {
+    SpectrumOptions options;
+    options.bands = 1;
+    analyzer_ = std::make_unique<SpectralAnalyzer>(sample_rate, options);
+    const size_t bins = analyzer_->Bins();
+    const size_t fft_size = 2 * (bins - 1);
+    bin_band_.assign(bins, 0);
+    for (size_t k = 1; k < bins; ++k) {
+        const size_t band = BandOf(static_cast<double>(k) * sample_rate / fft_size);
+        bin_band_[k] = static_cast<uint8_t>(band);
+        ++band_bins_[band];
+    }
+}
+
+NoiseProfileLearner::~NoiseProfileLearner() = default;
+
+void NoiseProfileLearner::AnalyzeFrame(const float* frame, bool noise, float noise_floor) {
+    analyzer_->ProcessFrame(frame);
+    // The window spans this frame and the one before; both must be noise
+    const bool joins = noise && previous_noise_;
+    previous_noise_ = noise;
+    if (!joins) {
+        return;
+    }
+
+    std::array<double, kNoiseBands> sums{};
+    const float* power = analyzer_->PowerSpectrum();
+    for (size_t k = 1; k < bin_band_.size(); ++k) {
+        sums[bin_band_[k]] += power[k];
+    }
+    ++frames_;
+    const double alpha = std::max(kNoiseAlpha, 1.0 / frames_);
+    for (size_t b = 0; b < kNoiseBands; ++b) {
+        if (band_bins_[b] > 0) {
+            psd_[b] += alpha * (sums[b] * kPowerToPsd / band_bins_[b] - psd_[b]);
+        }
+    }
+    noise_floor_ = noise_floor;
+    if (frames_ % kPublishFrames == 0) {
+        Publish();
+    }
+}
+
+void NoiseProfileLearner::Publish() {
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;  // the next second's
+    }
+    published_.noise_floor = noise_floor_;
+    published_.frames = frames_;
+    // Bands without a bin of their own (narrow low ones, or above this
+    // rate's Nyquist) take their nearest neighbour's level
+    size_t first = kNoiseBands;
+    for (size_t b = 0; b < kNoiseBands; ++b) {
+        if (band_bins_[b] > 0) {
+            published_.bands_db[b] = psd_[b] > 0.0 ? std::max(kFloorDb, static_cast<float>(10.0 * std::log10(psd_[b])))
+                                                   : kFloorDb;
+            first = std::min(first, b);
+        } else if (b > 0) {
+            published_.bands_db[b] = published_.bands_db[b - 1];
+        }
+    }
+    for (size_t b = 0; b < first && first < kNoiseBands; ++b) {
+        published_.bands_db[b] = published_.bands_db[first];
+    }
+}
+
+bool NoiseProfileLearner::Learned(NoiseProfile* profile) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (published_.frames < kMinFrames) {
+        return false;
+    }
+    *profile = published_;
+    return true;
+}
+
+void SynthesizeNoise(const NoiseProfile& profile, int sample_rate, size_t num_samples, uint32_t seed,
+                     std::vector<float>* out) {
+    out->assign(num_samples, 0.0f);
+    if (sample_rate <= 0 || num_samples == 0) {
+        return;
+    }
+    const size_t fft_size = FftSizeFor(2 * static_cast<size_t>(sample_rate / 100));
+    const size_t hop = fft_size / 2;
+    webrtc::Pffft fft(fft_size, webrtc::Pffft::FftType::kReal);
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> spectrum = fft.CreateBuffer();
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> frame = fft.CreateBuffer();
+
+    // The inverse is unnormalized: bin k with real and imaginary parts of
+    // deviation a adds 4a^2 of variance, which should be the density times
+    // the bin's width, rate / fft_size
+    std::vector<float> amplitude(hop, 0.0f);
+    for (size_t k = 1; k < hop; ++k) {
+        const double hz = static_cast<double>(k) * sample_rate / fft_size;
+        const double psd = std::pow(10.0, profile.bands_db[BandOf(hz)] / 10.0);
+        amplitude[k] = static_cast<float>(0.5 * std::sqrt(psd * sample_rate / fft_size));
+    }
+    // Square-root periodic Hann: the squares of frames a hop apart sum to one
+    const double pi = std::acos(-1.0);
+    std::vector<float> window(fft_size);
+    for (size_t n = 0; n < fft_size; ++n) {
+        window[n] = static_cast<float>(std::sqrt(0.5 - 0.5 * std::cos(2.0 * pi * n / fft_size)));
+    }
+
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    // Frame j covers [(j - 1) * hop, (j + 1) * hop), so every output sample
+    // gets two overlapping frames
+    for (size_t start = 0; start < num_samples + hop; start += hop) {
+        float* bins = spectrum->GetView().data();
+        bins[0] = 0.0f;  // DC
+        bins[1] = 0.0f;  // Nyquist
+        for (size_t k = 1; k < hop; ++k) {
+            bins[2 * k] = amplitude[k] * gauss(rng);
+            bins[2 * k + 1] = amplitude[k] * gauss(rng);
+        }
+        fft.BackwardTransform(*spectrum, frame.get(), true);
+        const float* samples = frame->GetConstView().data();
+        for (size_t n = 0; n < fft_size; ++n) {
+            if (start + n < hop) {
+                continue;
+            }
+            const size_t position = start + n - hop;
+            if (position >= num_samples) {
+                break;
+            }
+            (*out)[position] += window[n] * samples[n];
+        }
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace kakarot {
+
+class SpectralAnalyzer;
+
+// Bands of a noise profile: log-spaced from kNoiseBandLowHz to
+// kNoiseBandHighHz, the first reaching down to DC and the last up to Nyquist
+static constexpr size_t kNoiseBands = 24;
+static constexpr float kNoiseBandLowHz = 60.0f;
+static constexpr float kNoiseBandHighHz = 20000.0f;
+
+// What one session heard of its mic's background noise, to seed the next
+// session on the same device. Rate-independent: the spectrum is a power
+// spectral density, so a profile learned at 48kHz seeds a 16kHz APM.
+struct NoiseProfile {
+    float noise_floor = 0.0f;                   // LevelAnalyzer's floor of the processed output (RMS)
+    std::array<float, kNoiseBands> bands_db{};  // mean PSD of the input per band, dB re 1/Hz
+    uint32_t frames = 0;                        // noise frames it was learned from
+
+    bool operator==(const NoiseProfile& other) const {
+        return noise_floor == other.noise_floor && bands_db == other.bands_db && frames == other.frames;
+    }
+    bool operator!=(const NoiseProfile& other) const { return !(*this == other); }
+};
+
+// Learns a NoiseProfile from a capture stream's 10ms frames: the input's
+// spectrum over frames the caller judged to be noise alone (no speech, no
+// echo), and the output floor it passes along. Recent frames weigh most, so
+// a session's profile is where its room ended up. AnalyzeFrame() on one
+// thread, without locks or allocation; Learned() from any thread.
+class NoiseProfileLearner {
+public:
+    // Frames of noise before Learned() has a profile: three seconds
+    static constexpr uint32_t kMinFrames = 300;
+
+    static bool Supports(int sample_rate);
+
+    explicit NoiseProfileLearner(int sample_rate);
+    ~NoiseProfileLearner();
+
+    NoiseProfileLearner(const NoiseProfileLearner&) = delete;
+    NoiseProfileLearner& operator=(const NoiseProfileLearner&) = delete;
+
+    // One input frame of sample_rate / 100 samples. Every frame goes through
+    // the FFT, so the analysis window never straddles a gap; only a frame
+    // that follows another noise frame joins the estimate.
+    void AnalyzeFrame(const float* frame, bool noise, float noise_floor);
+
+    // The estimate as of its last publication (once a second of noise);
+    // false before kMinFrames
+    bool Learned(NoiseProfile* profile) const;
+
+private:
+    void Publish();
+
+    std::unique_ptr<SpectralAnalyzer> analyzer_;
+    std::vector<uint8_t> bin_band_;                 // each bin's band at this rate
+    std::array<uint32_t, kNoiseBands> band_bins_{};
+    std::array<double, kNoiseBands> psd_{};         // linear, 1/Hz
+    float noise_floor_ = 0.0f;
+    uint32_t frames_ = 0;
+    bool previous_noise_ = false;
+
+    mutable std::mutex mutex_;  // published_; AnalyzeFrame only try-locks it
+    NoiseProfile published_;
+};
+
+// |num_samples| of Gaussian noise at |sample_rate| with |profile|'s
+// spectrum: random-phase frames through an inverse FFT, overlap-added under
+// a square-root Hann window so the level holds steady. For priming a fresh
+// noise suppressor; allocates, so not for a real-time thread.
+void SynthesizeNoise(const NoiseProfile& profile, int sample_rate, size_t num_samples, uint32_t seed,
+                     std::vector<float>* out);
+
+} // namespace kakarot
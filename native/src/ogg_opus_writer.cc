@@ -0,0 +1,122 @@
+#include "ogg_opus_writer.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace kakarot {
+
+// A page's segment table holds 255 entries; Opus packets are at most 1275
+// bytes (6 entries), so a page never needs more than a few dozen packets
+static constexpr size_t kMaxSegments = 255;
+static constexpr size_t kPageHeaderSize = 27;
+
+static const char kVendor[] = "kakarot";
+
+// Ogg's CRC-32: polynomial 0x04c11db7, unreflected, no final xor
+static const std::array<uint32_t, 256>& CrcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04c11db7u : crc << 1;
+            }
+            entries[i] = crc;
+        }
+        return entries;
+    }();
+    return table;
+}
+
+static void PutLe(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+OggOpusWriter::OggOpusWriter() {
+    lacing_.reserve(kMaxSegments);
+    body_.reserve(kMaxSegments * 255);
+}
+
+void OggOpusWriter::Begin(uint32_t serial, int input_sample_rate, int pre_skip, std::vector<uint8_t>* out) {
+    serial_ = serial;
+    sequence_ = 0;
+    granule_ = 0;
+    pending_packets_ = 0;
+    lacing_.clear();
+    body_.clear();
+
+    // OpusHead: version 1, mono, channel mapping family 0
+    uint8_t head[19] = {'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1, 1};
+    PutLe(head + 10, static_cast<uint16_t>(pre_skip), 2);
+    PutLe(head + 12, static_cast<uint32_t>(input_sample_rate), 4);
+    lacing_.push_back(sizeof(head));
+    WritePage(0x02, 0, head, sizeof(head), out);
+
+    // OpusTags: the vendor string and no user comments
+    uint8_t tags[8 + 4 + sizeof(kVendor) - 1 + 4] = {'O', 'p', 'u', 's', 'T', 'a', 'g', 's'};
+    PutLe(tags + 8, sizeof(kVendor) - 1, 4);
+    std::memcpy(tags + 12, kVendor, sizeof(kVendor) - 1);
+    lacing_.clear();
+    lacing_.push_back(sizeof(tags));
+    WritePage(0x00, 0, tags, sizeof(tags), out);
+    lacing_.clear();
+}
+
+void OggOpusWriter::AddPacket(const uint8_t* data, size_t size, int samples_48k) {
+    // Lacing: 255s while the packet runs on, then the remainder (0 included)
+    size_t remaining = size;
+    while (remaining >= 255) {
+        lacing_.push_back(255);
+        remaining -= 255;
+    }
+    lacing_.push_back(static_cast<uint8_t>(remaining));
+    body_.insert(body_.end(), data, data + size);
+    granule_ += static_cast<uint64_t>(samples_48k);
+    pending_packets_++;
+}
+
+void OggOpusWriter::Flush(std::vector<uint8_t>* out) {
+    if (pending_packets_ == 0) {
+        return;
+    }
+    WritePage(0x00, granule_, body_.data(), body_.size(), out);
+    lacing_.clear();
+    body_.clear();
+    pending_packets_ = 0;
+}
+
+void OggOpusWriter::Finish(uint64_t end_granule, std::vector<uint8_t>* out) {
+    WritePage(0x04, std::min(granule_, end_granule), body_.data(), body_.size(), out);
+    lacing_.clear();
+    body_.clear();
+    pending_packets_ = 0;
+}
+
+void OggOpusWriter::WritePage(uint8_t header_type, uint64_t granule, const uint8_t* body, size_t body_size,
+                              std::vector<uint8_t>* out) {
+    const size_t start = out->size();
+    out->resize(start + kPageHeaderSize + lacing_.size() + body_size);
+    uint8_t* page = out->data() + start;
+    std::memcpy(page, "OggS", 4);
+    page[4] = 0;  // stream structure version
+    page[5] = header_type;
+    PutLe(page + 6, granule, 8);
+    PutLe(page + 14, serial_, 4);
+    PutLe(page + 18, sequence_++, 4);
+    PutLe(page + 22, 0, 4);  // CRC, computed with this field zeroed
+    page[26] = static_cast<uint8_t>(lacing_.size());
+    std::memcpy(page + kPageHeaderSize, lacing_.data(), lacing_.size());
+    std::memcpy(page + kPageHeaderSize + lacing_.size(), body, body_size);
+
+    const std::array<uint32_t, 256>& table = CrcTable();
+    const size_t page_size = out->size() - start;
+    uint32_t crc = 0;
+    for (size_t i = 0; i < page_size; ++i) {
+        crc = (crc << 8) ^ table[((crc >> 24) ^ page[i]) & 0xff];
+    }
+    PutLe(page + 22, crc, 4);
+}
+
+} // namespace kakarot
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kakarot {
+
+// Ogg encapsulation of one mono Opus stream (RFC 7845), as a websocket
+// consumer such as Deepgram reads it: the OpusHead and OpusTags pages, then
+// data pages of a few packets each. A live stream is never closed and a new
+// one starts with Begin(); a file ends with Finish(). Buffers are reserved up
+// front, so steady-state packets do not allocate.
+class OggOpusWriter {
+public:
+    OggOpusWriter();
+
+    // Appends the two header pages of a new logical stream to |out|.
+    // |pre_skip| is the encoder lookahead at 48kHz.
+    void Begin(uint32_t serial, int input_sample_rate, int pre_skip, std::vector<uint8_t>* out);
+
+    // Holds a packet for the next page. |samples_48k| is its duration.
+    void AddPacket(const uint8_t* data, size_t size, int samples_48k);
+
+    // Appends the held packets to |out| as one page; nothing when none are held
+    void Flush(std::vector<uint8_t>* out);
+
+    // Ends the stream with the held packets, if any, on a last page. Its
+    // granule is |end_granule| when that is smaller, which trims the padding
+    // of a final partial packet (pre-skip included, as all granules are).
+    void Finish(uint64_t end_granule, std::vector<uint8_t>* out);
+
+    size_t PendingPackets() const { return pending_packets_; }
+
+private:
+    void WritePage(uint8_t header_type, uint64_t granule, const uint8_t* body, size_t body_size,
+                   std::vector<uint8_t>* out);
+
+    uint32_t serial_ = 0;
+    uint32_t sequence_ = 0;
+    uint64_t granule_ = 0;
+    size_t pending_packets_ = 0;
+    std::vector<uint8_t> lacing_;   // segment table of the page being built
+    std::vector<uint8_t> body_;
+};
+
+} // namespace kakarot
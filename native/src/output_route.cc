@@ -0,0 +1,191 @@
+#include "output_route.h"
+#include "native_log.h"
+#include <algorithm>
+#include <cctype>
+
+namespace kakarot {
+
+static const char* const kLogSource = "OutputRoute";
+
+static const AudioObjectPropertyAddress kDefaultOutputAddress = {
+    kAudioHardwarePropertyDefaultOutputDevice, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain
+};
+static const AudioObjectPropertyAddress kDataSourceAddress = {
+    kAudioDevicePropertyDataSource, kAudioDevicePropertyScopeOutput, kAudioObjectPropertyElementMain
+};
+
+// Built-in output data sources (IOAudioTypes.h port subtypes)
+static constexpr UInt32 kDataSourceHeadphones = 'hdpn';
+
+static bool NameSuggestsHeadphones(std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+    return name.find("headphone") != std::string::npos || name.find("headset") != std::string::npos ||
+           name.find("airpods") != std::string::npos;
+}
+
+// 'ispk' style, for the log
+static std::string FourCc(UInt32 code) {
+    if (code == 0) {
+        return "none";
+    }
+    std::string text;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        char c = static_cast<char>((code >> shift) & 0xff);
+        text += std::isprint(static_cast<unsigned char>(c)) ? c : '?';
+    }
+    return text;
+}
+
+static OutputRouteInfo QueryRoute() {
+    OutputRouteInfo info;
+    UInt32 size = sizeof(info.device);
+    AudioObjectGetPropertyData(kAudioObjectSystemObject, &kDefaultOutputAddress, 0, nullptr, &size, &info.device);
+    if (info.device == kAudioObjectUnknown) {
+        return info;
+    }
+
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyDeviceNameCFString,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    CFStringRef name = nullptr;
+    size = sizeof(name);
+    if (AudioObjectGetPropertyData(info.device, &address, 0, nullptr, &size, &name) == noErr && name) {
+        char buffer[256];
+        if (CFStringGetCString(name, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
+            info.name = buffer;
+        }
+        CFRelease(name);
+    }
+
+    address.mSelector = kAudioDevicePropertyTransportType;
+    UInt32 transport = 0;
+    size = sizeof(transport);
+    AudioObjectGetPropertyData(info.device, &address, 0, nullptr, &size, &transport);
+
+    size = sizeof(info.data_source);
+    if (AudioObjectHasProperty(info.device, &kDataSourceAddress)) {
+        AudioObjectGetPropertyData(info.device, &kDataSourceAddress, 0, nullptr, &size, &info.data_source);
+    }
+
+    switch (transport) {
+        case kAudioDeviceTransportTypeBuiltIn:
+            info.transport = "builtIn";
+            info.headphones = info.data_source == kDataSourceHeadphones;
+            break;
+        case kAudioDeviceTransportTypeBluetooth:
+        case kAudioDeviceTransportTypeBluetoothLE:
+            info.transport = transport == kAudioDeviceTransportTypeBluetooth ? "bluetooth" : "bluetoothLE";
+            info.headphones = true;
+            break;
+        case kAudioDeviceTransportTypeUSB:
+            info.transport = "usb";
+            info.headphones = NameSuggestsHeadphones(info.name);
+            break;
+        default:
+            info.transport = "other";
+            break;
+    }
+    return info;
+}
+
+OutputRoute::~OutputRoute() {
+    Stop();
+}
+
+void OutputRoute::Start() {
+    if (listening_) {
+        return;
+    }
+    AudioObjectAddPropertyListener(kAudioObjectSystemObject, &kDefaultOutputAddress, &OutputRoute::PropertyChanged, this);
+    listening_ = true;
+    Update();
+}
+
+void OutputRoute::Stop() {
+    if (!listening_) {
+        return;
+    }
+    AudioObjectRemovePropertyListener(kAudioObjectSystemObject, &kDefaultOutputAddress,
+                                      &OutputRoute::PropertyChanged, this);
+    std::lock_guard<std::mutex> lock(mutex_);
+    WatchDevice(kAudioObjectUnknown);
+    listening_ = false;
+}
+
+OutputRouteInfo OutputRoute::Current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return info_;
+}
+
+void OutputRoute::SetChangeCallback(std::function<void(bool headphones)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_change_ = std::move(callback);
+}
+
+void OutputRoute::SetPathCallback(std::function<void(const OutputRouteInfo& from, const OutputRouteInfo& to)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_path_ = std::move(callback);
+}
+
+// HAL notification thread: the default output moved, or its data source did
+OSStatus OutputRoute::PropertyChanged(AudioObjectID /*object*/,
+                                      UInt32 /*num_addresses*/,
+                                      const AudioObjectPropertyAddress* /*addresses*/,
+                                      void* client_data) {
+    static_cast<OutputRoute*>(client_data)->Update();
+    return noErr;
+}
+
+// Call with mutex_ held. Moves the data source listener to |device|.
+void OutputRoute::WatchDevice(AudioDeviceID device) {
+    if (device == watched_device_) {
+        return;
+    }
+    if (watched_device_ != kAudioObjectUnknown) {
+        AudioObjectRemovePropertyListener(watched_device_, &kDataSourceAddress, &OutputRoute::PropertyChanged, this);
+        watched_device_ = kAudioObjectUnknown;
+    }
+    if (device != kAudioObjectUnknown && AudioObjectHasProperty(device, &kDataSourceAddress) &&
+        AudioObjectAddPropertyListener(device, &kDataSourceAddress, &OutputRoute::PropertyChanged, this) == noErr) {
+        watched_device_ = device;
+    }
+}
+
+void OutputRoute::Update() {
+    OutputRouteInfo info = QueryRoute();
+
+    std::function<void(bool)> callback;
+    std::function<void(const OutputRouteInfo&, const OutputRouteInfo&)> path_callback;
+    OutputRouteInfo previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!listening_) {
+            return;
+        }
+        WatchDevice(info.device);
+        bool changed = headphones_.exchange(info.headphones, std::memory_order_relaxed) != info.headphones;
+        bool moved = info_.device != kAudioObjectUnknown &&
+                     (info.device != info_.device || info.data_source != info_.data_source);
+        previous = info_;
+        info_ = info;
+        if (changed) {
+            callback = on_change_;
+        }
+        if (moved) {
+            path_callback = on_path_;
+        }
+    }
+    // Logged on the first evaluation too, so the starting route is on record
+    Log(LogLevel::kInfo, kLogSource, "Output route: %s (%s, source %s) -> %s", info.name.c_str(),
+        info.transport.c_str(), FourCc(info.data_source).c_str(), info.headphones ? "headphones" : "speakers");
+    if (callback) {
+        callback(info.headphones);
+    }
+    if (path_callback) {
+        path_callback(previous, info);
+    }
+}
+
+} // namespace kakarot
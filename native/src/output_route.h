@@ -0,0 +1,66 @@
+#pragma once
+
+#include <CoreAudio/CoreAudio.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace kakarot {
+
+struct OutputRouteInfo {
+    AudioDeviceID device = kAudioObjectUnknown;
+    std::string name;
+    std::string transport;   // as DeviceTable: "builtIn", "usb", "bluetooth", ...
+    UInt32 data_source = 0;  // built-in devices: 'ispk', 'hdpn', ...; 0 if none
+    bool headphones = false;
+};
+
+// Tracks whether the default output is a private listening route. Listeners
+// on the default output device and on that device's data source
+// (kAudioDevicePropertyDataSource: built-in speakers vs the headphone jack)
+// re-evaluate it on the HAL notification thread. Headphones are the
+// built-in 'hdpn' source, any Bluetooth output, and USB devices named as a
+// headset or headphones; everything else counts as speakers.
+class OutputRoute {
+public:
+    OutputRoute() = default;
+    ~OutputRoute();
+
+    OutputRoute(const OutputRoute&) = delete;
+    OutputRoute& operator=(const OutputRoute&) = delete;
+
+    // Evaluates the route and installs the listeners
+    void Start();
+    void Stop();
+
+    bool Headphones() const { return headphones_.load(std::memory_order_relaxed); }
+    OutputRouteInfo Current() const;
+
+    // Called on the HAL notification thread when Headphones() flips
+    void SetChangeCallback(std::function<void(bool headphones)> callback);
+
+    // Called on the HAL notification thread when the output device or its
+    // data source changes, whether or not Headphones() does: the echo path
+    // has moved. Not for the first evaluation.
+    void SetPathCallback(std::function<void(const OutputRouteInfo& from, const OutputRouteInfo& to)> callback);
+
+private:
+    static OSStatus PropertyChanged(AudioObjectID object,
+                                    UInt32 num_addresses,
+                                    const AudioObjectPropertyAddress* addresses,
+                                    void* client_data);
+    void Update();
+    void WatchDevice(AudioDeviceID device);
+
+    mutable std::mutex mutex_;
+    OutputRouteInfo info_;
+    AudioDeviceID watched_device_ = kAudioObjectUnknown;  // holds the data source listener
+    std::function<void(bool)> on_change_;
+    std::function<void(const OutputRouteInfo&, const OutputRouteInfo&)> on_path_;
+    std::atomic<bool> headphones_{false};
+    bool listening_ = false;
+};
+
+} // namespace kakarot
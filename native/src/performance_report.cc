@@ -0,0 +1,299 @@
+#include "performance_report.h"
+#include "platform_thread.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace kakarot {
+
+// First bucket of a series; doubled each time the meeting outgrows
+// kMaxSeriesPoints
+static constexpr double kSeriesBucketMs = 10000.0;
+static constexpr size_t kMaxSeriesPoints = 180;
+
+static constexpr double kMinReportIntervalMs = 100.0;
+static constexpr double kMaxReportIntervalMs = 60000.0;
+
+static WakeupCounter g_wakeups("performanceReport");
+
+namespace {
+
+using Fold = PerformanceReport::Fold;
+
+struct ReportMetric {
+    const char* name;
+    Fold fold;
+    bool series;
+};
+
+constexpr Fold kCount = Fold::kCount;
+constexpr Fold kMean = Fold::kMean;
+constexpr Fold kPeak = Fold::kPeak;
+constexpr Fold kLast = Fold::kLast;
+
+// Whole names
+const ReportMetric kAecMetrics[] = {
+    // CPU, and the canceller's share of each capture call
+    { "aec.processingLoad", kMean, true },
+    { "aec.captureCalls.p50Us", kLast, false },
+    { "aec.captureCalls.p95Us", kLast, false },
+    { "aec.captureCalls.p99Us", kLast, false },
+    { "aec.captureCalls.maxUs", kPeak, false },
+    { "aec.renderCalls.p95Us", kLast, false },
+    { "aec.renderCalls.maxUs", kPeak, false },
+    { "aec.governorTransitions", kCount, false },
+    // Deadlines
+    { "aec.captureCalls.deadlineMisses", kCount, false },
+    { "aec.renderCalls.deadlineMisses", kCount, false },
+    { "aec.captureCalls.errors", kCount, false },
+    { "aec.renderCalls.errors", kCount, false },
+    // Echo cancellation
+    { "aec.echoReturnLossEnhancement", kMean, true },
+    { "aec.echoReturnLoss", kMean, false },
+    { "aec.delayMedianMs", kMean, true },
+    { "aec.delayStdMs", kMean, false },
+    { "aec.aecConverged", kMean, false },
+    { "aec.residualEchoLikelihood", kMean, false },
+    { "aec.divergentFilterFraction", kMean, false },
+    { "aec.echoPathResets", kCount, false },
+    // Render resampler against the capture clock
+    { "aec.renderDriftPpm", kMean, true },
+};
+
+// After each capture stream's "mic.", "system." or "async."
+const char* const kStreamPrefixes[] = { "mic.", "system.", "async." };
+const ReportMetric kStreamMetrics[] = {
+    { "cpuMsPerSecond", kMean, true },
+    { "denoiseMeanUs", kLast, false },
+    { "avgCallbackDurationMs", kLast, false },
+    { "maxCallbackDurationMs", kPeak, false },
+    { "maxCallbackIntervalMs", kPeak, false },
+    { "maxConsumerWakeMs", kPeak, false },
+    { "maxDspWakeMs", kPeak, false },
+    // Drops
+    { "buffersDropped", kCount, false },
+    { "buffersOversized", kCount, false },
+    { "overloads", kCount, false },
+    { "renderGaps", kCount, false },
+    { "renderFramesConcealed", kCount, false },
+    { "renderFramesDropped", kCount, false },
+    // JS falling behind the deliveries
+    { "tsfnRejections", kCount, false },
+    { "deliveriesDropped", kCount, false },
+    { "deliveriesCoalesced", kCount, false },
+    { "consumerBlocks", kCount, false },
+    { "subscriberDropped", kCount, false },
+    { "queuePeak", kPeak, false },
+};
+
+// After each stream's "micTrace.", "systemTrace." or "asyncTrace."
+const char* const kTracePrefixes[] = { "micTrace.", "systemTrace.", "asyncTrace." };
+const ReportMetric kTraceMetrics[] = {
+    { "dispatchToJs.p95Ms", kLast, false },
+    { "jsToSent.p95Ms", kLast, false },
+    { "total.p50Ms", kLast, false },
+    { "total.p95Ms", kLast, false },
+    { "total.p99Ms", kLast, false },
+    { "total.maxMs", kPeak, false },
+};
+
+} // namespace
+
+PerformanceReport::PerformanceReport(const std::vector<std::string>& names) : slots_(names.size()) {
+    for (const ReportMetric& metric : kAecMetrics) {
+        Track(names, metric.name, metric.fold, metric.series);
+    }
+    for (const char* prefix : kStreamPrefixes) {
+        for (const ReportMetric& metric : kStreamMetrics) {
+            Track(names, std::string(prefix) + metric.name, metric.fold, metric.series);
+        }
+    }
+    for (const char* prefix : kTracePrefixes) {
+        for (const ReportMetric& metric : kTraceMetrics) {
+            Track(names, std::string(prefix) + metric.name, metric.fold, metric.series);
+        }
+    }
+    // Layout order, so a report reads like getMetricsLayout()
+    std::sort(tracked_.begin(), tracked_.end(),
+              [](const Tracked& a, const Tracked& b) { return a.slot < b.slot; });
+}
+
+void PerformanceReport::Track(const std::vector<std::string>& names, const std::string& name, Fold fold,
+                              bool series) {
+    auto it = std::find(names.begin(), names.end(), name);
+    if (it == names.end()) {
+        return;
+    }
+    Tracked tracked;
+    tracked.name = name;
+    tracked.slot = static_cast<size_t>(it - names.begin());
+    tracked.fold = fold;
+    if (series) {
+        tracked.series = static_cast<int>(series_.size());
+        Bucketed bucketed;
+        bucketed.name = name;
+        bucketed.bucket_ms = kSeriesBucketMs;
+        series_.push_back(std::move(bucketed));
+    }
+    tracked_.push_back(std::move(tracked));
+}
+
+void PerformanceReport::AddToSeries(Bucketed* series, double value, double elapsed_ms) {
+    size_t bucket = static_cast<size_t>(std::max(0.0, elapsed_ms) / series->bucket_ms);
+    while (bucket >= kMaxSeriesPoints) {
+        // Neighbours merged: half as many buckets, each twice as long
+        const size_t merged = (series->sum.size() + 1) / 2;
+        for (size_t i = 0; i < merged; ++i) {
+            const size_t a = 2 * i;
+            const size_t b = std::min(a + 1, series->sum.size() - 1);
+            const bool both = b != a;
+            series->min[i] = std::min(series->min[a], both ? series->min[b] : series->min[a]);
+            series->max[i] = std::max(series->max[a], both ? series->max[b] : series->max[a]);
+            series->sum[i] = series->sum[a] + (both ? series->sum[b] : 0.0);
+            series->count[i] = series->count[a] + (both ? series->count[b] : 0);
+        }
+        series->min.resize(merged);
+        series->max.resize(merged);
+        series->sum.resize(merged);
+        series->count.resize(merged);
+        series->bucket_ms *= 2.0;
+        bucket = static_cast<size_t>(std::max(0.0, elapsed_ms) / series->bucket_ms);
+    }
+    if (bucket >= series->sum.size()) {
+        series->min.resize(bucket + 1, std::numeric_limits<double>::infinity());
+        series->max.resize(bucket + 1, -std::numeric_limits<double>::infinity());
+        series->sum.resize(bucket + 1, 0.0);
+        series->count.resize(bucket + 1, 0);
+    }
+    series->min[bucket] = std::min(series->min[bucket], value);
+    series->max[bucket] = std::max(series->max[bucket], value);
+    series->sum[bucket] += value;
+    ++series->count[bucket];
+}
+
+void PerformanceReport::Add(const double* values, size_t count, double elapsed_ms) {
+    elapsed_ms_ = std::max(elapsed_ms_, elapsed_ms);
+    ++samples_;
+    for (Tracked& tracked : tracked_) {
+        if (tracked.slot >= count || std::isnan(values[tracked.slot])) {
+            continue;
+        }
+        const double value = values[tracked.slot];
+        switch (tracked.fold) {
+            case Fold::kCount:
+                // Below the last value: the stream restarted and counts from zero
+                if (tracked.seen > 0) {
+                    tracked.value += value >= tracked.previous ? value - tracked.previous : value;
+                }
+                tracked.previous = value;
+                break;
+            case Fold::kMean:
+                tracked.value += value;
+                break;
+            case Fold::kPeak:
+                tracked.value = tracked.seen > 0 ? std::max(tracked.value, value) : value;
+                break;
+            case Fold::kLast:
+                tracked.value = value;
+                break;
+        }
+        ++tracked.seen;
+        if (tracked.series >= 0) {
+            AddToSeries(&series_[tracked.series], value, elapsed_ms);
+        }
+    }
+}
+
+PerformanceSummary PerformanceReport::Summarize() const {
+    PerformanceSummary summary;
+    summary.duration_ms = elapsed_ms_;
+    summary.samples = samples_;
+    for (const Tracked& tracked : tracked_) {
+        if (tracked.seen == 0) {
+            continue;
+        }
+        const double value = tracked.fold == Fold::kMean ? tracked.value / static_cast<double>(tracked.seen)
+                                                         : tracked.value;
+        summary.metrics.emplace_back(tracked.name, value);
+    }
+    for (const Bucketed& bucketed : series_) {
+        if (bucketed.sum.empty()) {
+            continue;
+        }
+        PerformanceSeries series;
+        series.name = bucketed.name;
+        series.bucket_ms = bucketed.bucket_ms;
+        for (size_t i = 0; i < bucketed.sum.size(); ++i) {
+            const bool measured = bucketed.count[i] > 0;
+            series.min.push_back(measured ? static_cast<float>(bucketed.min[i]) : std::nanf(""));
+            series.mean.push_back(measured ? static_cast<float>(bucketed.sum[i] / bucketed.count[i]) : std::nanf(""));
+            series.max.push_back(measured ? static_cast<float>(bucketed.max[i]) : std::nanf(""));
+        }
+        summary.series.push_back(std::move(series));
+    }
+    return summary;
+}
+
+void PerformanceRecorder::Start(const std::vector<std::string>& names, Sampler sample, double interval_ms) {
+    Stop(nullptr);
+    sample_ = std::move(sample);
+    report_ = std::make_unique<PerformanceReport>(names);
+    values_.assign(names.size(), std::nan(""));
+    interval_ms_ = std::clamp(interval_ms, kMinReportIntervalMs, kMaxReportIntervalMs);
+    started_ = std::chrono::steady_clock::now();
+    SampleNow();
+    running_ = true;
+    thread_ = std::thread(&PerformanceRecorder::Loop, this);
+}
+
+bool PerformanceRecorder::Stop(PerformanceSummary* summary) {
+    if (!thread_.joinable()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wake_.notify_one();
+    thread_.join();
+    SampleNow();
+    if (summary) {
+        *summary = report_->Summarize();
+        summary->interval_ms = interval_ms_;
+    }
+    report_.reset();
+    sample_ = nullptr;
+    return true;
+}
+
+void PerformanceRecorder::SampleNow() {
+    std::fill(values_.begin(), values_.end(), std::nan(""));
+    sample_(values_.data(), values_.size());
+    const double elapsed_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started_).count();
+    report_->Add(values_.data(), values_.size(), elapsed_ms);
+}
+
+void PerformanceRecorder::Loop() {
+    ScopedThreadCpu thread_cpu("performanceReport");
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(interval_ms_));
+    auto next = started_ + period;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (wake_.wait_until(lock, next, [this] { return !running_; })) {
+            break;
+        }
+        g_wakeups.Count();
+        // A late tick does not try to catch up
+        next = std::max(next + period, std::chrono::steady_clock::now());
+        lock.unlock();
+        SampleNow();
+        lock.lock();
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace kakarot {
+
+// One metric over a meeting: min, mean and max per bucket, NaN where
+// nothing was measured
+struct PerformanceSeries {
+    std::string name;
+    double bucket_ms = 0.0;
+    std::vector<float> min;
+    std::vector<float> mean;
+    std::vector<float> max;
+};
+
+// A meeting's pipeline health, small enough to store with it
+struct PerformanceSummary {
+    double duration_ms = 0.0;
+    double interval_ms = 0.0;
+    uint64_t samples = 0;
+    std::vector<std::pair<std::string, double>> metrics;  // readMetrics() names
+    std::vector<PerformanceSeries> series;
+};
+
+// Folds snapshots of readMetrics() slots into a PerformanceSummary. Of the
+// slots it keeps a fixed set, each folded its own way: counters to what
+// they rose by (a stream restarting from zero included), rates and gauges
+// to their mean, worst cases to their peak and running percentiles to the
+// last value. A few also keep a series, whose buckets double in length
+// as the meeting runs on, so a long one costs no more than a short one.
+// NaN values and names the layout lacks are skipped.
+class PerformanceReport {
+public:
+    enum class Fold { kCount, kMean, kPeak, kLast };
+
+    explicit PerformanceReport(const std::vector<std::string>& names);
+
+    // |values| in the layout's order, |elapsed_ms| after the first
+    void Add(const double* values, size_t count, double elapsed_ms);
+
+    PerformanceSummary Summarize() const;
+
+    size_t Slots() const { return slots_; }
+
+private:
+    struct Bucketed {
+        std::string name;
+        double bucket_ms = 0.0;
+        std::vector<double> min;
+        std::vector<double> max;
+        std::vector<double> sum;
+        std::vector<uint32_t> count;
+    };
+
+    struct Tracked {
+        std::string name;
+        size_t slot = 0;
+        Fold fold = Fold::kLast;
+        double value = 0.0;
+        double previous = 0.0;
+        uint64_t seen = 0;
+        int series = -1;  // into series_
+    };
+
+    void Track(const std::vector<std::string>& names, const std::string& name, Fold fold, bool series);
+    static void AddToSeries(Bucketed* series, double value, double elapsed_ms);
+
+    size_t slots_ = 0;
+    std::vector<Tracked> tracked_;
+    std::vector<Bucketed> series_;
+    double elapsed_ms_ = 0.0;
+    uint64_t samples_ = 0;
+};
+
+// A PerformanceReport sampled on a thread of its own every |interval_ms|
+// from Start() to Stop(). |sample| fills the slots as readMetrics() does
+// and must be safe off the JS thread.
+class PerformanceRecorder {
+public:
+    using Sampler = std::function<void(double* out, size_t capacity)>;
+
+    ~PerformanceRecorder() { Stop(nullptr); }
+
+    // Restarts, dropping what was sampled, when running
+    void Start(const std::vector<std::string>& names, Sampler sample, double interval_ms);
+    // Takes one last sample; false when it was not running
+    bool Stop(PerformanceSummary* summary);
+
+    bool IsRunning() const { return thread_.joinable(); }
+
+private:
+    void Loop();
+    void SampleNow();
+
+    Sampler sample_;
+    std::unique_ptr<PerformanceReport> report_;
+    std::vector<double> values_;
+    double interval_ms_ = 0.0;
+    std::chrono::steady_clock::time_point started_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_ = false;
+};
+
+} // namespace kakarot
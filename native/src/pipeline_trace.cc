@@ -0,0 +1,313 @@
+#include "pipeline_trace.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "rtc_base/event_tracer.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#if defined(__APPLE__)
+#include <os/signpost.h>
+#endif
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace kakarot {
+
+static const char* const kLogSource = "PipelineTrace";
+
+// A few seconds of a busy pipeline (~1000 events/s) between drains
+static constexpr size_t kTraceRingCapacity = 8192;
+static constexpr auto kDrainInterval = std::chrono::milliseconds(50);
+
+static const struct {
+    const char* name;
+    const char* category;
+} kEvents[] = {
+    { "MicIOProc", "audio" },
+    { "SystemTapIOProc", "audio" },
+    { "AecPipelineChunk", "audio" },
+    { "JsDelivery", "audio" },
+    { "ProcessStream", "apm" },
+    { "ProcessReverseStream", "apm" },
+};
+
+namespace internal {
+std::atomic<TraceOutput> g_trace_output{TraceOutput::kOff};
+}
+
+namespace {
+
+struct TraceRecord {
+    const char* name;      // static strings only: ours, or WebRTC's literals
+    const char* category;
+    char phase;            // 'X' complete span, or WebRTC's 'B'/'E'/'I'
+    uint64_t ts_ns;        // steady clock
+    uint64_t dur_ns;
+    uint64_t tid;
+    int64_t value;
+};
+
+// Bounded MPSC ring with sequence-numbered slots (as LogRing): producers
+// claim a slot with one CAS, drop when full, and never block
+class TraceRing {
+public:
+    explicit TraceRing(size_t capacity) : mask_(capacity - 1), slots_(new Slot[capacity]) {
+        for (size_t i = 0; i < capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    void Write(const TraceRecord& record) {
+        size_t pos = write_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (write_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                pos = write_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record = record;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    bool Read(TraceRecord* out) {
+        Slot& slot = slots_[read_pos_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != read_pos_ + 1) {
+            return false;
+        }
+        *out = slot.record;
+        slot.sequence.store(read_pos_ + mask_ + 1, std::memory_order_release);
+        ++read_pos_;
+        return true;
+    }
+
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        TraceRecord record;
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<size_t> write_pos_{0};
+    size_t read_pos_ = 0;  // writer thread only
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// Constructed at load so producers never race its creation
+TraceRing g_ring(kTraceRingCapacity);
+
+// Written by Start/Stop on a JS thread, read by the writer thread it starts
+struct Session {
+    FILE* file = nullptr;
+    uint64_t start_ns = 0;
+    uint64_t dropped_at_start = 0;
+    bool first_event = true;
+    std::thread writer;
+    std::atomic<bool> running{false};
+};
+Session g_session;
+
+// Start/Stop may come from any env's JS thread (main or worker)
+std::mutex g_control_mutex;
+
+// WebRTC's TRACE_EVENT macros poll this byte through the pointer we hand out
+unsigned char g_webrtc_enabled = 0;
+bool g_webrtc_hooked = false;
+
+#if defined(__APPLE__)
+os_log_t g_signpost_log = nullptr;
+#endif
+
+uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const unsigned char* WebRtcCategoryEnabled(const char* /*name*/) {
+    return &g_webrtc_enabled;
+}
+
+void WebRtcTraceEvent(char phase, const unsigned char* /*category_enabled*/, const char* name,
+                      unsigned long long /*id*/, int /*num_args*/, const char** /*arg_names*/,
+                      const unsigned char* /*arg_types*/, const unsigned long long* /*arg_values*/,
+                      unsigned char /*flags*/) {
+    if (PipelineTraceOutput() != TraceOutput::kChromeJson) {
+        return;
+    }
+    g_ring.Write(TraceRecord{name, "webrtc", phase, NowNs(), 0, CurrentThreadId(), 0});
+}
+
+// Writer thread. Records from before this session (spans that straddled a
+// stop) are skipped.
+void WriteEvents() {
+    static const int pid = static_cast<int>(getpid());
+    TraceRecord record;
+    while (g_ring.Read(&record)) {
+        if (record.ts_ns < g_session.start_ns) {
+            continue;
+        }
+        double ts_us = (record.ts_ns - g_session.start_ns) / 1000.0;
+        std::fprintf(g_session.file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%llu",
+                     g_session.first_event ? "" : ",\n", record.name, record.category, record.phase, ts_us, pid,
+                     static_cast<unsigned long long>(record.tid));
+        if (record.phase == 'X') {
+            std::fprintf(g_session.file, ",\"dur\":%.3f,\"args\":{\"value\":%lld}", record.dur_ns / 1000.0,
+                         static_cast<long long>(record.value));
+        } else if (record.phase == 'I') {
+            std::fprintf(g_session.file, ",\"s\":\"t\"");
+        }
+        std::fputs("}", g_session.file);
+        g_session.first_event = false;
+    }
+}
+
+void WriterLoop() {
+    while (g_session.running.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(kDrainInterval);
+        WriteEvents();
+    }
+}
+
+} // namespace
+
+bool StartPipelineTrace(TraceOutput output, const char* path) {
+    std::lock_guard<std::mutex> lock(g_control_mutex);
+    if (PipelineTraceOutput() != TraceOutput::kOff) {
+        Log(LogLevel::kWarn, kLogSource, "Pipeline trace already running");
+        return false;
+    }
+
+    if (output == TraceOutput::kSignposts) {
+#if defined(__APPLE__)
+        if (!g_signpost_log) {
+            g_signpost_log = os_log_create("com.kakarot.audio", "Pipeline");
+        }
+        internal::g_trace_output.store(output, std::memory_order_relaxed);
+        Log(LogLevel::kInfo, kLogSource, "Pipeline trace started (os_signpost)");
+        return true;
+#else
+        Log(LogLevel::kError, kLogSource, "os_signpost tracing is only available on macOS");
+        return false;
+#endif
+    }
+    if (output != TraceOutput::kChromeJson) {
+        return false;
+    }
+
+    FILE* file = path ? std::fopen(path, "w") : nullptr;
+    if (!file) {
+        Log(LogLevel::kError, kLogSource, "Cannot open trace file %s", path ? path : "(none)");
+        return false;
+    }
+    // Array format: a trace cut short (crash, kill) still loads
+    std::fputs("[\n", file);
+
+    if (!g_webrtc_hooked) {
+        webrtc::SetupEventTracer(&WebRtcCategoryEnabled, &WebRtcTraceEvent);
+        g_webrtc_hooked = true;
+    }
+    g_session.file = file;
+    g_session.start_ns = NowNs();
+    g_session.dropped_at_start = g_ring.Dropped();
+    g_session.first_event = true;
+    g_session.running.store(true, std::memory_order_release);
+    g_session.writer = std::thread(&WriterLoop);
+
+    g_webrtc_enabled = 1;
+    internal::g_trace_output.store(output, std::memory_order_relaxed);
+    Log(LogLevel::kInfo, kLogSource, "Pipeline trace started (%s)", path);
+    return true;
+}
+
+void StopPipelineTrace() {
+    std::lock_guard<std::mutex> lock(g_control_mutex);
+    TraceOutput output = PipelineTraceOutput();
+    if (output == TraceOutput::kOff) {
+        return;
+    }
+    internal::g_trace_output.store(TraceOutput::kOff, std::memory_order_relaxed);
+    Log(LogLevel::kInfo, kLogSource, "Pipeline trace stopped");
+    if (output != TraceOutput::kChromeJson) {
+        return;
+    }
+
+    g_webrtc_enabled = 0;
+    g_session.running.store(false, std::memory_order_release);
+    if (g_session.writer.joinable()) {
+        g_session.writer.join();
+    }
+    WriteEvents();
+
+    uint64_t dropped = g_ring.Dropped() - g_session.dropped_at_start;
+    if (dropped > 0) {
+        std::fprintf(g_session.file, "%s{\"name\":\"TraceEventsDropped\",\"ph\":\"I\",\"s\":\"g\",\"ts\":%.3f,\"pid\":%d,"
+                     "\"tid\":0,\"args\":{\"count\":%llu}}", g_session.first_event ? "" : ",\n",
+                     (NowNs() - g_session.start_ns) / 1000.0, static_cast<int>(getpid()),
+                     static_cast<unsigned long long>(dropped));
+        Log(LogLevel::kWarn, kLogSource, "%llu trace event(s) dropped (ring full)",
+            static_cast<unsigned long long>(dropped));
+    }
+    std::fputs("\n]\n", g_session.file);
+    std::fclose(g_session.file);
+    g_session.file = nullptr;
+}
+
+#if defined(__APPLE__)
+// os_signpost wants literal names, hence one case per event
+#define KAKAROT_SIGNPOST_CASES(emit)                                   \
+    switch (event_) {                                                  \
+        case TraceEvent::kMicIOProc: emit("MicIOProc"); break;         \
+        case TraceEvent::kSystemTapIOProc: emit("SystemTapIOProc"); break; \
+        case TraceEvent::kAecPipelineChunk: emit("AecPipelineChunk"); break; \
+        case TraceEvent::kJsDelivery: emit("JsDelivery"); break;       \
+        case TraceEvent::kProcessStream: emit("ProcessStream"); break; \
+        case TraceEvent::kProcessReverseStream: emit("ProcessReverseStream"); break; \
+    }
+#endif
+
+void TraceScope::Begin() {
+    if (output_ == TraceOutput::kChromeJson) {
+        start_ns_ = NowNs();
+        return;
+    }
+#if defined(__APPLE__)
+    signpost_id_ = os_signpost_id_generate(g_signpost_log);
+#define KAKAROT_SIGNPOST_BEGIN(name) \
+    os_signpost_interval_begin(g_signpost_log, signpost_id_, name, "%lld", static_cast<long long>(value_))
+    KAKAROT_SIGNPOST_CASES(KAKAROT_SIGNPOST_BEGIN)
+#undef KAKAROT_SIGNPOST_BEGIN
+#endif
+}
+
+void TraceScope::End() {
+    if (output_ == TraceOutput::kChromeJson) {
+        const auto& info = kEvents[static_cast<size_t>(event_)];
+        g_ring.Write(TraceRecord{info.name, info.category, 'X', start_ns_, NowNs() - start_ns_, CurrentThreadId(), value_});
+        return;
+    }
+#if defined(__APPLE__)
+#define KAKAROT_SIGNPOST_END(name) os_signpost_interval_end(g_signpost_log, signpost_id_, name)
+    KAKAROT_SIGNPOST_CASES(KAKAROT_SIGNPOST_END)
+#undef KAKAROT_SIGNPOST_END
+#endif
+}
+
+} // namespace kakarot
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace kakarot {
+
+enum class TraceOutput : uint8_t { kOff, kChromeJson, kSignposts };
+
+// Spans the pipeline marks. Names are fixed so the signpost backend can
+// hand os_signpost the string literals it requires.
+enum class TraceEvent : uint8_t {
+    kMicIOProc,             // mic IOProc callback
+    kSystemTapIOProc,       // process-tap IOProc callback
+    kAecPipelineChunk,      // one capture chunk through the native AEC pipeline
+    kJsDelivery,            // a capture delivery's TSFN callback on the JS thread
+    kProcessStream,         // one capture frame through the APM (or fallback)
+    kProcessReverseStream,  // one render frame into the APM (or fallback)
+};
+
+// Process-wide tracing of the native pipeline, off by default. kChromeJson
+// writes chrome://tracing / Perfetto JSON to |path| from a background thread
+// and also records the APM's internal trace events; kSignposts emits
+// os_signpost intervals for Instruments (macOS only; |path| is ignored).
+// Events are recorded without locks or allocation, so the real-time threads
+// are safe to trace. Start and stop are serialized, so any JS thread may
+// call them. Returns false (and logs) when tracing is already on or the
+// output cannot be opened.
+bool StartPipelineTrace(TraceOutput output, const char* path);
+
+// Ends the trace; a Chrome JSON file is complete once this returns
+void StopPipelineTrace();
+
+namespace internal {
+extern std::atomic<TraceOutput> g_trace_output;
+}
+
+inline TraceOutput PipelineTraceOutput() {
+    return internal::g_trace_output.load(std::memory_order_relaxed);
+}
+
+// Marks the enclosing scope as |event|; |value| (sample or frame count) is
+// attached as an argument. A single relaxed load when tracing is off.
+class TraceScope {
+public:
+    explicit TraceScope(TraceEvent event, int64_t value = 0)
+        : output_(PipelineTraceOutput()), event_(event), value_(value) {
+        if (output_ != TraceOutput::kOff) {
+            Begin();
+        }
+    }
+
+    ~TraceScope() {
+        if (output_ != TraceOutput::kOff) {
+            End();
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    void Begin();
+    void End();
+
+    const TraceOutput output_;
+    const TraceEvent event_;
+    const int64_t value_;
+    uint64_t start_ns_ = 0;
+    uint64_t signpost_id_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,385 @@
+#include "pipewire_capture.h"
+#include "host_time.h"
+#include "native_log.h"
+#include <pipewire/extensions/metadata.h>
+#include <spa/param/audio/format-utils.h>
+#include <spa/pod/builder.h>
+#include <algorithm>
+#include <cstring>
+
+namespace kakarot {
+
+static const char* const kLogSource = "PipeWireCapture";
+
+// Matches the IOProc sanity limit
+static constexpr uint32_t kMaxFramesPerBuffer = 48000;
+
+// Quantum we ask the graph for: 10ms, one APM frame
+static const char* const kNodeLatency = "480/48000";
+
+// Linking waits on the session manager; give up after this
+static constexpr int kConnectTimeoutSeconds = 3;
+
+static const char* SourceName(CaptureSource source) {
+    return source == CaptureSource::kLoopback ? "Loopback" : "Microphone";
+}
+
+static void EnsurePipeWireInit() {
+    static std::once_flag once;
+    std::call_once(once, [] { pw_init(nullptr, nullptr); });
+}
+
+PipeWireCapture::PipeWireCapture(CaptureSource source, RealtimeSink sink, void* sink_context)
+    : source_(source), sink_(sink), sink_context_(sink_context) {}
+
+PipeWireCapture::~PipeWireCapture() {
+    Stop();
+}
+
+// ListInputDevices() state: the registry walk, then the "default" metadata
+// for which source is the default
+namespace {
+struct RegistryScan {
+    pw_main_loop* loop = nullptr;
+    pw_registry* registry = nullptr;
+    pw_metadata* metadata = nullptr;
+    spa_hook metadata_listener{};
+    int pending = 0;
+    std::vector<InputDeviceInfo> devices;
+    std::string default_name;
+};
+} // namespace
+
+// default.audio.source is JSON: {"name":"alsa_input.pci-0000_00_1f.3.analog-stereo"}
+static std::string JsonName(const char* value) {
+    static const char kKey[] = "\"name\":\"";
+    const char* start = std::strstr(value, kKey);
+    if (!start) {
+        return std::string();
+    }
+    start += sizeof(kKey) - 1;
+    const char* end = std::strchr(start, '"');
+    return end ? std::string(start, end) : std::string();
+}
+
+static int OnMetadataProperty(void* data, uint32_t, const char* key, const char*, const char* value) {
+    auto* scan = static_cast<RegistryScan*>(data);
+    if (key && value && std::strcmp(key, "default.audio.source") == 0) {
+        scan->default_name = JsonName(value);
+    }
+    return 0;
+}
+
+static const pw_metadata_events kMetadataEvents = [] {
+    pw_metadata_events events = {};
+    events.version = PW_VERSION_METADATA_EVENTS;
+    events.property = &OnMetadataProperty;
+    return events;
+}();
+
+static void OnRegistryGlobal(void* data, uint32_t id, uint32_t, const char* type, uint32_t, const spa_dict* props) {
+    auto* scan = static_cast<RegistryScan*>(data);
+    if (!props) {
+        return;
+    }
+    if (std::strcmp(type, PW_TYPE_INTERFACE_Node) == 0) {
+        const char* media_class = spa_dict_lookup(props, PW_KEY_MEDIA_CLASS);
+        const char* name = spa_dict_lookup(props, PW_KEY_NODE_NAME);
+        if (media_class && name && std::strcmp(media_class, "Audio/Source") == 0) {
+            const char* description = spa_dict_lookup(props, PW_KEY_NODE_DESCRIPTION);
+            InputDeviceInfo info;
+            info.id = name;
+            info.name = description ? description : name;
+            scan->devices.push_back(info);
+        }
+    } else if (std::strcmp(type, PW_TYPE_INTERFACE_Metadata) == 0 && !scan->metadata) {
+        const char* name = spa_dict_lookup(props, PW_KEY_METADATA_NAME);
+        if (name && std::strcmp(name, "default") == 0) {
+            scan->metadata = static_cast<pw_metadata*>(
+                pw_registry_bind(scan->registry, id, type, PW_VERSION_METADATA, 0));
+            if (scan->metadata) {
+                pw_metadata_add_listener(scan->metadata, &scan->metadata_listener, &kMetadataEvents, scan);
+            }
+        }
+    }
+}
+
+static const pw_registry_events kRegistryEvents = [] {
+    pw_registry_events events = {};
+    events.version = PW_VERSION_REGISTRY_EVENTS;
+    events.global = &OnRegistryGlobal;
+    return events;
+}();
+
+static void OnCoreDone(void* data, uint32_t id, int seq) {
+    auto* scan = static_cast<RegistryScan*>(data);
+    if (id == PW_ID_CORE && seq == scan->pending) {
+        pw_main_loop_quit(scan->loop);
+    }
+}
+
+static void OnCoreError(void* data, uint32_t id, int, int res, const char* message) {
+    auto* scan = static_cast<RegistryScan*>(data);
+    if (id == PW_ID_CORE) {
+        Log(LogLevel::kWarn, kLogSource, "Device scan: %s (%d)", message ? message : "core error", res);
+        pw_main_loop_quit(scan->loop);
+    }
+}
+
+static const pw_core_events kCoreEvents = [] {
+    pw_core_events events = {};
+    events.version = PW_VERSION_CORE_EVENTS;
+    events.done = &OnCoreDone;
+    events.error = &OnCoreError;
+    return events;
+}();
+
+static void Roundtrip(pw_core* core, RegistryScan* scan) {
+    scan->pending = pw_core_sync(core, PW_ID_CORE, scan->pending);
+    pw_main_loop_run(scan->loop);
+}
+
+std::vector<InputDeviceInfo> PipeWireCapture::ListInputDevices() {
+    EnsurePipeWireInit();
+    RegistryScan scan;
+
+    scan.loop = pw_main_loop_new(nullptr);
+    if (!scan.loop) {
+        return scan.devices;
+    }
+    pw_context* context = pw_context_new(pw_main_loop_get_loop(scan.loop), nullptr, 0);
+    pw_core* core = context ? pw_context_connect(context, nullptr, 0) : nullptr;
+    if (!core) {
+        Log(LogLevel::kWarn, kLogSource, "Device scan: connecting to PipeWire failed");
+        if (context) {
+            pw_context_destroy(context);
+        }
+        pw_main_loop_destroy(scan.loop);
+        return scan.devices;
+    }
+
+    spa_hook core_listener{};
+    spa_hook registry_listener{};
+    pw_core_add_listener(core, &core_listener, &kCoreEvents, &scan);
+    scan.registry = pw_core_get_registry(core, PW_VERSION_REGISTRY, 0);
+    pw_registry_add_listener(scan.registry, &registry_listener, &kRegistryEvents, &scan);
+
+    // First round trip delivers the globals, the second the metadata bound
+    // during the first
+    Roundtrip(core, &scan);
+    if (scan.metadata) {
+        Roundtrip(core, &scan);
+    }
+
+    for (InputDeviceInfo& info : scan.devices) {
+        info.is_default = info.id == scan.default_name;
+    }
+
+    if (scan.metadata) {
+        spa_hook_remove(&scan.metadata_listener);
+        pw_proxy_destroy(reinterpret_cast<pw_proxy*>(scan.metadata));
+    }
+    spa_hook_remove(&registry_listener);
+    pw_proxy_destroy(reinterpret_cast<pw_proxy*>(scan.registry));
+    spa_hook_remove(&core_listener);
+    pw_core_disconnect(core);
+    pw_context_destroy(context);
+    pw_main_loop_destroy(scan.loop);
+    return scan.devices;
+}
+
+bool PipeWireCapture::Start(const std::string& device_id, std::string* error) {
+    if (loop_) {
+        *error = "PipeWire capture already started";
+        return false;
+    }
+    EnsurePipeWireInit();
+
+    static const pw_stream_events kStreamEvents = [] {
+        pw_stream_events events = {};
+        events.version = PW_VERSION_STREAM_EVENTS;
+        events.state_changed = &PipeWireCapture::OnStateChanged;
+        events.param_changed = &PipeWireCapture::OnParamChanged;
+        events.process = &PipeWireCapture::OnProcess;
+        return events;
+    }();
+
+    std::string target = source_ == CaptureSource::kMicrophone ? device_id : std::string();
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        device_id_ = target;
+    }
+
+    loop_ = pw_thread_loop_new(source_ == CaptureSource::kLoopback ? "kakarot-loopback" : "kakarot-mic", nullptr);
+    if (!loop_ || pw_thread_loop_start(loop_) != 0) {
+        *error = "Starting the PipeWire loop failed";
+        Destroy();
+        return false;
+    }
+
+    pw_properties* props = pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio", PW_KEY_MEDIA_CATEGORY, "Capture",
+                                             PW_KEY_MEDIA_ROLE, "Communication", PW_KEY_NODE_LATENCY,
+                                             kNodeLatency, nullptr);
+    if (source_ == CaptureSource::kLoopback) {
+        pw_properties_set(props, PW_KEY_STREAM_CAPTURE_SINK, "true");
+    } else if (!target.empty()) {
+        pw_properties_set(props, PW_KEY_TARGET_OBJECT, target.c_str());
+    }
+
+    pw_thread_loop_lock(loop_);
+    state_ = PW_STREAM_STATE_UNCONNECTED;
+    stream_error_.clear();
+    // Takes ownership of |props|
+    stream_ = pw_stream_new_simple(pw_thread_loop_get_loop(loop_), SourceName(source_), props, &kStreamEvents, this);
+    if (!stream_) {
+        pw_thread_loop_unlock(loop_);
+        *error = "Creating the PipeWire stream failed";
+        Destroy();
+        return false;
+    }
+
+    // What the sink takes; the adapter converts from the node's format
+    uint8_t pod_buffer[512];
+    spa_pod_builder builder;
+    spa_pod_builder_init(&builder, pod_buffer, sizeof(pod_buffer));
+    spa_audio_info_raw info = {};
+    info.format = SPA_AUDIO_FORMAT_F32;
+    info.rate = static_cast<uint32_t>(kSampleRate);
+    info.channels = 1;
+    info.position[0] = SPA_AUDIO_CHANNEL_MONO;
+    const spa_pod* params[] = { spa_format_audio_raw_build(&builder, SPA_PARAM_EnumFormat, &info) };
+
+    int result = pw_stream_connect(stream_, PW_DIRECTION_INPUT, PW_ID_ANY,
+                                   static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT |
+                                                                PW_STREAM_FLAG_MAP_BUFFERS |
+                                                                PW_STREAM_FLAG_RT_PROCESS),
+                                   params, 1);
+    std::string failure;
+    if (result < 0) {
+        failure = std::strerror(-result);
+    } else {
+        // The session manager links the stream; OnStateChanged signals
+        while (state_ != PW_STREAM_STATE_STREAMING && state_ != PW_STREAM_STATE_ERROR) {
+            if (pw_thread_loop_timed_wait(loop_, kConnectTimeoutSeconds) != 0) {
+                failure = "timed out waiting for a link";
+                break;
+            }
+        }
+        if (state_ == PW_STREAM_STATE_ERROR) {
+            failure = stream_error_.empty() ? "stream error" : stream_error_;
+        }
+    }
+    pw_thread_loop_unlock(loop_);
+
+    if (!failure.empty()) {
+        *error = "Connecting the PipeWire stream failed: " + failure;
+        Destroy();
+        return false;
+    }
+
+    running_.store(true, std::memory_order_release);
+    Log(LogLevel::kInfo, kLogSource, "%s capture started on %s (%u ch @ %.0f Hz, delivered mono @ %.0f Hz)",
+        SourceName(source_), target.empty() ? "the default node" : target.c_str(),
+        channels_.load(std::memory_order_relaxed), rate_.load(std::memory_order_relaxed), kSampleRate);
+    return true;
+}
+
+void PipeWireCapture::Stop() {
+    Destroy();
+}
+
+std::string PipeWireCapture::DeviceId() const {
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    return device_id_;
+}
+
+// Destroying the stream under the loop lock removes it from the data thread,
+// so no process callback runs after it returns
+void PipeWireCapture::Destroy() {
+    if (stream_) {
+        pw_thread_loop_lock(loop_);
+        pw_stream_destroy(stream_);
+        stream_ = nullptr;
+        pw_thread_loop_unlock(loop_);
+    }
+    if (loop_) {
+        pw_thread_loop_stop(loop_);
+        pw_thread_loop_destroy(loop_);
+        loop_ = nullptr;
+    }
+    running_.store(false, std::memory_order_release);
+}
+
+// Loop thread
+void PipeWireCapture::OnStateChanged(void* data, pw_stream_state, pw_stream_state state, const char* error) {
+    auto* self = static_cast<PipeWireCapture*>(data);
+    self->state_ = state;
+    if (state == PW_STREAM_STATE_ERROR) {
+        self->stream_error_ = error ? error : std::string();
+        if (self->running_.exchange(false, std::memory_order_acq_rel)) {
+            Log(LogLevel::kError, kLogSource, "%s stream failed: %s", SourceName(self->source_),
+                error ? error : "unknown error");
+        }
+    } else if (state == PW_STREAM_STATE_UNCONNECTED && self->running_.exchange(false, std::memory_order_acq_rel)) {
+        Log(LogLevel::kError, kLogSource, "%s stream disconnected; capture stopped", SourceName(self->source_));
+    }
+    pw_thread_loop_signal(self->loop_, false);
+}
+
+// Loop thread
+void PipeWireCapture::OnParamChanged(void* data, uint32_t id, const spa_pod* param) {
+    auto* self = static_cast<PipeWireCapture*>(data);
+    if (id != SPA_PARAM_Format || !param) {
+        return;
+    }
+    spa_audio_info_raw info = {};
+    if (spa_format_audio_raw_parse(param, &info) >= 0) {
+        self->channels_.store(info.channels, std::memory_order_relaxed);
+        self->rate_.store(info.rate, std::memory_order_relaxed);
+    }
+}
+
+// Data thread: one buffer per graph cycle. No allocation, no locks.
+void PipeWireCapture::OnProcess(void* data) {
+    auto* self = static_cast<PipeWireCapture*>(data);
+    const uint64_t callback_start = HostTimeNow();
+
+    pw_buffer* buffer = pw_stream_dequeue_buffer(self->stream_);
+    if (!buffer) {
+        return;
+    }
+    spa_data& plane = buffer->buffer->datas[0];
+    if (plane.data && plane.chunk) {
+        uint32_t offset = std::min(plane.chunk->offset, plane.maxsize);
+        uint32_t size = std::min(plane.chunk->size, plane.maxsize - offset);
+        uint32_t frames = size / sizeof(float);
+        if (frames > kMaxFramesPerBuffer) {
+            if (self->stats_) {
+                self->stats_->buffers_oversized.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else if (frames > 0) {
+            // |now| is the cycle's monotonic time and |delay| how long ago,
+            // in graph ticks, the end of this buffer left the device
+            uint64_t host_time = callback_start;
+            pw_time time = {};
+            if (pw_stream_get_time_n(self->stream_, &time, sizeof(time)) == 0 && time.now > 0 &&
+                time.rate.denom > 0) {
+                int64_t delay_ns = time.delay * SPA_NSEC_PER_SEC * time.rate.num / time.rate.denom;
+                int64_t span_ns = static_cast<int64_t>(frames * SPA_NSEC_PER_SEC / kSampleRate);
+                int64_t first_frame = time.now - delay_ns - span_ns;
+                if (first_frame > 0) {
+                    host_time = static_cast<uint64_t>(first_frame);
+                }
+            }
+            const auto* samples = reinterpret_cast<const float*>(static_cast<const uint8_t*>(plane.data) + offset);
+            self->sink_(self->sink_context_, samples, frames, host_time);
+        }
+    }
+    pw_stream_queue_buffer(self->stream_, buffer);
+
+    if (self->stats_) {
+        self->stats_->RecordCallback(callback_start, HostTimeNow());
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <pipewire/pipewire.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "capture_backend.h"
+#include "capture_stats.h"
+
+namespace kakarot {
+
+// PipeWire capture stream, replacing the pw-record subprocess. The stream
+// asks for 48kHz mono float and PipeWire's adapter converts, so |sink| sees
+// the same frames as on macOS. RT_PROCESS runs the process callback on the
+// PipeWire data thread, which the daemon schedules real-time; each buffer is
+// handed over with its capture time in HostTimeNow() (CLOCK_MONOTONIC)
+// nanoseconds. Loopback captures the default sink's monitor and follows the
+// default sink as it moves; so does a microphone with no pinned node.
+class PipeWireCapture {
+public:
+    static constexpr double kSampleRate = 48000.0;
+    static constexpr const char* kBackendName = "PipeWire";
+    static constexpr const char* kTransport = "pipewire";  // getDevices() transport
+
+    PipeWireCapture(CaptureSource source, RealtimeSink sink, void* sink_context);
+    ~PipeWireCapture();
+
+    PipeWireCapture(const PipeWireCapture&) = delete;
+    PipeWireCapture& operator=(const PipeWireCapture&) = delete;
+
+    // Audio/Source nodes, by node name; one registry round trip
+    static std::vector<InputDeviceInfo> ListInputDevices();
+
+    // Connects to |device_id| (a node name from ListInputDevices(),
+    // microphone only) or, when empty, the default, and returns once the
+    // stream is linked and streaming
+    bool Start(const std::string& device_id, std::string* error);
+
+    // Disconnects the stream; no frames after this returns
+    void Stop();
+
+    // Counters for the data thread. Must be set before Start() and outlive
+    // Stop().
+    void SetStats(CaptureStats* stats) { stats_ = stats; }
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    double SampleRate() const { return kSampleRate; }
+
+    // Negotiated stream format (after the adapter's conversion)
+    uint32_t Channels() const { return channels_.load(std::memory_order_relaxed); }
+    double MixSampleRate() const { return rate_.load(std::memory_order_relaxed); }
+
+    // Node requested at Start(); empty when following the default
+    std::string DeviceId() const;
+
+private:
+    static void OnStateChanged(void* data, pw_stream_state old_state, pw_stream_state state, const char* error);
+    static void OnParamChanged(void* data, uint32_t id, const spa_pod* param);
+    static void OnProcess(void* data);
+    void Destroy();
+
+    const CaptureSource source_;
+    RealtimeSink sink_;
+    void* sink_context_;
+    CaptureStats* stats_ = nullptr;
+
+    mutable std::mutex device_mutex_;
+    std::string device_id_;
+
+    // Created by Start(), destroyed by Stop(); the stream is only touched
+    // with the loop lock held or from its own callbacks
+    pw_thread_loop* loop_ = nullptr;
+    pw_stream* stream_ = nullptr;
+    pw_stream_state state_ = PW_STREAM_STATE_UNCONNECTED;
+    std::string stream_error_;
+
+    std::atomic<bool> running_{false};
+    std::atomic<uint32_t> channels_{0};
+    std::atomic<double> rate_{0.0};
+};
+
+} // namespace kakarot
@@ -0,0 +1,351 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#include <os/workgroup.h>
+#include <pthread.h>
+#include <time.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <avrt.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace kakarot {
+
+// Counting semaphore the real-time producers can signal: dispatch on macOS,
+// a kernel semaphore on Windows, POSIX sem_t on Linux. Signal() never
+// allocates or takes a lock on any of them.
+class Semaphore {
+public:
+#if defined(__APPLE__)
+    Semaphore() : semaphore_(dispatch_semaphore_create(0)) {}
+    ~Semaphore() { dispatch_release(semaphore_); }
+
+    void Signal() { dispatch_semaphore_signal(semaphore_); }
+    void Wait() { dispatch_semaphore_wait(semaphore_, DISPATCH_TIME_FOREVER); }
+    void WaitFor(int64_t timeout_ns) {
+        dispatch_semaphore_wait(semaphore_, dispatch_time(DISPATCH_TIME_NOW, timeout_ns));
+    }
+#elif defined(_WIN32)
+    Semaphore() : semaphore_(CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr)) {}
+    ~Semaphore() { CloseHandle(semaphore_); }
+
+    void Signal() { ReleaseSemaphore(semaphore_, 1, nullptr); }
+    void Wait() { WaitForSingleObject(semaphore_, INFINITE); }
+    void WaitFor(int64_t timeout_ns) {
+        WaitForSingleObject(semaphore_, static_cast<DWORD>((timeout_ns + 999999) / 1000000));
+    }
+#else
+    Semaphore() { sem_init(&semaphore_, 0, 0); }
+    ~Semaphore() { sem_destroy(&semaphore_); }
+
+    void Signal() { sem_post(&semaphore_); }
+    void Wait() {
+        while (sem_wait(&semaphore_) != 0) {
+            // EINTR
+        }
+    }
+    // sem_timedwait takes a CLOCK_REALTIME deadline; a wall clock step only
+    // stretches or shortens one poll
+    void WaitFor(int64_t timeout_ns) {
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        int64_t nsec = deadline.tv_nsec + timeout_ns;
+        deadline.tv_sec += static_cast<time_t>(nsec / 1000000000);
+        deadline.tv_nsec = static_cast<long>(nsec % 1000000000);
+        sem_timedwait(&semaphore_, &deadline);
+    }
+#endif
+
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+private:
+#if defined(__APPLE__)
+    dispatch_semaphore_t semaphore_;
+#elif defined(_WIN32)
+    HANDLE semaphore_;
+#else
+    sem_t semaphore_;
+#endif
+};
+
+// A consumer's wake that polls while work comes in and blocks, with no
+// timer, once a whole poll has brought none, so an idle thread costs no
+// wakeups and a busy one still batches. Producers Notify() after each
+// write; that signals only a parked consumer, so while work flows it is one
+// relaxed load. Realtime-safe on the producer side.
+class IdleSignal {
+public:
+    // Consumer. Up to |timeout_ns| while |idle| is false; once it is true,
+    // until Notify() or Signal(). |idle| is the queue being empty after a
+    // poll that found it empty too.
+    template <typename Idle>
+    void Wait(int64_t timeout_ns, Idle idle) {
+        parked_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idle()) {
+            semaphore_.Wait();
+            parked_.store(false, std::memory_order_relaxed);
+            return;
+        }
+        // Polling: writes must not cut the interval short. A Notify() that
+        // raced the check costs one early wake, no more.
+        parked_.store(false, std::memory_order_relaxed);
+        semaphore_.WaitFor(timeout_ns);
+    }
+
+    // Producer, after each write
+    void Notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_.load(std::memory_order_relaxed) && parked_.exchange(false, std::memory_order_acq_rel)) {
+            semaphore_.Signal();
+        }
+    }
+
+    // Any thread: wakes the consumer parked or not (Stop())
+    void Signal() { semaphore_.Signal(); }
+
+private:
+    Semaphore semaphore_;
+    std::atomic<bool> parked_{false};
+};
+
+enum class ThreadPriority {
+    kInteractive,  // DSP: ahead of Electron's main and renderer work
+    kUtility,      // log draining and other background work
+};
+
+// Neither platform pins cores; the scheduling class is all we set
+inline void SetCurrentThreadPriority(ThreadPriority priority) {
+#if defined(__APPLE__)
+    pthread_set_qos_class_self_np(
+        priority == ThreadPriority::kInteractive ? QOS_CLASS_USER_INTERACTIVE : QOS_CLASS_UTILITY, 0);
+#elif defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), priority == ThreadPriority::kInteractive
+                                              ? THREAD_PRIORITY_HIGHEST : THREAD_PRIORITY_BELOW_NORMAL);
+#else
+    // Raising priority needs rtkit or CAP_SYS_NICE; lowering it does not
+    if (priority == ThreadPriority::kUtility) {
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+    }
+#endif
+}
+
+// Real-time scheduling for the calling thread while in scope, for a worker
+// that has to keep pace with an audio IO thread: a time-constraint policy
+// sized to |period_ms| on macOS, MMCSS "Pro Audio" on Windows, SCHED_FIFO on
+// Linux where rtkit or CAP_SYS_NICE allow it. When the system refuses, the
+// thread keeps kInteractive.
+class RealtimeThreadScope {
+public:
+    explicit RealtimeThreadScope(double period_ms) {
+        SetCurrentThreadPriority(ThreadPriority::kInteractive);
+#if defined(__APPLE__)
+        // Half the period to compute in; the kernel demotes a thread that
+        // keeps overrunning it, so this is a budget, not a hint
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        double ticks_per_ms = 1e6 * timebase.denom / timebase.numer;
+        thread_time_constraint_policy_data_t policy;
+        policy.period = static_cast<uint32_t>(period_ms * ticks_per_ms);
+        policy.computation = policy.period / 2;
+        policy.constraint = policy.period;
+        policy.preemptible = TRUE;
+        realtime_ = thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_TIME_CONSTRAINT_POLICY,
+                                      reinterpret_cast<thread_policy_t>(&policy),
+                                      THREAD_TIME_CONSTRAINT_POLICY_COUNT) == KERN_SUCCESS;
+#elif defined(_WIN32)
+        (void)period_ms;
+        DWORD task_index = 0;
+        mmcss_ = AvSetMmThreadCharacteristicsW(L"Pro Audio", &task_index);
+        realtime_ = mmcss_ != nullptr;
+#else
+        (void)period_ms;
+        // Below PipeWire's data loop, which rtkit runs at 88
+        sched_param param{};
+        param.sched_priority = 10;
+        realtime_ = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+    }
+
+    ~RealtimeThreadScope() {
+#if defined(_WIN32)
+        if (mmcss_) {
+            AvRevertMmThreadCharacteristics(mmcss_);
+        }
+#elif !defined(__APPLE__)
+        if (realtime_) {
+            sched_param param{};
+            pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+        }
+#endif
+    }
+
+    RealtimeThreadScope(const RealtimeThreadScope&) = delete;
+    RealtimeThreadScope& operator=(const RealtimeThreadScope&) = delete;
+
+    bool IsRealtime() const { return realtime_; }
+
+private:
+#if defined(_WIN32)
+    HANDLE mmcss_ = nullptr;
+#endif
+    bool realtime_ = false;
+};
+
+// A device's audio IO workgroup, retained while held. A worker that joins it
+// is scheduled against the IO thread's deadline, on the performance cores.
+// Only macOS has them; elsewhere this is always empty.
+class AudioWorkgroup {
+public:
+    AudioWorkgroup() = default;
+#if defined(__APPLE__)
+    // Takes over a reference the caller owns, as CoreAudio hands them out
+    static AudioWorkgroup Adopt(os_workgroup_t workgroup) {
+        AudioWorkgroup adopted;
+        adopted.workgroup_ = workgroup;
+        return adopted;
+    }
+    os_workgroup_t Get() const { return workgroup_; }
+
+    AudioWorkgroup(const AudioWorkgroup& other) : workgroup_(other.workgroup_) {
+        if (workgroup_) {
+            os_retain(workgroup_);
+        }
+    }
+    AudioWorkgroup(AudioWorkgroup&& other) noexcept : workgroup_(std::exchange(other.workgroup_, nullptr)) {}
+    AudioWorkgroup& operator=(AudioWorkgroup other) noexcept {
+        std::swap(workgroup_, other.workgroup_);
+        return *this;
+    }
+    ~AudioWorkgroup() {
+        if (workgroup_) {
+            os_release(workgroup_);
+        }
+    }
+
+    explicit operator bool() const { return workgroup_ != nullptr; }
+
+private:
+    os_workgroup_t workgroup_ = nullptr;
+#else
+    explicit operator bool() const { return false; }
+#endif
+};
+
+// The calling thread's membership of one AudioWorkgroup at a time. Join and
+// Leave on the same thread; joining another workgroup leaves the current one.
+class WorkgroupMembership {
+public:
+    WorkgroupMembership() = default;
+    ~WorkgroupMembership() { Leave(); }
+
+    WorkgroupMembership(const WorkgroupMembership&) = delete;
+    WorkgroupMembership& operator=(const WorkgroupMembership&) = delete;
+
+    // False when |workgroup| is empty or refused the thread (cancelled, or
+    // not joinable)
+    bool Join(const AudioWorkgroup& workgroup) {
+        Leave();
+#if defined(__APPLE__)
+        if (workgroup && os_workgroup_join(workgroup.Get(), &token_) == 0) {
+            joined_ = workgroup;
+            return true;
+        }
+#else
+        (void)workgroup;
+#endif
+        return false;
+    }
+
+    void Leave() {
+#if defined(__APPLE__)
+        if (joined_) {
+            os_workgroup_leave(joined_.Get(), &token_);
+            joined_ = AudioWorkgroup();
+        }
+#endif
+    }
+
+private:
+#if defined(__APPLE__)
+    AudioWorkgroup joined_;
+    os_workgroup_join_token_s token_{};
+#endif
+};
+
+// CPU time the calling thread has used, user and system, in nanoseconds
+inline uint64_t CurrentThreadCpuNs() {
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    uint64_t ticks = ((static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) +
+                     ((static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+    return ticks * 100;  // 100ns units
+#else
+    timespec now;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+// OS thread id, as profilers show it
+inline uint64_t CurrentThreadId() {
+#if defined(__APPLE__)
+    uint64_t tid = 0;
+    pthread_threadid_np(nullptr, &tid);
+    return tid;
+#elif defined(_WIN32)
+    return GetCurrentThreadId();
+#else
+    return static_cast<uint64_t>(syscall(SYS_gettid));
+#endif
+}
+
+// The calling thread's name in debuggers and profilers. Names are ASCII;
+// Linux keeps the first 15 characters.
+inline void SetCurrentThreadName(const char* name) {
+#if defined(__APPLE__)
+    pthread_setname_np(name);
+#elif defined(_WIN32)
+    wchar_t wide[64];
+    size_t i = 0;
+    for (; name[i] && i + 1 < sizeof(wide) / sizeof(wide[0]); ++i) {
+        wide[i] = static_cast<wchar_t>(name[i]);
+    }
+    wide[i] = L'\0';
+    SetThreadDescription(GetCurrentThread(), wide);
+#else
+    char truncated[16];
+    size_t i = 0;
+    for (; name[i] && i + 1 < sizeof(truncated); ++i) {
+        truncated[i] = name[i];
+    }
+    truncated[i] = '\0';
+    pthread_setname_np(pthread_self(), truncated);
+#endif
+}
+
+} // namespace kakarot
@@ -0,0 +1,145 @@
+#include "power_monitor.h"
+#include "native_log.h"
+#include <IOKit/IOMessage.h>
+#include <IOKit/ps/IOPSKeys.h>
+#include <IOKit/ps/IOPowerSources.h>
+#include <IOKit/pwr_mgt/IOPMLib.h>
+#include <notify.h>
+#include <unistd.h>
+
+namespace kakarot {
+
+static const char* const kLogSource = "PowerMonitor";
+
+PowerMonitor::~PowerMonitor() {
+    Stop();
+}
+
+void PowerMonitor::Start() {
+    if (queue_) {
+        return;
+    }
+    queue_ = dispatch_queue_create("kakarot.power", DISPATCH_QUEUE_SERIAL);
+    root_port_ = IORegisterForSystemPower(this, &notify_port_, &PowerMonitor::PowerChanged, &notifier_);
+    if (root_port_ == MACH_PORT_NULL) {
+        Log(LogLevel::kWarn, kLogSource, "Sleep/wake notifications unavailable");
+    } else {
+        IONotificationPortSetDispatchQueue(notify_port_, queue_);
+    }
+
+    on_battery_ = ReadOnBattery();
+    if (notify_register_file_descriptor(kIOPSNotifyPowerSource, &source_fd_, 0, &source_token_) != NOTIFY_STATUS_OK) {
+        Log(LogLevel::kWarn, kLogSource, "Power source notifications unavailable");
+        source_fd_ = -1;
+        return;
+    }
+    source_watch_ = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, static_cast<uintptr_t>(source_fd_), 0, queue_);
+    dispatch_set_context(source_watch_, this);
+    dispatch_source_set_event_handler_f(source_watch_, &PowerMonitor::PowerSourceChanged);
+    dispatch_resume(source_watch_);
+}
+
+void PowerMonitor::Stop() {
+    if (!queue_) {
+        return;
+    }
+    if (root_port_ != MACH_PORT_NULL) {
+        IODeregisterForSystemPower(&notifier_);
+        IOServiceClose(root_port_);
+        IONotificationPortDestroy(notify_port_);
+    }
+    if (source_watch_) {
+        dispatch_source_cancel(source_watch_);
+    }
+    // Wait out a notification already on the queue
+    dispatch_sync_f(queue_, nullptr, [](void*) {});
+    if (source_watch_) {
+        dispatch_release(source_watch_);
+        notify_cancel(source_token_);  // closes source_fd_
+    }
+    dispatch_release(queue_);
+    root_port_ = MACH_PORT_NULL;
+    notify_port_ = nullptr;
+    notifier_ = 0;
+    source_watch_ = nullptr;
+    source_fd_ = -1;
+    queue_ = nullptr;
+}
+
+void PowerMonitor::SetChangeCallback(std::function<void(bool awake)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_change_ = std::move(callback);
+}
+
+void PowerMonitor::SetPowerSourceCallback(std::function<void(bool on_battery)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_power_source_ = std::move(callback);
+}
+
+bool PowerMonitor::ReadOnBattery() {
+    CFTypeRef info = IOPSCopyPowerSourcesInfo();
+    if (!info) {
+        return false;  // desktops without a power source report none
+    }
+    CFStringRef type = IOPSGetProvidingPowerSourceType(info);
+    bool battery = type && CFStringCompare(type, CFSTR(kIOPMBatteryPowerKey), 0) == kCFCompareEqualTo;
+    CFRelease(info);
+    return battery;
+}
+
+// Power queue. The notification also fires on charge level updates; only a
+// change of the providing source is passed on.
+void PowerMonitor::PowerSourceChanged(void* context) {
+    PowerMonitor* self = static_cast<PowerMonitor*>(context);
+    int token = 0;
+    if (read(self->source_fd_, &token, sizeof(token)) != sizeof(token)) {
+        return;
+    }
+    bool on_battery = ReadOnBattery();
+    if (self->on_battery_.exchange(on_battery, std::memory_order_relaxed) == on_battery) {
+        return;
+    }
+
+    Log(LogLevel::kInfo, kLogSource, "Running on %s", on_battery ? "battery" : "AC power");
+    std::function<void(bool)> callback;
+    {
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        callback = self->on_power_source_;
+    }
+    if (callback) {
+        callback(on_battery);
+    }
+}
+
+// Power queue. Sleep waits for IOAllowPowerChange (or a 30s timeout), so
+// both sleep messages are answered before anything else.
+void PowerMonitor::PowerChanged(void* refcon, io_service_t /*service*/, natural_t message_type, void* argument) {
+    PowerMonitor* self = static_cast<PowerMonitor*>(refcon);
+    bool awake;
+    switch (message_type) {
+        case kIOMessageCanSystemSleep:
+            IOAllowPowerChange(self->root_port_, reinterpret_cast<intptr_t>(argument));
+            return;
+        case kIOMessageSystemWillSleep:
+            IOAllowPowerChange(self->root_port_, reinterpret_cast<intptr_t>(argument));
+            awake = false;
+            break;
+        case kIOMessageSystemHasPoweredOn:
+            awake = true;
+            break;
+        default:
+            return;
+    }
+
+    Log(LogLevel::kInfo, kLogSource, "System %s", awake ? "woke" : "going to sleep");
+    std::function<void(bool)> callback;
+    {
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        callback = self->on_change_;
+    }
+    if (callback) {
+        callback(awake);
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <IOKit/IOKitLib.h>
+#include <dispatch/dispatch.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace kakarot {
+
+// System sleep and wake, from IOKit's root power domain, and moves between
+// battery and AC. Sleep is allowed straight away: capture has nothing to
+// save, only a note of when its IO stopped. Notifications arrive on a private
+// serial dispatch queue.
+class PowerMonitor {
+public:
+    PowerMonitor() = default;
+    ~PowerMonitor();
+
+    PowerMonitor(const PowerMonitor&) = delete;
+    PowerMonitor& operator=(const PowerMonitor&) = delete;
+
+    void Start();
+    // No callback runs after this returns
+    void Stop();
+
+    // |awake| is false as the system goes to sleep, true once it has powered on
+    void SetChangeCallback(std::function<void(bool awake)> callback);
+
+    // Called when the providing power source changes between battery and AC
+    void SetPowerSourceCallback(std::function<void(bool on_battery)> callback);
+
+    // Any thread. As of the last power source notification (or Start())
+    bool OnBattery() const { return on_battery_.load(std::memory_order_relaxed); }
+
+private:
+    static void PowerChanged(void* refcon, io_service_t service, natural_t message_type, void* argument);
+    static void PowerSourceChanged(void* context);
+    static bool ReadOnBattery();
+
+    std::mutex mutex_;
+    std::function<void(bool)> on_change_;
+    std::function<void(bool)> on_power_source_;
+    std::atomic<bool> on_battery_{false};
+    io_connect_t root_port_ = MACH_PORT_NULL;
+    IONotificationPortRef notify_port_ = nullptr;
+    io_object_t notifier_ = 0;
+    dispatch_queue_t queue_ = nullptr;
+
+    // kIOPSNotifyPowerSource, posted to a descriptor the queue watches
+    int source_token_ = 0;
+    int source_fd_ = -1;
+    dispatch_source_t source_watch_ = nullptr;
+};
+
+} // namespace kakarot
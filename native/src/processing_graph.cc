@@ -0,0 +1,907 @@
+#include "processing_graph.h"
+#include "api/array_view.h"
+#include "common_audio/fir_filter.h"
+#include "common_audio/fir_filter_factory.h"
+#include "common_audio/include/audio_util.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "keystroke_suppressor.h"
+#include "neural_denoiser.h"
+#include "modules/audio_processing/utility/cascaded_biquad_filter.h"
+#include "ogg_opus_writer.h"
+#include "platform_thread.h"
+#include "speech_normalizer.h"
+#include "voice_activity.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#if defined(KAKAROT_HAVE_OPUS)
+#include <opus.h>
+#endif
+
+namespace kakarot {
+
+static uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Filter stage bounds: 4 sections, and taps the SIMD FIR runs well inside a
+// 10ms frame
+static constexpr int kMaxFilterOrder = 8;
+static constexpr int kMaxFirTaps = 255;
+
+static bool IsFrameRate(int sample_rate) {
+    return sample_rate >= 8000 && sample_rate <= 48000 && sample_rate % 100 == 0;
+}
+
+namespace {
+
+// Windowed sinc, one 10ms block in and one out
+class ResampleStage : public ProcessingStage {
+public:
+    explicit ResampleStage(int output_rate) : output_rate_(output_rate) {}
+
+    const char* Type() const override { return "resample"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        if (!IsFrameRate(output_rate_)) {
+            *error = "outputSampleRate must be a multiple of 100Hz in 8000-48000";
+            return false;
+        }
+        input_block_ = static_cast<size_t>(sample_rate / 100);
+        output_.assign(static_cast<size_t>(output_rate_ / 100), 0.0f);
+        resampler_ = std::make_unique<webrtc::PushSincResampler>(input_block_, output_.size());
+        *output_rate = output_rate_;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override {
+        resampler_->Resample(frame->samples, input_block_, output_.data(), output_.size());
+        frame->samples = output_.data();
+        frame->num_samples = output_.size();
+        frame->sample_rate = output_rate_;
+    }
+
+    void Reset() override {
+        resampler_ = std::make_unique<webrtc::PushSincResampler>(input_block_, output_.size());
+    }
+
+private:
+    const int output_rate_;
+    size_t input_block_ = 0;
+    std::vector<float> output_;
+    std::unique_ptr<webrtc::PushSincResampler> resampler_;
+};
+
+using BiQuadCoefficients = webrtc::CascadedBiQuadFilter::BiQuadCoefficients;
+
+// RBJ cookbook section at |frequency_hz|, normalized so a[0] = 1
+static BiQuadCoefficients DesignSection(BiquadKind kind, double frequency_hz, double q, double gain_db,
+                                        int sample_rate) {
+    const double w0 = 2.0 * M_PI * frequency_hz / sample_rate;
+    const double cos_w0 = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double A = std::pow(10.0, gain_db / 40.0);
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+    switch (kind) {
+        case BiquadKind::kLowPass:
+            b0 = (1.0 - cos_w0) / 2.0; b1 = 1.0 - cos_w0; b2 = b0;
+            a0 = 1.0 + alpha; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha;
+            break;
+        case BiquadKind::kHighPass:
+            b0 = (1.0 + cos_w0) / 2.0; b1 = -(1.0 + cos_w0); b2 = b0;
+            a0 = 1.0 + alpha; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha;
+            break;
+        case BiquadKind::kBandPass:  // 0dB peak gain
+            b0 = alpha; b1 = 0.0; b2 = -alpha;
+            a0 = 1.0 + alpha; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha;
+            break;
+        case BiquadKind::kPeaking:
+            b0 = 1.0 + alpha * A; b1 = -2.0 * cos_w0; b2 = 1.0 - alpha * A;
+            a0 = 1.0 + alpha / A; a1 = -2.0 * cos_w0; a2 = 1.0 - alpha / A;
+            break;
+        case BiquadKind::kLowShelf: {
+            const double root = 2.0 * std::sqrt(A) * alpha;
+            b0 = A * ((A + 1.0) - (A - 1.0) * cos_w0 + root);
+            b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cos_w0);
+            b2 = A * ((A + 1.0) - (A - 1.0) * cos_w0 - root);
+            a0 = (A + 1.0) + (A - 1.0) * cos_w0 + root;
+            a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cos_w0);
+            a2 = (A + 1.0) + (A - 1.0) * cos_w0 - root;
+            break;
+        }
+        case BiquadKind::kHighShelf: {
+            const double root = 2.0 * std::sqrt(A) * alpha;
+            b0 = A * ((A + 1.0) + (A - 1.0) * cos_w0 + root);
+            b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cos_w0);
+            b2 = A * ((A + 1.0) + (A - 1.0) * cos_w0 - root);
+            a0 = (A + 1.0) - (A - 1.0) * cos_w0 + root;
+            a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cos_w0);
+            a2 = (A + 1.0) - (A - 1.0) * cos_w0 - root;
+            break;
+        }
+    }
+    return {{static_cast<float>(b0 / a0), static_cast<float>(b1 / a0), static_cast<float>(b2 / a0)},
+            {static_cast<float>(a1 / a0), static_cast<float>(a2 / a0)}};
+}
+
+// A cascade of spec.order / 2 sections. Low- and high-pass cascades take
+// Butterworth Qs, so order 4 is a true 4th-order Butterworth; the other
+// kinds repeat one section at spec.q.
+class BiquadStage : public ProcessingStage {
+public:
+    BiquadStage(const char* type, const StageSpec& spec) : type_(type), spec_(spec) {}
+
+    const char* Type() const override { return type_; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        if (spec_.frequency_hz <= 0.0f || spec_.frequency_hz >= sample_rate / 2.0f) {
+            *error = "frequencyHz must be between 0 and half the sample rate";
+            return false;
+        }
+        if (spec_.order < 2 || spec_.order > kMaxFilterOrder || spec_.order % 2 != 0) {
+            *error = "order must be even, 2-" + std::to_string(kMaxFilterOrder);
+            return false;
+        }
+        const int sections = spec_.order / 2;
+        const bool butterworth = spec_.biquad == BiquadKind::kLowPass || spec_.biquad == BiquadKind::kHighPass;
+        std::vector<BiQuadCoefficients> coefficients;
+        for (int k = 0; k < sections; ++k) {
+            double q = butterworth ? 1.0 / (2.0 * std::cos(M_PI * (2 * k + 1) / (2.0 * spec_.order))) : spec_.q;
+            coefficients.push_back(DesignSection(spec_.biquad, spec_.frequency_hz, q, spec_.gain_db, sample_rate));
+        }
+        filter_ = std::make_unique<webrtc::CascadedBiQuadFilter>(coefficients);
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override {
+        filter_->Process(webrtc::ArrayView<float>(frame->samples, frame->num_samples));
+    }
+
+    void Reset() override { filter_->Reset(); }
+
+private:
+    const char* const type_;
+    const StageSpec spec_;
+    std::unique_ptr<webrtc::CascadedBiQuadFilter> filter_;
+};
+
+// WebRTC's FIR filter (SSE2/AVX2/NEON where the CPU has them) over either
+// spec.coefficients or a Blackman-windowed sinc low-pass of spec.taps at
+// spec.frequency_hz, e.g. anti-aliasing ahead of a 16kHz decimation
+class FirStage : public ProcessingStage {
+public:
+    explicit FirStage(const StageSpec& spec) : spec_(spec) {}
+
+    const char* Type() const override { return "fir"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        std::vector<float> coefficients = spec_.coefficients;
+        if (coefficients.empty()) {
+            if (spec_.frequency_hz <= 0.0f || spec_.frequency_hz >= sample_rate / 2.0f) {
+                *error = "frequencyHz must be between 0 and half the sample rate";
+                return false;
+            }
+            if (spec_.taps < 3 || spec_.taps > kMaxFirTaps || spec_.taps % 2 == 0) {
+                *error = "taps must be odd, 3-" + std::to_string(kMaxFirTaps);
+                return false;
+            }
+            coefficients = DesignLowPass(spec_.frequency_hz / sample_rate, spec_.taps);
+        } else if (coefficients.size() > kMaxFirTaps) {
+            *error = "at most " + std::to_string(kMaxFirTaps) + " coefficients";
+            return false;
+        }
+        const size_t frame_size = static_cast<size_t>(sample_rate / 100);
+        filter_.reset(webrtc::CreateFirFilter(coefficients.data(), coefficients.size(), frame_size));
+        coefficients_ = std::move(coefficients);
+        output_.assign(frame_size, 0.0f);
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override {
+        filter_->Filter(frame->samples, frame->num_samples, output_.data());
+        frame->samples = output_.data();
+    }
+
+    void Reset() override {
+        filter_.reset(webrtc::CreateFirFilter(coefficients_.data(), coefficients_.size(), output_.size()));
+    }
+
+private:
+    // Unity gain at DC; |cutoff| is a fraction of the sample rate
+    static std::vector<float> DesignLowPass(double cutoff, int taps) {
+        std::vector<float> coefficients(static_cast<size_t>(taps));
+        const int middle = taps / 2;
+        double sum = 0.0;
+        for (int n = 0; n < taps; ++n) {
+            int offset = n - middle;
+            double sinc = offset == 0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * offset) / (M_PI * offset);
+            double phase = 2.0 * M_PI * n / (taps - 1);
+            double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+            coefficients[n] = static_cast<float>(sinc * window);
+            sum += coefficients[n];
+        }
+        for (float& coefficient : coefficients) {
+            coefficient = static_cast<float>(coefficient / sum);
+        }
+        return coefficients;
+    }
+
+    const StageSpec spec_;
+    std::vector<float> coefficients_;
+    std::vector<float> output_;
+    std::unique_ptr<webrtc::FIRFilter> filter_;
+};
+
+// An AECProcessor of its own: AEC3 with NS/AGC2 as configured, or just NS
+// or AGC2 for the "ns"/"agc" shorthands. Output trails input by one frame.
+// Render reaches it only while it runs at the graph's input rate.
+class ApmStage : public ProcessingStage {
+public:
+    ApmStage(const char* type, const AECConfig& config) : type_(type), config_(config) {}
+
+    const char* Type() const override { return type_; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        processor_ = std::make_unique<AECProcessor>(config_);
+        if (!processor_->Initialize(sample_rate, 1, 1)) {
+            *error = "the APM could not start";
+            return false;
+        }
+        sample_rate_ = sample_rate;
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override {
+        processor_->ProcessCaptureAudio(frame->samples, frame->samples, frame->num_samples);
+    }
+
+    void ProcessRender(const float* data, size_t num_samples) override {
+        if (config_.enable_aec) {
+            processor_->ProcessRenderAudio(data, num_samples, 1);
+        }
+    }
+
+    void Reset() override {
+        processor_ = std::make_unique<AECProcessor>(config_);
+        processor_->Initialize(sample_rate_, 1, 1);
+    }
+
+private:
+    const char* const type_;
+    const AECConfig config_;
+    int sample_rate_ = 0;
+    std::unique_ptr<AECProcessor> processor_;
+};
+
+class NormalizeStage : public ProcessingStage {
+public:
+    explicit NormalizeStage(float target_dbfs) : target_dbfs_(target_dbfs) {}
+
+    const char* Type() const override { return "normalize"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        if (!SpeechNormalizer::Supports(sample_rate)) {
+            *error = "normalize runs at 8, 16, 32 or 48kHz only";
+            return false;
+        }
+        normalizer_ = std::make_unique<SpeechNormalizer>(sample_rate, target_dbfs_);
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override { normalizer_->ProcessFrame(frame->samples); }
+
+    void Reset() override { normalizer_->Reset(); }
+
+private:
+    const float target_dbfs_;
+    std::unique_ptr<SpeechNormalizer> normalizer_;
+};
+
+// RNNoise-class denoiser; its overlap delays the stream one frame
+class DenoiseStage : public ProcessingStage {
+public:
+    explicit DenoiseStage(const std::string& model_path) : model_path_(model_path) {}
+
+    const char* Type() const override { return "denoise"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        if (sample_rate != NeuralDenoiser::kSampleRate) {
+            *error = "denoise runs at 48kHz only";
+            return false;
+        }
+        std::shared_ptr<const DenoiserModel> model = DenoiserModel::Load(model_path_, error);
+        if (!model) {
+            return false;
+        }
+        denoiser_ = std::make_unique<NeuralDenoiser>(std::move(model));
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override { denoiser_->ProcessFrame(frame->samples); }
+
+    void Reset() override { denoiser_->Reset(); }
+
+private:
+    const std::string model_path_;
+    std::unique_ptr<NeuralDenoiser> denoiser_;
+};
+
+// Ducks keystrokes within the frame they start in, so it adds no delay
+class DeclickStage : public ProcessingStage {
+public:
+    explicit DeclickStage(float threshold) : threshold_(threshold) {}
+
+    const char* Type() const override { return "declick"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        if (!KeystrokeSuppressor::Supports(sample_rate)) {
+            *error = "declick runs at 8 to 48kHz only";
+            return false;
+        }
+        suppressor_ = std::make_unique<KeystrokeSuppressor>(sample_rate, threshold_);
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override { suppressor_->ProcessFrame(frame->samples); }
+
+    void Reset() override { suppressor_->Reset(); }
+
+private:
+    const float threshold_;
+    std::unique_ptr<KeystrokeSuppressor> suppressor_;
+};
+
+class VadStage : public ProcessingStage {
+public:
+    const char* Type() const override { return "vad"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        (void)error;
+        vad_ = std::make_unique<VoiceActivityDetector>(sample_rate);
+        sample_rate_ = sample_rate;
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override { frame->speech_probability = vad_->AnalyzeFrame(frame->samples); }
+
+    void Reset() override { vad_ = std::make_unique<VoiceActivityDetector>(sample_rate_); }
+
+private:
+    int sample_rate_ = 0;
+    std::unique_ptr<VoiceActivityDetector> vad_;
+};
+
+// Drops frames once the speech probability has stayed below the threshold
+// for the hangover. No pre-roll: the capture stream's gate has one. A frame
+// no vad stage analyzed passes.
+class GateStage : public ProcessingStage {
+public:
+    GateStage(float threshold, double hangover_ms)
+        : threshold_(threshold),
+          hangover_frames_(static_cast<size_t>(hangover_ms / 10.0)),
+          quiet_frames_(hangover_frames_) {}
+
+    const char* Type() const override { return "gate"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        (void)error;
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override {
+        if (frame->speech_probability < 0.0f || frame->speech_probability >= threshold_) {
+            quiet_frames_ = 0;
+            return;
+        }
+        frame->keep = ++quiet_frames_ <= hangover_frames_;
+    }
+
+    void Reset() override { quiet_frames_ = hangover_frames_; }
+
+private:
+    const float threshold_;
+    const size_t hangover_frames_;
+    size_t quiet_frames_;  // starts closed
+};
+
+// 16-bit PCM of the frame as it stands; normally last
+class EncodeStage : public ProcessingStage {
+public:
+    const char* Type() const override { return "encode"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        (void)error;
+        pcm16_.assign(static_cast<size_t>(sample_rate / 100), 0);
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override {
+        webrtc::FloatToS16(frame->samples, frame->num_samples, pcm16_.data());
+        frame->pcm16 = pcm16_.data();
+    }
+
+private:
+    std::vector<int16_t> pcm16_;
+};
+
+#if defined(KAKAROT_HAVE_OPUS)
+// Opus: 20ms packets, the most a 20ms frame can take, and the Ogg pages
+// that carry them: three packets a page keeps the framing under 4kbit/s
+static constexpr int kOpusPacketMs = 20;
+static constexpr size_t kMaxOpusPacketBytes = 1275;
+static constexpr size_t kOggPacketsPerPage = 3;
+
+// Quiet packets still sent in full after speech, so word endings survive
+static constexpr int kDtxHangoverPackets = 10;
+
+struct OpusEncoderDeleter {
+    void operator()(OpusEncoder* encoder) const { opus_encoder_destroy(encoder); }
+};
+
+// libopus at spec.bitrate on 20ms packets, VOIP-tuned; normally last. Two
+// frames make a packet, so every other frame hands on nothing. With DTX,
+// once a vad stage has called a packet's frames quiet past the hangover,
+// the packet shrinks to its 1-byte TOC, which decoders play as comfort
+// noise. The encoder still runs on those, so speech resumes from a warm
+// state and the stream's timing stays whole.
+class OpusStage : public ProcessingStage {
+public:
+    explicit OpusStage(const StageSpec& spec) : spec_(spec) {}
+
+    const char* Type() const override { return "opus"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        if (sample_rate != 8000 && sample_rate != 12000 && sample_rate != 16000 && sample_rate != 24000 &&
+            sample_rate != 48000) {
+            *error = "opus runs at 8, 12, 16, 24 or 48kHz only";
+            return false;
+        }
+        int status = OPUS_OK;
+        encoder_.reset(opus_encoder_create(sample_rate, 1, OPUS_APPLICATION_VOIP, &status));
+        if (status != OPUS_OK || !encoder_) {
+            *error = std::string("opus_encoder_create failed: ") + opus_strerror(status);
+            return false;
+        }
+        opus_encoder_ctl(encoder_.get(), OPUS_SET_BITRATE(spec_.bitrate));
+        opus_encoder_ctl(encoder_.get(), OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+        opus_encoder_ctl(encoder_.get(), OPUS_SET_DTX(spec_.dtx ? 1 : 0));
+        opus_int32 lookahead = 0;
+        opus_encoder_ctl(encoder_.get(), OPUS_GET_LOOKAHEAD(&lookahead));
+        pre_skip_ = static_cast<int>(static_cast<int64_t>(lookahead) * 48000 / sample_rate);
+
+        sample_rate_ = sample_rate;
+        pcm_.assign(static_cast<size_t>(sample_rate * kOpusPacketMs / 1000), 0.0f);
+        packet_.assign(kMaxOpusPacketBytes, 0);
+        output_.reserve(2 * kMaxOpusPacketBytes + 4 * 1024);
+        serial_ = static_cast<uint32_t>(NowNs());
+        *output_rate = sample_rate;
+        return true;
+    }
+
+    void Process(GraphFrame* frame) override {
+        output_.clear();
+        frame->compressed = true;
+        frame->bytes = output_.data();
+        frame->num_bytes = 0;
+
+        std::memcpy(pcm_.data() + fill_, frame->samples, frame->num_samples * sizeof(float));
+        fill_ += frame->num_samples;
+        if (frame->speech_probability < 0.0f || frame->speech_probability >= spec_.dtx_threshold) {
+            speech_ = true;
+        }
+        if (fill_ < pcm_.size()) {
+            return;
+        }
+        fill_ = 0;
+        quiet_packets_ = speech_ ? 0 : quiet_packets_ + 1;
+        speech_ = false;
+
+        opus_int32 size = opus_encode_float(encoder_.get(), pcm_.data(), static_cast<int>(pcm_.size()),
+                                            packet_.data(), static_cast<opus_int32>(packet_.size()));
+        if (size <= 0) {
+            return;
+        }
+        if (spec_.dtx && quiet_packets_ > kDtxHangoverPackets) {
+            packet_[0] &= 0xfc;  // code 0: one frame, here of no bytes
+            size = 1;
+        }
+
+        if (spec_.ogg) {
+            if (!started_) {
+                writer_.Begin(serial_, sample_rate_, pre_skip_, &output_);
+                started_ = true;
+            }
+            writer_.AddPacket(packet_.data(), static_cast<size_t>(size), 48 * kOpusPacketMs);
+            if (writer_.PendingPackets() >= kOggPacketsPerPage) {
+                writer_.Flush(&output_);
+            }
+        } else {
+            output_.assign(packet_.data(), packet_.data() + size);
+        }
+        frame->bytes = output_.data();
+        frame->num_bytes = output_.size();
+    }
+
+    // A new Ogg stream too, headers and all
+    void Reset() override {
+        opus_encoder_ctl(encoder_.get(), OPUS_RESET_STATE);
+        fill_ = 0;
+        speech_ = false;
+        quiet_packets_ = 0;
+        started_ = false;
+        serial_++;
+    }
+
+private:
+    const StageSpec spec_;
+    std::unique_ptr<OpusEncoder, OpusEncoderDeleter> encoder_;
+    int sample_rate_ = 0;
+    int pre_skip_ = 0;
+    std::vector<float> pcm_;        // one packet of input
+    size_t fill_ = 0;
+    std::vector<uint8_t> packet_;
+    std::vector<uint8_t> output_;
+    bool speech_ = false;           // any frame of this packet
+    int quiet_packets_ = 0;
+    OggOpusWriter writer_;
+    bool started_ = false;
+    uint32_t serial_ = 0;
+};
+#else
+// Built without libopus (binding.gyp looks for it with pkg-config)
+class OpusStage : public ProcessingStage {
+public:
+    explicit OpusStage(const StageSpec&) {}
+
+    const char* Type() const override { return "opus"; }
+
+    bool Prepare(int sample_rate, int* output_rate, std::string* error) override {
+        (void)sample_rate;
+        (void)output_rate;
+        *error = "this build has no Opus encoder";
+        return false;
+    }
+
+    void Process(GraphFrame* frame) override { (void)frame; }
+};
+#endif
+
+} // namespace
+
+static const struct {
+    const char* type;
+    std::unique_ptr<ProcessingStage> (*create)(const StageSpec& spec);
+} kStageTable[] = {
+    {"resample", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<ResampleStage>(spec.output_sample_rate);
+    }},
+    {"highpass", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        StageSpec highpass = spec;
+        highpass.biquad = BiquadKind::kHighPass;
+        return std::make_unique<BiquadStage>("highpass", highpass);
+    }},
+    {"lowpass", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        StageSpec lowpass = spec;
+        lowpass.biquad = BiquadKind::kLowPass;
+        return std::make_unique<BiquadStage>("lowpass", lowpass);
+    }},
+    {"biquad", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<BiquadStage>("biquad", spec);
+    }},
+    {"fir", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<FirStage>(spec);
+    }},
+    {"aec", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<ApmStage>("aec", spec.apm);
+    }},
+    {"ns", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        AECConfig config = ApplyPresetDefaults(spec.apm, AECPreset::kHeadphones);
+        config.enable_agc = false;
+        return std::make_unique<ApmStage>("ns", config);
+    }},
+    {"agc", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        AECConfig config = ApplyPresetDefaults(spec.apm, AECPreset::kHeadphones);
+        config.enable_ns = false;
+        config.enable_agc = true;
+        return std::make_unique<ApmStage>("agc", config);
+    }},
+    {"normalize", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<NormalizeStage>(spec.target_dbfs);
+    }},
+    {"denoise", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<DenoiseStage>(spec.model_path);
+    }},
+    {"declick", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<DeclickStage>(spec.gate_threshold);
+    }},
+    {"vad", [](const StageSpec&) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<VadStage>();
+    }},
+    {"gate", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<GateStage>(spec.gate_threshold, spec.gate_hangover_ms);
+    }},
+    {"encode", [](const StageSpec&) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<EncodeStage>();
+    }},
+    {"opus", [](const StageSpec& spec) -> std::unique_ptr<ProcessingStage> {
+        return std::make_unique<OpusStage>(spec);
+    }},
+};
+
+std::unique_ptr<ProcessingStage> CreateStage(const StageSpec& spec, std::string* error) {
+    for (const auto& entry : kStageTable) {
+        if (spec.type == entry.type) {
+            return entry.create(spec);
+        }
+    }
+    *error = "unknown stage type '" + spec.type + "'";
+    return nullptr;
+}
+
+std::vector<std::string> StageTypes() {
+    std::vector<std::string> types;
+    for (const auto& entry : kStageTable) {
+        types.push_back(entry.type);
+    }
+    return types;
+}
+
+bool ProcessingGraph::Build(int sample_rate, std::vector<std::unique_ptr<ProcessingStage>> stages,
+                            const std::vector<bool>& enabled, std::string* error) {
+    if (!IsFrameRate(sample_rate)) {
+        *error = "sampleRate must be a multiple of 100Hz in 8000-48000";
+        return false;
+    }
+    stats_.clear();
+    int rate = sample_rate;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        GraphStageStats stats;
+        stats.type = stages[i]->Type();
+        stats.enabled = i >= enabled.size() || enabled[i];
+        stats.input_rate = rate;
+        std::string stage_error;
+        if (!stages[i]->Prepare(rate, &rate, &stage_error)) {
+            *error = "stage " + std::to_string(i) + " (" + stats.type + "): " + stage_error;
+            stats_.clear();
+            return false;
+        }
+        stats.output_rate = rate;
+        if (!stats.enabled && stats.input_rate != stats.output_rate) {
+            *error = "stage " + std::to_string(i) + " (" + stats.type + ") changes the rate and cannot be disabled";
+            stats_.clear();
+            return false;
+        }
+        stats_.push_back(stats);
+    }
+
+    stages_ = std::move(stages);
+    points_.clear();
+    taps_.clear();
+    input_rate_ = sample_rate;
+    output_rate_ = rate;
+    frame_.assign(static_cast<size_t>(sample_rate / 100), 0.0f);
+    fill_ = 0;
+    return true;
+}
+
+bool ProcessingGraph::AddTap(const TapSpec& spec, std::string* error) {
+    if (frame_.empty()) {
+        *error = "the graph is not built";
+        return false;
+    }
+    for (const GraphTap& tap : taps_) {
+        if (tap.spec.name == spec.name) {
+            *error = "output '" + spec.name + "' is defined twice";
+            return false;
+        }
+    }
+    const size_t after = std::min(spec.after, stages_.size());
+    const int point_rate = after < stats_.size() ? stats_[after].input_rate : output_rate_;
+    const int rate = spec.sample_rate > 0 ? spec.sample_rate : point_rate;
+    int output_rate = 0;
+
+    GraphTap tap;
+    tap.spec = spec;
+    tap.spec.after = after;
+    if (spec.format == TapFormat::kPcm16) {
+        tap.encoder = std::make_unique<EncodeStage>();
+    } else if (spec.format == TapFormat::kOpus) {
+        tap.encoder = std::make_unique<OpusStage>(spec.opus);
+    }
+    std::string stage_error;
+    if (tap.encoder && !tap.encoder->Prepare(rate, &output_rate, &stage_error)) {
+        *error = "output '" + spec.name + "': " + stage_error;
+        return false;
+    }
+
+    auto point = std::find_if(points_.begin(), points_.end(),
+                              [&](const TapPoint& p) { return p.after == after && p.rate == rate; });
+    if (point == points_.end()) {
+        TapPoint added;
+        added.after = after;
+        added.rate = rate;
+        if (rate != point_rate) {
+            added.resampler = std::make_unique<ResampleStage>(rate);
+            if (!added.resampler->Prepare(point_rate, &output_rate, &stage_error)) {
+                *error = "output '" + spec.name + "': " + stage_error;
+                return false;
+            }
+        }
+        points_.push_back(std::move(added));
+        point = points_.end() - 1;
+    }
+    tap.point = static_cast<size_t>(point - points_.begin());
+    point->taps.push_back(taps_.size());
+    taps_.push_back(std::move(tap));
+    return true;
+}
+
+void ProcessingGraph::Process(const float* data, size_t num_samples, GraphOutput* output) {
+    output->samples.clear();
+    output->pcm16.clear();
+    output->encoded.clear();
+    output->encoded_sizes.clear();
+    output->vad.clear();
+    output->dropped_frames = 0;
+    output->taps.resize(taps_.size());
+    for (TapOutput& tap : output->taps) {
+        if (!tap.data || tap.data.use_count() > 1) {
+            tap.data = std::make_shared<std::vector<uint8_t>>();
+        } else {
+            tap.data->clear();
+        }
+        tap.encoded_sizes.clear();
+    }
+    if (frame_.empty()) {
+        return;
+    }
+
+    size_t consumed = 0;
+    while (consumed < num_samples) {
+        size_t count = std::min(frame_.size() - fill_, num_samples - consumed);
+        std::memcpy(frame_.data() + fill_, data + consumed, count * sizeof(float));
+        fill_ += count;
+        consumed += count;
+        if (fill_ == frame_.size()) {
+            RunFrame(output);
+            fill_ = 0;
+        }
+    }
+}
+
+void ProcessingGraph::RunFrame(GraphOutput* output) {
+    GraphFrame frame;
+    frame.samples = frame_.data();
+    frame.num_samples = frame_.size();
+    frame.sample_rate = input_rate_;
+
+    for (size_t i = 0; i < stages_.size() && frame.keep; ++i) {
+        RunTaps(i, frame, output);
+        GraphStageStats& stats = stats_[i];
+        if (!stats.enabled) {
+            continue;
+        }
+        uint64_t start = NowNs();
+        uint64_t cpu_start = CurrentThreadCpuNs();
+        stages_[i]->Process(&frame);
+        uint64_t elapsed = NowNs() - start;
+        stats.frames++;
+        stats.total_ns += elapsed;
+        stats.cpu_ns += CurrentThreadCpuNs() - cpu_start;
+        stats.max_ns = std::max(stats.max_ns, elapsed);
+    }
+
+    if (!frame.keep) {
+        output->dropped_frames++;
+        return;
+    }
+    RunTaps(stages_.size(), frame, output);
+    if (frame.compressed) {
+        if (frame.num_bytes > 0) {
+            output->encoded.insert(output->encoded.end(), frame.bytes, frame.bytes + frame.num_bytes);
+            output->encoded_sizes.push_back(static_cast<uint32_t>(frame.num_bytes));
+        }
+    } else if (frame.pcm16) {
+        output->pcm16.insert(output->pcm16.end(), frame.pcm16, frame.pcm16 + frame.num_samples);
+    } else {
+        output->samples.insert(output->samples.end(), frame.samples, frame.samples + frame.num_samples);
+    }
+    if (frame.speech_probability >= 0.0f) {
+        output->vad.push_back(frame.speech_probability);
+    }
+}
+
+// The frame as it leaves stage |after| - 1, to the taps there. Converters
+// and encoders only read the samples they are given, so the taps sharing a
+// point share its conversion and the main chain's frame is left as it was.
+void ProcessingGraph::RunTaps(size_t after, const GraphFrame& frame, GraphOutput* output) {
+    for (TapPoint& point : points_) {
+        if (point.after != after) {
+            continue;
+        }
+        GraphFrame branch;
+        branch.samples = frame.samples;
+        branch.num_samples = frame.num_samples;
+        branch.sample_rate = frame.sample_rate;
+        branch.speech_probability = frame.speech_probability;
+        if (point.resampler) {
+            point.resampler->Process(&branch);
+        }
+        for (size_t index : point.taps) {
+            GraphTap& tap = taps_[index];
+            TapOutput& out = output->taps[index];
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(branch.samples);
+            size_t num_bytes = branch.num_samples * sizeof(float);
+            if (tap.encoder) {
+                GraphFrame encoded = branch;
+                tap.encoder->Process(&encoded);
+                if (encoded.compressed) {
+                    bytes = encoded.bytes;
+                    num_bytes = encoded.num_bytes;
+                    if (num_bytes > 0) {
+                        out.encoded_sizes.push_back(static_cast<uint32_t>(num_bytes));
+                    }
+                } else {
+                    bytes = reinterpret_cast<const uint8_t*>(encoded.pcm16);
+                    num_bytes = encoded.num_samples * sizeof(int16_t);
+                }
+            }
+            out.data->insert(out.data->end(), bytes, bytes + num_bytes);
+        }
+    }
+}
+
+// Echo-cancelling stages before a resample see the input rate; after one,
+// render would need resampling too, so they go without
+void ProcessingGraph::ProcessRender(const float* data, size_t num_samples) {
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        if (stats_[i].input_rate != input_rate_) {
+            break;
+        }
+        if (stats_[i].enabled) {
+            stages_[i]->ProcessRender(data, num_samples);
+        }
+    }
+}
+
+bool ProcessingGraph::SetStageEnabled(size_t index, bool enabled) {
+    if (index >= stats_.size() || stats_[index].input_rate != stats_[index].output_rate) {
+        return false;
+    }
+    stats_[index].enabled = enabled;
+    return true;
+}
+
+void ProcessingGraph::Reset() {
+    fill_ = 0;
+    for (TapPoint& point : points_) {
+        if (point.resampler) {
+            point.resampler->Reset();
+        }
+    }
+    for (GraphTap& tap : taps_) {
+        if (tap.encoder) {
+            tap.encoder->Reset();
+        }
+    }
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        stages_[i]->Reset();
+        stats_[i].frames = 0;
+        stats_[i].total_ns = 0;
+        stats_[i].max_ns = 0;
+        stats_[i].cpu_ns = 0;
+    }
+}
+
+} // namespace kakarot
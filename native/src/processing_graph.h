@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "aec_processor.h"
+
+namespace kakarot {
+
+// One 10ms mono frame on its way through a ProcessingGraph. A stage
+// rewrites |samples| in place or points it at a buffer of its own (a rate
+// change); |pcm16| is set once a stage has encoded the frame. A codec stage
+// sets |compressed| and hands on whatever bytes the frame completed, often
+// none while it gathers a packet. A stage that drops the frame clears
+// |keep|, and later stages do not see it.
+struct GraphFrame {
+    float* samples = nullptr;
+    size_t num_samples = 0;
+    int sample_rate = 0;
+    const int16_t* pcm16 = nullptr;
+    bool compressed = false;
+    const uint8_t* bytes = nullptr;
+    size_t num_bytes = 0;
+    float speech_probability = -1.0f;  // from a vad stage; -1 = not analyzed
+    bool keep = true;
+};
+
+// A processor in the graph. To add one, implement this and add a row to the
+// stage table in processing_graph.cc.
+class ProcessingStage {
+public:
+    virtual ~ProcessingStage() = default;
+
+    // The stage table's name for it
+    virtual const char* Type() const = 0;
+
+    // Once, before the first frame, with the rate the stage receives.
+    // Returns the rate it hands on, or false with |error| set when it cannot
+    // run at |sample_rate|. Allocates everything Process() needs.
+    virtual bool Prepare(int sample_rate, int* output_rate, std::string* error) = 0;
+
+    // One frame, never allocating
+    virtual void Process(GraphFrame* frame) = 0;
+
+    // The far-end reference at the graph's input rate, for stages that
+    // cancel echo; the rest ignore it
+    virtual void ProcessRender(const float* data, size_t num_samples) {
+        (void)data;
+        (void)num_samples;
+    }
+
+    // A new stream: forget filter and estimator state
+    virtual void Reset() {}
+};
+
+// Section shapes of the biquad stages (RBJ cookbook)
+enum class BiquadKind { kLowPass, kHighPass, kBandPass, kPeaking, kLowShelf, kHighShelf };
+
+// What createProcessingGraph() asked of one stage. Fields a type does not
+// use are ignored.
+struct StageSpec {
+    std::string type;
+    bool enabled = true;
+    int output_sample_rate = 16000;  // resample
+
+    // highpass, lowpass, biquad, fir
+    BiquadKind biquad = BiquadKind::kHighPass;
+    float frequency_hz = 80.0f;      // cutoff, centre or shelf corner
+    float q = 0.70710678f;           // biquad sections other than low/high-pass
+    float gain_db = 0.0f;            // peaking and shelves
+    int order = 2;                   // even; order / 2 cascaded sections
+    int taps = 63;                   // fir: odd length of the designed low-pass
+    std::vector<float> coefficients; // fir: used as given instead of the design
+
+    AECConfig apm;                   // aec, ns, agc
+    float target_dbfs = -20.0f;      // normalize
+    std::string model_path;          // denoise: a DenoiserModel file
+    float gate_threshold = 0.5f;     // gate; declick's keystroke likelihood
+    double gate_hangover_ms = 500.0;
+
+    // opus
+    int bitrate = 24000;
+    bool dtx = true;                 // VAD-driven discontinuous transmission
+    float dtx_threshold = 0.5f;
+    bool ogg = true;                 // Ogg pages rather than bare packets
+};
+
+// Null with |error| set for an unknown type
+std::unique_ptr<ProcessingStage> CreateStage(const StageSpec& spec, std::string* error);
+
+// Names CreateStage() knows, in table order
+std::vector<std::string> StageTypes();
+
+// What an output tap hands on
+enum class TapFormat { kFloat32, kPcm16, kOpus };
+
+// An output tap: the stream as it stands after |after| stages (0 = the
+// graph's input, StageCount() or more = its output), converted to
+// |sample_rate| and |format| on a branch of its own. Taps branching at
+// the same point and rate share one conversion.
+struct TapSpec {
+    std::string name;
+    size_t after = SIZE_MAX;
+    int sample_rate = 0;             // 0 = the rate at that point
+    TapFormat format = TapFormat::kFloat32;
+    StageSpec opus;                  // bitrate, dtx and container, for kOpus
+};
+
+// One tap's share of a Process() call: float32, int16 or encoded bytes,
+// in a buffer the consumer may hold on to. The graph fills it again only
+// once nothing else holds it; while one is held, it starts a new one.
+struct TapOutput {
+    std::shared_ptr<std::vector<uint8_t>> data;
+    std::vector<uint32_t> encoded_sizes;  // kOpus: one per packet, or per run of Ogg pages
+};
+
+// Per-stage counters for getStats()
+struct GraphStageStats {
+    const char* type = "";
+    bool enabled = true;
+    int input_rate = 0;
+    int output_rate = 0;
+    uint64_t frames = 0;       // frames the stage processed
+    uint64_t total_ns = 0;     // wall time in Process()
+    uint64_t max_ns = 0;
+    uint64_t cpu_ns = 0;       // the calling thread's CPU time in Process()
+};
+
+// Everything one Process() call produced. Cleared by Process(); capacity is
+// kept, so a steady stream stops allocating.
+struct GraphOutput {
+    std::vector<float> samples;     // frames no stage encoded
+    std::vector<int16_t> pcm16;     // frames an encode stage produced
+    std::vector<uint8_t> encoded;   // what an opus stage emitted, back to back
+    std::vector<uint32_t> encoded_sizes;  // one per packet, or per run of Ogg pages
+    std::vector<float> vad;         // one per kept frame when a vad stage ran
+    std::vector<TapOutput> taps;    // per AddTap() call, in order
+    size_t dropped_frames = 0;
+};
+
+// A chain of stages assembled once and driven by whole buffers, so a stream
+// crosses into native code once per buffer rather than once per stage.
+// Input is buffered into 10ms frames; a partial frame carries over to the
+// next call. Output taps branch off along the way, so each frame is
+// processed once however many forms it leaves in. Not thread-safe: build
+// it and drive it from one thread.
+class ProcessingGraph {
+public:
+    ProcessingGraph() = default;
+
+    ProcessingGraph(const ProcessingGraph&) = delete;
+    ProcessingGraph& operator=(const ProcessingGraph&) = delete;
+
+    // Prepares |stages| in order from |sample_rate| (a multiple of 100Hz).
+    // False with |error| naming the stage that refused.
+    bool Build(int sample_rate, std::vector<std::unique_ptr<ProcessingStage>> stages,
+               const std::vector<bool>& enabled, std::string* error);
+
+    // After Build(). False with |error| for a duplicate name or a rate or
+    // format the branch cannot produce.
+    bool AddTap(const TapSpec& spec, std::string* error);
+
+    void Process(const float* data, size_t num_samples, GraphOutput* output);
+    void ProcessRender(const float* data, size_t num_samples);
+
+    // False for an index out of range or a stage that changes the rate,
+    // which the stages after it depend on
+    bool SetStageEnabled(size_t index, bool enabled);
+
+    // Drops the partial frame and resets every stage and counter
+    void Reset();
+
+    size_t StageCount() const { return stages_.size(); }
+    size_t TapCount() const { return taps_.size(); }
+    const TapSpec& Tap(size_t index) const { return taps_[index].spec; }
+    int TapSampleRate(size_t index) const { return points_[taps_[index].point].rate; }
+    const GraphStageStats& Stats(size_t index) const { return stats_[index]; }
+    int InputSampleRate() const { return input_rate_; }
+    int OutputSampleRate() const { return output_rate_; }
+
+private:
+    // Where taps branch off: after a number of stages, at a rate
+    struct TapPoint {
+        size_t after = 0;
+        int rate = 0;
+        std::unique_ptr<ProcessingStage> resampler;  // none when the rate is the stream's there
+        std::vector<size_t> taps;
+    };
+    struct GraphTap {
+        TapSpec spec;
+        size_t point = 0;
+        std::unique_ptr<ProcessingStage> encoder;  // encode or opus; none for float32
+    };
+
+    void RunFrame(GraphOutput* output);
+    void RunTaps(size_t after, const GraphFrame& frame, GraphOutput* output);
+
+    std::vector<std::unique_ptr<ProcessingStage>> stages_;
+    std::vector<TapPoint> points_;
+    std::vector<GraphTap> taps_;
+    std::vector<GraphStageStats> stats_;
+    int input_rate_ = 0;
+    int output_rate_ = 0;
+    std::vector<float> frame_;
+    size_t fill_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,186 @@
+#include "prosody_tracker.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "modules/audio_processing/agc2/cpu_features.h"
+#include "modules/audio_processing/agc2/rnn_vad/common.h"
+#include "modules/audio_processing/agc2/rnn_vad/lp_residual.h"
+#include "modules/audio_processing/agc2/rnn_vad/pitch_search.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+namespace rnn_vad = webrtc::rnn_vad;
+
+// Voiced frames kept: enough for the utterance mean behind the ending
+static constexpr size_t kHistoryFrames = 400;
+
+// A frame is voiced when the VAD calls it speech and the residual's
+// normalized autocorrelation at the pitch lag reaches this
+static constexpr float kMinSpeechProbability = 0.5f;
+static constexpr float kMinPeriodicity = 0.45f;
+
+// Between voiced frames at most this many frames apart, a pitch step above
+// kOctaveJump semitones is folded back by octaves
+static constexpr uint64_t kMaxRunGap = 2;
+static constexpr float kOctaveJump = 7.0f;
+
+// The ending: its slope is fit over this much voiced speech, its level over the last part
+static constexpr double kSlopeWindowMs = 300.0;
+static constexpr double kLevelWindowMs = 150.0;
+static constexpr uint32_t kMinSlopeFrames = 8;
+
+// Logistic weights of the question likelihood: rises in pitch at the end
+// push it up, the usual declination and energy drop of a statement push it down
+static constexpr float kBias = -1.5f;
+static constexpr float kSlopeWeight = 0.12f;   // per semitone/s
+static constexpr float kRiseWeight = 0.35f;    // per semitone
+static constexpr float kEnergyWeight = 0.05f;  // per dB
+
+bool ProsodyTracker::Supports(int sample_rate) {
+    return sample_rate >= 8000 && sample_rate <= 48000 && sample_rate % 100 == 0;
+}
+
+ProsodyTracker::ProsodyTracker(int sample_rate)
+    : sample_rate_(sample_rate),
+      frame_size_(static_cast<size_t>(sample_rate / 100)),
+      pitch_(std::make_unique<rnn_vad::PitchEstimator>(webrtc::GetAvailableCpuFeatures())),
+      frame_24k_(rnn_vad::kFrameSize10ms24kHz, 0.0f),
+      buffer_(rnn_vad::kBufSize24kHz, 0.0f),
+      residual_(rnn_vad::kBufSize24kHz, 0.0f),
+      voiced_(kHistoryFrames) {
+    if (sample_rate != rnn_vad::kSampleRate24kHz) {
+        resampler_ = std::make_unique<webrtc::PushSincResampler>(frame_size_, rnn_vad::kFrameSize10ms24kHz);
+    }
+}
+
+ProsodyTracker::~ProsodyTracker() = default;
+
+void ProsodyTracker::Reset() {
+    std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+    voiced_next_ = 0;
+    voiced_count_ = 0;
+}
+
+void ProsodyTracker::ProcessFrame(const float* frame, float speech_probability, uint64_t sample_index) {
+    const size_t hop = rnn_vad::kFrameSize10ms24kHz;
+    if (resampler_) {
+        resampler_->Resample(frame, frame_size_, frame_24k_.data(), hop);
+    } else {
+        std::memcpy(frame_24k_.data(), frame, hop * sizeof(float));
+    }
+    std::memmove(buffer_.data(), buffer_.data() + hop, (buffer_.size() - hop) * sizeof(float));
+    std::memcpy(buffer_.data() + buffer_.size() - hop, frame_24k_.data(), hop * sizeof(float));
+    if (speech_probability < kMinSpeechProbability) {
+        return;
+    }
+
+    // The pitch search works on the LP residual, as in the VAD's features;
+    // it only needs running on frames that may be voiced
+    float lpc[rnn_vad::kNumLpcCoefficients];
+    rnn_vad::ComputeAndPostProcessLpcCoefficients(buffer_, webrtc::ArrayView<float, rnn_vad::kNumLpcCoefficients>(lpc));
+    rnn_vad::ComputeLpResidual(webrtc::ArrayView<const float, rnn_vad::kNumLpcCoefficients>(lpc), buffer_, residual_);
+    const int period_48k = std::max(rnn_vad::kMinPitch48kHz, pitch_->Estimate(
+        webrtc::ArrayView<const float, rnn_vad::kBufSize24kHz>(residual_.data(), residual_.size())));
+    const size_t lag = static_cast<size_t>(std::max(1, period_48k / 2));
+
+    // Periodicity of the last 20ms at that lag
+    const size_t window = rnn_vad::kFrameSize20ms24kHz;
+    const float* x = residual_.data() + residual_.size() - window;
+    const float* y = x - std::min(lag, residual_.size() - window);
+    float xy = 0.0f, xx = 0.0f, yy = 0.0f;
+    for (size_t i = 0; i < window; ++i) {
+        xy += x[i] * y[i];
+        xx += x[i] * x[i];
+        yy += y[i] * y[i];
+    }
+    const float periodicity = xy / std::sqrt(xx * yy + 1e-12f);
+    if (periodicity < kMinPeriodicity) {
+        return;
+    }
+
+    float energy = 0.0f;
+    for (size_t i = 0; i < hop; ++i) {
+        energy += frame_24k_[i] * frame_24k_[i];
+    }
+    const double f0 = 48000.0 / period_48k;
+    float semitones = static_cast<float>(12.0 * std::log2(f0 / 100.0));
+
+    // An octave jump within a run of voicing is the pitch search halving
+    // or doubling the period, not the voice
+    if (voiced_count_ > 0) {
+        const VoicedFrame& previous = voiced_[(voiced_next_ + kHistoryFrames - 1) % kHistoryFrames];
+        if (sample_index - previous.sample_index <= kMaxRunGap * frame_size_) {
+            while (semitones - previous.semitones > kOctaveJump) semitones -= 12.0f;
+            while (previous.semitones - semitones > kOctaveJump) semitones += 12.0f;
+        }
+    }
+    voiced_[voiced_next_] = {sample_index, semitones, 10.0f * std::log10(energy / hop + 1e-10f)};
+    voiced_next_ = (voiced_next_ + 1) % kHistoryFrames;
+    voiced_count_ = std::min(voiced_count_ + 1, kHistoryFrames);
+}
+
+UtteranceProsody ProsodyTracker::Summarize(uint64_t begin, uint64_t end) const {
+    UtteranceProsody result;
+
+    // Oldest to newest within [begin, end)
+    std::vector<VoicedFrame> frames;
+    frames.reserve(voiced_count_);
+    for (size_t i = 0; i < voiced_count_; ++i) {
+        const VoicedFrame& frame = voiced_[(voiced_next_ + kHistoryFrames - voiced_count_ + i) % kHistoryFrames];
+        if (frame.sample_index >= begin && frame.sample_index < end) {
+            frames.push_back(frame);
+        }
+    }
+    result.voiced_frames = static_cast<uint32_t>(frames.size());
+    if (result.voiced_frames < kMinSlopeFrames) {
+        return result;
+    }
+
+    double mean_pitch = 0.0, mean_energy = 0.0;
+    for (const VoicedFrame& frame : frames) {
+        mean_pitch += frame.semitones;
+        mean_energy += frame.energy_db;
+    }
+    mean_pitch /= frames.size();
+    mean_energy /= frames.size();
+
+    // Least squares over the ending, in seconds before the last voiced frame
+    const double rate = static_cast<double>(sample_rate_);
+    const uint64_t last = frames.back().sample_index;
+    double st = 0.0, sp = 0.0, stt = 0.0, stp = 0.0;
+    size_t n = 0;
+    double end_pitch = 0.0, end_energy = 0.0;
+    size_t end_n = 0;
+    for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+        double ago_ms = (last - it->sample_index) * 1000.0 / rate;
+        if (ago_ms > kSlopeWindowMs) {
+            break;
+        }
+        double t = -ago_ms / 1000.0;
+        st += t;
+        sp += it->semitones;
+        stt += t * t;
+        stp += t * it->semitones;
+        ++n;
+        if (ago_ms <= kLevelWindowMs) {
+            end_pitch += it->semitones;
+            end_energy += it->energy_db;
+            ++end_n;
+        }
+    }
+    const double denominator = n * stt - st * st;
+    if (n < kMinSlopeFrames || denominator <= 0.0) {
+        return result;
+    }
+    result.end_slope = static_cast<float>((n * stp - st * sp) / denominator);
+    result.end_rise = static_cast<float>(end_pitch / end_n - mean_pitch);
+    result.end_energy = static_cast<float>(end_energy / end_n - mean_energy);
+
+    const float z = kBias + kSlopeWeight * result.end_slope + kRiseWeight * result.end_rise +
+                    kEnergyWeight * result.end_energy;
+    result.question_likelihood = 1.0f / (1.0f + std::exp(-z));
+    return result;
+}
+
+} // namespace kakarot
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace webrtc {
+class PushSincResampler;
+namespace rnn_vad {
+class PitchEstimator;
+}
+}
+
+namespace kakarot {
+
+// How an utterance ended, for telling questions from statements before any
+// transcript: the pitch contour's slope over its last voiced 300ms, how far
+// its last 150ms sit above the utterance's mean pitch, and the same for
+// energy. -1 likelihood when too little of it was voiced to say.
+struct UtteranceProsody {
+    float question_likelihood = -1.0f;  // 0 to 1: rising terminal intonation
+    float end_slope = 0.0f;             // semitones per second
+    float end_rise = 0.0f;              // semitones over the utterance mean
+    float end_energy = 0.0f;            // dB over the utterance mean
+    uint32_t voiced_frames = 0;
+};
+
+// Tracks pitch per 10ms frame with the RNN VAD's pitch search (the LP
+// residual at 24kHz, autocorrelation at 12kHz refined at 24 and 48kHz),
+// keeping the last few seconds of voiced frames: those the VAD calls speech
+// whose residual is periodic at the found lag. Summarize() reads an
+// utterance's ending out of them. Not thread-safe: one instance per stream.
+class ProsodyTracker {
+public:
+    // 10ms frames at 8 to 48kHz
+    static bool Supports(int sample_rate);
+
+    explicit ProsodyTracker(int sample_rate);
+    ~ProsodyTracker();
+
+    ProsodyTracker(const ProsodyTracker&) = delete;
+    ProsodyTracker& operator=(const ProsodyTracker&) = delete;
+
+    // One frame of FrameSize() samples, its VAD probability and the stream
+    // position of its first sample
+    void ProcessFrame(const float* frame, float speech_probability, uint64_t sample_index);
+
+    // The voiced frames in [begin, end) of the stream
+    UtteranceProsody Summarize(uint64_t begin, uint64_t end) const;
+
+    void Reset();
+
+    size_t FrameSize() const { return frame_size_; }
+
+private:
+    struct VoicedFrame {
+        uint64_t sample_index;
+        float semitones;  // pitch relative to 100Hz
+        float energy_db;
+    };
+
+    const int sample_rate_;
+    const size_t frame_size_;
+    std::unique_ptr<webrtc::PushSincResampler> resampler_;  // null at 24kHz
+    std::unique_ptr<webrtc::rnn_vad::PitchEstimator> pitch_;
+    std::vector<float> frame_24k_;
+    std::vector<float> buffer_;    // rnn_vad::kBufSize24kHz, oldest first
+    std::vector<float> residual_;
+    std::vector<VoicedFrame> voiced_;  // ring of the newest kHistoryFrames
+    size_t voiced_next_ = 0;
+    size_t voiced_count_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,434 @@
+#include "recording_compressor.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "flac_encoder.h"
+#include "native_log.h"
+#include "ogg_opus_writer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#if defined(KAKAROT_HAVE_OPUS)
+#include <opus.h>
+#endif
+
+namespace kakarot {
+
+static const char* const kLogSource = "RecordingCompressor";
+
+// Progress is reported in steps of at least this much
+static constexpr double kProgressStep = 0.01;
+
+// Ogg Opus files: 20ms packets, half a second per page
+static constexpr int kOpusPacketMs = 20;
+static constexpr size_t kOpusPacketsPerPage = 25;
+static constexpr size_t kMaxOpusPacketBytes = 1275;
+
+namespace {
+
+struct WavInfo {
+    int format = 0;          // 1 PCM, 3 IEEE float
+    int channels = 0;
+    int sample_rate = 0;
+    int bits = 0;
+    uint64_t data_offset = 0;
+    uint64_t frames = 0;
+};
+
+uint32_t GetLe(const uint8_t* data, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint32_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+bool Seek(FILE* file, uint64_t offset, int whence) {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<__int64>(offset), whence) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), whence) == 0;
+#endif
+}
+
+uint64_t Tell(FILE* file) {
+#if defined(_WIN32)
+    return static_cast<uint64_t>(_ftelli64(file));
+#else
+    return static_cast<uint64_t>(ftello(file));
+#endif
+}
+
+// Walks the RIFF chunks to "data", leaving |file| at its first sample
+bool ReadWavHeader(FILE* file, uint64_t file_size, WavInfo* info, std::string* error) {
+    uint8_t riff[12];
+    if (std::fread(riff, 1, sizeof(riff), file) != sizeof(riff) || std::memcmp(riff, "RIFF", 4) != 0 ||
+        std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        *error = "not a WAV file";
+        return false;
+    }
+    bool have_format = false;
+    uint64_t data_bytes = 0;
+    for (;;) {
+        uint8_t chunk[8];
+        if (std::fread(chunk, 1, sizeof(chunk), file) != sizeof(chunk)) {
+            *error = "no data chunk";
+            return false;
+        }
+        uint64_t size = GetLe(chunk + 4, 4);
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t format[40] = {};
+            size_t wanted = static_cast<size_t>(std::min<uint64_t>(size, sizeof(format)));
+            if (size < 16 || std::fread(format, 1, wanted, file) != wanted) {
+                *error = "bad fmt chunk";
+                return false;
+            }
+            info->format = static_cast<int>(GetLe(format, 2));
+            if (info->format == 0xfffe && size >= 26) {
+                info->format = static_cast<int>(GetLe(format + 24, 2));  // WAVE_FORMAT_EXTENSIBLE
+            }
+            info->channels = static_cast<int>(GetLe(format + 2, 2));
+            info->sample_rate = static_cast<int>(GetLe(format + 4, 4));
+            info->bits = static_cast<int>(GetLe(format + 14, 2));
+            have_format = true;
+            Seek(file, size - wanted + (size & 1), SEEK_CUR);
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) {
+                *error = "data before fmt";
+                return false;
+            }
+            info->data_offset = Tell(file);
+            // Unpatched (0) or past the end: whatever reached the disk
+            data_bytes = size == 0 || info->data_offset + size > file_size ? file_size - info->data_offset : size;
+            break;
+        } else {
+            Seek(file, size + (size & 1), SEEK_CUR);
+        }
+    }
+
+    const bool pcm = info->format == 1 && (info->bits == 16 || info->bits == 24 || info->bits == 32);
+    const bool ieee = info->format == 3 && info->bits == 32;
+    if (!pcm && !ieee) {
+        *error = "only 16/24/32-bit PCM and 32-bit float WAV";
+        return false;
+    }
+    if (info->channels < 1 || info->channels > FlacEncoder::kMaxChannels || info->sample_rate <= 0) {
+        *error = "unsupported channel count or rate";
+        return false;
+    }
+    info->frames = (data_bytes / (info->bits / 8)) / static_cast<uint64_t>(info->channels);
+    return true;
+}
+
+// Reads up to |frames| interleaved frames as raw bytes into |bytes|
+size_t ReadFrames(FILE* file, const WavInfo& info, size_t frames, std::vector<uint8_t>* bytes) {
+    const size_t frame_bytes = static_cast<size_t>(info.channels * info.bits / 8);
+    bytes->resize(frames * frame_bytes);
+    return std::fread(bytes->data(), frame_bytes, frames, file);
+}
+
+float SampleToFloat(const WavInfo& info, const uint8_t* data) {
+    if (info.format == 3) {
+        float value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+    switch (info.bits) {
+        case 16: return static_cast<int16_t>(GetLe(data, 2)) / 32768.0f;
+        case 24: return static_cast<int32_t>(GetLe(data, 3) << 8) / 2147483648.0f;
+        default: return static_cast<int32_t>(GetLe(data, 4)) / 2147483648.0f;
+    }
+}
+
+// FLAC takes 16-bit sources as they are and everything else at 24 bits
+int32_t SampleToFlac(const WavInfo& info, const uint8_t* data) {
+    if (info.format == 3) {
+        float value;
+        std::memcpy(&value, data, sizeof(value));
+        return static_cast<int32_t>(std::lrint(std::clamp(value, -1.0f, 1.0f) * 8388607.0f));
+    }
+    switch (info.bits) {
+        case 16: return static_cast<int16_t>(GetLe(data, 2));
+        case 24: return static_cast<int32_t>(GetLe(data, 3) << 8) >> 8;
+        default: return static_cast<int32_t>(GetLe(data, 4)) >> 8;
+    }
+}
+
+struct Progress {
+    const CompressionProgressFn& report;
+    uint64_t total;
+    double last = 0.0;
+
+    void Update(uint64_t done) {
+        double fraction = total > 0 ? static_cast<double>(done) / total : 1.0;
+        if (report && (fraction - last >= kProgressStep || fraction >= 1.0)) {
+            last = fraction;
+            report(std::min(fraction, 1.0));
+        }
+    }
+};
+
+bool WriteAll(FILE* file, std::vector<uint8_t>* bytes, uint64_t* written) {
+    if (!bytes->empty() && std::fwrite(bytes->data(), 1, bytes->size(), file) != bytes->size()) {
+        return false;
+    }
+    *written += bytes->size();
+    bytes->clear();
+    return true;
+}
+
+bool EncodeFlac(FILE* in, const WavInfo& info, FILE* out, Progress* progress, const std::atomic<bool>& cancel,
+                uint64_t* written, std::string* error) {
+    const int bits = info.format == 1 && info.bits == 16 ? 16 : 24;
+    FlacEncoder encoder(info.sample_rate, info.channels, bits, info.frames);
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> encoded;
+    std::vector<int32_t> samples(FlacEncoder::kBlockSize * static_cast<size_t>(info.channels));
+    encoder.WriteHeader(&encoded);
+
+    const size_t sample_bytes = static_cast<size_t>(info.bits / 8);
+    uint64_t done = 0;
+    while (done < info.frames) {
+        TaskScheduler::YieldForAudio(cancel);
+        if (cancel.load(std::memory_order_relaxed)) {
+            *error = "cancelled";
+            return false;
+        }
+        size_t wanted = static_cast<size_t>(std::min<uint64_t>(FlacEncoder::kBlockSize, info.frames - done));
+        size_t frames = ReadFrames(in, info, wanted, &bytes);
+        if (frames == 0) {
+            break;  // the file came up short of its header; keep what there is
+        }
+        for (size_t i = 0; i < frames * static_cast<size_t>(info.channels); ++i) {
+            samples[i] = SampleToFlac(info, bytes.data() + i * sample_bytes);
+        }
+        encoder.EncodeBlock(samples.data(), frames, &encoded);
+        if (!WriteAll(out, &encoded, written)) {
+            *error = "write failed";
+            return false;
+        }
+        done += frames;
+        progress->Update(done);
+    }
+    return true;
+}
+
+#if defined(KAKAROT_HAVE_OPUS)
+struct OpusEncoderDeleter {
+    void operator()(OpusEncoder* encoder) const { opus_encoder_destroy(encoder); }
+};
+
+static bool IsOpusRate(int sample_rate) {
+    return sample_rate == 8000 || sample_rate == 12000 || sample_rate == 16000 || sample_rate == 24000 ||
+           sample_rate == 48000;
+}
+
+// Mono Ogg Opus; other channel counts are downmixed, other rates resampled
+// to 48kHz
+bool EncodeOpus(FILE* in, const WavInfo& info, int bitrate, FILE* out, Progress* progress,
+                const std::atomic<bool>& cancel, uint64_t* written, std::string* error) {
+    const bool resample = !IsOpusRate(info.sample_rate);
+    if (resample && info.sample_rate % 100 != 0) {
+        *error = "opus needs a rate that is a multiple of 100Hz";
+        return false;
+    }
+    const int rate = resample ? 48000 : info.sample_rate;
+    int status = OPUS_OK;
+    std::unique_ptr<OpusEncoder, OpusEncoderDeleter> encoder(
+        opus_encoder_create(rate, 1, OPUS_APPLICATION_AUDIO, &status));
+    if (status != OPUS_OK || !encoder) {
+        *error = std::string("opus_encoder_create failed: ") + opus_strerror(status);
+        return false;
+    }
+    opus_encoder_ctl(encoder.get(), OPUS_SET_BITRATE(bitrate));
+    opus_encoder_ctl(encoder.get(), OPUS_SET_COMPLEXITY(10));  // offline: spend the CPU
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(encoder.get(), OPUS_GET_LOOKAHEAD(&lookahead));
+    const int pre_skip = static_cast<int>(static_cast<int64_t>(lookahead) * 48000 / rate);
+
+    const size_t in_block = static_cast<size_t>(info.sample_rate / 100);
+    const size_t out_block = static_cast<size_t>(rate / 100);
+    std::unique_ptr<webrtc::PushSincResampler> resampler;
+    if (resample) {
+        resampler = std::make_unique<webrtc::PushSincResampler>(in_block, out_block);
+    }
+
+    OggOpusWriter writer;
+    std::vector<uint8_t> encoded;
+    writer.Begin(static_cast<uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count()),
+                 info.sample_rate, pre_skip, &encoded);
+
+    const size_t packet_samples = static_cast<size_t>(rate * kOpusPacketMs / 1000);
+    std::vector<float> mono(in_block);
+    std::vector<float> block(out_block);
+    std::vector<float> packet(packet_samples);
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> payload(kMaxOpusPacketBytes);
+    size_t fill = 0;
+    uint64_t done = 0;
+    uint64_t encoded_samples = 0;  // at |rate|, padding excluded
+    const size_t sample_bytes = static_cast<size_t>(info.bits / 8);
+
+    auto encode_packet = [&]() {
+        opus_int32 size = opus_encode_float(encoder.get(), packet.data(), static_cast<int>(packet_samples),
+                                            payload.data(), static_cast<opus_int32>(payload.size()));
+        if (size > 0) {
+            writer.AddPacket(payload.data(), static_cast<size_t>(size), 48 * kOpusPacketMs);
+            if (writer.PendingPackets() >= kOpusPacketsPerPage) {
+                writer.Flush(&encoded);
+            }
+        }
+        fill = 0;
+    };
+
+    while (done < info.frames) {
+        TaskScheduler::YieldForAudio(cancel);
+        if (cancel.load(std::memory_order_relaxed)) {
+            *error = "cancelled";
+            return false;
+        }
+        size_t wanted = static_cast<size_t>(std::min<uint64_t>(in_block, info.frames - done));
+        size_t frames = ReadFrames(in, info, wanted, &bytes);
+        if (frames == 0) {
+            break;
+        }
+        std::fill(mono.begin(), mono.end(), 0.0f);
+        for (size_t i = 0; i < frames; ++i) {
+            float sum = 0.0f;
+            for (int c = 0; c < info.channels; ++c) {
+                sum += SampleToFloat(info, bytes.data() + (i * info.channels + c) * sample_bytes);
+            }
+            mono[i] = sum / static_cast<float>(info.channels);
+        }
+        const float* source = mono.data();
+        size_t count = frames;
+        if (resampler) {
+            resampler->Resample(mono.data(), in_block, block.data(), out_block);
+            source = block.data();
+            count = frames == in_block ? out_block : frames * out_block / in_block;
+        }
+        encoded_samples += count;
+        for (size_t i = 0; i < count; ++i) {
+            packet[fill++] = source[i];
+            if (fill == packet_samples) {
+                encode_packet();
+            }
+        }
+        if (!WriteAll(out, &encoded, written)) {
+            *error = "write failed";
+            return false;
+        }
+        done += frames;
+        progress->Update(done);
+    }
+
+    // The lookahead still in the encoder, then the last packet's padding,
+    // which the final granule trims
+    size_t flush = static_cast<size_t>(lookahead);
+    while (flush > 0 || fill > 0) {
+        size_t take = std::min(flush, packet_samples - fill);
+        std::fill(packet.begin() + fill, packet.begin() + fill + take, 0.0f);
+        fill += take;
+        flush -= take;
+        std::fill(packet.begin() + fill, packet.end(), 0.0f);
+        encode_packet();
+    }
+    writer.Finish(pre_skip + encoded_samples * 48000 / rate, &encoded);
+    if (!WriteAll(out, &encoded, written)) {
+        *error = "write failed";
+        return false;
+    }
+    return true;
+}
+#endif
+
+} // namespace
+
+CompressionResult CompressRecording(const CompressionJob& job, const CompressionProgressFn& progress,
+                                    const std::atomic<bool>& cancel) {
+    CompressionResult result;
+    auto start = std::chrono::steady_clock::now();
+
+    // Its samples are ciphertext, and an archive of them in the clear would undo the point
+    const std::string tags = job.input + ".tag";
+    if (FILE* sealed = std::fopen(tags.c_str(), "rb")) {
+        std::fclose(sealed);
+        result.error = "encrypted recording: " + job.input;
+        return result;
+    }
+    FILE* in = std::fopen(job.input.c_str(), "rb");
+    if (!in) {
+        result.error = "cannot open " + job.input;
+        return result;
+    }
+    Seek(in, 0, SEEK_END);
+    result.input_bytes = Tell(in);
+    Seek(in, 0, SEEK_SET);
+
+    WavInfo info;
+    if (!ReadWavHeader(in, result.input_bytes, &info, &result.error)) {
+        std::fclose(in);
+        return result;
+    }
+    result.audio_seconds = static_cast<double>(info.frames) / info.sample_rate;
+
+    const std::string part = job.output + ".part";
+    FILE* out = std::fopen(part.c_str(), "wb");
+    if (!out) {
+        std::fclose(in);
+        result.error = "cannot create " + part;
+        return result;
+    }
+
+    Progress tracker{progress, info.frames};
+    bool ok = false;
+    if (job.format == CompressionFormat::kFlac) {
+        ok = EncodeFlac(in, info, out, &tracker, cancel, &result.output_bytes, &result.error);
+    } else {
+#if defined(KAKAROT_HAVE_OPUS)
+        ok = EncodeOpus(in, info, job.bitrate, out, &tracker, cancel, &result.output_bytes, &result.error);
+#else
+        result.error = "this build has no Opus encoder";
+#endif
+    }
+    std::fclose(in);
+    ok = std::fclose(out) == 0 && ok;
+
+    if (ok) {
+        std::remove(job.output.c_str());  // rename() will not replace on Windows
+        ok = std::rename(part.c_str(), job.output.c_str()) == 0;
+        if (!ok) {
+            result.error = "cannot rename " + part;
+        }
+    }
+    if (!ok) {
+        std::remove(part.c_str());
+        return result;
+    }
+    if (job.delete_input) {
+        std::remove(job.input.c_str());
+    }
+    tracker.Update(info.frames);
+    result.ok = true;
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void SubmitCompression(TaskScheduler* scheduler, CompressionJob job, CompressionProgressFn progress,
+                       CompressionDoneFn done) {
+    scheduler->Post(TaskPriority::kBackground, [job = std::move(job), progress = std::move(progress),
+                                                done = std::move(done)](const std::atomic<bool>& cancel) {
+        CompressionResult result = CompressRecording(job, progress, cancel);
+        if (result.ok) {
+            Log(LogLevel::kInfo, kLogSource, "%s: %.0fs of audio, %llu -> %llu bytes in %.0fms",
+                job.output.c_str(), result.audio_seconds, static_cast<unsigned long long>(result.input_bytes),
+                static_cast<unsigned long long>(result.output_bytes), result.elapsed_ms);
+        } else {
+            Log(LogLevel::kWarn, kLogSource, "%s: %s", job.input.c_str(), result.error.c_str());
+        }
+        done(result);
+    });
+}
+
+} // namespace kakarot
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "task_scheduler.h"
+
+namespace kakarot {
+
+enum class CompressionFormat {
+    kFlac,  // lossless, for archival
+    kOpus,  // Ogg Opus, for playback; only in builds with libopus
+};
+
+struct CompressionJob {
+    std::string input;           // a WAV file: 16/24-bit PCM or 32-bit float; not an encrypted recording
+    std::string output;
+    CompressionFormat format = CompressionFormat::kFlac;
+    int bitrate = 32000;         // opus
+    bool delete_input = false;   // once the output is complete
+};
+
+struct CompressionResult {
+    bool ok = false;
+    std::string error;
+    uint64_t input_bytes = 0;
+    uint64_t output_bytes = 0;
+    double audio_seconds = 0.0;
+    double elapsed_ms = 0.0;
+};
+
+// Both run on the worker thread doing the job
+using CompressionProgressFn = std::function<void(double fraction)>;
+using CompressionDoneFn = std::function<void(const CompressionResult& result)>;
+
+// Compresses |job| on the calling thread, polling |cancel| between blocks.
+// Output goes to <output>.part and is renamed once complete, so a file at
+// |job.output| is always whole. A WAV whose header sizes were never patched
+// (a recording cut short) is read to the end of the file.
+CompressionResult CompressRecording(const CompressionJob& job, const CompressionProgressFn& progress,
+                                    const std::atomic<bool>& cancel);
+
+// Compresses |job| as a background task on |scheduler|, off the JS thread,
+// the audio threads and libuv's pool. |done| is always called, exactly once;
+// at the scheduler's teardown with a "cancelled" result.
+void SubmitCompression(TaskScheduler* scheduler, CompressionJob job, CompressionProgressFn progress,
+                       CompressionDoneFn done);
+
+} // namespace kakarot
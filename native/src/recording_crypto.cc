@@ -0,0 +1,77 @@
+#include "recording_crypto.h"
+#include "recording_index.h"
+#include <cstring>
+#include <mutex>
+#include <random>
+
+namespace kakarot {
+
+using recording_index::GetLe;
+using recording_index::PutLe;
+
+// The key check's block number, past any file's blocks
+static constexpr uint32_t kKeyCheckBlock = 0xffffffffu;
+
+namespace {
+
+std::mutex g_key_mutex;
+std::shared_ptr<const AesGcm> g_cipher;
+
+} // namespace
+
+void SetRecordingKey(const uint8_t key[kAesGcmKeySize]) {
+    auto cipher = std::make_shared<const AesGcm>(key);
+    std::lock_guard<std::mutex> lock(g_key_mutex);
+    g_cipher = std::move(cipher);
+}
+
+void ClearRecordingKey() {
+    std::lock_guard<std::mutex> lock(g_key_mutex);
+    g_cipher.reset();
+}
+
+std::shared_ptr<const AesGcm> RecordingCipher() {
+    std::lock_guard<std::mutex> lock(g_key_mutex);
+    return g_cipher;
+}
+
+void RecordingBlockIv(const uint8_t prefix[kRecordingIvPrefixSize], uint32_t block, uint8_t iv[kAesGcmIvSize]) {
+    std::memcpy(iv, prefix, kRecordingIvPrefixSize);
+    for (size_t i = 0; i < 4; ++i) {
+        iv[kRecordingIvPrefixSize + i] = static_cast<uint8_t>(block >> (24 - 8 * i));
+    }
+}
+
+void NewRecordingTagHeader(const AesGcm& cipher, uint8_t prefix[kRecordingIvPrefixSize],
+                           uint8_t header[kRecordingTagHeaderSize]) {
+    // The OS's entropy on every platform we ship
+    std::random_device random;
+    for (size_t i = 0; i < kRecordingIvPrefixSize; i += 4) {
+        PutLe(prefix + i, random(), 4);
+    }
+    std::memcpy(header, "KKTG", 4);
+    PutLe(header + 4, kRecordingTagVersion, 4);
+    PutLe(header + 8, kRecordingCryptoBlockBytes, 4);
+    std::memcpy(header + 12, prefix, kRecordingIvPrefixSize);
+    uint8_t iv[kAesGcmIvSize];
+    RecordingBlockIv(prefix, kKeyCheckBlock, iv);
+    cipher.Seal(iv, header, 4, nullptr, 0, header + 20);
+}
+
+bool CheckRecordingTagHeader(const AesGcm& cipher, const uint8_t* data, size_t size,
+                             uint8_t prefix[kRecordingIvPrefixSize], uint32_t* block_bytes) {
+    if (size < kRecordingTagHeaderSize || std::memcmp(data, "KKTG", 4) != 0 ||
+        GetLe(data + 4, 4) != kRecordingTagVersion || GetLe(data + 8, 4) == 0) {
+        return false;
+    }
+    std::memcpy(prefix, data + 12, kRecordingIvPrefixSize);
+    uint8_t iv[kAesGcmIvSize];
+    RecordingBlockIv(prefix, kKeyCheckBlock, iv);
+    if (!cipher.Open(iv, data, 4, nullptr, 0, data + 20)) {
+        return false;
+    }
+    *block_bytes = static_cast<uint32_t>(GetLe(data + 8, 4));
+    return true;
+}
+
+} // namespace kakarot
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "aes_gcm.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace kakarot {
+
+// Recordings at rest, for a recorder started with encrypt: each WAV's data
+// is sealed in fixed blocks of plaintext with AES-256-GCM, in place, so a
+// sample's offset is the same in the ciphertext and the index needs no
+// change; the header stays plain. The IV of block <b> is the file's random
+// 8-byte prefix and <b> big-endian, so a block can be opened alone and no
+// IV repeats under the key. The tags go beside the WAV in <wav>.tag:
+//
+//   header  "KKTG", u32 version, u32 block_bytes, u8[8] iv prefix,
+//           u8[16] key check (the tag of nothing, IV <prefix, ffffffff>)
+//   tag     u8[16] per block, in order
+//
+// Only whole blocks reach the WAV while recording, each with its tag, so a
+// crash loses the part-filled last block at most; the last block of a
+// finished file is short. The key is the process's, set once from the OS
+// keychain (through JS), never stored beside the audio.
+constexpr size_t kRecordingCryptoBlockBytes = 65536;
+constexpr size_t kRecordingTagHeaderSize = 36;
+constexpr size_t kRecordingIvPrefixSize = 8;
+constexpr uint32_t kRecordingTagVersion = 1;
+
+// Replaces the process's recording key; recordings started and readers
+// opened from now on use it
+void SetRecordingKey(const uint8_t key[kAesGcmKeySize]);
+void ClearRecordingKey();
+// The cipher under the current key, or null when none is set
+std::shared_ptr<const AesGcm> RecordingCipher();
+
+void RecordingBlockIv(const uint8_t prefix[kRecordingIvPrefixSize], uint32_t block, uint8_t iv[kAesGcmIvSize]);
+
+// A fresh random prefix and its header under |cipher|
+void NewRecordingTagHeader(const AesGcm& cipher, uint8_t prefix[kRecordingIvPrefixSize],
+                           uint8_t header[kRecordingTagHeaderSize]);
+// False for a header that is not a tag file's or whose key check fails
+// under |cipher| (another key)
+bool CheckRecordingTagHeader(const AesGcm& cipher, const uint8_t* data, size_t size,
+                             uint8_t prefix[kRecordingIvPrefixSize], uint32_t* block_bytes);
+
+} // namespace kakarot
@@ -0,0 +1,127 @@
+#include "recording_frames.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kakarot {
+
+// Longest read from a track at once
+static constexpr double kReadMs = 10000.0;
+
+TrackFrames::TrackFrames(int sample_rate)
+    : rate_(sample_rate), frame_(static_cast<size_t>(sample_rate / 100)), resampled_(frame_) {}
+
+TrackFrames::~TrackFrames() = default;
+
+bool TrackFrames::Next(float* out, const std::atomic<bool>& cancel, std::string* error) {
+    while (!end_ && pending_.size() - head_ < frame_) {
+        if (!Fill(cancel, error)) {
+            return false;
+        }
+    }
+    const size_t available = std::min(frame_, pending_.size() - head_);
+    std::copy(pending_.begin() + head_, pending_.begin() + head_ + available, out);
+    std::fill(out + available, out + frame_, 0.0f);
+    head_ += available;
+    if (head_ > kReadMs * rate_ / 1000.0) {
+        pending_.erase(pending_.begin(), pending_.begin() + head_);
+        head_ = 0;
+    }
+    return true;
+}
+
+bool TrackFrames::Fill(const std::atomic<bool>& cancel, std::string* error) {
+    TaskScheduler::YieldForAudio(cancel);
+    if (cancel.load(std::memory_order_relaxed)) {
+        *error = "cancelled";
+        return false;
+    }
+    RecordingRange range;
+    if (!reader_.Read(read_ms_, kReadMs, &range, error)) {
+        return false;
+    }
+    if (range.samples == 0) {
+        end_ = true;
+        return true;
+    }
+    if (range.sample_rate % 100 != 0) {
+        *error = "recording rate is not a multiple of 100Hz";
+        return false;
+    }
+    read_ms_ = range.start_ms + range.samples * 1000.0 / range.sample_rate;
+
+    // A gap: silence up to the range, dropping the resampler's partial block
+    const uint64_t due = static_cast<uint64_t>(range.start_ms * rate_ / 1000.0);
+    if (due > produced_ + frame_) {
+        pending_.resize(pending_.size() + (due - produced_), 0.0f);
+        produced_ = due;
+        fill_ = 0;
+    }
+
+    scratch_.resize(range.samples);
+    DownmixRange(range, range.samples, scratch_.data());
+    if (range.sample_rate == rate_) {
+        Append(scratch_.data(), scratch_.size());
+        return true;
+    }
+    // A device switch mid-recording changes the rate
+    if (!resampler_ || resampler_rate_ != range.sample_rate) {
+        resampler_ = std::make_unique<webrtc::PushSincResampler>(range.sample_rate / 100, frame_);
+        resampler_rate_ = range.sample_rate;
+        block_.assign(static_cast<size_t>(range.sample_rate / 100), 0.0f);
+        fill_ = 0;
+    }
+    for (float sample : scratch_) {
+        block_[fill_++] = sample;
+        if (fill_ == block_.size()) {
+            resampler_->Resample(block_.data(), block_.size(), resampled_.data(), resampled_.size());
+            Append(resampled_.data(), resampled_.size());
+            fill_ = 0;
+        }
+    }
+    return true;
+}
+
+void TrackFrames::Append(const float* data, size_t count) {
+    pending_.insert(pending_.end(), data, data + count);
+    produced_ += count;
+}
+
+FlacFileWriter::FlacFileWriter(FILE* out, int sample_rate, uint64_t total_frames)
+    : out_(out), encoder_(sample_rate, 1, 16, total_frames) {
+    block_.reserve(FlacEncoder::kBlockSize);
+    encoder_.WriteHeader(&encoded_);
+    ok_ = Flush();
+}
+
+void FlacFileWriter::Write(const float* data, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        block_.push_back(static_cast<int32_t>(std::lrint(std::clamp(data[i], -1.0f, 1.0f) * 32767.0f)));
+        if (block_.size() == FlacEncoder::kBlockSize) {
+            EncodeBlock();
+        }
+    }
+}
+
+bool FlacFileWriter::Finish() {
+    if (!block_.empty()) {
+        EncodeBlock();
+    }
+    return ok_;
+}
+
+void FlacFileWriter::EncodeBlock() {
+    encoder_.EncodeBlock(block_.data(), block_.size(), &encoded_);
+    block_.clear();
+    ok_ = Flush() && ok_;
+}
+
+bool FlacFileWriter::Flush() {
+    const bool written = std::fwrite(encoded_.data(), 1, encoded_.size(), out_) == encoded_.size();
+    bytes_ += encoded_.size();
+    encoded_.clear();
+    return written;
+}
+
+} // namespace kakarot
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "flac_encoder.h"
+#include "recording_reader.h"
+
+namespace webrtc {
+class PushSincResampler;
+}
+
+namespace kakarot {
+
+// A track as 10ms frames at one rate from recording time 0. What the
+// recorder never got, across a gap or past the end, comes out as silence,
+// so two tracks read frame by frame stay in step.
+class TrackFrames {
+public:
+    explicit TrackFrames(int sample_rate);
+    ~TrackFrames();
+
+    TrackFrames(const TrackFrames&) = delete;
+    TrackFrames& operator=(const TrackFrames&) = delete;
+
+    bool Open(const std::string& index, std::string* error) { return reader_.Open(index, error); }
+    double DurationMs() { return reader_.DurationMs(); }
+    uint64_t StartedAtMs() const { return reader_.StartedAtMs(); }
+
+    // The next frame_ samples into |out|
+    bool Next(float* out, const std::atomic<bool>& cancel, std::string* error);
+
+private:
+    // The next range of the track onto pending_ at rate_
+    bool Fill(const std::atomic<bool>& cancel, std::string* error);
+    void Append(const float* data, size_t count);
+
+    RecordingReader reader_;
+    const int rate_;
+    const size_t frame_;
+    std::vector<float> pending_;
+    size_t head_ = 0;          // of pending_, handed out
+    uint64_t produced_ = 0;    // samples at rate_ ever appended
+    double read_ms_ = 0.0;
+    bool end_ = false;
+    std::unique_ptr<webrtc::PushSincResampler> resampler_;
+    int resampler_rate_ = 0;
+    std::vector<float> block_;  // 10ms at the track's rate
+    size_t fill_ = 0;
+    std::vector<float> resampled_;
+    std::vector<float> scratch_;
+};
+
+// 16-bit mono FLAC blocks straight to |out| as they fill
+class FlacFileWriter {
+public:
+    FlacFileWriter(FILE* out, int sample_rate, uint64_t total_frames);
+
+    void Write(const float* data, size_t count);
+
+    // The last, short block; false if any write failed
+    bool Finish();
+
+    uint64_t Bytes() const { return bytes_; }
+
+private:
+    void EncodeBlock();
+    bool Flush();
+
+    FILE* out_;
+    FlacEncoder encoder_;
+    std::vector<int32_t> block_;
+    std::vector<uint8_t> encoded_;
+    uint64_t bytes_ = 0;
+    bool ok_ = true;
+};
+
+} // namespace kakarot
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace kakarot {
+
+// The recorder's per-track seek index, <name>.<track>.idx: a fixed header,
+// then an entry every index_interval_ms of audio and at the start of each
+// WAV. Entries only ever append, so a crash leaves a valid index of every
+// whole entry written. All fields are little-endian.
+//
+// With kRecordingIndexLoudness set, the last two fields are the track's
+// integrated loudness (LUFS) and sample peak (dBFS) so far, in hundredths;
+// the recorder rewrites the header as it syncs. Older indexes have zeros
+// there and the flag clear.
+//
+// With kRecordingIndexSilence set, the recorder left long silences out of
+// the WAVs: an entry with kRecordingIndexSilenceMark in its file field opens
+// such a run at its time, without audio, and the next entry ends it, so the
+// timeline keeps its length while the run costs one entry.
+//
+// With kRecordingIndexEncrypted set, each WAV's samples are sealed as
+// recording_crypto.h describes; offsets are unchanged.
+//
+//   header  "KKIX", u32 version, u32 interval_ms, u32 flags,
+//           u64 started_at_ms (Unix epoch), i32 loudness, i32 peak
+//   entry   u32 time_ms (since started_at), u32 file (the <n> of the WAV),
+//           u64 sample (its offset in that WAV's data)
+constexpr size_t kRecordingIndexHeaderSize = 32;
+constexpr size_t kRecordingIndexEntrySize = 16;
+constexpr uint32_t kRecordingIndexVersion = 1;
+constexpr uint32_t kRecordingIndexFloat32 = 1u << 0;
+constexpr uint32_t kRecordingIndexLoudness = 1u << 1;
+constexpr uint32_t kRecordingIndexSilence = 1u << 2;
+constexpr uint32_t kRecordingIndexEncrypted = 1u << 3;
+constexpr uint32_t kRecordingIndexSilenceMark = 1u << 31;
+
+struct RecordingIndexHeader {
+    uint32_t interval_ms = 0;
+    uint32_t flags = 0;
+    uint64_t started_at_ms = 0;
+    double loudness_lufs = 0.0;  // with kRecordingIndexLoudness
+    double peak_dbfs = 0.0;
+};
+
+struct RecordingIndexEntry {
+    uint32_t time_ms = 0;
+    uint32_t file = 0;
+    uint64_t sample = 0;
+    bool silence = false;  // a run of compacted silence starts here
+};
+
+namespace recording_index {
+
+inline void PutLe(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+inline uint64_t GetLe(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+inline void EncodeHeader(const RecordingIndexHeader& header, uint8_t out[kRecordingIndexHeaderSize]) {
+    std::memset(out, 0, kRecordingIndexHeaderSize);
+    std::memcpy(out, "KKIX", 4);
+    PutLe(out + 4, kRecordingIndexVersion, 4);
+    PutLe(out + 8, header.interval_ms, 4);
+    PutLe(out + 12, header.flags, 4);
+    PutLe(out + 16, header.started_at_ms, 8);
+    if (header.flags & kRecordingIndexLoudness) {
+        PutLe(out + 24, static_cast<uint32_t>(static_cast<int32_t>(std::lround(header.loudness_lufs * 100.0))), 4);
+        PutLe(out + 28, static_cast<uint32_t>(static_cast<int32_t>(std::lround(header.peak_dbfs * 100.0))), 4);
+    }
+}
+
+// False for another file or a version this build does not read
+inline bool DecodeHeader(const uint8_t* in, size_t size, RecordingIndexHeader* header) {
+    if (size < kRecordingIndexHeaderSize || std::memcmp(in, "KKIX", 4) != 0 ||
+        GetLe(in + 4, 4) != kRecordingIndexVersion) {
+        return false;
+    }
+    header->interval_ms = static_cast<uint32_t>(GetLe(in + 8, 4));
+    header->flags = static_cast<uint32_t>(GetLe(in + 12, 4));
+    header->started_at_ms = GetLe(in + 16, 8);
+    if (header->flags & kRecordingIndexLoudness) {
+        header->loudness_lufs = static_cast<int32_t>(static_cast<uint32_t>(GetLe(in + 24, 4))) / 100.0;
+        header->peak_dbfs = static_cast<int32_t>(static_cast<uint32_t>(GetLe(in + 28, 4))) / 100.0;
+    }
+    return true;
+}
+
+inline void EncodeEntry(const RecordingIndexEntry& entry, uint8_t out[kRecordingIndexEntrySize]) {
+    PutLe(out, entry.time_ms, 4);
+    PutLe(out + 4, entry.file | (entry.silence ? kRecordingIndexSilenceMark : 0), 4);
+    PutLe(out + 8, entry.sample, 8);
+}
+
+inline RecordingIndexEntry DecodeEntry(const uint8_t* in) {
+    RecordingIndexEntry entry;
+    entry.time_ms = static_cast<uint32_t>(GetLe(in, 4));
+    const uint32_t file = static_cast<uint32_t>(GetLe(in + 4, 4));
+    entry.file = file & ~kRecordingIndexSilenceMark;
+    entry.silence = (file & kRecordingIndexSilenceMark) != 0;
+    entry.sample = GetLe(in + 8, 8);
+    return entry;
+}
+
+} // namespace recording_index
+
+} // namespace kakarot
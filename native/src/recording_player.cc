@@ -0,0 +1,185 @@
+#include "recording_player.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kakarot {
+
+// Per read of the recording: short, so a skip-silence or speed change is
+// heard at once
+static constexpr double kReadMs = 100.0;
+
+// A read starting further than this from where the last ended is a jump
+// (skipped silence, a gap), and starts a new run
+static constexpr double kJumpMs = 1.0;
+
+namespace {
+
+// The first |frames| of |range| as |channels| interleaved floats: mono
+// averages the track's channels, stereo takes its first two or repeats a
+// mono one
+void ConvertRange(const RecordingRange& range, size_t frames, int channels, std::vector<float>* out) {
+    out->assign(frames * channels, 0.0f);
+    if (range.silent) {
+        return;
+    }
+    if (channels == 1 || range.channels == 1) {
+        std::vector<float> mono(frames);
+        DownmixRange(range, frames, mono.data());
+        for (size_t i = 0; i < frames; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                (*out)[i * channels + c] = mono[i];
+            }
+        }
+        return;
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            const size_t at = i * range.channels + c;
+            (*out)[i * channels + c] = range.float32
+                ? reinterpret_cast<const float*>(range.data)[at]
+                : reinterpret_cast<const int16_t*>(range.data)[at] / 32768.0f;
+        }
+    }
+}
+
+} // namespace
+
+RecordingPlayer::RecordingPlayer(int sample_rate)
+    : rate_(std::clamp(sample_rate, 8000, 48000) / 100 * 100),
+      stretcher_(std::make_unique<TimeStretcher>(rate_, 1)) {}
+
+RecordingPlayer::~RecordingPlayer() = default;
+
+bool RecordingPlayer::Open(const std::string& index_path, std::string* error) {
+    if (!reader_.Open(index_path, error)) {
+        return false;
+    }
+    // The first audio, for its channel count
+    RecordingRange range;
+    if (!reader_.Read(0.0, 10.0, &range, error, SilenceMode::kSkip)) {
+        return false;
+    }
+    channels_ = range.samples > 0 ? std::min(range.channels, TimeStretcher::kMaxChannels) : 1;
+    const double speed = stretcher_->Speed();
+    stretcher_ = std::make_unique<TimeStretcher>(rate_, channels_);
+    stretcher_->SetSpeed(speed);
+    Seek(0.0);
+    return true;
+}
+
+void RecordingPlayer::Seek(double ms) {
+    stretcher_->Reset();
+    read_ms_ = std::max(0.0, ms);
+    next_ms_ = -1.0;
+    pushed_ = 0;
+    runs_.clear();
+    resampler_rate_ = 0;
+    resamplers_.clear();
+    fill_ = 0;
+}
+
+double RecordingPlayer::PositionMs() const {
+    const double input = stretcher_->InputPosition();
+    if (runs_.empty()) {
+        return read_ms_;
+    }
+    const Run* run = &runs_.front();
+    for (const Run& candidate : runs_) {
+        if (static_cast<double>(candidate.frame) > input) {
+            break;
+        }
+        run = &candidate;
+    }
+    return run->ms + (input - static_cast<double>(run->frame)) * 1000.0 / rate_;
+}
+
+bool RecordingPlayer::Render(float* out, size_t frames, size_t* rendered, std::string* error) {
+    *rendered = 0;
+    while (*rendered < frames) {
+        const size_t pulled = stretcher_->Pull(out + *rendered * channels_, frames - *rendered);
+        *rendered += pulled;
+        if (*rendered == frames || stretcher_->Drained() || (pulled == 0 && stretcher_->InputEnded())) {
+            break;
+        }
+        if (!Fill(error)) {
+            return false;
+        }
+    }
+    // Runs the output has moved past
+    const double input = stretcher_->InputPosition();
+    while (runs_.size() > 1 && static_cast<double>(runs_[1].frame) <= input) {
+        runs_.pop_front();
+    }
+    return true;
+}
+
+bool RecordingPlayer::Fill(std::string* error) {
+    RecordingRange range;
+    if (!reader_.Read(read_ms_, kReadMs, &range, error,
+                      skip_silence_ ? SilenceMode::kSkip : SilenceMode::kFill)) {
+        return false;
+    }
+    if (range.samples == 0) {
+        stretcher_->EndInput();
+        return true;
+    }
+    if (range.sample_rate % 100 != 0) {
+        *error = "recording rate is not a multiple of 100Hz";
+        return false;
+    }
+    if (next_ms_ < 0.0 || std::fabs(range.start_ms - next_ms_) > kJumpMs) {
+        // Frames still waiting in the resamplers' block come first
+        const int64_t waiting = resampler_rate_ > 0 && resampler_rate_ != rate_
+            ? static_cast<int64_t>(fill_) * rate_ / resampler_rate_ : 0;
+        runs_.push_back({pushed_ + waiting, range.start_ms});
+    }
+    read_ms_ = range.start_ms + range.samples * 1000.0 / range.sample_rate;
+    next_ms_ = read_ms_;
+    ConvertRange(range, range.samples, channels_, &converted_);
+    PushAtRate(converted_.data(), range.samples, range.sample_rate);
+    return true;
+}
+
+void RecordingPlayer::PushAtRate(const float* interleaved, size_t frames, int sample_rate) {
+    if (sample_rate == rate_) {
+        stretcher_->Push(interleaved, frames);
+        pushed_ += static_cast<int64_t>(frames);
+        return;
+    }
+    // A device switch mid-recording changes the rate
+    const size_t in_block = static_cast<size_t>(sample_rate / 100);
+    const size_t out_block = static_cast<size_t>(rate_ / 100);
+    if (resampler_rate_ != sample_rate) {
+        resamplers_.clear();
+        for (int c = 0; c < channels_; ++c) {
+            resamplers_.push_back(std::make_unique<webrtc::PushSincResampler>(in_block, out_block));
+        }
+        resampler_rate_ = sample_rate;
+        block_.assign(in_block * channels_, 0.0f);
+        planar_.resize(in_block);
+        resampled_.resize(out_block);
+        output_.resize(out_block * channels_);
+        fill_ = 0;
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        std::copy(interleaved + i * channels_, interleaved + (i + 1) * channels_, block_.begin() + fill_ * channels_);
+        if (++fill_ < in_block) {
+            continue;
+        }
+        for (int c = 0; c < channels_; ++c) {
+            for (size_t n = 0; n < in_block; ++n) {
+                planar_[n] = block_[n * channels_ + c];
+            }
+            resamplers_[c]->Resample(planar_.data(), in_block, resampled_.data(), out_block);
+            for (size_t n = 0; n < out_block; ++n) {
+                output_[n * channels_ + c] = resampled_[n];
+            }
+        }
+        stretcher_->Push(output_.data(), out_block);
+        pushed_ += static_cast<int64_t>(out_block);
+        fill_ = 0;
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "recording_reader.h"
+#include "time_stretcher.h"
+
+namespace webrtc {
+class PushSincResampler;
+}
+
+namespace kakarot {
+
+// One track of a recording played at 0.5x to 3x, for review. Audio comes
+// off the mapped WAVs through the seek index 100ms at a time as the
+// caller renders, goes to the output rate and through a TimeStretcher, so
+// what is buffered is a few windows whatever the recording's length and a
+// seek is a binary search plus a 10ms fade-in. Compacted silence plays as
+// recorded or is skipped; either can change while playing, as can the
+// speed. One thread at a time.
+class RecordingPlayer {
+public:
+    // Output at |sample_rate|, 8 to 48kHz in steps of 100Hz
+    explicit RecordingPlayer(int sample_rate);
+    ~RecordingPlayer();
+
+    RecordingPlayer(const RecordingPlayer&) = delete;
+    RecordingPlayer& operator=(const RecordingPlayer&) = delete;
+
+    // |index_path| as RecordingReader takes it; the output is stereo for a
+    // stereo recording, else mono. Plays from the start.
+    bool Open(const std::string& index_path, std::string* error);
+
+    void SetSpeed(double speed) { stretcher_->SetSpeed(speed); }
+    double Speed() const { return stretcher_->Speed(); }
+    void SetSkipSilence(bool skip) { skip_silence_ = skip; }
+    bool SkipSilence() const { return skip_silence_; }
+
+    // Recording time to play from next
+    void Seek(double ms);
+
+    // |frames| interleaved frames of Channels() into |out|, fewer only at
+    // the end of the recording; false for a block that fails authentication
+    bool Render(float* out, size_t frames, size_t* rendered, std::string* error);
+
+    bool Ended() const { return stretcher_->Drained(); }
+    // Recording time of the next frame Render() returns
+    double PositionMs() const;
+    double DurationMs() { return reader_.DurationMs(); }
+
+    int SampleRate() const { return rate_; }
+    int Channels() const { return channels_; }
+
+private:
+    // One read of the recording onto the stretcher; the end of it ends
+    // the stretcher's input
+    bool Fill(std::string* error);
+    // |frames| at the track's rate onto the stretcher, through the
+    // resamplers when its rate is not the output's
+    void PushAtRate(const float* interleaved, size_t frames, int sample_rate);
+
+    // Where a run of contiguous input started, for PositionMs()
+    struct Run {
+        int64_t frame = 0;  // stretcher input frame
+        double ms = 0.0;    // recording time
+    };
+
+    const int rate_;
+    int channels_ = 1;
+    RecordingReader reader_;
+    std::unique_ptr<TimeStretcher> stretcher_;
+    bool skip_silence_ = false;
+    double read_ms_ = 0.0;
+    double next_ms_ = -1.0;  // where the last read ended; -1 after a seek
+    int64_t pushed_ = 0;     // stretcher input frames since the seek
+    std::deque<Run> runs_;
+
+    int resampler_rate_ = 0;
+    std::vector<std::unique_ptr<webrtc::PushSincResampler>> resamplers_;  // per channel
+    std::vector<float> block_;      // 10ms at the track's rate, interleaved
+    size_t fill_ = 0;               // frames in block_
+    std::vector<float> planar_;
+    std::vector<float> resampled_;  // one channel's 10ms at the output rate
+    std::vector<float> converted_;  // interleaved, at the track's rate
+    std::vector<float> output_;     // interleaved, at the output rate
+};
+
+} // namespace kakarot
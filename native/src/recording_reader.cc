@@ -0,0 +1,390 @@
+#include "recording_reader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kakarot {
+
+using recording_index::GetLe;
+
+// The most an encrypted read decrypts at once
+static constexpr uint64_t kMaxDecryptBytes = 1 << 20;
+
+#if defined(_WIN32)
+static std::wstring Wide(const std::string& text) {
+    int size = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, nullptr, 0);
+    if (size <= 1) {
+        return std::wstring();
+    }
+    std::wstring result(size - 1, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, &result[0], size);
+    return result;
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+}
+
+bool MappedFile::Open(const std::string& path, std::string* error) {
+    // Shared for writing too: the recorder may still be appending
+    HANDLE file = CreateFileW(Wide(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        *error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        *error = "cannot stat " + path;
+        return false;
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ > 0) {
+        mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_) {
+            data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+    CloseHandle(file);
+    if (size_ > 0 && !data_) {
+        size_ = 0;
+        *error = "cannot map " + path;
+        return false;
+    }
+    return true;
+}
+#else
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+bool MappedFile::Open(const std::string& path, std::string* error) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        *error = "cannot open " + path;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        *error = "cannot stat " + path;
+        return false;
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            size_ = 0;
+            *error = "cannot map " + path;
+            return false;
+        }
+        data_ = static_cast<const uint8_t*>(data);
+    }
+    close(fd);
+    return true;
+}
+#endif
+
+void DownmixRange(const RecordingRange& range, size_t frames, float* out) {
+    if (range.silent) {
+        std::fill(out, out + frames, 0.0f);
+        return;
+    }
+    const size_t width = static_cast<size_t>(range.channels);
+    const float scale = (range.float32 ? 1.0f : 1.0f / 32768.0f) / static_cast<float>(width);
+    const float* floats = reinterpret_cast<const float*>(range.data);
+    const int16_t* pcm = reinterpret_cast<const int16_t*>(range.data);
+    for (size_t i = 0; i < frames; ++i) {
+        float sum = 0.0f;
+        for (size_t c = 0; c < width; ++c) {
+            sum += range.float32 ? floats[i * width + c] : pcm[i * width + c];
+        }
+        out[i] = sum * scale;
+    }
+}
+
+bool RecordingReader::Open(const std::string& index_path, std::string* error) {
+    static const char kSuffix[] = ".idx";
+    const size_t suffix = sizeof(kSuffix) - 1;
+    if (index_path.size() <= suffix || index_path.compare(index_path.size() - suffix, suffix, kSuffix) != 0) {
+        *error = "not a recording index: " + index_path;
+        return false;
+    }
+    if (!index_.Open(index_path, error)) {
+        return false;
+    }
+    if (!recording_index::DecodeHeader(index_.Data(), index_.Size(), &header_)) {
+        *error = "not a recording index: " + index_path;
+        return false;
+    }
+    if (header_.flags & kRecordingIndexEncrypted) {
+        cipher_ = RecordingCipher();
+        if (!cipher_) {
+            *error = "recording is encrypted and no key is set: " + index_path;
+            return false;
+        }
+    }
+    base_ = index_path.substr(0, index_path.size() - suffix);
+    // A crash can leave a torn last entry; it is not counted
+    entry_count_ = (index_.Size() - kRecordingIndexHeaderSize) / kRecordingIndexEntrySize;
+    return true;
+}
+
+RecordingIndexEntry RecordingReader::Entry(size_t i) const {
+    return recording_index::DecodeEntry(index_.Data() + kRecordingIndexHeaderSize + i * kRecordingIndexEntrySize);
+}
+
+double RecordingReader::SilenceEndMs(size_t i) const {
+    return i + 1 < entry_count_ ? Entry(i + 1).time_ms : Entry(i).time_ms;
+}
+
+size_t RecordingReader::Find(double time_ms) const {
+    size_t low = 0;
+    size_t high = entry_count_;
+    while (high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        if (Entry(mid).time_ms <= time_ms) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+const RecordingReader::Wav* RecordingReader::File(uint32_t number, std::string* error) {
+    if (number < files_.size() && files_[number]) {
+        return files_[number].get();
+    }
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), ".%03u.wav", number);
+    const std::string path = base_ + suffix;
+    auto wav = std::make_unique<Wav>();
+    wav->map = std::make_shared<MappedFile>();
+    if (!wav->map->Open(path, error)) {
+        return nullptr;
+    }
+
+    // The recorder's files: 16-bit PCM or 32-bit float, mono but for a stereo mix. A data size
+    // that was never patched (a crash) reads to the end of the file.
+    const uint8_t* data = wav->map->Data();
+    const size_t size = wav->map->Size();
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        *error = "not a WAV file: " + path;
+        return nullptr;
+    }
+    int format = 0;
+    int channels = 0;
+    int bits = 0;
+    for (size_t offset = 12; offset + 8 <= size;) {
+        const uint8_t* chunk = data + offset;
+        uint64_t chunk_size = GetLe(chunk + 4, 4);
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16 && offset + 24 <= size) {
+            format = static_cast<int>(GetLe(chunk + 8, 2));
+            channels = static_cast<int>(GetLe(chunk + 10, 2));
+            wav->sample_rate = static_cast<int>(GetLe(chunk + 12, 4));
+            bits = static_cast<int>(GetLe(chunk + 22, 2));
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            uint64_t available = size - offset - 8;
+            uint64_t bytes = chunk_size > 0 ? std::min(chunk_size, available) : available;
+            wav->samples = chunk + 8;
+            wav->bytes = bytes;
+            break;
+        }
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+    wav->float32 = format == 3 && bits == 32;
+    wav->channels = channels;
+    if (!wav->samples || channels < 1 || wav->sample_rate <= 0 || !(wav->float32 || (format == 1 && bits == 16))) {
+        *error = "not a recorder WAV: " + path;
+        return nullptr;
+    }
+    wav->path = path;
+    if (cipher_ && !OpenTags(wav.get(), wav->bytes, error)) {
+        return nullptr;
+    }
+    wav->count = wav->bytes / (bits / 8 * channels);
+
+    if (files_.size() <= number) {
+        files_.resize(number + 1);
+    }
+    files_[number] = std::move(wav);
+    return files_[number].get();
+}
+
+bool RecordingReader::OpenTags(Wav* wav, uint64_t data_bytes, std::string* error) const {
+    const std::string path = wav->path + ".tag";
+    wav->tags = std::make_shared<MappedFile>();
+    if (!wav->tags->Open(path, error)) {
+        return false;
+    }
+    if (!CheckRecordingTagHeader(*cipher_, wav->tags->Data(), wav->tags->Size(), wav->iv_prefix,
+                                 &wav->block_bytes)) {
+        *error = "recording key does not match " + path;
+        return false;
+    }
+    // The tags reach disk ahead of the blocks' length; a torn last tag is not counted
+    const uint64_t blocks = (wav->tags->Size() - kRecordingTagHeaderSize) / kAesGcmTagSize;
+    wav->bytes = std::min(data_bytes, blocks * wav->block_bytes);
+    return true;
+}
+
+bool RecordingReader::Decrypt(const Wav& wav, uint64_t sample, uint64_t count, RecordingRange* range,
+                              std::string* error) const {
+    const size_t frame_bytes = (wav.float32 ? 4 : 2) * static_cast<size_t>(wav.channels);
+    const uint64_t begin = sample * frame_bytes;
+    const uint64_t end = (sample + count) * frame_bytes;
+    const uint64_t first = begin / wav.block_bytes;
+    const uint64_t last = (end - 1) / wav.block_bytes;
+    const uint64_t from = first * wav.block_bytes;
+    const uint64_t to = std::min(wav.bytes, (last + 1) * wav.block_bytes);
+    auto plain = std::make_shared<std::vector<uint8_t>>(wav.samples + from, wav.samples + to);
+    for (uint64_t block = first; block <= last; ++block) {
+        const uint64_t offset = (block - first) * wav.block_bytes;
+        const size_t bytes = static_cast<size_t>(std::min<uint64_t>(wav.block_bytes, plain->size() - offset));
+        uint8_t iv[kAesGcmIvSize];
+        RecordingBlockIv(wav.iv_prefix, static_cast<uint32_t>(block), iv);
+        const uint8_t* tag = wav.tags->Data() + kRecordingTagHeaderSize + block * kAesGcmTagSize;
+        if (!cipher_->Open(iv, nullptr, 0, plain->data() + offset, bytes, tag)) {
+            *error = "block " + std::to_string(block) + " of " + wav.path + " fails authentication";
+            return false;
+        }
+    }
+    range->data = plain->data() + (begin - from);
+    range->owner = std::move(plain);
+    return true;
+}
+
+double RecordingReader::DurationMs() {
+    if (entry_count_ == 0) {
+        return 0.0;
+    }
+    RecordingIndexEntry last = Entry(entry_count_ - 1);
+    std::string error;
+    const Wav* wav = File(last.file, &error);
+    if (!wav || wav->count < last.sample) {
+        return last.time_ms;
+    }
+    return last.time_ms + (wav->count - last.sample) * 1000.0 / wav->sample_rate;
+}
+
+bool RecordingReader::Read(double start_ms, double duration_ms, RecordingRange* range, std::string* error,
+                           SilenceMode silence) {
+    *range = RecordingRange();
+    if (entry_count_ == 0 || duration_ms <= 0.0) {
+        return true;
+    }
+    start_ms = std::max(start_ms, 0.0);
+    for (size_t i = Find(start_ms); i < entry_count_; ++i) {
+        const RecordingIndexEntry entry = Entry(i);
+        const Wav* wav = File(entry.file, error);
+        if (!wav) {
+            return false;
+        }
+        if (entry.silence) {
+            const double from = std::max(start_ms, static_cast<double>(entry.time_ms));
+            const double end_ms = SilenceEndMs(i);
+            if (silence == SilenceMode::kSkip || from >= end_ms) {
+                continue;
+            }
+            // The WAV's format, so callers need not special-case the range
+            range->silent = true;
+            range->samples = static_cast<size_t>(std::ceil(std::min(duration_ms, end_ms - from) * wav->sample_rate / 1000.0));
+            range->sample_rate = wav->sample_rate;
+            range->channels = wav->channels;
+            range->float32 = wav->float32;
+            range->start_ms = from;
+            return true;
+        }
+        // Audio runs on from the entry until the next one in the same WAV
+        // (the gap to a later entry is audio the recorder never got)
+        uint64_t end = wav->count;
+        if (i + 1 < entry_count_) {
+            RecordingIndexEntry next = Entry(i + 1);
+            if (next.file == entry.file) {
+                end = std::min(end, next.sample);
+            }
+        }
+        double offset_ms = std::max(0.0, start_ms - entry.time_ms);
+        uint64_t sample = entry.sample + static_cast<uint64_t>(std::floor(offset_ms * wav->sample_rate / 1000.0));
+        if (sample >= end) {
+            continue;
+        }
+        // Contiguous samples to the end of the WAV, across later entries up
+        // to a silence marker
+        uint64_t wanted = static_cast<uint64_t>(std::ceil(duration_ms * wav->sample_rate / 1000.0));
+        uint64_t stop = wav->count;
+        for (size_t j = i + 1; j < entry_count_; ++j) {
+            const RecordingIndexEntry later = Entry(j);
+            if (later.file != entry.file || later.sample >= sample + wanted) {
+                break;
+            }
+            if (later.silence) {
+                stop = later.sample;
+                break;
+            }
+        }
+        uint64_t count = std::min(wanted, stop - sample);
+        const size_t frame_bytes = (wav->float32 ? 4 : 2) * static_cast<size_t>(wav->channels);
+        if (cipher_) {
+            count = std::min<uint64_t>(count, std::max<uint64_t>(1, kMaxDecryptBytes / frame_bytes));
+            if (!Decrypt(*wav, sample, count, range, error)) {
+                return false;
+            }
+        } else {
+            range->owner = wav->map;
+            range->data = wav->samples + sample * frame_bytes;
+        }
+        range->samples = static_cast<size_t>(count);
+        range->bytes = range->samples * frame_bytes;
+        range->sample_rate = wav->sample_rate;
+        range->channels = wav->channels;
+        range->float32 = wav->float32;
+        range->start_ms = entry.time_ms + (sample - entry.sample) * 1000.0 / wav->sample_rate;
+        return true;
+    }
+    return true;
+}
+
+double RecordingReader::Silences(double start_ms, double end_ms, std::vector<SilenceRun>* runs) const {
+    double total = 0.0;
+    if (!CompactsSilence() || entry_count_ == 0) {
+        return total;
+    }
+    for (size_t i = Find(start_ms); i < entry_count_; ++i) {
+        const RecordingIndexEntry entry = Entry(i);
+        if (entry.time_ms >= end_ms) {
+            break;
+        }
+        const double run_end = SilenceEndMs(i);
+        if (!entry.silence || run_end <= start_ms) {
+            continue;
+        }
+        SilenceRun run;
+        run.start_ms = entry.time_ms;
+        run.duration_ms = run_end - entry.time_ms;
+        total += std::min(run_end, end_ms) - std::max(run.start_ms, start_ms);
+        runs->push_back(run);
+    }
+    return total;
+}
+
+} // namespace kakarot
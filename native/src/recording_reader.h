@@ -0,0 +1,148 @@
+#pragma once
+
+#include "recording_crypto.h"
+#include "recording_index.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// A read-only memory map of a whole file; empty files map to nothing
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path, std::string* error);
+
+    const uint8_t* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    void* mapping_ = nullptr;
+#endif
+};
+
+// Samples served straight out of a mapping, or out of a decrypted copy of
+// their blocks for an encrypted recording; |owner| keeps either alive
+struct RecordingRange {
+    bool silent = false;    // compacted silence: |samples| zero frames, no data
+    std::shared_ptr<const void> owner;
+    const uint8_t* data = nullptr;
+    size_t bytes = 0;
+    size_t samples = 0;     // frames; |channels| interleaved samples each
+    int sample_rate = 0;
+    int channels = 1;
+    bool float32 = false;   // else 16-bit PCM
+    double start_ms = 0.0;  // recording time of the first sample
+};
+
+// The first |frames| of |range| as mono floats, channels averaged; zeros
+// for a silent range
+void DownmixRange(const RecordingRange& range, size_t frames, float* out);
+
+// A run of silence the recorder left out of the WAVs, in recording time
+struct SilenceRun {
+    double start_ms = 0.0;
+    double duration_ms = 0.0;
+};
+
+// How Read() treats compacted silence
+enum class SilenceMode {
+    kSkip,  // on to the audio after it, as across any gap ("skip silence")
+    kFill,  // a silent range of its length, so the timeline plays as recorded
+};
+
+// One track of a recording, opened from its seek index. Opening maps the
+// index only, whatever the meeting's length; a WAV is mapped the first time
+// a read lands in it and its header is the only part touched until then.
+// Seeks are a binary search of the index, so reads cost their own length.
+// An encrypted recording opens with the process's recording key and a read
+// decrypts and authenticates only the blocks under its range. One thread
+// at a time.
+class RecordingReader {
+public:
+    // |index_path| is <name>.<track>.idx as the recorder wrote it. False
+    // for an encrypted recording while no key is set.
+    bool Open(const std::string& index_path, std::string* error);
+
+    uint64_t StartedAtMs() const { return header_.started_at_ms; }
+    uint32_t IntervalMs() const { return header_.interval_ms; }
+    // The recorder's loudness reading; false for an index from before it
+    bool Loudness(double* integrated_lufs, double* peak_dbfs) const {
+        if (!(header_.flags & kRecordingIndexLoudness)) {
+            return false;
+        }
+        *integrated_lufs = header_.loudness_lufs;
+        *peak_dbfs = header_.peak_dbfs;
+        return true;
+    }
+    size_t EntryCount() const { return entry_count_; }
+    // The recorder compacted long silences; older indexes never have
+    bool CompactsSilence() const { return (header_.flags & kRecordingIndexSilence) != 0; }
+    bool Encrypted() const { return (header_.flags & kRecordingIndexEncrypted) != 0; }
+    // <name>.<track>, which the track's other files share
+    const std::string& Base() const { return base_; }
+
+    // Recording time just past the last sample; maps the last WAV
+    double DurationMs();
+
+    // Up to |duration_ms| of samples from the one at |start_ms| (or the
+    // first after it, across a gap). A range stops at the end of a WAV and
+    // at compacted silence, which kFill returns as a silent range, and
+    // after a MiB of an encrypted recording; the caller reads again from
+    // range->start_ms plus what it got. An empty range at the end of the
+    // recording; false for a block that fails authentication.
+    bool Read(double start_ms, double duration_ms, RecordingRange* range, std::string* error,
+              SilenceMode silence = SilenceMode::kSkip);
+
+    // Compacted silence overlapping [start_ms, end_ms), in order, into
+    // |runs|; returns their total length within the span
+    double Silences(double start_ms, double end_ms, std::vector<SilenceRun>* runs) const;
+
+private:
+    struct Wav {
+        std::shared_ptr<MappedFile> map;
+        const uint8_t* samples = nullptr;
+        uint64_t count = 0;  // frames
+        int sample_rate = 0;
+        int channels = 1;
+        bool float32 = false;
+        // Encrypted
+        std::string path;
+        std::shared_ptr<MappedFile> tags;
+        uint8_t iv_prefix[kRecordingIvPrefixSize] = {};
+        uint32_t block_bytes = 0;
+        uint64_t bytes = 0;  // of sealed data, the last block perhaps short
+    };
+
+    RecordingIndexEntry Entry(size_t i) const;
+    // Where entry |i|'s run of silence ends; a run the recorder never
+    // closed (a crash) ends at its marker
+    double SilenceEndMs(size_t i) const;
+    // The last entry at or before |time_ms|, or 0
+    size_t Find(double time_ms) const;
+    const Wav* File(uint32_t number, std::string* error);
+    // Opens the WAV's tags and limits it to the blocks they cover
+    bool OpenTags(Wav* wav, uint64_t data_bytes, std::string* error) const;
+    // |range| over frames [sample, sample + count) of |wav|, decrypted
+    bool Decrypt(const Wav& wav, uint64_t sample, uint64_t count, RecordingRange* range, std::string* error) const;
+
+    std::string base_;  // the index path without .idx
+    MappedFile index_;
+    RecordingIndexHeader header_;
+    size_t entry_count_ = 0;
+    std::vector<std::unique_ptr<Wav>> files_;
+    std::shared_ptr<const AesGcm> cipher_;  // for an encrypted recording
+};
+
+} // namespace kakarot
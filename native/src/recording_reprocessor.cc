@@ -0,0 +1,144 @@
+#include "recording_reprocessor.h"
+#include "native_log.h"
+#include "recording_frames.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace kakarot {
+
+static const char* const kLogSource = "RecordingReprocessor";
+
+// Progress is reported in steps of at least this much
+static constexpr double kProgressStep = 0.01;
+
+namespace {
+
+// Everything but the rename; the output is open as |out|
+bool Run(const ReprocessJob& job, FILE* out, const ReprocessProgressFn& progress, const std::atomic<bool>& cancel,
+         ReprocessResult* result) {
+    const int rate = job.sample_rate;
+    const size_t frame = static_cast<size_t>(rate / 100);
+    TrackFrames mic(rate);
+    TrackFrames system(rate);
+    const bool has_system = !job.system.empty();
+    if (!mic.Open(job.microphone, &result->error) || (has_system && !system.Open(job.system, &result->error))) {
+        return false;
+    }
+    result->audio_ms = mic.DurationMs();
+    const uint64_t total = static_cast<uint64_t>(std::ceil(result->audio_ms / 10.0)) * frame;
+
+    AECProcessor aec(job.config);
+    if (!aec.Initialize(rate, 1, 1)) {
+        result->error = "cannot set up the AEC at " + std::to_string(rate) + "Hz";
+        return false;
+    }
+    // Output runs this far behind input: skip it at the start, flush it at the end
+    uint64_t skip = aec.OutputLatencySamples();
+
+    FlacFileWriter writer(out, rate, total);
+    std::vector<float> capture(frame);
+    std::vector<float> render(frame);
+    std::vector<float> processed(frame);
+    uint64_t written = 0;
+    uint64_t read = 0;
+    double reported = 0.0;
+    while (written < total) {
+        if (read < total) {
+            if (!mic.Next(capture.data(), cancel, &result->error) ||
+                (has_system && !system.Next(render.data(), cancel, &result->error))) {
+                return false;
+            }
+        } else {
+            std::fill(capture.begin(), capture.end(), 0.0f);
+            std::fill(render.begin(), render.end(), 0.0f);
+        }
+        read += frame;
+        if (has_system) {
+            aec.ProcessRenderAudio(render.data(), frame, 1);
+        }
+        aec.ProcessCaptureAudio(capture.data(), processed.data(), frame);
+
+        const size_t skipped = static_cast<size_t>(std::min<uint64_t>(skip, frame));
+        skip -= skipped;
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(frame - skipped, total - written));
+        writer.Write(processed.data() + skipped, count);
+        written += count;
+
+        const double fraction = static_cast<double>(written) / total;
+        if (fraction - reported >= kProgressStep) {
+            if (cancel.load(std::memory_order_relaxed)) {
+                result->error = "cancelled";
+                return false;
+            }
+            reported = fraction;
+            if (progress) {
+                progress(fraction);
+            }
+        }
+    }
+    if (!writer.Finish()) {
+        result->error = "cannot write " + job.output;
+        return false;
+    }
+    result->output_bytes = writer.Bytes();
+    result->metrics = aec.GetMetrics();
+    return true;
+}
+
+} // namespace
+
+ReprocessResult ReprocessRecording(const ReprocessJob& job, const ReprocessProgressFn& progress,
+                                   const std::atomic<bool>& cancel) {
+    ReprocessResult result;
+    const auto start = std::chrono::steady_clock::now();
+    const std::string part = job.output + ".part";
+    FILE* out = std::fopen(part.c_str(), "wb");
+    if (!out) {
+        result.error = "cannot create " + part;
+        return result;
+    }
+    bool ok = Run(job, out, progress, cancel, &result);
+    ok = std::fclose(out) == 0 && ok;
+    if (ok) {
+        std::remove(job.output.c_str());  // rename() will not replace on Windows
+        ok = std::rename(part.c_str(), job.output.c_str()) == 0;
+        if (!ok) {
+            result.error = "cannot rename " + part;
+        }
+    }
+    if (!ok) {
+        std::remove(part.c_str());
+        return result;
+    }
+    if (progress) {
+        progress(1.0);
+    }
+    result.ok = true;
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void SubmitReprocess(TaskScheduler* scheduler, ReprocessJob job, std::shared_ptr<std::atomic<bool>> cancel,
+                     ReprocessProgressFn progress, ReprocessDoneFn done) {
+    scheduler->Post(TaskPriority::kBackground, [job = std::move(job), cancel = std::move(cancel),
+                                                progress = std::move(progress),
+                                                done = std::move(done)](const std::atomic<bool>& stopping) {
+        if (stopping.load(std::memory_order_relaxed)) {
+            cancel->store(true, std::memory_order_relaxed);
+        }
+        ReprocessResult result = ReprocessRecording(job, progress, *cancel);
+        if (result.ok) {
+            Log(LogLevel::kInfo, kLogSource, "%s: %.0fs of audio in %.0fms (%.0fx real time)",
+                job.output.c_str(), result.audio_ms / 1000.0, result.elapsed_ms,
+                result.audio_ms / std::max(result.elapsed_ms, 1.0));
+        } else {
+            Log(LogLevel::kWarn, kLogSource, "%s: %s", job.microphone.c_str(), result.error.c_str());
+        }
+        done(result);
+    });
+}
+
+} // namespace kakarot
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include "aec_processor.h"
+#include "task_scheduler.h"
+
+namespace kakarot {
+
+// One meeting to run through the capture chain again, e.g. after the AEC or
+// NS presets changed
+struct ReprocessJob {
+    std::string microphone;    // seek index of the raw mic track
+    std::string system;        // of the system track, the far-end reference; empty for none
+    std::string output;        // 16-bit mono FLAC of the processed mic
+    AECConfig config;
+    int sample_rate = 16000;   // both tracks are resampled to this and it is the output's
+};
+
+struct ReprocessResult {
+    bool ok = false;
+    std::string error;
+    uint64_t output_bytes = 0;
+    double audio_ms = 0.0;
+    double elapsed_ms = 0.0;
+    AECMetrics metrics;        // of the AECProcessor at the end of the run
+};
+
+// Both run on the worker thread doing the job
+using ReprocessProgressFn = std::function<void(double fraction)>;
+using ReprocessDoneFn = std::function<void(const ReprocessResult& result)>;
+
+// Runs |job| on the calling thread through an AECProcessor of its own: the
+// system track goes in as render and the mic as capture, 10ms at a time in
+// recording time, so the pair lines up as it did live. Gaps in either
+// track are silence. Output goes to <output>.part and is renamed once
+// complete. Polls |cancel| between reads.
+ReprocessResult ReprocessRecording(const ReprocessJob& job, const ReprocessProgressFn& progress,
+                                   const std::atomic<bool>& cancel);
+
+// Reprocesses |job| as a background task on |scheduler|, whose workers
+// steal from each other's deques: meetings vary from minutes to hours, so a
+// worker that drew short ones helps with the rest rather than idling. |done|
+// is always called, exactly once; setting |cancel| fails the job if it has
+// not finished, and the scheduler's teardown sets it for a job still queued.
+void SubmitReprocess(TaskScheduler* scheduler, ReprocessJob job, std::shared_ptr<std::atomic<bool>> cancel,
+                     ReprocessProgressFn progress, ReprocessDoneFn done);
+
+} // namespace kakarot
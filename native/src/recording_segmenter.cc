@@ -0,0 +1,357 @@
+#include "recording_segmenter.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "flac_encoder.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "recording_reader.h"
+#include "task_scheduler.h"
+#include "thread_cpu.h"
+#include "voice_activity.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace kakarot {
+
+static const char* const kLogSource = "RecordingSegmenter";
+
+// VAD frames, and the grid cuts are placed on
+static constexpr double kFrameMs = 10.0;
+
+// Longest read from the recording at once
+static constexpr double kReadMs = 10000.0;
+
+// Segments with less speech than this are not worth a request
+static constexpr double kMinSegmentSpeechMs = 500.0;
+
+// Default workers: half the cores, up to this many
+static constexpr size_t kMaxDefaultThreads = 8;
+
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Calls |fn(data, count, sample_rate, start_ms)| with [start_ms, end_ms) of
+// the track as float, a stretch at a time; across a gap |start_ms| jumps
+template <typename Fn>
+bool ForEachRange(RecordingReader* reader, double start_ms, double end_ms, const std::atomic<bool>& cancel,
+                  std::vector<float>* scratch, std::string* error, Fn fn) {
+    double at = start_ms;
+    while (at < end_ms) {
+        TaskScheduler::YieldForAudio(cancel);
+        if (cancel.load(std::memory_order_relaxed)) {
+            *error = "cancelled";
+            return false;
+        }
+        RecordingRange range;
+        if (!reader->Read(at, std::min(kReadMs, end_ms - at), &range, error)) {
+            return false;
+        }
+        if (range.samples == 0 || range.start_ms >= end_ms) {
+            break;
+        }
+        const size_t count = std::min(range.samples, static_cast<size_t>(std::ceil(
+            (end_ms - range.start_ms) * range.sample_rate / 1000.0)));
+        scratch->resize(count);
+        DownmixRange(range, count, scratch->data());
+        fn(scratch->data(), count, range.sample_rate, range.start_ms);
+        at = range.start_ms + count * 1000.0 / range.sample_rate;
+    }
+    return true;
+}
+
+// Runs |fn(worker)| on |threads| threads and waits for them; they give way
+// to audio as the task that spawned them would
+template <typename Fn>
+void RunWorkers(size_t threads, Fn fn) {
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&fn, i] {
+            ScopedThreadCpu thread_cpu("recordingSegmenter");
+            SetCurrentThreadPriority(ThreadPriority::kUtility);
+            TaskScheduler::BackgroundScope background;
+            fn(i);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Speech probability of [first, last) frames of the track into |probabilities|
+bool DetectSpeech(RecordingReader* reader, size_t first, size_t last, const std::atomic<bool>& cancel,
+                  std::vector<float>* probabilities, std::string* error) {
+    std::unique_ptr<VoiceActivityDetector> vad;
+    int vad_rate = 0;
+    std::vector<float> scratch;
+    return ForEachRange(reader, first * kFrameMs, last * kFrameMs, cancel, &scratch, error,
+                        [&](const float* data, size_t count, int sample_rate, double start_ms) {
+        // A device switch mid-recording changes the rate
+        if (!vad || vad_rate != sample_rate) {
+            vad = std::make_unique<VoiceActivityDetector>(sample_rate);
+            vad_rate = sample_rate;
+        }
+        const size_t frame = vad->FrameSize();
+        const size_t at = static_cast<size_t>(start_ms / kFrameMs);
+        for (size_t i = 0; i + frame <= count; i += frame) {
+            const size_t index = at + i / frame;
+            if (index >= first && index < last) {
+                (*probabilities)[index] = vad->AnalyzeFrame(data + i);
+            }
+        }
+    });
+}
+
+// Frame to cut at for each of |count| - 1 boundaries: the middle of the
+// pause nearest the even split, or the least speechy frame near it
+std::vector<size_t> PlaceCuts(const std::vector<float>& probabilities, size_t count, const SegmentationJob& job) {
+    const size_t frames = probabilities.size();
+    const size_t shift = static_cast<size_t>(job.max_shift_ms / kFrameMs);
+    const size_t min_silence = std::max<size_t>(1, static_cast<size_t>(job.min_silence_ms / kFrameMs));
+    std::vector<size_t> cuts;
+    for (size_t k = 1; k < count; ++k) {
+        const size_t ideal = frames * k / count;
+        const size_t low = ideal > shift ? ideal - shift : 0;
+        const size_t high = std::min(frames, ideal + shift);
+
+        size_t best = ideal;
+        size_t best_distance = SIZE_MAX;
+        size_t quietest = ideal;
+        size_t run_start = low;
+        for (size_t i = low; i <= high; ++i) {
+            const bool silent = i < high && probabilities[i] < job.threshold;
+            if (i < high && probabilities[i] < probabilities[quietest]) {
+                quietest = i;
+            }
+            if (silent) {
+                continue;
+            }
+            if (i - run_start >= min_silence) {
+                const size_t middle = run_start + (i - run_start) / 2;
+                const size_t distance = middle > ideal ? middle - ideal : ideal - middle;
+                if (distance < best_distance) {
+                    best = middle;
+                    best_distance = distance;
+                }
+            }
+            run_start = i + 1;
+        }
+        best = best_distance == SIZE_MAX ? quietest : best;
+        if (cuts.empty() || best > cuts.back()) {
+            cuts.push_back(best);
+        }
+    }
+    return cuts;
+}
+
+// Reads, resamples and encodes one segment; false with |error| set
+bool EncodeSegment(RecordingReader* reader, const SegmentationJob& job, RecordingSegment* segment,
+                   const std::atomic<bool>& cancel, std::string* error) {
+    const int rate = job.sample_rate;
+    std::vector<int32_t> pcm;
+    pcm.reserve(static_cast<size_t>((segment->end_ms - segment->start_ms) * rate / 1000.0) + rate / 100);
+    std::unique_ptr<webrtc::PushSincResampler> resampler;
+    int resampler_rate = 0;
+    std::vector<float> block;
+    std::vector<float> resampled(static_cast<size_t>(rate / 100));
+    size_t fill = 0;
+    auto append = [&pcm](const float* data, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            pcm.push_back(static_cast<int32_t>(std::lrint(std::clamp(data[i], -1.0f, 1.0f) * 32767.0f)));
+        }
+    };
+
+    std::vector<float> scratch;
+    bool rate_ok = true;
+    bool ok = ForEachRange(reader, segment->start_ms, segment->end_ms, cancel, &scratch, error,
+                           [&](const float* data, size_t count, int sample_rate, double start_ms) {
+        // Audio the recorder never got is silence here, so times line up
+        const size_t due = static_cast<size_t>(std::max(0.0, start_ms - segment->start_ms) * rate / 1000.0);
+        if (due > pcm.size()) {
+            pcm.resize(due, 0);
+        }
+        if (sample_rate == rate) {
+            append(data, count);
+            return;
+        }
+        if (sample_rate % 100 != 0) {
+            rate_ok = false;
+            return;
+        }
+        if (!resampler || resampler_rate != sample_rate) {
+            resampler = std::make_unique<webrtc::PushSincResampler>(sample_rate / 100, resampled.size());
+            resampler_rate = sample_rate;
+            block.assign(static_cast<size_t>(sample_rate / 100), 0.0f);
+            fill = 0;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            block[fill++] = data[i];
+            if (fill == block.size()) {
+                resampler->Resample(block.data(), block.size(), resampled.data(), resampled.size());
+                append(resampled.data(), resampled.size());
+                fill = 0;
+            }
+        }
+    });
+    if (!ok) {
+        return false;
+    }
+    if (!rate_ok) {
+        *error = "recording rate is not a multiple of 100Hz";
+        return false;
+    }
+
+    FlacEncoder encoder(rate, 1, 16, pcm.size());
+    std::vector<uint8_t> encoded;
+    encoder.WriteHeader(&encoded);
+    for (size_t at = 0; at < pcm.size(); at += FlacEncoder::kBlockSize) {
+        encoder.EncodeBlock(pcm.data() + at, std::min(FlacEncoder::kBlockSize, pcm.size() - at), &encoded);
+    }
+
+    const std::string part = segment->path + ".part";
+    FILE* out = std::fopen(part.c_str(), "wb");
+    if (!out) {
+        *error = "cannot create " + part;
+        return false;
+    }
+    ok = std::fwrite(encoded.data(), 1, encoded.size(), out) == encoded.size();
+    ok = std::fclose(out) == 0 && ok;
+    if (ok) {
+        std::remove(segment->path.c_str());  // rename() will not replace on Windows
+        ok = std::rename(part.c_str(), segment->path.c_str()) == 0;
+    }
+    if (!ok) {
+        std::remove(part.c_str());
+        *error = "cannot write " + segment->path;
+        return false;
+    }
+    segment->bytes = encoded.size();
+    return true;
+}
+
+SegmentationResult Segment(const SegmentationJob& job, const SegmentReadyFn& ready, const std::atomic<bool>& cancel) {
+    SegmentationResult result;
+    const auto start = std::chrono::steady_clock::now();
+
+    RecordingReader reader;
+    if (!reader.Open(job.index, &result.error)) {
+        return result;
+    }
+    result.audio_ms = reader.DurationMs();
+    const size_t frames = static_cast<size_t>(std::ceil(result.audio_ms / kFrameMs));
+    if (frames == 0) {
+        result.ok = true;
+        return result;
+    }
+    size_t threads = job.threads;
+    if (threads == 0) {
+        threads = std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, kMaxDefaultThreads);
+    }
+
+    // Each worker its own reader and VAD over an equal span; a span's first
+    // frames are read cold, which costs nothing a cut would notice
+    std::vector<float> probabilities(frames, 0.0f);
+    std::mutex error_mutex;
+    const size_t vad_threads = std::min(threads, frames);
+    RunWorkers(vad_threads, [&](size_t worker) {
+        RecordingReader span_reader;
+        std::string error;
+        const size_t first = frames * worker / vad_threads;
+        const size_t last = frames * (worker + 1) / vad_threads;
+        if (!span_reader.Open(job.index, &error) ||
+            !DetectSpeech(&span_reader, first, last, cancel, &probabilities, &error)) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (result.error.empty()) {
+                result.error = error;
+            }
+        }
+    });
+    if (!result.error.empty()) {
+        return result;
+    }
+    result.vad_ms = MillisecondsSince(start);
+
+    // Balanced: the count that comes closest to target_ms, cuts moved into pauses
+    const size_t count = std::max<size_t>(1, static_cast<size_t>(std::lround(result.audio_ms / job.target_ms)));
+    std::vector<size_t> cuts = PlaceCuts(probabilities, count, job);
+    cuts.push_back(frames);
+    size_t from = 0;
+    for (size_t cut : cuts) {
+        size_t speech = 0;
+        for (size_t i = from; i < cut; ++i) {
+            speech += probabilities[i] >= job.threshold ? 1 : 0;
+        }
+        if (speech * kFrameMs >= kMinSegmentSpeechMs) {
+            RecordingSegment segment;
+            segment.index = result.segments.size();
+            segment.path = job.output_dir + "/" + job.name + "." + std::to_string(segment.index) + ".flac";
+            segment.start_ms = from * kFrameMs;
+            segment.end_ms = std::min(cut * kFrameMs, result.audio_ms);
+            segment.speech_ms = speech * kFrameMs;
+            result.speech_ms += segment.speech_ms;
+            result.segments.push_back(std::move(segment));
+        }
+        from = cut;
+    }
+
+    const auto encode_start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next{0};
+    const size_t encode_threads = std::min(threads, std::max<size_t>(result.segments.size(), 1));
+    RunWorkers(encode_threads, [&](size_t) {
+        RecordingReader segment_reader;
+        std::string error;
+        if (!segment_reader.Open(job.index, &error)) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            result.error = error;
+            return;
+        }
+        for (size_t i = next++; i < result.segments.size(); i = next++) {
+            if (!EncodeSegment(&segment_reader, job, &result.segments[i], cancel, &error)) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (result.error.empty()) {
+                    result.error = error;
+                }
+                next.store(result.segments.size());  // the others stop after their current one
+                return;
+            }
+            if (ready) {
+                ready(result.segments[i]);
+            }
+        }
+    });
+    if (!result.error.empty()) {
+        for (const RecordingSegment& segment : result.segments) {
+            std::remove(segment.path.c_str());
+        }
+        result.segments.clear();
+        return result;
+    }
+    result.encode_ms = MillisecondsSince(encode_start);
+    result.elapsed_ms = MillisecondsSince(start);
+    result.ok = true;
+    return result;
+}
+
+} // namespace
+
+SegmentationResult SegmentRecording(const SegmentationJob& job, const SegmentReadyFn& ready,
+                                    const std::atomic<bool>& cancel) {
+    SegmentationResult result = Segment(job, ready, cancel);
+    if (result.ok) {
+        Log(LogLevel::kInfo, kLogSource, "%s: %.0fs into %zu segments (%.0fs speech) in %.0fms",
+            job.index.c_str(), result.audio_ms / 1000.0, result.segments.size(), result.speech_ms / 1000.0,
+            result.elapsed_ms);
+    } else {
+        Log(LogLevel::kWarn, kLogSource, "%s: %s", job.index.c_str(), result.error.c_str());
+    }
+    return result;
+}
+
+} // namespace kakarot
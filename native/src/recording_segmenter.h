@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+struct SegmentationJob {
+    std::string index;               // <name>.<track>.idx of the track to split
+    std::string output_dir;          // must exist
+    std::string name = "segment";    // files <name>.<n>.flac
+    double target_ms = 60000.0;      // segments aim for this length
+    double max_shift_ms = 15000.0;   // a cut moves up to this far to land in a pause
+    double min_silence_ms = 300.0;   // the shortest pause a cut goes in
+    float threshold = 0.5f;          // VAD speech probability
+    int sample_rate = 16000;         // of the output
+    size_t threads = 0;              // 0 = half the cores
+};
+
+// One segment as written: 16-bit mono FLAC of [start_ms, end_ms)
+struct RecordingSegment {
+    size_t index = 0;
+    std::string path;
+    double start_ms = 0.0;   // recording time
+    double end_ms = 0.0;
+    double speech_ms = 0.0;
+    uint64_t bytes = 0;
+};
+
+struct SegmentationResult {
+    bool ok = false;
+    std::string error;
+    std::vector<RecordingSegment> segments;  // in order; those without speech are left out
+    double audio_ms = 0.0;
+    double speech_ms = 0.0;
+    double vad_ms = 0.0;      // wall time of each phase
+    double encode_ms = 0.0;
+    double elapsed_ms = 0.0;
+};
+
+// Called on a worker thread as each segment is complete, in any order
+using SegmentReadyFn = std::function<void(const RecordingSegment& segment)>;
+
+// Splits a recorded track for batch transcription, on the calling thread
+// and |threads| workers: the RNN VAD runs over equal spans of the track in
+// parallel, cuts go in the pause nearest each multiple of an even share of
+// target_ms (so segments come out balanced), and the segments are resampled
+// and FLAC-encoded in parallel, each to <name>.<n>.flac.part and renamed
+// when whole. Gaps in the recording are written as silence, so times inside
+// a segment are its start plus the offset. Polls |cancel| between reads.
+SegmentationResult SegmentRecording(const SegmentationJob& job, const SegmentReadyFn& ready,
+                                    const std::atomic<bool>& cancel);
+
+} // namespace kakarot
@@ -0,0 +1,88 @@
+#include "residual_echo_detector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kakarot {
+
+// Moments follow ~2s of audio
+static constexpr double kTimeConstantSeconds = 2.0;
+
+// Below this either stream is effectively constant (silent render, gated
+// mic) and the covariance says nothing
+static constexpr double kMinVariance = 1e-12;
+
+ResidualEchoDetector::ResidualEchoDetector(size_t frame_size, size_t max_delay_frames, int frames_per_second)
+    : frame_size_(frame_size),
+      kernels_(dsp::FrameKernelsFor(frame_size)),
+      block_frames_(static_cast<size_t>(std::max(1, frames_per_second))),
+      render_power_(max_delay_frames + 1, 0.0f),
+      moments_(max_delay_frames + 1) {}
+
+float ResidualEchoDetector::Power(const float* frame) const {
+    float sum = 0.0f;
+    float peak = 0.0f;
+    kernels_.sum_squares_and_peak(frame, frame_size_, &sum, &peak);
+    return sum / frame_size_;
+}
+
+void ResidualEchoDetector::AnalyzeRender(const float* frame) {
+    render_power_[render_pos_] = Power(frame);
+    render_pos_ = (render_pos_ + 1) % render_power_.size();
+    render_frames_ = std::min(render_frames_ + 1, render_power_.size());
+}
+
+void ResidualEchoDetector::AnalyzeCapture(const float* frame) {
+    const double alpha = 1.0 / (kTimeConstantSeconds * block_frames_);
+    const double capture = Power(frame);
+    const size_t ring = render_power_.size();
+
+    // Until the moments have seen two time constants of audio, chance alignment
+    // of the first few frames reads as full correlation
+    bool warm = ++capture_frames_ >= 2 * kTimeConstantSeconds * block_frames_;
+
+    double best = 0.0;
+    for (size_t delay = 0; delay < render_frames_; ++delay) {
+        const double render = render_power_[(render_pos_ + ring - 1 - delay) % ring];
+        Moments& m = moments_[delay];
+        m.render += alpha * (render - m.render);
+        m.capture += alpha * (capture - m.capture);
+        m.render_sq += alpha * (render * render - m.render_sq);
+        m.capture_sq += alpha * (capture * capture - m.capture_sq);
+        m.cross += alpha * (render * capture - m.cross);
+
+        double var_render = m.render_sq - m.render * m.render;
+        double var_capture = m.capture_sq - m.capture * m.capture;
+        if (!warm || var_render < kMinVariance || var_capture < kMinVariance) {
+            continue;
+        }
+        double covariance = m.cross - m.render * m.capture;
+        best = std::max(best, covariance / std::sqrt(var_render * var_capture));
+    }
+
+    float likelihood = static_cast<float>(std::min(best, 1.0));
+    likelihood_.store(likelihood, std::memory_order_relaxed);
+
+    // Recent max over kRecentBlocks one-second blocks, the current one included
+    block_max_[block_] = std::max(block_max_[block_], likelihood);
+    recent_max_.store(*std::max_element(block_max_, block_max_ + kRecentBlocks), std::memory_order_relaxed);
+    if (++block_fill_ == block_frames_) {
+        block_fill_ = 0;
+        block_ = (block_ + 1) % kRecentBlocks;
+        block_max_[block_] = 0.0f;
+    }
+}
+
+void ResidualEchoDetector::Reset() {
+    std::fill(render_power_.begin(), render_power_.end(), 0.0f);
+    render_pos_ = 0;
+    render_frames_ = 0;
+    capture_frames_ = 0;
+    std::fill(moments_.begin(), moments_.end(), Moments());
+    std::fill(block_max_, block_max_ + kRecentBlocks, 0.0f);
+    block_ = 0;
+    block_fill_ = 0;
+    likelihood_.store(0.0f, std::memory_order_relaxed);
+    recent_max_.store(0.0f, std::memory_order_relaxed);
+}
+
+} // namespace kakarot
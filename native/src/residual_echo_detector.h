@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "frame_kernels.h"
+
+namespace kakarot {
+
+// Likelihood that echo survives the canceller, after WebRTC's residual echo
+// detector (not part of the vendored build): the power of each render frame
+// is correlated with the power of the cleaned capture frame at every
+// candidate delay, and the highest normalized covariance across delays is the
+// likelihood. O(delays) per frame, no allocation after construction.
+// AnalyzeRender/AnalyzeCapture on the processing thread; the readings may be
+// taken from any thread.
+class ResidualEchoDetector {
+public:
+    // |max_delay_frames| candidate delays of one frame each
+    ResidualEchoDetector(size_t frame_size, size_t max_delay_frames, int frames_per_second);
+
+    void AnalyzeRender(const float* frame);
+    void AnalyzeCapture(const float* frame);
+
+    // 0-1: current, and the highest of roughly the last ten seconds
+    float Likelihood() const { return likelihood_.load(std::memory_order_relaxed); }
+    float RecentMax() const { return recent_max_.load(std::memory_order_relaxed); }
+
+    void Reset();
+
+private:
+    // Exponentially weighted moments of one (render at delay d, capture) pair
+    struct Moments {
+        double render = 0.0;
+        double capture = 0.0;
+        double render_sq = 0.0;
+        double capture_sq = 0.0;
+        double cross = 0.0;
+    };
+
+    static constexpr size_t kRecentBlocks = 10;
+
+    float Power(const float* frame) const;
+
+    const size_t frame_size_;
+    const dsp::FrameKernels kernels_;
+    const size_t block_frames_;       // capture frames per recent-max block (1s)
+    std::vector<float> render_power_;  // ring, newest at render_pos_ - 1
+    size_t render_pos_ = 0;
+    size_t render_frames_ = 0;         // since Reset, capped at the ring size
+    std::vector<Moments> moments_;     // per delay
+    size_t capture_frames_ = 0;
+    float block_max_[kRecentBlocks] = {};
+    size_t block_ = 0;
+    size_t block_fill_ = 0;
+    std::atomic<float> likelihood_{0.0f};
+    std::atomic<float> recent_max_{0.0f};
+};
+
+} // namespace kakarot
@@ -0,0 +1,85 @@
+#include "session_arena.h"
+#include <cstdio>
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace kakarot {
+
+void SessionArena::Prepare(size_t bytes) {
+    Release();
+    if (bytes > 0) {
+        block_.reset(new unsigned char[bytes]);
+        capacity_ = bytes;
+    }
+}
+
+void SessionArena::Release() {
+    block_.reset();
+    capacity_ = 0;
+    used_ = 0;
+    overflow_bytes_ = 0;
+}
+
+void* SessionArena::Allocate(size_t bytes, size_t alignment) {
+    if (block_) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(block_.get());
+        uintptr_t start = (base + used_ + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        if (start + bytes <= base + capacity_) {
+            used_ = static_cast<size_t>(start + bytes - base);
+            return reinterpret_cast<void*>(start);
+        }
+    }
+    overflow_bytes_ += bytes;
+    return ::operator new(bytes);
+}
+
+void SessionArena::Deallocate(void* pointer) {
+    const unsigned char* p = static_cast<const unsigned char*>(pointer);
+    if (block_ && p >= block_.get() && p < block_.get() + capacity_) {
+        return;
+    }
+    ::operator delete(pointer);
+}
+
+uint64_t ResidentBytes() {
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) !=
+        KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+#elif defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+#else
+    // statm: total and resident pages
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    unsigned long long total = 0;
+    unsigned long long resident = 0;
+    int read = std::fscanf(statm, "%llu %llu", &total, &resident);
+    std::fclose(statm);
+    if (read != 2) {
+        return 0;
+    }
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+} // namespace kakarot
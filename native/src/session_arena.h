@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace kakarot {
+
+// One block for a session's steady-state buffers: reserved whole when the
+// session opens, handed out by bumping a pointer, and freed whole when it
+// closes, so back-to-back meetings in one long-running process reuse one
+// large allocation instead of leaving the heap fragmented by many. What does
+// not fit comes from the heap and is counted, so an undersized reservation
+// shows. Memory given back before Release() stays used (a container that
+// grows wastes its old storage); heap fallbacks are freed as usual. One
+// thread at a time.
+class SessionArena {
+public:
+    SessionArena() = default;
+    ~SessionArena() { Release(); }
+
+    SessionArena(const SessionArena&) = delete;
+    SessionArena& operator=(const SessionArena&) = delete;
+
+    // Frees the previous session's block and reserves |bytes|
+    void Prepare(size_t bytes);
+
+    // Every container using the arena must be empty, its storage given back
+    void Release();
+
+    void* Allocate(size_t bytes, size_t alignment);
+    void Deallocate(void* pointer);
+
+    size_t Capacity() const { return capacity_; }
+    size_t Used() const { return used_; }
+    uint64_t OverflowBytes() const { return overflow_bytes_; }
+
+private:
+    std::unique_ptr<unsigned char[]> block_;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    uint64_t overflow_bytes_ = 0;  // since Prepare()
+};
+
+// Standard allocator over a SessionArena, for containers that live as long
+// as their owner but hold a session's storage
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(SessionArena* arena) : arena_(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* pointer, size_t) { arena_->Deallocate(pointer); }
+
+    SessionArena* arena() const { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.arena(); }
+
+private:
+    SessionArena* arena_;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Gives |vector|'s storage back to its arena
+template <typename T>
+void ReleaseStorage(ArenaVector<T>* vector) {
+    ArenaVector<T>(vector->get_allocator()).swap(*vector);
+}
+
+// Bytes of |count| T in an arena, alignment slack included
+template <typename T>
+constexpr size_t ArenaBytes(size_t count) {
+    return count * sizeof(T) + alignof(std::max_align_t);
+}
+
+// The process's resident set, in bytes; 0 where it cannot be read
+uint64_t ResidentBytes();
+
+} // namespace kakarot
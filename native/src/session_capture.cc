@@ -0,0 +1,259 @@
+#include "session_capture.h"
+#include "host_time.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "recording_index.h"
+#include "spsc_ring_buffer.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kakarot {
+
+static const char* const kLogSource = "SessionCapture";
+
+// Per stream, between the capture threads and the writer: ~5s at 48kHz, and
+// buffer headers for IO buffers down to 64 frames
+static constexpr size_t kRingSamples = 262144;
+static constexpr size_t kRingChunks = 4096;
+static constexpr int64_t kDrainIntervalNs = 100 * 1000 * 1000;
+static constexpr size_t kWriteBlockSamples = 4096;
+
+static WakeupCounter g_wakeups("sessionCaptureWriter");
+
+static const char* const kStreamNames[kSessionStreamCount] = {"microphone", "system"};
+
+const char* SessionStreamName(SessionStream stream) {
+    return kStreamNames[static_cast<size_t>(stream)];
+}
+
+namespace internal {
+std::atomic<bool> g_session_capture{false};
+}
+
+namespace {
+
+using recording_index::PutLe;
+
+struct BufferInfo {
+    uint32_t num_samples;
+    int32_t sample_rate;
+    uint64_t host_time;  // the device's, in ticks
+    uint64_t arrival;    // HostTimeNow() in the callback
+};
+
+struct Stream {
+    // Allocated by the first capture and kept, so a producer that read the
+    // flag just before a stop never writes into freed rings
+    std::unique_ptr<SpscRingBuffer<float>> samples;
+    std::unique_ptr<SpscRingBuffer<BufferInfo>> buffers;
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<const void*> producer{nullptr};
+};
+
+struct Event {
+    SessionStream stream;
+    SessionEventType type;
+    uint64_t arrival;
+    std::string detail;
+};
+
+struct Capture {
+    std::mutex control_mutex;   // start/stop, from any JS thread
+    HostClock clock;            // ticks to ns, the same on every thread
+    FILE* file = nullptr;
+    std::thread writer;
+    Semaphore wake;
+    std::atomic<bool> running{false};
+    bool failed = false;        // a write failed; the rest is dropped
+    SessionCaptureSummary summary;
+
+    std::mutex event_mutex;
+    std::vector<Event> events;
+};
+
+Stream g_streams[kSessionStreamCount];
+Capture g_capture;
+
+uint64_t TicksToNs(uint64_t ticks) {
+    return static_cast<uint64_t>(g_capture.clock.TicksToMs(ticks) * 1e6);
+}
+
+void WriteRecord(SessionEventType type, size_t stream, uint32_t count, int sample_rate, uint64_t host_time,
+                 uint64_t arrival, const void* payload, size_t payload_bytes) {
+    if (g_capture.failed) {
+        return;
+    }
+    uint8_t header[kSessionRecordSize] = {};
+    header[0] = static_cast<uint8_t>(type);
+    header[1] = static_cast<uint8_t>(stream);
+    PutLe(header + 4, count, 4);
+    PutLe(header + 8, static_cast<uint32_t>(sample_rate), 4);
+    PutLe(header + 16, TicksToNs(host_time), 8);
+    PutLe(header + 24, TicksToNs(arrival), 8);
+    bool ok = std::fwrite(header, 1, sizeof(header), g_capture.file) == sizeof(header) &&
+              (payload_bytes == 0 || std::fwrite(payload, 1, payload_bytes, g_capture.file) == payload_bytes);
+    g_capture.summary.bytes += sizeof(header) + payload_bytes;
+    if (!ok) {
+        g_capture.failed = true;
+        Log(LogLevel::kError, kLogSource, "Write failed; the capture stops here");
+    }
+}
+
+// Whole buffers only: one record per callback, as the addon received it
+void DrainStream(size_t index) {
+    Stream& stream = g_streams[index];
+    std::vector<float> block;
+    for (;;) {
+        // The producer publishes the samples before their header
+        BufferInfo info;
+        if (stream.buffers->Read(&info, 1) == 0) {
+            return;
+        }
+        block.resize(info.num_samples);
+        stream.samples->Read(block.data(), info.num_samples);
+        WriteRecord(SessionEventType::kBuffer, index, info.num_samples, info.sample_rate, info.host_time,
+                    info.arrival, block.data(), block.size() * sizeof(float));
+        g_capture.summary.buffers[index]++;
+        g_capture.summary.samples[index] += info.num_samples;
+    }
+}
+
+void DrainAll() {
+    for (size_t i = 0; i < kSessionStreamCount; ++i) {
+        DrainStream(i);
+    }
+    // Events after the buffers that arrived before them were drained
+    std::vector<Event> events;
+    {
+        std::lock_guard<std::mutex> lock(g_capture.event_mutex);
+        events.swap(g_capture.events);
+    }
+    for (const Event& event : events) {
+        WriteRecord(event.type, static_cast<size_t>(event.stream), static_cast<uint32_t>(event.detail.size()), 0,
+                    event.arrival, event.arrival, event.detail.data(), event.detail.size());
+        g_capture.summary.events++;
+    }
+    std::fflush(g_capture.file);
+}
+
+void WriterLoop() {
+    ScopedThreadCpu thread_cpu("sessionCaptureWriter");
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+    while (g_capture.running.load(std::memory_order_acquire)) {
+        g_capture.wake.WaitFor(kDrainIntervalNs);
+        g_wakeups.Count();
+        DrainAll();
+    }
+}
+
+} // namespace
+
+bool StartSessionCapture(const std::string& path, std::string* error) {
+    std::lock_guard<std::mutex> control(g_capture.control_mutex);
+    if (g_capture.writer.joinable()) {
+        *error = "already capturing";
+        Log(LogLevel::kWarn, kLogSource, "Session capture already running");
+        return false;
+    }
+    g_capture.file = std::fopen(path.c_str(), "wb");
+    if (!g_capture.file) {
+        *error = "cannot open " + path;
+        Log(LogLevel::kError, kLogSource, "Cannot open %s", path.c_str());
+        return false;
+    }
+    uint8_t header[kSessionHeaderSize] = {};
+    std::memcpy(header, "KKSC", 4);
+    PutLe(header + 4, kSessionVersion, 4);
+    PutLe(header + 8, TicksToNs(HostTimeNow()), 8);
+    PutLe(header + 16, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()), 8);
+    std::fwrite(header, 1, sizeof(header), g_capture.file);
+
+    for (Stream& stream : g_streams) {
+        if (!stream.samples) {
+            stream.samples = std::make_unique<SpscRingBuffer<float>>(kRingSamples);
+            stream.buffers = std::make_unique<SpscRingBuffer<BufferInfo>>(kRingChunks);
+        }
+        // Whatever a producer slipped in after the last stop
+        float discard[kWriteBlockSamples];
+        while (stream.samples->Read(discard, kWriteBlockSamples) > 0) {
+        }
+        BufferInfo info;
+        while (stream.buffers->Read(&info, 1) > 0) {
+        }
+        stream.dropped.store(0, std::memory_order_relaxed);
+        stream.producer.store(nullptr, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_capture.event_mutex);
+        g_capture.events.clear();
+    }
+    g_capture.summary = SessionCaptureSummary();
+    g_capture.summary.bytes = kSessionHeaderSize;
+    g_capture.failed = false;
+    g_capture.running.store(true, std::memory_order_release);
+    g_capture.writer = std::thread(&WriterLoop);
+    internal::g_session_capture.store(true, std::memory_order_release);
+    Log(LogLevel::kInfo, kLogSource, "Capturing the session to %s", path.c_str());
+    return true;
+}
+
+SessionCaptureSummary StopSessionCapture() {
+    std::lock_guard<std::mutex> control(g_capture.control_mutex);
+    if (!g_capture.writer.joinable()) {
+        return SessionCaptureSummary();
+    }
+    internal::g_session_capture.store(false, std::memory_order_relaxed);
+    g_capture.running.store(false, std::memory_order_release);
+    g_capture.wake.Signal();
+    g_capture.writer.join();
+
+    DrainAll();
+    std::fclose(g_capture.file);
+    g_capture.file = nullptr;
+    for (size_t i = 0; i < kSessionStreamCount; ++i) {
+        g_capture.summary.dropped[i] = g_streams[i].dropped.load(std::memory_order_relaxed);
+        if (g_capture.summary.dropped[i] > 0) {
+            Log(LogLevel::kWarn, kLogSource, "%llu %s buffer(s) not captured",
+                static_cast<unsigned long long>(g_capture.summary.dropped[i]), kStreamNames[i]);
+        }
+    }
+    Log(LogLevel::kInfo, kLogSource, "Session capture stopped: %llu + %llu buffers, %llu bytes",
+        static_cast<unsigned long long>(g_capture.summary.buffers[0]),
+        static_cast<unsigned long long>(g_capture.summary.buffers[1]),
+        static_cast<unsigned long long>(g_capture.summary.bytes));
+    return g_capture.summary;
+}
+
+void internal::CaptureSessionBuffer(SessionStream which, const void* producer, const float* data,
+                                    uint32_t num_samples, int sample_rate, uint64_t host_time) {
+    const uint64_t arrival = HostTimeNow();
+    Stream& stream = g_streams[static_cast<size_t>(which)];
+    // The rings are single-producer: the first instance to deliver keeps them
+    const void* owner = stream.producer.load(std::memory_order_acquire);
+    if (owner != producer && (owner != nullptr || !stream.producer.compare_exchange_strong(owner, producer))) {
+        return;
+    }
+    if (stream.samples->AvailableToWrite() < num_samples || stream.buffers->AvailableToWrite() < 1) {
+        stream.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    stream.samples->Write(data, num_samples);
+    BufferInfo info{num_samples, sample_rate, host_time, arrival};
+    stream.buffers->Write(&info, 1);
+}
+
+void internal::CaptureSessionEvent(SessionStream stream, SessionEventType type, const char* detail) {
+    Event event{stream, type, HostTimeNow(), detail ? detail : ""};
+    std::lock_guard<std::mutex> lock(g_capture.event_mutex);
+    g_capture.events.push_back(std::move(event));
+}
+
+} // namespace kakarot
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace kakarot {
+
+// The two producers a session capture records
+enum class SessionStream : uint8_t {
+    kMicrophone,  // the input device's buffers as its IOProc got them
+    kSystem,      // the tap's or loopback's
+};
+constexpr size_t kSessionStreamCount = 2;
+
+const char* SessionStreamName(SessionStream stream);
+
+// What happened to a stream, in record order
+enum class SessionEventType : uint8_t {
+    kBuffer = 0,  // samples handed to the addon
+    kPause = 1,   // capture paused on request
+    kGap = 2,     // capture stopped on its own (device lost, sleep)
+    kDevice = 3,  // the input moved to another device; the detail names it
+};
+
+// The capture file, everything little-endian. A fixed header, then records
+// in the order the writer drained them (each stream's in arrival order):
+//
+//   header  "KKSC", u32 version, u64 started_host_ns, u64 started_at_ms
+//           (Unix epoch), u64 reserved
+//   record  u8 type, u8 stream, u16 reserved, u32 count (samples or detail
+//           bytes), u32 sample_rate, u32 reserved, u64 host_ns (the
+//           buffer's device timestamp), u64 arrival_ns (when the callback
+//           ran), then count float32 samples or count bytes of UTF-8
+//
+// Host times are converted from the platform's ticks to nanoseconds of the
+// same monotonic clock, so a file replays on any platform.
+constexpr size_t kSessionHeaderSize = 32;
+constexpr size_t kSessionRecordSize = 32;
+constexpr uint32_t kSessionVersion = 1;
+
+struct SessionCaptureSummary {
+    uint64_t buffers[kSessionStreamCount] = {};
+    uint64_t samples[kSessionStreamCount] = {};
+    uint64_t dropped[kSessionStreamCount] = {};  // buffers the ring had no room for
+    uint64_t events = 0;
+    uint64_t bytes = 0;
+};
+
+// Process-wide raw capture of what the addon receives, off by default, for
+// replay through the pipeline when a bug needs real timing: every buffer
+// with its size, device timestamp and arrival time, plus pauses, gaps and
+// device moves. The capture threads copy into a ring per stream without
+// locks or allocation; a background thread writes the file. Start and stop
+// are serialized, so any JS thread may call them. Returns false (and logs)
+// when already capturing or the file will not open.
+bool StartSessionCapture(const std::string& path, std::string* error);
+
+// Writes what is buffered and closes the file; an empty summary when idle
+SessionCaptureSummary StopSessionCapture();
+
+namespace internal {
+extern std::atomic<bool> g_session_capture;
+void CaptureSessionBuffer(SessionStream stream, const void* producer, const float* data, uint32_t num_samples,
+                          int sample_rate, uint64_t host_time);
+void CaptureSessionEvent(SessionStream stream, SessionEventType type, const char* detail);
+}
+
+// Capture threads: a copy and an atomic publish while capturing, a single
+// load otherwise. Like the recorder, a stream takes one |producer| per
+// capture, the first to deliver.
+inline void CaptureSessionBuffer(SessionStream stream, const void* producer, const float* data,
+                                 uint32_t num_samples, int sample_rate, uint64_t host_time) {
+    if (internal::g_session_capture.load(std::memory_order_acquire)) {
+        internal::CaptureSessionBuffer(stream, producer, data, num_samples, sample_rate, host_time);
+    }
+}
+
+// Any thread but a real-time one (it takes a lock)
+inline void CaptureSessionEvent(SessionStream stream, SessionEventType type, const char* detail = "") {
+    if (internal::g_session_capture.load(std::memory_order_acquire)) {
+        internal::CaptureSessionEvent(stream, type, detail);
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,473 @@
+#include "session_replay.h"
+#include "addon_common.h"
+#include "aec_processor.h"
+#include "capture_stream.h"
+#include "echo_cancel_pipeline.h"
+#include "host_time.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "recording_index.h"
+#include "recording_reader.h"
+#include "thread_cpu.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace kakarot {
+
+static const char* const kLogSource = "SessionReplay";
+
+// The addon's own stream rings and render wait (the stream-based build's)
+static constexpr size_t kReplayRingSamples = 96000;
+static constexpr size_t kReplayRingChunks = 256;
+static constexpr double kReplayRenderWaitMs = 50.0;
+static constexpr double kReplayAecSampleRate = 48000.0;
+static constexpr double kMaxReplaySpeed = 64.0;
+// Back-to-back passes one start() takes: a soak's hours from a short capture
+static constexpr double kMaxReplayLoops = 100000.0;
+
+using recording_index::GetLe;
+
+SessionCaptureReader::SessionCaptureReader() = default;
+SessionCaptureReader::~SessionCaptureReader() = default;
+
+bool SessionCaptureReader::Open(const std::string& path, std::string* error) {
+    auto file = std::make_unique<MappedFile>();
+    if (!file->Open(path, error)) {
+        return false;
+    }
+    const uint8_t* data = file->Data();
+    size_t size = file->Size();
+    if (size < kSessionHeaderSize || std::memcmp(data, "KKSC", 4) != 0) {
+        *error = path + " is not a session capture";
+        return false;
+    }
+    if (GetLe(data + 4, 4) != kSessionVersion) {
+        *error = path + " is a newer session capture";
+        return false;
+    }
+    started_at_ms_ = GetLe(data + 16, 8);
+
+    records_.clear();
+    size_t offset = kSessionHeaderSize;
+    while (size - offset >= kSessionRecordSize) {
+        const uint8_t* header = data + offset;
+        SessionRecord record;
+        record.type = static_cast<SessionEventType>(header[0]);
+        record.stream = static_cast<SessionStream>(header[1]);
+        record.count = static_cast<uint32_t>(GetLe(header + 4, 4));
+        record.sample_rate = static_cast<int>(GetLe(header + 8, 4));
+        record.host_ns = GetLe(header + 16, 8);
+        record.arrival_ns = GetLe(header + 24, 8);
+        size_t payload = record.type == SessionEventType::kBuffer ? record.count * sizeof(float) : record.count;
+        if (header[1] >= kSessionStreamCount || size - offset - kSessionRecordSize < payload) {
+            break;
+        }
+        record.payload = header + kSessionRecordSize;
+        offset += kSessionRecordSize + payload;
+        if (record.type == SessionEventType::kBuffer) {
+            size_t stream = header[1];
+            if (record.count == 0 || record.sample_rate <= 0) {
+                continue;
+            }
+            if (sample_rates_[stream] == 0) {
+                sample_rates_[stream] = record.sample_rate;
+            }
+            buffers_[stream]++;
+        }
+        records_.push_back(record);
+    }
+    if (offset != size) {
+        Log(LogLevel::kWarn, kLogSource, "%s: %zu trailing bytes ignored", path.c_str(), size - offset);
+    }
+    // The writer drains each stream in turn and events last
+    std::stable_sort(records_.begin(), records_.end(), [](const SessionRecord& a, const SessionRecord& b) {
+        return a.arrival_ns < b.arrival_ns;
+    });
+    file_ = std::move(file);
+    return true;
+}
+
+double SessionCaptureReader::DurationMs() const {
+    if (records_.empty()) {
+        return 0.0;
+    }
+    return (records_.back().arrival_ns - records_.front().arrival_ns) / 1e6;
+}
+
+SessionReplayStats ReplaySession(const SessionCaptureReader& reader, double speed, const SessionReplaySinks& sinks,
+                                 const std::atomic<bool>& cancel) {
+    SessionReplayStats stats;
+    const std::vector<SessionRecord>& records = reader.Records();
+    if (records.empty()) {
+        return stats;
+    }
+    const HostClock clock;
+    const double scale = speed > 0.0 ? speed : 1.0;
+    const uint64_t first_ns = records.front().arrival_ns;
+    const uint64_t base_host = HostTimeNow();
+    const auto started = std::chrono::steady_clock::now();
+    const uint64_t cpu_start = CurrentThreadCpuNs();
+    const SessionStream timed = reader.Buffers(SessionStream::kMicrophone) > 0 ? SessionStream::kMicrophone
+                                                                             : SessionStream::kSystem;
+    std::vector<float> samples;
+
+    for (const SessionRecord& record : records) {
+        if (cancel.load(std::memory_order_relaxed)) {
+            break;
+        }
+        double due_ms = (record.arrival_ns - first_ns) / 1e6 / scale;
+        if (speed > 0.0) {
+            std::this_thread::sleep_until(started + std::chrono::duration<double, std::milli>(due_ms));
+            double now_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+            stats.max_late_ms = std::max(stats.max_late_ms, now_ms - due_ms);
+        }
+        if (record.type != SessionEventType::kBuffer) {
+            if (sinks.event) {
+                sinks.event(record);
+            }
+            stats.events++;
+            continue;
+        }
+        // Device times run a little ahead of or behind the first arrival
+        double offset_ms = (static_cast<double>(record.host_ns) - static_cast<double>(first_ns)) / 1e6 / scale;
+        uint64_t host_time = offset_ms >= 0.0 ? base_host + clock.MsToTicks(offset_ms)
+                                              : base_host - std::min(base_host, clock.MsToTicks(-offset_ms));
+        samples.resize(record.count);
+        std::memcpy(samples.data(), record.payload, record.count * sizeof(float));
+        if (sinks.buffer) {
+            sinks.buffer(record.stream, samples.data(), record.count, host_time);
+        }
+        stats.buffers++;
+        if (record.stream == timed) {
+            stats.audio_ms += record.count * 1000.0 / record.sample_rate;
+        }
+    }
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    stats.feeder_cpu_ns = CurrentThreadCpuNs() - cpu_start;
+    return stats;
+}
+
+namespace {
+
+// A capture played back through the same CaptureStream and
+// EchoCancelPipeline classes the addon captures with: the replay thread
+// stands in for the IOProcs and calls what their sinks do
+class SessionReplayWrap : public Napi::ObjectWrap<SessionReplayWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "SessionReplay", {
+            InstanceMethod("getInfo", &SessionReplayWrap::GetInfo),
+            InstanceMethod("start", &SessionReplayWrap::Start),
+            InstanceMethod("stop", &SessionReplayWrap::Stop),
+            InstanceMethod("getStats", &SessionReplayWrap::GetStats),
+        });
+    }
+
+    explicit SessionReplayWrap(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<SessionReplayWrap>(info),
+          mic_stream_("replay-mic", &clock_, kReplayRingSamples, kReplayRingChunks),
+          system_stream_("replay-system", &clock_, kReplayRingSamples, kReplayRingChunks),
+          pipeline_(&clock_, kReplayRingSamples, kReplayRingChunks) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a session capture path").ThrowAsJavaScriptException();
+            return;
+        }
+        std::string error;
+        if (!reader_.Open(info[0].As<Napi::String>().Utf8Value(), &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+        AECConfig defaults;
+        defaults.frame_duration_ms = 10;
+        config_ = ParseAECConfig(info.Length() > 1 ? info[1] : env.Undefined(), defaults);
+    }
+
+    ~SessionReplayWrap() {
+        cancel_.store(true, std::memory_order_relaxed);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        pipeline_.Stop();
+    }
+
+private:
+    // getInfo() -> { startedAt, durationMs, buffers: { stream: n },
+    // sampleRates: { stream: hz }, records }
+    Napi::Value GetInfo(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object buffers = Napi::Object::New(env);
+        Napi::Object rates = Napi::Object::New(env);
+        for (size_t i = 0; i < kSessionStreamCount; ++i) {
+            SessionStream stream = static_cast<SessionStream>(i);
+            buffers.Set(SessionStreamName(stream), Napi::Number::New(env, static_cast<double>(reader_.Buffers(stream))));
+            rates.Set(SessionStreamName(stream), Napi::Number::New(env, reader_.SampleRate(stream)));
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("startedAt", Napi::Number::New(env, static_cast<double>(reader_.StartedAtMs())));
+        result.Set("durationMs", Napi::Number::New(env, reader_.DurationMs()));
+        result.Set("buffers", buffers);
+        result.Set("sampleRates", rates);
+        result.Set("records", Napi::Number::New(env, static_cast<double>(reader_.Records().size())));
+        return result;
+    }
+
+    // start({ speed?, loops?, onMicrophone?, microphoneOptions?, onSystem?,
+    // systemOptions? }) -> Promise<report>. Callbacks get what the capture
+    // callbacks would; a stream without one is still delivered, to nothing.
+    // |loops| replays the capture that many times back to back, through the
+    // same streams and echo canceller, each pass timed on from the last.
+    Napi::Value Start(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        if (running_) {
+            deferred.Reject(Napi::Error::New(env, "Replay already running").Value());
+            return deferred.Promise();
+        }
+        Napi::Object options = info.Length() > 0 && info[0].IsObject() ? info[0].As<Napi::Object>()
+                                                                       : Napi::Object::New(env);
+        speed_ = 1.0;
+        if (options.Get("speed").IsNumber()) {
+            speed_ = std::max(0.0, std::min(options.Get("speed").As<Napi::Number>().DoubleValue(), kMaxReplaySpeed));
+        }
+        loops_ = 1;
+        if (options.Get("loops").IsNumber()) {
+            loops_ = static_cast<uint32_t>(
+                std::max(1.0, std::min(options.Get("loops").As<Napi::Number>().DoubleValue(), kMaxReplayLoops)));
+        }
+        Napi::Function noop = Napi::Function::New(env, [](const Napi::CallbackInfo&) {});
+        CaptureOptions mic_options = ParseCaptureOptions(options.Get("microphoneOptions"));
+        CaptureOptions system_options = ParseCaptureOptions(options.Get("systemOptions"));
+
+        const int mic_rate = reader_.SampleRate(SessionStream::kMicrophone);
+        const int system_rate = reader_.SampleRate(SessionStream::kSystem);
+        processed_ = mic_options.processed && mic_rate > 0;
+        if (processed_) {
+            aec_ = std::make_unique<AECProcessor>(config_);
+            if (!aec_->Initialize(static_cast<int>(kReplayAecSampleRate), 1, 1)) {
+                aec_.reset();
+                deferred.Reject(Napi::Error::New(env, "Failed to initialize AEC processor").Value());
+                return deferred.Promise();
+            }
+        }
+
+        clock_.Anchor();
+        if (mic_rate > 0) {
+            mic_stream_.Open(env, options.Get("onMicrophone").IsFunction()
+                ? options.Get("onMicrophone").As<Napi::Function>() : noop, mic_options, mic_rate);
+            mic_stream_.Stats().start_host.store(HostTimeNow(), std::memory_order_relaxed);
+        }
+        if (system_rate > 0) {
+            system_stream_.Open(env, options.Get("onSystem").IsFunction()
+                ? options.Get("onSystem").As<Napi::Function>() : noop, system_options, system_rate);
+            system_stream_.Stats().start_host.store(HostTimeNow(), std::memory_order_relaxed);
+        }
+        if (processed_) {
+            pipeline_.Start(aec_.get(), &mic_stream_, kReplayAecSampleRate, mic_rate, kReplayRenderWaitMs, 0.0);
+        }
+
+        deferred_ = std::make_unique<Napi::Promise::Deferred>(deferred);
+        done_ = Napi::ThreadSafeFunction::New(env, noop, "SessionReplay", 0, 1);
+        cancel_.store(false, std::memory_order_relaxed);
+        mic_paused_ = false;
+        device_changes_ = 0;
+        passes_.store(0, std::memory_order_relaxed);
+        replayed_ms_.store(0.0, std::memory_order_relaxed);
+        running_ = true;
+        Ref();  // kept alive until the promise settles
+        thread_ = std::thread(&SessionReplayWrap::ReplayLoop, this);
+        Log(LogLevel::kInfo, kLogSource, "Replaying %.1fs of capture at %s", reader_.DurationMs() / 1000.0,
+            speed_ > 0.0 ? (std::to_string(speed_) + "x").c_str() : "full speed");
+        return deferred.Promise();
+    }
+
+    // stop(): the replay ends at the next record; start()'s promise still
+    // resolves, with what was replayed
+    Napi::Value Stop(const Napi::CallbackInfo& info) {
+        cancel_.store(true, std::memory_order_relaxed);
+        return info.Env().Undefined();
+    }
+
+    // getStats() -> { passes, audioMs, microphone, system, aec? } while a
+    // replay runs, the streams' as in the report so far; null otherwise.
+    // audioMs counts finished passes only.
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (!running_) {
+            return env.Null();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("passes", Napi::Number::New(env, passes_.load(std::memory_order_relaxed)));
+        result.Set("audioMs", Napi::Number::New(env, replayed_ms_.load(std::memory_order_relaxed)));
+        const struct {
+            const char* name;
+            CaptureStream& stream;
+        } streams[] = {
+            { "microphone", mic_stream_ },
+            { "system", system_stream_ },
+        };
+        for (const auto& entry : streams) {
+            if (!entry.stream.IsOpen()) {
+                continue;
+            }
+            Napi::Object stream = CaptureStatsToObject(env, entry.stream.Stats(), clock_);
+            stream.Set("latency", LatencyTraceToObject(env, entry.stream.Trace()));
+            result.Set(entry.name, stream);
+        }
+        if (processed_) {
+            result.Set("aec", AECMetricsToObject(env, aec_->GetMetrics()));
+        }
+        return result;
+    }
+
+    // Replay thread, paced like a capture thread
+    void ReplayLoop() {
+        ScopedThreadCpu thread_cpu("sessionReplay");
+        SetCurrentThreadPriority(ThreadPriority::kInteractive);
+        SessionReplaySinks sinks;
+        sinks.buffer = [this](SessionStream stream, const float* data, uint32_t num_samples, uint64_t host_time) {
+            const uint64_t callback_start = HostTimeNow();
+            if (stream == SessionStream::kMicrophone) {
+                if (mic_paused_ && processed_) {
+                    pipeline_.SetCapturePaused(false);
+                }
+                mic_paused_ = false;
+                if (!processed_) {
+                    mic_stream_.PushFromRealtime(data, num_samples, host_time);
+                } else if (!pipeline_.PushCapture(data, num_samples, host_time)) {
+                    mic_stream_.Stats().buffers_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                mic_stream_.Stats().RecordCallback(callback_start, HostTimeNow());
+            } else {
+                system_stream_.PushFromRealtime(data, num_samples, host_time);
+                if (processed_) {
+                    pipeline_.PushRender(data, num_samples, 1, host_time);
+                }
+                system_stream_.Stats().RecordCallback(callback_start, HostTimeNow());
+            }
+        };
+        sinks.event = [this](const SessionRecord& record) {
+            if (record.stream != SessionStream::kMicrophone) {
+                return;
+            }
+            switch (record.type) {
+            case SessionEventType::kPause:
+            case SessionEventType::kGap:
+                if (processed_) {
+                    pipeline_.SetCapturePaused(true);
+                }
+                mic_paused_ = true;
+                if (record.type == SessionEventType::kPause) {
+                    mic_stream_.Pause();
+                } else {
+                    mic_stream_.MarkGap();
+                }
+                break;
+            case SessionEventType::kDevice:
+                device_changes_++;
+                Log(LogLevel::kInfo, kLogSource, "Input moved to %.*s", static_cast<int>(record.count),
+                    reinterpret_cast<const char*>(record.payload));
+                break;
+            default:
+                break;
+            }
+        };
+        SessionReplayStats total;
+        for (uint32_t pass = 0; pass < loops_ && !cancel_.load(std::memory_order_relaxed); ++pass) {
+            SessionReplayStats stats = ReplaySession(reader_, speed_, sinks, cancel_);
+            total.buffers += stats.buffers;
+            total.events += stats.events;
+            total.audio_ms += stats.audio_ms;
+            total.elapsed_ms += stats.elapsed_ms;
+            total.max_late_ms = std::max(total.max_late_ms, stats.max_late_ms);
+            total.feeder_cpu_ns += stats.feeder_cpu_ns;
+            replayed_ms_.store(total.audio_ms, std::memory_order_relaxed);
+            passes_.store(pass + 1, std::memory_order_relaxed);
+        }
+        stats_ = total;
+
+        Napi::ThreadSafeFunction done = done_;
+        napi_status status = done.NonBlockingCall(this, [](Napi::Env env, Napi::Function, SessionReplayWrap* self) {
+            self->Finish(env);
+        });
+        if (status != napi_ok) {
+            Log(LogLevel::kWarn, kLogSource, "Replay finished after its env closed");
+        }
+        done.Release();
+    }
+
+    // JS thread, once the replay thread is done feeding. The streams flush
+    // what they hold before the report is taken.
+    void Finish(Napi::Env env) {
+        thread_.join();
+        Napi::Object report = Napi::Object::New(env);
+        if (processed_) {
+            pipeline_.Stop();
+            report.Set("aec", AECMetricsToObject(env, aec_->GetMetrics()));
+        }
+        const struct {
+            const char* name;
+            CaptureStream& stream;
+        } streams[] = {
+            { "microphone", mic_stream_ },
+            { "system", system_stream_ },
+        };
+        for (const auto& entry : streams) {
+            if (!entry.stream.IsOpen()) {
+                continue;
+            }
+            entry.stream.Close();
+            Napi::Object stream = CaptureStatsToObject(env, entry.stream.Stats(), clock_);
+            stream.Set("latency", LatencyTraceToObject(env, entry.stream.Trace()));
+            report.Set(entry.name, stream);
+        }
+        report.Set("speed", Napi::Number::New(env, speed_));
+        report.Set("passes", Napi::Number::New(env, passes_.load(std::memory_order_relaxed)));
+        report.Set("completed", Napi::Boolean::New(env, !cancel_.load(std::memory_order_relaxed)));
+        report.Set("buffers", Napi::Number::New(env, static_cast<double>(stats_.buffers)));
+        report.Set("events", Napi::Number::New(env, static_cast<double>(stats_.events)));
+        report.Set("deviceChanges", Napi::Number::New(env, static_cast<double>(device_changes_)));
+        report.Set("audioMs", Napi::Number::New(env, stats_.audio_ms));
+        report.Set("elapsedMs", Napi::Number::New(env, stats_.elapsed_ms));
+        report.Set("maxLateMs", Napi::Number::New(env, stats_.max_late_ms));
+        report.Set("feederCpuMs", Napi::Number::New(env, stats_.feeder_cpu_ns / 1e6));
+        aec_.reset();
+        running_ = false;
+        std::unique_ptr<Napi::Promise::Deferred> deferred = std::move(deferred_);
+        deferred->Resolve(report);
+        Unref();
+    }
+
+    SessionCaptureReader reader_;
+    AECConfig config_;
+    HostClock clock_;
+    CaptureStream mic_stream_;
+    CaptureStream system_stream_;
+    EchoCancelPipeline pipeline_;
+    std::unique_ptr<AECProcessor> aec_;
+
+    // Set by start() before the replay thread runs; Finish() reads them after the join
+    std::thread thread_;
+    std::atomic<bool> cancel_{false};
+    std::unique_ptr<Napi::Promise::Deferred> deferred_;
+    Napi::ThreadSafeFunction done_;
+    bool running_ = false;
+    bool processed_ = false;
+    double speed_ = 1.0;
+    uint32_t loops_ = 1;
+    bool mic_paused_ = false;     // replay thread
+    uint64_t device_changes_ = 0; // replay thread
+    SessionReplayStats stats_;
+    std::atomic<uint32_t> passes_{0};     // replay thread -> getStats()
+    std::atomic<double> replayed_ms_{0.0};
+};
+
+} // namespace
+
+Napi::Function DefineSessionReplay(Napi::Env env) {
+    return SessionReplayWrap::Define(env);
+}
+
+} // namespace kakarot
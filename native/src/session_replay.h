@@ -0,0 +1,86 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "session_capture.h"
+
+namespace kakarot {
+
+class MappedFile;
+
+// One record of a session capture, pointing into the mapping
+struct SessionRecord {
+    SessionEventType type;
+    SessionStream stream;
+    uint32_t count = 0;         // samples, or detail bytes
+    int sample_rate = 0;
+    uint64_t host_ns = 0;
+    uint64_t arrival_ns = 0;
+    const uint8_t* payload = nullptr;  // unaligned: float32 samples or UTF-8
+};
+
+// A startSessionCapture() file, mapped and indexed; records sorted by
+// arrival, as the addon received them
+class SessionCaptureReader {
+public:
+    SessionCaptureReader();
+    ~SessionCaptureReader();
+
+    // False (with |error|) for a missing or foreign file. A truncated last
+    // record, from a capture the process did not stop, is left out.
+    bool Open(const std::string& path, std::string* error);
+
+    const std::vector<SessionRecord>& Records() const { return records_; }
+    uint64_t StartedAtMs() const { return started_at_ms_; }
+    double DurationMs() const;
+
+    // Of the first buffer on |stream|; 0 when it has none
+    int SampleRate(SessionStream stream) const { return sample_rates_[static_cast<size_t>(stream)]; }
+    uint64_t Buffers(SessionStream stream) const { return buffers_[static_cast<size_t>(stream)]; }
+
+private:
+    std::unique_ptr<MappedFile> file_;
+    std::vector<SessionRecord> records_;
+    uint64_t started_at_ms_ = 0;
+    int sample_rates_[kSessionStreamCount] = {};
+    uint64_t buffers_[kSessionStreamCount] = {};
+};
+
+// Where a replay hands each record; both run on the replay thread.
+// Buffers get their host time back in the replaying process's ticks.
+struct SessionReplaySinks {
+    std::function<void(SessionStream stream, const float* data, uint32_t num_samples, uint64_t host_time)> buffer;
+    std::function<void(const SessionRecord& record)> event;
+};
+
+struct SessionReplayStats {
+    uint64_t buffers = 0;
+    uint64_t events = 0;
+    double audio_ms = 0.0;       // of the microphone, or the system when there is none
+    double elapsed_ms = 0.0;
+    double max_late_ms = 0.0;    // behind the schedule at worst, for a paced replay
+    uint64_t feeder_cpu_ns = 0;  // of the replay thread itself, sinks included
+};
+
+// Feeds |reader|'s records to |sinks| on the calling thread, each when its
+// arrival comes round again: |speed| 1 replays in real time, 4 four times
+// faster, 0 as fast as the sinks take them. Device timestamps keep their
+// spacing to arrival, scaled the same way, from HostTimeNow() at the
+// start. Polls |cancel| between records.
+SessionReplayStats ReplaySession(const SessionCaptureReader& reader, double speed, const SessionReplaySinks& sinks,
+                                 const std::atomic<bool>& cancel);
+
+// The SessionReplay class export: new SessionReplay(path, aecOptions?);
+// start({ speed?, loops?, onMicrophone?, microphoneOptions?, onSystem?,
+// systemOptions? }) runs the capture through the addon's own streams and
+// echo canceller and resolves with their stats; getStats() reads them
+// mid-replay
+Napi::Function DefineSessionReplay(Napi::Env env);
+
+} // namespace kakarot
@@ -0,0 +1,282 @@
+#include "shadow_aec.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include "rtc_base/denormal_disabler.h"
+#include <algorithm>
+#include <chrono>
+
+namespace kakarot {
+
+// Source tag of records this file writes to the native log ring
+static const char* const kLogSource = "ShadowAec";
+
+// The shadow thread drains the ring this often while taps come in; at
+// utility priority there is no point waking per frame. Once a poll finds
+// the ring empty, with the taps open, it waits untimed.
+static constexpr int64_t kPollIntervalNs = 20 * 1000 * 1000;
+
+static WakeupCounter g_wakeups("shadowAec");
+
+// Load the cap is held to unless asked for another, and the range it takes
+static constexpr float kDefaultMaxLoad = 0.05f;
+static constexpr float kMinMaxLoad = 0.005f;
+static constexpr float kMaxMaxLoad = 0.5f;
+
+// Largest chunk either tap takes: a second at 48kHz over the APM's eight
+// reference channels
+static constexpr size_t kMaxChunkSamples = 48000 * 8;
+
+namespace {
+
+uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+ShadowAec::ShadowAec(size_t ring_samples, size_t ring_records)
+    : samples_(ring_samples), records_(ring_records), buffer_(kMaxChunkSamples), discard_(kMaxChunkSamples) {}
+
+ShadowAec::~ShadowAec() {
+    Stop();
+}
+
+bool ShadowAec::Start(const AECProcessor* live, const AECConfig& candidate, int sample_rate, int render_channels,
+                      float max_load, std::string* error) {
+    Stop();
+    if (!live) {
+        *error = "No live echo canceller to compare against";
+        return false;
+    }
+    AECConfig config = candidate;
+    config.cpu_governor = false;
+    auto shadow = std::make_unique<AECProcessor>(config);
+    if (!shadow->Initialize(sample_rate, 1, render_channels)) {
+        *error = "Candidate echo canceller failed to initialize";
+        return false;
+    }
+    // Start where the live instance is rather than from an unmeasured delay
+    const int delay_ms = live->GetLevels().stream_delay_ms;
+    if (delay_ms > 0) {
+        shadow->SetStreamDelayMs(delay_ms);
+    }
+
+    live_ = live;
+    shadow_ = std::move(shadow);
+    sample_rate_ = sample_rate;
+    max_load_ = max_load > 0.0f ? std::clamp(max_load, kMinMaxLoad, kMaxMaxLoad) : kDefaultMaxLoad;
+    {
+        std::lock_guard<std::mutex> lock(report_mutex_);
+        candidate_ = candidate;
+        seconds_processed_ = 0;
+        seconds_compared_ = 0;
+        seconds_skipped_ = 0;
+        cpu_ns_ = 0;
+        live_sums_ = Sums();
+        shadow_sums_ = Sums();
+    }
+    frames_dropped_.store(0, std::memory_order_relaxed);
+    second_samples_ = 0;
+    reopen_ns_ = 0;
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&ShadowAec::Loop, this);
+    Log(LogLevel::kInfo, kLogSource, "Shadow AEC started at %d Hz, capped at %.1f%% CPU", sample_rate,
+        max_load_ * 100.0f);
+    return true;
+}
+
+void ShadowAec::Stop() {
+    if (!running_.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    tap_open_.store(false, std::memory_order_release);
+    wake_.Signal();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    ShadowAecComparison result = GetComparison();
+    Log(LogLevel::kInfo, kLogSource, "Shadow AEC stopped after %llu s (%llu compared, %llu skipped)",
+        static_cast<unsigned long long>(result.seconds_processed),
+        static_cast<unsigned long long>(result.seconds_compared),
+        static_cast<unsigned long long>(result.seconds_skipped));
+    shadow_.reset();
+    live_ = nullptr;
+}
+
+void ShadowAec::TapRender(const float* data, size_t num_frames, uint32_t num_channels) {
+    if (!tap_open_.load(std::memory_order_acquire) || num_frames == 0) {
+        return;
+    }
+    const size_t count = num_frames * num_channels;
+    if (count > kMaxChunkSamples || records_.AvailableToWrite() < 1 || samples_.AvailableToWrite() < count) {
+        frames_dropped_.fetch_add(num_frames, std::memory_order_relaxed);
+        return;
+    }
+    samples_.Write(data, count);
+    const Record record = {kRender, static_cast<uint32_t>(num_frames), num_channels, -1};
+    records_.Write(&record, 1);
+    wake_.Notify();
+}
+
+void ShadowAec::TapCapture(const float* data, size_t num_samples, int stream_delay_ms) {
+    if (!tap_open_.load(std::memory_order_acquire) || num_samples == 0) {
+        return;
+    }
+    if (num_samples > kMaxChunkSamples || records_.AvailableToWrite() < 1 ||
+        samples_.AvailableToWrite() < num_samples) {
+        frames_dropped_.fetch_add(num_samples, std::memory_order_relaxed);
+        return;
+    }
+    samples_.Write(data, num_samples);
+    const Record record = {kCapture, static_cast<uint32_t>(num_samples), 1, stream_delay_ms};
+    records_.Write(&record, 1);
+    wake_.Notify();
+}
+
+void ShadowAec::Loop() {
+    ScopedThreadCpu thread_cpu("shadowAec");
+    // Background work: the candidate must never compete with the live DSP
+    // and render threads, which is also why the cap is on CPU time
+    SetCurrentThreadPriority(ThreadPriority::kUtility);
+    webrtc::DenormalDisabler denormals;
+
+    // Whatever a previous run left in the rings is not this run's audio
+    Drain(true);
+    start_ns_ = NowNs();
+    cpu_start_ns_ = CurrentThreadCpuNs();
+    tap_open_.store(true, std::memory_order_release);
+
+    bool idle = false;
+    while (running_.load(std::memory_order_acquire)) {
+        // Closed at the cap, nothing notifies; reopening is on the clock
+        wake_.Wait(kPollIntervalNs, [&] { return idle && reopen_ns_ == 0 && records_.AvailableToRead() == 0; });
+        g_wakeups.Count();
+        idle = records_.AvailableToRead() == 0;
+        Drain(false);
+
+        const uint64_t now = NowNs();
+        const uint64_t cpu = CurrentThreadCpuNs() - cpu_start_ns_;
+        {
+            std::lock_guard<std::mutex> lock(report_mutex_);
+            cpu_ns_ = cpu;
+        }
+        if (reopen_ns_ != 0) {
+            if (now < reopen_ns_) {
+                continue;
+            }
+            // The candidate rejoins mid-stream; AEC3 takes the gap like a
+            // render pause
+            reopen_ns_ = 0;
+            tap_open_.store(true, std::memory_order_release);
+            continue;
+        }
+        const double wall = static_cast<double>(now - start_ns_);
+        if (wall > 0.0 && static_cast<double>(cpu) > max_load_ * wall) {
+            // Closed until the time since the start has caught up with the
+            // CPU spent at the cap
+            reopen_ns_ = start_ns_ + static_cast<uint64_t>(static_cast<double>(cpu) / max_load_);
+            tap_open_.store(false, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(report_mutex_);
+            seconds_skipped_ += (reopen_ns_ - now + 500000000) / 1000000000;
+        }
+    }
+    Drain(true);
+}
+
+// Replays the ring into the candidate, or only empties it
+void ShadowAec::Drain(bool discard) {
+    Record record;
+    while (records_.Read(&record, 1) == 1) {
+        const size_t count = static_cast<size_t>(record.num_frames) * record.num_channels;
+        samples_.Read(buffer_.data(), count);
+        if (discard || !shadow_) {
+            continue;
+        }
+        if (record.kind == kRender) {
+            shadow_->ProcessRenderAudio(buffer_.data(), record.num_frames, static_cast<int>(record.num_channels));
+            continue;
+        }
+        if (record.stream_delay_ms >= 0) {
+            shadow_->SetStreamDelayMs(record.stream_delay_ms);
+        }
+        shadow_->ProcessCaptureAudio(buffer_.data(), discard_.data(), count);
+        second_samples_ += count;
+        if (second_samples_ >= static_cast<size_t>(sample_rate_)) {
+            second_samples_ -= static_cast<size_t>(sample_rate_);
+            EndSecond();
+        }
+    }
+}
+
+// A second of capture through the candidate: both instances' statistics,
+// counted toward the means only once both have an ERLE to compare
+void ShadowAec::EndSecond() {
+    const AECMetrics live = live_->GetMetrics();
+    const AECMetrics shadow = shadow_->GetMetrics();
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    ++seconds_processed_;
+    if (!live.echo_return_loss_enhancement || !shadow.echo_return_loss_enhancement) {
+        return;
+    }
+    ++seconds_compared_;
+    Accumulate(live, &live_sums_);
+    Accumulate(shadow, &shadow_sums_);
+}
+
+void ShadowAec::Accumulate(const AECMetrics& metrics, Sums* sums) {
+    sums->erle_db += *metrics.echo_return_loss_enhancement;
+    if (metrics.echo_return_loss) {
+        sums->leakage_db += -(*metrics.echo_return_loss + *metrics.echo_return_loss_enhancement);
+        ++sums->leakage_seconds;
+    }
+    if (metrics.residual_echo_likelihood) {
+        sums->residual += *metrics.residual_echo_likelihood;
+        ++sums->residual_seconds;
+    }
+    if (metrics.aec_converged) {
+        ++sums->converged_seconds;
+    }
+    sums->processing_load = metrics.processing_load;
+    sums->capture_calls = metrics.capture_calls;
+}
+
+ShadowAecSide ShadowAec::Average(const Sums& sums, uint64_t seconds) {
+    ShadowAecSide side;
+    if (seconds > 0) {
+        side.erle_db = static_cast<float>(sums.erle_db / static_cast<double>(seconds));
+        side.converged_fraction = static_cast<float>(sums.converged_seconds) / static_cast<float>(seconds);
+    }
+    if (sums.leakage_seconds > 0) {
+        side.leakage_db = static_cast<float>(sums.leakage_db / static_cast<double>(sums.leakage_seconds));
+    }
+    if (sums.residual_seconds > 0) {
+        side.residual_echo_likelihood = static_cast<float>(sums.residual / static_cast<double>(sums.residual_seconds));
+    }
+    side.processing_load = sums.processing_load;
+    side.capture_calls = sums.capture_calls;
+    return side;
+}
+
+ShadowAecComparison ShadowAec::GetComparison() const {
+    ShadowAecComparison result;
+    result.running = IsRunning();
+    result.max_load = max_load_;
+    result.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(report_mutex_);
+    result.candidate = candidate_;
+    result.seconds_processed = seconds_processed_;
+    result.seconds_compared = seconds_compared_;
+    result.seconds_skipped = seconds_skipped_;
+    if (seconds_processed_ > 0 && sample_rate_ > 0) {
+        result.cpu_load = static_cast<float>(static_cast<double>(cpu_ns_) / (seconds_processed_ * 1e9));
+    }
+    result.live = Average(live_sums_, seconds_compared_);
+    result.shadow = Average(shadow_sums_, seconds_compared_);
+    return result;
+}
+
+} // namespace kakarot
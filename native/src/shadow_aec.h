@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "aec_processor.h"
+#include "platform_thread.h"
+#include "spsc_ring_buffer.h"
+
+namespace kakarot {
+
+// One instance's side of a shadow comparison, averaged over the seconds
+// compared. Means the APM never reported are unset.
+struct ShadowAecSide {
+    std::optional<float> erle_db;                   // echo return loss enhancement
+    std::optional<float> leakage_db;                // -(ERL + ERLE): echo left in the output
+    std::optional<float> residual_echo_likelihood;
+    float converged_fraction = 0.0f;
+    float processing_load = 0.0f;                   // APM wall time / audio time, as the instance measures it
+    AECCallStats capture_calls;                     // at the last second compared
+};
+
+struct ShadowAecComparison {
+    bool running = false;
+    AECConfig candidate;
+    float max_load = 0.0f;
+    uint64_t seconds_processed = 0;  // of capture through the candidate
+    uint64_t seconds_compared = 0;   // with ERLE from both instances
+    uint64_t seconds_skipped = 0;    // tap closed by the CPU cap
+    uint64_t frames_dropped = 0;     // capture and render frames the full ring turned away
+    float cpu_load = 0.0f;           // the shadow thread's CPU time over the audio it processed
+    ShadowAecSide live;
+    ShadowAecSide shadow;
+};
+
+// A candidate AECProcessor run on the live pipeline's own frames, off the
+// audio path, to compare tunings before rolling them out. The DSP thread
+// taps drift-corrected render and unprocessed capture into one ordered ring
+// (memcpy and publish, dropped when full); a utility-priority thread
+// replays them into the candidate with the live stream delay, discards its
+// output and, once a second of capture, reads both instances' statistics.
+// When the thread's CPU time passes |max_load| of the wall time since the
+// start, the tap closes until it is back under, for both streams at once,
+// so the candidate sees a pause rather than misaligned audio.
+class ShadowAec {
+public:
+    ShadowAec(size_t ring_samples, size_t ring_records);
+    ~ShadowAec();
+
+    ShadowAec(const ShadowAec&) = delete;
+    ShadowAec& operator=(const ShadowAec&) = delete;
+
+    // JS thread. |live| must outlive Stop(). The candidate is built for the
+    // live stream's |sample_rate| and render layout, without the CPU
+    // governor (its wall-time budget means nothing at utility priority).
+    // Replaces the previous comparison. False with |error| when it cannot run.
+    bool Start(const AECProcessor* live, const AECConfig& candidate, int sample_rate, int render_channels,
+               float max_load, std::string* error);
+    void Stop();
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // DSP thread, in the order the live instance saw them. |stream_delay_ms|
+    // is the delay the live APM was given, or -1 while unmeasured.
+    void TapRender(const float* data, size_t num_frames, uint32_t num_channels);
+    void TapCapture(const float* data, size_t num_samples, int stream_delay_ms);
+
+    // Any thread; what the last run found once it is stopped
+    ShadowAecComparison GetComparison() const;
+
+private:
+    enum RecordKind : uint32_t { kRender, kCapture };
+    struct Record {
+        uint32_t kind;
+        uint32_t num_frames;
+        uint32_t num_channels;
+        int32_t stream_delay_ms;
+    };
+    // Running sums for one side
+    struct Sums {
+        double erle_db = 0.0;
+        double leakage_db = 0.0;
+        double residual = 0.0;
+        uint64_t leakage_seconds = 0;
+        uint64_t residual_seconds = 0;
+        uint64_t converged_seconds = 0;
+        float processing_load = 0.0f;
+        AECCallStats capture_calls;
+    };
+
+    void Loop();
+    void Drain(bool discard);
+    void EndSecond();
+    static void Accumulate(const AECMetrics& metrics, Sums* sums);
+    static ShadowAecSide Average(const Sums& sums, uint64_t seconds);
+
+    SpscRingBuffer<float> samples_;
+    SpscRingBuffer<Record> records_;
+    std::atomic<bool> tap_open_{false};
+    std::atomic<uint64_t> frames_dropped_{0};
+    std::atomic<bool> running_{false};
+    IdleSignal wake_;
+    std::thread thread_;
+
+    const AECProcessor* live_ = nullptr;
+    std::unique_ptr<AECProcessor> shadow_;
+    float max_load_ = 0.0f;
+    int sample_rate_ = 0;
+
+    // Shadow thread only
+    std::vector<float> buffer_;
+    std::vector<float> discard_;
+    size_t second_samples_ = 0;
+    uint64_t start_ns_ = 0;
+    uint64_t cpu_start_ns_ = 0;
+    uint64_t reopen_ns_ = 0;  // while the cap holds the tap closed
+
+    mutable std::mutex report_mutex_;
+    AECConfig candidate_;
+    uint64_t seconds_processed_ = 0;
+    uint64_t seconds_compared_ = 0;
+    uint64_t seconds_skipped_ = 0;
+    uint64_t cpu_ns_ = 0;
+    Sums live_sums_;
+    Sums shadow_sums_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,165 @@
+#include "shared_memory.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kakarot {
+
+static bool ValidName(const std::string& name) {
+    if (name.empty() || name.size() > 30) {
+        return false;
+    }
+    for (char c : name) {
+        if (c == '/' || c == '\\' || c < 0x21 || c > 0x7e) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if defined(_WIN32)
+static std::wstring MappingName(const std::string& name) {
+    return L"Local\\" + std::wstring(name.begin(), name.end());
+}
+
+std::shared_ptr<SharedMemory> SharedMemory::Create(const std::string& name, size_t bytes, std::string* error) {
+    if (!ValidName(name) || bytes == 0) {
+        *error = "invalid shared memory name or size";
+        return nullptr;
+    }
+    std::shared_ptr<SharedMemory> region(new SharedMemory());
+    const uint64_t size = bytes;
+    region->mapping_ = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                          static_cast<DWORD>(size >> 32), static_cast<DWORD>(size),
+                                          MappingName(name).c_str());
+    if (!region->mapping_) {
+        *error = "cannot create shared memory " + name;
+        return nullptr;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Another live holder has the name: a stale one would be gone with its process
+        *error = "shared memory " + name + " is in use";
+        return nullptr;
+    }
+    region->data_ = static_cast<uint8_t*>(MapViewOfFile(region->mapping_, FILE_MAP_ALL_ACCESS, 0, 0, bytes));
+    if (!region->data_) {
+        *error = "cannot map shared memory " + name;
+        return nullptr;
+    }
+    region->name_ = name;
+    region->owner_ = true;
+    region->size_ = bytes;
+    return region;
+}
+
+std::shared_ptr<SharedMemory> SharedMemory::Open(const std::string& name, std::string* error) {
+    if (!ValidName(name)) {
+        *error = "invalid shared memory name";
+        return nullptr;
+    }
+    std::shared_ptr<SharedMemory> region(new SharedMemory());
+    region->mapping_ = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, MappingName(name).c_str());
+    if (!region->mapping_) {
+        *error = "no shared memory " + name;
+        return nullptr;
+    }
+    region->data_ = static_cast<uint8_t*>(MapViewOfFile(region->mapping_, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+    MEMORY_BASIC_INFORMATION info;
+    if (!region->data_ || VirtualQuery(region->data_, &info, sizeof(info)) == 0) {
+        *error = "cannot map shared memory " + name;
+        return nullptr;
+    }
+    region->name_ = name;
+    region->size_ = info.RegionSize;
+    return region;
+}
+
+SharedMemory::~SharedMemory() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+}
+#else
+std::shared_ptr<SharedMemory> SharedMemory::Create(const std::string& name, size_t bytes, std::string* error) {
+    if (!ValidName(name) || bytes == 0) {
+        *error = "invalid shared memory name or size";
+        return nullptr;
+    }
+    const std::string path = "/" + name;
+    // A crashed engine leaves its name behind; nobody maps it any more
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        *error = "cannot create shared memory " + name;
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        close(fd);
+        shm_unlink(path.c_str());
+        *error = "cannot size shared memory " + name;
+        return nullptr;
+    }
+    void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        *error = "cannot map shared memory " + name;
+        return nullptr;
+    }
+    std::shared_ptr<SharedMemory> region(new SharedMemory());
+    region->name_ = name;
+    region->owner_ = true;
+    region->data_ = static_cast<uint8_t*>(data);
+    region->size_ = bytes;
+    return region;
+}
+
+std::shared_ptr<SharedMemory> SharedMemory::Open(const std::string& name, std::string* error) {
+    if (!ValidName(name)) {
+        *error = "invalid shared memory name";
+        return nullptr;
+    }
+    int fd = shm_open(("/" + name).c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        *error = "no shared memory " + name;
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        *error = "cannot stat shared memory " + name;
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        *error = "cannot map shared memory " + name;
+        return nullptr;
+    }
+    std::shared_ptr<SharedMemory> region(new SharedMemory());
+    region->name_ = name;
+    region->data_ = static_cast<uint8_t*>(data);
+    region->size_ = size;
+    return region;
+}
+
+SharedMemory::~SharedMemory() {
+    if (data_) {
+        munmap(data_, size_);
+    }
+    if (owner_) {
+        shm_unlink(("/" + name_).c_str());
+    }
+}
+#endif
+
+} // namespace kakarot
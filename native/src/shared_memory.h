@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace kakarot {
+
+// A named region of OS shared memory (POSIX shm, a Windows pagefile-backed
+// mapping) that two processes map alike: the audio engine process and the
+// app it delivers to. The creator's name goes away with it; a region opened
+// by name stays mapped until the last holder lets go.
+class SharedMemory {
+public:
+    // Null with |error| when the region cannot be made or mapped. Create()
+    // replaces a stale region of the same name; names are short ASCII
+    // (31 bytes on macOS) without slashes.
+    static std::shared_ptr<SharedMemory> Create(const std::string& name, size_t bytes, std::string* error);
+    static std::shared_ptr<SharedMemory> Open(const std::string& name, std::string* error);
+
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    uint8_t* Data() const { return data_; }
+    size_t Size() const { return size_; }
+    const std::string& Name() const { return name_; }
+
+private:
+    SharedMemory() = default;
+
+    std::string name_;
+    bool owner_ = false;
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    void* mapping_ = nullptr;
+#endif
+};
+
+} // namespace kakarot
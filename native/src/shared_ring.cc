@@ -0,0 +1,334 @@
+#include "shared_ring.h"
+#include "native_log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+namespace kakarot {
+
+static const char* const kLogSource = "SharedRing";
+
+static_assert(sizeof(std::atomic<int32_t>) == 4 && std::atomic<int32_t>::is_always_lock_free,
+              "control words are shared with JS Atomics");
+
+// One for every ring: commits are at most one per delivery, so waking all
+// waiters to recheck their own word costs nothing worth a table
+static std::mutex g_wait_mutex;
+static std::condition_variable g_wait_cv;
+
+static void NotifyWaiters() {
+    { std::lock_guard<std::mutex> lock(g_wait_mutex); }
+    g_wait_cv.notify_all();
+}
+
+// Shared memory rings: the bounds createSharedCaptureRing() leaves to JS
+static constexpr double kMaxRingSeconds = 30.0;
+static constexpr double kMaxRingFrames = 4096.0;
+
+static size_t RingBytes(uint32_t sample_capacity, uint32_t frame_capacity, int32_t format) {
+    return kSharedRingHeaderBytes + size_t{frame_capacity} * kSharedRingFrameBytes +
+           size_t{sample_capacity} * (format == 1 ? 2 : 4);
+}
+
+std::shared_ptr<SharedRingWriter> SharedRingWriter::FromValue(const Napi::Value& value) {
+    if (value.IsObject() && !value.IsTypedArray() && value.As<Napi::Object>().Get("name").IsString()) {
+        return FromOptions(value.As<Napi::Object>());
+    }
+    if (!value.IsTypedArray() || value.As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+        Log(LogLevel::kWarn, kLogSource, "sharedRing must be a Uint8Array over the ring; delivering by callback");
+        return nullptr;
+    }
+    Napi::Uint8Array view = value.As<Napi::Uint8Array>();
+    std::shared_ptr<SharedRingWriter> writer(new SharedRingWriter());
+    if (!writer->Attach(view.Data(), view.ByteLength())) {
+        return nullptr;
+    }
+    writer->view_ = Napi::Persistent(view);
+    return writer;
+}
+
+// { name, sampleRate, seconds = 2, format = 'float32', frames = 256 }, as
+// createSharedCaptureRing() lays a SharedArrayBuffer out
+std::shared_ptr<SharedRingWriter> SharedRingWriter::FromOptions(const Napi::Object& options) {
+    auto number = [&](const char* key, double fallback, double lo, double hi) {
+        if (!options.Has(key) || !options.Get(key).IsNumber()) {
+            return fallback;
+        }
+        return std::max(lo, std::min(options.Get(key).As<Napi::Number>().DoubleValue(), hi));
+    };
+    const std::string name = options.Get("name").As<Napi::String>().Utf8Value();
+    const double sample_rate = number("sampleRate", 0.0, 0.0, 384000.0);
+    if (sample_rate <= 0.0) {
+        Log(LogLevel::kWarn, kLogSource, "sharedRing %s needs a sampleRate; delivering by callback", name.c_str());
+        return nullptr;
+    }
+    const uint32_t sample_capacity = static_cast<uint32_t>(
+        std::max(1.0, std::ceil(sample_rate * number("seconds", 2.0, 0.01, kMaxRingSeconds))));
+    const uint32_t frame_capacity = static_cast<uint32_t>(number("frames", 256.0, 1.0, kMaxRingFrames));
+    const int32_t format =
+        options.Get("format").IsString() && options.Get("format").As<Napi::String>().Utf8Value() == "pcm16" ? 1 : 0;
+
+    std::string error;
+    std::shared_ptr<SharedMemory> region =
+        SharedMemory::Create(name, RingBytes(sample_capacity, frame_capacity, format), &error);
+    if (!region) {
+        Log(LogLevel::kWarn, kLogSource, "sharedRing unavailable (%s); delivering by callback", error.c_str());
+        return nullptr;
+    }
+    auto field = [&](SharedRingField index) -> std::atomic<int32_t>& {
+        return *reinterpret_cast<std::atomic<int32_t>*>(region->Data() + index * 4);
+    };
+    field(kSharedRingSampleCapacity).store(static_cast<int32_t>(sample_capacity), std::memory_order_relaxed);
+    field(kSharedRingFrameCapacity).store(static_cast<int32_t>(frame_capacity), std::memory_order_relaxed);
+    field(kSharedRingFormat).store(format, std::memory_order_relaxed);
+    field(kSharedRingVersion).store(kSharedRingVersionValue, std::memory_order_relaxed);
+    field(kSharedRingMagic).store(kSharedRingMagicValue, std::memory_order_release);
+
+    std::shared_ptr<SharedRingWriter> writer(new SharedRingWriter());
+    if (!writer->Attach(region->Data(), region->Size())) {
+        return nullptr;
+    }
+    writer->region_ = std::move(region);
+    return writer;
+}
+
+bool SharedRingWriter::Attach(uint8_t* data, size_t bytes) {
+    data_ = data;
+    if (bytes < kSharedRingHeaderBytes || reinterpret_cast<uintptr_t>(data_) % 8 != 0 ||
+        Field(kSharedRingMagic).load() != kSharedRingMagicValue ||
+        Field(kSharedRingVersion).load() != kSharedRingVersionValue) {
+        Log(LogLevel::kWarn, kLogSource, "sharedRing was not made by createSharedCaptureRing; delivering by callback");
+        return false;
+    }
+    sample_capacity_ = static_cast<uint32_t>(Field(kSharedRingSampleCapacity).load());
+    frame_capacity_ = static_cast<uint32_t>(Field(kSharedRingFrameCapacity).load());
+    format_ = Field(kSharedRingFormat).load();
+    if (sample_capacity_ == 0 || frame_capacity_ == 0 || (format_ != 0 && format_ != 1) ||
+        RingBytes(sample_capacity_, frame_capacity_, format_) > bytes) {
+        Log(LogLevel::kWarn, kLogSource, "sharedRing header does not match its %zu bytes; delivering by callback", bytes);
+        return false;
+    }
+    return true;
+}
+
+std::atomic<int32_t>& SharedRingWriter::Field(SharedRingField field) const {
+    return *reinterpret_cast<std::atomic<int32_t>*>(data_ + field * 4);
+}
+
+void SharedRingWriter::Begin(int sample_rate) {
+    Field(kSharedRingSampleRate).store(sample_rate, std::memory_order_relaxed);
+    Field(kSharedRingSampleWrite).store(0, std::memory_order_relaxed);
+    Field(kSharedRingSampleRead).store(0, std::memory_order_relaxed);
+    Field(kSharedRingFrameWrite).store(0, std::memory_order_relaxed);
+    Field(kSharedRingFrameRead).store(0, std::memory_order_relaxed);
+    Field(kSharedRingDropped).store(0, std::memory_order_relaxed);
+    Field(kSharedRingState).store(1, std::memory_order_release);
+    NotifyWaiters();
+}
+
+void SharedRingWriter::End() {
+    Field(kSharedRingState).store(0, std::memory_order_release);
+    NotifyWaiters();
+}
+
+bool SharedRingWriter::Reserve(size_t num_samples, uint8_t** first, size_t* first_samples, uint8_t** second) {
+    const uint32_t sample_write = static_cast<uint32_t>(Field(kSharedRingSampleWrite).load(std::memory_order_relaxed));
+    const uint32_t sample_read = static_cast<uint32_t>(Field(kSharedRingSampleRead).load(std::memory_order_acquire));
+    const uint32_t frame_write = static_cast<uint32_t>(Field(kSharedRingFrameWrite).load(std::memory_order_relaxed));
+    const uint32_t frame_read = static_cast<uint32_t>(Field(kSharedRingFrameRead).load(std::memory_order_acquire));
+    if (sample_capacity_ - (sample_write - sample_read) < num_samples || frame_write - frame_read >= frame_capacity_) {
+        Field(kSharedRingDropped).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    uint8_t* samples = data_ + kSharedRingHeaderBytes + size_t{frame_capacity_} * kSharedRingFrameBytes;
+    const size_t slot = sample_write % sample_capacity_;
+    *first = samples + slot * SampleBytes();
+    *first_samples = std::min<size_t>(num_samples, sample_capacity_ - slot);
+    *second = samples;
+    return true;
+}
+
+void SharedRingWriter::Commit(size_t num_samples, const SharedRingFrame& frame) {
+    const uint32_t sample_write = static_cast<uint32_t>(Field(kSharedRingSampleWrite).load(std::memory_order_relaxed));
+    const uint32_t frame_write = static_cast<uint32_t>(Field(kSharedRingFrameWrite).load(std::memory_order_relaxed));
+    uint8_t* entry = data_ + kSharedRingHeaderBytes + size_t{frame_write % frame_capacity_} * kSharedRingFrameBytes;
+    std::memcpy(entry, &frame, sizeof(frame));
+    const uint32_t count = static_cast<uint32_t>(num_samples);
+    std::memcpy(entry + 32, &sample_write, 4);
+    std::memcpy(entry + 36, &count, 4);
+    Field(kSharedRingSampleWrite).store(static_cast<int32_t>(sample_write + count), std::memory_order_release);
+    Field(kSharedRingFrameWrite).store(static_cast<int32_t>(frame_write + 1), std::memory_order_release);
+    NotifyWaiters();
+}
+
+Napi::Value WaitSharedRing(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 3 || !info[0].IsTypedArray() ||
+        info[0].As<Napi::TypedArray>().TypedArrayType() != napi_int32_array || !info[1].IsNumber() ||
+        !info[2].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (Int32Array, index, value, timeoutMs?)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Int32Array control = info[0].As<Napi::Int32Array>();
+    int64_t index = info[1].As<Napi::Number>().Int64Value();
+    if (index < 0 || static_cast<size_t>(index) >= control.ElementLength()) {
+        Napi::RangeError::New(env, "index out of range").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    const int32_t value = info[2].As<Napi::Number>().Int32Value();
+    double timeout_ms = info.Length() > 3 && info[3].IsNumber() ? info[3].As<Napi::Number>().DoubleValue() : INFINITY;
+    std::atomic<int32_t>& word = *reinterpret_cast<std::atomic<int32_t>*>(control.Data() + index);
+
+    std::unique_lock<std::mutex> lock(g_wait_mutex);
+    if (word.load(std::memory_order_acquire) != value) {
+        return Napi::String::New(env, "not-equal");
+    }
+    if (std::isfinite(timeout_ms)) {
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::microseconds(static_cast<int64_t>(std::max(0.0, timeout_ms) * 1000.0));
+        if (!g_wait_cv.wait_until(lock, deadline, [&] { return word.load(std::memory_order_acquire) != value; })) {
+            return Napi::String::New(env, "timed-out");
+        }
+    } else {
+        g_wait_cv.wait(lock, [&] { return word.load(std::memory_order_acquire) != value; });
+    }
+    return Napi::String::New(env, "ok");
+}
+
+namespace {
+
+class SharedMemoryRingWrap : public Napi::ObjectWrap<SharedMemoryRingWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "SharedMemoryRing", {
+            InstanceMethod("read", &SharedMemoryRingWrap::Read),
+            InstanceMethod("isOpen", &SharedMemoryRingWrap::IsOpen),
+            InstanceMethod("sampleRate", &SharedMemoryRingWrap::SampleRate),
+            InstanceMethod("dropped", &SharedMemoryRingWrap::Dropped),
+            InstanceMethod("close", &SharedMemoryRingWrap::Close),
+        });
+    }
+
+    explicit SharedMemoryRingWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<SharedMemoryRingWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a shared memory ring name").ThrowAsJavaScriptException();
+            return;
+        }
+        std::string error;
+        region_ = SharedMemory::Open(info[0].As<Napi::String>().Utf8Value(), &error);
+        if (!region_) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+        if (region_->Size() < kSharedRingHeaderBytes || Field(kSharedRingMagic).load() != kSharedRingMagicValue ||
+            Field(kSharedRingVersion).load() != kSharedRingVersionValue) {
+            region_.reset();
+            Napi::Error::New(env, "Not a shared capture ring").ThrowAsJavaScriptException();
+            return;
+        }
+        sample_capacity_ = static_cast<uint32_t>(Field(kSharedRingSampleCapacity).load());
+        frame_capacity_ = static_cast<uint32_t>(Field(kSharedRingFrameCapacity).load());
+        format_ = Field(kSharedRingFormat).load();
+        if (sample_capacity_ == 0 || frame_capacity_ == 0 || RingBytes(sample_capacity_, frame_capacity_, format_) >
+                                                                 region_->Size()) {
+            region_.reset();
+            Napi::Error::New(env, "Shared capture ring header does not match its size").ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    std::atomic<int32_t>& Field(SharedRingField field) const {
+        return *reinterpret_cast<std::atomic<int32_t>*>(region_->Data() + field * 4);
+    }
+
+    Napi::Value Read(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsFunction()) {
+            Napi::TypeError::New(env, "Expected a handler function").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (!region_) {
+            return Napi::Number::New(env, 0);
+        }
+        Napi::Function handler = info[0].As<Napi::Function>();
+        const size_t sample_bytes = format_ == 1 ? 2 : 4;
+        const uint8_t* frames = region_->Data() + kSharedRingHeaderBytes;
+        const uint8_t* samples = frames + size_t{frame_capacity_} * kSharedRingFrameBytes;
+        const uint32_t frame_write = static_cast<uint32_t>(Field(kSharedRingFrameWrite).load(std::memory_order_acquire));
+        uint32_t frame_read = static_cast<uint32_t>(Field(kSharedRingFrameRead).load(std::memory_order_relaxed));
+        uint32_t count = 0;
+        while (frame_read != frame_write) {
+            const uint8_t* entry = frames + size_t{frame_read % frame_capacity_} * kSharedRingFrameBytes;
+            SharedRingFrame frame;
+            uint32_t position = 0;
+            uint32_t length = 0;
+            std::memcpy(&frame, entry, sizeof(frame));
+            std::memcpy(&position, entry + 32, 4);
+            std::memcpy(&length, entry + 36, 4);
+            length = std::min(length, sample_capacity_);
+
+            // Copied out: the slots are the writer's again once read
+            Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, size_t{length} * sample_bytes);
+            uint8_t* out = static_cast<uint8_t*>(buffer.Data());
+            const size_t slot = position % sample_capacity_;
+            const size_t head = std::min<size_t>(length, sample_capacity_ - slot);
+            std::memcpy(out, samples + slot * sample_bytes, head * sample_bytes);
+            std::memcpy(out + head * sample_bytes, samples, (length - head) * sample_bytes);
+            frame_read += 1;
+            Field(kSharedRingSampleRead).store(static_cast<int32_t>(position + length), std::memory_order_release);
+            Field(kSharedRingFrameRead).store(static_cast<int32_t>(frame_read), std::memory_order_release);
+
+            Napi::Object delivery = Napi::Object::New(env);
+            if (format_ == 1) {
+                delivery.Set("samples", Napi::Int16Array::New(env, length, buffer, 0));
+            } else {
+                delivery.Set("samples", Napi::Float32Array::New(env, length, buffer, 0));
+            }
+            delivery.Set("timestamp", Napi::Number::New(env, frame.timestamp));
+            delivery.Set("hostTimeMs", Napi::Number::New(env, frame.host_time_ms));
+            delivery.Set("sampleIndex", Napi::Number::New(env, frame.sample_index));
+            delivery.Set("silenceMs", Napi::Number::New(env, frame.silence_ms));
+            handler.Call({ delivery });
+            ++count;
+            if (env.IsExceptionPending()) {
+                break;
+            }
+        }
+        return Napi::Number::New(env, count);
+    }
+
+    Napi::Value IsOpen(const Napi::CallbackInfo& info) {
+        return Napi::Boolean::New(info.Env(), region_ && Field(kSharedRingState).load(std::memory_order_acquire) == 1);
+    }
+
+    Napi::Value SampleRate(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), region_ ? Field(kSharedRingSampleRate).load(std::memory_order_relaxed) : 0);
+    }
+
+    Napi::Value Dropped(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(
+            info.Env(), region_ ? static_cast<uint32_t>(Field(kSharedRingDropped).load(std::memory_order_relaxed)) : 0);
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        region_.reset();
+        return info.Env().Undefined();
+    }
+
+    std::shared_ptr<SharedMemory> region_;
+    uint32_t sample_capacity_ = 0;
+    uint32_t frame_capacity_ = 0;
+    int32_t format_ = 0;
+};
+
+} // namespace
+
+Napi::Function DefineSharedMemoryRing(Napi::Env env) {
+    return SharedMemoryRingWrap::Define(env);
+}
+
+} // namespace kakarot
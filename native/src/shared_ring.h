@@ -0,0 +1,112 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "shared_memory.h"
+
+namespace kakarot {
+
+// A SharedArrayBuffer a capture stream writes its deliveries into instead
+// of calling back, for a worker to read on its own schedule. JS lays it out
+// (createSharedCaptureRing) as
+//
+//   control  16 x i32, read with Atomics; the SharedRingField indices
+//   frames   kFrameCapacity entries of kSharedRingFrameBytes: f64 timestamp
+//            (Date.now() domain), f64 hostTimeMs, f64 sampleIndex, f64
+//            silenceMs, u32 sample position, u32 sample count
+//   samples  kSampleCapacity float32 or int16 samples
+//
+// Sample and frame positions are free-running u32 counters; a slot is the
+// position modulo its capacity. The stream writes a delivery's samples and
+// entry, then publishes kSampleWrite and kFrameWrite; the reader advances
+// kSampleRead and kFrameRead once done with them. A delivery that does not
+// fit is dropped whole and counted in kDropped.
+//
+// The same layout in named shared memory carries deliveries out of the
+// audio engine process: the stream makes the region from { name,
+// sampleRate, seconds?, format?, frames? } and the app maps it with
+// SharedMemoryRing. Native waits never cross processes, so that side polls.
+enum SharedRingField : size_t {
+    kSharedRingMagic,
+    kSharedRingVersion,
+    kSharedRingSampleCapacity,
+    kSharedRingFrameCapacity,
+    kSharedRingFormat,        // 0 float32, 1 int16
+    kSharedRingSampleRate,
+    kSharedRingSampleWrite,
+    kSharedRingSampleRead,
+    kSharedRingFrameWrite,
+    kSharedRingFrameRead,
+    kSharedRingDropped,
+    kSharedRingState,         // 1 while a stream writes, 0 once it closed
+    kSharedRingFieldCount = 16,
+};
+constexpr int32_t kSharedRingMagicValue = 0x52534b4b;  // "KKSR"
+constexpr int32_t kSharedRingVersionValue = 1;
+constexpr size_t kSharedRingHeaderBytes = kSharedRingFieldCount * 4;
+constexpr size_t kSharedRingFrameBytes = 40;
+
+struct SharedRingFrame {
+    double timestamp;
+    double host_time_ms;
+    double sample_index;
+    double silence_ms;
+};
+
+// The stream's side: a reference keeps the JS memory alive, released on
+// the JS thread with the options that carry it (or the shared memory, which
+// goes with the writer)
+class SharedRingWriter {
+public:
+    // |value| is a Uint8Array over the ring, or the shared memory ring's
+    // options. Null, with a warning logged, when it is neither or its header
+    // does not match its size; the stream then delivers by callback as usual.
+    static std::shared_ptr<SharedRingWriter> FromValue(const Napi::Value& value);
+
+    // JS thread, at Open()/Close(): claims the ring for a stream at
+    // |sample_rate| (resetting every position) and hands it back
+    void Begin(int sample_rate);
+    void End();
+
+    // Consumer thread. The slots of the next |num_samples|, in up to two
+    // pieces at the wrap; false (and a drop counted) when they are not free.
+    bool Reserve(size_t num_samples, uint8_t** first, size_t* first_samples, uint8_t** second);
+
+    // Consumer thread. Publishes the reserved samples with their entry and
+    // wakes waitSharedRing() callers.
+    void Commit(size_t num_samples, const SharedRingFrame& frame);
+
+    size_t SampleBytes() const { return format_ == 1 ? 2 : 4; }
+
+private:
+    SharedRingWriter() = default;
+
+    static std::shared_ptr<SharedRingWriter> FromOptions(const Napi::Object& options);
+    bool Attach(uint8_t* data, size_t bytes);
+    std::atomic<int32_t>& Field(SharedRingField field) const;
+
+    Napi::Reference<Napi::Uint8Array> view_;
+    std::shared_ptr<SharedMemory> region_;
+    uint8_t* data_ = nullptr;
+    uint32_t sample_capacity_ = 0;
+    uint32_t frame_capacity_ = 0;
+    int32_t format_ = 0;
+};
+
+// waitSharedRing(control: Int32Array, index, value, timeoutMs) -> 'ok' |
+// 'not-equal' | 'timed-out', as Atomics.wait, but woken by the native
+// writer, which Atomics.wait never is (V8 keeps its own waiter lists).
+// Blocks the calling thread: for workers, never the main thread.
+Napi::Value WaitSharedRing(const Napi::CallbackInfo& info);
+
+// new SharedMemoryRing(name): the app's side of a shared memory ring, as
+// SharedCaptureRingReader is of a SharedArrayBuffer one. read(handler)
+// hands over every published delivery { samples (a copy), timestamp,
+// sampleIndex, hostTimeMs, silenceMs } and returns the count; isOpen(),
+// sampleRate(), dropped() and close(). Throws when |name| is not mapped.
+Napi::Function DefineSharedMemoryRing(Napi::Env env);
+
+} // namespace kakarot
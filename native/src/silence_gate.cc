@@ -0,0 +1,93 @@
+#include "silence_gate.h"
+#include <cstring>
+
+namespace kakarot {
+
+SilenceGate::SilenceGate(size_t frame_size, float threshold, size_t hangover_frames, size_t preroll_frames)
+    : frame_size_(frame_size),
+      threshold_(threshold),
+      hangover_frames_(hangover_frames),
+      preroll_frames_(preroll_frames),
+      preroll_(frame_size * preroll_frames),
+      preroll_info_(preroll_frames) {}
+
+size_t SilenceGate::Process(const float* frame, const GateFrameInfo& info,
+                            std::vector<float>* samples, std::vector<GateFrameInfo>* frames) {
+    bool speech = info.probability >= threshold_;
+
+    if (!open_) {
+        if (!speech) {
+            Hold(frame, info);
+            return 0;
+        }
+
+        // Speech onset: replay the pre-roll, oldest first
+        open_ = true;
+        quiet_frames_ = 0;
+        size_t appended = preroll_count_ + 1;
+        for (size_t i = 0; i < preroll_count_; ++i) {
+            size_t slot = (preroll_head_ + i) % preroll_frames_;
+            const float* held = preroll_.data() + slot * frame_size_;
+            samples->insert(samples->end(), held, held + frame_size_);
+            frames->push_back(preroll_info_[slot]);
+        }
+        preroll_head_ = 0;
+        preroll_count_ = 0;
+        samples->insert(samples->end(), frame, frame + frame_size_);
+        frames->push_back(info);
+        return appended;
+    }
+
+    quiet_frames_ = speech ? 0 : quiet_frames_ + 1;
+    if (quiet_frames_ > hangover_frames_) {
+        open_ = false;
+        Hold(frame, info);
+        return 0;
+    }
+
+    samples->insert(samples->end(), frame, frame + frame_size_);
+    frames->push_back(info);
+    return 1;
+}
+
+void SilenceGate::SetLimits(float threshold, size_t hangover_frames) {
+    threshold_ = threshold;
+    hangover_frames_ = hangover_frames;
+}
+
+size_t SilenceGate::TakeSuppressed(GateFrameInfo* first) {
+    size_t count = suppressed_;
+    if (first) {
+        *first = suppressed_first_;
+    }
+    suppressed_ = 0;
+    return count;
+}
+
+// Keeps |frame| for pre-roll; whatever it displaces is dropped for good
+void SilenceGate::Hold(const float* frame, const GateFrameInfo& info) {
+    if (preroll_frames_ == 0) {
+        CountSuppressed(info);
+        return;
+    }
+
+    if (preroll_count_ == preroll_frames_) {
+        CountSuppressed(preroll_info_[preroll_head_]);
+        preroll_head_ = (preroll_head_ + 1) % preroll_frames_;
+        --preroll_count_;
+    }
+
+    size_t slot = (preroll_head_ + preroll_count_) % preroll_frames_;
+    std::memcpy(preroll_.data() + slot * frame_size_, frame, frame_size_ * sizeof(float));
+    preroll_info_[slot] = info;
+    ++preroll_count_;
+}
+
+void SilenceGate::CountSuppressed(const GateFrameInfo& info) {
+    if (suppressed_ == 0) {
+        suppressed_first_ = info;
+    }
+    ++suppressed_;
+}
+
+} // namespace kakarot
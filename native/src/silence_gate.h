@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kakarot {
+
+// One 10ms frame as seen by the gate
+struct GateFrameInfo {
+    uint64_t host_time;      // mach host time of the first sample
+    uint64_t sample_index;   // position in the delivered stream
+    float probability;       // VAD speech probability
+};
+
+// Frame-level speech gate. Opens on the first frame at or above |threshold|,
+// replaying up to |preroll_frames| held frames so word onsets survive, and
+// closes after |hangover_frames| consecutive frames below it. Frames pushed
+// out of the pre-roll while closed are dropped and counted as suppressed.
+class SilenceGate {
+public:
+    SilenceGate(size_t frame_size, float threshold, size_t hangover_frames, size_t preroll_frames);
+
+    // Runs one frame through the gate. When open, the frame (preceded by the
+    // held pre-roll if the gate just opened) is appended to |samples| and
+    // |frames|; returns the number of frames appended, 0 while closed.
+    size_t Process(const float* frame, const GateFrameInfo& info,
+                   std::vector<float>* samples, std::vector<GateFrameInfo>* frames);
+
+    bool IsOpen() const { return open_; }
+
+    // Replaces the threshold and hangover, e.g. tighter while the stream's
+    // transport is congested; an open gate keeps its quiet frames
+    void SetLimits(float threshold, size_t hangover_frames);
+
+    // Frames dropped since the last call; |first| gets the earliest of them
+    size_t SuppressedFrames() const { return suppressed_; }
+    size_t TakeSuppressed(GateFrameInfo* first);
+
+private:
+    void Hold(const float* frame, const GateFrameInfo& info);
+    void CountSuppressed(const GateFrameInfo& info);
+
+    const size_t frame_size_;
+    float threshold_;
+    size_t hangover_frames_;
+    const size_t preroll_frames_;
+
+    bool open_ = false;
+    size_t quiet_frames_ = 0;
+
+    // Pre-roll ring of the most recent closed frames
+    std::vector<float> preroll_;
+    std::vector<GateFrameInfo> preroll_info_;
+    size_t preroll_head_ = 0;   // oldest held frame
+    size_t preroll_count_ = 0;
+
+    size_t suppressed_ = 0;
+    GateFrameInfo suppressed_first_{};
+};
+
+} // namespace kakarot
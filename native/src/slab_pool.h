@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace kakarot {
+
+// Pool of fixed-size float slabs that are lent to JavaScript as external
+// ArrayBuffers. A slab returns to the pool from the ArrayBuffer finalizer, so
+// the steady state reuses the same memory instead of churning V8 external
+// allocations.
+//
+// The pool can outlive its owner: Orphan() is called by the owner on teardown,
+// and the pool deletes itself once the last outstanding slab is released.
+class SlabPool {
+public:
+    SlabPool(size_t slab_samples, size_t initial_slabs)
+        : slab_samples_(slab_samples) {
+        free_.reserve(initial_slabs);
+        for (size_t i = 0; i < initial_slabs; ++i) {
+            free_.push_back(new float[slab_samples_]);
+        }
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    size_t SlabSamples() const { return slab_samples_; }
+
+    // Never called from the real-time thread; may allocate when the pool is
+    // exhausted (JS is holding on to more slabs than we preallocated).
+    float* Acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++outstanding_;
+        if (free_.empty()) {
+            ++grown_;
+            return new float[slab_samples_];
+        }
+        float* slab = free_.back();
+        free_.pop_back();
+        return slab;
+    }
+
+    void Release(float* slab) {
+        bool destroy = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(slab);
+            --outstanding_;
+            destroy = orphaned_ && outstanding_ == 0;
+        }
+        if (destroy) {
+            delete this;
+        }
+    }
+
+    // Owner is going away. Frees the pool now if nothing is on loan.
+    void Orphan() {
+        bool destroy = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            orphaned_ = true;
+            destroy = outstanding_ == 0;
+        }
+        if (destroy) {
+            delete this;
+        }
+    }
+
+    size_t Outstanding() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return outstanding_;
+    }
+
+    size_t GrowCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return grown_;
+    }
+
+    // Frees idle slabs beyond |keep|; Acquire() grows the pool back as needed
+    void Trim(size_t keep) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (free_.size() > keep) {
+            delete[] free_.back();
+            free_.pop_back();
+        }
+    }
+
+    // Allocates idle slabs up to |idle|, e.g. once memory pressure clears
+    void Fill(size_t idle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (free_.size() < idle) {
+            free_.push_back(new float[slab_samples_]);
+        }
+    }
+
+    // Idle and on loan
+    size_t Bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return (free_.size() + outstanding_) * slab_samples_ * sizeof(float);
+    }
+
+private:
+    ~SlabPool() {
+        for (float* slab : free_) {
+            delete[] slab;
+        }
+    }
+
+    const size_t slab_samples_;
+    mutable std::mutex mutex_;
+    std::vector<float*> free_;
+    size_t outstanding_ = 0;
+    size_t grown_ = 0;
+    bool orphaned_ = false;
+};
+
+} // namespace kakarot
@@ -0,0 +1,304 @@
+#include "speaker_tracker.h"
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace kakarot {
+
+// Frames per decision
+static constexpr size_t kFramesPerSecond = 100;
+
+// Mel filterbank over the voice band, and the cepstral coefficients kept
+// (c0, the level, is dropped)
+static constexpr int kMelBands = 24;
+static constexpr int kCepstra = 12;
+static constexpr float kBandHz[2] = {100.0f, 7600.0f};
+
+// A frame is speech when the VAD says so and it is louder than -60dBFS; a
+// second needs this many of them to be matched
+static constexpr float kSpeechProbability = 0.6f;
+static constexpr float kMinFramePower = 1e-6f;
+static constexpr size_t kMinSpeechFrames = 30;
+
+// Cepstral variance floor, so a steady second cannot look infinitely sure
+static constexpr double kMinVariance = 0.01;
+
+// A model's variances lean on the stream's as if it had seen this many more
+// frames (2s of speech), so a speaker heard for a second does not expect every
+// next second to sound exactly like it
+static constexpr double kPriorFrames = 200.0;
+
+// Seconds are matched by mean KL divergence per coefficient from each
+// speaker. The current speaker keeps a second unless another is nearer by
+// kSwitchMargin, so one ambiguous second does not flip the ID; a second
+// further than kNewSpeakerDivergence from every speaker is a candidate, and
+// kNewSpeakerSeconds of them in a row, still that far together, become a
+// new speaker.
+static constexpr double kSwitchMargin = 0.3;
+static constexpr double kNewSpeakerDivergence = 0.5;
+static constexpr int kNewSpeakerSeconds = 2;
+
+// Until the nearest speaker has this much speech (3s) its model is too rough
+// to tell anyone from it, and every second joins it
+static constexpr double kMatureFrames = 300.0;
+
+// Speaker models hold at most this many frames' weight (about a minute of
+// speech), so they follow a voice as the meeting and the codec drift
+static constexpr double kSpeakerFrames = 6000.0;
+
+static size_t FftSizeFor(size_t frame_size) {
+    size_t size = 128;
+    while (size < frame_size) {
+        size *= 2;
+    }
+    return size;
+}
+
+static double HzToMel(double hz) {
+    return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+static double MelToHz(double mel) {
+    return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+}
+
+bool SpeakerTracker::Supports(int sample_rate) {
+    return sample_rate >= 8000 && sample_rate <= 48000 && sample_rate % 100 == 0;
+}
+
+SpeakerTracker::SpeakerTracker(int sample_rate)
+    : frame_size_(static_cast<size_t>(sample_rate / 100)),
+      fft_size_(FftSizeFor(frame_size_)),
+      fft_(std::make_unique<webrtc::Pffft>(fft_size_, webrtc::Pffft::FftType::kReal)),
+      fft_in_(fft_->CreateBuffer()),
+      fft_out_(fft_->CreateBuffer()),
+      window_(frame_size_),
+      power_(fft_size_ / 2 + 1, 0.0f),
+      band_energies_(kMelBands),
+      frame_(frame_size_, 0.0f) {
+    const double pi = std::acos(-1.0);
+    for (size_t i = 0; i < frame_size_; ++i) {
+        window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * (i + 0.5) / frame_size_));
+    }
+
+    // Triangles on the mel scale, up to Nyquist when it is below the band's top
+    const size_t bins = fft_size_ / 2 + 1;
+    const double top = std::min<double>(kBandHz[1], 0.5 * sample_rate);
+    const double low_mel = HzToMel(kBandHz[0]);
+    const double step = (HzToMel(top) - low_mel) / (kMelBands + 1);
+    mel_.assign(static_cast<size_t>(kMelBands) * bins, 0.0f);
+    for (int b = 0; b < kMelBands; ++b) {
+        const double left = MelToHz(low_mel + b * step);
+        const double center = MelToHz(low_mel + (b + 1) * step);
+        const double right = MelToHz(low_mel + (b + 2) * step);
+        for (size_t k = 0; k < bins; ++k) {
+            const double hz = static_cast<double>(k) * sample_rate / fft_size_;
+            double weight = 0.0;
+            if (hz > left && hz <= center) {
+                weight = (hz - left) / (center - left);
+            } else if (hz > center && hz < right) {
+                weight = (right - hz) / (right - center);
+            }
+            mel_[b * bins + k] = static_cast<float>(weight);
+        }
+    }
+
+    dct_.resize(static_cast<size_t>(kCepstra) * kMelBands);
+    for (int c = 0; c < kCepstra; ++c) {
+        for (int b = 0; b < kMelBands; ++b) {
+            dct_[c * kMelBands + b] = static_cast<float>(
+                std::sqrt(2.0 / kMelBands) * std::cos(pi * (c + 1) * (b + 0.5) / kMelBands));
+        }
+    }
+    second_.Clear();
+    candidate_.Clear();
+    stream_.Clear();
+    speakers_.reserve(kMaxSpeakers);
+}
+
+SpeakerTracker::~SpeakerTracker() = default;
+
+void SpeakerTracker::Gaussian::Clear() {
+    weight = 0.0;
+    sum.assign(kCepstra, 0.0);
+    sum_squares.assign(kCepstra, 0.0);
+}
+
+void SpeakerTracker::Gaussian::Add(const Gaussian& other) {
+    weight += other.weight;
+    for (int c = 0; c < kCepstra; ++c) {
+        sum[c] += other.sum[c];
+        sum_squares[c] += other.sum_squares[c];
+    }
+}
+
+void SpeakerTracker::Gaussian::Cap(double max_weight) {
+    if (weight <= max_weight) {
+        return;
+    }
+    const double scale = max_weight / weight;
+    weight = max_weight;
+    for (int c = 0; c < kCepstra; ++c) {
+        sum[c] *= scale;
+        sum_squares[c] *= scale;
+    }
+}
+
+double SpeakerTracker::Divergence(const Gaussian& second, const Gaussian& model) const {
+    double total = 0.0;
+    for (int c = 0; c < kCepstra; ++c) {
+        const double mean_s = second.sum[c] / second.weight;
+        const double mean_m = model.sum[c] / model.weight;
+        const double var_s = std::max(kMinVariance, second.sum_squares[c] / second.weight - mean_s * mean_s);
+        double var_m = std::max(kMinVariance, model.sum_squares[c] / model.weight - mean_m * mean_m);
+        if (stream_.weight > 0.0) {
+            const double mean_g = stream_.sum[c] / stream_.weight;
+            const double var_g = std::max(kMinVariance, stream_.sum_squares[c] / stream_.weight - mean_g * mean_g);
+            var_m = (model.weight * var_m + kPriorFrames * var_g) / (model.weight + kPriorFrames);
+        }
+        const double d = mean_s - mean_m;
+        total += 0.5 * (var_s / var_m - 1.0 + d * d / var_m + std::log(var_m / var_s));
+    }
+    return total / kCepstra;
+}
+
+void SpeakerTracker::Reset() {
+    second_.Clear();
+    candidate_.Clear();
+    candidate_seconds_ = 0;
+    stream_.Clear();
+    speakers_.clear();
+    frames_ = 0;
+    speaker_ = 0;
+    current_ = 0;
+    changes_ = 0;
+    fill_ = 0;
+}
+
+bool SpeakerTracker::ProcessFrame(const float* frame, float speech_probability) {
+    float power = 0.0f;
+    for (size_t i = 0; i < frame_size_; ++i) {
+        power += frame[i] * frame[i];
+    }
+    power /= static_cast<float>(frame_size_);
+
+    if (speech_probability >= kSpeechProbability && power >= kMinFramePower) {
+        float* in = fft_in_->GetView().data();
+        for (size_t i = 0; i < frame_size_; ++i) {
+            in[i] = frame[i] * window_[i];
+        }
+        std::fill(in + frame_size_, in + fft_size_, 0.0f);
+        fft_->ForwardTransform(*fft_in_, fft_out_.get(), true);
+
+        dsp::OrderedPower(fft_out_->GetConstView().data(), fft_size_, power_.data());
+        const size_t bins = power_.size();
+        for (int b = 0; b < kMelBands; ++b) {
+            const float* weights = mel_.data() + b * bins;
+            float energy = 0.0f;
+            for (size_t k = 1; k + 1 < bins; ++k) {
+                if (weights[k] > 0.0f) {
+                    energy += weights[k] * power_[k];
+                }
+            }
+            band_energies_[b] = std::log(energy + 1e-10f);
+        }
+        for (int c = 0; c < kCepstra; ++c) {
+            const float* basis = dct_.data() + c * kMelBands;
+            double value = 0.0;
+            for (int b = 0; b < kMelBands; ++b) {
+                value += basis[b] * band_energies_[b];
+            }
+            second_.sum[c] += value;
+            second_.sum_squares[c] += value * value;
+        }
+        second_.weight += 1.0;
+    }
+
+    if (++frames_ < kFramesPerSecond) {
+        return false;
+    }
+    frames_ = 0;
+    speaker_ = 0;
+    if (second_.weight >= kMinSpeechFrames) {
+        stream_.Add(second_);
+        stream_.Cap(kSpeakerFrames);
+        uint8_t speaker = Match(second_);
+        if (speaker != 0) {
+            if (current_ != 0 && speaker != current_) {
+                ++changes_;
+            }
+            current_ = speaker;
+        }
+        speaker_ = current_;
+    }
+    second_.Clear();
+    return true;
+}
+
+// The speaker of |second|, learning from it; 0 while it may be someone new
+uint8_t SpeakerTracker::Match(const Gaussian& second) {
+    int best = -1;
+    double best_divergence = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < speakers_.size(); ++i) {
+        double divergence = Divergence(second, speakers_[i]);
+        if (divergence < best_divergence) {
+            best_divergence = divergence;
+            best = static_cast<int>(i);
+        }
+    }
+
+    const bool unlike = best >= 0 && best_divergence >= kNewSpeakerDivergence &&
+                        speakers_[best].weight >= kMatureFrames && static_cast<int>(speakers_.size()) < kMaxSpeakers;
+    if (best < 0 || unlike) {
+        candidate_.Add(second);
+        if (best >= 0 && ++candidate_seconds_ < kNewSpeakerSeconds) {
+            return 0;
+        }
+        bool apart = true;
+        for (const Gaussian& speaker : speakers_) {
+            apart = apart && Divergence(candidate_, speaker) >= kNewSpeakerDivergence;
+        }
+        if (apart) {
+            speakers_.push_back(candidate_);
+            candidate_.Clear();
+            candidate_seconds_ = 0;
+            return static_cast<uint8_t>(speakers_.size());
+        }
+    }
+    candidate_.Clear();
+    candidate_seconds_ = 0;
+
+    if (current_ != 0 && best != current_ - 1 &&
+        Divergence(second, speakers_[current_ - 1]) - best_divergence < kSwitchMargin) {
+        best = current_ - 1;
+    }
+    Gaussian& model = speakers_[best];
+    model.Add(second);
+    model.Cap(kSpeakerFrames);
+    return static_cast<uint8_t>(best + 1);
+}
+
+void SpeakerTracker::Process(const float* data, size_t num_samples, const std::vector<float>* probabilities,
+                             std::vector<uint8_t>* speakers) {
+    size_t next = 0;
+    size_t offset = 0;
+    while (offset < num_samples) {
+        size_t count = std::min(frame_size_ - fill_, num_samples - offset);
+        std::memcpy(frame_.data() + fill_, data + offset, count * sizeof(float));
+        fill_ += count;
+        offset += count;
+        if (fill_ < frame_size_) {
+            break;
+        }
+        fill_ = 0;
+        float probability = probabilities && next < probabilities->size() ? (*probabilities)[next] : 0.0f;
+        ++next;
+        if (ProcessFrame(frame_.data(), probability) && speakers) {
+            speakers->push_back(speaker_);
+        }
+    }
+}
+
+} // namespace kakarot
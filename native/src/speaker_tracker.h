@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "modules/audio_processing/utility/pffft_wrapper.h"
+
+namespace kakarot {
+
+// Local speaker IDs for one mixed stream (every remote participant on the
+// system channel), one per second, without a model. The frames the VAD calls
+// speech are described by their mel cepstrum (the vocal tract's shape,
+// level-free) as a diagonal Gaussian, per second and per speaker, and each
+// second goes to the speaker it diverges least from, with hysteresis; a few
+// seconds in a row unlike everyone are a new speaker. IDs are 1 to
+// kMaxSpeakers in order of first appearance, 0 for a second with too little
+// speech to say. Coarser than cloud diarization (voices a lot alike share an
+// ID), but here within a second. Not thread-safe: one instance per stream.
+class SpeakerTracker {
+public:
+    static constexpr int kMaxSpeakers = 8;
+
+    // 10ms frames at 8 to 48kHz
+    static bool Supports(int sample_rate);
+
+    explicit SpeakerTracker(int sample_rate);
+    ~SpeakerTracker();
+
+    SpeakerTracker(const SpeakerTracker&) = delete;
+    SpeakerTracker& operator=(const SpeakerTracker&) = delete;
+
+    // One frame of FrameSize() samples and its VAD probability. True when it
+    // completes a second, whose speaker Speaker() then is.
+    bool ProcessFrame(const float* frame, float speech_probability);
+
+    // |num_samples| through an internal frame; |probabilities| are the VAD's
+    // for the frames they complete, in order (missing ones count as 0). The
+    // speaker of each second completed is appended to |speakers|.
+    void Process(const float* data, size_t num_samples, const std::vector<float>* probabilities,
+                 std::vector<uint8_t>* speakers);
+
+    uint8_t Speaker() const { return speaker_; }
+    int Speakers() const { return static_cast<int>(speakers_.size()); }
+    uint32_t Changes() const { return changes_; }
+
+    void Reset();
+
+    size_t FrameSize() const { return frame_size_; }
+
+private:
+    // Per-coefficient sums of cepstra, weighted
+    struct Gaussian {
+        double weight = 0.0;
+        std::vector<double> sum;
+        std::vector<double> sum_squares;
+
+        void Clear();
+        void Add(const Gaussian& other);
+        // Keeps the model to about |max_weight| frames, so it follows drift
+        void Cap(double max_weight);
+    };
+
+    // Mean KL divergence per coefficient of |second| from |model|, the
+    // model's variances regularized toward the stream's
+    double Divergence(const Gaussian& second, const Gaussian& model) const;
+
+    uint8_t Match(const Gaussian& second);
+
+    const size_t frame_size_;
+    const size_t fft_size_;
+    std::unique_ptr<webrtc::Pffft> fft_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_in_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_out_;
+    std::vector<float> window_;
+    std::vector<float> power_;         // this frame's, DC to Nyquist
+    std::vector<float> mel_;           // kMelBands x (fft_size_ / 2 + 1) triangular weights
+    std::vector<float> dct_;           // kCepstra x kMelBands, c1 up
+    std::vector<float> band_energies_;
+
+    Gaussian second_;     // this second so far
+    Gaussian candidate_;  // seconds in a row unlike every speaker
+    int candidate_seconds_ = 0;
+    Gaussian stream_;     // every speaker
+    std::vector<Gaussian> speakers_;
+    size_t frames_ = 0;
+    uint8_t speaker_ = 0;
+    uint8_t current_ = 0;  // the last second's speaker, 0 before the first
+    uint32_t changes_ = 0;
+
+    std::vector<float> frame_;
+    size_t fill_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,231 @@
+#include "spectral_analyzer.h"
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+// Reported for a band with no energy at all
+static constexpr float kFloorDb = -120.0f;
+
+static size_t FftSizeFor(size_t window_size) {
+    size_t size = 128;
+    while (size < window_size) {
+        size *= 2;
+    }
+    return size;
+}
+
+static double HzToMel(double hz) {
+    return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+static double MelToHz(double mel) {
+    return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+}
+
+void Filterbank::Build(int sample_rate, size_t bins, size_t bands, SpectrumScale scale, double min_hz,
+                       double max_hz) {
+    const double nyquist = 0.5 * sample_rate;
+    const double top = std::min(max_hz, nyquist);
+    const double bottom = std::clamp(min_hz, 0.0, top * 0.5);
+    bins_ = bins;
+    weights_.assign(bands * bins, 0.0f);
+    begin_.assign(bands, bins);
+    end_.assign(bands, 0);
+    for (size_t b = 0; b < bands; ++b) {
+        double left, center, right;
+        if (scale == SpectrumScale::kMel) {
+            const double low_mel = HzToMel(bottom);
+            const double step = (HzToMel(top) - low_mel) / (bands + 1);
+            left = MelToHz(low_mel + b * step);
+            center = MelToHz(low_mel + (b + 1) * step);
+            right = MelToHz(low_mel + (b + 2) * step);
+        } else {
+            const double width = (top - bottom) / bands;
+            left = bottom + b * width;
+            right = left + width;
+            center = 0.5 * (left + right);
+        }
+        for (size_t k = 0; k < bins; ++k) {
+            const double hz = nyquist * static_cast<double>(k) / static_cast<double>(bins - 1);
+            double weight = 0.0;
+            if (scale == SpectrumScale::kLinear) {
+                weight = hz >= left && hz < right ? 1.0 : 0.0;
+            } else if (hz > left && hz <= center) {
+                weight = (hz - left) / (center - left);
+            } else if (hz > center && hz < right) {
+                weight = (right - hz) / (right - center);
+            }
+            if (weight > 0.0) {
+                weights_[b * bins + k] = static_cast<float>(weight);
+                begin_[b] = std::min(begin_[b], k);
+                end_[b] = k + 1;
+            }
+        }
+        if (end_[b] == 0) {
+            const size_t k = std::min(bins - 1, static_cast<size_t>(std::lround(center / nyquist * (bins - 1))));
+            weights_[b * bins + k] = 1.0f;
+            begin_[b] = k;
+            end_[b] = k + 1;
+        }
+    }
+}
+
+float Filterbank::Energy(size_t band, const float* power) const {
+    const size_t begin = begin_[band];
+    return dsp::DotProduct(weights_.data() + band * bins_ + begin, power + begin, end_[band] - begin);
+}
+
+bool SpectralAnalyzer::Supports(int sample_rate) {
+    return sample_rate >= 8000 && sample_rate <= 48000 && sample_rate % 100 == 0;
+}
+
+SpectralAnalyzer::SpectralAnalyzer(int sample_rate, const SpectrumOptions& options)
+    : sample_rate_(sample_rate),
+      options_(options),
+      frame_size_(static_cast<size_t>(sample_rate / 100)),
+      fft_size_(FftSizeFor(2 * frame_size_)),
+      fft_(std::make_unique<webrtc::Pffft>(fft_size_, webrtc::Pffft::FftType::kReal)),
+      fft_in_(fft_->CreateBuffer()),
+      fft_out_(fft_->CreateBuffer()),
+      window_(2 * frame_size_),
+      previous_(frame_size_, 0.0f),
+      power_(fft_size_ / 2 + 1, 0.0f),
+      bands_(static_cast<size_t>(std::clamp(options.bands, 1, kMaxBands)), 0.0f) {
+    const double pi = std::acos(-1.0);
+    double window_sum = 0.0;
+    for (size_t i = 0; i < window_.size(); ++i) {
+        window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * (i + 0.5) / window_.size()));
+        window_sum += window_[i];
+    }
+    // Power of a full-scale sine's bin: (amplitude * window_sum / 2)^2
+    const float scale = static_cast<float>(2.0 / window_sum);
+    for (float& w : window_) {
+        w *= scale;
+    }
+
+    filterbank_.Build(sample_rate, power_.size(), bands_.size(), options.scale, options.min_hz, options.max_hz);
+}
+
+SpectralAnalyzer::~SpectralAnalyzer() = default;
+
+void SpectralAnalyzer::ProcessFrame(const float* frame) {
+    float* in = fft_in_->GetView().data();
+    for (size_t i = 0; i < frame_size_; ++i) {
+        in[i] = previous_[i] * window_[i];
+        in[frame_size_ + i] = frame[i] * window_[frame_size_ + i];
+    }
+    std::fill(in + window_.size(), in + fft_size_, 0.0f);
+    std::memcpy(previous_.data(), frame, frame_size_ * sizeof(float));
+    fft_->ForwardTransform(*fft_in_, fft_out_.get(), true);
+
+    dsp::OrderedPower(fft_out_->GetConstView().data(), fft_size_, power_.data());
+    for (size_t b = 0; b < bands_.size(); ++b) {
+        bands_[b] = filterbank_.Energy(b, power_.data());
+    }
+}
+
+void SpectralAnalyzer::Reset() {
+    std::fill(previous_.begin(), previous_.end(), 0.0f);
+    std::fill(power_.begin(), power_.end(), 0.0f);
+    std::fill(bands_.begin(), bands_.end(), 0.0f);
+}
+
+SpectrumMeter::SpectrumMeter() = default;
+
+SpectrumMeter::~SpectrumMeter() = default;
+
+void SpectrumMeter::SetEnabled(bool enabled, const SpectrumOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+    if (enabled) {
+        options_ = options;
+        rebuild_ = true;
+    }
+    sums_.clear();
+    frames_ = 0;
+    active_.store(enabled_ || !listeners_.empty(), std::memory_order_relaxed);
+}
+
+void SpectrumMeter::AddListener(SpectrumListener* listener) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    listeners_.push_back(listener);
+    active_.store(true, std::memory_order_relaxed);
+}
+
+void SpectrumMeter::RemoveListener(SpectrumListener* listener) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    listeners_.erase(std::remove(listeners_.begin(), listeners_.end(), listener), listeners_.end());
+    active_.store(enabled_ || !listeners_.empty(), std::memory_order_relaxed);
+}
+
+void SpectrumMeter::Add(const float* data, size_t num_samples, int sample_rate) {
+    if (!active_.load(std::memory_order_relaxed) || num_samples == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (rebuild_ || !analyzer_ || analyzer_->SampleRate() != sample_rate) {
+        rebuild_ = false;
+        analyzer_.reset();
+        fill_ = 0;
+        if (!SpectralAnalyzer::Supports(sample_rate)) {
+            return;
+        }
+        analyzer_ = std::make_unique<SpectralAnalyzer>(sample_rate, options_);
+        frame_.assign(analyzer_->FrameSize(), 0.0f);
+        sums_.clear();
+        frames_ = 0;
+    }
+
+    const size_t frame_size = frame_.size();
+    while (num_samples > 0) {
+        const size_t count = std::min(num_samples, frame_size - fill_);
+        std::memcpy(frame_.data() + fill_, data, count * sizeof(float));
+        fill_ += count;
+        data += count;
+        num_samples -= count;
+        if (fill_ < frame_size) {
+            break;
+        }
+        fill_ = 0;
+        analyzer_->ProcessFrame(frame_.data());
+        for (SpectrumListener* listener : listeners_) {
+            listener->OnSpectrum(*analyzer_);
+        }
+        if (enabled_) {
+            sums_.resize(analyzer_->BandCount(), 0.0);
+            const float* bands = analyzer_->Bands();
+            for (size_t b = 0; b < sums_.size(); ++b) {
+                sums_[b] += bands[b];
+            }
+            ++frames_;
+        }
+    }
+}
+
+bool SpectrumMeter::Take(std::vector<float>* bands_db) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frames_ == 0) {
+        return false;
+    }
+    bands_db->resize(sums_.size());
+    for (size_t b = 0; b < sums_.size(); ++b) {
+        const double mean = sums_[b] / static_cast<double>(frames_);
+        (*bands_db)[b] = mean > 0.0 ? std::max(kFloorDb, static_cast<float>(10.0 * std::log10(mean))) : kFloorDb;
+        sums_[b] = 0.0;
+    }
+    frames_ = 0;
+    return true;
+}
+
+void SpectrumMeter::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fill_ = 0;
+    if (analyzer_) {
+        analyzer_->Reset();
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "modules/audio_processing/utility/pffft_wrapper.h"
+
+namespace kakarot {
+
+// How band energies are grouped
+enum class SpectrumScale {
+    kMel,     // triangles equally spaced in mel
+    kLinear,  // rectangles equally spaced in Hz
+};
+
+struct SpectrumOptions {
+    int bands = 32;
+    SpectrumScale scale = SpectrumScale::kMel;
+    float min_hz = 50.0f;
+    float max_hz = 8000.0f;  // clamped to Nyquist
+};
+
+// Band weights over the power bins of a |sample_rate| spectrum, DC to
+// Nyquist: mel triangles each reaching its neighbours' centres, or linear
+// rectangles, between |min_hz| and |max_hz| (clamped to Nyquist). A band
+// narrower than a bin gets the nearest one.
+class Filterbank {
+public:
+    void Build(int sample_rate, size_t bins, size_t bands, SpectrumScale scale, double min_hz, double max_hz);
+
+    // Weighted sum of |power| over band |band|
+    float Energy(size_t band, const float* power) const;
+
+    size_t Bins() const { return bins_; }
+    size_t Bands() const { return begin_.size(); }
+
+private:
+    size_t bins_ = 0;
+    std::vector<float> weights_;  // bands x bins
+    std::vector<size_t> begin_;   // first and past-last bin with weight, per band
+    std::vector<size_t> end_;
+};
+
+// One short-time Fourier transform per 10ms frame: a 20ms Hann window over
+// the frame and the one before, through pffft's SIMD real FFT, as the power
+// spectrum (a full-scale sine is 1.0 in its bin) and its band energies. Not
+// thread-safe: one instance per stream.
+class SpectralAnalyzer {
+public:
+    static constexpr int kMaxBands = 128;
+
+    // 10ms frames at 8 to 48kHz
+    static bool Supports(int sample_rate);
+
+    SpectralAnalyzer(int sample_rate, const SpectrumOptions& options);
+    ~SpectralAnalyzer();
+
+    SpectralAnalyzer(const SpectralAnalyzer&) = delete;
+    SpectralAnalyzer& operator=(const SpectralAnalyzer&) = delete;
+
+    // One frame of FrameSize() samples
+    void ProcessFrame(const float* frame);
+
+    // The newest frame's, DC to Nyquist
+    const float* PowerSpectrum() const { return power_.data(); }
+    size_t Bins() const { return power_.size(); }
+    const float* Bands() const { return bands_.data(); }
+    size_t BandCount() const { return bands_.size(); }
+
+    void Reset();
+
+    int SampleRate() const { return sample_rate_; }
+    size_t FrameSize() const { return frame_size_; }
+    const SpectrumOptions& Options() const { return options_; }
+
+private:
+    const int sample_rate_;
+    const SpectrumOptions options_;
+    const size_t frame_size_;
+    const size_t fft_size_;
+    std::unique_ptr<webrtc::Pffft> fft_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_in_;
+    std::unique_ptr<webrtc::Pffft::FloatBuffer> fft_out_;
+    std::vector<float> window_;      // two frames
+    std::vector<float> previous_;    // the frame before
+    Filterbank filterbank_;
+    std::vector<float> power_;
+    std::vector<float> bands_;
+};
+
+// Native stages that want the stream's spectrum rather than an FFT of their
+// own. Called on the consumer thread after each frame; must return quickly.
+class SpectrumListener {
+public:
+    virtual ~SpectrumListener() = default;
+    virtual void OnSpectrum(const SpectralAnalyzer& analyzer) = 0;
+};
+
+// A stream's spectrum for startLevelMeter()'s spectrum option and for
+// listeners: the consumer thread frames each delivery through one analyzer,
+// and the mean band powers since the last Take() go to the meter thread.
+// Nothing is computed while neither wants it.
+class SpectrumMeter {
+public:
+    SpectrumMeter();
+    ~SpectrumMeter();
+
+    SpectrumMeter(const SpectrumMeter&) = delete;
+    SpectrumMeter& operator=(const SpectrumMeter&) = delete;
+
+    // Any thread. The meter's bands; the analyzer is rebuilt on the next
+    // delivery, so listeners see these bands too
+    void SetEnabled(bool enabled, const SpectrumOptions& options = SpectrumOptions());
+
+    // Any thread. No call runs after RemoveListener() returns.
+    void AddListener(SpectrumListener* listener);
+    void RemoveListener(SpectrumListener* listener);
+
+    // Consumer thread, at the stream's output rate
+    void Add(const float* data, size_t num_samples, int sample_rate);
+
+    // Mean power per band since the last Take(), in dB relative to full
+    // scale; false when no frame completed
+    bool Take(std::vector<float>* bands_db);
+
+    // Between sessions: drops the partial frame and the window's history
+    void Reset();
+
+private:
+    std::atomic<bool> active_{false};  // enabled or listened to
+    std::mutex mutex_;
+    bool enabled_ = false;
+    SpectrumOptions options_;
+    bool rebuild_ = false;
+    std::vector<SpectrumListener*> listeners_;
+    std::unique_ptr<SpectralAnalyzer> analyzer_;
+    std::vector<float> frame_;
+    size_t fill_ = 0;
+    std::vector<double> sums_;
+    uint64_t frames_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,124 @@
+#include "speech_normalizer.h"
+// As libwebrtc.a is built: the data dumper compiles to no-ops
+#ifndef WEBRTC_APM_DEBUG_DUMP
+#define WEBRTC_APM_DEBUG_DUMP 0
+#endif
+#include "api/audio/audio_processing.h"
+#include "api/audio/audio_view.h"
+#include "modules/audio_processing/agc2/agc2_common.h"
+#include "modules/audio_processing/agc2/clipping_predictor.h"
+#include "modules/audio_processing/agc2/limiter.h"
+#include "modules/audio_processing/agc2/speech_level_estimator_impl.h"
+#include "modules/audio_processing/include/audio_frame_view.h"
+#include "modules/audio_processing/logging/apm_data_dumper.h"
+#include "voice_activity.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kakarot {
+
+// Gain range; attenuation only tames a hot mic, never a whisper into silence
+static constexpr float kMinGainDb = -10.0f;
+static constexpr float kMaxGainDb = 30.0f;
+
+// AGC2's adaptive digital slew rate, per 10ms frame
+static constexpr float kMaxGainChangeDbPerFrame = 6.0f / 100.0f;
+
+// A predicted clip drops the gain at once and holds it there for a second
+static constexpr float kClippingBackoffDb = 3.0f;
+static constexpr int kClippingHoldFrames = 100;
+
+// Analog-level scale the predictor reasons in; only whether it steps matters
+static constexpr int kPredictorLevel = 255;
+static constexpr int kPredictorStep = 15;
+
+bool SpeechNormalizer::Supports(int sample_rate) {
+    return sample_rate == 8000 || sample_rate == 16000 || sample_rate == 32000 || sample_rate == 48000;
+}
+
+SpeechNormalizer::SpeechNormalizer(int sample_rate, float target_dbfs)
+    : frame_size_(static_cast<size_t>(sample_rate / 100)),
+      kernels_(dsp::FrameKernelsFor(frame_size_)),
+      target_dbfs_(target_dbfs),
+      dumper_(std::make_unique<webrtc::ApmDataDumper>(0)),
+      vad_(std::make_unique<VoiceActivityDetector>(sample_rate)),
+      work_(frame_size_, 0.0f) {
+    webrtc::AudioProcessing::Config::GainController2::AdaptiveDigital level_config;
+    level_estimator_ = std::make_unique<webrtc::SpeechLevelEstimatorImpl>(
+        dumper_.get(), level_config, webrtc::kAdjacentSpeechFramesThreshold);
+
+    webrtc::AudioProcessing::Config::GainController1::AnalogGainController::ClippingPredictor clipping_config;
+    clipping_config.enabled = true;
+    clipping_config.mode = clipping_config.kClippingEventPrediction;
+    clipping_predictor_ = webrtc::CreateClippingPredictor(1, clipping_config);
+
+    limiter_ = std::make_unique<webrtc::Limiter>(dumper_.get(), frame_size_, "Kakarot");
+}
+
+SpeechNormalizer::~SpeechNormalizer() = default;
+
+void SpeechNormalizer::Reset() {
+    level_estimator_->Reset();
+    clipping_predictor_->Reset();
+    limiter_->Reset();
+    gain_db_ = 0.0f;
+    level_dbfs_ = -90.0f;
+    confident_ = false;
+    hold_frames_ = 0;
+}
+
+void SpeechNormalizer::ProcessFrame(float* frame) {
+    float sum = 0.0f;
+    float peak = 0.0f;
+    kernels_.sum_squares_and_peak(frame, frame_size_, &sum, &peak);
+    float rms_dbfs = sum > 0.0f ? 10.0f * std::log10(sum / frame_size_) : -90.0f;
+
+    // AGC2 works on floats at int16 scale, the VAD included
+    for (size_t i = 0; i < frame_size_; ++i) {
+        work_[i] = frame[i] * webrtc::kMaxAbsFloatS16Value;
+    }
+    float speech_probability = vad_->AnalyzeFrame(work_.data());
+    level_estimator_->Update(std::max(rms_dbfs, -90.0f), speech_probability);
+    level_dbfs_ = level_estimator_->GetLevelDbfs();
+    confident_ = level_estimator_->IsConfident();
+
+    // Slew towards the gain that puts speech on target; hold it otherwise
+    float last_gain_db = gain_db_;
+    if (hold_frames_ > 0) {
+        --hold_frames_;
+    }
+    if (confident_) {
+        float wanted = std::clamp(target_dbfs_ - level_dbfs_, kMinGainDb, kMaxGainDb);
+        float step = std::clamp(wanted - gain_db_, -kMaxGainChangeDbPerFrame, kMaxGainChangeDbPerFrame);
+        if (step < 0.0f || hold_frames_ == 0) {
+            gain_db_ += step;
+        }
+    }
+
+    // Ramped across the frame so a gain change never clicks
+    float from = std::pow(10.0f, last_gain_db / 20.0f);
+    float to = std::pow(10.0f, gain_db_ / 20.0f);
+    float delta = (to - from) / static_cast<float>(frame_size_);
+    for (size_t i = 0; i < frame_size_; ++i) {
+        work_[i] *= from + delta * static_cast<float>(i);
+    }
+
+    const float* channels[] = {work_.data()};
+    clipping_predictor_->Analyze(webrtc::AudioFrameView<const float>(channels, 1, static_cast<int>(frame_size_)));
+    if (clipping_predictor_->EstimateClippedLevelStep(0, kPredictorLevel, kPredictorStep, 0, kPredictorLevel)) {
+        // This frame still goes out at its gain; the limiter catches it. One
+        // back-off per hold, however many frames of it predict the clip.
+        if (hold_frames_ == 0) {
+            gain_db_ = std::max(kMinGainDb, gain_db_ - kClippingBackoffDb);
+            ++clipping_predictions_;
+        }
+        hold_frames_ = kClippingHoldFrames;
+    }
+
+    limiter_->Process(webrtc::DeinterleavedView<float>(work_.data(), frame_size_, 1));
+    for (size_t i = 0; i < frame_size_; ++i) {
+        frame[i] = work_[i] / webrtc::kMaxAbsFloatS16Value;
+    }
+}
+
+} // namespace kakarot
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "frame_kernels.h"
+
+namespace webrtc {
+class ApmDataDumper;
+class ClippingPredictor;
+class Limiter;
+class SpeechLevelEstimator;
+}
+
+namespace kakarot {
+
+class VoiceActivityDetector;
+
+// Brings speech to a target level, one 10ms frame at a time, after the APM.
+// AGC2's speech level estimator follows the level of frames the RNN VAD
+// calls speech; a digital gain slews towards target minus that level, and
+// AGC2's limiter keeps the result out of clipping. The clipping predictor
+// watches the gained signal and backs the gain off before the limiter has
+// to squash it. Holds its gain through silence. One instance per stream.
+class SpeechNormalizer {
+public:
+    // The limiter takes 10ms frames at 8, 16, 32 and 48kHz only
+    static bool Supports(int sample_rate);
+
+    SpeechNormalizer(int sample_rate, float target_dbfs);
+    ~SpeechNormalizer();
+
+    SpeechNormalizer(const SpeechNormalizer&) = delete;
+    SpeechNormalizer& operator=(const SpeechNormalizer&) = delete;
+
+    void SetTargetDbfs(float target_dbfs) { target_dbfs_ = target_dbfs; }
+
+    // Exactly FrameSize() samples, in place
+    void ProcessFrame(float* frame);
+
+    // Back to unity gain and an unknown speech level
+    void Reset();
+
+    size_t FrameSize() const { return frame_size_; }
+    float GainDb() const { return gain_db_; }
+    float SpeechLevelDbfs() const { return level_dbfs_; }
+    bool IsConfident() const { return confident_; }
+    uint64_t ClippingPredictions() const { return clipping_predictions_; }
+
+private:
+    const size_t frame_size_;
+    const dsp::FrameKernels kernels_;
+    float target_dbfs_;
+
+    std::unique_ptr<webrtc::ApmDataDumper> dumper_;
+    std::unique_ptr<VoiceActivityDetector> vad_;
+    std::unique_ptr<webrtc::SpeechLevelEstimator> level_estimator_;
+    std::unique_ptr<webrtc::ClippingPredictor> clipping_predictor_;
+    std::unique_ptr<webrtc::Limiter> limiter_;
+    std::vector<float> work_;   // the frame at AGC2's int16 scale
+
+    float gain_db_ = 0.0f;
+    float level_dbfs_ = -90.0f;
+    bool confident_ = false;
+    int hold_frames_ = 0;       // no gain increase while counting down
+    uint64_t clipping_predictions_ = 0;
+};
+
+} // namespace kakarot
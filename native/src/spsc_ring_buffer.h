@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace kakarot {
+
+// Wait-free single-producer/single-consumer ring buffer.
+//
+// The producer (CoreAudio IOProc) only memcpys into preallocated storage and
+// publishes the new write index with a release store; the consumer observes it
+// with an acquire load. No locks, no allocation after construction.
+template <typename T>
+class SpscRingBuffer {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscRingBuffer only supports trivially copyable types");
+
+public:
+    // Capacity is rounded up to the next power of two so wrapping is a mask.
+    explicit SpscRingBuffer(size_t min_capacity)
+        : capacity_(RoundUpPow2(min_capacity)),
+          mask_(capacity_ - 1),
+          storage_(new T[capacity_]) {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t Capacity() const { return capacity_; }
+
+    // Producer side. Writes all |count| items or nothing; returns false when
+    // there is not enough free space (the caller counts that as a drop).
+    bool Write(const T* data, size_t count) {
+        const size_t write = write_index_.load(std::memory_order_relaxed);
+        const size_t read = read_index_.load(std::memory_order_acquire);
+        if (capacity_ - (write - read) < count) {
+            return false;
+        }
+
+        const size_t offset = write & mask_;
+        const size_t first = std::min(count, capacity_ - offset);
+        std::memcpy(storage_.get() + offset, data, first * sizeof(T));
+        if (count > first) {
+            std::memcpy(storage_.get(), data + first, (count - first) * sizeof(T));
+        }
+
+        write_index_.store(write + count, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Reads up to |max_count| items, returns the number read.
+    size_t Read(T* out, size_t max_count) {
+        const size_t read = read_index_.load(std::memory_order_relaxed);
+        const size_t write = write_index_.load(std::memory_order_acquire);
+        const size_t count = std::min(max_count, write - read);
+        if (count == 0) {
+            return 0;
+        }
+
+        const size_t offset = read & mask_;
+        const size_t first = std::min(count, capacity_ - offset);
+        std::memcpy(out, storage_.get() + offset, first * sizeof(T));
+        if (count > first) {
+            std::memcpy(out + first, storage_.get(), (count - first) * sizeof(T));
+        }
+
+        read_index_.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t AvailableToRead() const {
+        return write_index_.load(std::memory_order_acquire) -
+               read_index_.load(std::memory_order_relaxed);
+    }
+
+    size_t AvailableToWrite() const {
+        return capacity_ - (write_index_.load(std::memory_order_relaxed) -
+                            read_index_.load(std::memory_order_acquire));
+    }
+
+    // Only safe while neither side is running.
+    void Reset() {
+        write_index_.store(0, std::memory_order_relaxed);
+        read_index_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static size_t RoundUpPow2(size_t v) {
+        size_t p = 1;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<T[]> storage_;
+
+    // Keep producer and consumer indices on separate cache lines.
+    alignas(64) std::atomic<size_t> write_index_{0};
+    alignas(64) std::atomic<size_t> read_index_{0};
+};
+
+} // namespace kakarot
@@ -0,0 +1,481 @@
+#include <napi.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sqlite_store.h"
+#include "sqlite_write_queue.h"
+#include "transcript_codec.h"
+
+namespace kakarot {
+
+namespace {
+
+// Largest integer a JS number holds exactly
+constexpr double kMaxSafeInteger = 9007199254740991.0;
+
+bool ToSqlValue(const Napi::Value& value, SqlValue* out) {
+    if (value.IsNull() || value.IsUndefined()) {
+        *out = SqlValue::Null();
+    } else if (value.IsNumber()) {
+        double number = value.As<Napi::Number>().DoubleValue();
+        if (std::floor(number) == number && std::fabs(number) <= kMaxSafeInteger) {
+            *out = SqlValue::Integer(static_cast<int64_t>(number));
+        } else {
+            *out = SqlValue::Real(number);
+        }
+    } else if (value.IsBoolean()) {
+        *out = SqlValue::Integer(value.As<Napi::Boolean>().Value() ? 1 : 0);
+    } else if (value.IsString()) {
+        *out = SqlValue::Text(value.As<Napi::String>().Utf8Value());
+    } else if (value.IsTypedArray() && value.As<Napi::TypedArray>().TypedArrayType() == napi_uint8_array) {
+        Napi::Uint8Array bytes = value.As<Napi::Uint8Array>();
+        *out = SqlValue::Blob(std::string(reinterpret_cast<const char*>(bytes.Data()), bytes.ByteLength()));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// sql.js's bind shapes: an array for positional parameters, an object
+// keyed by the parameter's full name (':id', '$id', '@id')
+bool ParseParams(const Napi::Value& value, SqlParams* params) {
+    if (value.IsUndefined() || value.IsNull()) {
+        return true;
+    }
+    if (value.IsArray()) {
+        Napi::Array array = value.As<Napi::Array>();
+        params->positional.resize(array.Length());
+        for (uint32_t i = 0; i < array.Length(); ++i) {
+            if (!ToSqlValue(array.Get(i), &params->positional[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (!value.IsObject()) {
+        return false;
+    }
+    Napi::Object object = value.As<Napi::Object>();
+    Napi::Array names = object.GetPropertyNames();
+    for (uint32_t i = 0; i < names.Length(); ++i) {
+        std::string name = names.Get(i).As<Napi::String>().Utf8Value();
+        SqlValue bound;
+        if (!ToSqlValue(object.Get(name), &bound)) {
+            return false;
+        }
+        params->named.emplace_back(std::move(name), std::move(bound));
+    }
+    return true;
+}
+
+Napi::Value FromSqlValue(Napi::Env env, const SqlValue& value) {
+    switch (value.type) {
+        case SqlValue::Type::kInteger:
+            return Napi::Number::New(env, static_cast<double>(value.integer));
+        case SqlValue::Type::kReal:
+            return Napi::Number::New(env, value.real);
+        case SqlValue::Type::kText:
+            return Napi::String::New(env, value.bytes);
+        case SqlValue::Type::kBlob: {
+            Napi::Uint8Array bytes = Napi::Uint8Array::New(env, value.bytes.size());
+            std::memcpy(bytes.Data(), value.bytes.data(), value.bytes.size());
+            return bytes;
+        }
+        case SqlValue::Type::kNull:
+        default:
+            return env.Null();
+    }
+}
+
+} // namespace
+
+// new Database(path) opens or creates a WAL database. run() and exec()
+// take the same arguments and return the same shapes as sql.js's, so the
+// repositories work unchanged on either engine.
+class SqliteDatabaseWrap : public Napi::ObjectWrap<SqliteDatabaseWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "Database", {
+            InstanceMethod("run", &SqliteDatabaseWrap::Run),
+            InstanceMethod("exec", &SqliteDatabaseWrap::Exec),
+            InstanceMethod("upsertMany", &SqliteDatabaseWrap::UpsertMany),
+            InstanceMethod("getRowsModified", &SqliteDatabaseWrap::GetRowsModified),
+            InstanceMethod("checkpoint", &SqliteDatabaseWrap::Checkpoint),
+            InstanceMethod("getStats", &SqliteDatabaseWrap::GetStats),
+            InstanceMethod("close", &SqliteDatabaseWrap::Close),
+        });
+    }
+
+    explicit SqliteDatabaseWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<SqliteDatabaseWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a database path").ThrowAsJavaScriptException();
+            return;
+        }
+        std::string error;
+        if (!store_.Open(info[0].As<Napi::String>().Utf8Value(), &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    // Throws on a bad call or a failed statement, as sql.js does
+    bool Execute(const Napi::CallbackInfo& info, std::vector<SqlResult>* results) {
+        Napi::Env env = info.Env();
+        SqlParams params;
+        if (info.Length() < 1 || !info[0].IsString() || (info.Length() > 1 && !ParseParams(info[1], &params))) {
+            Napi::TypeError::New(env, "Expected (sql, params?)").ThrowAsJavaScriptException();
+            return false;
+        }
+        std::string error;
+        if (!store_.Execute(info[0].As<Napi::String>().Utf8Value(), params, results, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return false;
+        }
+        return true;
+    }
+
+    // run(sql, params?) -> this
+    Napi::Value Run(const Napi::CallbackInfo& info) {
+        if (!Execute(info, nullptr)) {
+            return info.Env().Undefined();
+        }
+        return info.This();
+    }
+
+    // exec(sql, params?) -> [{ columns, values }], one per statement that
+    // yielded rows
+    Napi::Value Exec(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::vector<SqlResult> results;
+        if (!Execute(info, &results)) {
+            return env.Undefined();
+        }
+        Napi::Array array = Napi::Array::New(env, results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            const SqlResult& result = results[i];
+            Napi::Array columns = Napi::Array::New(env, result.columns.size());
+            for (size_t c = 0; c < result.columns.size(); ++c) {
+                columns.Set(static_cast<uint32_t>(c), Napi::String::New(env, result.columns[c]));
+            }
+            Napi::Array values = Napi::Array::New(env, result.values.size());
+            for (size_t r = 0; r < result.values.size(); ++r) {
+                const std::vector<SqlValue>& row = result.values[r];
+                Napi::Array cells = Napi::Array::New(env, row.size());
+                for (size_t c = 0; c < row.size(); ++c) {
+                    cells.Set(static_cast<uint32_t>(c), FromSqlValue(env, row[c]));
+                }
+                values.Set(static_cast<uint32_t>(r), cells);
+            }
+            Napi::Object entry = Napi::Object::New(env);
+            entry.Set("columns", columns);
+            entry.Set("values", values);
+            array.Set(static_cast<uint32_t>(i), entry);
+        }
+        return array;
+    }
+
+    // upsertMany(updateSql, insertSql, rows) -> { inserted, updated }: each
+    // row's params (named ones, so both statements take the same row) to the
+    // update, and to the insert where the update matched nothing, in one
+    // transaction that a failing row undoes whole
+    Napi::Value UpsertMany(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::vector<SqlParams> rows;
+        bool valid = info.Length() >= 3 && info[0].IsString() && info[1].IsString() && info[2].IsArray();
+        if (valid) {
+            Napi::Array array = info[2].As<Napi::Array>();
+            rows.resize(array.Length());
+            for (uint32_t i = 0; i < array.Length() && valid; ++i) {
+                valid = ParseParams(array.Get(i), &rows[i]);
+            }
+        }
+        if (!valid) {
+            Napi::TypeError::New(env, "Expected (updateSql, insertSql, rows)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        UpsertCounts counts;
+        std::string error;
+        if (!store_.Upsert(info[0].As<Napi::String>().Utf8Value(), info[1].As<Napi::String>().Utf8Value(), rows,
+                           &counts, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("inserted", Napi::Number::New(env, static_cast<double>(counts.inserted)));
+        result.Set("updated", Napi::Number::New(env, static_cast<double>(counts.updated)));
+        return result;
+    }
+
+    Napi::Value GetRowsModified(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), static_cast<double>(store_.RowsModified()));
+    }
+
+    // checkpoint(truncate?) copies the log into the database file
+    Napi::Value Checkpoint(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        bool truncate = info.Length() > 0 && info[0].IsBoolean() && info[0].As<Napi::Boolean>().Value();
+        std::string error;
+        if (!store_.Checkpoint(truncate, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return env.Undefined();
+    }
+
+    // getStats() -> { cachedStatements, cacheHits, cacheMisses, inTransaction }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("cachedStatements", Napi::Number::New(env, static_cast<double>(store_.CachedStatements())));
+        result.Set("cacheHits", Napi::Number::New(env, static_cast<double>(store_.CacheHits())));
+        result.Set("cacheMisses", Napi::Number::New(env, static_cast<double>(store_.CacheMisses())));
+        result.Set("inTransaction", Napi::Boolean::New(env, store_.InTransaction()));
+        return result;
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        store_.Close();
+        return info.Env().Undefined();
+    }
+
+    SqliteStore store_;
+};
+
+// One flush() call, settled on the JS thread through |tsfn|
+struct FlushCall {
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    bool ok = true;
+    std::string error;
+};
+
+// new WriteQueue(path, { intervalMs?, maxRows? }) opens a second
+// connection to the database for write-behind: enqueue() returns at once
+// and its writer thread commits the queue as one transaction per batch
+class WriteQueueWrap : public Napi::ObjectWrap<WriteQueueWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "WriteQueue", {
+            InstanceMethod("enqueue", &WriteQueueWrap::Enqueue),
+            InstanceMethod("flush", &WriteQueueWrap::Flush),
+            InstanceMethod("getStats", &WriteQueueWrap::GetStats),
+            InstanceMethod("close", &WriteQueueWrap::Close),
+        });
+    }
+
+    explicit WriteQueueWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<WriteQueueWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected (path, { intervalMs?, maxRows? })").ThrowAsJavaScriptException();
+            return;
+        }
+        WriteQueueOptions options;
+        if (info.Length() > 1 && info[1].IsObject()) {
+            Napi::Object object = info[1].As<Napi::Object>();
+            if (object.Get("intervalMs").IsNumber()) {
+                options.interval_ms = object.Get("intervalMs").As<Napi::Number>().DoubleValue();
+            }
+            if (object.Get("maxRows").IsNumber()) {
+                options.max_rows = static_cast<size_t>(std::max(1.0, object.Get("maxRows").As<Napi::Number>().DoubleValue()));
+            }
+        }
+        std::string error;
+        if (!queue_.Open(info[0].As<Napi::String>().Utf8Value(), options, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    // enqueue(sql, params?); a statement that later fails is counted in
+    // getStats().failed rather than thrown
+    Napi::Value Enqueue(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        SqlParams params;
+        if (info.Length() < 1 || !info[0].IsString() || (info.Length() > 1 && !ParseParams(info[1], &params))) {
+            Napi::TypeError::New(env, "Expected (sql, params?)").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        queue_.Enqueue(info[0].As<Napi::String>().Utf8Value(), std::move(params));
+        return env.Undefined();
+    }
+
+    // flush() -> Promise<void>, resolved once every write enqueued before
+    // it is on disk; rejects when that commit failed
+    Napi::Value Flush(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        auto* call = new FlushCall{Napi::Promise::Deferred::New(env), Napi::ThreadSafeFunction(), true, {}};
+        call->tsfn = Napi::ThreadSafeFunction::New(env, Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+                                                   "SqliteFlush", 0, 1);
+        Napi::Promise promise = call->deferred.Promise();
+        queue_.Flush([call](bool ok, const std::string& error) {
+            call->ok = ok;
+            call->error = error;
+            // |call| is the JS thread's once queued
+            Napi::ThreadSafeFunction tsfn = call->tsfn;
+            napi_status status = tsfn.NonBlockingCall(call, [](Napi::Env env, Napi::Function, FlushCall* settled) {
+                std::unique_ptr<FlushCall> owned(settled);
+                if (owned->ok) {
+                    owned->deferred.Resolve(env.Undefined());
+                } else {
+                    owned->deferred.Reject(Napi::Error::New(env, owned->error).Value());
+                }
+            });
+            if (status != napi_ok) {
+                delete call;  // the env is going away
+            }
+            tsfn.Release();
+        });
+        return promise;
+    }
+
+    // getStats() -> { queued, committed, failed, batches, retries, pending,
+    // maxBatch, maxCommitMs, lastError? }
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        WriteQueueStats stats = queue_.Stats();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("queued", Napi::Number::New(env, static_cast<double>(stats.queued)));
+        result.Set("committed", Napi::Number::New(env, static_cast<double>(stats.committed)));
+        result.Set("failed", Napi::Number::New(env, static_cast<double>(stats.failed)));
+        result.Set("batches", Napi::Number::New(env, static_cast<double>(stats.batches)));
+        result.Set("retries", Napi::Number::New(env, static_cast<double>(stats.retries)));
+        result.Set("pending", Napi::Number::New(env, static_cast<double>(stats.pending)));
+        result.Set("maxBatch", Napi::Number::New(env, static_cast<double>(stats.max_batch)));
+        result.Set("maxCommitMs", Napi::Number::New(env, stats.max_commit_ms));
+        if (!stats.last_error.empty()) {
+            result.Set("lastError", Napi::String::New(env, stats.last_error));
+        }
+        return result;
+    }
+
+    // close() commits what is queued, on this thread, and stops the writer
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        queue_.Close();
+        return info.Env().Undefined();
+    }
+
+    SqliteWriteQueue queue_;
+};
+
+bool ReadBytes(const Napi::Value& value, std::string* out) {
+    if (!value.IsTypedArray() || value.As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+        return false;
+    }
+    Napi::Uint8Array bytes = value.As<Napi::Uint8Array>();
+    out->assign(reinterpret_cast<const char*>(bytes.Data()), bytes.ByteLength());
+    return true;
+}
+
+Napi::Uint8Array ToBytes(Napi::Env env, const std::string& bytes) {
+    Napi::Uint8Array result = Napi::Uint8Array::New(env, bytes.size());
+    std::memcpy(result.Data(), bytes.data(), bytes.size());
+    return result;
+}
+
+// new TranscriptCodec(dictionary?, level?) compresses archived transcripts
+// with zstd; the dictionary is digested once for all the calls after
+class TranscriptCodecWrap : public Napi::ObjectWrap<TranscriptCodecWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "TranscriptCodec", {
+            InstanceMethod("compress", &TranscriptCodecWrap::Compress),
+            InstanceMethod("decompress", &TranscriptCodecWrap::Decompress),
+        });
+    }
+
+    explicit TranscriptCodecWrap(const Napi::CallbackInfo& info) : Napi::ObjectWrap<TranscriptCodecWrap>(info) {
+        Napi::Env env = info.Env();
+        std::string dictionary;
+        if (info.Length() > 0 && !info[0].IsUndefined() && !info[0].IsNull() && !ReadBytes(info[0], &dictionary)) {
+            Napi::TypeError::New(env, "Expected (dictionary?: Uint8Array, level?)").ThrowAsJavaScriptException();
+            return;
+        }
+        int level = 19;
+        if (info.Length() > 1 && info[1].IsNumber()) {
+            level = info[1].As<Napi::Number>().Int32Value();
+        }
+        std::string error;
+        if (!codec_.SetDictionary(dictionary, level, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+private:
+    Napi::Value Compress(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::string input;
+        if (info.Length() < 1 || !ReadBytes(info[0], &input)) {
+            Napi::TypeError::New(env, "Expected a Uint8Array").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::string output;
+        std::string error;
+        if (!codec_.Compress(input, &output, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return ToBytes(env, output);
+    }
+
+    Napi::Value Decompress(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        std::string input;
+        if (info.Length() < 1 || !ReadBytes(info[0], &input)) {
+            Napi::TypeError::New(env, "Expected a Uint8Array").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::string output;
+        std::string error;
+        if (!codec_.Decompress(input, &output, &error)) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return ToBytes(env, output);
+    }
+
+    TranscriptCodec codec_;
+};
+
+// trainTranscriptDictionary(samples: string[], capacity) -> Uint8Array
+Napi::Value TrainTranscriptDictionary(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected (samples, capacity)").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    Napi::Array list = info[0].As<Napi::Array>();
+    std::vector<std::string> samples;
+    samples.reserve(list.Length());
+    for (uint32_t i = 0; i < list.Length(); ++i) {
+        Napi::Value sample = list.Get(i);
+        if (sample.IsString()) {
+            samples.push_back(sample.As<Napi::String>().Utf8Value());
+        }
+    }
+    size_t capacity = static_cast<size_t>(std::max(1024.0, info[1].As<Napi::Number>().DoubleValue()));
+    std::string dictionary;
+    std::string error;
+    if (!TranscriptCodec::TrainDictionary(samples, capacity, &dictionary, &error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return ToBytes(env, dictionary);
+}
+
+Napi::Object InitSqlite(Napi::Env env, Napi::Object exports) {
+    exports.Set("Database", SqliteDatabaseWrap::Define(env));
+    exports.Set("WriteQueue", WriteQueueWrap::Define(env));
+    exports.Set("TranscriptCodec", TranscriptCodecWrap::Define(env));
+    exports.Set("trainTranscriptDictionary",
+                Napi::Function::New(env, TrainTranscriptDictionary, "trainTranscriptDictionary"));
+    exports.Set("hasZstd", Napi::Boolean::New(env, TranscriptCodec::Available()));
+    return exports;
+}
+
+} // namespace kakarot
+
+NODE_API_MODULE(kakarot_sqlite, kakarot::InitSqlite)
@@ -0,0 +1,341 @@
+#include "sqlite_store.h"
+
+#if defined(_WIN32)
+#include <winsqlite/winsqlite3.h>
+#else
+#include <sqlite3.h>
+#endif
+
+#include <cctype>
+
+namespace kakarot {
+
+namespace {
+
+constexpr int kBusyTimeoutMs = 5000;
+
+bool Fail(sqlite3* db, const char* what, std::string* error) {
+    if (error) {
+        *error = std::string(what) + ": " + (db ? sqlite3_errmsg(db) : "out of memory");
+    }
+    return false;
+}
+
+bool OnlyWhitespace(const char* text) {
+    for (; text && *text; ++text) {
+        if (!std::isspace(static_cast<unsigned char>(*text)) && *text != ';') {
+            return false;
+        }
+    }
+    return true;
+}
+
+int BindValue(sqlite3_stmt* stmt, int index, const SqlValue& value) {
+    switch (value.type) {
+        case SqlValue::Type::kInteger:
+            return sqlite3_bind_int64(stmt, index, value.integer);
+        case SqlValue::Type::kReal:
+            return sqlite3_bind_double(stmt, index, value.real);
+        case SqlValue::Type::kText:
+            return sqlite3_bind_text(stmt, index, value.bytes.data(), static_cast<int>(value.bytes.size()),
+                                     SQLITE_TRANSIENT);
+        case SqlValue::Type::kBlob:
+            return sqlite3_bind_blob(stmt, index, value.bytes.data(), static_cast<int>(value.bytes.size()),
+                                     SQLITE_TRANSIENT);
+        case SqlValue::Type::kNull:
+        default:
+            return sqlite3_bind_null(stmt, index);
+    }
+}
+
+SqlValue ColumnValue(sqlite3_stmt* stmt, int column) {
+    switch (sqlite3_column_type(stmt, column)) {
+        case SQLITE_INTEGER:
+            return SqlValue::Integer(sqlite3_column_int64(stmt, column));
+        case SQLITE_FLOAT:
+            return SqlValue::Real(sqlite3_column_double(stmt, column));
+        case SQLITE_TEXT: {
+            const auto* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+            return SqlValue::Text(std::string(text ? text : "", sqlite3_column_bytes(stmt, column)));
+        }
+        case SQLITE_BLOB: {
+            const auto* blob = static_cast<const char*>(sqlite3_column_blob(stmt, column));
+            return SqlValue::Blob(std::string(blob ? blob : "", sqlite3_column_bytes(stmt, column)));
+        }
+        default:
+            return SqlValue::Null();
+    }
+}
+
+} // namespace
+
+SqliteStore::SqliteStore(size_t statement_cache) : capacity_(statement_cache) {}
+
+SqliteStore::~SqliteStore() { Close(); }
+
+bool SqliteStore::Open(const std::string& path, std::string* error) {
+    Close();
+    sqlite3* db = nullptr;
+    int rc = sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX,
+                             nullptr);
+    if (rc != SQLITE_OK) {
+        Fail(db, ("Cannot open " + path).c_str(), error);
+        sqlite3_close(db);
+        return false;
+    }
+    sqlite3_busy_timeout(db, kBusyTimeoutMs);
+    // journal_mode answers with the mode it took: a filesystem without
+    // shared memory keeps the rollback journal, which still works
+    if (sqlite3_exec(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", nullptr, nullptr, nullptr)
+        != SQLITE_OK) {
+        Fail(db, ("Cannot configure " + path).c_str(), error);
+        sqlite3_close(db);
+        return false;
+    }
+    db_ = db;
+    return true;
+}
+
+void SqliteStore::Close() {
+    if (!db_) {
+        return;
+    }
+    ClearCache();
+    // Back to a rollback journal at rest, which checkpoints the log and
+    // removes it, so sql.js and older builds can still read the file. Only
+    // the last connection can; the others give up at once.
+    sqlite3_busy_timeout(db_, 0);
+    sqlite3_exec(db_, "PRAGMA journal_mode=DELETE;", nullptr, nullptr, nullptr);
+    sqlite3_close(db_);
+    db_ = nullptr;
+}
+
+bool SqliteStore::Execute(const std::string& sql, const SqlParams& params, std::vector<SqlResult>* results,
+                          std::string* error) {
+    if (!db_) {
+        if (error) *error = "Database is closed";
+        return false;
+    }
+    sqlite3_stmt* stmt = nullptr;
+    bool cached = false;
+    if (!Acquire(sql, &stmt, &cached, error)) {
+        return false;
+    }
+    if (!stmt) {
+        // Several statements, or none: not worth caching
+        return ExecuteScript(sql, params, results, error);
+    }
+    bool ok = Bind(stmt, params, error) && Step(stmt, results, error);
+    Release(sql, stmt, cached);
+    return ok;
+}
+
+bool SqliteStore::Upsert(const std::string& update_sql, const std::string& insert_sql,
+                         const std::vector<SqlParams>& rows, UpsertCounts* counts, std::string* error) {
+    *counts = UpsertCounts();
+    if (!db_) {
+        if (error) *error = "Database is closed";
+        return false;
+    }
+    sqlite3_stmt* update = nullptr;
+    sqlite3_stmt* insert = nullptr;
+    bool update_cached = false;
+    bool insert_cached = false;
+    if (!Acquire(update_sql, &update, &update_cached, error)) {
+        return false;
+    }
+    if (!Acquire(insert_sql, &insert, &insert_cached, error)) {
+        if (update) Release(update_sql, update, update_cached);
+        return false;
+    }
+    auto release = [&] {
+        if (update) Release(update_sql, update, update_cached);
+        if (insert) Release(insert_sql, insert, insert_cached);
+    };
+    if (!update || !insert) {
+        release();
+        if (error) *error = "Upsert takes single statements";
+        return false;
+    }
+    if (sqlite3_exec(db_, "SAVEPOINT upsert", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        release();
+        return Fail(db_, "Cannot begin upsert", error);
+    }
+    bool ok = true;
+    for (const SqlParams& row : rows) {
+        ok = Bind(update, row, error) && Step(update, nullptr, error);
+        sqlite3_reset(update);
+        sqlite3_clear_bindings(update);
+        if (!ok) {
+            break;
+        }
+        if (sqlite3_changes(db_) > 0) {
+            counts->updated++;
+            continue;
+        }
+        ok = Bind(insert, row, error) && Step(insert, nullptr, error);
+        sqlite3_reset(insert);
+        sqlite3_clear_bindings(insert);
+        if (!ok) {
+            break;
+        }
+        counts->inserted += sqlite3_changes(db_) > 0 ? 1 : 0;
+    }
+    release();
+    if (!ok) {
+        sqlite3_exec(db_, "ROLLBACK TO upsert; RELEASE upsert", nullptr, nullptr, nullptr);
+        *counts = UpsertCounts();
+        return false;
+    }
+    if (sqlite3_exec(db_, "RELEASE upsert", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        Fail(db_, "Cannot commit upsert", error);
+        sqlite3_exec(db_, "ROLLBACK TO upsert; RELEASE upsert", nullptr, nullptr, nullptr);
+        *counts = UpsertCounts();
+        return false;
+    }
+    return true;
+}
+
+bool SqliteStore::Checkpoint(bool truncate, std::string* error) {
+    if (!db_) {
+        if (error) *error = "Database is closed";
+        return false;
+    }
+    int mode = truncate ? SQLITE_CHECKPOINT_TRUNCATE : SQLITE_CHECKPOINT_PASSIVE;
+    if (sqlite3_wal_checkpoint_v2(db_, nullptr, mode, nullptr, nullptr) != SQLITE_OK) {
+        return Fail(db_, "Checkpoint failed", error);
+    }
+    return true;
+}
+
+int64_t SqliteStore::RowsModified() const {
+    return db_ ? sqlite3_changes(db_) : 0;
+}
+
+bool SqliteStore::InTransaction() const {
+    return db_ && !sqlite3_get_autocommit(db_);
+}
+
+// The cached statement for |sql|, or a fresh one that goes into the cache
+// once it has run. |*stmt| stays null when |sql| is not a single statement.
+bool SqliteStore::Acquire(const std::string& sql, sqlite3_stmt** stmt, bool* cached, std::string* error) {
+    auto it = cache_.find(sql);
+    if (it != cache_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        *stmt = it->second->second;
+        *cached = true;
+        ++cache_hits_;
+        return true;
+    }
+    ++cache_misses_;
+    const char* tail = nullptr;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), static_cast<int>(sql.size()), stmt, &tail) != SQLITE_OK) {
+        return Fail(db_, "Prepare failed", error);
+    }
+    if (*stmt && !OnlyWhitespace(tail)) {
+        sqlite3_finalize(*stmt);
+        *stmt = nullptr;
+    }
+    return true;
+}
+
+void SqliteStore::Release(const std::string& sql, sqlite3_stmt* stmt, bool cached) {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    if (cached) {
+        return;
+    }
+    if (capacity_ == 0) {
+        sqlite3_finalize(stmt);
+        return;
+    }
+    if (lru_.size() >= capacity_) {
+        sqlite3_finalize(lru_.back().second);
+        cache_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+    lru_.emplace_front(sql, stmt);
+    cache_[sql] = lru_.begin();
+}
+
+bool SqliteStore::Bind(sqlite3_stmt* stmt, const SqlParams& params, std::string* error) {
+    int count = sqlite3_bind_parameter_count(stmt);
+    for (size_t i = 0; i < params.positional.size() && static_cast<int>(i) < count; ++i) {
+        if (BindValue(stmt, static_cast<int>(i) + 1, params.positional[i]) != SQLITE_OK) {
+            return Fail(db_, "Bind failed", error);
+        }
+    }
+    for (const auto& [name, value] : params.named) {
+        int index = sqlite3_bind_parameter_index(stmt, name.c_str());
+        if (index > 0 && BindValue(stmt, index, value) != SQLITE_OK) {
+            return Fail(db_, "Bind failed", error);
+        }
+    }
+    return true;
+}
+
+bool SqliteStore::Step(sqlite3_stmt* stmt, std::vector<SqlResult>* results, std::string* error) {
+    SqlResult* result = nullptr;
+    int columns = sqlite3_column_count(stmt);
+    for (;;) {
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_DONE) {
+            return true;
+        }
+        if (rc != SQLITE_ROW) {
+            return Fail(db_, "Statement failed", error);
+        }
+        if (!results) {
+            continue;
+        }
+        if (!result) {
+            results->emplace_back();
+            result = &results->back();
+            for (int c = 0; c < columns; ++c) {
+                const char* name = sqlite3_column_name(stmt, c);
+                result->columns.emplace_back(name ? name : "");
+            }
+        }
+        std::vector<SqlValue> row;
+        row.reserve(columns);
+        for (int c = 0; c < columns; ++c) {
+            row.push_back(ColumnValue(stmt, c));
+        }
+        result->values.push_back(std::move(row));
+    }
+}
+
+bool SqliteStore::ExecuteScript(const std::string& sql, const SqlParams& params, std::vector<SqlResult>* results,
+                                std::string* error) {
+    const char* next = sql.c_str();
+    const char* end = next + sql.size();
+    bool first = true;
+    while (next < end && !OnlyWhitespace(next)) {
+        sqlite3_stmt* stmt = nullptr;
+        const char* tail = nullptr;
+        if (sqlite3_prepare_v2(db_, next, static_cast<int>(end - next), &stmt, &tail) != SQLITE_OK) {
+            return Fail(db_, "Prepare failed", error);
+        }
+        next = tail;
+        if (!stmt) {
+            continue;  // a comment
+        }
+        bool ok = (!first || Bind(stmt, params, error)) && Step(stmt, results, error);
+        sqlite3_finalize(stmt);
+        if (!ok) {
+            return false;
+        }
+        first = false;
+    }
+    return true;
+}
+
+void SqliteStore::ClearCache() {
+    for (auto& entry : lru_) {
+        sqlite3_finalize(entry.second);
+    }
+    lru_.clear();
+    cache_.clear();
+}
+
+} // namespace kakarot
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace kakarot {
+
+// A bound parameter or a result cell, in SQLite's own storage classes
+struct SqlValue {
+    enum class Type { kNull, kInteger, kReal, kText, kBlob };
+    Type type = Type::kNull;
+    int64_t integer = 0;
+    double real = 0.0;
+    std::string bytes;  // text as UTF-8, or the blob
+
+    static SqlValue Null() { return SqlValue(); }
+    static SqlValue Integer(int64_t v) { SqlValue s; s.type = Type::kInteger; s.integer = v; return s; }
+    static SqlValue Real(double v) { SqlValue s; s.type = Type::kReal; s.real = v; return s; }
+    static SqlValue Text(std::string v) { SqlValue s; s.type = Type::kText; s.bytes = std::move(v); return s; }
+    static SqlValue Blob(std::string v) { SqlValue s; s.type = Type::kBlob; s.bytes = std::move(v); return s; }
+};
+
+// Positional (?, ?NNN) values, or named ones keyed with their prefix
+// (:id, @id, $id); they bind to the first statement of a script only
+struct SqlParams {
+    std::vector<SqlValue> positional;
+    std::vector<std::pair<std::string, SqlValue>> named;
+
+    bool Empty() const { return positional.empty() && named.empty(); }
+};
+
+// The rows of one statement, as sql.js's exec() shapes them
+struct SqlResult {
+    std::vector<std::string> columns;
+    std::vector<std::vector<SqlValue>> values;
+};
+
+struct UpsertCounts {
+    size_t inserted = 0;
+    size_t updated = 0;
+};
+
+// A SQLite database on disk, in WAL mode: each statement outside an
+// explicit transaction commits on its own by appending its pages to the
+// log, so a write costs the pages it changed rather than the file.
+// synchronous=NORMAL leaves the fsync to checkpoints, which SQLite runs
+// as the log grows. Single-statement SQL is kept prepared in an LRU
+// keyed by its text, so the repositories' fixed queries are parsed once.
+// One thread at a time.
+class SqliteStore {
+public:
+    static constexpr size_t kDefaultStatementCache = 64;
+
+    explicit SqliteStore(size_t statement_cache = kDefaultStatementCache);
+    ~SqliteStore();
+
+    SqliteStore(const SqliteStore&) = delete;
+    SqliteStore& operator=(const SqliteStore&) = delete;
+
+    // Creates the file if needed. An existing rollback-journal database,
+    // such as one sql.js exported, converts to WAL in place.
+    bool Open(const std::string& path, std::string* error);
+    // The last connection to close checkpoints the log into the file and
+    // leaves WAL mode, so a closed database is a single file any SQLite
+    // reader opens
+    void Close();
+    bool IsOpen() const { return db_ != nullptr; }
+
+    // Runs every statement in |sql|, |params| binding to the first. Each
+    // statement that yields rows appends them to |results| when given.
+    bool Execute(const std::string& sql, const SqlParams& params, std::vector<SqlResult>* results,
+                 std::string* error);
+
+    // Each row binds to |update_sql| and, where that changed nothing, to
+    // |insert_sql|; both single statements, prepared once. The rows go in
+    // as one transaction (a savepoint inside an open one), undone whole if
+    // any fails.
+    bool Upsert(const std::string& update_sql, const std::string& insert_sql, const std::vector<SqlParams>& rows,
+                UpsertCounts* counts, std::string* error);
+
+    // Copies the log back into the database; |truncate| also empties it
+    bool Checkpoint(bool truncate, std::string* error);
+
+    // Of the last statement, as sqlite3_changes()
+    int64_t RowsModified() const;
+    bool InTransaction() const;
+
+    size_t CachedStatements() const { return lru_.size(); }
+    uint64_t CacheHits() const { return cache_hits_; }
+    uint64_t CacheMisses() const { return cache_misses_; }
+
+private:
+    bool Acquire(const std::string& sql, sqlite3_stmt** stmt, bool* cached, std::string* error);
+    void Release(const std::string& sql, sqlite3_stmt* stmt, bool cached);
+    bool Bind(sqlite3_stmt* stmt, const SqlParams& params, std::string* error);
+    bool Step(sqlite3_stmt* stmt, std::vector<SqlResult>* results, std::string* error);
+    bool ExecuteScript(const std::string& sql, const SqlParams& params, std::vector<SqlResult>* results,
+                       std::string* error);
+    void ClearCache();
+
+    sqlite3* db_ = nullptr;
+    size_t capacity_;
+    // Most recent first; the map points into it
+    std::list<std::pair<std::string, sqlite3_stmt*>> lru_;
+    std::unordered_map<std::string, std::list<std::pair<std::string, sqlite3_stmt*>>::iterator> cache_;
+    uint64_t cache_hits_ = 0;
+    uint64_t cache_misses_ = 0;
+};
+
+} // namespace kakarot
@@ -0,0 +1,163 @@
+#include "sqlite_write_queue.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace kakarot {
+
+SqliteWriteQueue::~SqliteWriteQueue() { Close(); }
+
+bool SqliteWriteQueue::Open(const std::string& path, const WriteQueueOptions& options, std::string* error) {
+    Close();
+    if (!store_.Open(path, error)) {
+        return false;
+    }
+    // Batches are few, so each can afford its own fsync
+    if (!store_.Execute("PRAGMA synchronous=FULL", {}, nullptr, error)) {
+        store_.Close();
+        return false;
+    }
+    options_ = options;
+    options_.interval_ms = std::max(1.0, options_.interval_ms);
+    options_.max_rows = std::max<size_t>(1, options_.max_rows);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+        running_ = true;
+    }
+    thread_ = std::thread(&SqliteWriteQueue::Run, this);
+    return true;
+}
+
+void SqliteWriteQueue::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+    store_.Close();
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+}
+
+void SqliteWriteQueue::Enqueue(std::string sql, SqlParams params) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_ || stopping_) {
+        return;
+    }
+    if (pending_.empty()) {
+        oldest_ = std::chrono::steady_clock::now();
+    }
+    pending_.push_back(Write{std::move(sql), std::move(params)});
+    ++stats_.queued;
+    // The writer sleeps untimed while empty, and until the deadline after
+    if (pending_.size() == 1 || pending_.size() >= options_.max_rows) {
+        wake_.notify_one();
+    }
+}
+
+void SqliteWriteQueue::Flush(std::function<void(bool ok, const std::string& error)> done) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ && !stopping_) {
+            flushes_.push_back(std::move(done));
+            wake_.notify_one();
+            return;
+        }
+    }
+    // Closed: Close() committed everything already
+    done(true, std::string());
+}
+
+WriteQueueStats SqliteWriteQueue::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteQueueStats stats = stats_;
+    stats.pending = pending_.size();
+    return stats;
+}
+
+void SqliteWriteQueue::Run() {
+    const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(options_.interval_ms));
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        while (!stopping_ && flushes_.empty() &&
+               (pending_.empty() ||
+                (pending_.size() < options_.max_rows && std::chrono::steady_clock::now() < oldest_ + interval))) {
+            if (pending_.empty()) {
+                wake_.wait(lock);
+            } else {
+                wake_.wait_until(lock, oldest_ + interval);
+            }
+        }
+        if (stopping_ && pending_.empty() && flushes_.empty()) {
+            return;
+        }
+        std::vector<Write> batch;
+        batch.swap(pending_);
+        std::vector<FlushCallback> flushes;
+        flushes.swap(flushes_);
+        lock.unlock();
+
+        auto started = std::chrono::steady_clock::now();
+        std::string error;
+        uint64_t rejected = 0;
+        bool ok = batch.empty() || Commit(batch, &rejected, &error);
+        double commit_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+        lock.lock();
+        if (!error.empty()) {
+            stats_.last_error = error;
+        }
+        if (ok && !batch.empty()) {
+            stats_.committed += batch.size() - rejected;
+            stats_.failed += rejected;
+            ++stats_.batches;
+            stats_.max_batch = std::max(stats_.max_batch, batch.size());
+            stats_.max_commit_ms = std::max(stats_.max_commit_ms, commit_ms);
+        } else if (!ok && stopping_) {
+            // No second chance on the way out
+            stats_.failed += batch.size();
+        } else if (!ok) {
+            // Back in front of anything queued meanwhile, after another interval
+            ++stats_.retries;
+            pending_.insert(pending_.begin(), std::make_move_iterator(batch.begin()),
+                            std::make_move_iterator(batch.end()));
+            oldest_ = std::chrono::steady_clock::now();
+        }
+        lock.unlock();
+        if (ok) {
+            error.clear();
+        }
+        for (FlushCallback& done : flushes) {
+            done(ok, error);
+        }
+        lock.lock();
+    }
+}
+
+// One transaction for the batch. A statement SQLite rejects (a constraint,
+// say) is counted in |rejected| and skipped, as it would have been on its
+// own; false only when the transaction itself could not commit
+bool SqliteWriteQueue::Commit(const std::vector<Write>& batch, uint64_t* rejected, std::string* error) {
+    if (!store_.Execute("BEGIN IMMEDIATE", {}, nullptr, error)) {
+        return false;
+    }
+    for (const Write& write : batch) {
+        if (!store_.Execute(write.sql, write.params, nullptr, error)) {
+            ++*rejected;
+        }
+    }
+    if (!store_.Execute("COMMIT", {}, nullptr, error)) {
+        store_.Execute("ROLLBACK", {}, nullptr, nullptr);
+        *rejected = 0;
+        return false;
+    }
+    return true;
+}
+
+} // namespace kakarot
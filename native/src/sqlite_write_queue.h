@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sqlite_store.h"
+
+namespace kakarot {
+
+struct WriteQueueOptions {
+    double interval_ms = 250.0;  // how long a write may wait for company
+    size_t max_rows = 64;        // or how many it waits for
+};
+
+struct WriteQueueStats {
+    uint64_t queued = 0;
+    uint64_t committed = 0;
+    uint64_t failed = 0;        // statements SQLite rejected; the rest of their batch still commits
+    uint64_t batches = 0;
+    uint64_t retries = 0;       // batches whose commit failed and went round again
+    size_t pending = 0;
+    size_t max_batch = 0;
+    double max_commit_ms = 0.0;
+    std::string last_error;
+};
+
+// Write-behind for the database's append-mostly rows (transcript segments,
+// callouts): Enqueue() only takes a lock, and a writer thread on its own
+// WAL connection commits what has gathered as one transaction every
+// |interval_ms| or |max_rows|. Its connection syncs every commit
+// (synchronous=FULL); at most one batch is lost if the process dies.
+// Statements run in the order they were enqueued. Enqueue, Flush and
+// Stats from any thread.
+class SqliteWriteQueue {
+public:
+    SqliteWriteQueue() = default;
+    ~SqliteWriteQueue();
+
+    SqliteWriteQueue(const SqliteWriteQueue&) = delete;
+    SqliteWriteQueue& operator=(const SqliteWriteQueue&) = delete;
+
+    bool Open(const std::string& path, const WriteQueueOptions& options, std::string* error);
+    // Commits whatever is queued and stops the writer; Enqueue is ignored
+    // afterwards
+    void Close();
+
+    void Enqueue(std::string sql, SqlParams params);
+    // Barrier: |done| runs on the writer thread once every write enqueued
+    // before the call has committed, or with the error of the commit
+    // that failed
+    void Flush(std::function<void(bool ok, const std::string& error)> done);
+
+    WriteQueueStats Stats() const;
+
+private:
+    struct Write {
+        std::string sql;
+        SqlParams params;
+    };
+    using FlushCallback = std::function<void(bool ok, const std::string& error)>;
+
+    void Run();
+    bool Commit(const std::vector<Write>& batch, uint64_t* rejected, std::string* error);
+
+    WriteQueueOptions options_;
+    SqliteStore store_{16};
+    std::thread thread_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<Write> pending_;
+    std::vector<FlushCallback> flushes_;
+    std::chrono::steady_clock::time_point oldest_;
+    bool stopping_ = false;
+    bool running_ = false;
+    WriteQueueStats stats_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <CoreAudio/CoreAudio.h>
+#include "capture_backend.h"
+#include "capture_stats.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// System output capture through a Core Audio process tap (macOS 14.2+).
+// A private global tap is attached to a private aggregate device whose main
+// subdevice is the current default output, and a HAL IOProc on that aggregate
+// hands mono float frames to |sink|. This replaces the audiotee subprocess.
+//
+// With processes set, the tap mixes only theirs (the meeting app) instead of
+// the whole output, and follows them as they start and quit.
+//
+// With an input device set, the aggregate also carries that device as a
+// drift-compensated subdevice: mic and tap frames then arrive in the same
+// IOProc with the same timestamp, on the output device's sample clock.
+//
+// Implemented in Objective-C++ (system_audio_tap.mm) because the tap is
+// described with CATapDescription; this header stays plain C++.
+class SystemAudioTap {
+public:
+    SystemAudioTap(RealtimeSink sink, void* sink_context);
+    ~SystemAudioTap();
+
+    SystemAudioTap(const SystemAudioTap&) = delete;
+    SystemAudioTap& operator=(const SystemAudioTap&) = delete;
+
+    static bool IsSupported();
+
+    // Routes |device|'s input, downmixed to mono, to |sink| from the tap's
+    // IOProc. Call before Create(); the aggregate must then run at 48kHz.
+    void SetInputDevice(AudioObjectID device, RealtimeSink sink, void* sink_context);
+    bool HasInputDevice() const { return input_device_ != kAudioObjectUnknown; }
+
+    // Taps only processes whose bundle ID starts with one of |bundle_ids|
+    // ("com.google.Chrome" takes its helpers) or whose PID is in |pids|.
+    // Call before Create(); both empty taps every process.
+    void SetProcesses(std::vector<std::string> bundle_ids, std::vector<int32_t> pids);
+
+    // Creates the tap and aggregate device and reads the tap format.
+    bool Create(std::string* error);
+
+    // Creates the IOProc and starts IO. Create() must have succeeded.
+    bool Start(std::string* error);
+
+    // Stops IO; frames stop arriving once this returns.
+    void Stop();
+
+    // Destroys the aggregate device and the tap.
+    void Destroy();
+
+    // Counters for the tap IOProc (timing, oversized buffers, overloads).
+    // Must be set before Start() and outlive Stop().
+    void SetStats(CaptureStats* stats) { stats_ = stats; }
+
+    bool IsRunning() const { return running_; }
+    double SampleRate() const { return sample_rate_; }
+    uint32_t Channels() const { return channels_; }
+
+    // Private aggregate the IOProc runs on; kAudioObjectUnknown when stopped
+    AudioObjectID AggregateDevice() const { return aggregate_id_; }
+
+private:
+    static OSStatus IOProc(AudioObjectID device,
+                           const AudioTimeStamp* now,
+                           const AudioBufferList* input_data,
+                           const AudioTimeStamp* input_time,
+                           AudioBufferList* output_data,
+                           const AudioTimeStamp* output_time,
+                           void* client_data);
+    static OSStatus OverloadListener(AudioObjectID object,
+                                     UInt32 num_addresses,
+                                     const AudioObjectPropertyAddress* addresses,
+                                     void* client_data);
+    static OSStatus ProcessListListener(AudioObjectID object,
+                                        UInt32 num_addresses,
+                                        const AudioObjectPropertyAddress* addresses,
+                                        void* client_data);
+
+    bool FiltersProcesses() const { return !bundle_ids_.empty() || !pids_.empty(); }
+    // Re-describes the tap with the processes now matching; HAL notification thread
+    void UpdateProcesses();
+
+    RealtimeSink sink_;
+    void* sink_context_;
+    CaptureStats* stats_ = nullptr;
+
+    AudioObjectID input_device_ = kAudioObjectUnknown;
+    RealtimeSink input_sink_ = nullptr;
+    void* input_sink_context_ = nullptr;
+
+    std::vector<std::string> bundle_ids_;
+    std::vector<int32_t> pids_;
+    void* description_ = nullptr;  // CATapDescription, retained while filtering processes
+    std::vector<AudioObjectID> tapped_processes_;
+
+    AudioObjectID tap_id_ = kAudioObjectUnknown;
+    AudioObjectID aggregate_id_ = kAudioObjectUnknown;
+    AudioDeviceIOProcID io_proc_id_ = nullptr;
+    bool running_ = false;
+
+    double sample_rate_ = 48000.0;
+    uint32_t channels_ = 1;
+
+    // Positions in the IOProc's input buffer list: subdevice streams in
+    // subdevice order, then the tap
+    uint32_t tap_buffer_ = 0;
+    uint32_t input_buffer_ = 0;
+
+    // Interleaved multichannel buffers are downmixed into these preallocated
+    // buffers
+    std::vector<float> downmix_;
+    std::vector<float> input_downmix_;
+};
+
+} // namespace kakarot
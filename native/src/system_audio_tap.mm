@@ -0,0 +1,493 @@
+#import <Foundation/Foundation.h>
+#import <CoreAudio/CoreAudio.h>
+#import <CoreAudio/AudioHardwareTapping.h>
+#import <CoreAudio/CATapDescription.h>
+#include "system_audio_tap.h"
+#include "pipeline_trace.h"
+#include <mach/mach_time.h>
+#include <algorithm>
+#include <iostream>
+
+namespace kakarot {
+
+// Largest IOProc buffer we downmix; matches the mic path's sanity limit
+static constexpr uint32_t kMaxTapFrames = 48000;
+
+static const AudioObjectPropertyAddress kOverloadAddress = {
+    kAudioDeviceProcessorOverload,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+static const AudioObjectPropertyAddress kProcessListAddress = {
+    kAudioHardwarePropertyProcessObjectList,
+    kAudioObjectPropertyScopeGlobal,
+    kAudioObjectPropertyElementMain
+};
+
+static AudioObjectID GetDefaultOutputDevice() {
+    AudioObjectID device = kAudioObjectUnknown;
+    AudioObjectPropertyAddress address = {
+        kAudioHardwarePropertyDefaultOutputDevice,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 size = sizeof(device);
+    AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, &device);
+    return device;
+}
+
+static NSString* GetDeviceUID(AudioObjectID device) {
+    CFStringRef uid = nullptr;
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyDeviceUID,
+        kAudioObjectPropertyScopeGlobal,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 size = sizeof(uid);
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &uid) != noErr || !uid) {
+        return nil;
+    }
+    return (__bridge_transfer NSString*)uid;
+}
+
+static UInt32 InputStreamCount(AudioObjectID device) {
+    AudioObjectPropertyAddress address = {
+        kAudioDevicePropertyStreams,
+        kAudioObjectPropertyScopeInput,
+        kAudioObjectPropertyElementMain
+    };
+    UInt32 size = 0;
+    if (AudioObjectGetPropertyDataSize(device, &address, 0, nullptr, &size) != noErr) {
+        return 0;
+    }
+    return size / sizeof(AudioStreamID);
+}
+
+// Process objects (every process that has opened audio) whose bundle ID
+// starts with one of |bundle_ids| or whose PID is in |pids|, sorted
+static std::vector<AudioObjectID> MatchingProcesses(const std::vector<std::string>& bundle_ids,
+                                                    const std::vector<int32_t>& pids) {
+    std::vector<AudioObjectID> matches;
+    UInt32 size = 0;
+    if (AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &kProcessListAddress, 0, nullptr, &size) != noErr) {
+        return matches;
+    }
+    std::vector<AudioObjectID> processes(size / sizeof(AudioObjectID));
+    if (processes.empty() ||
+        AudioObjectGetPropertyData(kAudioObjectSystemObject, &kProcessListAddress, 0, nullptr, &size,
+                                   processes.data()) != noErr) {
+        return matches;
+    }
+    processes.resize(size / sizeof(AudioObjectID));
+
+    for (AudioObjectID process : processes) {
+        pid_t pid = -1;
+        AudioObjectPropertyAddress pid_address = {
+            kAudioProcessPropertyPID,
+            kAudioObjectPropertyScopeGlobal,
+            kAudioObjectPropertyElementMain
+        };
+        UInt32 pid_size = sizeof(pid);
+        AudioObjectGetPropertyData(process, &pid_address, 0, nullptr, &pid_size, &pid);
+        bool match = std::find(pids.begin(), pids.end(), pid) != pids.end();
+
+        CFStringRef bundle = nullptr;
+        AudioObjectPropertyAddress bundle_address = {
+            kAudioProcessPropertyBundleID,
+            kAudioObjectPropertyScopeGlobal,
+            kAudioObjectPropertyElementMain
+        };
+        UInt32 bundle_size = sizeof(bundle);
+        if (!match && !bundle_ids.empty() &&
+            AudioObjectGetPropertyData(process, &bundle_address, 0, nullptr, &bundle_size, &bundle) == noErr && bundle) {
+            NSString* bundle_id = (__bridge_transfer NSString*)bundle;
+            std::string id = bundle_id.UTF8String ? bundle_id.UTF8String : "";
+            for (const std::string& prefix : bundle_ids) {
+                match = match || id.compare(0, prefix.size(), prefix) == 0;
+            }
+        }
+        if (match) {
+            matches.push_back(process);
+        }
+    }
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+static NSArray<NSNumber*>* ProcessArray(const std::vector<AudioObjectID>& processes) {
+    NSMutableArray<NSNumber*>* array = [NSMutableArray arrayWithCapacity:processes.size()];
+    for (AudioObjectID process : processes) {
+        [array addObject:@(process)];
+    }
+    return array;
+}
+
+// Mono view of an interleaved buffer: the data itself, or the channel
+// average written to |scratch|. Null when the buffer does not fit.
+static const float* MonoFrames(const AudioBuffer& buffer, uint32_t frames, std::vector<float>& scratch) {
+    const float* samples = static_cast<const float*>(buffer.mData);
+    const uint32_t channels = std::max<uint32_t>(1, buffer.mNumberChannels);
+    if (channels == 1) {
+        return samples;
+    }
+    if (scratch.size() < frames) {
+        return nullptr;
+    }
+    const float scale = 1.0f / channels;
+    float* mono = scratch.data();
+    for (uint32_t i = 0; i < frames; ++i) {
+        float sum = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c) {
+            sum += samples[i * channels + c];
+        }
+        mono[i] = sum * scale;
+    }
+    return mono;
+}
+
+SystemAudioTap::SystemAudioTap(RealtimeSink sink, void* sink_context)
+    : sink_(sink), sink_context_(sink_context) {}
+
+SystemAudioTap::~SystemAudioTap() {
+    Stop();
+    Destroy();
+}
+
+bool SystemAudioTap::IsSupported() {
+    if (@available(macOS 14.2, *)) {
+        return true;
+    }
+    return false;
+}
+
+void SystemAudioTap::SetInputDevice(AudioObjectID device, RealtimeSink sink, void* sink_context) {
+    input_device_ = device;
+    input_sink_ = sink;
+    input_sink_context_ = sink_context;
+}
+
+void SystemAudioTap::SetProcesses(std::vector<std::string> bundle_ids, std::vector<int32_t> pids) {
+    bundle_ids_ = std::move(bundle_ids);
+    pids_ = std::move(pids);
+}
+
+bool SystemAudioTap::Create(std::string* error) {
+    if (!IsSupported()) {
+        *error = "Process taps require macOS 14.2 or later";
+        return false;
+    }
+
+    if (@available(macOS 14.2, *)) {
+        // STEP 1: Private, unmuted mono tap of every process's output, or
+        // of just the matching ones' (none yet is a tap of silence)
+        CATapDescription* description = nil;
+        if (FiltersProcesses()) {
+            tapped_processes_ = MatchingProcesses(bundle_ids_, pids_);
+            description = [[CATapDescription alloc] initMonoMixdownOfProcesses:ProcessArray(tapped_processes_)];
+        } else {
+            description = [[CATapDescription alloc] initMonoGlobalTapButExcludeProcesses:@[]];
+        }
+        description.name = @"Kakarot System Audio";
+        description.privateTap = YES;
+        description.muteBehavior = CATapUnmuted;
+
+        OSStatus status = AudioHardwareCreateProcessTap(description, &tap_id_);
+        if (status != noErr || tap_id_ == kAudioObjectUnknown) {
+            *error = "Failed to create process tap (error " + std::to_string(status) + ")";
+            tap_id_ = kAudioObjectUnknown;
+            return false;
+        }
+        std::cout << "✅ System tap: created process tap " << tap_id_ << std::endl;
+
+        // Apps that open audio later (or restart) join the tap as they appear
+        if (FiltersProcesses()) {
+            description_ = (void*)CFBridgingRetain(description);
+            AudioObjectAddPropertyListener(kAudioObjectSystemObject, &kProcessListAddress,
+                                           &SystemAudioTap::ProcessListListener, this);
+            std::cout << "✅ System tap: " << tapped_processes_.size() << " matching process(es)" << std::endl;
+        }
+
+        // STEP 2: Private aggregate device clocked by the default output
+        AudioObjectID output_device = GetDefaultOutputDevice();
+        NSString* outputUID = GetDeviceUID(output_device);
+        if (!outputUID) {
+            *error = "Failed to get default output device UID";
+            Destroy();
+            return false;
+        }
+
+        // The input device follows the output's clock; the HAL resamples it
+        // to track the drift. A headset that is both is already in the list.
+        NSMutableArray* subdevices = [NSMutableArray arrayWithObject:@{ @(kAudioSubDeviceUIDKey): outputUID }];
+        UInt32 output_inputs = InputStreamCount(output_device);
+        UInt32 input_streams = 0;
+        if (HasInputDevice() && input_device_ == output_device) {
+            input_buffer_ = 0;
+            input_streams = output_inputs;
+        } else if (HasInputDevice()) {
+            NSString* inputUID = GetDeviceUID(input_device_);
+            if (!inputUID) {
+                *error = "Failed to get input device UID";
+                Destroy();
+                return false;
+            }
+            [subdevices addObject:@{
+                @(kAudioSubDeviceUIDKey): inputUID,
+                @(kAudioSubDeviceDriftCompensationKey): @YES
+            }];
+            input_buffer_ = output_inputs;
+            input_streams = InputStreamCount(input_device_);
+            output_inputs += input_streams;
+        }
+        if (HasInputDevice() && input_streams == 0) {
+            *error = "Input device has no input streams";
+            Destroy();
+            return false;
+        }
+        tap_buffer_ = output_inputs;
+
+        NSDictionary* aggregate = @{
+            @(kAudioAggregateDeviceNameKey): @"Kakarot System Tap",
+            @(kAudioAggregateDeviceUIDKey): [[NSUUID UUID] UUIDString],
+            @(kAudioAggregateDeviceMainSubDeviceKey): outputUID,
+            @(kAudioAggregateDeviceIsPrivateKey): @YES,
+            @(kAudioAggregateDeviceIsStackedKey): @NO,
+            @(kAudioAggregateDeviceTapAutoStartKey): @YES,
+            @(kAudioAggregateDeviceSubDeviceListKey): subdevices,
+            @(kAudioAggregateDeviceTapListKey): @[
+                @{
+                    @(kAudioSubTapDriftCompensationKey): @YES,
+                    @(kAudioSubTapUIDKey): [description.UUID UUIDString]
+                }
+            ],
+        };
+
+        status = AudioHardwareCreateAggregateDevice((__bridge CFDictionaryRef)aggregate, &aggregate_id_);
+        if (status != noErr || aggregate_id_ == kAudioObjectUnknown) {
+            *error = "Failed to create tap aggregate device (error " + std::to_string(status) + ")";
+            aggregate_id_ = kAudioObjectUnknown;
+            Destroy();
+            return false;
+        }
+        std::cout << "✅ System tap: created aggregate device " << aggregate_id_ << std::endl;
+
+        // The buffer indices assume subdevice streams come first, in order
+        if (InputStreamCount(aggregate_id_) != tap_buffer_ + 1) {
+            *error = "Unexpected tap aggregate stream layout";
+            Destroy();
+            return false;
+        }
+
+        // STEP 3: Tap stream format (float32 at the output device rate)
+        AudioStreamBasicDescription format = {};
+        AudioObjectPropertyAddress formatAddress = {
+            kAudioTapPropertyFormat,
+            kAudioObjectPropertyScopeGlobal,
+            kAudioObjectPropertyElementMain
+        };
+        UInt32 size = sizeof(format);
+        status = AudioObjectGetPropertyData(tap_id_, &formatAddress, 0, nullptr, &size, &format);
+        if (status != noErr || format.mFormatID != kAudioFormatLinearPCM ||
+            !(format.mFormatFlags & kAudioFormatFlagIsFloat)) {
+            *error = "Unsupported process tap format";
+            Destroy();
+            return false;
+        }
+
+        sample_rate_ = format.mSampleRate;
+        channels_ = std::max<UInt32>(1, format.mChannelsPerFrame);
+        if (channels_ > 1) {
+            downmix_.assign(kMaxTapFrames, 0.0f);
+        }
+        std::cout << "✅ System tap: " << sample_rate_ << "Hz, " << channels_ << " channel(s)" << std::endl;
+
+        if (HasInputDevice()) {
+            // Input frames run at the aggregate rate, which the mic path
+            // cannot resample
+            if (sample_rate_ != 48000.0) {
+                *error = "Shared-clock capture needs the output device at 48kHz";
+                Destroy();
+                return false;
+            }
+            input_downmix_.assign(kMaxTapFrames, 0.0f);
+            std::cout << "✅ System tap: input device " << input_device_ << " shares the output clock" << std::endl;
+        }
+    }
+
+    return true;
+}
+
+bool SystemAudioTap::Start(std::string* error) {
+    if (aggregate_id_ == kAudioObjectUnknown) {
+        *error = "System tap not created";
+        return false;
+    }
+    if (running_) {
+        return true;
+    }
+
+    OSStatus status = AudioDeviceCreateIOProcID(aggregate_id_, &SystemAudioTap::IOProc, this, &io_proc_id_);
+    if (status != noErr) {
+        *error = "Failed to create system tap IOProc (error " + std::to_string(status) + ")";
+        io_proc_id_ = nullptr;
+        return false;
+    }
+
+    status = AudioDeviceStart(aggregate_id_, io_proc_id_);
+    if (status != noErr) {
+        AudioDeviceDestroyIOProcID(aggregate_id_, io_proc_id_);
+        io_proc_id_ = nullptr;
+        *error = "Failed to start system tap device (error " + std::to_string(status) + ")";
+        return false;
+    }
+
+    if (stats_) {
+        AudioObjectAddPropertyListener(aggregate_id_, &kOverloadAddress, &SystemAudioTap::OverloadListener, this);
+    }
+
+    running_ = true;
+    std::cout << "✅ System tap: capture started" << std::endl;
+    return true;
+}
+
+void SystemAudioTap::Stop() {
+    if (aggregate_id_ != kAudioObjectUnknown && io_proc_id_ != nullptr) {
+        if (stats_) {
+            AudioObjectRemovePropertyListener(aggregate_id_, &kOverloadAddress, &SystemAudioTap::OverloadListener, this);
+        }
+        AudioDeviceStop(aggregate_id_, io_proc_id_);
+        AudioDeviceDestroyIOProcID(aggregate_id_, io_proc_id_);
+        io_proc_id_ = nullptr;
+    }
+    running_ = false;
+}
+
+void SystemAudioTap::Destroy() {
+    if (description_) {
+        AudioObjectRemovePropertyListener(kAudioObjectSystemObject, &kProcessListAddress,
+                                          &SystemAudioTap::ProcessListListener, this);
+        CFRelease(description_);
+        description_ = nullptr;
+    }
+    if (aggregate_id_ != kAudioObjectUnknown) {
+        AudioHardwareDestroyAggregateDevice(aggregate_id_);
+        aggregate_id_ = kAudioObjectUnknown;
+    }
+    if (tap_id_ != kAudioObjectUnknown) {
+        if (@available(macOS 14.2, *)) {
+            AudioHardwareDestroyProcessTap(tap_id_);
+        }
+        tap_id_ = kAudioObjectUnknown;
+    }
+}
+
+// HAL notification thread
+OSStatus SystemAudioTap::OverloadListener(AudioObjectID /*object*/,
+                                          UInt32 /*num_addresses*/,
+                                          const AudioObjectPropertyAddress* /*addresses*/,
+                                          void* client_data) {
+    SystemAudioTap* self = static_cast<SystemAudioTap*>(client_data);
+    self->stats_->overloads.fetch_add(1, std::memory_order_relaxed);
+    return noErr;
+}
+
+// HAL notification thread
+OSStatus SystemAudioTap::ProcessListListener(AudioObjectID /*object*/,
+                                             UInt32 /*num_addresses*/,
+                                             const AudioObjectPropertyAddress* /*addresses*/,
+                                             void* client_data) {
+    static_cast<SystemAudioTap*>(client_data)->UpdateProcesses();
+    return noErr;
+}
+
+void SystemAudioTap::UpdateProcesses() {
+    if (!description_ || tap_id_ == kAudioObjectUnknown) {
+        return;
+    }
+    std::vector<AudioObjectID> processes = MatchingProcesses(bundle_ids_, pids_);
+    if (processes == tapped_processes_) {
+        return;
+    }
+    if (@available(macOS 14.2, *)) {
+        CATapDescription* description = (__bridge CATapDescription*)description_;
+        description.processes = ProcessArray(processes);
+        AudioObjectPropertyAddress address = {
+            kAudioTapPropertyDescription,
+            kAudioObjectPropertyScopeGlobal,
+            kAudioObjectPropertyElementMain
+        };
+        CFTypeRef value = (__bridge CFTypeRef)description;
+        OSStatus status = AudioObjectSetPropertyData(tap_id_, &address, 0, nullptr, sizeof(value), &value);
+        if (status != noErr) {
+            std::cerr << "❌ System tap: failed to update tapped processes (error " << status << ")" << std::endl;
+            return;
+        }
+        tapped_processes_ = std::move(processes);
+        std::cout << "✅ System tap: now " << tapped_processes_.size() << " matching process(es)" << std::endl;
+    }
+}
+
+// Runs on the CoreAudio real-time thread
+OSStatus SystemAudioTap::IOProc(AudioObjectID /*device*/,
+                                const AudioTimeStamp* /*now*/,
+                                const AudioBufferList* input_data,
+                                const AudioTimeStamp* input_time,
+                                AudioBufferList* /*output_data*/,
+                                const AudioTimeStamp* /*output_time*/,
+                                void* client_data) {
+    SystemAudioTap* self = static_cast<SystemAudioTap*>(client_data);
+    if (!self || !input_data || input_data->mNumberBuffers <= self->tap_buffer_) {
+        return noErr;
+    }
+
+    const AudioBuffer& buffer = input_data->mBuffers[self->tap_buffer_];
+    if (!buffer.mData || buffer.mDataByteSize == 0) {
+        return noErr;
+    }
+
+    const uint64_t callback_start = mach_absolute_time();
+    uint64_t host_time = (input_time && (input_time->mFlags & kAudioTimeStampHostTimeValid))
+        ? input_time->mHostTime
+        : callback_start;
+
+    const uint32_t channels = std::max<uint32_t>(1, buffer.mNumberChannels);
+    const uint32_t frames = buffer.mDataByteSize / (sizeof(float) * channels);
+    TraceScope trace(TraceEvent::kSystemTapIOProc, frames);
+    if (frames == 0 || frames > kMaxTapFrames) {
+        if (self->stats_ && frames > 0) {
+            self->stats_->buffers_oversized.fetch_add(1, std::memory_order_relaxed);
+        }
+        return noErr;
+    }
+
+    // Interleaved: average channels into the preallocated mono buffer
+    const float* mono = MonoFrames(buffer, frames, self->downmix_);
+    if (!mono) {
+        if (self->stats_) {
+            self->stats_->buffers_oversized.fetch_add(1, std::memory_order_relaxed);
+        }
+        return noErr;
+    }
+    self->sink_(self->sink_context_, mono, frames, host_time);
+
+    // Shared clock: the input's buffer covers the same frames, so it carries
+    // the same timestamp
+    if (self->input_sink_ && self->input_buffer_ < input_data->mNumberBuffers) {
+        const AudioBuffer& input = input_data->mBuffers[self->input_buffer_];
+        const uint32_t input_channels = std::max<uint32_t>(1, input.mNumberChannels);
+        const uint32_t input_frames = input.mDataByteSize / (sizeof(float) * input_channels);
+        const float* input_mono = (input.mData && input_frames > 0 && input_frames <= kMaxTapFrames)
+            ? MonoFrames(input, input_frames, self->input_downmix_) : nullptr;
+        if (input_mono) {
+            self->input_sink_(self->input_sink_context_, input_mono, input_frames, host_time);
+        }
+    }
+
+    if (self->stats_) {
+        self->stats_->RecordCallback(callback_start, mach_absolute_time());
+    }
+    return noErr;
+}
+
+} // namespace kakarot
@@ -0,0 +1,342 @@
+#include "talk_analytics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+namespace kakarot {
+
+namespace internal {
+std::atomic<bool> g_talk_analytics_running{false};
+}
+
+static constexpr double kSlotMs = 10.0;
+
+// Slots of the timeline held unsettled (about 10s): a party further behind
+// than this finds its frames already judged without them
+static constexpr int64_t kSlots = 1024;
+
+// A party that fed nothing for two seconds stops holding the timeline back
+static constexpr int64_t kStaleSlots = 200;
+
+// A question counts as answered when the floor passes within a second of it
+static constexpr int64_t kQuestionSlots = 100;
+
+const char* TalkPartyName(TalkParty party) {
+    switch (party) {
+        case TalkParty::kLocal:
+            return "local";
+        case TalkParty::kRemote:
+            return "remote";
+        case TalkParty::kNone:
+            break;
+    }
+    return "none";
+}
+
+namespace {
+
+struct Party {
+    int64_t head = -1;            // newest slot written; -1 before any
+    bool in_utterance = false;
+    int64_t run = 0;              // voiced slots in a row, before an utterance
+    int64_t run_first = 0;
+    int64_t utterance_start = 0;
+    int64_t last_voiced = 0;
+    bool overlapped = false;      // the open utterance began over the other party
+    int64_t turn_start = 0;
+    int64_t turn_end = 0;         // end of the turn's newest utterance
+    int64_t last_end = -1;
+    int64_t question = -1;        // the newest question not yet answered
+};
+
+struct Analytics {
+    std::mutex mutex;
+    bool running = false;
+    TalkAnalyticsOptions options;
+    int64_t min_frames = 15;
+    int64_t trailing_frames = 50;
+    bool has_origin = false;
+    double origin_ms = 0.0;       // host time of slot 0
+    int64_t next = 0;             // first slot not yet settled
+    uint8_t voiced[kSlots][kTalkPartyCount] = {};
+    Party parties[kTalkPartyCount];
+    int floor = -1;               // the party holding it; -1 before anyone spoke
+
+    // The last floor change, for a question reported after it
+    int floor_from = -1;
+    int64_t floor_from_end = -1;
+    int64_t floor_at = 0;
+    bool floor_answered = true;
+
+    TalkAnalyticsTotals totals;
+};
+
+Analytics g_analytics;
+
+void CountResponse(Analytics* a, int responder, int64_t question_end, int64_t answer_start) {
+    TalkPartyTotals& totals = a->totals.parties[responder];
+    const double latency = static_cast<double>(std::max<int64_t>(0, answer_start - question_end)) * kSlotMs;
+    ++totals.responses;
+    totals.response_latency_sum_ms += latency;
+    totals.response_latency_max_ms = std::max(totals.response_latency_max_ms, latency);
+}
+
+void TakeFloor(Analytics* a, int p, int64_t at) {
+    if (a->floor == p) {
+        return;
+    }
+    if (a->floor >= 0) {
+        const int from = a->floor;
+        Party& previous = a->parties[from];
+        // Its utterance may be open still, in its trailing silence
+        const int64_t end = previous.in_utterance ? previous.last_voiced + 1 : previous.last_end;
+        previous.turn_end = end;
+        TalkPartyTotals& totals = a->totals.parties[from];
+        totals.longest_turn_ms = std::max(totals.longest_turn_ms,
+                                          static_cast<double>(previous.turn_end - previous.turn_start) * kSlotMs);
+        a->floor_from = from;
+        a->floor_from_end = end;
+        a->floor_at = at;
+        a->floor_answered = false;
+        if (previous.question >= 0 && previous.question >= end - kQuestionSlots) {
+            CountResponse(a, p, end, at);
+            a->floor_answered = true;
+        }
+        previous.question = -1;
+    }
+    Party& party = a->parties[p];
+    a->floor = p;
+    party.turn_start = at;
+    party.turn_end = at;
+    ++a->totals.parties[p].turns;
+}
+
+void StartUtterance(Analytics* a, int p, int64_t at) {
+    Party& party = a->parties[p];
+    Party& other = a->parties[1 - p];
+    party.in_utterance = true;
+    party.utterance_start = at;
+    ++a->totals.parties[p].utterances;
+    // The other's utterance is open until its trailing silence runs out;
+    // only speech from |at| on is spoken over
+    if (other.in_utterance && other.last_voiced >= at) {
+        party.overlapped = true;
+        ++a->totals.parties[p].overlaps;
+    } else {
+        TakeFloor(a, p, at);
+    }
+}
+
+void EndUtterance(Analytics* a, int p, int64_t at) {
+    Party& party = a->parties[p];
+    Party& other = a->parties[1 - p];
+    party.in_utterance = false;
+    party.overlapped = false;
+    party.last_end = at;
+    a->totals.parties[p].talk_ms += static_cast<double>(at - party.utterance_start) * kSlotMs;
+    if (a->floor == p) {
+        party.turn_end = at;
+    }
+    // Spoken over and outlasted: the other party has the floor from when
+    // it started
+    if (other.in_utterance && other.overlapped) {
+        other.overlapped = false;
+        ++a->totals.parties[1 - p].interruptions;
+        TakeFloor(a, 1 - p, other.utterance_start);
+    }
+}
+
+void SettleSlot(Analytics* a, int64_t slot) {
+    uint8_t* voiced = a->voiced[slot % kSlots];
+    if (voiced[0] && voiced[1]) {
+        a->totals.overlap_ms += kSlotMs;
+    }
+
+    // Ends go first, so speech resuming as the other side stops is no overlap
+    bool starts[kTalkPartyCount] = {};
+    for (int p = 0; p < static_cast<int>(kTalkPartyCount); ++p) {
+        Party& party = a->parties[p];
+        if (party.in_utterance) {
+            if (voiced[p]) {
+                party.last_voiced = slot;
+            } else if (slot - party.last_voiced >= a->trailing_frames) {
+                EndUtterance(a, p, party.last_voiced + 1);
+            }
+        } else if (voiced[p]) {
+            if (party.run++ == 0) {
+                party.run_first = slot;
+            }
+            starts[p] = party.run >= a->min_frames;
+        } else {
+            party.run = 0;
+        }
+    }
+    for (int p = 0; p < static_cast<int>(kTalkPartyCount); ++p) {
+        if (starts[p]) {
+            Party& party = a->parties[p];
+            StartUtterance(a, p, party.run_first);
+            party.last_voiced = slot;
+            party.run = 0;
+        }
+    }
+    voiced[0] = voiced[1] = 0;
+}
+
+void SettleTo(Analytics* a, int64_t until) {
+    while (a->next < until) {
+        SettleSlot(a, a->next++);
+    }
+}
+
+// As far as every party still feeding has reached
+void Advance(Analytics* a) {
+    int64_t newest = -1;
+    for (const Party& party : a->parties) {
+        newest = std::max(newest, party.head);
+    }
+    int64_t until = newest + 1;
+    for (const Party& party : a->parties) {
+        if (party.head >= 0 && party.head >= newest - kStaleSlots) {
+            until = std::min(until, party.head + 1);
+        }
+    }
+    SettleTo(a, until);
+}
+
+int64_t SlotAt(const Analytics& a, double host_ms) {
+    return static_cast<int64_t>(std::llround((host_ms - a.origin_ms) / kSlotMs));
+}
+
+} // namespace
+
+bool StartTalkAnalytics(const TalkAnalyticsOptions& options) {
+    Analytics* a = &g_analytics;
+    std::lock_guard<std::mutex> lock(a->mutex);
+    if (a->running) {
+        return false;
+    }
+    a->options = options;
+    a->min_frames = std::max<int64_t>(1, static_cast<int64_t>(std::lround(options.min_speech_ms / kSlotMs)));
+    a->trailing_frames = std::max<int64_t>(1, static_cast<int64_t>(std::lround(options.trailing_silence_ms / kSlotMs)));
+    a->has_origin = false;
+    a->origin_ms = 0.0;
+    a->next = 0;
+    std::memset(a->voiced, 0, sizeof(a->voiced));
+    for (Party& party : a->parties) {
+        party = Party();
+    }
+    a->floor = -1;
+    a->floor_from = -1;
+    a->floor_answered = true;
+    a->totals = TalkAnalyticsTotals();
+    a->running = true;
+    internal::g_talk_analytics_running.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+TalkAnalyticsTotals StopTalkAnalytics() {
+    Analytics* a = &g_analytics;
+    std::lock_guard<std::mutex> lock(a->mutex);
+    internal::g_talk_analytics_running.store(false, std::memory_order_relaxed);
+    if (!a->running) {
+        return a->totals;
+    }
+    a->running = false;
+
+    int64_t newest = -1;
+    for (const Party& party : a->parties) {
+        newest = std::max(newest, party.head);
+    }
+    SettleTo(a, newest + 1);
+    for (int p = 0; p < static_cast<int>(kTalkPartyCount); ++p) {
+        if (a->parties[p].in_utterance) {
+            EndUtterance(a, p, a->parties[p].last_voiced + 1);
+        }
+    }
+    if (a->floor >= 0) {
+        const Party& party = a->parties[a->floor];
+        TalkPartyTotals& totals = a->totals.parties[a->floor];
+        totals.longest_turn_ms = std::max(totals.longest_turn_ms,
+                                          static_cast<double>(party.turn_end - party.turn_start) * kSlotMs);
+    }
+    a->totals.elapsed_ms = static_cast<double>(a->next) * kSlotMs;
+    return a->totals;
+}
+
+bool TalkAnalyticsSnapshot(TalkAnalyticsTotals* totals) {
+    Analytics* a = &g_analytics;
+    std::lock_guard<std::mutex> lock(a->mutex);
+    *totals = a->totals;
+    totals->elapsed_ms = static_cast<double>(a->next) * kSlotMs;
+    if (!a->running) {
+        return false;
+    }
+    for (size_t p = 0; p < kTalkPartyCount; ++p) {
+        const Party& party = a->parties[p];
+        if (party.in_utterance) {
+            totals->parties[p].talk_ms += static_cast<double>(a->next - party.utterance_start) * kSlotMs;
+        }
+    }
+    if (a->floor >= 0) {
+        const Party& party = a->parties[a->floor];
+        const int64_t end = party.in_utterance ? a->next : party.turn_end;
+        TalkPartyTotals& held = totals->parties[a->floor];
+        held.longest_turn_ms = std::max(held.longest_turn_ms, static_cast<double>(end - party.turn_start) * kSlotMs);
+    }
+    return true;
+}
+
+void AddTalkFrames(TalkParty party, double first_host_ms, const float* probabilities, size_t count) {
+    if (party == TalkParty::kNone || count == 0) {
+        return;
+    }
+    Analytics* a = &g_analytics;
+    std::lock_guard<std::mutex> lock(a->mutex);
+    if (!a->running) {
+        return;
+    }
+    if (!a->has_origin) {
+        a->has_origin = true;
+        a->origin_ms = first_host_ms;
+    }
+    const int p = static_cast<int>(party);
+    Party& state = a->parties[p];
+    const int64_t first = SlotAt(*a, first_host_ms);
+    for (size_t i = 0; i < count; ++i) {
+        const int64_t slot = first + static_cast<int64_t>(i);
+        if (slot < a->next) {
+            continue;  // settled without it
+        }
+        if (slot >= a->next + kSlots) {
+            SettleTo(a, slot - kSlots + 1);
+        }
+        a->voiced[slot % kSlots][p] = probabilities[i] >= a->options.threshold ? 1 : 0;
+        state.head = std::max(state.head, slot);
+    }
+    Advance(a);
+}
+
+void AddTalkQuestion(TalkParty party, double host_ms, float question_likelihood) {
+    if (party == TalkParty::kNone) {
+        return;
+    }
+    Analytics* a = &g_analytics;
+    std::lock_guard<std::mutex> lock(a->mutex);
+    if (!a->running || !a->has_origin || question_likelihood < a->options.question_threshold) {
+        return;
+    }
+    const int p = static_cast<int>(party);
+    const int64_t slot = SlotAt(*a, host_ms);
+    ++a->totals.parties[p].questions;
+    // Reported after the floor already passed on: answered there
+    if (a->floor == 1 - p && a->floor_from == p && !a->floor_answered &&
+        std::llabs(slot - a->floor_from_end) <= kQuestionSlots) {
+        CountResponse(a, 1 - p, a->floor_from_end, a->floor_at);
+        a->floor_answered = true;
+        return;
+    }
+    a->parties[p].question = slot;
+}
+
+} // namespace kakarot
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace kakarot {
+
+// Who a stream's speech belongs to in the meeting's talk analytics
+enum class TalkParty : int8_t {
+    kNone = -1,  // not counted
+    kLocal,      // the microphone
+    kRemote,     // system audio: every remote participant together
+};
+constexpr size_t kTalkPartyCount = 2;
+
+const char* TalkPartyName(TalkParty party);
+
+struct TalkAnalyticsOptions {
+    float threshold = 0.5f;              // speech probability of a voiced frame
+    double min_speech_ms = 150.0;        // voiced run that starts an utterance
+    double trailing_silence_ms = 500.0;  // silence that ends one
+    float question_threshold = 0.5f;     // prosody question likelihood of a question
+};
+
+struct TalkPartyTotals {
+    double talk_ms = 0.0;            // utterances, start to end
+    uint32_t utterances = 0;
+    uint32_t turns = 0;              // times it took the floor
+    double longest_turn_ms = 0.0;    // longest monologue: the floor held, pauses included
+    uint32_t overlaps = 0;           // utterances begun while the other party spoke
+    uint32_t interruptions = 0;      // of those, ones the other party stopped for
+    uint32_t questions = 0;          // utterances ending like a question (prosody option)
+    uint32_t responses = 0;          // the other party's questions answered by taking the floor
+    double response_latency_sum_ms = 0.0;  // question's end to the answer's start, 0 when overlapping
+    double response_latency_max_ms = 0.0;
+};
+
+struct TalkAnalyticsTotals {
+    double elapsed_ms = 0.0;         // of the settled timeline
+    double overlap_ms = 0.0;         // frames voiced on both sides
+    TalkPartyTotals parties[kTalkPartyCount];
+};
+
+// Meeting talk analytics from the streams' per-10ms speech probabilities, a
+// few counters per meeting. Frames land on one 10ms timeline by host time;
+// the timeline settles as far as every party fed in the last two seconds
+// has reached, so both sides are judged at the same instants whatever their
+// delivery batching. Per party, utterances start after a voiced run and end
+// at a trailing silence; the floor passes to whoever starts speaking while
+// the other is quiet, or outlasts the one they spoke over (an interruption).
+// Any thread.
+bool StartTalkAnalytics(const TalkAnalyticsOptions& options);
+
+// Final totals: open utterances and turns close at their last voiced frame
+TalkAnalyticsTotals StopTalkAnalytics();
+
+// A running snapshot, open utterances and turns counted so far; false when
+// not running
+bool TalkAnalyticsSnapshot(TalkAnalyticsTotals* totals);
+
+// Consumer threads. |count| frames of speech probability, the first starting
+// at |first_host_ms| (monotonic host time) and each 10ms after it.
+void AddTalkFrames(TalkParty party, double first_host_ms, const float* probabilities, size_t count);
+
+// Consumer threads. An utterance ending at |host_ms| and how much it sounded
+// like a question (UtteranceProsody::question_likelihood)
+void AddTalkQuestion(TalkParty party, double host_ms, float question_likelihood);
+
+namespace internal {
+extern std::atomic<bool> g_talk_analytics_running;
+}
+
+// Lock-free, for the streams to skip the calls while off
+inline bool IsTalkAnalyticsRunning() {
+    return internal::g_talk_analytics_running.load(std::memory_order_relaxed);
+}
+
+} // namespace kakarot
@@ -0,0 +1,97 @@
+#include "talk_detector.h"
+#include <algorithm>
+#include <cmath>
+#include "dsp_kernels.h"
+
+namespace kakarot {
+
+// Render RMS that counts as the far end talking (about -50 dBFS)
+static constexpr float kFarActiveRms = 0.003f;
+
+// The far end stays active this many steps after its render goes quiet, for
+// the playback latency and the room's echo tail
+static constexpr size_t kFarHangoverSteps = 30;
+
+// Near-end activity: above max(kMinNearRms, noise floor * kNearFloorMultiplier),
+// held for kNearHangoverSteps; the floor follows quiet steps
+static constexpr float kMinNearRms = 0.01f;
+static constexpr float kNearFloorMultiplier = 2.5f;
+static constexpr float kInitialNoiseFloor = 0.005f;
+static constexpr float kNoiseFloorAlpha = 0.05f;
+static constexpr size_t kNearHangoverSteps = 5;
+
+// Against active render, cleaned capture below this fraction of the input's
+// power is echo the canceller took out (some 6 dB or more)
+static constexpr float kMinKeptPower = 0.25f;
+
+// Keeps the echo-reduction ratio finite over digital silence
+static constexpr float kMinPower = 1e-10f;
+
+static float MeanSquare(const float* data, size_t num_samples) {
+    if (num_samples == 0) {
+        return 0.0f;
+    }
+    float sum = 0.0f;
+    float peak = 0.0f;
+    dsp::SumSquaresAndPeak(data, num_samples, &sum, &peak);
+    return sum / num_samples;
+}
+
+void TalkDetector::AddRender(const float* data, size_t num_samples) {
+    float sum = 0.0f;
+    float peak = 0.0f;
+    dsp::SumSquaresAndPeak(data, num_samples, &sum, &peak);
+    render_sum_ += sum;
+    render_samples_ += num_samples;
+}
+
+TalkState TalkDetector::Classify(const float* capture, const float* cleaned, size_t num_samples) {
+    // A step with no render fed keeps the previous step's far-end reading
+    if (render_samples_ > 0) {
+        float render_rms = std::sqrt(static_cast<float>(render_sum_ / render_samples_));
+        if (render_rms >= kFarActiveRms) {
+            far_hold_ = kFarHangoverSteps;
+        } else if (far_hold_ > 0) {
+            --far_hold_;
+        }
+        render_sum_ = 0.0;
+        render_samples_ = 0;
+    } else if (far_hold_ > 0) {
+        --far_hold_;
+    }
+    const bool far = far_hold_ > 0;
+
+    const float input_power = MeanSquare(capture, num_samples);
+    const float cleaned_power = MeanSquare(cleaned, num_samples);
+    const float cleaned_rms = std::sqrt(cleaned_power);
+    echo_reduction_db_ = far ? 10.0f * std::log10((input_power + kMinPower) / (cleaned_power + kMinPower)) : 0.0f;
+    bool near = cleaned_rms > std::max(kMinNearRms, noise_floor_ * kNearFloorMultiplier);
+    if (near && far && cleaned_power < input_power * kMinKeptPower) {
+        near = false;
+    }
+    if (near) {
+        near_hold_ = kNearHangoverSteps;
+    } else {
+        noise_floor_ += kNoiseFloorAlpha * (cleaned_rms - noise_floor_);
+        if (near_hold_ > 0) {
+            --near_hold_;
+        }
+    }
+    const bool near_active = near || near_hold_ > 0;
+
+    if (near_active) {
+        return far ? TalkState::kDoubleTalk : TalkState::kNearEnd;
+    }
+    return far ? TalkState::kFarEnd : TalkState::kSilence;
+}
+
+void TalkDetector::Reset() {
+    render_sum_ = 0.0;
+    render_samples_ = 0;
+    far_hold_ = 0;
+    near_hold_ = 0;
+    noise_floor_ = kInitialNoiseFloor;
+    echo_reduction_db_ = 0.0f;
+}
+
+} // namespace kakarot
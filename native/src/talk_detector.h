@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kakarot {
+
+// Who is talking in one 10ms capture step. Values as delivered to JS.
+enum class TalkState : uint8_t {
+    kUnknown = 0,  // no echo-cancelled capture to judge by
+    kSilence,
+    kNearEnd,      // the local speaker only
+    kFarEnd,       // remote audio only; what the mic hears of it is echo
+    kDoubleTalk,
+};
+
+// Talk state from the render fed ahead of each capture step and that step
+// before and after echo cancellation. The far end is active while render
+// carries signal, held for the echo path; the near end when the cleaned
+// capture rises above its noise floor and, against active render, keeps a
+// good part of the input's power, which echo the canceller removed does
+// not. DSP thread only.
+class TalkDetector {
+public:
+    TalkDetector() { Reset(); }
+
+    // Render since the last step, any channel layout
+    void AddRender(const float* data, size_t num_samples);
+
+    // One step of |num_samples| raw |capture| and |cleaned| output
+    TalkState Classify(const float* capture, const float* cleaned, size_t num_samples);
+
+    // The last step's input over cleaned power in dB while the far end was
+    // active, 0 otherwise: how much echo the canceller took out of that
+    // step. Per step, where the APM's ERLE is a smoothed statistic.
+    float EchoReductionDb() const { return echo_reduction_db_; }
+
+    void Reset();
+
+private:
+    double render_sum_ = 0.0;
+    size_t render_samples_ = 0;
+    size_t far_hold_ = 0;   // steps the far end stays active
+    size_t near_hold_ = 0;  // likewise the near end
+    float noise_floor_ = 0.0f;
+    float echo_reduction_db_ = 0.0f;
+};
+
+} // namespace kakarot
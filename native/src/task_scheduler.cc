@@ -0,0 +1,231 @@
+#include "task_scheduler.h"
+#include "platform_thread.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace kakarot {
+
+// Background work holds off until audio has kept its deadlines this long
+static constexpr int64_t kPressureHoldNs = 500ll * 1000 * 1000;
+
+// A paused background task checks again this often, and runs on after
+// kMaxYield even if audio is still struggling, so a stream late all
+// meeting slows offline work rather than stopping it
+static constexpr auto kYieldSlice = std::chrono::milliseconds(5);
+static constexpr auto kMaxYield = std::chrono::milliseconds(2000);
+
+// Two interactive workers from this many cores
+static constexpr size_t kTwoInteractiveCores = 8;
+
+static constexpr int kBackground = static_cast<int>(TaskPriority::kBackground);
+
+static WakeupCounter g_wakeups("schedulerWorker");
+
+// Steady clock of the last ReportAudioDeadlinePressure(); far enough in the
+// past that nothing is at risk before the first
+static std::atomic<int64_t> g_pressure_ns{std::numeric_limits<int64_t>::min() / 2};
+
+// YieldForAudio() pauses, from any thread
+static std::atomic<uint64_t> g_yields{0};
+static std::atomic<uint64_t> g_yield_ns{0};
+
+// The worker the calling thread is, if any
+struct CurrentWorker {
+    TaskScheduler* scheduler = nullptr;
+    size_t index = 0;
+    bool background_task = false;  // running one now, or in a BackgroundScope
+};
+static thread_local CurrentWorker t_worker;
+
+static int64_t SteadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TaskScheduler::TaskScheduler(size_t threads, size_t interactive_threads) {
+    threads = std::max<size_t>(threads, 2);
+    interactive_threads_ = std::clamp<size_t>(interactive_threads, 1, threads - 1);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+        workers_[i]->background = i >= interactive_threads_;
+    }
+    // Started once every deque exists, since any worker may steal from any
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&TaskScheduler::WorkerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    std::vector<TaskFn> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_.store(true, std::memory_order_relaxed);
+        for (auto& worker : workers_) {
+            std::lock_guard<std::mutex> worker_lock(worker->mutex);
+            for (auto& tasks : worker->tasks) {
+                for (TaskFn& task : tasks) {
+                    abandoned.push_back(std::move(task));
+                }
+                tasks.clear();
+            }
+        }
+        queued_.fill(0);
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+    for (TaskFn& task : abandoned) {
+        task(stopping_);
+    }
+}
+
+std::unique_ptr<TaskScheduler> TaskScheduler::CreateDefault() {
+    size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+    return std::make_unique<TaskScheduler>(cores - 1, cores >= kTwoInteractiveCores ? 2 : 1);
+}
+
+void TaskScheduler::Post(TaskPriority priority, TaskFn task) {
+    const int p = static_cast<int>(priority);
+    // Background tasks only go where background workers look
+    size_t first = p == kBackground ? interactive_threads_ : 0;
+    size_t target;
+    if (t_worker.scheduler == this && t_worker.index >= first) {
+        target = t_worker.index;
+    } else {
+        target = first + next_worker_.fetch_add(1, std::memory_order_relaxed) % (workers_.size() - first);
+    }
+    Worker& worker = *workers_[target];
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        std::lock_guard<std::mutex> worker_lock(worker.mutex);
+        worker.tasks[p].push_back(std::move(task));
+        ++queued_[p];
+    }
+    // Any idle worker may take it, not just the one it was dealt to
+    wake_.notify_all();
+}
+
+bool TaskScheduler::Take(size_t self, bool background, TaskFn* task, int* priority) {
+    const int last = background ? kBackground : kBackground - 1;
+    for (int p = 0; p <= last; ++p) {
+        if (queued_[p] == 0) {
+            continue;
+        }
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            Worker& worker = *workers_[(self + i) % workers_.size()];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            std::deque<TaskFn>& tasks = worker.tasks[p];
+            if (tasks.empty()) {
+                continue;
+            }
+            if (i == 0) {
+                *task = std::move(tasks.front());
+                tasks.pop_front();
+            } else {
+                *task = std::move(tasks.back());
+                tasks.pop_back();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+            }
+            *priority = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::WorkerLoop(size_t self) {
+    Worker& worker = *workers_[self];
+    ScopedThreadCpu thread_cpu(worker.background ? "schedulerBackground" : "schedulerWorker");
+    SetCurrentThreadPriority(worker.background ? ThreadPriority::kUtility : ThreadPriority::kInteractive);
+    t_worker.scheduler = this;
+    t_worker.index = self;
+    for (;;) {
+        TaskFn task;
+        int priority = 0;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            for (;;) {
+                if (stopping_.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                const bool held_off = worker.background && AudioDeadlinesAtRisk();
+                if (Take(self, worker.background && !held_off, &task, &priority)) {
+                    break;
+                }
+                // Held-off background work is looked at again once audio
+                // recovers; nothing posts to say so
+                if (held_off && queued_[kBackground] > 0) {
+                    wake_.wait_for(lock, kYieldSlice);
+                } else {
+                    wake_.wait(lock);
+                }
+                g_wakeups.Count();
+            }
+            --queued_[priority];
+        }
+        running_[priority].fetch_add(1, std::memory_order_relaxed);
+        t_worker.background_task = priority == kBackground;
+        task(stopping_);
+        t_worker.background_task = false;
+        running_[priority].fetch_sub(1, std::memory_order_relaxed);
+        completed_[priority].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TaskScheduler::ReportAudioDeadlinePressure() {
+    g_pressure_ns.store(SteadyNs(), std::memory_order_relaxed);
+}
+
+bool TaskScheduler::AudioDeadlinesAtRisk() {
+    return SteadyNs() - g_pressure_ns.load(std::memory_order_relaxed) < kPressureHoldNs;
+}
+
+void TaskScheduler::YieldForAudio(const std::atomic<bool>& cancel) {
+    if (!t_worker.background_task || !AudioDeadlinesAtRisk()) {
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    auto waited = std::chrono::steady_clock::duration::zero();
+    while (!cancel.load(std::memory_order_relaxed) && AudioDeadlinesAtRisk() && waited < kMaxYield) {
+        std::this_thread::sleep_for(kYieldSlice);
+        waited = std::chrono::steady_clock::now() - start;
+    }
+    g_yields.fetch_add(1, std::memory_order_relaxed);
+    g_yield_ns.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count()),
+                         std::memory_order_relaxed);
+}
+
+TaskScheduler::BackgroundScope::BackgroundScope() : previous_(t_worker.background_task) {
+    t_worker.background_task = true;
+}
+
+TaskScheduler::BackgroundScope::~BackgroundScope() {
+    t_worker.background_task = previous_;
+}
+
+TaskScheduler::Stats TaskScheduler::GetStats() const {
+    Stats stats{};
+    stats.threads = workers_.size();
+    stats.interactive_threads = interactive_threads_;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        for (int p = 0; p < kTaskPriorities; ++p) {
+            stats.queued[p] = queued_[p];
+        }
+    }
+    for (int p = 0; p < kTaskPriorities; ++p) {
+        stats.running[p] = running_[p].load(std::memory_order_relaxed);
+        stats.completed[p] = completed_[p].load(std::memory_order_relaxed);
+    }
+    stats.steals = steals_.load(std::memory_order_relaxed);
+    stats.yields = g_yields.load(std::memory_order_relaxed);
+    stats.yield_ms = g_yield_ns.load(std::memory_order_relaxed) / 1e6;
+    stats.audio_at_risk = AudioDeadlinesAtRisk();
+    return stats;
+}
+
+} // namespace kakarot
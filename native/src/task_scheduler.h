@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kakarot {
+
+// What a task is waiting on, most urgent first
+enum class TaskPriority {
+    kRealtime,     // an audio stream waits for it (stage swaps, model loads)
+    kInteractive,  // the user waits for it
+    kBackground,   // nobody waits: compression, reprocessing, segmentation
+};
+static constexpr int kTaskPriorities = 3;
+
+// The addon's one pool for native work off the audio threads, so offline
+// jobs from different features share the cores instead of each sizing a
+// pool to the machine. Workers have a deque per priority: a task posted
+// from a worker stays on its deque, others are dealt round-robin; a worker
+// takes the most urgent task it may run, from the front of its own deque
+// and otherwise from the back of another's. The first workers run at
+// interactive priority and take only realtime and interactive tasks, so
+// those never queue behind an hour-long reprocess; the rest run at utility
+// priority and take anything. Background tasks give way to audio: while
+// ReportAudioDeadlinePressure() has been called recently, background
+// workers do not start new tasks, and running ones pause in
+// YieldForAudio(). Thread-safe.
+class TaskScheduler {
+public:
+    // |cancel| is set once the scheduler is going away
+    using TaskFn = std::function<void(const std::atomic<bool>& cancel)>;
+
+    // |threads| workers, |interactive_threads| of them (at least one, at
+    // most all but one) reserved for realtime and interactive tasks
+    TaskScheduler(size_t threads, size_t interactive_threads);
+
+    // Sets cancel, joins the workers, then runs every task still queued with
+    // cancel set, for it to fail fast and report
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Every core but the one the DSP thread runs on, the first of them
+    // interactive (two from eight cores up)
+    static std::unique_ptr<TaskScheduler> CreateDefault();
+
+    // Any thread. |task| always runs, exactly once.
+    void Post(TaskPriority priority, TaskFn task);
+
+    size_t ThreadCount() const { return workers_.size(); }
+
+    // Any thread, the audio ones included: lock-free, no allocation. Audio
+    // missed or nearly missed a deadline; background work holds off for a
+    // while.
+    static void ReportAudioDeadlinePressure();
+    static bool AudioDeadlinesAtRisk();
+
+    // A background task's checkpoint: on a background worker, sleeps while
+    // audio deadlines are at risk (a bounded time, and not once |cancel| is
+    // set). Elsewhere returns at once.
+    static void YieldForAudio(const std::atomic<bool>& cancel);
+
+    // The calling thread's work counts as background while in scope, for
+    // helper threads a background task fans out to
+    class BackgroundScope {
+    public:
+        BackgroundScope();
+        ~BackgroundScope();
+
+        BackgroundScope(const BackgroundScope&) = delete;
+        BackgroundScope& operator=(const BackgroundScope&) = delete;
+
+    private:
+        bool previous_;
+    };
+
+    struct Stats {
+        size_t threads;
+        size_t interactive_threads;
+        uint64_t queued[kTaskPriorities];     // waiting now
+        uint64_t running[kTaskPriorities];    // on a worker now
+        uint64_t completed[kTaskPriorities];
+        uint64_t steals;                      // tasks taken from another worker's deque
+        uint64_t yields;                      // YieldForAudio() pauses, helper threads' included
+        double yield_ms;
+        bool audio_at_risk;
+    };
+    Stats GetStats() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::array<std::deque<TaskFn>, kTaskPriorities> tasks;
+        bool background = false;  // takes background tasks, at utility priority
+        std::thread thread;
+    };
+
+    // The most urgent task |self| may run, own front first, then the back
+    // of the others, background ones only when |background|; wake_mutex_ held
+    bool Take(size_t self, bool background, TaskFn* task, int* priority);
+    void WorkerLoop(size_t self);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    size_t interactive_threads_ = 0;
+    mutable std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::array<uint64_t, kTaskPriorities> queued_{};  // across the deques; wake_mutex_
+    std::atomic<size_t> next_worker_{0};
+    std::atomic<bool> stopping_{false};
+
+    std::array<std::atomic<uint64_t>, kTaskPriorities> running_{};
+    std::array<std::atomic<uint64_t>, kTaskPriorities> completed_{};
+    std::atomic<uint64_t> steals_{0};
+};
+
+} // namespace kakarot
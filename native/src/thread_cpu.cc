@@ -0,0 +1,110 @@
+#include "thread_cpu.h"
+#include "platform_thread.h"
+#include <cstring>
+#include <mutex>
+
+namespace kakarot {
+
+namespace {
+
+// Constant-initialized, so a thread started during static init finds them
+// ready
+std::mutex g_mutex;
+ScopedThreadCpu* g_threads = nullptr;
+std::vector<RetiredThreadCpu>* g_exited = nullptr;  // leaked; outlives every thread
+
+} // namespace
+
+ScopedThreadCpu::ScopedThreadCpu(const char* name) : name_(name), tid_(CurrentThreadId()) {
+    SetCurrentThreadName(name);
+#if defined(__APPLE__)
+    port_ = mach_thread_self();
+#elif defined(_WIN32)
+    DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &handle_,
+                    THREAD_QUERY_LIMITED_INFORMATION, FALSE, 0);
+#else
+    has_clock_ = pthread_getcpuclockid(pthread_self(), &clock_) == 0;
+#endif
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    next_ = g_threads;
+    if (g_threads) {
+        g_threads->prev_ = this;
+    }
+    g_threads = this;
+}
+
+ScopedThreadCpu::~ScopedThreadCpu() {
+    const uint64_t cpu_ns = CurrentThreadCpuNs();
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        (prev_ ? prev_->next_ : g_threads) = next_;
+        if (next_) {
+            next_->prev_ = prev_;
+        }
+        if (!g_exited) {
+            g_exited = new std::vector<RetiredThreadCpu>();
+        }
+        RetiredThreadCpu* retired = nullptr;
+        for (RetiredThreadCpu& entry : *g_exited) {
+            if (std::strcmp(entry.name, name_) == 0) {
+                retired = &entry;
+                break;
+            }
+        }
+        if (!retired) {
+            g_exited->push_back(RetiredThreadCpu{name_, 0, 0});
+            retired = &g_exited->back();
+        }
+        retired->threads++;
+        retired->cpu_ns += cpu_ns;
+    }
+#if defined(__APPLE__)
+    mach_port_deallocate(mach_task_self(), port_);
+#elif defined(_WIN32)
+    if (handle_) {
+        CloseHandle(handle_);
+    }
+#endif
+}
+
+// Under g_mutex, so the thread is still registered and its handle open
+uint64_t ScopedThreadCpu::ReadCpuNs() const {
+#if defined(__APPLE__)
+    thread_basic_info_data_t info;
+    mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+    if (thread_info(port_, THREAD_BASIC_INFO, reinterpret_cast<thread_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return (static_cast<uint64_t>(info.user_time.seconds) + info.system_time.seconds) * 1000000000ull +
+           (static_cast<uint64_t>(info.user_time.microseconds) + info.system_time.microseconds) * 1000ull;
+#elif defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!handle_ || !GetThreadTimes(handle_, &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    uint64_t ticks = ((static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) +
+                     ((static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+    return ticks * 100;  // 100ns units
+#else
+    timespec now;
+    if (!has_clock_ || clock_gettime(clock_, &now) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+ThreadCpuSnapshot GetThreadCpu() {
+    ThreadCpuSnapshot snapshot;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (const ScopedThreadCpu* thread = g_threads; thread; thread = thread->next_) {
+        snapshot.threads.push_back(ThreadCpuStat{thread->name_, thread->tid_, thread->ReadCpuNs()});
+    }
+    if (g_exited) {
+        snapshot.exited = *g_exited;
+    }
+    return snapshot;
+}
+
+} // namespace kakarot
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+namespace kakarot {
+
+// One native thread's CPU time, user and system
+struct ThreadCpuStat {
+    const char* name = nullptr;
+    uint64_t tid = 0;        // the OS's id, as in a profiler or /proc/self/task
+    uint64_t cpu_ns = 0;
+};
+
+// Threads of one name that have exited, summed
+struct RetiredThreadCpu {
+    const char* name = nullptr;
+    uint64_t threads = 0;
+    uint64_t cpu_ns = 0;
+};
+
+struct ThreadCpuSnapshot {
+    std::vector<ThreadCpuStat> threads;    // running, in no particular order
+    std::vector<RetiredThreadCpu> exited;  // one per name, since load
+};
+
+// Names the calling thread for the OS (debuggers, profilers, Activity
+// Monitor) and accounts its CPU time under |name| while the scope lives:
+// one at the top of each native thread's loop. Other threads read the time
+// through the OS's handle on this one (thread_info, GetThreadTimes, the
+// thread's CPU clock), so the thread itself pays nothing after the start.
+// |name| must outlive the process; the OS copy is cut to 15 characters on
+// Linux.
+class ScopedThreadCpu {
+public:
+    explicit ScopedThreadCpu(const char* name);
+    ~ScopedThreadCpu();
+
+    ScopedThreadCpu(const ScopedThreadCpu&) = delete;
+    ScopedThreadCpu& operator=(const ScopedThreadCpu&) = delete;
+
+private:
+    friend ThreadCpuSnapshot GetThreadCpu();
+
+    uint64_t ReadCpuNs() const;
+
+    const char* name_;
+    uint64_t tid_ = 0;
+#if defined(__APPLE__)
+    thread_act_t port_ = MACH_PORT_NULL;
+#elif defined(_WIN32)
+    HANDLE handle_ = nullptr;
+#else
+    clockid_t clock_{};
+    bool has_clock_ = false;
+#endif
+    ScopedThreadCpu* next_ = nullptr;
+    ScopedThreadCpu* prev_ = nullptr;
+};
+
+ThreadCpuSnapshot GetThreadCpu();
+
+} // namespace kakarot
@@ -0,0 +1,217 @@
+#include "time_stretcher.h"
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kakarot {
+
+// Window length; a hop is half of it
+static constexpr int kFrameMs = 20;
+// Furthest a window's start moves off its target: half the period of a
+// 80Hz voice
+static constexpr int kSeekMs = 6;
+// The coarse search steps by this much of a second
+static constexpr int kCoarseStepHz = 12000;
+
+// Input kept behind what the next window can reach, in windows, before
+// it is trimmed
+static constexpr size_t kTrimFrames = 4;
+
+TimeStretcher::TimeStretcher(int sample_rate, int channels)
+    : channels_(std::clamp(channels, 1, kMaxChannels)),
+      frame_(static_cast<size_t>(sample_rate / (1000 / kFrameMs)) / 2 * 2),
+      hop_(frame_ / 2),
+      seek_(sample_rate * kSeekMs / 1000),
+      coarse_step_(static_cast<size_t>(std::max(1, sample_rate / kCoarseStepHz))),
+      window_(frame_),
+      overlap_(frame_ * channels_, 0.0f) {
+    // Periodic Hann: windows a hop apart sum to one
+    const double pi = std::acos(-1.0);
+    for (size_t n = 0; n < frame_; ++n) {
+        window_[n] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * n / frame_));
+    }
+}
+
+void TimeStretcher::SetSpeed(double speed) {
+    speed_ = std::clamp(speed, kMinSpeed, kMaxSpeed);
+}
+
+void TimeStretcher::Reset() {
+    base_ = 0;
+    input_.clear();
+    mono_.clear();
+    target_ = 0.0;
+    previous_ = -1;
+    ended_ = false;
+    end_ = 0;
+    std::fill(overlap_.begin(), overlap_.end(), 0.0f);
+    output_.clear();
+    output_head_ = 0;
+    hops_.clear();
+    produced_ = 0;
+    pulled_ = 0;
+}
+
+void TimeStretcher::Push(const float* interleaved, size_t frames) {
+    if (ended_) {
+        return;
+    }
+    input_.insert(input_.end(), interleaved, interleaved + frames * channels_);
+    const size_t first = mono_.size();
+    mono_.resize(first + frames);
+    if (channels_ == 1) {
+        std::copy(interleaved, interleaved + frames, mono_.begin() + first);
+    } else {
+        dsp::Downmix(interleaved, frames, channels_, mono_.data() + first);
+    }
+}
+
+void TimeStretcher::EndInput() {
+    if (ended_) {
+        return;
+    }
+    end_ = InputEnd();
+    // Zeros past the end, so the last windows have all they reach
+    const size_t padding = frame_ + static_cast<size_t>(seek_) + hop_;
+    input_.resize(input_.size() + padding * channels_, 0.0f);
+    mono_.resize(mono_.size() + padding, 0.0f);
+    ended_ = true;
+}
+
+bool TimeStretcher::Drained() const {
+    return ended_ && target_ >= static_cast<double>(end_ + static_cast<int64_t>(hop_)) &&
+           output_head_ == output_.size();
+}
+
+size_t TimeStretcher::InputWanted() const {
+    if (ended_) {
+        return 0;
+    }
+    const int64_t needed = std::llround(target_) + seek_ + static_cast<int64_t>(frame_);
+    return static_cast<size_t>(std::max<int64_t>(0, needed - InputEnd()));
+}
+
+float TimeStretcher::Similarity(int64_t start, const float* reference, size_t length) const {
+    const float* candidate = mono_.data() + (start - base_);
+    const float correlation = dsp::DotProduct(candidate, reference, length);
+    const float energy = dsp::DotProduct(candidate, candidate, length);
+    return correlation / std::sqrt(energy + 1e-9f);
+}
+
+int64_t TimeStretcher::BestStart(int64_t target) const {
+    const int64_t lo = std::max(target - seek_, base_);
+    const int64_t hi = std::min(target + seek_, InputEnd() - static_cast<int64_t>(frame_));
+    if (lo > hi) {
+        return std::clamp(target, base_, InputEnd() - static_cast<int64_t>(frame_));
+    }
+    // What the last window would have gone on to: the new window's first
+    // half is summed over its second
+    const float* reference = mono_.data() + (previous_ + static_cast<int64_t>(hop_) - base_);
+    int64_t best = std::clamp(target, lo, hi);
+    float best_score = Similarity(best, reference, hop_);
+    const int64_t step = static_cast<int64_t>(coarse_step_);
+    for (int64_t start = lo; start <= hi; start += step) {
+        const float score = Similarity(start, reference, hop_);
+        if (score > best_score) {
+            best_score = score;
+            best = start;
+        }
+    }
+    const int64_t coarse = best;
+    for (int64_t start = std::max(lo, coarse - step + 1); start <= std::min(hi, coarse + step - 1); ++start) {
+        if (start == coarse) {
+            continue;
+        }
+        const float score = Similarity(start, reference, hop_);
+        if (score > best_score) {
+            best_score = score;
+            best = start;
+        }
+    }
+    return best;
+}
+
+bool TimeStretcher::Produce() {
+    if (ended_ && target_ >= static_cast<double>(end_ + static_cast<int64_t>(hop_))) {
+        return false;
+    }
+    const bool unchanged = std::fabs(speed_ - 1.0) < 1e-6;
+    if (unchanged && previous_ >= 0) {
+        // Straight on from the last window: the input as it was
+        target_ = static_cast<double>(previous_ + static_cast<int64_t>(hop_));
+    }
+    const int64_t target = std::llround(target_);
+    if (InputEnd() < target + static_cast<int64_t>(frame_) + (ended_ ? 0 : seek_)) {
+        return false;
+    }
+    int64_t start = target;
+    if (previous_ >= 0 && !unchanged) {
+        start = BestStart(target);
+    } else {
+        start = std::max(start, base_);
+    }
+
+    const float* source = input_.data() + (start - base_) * channels_;
+    for (size_t n = 0; n < frame_; ++n) {
+        for (int c = 0; c < channels_; ++c) {
+            overlap_[n * channels_ + c] += window_[n] * source[n * channels_ + c];
+        }
+    }
+    // The first half is complete: no later window reaches it
+    const size_t half = hop_ * channels_;
+    output_.insert(output_.end(), overlap_.begin(), overlap_.begin() + half);
+    std::copy(overlap_.begin() + half, overlap_.end(), overlap_.begin());
+    std::fill(overlap_.end() - half, overlap_.end(), 0.0f);
+
+    hops_.push_back({produced_, target_, speed_});
+    produced_ += hop_;
+    previous_ = start;
+    target_ += hop_ * speed_;
+    Trim();
+    return true;
+}
+
+void TimeStretcher::Trim() {
+    const int64_t keep = std::min(previous_ + static_cast<int64_t>(hop_),
+                                  static_cast<int64_t>(std::floor(target_)) - seek_);
+    const int64_t drop = keep - base_;
+    if (drop > static_cast<int64_t>(kTrimFrames * frame_)) {
+        input_.erase(input_.begin(), input_.begin() + drop * channels_);
+        mono_.erase(mono_.begin(), mono_.begin() + drop);
+        base_ = keep;
+    }
+}
+
+size_t TimeStretcher::Pull(float* interleaved, size_t frames) {
+    size_t done = 0;
+    while (done < frames) {
+        if (output_head_ == output_.size()) {
+            output_.clear();
+            output_head_ = 0;
+            if (!Produce()) {
+                break;
+            }
+        }
+        const size_t available = (output_.size() - output_head_) / channels_;
+        const size_t take = std::min(frames - done, available);
+        std::copy(output_.begin() + output_head_, output_.begin() + output_head_ + take * channels_,
+                  interleaved + done * channels_);
+        output_head_ += take * channels_;
+        done += take;
+        pulled_ += take;
+        while (hops_.size() > 1 && hops_[1].output <= pulled_) {
+            hops_.pop_front();
+        }
+    }
+    return done;
+}
+
+double TimeStretcher::InputPosition() const {
+    if (hops_.empty() || pulled_ >= produced_) {
+        return target_;
+    }
+    const Hop& hop = hops_.front();
+    return hop.input + static_cast<double>(pulled_ - hop.output) * hop.speed;
+}
+
+} // namespace kakarot
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace kakarot {
+
+// Speech played faster or slower at its own pitch, by WSOLA: 20ms Hann
+// frames overlap-added every 10ms of output, each taken from where the
+// speed puts it in the input, give or take the offset (up to 6ms) whose
+// start best continues the waveform already written, so pitch periods
+// line up instead of smearing. The offset is found on a coarse grid and
+// refined, a few dot products per 10ms of output. At 1x the frames are
+// taken as they are and the input comes back unchanged, and the first
+// frame after a Reset() fades in over 10ms, so a seek never clicks.
+// Interleaved float frames, up to kMaxChannels channels aligned by their
+// mean. Not thread-safe; allocates only as its buffers grow.
+class TimeStretcher {
+public:
+    static constexpr int kMaxChannels = 2;
+    static constexpr double kMinSpeed = 0.5;
+    static constexpr double kMaxSpeed = 3.0;
+
+    TimeStretcher(int sample_rate, int channels);
+
+    // From the next output frame on; clamped to [kMinSpeed, kMaxSpeed]
+    void SetSpeed(double speed);
+    double Speed() const { return speed_; }
+
+    // Drops all input and output: the next input starts a new stream
+    void Reset();
+
+    void Push(const float* interleaved, size_t frames);
+    // No more input: what is buffered plays out, then Drained()
+    void EndInput();
+    bool InputEnded() const { return ended_; }
+    bool Drained() const;
+
+    // Input frames Pull() is waiting for before it can produce more
+    size_t InputWanted() const;
+
+    // Up to |frames| output frames; fewer when it needs input
+    size_t Pull(float* interleaved, size_t frames);
+
+    // Input frame (counted from the last Reset()) that the next frame
+    // Pull() returns was taken from, as the speed maps them
+    double InputPosition() const;
+
+    int Channels() const { return channels_; }
+
+private:
+    // One more hop of output from the input at target_; false without the
+    // input it needs
+    bool Produce();
+    // The start in [target - seek, target + seek] that best continues the
+    // output; bounded to what the buffer holds
+    int64_t BestStart(int64_t target) const;
+    float Similarity(int64_t start, const float* reference, size_t step) const;
+    int64_t InputEnd() const { return base_ + static_cast<int64_t>(mono_.size()); }
+    void Trim();
+
+    const int channels_;
+    const size_t frame_;  // samples of a window
+    const size_t hop_;    // of output per window
+    const int64_t seek_;  // furthest the start moves off its target
+    const size_t coarse_step_;
+    std::vector<float> window_;
+
+    double speed_ = 1.0;
+    int64_t base_ = 0;             // input frame at input_[0]
+    std::vector<float> input_;     // interleaved
+    std::vector<float> mono_;      // the channels' mean, for the search
+    double target_ = 0.0;          // ideal start of the next window
+    int64_t previous_ = -1;        // start of the last window; -1 before the first
+    bool ended_ = false;
+    int64_t end_ = 0;              // input frames before the padding EndInput() added
+
+    std::vector<float> overlap_;   // frame_ interleaved frames being summed
+    std::vector<float> output_;    // whole frames waiting for Pull()
+    size_t output_head_ = 0;
+
+    // Where each hop of output came from, for InputPosition()
+    struct Hop {
+        uint64_t output = 0;  // its first frame, counted from Reset()
+        double input = 0.0;
+        double speed = 1.0;
+    };
+    std::deque<Hop> hops_;
+    uint64_t produced_ = 0;  // output frames ever made
+    uint64_t pulled_ = 0;
+};
+
+} // namespace kakarot
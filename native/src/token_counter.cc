@@ -0,0 +1,411 @@
+#include "token_counter.h"
+#include "memory_pressure.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace kakarot {
+
+namespace {
+
+// Longer letter runs (base64, hashes) are cut, which bounds the merge work
+// per piece; counts for them are off by a token or so
+constexpr size_t kMaxPieceBytes = 256;
+// Exact counts are remembered for this many distinct pieces
+constexpr size_t kMaxCachedPieces = 1 << 16;
+
+enum class Kind { kLetter, kNumber, kSpace, kNewline, kOther };
+
+struct CodePoint {
+    uint32_t value = 0;
+    size_t size = 1;
+};
+
+// A stray byte stands for itself
+CodePoint Decode(const std::string& text, size_t i) {
+    const auto* s = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t left = text.size() - i;
+    const unsigned char lead = s[i];
+    CodePoint cp{lead, 1};
+    size_t size = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+    if (size <= 1 || size > left) {
+        return cp;
+    }
+    uint32_t value = lead & (0x7F >> size);
+    for (size_t k = 1; k < size; ++k) {
+        if ((s[i + k] & 0xC0) != 0x80) {
+            return cp;
+        }
+        value = (value << 6) | (s[i + k] & 0x3F);
+    }
+    return CodePoint{value, size};
+}
+
+bool IsCjk(uint32_t cp) {
+    return (cp >= 0x2E80 && cp <= 0x9FFF) || (cp >= 0xAC00 && cp <= 0xD7AF) || (cp >= 0xF900 && cp <= 0xFAFF) ||
+           (cp >= 0x20000 && cp <= 0x3FFFF);
+}
+
+// \p{L} and \p{N} by the ranges that matter for meeting text: outside
+// ASCII everything but whitespace, Latin-1 and general punctuation,
+// symbols and emoji counts as a letter
+Kind Classify(uint32_t cp) {
+    if (cp < 0x80) {
+        if (cp == '\n' || cp == '\r') return Kind::kNewline;
+        if (cp == ' ' || (cp >= '\t' && cp <= '\f')) return Kind::kSpace;
+        if ((cp | 0x20) >= 'a' && (cp | 0x20) <= 'z') return Kind::kLetter;
+        if (cp >= '0' && cp <= '9') return Kind::kNumber;
+        return Kind::kOther;
+    }
+    if (cp == 0x85 || cp == 0xA0 || cp == 0x1680 || (cp >= 0x2000 && cp <= 0x200A) || cp == 0x2028 ||
+        cp == 0x2029 || cp == 0x202F || cp == 0x205F || cp == 0x3000) {
+        return Kind::kSpace;
+    }
+    if (cp < 0xC0) {
+        return (cp == 0xAA || cp == 0xB5 || cp == 0xBA) ? Kind::kLetter : Kind::kOther;
+    }
+    if (cp == 0xD7 || cp == 0xF7 || (cp >= 0x2000 && cp <= 0x2BFF) || (cp >= 0x3000 && cp <= 0x303F) ||
+        (cp >= 0xFF00 && cp <= 0xFF20) || (cp >= 0x1F000 && cp <= 0x1FAFF)) {
+        return Kind::kOther;
+    }
+    return Kind::kLetter;
+}
+
+Kind KindAt(const std::string& text, size_t i) { return Classify(Decode(text, i).value); }
+
+// The end of the piece at |i|, by cl100k's pattern, alternative by
+// alternative:
+//   '(?i:[sdmt]|ll|ve|re) | [^\r\n\p{L}\p{N}]?+\p{L}+ | \p{N}{1,3} |
+//    ?[^\s\p{L}\p{N}]++[\r\n]* | \s*[\r\n] | \s+(?!\S) | \s+
+size_t NextPiece(const std::string& text, size_t i) {
+    const size_t n = text.size();
+    const CodePoint first = Decode(text, i);
+    const Kind kind = Classify(first.value);
+
+    if (text[i] == '\'' && i + 1 < n) {
+        char a = static_cast<char>(text[i + 1] | 0x20);
+        if (a == 's' || a == 'd' || a == 'm' || a == 't') return i + 2;
+        if (i + 2 < n) {
+            char b = static_cast<char>(text[i + 2] | 0x20);
+            if ((a == 'l' && b == 'l') || (a == 'v' && b == 'e') || (a == 'r' && b == 'e')) return i + 3;
+        }
+    }
+
+    size_t p = i;
+    if (kind == Kind::kSpace || kind == Kind::kOther) {
+        p = i + first.size;
+    }
+    if (p < n && KindAt(text, p) == Kind::kLetter) {
+        while (p < n) {
+            CodePoint cp = Decode(text, p);
+            if (Classify(cp.value) != Kind::kLetter) break;
+            p += cp.size;
+        }
+        return p;
+    }
+
+    if (kind == Kind::kNumber) {
+        p = i;
+        for (int digits = 0; digits < 3 && p < n; ++digits) {
+            CodePoint cp = Decode(text, p);
+            if (Classify(cp.value) != Kind::kNumber) break;
+            p += cp.size;
+        }
+        return p;
+    }
+
+    p = text[i] == ' ' ? i + 1 : i;
+    if (p < n && KindAt(text, p) == Kind::kOther) {
+        while (p < n) {
+            CodePoint cp = Decode(text, p);
+            if (Classify(cp.value) != Kind::kOther) break;
+            p += cp.size;
+        }
+        while (p < n && (text[p] == '\r' || text[p] == '\n')) ++p;
+        return p;
+    }
+
+    if (kind == Kind::kSpace || kind == Kind::kNewline) {
+        size_t end = i;
+        size_t last_newline = std::string::npos;
+        size_t last_start = i;
+        while (end < n) {
+            CodePoint cp = Decode(text, end);
+            Kind k = Classify(cp.value);
+            if (k != Kind::kSpace && k != Kind::kNewline) break;
+            if (k == Kind::kNewline) last_newline = end;
+            last_start = end;
+            end += cp.size;
+        }
+        if (last_newline != std::string::npos) return last_newline + 1;
+        if (end == n || last_start == i) return end;
+        return last_start;  // the last one goes with the word after it
+    }
+    return i + first.size;
+}
+
+// Without the ranks: common words are one token, longer ones about one
+// per four letters, CJK about one per character
+size_t EstimateTokens(const std::string& text, size_t offset, size_t size) {
+    size_t ascii = 0, other = 0, cjk = 0, numbers = 0, symbols = 0, wide_symbols = 0, spaces = 0;
+    for (size_t i = offset; i < offset + size;) {
+        CodePoint cp = Decode(text, i);
+        switch (Classify(cp.value)) {
+            case Kind::kLetter:
+                if (cp.value < 0x80) ++ascii;
+                else if (IsCjk(cp.value)) ++cjk;
+                else ++other;
+                break;
+            case Kind::kNumber:
+                ++numbers;
+                break;
+            case Kind::kOther:
+                if (cp.value < 0x80) ++symbols;
+                else ++wide_symbols;
+                break;
+            default:
+                ++spaces;
+                break;
+        }
+        i += cp.size;
+    }
+    size_t tokens;
+    if (ascii + other + cjk > 0) {
+        tokens = (ascii > 0 ? 1 + (ascii > 6 ? (ascii - 3) / 4 : 0) : 0) + cjk + (other + 1) / 2;
+    } else if (numbers > 0) {
+        tokens = 1;
+    } else if (symbols + wide_symbols > 0) {
+        tokens = (symbols + 2) / 3 + wide_symbols;
+    } else {
+        tokens = 1 + spaces / 16;
+    }
+    return std::max<size_t>(tokens, 1);
+}
+
+int Base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+bool DecodeBase64(const std::string& in, size_t size, std::string* out) {
+    out->clear();
+    uint32_t bits = 0;
+    int count = 0;
+    for (size_t i = 0; i < size && in[i] != '='; ++i) {
+        int value = Base64Value(in[i]);
+        if (value < 0) return false;
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out->push_back(static_cast<char>((bits >> count) & 0xFF));
+        }
+    }
+    return !out->empty();
+}
+
+} // namespace
+
+bool TokenCounter::LoadRanks(const std::string& path, std::string* error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        *error = "cannot open " + path;
+        return false;
+    }
+    std::unordered_map<std::string, uint32_t> ranks;
+    std::string line;
+    std::string bytes;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        size_t space = line.find(' ');
+        if (space == std::string::npos || !DecodeBase64(line, space, &bytes)) {
+            *error = "not a tiktoken ranks file: " + path;
+            return false;
+        }
+        ranks[bytes] = static_cast<uint32_t>(std::strtoul(line.c_str() + space + 1, nullptr, 10));
+    }
+    if (ranks.empty()) {
+        *error = "no ranks in " + path;
+        return false;
+    }
+    ranks_ = std::move(ranks);
+    cache_.clear();
+    return true;
+}
+
+// Byte pair merging as tiktoken does it: the adjacent pair whose joining
+// has the lowest rank merges first, until no joined pair has a rank
+size_t TokenCounter::MergeTokens(const std::string& piece) const {
+    if (ranks_.count(piece)) {
+        return 1;
+    }
+    std::vector<size_t> bounds(piece.size() + 1);
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        bounds[i] = i;
+    }
+    std::string key;
+    while (bounds.size() > 2) {
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        size_t best_at = 0;
+        for (size_t j = 0; j + 2 < bounds.size(); ++j) {
+            key.assign(piece, bounds[j], bounds[j + 2] - bounds[j]);
+            auto rank = ranks_.find(key);
+            if (rank != ranks_.end() && rank->second < best) {
+                best = rank->second;
+                best_at = j + 1;
+            }
+        }
+        if (best == std::numeric_limits<uint32_t>::max()) {
+            break;
+        }
+        bounds.erase(bounds.begin() + static_cast<std::ptrdiff_t>(best_at));
+    }
+    return bounds.size() - 1;
+}
+
+size_t TokenCounter::PieceTokens(const char* data, size_t size) {
+    // Dropped whole when memory pressure has risen since it was filled
+    uint64_t epoch = MemoryPressureEpoch();
+    if (epoch != cache_epoch_) {
+        std::unordered_map<std::string, uint32_t>().swap(cache_);
+        cache_epoch_ = epoch;
+    }
+    std::string piece(data, size);
+    auto cached = cache_.find(piece);
+    if (cached != cache_.end()) {
+        return cached->second;
+    }
+    size_t tokens = MergeTokens(piece);
+    if (cache_.size() >= kMaxCachedPieces) {
+        cache_.clear();
+    }
+    cache_.emplace(std::move(piece), static_cast<uint32_t>(tokens));
+    return tokens;
+}
+
+void TokenCounter::Pieces(const std::string& text, std::vector<Piece>* pieces) {
+    pieces->clear();
+    for (size_t i = 0; i < text.size();) {
+        size_t end = NextPiece(text, i);
+        while (end - i > kMaxPieceBytes) {
+            size_t cut = i + kMaxPieceBytes;
+            while (cut > i && (static_cast<unsigned char>(text[cut]) & 0xC0) == 0x80) --cut;
+            if (cut == i) cut = i + kMaxPieceBytes;
+            Piece piece{i, cut - i, 0};
+            piece.tokens = Exact() ? PieceTokens(text.data() + i, piece.size) : EstimateTokens(text, i, piece.size);
+            pieces->push_back(piece);
+            i = cut;
+        }
+        Piece piece{i, end - i, 0};
+        piece.tokens = Exact() ? PieceTokens(text.data() + i, piece.size) : EstimateTokens(text, i, piece.size);
+        pieces->push_back(piece);
+        i = end;
+    }
+}
+
+size_t TokenCounter::Count(const std::string& text) {
+    Pieces(text, &pieces_);
+    size_t tokens = 0;
+    for (const Piece& piece : pieces_) {
+        tokens += piece.tokens;
+    }
+    return tokens;
+}
+
+size_t TokenCounter::Fit(const std::string& text, size_t max_tokens, bool from_end, size_t* tokens) {
+    Pieces(text, &pieces_);
+    size_t total = 0;
+    size_t bytes = 0;
+    if (from_end) {
+        for (size_t i = pieces_.size(); i-- > 0 && total + pieces_[i].tokens <= max_tokens;) {
+            total += pieces_[i].tokens;
+            bytes = text.size() - pieces_[i].offset;
+        }
+    } else {
+        for (const Piece& piece : pieces_) {
+            if (total + piece.tokens > max_tokens) break;
+            total += piece.tokens;
+            bytes = piece.offset + piece.size;
+        }
+    }
+    if (tokens) {
+        *tokens = total;
+    }
+    return bytes;
+}
+
+std::vector<TokenChunk> TokenCounter::Chunk(const std::string& text, size_t max_tokens, size_t overlap_tokens) {
+    std::vector<TokenChunk> chunks;
+    if (max_tokens == 0) {
+        return chunks;
+    }
+    overlap_tokens = std::min(overlap_tokens, max_tokens / 2);
+    Pieces(text, &pieces_);
+
+    // Sentences and lines as runs of pieces, cut to |max_tokens|
+    struct Span {
+        size_t first = 0;
+        size_t last = 0;  // exclusive
+        size_t tokens = 0;
+    };
+    std::vector<Span> spans;
+    Span span;
+    for (size_t i = 0; i < pieces_.size(); ++i) {
+        const Piece& piece = pieces_[i];
+        if (span.last > span.first && span.tokens + piece.tokens > max_tokens) {
+            spans.push_back(span);
+            span = Span{i, i, 0};
+        }
+        span.last = i + 1;
+        span.tokens += piece.tokens;
+        const char tail = text[piece.offset + piece.size - 1];
+        const bool ends_sentence = tail == '.' || tail == '!' || tail == '?' || tail == '\n' ||
+                                   text.compare(piece.offset + piece.size - std::min<size_t>(3, piece.size),
+                                                std::min<size_t>(3, piece.size), "\xE3\x80\x82") == 0;
+        if (ends_sentence) {
+            spans.push_back(span);
+            span = Span{i + 1, i + 1, 0};
+        }
+    }
+    if (span.last > span.first) {
+        spans.push_back(span);
+    }
+
+    auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; };
+    for (size_t start = 0; start < spans.size();) {
+        size_t end = start;
+        size_t tokens = 0;
+        while (end < spans.size() && (end == start || tokens + spans[end].tokens <= max_tokens)) {
+            tokens += spans[end].tokens;
+            ++end;
+        }
+        size_t from = pieces_[spans[start].first].offset;
+        const Piece& last = pieces_[spans[end - 1].last - 1];
+        size_t to = last.offset + last.size;
+        while (from < to && is_space(text[from])) ++from;
+        while (to > from && is_space(text[to - 1])) --to;
+        if (to > from) {
+            chunks.push_back(TokenChunk{from, to - from, tokens});
+        }
+        if (end == spans.size()) {
+            break;
+        }
+        // Back up whole sentences into the overlap, always moving on
+        size_t next = end;
+        size_t carried = 0;
+        while (next - 1 > start && carried + spans[next - 1].tokens <= overlap_tokens) {
+            carried += spans[next - 1].tokens;
+            --next;
+        }
+        start = next;
+    }
+    return chunks;
+}
+
+} // namespace kakarot
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kakarot {
+
+// A span of the text handed to TokenCounter::Chunk(), by byte offset
+struct TokenChunk {
+    size_t offset = 0;
+    size_t size = 0;
+    size_t tokens = 0;
+};
+
+// Counts tokens the way OpenAI's cl100k_base encoding does. Text is split
+// into pieces with cl100k's pre-tokenizer rules (contractions, letter runs
+// with one leading character, up to three digits, punctuation runs,
+// whitespace). With the encoding's ranks loaded each piece is then merged
+// byte pair by byte pair, so counts are exact; without them a piece's
+// count is estimated from its length and script, which lands close on
+// prose. Every cut falls between pieces, so it never splits a UTF-8
+// sequence. One thread at a time.
+class TokenCounter {
+public:
+    // A cl100k_base.tiktoken file: one "<base64 bytes> <rank>" per line
+    bool LoadRanks(const std::string& path, std::string* error);
+    bool Exact() const { return !ranks_.empty(); }
+
+    size_t Count(const std::string& text);
+
+    // Bytes of the longest prefix within |max_tokens| (the longest suffix
+    // when |from_end|); its count goes to |tokens| when given
+    size_t Fit(const std::string& text, size_t max_tokens, bool from_end, size_t* tokens);
+
+    // Spans of at most |max_tokens| that end at a sentence or line where
+    // one fits, each starting about |overlap_tokens| back into the one
+    // before. Leading and trailing whitespace is left out of a span. One
+    // pass over the text.
+    std::vector<TokenChunk> Chunk(const std::string& text, size_t max_tokens, size_t overlap_tokens);
+
+private:
+    struct Piece {
+        size_t offset = 0;
+        size_t size = 0;
+        size_t tokens = 0;
+    };
+
+    void Pieces(const std::string& text, std::vector<Piece>* pieces);
+    size_t PieceTokens(const char* data, size_t size);
+    size_t MergeTokens(const std::string& piece) const;
+
+    std::unordered_map<std::string, uint32_t> ranks_;
+    std::unordered_map<std::string, uint32_t> cache_;  // piece -> tokens, exact counts only
+    uint64_t cache_epoch_ = 0;                         // MemoryPressureEpoch() cache_ was filled under
+    std::vector<Piece> pieces_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,436 @@
+#include "transcript_aligner.h"
+#include "native_log.h"
+#include "recording_reader.h"
+#include "spectral_analyzer.h"
+#include "task_scheduler.h"
+#include "voice_activity.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace kakarot {
+
+static const char* const kLogSource = "TranscriptAligner";
+
+// Frames of the features and the grid words are placed on
+static constexpr double kFrameMs = 10.0;
+
+// Longest read from the recording at once
+static constexpr double kReadMs = 10000.0;
+
+// Features are computed this far beyond where any word could move
+static constexpr double kMarginMs = 1000.0;
+
+// A syllable's usual length, for the duration a word's text suggests
+static constexpr double kSyllableMs = 180.0;
+
+// Longest a word is stretched over
+static constexpr int64_t kMaxWordFrames = 200;
+
+// Weights of placement against speech evidence, which costs up to one per
+// frame: a word's duration off what was expected, its start off where the
+// shifted run put it, starting on an onset
+static constexpr double kDurationWeight = 0.3;
+static constexpr double kPositionWeight = 1.0;
+static constexpr double kOnsetWeight = 1.0;
+
+// Words a run holds at most, so drift within long stretches of talk is
+// followed run by run
+static constexpr size_t kMaxRunWords = 50;
+
+// Provider time stepping back further than this starts a new run
+static constexpr int64_t kRestartFrames = 50;
+
+// Per frame a run moves: against moving at all, and away from the run
+// before, as drift builds slowly
+static constexpr double kShiftCost = 0.002;
+static constexpr double kDriftCost = 0.03;
+
+// Either side of a run, where the pause that set it apart should be: this
+// long, starting this far out, as provider ends are loose
+static constexpr int64_t kGuardFrames = 30;
+static constexpr int64_t kGuardSlackFrames = 20;
+
+// Share of speech evidence from the VAD; the rest is energy
+static constexpr float kVadWeight = 0.6f;
+
+static constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Per-frame evidence over [first, first + size)
+struct Features {
+    int64_t first = 0;
+    std::vector<float> speech;   // 0-1
+    std::vector<float> onset;    // 0-1
+    std::vector<double> prefix;  // of speech, size + 1
+    int sample_rate = 0;
+
+    int64_t End() const { return first + static_cast<int64_t>(speech.size()); }
+    float Onset(int64_t f) const { return f >= first && f < End() ? onset[f - first] : 0.0f; }
+    // Speech summed up to frame |f|; frames outside the span are silence
+    double Prefix(int64_t f) const { return prefix[std::clamp<int64_t>(f, first, End()) - first]; }
+    double Speech(int64_t from, int64_t to) const { return Prefix(to) - Prefix(from); }
+};
+
+float Percentile(std::vector<float> values, double share) {
+    if (values.empty()) {
+        return 0.0f;
+    }
+    auto at = values.begin() + static_cast<ptrdiff_t>(share * (values.size() - 1));
+    std::nth_element(values.begin(), at, values.end());
+    return *at;
+}
+
+// VAD, energy and spectral flux of [first, last) frames of the track
+bool ComputeFeatures(RecordingReader* reader, int64_t first, int64_t last, const std::atomic<bool>& cancel,
+                     Features* features, std::string* error) {
+    const size_t count = static_cast<size_t>(last - first);
+    std::vector<float> vad(count, 0.0f);
+    std::vector<float> energy(count, -100.0f);
+    std::vector<float> flux(count, 0.0f);
+
+    std::unique_ptr<VoiceActivityDetector> detector;
+    std::unique_ptr<SpectralAnalyzer> analyzer;
+    int rate = 0;
+    std::vector<float> previous;  // log band energies of the frame before
+    SpectrumOptions bands;
+    bands.bands = 24;
+    bands.min_hz = 100.0f;
+    bands.max_hz = 6000.0f;
+
+    std::vector<float> scratch;
+    const double end_ms = last * kFrameMs;
+    double at = first * kFrameMs;
+    while (at < end_ms) {
+        TaskScheduler::YieldForAudio(cancel);
+        if (cancel.load(std::memory_order_relaxed)) {
+            *error = "cancelled";
+            return false;
+        }
+        RecordingRange range;
+        if (!reader->Read(at, std::min(kReadMs, end_ms - at), &range, error)) {
+            return false;
+        }
+        if (range.samples == 0 || range.start_ms >= end_ms) {
+            break;
+        }
+        const size_t samples = std::min(range.samples, static_cast<size_t>(std::ceil(
+            (end_ms - range.start_ms) * range.sample_rate / 1000.0)));
+        scratch.resize(samples);
+        DownmixRange(range, samples, scratch.data());
+        at = range.start_ms + samples * 1000.0 / range.sample_rate;
+
+        // A device switch mid-recording changes the rate
+        if (!detector || rate != range.sample_rate) {
+            rate = range.sample_rate;
+            detector = std::make_unique<VoiceActivityDetector>(rate);
+            analyzer = SpectralAnalyzer::Supports(rate) ? std::make_unique<SpectralAnalyzer>(rate, bands) : nullptr;
+            previous.clear();
+        }
+        if (features->sample_rate == 0) {
+            features->sample_rate = rate;
+        }
+        const size_t frame = detector->FrameSize();
+        const int64_t base = static_cast<int64_t>(range.start_ms / kFrameMs);
+        for (size_t i = 0; i + frame <= samples; i += frame) {
+            const int64_t index = base + static_cast<int64_t>(i / frame) - first;
+            const float* data = scratch.data() + i;
+            if (index < 0 || index >= static_cast<int64_t>(count)) {
+                continue;
+            }
+            vad[index] = detector->AnalyzeFrame(data);
+            double power = 0.0;
+            for (size_t k = 0; k < frame; ++k) {
+                power += static_cast<double>(data[k]) * data[k];
+            }
+            energy[index] = static_cast<float>(10.0 * std::log10(power / frame + 1e-10));
+            if (analyzer) {
+                analyzer->ProcessFrame(data);
+                const float* band = analyzer->Bands();
+                const size_t n = analyzer->BandCount();
+                float rise = 0.0f;
+                previous.resize(n, -10.0f);
+                for (size_t b = 0; b < n; ++b) {
+                    const float level = std::log10(band[b] + 1e-10f);
+                    rise += std::max(0.0f, level - previous[b]);
+                    previous[b] = level;
+                }
+                flux[index] = rise / n;
+            }
+        }
+    }
+
+    // Energy against the track's own floor and peak, flux against its loud onsets
+    const float floor = Percentile(energy, 0.1);
+    const float peak = Percentile(energy, 0.95);
+    const float flux_peak = Percentile(flux, 0.95);
+    features->first = first;
+    features->speech.resize(count);
+    features->onset.resize(count);
+    features->prefix.assign(count + 1, 0.0);
+    for (size_t i = 0; i < count; ++i) {
+        const float level = peak - floor > 1.0f ? std::clamp((energy[i] - floor) / (peak - floor), 0.0f, 1.0f) : 0.0f;
+        features->speech[i] = kVadWeight * vad[i] + (1.0f - kVadWeight) * level;
+        features->onset[i] = flux_peak > 0.0f ? std::min(1.0f, flux[i] / flux_peak) : 0.0f;
+        features->prefix[i + 1] = features->prefix[i] + features->speech[i];
+    }
+    return true;
+}
+
+size_t Syllables(const std::string& text) {
+    size_t groups = 0;
+    size_t letters = 0;
+    bool in_vowel = false;
+    for (unsigned char c : text) {
+        if ((c & 0xC0) == 0x80) {
+            continue;  // a UTF-8 continuation byte
+        }
+        if (c < 0x80 && !std::isalnum(c)) {
+            in_vowel = false;  // punctuation and apostrophes
+            continue;
+        }
+        ++letters;
+        const char lower = static_cast<char>(std::tolower(c));
+        const bool vowel = lower == 'a' || lower == 'e' || lower == 'i' || lower == 'o' || lower == 'u' || lower == 'y';
+        groups += vowel && !in_vowel ? 1 : 0;
+        in_vowel = vowel;
+    }
+    // Scripts without Latin vowels: a syllable every few characters
+    return groups > 0 ? groups : std::max<size_t>(1, (letters + 2) / 3);
+}
+
+// One word as the programme sees it, in frames
+struct Slot {
+    int64_t guess = 0;      // provider start, shifted with its run
+    bool restart = false;   // provider time stepped back before it (a reconnect)
+    int64_t provided = 1;   // provider duration
+    double expected = 1.0;  // duration it should have
+    int64_t min_length = 1;
+    int64_t max_length = 1;
+    int64_t start_low = 0;  // starts considered
+    int64_t start_high = 0;
+    int64_t end_low = 0;    // ends reachable
+    std::vector<double> start_cost;   // best cost to start at each start, words before placed
+    std::vector<int64_t> start_from;  // the previous word's end it came from
+    std::vector<double> end_cost;     // best cost to end at each end
+    std::vector<int64_t> end_from;    // the start it came from
+};
+
+// Places [first, last) of |slots|, a run, from frame |floor| on; fills |words|
+void PlaceRun(const Features& features, const AlignmentJob& job, int64_t floor, std::vector<Slot>* slots,
+              size_t first, size_t last, int sample_rate, std::vector<AlignedWord>* words) {
+    const int64_t reach = std::max<int64_t>(1, static_cast<int64_t>(job.max_word_shift_ms / kFrameMs));
+    const double sigma = std::max(1.0, reach / 2.0);
+    int64_t previous_end_low = std::max(floor, features.first);
+    for (size_t i = first; i < last; ++i) {
+        Slot& slot = (*slots)[i];
+        slot.start_low = std::max(slot.guess - reach, previous_end_low);
+        slot.start_high = std::max(slot.guess + reach, slot.start_low);
+        slot.end_low = slot.start_low + slot.min_length;
+        previous_end_low = slot.end_low;
+        slot.start_cost.assign(static_cast<size_t>(slot.start_high - slot.start_low + 1), kInfinity);
+        slot.start_from.assign(slot.start_cost.size(), -1);
+        slot.end_cost.assign(static_cast<size_t>(slot.start_high + slot.max_length - slot.end_low + 1), kInfinity);
+        slot.end_from.assign(slot.end_cost.size(), -1);
+
+        // Entering: after the previous word and a gap, where speech costs
+        if (i == first) {
+            std::fill(slot.start_cost.begin(), slot.start_cost.end(), 0.0);
+        } else {
+            const Slot& before = (*slots)[i - 1];
+            const int64_t before_end_high = before.end_low + static_cast<int64_t>(before.end_cost.size()) - 1;
+            int64_t u = before.end_low;
+            double best = kInfinity;
+            int64_t best_u = -1;
+            for (int64_t s = slot.start_low; s <= slot.start_high; ++s) {
+                for (; u <= std::min(s, before_end_high); ++u) {
+                    const double value = before.end_cost[u - before.end_low] - features.Prefix(u);
+                    if (value < best) {
+                        best = value;
+                        best_u = u;
+                    }
+                }
+                if (best_u >= 0) {
+                    slot.start_cost[s - slot.start_low] = best + features.Prefix(s);
+                    slot.start_from[s - slot.start_low] = best_u;
+                }
+            }
+        }
+
+        // The word itself: silence in it costs, as do a duration and start
+        // away from what was expected; an onset at the start is a reward
+        for (int64_t s = slot.start_low; s <= slot.start_high; ++s) {
+            const double entry = slot.start_cost[s - slot.start_low];
+            if (entry == kInfinity) {
+                continue;
+            }
+            const double offset = (s - slot.guess) / sigma;
+            const double base = entry + kPositionWeight * offset * offset - kOnsetWeight * features.Onset(s);
+            for (int64_t length = slot.min_length; length <= slot.max_length; ++length) {
+                const double mismatch = length - slot.expected;
+                const double cost = base + (length - features.Speech(s, s + length)) +
+                                    kDurationWeight * mismatch * mismatch / slot.expected;
+                const size_t at = static_cast<size_t>(s + length - slot.end_low);
+                if (cost < slot.end_cost[at]) {
+                    slot.end_cost[at] = cost;
+                    slot.end_from[at] = s;
+                }
+            }
+        }
+    }
+
+    // Whatever follows the run's last word is free
+    const Slot& tail = (*slots)[last - 1];
+    size_t best = 0;
+    for (size_t at = 1; at < tail.end_cost.size(); ++at) {
+        if (tail.end_cost[at] < tail.end_cost[best]) {
+            best = at;
+        }
+    }
+    int64_t end = tail.end_low + static_cast<int64_t>(best);
+    for (size_t i = last; i-- > first;) {
+        const Slot& slot = (*slots)[i];
+        const int64_t start = slot.end_from[end - slot.end_low];
+        AlignedWord& word = (*words)[i];
+        word.start_ms = start * kFrameMs;
+        word.end_ms = end * kFrameMs;
+        word.start_sample = static_cast<uint64_t>(std::llround(word.start_ms * sample_rate / 1000.0));
+        word.end_sample = static_cast<uint64_t>(std::llround(word.end_ms * sample_rate / 1000.0));
+        word.confidence = static_cast<float>(features.Speech(start, end) / std::max<int64_t>(1, end - start));
+        if (i > first) {
+            end = slot.start_from[start - slot.start_low];
+        }
+    }
+}
+
+AlignmentResult Align(const AlignmentJob& job, const std::atomic<bool>& cancel) {
+    AlignmentResult result;
+    const auto start = std::chrono::steady_clock::now();
+
+    RecordingReader reader;
+    if (!reader.Open(job.index, &result.error)) {
+        return result;
+    }
+    result.audio_ms = reader.DurationMs();
+    if (job.words.empty()) {
+        result.ok = true;
+        return result;
+    }
+
+    // Provider times in frames, kept in order and at least a frame long
+    const size_t count = job.words.size();
+    std::vector<Slot> slots(count);
+    int64_t floor_frame = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const AlignmentWord& word = job.words[i];
+        Slot& slot = slots[i];
+        const int64_t provided = static_cast<int64_t>(std::floor(word.start_ms / kFrameMs));
+        // Back to before a word already placed: a new timeline, not a misordering
+        slot.restart = provided + kRestartFrames < floor_frame;
+        slot.guess = slot.restart ? provided : std::max(floor_frame, provided);
+        slot.provided = std::max<int64_t>(1, static_cast<int64_t>(std::lround(word.end_ms / kFrameMs)) - slot.guess);
+        floor_frame = slot.guess;
+        const double spoken = Syllables(word.text) * kSyllableMs / kFrameMs;
+        slot.expected = std::clamp(0.5 * (slot.provided + spoken), 3.0, static_cast<double>(kMaxWordFrames));
+        slot.min_length = std::max<int64_t>(1, static_cast<int64_t>(slot.expected / 3.0));
+        slot.max_length = std::min<int64_t>(kMaxWordFrames, static_cast<int64_t>(std::ceil(slot.expected * 3.0)) + 1);
+    }
+
+    const int64_t shift = static_cast<int64_t>(job.max_shift_ms / kFrameMs);
+    const int64_t margin = shift + static_cast<int64_t>((job.max_word_shift_ms + kMarginMs) / kFrameMs);
+    const int64_t first = std::max<int64_t>(0, slots.front().guess - margin);
+    const int64_t last = slots.back().guess + slots.back().provided + kMaxWordFrames + margin;
+    Features features;
+    if (!ComputeFeatures(&reader, first, last, cancel, &features, &result.error)) {
+        return result;
+    }
+    const int sample_rate = features.sample_rate > 0 ? features.sample_rate : 16000;
+    result.sample_rate = sample_rate;
+
+    result.words.resize(count);
+    const int64_t run_gap = static_cast<int64_t>(job.run_gap_ms / kFrameMs);
+    int64_t previous_shift = 0;
+    int64_t previous_end = 0;  // of the run before, as placed
+    double shift_sum = 0.0;
+    for (size_t run_first = 0; run_first < count;) {
+        size_t run_last = run_first + 1;
+        while (run_last < count && run_last - run_first < kMaxRunWords && !slots[run_last].restart &&
+               slots[run_last].guess - (slots[run_last - 1].guess + slots[run_last - 1].provided) <= run_gap) {
+            ++run_last;
+        }
+
+        // The shift that best puts the run on speech and the pauses either
+        // side of it on silence, each frame scored by its evidence less a
+        // half; never back over the run before. The pauses inside a run are
+        // too short for provider times to place them.
+        const int64_t run_start = slots[run_first].guess;
+        int64_t run_end = run_start;
+        for (size_t i = run_first; i < run_last; ++i) {
+            run_end = std::max(run_end, slots[i].guess + slots[i].provided);
+        }
+        int64_t best_shift = 0;
+        double best_score = -kInfinity;
+        const int64_t lowest = std::max(-shift, std::max(first, previous_end) - slots[run_first].guess);
+        const int64_t highest = std::max(shift, lowest);
+        for (int64_t k = lowest; k <= highest; ++k) {
+            double score = -kShiftCost * std::llabs(k) - kDriftCost * std::llabs(k - previous_shift);
+            const int64_t from = run_start + k;
+            const int64_t to = run_end + k;
+            score += features.Speech(from, to) - 0.5 * (to - from);
+            const int64_t before = from - kGuardSlackFrames;
+            const int64_t after = to + kGuardSlackFrames;
+            score += kGuardFrames - features.Speech(before - kGuardFrames, before) -
+                     features.Speech(after, after + kGuardFrames);
+            if (score > best_score) {
+                best_score = score;
+                best_shift = k;
+            }
+        }
+        for (size_t i = run_first; i < run_last; ++i) {
+            slots[i].guess += best_shift;
+        }
+        PlaceRun(features, job, previous_end, &slots, run_first, run_last, sample_rate, &result.words);
+        previous_end = static_cast<int64_t>(std::lround(result.words[run_last - 1].end_ms / kFrameMs));
+
+        // The run is placed; free its DP tables
+        for (size_t i = run_first; i < run_last; ++i) {
+            std::vector<double>().swap(slots[i].start_cost);
+            std::vector<int64_t>().swap(slots[i].start_from);
+            std::vector<double>().swap(slots[i].end_cost);
+            std::vector<int64_t>().swap(slots[i].end_from);
+        }
+        previous_shift = best_shift;
+        shift_sum += static_cast<double>(best_shift) * (run_last - run_first);
+        result.max_shift_ms = std::max(result.max_shift_ms, std::llabs(best_shift) * kFrameMs);
+        ++result.runs;
+        run_first = run_last;
+    }
+    result.mean_shift_ms = shift_sum / count * kFrameMs;
+    result.elapsed_ms = MillisecondsSince(start);
+    result.ok = true;
+    return result;
+}
+
+} // namespace
+
+AlignmentResult AlignTranscript(const AlignmentJob& job, const std::atomic<bool>& cancel) {
+    AlignmentResult result = Align(job, cancel);
+    if (result.ok) {
+        Log(LogLevel::kInfo, kLogSource, "%s: %zu words in %zu runs, mean shift %.0fms (max %.0fms), in %.0fms",
+            job.index.c_str(), result.words.size(), result.runs, result.mean_shift_ms, result.max_shift_ms,
+            result.elapsed_ms);
+    } else {
+        Log(LogLevel::kWarn, kLogSource, "%s: %s", job.index.c_str(), result.error.c_str());
+    }
+    return result;
+}
+
+} // namespace kakarot
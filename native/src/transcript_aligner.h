@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// A transcript word where the provider put it, in recording time
+struct AlignmentWord {
+    std::string text;
+    double start_ms = 0.0;
+    double end_ms = 0.0;
+};
+
+struct AlignmentJob {
+    std::string index;                 // <name>.<track>.idx the words were heard on
+    std::vector<AlignmentWord> words;  // in order
+    double max_shift_ms = 3000.0;      // how far a run of words moves as a whole
+    double max_word_shift_ms = 600.0;  // and each word within its run
+    double run_gap_ms = 800.0;         // a longer pause between words starts a new run
+};
+
+struct AlignedWord {
+    double start_ms = 0.0;     // recording time
+    double end_ms = 0.0;
+    uint64_t start_sample = 0;  // the same at the track's sample rate
+    uint64_t end_sample = 0;
+    float confidence = 0.0f;   // mean speech evidence over the word, 0-1
+};
+
+struct AlignmentResult {
+    bool ok = false;
+    std::string error;
+    std::vector<AlignedWord> words;  // one per job word, in order
+    int sample_rate = 0;             // of the track where the first word is
+    size_t runs = 0;
+    double mean_shift_ms = 0.0;      // runs' shifts, weighted by their words
+    double max_shift_ms = 0.0;       // largest move of a run, either way
+    double audio_ms = 0.0;
+    double elapsed_ms = 0.0;
+};
+
+// Forced alignment of a track's transcript, on the calling thread. One pass
+// over the span the words cover computes per-10ms speech evidence (RNN VAD
+// probability and energy against the track's own floor and peak) and onset
+// strength (log mel spectral flux, where phones change). Words split into
+// runs at pauses; each run takes the shift within max_shift_ms that best
+// puts its words on speech, which undoes provider drift and reconnect
+// offsets, then a dynamic programme places each word inside it: speech in
+// words, silence between them, durations near what the provider and the
+// word's syllables suggest, starts on onsets. Polls |cancel| between reads.
+AlignmentResult AlignTranscript(const AlignmentJob& job, const std::atomic<bool>& cancel);
+
+} // namespace kakarot
@@ -0,0 +1,131 @@
+#include "transcript_codec.h"
+#if defined(KAKAROT_HAVE_ZSTD)
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+namespace kakarot {
+
+TranscriptCodec::~TranscriptCodec() { Reset(); }
+
+#if defined(KAKAROT_HAVE_ZSTD)
+
+bool TranscriptCodec::Available() { return true; }
+
+bool TranscriptCodec::TrainDictionary(const std::vector<std::string>& samples, size_t capacity,
+                                      std::string* dictionary, std::string* error) {
+    std::string buffer;
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    for (const std::string& sample : samples) {
+        buffer += sample;
+        sizes.push_back(sample.size());
+    }
+    dictionary->resize(capacity);
+    size_t size = ZDICT_trainFromBuffer(&(*dictionary)[0], capacity, buffer.data(), sizes.data(),
+                                        static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(size)) {
+        dictionary->clear();
+        *error = std::string("dictionary training failed: ") + ZDICT_getErrorName(size);
+        return false;
+    }
+    dictionary->resize(size);
+    return true;
+}
+
+void TranscriptCodec::Reset() {
+    ZSTD_freeCDict(cdict_);
+    ZSTD_freeDDict(ddict_);
+    ZSTD_freeCCtx(cctx_);
+    ZSTD_freeDCtx(dctx_);
+    cdict_ = nullptr;
+    ddict_ = nullptr;
+    cctx_ = nullptr;
+    dctx_ = nullptr;
+}
+
+bool TranscriptCodec::SetDictionary(const std::string& dictionary, int level, std::string* error) {
+    Reset();
+    level_ = level;
+    cctx_ = ZSTD_createCCtx();
+    dctx_ = ZSTD_createDCtx();
+    if (!dictionary.empty()) {
+        cdict_ = ZSTD_createCDict(dictionary.data(), dictionary.size(), level_);
+        ddict_ = ZSTD_createDDict(dictionary.data(), dictionary.size());
+    }
+    if (!cctx_ || !dctx_ || (!dictionary.empty() && (!cdict_ || !ddict_))) {
+        Reset();
+        *error = "out of memory for the zstd dictionary";
+        return false;
+    }
+    return true;
+}
+
+bool TranscriptCodec::Compress(const std::string& input, std::string* output, std::string* error) {
+    if (!cctx_ && !SetDictionary(std::string(), level_, error)) {
+        return false;
+    }
+    output->resize(ZSTD_compressBound(input.size()));
+    size_t size = cdict_ ? ZSTD_compress_usingCDict(cctx_, &(*output)[0], output->size(), input.data(),
+                                                    input.size(), cdict_)
+                         : ZSTD_compressCCtx(cctx_, &(*output)[0], output->size(), input.data(), input.size(),
+                                             level_);
+    if (ZSTD_isError(size)) {
+        output->clear();
+        *error = std::string("zstd: ") + ZSTD_getErrorName(size);
+        return false;
+    }
+    output->resize(size);
+    return true;
+}
+
+bool TranscriptCodec::Decompress(const std::string& input, std::string* output, std::string* error) {
+    if (!dctx_ && !SetDictionary(std::string(), level_, error)) {
+        return false;
+    }
+    unsigned long long content = ZSTD_getFrameContentSize(input.data(), input.size());
+    if (content == ZSTD_CONTENTSIZE_ERROR || content == ZSTD_CONTENTSIZE_UNKNOWN) {
+        *error = "not a zstd frame with its size";
+        return false;
+    }
+    output->resize(static_cast<size_t>(content));
+    size_t size = ddict_ ? ZSTD_decompress_usingDDict(dctx_, &(*output)[0], output->size(), input.data(),
+                                                      input.size(), ddict_)
+                         : ZSTD_decompressDCtx(dctx_, &(*output)[0], output->size(), input.data(), input.size());
+    if (ZSTD_isError(size) || size != content) {
+        output->clear();
+        *error = ZSTD_isError(size) ? std::string("zstd: ") + ZSTD_getErrorName(size) : "zstd: short frame";
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool TranscriptCodec::Available() { return false; }
+
+bool TranscriptCodec::TrainDictionary(const std::vector<std::string>&, size_t, std::string*, std::string* error) {
+    *error = "this build has no zstd";
+    return false;
+}
+
+void TranscriptCodec::Reset() {}
+
+bool TranscriptCodec::SetDictionary(const std::string&, int, std::string* error) {
+    *error = "this build has no zstd";
+    return false;
+}
+
+bool TranscriptCodec::Compress(const std::string&, std::string*, std::string* error) {
+    *error = "this build has no zstd";
+    return false;
+}
+
+bool TranscriptCodec::Decompress(const std::string&, std::string*, std::string* error) {
+    *error = "this build has no zstd";
+    return false;
+}
+
+#endif
+
+} // namespace kakarot
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+namespace kakarot {
+
+// zstd with a dictionary trained on transcript text, for archived
+// meetings: segments are short and alike, and a shared dictionary is what
+// lets each meeting's blob compress well on its own. Builds without libzstd
+// keep the class, and every call fails with Available() false.
+class TranscriptCodec {
+public:
+    TranscriptCodec() = default;
+    ~TranscriptCodec();
+
+    TranscriptCodec(const TranscriptCodec&) = delete;
+    TranscriptCodec& operator=(const TranscriptCodec&) = delete;
+
+    static bool Available();
+
+    // A dictionary of up to |capacity| bytes from |samples|, e.g. one per
+    // segment; needs a few hundred samples to do better than none
+    static bool TrainDictionary(const std::vector<std::string>& samples, size_t capacity, std::string* dictionary,
+                                std::string* error);
+
+    // Empty for none. Digested once; every call after uses it.
+    bool SetDictionary(const std::string& dictionary, int level, std::string* error);
+
+    bool Compress(const std::string& input, std::string* output, std::string* error);
+    // The frame records its size, so the output is allocated once
+    bool Decompress(const std::string& input, std::string* output, std::string* error);
+
+private:
+    void Reset();
+
+    int level_ = 19;
+    ZSTD_CCtx_s* cctx_ = nullptr;
+    ZSTD_DCtx_s* dctx_ = nullptr;
+    ZSTD_CDict_s* cdict_ = nullptr;  // null without a dictionary
+    ZSTD_DDict_s* ddict_ = nullptr;
+};
+
+} // namespace kakarot
@@ -0,0 +1,472 @@
+#include "transcript_frame.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace kakarot {
+
+// Deepness past which a frame is not one of ours
+static constexpr int kMaxDepth = 32;
+
+namespace {
+
+// A forward-only cursor over the frame. Strings are scanned with memchr for
+// their closing quote and copied only when asked for; skipped values are
+// matched bracket by bracket without decoding them.
+class JsonCursor {
+public:
+    JsonCursor(const char* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool Ok() const { return ok_; }
+    bool AtEnd() {
+        SkipSpace();
+        return p_ == end_;
+    }
+
+    bool Consume(char c) {
+        SkipSpace();
+        if (p_ < end_ && *p_ == c) {
+            ++p_;
+            return true;
+        }
+        return false;
+    }
+
+    char Peek() {
+        SkipSpace();
+        return p_ < end_ ? *p_ : '\0';
+    }
+
+    // Inside an object: the next key, false at its end. |first| tracks commas.
+    bool NextKey(bool* first, std::string* key) {
+        if (Consume('}')) {
+            return false;
+        }
+        if (!*first && !Expect(',')) {
+            return false;
+        }
+        *first = false;
+        return String(key) && Expect(':');
+    }
+
+    // Inside an array: true before each element, false at its end
+    bool NextElement(bool* first) {
+        if (Consume(']')) {
+            return false;
+        }
+        if (!*first && !Expect(',')) {
+            return false;
+        }
+        *first = false;
+        return ok_;
+    }
+
+    bool String(std::string* out) {
+        if (!Expect('"')) {
+            return false;
+        }
+        out->clear();
+        while (true) {
+            const char* quote = static_cast<const char*>(std::memchr(p_, '"', end_ - p_));
+            if (!quote) {
+                return Fail();
+            }
+            const char* escape = static_cast<const char*>(std::memchr(p_, '\\', quote - p_));
+            if (!escape) {
+                out->append(p_, quote);
+                p_ = quote + 1;
+                return true;
+            }
+            out->append(p_, escape);
+            p_ = escape + 1;
+            if (!Escape(out)) {
+                return false;
+            }
+        }
+    }
+
+    bool Number(double* value) {
+        SkipSpace();
+        // strtod stops at the frame's end only on a terminator; frames end in '}'
+        char* stop = nullptr;
+        *value = std::strtod(p_, &stop);
+        if (stop == p_ || stop > end_) {
+            return Fail();
+        }
+        p_ = stop;
+        return true;
+    }
+
+    bool Bool(bool* value) {
+        SkipSpace();
+        if (Literal("true")) {
+            *value = true;
+            return true;
+        }
+        if (Literal("false")) {
+            *value = false;
+            return true;
+        }
+        return Fail();
+    }
+
+    // Any value, undecoded
+    bool Skip(int depth = 0) {
+        if (depth > kMaxDepth) {
+            return Fail();
+        }
+        switch (Peek()) {
+            case '"': {
+                ++p_;
+                while (true) {
+                    const char* quote = static_cast<const char*>(std::memchr(p_, '"', end_ - p_));
+                    if (!quote) {
+                        return Fail();
+                    }
+                    // An escaped quote has an odd run of backslashes before it
+                    size_t slashes = 0;
+                    for (const char* q = quote; q > p_ && q[-1] == '\\'; --q) {
+                        ++slashes;
+                    }
+                    p_ = quote + 1;
+                    if (slashes % 2 == 0) {
+                        return true;
+                    }
+                }
+            }
+            case '{': {
+                ++p_;
+                bool first = true;
+                std::string key;
+                while (NextKey(&first, &key)) {
+                    if (!Skip(depth + 1)) {
+                        return false;
+                    }
+                }
+                return ok_;
+            }
+            case '[': {
+                ++p_;
+                bool first = true;
+                while (NextElement(&first)) {
+                    if (!Skip(depth + 1)) {
+                        return false;
+                    }
+                }
+                return ok_;
+            }
+            case 't':
+            case 'f': {
+                bool ignored;
+                return Bool(&ignored);
+            }
+            case 'n':
+                return Literal("null") || Fail();
+            default: {
+                double ignored;
+                return Number(&ignored);
+            }
+        }
+    }
+
+    bool Expect(char c) { return Consume(c) || Fail(); }
+
+private:
+    void SkipSpace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            ++p_;
+        }
+    }
+
+    bool Literal(const char* word) {
+        const size_t length = std::strlen(word);
+        if (static_cast<size_t>(end_ - p_) >= length && std::memcmp(p_, word, length) == 0) {
+            p_ += length;
+            return true;
+        }
+        return false;
+    }
+
+    bool Hex4(uint32_t* code) {
+        if (end_ - p_ < 4) {
+            return Fail();
+        }
+        *code = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = *p_++;
+            *code <<= 4;
+            if (c >= '0' && c <= '9') {
+                *code |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                *code |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                *code |= c - 'A' + 10;
+            } else {
+                return Fail();
+            }
+        }
+        return true;
+    }
+
+    // After a backslash: appends the character it stands for as UTF-8
+    bool Escape(std::string* out) {
+        if (p_ >= end_) {
+            return Fail();
+        }
+        const char c = *p_++;
+        switch (c) {
+            case '"': case '\\': case '/': out->push_back(c); return true;
+            case 'b': out->push_back('\b'); return true;
+            case 'f': out->push_back('\f'); return true;
+            case 'n': out->push_back('\n'); return true;
+            case 'r': out->push_back('\r'); return true;
+            case 't': out->push_back('\t'); return true;
+            case 'u': break;
+            default: return Fail();
+        }
+        uint32_t code = 0;
+        if (!Hex4(&code)) {
+            return false;
+        }
+        if (code >= 0xD800 && code < 0xDC00 && end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') {
+            p_ += 2;
+            uint32_t low = 0;
+            if (!Hex4(&low)) {
+                return false;
+            }
+            code = low >= 0xDC00 && low < 0xE000 ? 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00) : 0xFFFD;
+        } else if (code >= 0xD800 && code < 0xE000) {
+            code = 0xFFFD;
+        }
+        if (code < 0x80) {
+            out->push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out->push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out->push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out->push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        return true;
+    }
+
+    bool Fail() {
+        ok_ = false;
+        p_ = end_;
+        return false;
+    }
+
+    const char* p_;
+    const char* end_;
+    bool ok_ = true;
+};
+
+// { text, start, end, confidence, word_is_final }, times in ms
+bool AssemblyAIWord(JsonCursor* json, TranscriptWord* word) {
+    if (!json->Expect('{')) {
+        return false;
+    }
+    bool first = true;
+    std::string key;
+    double number = 0.0;
+    while (json->NextKey(&first, &key)) {
+        if (key == "text") {
+            json->String(&word->text);
+        } else if (key == "start" && json->Number(&number)) {
+            word->start_ms = number;
+        } else if (key == "end" && json->Number(&number)) {
+            word->end_ms = number;
+        } else if (key == "confidence" && json->Number(&number)) {
+            word->confidence = static_cast<float>(number);
+        } else if (key == "word_is_final") {
+            json->Bool(&word->is_final);
+        } else {
+            json->Skip();
+        }
+    }
+    return json->Ok();
+}
+
+FrameKind ParseAssemblyAI(JsonCursor* json, TranscriptFrame* frame) {
+    bool first = true;
+    bool turn = false;
+    std::string key;
+    std::string type;
+    double number = 0.0;
+    while (json->NextKey(&first, &key)) {
+        if (key == "type") {
+            json->String(&type);
+            turn = type == "Turn";
+            if (!turn) {
+                // Begin, Termination: the rest is not ours to read
+                return json->Ok() ? FrameKind::kOther : FrameKind::kMalformed;
+            }
+        } else if (key == "transcript") {
+            json->String(&frame->text);
+        } else if (key == "end_of_turn") {
+            json->Bool(&frame->end_of_turn);
+        } else if (key == "turn_is_formatted") {
+            json->Bool(&frame->formatted);
+        } else if (key == "turn_order" && json->Number(&number)) {
+            frame->turn = static_cast<int64_t>(number);
+        } else if (key == "words" && json->Expect('[')) {
+            bool first_word = true;
+            while (json->NextElement(&first_word)) {
+                frame->words.emplace_back();
+                if (!AssemblyAIWord(json, &frame->words.back())) {
+                    break;
+                }
+            }
+        } else {
+            json->Skip();
+        }
+    }
+    if (!json->Ok()) {
+        return FrameKind::kMalformed;
+    }
+    if (!turn) {
+        return FrameKind::kOther;
+    }
+    frame->is_final = frame->end_of_turn;
+    if (!frame->words.empty()) {
+        double confidence = 0.0;
+        for (const TranscriptWord& word : frame->words) {
+            confidence += word.confidence;
+        }
+        frame->confidence = static_cast<float>(confidence / frame->words.size());
+        frame->start_ms = frame->words.front().start_ms;
+        frame->end_ms = frame->words.back().end_ms;
+    }
+    return FrameKind::kTranscript;
+}
+
+// { word, punctuated_word?, start, end, confidence }, times in seconds
+bool DeepgramWord(JsonCursor* json, TranscriptWord* word) {
+    if (!json->Expect('{')) {
+        return false;
+    }
+    bool first = true;
+    bool punctuated = false;
+    std::string key;
+    double number = 0.0;
+    while (json->NextKey(&first, &key)) {
+        if (key == "punctuated_word") {
+            punctuated = json->String(&word->text);
+        } else if (key == "word" && !punctuated) {
+            json->String(&word->text);
+        } else if (key == "start" && json->Number(&number)) {
+            word->start_ms = number * 1000.0;
+        } else if (key == "end" && json->Number(&number)) {
+            word->end_ms = number * 1000.0;
+        } else if (key == "confidence" && json->Number(&number)) {
+            word->confidence = static_cast<float>(number);
+        } else {
+            json->Skip();
+        }
+    }
+    return json->Ok();
+}
+
+// channel.alternatives[0]: { transcript, confidence, words }
+bool DeepgramChannel(JsonCursor* json, TranscriptFrame* frame) {
+    if (!json->Expect('{')) {
+        return false;
+    }
+    bool first = true;
+    std::string key;
+    double number = 0.0;
+    while (json->NextKey(&first, &key)) {
+        if (key != "alternatives" || !json->Expect('[')) {
+            json->Skip();
+            continue;
+        }
+        bool first_alternative = true;
+        for (size_t index = 0; json->NextElement(&first_alternative); ++index) {
+            if (index > 0 || !json->Expect('{')) {
+                json->Skip();
+                continue;
+            }
+            bool first_field = true;
+            std::string field;
+            while (json->NextKey(&first_field, &field)) {
+                if (field == "transcript") {
+                    json->String(&frame->text);
+                } else if (field == "confidence" && json->Number(&number)) {
+                    frame->confidence = static_cast<float>(number);
+                } else if (field == "words" && json->Expect('[')) {
+                    bool first_word = true;
+                    while (json->NextElement(&first_word)) {
+                        frame->words.emplace_back();
+                        if (!DeepgramWord(json, &frame->words.back())) {
+                            break;
+                        }
+                    }
+                } else {
+                    json->Skip();
+                }
+            }
+        }
+    }
+    return json->Ok();
+}
+
+FrameKind ParseDeepgram(JsonCursor* json, TranscriptFrame* frame) {
+    bool first = true;
+    bool results = false;
+    std::string key;
+    std::string type;
+    double start = 0.0;
+    double duration = 0.0;
+    while (json->NextKey(&first, &key)) {
+        if (key == "type") {
+            json->String(&type);
+            results = type == "Results";
+            if (!results) {
+                return json->Ok() ? FrameKind::kOther : FrameKind::kMalformed;
+            }
+        } else if (key == "channel") {
+            DeepgramChannel(json, frame);
+        } else if (key == "is_final") {
+            json->Bool(&frame->is_final);
+        } else if (key == "speech_final") {
+            json->Bool(&frame->end_of_turn);
+        } else if (key == "start") {
+            json->Number(&start);
+        } else if (key == "duration") {
+            json->Number(&duration);
+        } else {
+            json->Skip();
+        }
+    }
+    if (!json->Ok()) {
+        return FrameKind::kMalformed;
+    }
+    if (!results) {
+        return FrameKind::kOther;
+    }
+    frame->formatted = true;
+    frame->start_ms = start * 1000.0;
+    frame->end_ms = (start + duration) * 1000.0;
+    for (TranscriptWord& word : frame->words) {
+        word.is_final = frame->is_final;
+    }
+    return FrameKind::kTranscript;
+}
+
+} // namespace
+
+FrameKind ParseTranscriptFrame(TranscriptFormat format, const char* json, size_t size, TranscriptFrame* frame) {
+    *frame = TranscriptFrame();
+    JsonCursor cursor(json, size);
+    if (format == TranscriptFormat::kNone || !cursor.Consume('{')) {
+        return FrameKind::kMalformed;
+    }
+    return format == TranscriptFormat::kAssemblyAI ? ParseAssemblyAI(&cursor, frame) : ParseDeepgram(&cursor, frame);
+}
+
+} // namespace kakarot
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// The streaming providers whose result frames parse natively
+enum class TranscriptFormat { kNone, kAssemblyAI, kDeepgram };
+
+struct TranscriptWord {
+    std::string text;        // Deepgram's punctuated_word when there is one
+    double start_ms = 0.0;   // session time
+    double end_ms = 0.0;
+    float confidence = 0.0f;
+    bool is_final = false;   // AssemblyAI word_is_final; Deepgram the frame's is_final
+};
+
+// The fields of one result frame the app uses. For AssemblyAI (v3 Turn)
+// the turn is turn_order and its times its words'; for Deepgram (Results,
+// first alternative) start and duration are the frame's, formatted is
+// always true and turn is -1.
+struct TranscriptFrame {
+    std::string text;
+    bool is_final = false;     // AssemblyAI end_of_turn, Deepgram is_final
+    bool end_of_turn = false;  // AssemblyAI end_of_turn, Deepgram speech_final
+    bool formatted = false;    // AssemblyAI turn_is_formatted
+    int64_t turn = -1;
+    float confidence = 0.0f;   // Deepgram's alternative's; AssemblyAI the words' mean
+    double start_ms = 0.0;
+    double end_ms = 0.0;
+    std::vector<TranscriptWord> words;
+};
+
+enum class FrameKind { kTranscript, kOther, kMalformed };
+
+// One pass over |json|, on demand: only the fields above are decoded and
+// everything else is skipped without being built. kOther for a well-formed
+// frame that is not a result (Begin, Metadata, ...). |json| is read to a
+// terminator after |size| when a number ends the text, as std::string's is.
+FrameKind ParseTranscriptFrame(TranscriptFormat format, const char* json, size_t size, TranscriptFrame* frame);
+
+} // namespace kakarot
@@ -0,0 +1,937 @@
+#include "transcription_socket.h"
+#include "addon_common.h"
+#include "native_log.h"
+#include "thread_cpu.h"
+#include "wakeup_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+static const char* const kLogSource = "TranscriptionSocket";
+
+// A capture-time step smaller than this is clock jitter, not gated silence
+static constexpr double kTimelineJumpMs = 1.0;
+
+// Longest wait between reconnect attempts, as a power of two of the first
+static constexpr int kMaxBackoffDoublings = 5;
+
+// Latency budget utilization each pressure level starts at, and the audio
+// one message carries at it; a level is left after kRecoveryMs below it
+static constexpr double kPressureUtilization[kMaxTransportPressure + 1] = {0.0, 0.5, 0.75, 1.0};
+static constexpr double kCoalesceMs[kMaxTransportPressure + 1] = {0.0, 100.0, 200.0, 400.0};
+static constexpr double kRecoveryMs = 2000.0;
+
+static WakeupCounter g_send_wakeups("transcriptionSend");
+
+// Round-trip smoothing, and the age a measurement stops counting at (no
+// results lately: the queue speaks for the uplink)
+static constexpr double kRttSmoothing = 0.2;
+static constexpr double kRttStaleMs = 5000.0;
+
+// Sent messages awaiting a result; past it the oldest go unmeasured
+static constexpr size_t kMaxUnanswered = 2048;
+
+#if !defined(__APPLE__) && !defined(_WIN32)
+std::unique_ptr<WebSocketConnection> CreateWebSocketConnection(std::string* error) {
+    *error = "No native websocket on this platform";
+    return nullptr;
+}
+#endif
+
+// One event on its way to the JS thread
+struct SocketEvent {
+    const char* type;
+    std::string text;  // message data, error message or close reason
+    uint16_t code = 0;
+    int attempt = 0;
+    double audio_offset_ms = 0.0;
+    double replayed_ms = 0.0;
+    std::unique_ptr<TranscriptFrame> frame;  // a transcript's
+};
+
+namespace {
+
+std::chrono::steady_clock::duration Milliseconds(double ms) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::milli>(std::max(0.0, ms)));
+}
+
+// Closes a new connection may get past: the peer going away or restarting,
+// an internal error, try-again-later, a bad gateway, or no close frame at all
+bool Retryable(uint16_t code) {
+    return code == 1001 || code == 1006 || code == 1011 || code == 1012 || code == 1013 || code == 1014;
+}
+
+} // namespace
+
+TranscriptionSocket::TranscriptionSocket(TranscriptionSocketConfig config) : config_(std::move(config)) {}
+
+TranscriptionSocket::~TranscriptionSocket() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::kClosed) {
+            state_ = State::kClosing;
+        }
+        // No graceful close here: the object is gone, so nobody waits on one
+        if (connection_) {
+            connection_->Abort();
+        }
+    }
+    wake_.notify_all();
+    if (io_thread_.joinable()) {
+        io_thread_.join();
+    }
+}
+
+bool TranscriptionSocket::Open(Napi::Env env, Napi::Function callback, std::string* error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ != State::kIdle) {
+        *error = "connect() was already called";
+        return false;
+    }
+    connection_ = CreateWebSocketConnection(error);
+    if (!connection_) {
+        return false;
+    }
+    tsfn_ = Napi::ThreadSafeFunction::New(env, callback, "TranscriptionSocket", 0, 1);
+    state_ = State::kConnecting;
+    io_thread_ = std::thread(&TranscriptionSocket::Run, this);
+    return true;
+}
+
+void TranscriptionSocket::SendAudio(const int16_t* samples, size_t num_samples, double timestamp) {
+    if (num_samples == 0) {
+        return;
+    }
+    const size_t bytes = num_samples * sizeof(int16_t);
+    Message message{std::vector<uint8_t>(bytes), false};
+    std::memcpy(message.bytes.data(), samples, bytes);  // little-endian hosts only, as the providers expect
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == State::kClosing || state_ == State::kClosed) {
+        dropped_bytes_ += bytes;
+        return;
+    }
+    message.start_sample = next_sample_;
+    message.timestamp = timestamp > 0.0 ? timestamp : next_timestamp_;
+    const size_t frames = num_samples / config_.channels;
+    next_sample_ += frames;
+    next_timestamp_ = message.timestamp + frames * 1000.0 / config_.sample_rate;
+    queue_.push_back(std::move(message));
+    queued_bytes_ += bytes;
+    // Past the bound the oldest audio goes; text frames are kept
+    while (queued_bytes_ > config_.max_queued_bytes) {
+        auto oldest = std::find_if(queue_.begin(), queue_.end(), [](const Message& queued) { return !queued.text; });
+        if (oldest == queue_.end()) {
+            break;
+        }
+        queued_bytes_ -= oldest->bytes.size();
+        dropped_bytes_ += oldest->bytes.size();
+        queue_.erase(oldest);
+    }
+    wake_.notify_all();
+}
+
+void TranscriptionSocket::SendText(std::string text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == State::kClosing || state_ == State::kClosed) {
+        return;
+    }
+    queue_.push_back(Message{std::vector<uint8_t>(text.begin(), text.end()), true});
+    queued_bytes_ += text.size();
+    wake_.notify_all();
+}
+
+void TranscriptionSocket::Acknowledge(double session_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t session_sample = static_cast<uint64_t>(std::max(0.0, session_ms) * config_.sample_rate / 1000.0);
+    const TimelinePoint* point = PointAt(session_sample);
+    if (!point) {
+        return;
+    }
+    acked_sample_ = std::max(acked_sample_, point->stream_sample + (session_sample - point->session_sample));
+    TrimHistory();
+    if (config_.parse == TranscriptFormat::kNone) {
+        Answered(session_sample);  // parsed partials answer sooner
+    }
+}
+
+double TranscriptionSocket::CaptureTime(double session_ms) const {
+    TimelinePosition position;
+    return AtSessionTime(session_ms, &position) ? position.capture_time : 0.0;
+}
+
+bool TranscriptionSocket::AtSessionTime(double session_ms, TimelinePosition* position) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t session_sample = static_cast<uint64_t>(std::max(0.0, session_ms) * config_.sample_rate / 1000.0);
+    const TimelinePoint* point = PointAt(session_sample);
+    if (!point) {
+        return false;
+    }
+    *position = PositionAt(*point, session_sample - point->session_sample);
+    return true;
+}
+
+bool TranscriptionSocket::AtStreamSample(uint64_t stream_sample, TimelinePosition* position) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto after = std::upper_bound(timeline_.begin(), timeline_.end(), stream_sample,
+                                  [](uint64_t sample, const TimelinePoint& point) { return sample < point.stream_sample; });
+    if (after == timeline_.begin()) {
+        return false;
+    }
+    *position = Resumed(after - 1, stream_sample - (after - 1)->stream_sample);
+    return true;
+}
+
+bool TranscriptionSocket::AtCaptureTime(double capture_time, TimelinePosition* position) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto after = std::upper_bound(timeline_.begin(), timeline_.end(), capture_time,
+                                  [](double time, const TimelinePoint& point) { return time < point.timestamp; });
+    if (after == timeline_.begin()) {
+        return false;
+    }
+    const auto offset = static_cast<uint64_t>((capture_time - (after - 1)->timestamp) * config_.sample_rate / 1000.0);
+    *position = Resumed(after - 1, offset);
+    return true;
+}
+
+void TranscriptionSocket::Close(uint16_t code) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == State::kIdle) {
+        state_ = State::kClosed;
+    } else if (state_ != State::kClosed) {
+        state_ = State::kClosing;
+        close_code_ = code;
+    }
+    wake_.notify_all();
+}
+
+TranscriptionSocket::Stats TranscriptionSocket::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{state_,         sent_bytes_,   sent_messages_, received_messages_, parsed_messages_,
+                 dropped_bytes_, queued_bytes_, reconnects_,    replayed_bytes_,    history_bytes_,
+                 pressure_.load(std::memory_order_relaxed), rtt_ms_, BacklogMs(), budget_utilization_,
+                 coalesced_messages_};
+}
+
+// Lock held. The timeline point |session_sample| falls after; null before
+// the session sent anything.
+const TranscriptionSocket::TimelinePoint* TranscriptionSocket::PointAt(uint64_t session_sample) const {
+    auto after = std::upper_bound(timeline_.begin(), timeline_.end(), session_sample,
+                                  [](uint64_t sample, const TimelinePoint& point) { return sample < point.session_sample; });
+    return after == timeline_.begin() ? nullptr : &*(after - 1);
+}
+
+// Lock held. |offset| samples into the segment |point| starts
+TranscriptionSocket::TimelinePosition TranscriptionSocket::PositionAt(const TimelinePoint& point,
+                                                                      uint64_t offset) const {
+    return TimelinePosition{(point.session_sample + offset) * 1000.0 / config_.sample_rate,
+                            point.stream_sample + offset,
+                            point.timestamp + offset * 1000.0 / config_.sample_rate};
+}
+
+// Lock held. |offset| samples into the segment |point| starts, or the start
+// of the next one when that is past its end; the newest segment extrapolates
+TranscriptionSocket::TimelinePosition TranscriptionSocket::Resumed(std::vector<TimelinePoint>::const_iterator point,
+                                                                   uint64_t offset) const {
+    auto next = point + 1;
+    if (next != timeline_.end() && offset >= next->session_sample - point->session_sample) {
+        return PositionAt(*next, 0);
+    }
+    return PositionAt(*point, offset);
+}
+
+// I/O thread, lock held. |message| is on the wire: extend the session's
+// timeline and keep it for a replay.
+void TranscriptionSocket::Sent(Message message) {
+    const size_t samples = Samples(message);
+    if (config_.latency_budget_ms > 0.0) {
+        if (unanswered_.size() == kMaxUnanswered) {
+            unanswered_.pop_front();
+        }
+        unanswered_.push_back(Unanswered{session_samples_, std::chrono::steady_clock::now()});
+    }
+    if (timeline_.empty() || message.start_sample != session_next_sample_ ||
+        std::abs(message.timestamp - session_next_time_) > kTimelineJumpMs) {
+        timeline_.push_back(TimelinePoint{session_samples_, message.start_sample, message.timestamp});
+    }
+    session_samples_ += samples;
+    session_next_sample_ = message.start_sample + samples;
+    session_next_time_ = message.timestamp + samples * 1000.0 / config_.sample_rate;
+    if (config_.replay_ms <= 0.0) {
+        return;
+    }
+    history_bytes_ += message.bytes.size();
+    history_.push_back(std::move(message));
+    TrimHistory();
+}
+
+// Lock held. Drops history past replay_ms and what the provider acknowledged
+void TranscriptionSocket::TrimHistory() {
+    const size_t limit =
+        static_cast<size_t>(config_.replay_ms * config_.sample_rate / 1000.0) * sizeof(int16_t) * config_.channels;
+    while (!history_.empty() && (history_bytes_ > limit ||
+                                 history_.front().start_sample + Samples(history_.front()) <= acked_sample_)) {
+        history_bytes_ -= history_.front().bytes.size();
+        history_.pop_front();
+    }
+}
+
+// I/O thread, lock held. Under pressure, queued audio that continues
+// |message| rides along in it, up to the level's coalescing span: fewer,
+// larger frames for a congested uplink
+void TranscriptionSocket::Coalesce(Message* message) {
+    const size_t limit = static_cast<size_t>(kCoalesceMs[pressure_.load(std::memory_order_relaxed)] *
+                                             config_.sample_rate / 1000.0) * sizeof(int16_t) * config_.channels;
+    while (!queue_.empty() && !queue_.front().text && message->bytes.size() + queue_.front().bytes.size() <= limit) {
+        const Message& next = queue_.front();
+        const size_t samples = Samples(*message);
+        if (next.start_sample != message->start_sample + samples ||
+            std::abs(next.timestamp - (message->timestamp + samples * 1000.0 / config_.sample_rate)) > kTimelineJumpMs) {
+            break;  // a jump starts a timeline segment of its own
+        }
+        message->bytes.insert(message->bytes.end(), next.bytes.begin(), next.bytes.end());
+        queued_bytes_ -= next.bytes.size();
+        coalesced_messages_++;
+        queue_.pop_front();
+    }
+}
+
+// Lock held. A result reached |session_sample|: the time since the newest
+// message it covers went out is a round trip, once per message
+void TranscriptionSocket::Answered(uint64_t session_sample) {
+    bool answered = false;
+    std::chrono::steady_clock::time_point sent;
+    while (!unanswered_.empty() && unanswered_.front().session_begin <= session_sample) {
+        sent = unanswered_.front().sent;
+        answered = true;
+        unanswered_.pop_front();
+    }
+    if (!answered) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const double rtt_ms = std::chrono::duration<double, std::milli>(now - sent).count();
+    rtt_ms_ = rtt_ms_ == 0.0 ? rtt_ms : rtt_ms_ + kRttSmoothing * (rtt_ms - rtt_ms_);
+    rtt_at_ = now;
+    UpdatePressure();
+}
+
+// Lock held. Re-rates the latency budget: pressure rises at once to the
+// level its utilization reaches, and falls a level per kRecoveryMs below
+void TranscriptionSocket::UpdatePressure() {
+    if (config_.latency_budget_ms <= 0.0) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const double rtt_ms = now - rtt_at_ < Milliseconds(kRttStaleMs) ? rtt_ms_ : 0.0;
+    const double backlog_ms = BacklogMs();
+    budget_utilization_ = std::max(backlog_ms, rtt_ms) / config_.latency_budget_ms;
+    int target = 0;
+    while (target < kMaxTransportPressure && budget_utilization_ >= kPressureUtilization[target + 1]) {
+        target++;
+    }
+    const int pressure = pressure_.load(std::memory_order_relaxed);
+    int next = pressure;
+    if (target >= pressure) {
+        calm_since_ = now;
+        next = target;
+    } else {
+        const auto steps = static_cast<int>((now - calm_since_) / Milliseconds(kRecoveryMs));
+        if (steps > 0) {
+            calm_since_ = now;
+            next = std::max(target, pressure - steps);
+        }
+    }
+    if (next != pressure) {
+        Log(LogLevel::kInfo, kLogSource, "pressure %d -> %d (backlog %.0fms, round trip %.0fms)", pressure, next,
+            backlog_ms, rtt_ms);
+        pressure_.store(next, std::memory_order_relaxed);
+    }
+}
+
+// Lock held. The audio queued, in ms (text frames are too few to count)
+double TranscriptionSocket::BacklogMs() const {
+    return queued_bytes_ * 1000.0 / (sizeof(int16_t) * config_.channels * config_.sample_rate);
+}
+
+// I/O thread, lock held, as a session opens. Puts the history back at the
+// head of the queue, so the new session starts where the provider's last
+// final result ended; returns that stream position.
+uint64_t TranscriptionSocket::Requeue(uint64_t* replayed_samples) {
+    TrimHistory();
+    *replayed_samples = 0;
+    for (auto it = history_.rbegin(); it != history_.rend(); ++it) {
+        *replayed_samples += Samples(*it);
+        replayed_bytes_ += it->bytes.size();
+        queued_bytes_ += it->bytes.size();
+        queue_.push_front(std::move(*it));
+    }
+    history_.clear();
+    history_bytes_ = 0;
+    timeline_.clear();
+    session_samples_ = 0;
+    unanswered_.clear();
+    auto first = std::find_if(queue_.begin(), queue_.end(), [](const Message& queued) { return !queued.text; });
+    return first != queue_.end() ? first->start_sample : next_sample_;
+}
+
+// I/O thread. Writes the queue out until close() or a hang-up; false, with
+// |error| set and the message put back, when a send fails
+bool TranscriptionSocket::Stream(std::unique_lock<std::mutex>& lock, std::string* error) {
+    const auto keep_alive = Milliseconds(config_.keep_alive_ms);
+    const bool keeps_alive = config_.keep_alive_ms > 0.0 && !config_.keep_alive_message.empty();
+    auto stopping = [this] { return state_ == State::kClosing || receive_done_; };
+    auto ready = [&] { return !queue_.empty() || stopping(); };
+    for (;;) {
+        if (receive_done_) {
+            return true;  // what is queued waits for the next session
+        }
+        if (queue_.empty()) {
+            if (state_ == State::kClosing) {
+                return true;
+            }
+            if (!keeps_alive && pressure_.load(std::memory_order_relaxed) == 0) {
+                wake_.wait(lock, ready);
+            } else if (!keeps_alive) {
+                // Idle under pressure: the calm counts toward recovery
+                wake_.wait_for(lock, Milliseconds(kRecoveryMs), ready);
+                UpdatePressure();
+            } else if (!wake_.wait_for(lock, keep_alive, ready)) {
+                queue_.push_back(Message{std::vector<uint8_t>(config_.keep_alive_message.begin(),
+                                                              config_.keep_alive_message.end()), true});
+                queued_bytes_ += config_.keep_alive_message.size();
+            }
+            g_send_wakeups.Count();
+            continue;
+        }
+
+        Message message = std::move(queue_.front());
+        queue_.pop_front();
+        queued_bytes_ -= message.bytes.size();
+        if (!message.text) {
+            Coalesce(&message);
+        }
+        lock.unlock();
+        const bool sent = connection_->Send(message.bytes.data(), message.bytes.size(), message.text, error);
+        lock.lock();
+        if (!sent) {
+            queued_bytes_ += message.bytes.size();
+            queue_.push_front(std::move(message));
+            return false;
+        }
+        sent_bytes_ += message.bytes.size();
+        sent_messages_++;
+        UpdatePressure();
+        if (message.text) {
+            continue;
+        }
+        const double duration_ms = Samples(message) * 1000.0 / config_.sample_rate;
+        Sent(std::move(message));
+
+        // Behind live (a replay, or audio held while connecting): no faster
+        // than replay_rate, which the providers accept, until caught up
+        const bool behind =
+            std::any_of(queue_.begin(), queue_.end(), [](const Message& queued) { return !queued.text; });
+        if (behind && config_.replay_rate > 0.0) {
+            wake_.wait_for(lock, Milliseconds(duration_ms / config_.replay_rate), stopping);
+        }
+    }
+}
+
+// I/O thread, once close() was asked for and the queue is out. The server
+// sends its last results before it hangs up: ask it to finish, then close
+// ourselves only if it does not. False when the close message did not go out.
+bool TranscriptionSocket::CloseGracefully(std::unique_lock<std::mutex>& lock, std::string* error) {
+    const auto close_timeout = Milliseconds(config_.close_timeout_ms);
+    auto hung_up = [this] { return receive_done_; };
+    if (!config_.close_message.empty()) {
+        lock.unlock();
+        const bool sent = connection_->Send(reinterpret_cast<const uint8_t*>(config_.close_message.data()),
+                                            config_.close_message.size(), true, error);
+        lock.lock();
+        if (!sent) {
+            return false;
+        }
+        wake_.wait_for(lock, close_timeout, hung_up);
+    }
+    if (!receive_done_) {
+        const uint16_t code = close_code_;
+        lock.unlock();
+        connection_->Shutdown(code);
+        lock.lock();
+        wake_.wait_for(lock, close_timeout, hung_up);
+    }
+    return true;
+}
+
+// I/O thread: a session per connection until close(), a deliberate close by
+// the server, or reconnect_attempts failures in a row
+void TranscriptionSocket::Run() {
+    ScopedThreadCpu thread_cpu("transcriptionIo");
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::string error;   // why the last attempt or session ended
+    std::string report;  // posted before 'close'
+    uint16_t close_code = 1006;
+    std::string close_reason;
+    int failures = 0;
+    for (;;) {
+        if (state_ == State::kClosing) {
+            break;
+        }
+        if (failures > 0) {
+            if (failures > config_.reconnect_attempts) {
+                report = error;
+                break;
+            }
+            lock.unlock();
+            SocketEvent* reconnecting = new SocketEvent{"reconnecting", error};
+            reconnecting->attempt = failures;
+            Post(reconnecting);
+            lock.lock();
+            const double delay_ms = config_.reconnect_delay_ms * std::pow(2.0, std::min(failures - 1, kMaxBackoffDoublings));
+            if (wake_.wait_for(lock, Milliseconds(delay_ms), [this] { return state_ == State::kClosing; })) {
+                break;
+            }
+            std::string unused;
+            connection_ = CreateWebSocketConnection(&unused);
+            receive_done_ = false;
+            receive_error_.clear();
+            reconnects_++;
+            state_ = State::kConnecting;
+        }
+
+        lock.unlock();
+        const bool connected = connection_->Connect(config_.url, config_.headers, &error);
+        lock.lock();
+        if (!connected) {
+            Log(LogLevel::kWarn, kLogSource, "connect failed: %s", error.c_str());
+            close_code = 1006;
+            close_reason.clear();
+            failures++;
+            continue;
+        }
+        uint64_t replayed = 0;
+        const uint64_t offset = Requeue(&replayed);
+        if (state_ == State::kConnecting) {
+            state_ = State::kOpen;
+        }
+        const uint64_t received_before = received_messages_;
+        lock.unlock();
+        SocketEvent* open = new SocketEvent{"open"};
+        open->audio_offset_ms = offset * 1000.0 / config_.sample_rate;
+        open->replayed_ms = replayed * 1000.0 / config_.sample_rate;
+        Post(open);
+        receive_thread_ = std::thread(&TranscriptionSocket::ReceiveLoop, this);
+        lock.lock();
+
+        std::string send_error;
+        bool sent = Stream(lock, &send_error);
+        if (sent && state_ == State::kClosing && !receive_done_) {
+            sent = CloseGracefully(lock, &send_error);
+        }
+        const bool requested = state_ == State::kClosing;
+        const std::string receive_error = receive_done_ ? receive_error_ : std::string();
+        close_code = connection_->CloseCode();
+        close_reason = connection_->CloseReason();
+        lock.unlock();
+        connection_->Abort();
+        receive_thread_.join();
+        lock.lock();
+
+        if (requested) {
+            report = sent ? std::string() : send_error;
+            break;
+        }
+        error = sent ? receive_error : send_error;
+        if (sent && !Retryable(close_code)) {
+            report = error;  // the server ended the session on purpose
+            break;
+        }
+        Log(LogLevel::kWarn, kLogSource, "connection lost (%u): %s", static_cast<unsigned>(close_code), error.c_str());
+        if (error.empty()) {
+            error = "Connection lost (" + std::to_string(close_code) + ")";
+        }
+        // A session that produced results resets the budget; one that died
+        // straight after the upgrade does not
+        failures = received_messages_ > received_before ? 1 : failures + 1;
+    }
+
+    state_ = State::kClosed;
+    dropped_bytes_ += queued_bytes_;
+    queue_.clear();
+    queued_bytes_ = 0;
+    history_.clear();
+    history_bytes_ = 0;
+    lock.unlock();
+    if (!report.empty()) {
+        Post(new SocketEvent{"error", report});
+    }
+    SocketEvent* closed = new SocketEvent{"close", close_reason};
+    closed->code = close_code;
+    Post(closed);
+    tsfn_.Release();
+}
+
+// Receive thread: every text frame to JS until the connection ends; with
+// the parse option, result frames as their parsed fields and the rest as is
+void TranscriptionSocket::ReceiveLoop() {
+    ScopedThreadCpu thread_cpu("transcriptionReceive");
+    std::string message;
+    std::string error;
+    bool text = false;
+    while (connection_->Receive(&message, &text, &error)) {
+        if (!text) {
+            continue;  // providers answer in JSON; binary frames carry nothing for us
+        }
+        std::unique_ptr<TranscriptFrame> frame;
+        if (config_.parse != TranscriptFormat::kNone) {
+            frame = std::make_unique<TranscriptFrame>();
+            if (ParseTranscriptFrame(config_.parse, message.data(), message.size(), frame.get()) !=
+                FrameKind::kTranscript) {
+                frame.reset();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            received_messages_++;
+            parsed_messages_ += frame ? 1 : 0;
+            if (frame && frame->end_ms > 0.0) {
+                Answered(static_cast<uint64_t>(frame->end_ms * config_.sample_rate / 1000.0));
+            }
+        }
+        if (frame) {
+            SocketEvent* event = new SocketEvent{"transcript"};
+            event->frame = std::move(frame);
+            Post(event);
+        } else {
+            Post(new SocketEvent{"message", std::move(message)});
+        }
+        message = std::string();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    receive_done_ = true;
+    receive_error_ = error;
+    wake_.notify_all();
+}
+
+void TranscriptionSocket::Post(SocketEvent* event) {
+    napi_status status = tsfn_.NonBlockingCall(event, [](Napi::Env env, Napi::Function callback, SocketEvent* event) {
+        Napi::Object object = Napi::Object::New(env);
+        object.Set("type", Napi::String::New(env, event->type));
+        if (std::strcmp(event->type, "open") == 0) {
+            object.Set("audioOffsetMs", Napi::Number::New(env, event->audio_offset_ms));
+            object.Set("replayedMs", Napi::Number::New(env, event->replayed_ms));
+        } else if (std::strcmp(event->type, "message") == 0) {
+            object.Set("data", Napi::String::New(env, event->text));
+        } else if (std::strcmp(event->type, "transcript") == 0) {
+            const TranscriptFrame& frame = *event->frame;
+            object.Set("text", Napi::String::New(env, frame.text));
+            object.Set("isFinal", Napi::Boolean::New(env, frame.is_final));
+            object.Set("endOfTurn", Napi::Boolean::New(env, frame.end_of_turn));
+            object.Set("formatted", Napi::Boolean::New(env, frame.formatted));
+            object.Set("turn", Napi::Number::New(env, static_cast<double>(frame.turn)));
+            object.Set("confidence", Napi::Number::New(env, frame.confidence));
+            object.Set("startMs", Napi::Number::New(env, frame.start_ms));
+            object.Set("endMs", Napi::Number::New(env, frame.end_ms));
+            // Word texts, and their start, end, confidence and final flag packed four apiece
+            Napi::Array words = Napi::Array::New(env, frame.words.size());
+            Napi::Float64Array times = Napi::Float64Array::New(env, frame.words.size() * 4);
+            for (size_t i = 0; i < frame.words.size(); ++i) {
+                const TranscriptWord& word = frame.words[i];
+                words.Set(static_cast<uint32_t>(i), Napi::String::New(env, word.text));
+                times[i * 4] = word.start_ms;
+                times[i * 4 + 1] = word.end_ms;
+                times[i * 4 + 2] = word.confidence;
+                times[i * 4 + 3] = word.is_final ? 1.0 : 0.0;
+            }
+            object.Set("words", words);
+            object.Set("wordTimes", times);
+        } else if (std::strcmp(event->type, "reconnecting") == 0) {
+            object.Set("attempt", Napi::Number::New(env, event->attempt));
+            object.Set("message", Napi::String::New(env, event->text));
+        } else if (std::strcmp(event->type, "error") == 0) {
+            object.Set("message", Napi::String::New(env, event->text));
+        } else if (std::strcmp(event->type, "close") == 0) {
+            object.Set("code", Napi::Number::New(env, event->code));
+            object.Set("reason", Napi::String::New(env, event->text));
+        }
+        delete event;
+        try {
+            callback.Call({object});
+        } catch (...) {
+            // Silently catch to prevent crash
+        }
+    });
+    if (status != napi_ok) {
+        delete event;
+    }
+}
+
+namespace {
+
+const char* StateName(TranscriptionSocket::State state) {
+    switch (state) {
+        case TranscriptionSocket::State::kIdle: return "idle";
+        case TranscriptionSocket::State::kConnecting: return "connecting";
+        case TranscriptionSocket::State::kOpen: return "open";
+        case TranscriptionSocket::State::kClosing: return "closing";
+        case TranscriptionSocket::State::kClosed: return "closed";
+    }
+    return "closed";
+}
+
+// new TranscriptionSocket({ url, headers?, sampleRate?, channels?, maxQueuedBytes?,
+// keepAlive?: { message, intervalMs }, closeMessage?, closeTimeoutMs?,
+// reconnect?: { attempts, delayMs? }, replayMs?, replayRate?, parse?,
+// latencyBudgetMs? }). Keep a reference while it is open: collecting it
+// drops the connection.
+class TranscriptionSocketWrap : public Napi::ObjectWrap<TranscriptionSocketWrap> {
+public:
+    static Napi::Function Define(Napi::Env env) {
+        return DefineClass(env, "TranscriptionSocket", {
+            InstanceMethod("connect", &TranscriptionSocketWrap::Connect),
+            InstanceMethod("send", &TranscriptionSocketWrap::Send),
+            InstanceMethod("sendAudio", &TranscriptionSocketWrap::SendAudio),
+            InstanceMethod("acknowledge", &TranscriptionSocketWrap::Acknowledge),
+            InstanceMethod("captureTime", &TranscriptionSocketWrap::CaptureTime),
+            InstanceMethod("locate", &TranscriptionSocketWrap::Locate),
+            InstanceMethod("close", &TranscriptionSocketWrap::Close),
+            InstanceMethod("getStats", &TranscriptionSocketWrap::GetStats),
+        });
+    }
+
+    explicit TranscriptionSocketWrap(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<TranscriptionSocketWrap>(info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("url").IsString()) {
+            Napi::TypeError::New(env, "Expected { url, headers? }").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = info[0].As<Napi::Object>();
+        TranscriptionSocketConfig config;
+        config.url = options.Get("url").As<Napi::String>().Utf8Value();
+        if (config.url.compare(0, 6, "wss://") != 0 && config.url.compare(0, 5, "ws://") != 0) {
+            Napi::TypeError::New(env, "url must be ws:// or wss://").ThrowAsJavaScriptException();
+            return;
+        }
+        if (options.Get("headers").IsObject()) {
+            Napi::Object headers = options.Get("headers").As<Napi::Object>();
+            Napi::Array names = headers.GetPropertyNames();
+            for (uint32_t i = 0; i < names.Length(); ++i) {
+                Napi::Value value = headers.Get(names.Get(i));
+                if (value.IsString()) {
+                    config.headers.emplace_back(names.Get(i).As<Napi::String>().Utf8Value(),
+                                                value.As<Napi::String>().Utf8Value());
+                }
+            }
+        }
+        if (options.Get("sampleRate").IsNumber()) {
+            config.sample_rate = std::max(1000, options.Get("sampleRate").As<Napi::Number>().Int32Value());
+        }
+        if (options.Get("channels").IsNumber()) {
+            config.channels = std::max(1, std::min(8, options.Get("channels").As<Napi::Number>().Int32Value()));
+        }
+        if (options.Get("maxQueuedBytes").IsNumber()) {
+            config.max_queued_bytes = static_cast<size_t>(
+                std::max(0.0, options.Get("maxQueuedBytes").As<Napi::Number>().DoubleValue()));
+        }
+        if (options.Get("keepAlive").IsObject()) {
+            Napi::Object keep_alive = options.Get("keepAlive").As<Napi::Object>();
+            if (keep_alive.Get("message").IsString() && keep_alive.Get("intervalMs").IsNumber()) {
+                config.keep_alive_message = keep_alive.Get("message").As<Napi::String>().Utf8Value();
+                config.keep_alive_ms = keep_alive.Get("intervalMs").As<Napi::Number>().DoubleValue();
+            }
+        }
+        if (options.Get("closeMessage").IsString()) {
+            config.close_message = options.Get("closeMessage").As<Napi::String>().Utf8Value();
+        }
+        if (options.Get("closeTimeoutMs").IsNumber()) {
+            config.close_timeout_ms = options.Get("closeTimeoutMs").As<Napi::Number>().DoubleValue();
+        }
+        if (options.Get("reconnect").IsObject()) {
+            Napi::Object reconnect = options.Get("reconnect").As<Napi::Object>();
+            if (reconnect.Get("attempts").IsNumber()) {
+                config.reconnect_attempts = std::max(0, reconnect.Get("attempts").As<Napi::Number>().Int32Value());
+            }
+            if (reconnect.Get("delayMs").IsNumber()) {
+                config.reconnect_delay_ms = reconnect.Get("delayMs").As<Napi::Number>().DoubleValue();
+            }
+        }
+        if (options.Get("replayMs").IsNumber()) {
+            config.replay_ms = std::max(0.0, options.Get("replayMs").As<Napi::Number>().DoubleValue());
+        }
+        if (options.Get("replayRate").IsNumber()) {
+            config.replay_rate = std::max(0.0, options.Get("replayRate").As<Napi::Number>().DoubleValue());
+        }
+        if (options.Get("latencyBudgetMs").IsNumber()) {
+            config.latency_budget_ms = std::max(0.0, options.Get("latencyBudgetMs").As<Napi::Number>().DoubleValue());
+        }
+        // 'assemblyai' (v3 Turn) or 'deepgram' (Results)
+        if (options.Get("parse").IsString()) {
+            std::string parse = options.Get("parse").As<Napi::String>().Utf8Value();
+            config.parse = parse == "assemblyai" ? TranscriptFormat::kAssemblyAI
+                : parse == "deepgram" ? TranscriptFormat::kDeepgram : TranscriptFormat::kNone;
+        }
+        socket_ = std::make_shared<TranscriptionSocket>(std::move(config));
+    }
+
+    std::shared_ptr<TranscriptionSocket> Socket() const { return socket_; }
+
+private:
+    // connect(onEvent) -> boolean; false when already used or unsupported here
+    Napi::Value Connect(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsFunction()) {
+            Napi::TypeError::New(env, "Expected an event callback").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        std::string error;
+        if (!socket_->Open(env, info[0].As<Napi::Function>(), &error)) {
+            Log(LogLevel::kWarn, kLogSource, "connect: %s", error.c_str());
+            return Napi::Boolean::New(env, false);
+        }
+        return Napi::Boolean::New(env, true);
+    }
+
+    // send(text): a text frame, after the audio already queued
+    Napi::Value Send(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsString()) {
+            Napi::TypeError::New(env, "Expected a string").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        socket_->SendText(info[0].As<Napi::String>().Utf8Value());
+        return env.Undefined();
+    }
+
+    // sendAudio(Int16Array, timestamp?): for audio that arrives in JS
+    // (audiotee); native capture streams send through their transport option
+    Napi::Value SendAudio(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsTypedArray() ||
+            info[0].As<Napi::TypedArray>().TypedArrayType() != napi_int16_array) {
+            Napi::TypeError::New(env, "Expected an Int16Array").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Int16Array samples = info[0].As<Napi::Int16Array>();
+        double timestamp = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().DoubleValue() : 0.0;
+        socket_->SendAudio(samples.Data(), samples.ElementLength(), timestamp);
+        return env.Undefined();
+    }
+
+    // acknowledge(sessionMs): final results cover the session up to here
+    Napi::Value Acknowledge(const Napi::CallbackInfo& info) {
+        if (info.Length() > 0 && info[0].IsNumber()) {
+            socket_->Acknowledge(info[0].As<Napi::Number>().DoubleValue());
+        }
+        return info.Env().Undefined();
+    }
+
+    // captureTime(sessionMs) -> Date.now() time the audio there was captured; 0 when unknown
+    Napi::Value CaptureTime(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsNumber()) {
+            Napi::TypeError::New(env, "Expected sessionMs").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        return Napi::Number::New(env, socket_->CaptureTime(info[0].As<Napi::Number>().DoubleValue()));
+    }
+
+    // locate({ sessionMs } | { streamSample } | { captureTime })
+    //   -> { sessionMs, streamSample, captureTime } | null
+    Napi::Value Locate(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        if (info.Length() < 1 || !info[0].IsObject()) {
+            Napi::TypeError::New(env, "Expected { sessionMs | streamSample | captureTime }").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        Napi::Object query = info[0].As<Napi::Object>();
+        auto number = [&](const char* key, double* value) {
+            Napi::Value v = query.Get(key);
+            if (!v.IsNumber()) {
+                return false;
+            }
+            *value = v.As<Napi::Number>().DoubleValue();
+            return true;
+        };
+        TranscriptionSocket::TimelinePosition position;
+        double value = 0.0;
+        bool found = false;
+        if (number("sessionMs", &value)) {
+            found = socket_->AtSessionTime(value, &position);
+        } else if (number("streamSample", &value)) {
+            found = socket_->AtStreamSample(static_cast<uint64_t>(std::max(0.0, value)), &position);
+        } else if (number("captureTime", &value)) {
+            found = socket_->AtCaptureTime(value, &position);
+        } else {
+            Napi::TypeError::New(env, "Expected { sessionMs | streamSample | captureTime }").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (!found) {
+            return env.Null();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("sessionMs", Napi::Number::New(env, position.session_ms));
+        result.Set("streamSample", Napi::Number::New(env, static_cast<double>(position.stream_sample)));
+        result.Set("captureTime", Napi::Number::New(env, position.capture_time));
+        return result;
+    }
+
+    // close(code = 1000)
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        uint16_t code = 1000;
+        if (info.Length() > 0 && info[0].IsNumber()) {
+            code = static_cast<uint16_t>(info[0].As<Napi::Number>().Uint32Value());
+        }
+        socket_->Close(code);
+        return info.Env().Undefined();
+    }
+
+    Napi::Value GetStats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        TranscriptionSocket::Stats stats = socket_->GetStats();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("state", Napi::String::New(env, StateName(stats.state)));
+        result.Set("sentBytes", Napi::Number::New(env, static_cast<double>(stats.sent_bytes)));
+        result.Set("sentMessages", Napi::Number::New(env, static_cast<double>(stats.sent_messages)));
+        result.Set("receivedMessages", Napi::Number::New(env, static_cast<double>(stats.received_messages)));
+        result.Set("parsedMessages", Napi::Number::New(env, static_cast<double>(stats.parsed_messages)));
+        result.Set("pressure", Napi::Number::New(env, stats.pressure));
+        result.Set("rttMs", Napi::Number::New(env, stats.rtt_ms));
+        result.Set("backlogMs", Napi::Number::New(env, stats.backlog_ms));
+        result.Set("budgetUtilization", Napi::Number::New(env, stats.budget_utilization));
+        result.Set("coalescedMessages", Napi::Number::New(env, static_cast<double>(stats.coalesced_messages)));
+        result.Set("droppedBytes", Napi::Number::New(env, static_cast<double>(stats.dropped_bytes)));
+        result.Set("queuedBytes", Napi::Number::New(env, static_cast<double>(stats.queued_bytes)));
+        result.Set("reconnects", Napi::Number::New(env, static_cast<double>(stats.reconnects)));
+        result.Set("replayedBytes", Napi::Number::New(env, static_cast<double>(stats.replayed_bytes)));
+        result.Set("historyBytes", Napi::Number::New(env, static_cast<double>(stats.history_bytes)));
+        return result;
+    }
+
+    std::shared_ptr<TranscriptionSocket> socket_;
+};
+
+} // namespace
+
+Napi::Function DefineTranscriptionSocket(Napi::Env env) {
+    Napi::Function constructor = TranscriptionSocketWrap::Define(env);
+    GetAddonInstance(env)->transcription_socket = Napi::Persistent(constructor);
+    return constructor;
+}
+
+std::shared_ptr<TranscriptionSocket> TranscriptionSocketFromValue(const Napi::Value& value) {
+    Napi::Env env = value.Env();
+    AddonInstance* instance = GetAddonInstance(env);
+    if (!value.IsObject() || !instance || instance->transcription_socket.IsEmpty() ||
+        !value.As<Napi::Object>().InstanceOf(instance->transcription_socket.Value())) {
+        return nullptr;
+    }
+    return TranscriptionSocketWrap::Unwrap(value.As<Napi::Object>())->Socket();
+}
+
+} // namespace kakarot
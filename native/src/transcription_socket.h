@@ -0,0 +1,231 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audio_transport.h"
+#include "transcript_frame.h"
+#include "websocket_connection.h"
+
+namespace kakarot {
+
+// new TranscriptionSocket(options)
+struct TranscriptionSocketConfig {
+    std::string url;
+    HttpHeaders headers;
+    int sample_rate = 16000;            // of the PCM16 audio; times audio positions
+    int channels = 1;                   // interleaved per frame (a ChannelInterleaver's 2)
+    size_t max_queued_bytes = 1 << 20;  // audio held while connecting or stalled; oldest dropped past it
+    std::string keep_alive_message;     // text frame sent after keep_alive_ms without a send
+    double keep_alive_ms = 0.0;         // 0 = none
+    std::string close_message;          // text frame that asks the server to finish (e.g. Terminate)
+    double close_timeout_ms = 3000.0;   // close() waits this long for the server to hang up
+
+    // Reconnects after a lost connection: up to |reconnect_attempts| in a
+    // row, |reconnect_delay_ms| doubling between them. Sent audio newer than
+    // the last acknowledge() is kept for |replay_ms| and sent again first.
+    int reconnect_attempts = 0;
+    double reconnect_delay_ms = 500.0;
+    double replay_ms = 0.0;
+    double replay_rate = 2.0;           // a backlog goes out at this multiple of real time; 0 = unpaced
+
+    // Result frames of this provider are parsed on the receive thread and
+    // arrive as 'transcript' events; kNone passes every frame as 'message'
+    TranscriptFormat parse = TranscriptFormat::kNone;
+
+    // Latency the transcript may run behind the audio: as the audio queued
+    // or the round trip from sending audio to its first result (a partial
+    // with parse, acknowledge() without) nears it, sends are coalesced and
+    // Pressure() rises, and it falls back as they recover; 0 = no adapting
+    double latency_budget_ms = 1500.0;
+};
+
+struct SocketEvent;
+
+// A streaming-transcription websocket owned by native code: audio goes from
+// a capture stream's consumer thread (the stream's transport option) or from
+// sendAudio() into a bounded queue, and an I/O thread of its own writes it
+// out, so the JS thread neither copies nor sends audio. JS receives only
+// events: { type: 'open', audioOffsetMs, replayedMs } per session,
+// { type: 'message', data } per text frame (or { type: 'transcript', ... }
+// per result frame with the parse option), { type: 'reconnecting', attempt,
+// message }, { type: 'error', message } and, last, { type: 'close', code,
+// reason }.
+//
+// Audio positions count PCM16 frames, one sample per channel, from the first
+// one queued. A session
+// starts at audioOffsetMs; the provider's times are relative to it, and the
+// session's timeline maps them back to when the audio was captured, across
+// gated silence and replays.
+class TranscriptionSocket : public AudioTransport {
+public:
+    enum class State { kIdle, kConnecting, kOpen, kClosing, kClosed };
+
+    explicit TranscriptionSocket(TranscriptionSocketConfig config);
+    ~TranscriptionSocket() override;
+
+    TranscriptionSocket(const TranscriptionSocket&) = delete;
+    TranscriptionSocket& operator=(const TranscriptionSocket&) = delete;
+
+    // JS thread. Connects on the I/O thread; false with |error| set when
+    // already used or the platform has no websocket backend.
+    bool Open(Napi::Env env, Napi::Function callback, std::string* error);
+
+    // Any thread. One binary message, queued until the socket is open;
+    // dropped once it is closing. |timestamp| is the Date.now() time of its
+    // first sample; 0 continues from the previous message.
+    void SendAudio(const int16_t* samples, size_t num_samples, double timestamp) override;
+    int Pressure() const override { return pressure_.load(std::memory_order_relaxed); }
+
+    // JS thread. The provider has final results up to |session_ms| into
+    // the current session; a replay after a reconnect starts there.
+    void Acknowledge(double session_ms);
+
+    // JS thread. Capture time (Date.now() domain) of |session_ms| into the
+    // current session; 0 before any audio was sent in it.
+    double CaptureTime(double session_ms) const;
+
+    // One instant of the current session on each of its axes
+    struct TimelinePosition {
+        double session_ms;       // provider time
+        uint64_t stream_sample;  // audio position, from the first frame queued
+        double capture_time;     // Date.now() time it was captured
+    };
+
+    // JS thread. The session's timeline is piecewise linear, a segment per
+    // run of audio sent without a jump (gated silence, audio dropped from a
+    // full queue); these find a position from any of its axes by binary
+    // search. A stream sample or capture time inside a jump lands where the
+    // audio resumed, one past the newest audio extrapolates; false before
+    // the segment the value would be in (or before any audio in the session).
+    bool AtSessionTime(double session_ms, TimelinePosition* position) const;
+    bool AtStreamSample(uint64_t stream_sample, TimelinePosition* position) const;
+    bool AtCaptureTime(double capture_time, TimelinePosition* position) const;
+
+    // JS thread. A text frame, e.g. a provider's configuration message
+    void SendText(std::string text);
+
+    // JS thread. Sends what is queued, then close_message, and waits up to
+    // close_timeout_ms for the server to hang up before sending |code|
+    void Close(uint16_t code);
+
+    struct Stats {
+        State state;
+        uint64_t sent_bytes;
+        uint64_t sent_messages;
+        uint64_t received_messages;
+        uint64_t parsed_messages;  // of those, delivered as transcripts
+        uint64_t dropped_bytes;
+        size_t queued_bytes;
+        uint64_t reconnects;
+        uint64_t replayed_bytes;
+        size_t history_bytes;
+        int pressure;
+        double rtt_ms;              // smoothed round trip to a first result
+        double backlog_ms;          // audio queued
+        double budget_utilization;  // the larger of the two over latency_budget_ms
+        uint64_t coalesced_messages;  // audio messages sent as part of another
+    };
+    Stats GetStats() const;
+
+private:
+    struct Message {
+        std::vector<uint8_t> bytes;
+        bool text;
+        uint64_t start_sample = 0;  // audio only: stream position of its first sample
+        double timestamp = 0.0;     // and its capture time
+    };
+
+    // Where a session's audio jumps in capture time (gated silence)
+    struct TimelinePoint {
+        uint64_t session_sample;
+        uint64_t stream_sample;  // differs after audio dropped from a full queue
+        double timestamp;
+    };
+
+    // Audio of the session sent and not yet answered by a result
+    struct Unanswered {
+        uint64_t session_begin;
+        std::chrono::steady_clock::time_point sent;
+    };
+
+    void Run();
+    void ReceiveLoop();
+    bool Stream(std::unique_lock<std::mutex>& lock, std::string* error);
+    bool CloseGracefully(std::unique_lock<std::mutex>& lock, std::string* error);
+    void Sent(Message message);
+    void TrimHistory();
+    void Coalesce(Message* message);
+    void Answered(uint64_t session_sample);
+    void UpdatePressure();
+    double BacklogMs() const;
+    uint64_t Requeue(uint64_t* replayed_samples);
+    size_t Samples(const Message& message) const {
+        return message.bytes.size() / (sizeof(int16_t) * config_.channels);
+    }
+    const TimelinePoint* PointAt(uint64_t session_sample) const;
+    TimelinePosition PositionAt(const TimelinePoint& point, uint64_t offset) const;
+    TimelinePosition Resumed(std::vector<TimelinePoint>::const_iterator point, uint64_t offset) const;
+    void Post(SocketEvent* event);
+
+    const TranscriptionSocketConfig config_;
+    std::unique_ptr<WebSocketConnection> connection_;
+    Napi::ThreadSafeFunction tsfn_;
+    std::thread io_thread_;
+    std::thread receive_thread_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Message> queue_;
+    State state_ = State::kIdle;
+    uint16_t close_code_ = 1000;
+    bool receive_done_ = false;
+    std::string receive_error_;
+    size_t queued_bytes_ = 0;
+    uint64_t sent_bytes_ = 0;
+    uint64_t sent_messages_ = 0;
+    uint64_t received_messages_ = 0;
+    uint64_t parsed_messages_ = 0;
+    uint64_t dropped_bytes_ = 0;
+    uint64_t reconnects_ = 0;
+    uint64_t replayed_bytes_ = 0;
+
+    // Audio positions. History is the sent audio a replay may need, oldest
+    // first, trimmed to replay_ms and to what was acknowledged.
+    uint64_t next_sample_ = 0;
+    double next_timestamp_ = 0.0;
+    uint64_t acked_sample_ = 0;
+    std::deque<Message> history_;
+    size_t history_bytes_ = 0;
+    uint64_t session_samples_ = 0;      // sent in this session
+    uint64_t session_next_sample_ = 0;  // stream position and capture time that would continue it
+    double session_next_time_ = 0.0;
+    std::vector<TimelinePoint> timeline_;
+
+    // Adapting to the uplink, with latency_budget_ms
+    std::deque<Unanswered> unanswered_;
+    double rtt_ms_ = 0.0;
+    std::chrono::steady_clock::time_point rtt_at_{};      // last measured
+    std::chrono::steady_clock::time_point calm_since_{};  // utilization last at or above the pressure's
+    double budget_utilization_ = 0.0;
+    uint64_t coalesced_messages_ = 0;
+    std::atomic<int> pressure_{0};
+};
+
+// The TranscriptionSocket class export; also remembered in the env's
+// AddonInstance, so a capture option can tell its objects apart
+Napi::Function DefineTranscriptionSocket(Napi::Env env);
+
+// The socket behind a TranscriptionSocket object; null for anything else
+std::shared_ptr<TranscriptionSocket> TranscriptionSocketFromValue(const Napi::Value& value);
+
+} // namespace kakarot
@@ -0,0 +1,178 @@
+#include "trigger_matcher.h"
+#include <deque>
+
+namespace kakarot {
+
+namespace {
+
+constexpr size_t kMaxPatternBytes = 200;
+
+uint8_t Fold(uint8_t byte) {
+    if (byte >= 'A' && byte <= 'Z') return static_cast<uint8_t>(byte | 0x20);
+    if (byte == '\t' || byte == '\n' || byte == '\r' || byte == '\f' || byte == '\v') return ' ';
+    return byte;
+}
+
+// UTF-8 lead and continuation bytes count as letters
+bool IsWord(uint8_t byte) {
+    return (byte >= 'a' && byte <= 'z') || (byte >= '0' && byte <= '9') || byte >= 0x80;
+}
+
+} // namespace
+
+bool TriggerMatcher::Compile(const std::vector<TriggerPattern>& patterns, std::string* error) {
+    std::vector<Compiled> compiled;
+    compiled.reserve(patterns.size());
+    for (const TriggerPattern& pattern : patterns) {
+        Compiled c;
+        for (char raw : pattern.text) {
+            uint8_t folded = Fold(static_cast<uint8_t>(raw));
+            if (folded == ' ' && (c.text.empty() || c.text.back() == ' ')) continue;
+            c.text.push_back(static_cast<char>(folded));
+        }
+        if (!c.text.empty() && c.text.back() == ' ') c.text.pop_back();
+        if (c.text.empty() || c.text.size() > kMaxPatternBytes) {
+            *error = "trigger must be 1 to 200 bytes: \"" + pattern.text + "\"";
+            return false;
+        }
+        c.anchor = pattern.anchor;
+        c.word_start = pattern.whole_word && IsWord(static_cast<uint8_t>(c.text.front()));
+        c.word_end = pattern.whole_word && IsWord(static_cast<uint8_t>(c.text.back()));
+        compiled.push_back(std::move(c));
+    }
+
+    // A class per byte the patterns use; the rest share class 0, which
+    // always leads back to the root
+    std::array<uint8_t, 256> classes{};
+    size_t class_count = 1;
+    for (const Compiled& c : compiled) {
+        for (char byte : c.text) {
+            uint8_t& cls = classes[static_cast<uint8_t>(byte)];
+            if (cls == 0) cls = static_cast<uint8_t>(class_count++);
+        }
+    }
+
+    // The trie, with -1 for no child
+    std::vector<int32_t> next(class_count, -1);
+    std::vector<std::vector<uint32_t>> outputs(1);
+    for (size_t p = 0; p < compiled.size(); ++p) {
+        int32_t state = 0;
+        for (char byte : compiled[p].text) {
+            size_t slot = static_cast<size_t>(state) * class_count + classes[static_cast<uint8_t>(byte)];
+            if (next[slot] < 0) {
+                next[slot] = static_cast<int32_t>(outputs.size());
+                outputs.emplace_back();
+                next.resize(next.size() + class_count, -1);
+            }
+            state = next[slot];
+        }
+        outputs[static_cast<size_t>(state)].push_back(static_cast<uint32_t>(p));
+    }
+
+    // Breadth first, a missing edge takes the failure state's edge, which
+    // turns the trie into the DFA
+    std::vector<int32_t> fail(outputs.size(), 0);
+    std::deque<int32_t> queue;
+    for (size_t c = 0; c < class_count; ++c) {
+        int32_t& edge = next[c];
+        if (edge < 0) {
+            edge = 0;
+        } else if (edge > 0) {
+            fail[static_cast<size_t>(edge)] = 0;
+            queue.push_back(edge);
+        }
+    }
+    while (!queue.empty()) {
+        const int32_t state = queue.front();
+        queue.pop_front();
+        const size_t from = static_cast<size_t>(fail[static_cast<size_t>(state)]);
+        const std::vector<uint32_t>& inherited = outputs[from];
+        outputs[static_cast<size_t>(state)].insert(outputs[static_cast<size_t>(state)].end(), inherited.begin(),
+                                                   inherited.end());
+        for (size_t c = 0; c < class_count; ++c) {
+            int32_t& edge = next[static_cast<size_t>(state) * class_count + c];
+            const int32_t fallback = next[from * class_count + c];
+            if (edge < 0) {
+                edge = fallback;
+            } else {
+                fail[static_cast<size_t>(edge)] = fallback;
+                queue.push_back(edge);
+            }
+        }
+    }
+
+    patterns_ = std::move(compiled);
+    classes_ = classes;
+    class_count_ = class_count;
+    next_ = std::move(next);
+    outputs_ = std::move(outputs);
+    return true;
+}
+
+void TriggerMatcher::Emit(const TriggerStream& stream, size_t pattern, uint64_t end,
+                          std::vector<TriggerMatch>* matches) const {
+    const uint64_t start = end - patterns_[pattern].text.size();
+    const uint64_t offset = stream.seen[start % stream.seen.size()].offset;
+    const uint64_t last = stream.seen[(end - 1) % stream.seen.size()].offset;
+    matches->push_back(TriggerMatch{pattern, offset, last + 1 - offset});
+}
+
+void TriggerMatcher::Step(TriggerStream* stream, uint8_t byte, uint64_t offset,
+                          std::vector<TriggerMatch>* matches) const {
+    const uint8_t folded = Fold(byte);
+    if (folded == ' ' && stream->space) {
+        return;  // leading, or more of the same run
+    }
+    const bool word = IsWord(folded);
+    for (const TriggerStream::Pending& pending : stream->awaiting_boundary) {
+        if (!word) Emit(*stream, pending.pattern, pending.end, matches);
+    }
+    stream->awaiting_boundary.clear();
+    if (folded != ' ') {
+        stream->at_end.clear();  // not at the end after all
+    }
+
+    stream->seen[stream->normalized % stream->seen.size()] = TriggerStream::Seen{offset, word};
+    ++stream->normalized;
+    stream->space = folded == ' ';
+    stream->state = next_[static_cast<size_t>(stream->state) * class_count_ + classes_[folded]];
+
+    for (uint32_t p : outputs_[static_cast<size_t>(stream->state)]) {
+        const Compiled& pattern = patterns_[p];
+        const uint64_t end = stream->normalized;
+        const uint64_t start = end - pattern.text.size();
+        if (pattern.anchor == TriggerAnchor::kStart && start != 0) continue;
+        if (pattern.word_start && start > 0 && stream->seen[(start - 1) % stream->seen.size()].word) continue;
+        if (pattern.anchor == TriggerAnchor::kEnd) {
+            stream->at_end.push_back(TriggerStream::Pending{p, end});
+        } else if (pattern.word_end) {
+            stream->awaiting_boundary.push_back(TriggerStream::Pending{p, end});
+        } else {
+            Emit(*stream, p, end, matches);
+        }
+    }
+}
+
+void TriggerMatcher::Feed(TriggerStream* stream, const char* text, size_t size,
+                          std::vector<TriggerMatch>* matches) const {
+    if (outputs_.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        Step(stream, static_cast<uint8_t>(text[i]), stream->fed + i, matches);
+    }
+    stream->fed += size;
+}
+
+void TriggerMatcher::End(TriggerStream* stream, std::vector<TriggerMatch>* matches) const {
+    for (const TriggerStream::Pending& pending : stream->awaiting_boundary) {
+        Emit(*stream, pending.pattern, pending.end, matches);
+    }
+    for (const TriggerStream::Pending& pending : stream->at_end) {
+        Emit(*stream, pending.pattern, pending.end, matches);
+    }
+    stream->awaiting_boundary.clear();
+    stream->at_end.clear();
+}
+
+} // namespace kakarot
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+enum class TriggerAnchor {
+    kAnywhere,
+    kStart,  // the utterance's first words
+    kEnd,    // its last characters, reported by End()
+};
+
+struct TriggerPattern {
+    std::string text;
+    TriggerAnchor anchor = TriggerAnchor::kAnywhere;
+    // Not inside a longer word at an edge that is a letter or digit
+    bool whole_word = true;
+};
+
+// Byte offsets into the text fed since the stream's last reset
+struct TriggerMatch {
+    size_t pattern = 0;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+// Where one transcript stream has got to; Reset() at each utterance
+struct TriggerStream {
+    void Reset() { *this = TriggerStream(); }
+
+private:
+    friend class TriggerMatcher;
+    struct Seen {
+        uint64_t offset = 0;  // of the byte, in the text as fed
+        bool word = false;
+    };
+    struct Pending {
+        size_t pattern = 0;
+        uint64_t end = 0;  // normalized
+    };
+
+    int32_t state = 0;
+    uint64_t fed = 0;            // bytes fed
+    uint64_t normalized = 0;     // bytes after whitespace runs became one space
+    bool space = true;           // the last normalized byte (or none) was a space
+    std::array<Seen, 256> seen;  // by normalized index, modulo its size
+    std::vector<Pending> awaiting_boundary;
+    std::vector<Pending> at_end;
+};
+
+// All triggers in one Aho-Corasick automaton compiled to a dense DFA over
+// the byte classes the patterns use, so feeding text costs one table step
+// per byte however many triggers there are. Matching is ASCII
+// case-insensitive, and a whitespace run in the text matches one space in
+// a pattern. Start and end anchors are checked against the stream's
+// position as matches come out. Compile once; streams are fed on any one
+// thread each.
+class TriggerMatcher {
+public:
+    // Patterns are 1 to 200 bytes once whitespace is collapsed
+    bool Compile(const std::vector<TriggerPattern>& patterns, std::string* error);
+    size_t Patterns() const { return patterns_.size(); }
+    size_t States() const { return outputs_.size(); }
+
+    // Appends each match that completed within |text|. A whole-word match
+    // ending the text waits for the next byte, or End().
+    void Feed(TriggerStream* stream, const char* text, size_t size, std::vector<TriggerMatch>* matches) const;
+    // The utterance is over: end-anchored matches and any still waiting
+    void End(TriggerStream* stream, std::vector<TriggerMatch>* matches) const;
+
+private:
+    void Step(TriggerStream* stream, uint8_t byte, uint64_t offset, std::vector<TriggerMatch>* matches) const;
+    void Emit(const TriggerStream& stream, size_t pattern, uint64_t end, std::vector<TriggerMatch>* matches) const;
+
+    struct Compiled {
+        std::string text;  // folded and collapsed
+        TriggerAnchor anchor = TriggerAnchor::kAnywhere;
+        bool word_start = false;  // a boundary is needed before it
+        bool word_end = false;    // and after it
+    };
+
+    std::vector<Compiled> patterns_;
+    std::array<uint8_t, 256> classes_{};  // folded byte -> class; 0 for bytes no pattern has
+    size_t class_count_ = 1;
+    std::vector<int32_t> next_;           // state * class_count_ + class
+    std::vector<std::vector<uint32_t>> outputs_;  // patterns ending at each state, via failure links too
+};
+
+} // namespace kakarot
@@ -0,0 +1,43 @@
+#include "voice_activity.h"
+#include "api/audio/audio_view.h"
+#include "modules/audio_processing/agc2/cpu_features.h"
+#include "modules/audio_processing/agc2/vad_wrapper.h"
+#include <algorithm>
+#include <cstring>
+
+namespace kakarot {
+
+VoiceActivityDetector::VoiceActivityDetector(int sample_rate)
+    : vad_(std::make_unique<webrtc::VoiceActivityDetectorWrapper>(
+          webrtc::GetAvailableCpuFeatures(), sample_rate)),
+      frame_size_(static_cast<size_t>(sample_rate / 100)),
+      frame_(frame_size_, 0.0f) {}
+
+VoiceActivityDetector::~VoiceActivityDetector() = default;
+
+size_t VoiceActivityDetector::Process(const float* data, size_t num_samples,
+                                      std::vector<float>* probabilities) {
+    size_t frames = 0;
+    size_t consumed = 0;
+    while (consumed < num_samples) {
+        size_t count = std::min(frame_size_ - fill_, num_samples - consumed);
+        std::memcpy(frame_.data() + fill_, data + consumed, count * sizeof(float));
+        fill_ += count;
+        consumed += count;
+
+        if (fill_ == frame_size_) {
+            probabilities->push_back(AnalyzeFrame(frame_.data()));
+            fill_ = 0;
+            ++frames;
+        }
+    }
+    return frames;
+}
+
+// The RNN VAD resamples to 24kHz itself and resets periodically
+float VoiceActivityDetector::AnalyzeFrame(const float* frame) {
+    last_probability_ = vad_->Analyze(webrtc::DeinterleavedView<const float>(frame, frame_size_, 1));
+    return last_probability_;
+}
+
+} // namespace kakarot
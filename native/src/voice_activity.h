@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace webrtc {
+class VoiceActivityDetectorWrapper;
+}
+
+namespace kakarot {
+
+// Per-10ms speech probability from WebRTC's RNN VAD (the one AGC2 uses).
+// Buffers arbitrary chunk sizes into 10ms frames; a partial frame carries
+// over to the next call. Not thread-safe: one instance per stream.
+class VoiceActivityDetector {
+public:
+    explicit VoiceActivityDetector(int sample_rate);
+    ~VoiceActivityDetector();
+
+    VoiceActivityDetector(const VoiceActivityDetector&) = delete;
+    VoiceActivityDetector& operator=(const VoiceActivityDetector&) = delete;
+
+    // Analyzes |num_samples| mono samples and appends one probability (0-1)
+    // per completed frame to |probabilities|. Returns the number appended.
+    size_t Process(const float* data, size_t num_samples, std::vector<float>* probabilities);
+
+    // Analyzes exactly one frame of FrameSize() samples, bypassing the buffering
+    float AnalyzeFrame(const float* frame);
+
+    // Frames |num_samples| can complete, counting the carried-over partial frame
+    size_t FramesFor(size_t num_samples) const { return (fill_ + num_samples) / frame_size_; }
+
+    size_t FrameSize() const { return frame_size_; }
+    float LastProbability() const { return last_probability_; }
+
+private:
+    std::unique_ptr<webrtc::VoiceActivityDetectorWrapper> vad_;
+    size_t frame_size_;
+    std::vector<float> frame_;
+    size_t fill_ = 0;
+    float last_probability_ = 0.0f;
+};
+
+} // namespace kakarot
@@ -0,0 +1,367 @@
+#include "voice_verifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace kakarot {
+
+// 2: cepstra of the stream's shared 20ms spectrum, not a 10ms FFT of its own
+static constexpr uint32_t kVoiceprintVersion = 1;
+
+// Mel filterbank over the voice band and the cepstra kept (c0, the level,
+// is dropped), as SpeakerTracker has them
+static constexpr int kMelBands = 24;
+static constexpr int kCepstra = 12;
+static constexpr float kBandHz[2] = {100.0f, 7600.0f};
+
+// A frame is speech when the VAD says so and it is louder than -60dBFS
+static constexpr float kSpeechProbability = 0.6f;
+static constexpr float kMinFramePower = 1e-6f;
+
+// An utterance is decided once it has this much speech (300ms), and
+// decided again every kRecheckFrames more; it ends after kUtteranceGapFrames
+// without speech
+static constexpr size_t kDecisionFrames = 30;
+static constexpr size_t kRecheckFrames = 50;
+static constexpr size_t kUtteranceGapFrames = 30;
+
+// Cepstral variance floor, and the voiceprint frames an utterance's
+// variances lean on, since 300ms of speech hardly has any
+static constexpr double kMinVariance = 0.01;
+static constexpr double kPriorFrames = 100.0;
+
+// The threshold: this many deviations over the enrollment blocks' mean
+// divergence, and never under kMinThreshold
+static constexpr double kThresholdDeviations = 3.0;
+static constexpr double kMinThreshold = 0.2;
+
+// Enrollment keeps at most this many blocks (two minutes of speech)
+static constexpr size_t kMaxEnrollmentBlocks = 400;
+
+template <typename T>
+static void Append(std::vector<uint8_t>* out, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out->insert(out->end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static bool Take(const uint8_t** data, const uint8_t* end, T* value) {
+    if (static_cast<size_t>(end - *data) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(value, *data, sizeof(T));
+    *data += sizeof(T);
+    return true;
+}
+
+std::vector<uint8_t> Voiceprint::Serialize() const {
+    std::vector<uint8_t> out = {'K', 'K', 'V', 'P'};
+    Append(&out, kVoiceprintVersion);
+    Append(&out, static_cast<uint32_t>(mean.size()));
+    Append(&out, frames);
+    for (size_t c = 0; c < mean.size(); ++c) {
+        Append(&out, mean[c]);
+        Append(&out, variance[c]);
+    }
+    Append(&out, threshold);
+    Append(&out, band_top_hz);
+    return out;
+}
+
+bool Voiceprint::Parse(const uint8_t* data, size_t size, Voiceprint* voiceprint, std::string* error) {
+    const uint8_t* end = data + size;
+    uint32_t version = 0;
+    uint32_t coefficients = 0;
+    if (size < 4 || std::memcmp(data, "KKVP", 4) != 0) {
+        *error = "not a voiceprint";
+        return false;
+    }
+    data += 4;
+    if (!Take(&data, end, &version) || version != kVoiceprintVersion || !Take(&data, end, &coefficients) ||
+        coefficients != static_cast<uint32_t>(kCepstra) || !Take(&data, end, &voiceprint->frames)) {
+        *error = "not a version 1 voiceprint";
+        return false;
+    }
+    voiceprint->mean.assign(coefficients, 0.0);
+    voiceprint->variance.assign(coefficients, 0.0);
+    for (uint32_t c = 0; c < coefficients; ++c) {
+        if (!Take(&data, end, &voiceprint->mean[c]) || !Take(&data, end, &voiceprint->variance[c])) {
+            *error = "voiceprint is truncated";
+            return false;
+        }
+        voiceprint->variance[c] = std::max(kMinVariance, voiceprint->variance[c]);
+    }
+    if (!Take(&data, end, &voiceprint->threshold) || !Take(&data, end, &voiceprint->band_top_hz) ||
+        !(voiceprint->threshold > 0.0f)) {
+        *error = "voiceprint is truncated";
+        return false;
+    }
+    return true;
+}
+
+bool VoiceVerifier::Supports(int sample_rate) {
+    return SpectralAnalyzer::Supports(sample_rate);
+}
+
+VoiceVerifier::VoiceVerifier(int sample_rate)
+    : frame_size_(static_cast<size_t>(sample_rate / 100)),
+      band_top_hz_(static_cast<uint32_t>(std::min<double>(kBandHz[1], 0.5 * sample_rate))),
+      band_energies_(kMelBands),
+      cepstrum_(kCepstra, 0.0) {
+    const double pi = std::acos(-1.0);
+    dct_.resize(static_cast<size_t>(kCepstra) * kMelBands);
+    for (int c = 0; c < kCepstra; ++c) {
+        for (int b = 0; b < kMelBands; ++b) {
+            dct_[c * kMelBands + b] = static_cast<float>(
+                std::sqrt(2.0 / kMelBands) * std::cos(pi * (c + 1) * (b + 0.5) / kMelBands));
+        }
+    }
+    utterance_.Clear();
+    enrollment_block_.Clear();
+}
+
+VoiceVerifier::~VoiceVerifier() = default;
+
+void VoiceVerifier::Gaussian::Clear() {
+    weight = 0.0;
+    sum.assign(kCepstra, 0.0);
+    sum_squares.assign(kCepstra, 0.0);
+}
+
+void VoiceVerifier::Gaussian::Add(const Gaussian& other) {
+    weight += other.weight;
+    for (int c = 0; c < kCepstra; ++c) {
+        sum[c] += other.sum[c];
+        sum_squares[c] += other.sum_squares[c];
+    }
+}
+
+bool VoiceVerifier::SetVoiceprint(std::shared_ptr<const Voiceprint> voiceprint, std::string* error) {
+    if (voiceprint && voiceprint->band_top_hz != band_top_hz_) {
+        *error = "voiceprint was enrolled over a " + std::to_string(voiceprint->band_top_hz) +
+                 " Hz band, not this stream's " + std::to_string(band_top_hz_) + " Hz";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ = std::move(voiceprint);
+    stats_.enrolled = pending_ != nullptr;
+    stats_.threshold = pending_ ? pending_->threshold : 0.0f;
+    voiceprint_changed_.store(true, std::memory_order_release);
+    return true;
+}
+
+void VoiceVerifier::StartEnrollment() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enrollment_.clear();
+    enrollment_block_.Clear();
+    stats_.enrolling = true;
+    stats_.enrollment_seconds = 0.0f;
+    enrolling_.store(true, std::memory_order_release);
+}
+
+void VoiceVerifier::CancelEnrollment() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enrolling_.store(false, std::memory_order_release);
+    enrollment_.clear();
+    enrollment_block_.Clear();
+    stats_.enrolling = false;
+}
+
+bool VoiceVerifier::FinishEnrollment(Voiceprint* voiceprint, std::string* error) {
+    std::vector<Gaussian> blocks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!enrolling_.load(std::memory_order_acquire)) {
+            *error = "No enrollment in progress";
+            return false;
+        }
+        if (stats_.enrollment_seconds < kMinEnrollmentSeconds) {
+            *error = "Enrollment has " + std::to_string(static_cast<int>(stats_.enrollment_seconds)) + " s of " +
+                     std::to_string(static_cast<int>(kMinEnrollmentSeconds)) + " s of speech needed";
+            return false;
+        }
+        blocks.swap(enrollment_);
+        enrollment_block_.Clear();
+        enrolling_.store(false, std::memory_order_release);
+        stats_.enrolling = false;
+    }
+
+    Gaussian total;
+    total.Clear();
+    for (const Gaussian& block : blocks) {
+        total.Add(block);
+    }
+    Voiceprint result;
+    result.frames = total.weight;
+    result.band_top_hz = band_top_hz_;
+    result.mean.resize(kCepstra);
+    result.variance.resize(kCepstra);
+    for (int c = 0; c < kCepstra; ++c) {
+        result.mean[c] = total.sum[c] / total.weight;
+        result.variance[c] =
+            std::max(kMinVariance, total.sum_squares[c] / total.weight - result.mean[c] * result.mean[c]);
+    }
+
+    // The user's own blocks against the whole: how far an utterance of
+    // theirs strays
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    for (const Gaussian& block : blocks) {
+        const double divergence = Divergence(block, result);
+        sum += divergence;
+        sum_squares += divergence * divergence;
+    }
+    const double mean = sum / blocks.size();
+    const double deviation = std::sqrt(std::max(0.0, sum_squares / blocks.size() - mean * mean));
+    result.threshold = static_cast<float>(std::max(kMinThreshold, mean + kThresholdDeviations * deviation));
+
+    *voiceprint = result;
+    return SetVoiceprint(std::make_shared<const Voiceprint>(std::move(result)), error);
+}
+
+VoiceVerifierStats VoiceVerifier::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// Mean KL divergence per coefficient of |utterance| from the voiceprint,
+// the utterance's variances regularized toward the voiceprint's
+double VoiceVerifier::Divergence(const Gaussian& utterance, const Voiceprint& voiceprint) {
+    double total = 0.0;
+    for (int c = 0; c < kCepstra; ++c) {
+        const double mean = utterance.sum[c] / utterance.weight;
+        const double raw = std::max(kMinVariance, utterance.sum_squares[c] / utterance.weight - mean * mean);
+        const double variance =
+            (utterance.weight * raw + kPriorFrames * voiceprint.variance[c]) / (utterance.weight + kPriorFrames);
+        const double d = mean - voiceprint.mean[c];
+        const double v = voiceprint.variance[c];
+        total += 0.5 * (variance / v - 1.0 + d * d / v + std::log(v / variance));
+    }
+    return total / kCepstra;
+}
+
+void VoiceVerifier::Cepstrum(const float* power, double* cepstrum) {
+    for (int b = 0; b < kMelBands; ++b) {
+        band_energies_[b] = std::log(mel_.Energy(static_cast<size_t>(b), power) + 1e-10f);
+    }
+    for (int c = 0; c < kCepstra; ++c) {
+        const float* basis = dct_.data() + c * kMelBands;
+        double value = 0.0;
+        for (int b = 0; b < kMelBands; ++b) {
+            value += basis[b] * band_energies_[b];
+        }
+        cepstrum[c] = value;
+    }
+}
+
+// The utterance so far against the voiceprint; a verdict that changes as
+// it grows moves its count
+void VoiceVerifier::OnSpectrum(const SpectralAnalyzer& analyzer) {
+    if (weights_for_ != &analyzer || mel_.Bins() != analyzer.Bins()) {
+        mel_.Build(analyzer.SampleRate(), analyzer.Bins(), kMelBands, SpectrumScale::kMel, kBandHz[0],
+                   band_top_hz_);
+        weights_for_ = &analyzer;
+    }
+    Cepstrum(analyzer.PowerSpectrum(), cepstrum_.data());
+    cepstrum_ready_ = true;
+}
+
+void VoiceVerifier::Decide() {
+    const double divergence = Divergence(utterance_, *active_);
+    const bool user = divergence <= active_->threshold;
+    verdict_ = user ? Verdict::kUser : Verdict::kOther;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.last_score = static_cast<float>(divergence);
+    if (!counted_) {
+        ++stats_.utterances;
+        ++(user ? stats_.accepted : stats_.rejected);
+        counted_ = true;
+    } else if (user != accepted_) {
+        --(accepted_ ? stats_.accepted : stats_.rejected);
+        ++(user ? stats_.accepted : stats_.rejected);
+    }
+    accepted_ = user;
+}
+
+bool VoiceVerifier::ProcessFrame(const float* frame, float speech_probability) {
+    if (voiceprint_changed_.exchange(false, std::memory_order_acq_rel)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_ = pending_;
+    }
+    const bool enrolling = enrolling_.load(std::memory_order_acquire);
+    if (!active_ && !enrolling) {
+        return true;
+    }
+
+    float power = 0.0f;
+    for (size_t i = 0; i < frame_size_; ++i) {
+        power += frame[i] * frame[i];
+    }
+    power /= static_cast<float>(frame_size_);
+    // Without this frame's spectrum there is no cepstrum to pool
+    const bool measured = cepstrum_ready_;
+    cepstrum_ready_ = false;
+    const bool speech = measured && speech_probability >= kSpeechProbability && power >= kMinFramePower;
+
+    if (!speech) {
+        if (++gap_frames_ >= kUtteranceGapFrames && utterance_.weight > 0.0) {
+            utterance_.Clear();
+            since_decision_ = 0;
+            verdict_ = Verdict::kUndecided;
+            counted_ = false;
+        }
+        return !active_ || verdict_ == Verdict::kUser;
+    }
+    gap_frames_ = 0;
+
+    const double* cepstrum = cepstrum_.data();
+    if (enrolling) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (enrolling_.load(std::memory_order_relaxed) && enrollment_.size() < kMaxEnrollmentBlocks) {
+            enrollment_block_.weight += 1.0;
+            for (int c = 0; c < kCepstra; ++c) {
+                enrollment_block_.sum[c] += cepstrum[c];
+                enrollment_block_.sum_squares[c] += cepstrum[c] * cepstrum[c];
+            }
+            if (enrollment_block_.weight >= kDecisionFrames) {
+                enrollment_.push_back(enrollment_block_);
+                enrollment_block_.Clear();
+            }
+            stats_.enrollment_seconds =
+                static_cast<float>((enrollment_.size() * kDecisionFrames + enrollment_block_.weight) / 100.0);
+        }
+    }
+    if (!active_) {
+        return true;
+    }
+
+    utterance_.weight += 1.0;
+    for (int c = 0; c < kCepstra; ++c) {
+        utterance_.sum[c] += cepstrum[c];
+        utterance_.sum_squares[c] += cepstrum[c] * cepstrum[c];
+    }
+    ++since_decision_;
+    if ((verdict_ == Verdict::kUndecided && utterance_.weight >= kDecisionFrames) ||
+        (verdict_ != Verdict::kUndecided && since_decision_ >= kRecheckFrames)) {
+        since_decision_ = 0;
+        Decide();
+    }
+    if (verdict_ == Verdict::kUser) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.frames_held;
+    return false;
+}
+
+void VoiceVerifier::Reset() {
+    cepstrum_ready_ = false;
+    utterance_.Clear();
+    gap_frames_ = 0;
+    since_decision_ = 0;
+    verdict_ = Verdict::kUndecided;
+    counted_ = false;
+    accepted_ = false;
+}
+
+} // namespace kakarot
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "spectral_analyzer.h"
+
+namespace kakarot {
+
+// The enrolled user's voice: a diagonal Gaussian over the mel cepstra of
+// their speech, and the divergence from it an utterance of theirs stays
+// under (the mean plus three deviations of their own enrollment's
+// utterance-length blocks, so the threshold fits the voice and the mic).
+//
+// Serialized as "KKVP", a little-endian uint32 version (1), uint32
+// coefficients, float64 frames, float64 mean and variance per coefficient,
+// float32 threshold and uint32 top band edge in Hz.
+struct Voiceprint {
+    double frames = 0.0;
+    std::vector<double> mean;
+    std::vector<double> variance;
+    float threshold = 0.0f;
+    uint32_t band_top_hz = 0;
+
+    std::vector<uint8_t> Serialize() const;
+    // False with |error| for bytes that are not a version 1 voiceprint
+    static bool Parse(const uint8_t* data, size_t size, Voiceprint* voiceprint, std::string* error);
+};
+
+struct VoiceVerifierStats {
+    bool enrolled = false;
+    bool enrolling = false;
+    float enrollment_seconds = 0.0f;  // speech so far
+    uint64_t utterances = 0;          // decided ones
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;
+    uint64_t frames_held = 0;         // speech frames turned to non-speech
+    float last_score = 0.0f;          // divergence of the last decision
+    float threshold = 0.0f;
+};
+
+// Speaker verification for the mic stream, without a model: the mel
+// cepstrum of each speech frame, taken from the stream's shared spectrum
+// (no FFT of its own), is pooled per utterance (speech until
+// kUtteranceGapFrames without it), and once the utterance has
+// kDecisionFrames of speech its divergence from the voiceprint says
+// whether it is the user's, rechecked as it grows. Until then and when it
+// is not, ProcessFrame() is false, and the stream hands the gate and the
+// endpointer non-speech: a bystander's words are never passed on, and the
+// user's own first frames come back with the gate's pre-roll.
+//
+// Enrollment pools the user's speech frames (those with the far end's echo
+// already turned to non-speech) into a voiceprint, which takes effect at
+// once. Without one every frame passes.
+//
+// Listening is the stream's: it feeds its SpectrumMeter each frame ahead
+// of ProcessFrame(), so OnSpectrum() has always seen the frame decided.
+class VoiceVerifier : public SpectrumListener {
+public:
+    // Speech a voiceprint needs, and the pre-roll a gate before the
+    // verifier needs to replay the frames its decision held
+    static constexpr double kMinEnrollmentSeconds = 15.0;
+    static constexpr double kPrerollMs = 500.0;
+
+    // 10ms frames at 8 to 48kHz
+    static bool Supports(int sample_rate);
+
+    explicit VoiceVerifier(int sample_rate);
+    ~VoiceVerifier() override;
+
+    VoiceVerifier(const VoiceVerifier&) = delete;
+    VoiceVerifier& operator=(const VoiceVerifier&) = delete;
+
+    // Any thread. Null passes every frame; false with |error| for a
+    // voiceprint taken over another band.
+    bool SetVoiceprint(std::shared_ptr<const Voiceprint> voiceprint, std::string* error);
+    void StartEnrollment();
+    // The voiceprint of the speech since StartEnrollment(), now in effect;
+    // false with |error| before kMinEnrollmentSeconds of it
+    bool FinishEnrollment(Voiceprint* voiceprint, std::string* error);
+    void CancelEnrollment();
+    VoiceVerifierStats GetStats() const;
+
+    // Consumer thread. The frame's spectrum, then the frame itself, of
+    // FrameSize() samples, and its speech probability: false when its
+    // speech is not (yet) the user's.
+    void OnSpectrum(const SpectralAnalyzer& analyzer) override;
+    bool ProcessFrame(const float* frame, float speech_probability);
+
+    void Reset();
+
+    size_t FrameSize() const { return frame_size_; }
+
+private:
+    struct Gaussian {
+        double weight = 0.0;
+        std::vector<double> sum;
+        std::vector<double> sum_squares;
+
+        void Clear();
+        void Add(const Gaussian& other);
+    };
+    enum class Verdict { kUndecided, kUser, kOther };
+
+    void Cepstrum(const float* power, double* cepstrum);
+    static double Divergence(const Gaussian& utterance, const Voiceprint& voiceprint);
+    void Decide();
+
+    const size_t frame_size_;
+    const uint32_t band_top_hz_;
+    std::vector<float> dct_;  // cepstra x bands, c1 up
+    std::vector<float> band_energies_;
+
+    // Consumer thread: the mel triangles over the analyzer's bins, rebuilt
+    // when another analyzer shows up, and the last frame's cepstrum
+    const SpectralAnalyzer* weights_for_ = nullptr;
+    Filterbank mel_;
+    std::vector<double> cepstrum_;
+    bool cepstrum_ready_ = false;
+    std::shared_ptr<const Voiceprint> active_;
+    Gaussian utterance_;
+    size_t gap_frames_ = 0;
+    size_t since_decision_ = 0;
+    Verdict verdict_ = Verdict::kUndecided;
+    bool counted_ = false;  // this utterance's verdict is in the stats
+    bool accepted_ = false;
+
+    // Shared with the JS thread
+    std::atomic<bool> voiceprint_changed_{false};
+    std::atomic<bool> enrolling_{false};
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Voiceprint> pending_;
+    std::vector<Gaussian> enrollment_;  // blocks of kDecisionFrames
+    Gaussian enrollment_block_;
+    VoiceVerifierStats stats_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,44 @@
+#include "wakeup_stats.h"
+#include <chrono>
+#include <mutex>
+
+namespace kakarot {
+
+namespace {
+
+// Constant-initialized, so counters constructed at load in any order find
+// them ready
+std::mutex g_mutex;
+WakeupCounter* g_counters = nullptr;
+std::chrono::steady_clock::time_point g_reported;
+
+} // namespace
+
+WakeupCounter::WakeupCounter(const char* name) : name_(name) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_counters) {
+        g_reported = std::chrono::steady_clock::now();
+    }
+    next_ = g_counters;
+    g_counters = this;
+}
+
+std::vector<WakeupStat> GetWakeupStats() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    const auto now = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(now - g_reported).count();
+    g_reported = now;
+
+    std::vector<WakeupStat> stats;
+    for (WakeupCounter* counter = g_counters; counter; counter = counter->next_) {
+        WakeupStat stat;
+        stat.name = counter->name_;
+        stat.wakeups = counter->count_.load(std::memory_order_relaxed);
+        stat.per_second = seconds > 0 ? static_cast<double>(stat.wakeups - counter->reported_) / seconds : 0;
+        counter->reported_ = stat.wakeups;
+        stats.push_back(stat);
+    }
+    return stats;
+}
+
+} // namespace kakarot
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace kakarot {
+
+struct WakeupStat {
+    const char* name = nullptr;
+    uint64_t wakeups = 0;    // since load
+    double per_second = 0;   // since the previous GetWakeupStats()
+};
+
+// How often one kind of native thread returns from its wait, signalled or
+// timed out; every thread of the kind counts into the one counter. Defined
+// at namespace scope only: each links itself into the process-wide list as
+// it is constructed at load and lives as long as the process. An idle addon
+// - stopped, or paused with no device IO - should read 0/s everywhere.
+class WakeupCounter {
+public:
+    explicit WakeupCounter(const char* name);
+
+    WakeupCounter(const WakeupCounter&) = delete;
+    WakeupCounter& operator=(const WakeupCounter&) = delete;
+
+    // The waiting thread, once per return from its wait
+    void Count() { count_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    friend std::vector<WakeupStat> GetWakeupStats();
+
+    const char* name_;
+    std::atomic<uint64_t> count_{0};
+    WakeupCounter* next_ = nullptr;
+    uint64_t reported_ = 0;  // at the previous GetWakeupStats()
+};
+
+// Every counter, in no particular order. The rates are over the time since
+// the previous call (since load on the first), so one poller should own it.
+std::vector<WakeupStat> GetWakeupStats();
+
+} // namespace kakarot
@@ -0,0 +1,526 @@
+#include "wasapi_capture.h"
+#include "host_time.h"
+#include "native_log.h"
+#include "thread_cpu.h"
+#include <avrt.h>
+#include <functiondiscoverykeys_devpkey.h>
+#include <ksmedia.h>
+#include <mmreg.h>
+#include <cstdio>
+
+namespace kakarot {
+
+static const char* const kLogSource = "WasapiCapture";
+
+// Shared-mode buffer (100ns units); the engine still signals once per period
+static constexpr REFERENCE_TIME kBufferDuration = 200000;
+
+// Matches the IOProc sanity limit
+static constexpr UINT32 kMaxFramesPerPacket = 48000;
+
+// Loopback of an idle endpoint signals nothing; drain on this timeout anyway
+static constexpr DWORD kEventTimeoutMs = 500;
+
+// Retry interval while the default endpoint is missing
+static constexpr DWORD kReopenIntervalMs = 200;
+
+template <typename T>
+static void SafeRelease(T** object) {
+    if (*object) {
+        (*object)->Release();
+        *object = nullptr;
+    }
+}
+
+// Per-thread COM, multithreaded apartment. A thread that already chose STA
+// (the Electron main thread) keeps it; COM is usable either way.
+class ComScope {
+public:
+    ComScope() : hr_(CoInitializeEx(nullptr, COINIT_MULTITHREADED)) {}
+    ~ComScope() {
+        if (SUCCEEDED(hr_)) {
+            CoUninitialize();
+        }
+    }
+
+private:
+    HRESULT hr_;
+};
+
+static std::string Utf8(const wchar_t* text) {
+    if (!text) {
+        return std::string();
+    }
+    int size = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    if (size <= 1) {
+        return std::string();
+    }
+    std::string result(size - 1, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, -1, &result[0], size, nullptr, nullptr);
+    return result;
+}
+
+static std::wstring Wide(const std::string& text) {
+    int size = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, nullptr, 0);
+    if (size <= 1) {
+        return std::wstring();
+    }
+    std::wstring result(size - 1, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, &result[0], size);
+    return result;
+}
+
+static std::string Failure(const char* step, HRESULT hr) {
+    char text[128];
+    std::snprintf(text, sizeof(text), "%s failed (0x%08lx)", step, static_cast<unsigned long>(hr));
+    return text;
+}
+
+// AUDIO_EFFECT_TYPE_ACOUSTIC_ECHO_CANCELLATION (ksmedia.h), here so no
+// GUID library has to be linked
+static const GUID kEchoCancellationEffect = {
+    0x6f64adbe, 0x8211, 0x11e2, { 0x8c, 0x70, 0x2c, 0x27, 0xd7, 0xf0, 0x01, 0xfa } };
+
+// What the sink takes; the engine converts from the mix format
+static WAVEFORMATEXTENSIBLE MonoFloatFormat(DWORD sample_rate) {
+    WAVEFORMATEXTENSIBLE format = {};
+    format.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    format.Format.nChannels = 1;
+    format.Format.nSamplesPerSec = sample_rate;
+    format.Format.wBitsPerSample = 32;
+    format.Format.nBlockAlign = sizeof(float);
+    format.Format.nAvgBytesPerSec = sample_rate * sizeof(float);
+    format.Format.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+    format.Samples.wValidBitsPerSample = 32;
+    format.dwChannelMask = SPEAKER_FRONT_CENTER;
+    format.SubFormat = KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+    return format;
+}
+
+// Before Initialize(): the communications category, where the endpoint
+// runs its voice processing
+static HRESULT SetCommunicationsCategory(IAudioClient* client) {
+    IAudioClient2* client2 = nullptr;
+    HRESULT hr = client->QueryInterface(__uuidof(IAudioClient2), reinterpret_cast<void**>(&client2));
+    if (FAILED(hr)) {
+        return hr;
+    }
+    AudioClientProperties properties = {};
+    properties.cbSize = sizeof(properties);
+    properties.bIsOffload = FALSE;
+    properties.eCategory = AudioCategory_Communications;
+    properties.Options = AUDCLNT_STREAMOPTIONS_NONE;
+    hr = client2->SetClientProperties(&properties);
+    SafeRelease(&client2);
+    return hr;
+}
+
+// After Initialize(). SDKs before the effects manager build to
+// kUnavailable, as does Windows before 11 22H2 at run time.
+static SystemEchoCancellation QueryEchoCancellation(IAudioClient* client) {
+    SystemEchoCancellation state = SystemEchoCancellation::kUnavailable;
+#if defined(__IAudioEffectsManager_INTERFACE_DEFINED__)
+    IAudioEffectsManager* effects = nullptr;
+    if (FAILED(client->GetService(__uuidof(IAudioEffectsManager), reinterpret_cast<void**>(&effects)))) {
+        return state;
+    }
+    AUDIO_EFFECT* list = nullptr;
+    UINT32 count = 0;
+    if (SUCCEEDED(effects->GetAudioEffects(&list, &count))) {
+        for (UINT32 i = 0; i < count; ++i) {
+            if (!IsEqualGUID(list[i].id, kEchoCancellationEffect)) {
+                continue;
+            }
+            state = list[i].state == AUDIO_EFFECT_STATE_ON ? SystemEchoCancellation::kOn : SystemEchoCancellation::kOff;
+            if (state == SystemEchoCancellation::kOff && list[i].canSetState &&
+                SUCCEEDED(effects->SetAudioEffectState(list[i].id, AUDIO_EFFECT_STATE_ON))) {
+                state = SystemEchoCancellation::kOn;
+            }
+            break;
+        }
+        CoTaskMemFree(list);
+    }
+    SafeRelease(&effects);
+#else
+    (void)client;
+#endif
+    return state;
+}
+
+static const char* EchoCancellationName(SystemEchoCancellation state) {
+    return state == SystemEchoCancellation::kOn ? "on"
+        : state == SystemEchoCancellation::kOff ? "off" : "unavailable";
+}
+
+static const char* SourceName(CaptureSource source) {
+    return source == CaptureSource::kLoopback ? "Loopback" : "Microphone";
+}
+
+static std::string DeviceIdOf(IMMDevice* device) {
+    LPWSTR id = nullptr;
+    if (FAILED(device->GetId(&id))) {
+        return std::string();
+    }
+    std::string result = Utf8(id);
+    CoTaskMemFree(id);
+    return result;
+}
+
+static std::string FriendlyNameOf(IMMDevice* device) {
+    IPropertyStore* properties = nullptr;
+    if (FAILED(device->OpenPropertyStore(STGM_READ, &properties))) {
+        return std::string();
+    }
+    std::string name;
+    PROPVARIANT value;
+    PropVariantInit(&value);
+    if (SUCCEEDED(properties->GetValue(PKEY_Device_FriendlyName, &value)) && value.vt == VT_LPWSTR) {
+        name = Utf8(value.pwszVal);
+    }
+    PropVariantClear(&value);
+    SafeRelease(&properties);
+    return name;
+}
+
+WasapiCapture::WasapiCapture(CaptureSource source, RealtimeSink sink, void* sink_context)
+    : source_(source),
+      sink_(sink),
+      sink_context_(sink_context),
+      sample_event_(CreateEventW(nullptr, FALSE, FALSE, nullptr)),
+      stop_event_(CreateEventW(nullptr, TRUE, FALSE, nullptr)),
+      silence_(kMaxFramesPerPacket, 0.0f) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    qpc_frequency_ = frequency.QuadPart;
+}
+
+WasapiCapture::~WasapiCapture() {
+    Stop();
+    CloseHandle(sample_event_);
+    CloseHandle(stop_event_);
+}
+
+std::vector<InputDeviceInfo> WasapiCapture::ListInputDevices() {
+    ComScope com;
+    std::vector<InputDeviceInfo> devices;
+
+    IMMDeviceEnumerator* enumerator = nullptr;
+    if (FAILED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator),
+                                reinterpret_cast<void**>(&enumerator)))) {
+        return devices;
+    }
+
+    std::string default_id;
+    IMMDevice* device = nullptr;
+    if (SUCCEEDED(enumerator->GetDefaultAudioEndpoint(eCapture, eConsole, &device))) {
+        default_id = DeviceIdOf(device);
+        SafeRelease(&device);
+    }
+
+    IMMDeviceCollection* collection = nullptr;
+    if (SUCCEEDED(enumerator->EnumAudioEndpoints(eCapture, DEVICE_STATE_ACTIVE, &collection))) {
+        UINT count = 0;
+        collection->GetCount(&count);
+        for (UINT i = 0; i < count; ++i) {
+            if (FAILED(collection->Item(i, &device))) {
+                continue;
+            }
+            InputDeviceInfo info;
+            info.id = DeviceIdOf(device);
+            info.name = FriendlyNameOf(device);
+            info.is_default = !info.id.empty() && info.id == default_id;
+            devices.push_back(info);
+            SafeRelease(&device);
+        }
+        SafeRelease(&collection);
+    }
+    SafeRelease(&enumerator);
+    return devices;
+}
+
+SystemEchoCancellation WasapiCapture::ProbeEchoCancellation(const std::string& device_id) {
+    ComScope com;
+    SystemEchoCancellation state = SystemEchoCancellation::kUnavailable;
+
+    IMMDeviceEnumerator* enumerator = nullptr;
+    if (FAILED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator),
+                                reinterpret_cast<void**>(&enumerator)))) {
+        return state;
+    }
+    IMMDevice* device = nullptr;
+    HRESULT hr = device_id.empty() ? enumerator->GetDefaultAudioEndpoint(eCapture, eCommunications, &device)
+                                   : enumerator->GetDevice(Wide(device_id).c_str(), &device);
+    IAudioClient* client = nullptr;
+    if (SUCCEEDED(hr)) {
+        hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, reinterpret_cast<void**>(&client));
+    }
+    if (SUCCEEDED(hr)) {
+        hr = SetCommunicationsCategory(client);
+    }
+    if (SUCCEEDED(hr)) {
+        WAVEFORMATEXTENSIBLE format = MonoFloatFormat(static_cast<DWORD>(kSampleRate));
+        hr = client->Initialize(AUDCLNT_SHAREMODE_SHARED,
+                                AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM | AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY,
+                                kBufferDuration, 0, &format.Format, nullptr);
+    }
+    if (SUCCEEDED(hr)) {
+        state = QueryEchoCancellation(client);
+    }
+    SafeRelease(&client);
+    SafeRelease(&device);
+    SafeRelease(&enumerator);
+    return state;
+}
+
+bool WasapiCapture::Start(const std::string& device_id, std::string* error) {
+    if (thread_.joinable()) {
+        *error = "WASAPI capture already started";
+        return false;
+    }
+    requested_id_ = source_ == CaptureSource::kMicrophone ? device_id : std::string();
+    ResetEvent(stop_event_);
+    {
+        std::lock_guard<std::mutex> lock(start_mutex_);
+        start_done_ = false;
+        start_error_.clear();
+    }
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&WasapiCapture::ThreadMain, this);
+
+    std::unique_lock<std::mutex> lock(start_mutex_);
+    start_cv_.wait(lock, [this] { return start_done_; });
+    if (start_error_.empty()) {
+        return true;
+    }
+    *error = start_error_;
+    lock.unlock();
+    thread_.join();
+    return false;
+}
+
+void WasapiCapture::Stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    SetEvent(stop_event_);
+    thread_.join();
+}
+
+std::string WasapiCapture::DeviceId() const {
+    std::lock_guard<std::mutex> lock(device_mutex_);
+    return device_id_;
+}
+
+void WasapiCapture::ThreadMain() {
+    ScopedThreadCpu thread_cpu("wasapiCapture");
+    ComScope com;
+
+    std::string error;
+    bool opened = Open(&error);
+    {
+        std::lock_guard<std::mutex> lock(start_mutex_);
+        start_done_ = true;
+        start_error_ = opened ? std::string() : error;
+    }
+    start_cv_.notify_one();
+    if (!opened) {
+        SafeRelease(&enumerator_);
+        running_.store(false, std::memory_order_release);
+        return;
+    }
+
+    // Same scheduling class as the HAL IO threads get on macOS
+    DWORD task_index = 0;
+    HANDLE mmcss = AvSetMmThreadCharacteristicsW(L"Pro Audio", &task_index);
+    if (!mmcss) {
+        Log(LogLevel::kWarn, kLogSource, "MMCSS registration failed (%lu); capturing at normal priority",
+            static_cast<unsigned long>(GetLastError()));
+    }
+
+    HANDLE events[] = { stop_event_, sample_event_ };
+    while (WaitForMultipleObjects(2, events, FALSE, client_ ? kEventTimeoutMs : kReopenIntervalMs) != WAIT_OBJECT_0) {
+        if (!client_) {
+            std::string reopen_error;
+            if (Open(&reopen_error)) {
+                Log(LogLevel::kInfo, kLogSource, "%s capture moved to the new default endpoint", SourceName(source_));
+            }
+            continue;
+        }
+
+        HRESULT hr = Pump();
+        if (hr == AUDCLNT_E_DEVICE_INVALIDATED || hr == AUDCLNT_E_RESOURCES_INVALIDATED) {
+            Close();
+            if (!requested_id_.empty()) {
+                Log(LogLevel::kError, kLogSource, "%s endpoint removed; capture stopped", SourceName(source_));
+                break;
+            }
+            Log(LogLevel::kWarn, kLogSource, "%s endpoint invalidated; waiting for the new default", SourceName(source_));
+        } else if (FAILED(hr)) {
+            Log(LogLevel::kError, kLogSource, "%s: %s", SourceName(source_), Failure("Capture", hr).c_str());
+            break;
+        }
+    }
+
+    Close();
+    SafeRelease(&enumerator_);
+    if (mmcss) {
+        AvRevertMmThreadCharacteristics(mmcss);
+    }
+    running_.store(false, std::memory_order_release);
+}
+
+// Capture thread. On failure everything it created is released and |error|
+// says which step failed.
+bool WasapiCapture::Open(std::string* error) {
+    HRESULT hr = S_OK;
+    if (!enumerator_) {
+        hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator),
+                              reinterpret_cast<void**>(&enumerator_));
+        if (FAILED(hr)) {
+            *error = Failure("Creating the device enumerator", hr);
+            return false;
+        }
+    }
+
+    IMMDevice* device = nullptr;
+    if (requested_id_.empty()) {
+        hr = enumerator_->GetDefaultAudioEndpoint(source_ == CaptureSource::kLoopback ? eRender : eCapture,
+                                                  communications_ ? eCommunications : eConsole, &device);
+    } else {
+        hr = enumerator_->GetDevice(Wide(requested_id_).c_str(), &device);
+    }
+    if (FAILED(hr)) {
+        *error = Failure(requested_id_.empty() ? "Finding the default endpoint" : "Opening the input device", hr);
+        return false;
+    }
+    std::string id = DeviceIdOf(device);
+    std::string name = FriendlyNameOf(device);
+    hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, reinterpret_cast<void**>(&client_));
+    SafeRelease(&device);
+    if (FAILED(hr)) {
+        *error = Failure("Activating the audio client", hr);
+        return false;
+    }
+
+    WAVEFORMATEX* mix = nullptr;
+    if (SUCCEEDED(client_->GetMixFormat(&mix))) {
+        mix_channels_.store(mix->nChannels, std::memory_order_relaxed);
+        mix_sample_rate_.store(mix->nSamplesPerSec, std::memory_order_relaxed);
+        CoTaskMemFree(mix);
+    }
+
+    WAVEFORMATEXTENSIBLE format = MonoFloatFormat(static_cast<DWORD>(kSampleRate));
+
+    DWORD flags = AUDCLNT_STREAMFLAGS_EVENTCALLBACK | AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM |
+                  AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY;
+    if (source_ == CaptureSource::kLoopback) {
+        flags |= AUDCLNT_STREAMFLAGS_LOOPBACK;
+    }
+
+    const bool communications = communications_ && source_ == CaptureSource::kMicrophone;
+    if (communications) {
+        hr = SetCommunicationsCategory(client_);
+        if (FAILED(hr)) {
+            Log(LogLevel::kWarn, kLogSource, "%s", Failure("Setting the communications category", hr).c_str());
+        }
+    }
+
+    hr = client_->Initialize(AUDCLNT_SHAREMODE_SHARED, flags, kBufferDuration, 0, &format.Format, nullptr);
+    if (FAILED(hr)) {
+        *error = Failure("Initializing the audio client", hr);
+        Close();
+        return false;
+    }
+    echo_cancellation_.store(communications ? QueryEchoCancellation(client_) : SystemEchoCancellation::kUnavailable,
+                             std::memory_order_relaxed);
+    hr = client_->SetEventHandle(sample_event_);
+    if (SUCCEEDED(hr)) {
+        hr = client_->GetService(__uuidof(IAudioCaptureClient), reinterpret_cast<void**>(&capture_client_));
+    }
+    if (SUCCEEDED(hr)) {
+        hr = client_->Start();
+    }
+    if (FAILED(hr)) {
+        *error = Failure("Starting the capture client", hr);
+        Close();
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        device_id_ = id;
+    }
+    Log(LogLevel::kInfo, kLogSource, "%s capture started on %s (mix %u ch @ %.0f Hz, delivered mono @ %.0f Hz)",
+        SourceName(source_), name.c_str(), mix_channels_.load(std::memory_order_relaxed),
+        mix_sample_rate_.load(std::memory_order_relaxed), kSampleRate);
+    if (communications) {
+        Log(LogLevel::kInfo, kLogSource, "Communications mode, endpoint AEC %s",
+            EchoCancellationName(echo_cancellation_.load(std::memory_order_relaxed)));
+    }
+    return true;
+}
+
+void WasapiCapture::Close() {
+    if (client_) {
+        client_->Stop();
+    }
+    SafeRelease(&capture_client_);
+    SafeRelease(&client_);
+}
+
+// Capture thread: hands every queued packet to the sink. No allocation, no
+// locks; returns the first failing HRESULT.
+HRESULT WasapiCapture::Pump() {
+    const uint64_t callback_start = HostTimeNow();
+
+    UINT32 packet_frames = 0;
+    HRESULT hr = capture_client_->GetNextPacketSize(&packet_frames);
+    while (SUCCEEDED(hr) && packet_frames > 0) {
+        BYTE* data = nullptr;
+        UINT32 frames = 0;
+        DWORD flags = 0;
+        UINT64 qpc_position = 0;
+        hr = capture_client_->GetBuffer(&data, &frames, &flags, nullptr, &qpc_position);
+        if (FAILED(hr)) {
+            break;
+        }
+
+        // The engine's glitch report, counted as the HAL's overloads are
+        if ((flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) && stats_) {
+            stats_->overloads.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (frames > kMaxFramesPerPacket) {
+            if (stats_) {
+                stats_->buffers_oversized.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else if (frames > 0) {
+            // When the first frame was captured, as reported by the engine
+            uint64_t host_time = (flags & AUDCLNT_BUFFERFLAGS_TIMESTAMP_ERROR)
+                ? callback_start : QpcPositionToHostTime(qpc_position);
+            const float* samples = (flags & AUDCLNT_BUFFERFLAGS_SILENT)
+                ? silence_.data() : reinterpret_cast<const float*>(data);
+            sink_(sink_context_, samples, frames, host_time);
+        }
+
+        hr = capture_client_->ReleaseBuffer(frames);
+        if (SUCCEEDED(hr)) {
+            hr = capture_client_->GetNextPacketSize(&packet_frames);
+        }
+    }
+
+    if (stats_) {
+        stats_->RecordCallback(callback_start, HostTimeNow());
+    }
+    return hr;
+}
+
+// WASAPI reports QPC positions in 100ns units; host time is raw QPC ticks
+uint64_t WasapiCapture::QpcPositionToHostTime(uint64_t qpc_position_100ns) const {
+    constexpr uint64_t kUnitsPerSecond = 10000000;
+    uint64_t frequency = static_cast<uint64_t>(qpc_frequency_);
+    return qpc_position_100ns / kUnitsPerSecond * frequency +
+           qpc_position_100ns % kUnitsPerSecond * frequency / kUnitsPerSecond;
+}
+
+} // namespace kakarot
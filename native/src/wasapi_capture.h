@@ -0,0 +1,127 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <audioclient.h>
+#include <mmdeviceapi.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "capture_backend.h"
+#include "capture_stats.h"
+
+namespace kakarot {
+
+// The endpoint's own echo canceller on a communications-mode stream: a
+// driver or OS audio processing object, queried through
+// IAudioEffectsManager (Windows 11 22H2 and later)
+enum class SystemEchoCancellation {
+    kUnavailable,  // no AEC effect, older Windows, or not in communications mode
+    kOff,          // listed but off, and the stream may not switch it on
+    kOn,
+};
+
+// Event-driven shared-mode WASAPI capture. The engine converts the endpoint
+// mix format to 48kHz mono float (AUTOCONVERTPCM), so |sink| sees the same
+// frames as on macOS. A dedicated thread, registered with MMCSS "Pro Audio",
+// waits on the buffer event and hands each packet over with its QPC capture
+// time in HostTimeNow() ticks. A default endpoint that goes away (unplugged,
+// default changed) is reopened on the new default.
+class WasapiCapture {
+public:
+    static constexpr double kSampleRate = 48000.0;
+    static constexpr const char* kBackendName = "WASAPI";
+    static constexpr const char* kTransport = "wasapi";  // getDevices() transport
+
+    WasapiCapture(CaptureSource source, RealtimeSink sink, void* sink_context);
+    ~WasapiCapture();
+
+    WasapiCapture(const WasapiCapture&) = delete;
+    WasapiCapture& operator=(const WasapiCapture&) = delete;
+
+    // Active capture endpoints; initializes COM on the calling thread
+    static std::vector<InputDeviceInfo> ListInputDevices();
+
+    // Opens |device_id| (or the default communications endpoint) in
+    // communications mode without starting it, to see whether its AEC
+    // effect runs, switching it on where the stream may. Blocking, a few
+    // milliseconds; initializes COM on the calling thread.
+    static SystemEchoCancellation ProbeEchoCancellation(const std::string& device_id);
+
+    // Microphone only, before Start(): open the stream in the
+    // communications category, where the endpoint's voice processing (AEC,
+    // often NS and AGC) applies, and default to the communications device
+    void SetCommunications(bool communications) { communications_ = communications; }
+
+    // Opens |device_id| (from ListInputDevices(), microphone only) or, when
+    // empty, the default endpoint, and returns once the stream is running
+    bool Start(const std::string& device_id, std::string* error);
+
+    // Stops the stream and joins the capture thread; no frames after this
+    void Stop();
+
+    // Counters for the capture thread. Must be set before Start() and
+    // outlive Stop().
+    void SetStats(CaptureStats* stats) { stats_ = stats; }
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    double SampleRate() const { return kSampleRate; }
+
+    // Endpoint mix format before conversion
+    uint32_t Channels() const { return mix_channels_.load(std::memory_order_relaxed); }
+    double MixSampleRate() const { return mix_sample_rate_.load(std::memory_order_relaxed); }
+
+    // Endpoint currently captured
+    std::string DeviceId() const;
+
+    // The AEC effect of the stream last opened
+    SystemEchoCancellation EchoCancellation() const { return echo_cancellation_.load(std::memory_order_relaxed); }
+
+private:
+    void ThreadMain();
+    bool Open(std::string* error);
+    void Close();
+    HRESULT Pump();
+    uint64_t QpcPositionToHostTime(uint64_t qpc_position_100ns) const;
+
+    const CaptureSource source_;
+    RealtimeSink sink_;
+    void* sink_context_;
+    CaptureStats* stats_ = nullptr;
+    std::string requested_id_;
+    bool communications_ = false;
+    std::atomic<SystemEchoCancellation> echo_cancellation_{SystemEchoCancellation::kUnavailable};
+
+    // Capture thread only, apart from DeviceId()
+    mutable std::mutex device_mutex_;
+    std::string device_id_;
+    IMMDeviceEnumerator* enumerator_ = nullptr;
+    IAudioClient* client_ = nullptr;
+    IAudioCaptureClient* capture_client_ = nullptr;
+
+    HANDLE sample_event_ = nullptr;
+    HANDLE stop_event_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // Handed to the sink for AUDCLNT_BUFFERFLAGS_SILENT packets
+    std::vector<float> silence_;
+
+    int64_t qpc_frequency_ = 1;
+    std::atomic<uint32_t> mix_channels_{0};
+    std::atomic<double> mix_sample_rate_{0.0};
+
+    // Start() waits on the first Open()
+    std::mutex start_mutex_;
+    std::condition_variable start_cv_;
+    bool start_done_ = false;
+    std::string start_error_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,237 @@
+#include "waveform_peaks.h"
+#include "native_log.h"
+#include "recording_index.h"
+#include "recording_reader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace kakarot {
+
+static const char* const kLogSource = "WaveformPeaks";
+
+static constexpr size_t kPeakHeaderSize = 16;
+static constexpr size_t kPeakBucketSize = 6;
+static constexpr uint32_t kPeakVersion = 1;
+
+// Capture timestamps wander by a few ms around the sample count; only a
+// jump larger than this is a gap in the audio
+static constexpr double kResyncMs = 20.0;
+
+using recording_index::GetLe;
+using recording_index::PutLe;
+
+static std::string LevelPath(const std::string& base, size_t level) {
+    return base + "." + std::to_string(kPeakLevelMs[level]) + "ms.peaks";
+}
+
+static int16_t ToS16(float value) {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+void PeakPyramidWriter::Reset(const std::string& base) {
+    Close();
+    base_ = base;
+    cursor_ms_ = -1.0;
+    failed_ = false;
+}
+
+bool PeakPyramidWriter::Open(int64_t first_bucket_10ms) {
+    for (size_t level = 0; level < kPeakLevels; ++level) {
+        const std::string path = LevelPath(base_, level);
+        Level& state = levels_[level];
+        state.file = std::fopen(path.c_str(), "wb");
+        if (!state.file) {
+            Log(LogLevel::kError, kLogSource, "Cannot open %s", path.c_str());
+            return false;
+        }
+        uint8_t header[kPeakHeaderSize] = {'K', 'K', 'P', 'K'};
+        PutLe(header + 4, kPeakVersion, 4);
+        PutLe(header + 8, static_cast<uint32_t>(kPeakLevelMs[level]), 4);
+        PutLe(header + 12, static_cast<uint32_t>(first_bucket_10ms * kPeakLevelMs[0] / kPeakLevelMs[level]), 4);
+        std::fwrite(header, 1, sizeof(header), state.file);
+        state.bucket = -1;
+    }
+    return true;
+}
+
+void PeakPyramidWriter::Fail() {
+    Log(LogLevel::kError, kLogSource, "Write to %s.*.peaks failed; the waveform stops", base_.c_str());
+    failed_ = true;
+    for (Level& state : levels_) {
+        if (state.file) {
+            std::fclose(state.file);
+            state.file = nullptr;
+        }
+    }
+}
+
+void PeakPyramidWriter::Add(const float* samples, size_t count, int sample_rate, double time_ms) {
+    if (failed_ || base_.empty() || count == 0 || sample_rate <= 0) {
+        return;
+    }
+    if (cursor_ms_ < 0.0) {
+        cursor_ms_ = std::max(time_ms, 0.0);
+        if (!Open(static_cast<int64_t>(cursor_ms_ / kPeakLevelMs[0]))) {
+            Fail();
+            return;
+        }
+    } else if (time_ms > cursor_ms_ + kResyncMs) {
+        cursor_ms_ = time_ms;
+    }
+
+    // Runs of samples that share a 10ms bucket, folded in one call each
+    const double sample_ms = 1000.0 / sample_rate;
+    size_t i = 0;
+    while (i < count && !failed_) {
+        const double start_ms = cursor_ms_ + i * sample_ms;
+        const int64_t bucket = static_cast<int64_t>(start_ms / kPeakLevelMs[0]);
+        const double bucket_end_ms = static_cast<double>(bucket + 1) * kPeakLevelMs[0];
+        size_t run = static_cast<size_t>(std::ceil((bucket_end_ms - start_ms) / sample_ms));
+        run = std::clamp<size_t>(run, 1, count - i);
+        float min = std::numeric_limits<float>::max();
+        float max = std::numeric_limits<float>::lowest();
+        double sum_squares = 0.0;
+        for (size_t k = i; k < i + run; ++k) {
+            min = std::min(min, samples[k]);
+            max = std::max(max, samples[k]);
+            sum_squares += static_cast<double>(samples[k]) * samples[k];
+        }
+        Accumulate(0, bucket, min, max, sum_squares, run);
+        i += run;
+    }
+    cursor_ms_ += count * sample_ms;
+}
+
+void PeakPyramidWriter::Accumulate(size_t level, int64_t bucket, float min, float max, double sum_squares,
+                                   uint64_t count) {
+    Level& state = levels_[level];
+    if (state.bucket >= 0 && bucket > state.bucket) {
+        // Finish this bucket, then silence for any the track skipped
+        const int64_t target = bucket;
+        Emit(level);
+        while (!failed_ && state.bucket + 1 < target) {
+            state.bucket++;
+            Emit(level);
+        }
+    }
+    if (failed_) {
+        return;
+    }
+    if (state.bucket < 0 || bucket > state.bucket) {
+        state.bucket = bucket;
+        state.min = std::numeric_limits<float>::max();
+        state.max = std::numeric_limits<float>::lowest();
+        state.sum_squares = 0.0;
+        state.count = 0;
+    }
+    if (count > 0) {
+        state.min = std::min(state.min, min);
+        state.max = std::max(state.max, max);
+        state.sum_squares += sum_squares;
+        state.count += count;
+    }
+}
+
+// Writes the bucket in progress and passes it to the next level up; an
+// empty bucket is written as silence
+void PeakPyramidWriter::Emit(size_t level) {
+    Level& state = levels_[level];
+    uint8_t bucket[kPeakBucketSize] = {};
+    if (state.count > 0) {
+        const double rms = std::sqrt(state.sum_squares / static_cast<double>(state.count));
+        PutLe(bucket, static_cast<uint16_t>(ToS16(state.min)), 2);
+        PutLe(bucket + 2, static_cast<uint16_t>(ToS16(state.max)), 2);
+        PutLe(bucket + 4, static_cast<uint16_t>(ToS16(static_cast<float>(rms))), 2);
+    }
+    if (std::fwrite(bucket, 1, sizeof(bucket), state.file) != sizeof(bucket)) {
+        Fail();
+        return;
+    }
+    if (level + 1 < kPeakLevels) {
+        const int64_t up = state.bucket * kPeakLevelMs[level] / kPeakLevelMs[level + 1];
+        Accumulate(level + 1, up, state.min, state.max, state.sum_squares, state.count);
+    }
+    state.count = 0;
+    state.sum_squares = 0.0;
+    state.min = std::numeric_limits<float>::max();
+    state.max = std::numeric_limits<float>::lowest();
+}
+
+void PeakPyramidWriter::Commit() {
+    for (Level& state : levels_) {
+        if (!state.file) {
+            continue;
+        }
+        std::fflush(state.file);
+#if defined(_WIN32)
+        _commit(_fileno(state.file));
+#else
+        fsync(fileno(state.file));
+#endif
+    }
+}
+
+void PeakPyramidWriter::Close() {
+    for (size_t level = 0; level < kPeakLevels && !failed_; ++level) {
+        if (levels_[level].file && levels_[level].bucket >= 0) {
+            Emit(level);
+        }
+    }
+    Commit();
+    for (Level& state : levels_) {
+        if (state.file) {
+            std::fclose(state.file);
+            state.file = nullptr;
+        }
+        state.bucket = -1;
+    }
+}
+
+bool ReadPeaks(const std::string& base, double start_ms, double end_ms, size_t points, PeakRange* range,
+               std::string* error) {
+    *range = PeakRange();
+    size_t level = 0;
+    for (size_t candidate = kPeakLevels; candidate-- > 0;) {
+        if ((end_ms - start_ms) / kPeakLevelMs[candidate] >= static_cast<double>(points)) {
+            level = candidate;
+            break;
+        }
+    }
+
+    const std::string path = LevelPath(base, level);
+    MappedFile file;
+    if (!file.Open(path, error)) {
+        return false;
+    }
+    if (file.Size() < kPeakHeaderSize || std::memcmp(file.Data(), "KKPK", 4) != 0 ||
+        GetLe(file.Data() + 4, 4) != kPeakVersion) {
+        *error = "not a waveform file: " + path;
+        return false;
+    }
+    const int bucket_ms = kPeakLevelMs[level];
+    const int64_t first = static_cast<int64_t>(GetLe(file.Data() + 12, 4));
+    const int64_t available = static_cast<int64_t>((file.Size() - kPeakHeaderSize) / kPeakBucketSize);
+    const int64_t begin = std::max<int64_t>(static_cast<int64_t>(std::floor(start_ms / bucket_ms)), first);
+    const int64_t end = std::min<int64_t>(static_cast<int64_t>(std::ceil(end_ms / bucket_ms)), first + available);
+
+    range->bucket_ms = bucket_ms;
+    range->start_ms = static_cast<double>(begin) * bucket_ms;
+    if (end <= begin) {
+        return true;
+    }
+    range->values.resize(static_cast<size_t>(end - begin) * 3);
+    const uint8_t* bucket = file.Data() + kPeakHeaderSize + (begin - first) * kPeakBucketSize;
+    for (size_t i = 0; i < range->values.size(); ++i, bucket += 2) {
+        range->values[i] = static_cast<int16_t>(GetLe(bucket, 2));
+    }
+    return true;
+}
+
+} // namespace kakarot
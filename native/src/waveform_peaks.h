@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// A track's waveform at three zooms, built as it records so a timeline
+// never scans audio: <base>.<ms>ms.peaks holds a min/max/RMS triple per
+// bucket of 10ms, 100ms or 1s of recording time. Each file is
+//
+//   header  "KKPK", u32 version, u32 bucket_ms, u32 first_bucket
+//   bucket  i16 min, i16 max, u16 rms (full scale 32767), one per bucket from
+//           first_bucket on; silence where the track had no audio
+//
+// little-endian and append-only, so a crash costs the unsynced tail only.
+constexpr size_t kPeakLevels = 3;
+constexpr int kPeakLevelMs[kPeakLevels] = {10, 100, 1000};
+
+// Writer thread of the recorder
+class PeakPyramidWriter {
+public:
+    PeakPyramidWriter() = default;
+    ~PeakPyramidWriter() { Close(); }
+
+    PeakPyramidWriter(const PeakPyramidWriter&) = delete;
+    PeakPyramidWriter& operator=(const PeakPyramidWriter&) = delete;
+
+    // Files open with the first Add(); a failed write is logged and only the
+    // pyramid stops
+    void Reset(const std::string& base);
+
+    // |time_ms| is the recording time of samples[0]. Jitter against the
+    // running sample count is absorbed; a jump forward is a gap.
+    void Add(const float* samples, size_t count, int sample_rate, double time_ms);
+
+    // Flushed and committed to disk, as the recorder syncs its WAVs
+    void Commit();
+
+    // Writes the buckets in progress and closes the files
+    void Close();
+
+private:
+    struct Level {
+        FILE* file = nullptr;
+        int64_t bucket = -1;  // in progress
+        float min = 0.0f;
+        float max = 0.0f;
+        double sum_squares = 0.0;
+        uint64_t count = 0;
+    };
+
+    bool Open(int64_t first_bucket_10ms);
+    void Accumulate(size_t level, int64_t bucket, float min, float max, double sum_squares, uint64_t count);
+    void Emit(size_t level);
+    void Fail();
+
+    std::string base_;
+    Level levels_[kPeakLevels];
+    double cursor_ms_ = -1.0;  // recording time of the next sample
+    bool failed_ = false;
+};
+
+// The buckets covering [start_ms, end_ms) at the coarsest zoom that still
+// gives |points| of them, or the finest there is
+struct PeakRange {
+    int bucket_ms = 0;
+    double start_ms = 0.0;         // of values' first triple
+    std::vector<int16_t> values;   // min, max, rms per bucket
+};
+
+// Reads <base>.<ms>ms.peaks as it stands, a live recording's included.
+// False (with |error|) when the track has no pyramid.
+bool ReadPeaks(const std::string& base, double start_ms, double end_ms, size_t points, PeakRange* range,
+               std::string* error);
+
+} // namespace kakarot
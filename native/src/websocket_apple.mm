@@ -0,0 +1,198 @@
+#import <Foundation/Foundation.h>
+#include "websocket_connection.h"
+#include <atomic>
+#include <mutex>
+
+// Open and failure of the task's handshake, which NSURLSession reports only
+// to its delegate
+@interface KakarotWebSocketDelegate : NSObject <NSURLSessionWebSocketDelegate>
+@property (nonatomic, strong) dispatch_semaphore_t opened;
+@property (atomic, assign) BOOL open;
+@property (atomic, copy) NSString* failure;
+@end
+
+@implementation KakarotWebSocketDelegate
+
+- (void)URLSession:(NSURLSession*)session
+          webSocketTask:(NSURLSessionWebSocketTask*)webSocketTask
+    didOpenWithProtocol:(NSString*)protocol {
+    self.open = YES;
+    dispatch_semaphore_signal(self.opened);
+}
+
+- (void)URLSession:(NSURLSession*)session task:(NSURLSessionTask*)task didCompleteWithError:(NSError*)error {
+    if (!self.open) {
+        self.failure = error ? error.localizedDescription : @"Websocket closed during the handshake";
+    }
+    dispatch_semaphore_signal(self.opened);
+}
+
+@end
+
+namespace kakarot {
+
+// Resolve, TLS and the upgrade together
+static constexpr int64_t kConnectTimeoutNs = 10 * NSEC_PER_SEC;
+
+static std::string Describe(NSError* error) {
+    return error ? std::string(error.localizedDescription.UTF8String ?: "unknown error") : std::string();
+}
+
+class AppleWebSocket : public WebSocketConnection {
+public:
+    ~AppleWebSocket() override {
+        Abort();
+    }
+
+    bool Connect(const std::string& url, const HttpHeaders& headers, std::string* error) override {
+        @autoreleasepool {
+            NSURL* ns_url = [NSURL URLWithString:[NSString stringWithUTF8String:url.c_str()]];
+            if (!ns_url) {
+                *error = "Invalid websocket URL";
+                return false;
+            }
+            NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:ns_url];
+            for (const auto& header : headers) {
+                [request setValue:[NSString stringWithUTF8String:header.second.c_str()]
+                    forHTTPHeaderField:[NSString stringWithUTF8String:header.first.c_str()]];
+            }
+
+            KakarotWebSocketDelegate* delegate = [[KakarotWebSocketDelegate alloc] init];
+            delegate.opened = dispatch_semaphore_create(0);
+            NSURLSessionWebSocketTask* task = nil;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (aborted_) {
+                    *error = "Websocket was aborted";
+                    return false;
+                }
+                // The session keeps its delegate until invalidated, in Abort()
+                session_ = [NSURLSession sessionWithConfiguration:[NSURLSessionConfiguration ephemeralSessionConfiguration]
+                                                         delegate:delegate
+                                                    delegateQueue:nil];
+                task_ = [session_ webSocketTaskWithRequest:request];
+                task = task_;
+            }
+            [task resume];
+            if (dispatch_semaphore_wait(delegate.opened, dispatch_time(DISPATCH_TIME_NOW, kConnectTimeoutNs)) != 0) {
+                *error = "Websocket handshake timed out";
+                return false;
+            }
+            if (!delegate.open) {
+                *error = delegate.failure ? std::string(delegate.failure.UTF8String) : "Websocket was aborted";
+                return false;
+            }
+            return true;
+        }
+    }
+
+    bool Send(const uint8_t* data, size_t size, bool text, std::string* error) override {
+        @autoreleasepool {
+            NSURLSessionWebSocketTask* task = Task();
+            if (!task) {
+                *error = "Websocket is closed";
+                return false;
+            }
+            NSURLSessionWebSocketMessage* message = text
+                ? [[NSURLSessionWebSocketMessage alloc]
+                      initWithString:[[NSString alloc] initWithBytes:data length:size encoding:NSUTF8StringEncoding]]
+                : [[NSURLSessionWebSocketMessage alloc] initWithData:[NSData dataWithBytes:data length:size]];
+            dispatch_semaphore_t done = dispatch_semaphore_create(0);
+            __block NSError* failure = nil;
+            [task sendMessage:message completionHandler:^(NSError* send_error) {
+                failure = send_error;
+                dispatch_semaphore_signal(done);
+            }];
+            dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+            if (failure) {
+                *error = Describe(failure);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    bool Receive(std::string* message, bool* text, std::string* error) override {
+        @autoreleasepool {
+            NSURLSessionWebSocketTask* task = Task();
+            if (!task) {
+                *error = "Websocket is closed";
+                return false;
+            }
+            dispatch_semaphore_t done = dispatch_semaphore_create(0);
+            __block NSURLSessionWebSocketMessage* received = nil;
+            __block NSError* failure = nil;
+            [task receiveMessageWithCompletionHandler:^(NSURLSessionWebSocketMessage* result, NSError* receive_error) {
+                received = result;
+                failure = receive_error;
+                dispatch_semaphore_signal(done);
+            }];
+            dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+            if (!received) {
+                // A close frame ends the task with an error too; only a missing one is a failure
+                if (task.closeCode != NSURLSessionWebSocketCloseCodeInvalid) {
+                    error->clear();
+                } else {
+                    *error = failure ? Describe(failure) : "Websocket closed";
+                }
+                return false;
+            }
+            if (received.type == NSURLSessionWebSocketMessageTypeString) {
+                *text = true;
+                message->assign(received.string.UTF8String ?: "");
+            } else {
+                *text = false;
+                message->assign(static_cast<const char*>(received.data.bytes), received.data.length);
+            }
+            return true;
+        }
+    }
+
+    void Shutdown(uint16_t code) override {
+        NSURLSessionWebSocketTask* task = Task();
+        if (task && !shut_down_.exchange(true)) {
+            [task cancelWithCloseCode:static_cast<NSURLSessionWebSocketCloseCode>(code) reason:nil];
+        }
+    }
+
+    void Abort() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+        // Fails pending sends and receives, and releases the delegate
+        [task_ cancel];
+        [session_ invalidateAndCancel];
+        task_ = nil;
+        session_ = nil;
+    }
+
+    uint16_t CloseCode() const override {
+        NSURLSessionWebSocketTask* task = Task();
+        NSInteger code = task ? task.closeCode : NSURLSessionWebSocketCloseCodeInvalid;
+        return code == NSURLSessionWebSocketCloseCodeInvalid ? 1006 : static_cast<uint16_t>(code);
+    }
+
+    std::string CloseReason() const override {
+        NSURLSessionWebSocketTask* task = Task();
+        NSData* reason = task ? task.closeReason : nil;
+        return reason ? std::string(static_cast<const char*>(reason.bytes), reason.length) : std::string();
+    }
+
+private:
+    NSURLSessionWebSocketTask* Task() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return task_;
+    }
+
+    mutable std::mutex mutex_;
+    NSURLSession* session_ = nil;
+    NSURLSessionWebSocketTask* task_ = nil;
+    bool aborted_ = false;
+    std::atomic<bool> shut_down_{false};
+};
+
+std::unique_ptr<WebSocketConnection> CreateWebSocketConnection(std::string* error) {
+    (void)error;
+    return std::make_unique<AppleWebSocket>();
+}
+
+} // namespace kakarot
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kakarot {
+
+using HttpHeaders = std::vector<std::pair<std::string, std::string>>;
+
+// A client websocket over the OS TLS stack: NSURLSession on macOS, WinHTTP
+// on Windows. Blocking calls, made by TranscriptionSocket's threads: one
+// sends (and shuts down) while another receives; only Abort() is for any
+// thread.
+class WebSocketConnection {
+public:
+    virtual ~WebSocketConnection() = default;
+
+    // TLS handshake and upgrade of a wss:// (or ws://) |url|. False with
+    // |error| set when the server refused or could not be reached.
+    virtual bool Connect(const std::string& url, const HttpHeaders& headers, std::string* error) = 0;
+
+    // One binary or text message; false once the connection is gone
+    virtual bool Send(const uint8_t* data, size_t size, bool text, std::string* error) = 0;
+
+    // Waits for the next whole message. False when the connection closed
+    // (|error| empty after a close handshake) or failed.
+    virtual bool Receive(std::string* message, bool* text, std::string* error) = 0;
+
+    // Sending thread. A close frame; Receive() returns once the peer answers.
+    virtual void Shutdown(uint16_t code) = 0;
+
+    // Any thread. Drops the connection, failing whatever call is blocked.
+    virtual void Abort() = 0;
+
+    // The peer's close frame, once Receive() returned false; 1006 when none came
+    virtual uint16_t CloseCode() const = 0;
+    virtual std::string CloseReason() const = 0;
+};
+
+// Null, with |error| set, on platforms without a backend (Linux)
+std::unique_ptr<WebSocketConnection> CreateWebSocketConnection(std::string* error);
+
+} // namespace kakarot
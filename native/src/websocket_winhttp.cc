@@ -0,0 +1,241 @@
+#include "websocket_connection.h"
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <winhttp.h>
+#include <atomic>
+#include <mutex>
+
+namespace kakarot {
+
+// Receive() reads a message in pieces of this size
+static constexpr DWORD kReceiveChunkBytes = 16384;
+
+// Resolve, connect and each step of the upgrade request
+static constexpr int kConnectTimeoutMs = 10000;
+
+static std::wstring Widen(const std::string& text) {
+    if (text.empty()) {
+        return std::wstring();
+    }
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &wide[0], length);
+    return wide;
+}
+
+static std::string WinHttpError(const char* call, DWORD code) {
+    return std::string(call) + " failed (" + std::to_string(code) + ")";
+}
+
+class WinHttpWebSocket : public WebSocketConnection {
+public:
+    ~WinHttpWebSocket() override {
+        Abort();
+    }
+
+    bool Connect(const std::string& url, const HttpHeaders& headers, std::string* error) override {
+        // ws(s):// is not a scheme WinHttpCrackUrl knows; the upgrade is what makes it one
+        std::string http_url = url;
+        if (http_url.compare(0, 6, "wss://") == 0) {
+            http_url = "https://" + http_url.substr(6);
+        } else if (http_url.compare(0, 5, "ws://") == 0) {
+            http_url = "http://" + http_url.substr(5);
+        }
+        std::wstring wide_url = Widen(http_url);
+        URL_COMPONENTS parts = {};
+        parts.dwStructSize = sizeof(parts);
+        parts.dwHostNameLength = static_cast<DWORD>(-1);
+        parts.dwUrlPathLength = static_cast<DWORD>(-1);
+        parts.dwExtraInfoLength = static_cast<DWORD>(-1);
+        if (!WinHttpCrackUrl(wide_url.c_str(), 0, 0, &parts)) {
+            *error = "Invalid websocket URL";
+            return false;
+        }
+        std::wstring host(parts.lpszHostName, parts.dwHostNameLength);
+        std::wstring path(parts.lpszUrlPath, parts.dwUrlPathLength);
+        path.append(parts.lpszExtraInfo, parts.dwExtraInfoLength);
+
+        // Handles are published as they open, so Abort() from another thread
+        // closes them and fails the blocked call
+        HINTERNET session = WinHttpOpen(L"kakarot", WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY, WINHTTP_NO_PROXY_NAME,
+                                        WINHTTP_NO_PROXY_BYPASS, 0);
+        if (!session || !Publish(&session_, session)) {
+            *error = session ? "Websocket was aborted" : WinHttpError("WinHttpOpen", GetLastError());
+            return false;
+        }
+        HINTERNET connection = WinHttpConnect(session, host.c_str(), parts.nPort, 0);
+        if (!connection || !Publish(&connection_, connection)) {
+            *error = connection ? "Websocket was aborted" : WinHttpError("WinHttpConnect", GetLastError());
+            return false;
+        }
+        HINTERNET request = WinHttpOpenRequest(connection, L"GET", path.c_str(), nullptr, WINHTTP_NO_REFERER,
+                                               WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                               parts.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE : 0);
+        if (!request) {
+            *error = WinHttpError("WinHttpOpenRequest", GetLastError());
+            return false;
+        }
+        WinHttpSetTimeouts(request, kConnectTimeoutMs, kConnectTimeoutMs, kConnectTimeoutMs, kConnectTimeoutMs);
+        bool ok = WinHttpSetOption(request, WINHTTP_OPTION_UPGRADE_TO_WEB_SOCKET, nullptr, 0);
+        for (const auto& header : headers) {
+            if (!ok) {
+                break;
+            }
+            std::wstring line = Widen(header.first + ": " + header.second);
+            ok = WinHttpAddRequestHeaders(request, line.c_str(), static_cast<DWORD>(line.size()),
+                                          WINHTTP_ADDREQ_FLAG_ADD | WINHTTP_ADDREQ_FLAG_REPLACE);
+        }
+        if (!ok || !WinHttpSendRequest(request, WINHTTP_NO_ADDITIONAL_HEADERS, 0, nullptr, 0, 0, 0) ||
+            !WinHttpReceiveResponse(request, nullptr)) {
+            *error = WinHttpError("Websocket request", GetLastError());
+            WinHttpCloseHandle(request);
+            return false;
+        }
+        DWORD status = 0;
+        DWORD size = sizeof(status);
+        WinHttpQueryHeaders(request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                            WINHTTP_HEADER_NAME_BY_INDEX, &status, &size, WINHTTP_NO_HEADER_INDEX);
+        if (status != 101) {
+            *error = "Websocket upgrade refused (HTTP " + std::to_string(status) + ")";
+            WinHttpCloseHandle(request);
+            return false;
+        }
+        HINTERNET websocket = WinHttpWebSocketCompleteUpgrade(request, 0);
+        DWORD upgrade_error = GetLastError();
+        WinHttpCloseHandle(request);
+        if (!websocket) {
+            *error = WinHttpError("WinHttpWebSocketCompleteUpgrade", upgrade_error);
+            return false;
+        }
+        websocket_.store(websocket);
+        if (aborted_.load()) {
+            Abort();
+            *error = "Websocket was aborted";
+            return false;
+        }
+        return true;
+    }
+
+    bool Send(const uint8_t* data, size_t size, bool text, std::string* error) override {
+        HINTERNET websocket = websocket_.load();
+        if (!websocket) {
+            *error = "Websocket is closed";
+            return false;
+        }
+        DWORD result = WinHttpWebSocketSend(
+            websocket, text ? WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE : WINHTTP_WEB_SOCKET_BINARY_MESSAGE_BUFFER_TYPE,
+            const_cast<uint8_t*>(data), static_cast<DWORD>(size));
+        if (result != NO_ERROR) {
+            *error = WinHttpError("WinHttpWebSocketSend", result);
+            return false;
+        }
+        return true;
+    }
+
+    bool Receive(std::string* message, bool* text, std::string* error) override {
+        message->clear();
+        for (;;) {
+            HINTERNET websocket = websocket_.load();
+            if (!websocket) {
+                *error = "Websocket is closed";
+                return false;
+            }
+            const size_t offset = message->size();
+            message->resize(offset + kReceiveChunkBytes);
+            DWORD read = 0;
+            WINHTTP_WEB_SOCKET_BUFFER_TYPE type;
+            DWORD result = WinHttpWebSocketReceive(websocket, &(*message)[offset], kReceiveChunkBytes, &read, &type);
+            message->resize(offset + (result == NO_ERROR ? read : 0));
+            if (result != NO_ERROR) {
+                *error = WinHttpError("WinHttpWebSocketReceive", result);
+                return false;
+            }
+            switch (type) {
+                case WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE:
+                case WINHTTP_WEB_SOCKET_BINARY_MESSAGE_BUFFER_TYPE:
+                    *text = type == WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE;
+                    return true;
+                case WINHTTP_WEB_SOCKET_CLOSE_BUFFER_TYPE: {
+                    USHORT code = 1006;
+                    BYTE reason[123];
+                    DWORD reason_bytes = 0;
+                    if (WinHttpWebSocketQueryCloseStatus(websocket, &code, reason, sizeof(reason), &reason_bytes) ==
+                        NO_ERROR) {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        close_code_ = code;
+                        close_reason_.assign(reinterpret_cast<const char*>(reason), reason_bytes);
+                    }
+                    error->clear();
+                    return false;
+                }
+                default:
+                    break;  // a fragment: keep reading
+            }
+        }
+    }
+
+    void Shutdown(uint16_t code) override {
+        HINTERNET websocket = websocket_.load();
+        if (websocket && !shut_down_.exchange(true)) {
+            WinHttpWebSocketShutdown(websocket, code, nullptr, 0);
+        }
+    }
+
+    void Abort() override {
+        // Closing the handles cancels a blocked send or receive
+        aborted_.store(true);
+        HINTERNET websocket = websocket_.exchange(nullptr);
+        if (websocket) {
+            WinHttpCloseHandle(websocket);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (connection_) {
+            WinHttpCloseHandle(connection_);
+            connection_ = nullptr;
+        }
+        if (session_) {
+            WinHttpCloseHandle(session_);
+            session_ = nullptr;
+        }
+    }
+
+    uint16_t CloseCode() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return close_code_;
+    }
+
+    std::string CloseReason() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return close_reason_;
+    }
+
+private:
+    // False, closing |handle|, once Abort() ran
+    bool Publish(HINTERNET* slot, HINTERNET handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (aborted_.load()) {
+            WinHttpCloseHandle(handle);
+            return false;
+        }
+        *slot = handle;
+        return true;
+    }
+
+    mutable std::mutex mutex_;
+    HINTERNET session_ = nullptr;
+    HINTERNET connection_ = nullptr;
+    std::atomic<HINTERNET> websocket_{nullptr};
+    std::atomic<bool> shut_down_{false};
+    std::atomic<bool> aborted_{false};
+    uint16_t close_code_ = 1006;
+    std::string close_reason_;
+};
+
+std::unique_ptr<WebSocketConnection> CreateWebSocketConnection(std::string* error) {
+    (void)error;
+    return std::make_unique<WinHttpWebSocket>();
+}
+
+} // namespace kakarot
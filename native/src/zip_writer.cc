@@ -0,0 +1,242 @@
+#include "zip_writer.h"
+#include "recording_index.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <array>
+#include <ctime>
+#include <limits>
+
+namespace kakarot {
+
+using recording_index::PutLe;
+
+static constexpr uint32_t kLocalHeaderSignature = 0x04034b50;
+static constexpr uint32_t kDataDescriptorSignature = 0x08074b50;
+static constexpr uint32_t kCentralHeaderSignature = 0x02014b50;
+static constexpr uint32_t kEndOfDirectorySignature = 0x06054b50;
+
+static constexpr size_t kLocalHeaderBytes = 30;
+static constexpr size_t kDataDescriptorBytes = 16;
+static constexpr size_t kCentralHeaderBytes = 46;
+static constexpr size_t kEndOfDirectoryBytes = 22;
+
+// 2.0: a data descriptor; stored entries need nothing later
+static constexpr uint16_t kVersion = 20;
+// Sizes and CRC follow the data (bit 3); the name is UTF-8 (bit 11)
+static constexpr uint16_t kFlags = (1 << 3) | (1 << 11);
+
+static constexpr uint64_t kMaxOffset = std::numeric_limits<uint32_t>::max();
+
+static const std::array<uint32_t, 256>& CrcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    const std::array<uint32_t, 256>& table = CrcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool ZipWriter::IsEntryName(const std::string& name) {
+    if (name.empty() || name.size() > 0xffff || name.front() == '/' || name.back() == '/' ||
+        name.find('\\') != std::string::npos || name.find(':') != std::string::npos) {
+        return false;
+    }
+    size_t start = 0;
+    while (start <= name.size()) {
+        size_t end = name.find('/', start);
+        if (end == std::string::npos) {
+            end = name.size();
+        }
+        const std::string part = name.substr(start, end - start);
+        if (part.empty() || part == "." || part == "..") {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+ZipWriter::~ZipWriter() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+bool ZipWriter::Open(const std::string& path, std::string* error) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        *error = "cannot create " + path;
+        return false;
+    }
+    // Every entry gets the archive's time, in local time as DOS dates are
+    const std::time_t now = std::time(nullptr);
+    std::tm local{};
+#if defined(_WIN32)
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    dos_time_ = static_cast<uint16_t>((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+    dos_date_ = static_cast<uint16_t>((std::max(0, local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) |
+                                      local.tm_mday);
+    buffer_.resize(kCopyBytes);
+    return true;
+}
+
+bool ZipWriter::Begin(const std::string& name, std::string* error) {
+    if (!IsEntryName(name)) {
+        *error = "bad entry name '" + name + "'";
+        return false;
+    }
+    for (const Entry& entry : entries_) {
+        if (entry.name == name) {
+            *error = "entry '" + name + "' is already in the archive";
+            return false;
+        }
+    }
+    if (offset_ > kMaxOffset) {
+        *error = "archive is over 4GiB";
+        return false;
+    }
+    Entry entry;
+    entry.name = name;
+    entry.offset = static_cast<uint32_t>(offset_);
+    entries_.push_back(std::move(entry));
+
+    uint8_t header[kLocalHeaderBytes] = {};
+    PutLe(header, kLocalHeaderSignature, 4);
+    PutLe(header + 4, kVersion, 2);
+    PutLe(header + 6, kFlags, 2);
+    PutLe(header + 8, 0, 2);  // stored
+    PutLe(header + 10, dos_time_, 2);
+    PutLe(header + 12, dos_date_, 2);
+    // CRC and sizes stay zero here, as bit 3 says
+    PutLe(header + 26, name.size(), 2);
+    return Write(header, sizeof(header), error) &&
+           Write(reinterpret_cast<const uint8_t*>(name.data()), name.size(), error);
+}
+
+bool ZipWriter::Write(const uint8_t* data, size_t size, std::string* error) {
+    if (size > 0 && std::fwrite(data, 1, size, file_) != size) {
+        *error = "cannot write the archive";
+        return false;
+    }
+    offset_ += size;
+    return true;
+}
+
+bool ZipWriter::End(uint32_t crc, uint64_t size, std::string* error) {
+    if (size > kMaxOffset) {
+        *error = "entry '" + entries_.back().name + "' is over 4GiB";
+        return false;
+    }
+    entries_.back().crc = crc;
+    entries_.back().size = static_cast<uint32_t>(size);
+    uint8_t descriptor[kDataDescriptorBytes];
+    PutLe(descriptor, kDataDescriptorSignature, 4);
+    PutLe(descriptor + 4, crc, 4);
+    PutLe(descriptor + 8, size, 4);   // compressed
+    PutLe(descriptor + 12, size, 4);  // uncompressed
+    return Write(descriptor, sizeof(descriptor), error);
+}
+
+bool ZipWriter::Add(const std::string& name, const uint8_t* data, size_t size, std::string* error) {
+    return Begin(name, error) && Write(data, size, error) && End(Crc32(0, data, size), size, error);
+}
+
+bool ZipWriter::AddFile(const std::string& name, const std::string& path, const std::atomic<bool>& cancel,
+                        const CopyProgressFn& copied, std::string* error) {
+    FILE* in = std::fopen(path.c_str(), "rb");
+    if (!in) {
+        *error = "cannot open " + path;
+        return false;
+    }
+    bool ok = Begin(name, error);
+    uint32_t crc = 0;
+    uint64_t size = 0;
+    while (ok) {
+        TaskScheduler::YieldForAudio(cancel);
+        if (cancel.load(std::memory_order_relaxed)) {
+            *error = "cancelled";
+            ok = false;
+            break;
+        }
+        const size_t read = std::fread(buffer_.data(), 1, buffer_.size(), in);
+        if (read == 0) {
+            if (std::ferror(in)) {
+                *error = "cannot read " + path;
+                ok = false;
+            }
+            break;
+        }
+        crc = Crc32(crc, buffer_.data(), read);
+        size += read;
+        ok = Write(buffer_.data(), read, error);
+        if (ok && copied) {
+            copied(size);
+        }
+    }
+    std::fclose(in);
+    return ok && End(crc, size, error);
+}
+
+bool ZipWriter::Finish(std::string* error) {
+    if (offset_ > kMaxOffset || entries_.size() > 0xffff) {
+        *error = "archive is over 4GiB or 65535 entries";
+        return false;
+    }
+    const uint64_t directory = offset_;
+    bool ok = true;
+    for (const Entry& entry : entries_) {
+        uint8_t header[kCentralHeaderBytes] = {};
+        PutLe(header, kCentralHeaderSignature, 4);
+        PutLe(header + 4, kVersion, 2);  // made by: MS-DOS attributes, v2.0
+        PutLe(header + 6, kVersion, 2);
+        PutLe(header + 8, kFlags, 2);
+        PutLe(header + 10, 0, 2);
+        PutLe(header + 12, dos_time_, 2);
+        PutLe(header + 14, dos_date_, 2);
+        PutLe(header + 16, entry.crc, 4);
+        PutLe(header + 20, entry.size, 4);
+        PutLe(header + 24, entry.size, 4);
+        PutLe(header + 28, entry.name.size(), 2);
+        PutLe(header + 42, entry.offset, 4);
+        ok = ok && Write(header, sizeof(header), error) &&
+             Write(reinterpret_cast<const uint8_t*>(entry.name.data()), entry.name.size(), error);
+    }
+    const uint64_t directory_bytes = offset_ - directory;
+    uint8_t end[kEndOfDirectoryBytes] = {};
+    PutLe(end, kEndOfDirectorySignature, 4);
+    PutLe(end + 8, entries_.size(), 2);
+    PutLe(end + 10, entries_.size(), 2);
+    PutLe(end + 12, directory_bytes, 4);
+    PutLe(end + 16, directory, 4);
+    ok = ok && Write(end, sizeof(end), error);
+    if (ok && offset_ > kMaxOffset) {
+        *error = "archive is over 4GiB";
+        ok = false;
+    }
+    const bool closed = std::fclose(file_) == 0;
+    file_ = nullptr;
+    if (ok && !closed) {
+        *error = "cannot write the archive";
+    }
+    return ok && closed;
+}
+
+} // namespace kakarot
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace kakarot {
+
+// CRC-32 (IEEE, as ZIP and gzip use it) of |size| bytes, continuing from |crc|
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size);
+
+// A ZIP archive written front to back in one pass: each entry's local
+// header, its bytes as they arrive, then a data descriptor with the CRC and
+// sizes, and the central directory at Finish(). Nothing is seeked back
+// over and nothing is held but the directory, so an entry costs its copy
+// buffer whatever its size. Entries are stored, not deflated (the audio
+// is compressed already); names are UTF-8. No Zip64: past 4GiB an entry
+// or the archive fails. One thread at a time.
+class ZipWriter {
+public:
+    ZipWriter() = default;
+    ~ZipWriter();
+
+    ZipWriter(const ZipWriter&) = delete;
+    ZipWriter& operator=(const ZipWriter&) = delete;
+
+    // Relative, '/'-separated, without empty, "." or ".." parts: what every
+    // unzip extracts inside the folder it was asked to
+    static bool IsEntryName(const std::string& name);
+
+    bool Open(const std::string& path, std::string* error);
+
+    // |name| is the path inside the archive: relative, '/'-separated
+    bool Add(const std::string& name, const uint8_t* data, size_t size, std::string* error);
+
+    // The file at |path| copied in |kCopyBytes| reads, calling |copied|
+    // with the bytes done so far after each; polls |cancel| between reads
+    using CopyProgressFn = std::function<void(uint64_t bytes)>;
+    bool AddFile(const std::string& name, const std::string& path, const std::atomic<bool>& cancel,
+                 const CopyProgressFn& copied, std::string* error);
+
+    // The central directory; closes the file. False if any write failed.
+    bool Finish(std::string* error);
+
+    uint64_t Bytes() const { return offset_; }
+    size_t EntryCount() const { return entries_.size(); }
+
+    static constexpr size_t kCopyBytes = 256 * 1024;
+
+private:
+    struct Entry {
+        std::string name;
+        uint32_t crc = 0;
+        uint32_t size = 0;
+        uint32_t offset = 0;  // of the local header
+    };
+
+    bool Begin(const std::string& name, std::string* error);
+    bool Write(const uint8_t* data, size_t size, std::string* error);
+    // The data descriptor for the entry Begin() started, of |size| bytes
+    bool End(uint32_t crc, uint64_t size, std::string* error);
+
+    FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    uint16_t dos_time_ = 0;
+    uint16_t dos_date_ = 0;
+    std::vector<Entry> entries_;
+    std::vector<uint8_t> buffer_;
+};
+
+} // namespace kakarot
@@ -0,0 +1,517 @@
+// Echo cancellation quality and cost of every AEC preset on a reference
+// corpus: how much echo each removes (ERLE), what it does to the near-end
+// talker (signal-to-distortion ratio and level loss) and the CPU it takes
+// per 10ms frame, in one table, so presets are picked on numbers and a
+// regression shows up in the next run.
+//
+//   aec_quality [--preset aggressive|default|lowCpu|headphones]
+//               [--scene NAME] [--corpus DIR] [--json]
+//
+// Built by binding.gyp as the aec_quality target (build/Release/aec_quality).
+// The built-in scenes are synthetic and deterministic, at the addon's 48kHz:
+// single talk, double talk, music on the far end and a Bluetooth-sized
+// 220ms output delay, all through the same simulated room. Because the
+// near-end and echo components are known apart, ERLE is taken over
+// echo-only frames and distortion over near-end frames, both after the
+// first seconds of convergence. --corpus adds recorded cases, each a
+// <name>.render.wav and <name>.capture.wav (16-bit mono, same rate) and,
+// for the near-end metrics, the clean <name>.near.wav; without it ERLE
+// covers every frame.
+
+#include "aec_processor.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "common_audio/wav_file.h"
+#include "rtc_base/system/file_wrapper.h"
+#include <dirent.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace kakarot;
+
+static constexpr int kFrameMs = 10;
+static constexpr int kSceneRate = 48000;
+static constexpr double kSceneSeconds = 20.0;
+
+// Metrics skip the first seconds while the filters converge
+static constexpr double kConvergenceMs = 3000.0;
+
+// A frame counts as carrying a component above this RMS (-50dBFS)
+static constexpr double kActiveRms = 0.00316;
+
+// A frame's SDR is clamped to this range before averaging, so one silent or
+// perfect frame does not dominate
+static constexpr double kMinFrameSdrDb = -10.0;
+static constexpr double kMaxFrameSdrDb = 35.0;
+
+static const struct {
+    const char* name;
+    AECPreset preset;
+} kPresets[] = {
+    { "aggressive", AECPreset::kAggressive },
+    { "default", AECPreset::kDefault },
+    { "lowCpu", AECPreset::kLowCpu },
+    { "headphones", AECPreset::kHeadphones },
+};
+
+struct Options {
+    std::string preset;  // empty = every preset
+    std::string scene;   // empty = every scene
+    std::string corpus;
+    bool json = false;
+};
+
+static void Usage() {
+    std::fprintf(stderr,
+                 "usage: aec_quality [--preset aggressive|default|lowCpu|headphones]\n"
+                 "                   [--scene NAME] [--corpus DIR] [--json]\n");
+}
+
+static bool ParseArgs(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            options->json = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--preset") {
+            bool found = false;
+            for (const auto& entry : kPresets) {
+                found = found || std::strcmp(value, entry.name) == 0;
+            }
+            if (!found) {
+                std::fprintf(stderr, "unknown preset: %s\n", value);
+                return false;
+            }
+            options->preset = value;
+        } else if (arg == "--scene") {
+            options->scene = value;
+        } else if (arg == "--corpus") {
+            options->corpus = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Native log records go to stderr; nothing else drains the ring here
+static void FlushLog() {
+    LogRecord records[16];
+    size_t count;
+    while ((count = NativeLogRing().Read(records, 16)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            std::fprintf(stderr, "[%s] %s\n", records[i].source, records[i].message);
+        }
+    }
+}
+
+static double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// ---------------------------------------------------------------------------
+// Corpus
+
+// One render/capture pair. |near| and |echo| are the capture's components
+// when they are known (the built-in scenes), else empty.
+struct Scene {
+    std::string name;
+    int sample_rate = kSceneRate;
+    std::vector<float> render;
+    std::vector<float> capture;
+    std::vector<float> near;
+    std::vector<float> echo;
+};
+
+class Random {
+public:
+    explicit Random(uint32_t seed) : state_(seed * 2654435761u + 1u) {}
+
+    // Uniform in [-1, 1)
+    float Next() {
+        state_ = state_ * 1664525u + 1013904223u;
+        return static_cast<float>(static_cast<int32_t>(state_)) / 2147483648.0f;
+    }
+
+private:
+    uint32_t state_;
+};
+
+// Voiced speech stand-in: harmonics of a wandering pitch under a syllable
+// envelope, in phrases of |talk_s| out of every |cycle_s|, plus some
+// fricative noise
+static std::vector<float> Talker(uint32_t seed, double f0, double cycle_s, double talk_s, double offset_s,
+                                 size_t length) {
+    std::vector<float> out(length);
+    Random random(seed);
+    double phase = 0.0;
+    for (size_t i = 0; i < length; ++i) {
+        double t = static_cast<double>(i) / kSceneRate;
+        if (std::fmod(t + offset_s, cycle_s) >= talk_s) {
+            continue;
+        }
+        double syllable = std::sqrt(std::max(0.0, std::sin(2.0 * M_PI * 4.3 * t + seed)));
+        double pitch = f0 * (1.0 + 0.1 * std::sin(2.0 * M_PI * 0.7 * t + seed));
+        phase += 2.0 * M_PI * pitch / kSceneRate;
+        double voiced = 0.0;
+        for (int k = 1; k <= 12; ++k) {
+            voiced += std::sin(k * phase) / k;
+        }
+        out[i] = static_cast<float>(syllable * (0.12 * voiced + 0.03 * random.Next()));
+    }
+    return out;
+}
+
+// A chord progression with a kick drum, no pauses: the far end the echo
+// canceller finds hardest to tell from a talker
+static std::vector<float> Music(size_t length) {
+    static const double kChords[][3] = {
+        { 261.63, 329.63, 392.00 },  // C
+        { 220.00, 261.63, 329.63 },  // Am
+        { 174.61, 220.00, 261.63 },  // F
+        { 196.00, 246.94, 293.66 },  // G
+    };
+    std::vector<float> out(length);
+    for (size_t i = 0; i < length; ++i) {
+        double t = static_cast<double>(i) / kSceneRate;
+        const double* chord = kChords[static_cast<size_t>(t / 2.0) % 4];
+        double value = 0.0;
+        for (int note = 0; note < 3; ++note) {
+            for (int k = 1; k <= 6; ++k) {
+                value += std::sin(2.0 * M_PI * chord[note] * k * t) / (k * k);
+            }
+        }
+        double beat = std::fmod(t, 0.5);
+        double kick = std::exp(-beat * 30.0) * std::sin(2.0 * M_PI * 55.0 * beat);
+        out[i] = static_cast<float>(0.06 * value + 0.25 * kick);
+    }
+    return out;
+}
+
+// The loudspeaker-to-mic path: |delay_ms| of output latency and flight,
+// then a direct path and reflections decaying over ~120ms
+static std::vector<float> Room(const std::vector<float>& far, double delay_ms, uint32_t seed) {
+    struct Tap {
+        size_t delay;
+        float gain;
+    };
+    Random random(seed);
+    std::vector<Tap> taps;
+    size_t base = static_cast<size_t>(delay_ms * kSceneRate / 1000.0);
+    taps.push_back({ base, 0.35f });
+    for (int i = 0; i < 24; ++i) {
+        double after_ms = 2.0 + (random.Next() + 1.0) * 60.0;
+        float gain = static_cast<float>(0.12 * std::exp(-after_ms / 40.0)) * random.Next();
+        taps.push_back({ base + static_cast<size_t>(after_ms * kSceneRate / 1000.0), gain });
+    }
+    std::vector<float> echo(far.size());
+    for (const Tap& tap : taps) {
+        for (size_t i = tap.delay; i < far.size(); ++i) {
+            echo[i] += tap.gain * far[i - tap.delay];
+        }
+    }
+    return echo;
+}
+
+static Scene MakeScene(const char* name, std::vector<float> far, std::vector<float> near, double delay_ms) {
+    Scene scene;
+    scene.name = name;
+    scene.echo = Room(far, delay_ms, 7);
+    scene.render = std::move(far);
+    scene.near = std::move(near);
+    scene.capture.resize(scene.render.size());
+    Random noise(11);
+    for (size_t i = 0; i < scene.capture.size(); ++i) {
+        // A -60dBFS room noise floor under everything
+        scene.capture[i] = scene.echo[i] + scene.near[i] + 0.001f * noise.Next();
+    }
+    return scene;
+}
+
+static std::vector<Scene> BuiltInScenes() {
+    const size_t length = static_cast<size_t>(kSceneSeconds * kSceneRate);
+    std::vector<float> silence(length, 0.0f);
+    std::vector<Scene> scenes;
+    // Only the far end talks
+    scenes.push_back(MakeScene("single_talk", Talker(1, 120.0, 6.0, 4.0, 0.0, length), silence, 15.0));
+    // Turns that overlap for about a second each time
+    scenes.push_back(MakeScene("double_talk", Talker(1, 120.0, 6.0, 3.5, 0.0, length),
+                               Talker(2, 210.0, 6.0, 3.5, 2.5, length), 15.0));
+    // Music playing while the near end talks in phrases
+    scenes.push_back(MakeScene("music", Music(length), Talker(2, 210.0, 5.0, 2.5, 0.0, length), 15.0));
+    // Headset-free Bluetooth speaker: the echo comes back 220ms late
+    scenes.push_back(MakeScene("bluetooth_delay", Talker(1, 120.0, 6.0, 3.5, 0.0, length),
+                               Talker(2, 210.0, 6.0, 3.5, 2.5, length), 220.0));
+    return scenes;
+}
+
+// WavReader RTC_CHECKs on open failures; opening the FILE here turns those
+// into an error message
+static bool ReadWav(const std::string& path, int* sample_rate, std::vector<float>* samples) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    webrtc::WavReader reader{webrtc::FileWrapper(file)};
+    if (reader.num_channels() != 1) {
+        std::fprintf(stderr, "%s: need mono\n", path.c_str());
+        return false;
+    }
+    *sample_rate = reader.sample_rate();
+    samples->resize(reader.num_samples());
+    samples->resize(reader.ReadSamples(samples->size(), samples->data()));
+    // WAV floats are in [-32768, 32767]; the processor works in [-1, 1]
+    for (float& sample : *samples) {
+        sample /= 32768.0f;
+    }
+    return true;
+}
+
+static bool LoadCorpus(const std::string& directory, std::vector<Scene>* scenes) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        std::fprintf(stderr, "cannot open %s\n", directory.c_str());
+        return false;
+    }
+    static const std::string kSuffix = ".capture.wav";
+    std::vector<std::string> names;
+    while (dirent* entry = readdir(dir)) {
+        std::string file = entry->d_name;
+        if (file.size() > kSuffix.size() && file.compare(file.size() - kSuffix.size(), kSuffix.size(), kSuffix) == 0) {
+            names.push_back(file.substr(0, file.size() - kSuffix.size()));
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    for (const std::string& name : names) {
+        Scene scene;
+        scene.name = name;
+        std::string base = directory + "/" + name;
+        int render_rate = 0;
+        if (!ReadWav(base + ".capture.wav", &scene.sample_rate, &scene.capture) ||
+            !ReadWav(base + ".render.wav", &render_rate, &scene.render) || render_rate != scene.sample_rate) {
+            std::fprintf(stderr, "%s: need a mono render and capture at the same rate\n", base.c_str());
+            return false;
+        }
+        int near_rate = 0;
+        if (ReadWav(base + ".near.wav", &near_rate, &scene.near) && near_rate == scene.sample_rate) {
+            // The echo is what the capture holds beyond the near end
+            scene.near.resize(scene.capture.size());
+            scene.echo.resize(scene.capture.size());
+            for (size_t i = 0; i < scene.capture.size(); ++i) {
+                scene.echo[i] = scene.capture[i] - scene.near[i];
+            }
+        } else {
+            scene.near.clear();
+        }
+        scene.render.resize(scene.capture.size());
+        scenes->push_back(std::move(scene));
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Measurement
+
+struct Result {
+    std::string scene;
+    const char* preset;
+    double erle_db = NAN;            // echo-only frames: capture power over output power
+    double sdr_db = NAN;             // near-end frames: near over (output - near), mean per frame
+    double near_loss_db = NAN;       // near-only frames: output level below the near end
+    double apm_erle_db = NAN;        // the APM's own estimate at the end
+    double cpu_us_per_frame = 0.0;   // thread CPU
+    double p99_us = 0.0;             // wall time per frame
+};
+
+static double Energy(const float* data, size_t n) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += static_cast<double>(data[i]) * data[i];
+    }
+    return sum;
+}
+
+static bool Active(double energy, size_t n) {
+    return std::sqrt(energy / n) > kActiveRms;
+}
+
+static bool Measure(const Scene& scene, const char* preset_name, AECPreset preset, Result* result) {
+    AECProcessor aec(ApplyPresetDefaults(AECConfig(), preset));
+    if (!aec.Initialize(scene.sample_rate, 1, 1)) {
+        FlushLog();
+        std::fprintf(stderr, "AECProcessor failed to initialize at %d Hz\n", scene.sample_rate);
+        return false;
+    }
+    const size_t frame = static_cast<size_t>(scene.sample_rate) * kFrameMs / 1000;
+    const size_t frames = scene.capture.size() / frame;
+    const size_t latency = aec.OutputLatencySamples();
+    std::vector<float> output(frames * frame + latency);
+    std::vector<double> wall_us;
+    wall_us.reserve(frames);
+
+    uint64_t cpu_start = CurrentThreadCpuNs();
+    for (size_t i = 0; i < frames; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        aec.ProcessRenderAudio(scene.render.data() + i * frame, frame, 1);
+        aec.ProcessCaptureAudio(scene.capture.data() + i * frame, output.data() + i * frame, frame);
+        wall_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    uint64_t cpu_ns = CurrentThreadCpuNs() - cpu_start;
+    AECMetrics metrics = aec.GetMetrics();
+    FlushLog();
+
+    result->scene = scene.name;
+    result->preset = preset_name;
+    result->cpu_us_per_frame = frames > 0 ? cpu_ns / 1000.0 / frames : 0.0;
+    result->p99_us = Percentile(wall_us, 0.99);
+    if (metrics.echo_return_loss_enhancement) {
+        result->apm_erle_db = *metrics.echo_return_loss_enhancement;
+    }
+
+    // Output sample i answers input sample i - latency
+    const float* aligned = output.data() + latency;
+    const size_t first = static_cast<size_t>(kConvergenceMs * scene.sample_rate / 1000.0) / frame;
+    const bool known = !scene.near.empty();
+    double echo_in = 0.0, echo_out = 0.0, near_in = 0.0, near_out = 0.0, sdr_sum = 0.0;
+    size_t sdr_frames = 0;
+    for (size_t i = first; i + 1 < frames; ++i) {
+        size_t at = i * frame;
+        double capture = Energy(scene.capture.data() + at, frame);
+        double out = Energy(aligned + at, frame);
+        if (!known) {
+            echo_in += capture;
+            echo_out += out;
+            continue;
+        }
+        double near = Energy(scene.near.data() + at, frame);
+        double echo = Energy(scene.echo.data() + at, frame);
+        bool near_active = Active(near, frame);
+        bool echo_active = Active(echo, frame);
+        if (echo_active && !near_active) {
+            echo_in += capture;
+            echo_out += out;
+        }
+        if (near_active) {
+            double error = 0.0;
+            for (size_t j = 0; j < frame; ++j) {
+                double diff = static_cast<double>(aligned[at + j]) - scene.near[at + j];
+                error += diff * diff;
+            }
+            double sdr = 10.0 * std::log10(near / std::max(error, 1e-12));
+            sdr_sum += std::max(kMinFrameSdrDb, std::min(sdr, kMaxFrameSdrDb));
+            sdr_frames++;
+            if (!echo_active) {
+                near_in += near;
+                near_out += out;
+            }
+        }
+    }
+    if (echo_in > 0.0) {
+        result->erle_db = 10.0 * std::log10(echo_in / std::max(echo_out, 1e-12));
+    }
+    if (sdr_frames > 0) {
+        result->sdr_db = sdr_sum / sdr_frames;
+    }
+    if (near_in > 0.0) {
+        result->near_loss_db = 10.0 * std::log10(near_in / std::max(near_out, 1e-12));
+    }
+    return true;
+}
+
+static void PrintValue(double value) {
+    if (std::isnan(value)) {
+        std::printf(" %9s", "-");
+    } else {
+        std::printf(" %9.1f", value);
+    }
+}
+
+static void PrintJsonValue(const char* key, double value, bool last) {
+    if (std::isnan(value)) {
+        std::printf("\"%s\": null%s", key, last ? "" : ", ");
+    } else {
+        std::printf("\"%s\": %.2f%s", key, value, last ? "" : ", ");
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, &options)) {
+        Usage();
+        return 2;
+    }
+    // Warnings and errors still reach stderr; per-frame debug chatter does not
+    SetLogLevel(LogLevel::kWarn);
+
+    std::vector<Scene> scenes = BuiltInScenes();
+    if (!options.corpus.empty() && !LoadCorpus(options.corpus, &scenes)) {
+        return 1;
+    }
+
+    std::vector<Result> results;
+    if (!options.json) {
+        std::printf("%-18s %-11s %9s %9s %9s %9s %9s %9s\n", "scene", "preset", "ERLE dB", "SDR dB",
+                    "loss dB", "apm ERLE", "cpu us", "p99 us");
+    }
+    for (const Scene& scene : scenes) {
+        if (!options.scene.empty() && scene.name != options.scene) {
+            continue;
+        }
+        for (const auto& entry : kPresets) {
+            if (!options.preset.empty() && options.preset != entry.name) {
+                continue;
+            }
+            Result result;
+            if (!Measure(scene, entry.name, entry.preset, &result)) {
+                return 1;
+            }
+            results.push_back(result);
+            if (!options.json) {
+                std::printf("%-18s %-11s", result.scene.c_str(), result.preset);
+                PrintValue(result.erle_db);
+                PrintValue(result.sdr_db);
+                PrintValue(result.near_loss_db);
+                PrintValue(result.apm_erle_db);
+                std::printf(" %9.1f %9.1f\n", result.cpu_us_per_frame, result.p99_us);
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    if (options.json) {
+        std::printf("[\n");
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& result = results[i];
+            std::printf("  { \"scene\": \"%s\", \"preset\": \"%s\", ", result.scene.c_str(), result.preset);
+            PrintJsonValue("erleDb", result.erle_db, false);
+            PrintJsonValue("sdrDb", result.sdr_db, false);
+            PrintJsonValue("nearLossDb", result.near_loss_db, false);
+            PrintJsonValue("apmErleDb", result.apm_erle_db, false);
+            PrintJsonValue("cpuUsPerFrame", result.cpu_us_per_frame, false);
+            PrintJsonValue("p99Us", result.p99_us, true);
+            std::printf(" }%s\n", i + 1 < results.size() ? "," : "");
+        }
+        std::printf("]\n");
+    }
+    return 0;
+}
@@ -0,0 +1,245 @@
+// Offline AECProcessor run over a mic WAV and its render (loopback) WAV.
+// Writes the cleaned mic to a WAV and reports real-time factor, per-frame
+// latency percentiles and peak RSS, so presets and regressions can be
+// compared outside Electron.
+//
+//   aec_replay --mic mic.wav --render render.wav --out clean.wav
+//              [--preset aggressive|default|lowCpu|headphones] [--delay-ms N]
+//              [--trace trace.json]
+//
+// Built by binding.gyp as the aec_replay target (build/Release/aec_replay).
+// The mic must be mono; render may be mono or stereo at the same rate
+// (16/32/48kHz). Render shorter than the mic is padded with silence.
+// --trace writes the APM calls as a Chrome trace (chrome://tracing, Perfetto).
+
+#include "aec_processor.h"
+#include "native_log.h"
+#include "pipeline_trace.h"
+#include "common_audio/wav_file.h"
+#include "rtc_base/system/file_wrapper.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace kakarot;
+
+static constexpr int kFrameMs = 10;
+
+struct Options {
+    std::string mic;
+    std::string render;
+    std::string out;
+    std::string trace;
+    AECPreset preset = AECPreset::kAggressive;
+    const char* preset_name = "aggressive";
+    int delay_ms = 0;
+};
+
+static const struct {
+    const char* name;
+    AECPreset preset;
+} kPresets[] = {
+    { "aggressive", AECPreset::kAggressive },
+    { "default", AECPreset::kDefault },
+    { "lowCpu", AECPreset::kLowCpu },
+    { "headphones", AECPreset::kHeadphones },
+};
+
+static void Usage() {
+    std::fprintf(stderr,
+                 "usage: aec_replay --mic mic.wav --render render.wav --out clean.wav\n"
+                 "                  [--preset aggressive|default|lowCpu|headphones] [--delay-ms N]\n"
+                 "                  [--trace trace.json]\n");
+}
+
+static bool ParseArgs(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--mic") {
+            options->mic = value;
+        } else if (arg == "--render") {
+            options->render = value;
+        } else if (arg == "--out") {
+            options->out = value;
+        } else if (arg == "--trace") {
+            options->trace = value;
+        } else if (arg == "--delay-ms") {
+            options->delay_ms = std::max(0, std::atoi(value));
+        } else if (arg == "--preset") {
+            bool found = false;
+            for (const auto& entry : kPresets) {
+                if (std::strcmp(value, entry.name) == 0) {
+                    options->preset = entry.preset;
+                    options->preset_name = entry.name;
+                    found = true;
+                }
+            }
+            if (!found) {
+                std::fprintf(stderr, "unknown preset: %s\n", value);
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return !options->mic.empty() && !options->render.empty() && !options->out.empty();
+}
+
+// WavReader/WavWriter RTC_CHECK on open failures; opening the FILE here
+// turns those into an error message (and keeps std::string_view out of the
+// calls into libwebrtc, which is built against its own libc++)
+static std::unique_ptr<webrtc::WavReader> OpenReader(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", path.c_str());
+        return nullptr;
+    }
+    return std::make_unique<webrtc::WavReader>(webrtc::FileWrapper(file));
+}
+
+// Native log records go to stderr; nothing else drains the ring here
+static void FlushLog() {
+    LogRecord records[16];
+    size_t count;
+    while ((count = NativeLogRing().Read(records, 16)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            std::fprintf(stderr, "[%s] %s\n", records[i].source, records[i].message);
+        }
+    }
+}
+
+// WAV floats are in [-32768, 32767]; the processor works in [-1, 1]
+static void Scale(float* data, size_t n, float gain) {
+    for (size_t i = 0; i < n; ++i) {
+        data[i] *= gain;
+    }
+}
+
+static double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static double PeakRssMb() {
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / (1024.0 * 1024.0);  // bytes
+#else
+    return usage.ru_maxrss / 1024.0;             // kilobytes
+#endif
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, &options)) {
+        Usage();
+        return 2;
+    }
+
+    std::unique_ptr<webrtc::WavReader> mic = OpenReader(options.mic);
+    std::unique_ptr<webrtc::WavReader> render = OpenReader(options.render);
+    if (!mic || !render) {
+        return 1;
+    }
+    int rate = mic->sample_rate();
+    int render_channels = static_cast<int>(render->num_channels());
+    if (mic->num_channels() != 1 || render->sample_rate() != rate || render_channels > 2) {
+        std::fprintf(stderr, "need a mono mic and a mono/stereo render at the same rate (mic %zu ch @ %d Hz, "
+                     "render %d ch @ %d Hz)\n", mic->num_channels(), rate, render_channels, render->sample_rate());
+        return 1;
+    }
+
+    FILE* out_file = std::fopen(options.out.c_str(), "wb");
+    if (!out_file) {
+        std::fprintf(stderr, "cannot create %s\n", options.out.c_str());
+        return 1;
+    }
+    webrtc::WavWriter out(webrtc::FileWrapper(out_file), rate, 1);
+
+    AECProcessor aec(ApplyPresetDefaults(AECConfig(), options.preset));
+    if (!aec.Initialize(rate, 1, render_channels)) {
+        FlushLog();
+        std::fprintf(stderr, "AECProcessor failed to initialize\n");
+        return 1;
+    }
+    aec.SetStreamDelayMs(options.delay_ms);
+    if (!options.trace.empty() && !StartPipelineTrace(TraceOutput::kChromeJson, options.trace.c_str())) {
+        FlushLog();
+        return 1;
+    }
+    FlushLog();
+
+    size_t frame = static_cast<size_t>(rate) * kFrameMs / 1000;
+    std::vector<float> mic_frame(frame);
+    std::vector<float> render_frame(frame * render_channels);
+    std::vector<float> clean(frame);
+    std::vector<double> latencies_us;
+    latencies_us.reserve(mic->num_samples() / frame + 1);
+
+    // Output runs one frame behind input: the first frame out is dropped and
+    // one frame of silence at the end flushes the last real one
+    size_t frames_in = 0;
+    double busy_s = 0.0;
+    for (;;) {
+        size_t got = mic->ReadSamples(frame, mic_frame.data());
+        bool flush = got == 0;
+        std::fill(mic_frame.begin() + got, mic_frame.end(), 0.0f);
+        size_t render_got = flush ? 0 : render->ReadSamples(render_frame.size(), render_frame.data());
+        std::fill(render_frame.begin() + render_got, render_frame.end(), 0.0f);
+        Scale(mic_frame.data(), frame, 1.0f / 32768.0f);
+        Scale(render_frame.data(), render_frame.size(), 1.0f / 32768.0f);
+
+        auto start = std::chrono::steady_clock::now();
+        aec.ProcessRenderAudio(render_frame.data(), frame, render_channels);
+        aec.ProcessCaptureAudio(mic_frame.data(), clean.data(), frame);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        busy_s += elapsed.count();
+        latencies_us.push_back(elapsed.count() * 1e6);
+
+        if (frames_in++ > 0) {
+            // Trim the padding of a partial last frame
+            size_t keep = std::min(frame, mic->num_samples() - out.num_samples());
+            Scale(clean.data(), keep, 32768.0f);
+            out.WriteSamples(clean.data(), keep);
+        }
+        if (flush) {
+            break;
+        }
+    }
+    StopPipelineTrace();
+    FlushLog();
+
+    double audio_s = static_cast<double>(out.num_samples()) / rate;
+    AECMetrics metrics = aec.GetMetrics();
+    std::printf("preset %s, %d Hz, %d render channel(s), %zu frames (%.1f s of audio)\n",
+                options.preset_name, rate, render_channels, latencies_us.size(), audio_s);
+    std::printf("real-time factor  %.4f  (%.1fx faster than real time)\n",
+                audio_s > 0.0 ? busy_s / audio_s : 0.0, busy_s > 0.0 ? audio_s / busy_s : 0.0);
+    std::printf("frame latency us  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+                Percentile(latencies_us, 0.50), Percentile(latencies_us, 0.90),
+                Percentile(latencies_us, 0.99), Percentile(latencies_us, 1.0));
+    std::printf("peak RSS          %.1f MB\n", PeakRssMb());
+    if (metrics.echo_return_loss_enhancement) {
+        std::printf("ERLE              %.1f dB%s\n", *metrics.echo_return_loss_enhancement,
+                    metrics.aec_converged ? " (converged)" : "");
+    }
+    if (metrics.delay_median_ms) {
+        std::printf("delay median      %d ms\n", *metrics.delay_median_ms);
+    }
+    return 0;
+}
@@ -0,0 +1,735 @@
+// Microbenchmarks of the native audio hot paths: AECProcessor render/capture
+// at 16/48kHz across the chunk sizes callers actually hand it, per-frame
+// levels, format conversion, resampling and the IOProc-to-consumer ring
+// handoff, the mic engines' input conversion, plus the APM on quiet tails
+// with and without flush-to-zero. Results print as a table, or as JSON in google-benchmark's schema
+// (context + benchmarks[]) so runs from different commits can be diffed with
+// its compare.py or any JSON tooling.
+//
+//   audio_bench [--benchmark_filter=REGEX] [--benchmark_min_time=SECONDS]
+//               [--benchmark_format=console|json] [--benchmark_out=FILE]
+//
+// Built by binding.gyp as the audio_bench target (build/Release/audio_bench).
+// --benchmark_out always writes JSON, whatever the console format.
+
+#include "aec_processor.h"
+#include "dsp_kernels.h"
+#include "level_analyzer.h"
+#include "native_log.h"
+#include "spsc_ring_buffer.h"
+#include "common_audio/include/audio_util.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
+#include "rtc_base/denormal_disabler.h"
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__APPLE__)
+#include <AudioToolbox/AudioToolbox.h>
+#include <dispatch/dispatch.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+using namespace kakarot;
+
+// Chunk sizes seen at the addon boundary: CoreAudio's 128/512-frame buffers,
+// 10ms at 48kHz, a 1024 tap buffer and 100ms JS batches
+static constexpr size_t kChunkSizes[] = { 128, 480, 512, 1024, 4800 };
+static constexpr int kRates[] = { 16000, 48000 };
+
+// Same ring geometry as the addon's capture streams
+static constexpr size_t kRingSamples = 96000;
+static constexpr size_t kRingChunks = 256;
+
+// ---------------------------------------------------------------------------
+// Harness
+
+// Runs |iterations| iterations of the benchmark body
+using Runner = std::function<void(int64_t iterations)>;
+
+struct Benchmark {
+    std::string name;
+    size_t items_per_iteration;  // samples (frames for multichannel input)
+    int sample_rate;             // 0 when the items are not audio at a fixed rate
+    std::function<Runner()> setup;  // allocations and warm-up, outside the timing
+};
+
+struct Result {
+    std::string name;
+    int64_t iterations;
+    double real_ns;  // per iteration
+    double cpu_ns;
+    double items_per_second;
+    double real_time_factor;  // processing time / audio duration; 0 if n/a
+};
+
+static std::vector<Benchmark>& Registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+static void Register(std::string name, size_t items, int sample_rate, std::function<Runner()> setup) {
+    Registry().push_back(Benchmark{std::move(name), items, sample_rate, std::move(setup)});
+}
+
+static double CpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Grows the iteration count until one batch runs for at least |min_time_s|,
+// the way google-benchmark does, then reports that batch
+static Result RunBenchmark(const Benchmark& benchmark, double min_time_s) {
+    Runner run = benchmark.setup();
+    run(1);
+
+    int64_t iterations = 1;
+    for (;;) {
+        double cpu_start = CpuSeconds();
+        auto start = std::chrono::steady_clock::now();
+        run(iterations);
+        std::chrono::duration<double> real = std::chrono::steady_clock::now() - start;
+        double cpu = CpuSeconds() - cpu_start;
+
+        if (real.count() >= min_time_s || iterations >= (int64_t{1} << 40)) {
+            Result result;
+            result.name = benchmark.name;
+            result.iterations = iterations;
+            result.real_ns = real.count() * 1e9 / iterations;
+            result.cpu_ns = cpu * 1e9 / iterations;
+            result.items_per_second = benchmark.items_per_iteration * iterations / real.count();
+            result.real_time_factor = benchmark.sample_rate > 0
+                ? result.real_ns * 1e-9 / (static_cast<double>(benchmark.items_per_iteration) / benchmark.sample_rate)
+                : 0.0;
+            return result;
+        }
+        // Aim 40% past the target so the next batch is usually the last
+        double scale = real.count() > 0.0 ? 1.4 * min_time_s / real.count() : 10.0;
+        iterations = std::max(iterations + 1, static_cast<int64_t>(iterations * std::min(scale, 10.0)));
+    }
+}
+
+static void WriteJson(FILE* out, const std::vector<Result>& results, const char* executable) {
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    char date[64] = "";
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+    std::fprintf(out, "{\n  \"context\": {\n");
+    std::fprintf(out, "    \"date\": \"%s\",\n", date);
+    std::fprintf(out, "    \"host_name\": \"%s\",\n", host);
+    std::fprintf(out, "    \"executable\": \"%s\",\n", executable);
+    std::fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#if defined(__OPTIMIZE__)
+    std::fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+    std::fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+    std::fprintf(out, "  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(out,
+                     "    {\n"
+                     "      \"name\": \"%s\",\n"
+                     "      \"run_name\": \"%s\",\n"
+                     "      \"run_type\": \"iteration\",\n"
+                     "      \"repetitions\": 1,\n"
+                     "      \"repetition_index\": 0,\n"
+                     "      \"threads\": 1,\n"
+                     "      \"iterations\": %lld,\n"
+                     "      \"real_time\": %.3f,\n"
+                     "      \"cpu_time\": %.3f,\n"
+                     "      \"time_unit\": \"ns\",\n"
+                     "      \"items_per_second\": %.6e",
+                     r.name.c_str(), r.name.c_str(), static_cast<long long>(r.iterations),
+                     r.real_ns, r.cpu_ns, r.items_per_second);
+        if (r.real_time_factor > 0.0) {
+            std::fprintf(out, ",\n      \"real_time_factor\": %.6e", r.real_time_factor);
+        }
+        std::fprintf(out, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+static void PrintRow(const Result& r) {
+    std::printf("%-40s %12.1f %12.1f %12lld %12.3fM/s", r.name.c_str(), r.real_ns, r.cpu_ns,
+                static_cast<long long>(r.iterations), r.items_per_second * 1e-6);
+    if (r.real_time_factor > 0.0) {
+        std::printf("   rtf %.5f", r.real_time_factor);
+    }
+    std::printf("\n");
+}
+
+// ---------------------------------------------------------------------------
+// Signals
+
+// Deterministic white noise in [-amplitude, amplitude]
+static std::vector<float> Noise(size_t n, float amplitude, uint32_t seed) {
+    std::vector<float> out(n);
+    for (float& v : out) {
+        seed = seed * 1664525u + 1013904223u;
+        v = amplitude * (static_cast<float>(seed >> 8) / 8388608.0f - 1.0f);
+    }
+    return out;
+}
+
+// One second of far-end noise and a mic carrying its 20ms-delayed echo plus
+// near-end noise, so the canceller has real work to do
+struct EchoSignals {
+    std::vector<float> render;
+    std::vector<float> mic;
+};
+
+static EchoSignals MakeEchoSignals(int sample_rate) {
+    size_t n = static_cast<size_t>(sample_rate);
+    size_t delay = n / 50;
+    EchoSignals signals;
+    signals.render = Noise(n, 0.3f, 1);
+    signals.mic = Noise(n, 0.01f, 2);
+    for (size_t i = delay; i < n; ++i) {
+        signals.mic[i] += 0.5f * signals.render[i - delay];
+    }
+    return signals;
+}
+
+// Native log records go to stderr; nothing else drains the ring here
+static void FlushLog() {
+    LogRecord records[16];
+    size_t count;
+    while ((count = NativeLogRing().Read(records, 16)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            std::fprintf(stderr, "[%s] %s\n", records[i].source, records[i].message);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AECProcessor
+
+// Chunks walk through the one-second signals; the offset wraps on a whole
+// chunk so every call sees |chunk| contiguous samples
+struct AecState {
+    AECProcessor aec{ApplyPresetDefaults(AECConfig(), AECPreset::kAggressive)};
+    EchoSignals signals;
+    std::vector<float> out;
+    size_t offset = 0;
+};
+
+static std::shared_ptr<AecState> MakeAec(int sample_rate, size_t chunk) {
+    auto state = std::make_shared<AecState>();
+    if (!state->aec.Initialize(sample_rate, 1, 1)) {
+        std::fprintf(stderr, "AECProcessor failed to initialize at %d Hz\n", sample_rate);
+        std::exit(1);
+    }
+    FlushLog();
+    state->signals = MakeEchoSignals(sample_rate);
+    state->out.resize(chunk);
+    return state;
+}
+
+static void RegisterAec() {
+    for (int rate : kRates) {
+        for (size_t chunk : kChunkSizes) {
+            std::string suffix = "/" + std::to_string(rate) + "/" + std::to_string(chunk);
+
+            // Render alone: downmix, framing and the APM's render analysis
+            Register("AEC/ProcessRender" + suffix, chunk, rate, [rate, chunk] {
+                auto state = MakeAec(rate, chunk);
+                return Runner([state, chunk](int64_t iterations) {
+                    for (int64_t i = 0; i < iterations; ++i) {
+                        if (state->offset + chunk > state->signals.render.size()) {
+                            state->offset = 0;
+                        }
+                        state->aec.ProcessRenderAudio(state->signals.render.data() + state->offset, chunk, 1);
+                        state->offset += chunk;
+                    }
+                });
+            });
+
+            // Render then capture, as the pipeline runs them. Capture is only
+            // meaningful with render flowing, so its cost is this minus the
+            // render-only number.
+            Register("AEC/ProcessRenderCapture" + suffix, chunk, rate, [rate, chunk] {
+                auto state = MakeAec(rate, chunk);
+                return Runner([state, chunk](int64_t iterations) {
+                    for (int64_t i = 0; i < iterations; ++i) {
+                        if (state->offset + chunk > state->signals.render.size()) {
+                            state->offset = 0;
+                        }
+                        state->aec.ProcessRenderAudio(state->signals.render.data() + state->offset, chunk, 1);
+                        state->aec.ProcessCaptureAudio(state->signals.mic.data() + state->offset,
+                                                       state->out.data(), chunk);
+                        state->offset += chunk;
+                    }
+                });
+            });
+        }
+    }
+}
+
+// Quiet tails: each second is a 10ms burst of echo and then digital silence,
+// which walks the filter states down through the denormal range. The
+// Denormals variant runs with the FP state the JS thread has by default,
+// FlushToZero as the addon's DSP threads and entry points run.
+static void RegisterQuietTail() {
+    constexpr size_t kChunk = 480;
+    for (int rate : kRates) {
+        for (bool flush : { false, true }) {
+            std::string name = std::string("AEC/QuietTail/") + (flush ? "FlushToZero/" : "Denormals/") +
+                               std::to_string(rate) + "/" + std::to_string(kChunk);
+            Register(name, kChunk, rate, [rate, flush] {
+                auto state = MakeAec(rate, kChunk);
+                size_t burst = static_cast<size_t>(rate / 100);
+                std::fill(state->signals.render.begin() + burst, state->signals.render.end(), 0.0f);
+                std::fill(state->signals.mic.begin() + burst, state->signals.mic.end(), 0.0f);
+                return Runner([state, flush](int64_t iterations) {
+                    webrtc::DenormalDisabler denormals(flush);
+                    for (int64_t i = 0; i < iterations; ++i) {
+                        if (state->offset + kChunk > state->signals.render.size()) {
+                            state->offset = 0;
+                        }
+                        state->aec.ProcessRenderAudio(state->signals.render.data() + state->offset, kChunk, 1);
+                        state->aec.ProcessCaptureAudio(state->signals.mic.data() + state->offset,
+                                                       state->out.data(), kChunk);
+                        state->offset += kChunk;
+                    }
+                });
+            });
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Levels (the per-frame rms/peak/noise-floor metrics behind the levels option)
+
+static void RegisterLevels() {
+    for (int rate : kRates) {
+        for (size_t chunk : kChunkSizes) {
+            std::string name = "Levels/Process/" + std::to_string(rate) + "/" + std::to_string(chunk);
+            Register(name, chunk, rate, [rate, chunk] {
+                auto analyzer = std::make_shared<LevelAnalyzer>(static_cast<size_t>(rate / 100));
+                auto data = std::make_shared<std::vector<float>>(Noise(chunk, 0.1f, 3));
+                auto packed = std::make_shared<std::vector<float>>();
+                packed->reserve((chunk / (rate / 100) + 1) * kLevelFields);
+                return Runner([analyzer, data, packed, chunk](int64_t iterations) {
+                    for (int64_t i = 0; i < iterations; ++i) {
+                        packed->clear();
+                        analyzer->Process(data->data(), chunk, packed.get());
+                    }
+                });
+            });
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Format conversion: pcm16 delivery, s16le render input, stereo render downmix
+
+static void RegisterConversion() {
+    for (size_t chunk : kChunkSizes) {
+        std::string suffix = "/" + std::to_string(chunk);
+
+        Register("Convert/FloatToS16" + suffix, chunk, 0, [chunk] {
+            auto src = std::make_shared<std::vector<float>>(Noise(chunk, 0.5f, 4));
+            auto dst = std::make_shared<std::vector<int16_t>>(chunk);
+            return Runner([src, dst, chunk](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    webrtc::FloatToS16(src->data(), chunk, dst->data());
+                }
+            });
+        });
+
+        Register("Convert/DownmixS16Stereo" + suffix, chunk, 0, [chunk] {
+            auto src = std::make_shared<std::vector<int16_t>>(chunk * 2);
+            std::vector<float> noise = Noise(chunk * 2, 0.5f, 5);
+            webrtc::FloatToS16(noise.data(), noise.size(), src->data());
+            auto dst = std::make_shared<std::vector<float>>(chunk);
+            return Runner([src, dst, chunk](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    dsp::DownmixS16(src->data(), chunk, 2, dst->data());
+                }
+            });
+        });
+
+        Register("Convert/DownmixStereo" + suffix, chunk, 0, [chunk] {
+            auto src = std::make_shared<std::vector<float>>(Noise(chunk * 2, 0.5f, 6));
+            auto dst = std::make_shared<std::vector<float>>(chunk);
+            return Runner([src, dst, chunk](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    dsp::Downmix(src->data(), chunk, 2, dst->data());
+                }
+            });
+        });
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Resampling: one 10ms block per iteration, as CaptureStream feeds it
+
+static void RegisterResampling() {
+    static constexpr struct {
+        int from;
+        int to;
+    } kConversions[] = {
+        { 48000, 16000 },
+        { 44100, 16000 },
+        { 16000, 48000 },
+        { 44100, 48000 },
+    };
+    for (const auto& conversion : kConversions) {
+        int from = conversion.from;
+        int to = conversion.to;
+        size_t source_frames = static_cast<size_t>(from / 100);
+        std::string name = "Resample/PushSinc/" + std::to_string(from) + "to" + std::to_string(to);
+        Register(name, source_frames, from, [from, to, source_frames] {
+            size_t destination_frames = static_cast<size_t>(to / 100);
+            auto resampler = std::make_shared<webrtc::PushSincResampler>(source_frames, destination_frames);
+            auto src = std::make_shared<std::vector<float>>(Noise(source_frames, 0.5f, 7));
+            auto dst = std::make_shared<std::vector<float>>(destination_frames);
+            return Runner([resampler, src, dst, source_frames](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    resampler->Resample(src->data(), source_frames, dst->data(), dst->size());
+                }
+            });
+        });
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Mic input conversion, one 10ms stereo device buffer to mono at the
+// transcription or AEC rate per iteration: the 'hal' engine's Downmix and
+// PushSincResampler, and on macOS the AudioConverter the 'auhal' engine's
+// AUHAL runs in its input element
+
+static constexpr struct {
+    int from;
+    int to;
+} kEngineConversions[] = {
+    { 48000, 16000 },
+    { 44100, 16000 },
+    { 44100, 48000 },
+};
+
+#if defined(__APPLE__)
+struct ConverterState {
+    AudioConverterRef converter = nullptr;
+    std::vector<float> input;  // interleaved stereo
+    std::vector<float> output;
+    UInt32 input_frames = 0;
+    ~ConverterState() {
+        if (converter) {
+            AudioConverterDispose(converter);
+        }
+    }
+};
+
+static AudioStreamBasicDescription FloatFormat(double sample_rate, UInt32 channels) {
+    AudioStreamBasicDescription format = {};
+    format.mSampleRate = sample_rate;
+    format.mFormatID = kAudioFormatLinearPCM;
+    format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked;
+    format.mBytesPerPacket = sizeof(float) * channels;
+    format.mFramesPerPacket = 1;
+    format.mBytesPerFrame = sizeof(float) * channels;
+    format.mChannelsPerFrame = channels;
+    format.mBitsPerChannel = 32;
+    return format;
+}
+
+// Hands the same device buffer over on every pull
+static OSStatus SupplyDeviceBuffer(AudioConverterRef, UInt32* packets, AudioBufferList* data,
+                                   AudioStreamPacketDescription**, void* user_data) {
+    ConverterState* state = static_cast<ConverterState*>(user_data);
+    *packets = std::min(*packets, state->input_frames);
+    data->mNumberBuffers = 1;
+    data->mBuffers[0].mNumberChannels = 2;
+    data->mBuffers[0].mData = state->input.data();
+    data->mBuffers[0].mDataByteSize = *packets * 2 * sizeof(float);
+    return noErr;
+}
+#endif
+
+static void RegisterEngineConversion() {
+    for (const auto& conversion : kEngineConversions) {
+        int from = conversion.from;
+        int to = conversion.to;
+        size_t source_frames = static_cast<size_t>(from / 100);
+        size_t destination_frames = static_cast<size_t>(to / 100);
+        std::string suffix = "/" + std::to_string(from) + "to" + std::to_string(to);
+
+        Register("MicEngine/Hal" + suffix, source_frames, from, [source_frames, destination_frames] {
+            auto resampler = std::make_shared<webrtc::PushSincResampler>(source_frames, destination_frames);
+            auto src = std::make_shared<std::vector<float>>(Noise(source_frames * 2, 0.5f, 9));
+            auto mono = std::make_shared<std::vector<float>>(source_frames);
+            auto dst = std::make_shared<std::vector<float>>(destination_frames);
+            return Runner([resampler, src, mono, dst, source_frames](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    dsp::Downmix(src->data(), source_frames, 2, mono->data());
+                    resampler->Resample(mono->data(), source_frames, dst->data(), dst->size());
+                }
+            });
+        });
+
+#if defined(__APPLE__)
+        Register("MicEngine/Auhal" + suffix, source_frames, from, [from, to, source_frames, destination_frames] {
+            auto state = std::make_shared<ConverterState>();
+            AudioStreamBasicDescription in = FloatFormat(from, 2);
+            AudioStreamBasicDescription out = FloatFormat(to, 1);
+            if (AudioConverterNew(&in, &out, &state->converter) != noErr) {
+                std::fprintf(stderr, "AudioConverterNew failed\n");
+                std::exit(1);
+            }
+            state->input = Noise(source_frames * 2, 0.5f, 9);
+            state->output.resize(destination_frames);
+            state->input_frames = static_cast<UInt32>(source_frames);
+            return Runner([state, destination_frames](int64_t iterations) {
+                for (int64_t i = 0; i < iterations; ++i) {
+                    UInt32 packets = static_cast<UInt32>(destination_frames);
+                    AudioBufferList list;
+                    list.mNumberBuffers = 1;
+                    list.mBuffers[0].mNumberChannels = 1;
+                    list.mBuffers[0].mData = state->output.data();
+                    list.mBuffers[0].mDataByteSize = packets * sizeof(float);
+                    AudioConverterFillComplexBuffer(state->converter, &SupplyDeviceBuffer, state.get(), &packets,
+                                                    &list, nullptr);
+                }
+            });
+        });
+#endif
+    }
+}
+
+// ---------------------------------------------------------------------------
+// IOProc-to-consumer handoff: CaptureStream::PushFromRealtime's two ring
+// writes plus a semaphore signal on one thread, the consumer's wait and
+// reads on another
+
+class Semaphore {
+public:
+#if defined(__APPLE__)
+    Semaphore() : semaphore_(dispatch_semaphore_create(0)) {}
+    ~Semaphore() { dispatch_release(semaphore_); }
+    void Signal() { dispatch_semaphore_signal(semaphore_); }
+    void Wait() { dispatch_semaphore_wait(semaphore_, DISPATCH_TIME_FOREVER); }
+
+private:
+    dispatch_semaphore_t semaphore_;
+#else
+    void Signal() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++count_;
+        cv_.notify_one();
+    }
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return count_ > 0; });
+        --count_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int count_ = 0;
+#endif
+};
+
+struct ChunkInfo {
+    uint64_t host_time;
+    uint64_t sample_index;
+    uint32_t num_samples;
+};
+
+struct HandoffState {
+    SpscRingBuffer<float> ring{kRingSamples};
+    SpscRingBuffer<ChunkInfo> chunk_ring{kRingChunks};
+    Semaphore signal;
+    std::vector<float> input;
+    std::vector<float> output;
+};
+
+static std::shared_ptr<HandoffState> MakeHandoff(size_t chunk) {
+    auto state = std::make_shared<HandoffState>();
+    state->input = Noise(chunk, 0.1f, 8);
+    state->output.resize(chunk);
+    return state;
+}
+
+// Producer side of one buffer; false when either ring is full
+static bool Push(HandoffState* state, uint64_t index) {
+    uint32_t n = static_cast<uint32_t>(state->input.size());
+    if (state->ring.AvailableToWrite() < n || state->chunk_ring.AvailableToWrite() < 1) {
+        return false;
+    }
+    ChunkInfo info{index, index * n, n};
+    state->ring.Write(state->input.data(), n);
+    state->chunk_ring.Write(&info, 1);
+    state->signal.Signal();
+    return true;
+}
+
+// Drains until |count| buffers have been read
+static void Consume(HandoffState* state, int64_t count) {
+    int64_t received = 0;
+    while (received < count) {
+        state->signal.Wait();
+        ChunkInfo info;
+        while (state->chunk_ring.Read(&info, 1) == 1) {
+            state->ring.Read(state->output.data(), info.num_samples);
+            ++received;
+        }
+    }
+}
+
+static void RegisterHandoff() {
+    for (size_t chunk : kChunkSizes) {
+        std::string suffix = "/" + std::to_string(chunk);
+
+        // Buffers pushed back to back: the consumer's sustained drain rate
+        Register("Handoff/Throughput" + suffix, chunk, 0, [chunk] {
+            auto state = MakeHandoff(chunk);
+            return Runner([state](int64_t iterations) {
+                std::thread producer([&] {
+                    for (int64_t i = 0; i < iterations; ++i) {
+                        while (!Push(state.get(), static_cast<uint64_t>(i))) {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+                Consume(state.get(), iterations);
+                producer.join();
+            });
+        });
+
+        // One buffer in flight at a time, as when the IOProc is paced by the
+        // hardware and the consumer is asleep on each arrival: push, wake,
+        // read, and the acknowledgement back
+        Register("Handoff/Latency" + suffix, chunk, 0, [chunk] {
+            auto state = MakeHandoff(chunk);
+            auto ack = std::make_shared<Semaphore>();
+            return Runner([state, ack](int64_t iterations) {
+                std::thread consumer([&] {
+                    for (int64_t i = 0; i < iterations; ++i) {
+                        Consume(state.get(), 1);
+                        ack->Signal();
+                    }
+                });
+                for (int64_t i = 0; i < iterations; ++i) {
+                    Push(state.get(), static_cast<uint64_t>(i));
+                    ack->Wait();
+                }
+                consumer.join();
+            });
+        });
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+struct Options {
+    std::string filter = ".";
+    double min_time_s = 0.5;
+    bool json = false;
+    std::string out;
+};
+
+static bool ParseArgs(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--benchmark_filter") {
+            options->filter = value;
+        } else if (key == "--benchmark_min_time") {
+            // google-benchmark accepts "0.5" or "0.5s"
+            options->min_time_s = std::atof(value.c_str());
+            if (options->min_time_s <= 0.0) {
+                return false;
+            }
+        } else if (key == "--benchmark_format") {
+            if (value != "console" && value != "json") {
+                return false;
+            }
+            options->json = value == "json";
+        } else if (key == "--benchmark_out") {
+            options->out = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, &options)) {
+        std::fprintf(stderr,
+                     "usage: audio_bench [--benchmark_filter=REGEX] [--benchmark_min_time=SECONDS]\n"
+                     "                   [--benchmark_format=console|json] [--benchmark_out=FILE]\n");
+        return 2;
+    }
+    std::regex filter;
+    try {
+        filter = std::regex(options.filter);
+    } catch (const std::regex_error&) {
+        std::fprintf(stderr, "invalid --benchmark_filter: %s\n", options.filter.c_str());
+        return 2;
+    }
+
+    // Warnings and errors still reach stderr; per-frame debug chatter does not
+    SetLogLevel(LogLevel::kWarn);
+
+    RegisterAec();
+    RegisterQuietTail();
+    RegisterLevels();
+    RegisterConversion();
+    RegisterResampling();
+    RegisterEngineConversion();
+    RegisterHandoff();
+
+    if (!options.json) {
+        std::printf("%-40s %12s %12s %12s %14s\n", "benchmark", "real ns", "cpu ns", "iterations", "items");
+    }
+    std::vector<Result> results;
+    for (const Benchmark& benchmark : Registry()) {
+        if (!std::regex_search(benchmark.name, filter)) {
+            continue;
+        }
+        results.push_back(RunBenchmark(benchmark, options.min_time_s));
+        FlushLog();
+        if (!options.json) {
+            PrintRow(results.back());
+            std::fflush(stdout);
+        }
+    }
+
+    if (options.json) {
+        WriteJson(stdout, results, argv[0]);
+    }
+    if (!options.out.empty()) {
+        FILE* file = std::fopen(options.out.c_str(), "w");
+        if (!file) {
+            std::fprintf(stderr, "cannot create %s\n", options.out.c_str());
+            return 1;
+        }
+        WriteJson(file, results, argv[0]);
+        std::fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+// Per-frame cost of the addon's DSP kernels against their scalar loops, and
+// of the fixed-size frame kernels against the runtime-length ones.
+//
+//   SOURCES="tools/dsp_bench.cc src/dsp_kernels.cc src/frame_kernels.cc"
+//   macOS:  clang++ -O2 -std=c++17 -Isrc $SOURCES -framework Accelerate -o build/dsp_bench
+//   other:  c++ -O2 -std=c++17 -Isrc $SOURCES -o build/dsp_bench
+//
+// Build once per architecture (-arch arm64 / -arch x86_64) to compare.
+
+#include "dsp_kernels.h"
+#include "frame_kernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace kakarot;
+
+static constexpr int kIterations = 200000;
+
+static void ScalarSumSquaresAndPeak(const float* data, size_t n, float* sum_squares, float* peak) {
+    float sum = 0.0f;
+    float max = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        float value = std::abs(data[i]);
+        sum += value * value;
+        max = std::max(max, value);
+    }
+    *sum_squares = sum;
+    *peak = max;
+}
+
+static void ScalarMultiplyAdd(const float* src, float gain, float* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] += gain * src[i];
+    }
+}
+
+static void ScalarDownmix(const float* src, size_t frames, int channels, float* dst) {
+    for (size_t i = 0; i < frames; ++i) {
+        float sum = 0.0f;
+        for (int ch = 0; ch < channels; ++ch) {
+            sum += src[i * channels + ch];
+        }
+        dst[i] = sum / channels;
+    }
+}
+
+// Average ns per call; |sink| keeps the optimizer from dropping the work
+template <typename Fn>
+static double TimeNs(Fn fn, volatile float* sink) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        fn();
+        *sink = *sink + 1.0f;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / kIterations;
+}
+
+static void ScalarDownmixS16(const int16_t* src, size_t num_frames, float* dst) {
+    for (size_t i = 0; i < num_frames; ++i) {
+        dst[i] = (src[2 * i] / 32768.0f + src[2 * i + 1] / 32768.0f) * 0.5f;
+    }
+}
+
+static void ScalarComplexMac(const float* a_re, const float* a_im, const float* b_re, const float* b_im,
+                             float* c_re, float* c_im, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        c_re[i] += a_re[i] * b_re[i] - a_im[i] * b_im[i];
+        c_im[i] += a_re[i] * b_im[i] + a_im[i] * b_re[i];
+    }
+}
+
+static void Report(const char* name, double base_ns, double kernel_ns,
+                   const char* base = "scalar", const char* kernel = "kernel") {
+    std::printf("%-28s %s %8.1f ns   %s %8.1f ns   x%.2f\n",
+                name, base, base_ns, kernel, kernel_ns, base_ns / kernel_ns);
+}
+
+int main() {
+#if defined(__aarch64__) || defined(__arm64__)
+    const char* arch = "arm64";
+#elif defined(__x86_64__)
+    const char* arch = "x86_64";
+#else
+    const char* arch = "unknown";
+#endif
+    std::printf("dsp_bench (%s), %d iterations\n", arch, kIterations);
+
+    volatile float sink = 0.0f;
+    for (size_t frame : {160, 480}) {
+        // Stereo frames, or two split-complex halves of frame + 1 bins
+        std::vector<float> a(frame * 2 + 2), b(frame * 2 + 2), mono(frame);
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = std::sin(i * 0.01f) * 0.5f;
+            b[i] = std::cos(i * 0.013f) * 0.25f;
+        }
+
+        char name[64];
+        float sum = 0.0f, peak = 0.0f;
+        std::snprintf(name, sizeof(name), "rms/peak %zu", frame);
+        Report(name,
+               TimeNs([&] { ScalarSumSquaresAndPeak(a.data(), frame, &sum, &peak); }, &sink),
+               TimeNs([&] { dsp::SumSquaresAndPeak(a.data(), frame, &sum, &peak); }, &sink));
+
+        std::snprintf(name, sizeof(name), "multiply-add %zu", frame);
+        Report(name,
+               TimeNs([&] { ScalarMultiplyAdd(a.data(), -0.5f, b.data(), frame); }, &sink),
+               TimeNs([&] { dsp::MultiplyAdd(a.data(), -0.5f, b.data(), frame); }, &sink));
+
+        std::snprintf(name, sizeof(name), "stereo downmix %zu", frame);
+        Report(name,
+               TimeNs([&] { ScalarDownmix(a.data(), frame, 2, mono.data()); }, &sink),
+               TimeNs([&] { dsp::Downmix(a.data(), frame, 2, mono.data()); }, &sink));
+
+        std::vector<int16_t> pcm(frame * 2);
+        for (size_t i = 0; i < pcm.size(); ++i) {
+            pcm[i] = static_cast<int16_t>(a[i] * 32767.0f);
+        }
+        std::snprintf(name, sizeof(name), "s16 stereo downmix %zu", frame);
+        Report(name,
+               TimeNs([&] { ScalarDownmixS16(pcm.data(), frame, mono.data()); }, &sink),
+               TimeNs([&] { dsp::DownmixS16(pcm.data(), frame, 2, mono.data()); }, &sink));
+
+        // One NLMS partition: frame + 1 bins, split complex
+        size_t bins = frame + 1;
+        std::vector<float> acc_re(bins), acc_im(bins);
+        std::snprintf(name, sizeof(name), "complex mac %zu", bins);
+        Report(name,
+               TimeNs([&] { ScalarComplexMac(a.data(), a.data() + bins, b.data(), b.data() + bins,
+                                             acc_re.data(), acc_im.data(), bins); }, &sink),
+               TimeNs([&] { dsp::ComplexMultiplyAccumulate(a.data(), a.data() + bins, b.data(), b.data() + bins,
+                                                           acc_re.data(), acc_im.data(), bins); }, &sink));
+    }
+
+    // What the AEC frame loop dispatches to at Initialize
+    for (size_t frame : {160, 320, 480}) {
+        // Any unlisted size gets the runtime-length table
+        dsp::FrameKernels fixed = dsp::FrameKernelsFor(frame);
+        dsp::FrameKernels runtime = dsp::FrameKernelsFor(frame + 1);
+        std::vector<float> a(frame * 2), frame_out(frame);
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = std::sin(i * 0.01f) * 0.05f;
+        }
+
+        char name[64];
+        float sum = 0.0f, peak = 0.0f;
+        std::snprintf(name, sizeof(name), "frame rms/peak %zu", frame);
+        Report(name,
+               TimeNs([&] { runtime.sum_squares_and_peak(a.data(), frame, &sum, &peak); }, &sink),
+               TimeNs([&] { fixed.sum_squares_and_peak(a.data(), frame, &sum, &peak); }, &sink),
+               "runtime", "fixed");
+
+        std::snprintf(name, sizeof(name), "frame deinterleave %zu", frame);
+        Report(name,
+               TimeNs([&] { runtime.deinterleave(a.data(), frame, 2, 1, frame_out.data()); }, &sink),
+               TimeNs([&] { fixed.deinterleave(a.data(), frame, 2, 1, frame_out.data()); }, &sink),
+               "runtime", "fixed");
+
+        std::snprintf(name, sizeof(name), "frame downmix %zu", frame);
+        Report(name,
+               TimeNs([&] { runtime.downmix(a.data(), frame, 2, frame_out.data()); }, &sink),
+               TimeNs([&] { fixed.downmix(a.data(), frame, 2, frame_out.data()); }, &sink),
+               "runtime", "fixed");
+
+        std::snprintf(name, sizeof(name), "frame attenuate %zu", frame);
+        Report(name,
+               TimeNs([&] { runtime.attenuate_below(frame_out.data(), frame, 0.01f, 1.0f); }, &sink),
+               TimeNs([&] { fixed.attenuate_below(frame_out.data(), frame, 0.01f, 1.0f); }, &sink),
+               "runtime", "fixed");
+    }
+    return 0;
+}
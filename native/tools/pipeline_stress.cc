@@ -0,0 +1,859 @@
+// Stress test of the capture pipeline's framing: feeds the echo canceller
+// and a ProcessingGraph random chunk sizes (log-uniform from --min-chunk to
+// --max-chunk samples), in random render/capture interleavings and, in the
+// threaded runs, from producer threads on a jittered clock through the
+// IOProc-to-consumer rings. Reports per configuration the throughput, the
+// per-call and end-to-end latency percentiles, the cost per sample by chunk
+// size, and whether the output is continuous: every input sample handed
+// over once, in order, and the output sample-for-sample what 10ms buffers
+// give, so no sample was dropped or repeated on the way.
+//
+//   pipeline_stress [--seconds S] [--seed N] [--min-chunk N] [--max-chunk N]
+//                   [--jitter-ms N] [--speed N] [--graph highpass,ns,resample]
+//                   [--filter SUBSTRING] [--json]
+//
+// Built by binding.gyp as the pipeline_stress target
+// (build/Release/pipeline_stress). --seconds is of audio per configuration
+// (default 20); the threaded runs are paced at --speed times real time
+// (default 8), each chunk arriving up to --jitter-ms late (default 5). A
+// run is compared with its reference only where the output cannot depend
+// on the render interleaving: AEC3 with no render, NS alone, and a graph
+// without an aec stage; the other runs report continuity as null and are
+// checked for handoff order only. After the runs, the idle check records a
+// second of the mic signal, stops the recorder and watches every native
+// thread's wakeups (getWakeupStats()) for a second: each should read 0/s.
+// Exits 3 when any run lost, repeated or changed a sample, or a thread woke
+// while idle, so a CI run fails on a regression. --seed makes a failure
+// reproducible; --filter idle runs the idle check alone.
+
+#include "aec_processor.h"
+#include "latency_histogram.h"
+#include "meeting_recorder.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "processing_graph.h"
+#include "spsc_ring_buffer.h"
+#include "wakeup_stats.h"
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kakarot;
+
+// What the addon's capture streams see: 48kHz mono, through rings of the
+// same geometry; 10ms is the reference chunk
+static constexpr int kCaptureRate = 48000;
+static constexpr size_t kFrameSamples = kCaptureRate / 100;
+static constexpr size_t kRingSamples = 96000;
+static constexpr size_t kRingChunks = 4096;
+static constexpr int64_t kConsumerWaitNs = 20 * 1000 * 1000;
+
+// How far the interleaved runs let render and capture drift apart: 100ms,
+// about what the render ring absorbs live
+static constexpr size_t kMaxSkewSamples = kCaptureRate / 10;
+
+// Reference and stress run share one float path, so any difference is a
+// real one
+static constexpr float kTolerance = 1e-6f;
+
+// The simulated room: the far end comes back into the mic 40ms later at -12dB
+static constexpr size_t kEchoDelaySamples = kCaptureRate * 40 / 1000;
+static constexpr float kEchoGain = 0.25f;
+
+// How long the idle check watches the wakeup counters once the recorder has
+// stopped, and how much it records first
+static constexpr int kIdleWatchMs = 1000;
+static constexpr size_t kIdleRecordSamples = kCaptureRate;
+
+struct Options {
+    double seconds = 20.0;
+    uint32_t seed = 1;
+    size_t min_chunk = 1;
+    size_t max_chunk = 10000;
+    double jitter_ms = 5.0;
+    double speed = 8.0;
+    std::string graph = "highpass,ns,resample";
+    std::string filter;
+    bool json = false;
+};
+
+static void Usage() {
+    std::fprintf(stderr,
+                 "usage: pipeline_stress [--seconds S] [--seed N] [--min-chunk N] [--max-chunk N]\n"
+                 "                       [--jitter-ms N] [--speed N] [--graph highpass,ns,resample]\n"
+                 "                       [--filter SUBSTRING] [--json]\n");
+}
+
+static bool ParseArgs(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            options->json = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--seconds") {
+            options->seconds = std::max(1.0, std::atof(value));
+        } else if (arg == "--seed") {
+            options->seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (arg == "--min-chunk") {
+            options->min_chunk = static_cast<size_t>(std::max(1, std::atoi(value)));
+        } else if (arg == "--max-chunk") {
+            options->max_chunk = static_cast<size_t>(std::max(1, std::atoi(value)));
+        } else if (arg == "--jitter-ms") {
+            options->jitter_ms = std::max(0.0, std::atof(value));
+        } else if (arg == "--speed") {
+            options->speed = std::max(0.1, std::atof(value));
+        } else if (arg == "--graph") {
+            options->graph = value;
+        } else if (arg == "--filter") {
+            options->filter = value;
+        } else {
+            return false;
+        }
+    }
+    // A chunk must fit the ring, with room for the consumer to be behind
+    options->max_chunk = std::min(options->max_chunk, kRingSamples / 4);
+    options->min_chunk = std::min(options->min_chunk, options->max_chunk);
+    return true;
+}
+
+// Native log records go to stderr; nothing else drains the ring here
+static void FlushLog() {
+    LogRecord records[16];
+    size_t count;
+    while ((count = NativeLogRing().Read(records, 16)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            std::fprintf(stderr, "[%s] %s\n", records[i].source, records[i].message);
+        }
+    }
+}
+
+static uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Chunk sizes spread evenly over orders of magnitude, so 1-sample calls are
+// as common as 10k ones and every framing case comes up
+class ChunkSizer {
+public:
+    ChunkSizer(uint32_t seed, size_t min_chunk, size_t max_chunk)
+        : rng_(seed), log_size_(std::log(static_cast<double>(min_chunk)),
+                                std::log(static_cast<double>(max_chunk) + 1.0)),
+          min_(min_chunk), max_(max_chunk) {}
+
+    size_t Next() {
+        size_t size = static_cast<size_t>(std::exp(log_size_(rng_)));
+        return std::min(max_, std::max(min_, size));
+    }
+
+    std::mt19937& Rng() { return rng_; }
+
+private:
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> log_size_;
+    const size_t min_;
+    const size_t max_;
+};
+
+// The signals every run is fed: a talker on the mic with the far end's echo
+// under it, and the far end as render
+struct Signals {
+    std::vector<float> mic;
+    std::vector<float> far;
+};
+
+static void FillTalker(uint32_t seed, double syllable_hz, double phase_s, std::vector<float>* out) {
+    uint32_t state = seed * 2654435761u + 1u;
+    float lowpass = 0.0f;
+    for (size_t i = 0; i < out->size(); ++i) {
+        double t = static_cast<double>(i) / kCaptureRate;
+        double talking = std::fmod(t + phase_s, 5.0) < 3.0 ? 1.0 : 0.0;
+        double envelope = talking * std::max(0.0, std::sin(2.0 * M_PI * syllable_hz * t));
+        state = state * 1664525u + 1013904223u;
+        float noise = static_cast<float>(static_cast<int32_t>(state)) / 2147483648.0f;
+        lowpass += 0.3f * (noise - lowpass);
+        (*out)[i] = static_cast<float>(0.3 * envelope) * lowpass + 0.001f * noise;
+    }
+}
+
+static Signals MakeSignals(size_t samples) {
+    Signals signals;
+    signals.mic.resize(samples);
+    signals.far.resize(samples);
+    FillTalker(1, 4.0, 0.0, &signals.mic);
+    FillTalker(2, 3.3, 2.5, &signals.far);
+    for (size_t i = kEchoDelaySamples; i < samples; ++i) {
+        signals.mic[i] += kEchoGain * signals.far[i - kEchoDelaySamples];
+    }
+    return signals;
+}
+
+enum class TargetKind { kAec3, kNs, kGraph };
+enum class FeedMode { kCapture, kInterleaved, kThreaded };
+
+// What a run drives: the echo canceller as CaptureStream runs it, or a
+// graph as the native capture stream does
+class Target {
+public:
+    virtual ~Target() = default;
+    virtual bool Prepare(std::string* error) = 0;
+    virtual void Render(const float* data, size_t n) = 0;
+    // Appends what |n| samples in let out
+    virtual void Capture(const float* data, size_t n, std::vector<float>* out) = 0;
+    // Whether Render() may run beside Capture(), as on the aecRender thread
+    virtual bool RenderThreadSafe() const = 0;
+    // Whether the output is the same however render and capture interleave
+    virtual bool RenderIndependent() const = 0;
+};
+
+class AecTarget : public Target {
+public:
+    explicit AecTarget(bool echo_cancellation) : echo_cancellation_(echo_cancellation) {}
+
+    bool Prepare(std::string* error) override {
+        AECConfig config = ApplyPresetDefaults(AECConfig(), AECPreset::kAggressive);
+        config.enable_aec = echo_cancellation_;
+        config.enable_agc = false;
+        // The governor steps down on timing, which would make the output
+        // depend on the machine's load
+        config.cpu_governor = false;
+        config.adaptive_suppression = false;
+        aec_ = std::make_unique<AECProcessor>(config);
+        if (!aec_->Initialize(kCaptureRate, 1, 1)) {
+            *error = "AECProcessor failed to initialize";
+            return false;
+        }
+        return true;
+    }
+
+    void Render(const float* data, size_t n) override { aec_->ProcessRenderAudio(data, n, 1); }
+
+    void Capture(const float* data, size_t n, std::vector<float>* out) override {
+        size_t at = out->size();
+        out->resize(at + n);
+        aec_->ProcessCaptureAudio(data, out->data() + at, n);
+    }
+
+    bool RenderThreadSafe() const override { return true; }
+    bool RenderIndependent() const override { return !echo_cancellation_; }
+
+private:
+    const bool echo_cancellation_;
+    std::unique_ptr<AECProcessor> aec_;
+};
+
+class GraphTarget : public Target {
+public:
+    explicit GraphTarget(const std::string& graph) : graph_spec_(graph) {}
+
+    bool Prepare(std::string* error) override {
+        std::vector<std::unique_ptr<ProcessingStage>> stages;
+        std::vector<bool> enabled;
+        size_t start = 0;
+        while (start <= graph_spec_.size()) {
+            size_t end = graph_spec_.find(',', start);
+            if (end == std::string::npos) {
+                end = graph_spec_.size();
+            }
+            StageSpec spec;
+            spec.type = graph_spec_.substr(start, end - start);
+            start = end + 1;
+            if (spec.type.empty()) {
+                continue;
+            }
+            if (spec.type == "aec") {
+                has_aec_ = true;
+            }
+            std::unique_ptr<ProcessingStage> stage = CreateStage(spec, error);
+            if (!stage) {
+                return false;
+            }
+            stages.push_back(std::move(stage));
+            enabled.push_back(true);
+        }
+        return graph_.Build(kCaptureRate, std::move(stages), enabled, error);
+    }
+
+    void Render(const float* data, size_t n) override { graph_.ProcessRender(data, n); }
+
+    void Capture(const float* data, size_t n, std::vector<float>* out) override {
+        graph_.Process(data, n, &output_);
+        out->insert(out->end(), output_.samples.begin(), output_.samples.end());
+    }
+
+    bool RenderThreadSafe() const override { return false; }
+    bool RenderIndependent() const override { return !has_aec_; }
+
+private:
+    const std::string graph_spec_;
+    bool has_aec_ = false;
+    ProcessingGraph graph_;
+    GraphOutput output_;
+};
+
+struct RunConfig {
+    const char* name;
+    TargetKind kind;
+    FeedMode mode;
+};
+
+static const RunConfig kRuns[] = {
+    {"aec3/capture", TargetKind::kAec3, FeedMode::kCapture},
+    {"aec3/interleaved", TargetKind::kAec3, FeedMode::kInterleaved},
+    {"aec3/threaded", TargetKind::kAec3, FeedMode::kThreaded},
+    {"ns/interleaved", TargetKind::kNs, FeedMode::kInterleaved},
+    {"ns/threaded", TargetKind::kNs, FeedMode::kThreaded},
+    {"graph/capture", TargetKind::kGraph, FeedMode::kCapture},
+    {"graph/threaded", TargetKind::kGraph, FeedMode::kThreaded},
+};
+
+static std::unique_ptr<Target> MakeTarget(TargetKind kind, const Options& options) {
+    switch (kind) {
+        case TargetKind::kAec3:
+            return std::make_unique<AecTarget>(true);
+        case TargetKind::kNs:
+            return std::make_unique<AecTarget>(false);
+        case TargetKind::kGraph:
+            return std::make_unique<GraphTarget>(options.graph);
+    }
+    return nullptr;
+}
+
+// Calls grouped by how their size meets the 10ms frame
+enum SizeClass { kTiny, kSubFrame, kWholeFrames, kMixed, kSizeClasses };
+static const char* const kSizeClassNames[kSizeClasses] = {"tiny", "subFrame", "wholeFrames", "mixed"};
+
+static SizeClass ClassOf(size_t n) {
+    if (n < 64) {
+        return kTiny;
+    }
+    if (n < kFrameSamples) {
+        return kSubFrame;
+    }
+    return n % kFrameSamples == 0 ? kWholeFrames : kMixed;
+}
+
+struct ClassStats {
+    uint64_t calls = 0;
+    uint64_t samples = 0;
+    uint64_t ns = 0;
+};
+
+struct Continuity {
+    bool compared = false;        // false: the output depends on the interleaving
+    uint64_t expected = 0;        // output samples the reference produced
+    uint64_t produced = 0;
+    uint64_t mismatches = 0;
+    int64_t first_mismatch = -1;  // output sample offset
+    float max_diff = 0.0f;
+};
+
+struct RunResult {
+    std::string name;
+    uint64_t capture_calls = 0;
+    uint64_t render_calls = 0;
+    uint64_t samples = 0;
+    uint64_t busy_ns = 0;           // inside Capture() and Render()
+    uint64_t wall_ns = 0;
+    uint64_t handoff_errors = 0;    // chunks out of order through the rings
+    uint64_t producer_stalls = 0;   // rings full; the producer waited
+    ClassStats classes[kSizeClasses];
+    LatencyHistogram call_us;       // per Capture() call
+    LatencyHistogram end_to_end_us; // threaded: push to processed
+    Continuity continuity;
+
+    bool Failed() const {
+        return handoff_errors > 0 ||
+               (continuity.compared && (continuity.mismatches > 0 || continuity.produced != continuity.expected));
+    }
+};
+
+// What one chunk carried through the ring, for the consumer to check
+struct ChunkInfo {
+    uint64_t offset;
+    uint32_t size;
+    uint64_t pushed_ns;
+};
+
+static void TimedCapture(Target* target, const float* data, size_t n, std::vector<float>* out, RunResult* result) {
+    uint64_t start = NowNs();
+    target->Capture(data, n, out);
+    uint64_t elapsed = NowNs() - start;
+    result->busy_ns += elapsed;
+    result->capture_calls++;
+    result->call_us.Record(elapsed / 1000);
+    ClassStats& stats = result->classes[ClassOf(n)];
+    stats.calls++;
+    stats.samples += n;
+    stats.ns += elapsed;
+}
+
+static void TimedRender(Target* target, const float* data, size_t n, RunResult* result) {
+    uint64_t start = NowNs();
+    target->Render(data, n);
+    result->busy_ns += NowNs() - start;
+    result->render_calls++;
+}
+
+// One thread, random sizes; render chunks drawn from their own stream and
+// interleaved at random within kMaxSkewSamples of capture
+static void RunSameThread(Target* target, const Signals& signals, const Options& options, bool with_render,
+                          uint32_t seed, std::vector<float>* out, RunResult* result) {
+    ChunkSizer capture_sizes(seed, options.min_chunk, options.max_chunk);
+    ChunkSizer render_sizes(seed + 1, options.min_chunk, options.max_chunk);
+    std::bernoulli_distribution coin(0.5);
+    const size_t total = signals.mic.size();
+    size_t captured = 0;
+    size_t rendered = 0;
+    while (captured < total) {
+        bool render = with_render && rendered < total &&
+                      (rendered + kMaxSkewSamples < captured ||
+                       (rendered < captured + kMaxSkewSamples && coin(render_sizes.Rng())));
+        if (render) {
+            size_t n = std::min(render_sizes.Next(), total - rendered);
+            TimedRender(target, signals.far.data() + rendered, n, result);
+            rendered += n;
+        } else {
+            size_t n = std::min(capture_sizes.Next(), total - captured);
+            TimedCapture(target, signals.mic.data() + captured, n, out, result);
+            captured += n;
+        }
+    }
+    result->samples = captured;
+}
+
+// A device's IOProc: random chunks of |signal| into the rings on the clock,
+// each up to the jitter late. Waits, counted, when the consumer is a ring
+// behind rather than dropping, so continuity stays checkable.
+static void ProduceChunks(const std::vector<float>& signal, const Options& options, uint32_t seed,
+                          SpscRingBuffer<float>* ring, SpscRingBuffer<ChunkInfo>* infos, Semaphore* wake,
+                          std::atomic<uint64_t>* stalls) {
+    ChunkSizer sizes(seed, options.min_chunk, options.max_chunk);
+    std::uniform_real_distribution<double> jitter(0.0, options.jitter_ms * 1e6);
+    const auto start = std::chrono::steady_clock::now();
+    const double ns_per_sample = 1e9 / kCaptureRate / options.speed;
+    size_t offset = 0;
+    while (offset < signal.size()) {
+        size_t n = std::min(sizes.Next(), signal.size() - offset);
+        int64_t due_ns = static_cast<int64_t>((offset + n) * ns_per_sample + jitter(sizes.Rng()));
+        std::this_thread::sleep_until(start + std::chrono::nanoseconds(due_ns));
+        while (ring->AvailableToWrite() < n || infos->AvailableToWrite() < 1) {
+            stalls->fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        ring->Write(signal.data() + offset, n);
+        ChunkInfo info{offset, static_cast<uint32_t>(n), NowNs()};
+        infos->Write(&info, 1);
+        wake->Signal();
+        offset += n;
+    }
+}
+
+// Takes one chunk off the rings and checks it is the next one
+static bool TakeChunk(SpscRingBuffer<float>* ring, SpscRingBuffer<ChunkInfo>* infos, uint64_t* expected_offset,
+                      std::vector<float>* chunk, ChunkInfo* info, RunResult* result) {
+    if (infos->Read(info, 1) != 1) {
+        return false;
+    }
+    chunk->resize(info->size);
+    size_t got = ring->Read(chunk->data(), info->size);
+    if (got != info->size || info->offset != *expected_offset) {
+        result->handoff_errors++;
+    }
+    chunk->resize(got);
+    *expected_offset = info->offset + info->size;
+    return true;
+}
+
+// The live shape: a mic producer and a render producer on jittered clocks,
+// and this thread as the consumer. Render runs on its own thread where the
+// target allows it, as the aecRender thread does; otherwise through a ring
+// the consumer drains before each capture chunk.
+static void RunThreaded(Target* target, const Signals& signals, const Options& options, uint32_t seed,
+                        std::vector<float>* out, RunResult* result) {
+    SpscRingBuffer<float> mic_ring(kRingSamples);
+    SpscRingBuffer<ChunkInfo> mic_infos(kRingChunks);
+    SpscRingBuffer<float> render_ring(kRingSamples);
+    SpscRingBuffer<ChunkInfo> render_infos(kRingChunks);
+    Semaphore wake;
+    Semaphore render_wake;
+    std::atomic<uint64_t> stalls{0};
+    std::atomic<bool> render_done{false};
+    std::atomic<uint64_t> render_busy_ns{0};
+    std::atomic<uint64_t> render_calls{0};
+
+    std::thread mic([&] {
+        ProduceChunks(signals.mic, options, seed, &mic_ring, &mic_infos, &wake, &stalls);
+    });
+    std::thread render([&] {
+        ProduceChunks(signals.far, options, seed + 1, &render_ring, &render_infos,
+                      target->RenderThreadSafe() ? &render_wake : &wake, &stalls);
+        render_done.store(true, std::memory_order_release);
+        render_wake.Signal();
+    });
+    // Stands in for the aecRender thread
+    std::thread render_consumer;
+    if (target->RenderThreadSafe()) {
+        render_consumer = std::thread([&] {
+            std::vector<float> chunk;
+            ChunkInfo info;
+            uint64_t expected = 0;
+            RunResult render_result;
+            for (;;) {
+                bool done = render_done.load(std::memory_order_acquire);
+                while (TakeChunk(&render_ring, &render_infos, &expected, &chunk, &info, &render_result)) {
+                    uint64_t start = NowNs();
+                    target->Render(chunk.data(), chunk.size());
+                    render_busy_ns.fetch_add(NowNs() - start, std::memory_order_relaxed);
+                    render_calls.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (done) {
+                    break;
+                }
+                render_wake.WaitFor(kConsumerWaitNs);
+            }
+            result->handoff_errors += render_result.handoff_errors;
+        });
+    }
+
+    std::vector<float> chunk;
+    std::vector<float> render_chunk;
+    ChunkInfo info;
+    uint64_t expected = 0;
+    uint64_t render_expected = 0;
+    while (expected < signals.mic.size()) {
+        if (!target->RenderThreadSafe()) {
+            ChunkInfo render_info;
+            while (TakeChunk(&render_ring, &render_infos, &render_expected, &render_chunk, &render_info, result)) {
+                TimedRender(target, render_chunk.data(), render_chunk.size(), result);
+            }
+        }
+        if (!TakeChunk(&mic_ring, &mic_infos, &expected, &chunk, &info, result)) {
+            wake.WaitFor(kConsumerWaitNs);
+            continue;
+        }
+        TimedCapture(target, chunk.data(), chunk.size(), out, result);
+        result->end_to_end_us.Record((NowNs() - info.pushed_ns) / 1000);
+        result->samples += chunk.size();
+    }
+    mic.join();
+    render.join();
+    if (render_consumer.joinable()) {
+        render_consumer.join();
+    }
+    result->busy_ns += render_busy_ns.load();
+    result->render_calls += render_calls.load();
+    result->producer_stalls = stalls.load();
+}
+
+// The same mic audio through a fresh target in 10ms buffers, capture only
+static bool RunReference(const RunConfig& run, const Options& options, const Signals& signals,
+                         std::vector<float>* out, std::string* error) {
+    std::unique_ptr<Target> target = MakeTarget(run.kind, options);
+    if (!target->Prepare(error)) {
+        return false;
+    }
+    for (size_t at = 0; at < signals.mic.size(); at += kFrameSamples) {
+        target->Capture(signals.mic.data() + at, std::min(kFrameSamples, signals.mic.size() - at), out);
+    }
+    return true;
+}
+
+static void Compare(const std::vector<float>& expected, const std::vector<float>& produced, Continuity* continuity) {
+    continuity->compared = true;
+    continuity->expected = expected.size();
+    continuity->produced = produced.size();
+    size_t common = std::min(expected.size(), produced.size());
+    for (size_t i = 0; i < common; ++i) {
+        float diff = std::fabs(expected[i] - produced[i]);
+        if (diff > kTolerance) {
+            if (continuity->first_mismatch < 0) {
+                continuity->first_mismatch = static_cast<int64_t>(i);
+            }
+            continuity->mismatches++;
+        }
+        continuity->max_diff = std::max(continuity->max_diff, diff);
+    }
+}
+
+static bool Run(const RunConfig& run, const Options& options, const Signals& signals, uint32_t seed,
+                RunResult* result, std::string* error) {
+    result->name = run.name;
+    std::unique_ptr<Target> target = MakeTarget(run.kind, options);
+    if (!target->Prepare(error)) {
+        return false;
+    }
+    std::vector<float> out;
+    out.reserve(signals.mic.size());
+    const uint64_t started = NowNs();
+    switch (run.mode) {
+        case FeedMode::kCapture:
+            RunSameThread(target.get(), signals, options, false, seed, &out, result);
+            break;
+        case FeedMode::kInterleaved:
+            RunSameThread(target.get(), signals, options, true, seed, &out, result);
+            break;
+        case FeedMode::kThreaded:
+            RunThreaded(target.get(), signals, options, seed, &out, result);
+            break;
+    }
+    result->wall_ns = NowNs() - started;
+
+    // Without render the output of any target is render-independent
+    if (target->RenderIndependent() || run.mode == FeedMode::kCapture) {
+        std::vector<float> reference;
+        reference.reserve(signals.mic.size());
+        if (!RunReference(run, options, signals, &reference, error)) {
+            return false;
+        }
+        Compare(reference, out, &result->continuity);
+    }
+    return true;
+}
+
+// What the idle check saw: a thread kind per nonzero rate
+struct IdleResult {
+    bool ran = false;
+    std::string directory;
+    std::vector<WakeupStat> awake;
+
+    bool Failed() const { return !awake.empty(); }
+};
+
+// Starts a recording, feeds it the mic signal, stops it and then watches
+// the wakeup counters. The recorder's writer and the runs' threads have all
+// exited by then, so any wakeup is a thread polling with nothing to do.
+static bool CheckIdle(const Signals& signals, IdleResult* result, std::string* error) {
+    result->ran = true;
+    char pattern[] = "/tmp/pipeline_stress.XXXXXX";
+    if (!mkdtemp(pattern)) {
+        *error = "cannot create a recording directory";
+        return false;
+    }
+    result->directory = pattern;
+
+    RecorderOptions recorder;
+    recorder.directory = result->directory;
+    recorder.name = "idle";
+    if (!StartRecording(recorder, error)) {
+        return false;
+    }
+    // At the pace the mic delivers it, so the writer drains as it does live
+    const size_t samples = std::min(kIdleRecordSamples, signals.mic.size());
+    for (size_t at = 0; at < samples; at += kFrameSamples) {
+        const uint32_t n = static_cast<uint32_t>(std::min(kFrameSamples, samples - at));
+        RecordSamples(RecordTrack::kMicrophone, &recorder, signals.mic.data() + at, n, kCaptureRate, 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    StopRecording();
+
+    // The first call only starts the window the second one's rates are over
+    GetWakeupStats();
+    std::this_thread::sleep_for(std::chrono::milliseconds(kIdleWatchMs));
+    for (const WakeupStat& stat : GetWakeupStats()) {
+        if (stat.per_second > 0) {
+            result->awake.push_back(stat);
+        }
+    }
+    return true;
+}
+
+static double AudioMs(const RunResult& result) {
+    return result.samples * 1000.0 / kCaptureRate;
+}
+
+static double RealtimeFactor(const RunResult& result) {
+    return result.busy_ns > 0 ? AudioMs(result) * 1e6 / result.busy_ns : 0.0;
+}
+
+static void PrintJson(const Options& options, const std::vector<std::unique_ptr<RunResult>>& results,
+                      const IdleResult& idle) {
+    std::printf("{\n  \"seed\": %u,\n  \"seconds\": %.1f,\n  \"minChunk\": %zu,\n  \"maxChunk\": %zu,\n",
+                options.seed, options.seconds, options.min_chunk, options.max_chunk);
+    std::printf("  \"jitterMs\": %.1f,\n  \"speed\": %.1f,\n  \"graph\": \"%s\",\n  \"runs\": [\n",
+                options.jitter_ms, options.speed, options.graph.c_str());
+    for (size_t i = 0; i < results.size(); ++i) {
+        const RunResult& result = *results[i];
+        LatencySummary call = result.call_us.Summarize();
+        LatencySummary e2e = result.end_to_end_us.Summarize();
+        std::printf("    { \"name\": \"%s\", \"passed\": %s, \"captureCalls\": %llu, \"renderCalls\": %llu,\n",
+                    result.name.c_str(), result.Failed() ? "false" : "true",
+                    static_cast<unsigned long long>(result.capture_calls),
+                    static_cast<unsigned long long>(result.render_calls));
+        std::printf("      \"audioMs\": %.1f, \"wallMs\": %.1f, \"busyMs\": %.1f, \"realtimeFactor\": %.1f,\n",
+                    AudioMs(result), result.wall_ns / 1e6, result.busy_ns / 1e6, RealtimeFactor(result));
+        std::printf("      \"callUs\": { \"p50\": %llu, \"p95\": %llu, \"p99\": %llu, \"max\": %llu },\n",
+                    static_cast<unsigned long long>(call.p50), static_cast<unsigned long long>(call.p95),
+                    static_cast<unsigned long long>(call.p99), static_cast<unsigned long long>(call.max));
+        if (e2e.count > 0) {
+            std::printf("      \"endToEndUs\": { \"p50\": %llu, \"p95\": %llu, \"p99\": %llu, \"max\": %llu },\n",
+                        static_cast<unsigned long long>(e2e.p50), static_cast<unsigned long long>(e2e.p95),
+                        static_cast<unsigned long long>(e2e.p99), static_cast<unsigned long long>(e2e.max));
+        } else {
+            std::printf("      \"endToEndUs\": null,\n");
+        }
+        std::printf("      \"handoffErrors\": %llu, \"producerStalls\": %llu,\n",
+                    static_cast<unsigned long long>(result.handoff_errors),
+                    static_cast<unsigned long long>(result.producer_stalls));
+        std::printf("      \"nsPerSample\": {");
+        for (int c = 0; c < kSizeClasses; ++c) {
+            const ClassStats& stats = result.classes[c];
+            if (stats.samples > 0) {
+                std::printf(" \"%s\": %.2f%s", kSizeClassNames[c], static_cast<double>(stats.ns) / stats.samples,
+                            c + 1 < kSizeClasses ? "," : "");
+            } else {
+                std::printf(" \"%s\": null%s", kSizeClassNames[c], c + 1 < kSizeClasses ? "," : "");
+            }
+        }
+        std::printf(" },\n");
+        const Continuity& continuity = result.continuity;
+        if (continuity.compared) {
+            std::printf("      \"continuity\": { \"expected\": %llu, \"produced\": %llu, \"mismatches\": %llu, "
+                        "\"firstMismatch\": %lld, \"maxDiff\": %g } }%s\n",
+                        static_cast<unsigned long long>(continuity.expected),
+                        static_cast<unsigned long long>(continuity.produced),
+                        static_cast<unsigned long long>(continuity.mismatches),
+                        static_cast<long long>(continuity.first_mismatch), continuity.max_diff,
+                        i + 1 < results.size() ? "," : "");
+        } else {
+            std::printf("      \"continuity\": null }%s\n", i + 1 < results.size() ? "," : "");
+        }
+    }
+    std::printf("  ],\n");
+    if (!idle.ran) {
+        std::printf("  \"idle\": null\n}\n");
+        return;
+    }
+    std::printf("  \"idle\": { \"passed\": %s, \"watchMs\": %d, \"awake\": [", idle.Failed() ? "false" : "true",
+                kIdleWatchMs);
+    for (size_t i = 0; i < idle.awake.size(); ++i) {
+        std::printf("%s{ \"name\": \"%s\", \"perSecond\": %.2f }", i > 0 ? ", " : " ", idle.awake[i].name,
+                    idle.awake[i].per_second);
+    }
+    std::printf("%s] }\n}\n", idle.awake.empty() ? "" : " ");
+}
+
+static void PrintTable(const Options& options, const std::vector<std::unique_ptr<RunResult>>& results,
+                       const IdleResult& idle) {
+    std::printf("seed %u, %.1f s per run, chunks %zu-%zu samples, jitter %.1f ms at %.1fx, graph %s\n",
+                options.seed, options.seconds, options.min_chunk, options.max_chunk, options.jitter_ms,
+                options.speed, options.graph.c_str());
+    std::printf("%-18s %8s %8s %9s %8s %8s %8s %9s %9s %s\n", "run", "calls", "x rt", "p50 us", "p99 us",
+                "max us", "e2e p99", "handoff", "stalls", "continuity");
+    for (const auto& run : results) {
+        const RunResult& result = *run;
+        LatencySummary call = result.call_us.Summarize();
+        LatencySummary e2e = result.end_to_end_us.Summarize();
+        char continuity[96];
+        if (!result.continuity.compared) {
+            std::snprintf(continuity, sizeof(continuity), "not comparable");
+        } else if (!result.Failed()) {
+            std::snprintf(continuity, sizeof(continuity), "ok");
+        } else {
+            std::snprintf(continuity, sizeof(continuity), "%llu/%llu samples, %llu differ from %lld",
+                          static_cast<unsigned long long>(result.continuity.produced),
+                          static_cast<unsigned long long>(result.continuity.expected),
+                          static_cast<unsigned long long>(result.continuity.mismatches),
+                          static_cast<long long>(result.continuity.first_mismatch));
+        }
+        std::printf("%-18s %8llu %8.1f %9llu %8llu %8llu %8llu %9llu %9llu %s\n", result.name.c_str(),
+                    static_cast<unsigned long long>(result.capture_calls), RealtimeFactor(result),
+                    static_cast<unsigned long long>(call.p50), static_cast<unsigned long long>(call.p99),
+                    static_cast<unsigned long long>(call.max), static_cast<unsigned long long>(e2e.p99),
+                    static_cast<unsigned long long>(result.handoff_errors),
+                    static_cast<unsigned long long>(result.producer_stalls), continuity);
+    }
+    std::printf("\nns per sample by chunk size\n%-18s", "run");
+    for (const char* name : kSizeClassNames) {
+        std::printf(" %12s", name);
+    }
+    std::printf("\n");
+    for (const auto& result : results) {
+        std::printf("%-18s", result->name.c_str());
+        for (const ClassStats& stats : result->classes) {
+            if (stats.samples > 0) {
+                std::printf(" %12.2f", static_cast<double>(stats.ns) / stats.samples);
+            } else {
+                std::printf(" %12s", "-");
+            }
+        }
+        std::printf("\n");
+    }
+    if (!idle.ran) {
+        return;
+    }
+    std::printf("\nidle wakeups over %d ms after stop (recorded to %s): ", kIdleWatchMs, idle.directory.c_str());
+    if (!idle.Failed()) {
+        std::printf("none\n");
+    }
+    for (size_t i = 0; i < idle.awake.size(); ++i) {
+        std::printf("%s%s %.2f/s%s", i > 0 ? ", " : "", idle.awake[i].name, idle.awake[i].per_second,
+                    i + 1 < idle.awake.size() ? "" : "\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, &options)) {
+        Usage();
+        return 2;
+    }
+    SetLogLevel(LogLevel::kWarn);
+
+    const Signals signals = MakeSignals(static_cast<size_t>(options.seconds * kCaptureRate));
+    std::vector<std::unique_ptr<RunResult>> results;
+    uint32_t seed = options.seed;
+    for (const RunConfig& run : kRuns) {
+        // Each run draws its own sequence, so --filter does not change it
+        seed += 2;
+        if (!options.filter.empty() && std::string(run.name).find(options.filter) == std::string::npos) {
+            continue;
+        }
+        results.push_back(std::make_unique<RunResult>());
+        std::string error;
+        if (!Run(run, options, signals, seed, results.back().get(), &error)) {
+            FlushLog();
+            std::fprintf(stderr, "%s: %s\n", run.name, error.c_str());
+            return 1;
+        }
+        FlushLog();
+    }
+
+    IdleResult idle;
+    if (options.filter.empty() || std::string("idle").find(options.filter) != std::string::npos) {
+        std::string error;
+        if (!CheckIdle(signals, &idle, &error)) {
+            FlushLog();
+            std::fprintf(stderr, "idle: %s\n", error.c_str());
+            return 1;
+        }
+        FlushLog();
+    }
+
+    bool failed = idle.Failed();
+    for (const auto& result : results) {
+        failed = failed || result->Failed();
+    }
+    if (options.json) {
+        PrintJson(options, results, idle);
+    } else {
+        PrintTable(options, results, idle);
+    }
+    return failed ? 3 : 0;
+}
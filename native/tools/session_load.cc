@@ -0,0 +1,525 @@
+// Load test of concurrent meetings: N simulated sessions, each with a
+// capture thread producing 10ms mic and system buffers on the clock into the
+// IOProc-to-consumer ring and the meeting recorder, and a consumer thread
+// running them through a ProcessingGraph (system audio as its render) and
+// cutting the output into deliveries as CaptureStream does. Reports audio
+// throughput, deadline misses, delivery latency, CPU and memory per
+// session, so runs at different session and core counts show how the
+// native side scales.
+//
+//   session_load [--sessions N] [--cores N] [--seconds S] [--chunk-ms N]
+//                [--graph highpass,aec,resample,vad] [--no-record] [--json]
+//
+// Built by binding.gyp as the session_load target (build/Release/session_load).
+// --cores pins the process to its first N CPUs on Linux; elsewhere the
+// scheduler decides and the count is only reported. A buffer misses its
+// deadline when the consumer has not finished it one period after capture,
+// the point where a live stream starts backing up. The recorder takes one
+// producer per track, as across envs in the addon, so session 0 is the one
+// recorded and the rest pay only its check. Exits 3 when any buffer missed
+// its deadline or was dropped, so a CI run fails on a regression.
+
+#include "aec_processor.h"
+#include "chunk_assembler.h"
+#include "latency_histogram.h"
+#include "meeting_recorder.h"
+#include "native_log.h"
+#include "platform_thread.h"
+#include "processing_graph.h"
+#include "spsc_ring_buffer.h"
+#include <sys/resource.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kakarot;
+
+// What the addon's capture streams see: 48kHz mono in 10ms buffers, through
+// rings of the same geometry
+static constexpr int kCaptureRate = 48000;
+static constexpr uint32_t kPeriodSamples = kCaptureRate / 100;
+static constexpr double kPeriodMs = 10.0;
+static constexpr size_t kRingSamples = 96000;
+static constexpr size_t kRingChunks = 256;
+static constexpr int64_t kConsumerWaitNs = 20 * 1000 * 1000;
+
+// The simulated room: the far end comes back into the mic 40ms later at -12dB
+static constexpr size_t kEchoDelaySamples = kCaptureRate * 40 / 1000;
+static constexpr float kEchoGain = 0.25f;
+
+struct Options {
+    int sessions = 4;
+    int cores = 0;             // 0 = leave the affinity alone
+    double seconds = 30.0;
+    double chunk_ms = 100.0;   // the delivery size; 0 = one per buffer
+    std::string graph = "highpass,aec,resample,vad";
+    bool record = true;
+    bool json = false;
+};
+
+static void Usage() {
+    std::fprintf(stderr,
+                 "usage: session_load [--sessions N] [--cores N] [--seconds S] [--chunk-ms N]\n"
+                 "                    [--graph highpass,aec,resample,vad] [--no-record] [--json]\n");
+}
+
+static bool ParseArgs(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-record") {
+            options->record = false;
+            continue;
+        }
+        if (arg == "--json") {
+            options->json = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--sessions") {
+            options->sessions = std::max(1, std::atoi(value));
+        } else if (arg == "--cores") {
+            options->cores = std::max(0, std::atoi(value));
+        } else if (arg == "--seconds") {
+            options->seconds = std::max(1.0, std::atof(value));
+        } else if (arg == "--chunk-ms") {
+            options->chunk_ms = std::max(0.0, std::atof(value));
+        } else if (arg == "--graph") {
+            options->graph = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Native log records go to stderr; nothing else drains the ring here
+static void FlushLog() {
+    LogRecord records[16];
+    size_t count;
+    while ((count = NativeLogRing().Read(records, 16)) > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            std::fprintf(stderr, "[%s] %s\n", records[i].source, records[i].message);
+        }
+    }
+}
+
+static double PeakRssMb() {
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / (1024.0 * 1024.0);  // bytes
+#else
+    return usage.ru_maxrss / 1024.0;             // kilobytes
+#endif
+}
+
+static uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static bool PinToCores(int cores) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < cores && cpu < CPU_SETSIZE; ++cpu) {
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cores;
+    return false;
+#endif
+}
+
+// Speech-like test signal: noise under a syllable-rate envelope, with
+// pauses, so VAD, NS and the echo canceller all have work to do
+class SyntheticTalker {
+public:
+    // |phase_s| offsets the talk/pause cycle, so two talkers overlap only sometimes
+    SyntheticTalker(uint32_t seed, double syllable_hz, double phase_s)
+        : state_(seed * 2654435761u + 1u), syllable_hz_(syllable_hz), phase_s_(phase_s) {}
+
+    void Fill(float* out, size_t n) {
+        for (size_t i = 0; i < n; ++i, ++sample_) {
+            double t = static_cast<double>(sample_) / kCaptureRate;
+            // Talk for ~3s of every 5, in syllables
+            double talking = std::fmod(t + phase_s_, 5.0) < 3.0 ? 1.0 : 0.0;
+            double envelope = talking * std::max(0.0, std::sin(2.0 * M_PI * syllable_hz_ * t));
+            state_ = state_ * 1664525u + 1013904223u;
+            float noise = static_cast<float>(static_cast<int32_t>(state_)) / 2147483648.0f;
+            // A one-pole low-pass takes the top off, nearer a voice's spectrum
+            lowpass_ += 0.3f * (noise - lowpass_);
+            out[i] = static_cast<float>(0.3 * envelope) * lowpass_ + 0.001f * noise;
+        }
+    }
+
+private:
+    uint32_t state_;
+    const double syllable_hz_;
+    const double phase_s_;
+    uint64_t sample_ = 0;
+    float lowpass_ = 0.0f;
+};
+
+// One meeting: its capture thread, the rings it fills and the consumer that
+// drains them
+class Session {
+public:
+    Session(int index, const Options& options)
+        : index_(index),
+          options_(options),
+          near_(static_cast<uint32_t>(2 * index + 1), 4.0, 0.0),
+          far_(static_cast<uint32_t>(2 * index + 2), 3.3, 2.5),
+          mic_ring_(kRingSamples),
+          render_ring_(kRingSamples),
+          pushed_(kRingChunks),
+          echo_(kEchoDelaySamples, 0.0f) {}
+
+    // Builds the graph and allocates everything the threads use
+    bool Prepare(std::string* error) {
+        std::vector<std::unique_ptr<ProcessingStage>> stages;
+        std::vector<bool> enabled;
+        size_t start = 0;
+        while (start <= options_.graph.size()) {
+            size_t end = options_.graph.find(',', start);
+            if (end == std::string::npos) {
+                end = options_.graph.size();
+            }
+            StageSpec spec;
+            spec.type = options_.graph.substr(start, end - start);
+            start = end + 1;
+            if (spec.type.empty()) {
+                continue;
+            }
+            std::unique_ptr<ProcessingStage> stage = CreateStage(spec, error);
+            if (!stage) {
+                return false;
+            }
+            stages.push_back(std::move(stage));
+            enabled.push_back(true);
+        }
+        if (!graph_.Build(kCaptureRate, std::move(stages), enabled, error)) {
+            return false;
+        }
+        int output_rate = graph_.OutputSampleRate();
+        size_t frame = static_cast<size_t>(output_rate / 100);
+        size_t chunk = options_.chunk_ms > 0.0
+            ? std::max<size_t>(1, static_cast<size_t>(std::lround(options_.chunk_ms / 10.0))) * frame : frame;
+        assembler_ = std::make_unique<ChunkAssembler>(chunk, frame);
+        mic_.resize(kPeriodSamples);
+        render_.resize(kPeriodSamples);
+        output_.samples.reserve(kRingSamples);
+        return true;
+    }
+
+    void Start() {
+        running_.store(true, std::memory_order_release);
+        consumer_ = std::thread(&Session::ConsumerLoop, this);
+        capture_ = std::thread(&Session::CaptureLoop, this);
+    }
+
+    // The capture thread stops first; the consumer drains what it left
+    void Stop() {
+        capturing_.store(false, std::memory_order_release);
+        capture_.join();
+        running_.store(false, std::memory_order_release);
+        wake_.Signal();
+        consumer_.join();
+    }
+
+    int Index() const { return index_; }
+    uint64_t Buffers() const { return buffers_; }
+    uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t DeadlineMisses() const { return misses_; }
+    uint64_t CaptureOverruns() const { return overruns_.load(std::memory_order_relaxed); }
+    uint64_t Deliveries() const { return deliveries_; }
+    uint64_t EncodedBytes() const { return encoded_bytes_; }
+    uint64_t ConsumerCpuNs() const { return consumer_cpu_ns_; }
+    LatencySummary Latency() const { return latency_.Summarize(); }
+    double AudioMs() const { return buffers_ * kPeriodMs; }
+
+private:
+    // Stands in for the IOProcs: a buffer per period, on the clock, doing
+    // what their sinks do
+    void CaptureLoop() {
+        RealtimeThreadScope realtime(kPeriodMs);
+        std::vector<float> mic(kPeriodSamples);
+        std::vector<float> far(kPeriodSamples);
+        auto next = std::chrono::steady_clock::now();
+        const auto period = std::chrono::microseconds(static_cast<int64_t>(kPeriodMs * 1000));
+        while (capturing_.load(std::memory_order_acquire)) {
+            far_.Fill(far.data(), kPeriodSamples);
+            near_.Fill(mic.data(), kPeriodSamples);
+            for (uint32_t i = 0; i < kPeriodSamples; ++i) {
+                mic[i] += kEchoGain * echo_[echo_pos_];
+                echo_[echo_pos_] = far[i];
+                echo_pos_ = (echo_pos_ + 1) % echo_.size();
+            }
+
+            uint64_t pushed = NowNs();
+            RecordSamples(RecordTrack::kMicrophone, this, mic.data(), kPeriodSamples, kCaptureRate);
+            RecordSamples(RecordTrack::kSystem, this, far.data(), kPeriodSamples, kCaptureRate);
+            if (mic_ring_.AvailableToWrite() < kPeriodSamples || render_ring_.AvailableToWrite() < kPeriodSamples ||
+                pushed_.AvailableToWrite() < 1) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                mic_ring_.Write(mic.data(), kPeriodSamples);
+                render_ring_.Write(far.data(), kPeriodSamples);
+                pushed_.Write(&pushed, 1);
+                wake_.Signal();
+            }
+
+            next += period;
+            auto now = std::chrono::steady_clock::now();
+            if (now > next + period) {
+                // The capture thread itself fell a period behind; resync
+                overruns_.fetch_add(1, std::memory_order_relaxed);
+                next = now;
+            }
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    void ConsumerLoop() {
+        SetCurrentThreadPriority(ThreadPriority::kInteractive);
+        const uint64_t cpu_start = CurrentThreadCpuNs();
+        const uint64_t deadline_ns = static_cast<uint64_t>(kPeriodMs * 1e6);
+        for (;;) {
+            bool running = running_.load(std::memory_order_acquire);
+            uint64_t pushed;
+            while (pushed_.Read(&pushed, 1) == 1) {
+                mic_ring_.Read(mic_.data(), kPeriodSamples);
+                render_ring_.Read(render_.data(), kPeriodSamples);
+                graph_.ProcessRender(render_.data(), kPeriodSamples);
+                graph_.Process(mic_.data(), kPeriodSamples, &output_);
+                Deliver();
+                uint64_t latency = NowNs() - pushed;
+                latency_.Record(latency / 1000);
+                if (latency > deadline_ns) {
+                    misses_++;
+                }
+                buffers_++;
+            }
+            if (!running) {
+                break;
+            }
+            wake_.WaitFor(kConsumerWaitNs);
+        }
+        if (!assembler_->Empty()) {
+            deliveries_++;
+            assembler_->Clear();
+        }
+        consumer_cpu_ns_ = CurrentThreadCpuNs() - cpu_start;
+    }
+
+    // What CaptureStream does before the TSFN: whole chunks, each with its
+    // frames' speech probabilities. Encoded output is counted, not chunked.
+    void Deliver() {
+        encoded_bytes_ += output_.pcm16.size() * sizeof(int16_t) + output_.encoded.size();
+        const float* samples = output_.samples.data();
+        size_t remaining = output_.samples.size();
+        const float* vad = output_.vad.size() * (graph_.OutputSampleRate() / 100) == remaining
+            ? output_.vad.data() : nullptr;
+        const size_t frame = static_cast<size_t>(graph_.OutputSampleRate() / 100);
+        while (remaining > 0) {
+            size_t taken = assembler_->Append(samples, remaining, 0, output_index_, vad);
+            samples += taken;
+            remaining -= taken;
+            output_index_ += taken;
+            if (vad) {
+                vad += taken / frame;
+            }
+            if (assembler_->Ready()) {
+                deliveries_++;
+                assembler_->Clear();
+            }
+        }
+    }
+
+    const int index_;
+    const Options& options_;
+    SyntheticTalker near_;
+    SyntheticTalker far_;
+
+    SpscRingBuffer<float> mic_ring_;
+    SpscRingBuffer<float> render_ring_;
+    SpscRingBuffer<uint64_t> pushed_;  // each buffer's push time, NowNs()
+    Semaphore wake_;
+    std::atomic<bool> capturing_{true};
+    std::atomic<bool> running_{false};
+    std::thread capture_;
+    std::thread consumer_;
+
+    // Capture thread
+    std::vector<float> echo_;
+    size_t echo_pos_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> overruns_{0};
+
+    // Consumer thread
+    ProcessingGraph graph_;
+    std::unique_ptr<ChunkAssembler> assembler_;
+    GraphOutput output_;
+    std::vector<float> mic_;
+    std::vector<float> render_;
+    uint64_t output_index_ = 0;
+    uint64_t buffers_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t deliveries_ = 0;
+    uint64_t encoded_bytes_ = 0;
+    uint64_t consumer_cpu_ns_ = 0;
+    LatencyHistogram latency_;  // microseconds, push to delivered
+};
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, &options)) {
+        Usage();
+        return 2;
+    }
+    SetLogLevel(LogLevel::kWarn);
+
+    bool pinned = options.cores > 0 && PinToCores(options.cores);
+    if (options.cores > 0 && !pinned) {
+        std::fprintf(stderr, "cannot pin to %d cores here; running unpinned\n", options.cores);
+    }
+    unsigned cores = pinned ? static_cast<unsigned>(options.cores) : std::thread::hardware_concurrency();
+
+    std::string record_dir;
+    if (options.record) {
+        char pattern[] = "/tmp/session_load.XXXXXX";
+        if (!mkdtemp(pattern)) {
+            std::fprintf(stderr, "cannot create a recording directory\n");
+            return 1;
+        }
+        record_dir = pattern;
+    }
+
+    const double baseline_mb = PeakRssMb();
+    std::vector<std::unique_ptr<Session>> sessions;
+    for (int i = 0; i < options.sessions; ++i) {
+        auto session = std::make_unique<Session>(i, options);
+        std::string error;
+        if (!session->Prepare(&error)) {
+            std::fprintf(stderr, "graph '%s': %s\n", options.graph.c_str(), error.c_str());
+            return 1;
+        }
+        sessions.push_back(std::move(session));
+    }
+    const double prepared_mb = PeakRssMb();
+
+    if (options.record) {
+        RecorderOptions recorder;
+        recorder.directory = record_dir;
+        recorder.name = "load";
+        recorder.tracks[static_cast<size_t>(RecordTrack::kProcessed)] = false;
+        std::string error;
+        if (!StartRecording(recorder, &error)) {
+            std::fprintf(stderr, "recorder: %s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    const uint64_t started = NowNs();
+    for (auto& session : sessions) {
+        session->Start();
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+    for (auto& session : sessions) {
+        session->Stop();
+    }
+    const double wall_ms = (NowNs() - started) / 1e6;
+    RecordingSummary recording = options.record ? StopRecording() : RecordingSummary();
+    FlushLog();
+    const double peak_mb = PeakRssMb();
+
+    uint64_t buffers = 0, dropped = 0, misses = 0, overruns = 0, cpu_ns = 0;
+    double audio_ms = 0.0;
+    for (const auto& session : sessions) {
+        buffers += session->Buffers();
+        dropped += session->Dropped();
+        misses += session->DeadlineMisses();
+        overruns += session->CaptureOverruns();
+        cpu_ns += session->ConsumerCpuNs();
+        audio_ms += session->AudioMs();
+    }
+    uint64_t recorded_samples = 0;
+    for (const RecordedFile& file : recording.files) {
+        recorded_samples += file.samples;
+    }
+    const double per_session_mb = (prepared_mb - baseline_mb) / options.sessions;
+
+    if (options.json) {
+        std::printf("{\n  \"sessions\": %d,\n  \"cores\": %u,\n  \"pinned\": %s,\n  \"graph\": \"%s\",\n",
+                    options.sessions, cores, pinned ? "true" : "false", options.graph.c_str());
+        std::printf("  \"wallMs\": %.1f,\n  \"audioMs\": %.1f,\n  \"realtimeSessions\": %.2f,\n", wall_ms, audio_ms,
+                    wall_ms > 0.0 ? audio_ms / wall_ms : 0.0);
+        std::printf("  \"buffers\": %llu,\n  \"dropped\": %llu,\n  \"deadlineMisses\": %llu,\n"
+                    "  \"captureOverruns\": %llu,\n  \"cpuMsPerSessionSecond\": %.2f,\n",
+                    static_cast<unsigned long long>(buffers), static_cast<unsigned long long>(dropped),
+                    static_cast<unsigned long long>(misses), static_cast<unsigned long long>(overruns),
+                    audio_ms > 0.0 ? cpu_ns / 1e6 * 1000.0 / audio_ms : 0.0);
+        std::printf("  \"memoryMbPerSession\": %.2f,\n  \"peakRssMb\": %.1f,\n  \"recordedSamples\": %llu,\n",
+                    per_session_mb, peak_mb, static_cast<unsigned long long>(recorded_samples));
+        std::printf("  \"perSession\": [\n");
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            const Session& session = *sessions[i];
+            LatencySummary latency = session.Latency();
+            std::printf("    { \"buffers\": %llu, \"dropped\": %llu, \"deadlineMisses\": %llu, \"deliveries\": %llu, "
+                        "\"latencyUs\": { \"p50\": %llu, \"p99\": %llu, \"max\": %llu }, \"cpuMs\": %.1f }%s\n",
+                        static_cast<unsigned long long>(session.Buffers()),
+                        static_cast<unsigned long long>(session.Dropped()),
+                        static_cast<unsigned long long>(session.DeadlineMisses()),
+                        static_cast<unsigned long long>(session.Deliveries()),
+                        static_cast<unsigned long long>(latency.p50), static_cast<unsigned long long>(latency.p99),
+                        static_cast<unsigned long long>(latency.max), session.ConsumerCpuNs() / 1e6,
+                        i + 1 < sessions.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+        return misses > 0 || dropped > 0 ? 3 : 0;
+    }
+
+    std::printf("%d session(s) on %u core(s)%s, graph %s, %.1f s\n", options.sessions, cores,
+                pinned ? " (pinned)" : "", options.graph.c_str(), wall_ms / 1000.0);
+    std::printf("%-8s %10s %8s %8s %10s %10s %10s %10s %10s\n", "session", "buffers", "dropped", "missed",
+                "deliveries", "p50 us", "p99 us", "max us", "cpu ms");
+    for (const auto& session : sessions) {
+        LatencySummary latency = session->Latency();
+        std::printf("%-8d %10llu %8llu %8llu %10llu %10llu %10llu %10llu %10.1f\n", session->Index(),
+                    static_cast<unsigned long long>(session->Buffers()),
+                    static_cast<unsigned long long>(session->Dropped()),
+                    static_cast<unsigned long long>(session->DeadlineMisses()),
+                    static_cast<unsigned long long>(session->Deliveries()),
+                    static_cast<unsigned long long>(latency.p50), static_cast<unsigned long long>(latency.p99),
+                    static_cast<unsigned long long>(latency.max), session->ConsumerCpuNs() / 1e6);
+    }
+    std::printf("throughput        %.2f sessions of real-time audio\n", wall_ms > 0.0 ? audio_ms / wall_ms : 0.0);
+    std::printf("cpu               %.2f ms per session-second\n",
+                audio_ms > 0.0 ? cpu_ns / 1e6 * 1000.0 / audio_ms : 0.0);
+    std::printf("deadline misses   %llu of %llu buffers (%llu dropped, %llu capture overruns)\n",
+                static_cast<unsigned long long>(misses), static_cast<unsigned long long>(buffers),
+                static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(overruns));
+    std::printf("memory            %.2f MB per session, peak RSS %.1f MB\n", per_session_mb, peak_mb);
+    if (options.record) {
+        std::printf("recorded          %llu samples to %s\n", static_cast<unsigned long long>(recorded_samples),
+                    record_dir.c_str());
+    }
+    return misses > 0 || dropped > 0 ? 3 : 0;
+}
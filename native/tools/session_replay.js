@@ -0,0 +1,59 @@
+#!/usr/bin/env node
+// Replays a startSessionCapture() file through the addon's capture streams
+// and echo canceller and prints their stats as JSON, so a stall or drop seen
+// in the field can be rerun, and before/after numbers compared, on any
+// machine.
+//
+//   npm run replay -- session.kksc [--speed N] [--processed] [--chunk-ms N]
+//                     [--preset aggressive|default|lowCpu|headphones]
+//
+// --speed 1 (default) keeps the captured timing, N runs N times faster and 0
+// as fast as the pipeline takes it. --processed delivers the mic through
+// the native AEC, with the system track as its render.
+
+'use strict';
+
+const path = require('path');
+const addon = require(path.join(__dirname, '..', 'build', 'Release', 'audio_capture_native.node'));
+
+function parseArgs(argv) {
+  const args = { file: null, speed: 1, processed: false, chunkMs: 0, preset: undefined };
+  for (let i = 0; i < argv.length; ++i) {
+    const arg = argv[i];
+    if (arg === '--speed') args.speed = Number(argv[++i]);
+    else if (arg === '--processed') args.processed = true;
+    else if (arg === '--chunk-ms') args.chunkMs = Number(argv[++i]);
+    else if (arg === '--preset') args.preset = argv[++i];
+    else if (!args.file) args.file = arg;
+    else throw new Error(`Unexpected argument: ${arg}`);
+  }
+  if (!args.file) throw new Error('Usage: session_replay <capture> [--speed N] [--processed] [--chunk-ms N] [--preset name]');
+  return args;
+}
+
+async function main() {
+  const args = parseArgs(process.argv.slice(2));
+  const replay = new addon.SessionReplay(args.file, args.preset ? { preset: args.preset } : undefined);
+  const info = replay.getInfo();
+  process.stderr.write(`${args.file}: ${(info.durationMs / 1000).toFixed(1)}s, ` +
+    `${info.buffers.microphone} mic / ${info.buffers.system} system buffers\n`);
+
+  let deliveries = 0;
+  const onDelivery = () => { deliveries++; };
+  const streamOptions = args.chunkMs > 0 ? { chunkMs: args.chunkMs } : {};
+  process.on('SIGINT', () => replay.stop());
+  const report = await replay.start({
+    speed: args.speed,
+    onMicrophone: onDelivery,
+    microphoneOptions: { ...streamOptions, processed: args.processed },
+    onSystem: onDelivery,
+    systemOptions: streamOptions,
+  });
+  report.jsDeliveries = deliveries;
+  process.stdout.write(`${JSON.stringify(report, null, 2)}\n`);
+}
+
+main().catch((error) => {
+  process.stderr.write(`${error.message}\n`);
+  process.exit(1);
+});
@@ -0,0 +1,182 @@
+#!/usr/bin/env node
+// Soaks the full native pipeline: replays a startSessionCapture() file back
+// to back, accelerated, through the addon's capture streams and echo
+// canceller for hours of audio, sampling memory, queues, drift and latency
+// as it goes. Exits 1, with the report, when a series keeps growing or a
+// sample crosses its limit: the problems that show two hours into a
+// meeting, in minutes.
+//
+//   npm run soak -- session.kksc [--hours N] [--speed N] [--processed]
+//                   [--sample-s N] [--max-rss-mb N] [--max-queue N]
+//                   [--max-latency-ms N] [--max-drift-ppm N]
+//
+// --hours is of replayed audio (default 8), --speed the replay's (default
+// 32, at most 64). A series "keeps growing" when, past the first tenth of
+// the run, each quarter's median is above the last and the rise is more
+// than --growth-pct (default 5) and --growth-mb (default 8) for byte series.
+
+'use strict';
+
+const path = require('path');
+const addon = require(path.join(__dirname, '..', 'build', 'Release', 'audio_capture_native.node'));
+
+function parseArgs(argv) {
+  const args = {
+    file: null, hours: 8, speed: 32, processed: false, sampleS: 10, maxRssMb: 1024, maxQueue: 64,
+    maxLatencyMs: 250, maxDriftPpm: 1000, growthPct: 5, growthMb: 8,
+  };
+  const numbers = {
+    '--hours': 'hours', '--speed': 'speed', '--sample-s': 'sampleS', '--max-rss-mb': 'maxRssMb',
+    '--max-queue': 'maxQueue', '--max-latency-ms': 'maxLatencyMs', '--max-drift-ppm': 'maxDriftPpm',
+    '--growth-pct': 'growthPct', '--growth-mb': 'growthMb',
+  };
+  for (let i = 0; i < argv.length; ++i) {
+    const arg = argv[i];
+    if (numbers[arg]) args[numbers[arg]] = Number(argv[++i]);
+    else if (arg === '--processed') args.processed = true;
+    else if (!args.file) args.file = arg;
+    else throw new Error(`Unexpected argument: ${arg}`);
+  }
+  if (!args.file) throw new Error('Usage: soak <capture> [--hours N] [--speed N] [--processed] [--sample-s N] ...');
+  for (const key of Object.values(numbers)) {
+    if (!Number.isFinite(args[key]) || args[key] < 0) throw new Error(`Bad value for ${key}`);
+  }
+  if (args.speed <= 0) throw new Error('--speed must be positive; a soak is paced');
+  return args;
+}
+
+// The figures watched, from one replay getStats() and the process
+function takeSample(replay, startedAt) {
+  const stats = replay.getStats();
+  if (!stats) return null;
+  const memory = process.memoryUsage();
+  const sample = {
+    elapsedS: (Date.now() - startedAt) / 1000,
+    audioS: stats.audioMs / 1000,
+    passes: stats.passes,
+    rssBytes: memory.rss,
+    heapUsedBytes: memory.heapUsed,
+    externalBytes: memory.external,
+    arrayBufferBytes: memory.arrayBuffers,
+    nativeBytes: 0,
+    schedulerQueue: 0,
+    queuePeak: 0,
+    tsfnRejections: 0,
+    deliveriesDropped: 0,
+    buffersDropped: 0,
+    latencyP99Ms: 0,
+    driftPpm: stats.aec && typeof stats.aec.renderDriftPpm === 'number' ? stats.aec.renderDriftPpm : null,
+  };
+  if (typeof addon.getNativeMemory === 'function') {
+    const native = addon.getNativeMemory();
+    sample.nativeBytes = native.components.reduce((sum, component) => sum + component.bytes, 0);
+  }
+  if (typeof addon.getSchedulerStats === 'function') {
+    sample.schedulerQueue = addon.getSchedulerStats().queueDepth;
+  }
+  for (const name of ['microphone', 'system']) {
+    const stream = stats[name];
+    if (!stream) continue;
+    sample.queuePeak = Math.max(sample.queuePeak, stream.queuePeak);
+    sample.tsfnRejections += stream.tsfnRejections;
+    sample.deliveriesDropped += stream.deliveriesDropped;
+    sample.buffersDropped += stream.buffersDropped;
+    sample.latencyP99Ms = Math.max(sample.latencyP99Ms, stream.latency.total.p99Ms);
+  }
+  return sample;
+}
+
+const kGrowthSeries = ['rssBytes', 'heapUsedBytes', 'externalBytes', 'arrayBufferBytes', 'nativeBytes', 'schedulerQueue'];
+
+function median(values) {
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted[Math.floor(sorted.length / 2)];
+}
+
+// Each quarter's median above the last, and by more than noise
+function growth(samples, series, args) {
+  const settled = samples.slice(Math.floor(samples.length / 10));
+  if (settled.length < 8) return null;
+  const quarter = Math.floor(settled.length / 4);
+  const medians = [0, 1, 2, 3].map((q) => median(settled.slice(q * quarter, (q + 1) * quarter).map((s) => s[series])));
+  if (!medians.every((value, q) => q === 0 || value > medians[q - 1])) return null;
+  const rise = medians[3] - medians[0];
+  const bytes = series.endsWith('Bytes');
+  if (rise <= medians[0] * args.growthPct / 100 || (bytes && rise <= args.growthMb * 1024 * 1024)) return null;
+  return { series, quarterMedians: medians, rise };
+}
+
+function limits(sample, args) {
+  const failures = [];
+  const over = (name, value, limit) => {
+    if (value > limit) failures.push({ limit: name, value, max: limit, atAudioS: sample.audioS });
+  };
+  over('rssMb', sample.rssBytes / (1024 * 1024), args.maxRssMb);
+  over('queuePeak', sample.queuePeak, args.maxQueue);
+  over('latencyP99Ms', sample.latencyP99Ms, args.maxLatencyMs);
+  if (sample.driftPpm !== null) over('driftPpm', Math.abs(sample.driftPpm), args.maxDriftPpm);
+  return failures;
+}
+
+async function main() {
+  const args = parseArgs(process.argv.slice(2));
+  const replay = new addon.SessionReplay(args.file);
+  const info = replay.getInfo();
+  if (!(info.durationMs > 0)) throw new Error(`${args.file} holds no audio`);
+  const loops = Math.max(1, Math.ceil(args.hours * 3600 * 1000 / info.durationMs));
+  process.stderr.write(`${args.file}: ${(info.durationMs / 1000).toFixed(1)}s x ${loops} at ${args.speed}x, ` +
+    `~${(loops * info.durationMs / args.speed / 60000).toFixed(0)} min\n`);
+
+  let deliveries = 0;
+  const onDelivery = () => { deliveries++; };
+  const samples = [];
+  const failures = [];
+  const startedAt = Date.now();
+  const timer = setInterval(() => {
+    const sample = takeSample(replay, startedAt);
+    if (!sample) return;
+    samples.push(sample);
+    // The first crossing of each limit
+    for (const failure of limits(sample, args)) {
+      if (!failures.some((seen) => seen.limit === failure.limit)) failures.push(failure);
+    }
+    process.stderr.write(`${(sample.audioS / 3600).toFixed(2)}h: rss ${(sample.rssBytes / 1048576).toFixed(0)}MB, ` +
+      `native ${(sample.nativeBytes / 1048576).toFixed(1)}MB, queue peak ${sample.queuePeak}, ` +
+      `p99 ${sample.latencyP99Ms.toFixed(1)}ms\n`);
+  }, args.sampleS * 1000);
+  process.on('SIGINT', () => replay.stop());
+
+  const report = await replay.start({
+    speed: args.speed,
+    loops,
+    onMicrophone: onDelivery,
+    microphoneOptions: { processed: args.processed },
+    onSystem: onDelivery,
+  });
+  clearInterval(timer);
+
+  for (const series of kGrowthSeries) {
+    const grew = growth(samples, series, args);
+    if (grew) failures.push({ growth: grew.series, quarterMedians: grew.quarterMedians, rise: grew.rise });
+  }
+  if (!report.completed) failures.push({ stopped: 'replay stopped before its last pass' });
+
+  const passed = failures.length === 0;
+  process.stdout.write(`${JSON.stringify({
+    passed,
+    failures,
+    args,
+    passes: report.passes,
+    audioHours: report.audioMs / 3600000,
+    elapsedMinutes: report.elapsedMs / 60000,
+    jsDeliveries: deliveries,
+    samples,
+    report,
+  }, null, 2)}\n`);
+  process.exit(passed ? 0 : 1);
+}
+
+main().catch((error) => {
+  process.stderr.write(`${error.message}\n`);
+  process.exit(1);
+});
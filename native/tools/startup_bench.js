@@ -0,0 +1,169 @@
+#!/usr/bin/env node
+// Times the native share of launch and record start and prints it as JSON:
+// loading the module (dlopen with libwebrtc, static init), constructing
+// AudioCaptureAddon (the APM build), prepareMicrophoneCapture(),
+// startMicrophoneCapture() and the first delivered sample, per input
+// device, so startup work has a number to be held to.
+//
+//   npm run bench:startup -- [--runs N] [--device <id> | --all-devices]
+//                            [--preset aggressive|default|lowCpu|headphones]
+//                            [--processed] [--timeout-ms N]
+//
+// Every run is a process of its own, so each load is a real dlopen (the
+// page cache is warm after the first). Without --device or --all-devices
+// the default input is measured. firstSampleMs runs from the start call to
+// the first JS delivery; startToFirstCallbackMs is the addon's own reading,
+// to the first device callback.
+
+'use strict';
+
+const path = require('path');
+const { execFileSync } = require('child_process');
+
+const modulePath = path.join(__dirname, '..', 'build', 'Release', 'audio_capture_native.node');
+
+const kMetrics = ['loadMs', 'constructMs', 'prepareMs', 'startMs', 'firstSampleMs', 'startToFirstCallbackMs'];
+
+function parseArgs(argv) {
+  const args = { child: false, runs: 5, device: null, allDevices: false, preset: undefined, processed: false,
+    timeoutMs: 5000 };
+  for (let i = 0; i < argv.length; ++i) {
+    const arg = argv[i];
+    if (arg === '--child') args.child = true;
+    else if (arg === '--runs') args.runs = Number(argv[++i]);
+    else if (arg === '--device') args.device = argv[++i];
+    else if (arg === '--all-devices') args.allDevices = true;
+    else if (arg === '--preset') args.preset = argv[++i];
+    else if (arg === '--processed') args.processed = true;
+    else if (arg === '--timeout-ms') args.timeoutMs = Number(argv[++i]);
+    else throw new Error(`Unexpected argument: ${arg}`);
+  }
+  if (!Number.isInteger(args.runs) || args.runs < 1) throw new Error('--runs must be a positive integer');
+  return args;
+}
+
+const nowMs = () => Number(process.hrtime.bigint()) / 1e6;
+
+// One run, in this process: one JSON line on stdout
+async function runChild(args) {
+  const loadStart = nowMs();
+  const addon = require(modulePath);
+  const result = { loadMs: nowMs() - loadStart };
+
+  const constructStart = nowMs();
+  const capture = new addon.AudioCaptureAddon(args.preset ? { preset: args.preset } : {});
+  result.constructMs = nowMs() - constructStart;
+
+  if (args.device !== null) {
+    capture.setInputDevice(args.device);
+  }
+  const options = { processed: args.processed };
+
+  const prepareStart = nowMs();
+  if (!await capture.prepareMicrophoneCapture(options)) {
+    throw new Error('prepareMicrophoneCapture() refused');
+  }
+  result.prepareMs = nowMs() - prepareStart;
+
+  let firstSample;
+  const delivered = new Promise((resolve) => { firstSample = resolve; });
+  let timer;
+  const timedOut = new Promise((_, reject) => {
+    timer = setTimeout(() => reject(new Error(`No sample within ${args.timeoutMs}ms`)), args.timeoutMs);
+  });
+
+  const startStart = nowMs();
+  const started = capture.startMicrophoneCapture(() => firstSample(nowMs()), options);
+  if (!await started) {
+    throw new Error('startMicrophoneCapture() refused');
+  }
+  result.startMs = nowMs() - startStart;
+
+  try {
+    result.firstSampleMs = await Promise.race([delivered, timedOut]) - startStart;
+  } finally {
+    clearTimeout(timer);
+    result.startToFirstCallbackMs = capture.getCaptureStats().mic.startToFirstCallbackMs;
+    await capture.stopMicrophoneCapture();
+  }
+  process.stdout.write(`${JSON.stringify(result)}\n`);
+}
+
+function inputDevices() {
+  const addon = require(modulePath);
+  const capture = new addon.AudioCaptureAddon({});
+  return capture.getDevices().filter((device) => device.inputChannels > 0);
+}
+
+function summarize(values) {
+  if (values.length === 0) return null;
+  const sorted = [...values].sort((a, b) => a - b);
+  const at = (q) => sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))];
+  const round = (value) => Math.round(value * 1000) / 1000;
+  return {
+    min: round(sorted[0]),
+    median: round(at(0.5)),
+    p90: round(at(0.9)),
+    max: round(sorted[sorted.length - 1]),
+    mean: round(values.reduce((sum, value) => sum + value, 0) / values.length),
+  };
+}
+
+function benchDevice(args, device) {
+  const childArgs = [__filename, '--child', '--timeout-ms', String(args.timeoutMs)];
+  if (device) childArgs.push('--device', String(device.id));
+  if (args.preset) childArgs.push('--preset', args.preset);
+  if (args.processed) childArgs.push('--processed');
+
+  const samples = Object.fromEntries(kMetrics.map((metric) => [metric, []]));
+  const failures = [];
+  for (let run = 0; run < args.runs; ++run) {
+    try {
+      const line = execFileSync(process.execPath, childArgs, { encoding: 'utf8', stdio: ['ignore', 'pipe', 'pipe'] });
+      const result = JSON.parse(line.trim().split('\n').pop());
+      for (const metric of kMetrics) {
+        if (typeof result[metric] === 'number') samples[metric].push(result[metric]);
+      }
+    } catch (error) {
+      failures.push(((error.stderr && error.stderr.toString().trim()) || error.message).split('\n').pop());
+    }
+  }
+  process.stderr.write(`${device ? device.name : 'default input'}: ${args.runs - failures.length}/${args.runs} runs\n`);
+  return {
+    id: device ? device.id : null,
+    name: device ? device.name : 'default',
+    runs: args.runs - failures.length,
+    failures,
+    metrics: Object.fromEntries(kMetrics.map((metric) => [metric, summarize(samples[metric])])),
+  };
+}
+
+async function main() {
+  const args = parseArgs(process.argv.slice(2));
+  if (args.child) {
+    await runChild(args);
+    process.exit(0);
+  }
+
+  let devices = [null];
+  if (args.allDevices) {
+    devices = inputDevices();
+  } else if (args.device !== null) {
+    devices = [inputDevices().find((device) => String(device.id) === args.device) || { id: args.device, name: args.device }];
+  }
+  const report = {
+    platform: process.platform,
+    arch: process.arch,
+    node: process.versions.node,
+    runs: args.runs,
+    preset: args.preset || 'default',
+    processed: args.processed,
+    devices: devices.map((device) => benchDevice(args, device)),
+  };
+  process.stdout.write(`${JSON.stringify(report, null, 2)}\n`);
+}
+
+main().catch((error) => {
+  process.stderr.write(`${error.message}\n`);
+  process.exit(1);
+});
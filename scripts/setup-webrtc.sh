@@ -3,18 +3,50 @@ set -e
 
 echo "🎛️ Setting up WebRTC library for AEC3..."
 
+SCRIPT="$(cd "$(dirname "$0")" && pwd)/$(basename "$0")"
+
 # Create directories
 mkdir -p native/webrtc/lib
 mkdir -p native/webrtc/include
 
 cd native/webrtc
 
-# Detect architecture
-ARCH=$(uname -m)
-if [ "$ARCH" = "arm64" ]; then
-    WEBRTC_ARCH="arm64"
-else
-    WEBRTC_ARCH="x64"
+# --universal: fetch both macOS slices and lipo each archive into one, for
+# `npm run build:universal` in native/
+if [ "$1" = "--universal" ]; then
+    echo "Fetching arm64 and x64 for a universal build"
+    rm -rf stage
+    for SLICE in arm64 x64; do
+        mkdir -p "stage/$SLICE"
+        (cd "stage/$SLICE" && WEBRTC_ARCH="$SLICE" bash "$SCRIPT")
+    done
+    for LIB in stage/arm64/native/webrtc/lib/*.a; do
+        NAME=$(basename "$LIB")
+        if [ -f "stage/x64/native/webrtc/lib/$NAME" ]; then
+            lipo -create "$LIB" "stage/x64/native/webrtc/lib/$NAME" -output "lib/$NAME"
+        else
+            echo "⚠️ $NAME has no x64 slice; skipped"
+        fi
+    done
+    cp -r stage/arm64/native/webrtc/include/* include/
+    rm -rf stage
+    echo ""
+    lipo -info lib/libwebrtc.a
+    echo "🎉 Universal WebRTC setup complete!"
+    echo ""
+    echo "Next steps:"
+    echo "  cd native && npm run build:universal"
+    exit 0
+fi
+
+# Detect architecture, unless a universal setup picked the slice
+if [ -z "$WEBRTC_ARCH" ]; then
+    ARCH=$(uname -m)
+    if [ "$ARCH" = "arm64" ]; then
+        WEBRTC_ARCH="arm64"
+    else
+        WEBRTC_ARCH="x64"
+    fi
 fi
 
 echo "Detected architecture: $WEBRTC_ARCH"
@@ -100,8 +132,10 @@ elif [ -d "webrtc" ]; then
     fi
     rm -rf webrtc
 else
-    # Try to find libwebrtc.a anywhere in extracted content
+    # Try to find libwebrtc.a (and the denormal disabler it ships beside it)
+    # anywhere in extracted content
     find . -name "libwebrtc.a" -exec cp {} lib/ \; 2>/dev/null || true
+    find . -name "libdenormal_disabler.a" -exec cp {} lib/ \; 2>/dev/null || true
     # Copy all headers maintaining directory structure
     if [ -d "include" ]; then
         echo "Headers already in place"
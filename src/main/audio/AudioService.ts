@@ -170,6 +170,11 @@ export class AudioService {
 
       this.aecProcessor = new AECProcessor(aecConfig);
       logger.info("WebRTC AEC processor initialized");
+      if (this.config.disableAecOnHeadphones) {
+        // The addon watches the output route and bypasses (rather than
+        // disables) AEC itself, so it is still converged when they come out
+        this.aecProcessor.setHeadphoneBypass('auto');
+      }
 
       // Optional: Log AEC metrics every 5 seconds
       this.aecMetricsInterval = setInterval(() => {
@@ -181,6 +186,8 @@ export class AudioService {
               rerl: metrics.rerl,
               residualEchoLevel: metrics.residualEchoLevel,
               renderDelayMs: metrics.renderDelayMs,
+              divergentFilterFraction: metrics.divergentFilterFraction,
+              residualEchoLikelihood: metrics.residualEchoLikelihood,
               converged: metrics.converged,
             });
           }
@@ -0,0 +1,86 @@
+import { app } from 'electron';
+import { join } from 'path';
+import { existsSync, mkdirSync, readFileSync, writeFileSync } from 'fs';
+import { createLogger } from '../core/logger';
+import { EXPORT_CONFIG } from '../config/constants';
+import type { AECProfile, AECWarmStart } from './native/AECProcessor';
+
+const logger = createLogger('AECProfiles');
+
+// Converged AEC state per output/input device pair, so a meeting on known
+// hardware starts from where the last one settled
+const PROFILES_FILE = 'aec-profiles.json';
+
+type ProfileMap = Record<string, AECWarmStart & { updatedAt: number }>;
+
+function profilesPath(): string {
+  return join(app.getPath('userData'), EXPORT_CONFIG.DATA_DIR, PROFILES_FILE);
+}
+
+function profileKey(inputDeviceUid: string, outputDeviceUid: string): string {
+  return `${inputDeviceUid}|${outputDeviceUid}`;
+}
+
+function readProfiles(): ProfileMap {
+  const path = profilesPath();
+  if (!existsSync(path)) {
+    return {};
+  }
+  try {
+    return JSON.parse(readFileSync(path, 'utf8')) as ProfileMap;
+  } catch (error) {
+    logger.warn('Ignoring unreadable AEC profiles', { error: (error as Error).message });
+    return {};
+  }
+}
+
+export function loadAecProfile(inputDeviceUid: string, outputDeviceUid: string): AECWarmStart | null {
+  const profile = readProfiles()[profileKey(inputDeviceUid, outputDeviceUid)];
+  if (!profile) {
+    return null;
+  }
+  const { echoDelayMs, streamDelayMs, preset } = profile;
+  return { echoDelayMs, streamDelayMs, preset };
+}
+
+/** Every stored profile with its device pair, for AECProcessor.setAecProfiles() */
+export function listAecProfiles(): AECProfile[] {
+  return Object.entries(readProfiles()).map(([key, { echoDelayMs, streamDelayMs, preset }]) => {
+    const [inputDeviceUid, outputDeviceUid] = key.split('|');
+    return { inputDeviceUid, outputDeviceUid, echoDelayMs, streamDelayMs, preset };
+  });
+}
+
+/**
+ * Merges what the session learned into the stored profile; fields it did not
+ * settle keep their previous values. Profiles without device UIDs are not
+ * stored, since they cannot be matched to hardware later.
+ */
+export function saveAecProfile(profile: AECProfile): void {
+  const { inputDeviceUid, outputDeviceUid, echoDelayMs, streamDelayMs, preset } = profile;
+  if (!inputDeviceUid || !outputDeviceUid) {
+    return;
+  }
+  if (echoDelayMs === undefined && streamDelayMs === undefined && preset === undefined) {
+    return;
+  }
+
+  const profiles = readProfiles();
+  const key = profileKey(inputDeviceUid, outputDeviceUid);
+  const learned = Object.fromEntries(
+    Object.entries({ echoDelayMs, streamDelayMs, preset }).filter(([, value]) => value !== undefined)
+  );
+  profiles[key] = { ...profiles[key], ...learned, updatedAt: Date.now() };
+
+  try {
+    const path = profilesPath();
+    const dir = join(app.getPath('userData'), EXPORT_CONFIG.DATA_DIR);
+    if (!existsSync(dir)) {
+      mkdirSync(dir, { recursive: true });
+    }
+    writeFileSync(path, JSON.stringify(profiles, null, 2));
+    logger.info('Saved AEC profile', { key, ...learned });
+  } catch (error) {
+    logger.warn('Failed to save AEC profile', { error: (error as Error).message });
+  }
+}
@@ -0,0 +1,304 @@
+import { utilityProcess, type UtilityProcess } from 'electron';
+import { join } from 'path';
+import { createLogger } from '../../core/logger';
+import { AUDIO_ENGINE_CONFIG } from '../../config/constants';
+import type { AECConfig, RecordingOptions, RecordingSummary } from '../native/AECProcessor';
+import type { NativeSharedMemoryRing, SharedRingDelivery } from '../native/SharedCaptureRing';
+import {
+  ENGINE_CONFIG_ENV,
+  type EngineCaptureOptions,
+  type EngineMessage,
+  type EngineRequest,
+  type EngineStats,
+  type EngineStream,
+} from './protocol';
+
+const logger = createLogger('AudioEngineHost');
+
+// Distributive, so each request keeps its own fields without the id
+type EngineCall = EngineRequest extends infer R ? (R extends EngineRequest ? Omit<R, 'id'> : never) : never;
+
+interface PendingRequest {
+  resolve: (result: unknown) => void;
+  reject: (error: Error) => void;
+  timer: ReturnType<typeof setTimeout>;
+}
+
+interface EngineRing {
+  ring: NativeSharedMemoryRing;
+  onDelivery: (delivery: SharedRingDelivery) => void;
+}
+
+export interface AudioEngineHostOptions {
+  aec?: AECConfig;
+  /** Maps a stream's ring by name: AECProcessor.openSharedMemoryRing() */
+  openRing: (name: string) => NativeSharedMemoryRing | null;
+  /** The engine exited without stop(); its streams are gone */
+  onExit?: (code: number) => void;
+}
+
+/**
+ * The app's side of the audio engine process: forks it, drives it over the
+ * control channel and drains each stream's shared memory ring every
+ * POLL_MS. The rings hold RING_SECONDS, so a main-process stall up to that
+ * long loses nothing, and capture never waits on this process at all.
+ */
+export class AudioEngineHost {
+  private child: UtilityProcess | null = null;
+  private nextId = 1;
+  private ringCount = 0;
+  private readonly pending = new Map<number, PendingRequest>();
+  private readonly rings = new Map<EngineStream, EngineRing>();
+  private pollTimer: ReturnType<typeof setInterval> | null = null;
+  private stopping = false;
+
+  constructor(private readonly options: AudioEngineHostOptions) {}
+
+  public isRunning(): boolean {
+    return this.child !== null;
+  }
+
+  /**
+   * Forks the engine; false when it does not come up with the addon loaded
+   * within REQUEST_TIMEOUT_MS
+   */
+  public start(): Promise<boolean> {
+    if (this.child) {
+      return Promise.resolve(true);
+    }
+    this.stopping = false;
+    const child = utilityProcess.fork(join(__dirname, AUDIO_ENGINE_CONFIG.ENTRY), [], {
+      serviceName: 'Kakarot Audio Engine',
+      env: { ...process.env, [ENGINE_CONFIG_ENV]: JSON.stringify({ aec: this.options.aec ?? {} }) },
+      stdio: 'inherit',
+    });
+    this.child = child;
+
+    return new Promise((resolve) => {
+      let ready = false;
+      // A recording waits on this; an engine that hangs loading is killed,
+      // and its exit resolves false
+      const timer = setTimeout(() => {
+        logger.error('Audio engine did not come up');
+        this.stopping = true;
+        child.kill();
+      }, AUDIO_ENGINE_CONFIG.REQUEST_TIMEOUT_MS);
+      child.on('message', (message: EngineMessage) => {
+        if (message.type === 'ready') {
+          ready = true;
+          clearTimeout(timer);
+          if (!message.ok) {
+            logger.error('Audio engine has no native audio', { error: message.error });
+          } else {
+            logger.info('Audio engine started', { pid: child.pid });
+          }
+          resolve(message.ok);
+          return;
+        }
+        const request = this.pending.get(message.id);
+        if (!request) {
+          return;
+        }
+        this.pending.delete(message.id);
+        clearTimeout(request.timer);
+        if (message.ok) {
+          request.resolve(message.result);
+        } else {
+          request.reject(new Error(message.error));
+        }
+      });
+      child.on('exit', (code) => {
+        clearTimeout(timer);
+        this.onChildExit(child, code);
+        if (!ready) {
+          resolve(false);
+        }
+      });
+    });
+  }
+
+  /**
+   * Starts |stream| in the engine with |options| (no sharedRing or
+   * transport: the ring is made here and drained into |onDelivery|, whose
+   * samples are copies it may keep)
+   */
+  public async startCapture(
+    stream: EngineStream,
+    options: EngineCaptureOptions,
+    onDelivery: (delivery: SharedRingDelivery) => void
+  ): Promise<boolean> {
+    if (!this.child) {
+      return false;
+    }
+    await this.stopCapture(stream);
+    const name = `kkae-${process.pid}-${stream}-${++this.ringCount}`;
+    const pcm16 = options.format === 'pcm16' || options.format === 's16le';
+    try {
+      await this.request({
+        type: 'start',
+        stream,
+        // Without an output rate the device's may be up to 48kHz
+        ring: {
+          name,
+          sampleRate: options.outputSampleRate ?? 48000,
+          seconds: AUDIO_ENGINE_CONFIG.RING_SECONDS,
+          format: pcm16 ? 'pcm16' : 'float32',
+        },
+        options,
+      });
+    } catch (error) {
+      logger.error('Audio engine capture failed to start', { stream, error: (error as Error).message });
+      return false;
+    }
+    const ring = this.options.openRing(name);
+    if (!ring) {
+      await this.request({ type: 'stop', stream }).catch(() => undefined);
+      return false;
+    }
+    this.rings.set(stream, { ring, onDelivery });
+    this.pollTimer ??= setInterval(() => this.drain(), AUDIO_ENGINE_CONFIG.POLL_MS);
+    return true;
+  }
+
+  /** Stops |stream| in the engine, then delivers what its ring still holds */
+  public async stopCapture(stream: EngineStream): Promise<void> {
+    const entry = this.rings.get(stream);
+    if (!entry) {
+      return;
+    }
+    await this.request({ type: 'stop', stream }).catch((error) =>
+      logger.warn('Audio engine capture failed to stop', { stream, error: (error as Error).message })
+    );
+    try {
+      entry.ring.read(entry.onDelivery);
+    } catch (error) {
+      logger.error('Audio engine delivery handler failed', { stream, error: (error as Error).message });
+    }
+    this.rings.delete(stream);
+    const dropped = entry.ring.dropped();
+    entry.ring.close();
+    if (dropped > 0) {
+      logger.warn('Audio engine ring dropped deliveries', { stream, dropped });
+    }
+    if (this.rings.size === 0 && this.pollTimer) {
+      clearInterval(this.pollTimer);
+      this.pollTimer = null;
+    }
+  }
+
+  /** Pauses or resumes the mic's device IO in the engine; false when it did not */
+  public async setMicrophonePaused(paused: boolean): Promise<boolean> {
+    if (!this.rings.has('mic')) {
+      return false;
+    }
+    try {
+      return (await this.request({ type: paused ? 'pause' : 'resume' })) as boolean;
+    } catch (error) {
+      logger.warn('Audio engine mic pause failed', { paused, error: (error as Error).message });
+      return false;
+    }
+  }
+
+  /** Starts the recorder in the engine, on the streams it captures */
+  public async startRecording(options: RecordingOptions): Promise<boolean> {
+    if (!this.child) {
+      return false;
+    }
+    try {
+      return (await this.request({ type: 'record', options })) as boolean;
+    } catch (error) {
+      logger.warn('Audio engine recording failed to start', { error: (error as Error).message });
+      return false;
+    }
+  }
+
+  /** Closes the engine's recording; null when it has no recorder or is gone */
+  public async stopRecording(): Promise<RecordingSummary | null> {
+    if (!this.child) {
+      return null;
+    }
+    try {
+      return (await this.request({ type: 'stopRecording' })) as RecordingSummary | null;
+    } catch (error) {
+      logger.warn('Audio engine recording failed to stop', { error: (error as Error).message });
+      return null;
+    }
+  }
+
+  public async getStats(): Promise<EngineStats | null> {
+    if (!this.child) {
+      return null;
+    }
+    try {
+      return (await this.request({ type: 'stats' })) as EngineStats;
+    } catch (error) {
+      logger.warn('Failed to read audio engine stats', { error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /** Stops every stream and the engine; killed if it does not exit in time */
+  public async stop(): Promise<void> {
+    const child = this.child;
+    if (!child) {
+      return;
+    }
+    for (const stream of [...this.rings.keys()]) {
+      await this.stopCapture(stream);
+    }
+    this.stopping = true;
+    await this.request({ type: 'shutdown' }).catch(() => child.kill());
+  }
+
+  private drain(): void {
+    for (const [stream, { ring, onDelivery }] of this.rings) {
+      try {
+        ring.read(onDelivery);
+      } catch (error) {
+        logger.error('Audio engine delivery handler failed', { stream, error: (error as Error).message });
+      }
+    }
+  }
+
+  private request(call: EngineCall): Promise<unknown> {
+    const child = this.child;
+    if (!child) {
+      return Promise.reject(new Error('Audio engine is not running'));
+    }
+    const id = this.nextId++;
+    return new Promise((resolve, reject) => {
+      const timer = setTimeout(() => {
+        this.pending.delete(id);
+        reject(new Error(`Audio engine did not answer ${call.type}`));
+      }, AUDIO_ENGINE_CONFIG.REQUEST_TIMEOUT_MS);
+      this.pending.set(id, { resolve, reject, timer });
+      child.postMessage({ ...call, id });
+    });
+  }
+
+  private onChildExit(child: UtilityProcess, code: number): void {
+    if (this.child !== child) {
+      return;
+    }
+    this.child = null;
+    for (const request of this.pending.values()) {
+      clearTimeout(request.timer);
+      request.reject(new Error('Audio engine exited'));
+    }
+    this.pending.clear();
+    for (const { ring } of this.rings.values()) {
+      ring.close();
+    }
+    this.rings.clear();
+    if (this.pollTimer) {
+      clearInterval(this.pollTimer);
+      this.pollTimer = null;
+    }
+    if (this.stopping) {
+      logger.info('Audio engine stopped');
+      return;
+    }
+    logger.error('Audio engine exited unexpectedly', { code });
+    this.options.onExit?.(code);
+  }
+}
@@ -0,0 +1,109 @@
+/**
+ * Audio engine process: native capture and processing in an Electron
+ * utilityProcess, away from the main process's stalls and crashes. Driven
+ * over process.parentPort (protocol.ts); each stream delivers into the
+ * shared memory ring the app named, which the app drains on its own time.
+ */
+import { constants, setPriority } from 'os';
+import { createLogger } from '@main/core/logger';
+import { AECProcessor } from '../native/AECProcessor';
+import { ENGINE_CONFIG_ENV } from './protocol';
+import type { EngineLaunchConfig, EngineMessage, EngineRequest, EngineStats, EngineStream } from './protocol';
+
+const logger = createLogger('AudioEngine');
+
+// Deliveries go to the rings; the callback only ever sees a stream's markers
+const noop = (): void => {};
+
+let aec: AECProcessor | null = null;
+const streams = new Set<EngineStream>();
+
+function post(message: EngineMessage): void {
+  process.parentPort.postMessage(message);
+}
+
+async function handle(request: EngineRequest): Promise<unknown> {
+  if (!aec) {
+    throw new Error('Native audio is unavailable');
+  }
+  switch (request.type) {
+    case 'start': {
+      const options = { ...request.options, sharedRing: request.ring };
+      const started =
+        request.stream === 'mic'
+          ? await aec.startMicrophoneCapture(noop, options)
+          : aec.startSystemAudioCapture(noop, options);
+      if (!started) {
+        throw new Error(`Failed to start ${request.stream} capture`);
+      }
+      streams.add(request.stream);
+      return undefined;
+    }
+    case 'stop':
+      if (request.stream === 'mic') {
+        await aec.stopMicrophoneCapture();
+      } else {
+        aec.stopSystemAudioCapture();
+      }
+      streams.delete(request.stream);
+      return undefined;
+    case 'pause':
+      return aec.pauseMicrophoneCapture();
+    case 'resume':
+      return aec.resumeMicrophoneCapture();
+    case 'record':
+      return aec.startRecording(request.options);
+    case 'stopRecording':
+      return aec.stopRecording();
+    case 'stats': {
+      const stats: EngineStats = { pid: process.pid, capture: aec.getCaptureStats(), streams: [...streams] };
+      return stats;
+    }
+    case 'shutdown':
+      if (streams.has('mic')) {
+        await aec.stopMicrophoneCapture();
+      }
+      if (streams.has('system')) {
+        aec.stopSystemAudioCapture();
+      }
+      streams.clear();
+      // A recording left running still gets its files closed
+      aec.stopRecording();
+      aec.destroy();
+      aec = null;
+      setImmediate(() => process.exit(0));
+      return undefined;
+  }
+}
+
+function main(): void {
+  // Capture threads set their own real-time priority; this keeps the
+  // control channel responsive on a loaded machine
+  try {
+    setPriority(constants.priority.PRIORITY_ABOVE_NORMAL);
+  } catch (error) {
+    logger.debug('Engine priority unchanged', { error: (error as Error).message });
+  }
+
+  let config: EngineLaunchConfig = { aec: {} };
+  try {
+    config = JSON.parse(process.env[ENGINE_CONFIG_ENV] ?? '{}') as EngineLaunchConfig;
+  } catch {
+    logger.warn('Ignoring unreadable engine config');
+  }
+  try {
+    aec = new AECProcessor(config.aec ?? {});
+    post({ type: 'ready', ok: true });
+  } catch (error) {
+    post({ type: 'ready', ok: false, error: (error as Error).message });
+  }
+
+  process.parentPort.on('message', (event) => {
+    const request = event.data as EngineRequest;
+    handle(request)
+      .then((result) => post({ type: 'reply', id: request.id, ok: true, result }))
+      .catch((error) => post({ type: 'reply', id: request.id, ok: false, error: (error as Error).message }));
+  });
+}
+
+main();
@@ -0,0 +1,47 @@
+/**
+ * Control channel between the app and the audio engine process
+ * (audioEngine.ts). Requests carry an id their reply echoes; audio never
+ * rides on it, only on the streams' shared memory rings.
+ */
+import type { AECConfig, CaptureStats, MicCaptureOptions, RecordingOptions } from '../native/AECProcessor';
+import type { SharedMemoryRingOptions } from '../native/SharedCaptureRing';
+
+export type EngineStream = 'mic' | 'system';
+
+/** Capture options that survive structured cloning; the ring is the engine's to make */
+export type EngineCaptureOptions = Omit<MicCaptureOptions, 'sharedRing' | 'transport'>;
+
+export type EngineRequest =
+  | { id: number; type: 'start'; stream: EngineStream; ring: SharedMemoryRingOptions; options: EngineCaptureOptions }
+  | { id: number; type: 'stop'; stream: EngineStream }
+  // The mic's device IO, as pauseMicrophoneCapture()/resumeMicrophoneCapture()
+  | { id: number; type: 'pause' }
+  | { id: number; type: 'resume' }
+  // The recorder takes the engine's streams, so it runs there too
+  | { id: number; type: 'record'; options: RecordingOptions }
+  | { id: number; type: 'stopRecording' }
+  | { id: number; type: 'stats' }
+  | { id: number; type: 'shutdown' };
+
+export type EngineReply =
+  | { type: 'reply'; id: number; ok: true; result?: unknown }
+  | { type: 'reply'; id: number; ok: false; error: string };
+
+/** Unprompted, once: whether the addon loaded */
+export type EngineEvent = { type: 'ready'; ok: boolean; error?: string };
+
+export type EngineMessage = EngineReply | EngineEvent;
+
+/** What 'stats' resolves to */
+export interface EngineStats {
+  pid: number;
+  capture: CaptureStats | null;
+  streams: EngineStream[];
+}
+
+/** The forking side's config, as JSON in the engine's ENGINE_CONFIG_ENV */
+export const ENGINE_CONFIG_ENV = 'KAKAROT_AUDIO_ENGINE_CONFIG';
+
+export interface EngineLaunchConfig {
+  aec: AECConfig;
+}
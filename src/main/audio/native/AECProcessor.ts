@@ -8,37 +8,354 @@
  * - Render path: System audio (speakers) → processRenderAudio() → AEC reference
  * - Capture path: Microphone audio → processCaptureAudio() → Echo-cancelled output
  * - Native mic capture: AudioUnit capture → Shared timestamp source → Perfect sync!
+ * - Native system capture: Core Audio process tap → same host clock as the mic
  *
  * The AEC requires render audio to be processed BEFORE corresponding capture audio
  * for optimal echo suppression.
  */
 
 import bindings from 'bindings';
+import type { PerformanceReport } from '@shared/types';
 import { createLogger } from '@main/core/logger';
+import { installNativeLogHandler } from './nativeLog';
+import type { NativeSharedMemoryRing, SharedMemoryRingOptions } from './SharedCaptureRing';
 
 const logger = createLogger('AECProcessor');
 
+/**
+ * AEC3 tunings. Switching presets at runtime rebuilds the native canceller
+ * (it re-converges over a second or two); capture keeps running.
+ * - aggressive: long filters, heavy suppression for open speakers
+ * - default: stock WebRTC AEC3
+ * - lowCpu: short filters, noise suppression off, for laptops on battery
+ * - headphones: no acoustic echo path; AEC off, noise suppression only
+ */
+export type AECPreset = 'aggressive' | 'default' | 'lowCpu' | 'headphones';
+
+export type NoiseSuppressionLevel = 'low' | 'moderate' | 'high' | 'veryHigh';
+
+/** CPU governor steps, each on top of the ones before it */
+export type GovernorLevel = 'full' | 'noAgc' | 'lightNs' | 'shortFilters' | 'wideband';
+
+/**
+ * Runtime AEC settings for configure(). Unspecified fields keep their current
+ * values; a preset applies its own enableAec/enableNs/enableAgc defaults
+ * before any explicit fields.
+ */
+export interface AECRuntimeConfig {
+  preset?: AECPreset;
+  enableAec?: boolean;
+  enableNs?: boolean;
+  nsLevel?: NoiseSuppressionLevel;
+  enableAgc?: boolean;
+  adaptiveSuppression?: boolean;
+  cpuGovernor?: boolean;
+  normalizeSpeech?: boolean;
+  normalizeTargetDbfs?: number;
+  /** Seed from a previous session on the same devices; null clears it */
+  warmStart?: AECWarmStart | null;
+  /** The mic's noise from a previous session on it; null clears it */
+  noiseProfile?: NoiseProfile | null;
+}
+
+/**
+ * Where postConfig()'s changes stand. A change posted over one still waiting
+ * replaces it, so `applied` may skip sequence numbers.
+ */
+export interface AECConfigStatus {
+  /** The last sequence number postConfig() returned */
+  posted: number;
+  /** The last change to take effect */
+  applied: number;
+  /** The last whose APM failed to build; the config before it runs on */
+  rejected: number;
+  pending: boolean;
+  /** Capture frames processed when `applied` took effect */
+  appliedFrame: number;
+  /** From its post to taking effect */
+  latencyMs: number;
+}
+
+/**
+ * What a session converged to, to seed the next one on the same devices.
+ * AEC3 starts its delay search at echoDelayMs instead of searching from
+ * scratch, and adaptive suppression starts on the preset it settled on.
+ */
+export interface AECWarmStart {
+  /** AEC3's delay estimate once converged */
+  echoDelayMs?: number;
+  /** Reported render-to-capture delay, until the first measurement */
+  streamDelayMs?: number;
+  /** Adaptive suppression's last preset */
+  preset?: AECPreset;
+}
+
+/**
+ * What a session heard of its mic's background noise, to seed the next one
+ * on the same input: the native noise suppressor is primed on noise of this
+ * spectrum before capture, and the speech/silence floor starts at its level
+ * instead of relearning both over the first seconds.
+ */
+export interface NoiseProfile {
+  /** RMS floor of the processed mic between speech */
+  noiseFloor: number;
+  /** Input noise density per band, low to high, dB */
+  bandsDb: number[];
+  /** 10ms frames of noise it was learned from */
+  frames: number;
+}
+
+/** getNoiseProfile(): the profile plus the input it was learned on (macOS only) */
+export interface DeviceNoiseProfile extends NoiseProfile {
+  inputDeviceUid?: string;
+}
+
+/** What moved the echo path for the last reset */
+export type EchoPathChange = 'outputDevice' | 'inputDevice' | 'delayJump' | 'requested';
+
+/**
+ * getAecProfile(): the warm start plus the devices it was learned on
+ * (macOS only; elsewhere the UIDs are absent)
+ */
+export interface AECProfile extends AECWarmStart {
+  inputDeviceUid?: string;
+  outputDeviceUid?: string;
+}
+
+/**
+ * calibrate(): the measured speaker-to-mic round trip, the echo path latency
+ * estimate it replaced, and the echo delay AEC was seeded with
+ */
+export interface CalibrationResult {
+  roundTripMs: number;
+  clarity: number;
+  outputLatencyMs: number;
+  echoDelayMs: number;
+}
+
+/** One side of getEchoPathLatency(), from its CoreAudio properties */
+export interface DeviceLatency {
+  totalMs: number;
+  deviceMs: number;
+  safetyOffsetMs: number;
+  streamMs: number;
+  bufferMs: number;
+}
+
+/**
+ * getEchoPathLatency(): the render-to-capture hardware delay of the current
+ * output and input devices, which the native pipeline adds to the measured
+ * render/capture lead so AEC3's delay search only covers the acoustic path.
+ * appliedMs is what is in use: the same, or the calibrated round trip.
+ */
+export interface EchoPathLatency {
+  totalMs: number;
+  output: DeviceLatency;
+  input: DeviceLatency;
+  appliedMs: number;
+  calibrated: boolean;
+}
+
+/**
+ * startMeetingMonitor()'s event: the last windowSeconds of system output
+ * held speechSeconds of speech in speechRuns separate stretches
+ */
+export interface MeetingAudioEvent {
+  speechSeconds: number;
+  windowSeconds: number;
+  speechRuns: number;
+  confidence: number;
+}
+
+export interface MeetingMonitorStats {
+  running: boolean;
+  /** An event can fire; after one, it rearms once the output has gone quiet for a while */
+  armed: boolean;
+  secondsHeard: number;
+  secondsAnalyzed: number;
+  secondsSilent: number;
+  secondsSpeech: number;
+  events: number;
+  wakeups: number;
+  framesDropped: number;
+  windowSpeechSeconds: number;
+  /** The monitor thread's CPU time over its wall time */
+  cpuLoad: number;
+}
+
+/**
+ * startKeywordSpotter()'s event: |keyword| (as given, |index| in the list)
+ * heard on the system stream between startMs and endMs (Date.now()), with
+ * the geometric mean of its token peaks as confidence
+ */
+export interface KeywordEvent {
+  keyword: string;
+  index: number;
+  confidence: number;
+  startMs: number;
+  endMs: number;
+  /** When the event left the spotter */
+  detectedMs: number;
+}
+
+export interface KeywordSpotterStats {
+  running: boolean;
+  keywords: number;
+  /** Nodes in the prefix tree the keywords compiled to */
+  graphStates: number;
+  frames: number;
+  framesDropped: number;
+  events: number;
+  /** detectedMs - endMs over the events */
+  meanLatencyMs: number;
+  /** The spotter thread's CPU time over the audio time */
+  cpuLoad: number;
+}
+
+/** getVoiceVerifierStats(): the mic stream's speaker verification */
+export interface VoiceVerifierStats {
+  enrolled: boolean;
+  enrolling: boolean;
+  /** Speech pooled by the enrollment so far */
+  enrollmentSeconds: number;
+  /** Utterances decided, and how */
+  utterances: number;
+  accepted: number;
+  rejected: number;
+  /** 10ms speech frames held back as not the user's */
+  framesHeld: number;
+  /** Divergence from the voiceprint at the last decision, against threshold */
+  lastScore: number;
+  threshold: number;
+}
+
+/** One instance's means over the seconds a shadow evaluation compared */
+export interface ShadowAecSide {
+  erleDb?: number;
+  /** -(ERL + ERLE): the echo left in the output */
+  leakageDb?: number;
+  residualEchoLikelihood?: number;
+  convergedFraction: number;
+  processingLoad: number;
+  captureCalls: AECCallStats;
+}
+
+/**
+ * getShadowComparison(): a candidate configuration run beside the live
+ * canceller on the same frames, output discarded. Seconds count capture
+ * through the candidate; only those where both reported ERLE are averaged.
+ * cpuLoad is the shadow thread's CPU time over the audio it processed.
+ */
+export interface ShadowAecComparison {
+  running: boolean;
+  candidate: AECConfig;
+  maxLoad: number;
+  secondsProcessed: number;
+  secondsCompared: number;
+  secondsSkipped: number;
+  framesDropped: number;
+  cpuLoad: number;
+  live: ShadowAecSide;
+  shadow: ShadowAecSide;
+}
+
 /**
  * Configuration options for AEC initialization
  */
 export interface AECConfig {
+  /** AEC3 tuning (default: 'aggressive') */
+  preset?: AECPreset;
+
   /** Enable acoustic echo cancellation (default: true) */
   enableAec?: boolean;
 
   /** Enable noise suppression (default: true) */
   enableNs?: boolean;
 
+  /** Noise suppression strength (default: 'moderate') */
+  nsLevel?: NoiseSuppressionLevel;
+
   /** Enable automatic gain control (default: false) */
   enableAgc?: boolean;
 
   /** Disable AEC when headphones are detected (default: true) */
   disableAecOnHeadphones?: boolean;
 
+  /**
+   * Start on the cheaper 'default' preset and switch to 'aggressive' only while
+   * the measured residual echo stays high, then back after a minute without.
+   * Each switch restarts AEC3 convergence. Overrides preset (default: false)
+   */
+  adaptiveSuppression?: boolean;
+
+  /**
+   * Under CPU load (frames missing their deadline), step down through
+   * cheaper settings: AGC off, NS low, short filters, 16kHz. Steps back up
+   * after half a minute of headroom; the settings asked for are what
+   * getConfig() keeps reporting (default: false)
+   */
+  cpuGovernor?: boolean;
+
+  /**
+   * Bring speech to normalizeTargetDbfs after the APM, for transcription:
+   * AGC2's speech level estimator sets a slowly slewed gain (-10 to +30dB),
+   * its clipping predictor backs the gain off ahead of a clip and its limiter
+   * catches the rest. Holds the gain through silence. Use instead of
+   * enableAgc, not with it (default: false)
+   */
+  normalizeSpeech?: boolean;
+
+  /** Speech level normalizeSpeech aims for, -40 to -1 dBFS (default: -20) */
+  normalizeTargetDbfs?: number;
+
   /** Frame duration in milliseconds: 10, 20, or 30 (default: 10) */
   frameDurationMs?: 10 | 20 | 30;
 
   /** Sample rate in Hz (default: 48000) */
   sampleRate?: number;
+
+  /**
+   * Rate the WebRTC APM runs at: 8000, 16000, 32000 or 48000. Render and
+   * capture are resampled around it, so streams stay at sampleRate. 16000 is
+   * plenty when only transcription consumes the output (default: 48000)
+   */
+  processingSampleRate?: 8000 | 16000 | 32000 | 48000;
+
+  /**
+   * Channels in the render reference (1-8). Stereo system audio can be passed
+   * interleaved as-is; AEC3 cancels against a downmix until the channels
+   * actually differ (default: 1)
+   */
+  renderChannels?: number;
+}
+
+/**
+ * Wall time of one APM entry point per 10ms frame (resampling included), from
+ * a log-linear histogram: percentiles are within ~3%, the max is exact
+ */
+export interface AECCallStats {
+  frames: number;
+  /** Nonzero APM return codes */
+  errors: number;
+  /** Calls that took longer than the frame duration, and their share of all calls */
+  deadlineMisses: number;
+  deadlineMissFraction: number;
+  p50Us: number;
+  p95Us: number;
+  p99Us: number;
+  maxUs: number;
+}
+
+/**
+ * Where readMetrics() puts each value: offsets by name, "aec." for
+ * getMetrics()'s native keys, "mic."/"system."/"async." for getCaptureStats()
+ * streams and "micTrace." etc. for getLatencyTrace() stages (nested keys
+ * dotted). Unset values read NaN, booleans 0/1. Streams vary by platform,
+ * so read offsets from here rather than hard-coding them.
+ */
+export interface MetricsLayout {
+  length: number;
+  offsets: Record<string, number>;
 }
 
 /**
@@ -48,15 +365,90 @@ export interface AECMetrics {
   /** Echo return loss enhancement in dB */
   erle?: number;
 
-  /** Residual echo return loss in dB */
+  /** Echo return loss in dB */
   rerl?: number;
 
-  /** Echo suppression strength (0-1) */
+  /** RMS level of the last processed 10ms capture frame */
   echoPower?: number;
 
-  /** Current residual echo level */
+  /** Peak level of the last processed 10ms capture frame */
   residualEchoLevel?: number;
 
+  /** Adaptive noise floor of the processed capture (RMS of silent frames) */
+  noiseFloor?: number;
+
+  /** Whether the last processed frame was above the noise-floor threshold */
+  speech?: boolean;
+
+  /** Fraction of the last second the linear filter was divergent (0-1) */
+  divergentFilterFraction?: number;
+
+  /** Residual echo detector likelihood (0-1) */
+  residualEchoLikelihood?: number;
+
+  /** Maximum residual echo likelihood over the recent period (0-1) */
+  residualEchoLikelihoodRecentMax?: number;
+
+  /** Median and standard deviation of the AEC delay estimate in ms */
+  delayMedianMs?: number;
+  delayStdMs?: number;
+
+  /** Render->capture delay measured by the native pipeline and passed to the APM */
+  streamDelayMs?: number;
+
+  /**
+   * Render clock against capture in ppm, once the native pipeline has ~10s of
+   * continuous audio on both; render is resampled by it before the APM
+   */
+  renderDriftPpm?: number;
+
+  /** Rate the APM runs at, and the share of real time it spends processing */
+  processingSampleRate?: number;
+  processingLoad?: number;
+
+  /** Headphone bypass is on: the APM is skipped and the canceller is on standby */
+  bypassed?: boolean;
+
+  /** With adaptiveSuppression, the preset the adaptation is currently on */
+  suppressionLevel?: 'default' | 'aggressive';
+
+  /** With cpuGovernor, the cheapest step in effect and how many steps were taken */
+  governorLevel?: GovernorLevel;
+  governorTransitions?: number;
+
+  /**
+   * With normalizeSpeech, the gain applied to the latest 10ms frame, the
+   * speech level it works from (once confident) and how often a predicted
+   * clip backed the gain off
+   */
+  normalizerGainDb?: number;
+  speechLevelDbfs?: number;
+  clippingPredictions?: number;
+
+  /**
+   * Echo path resets after a device switch, a delay jump or resetEchoPath():
+   * how many, the last one's cause, and the echo leaking through until the
+   * fresh canceller converged (leakage as -(ERL + ERLE), worst second). The
+   * reconvergence time is absent while reconverging.
+   */
+  echoPathResets?: number;
+  echoPathChange?: EchoPathChange;
+  echoPathReconverging?: boolean;
+  echoPathReconvergeMs?: number;
+  echoPathLeakageDb?: number;
+
+  /**
+   * Fixed delay of the cleaned capture behind its input: one processing frame,
+   * for any buffer size. Timestamps of natively processed streams already
+   * account for it.
+   */
+  outputLatencySamples?: number;
+  outputLatencyMs?: number;
+
+  /** Per-frame timing of ProcessStream (capture) and ProcessReverseStream (render) */
+  captureCalls?: AECCallStats;
+  renderCalls?: AECCallStats;
+
   /** Whether AEC is currently processing */
   isProcessing?: boolean;
 
@@ -70,396 +462,4338 @@ export interface AECMetrics {
   converged?: boolean;
 }
 
-const DEFAULT_CONFIG: Required<AECConfig> = {
-  enableAec: true,
-  enableNs: true,
-  enableAgc: false,
-  disableAecOnHeadphones: true,
-  frameDurationMs: 10,
-  sampleRate: 48000,
-};
+/**
+ * Float32Array by default; Int16Array when capture options set format: 'pcm16',
+ * and a Buffer of little-endian 16-bit PCM with format: 's16le'
+ */
+export type CaptureSamples = Float32Array | Int16Array | Buffer;
 
 /**
- * TypeScript wrapper for the native WebRTC AEC module.
- * Manages render/capture processing and native mic capture.
+ * Where synchronous capture processing writes: a Float32Array, an Int16Array
+ * or Buffer (16-bit PCM), or a format to allocate one ('f32' / 's16le')
  */
-export class AECProcessor {
-  private nativeModule: any = null;
-  private nativeInstance: any = null;
-  private config: Required<AECConfig>;
-  private isInitialized = false;
-  private isDestroyed = false;
-  private renderBufferQueue: Float32Array[] = [];
-  private readonly MAX_RENDER_QUEUE = 10;
-  private micCapturing = false;
-  private micAudioCallback?: (samples: Float32Array, timestamp: number) => void;
+export type CaptureOutput = Float32Array | Int16Array | Buffer | 'f32' | 's16le';
 
-  constructor(config: AECConfig = {}) {
-    this.config = { ...DEFAULT_CONFIG, ...config };
+/**
+ * Render reference: float samples, or 16-bit PCM (Int16Array, or a Buffer of
+ * s16le unless processRenderAudio() is given format 'f32')
+ */
+export type RenderSamples = Float32Array | Int16Array | Buffer;
 
-    try {
-      // Load the native module (exports a class AudioCaptureAddon)
-      let nativeModule;
-      
-      try {
-        // First try: use bindings module (works in dev/unbundled)
-        logger.debug('Attempting to load native addon via bindings module...');
-          logger.debug('DEBUG:', { __dirname, cwd: process.cwd() });
-        nativeModule = bindings('audio_capture_native');
-        logger.debug('Loaded native addon via bindings module');
-      } catch (bindingsError) {
-        // Fallback: try to require directly at runtime using multiple possible paths
-        // eslint-disable-next-line @typescript-eslint/no-require-imports
-        const fs = require('fs');
-        // eslint-disable-next-line @typescript-eslint/no-require-imports
-        const path = require('path');
-        
-        const errorMsg = bindingsError instanceof Error ? bindingsError.message : String(bindingsError);
-        logger.debug('bindings() failed, trying direct require paths', { error: errorMsg.substring(0, 100) });
-        
-        const possiblePaths: string[] = [];
-        
-        // Try same directory as the bundled code (after build copy)
-        possiblePaths.push(
-          path.join(__dirname, 'audio_capture_native.node')
-        );
-        
-        // Try absolute dev paths
-        possiblePaths.push(
-          path.resolve('/Users/moxo/Desktop/kakarot-master/native/build/Release/audio_capture_native.node'),
-          path.resolve('/Users/moxo/Desktop/kakarot-master/build/Release/audio_capture_native.node')
-        );
-        
-        // Try cwd-relative paths
-        possiblePaths.push(
-          path.join(process.cwd(), 'native/build/Release/audio_capture_native.node'),
-          path.join(process.cwd(), 'build/Release/audio_capture_native.node'),
-          path.join(process.cwd(), 'audio_capture_native.node')
-        );
-        
-        // Try relative to app directory (for production)
-        if (process.resourcesPath) {
-          possiblePaths.push(
-            path.join(process.resourcesPath, 'app/native/build/Release/audio_capture_native.node'),
-            path.join(process.resourcesPath, 'native/build/Release/audio_capture_native.node'),
-            path.join(process.resourcesPath, 'app/audio_capture_native.node'),
-            path.join(process.resourcesPath, 'audio_capture_native.node')
-          );
-        }
+/**
+ * Native mic delivery. All values describe the first sample of the buffer:
+ * - timestamp: capture time in the Date.now() domain, derived from CoreAudio host time
+ * - sampleIndex: running sample position since capture start, in the output
+ *   sample rate (advances across drops)
+ * - hostTimeMs: monotonic host time in ms, convertible with hostTimeToDateNow()
+ * - vad: with the vad option, the RNN VAD speech probability (0-1) of each
+ *   10ms frame that completes in this buffer; a frame straddling two
+ *   deliveries is reported with the second. With the gate, one per frame
+ *   delivered.
+ * - silenceMs: set only on gate markers, which carry no samples; that much
+ *   non-speech starting at `timestamp` was withheld
+ * - levels: with the levels option, LEVEL_FIELDS values per 10ms frame that
+ *   completes in this buffer: rms, peak, noise floor, speech (1) / silence (0)
+ * - endpoint: set only on endpoint markers, which carry no samples; speech
+ *   started, or the utterance ended, at `timestamp` / `sampleIndex`
+ * - talk: with the talk option, the TalkState of each 10ms frame that
+ *   completes in this buffer
+ * - prosody: with endpoint.prosody, on 'end' markers: how the utterance's
+ *   pitch and energy ended
+ * - classes: with the classify option, the AudioClass of each second that
+ *   completes in this buffer
+ * - speakers: with the speakers option, the local speaker ID (1 up, 0 for
+ *   too little speech) of each second that completes in this buffer
+ * - metadata: with the metadata option, a block of METADATA_FIELDS rows
+ *   (MetadataField) over the 10ms frames that complete in this buffer, as
+ *   levels counts them: row f holds field f of every frame, so frame i of
+ *   field f is at f * frames + i
+ */
+export type MicAudioCallback<T extends CaptureSamples = Float32Array> = (
+  samples: T,
+  timestamp: number,
+  sampleIndex: number,
+  hostTimeMs: number,
+  vad?: Float32Array,
+  silenceMs?: number,
+  levels?: Float32Array,
+  endpoint?: EndpointType,
+  talk?: Uint8Array,
+  prosody?: UtteranceProsody,
+  classes?: Uint8Array,
+  speakers?: Uint8Array,
+  metadata?: Float64Array
+) => void;
 
-        let foundPath: string | null = null;
-        const checkedPaths: string[] = [];
-        
-        for (const testPath of possiblePaths) {
-          checkedPaths.push(testPath);
-          try {
-            if (fs.existsSync(testPath)) {
-              logger.info('Found native addon', { path: testPath });
-              foundPath = testPath;
-              break;
-            }
-          } catch (e) {
-            logger.debug('Path check failed', { path: testPath, error: String(e).substring(0, 50) });
-          }
-        }
+/** Endpoint marker: start of speech, or end of the utterance */
+export type EndpointType = 'start' | 'end';
 
-        if (!foundPath) {
-          const checkedStr = checkedPaths.slice(0, 2).join(' OR ');
-          throw new Error(
-            `Could not find native audio_capture_native module. Checked: ${checkedStr}`
-          );
-        }
+/**
+ * The ending of an utterance from the native pitch tracker, over its last
+ * voiced 300ms (pitch slope) and 150ms (pitch and energy against the
+ * utterance's mean)
+ */
+export interface UtteranceProsody {
+  /** 0-1, rising terminal intonation; -1 when too little was voiced to say */
+  questionLikelihood: number;
+  /** Semitones per second */
+  endSlope: number;
+  /** Semitones over the utterance's mean pitch */
+  endRise: number;
+  /** dB over the utterance's mean energy */
+  endEnergy: number;
+  voicedFrames: number;
+}
 
-        logger.debug('Loading native addon using require()', { path: foundPath });
-        // eslint-disable-next-line @typescript-eslint/no-require-imports
-        nativeModule = require(foundPath);
-        logger.debug('Loaded native addon via direct require()');
-      }
+/** Who is talking in a 10ms mic frame, judged by the native echo canceller */
+export const TalkState = {
+  /** No echo-cancelled capture to judge by (capture not processed) */
+  UNKNOWN: 0,
+  SILENCE: 1,
+  /** The local speaker only */
+  NEAR_END: 2,
+  /** Remote audio only: what the mic hears is echo */
+  FAR_END: 3,
+  DOUBLE_TALK: 4,
+} as const;
+export type TalkState = (typeof TalkState)[keyof typeof TalkState];
 
-      if (!nativeModule || typeof nativeModule.AudioCaptureAddon !== 'function') {
-        logger.error('Invalid native module structure', { hasModule: !!nativeModule, hasAudioCaptureAddon: !!nativeModule?.AudioCaptureAddon });
-        throw new Error('Failed to load native audio_capture_native module');
-      }
+/** What a second of delivered audio is, judged natively from the VAD and its spectrum */
+export const AudioClass = {
+  SILENCE: 0,
+  SPEECH: 1,
+  /** Hold music, a shared clip's soundtrack */
+  MUSIC: 2,
+  NOISE: 3,
+} as const;
+export type AudioClass = (typeof AudioClass)[keyof typeof AudioClass];
 
-      this.nativeModule = nativeModule;
+/** Values per frame in the levels array: [rms, peak, noiseFloor, speech] */
+export const LEVEL_FIELDS = 4;
 
-      // Create native instance with config (init occurs in constructor)
-      logger.debug('Creating native AudioCaptureAddon instance...');
-      this.nativeInstance = new this.nativeModule.AudioCaptureAddon({
-        enableAec: this.config.enableAec,
-        enableNs: this.config.enableNs,
-        enableAgc: this.config.enableAgc,
-      });
+/** Rows of the metadata block, each one value per 10ms frame */
+export const MetadataField = {
+  /** 10ms frames delivered on this stream before it */
+  FRAME_INDEX: 0,
+  /** Host time of its first sample (ms), as hostTimeMs */
+  HOST_TIME_MS: 1,
+  RMS: 2,
+  PEAK: 3,
+  /** VAD speech probability, 0-1 */
+  SPEECH_PROBABILITY: 4,
+  /** dB the echo canceller took out while the far end talked; 0 otherwise or unprocessed */
+  ECHO_REDUCTION_DB: 5,
+  /** TalkState */
+  TALK: 6,
+  /** 1 when the frame peaked at full scale */
+  CLIPPED: 7,
+} as const;
+export type MetadataField = (typeof MetadataField)[keyof typeof MetadataField];
 
-      this.isInitialized = true;
-      logger.info('AEC initialized successfully', {
-        enableAec: this.config.enableAec,
-        enableNs: this.config.enableNs,
-        enableAgc: this.config.enableAgc,
-        sampleRate: this.config.sampleRate,
-        frameDurationMs: this.config.frameDurationMs,
-      });
+export const METADATA_FIELDS = 8;
+
+/**
+ * Native silence gate: only speech frames (plus pre-roll and hangover) are
+ * delivered, so silent audio never crosses into JS
+ */
+export interface SilenceGateOptions {
+  /** VAD speech probability that opens the gate, 0-1 (default: 0.5) */
+  threshold?: number;
+  /** Non-speech delivered after speech ends, up to 5000 (default: 500) */
+  hangoverMs?: number;
+  /** Audio replayed before each speech onset, up to 1000 (default: 200) */
+  prerollMs?: number;
+  /**
+   * While gated, deliver a sample-less marker at this cadence and when speech
+   * resumes; 0 disables markers (default: 1000)
+   */
+  silenceMarkerMs?: number;
+}
+
+/**
+ * Native endpointing on the VAD output: sample-less markers at utterance
+ * boundaries, as soon as the trailing silence has passed rather than when a
+ * provider finalizes the turn
+ */
+export interface EndpointOptions {
+  /** VAD speech probability that counts as speech, 0-1 (default: 0.5) */
+  threshold?: number;
+  /** Speech needed to start an utterance, 10-1000; shorter bursts are ignored (default: 100) */
+  minSpeechMs?: number;
+  /** Silence that ends the utterance, 10-5000 (default: 600) */
+  trailingSilenceMs?: number;
+  /** Track pitch and pass each 'end' marker the utterance's UtteranceProsody (default: false) */
+  prosody?: boolean;
+}
+
+/**
+ * Options for native microphone capture
+ */
+export interface MicCaptureOptions {
+  /**
+   * Deliver Float32Array views over pooled native slabs instead of fresh copies.
+   * A slab returns to the pool when the array is garbage collected, so callers
+   * should not retain delivered arrays longer than needed (default: false)
+   */
+  zeroCopy?: boolean;
+
+  /**
+   * Coalesce IOProc buffers into one callback per interval, trading a few ms of
+   * latency for fewer main-thread wakeups. The timestamp passed to the callback
+   * is that of the first sample in the batch. 0 delivers every buffer (default: 0, max: 500)
+   */
+  deliveryIntervalMs?: number;
+
+  /**
+   * Run echo cancellation natively: the addon pairs mic and system audio on a
+   * DSP thread and the callback receives the cleaned stream (the 'processed'
+   * source). processCaptureAudio() is unavailable while this is active.
+   * A Bluetooth hands-free mic (16kHz HFP) with the headset as the output is
+   * delivered at its own rate with noise suppression only: there is no echo
+   * path, and the 48kHz pipeline would resample twice for nothing
+   * (isNativeEchoCancelling() then reads false).
+   * When system audio is not captured natively, feed it with
+   * processRenderAudio(samples, timestamp) and the addon aligns it (default: false)
+   */
+  processed?: boolean;
+
+  /**
+   * System capture only (macOS): build the tap's aggregate device with the
+   * current input device as a drift-compensated subdevice, so a microphone
+   * capture started afterwards comes from the same IOProc on the output
+   * device's sample clock. Needs a 48kHz output device; otherwise, or when
+   * the mic is already running, the mic keeps its own clock. While it rides
+   * the tap the input device is fixed (default: false)
+   */
+  sharedClock?: boolean;
+
+  /**
+   * System capture only (macOS): tap just these apps' output instead of the
+   * whole mix, by bundle ID prefix ('com.google.Chrome' takes its helper
+   * processes) or PID. Apps that open audio after the start join the tap;
+   * until one does it delivers silence (default: every process)
+   */
+  processes?: (string | number)[];
+
+  /**
+   * Microphone only (macOS): IO buffer size to request from the input device,
+   * in frames at its own rate, clamped to the device's range. 480 at 48kHz is
+   * one 10ms AEC frame per callback. The size granted is reported as
+   * getCaptureStats().mic.ioBufferFrames (default: the device's own)
+   */
+  ioBufferFrames?: number;
+
+  /**
+   * Microphone only (macOS): device channels to record, 0-based across its
+   * input streams, e.g. [2] for input 3 of an interface. Several are mixed
+   * to mono; the rest never leave the IOProc. The 'auhal' engine takes the
+   * first one, 'voiceProcessing' and a shared-clock mic ignore this. The
+   * device's channel count is getCaptureStats().mic.deviceChannels
+   * (default: all channels, mixed)
+   */
+  inputChannels?: number[];
+
+  /**
+   * Microphone only (macOS, 'hal' engine): combine the device's channels
+   * (inputChannels, or up to 8) as a delay-and-sum beam steered at the
+   * talker, instead of averaging them. Speech adds up across the mics and
+   * room noise does not, so the AEC and noise suppression start from a
+   * cleaner channel. Adds 1ms of latency; no effect on a mono device. The
+   * steering is getCaptureStats().beamLagsMs (default: false)
+   */
+  beamform?: boolean;
+
+  /**
+   * Microphone only (macOS): how the input device is read. 'hal' is a raw
+   * IOProc in the device's own format, downmixed and resampled by the addon.
+   * 'auhal' takes input through the AUHAL's callback, and CoreAudio's
+   * converter produces mono float at outputSampleRate (48000 with processed)
+   * in one pass; a multichannel device contributes its first channel.
+   * Compare the two with getCaptureStats().mic.cpuMsPerSecond.
+   * 'voiceProcessing' captures through Apple's
+   * VoiceProcessingIO unit, which cancels the echo of everything the machine
+   * plays, with AGC and noise suppression, in the system audio server. The
+   * addon's own AEC is then bypassed (processed and talk are ignored), the
+   * stream is 48kHz, and calibrate() is unavailable. The state is reported as
+   * getCaptureStats().voiceProcessing. The unit engines fix the input
+   * device until capture restarts (default: 'hal').
+   * On Windows the only other engine is 'communications'. It opens the
+   * endpoint in communications mode, so the driver's or the OS's voice
+   * processing applies; without a device set, it also uses the default
+   * communications device. When the endpoint's echo canceller runs, the
+   * addon's AEC is bypassed: processed and talk have no effect, and
+   * isMicrophoneProcessed() reads false. Otherwise processed runs AEC3 as
+   * usual. getCaptureStats().endpointAec reports which path was taken.
+   */
+  engine?: MicEngine;
+
+  /**
+   * With engine 'voiceProcessing': how far other apps' audio is ducked while
+   * the mic runs, only while someone speaks. Needs macOS 14; earlier, and
+   * with 'default', the system's own ducking applies (default: 'default')
+   */
+  ducking?: VoiceDucking;
+
+  /**
+   * Resample natively (windowed sinc, 10ms blocks) before delivery, e.g. 16000
+   * for transcription. Rounded to 100Hz, clamped to 8000-48000 (default: the
+   * stream's own rate; 48000 for the microphone, which is captured at its
+   * device's native rate and converted once, straight to this rate)
+   */
+  outputSampleRate?: number;
+
+  /**
+   * 'pcm16' delivers Int16Array samples ready to send as linear16; 's16le'
+   * delivers the same bytes as a Buffer for websocket sends. Pair either with
+   * a matching callback type (default: 'float32', alias 'f32')
+   */
+  format?: 'float32' | 'f32' | 'pcm16' | 's16le';
+
+  /**
+   * Assemble deliveries natively into chunks of exactly this many ms (rounded
+   * to 10ms, 10-5000) at the output rate. Each chunk's timestamp and
+   * hostTimeMs come from the sample counter, so it ends precisely
+   * samples.length / rate later. A gap (drops, gated silence) delivers the
+   * partial chunk first (default: off)
+   */
+  chunkMs?: number;
+
+  /**
+   * System capture: clean the stream up natively before delivery with its own
+   * WebRTC APM (noise suppression, AGC2 adaptive gain, high-pass; no echo
+   * cancellation, no render reference). It runs on the stream's consumer
+   * thread, in parallel with the microphone's DSP thread, and timestamps are
+   * moved back by its fixed 10ms latency (default: false)
+   */
+  enhance?: boolean;
+
+  /**
+   * Duck keystrokes and other clicks natively ahead of the VAD, the gate and
+   * delivery, on the stream's consumer thread. Resampled streams (e.g. with
+   * outputSampleRate) incur no delay; others are delayed 10ms, with timestamps
+   * moved back to match (default: false)
+   */
+  declick?: boolean;
+
+  /**
+   * Path of a denoise model (see LOCAL_DENOISE_CONFIG): run the RNNoise-class
+   * neural denoiser on this stream, at 48kHz only, on its consumer thread.
+   * Cleaner than the APM's NS against babble and fan noise, for about
+   * denoiseMeanUs of CPU per 10ms. Delays the stream 10ms when resampled,
+   * 20ms otherwise, with timestamps moved back to match (default: off)
+   */
+  denoiseModel?: string;
+
+  /**
+   * Deliveries allowed to wait for the JS thread (e.g. behind a long IPC or
+   * GC pause) before overloadPolicy applies, 1-1024 (default: 32)
+   */
+  maxQueuedDeliveries?: number;
+
+  /**
+   * What gives when the queue is full: 'coalesce' appends to the newest queued
+   * delivery so the backlog arrives as one larger callback, 'dropOldest'
+   * discards the oldest, 'block' holds the native consumer thread (never the
+   * audio thread) until JS catches up, after which the ring drops. Each
+   * action is counted in getCaptureStats() (default: 'coalesce')
+   */
+  overloadPolicy?: 'coalesce' | 'dropOldest' | 'block';
+
+  /**
+   * Run WebRTC's RNN voice activity detector natively on the delivered audio
+   * (after AEC and resampling) and pass per-10ms speech probabilities as the
+   * callback's fifth argument (default: false)
+   */
+  vad?: boolean;
+
+  /**
+   * Track levels natively on the delivered audio: per-10ms RMS, peak, an
+   * adaptive noise floor and a speech/silence flag, passed packed as the
+   * callback's seventh argument (default: false)
+   */
+  levels?: boolean;
+
+  /**
+   * Classify the delivered audio natively, from the VAD and spectral
+   * features: an AudioClass per second, passed as the callback's eleventh
+   * argument; implies vad (default: false)
+   */
+  classify?: boolean;
+
+  /**
+   * Tell voices apart natively: a local speaker ID per second, from online
+   * clustering of the delivered speech's cepstra, passed as the callback's
+   * twelfth argument. IDs number speakers in order of appearance on this
+   * stream only; implies vad (default: false)
+   */
+  speakers?: boolean;
+
+  /**
+   * Per-10ms frame metadata computed natively once for every consumer:
+   * frame index, host time, RMS, peak, speech probability, echo reduction,
+   * TalkState and a clipping flag, passed as one struct-of-arrays
+   * Float64Array as the callback's thirteenth argument (see
+   * MetadataField); implies vad (default: false)
+   */
+  metadata?: boolean;
+
+  /**
+   * Drop non-speech natively. Runs after AEC and resampling; implies vad.
+   * Each run of speech arrives as contiguous deliveries with their own
+   * timestamps (default: off)
+   */
+  gate?: boolean | SilenceGateOptions;
+
+  /**
+   * Keep the stream's recent audio natively as Opus (about 3MB for ten
+   * minutes), after enhancement and resampling but ahead of the gate, for
+   * readHistory(). It stays readable after stop, until the next start
+   * (default: off; true keeps 600 seconds at 24kbit/s)
+   */
+  history?: boolean | AudioHistoryOptions;
+
+  /**
+   * Mark utterance boundaries natively; implies vad. Markers reach the
+   * callback in every delivery mode (sharedRing and transport included), and
+   * with chunkMs a chunk ends at each utterance end (default: off)
+   */
+  endpoint?: boolean | EndpointOptions;
+
+  /**
+   * Mic only, with processed: pass the TalkState of each 10ms frame as the
+   * callback's ninth argument. Far-end-only frames, the mic's echo of remote
+   * audio, then count as non-speech for the gate and endpoint, so leaked
+   * audio is not delivered (default: false)
+   */
+  talk?: boolean;
+
+  /**
+   * Mic only, with gate or endpoint: hold utterances that are not the
+   * enrolled user's voice (bystanders) from them, so they never reach
+   * transcription; the gate's pre-roll grows to 500ms to replay the user's
+   * first words once verified (default: false)
+   */
+  verifyVoice?: boolean;
+
+  /** The user's voiceprint, from finishVoiceEnrollment(); without one only enrollment runs */
+  voiceprint?: Uint8Array;
+
+  /**
+   * Write deliveries into this ring (createSharedCaptureRing) instead of
+   * calling back, for a worker to drain with SharedCaptureRingReader. The
+   * ring's format overrides format; vad and levels are not carried, and the
+   * callback is still required but never invoked. Options with a name make
+   * the ring in shared memory instead, for a reader in another process
+   * (default: callback delivery)
+   */
+  sharedRing?: SharedArrayBuffer | SharedMemoryRingOptions;
+
+  /**
+   * Send audio on this socket (createTranscriptionSocket), to this
+   * on-device transcriber (createLocalTranscriber) or into this channel of
+   * an interleaved stream (createChannelInterleaver) from the capture thread
+   * instead of calling back: always PCM16 at outputSampleRate. The callback
+   * still sees silence markers; vad and levels are not carried (default:
+   * callback delivery)
+   */
+  transport?: NativeTranscriptionSocket | NativeLocalTranscriber | NativeInterleaverChannel;
+}
+
+/**
+ * Native system audio delivery; same arguments and clock domain as MicAudioCallback.
+ * Samples are mono float32 at the tap's sample rate (see startSystemAudioCapture).
+ */
+export type SystemAudioCallback<T extends CaptureSamples = Float32Array> = MicAudioCallback<T>;
+
+/**
+ * A subscribeCapture() callback: the stream's audio deliveries only (no
+ * markers or per-frame extras). `samples` views the same native buffer as
+ * every other callback of the stream; treat it as read-only and copy what
+ * must outlive the call's consumers.
+ */
+export type CaptureSubscriberCallback<T extends CaptureSamples = Float32Array> = (
+  samples: T,
+  timestamp: number,
+  sampleIndex: number,
+  hostTimeMs: number
+) => void;
+
+export interface CaptureSubscriberOptions {
+  /** Deliveries this subscriber lets wait before its policy applies, 1-1024 (default: 32) */
+  maxQueuedDeliveries?: number;
+  /**
+   * What gives for this subscriber alone when its queue is full: 'dropOldest'
+   * discards its oldest delivery, 'coalesce' merges into its newest (a copy,
+   * its own). Never holds the stream (default: 'dropOldest')
+   */
+  overloadPolicy?: 'dropOldest' | 'coalesce';
+}
+
+/**
+ * CoreAudio device as reported by the native device table
+ */
+export interface AudioDeviceInfo {
+  /** AudioDeviceID as a string; pass to setInputDevice() */
+  id: string;
+  /** Persistent device UID (survives reboots, unlike id) */
+  uid: string;
+  name: string;
+  /** Default input device */
+  isDefault: boolean;
+  isDefaultOutput: boolean;
+  /** 'builtIn', 'usb', 'bluetooth', 'bluetoothLE', 'aggregate', 'virtual', ... */
+  transport: string;
+  nominalSampleRate: number;
+  bufferFrameSize: number;
+  bufferFrameSizeMin: number;
+  bufferFrameSizeMax: number;
+  inputChannels: number;
+  outputChannels: number;
+}
+
+/**
+ * Mic capture running again after it stopped on its own. The gap also
+ * arrives in the mic stream as a silence marker (silenceMs) at the sample
+ * index where it began.
+ */
+export interface CaptureRecoveredEvent {
+  /** 'device lost' or 'sleep' */
+  reason: string;
+  /** Time without capture, from the interruption to the restart */
+  gapMs: number;
+  /** AudioDeviceID capture resumed on */
+  deviceId: string;
+}
+
+/** The instant armSharedStart() put both streams' sampleIndex 0 at */
+export interface SharedStart {
+  /** Monotonic host time */
+  hostTimeMs: number;
+  /** Date.now() domain */
+  timestamp: number;
+}
+
+/** startSession(): a capture with its own device and graph, beside the mic and system streams */
+export interface CaptureSessionOptions {
+  /** Input device id as in getDevices() (default: the default input) */
+  deviceId?: string;
+  /**
+   * Run at the device's rate on the shared native DSP pool (default: none,
+   * the device's audio as-is). Sample stages only; encode and opus output
+   * is not delivered.
+   */
+  stages?: ProcessingStageConfig[];
+  /** Delivery size (default 100, at least 10) */
+  chunkMs?: number;
+  /** How soon after each device buffer its pool run should finish; later runs count as misses (default 20) */
+  deadlineMs?: number;
+}
+
+/** One startSession() delivery, all for its first sample, as the mic callback gets them */
+export type CaptureSessionCallback = (
+  samples: Float32Array,
+  timestamp: number,
+  sampleIndex: number,
+  hostTimeMs: number
+) => void;
+
+export interface CaptureSessionStats {
+  name: string;
+  deviceId: string | null;
+  running: boolean;
+  inputSampleRate: number;
+  outputSampleRate: number;
+  buffers: number;
+  /** Device buffers lost because the pool fell two seconds behind */
+  buffersDropped: number;
+  samplesIn: number;
+  samplesOut: number;
+  deliveries: number;
+  deliveriesRejected: number;
+  dsp: {
+    runs: number;
+    deadlineMs: number;
+    deadlineMisses: number;
+    cpuMs: number;
+    /** Device buffer queued to its run finished */
+    latency: { p50Ms: number; p95Ms: number; p99Ms: number; maxMs: number };
+  };
+}
+
+/** getSessions(): the process's DSP pool, whose thread count does not grow with sessions, and this instance's sessions */
+export interface CaptureSessionsSnapshot {
+  pool: { threads: number; jobs: number; runs: number; deadlineMisses: number };
+  sessions: CaptureSessionStats[];
+}
+
+/** Peak and RMS (linear, full scale 1) of a stream's delivered audio over one meter tick */
+export interface StreamLevel {
+  rms: number;
+  peak: number;
+  /** With the spectrum option: mean power per band over the tick, dB full scale (-120 floor) */
+  bands?: Float32Array;
+}
+
+/**
+ * startLevelMeter()'s spectrum: one native STFT per 10ms frame per stream
+ * (20ms Hann window, pffft), grouped into bands
+ */
+export interface SpectrumMeterOptions {
+  /** 1-128 (default: 32) */
+  bands?: number;
+  /** 'mel' triangles or equal-width 'linear' bands (default: 'mel') */
+  scale?: 'mel' | 'linear';
+  /** Default: 50 */
+  minHz?: number;
+  /** Clamped to Nyquist (default: 8000) */
+  maxHz?: number;
+}
+
+export interface LevelMeterOptions {
+  /** 1-120 (default: 30) */
+  rateHz?: number;
+  /** Band energies with each level, for spectrum displays (default: off) */
+  spectrum?: boolean | SpectrumMeterOptions;
+}
+
+/**
+ * One startLevelMeter() tick. A stream is absent while it delivered nothing;
+ * a tick with none is sent once when the last one goes quiet
+ */
+export interface LevelMeterReading {
+  /** Date.now() domain */
+  time: number;
+  mic?: StreamLevel;
+  system?: StreamLevel;
+  /** macOS async processing output */
+  async?: StreamLevel;
+}
+
+/**
+ * Capture-path health counters for one native stream, since its last start
+ */
+export interface CaptureStreamStats {
+  /** IOProc invocations */
+  callbacks: number;
+  /** Buffers accepted into the native ring */
+  buffersCaptured: number;
+  /** Buffers dropped because the ring was full (consumer stalled) */
+  buffersDropped: number;
+  /** Buffers dropped for exceeding the per-callback sample limit */
+  buffersOversized: number;
+  /** JS deliveries queued */
+  deliveries: number;
+  /** Deliveries refused by the thread-safe function (queue full or closing) */
+  tsfnRejections: number;
+  /** overloadPolicy 'dropOldest': queued deliveries discarded */
+  deliveriesDropped: number;
+  /** overloadPolicy 'coalesce': deliveries appended to a queued one */
+  deliveriesCoalesced: number;
+  /** overloadPolicy 'block': times the consumer thread waited for JS */
+  consumerBlocks: number;
+  /** Most deliveries queued for the JS thread at once */
+  queuePeak: number;
+  /** Deliveries queued for subscribeCapture() callbacks */
+  subscriberDeliveries: number;
+  /** Subscriber deliveries discarded by their own 'dropOldest' */
+  subscriberDropped: number;
+  /** Subscriber deliveries merged by their own 'coalesce' */
+  subscriberCoalesced: number;
+  /** CoreAudio processor overload notifications (missed IO deadlines) */
+  overloads: number;
+  /** 10ms frames withheld by the silence gate */
+  framesGated: number;
+  /** declick: keystrokes and clicks ducked */
+  keystrokesDucked: number;
+  /** denoiseModel: mean time per 10ms frame in the denoiser */
+  denoiseMeanUs: number;
+  /**
+   * Processed mode (mic): holes in the render reference, from dropped system
+   * chunks, filled with silence so the canceller keeps its alignment
+   */
+  renderGaps: number;
+  /** Render frames those holes were filled with */
+  renderFramesConcealed: number;
+  /** Processed mode (mic): render lost while the APM's render thread was stalled */
+  renderFramesDropped: number;
+  /** Device IO buffer in effect, in frames; 0 when not reported */
+  ioBufferFrames: number;
+  /** Mic: channels per frame across the device's input streams; 0 = not reported */
+  deviceChannels: number;
+  maxCallbackIntervalMs: number;
+  avgCallbackIntervalMs: number;
+  maxCallbackDurationMs: number;
+  avgCallbackDurationMs: number;
+  /** From the start request to the first callback; 0 until it arrives */
+  startToFirstCallbackMs: number;
+  /** Scheduling latency of the native consumer thread: ring write to its first read after waking */
+  maxConsumerWakeMs: number;
+  avgConsumerWakeMs: number;
+  /** The same for the DSP thread in processed mode (0 otherwise) */
+  maxDspWakeMs: number;
+  avgDspWakeMs: number;
+  /**
+   * Estimated native CPU per second of audio: IOProc time plus the consumer,
+   * DSP and render threads, the APM included
+   */
+  cpuMsPerSecond: number;
+  /**
+   * The stream's session arena: the block its fixed-size buffers were
+   * reserved in at start and freed in at stop, and what did not fit in it
+   */
+  arenaBytes: number;
+  arenaOverflowBytes: number;
+  /** The process's resident set before this session started, and once it stopped (0 while running) */
+  rssOpenBytes: number;
+  rssCloseBytes: number;
+}
+
+/** processSyncedPair() result */
+export interface SyncedPairResult {
+  /** Cleaned capture (the `output` buffer when one was passed) */
+  audio: Float32Array | Int16Array | Buffer;
+  rmsLevel: number;
+  peakLevel: number;
+  noiseFloor: number;
+  speech: boolean;
+  /** Stream delay reported to the APM for this chunk */
+  streamDelayMs: number;
+}
+
+export interface CaptureStats {
+  mic: CaptureStreamStats;
+  system: CaptureStreamStats;
+  /** Buffers queued by enqueueCaptureAudio() in async mode */
+  async: CaptureStreamStats;
+  /** The low-power profile is in effect (see setPowerProfile()) */
+  lowPower: boolean;
+  /** The engine of the current or last mic capture */
+  micEngine: MicEngine;
+  /** With beamform: how far each mic channel lags the first, as steered */
+  beamLagsMs?: number[];
+  /** Windows: the endpoint's own AEC on 'communications' captures */
+  endpointAec?: {
+    /** 'unavailable' before Windows 11 22H2 or without the effect */
+    state: 'on' | 'off' | 'unavailable';
+    /** The addon's AEC was skipped for it */
+    nativeBypassed: boolean;
+  };
+  /** The mic's VoiceProcessingIO engine ('voiceProcessing' captures) */
+  voiceProcessing: {
+    /** The voice unit is running */
+    active: boolean;
+    /** See setVoiceProcessingBypass() */
+    bypassed: boolean;
+    /** The ducking level in effect */
+    ducking: VoiceDucking;
+    /** Ducking applies only while someone speaks */
+    advancedDucking: boolean;
+  };
+}
+
+/** See MicCaptureOptions.engine */
+export type MicEngine = 'hal' | 'auhal' | 'voiceProcessing' | 'communications';
+
+/** VoiceProcessingIO ducking of other audio, least to most */
+export type VoiceDucking = 'default' | 'min' | 'mid' | 'max';
+
+/**
+ * setPowerProfile() modes. 'auto' follows the power source (macOS; elsewhere
+ * it stays normal).
+ */
+export type PowerProfile = 'normal' | 'lowPower' | 'auto';
+
+/** Distribution of one trace stage, from a log-linear histogram (~3%) */
+export interface LatencyStage {
+  count: number;
+  p50Ms: number;
+  p95Ms: number;
+  p99Ms: number;
+  maxMs: number;
+}
+
+/**
+ * Where a delivery's time goes between the HAL and the provider socket, each
+ * stage timed from the newest sample it carries. captureToEnqueue covers the
+ * IOProc (and, for processed mic audio, the AEC pipeline); jsToSent and total
+ * only count deliveries closed with markAudioSent().
+ */
+export interface StreamLatencyTrace {
+  captureToEnqueue: LatencyStage;
+  enqueueToDsp: LatencyStage;
+  dspToDispatch: LatencyStage;
+  dispatchToJs: LatencyStage;
+  jsToSent: LatencyStage;
+  total: LatencyStage;
+}
+
+export interface LatencyTrace {
+  mic: StreamLatencyTrace;
+  system: StreamLatencyTrace;
+  async: StreamLatencyTrace;
+}
+
+export type TracedStream = keyof LatencyTrace;
+
+export interface AudioHistoryOptions {
+  /** How far back the history reaches, up to 3600 (default: 600) */
+  seconds?: number;
+  /** Opus bitrate, 8000-128000 (default: 24000) */
+  bitrate?: number;
+}
+
+/** The last `lastMs` held, or a host-time range (getHostTime's clock) */
+export type HistoryRangeRequest =
+  | { lastMs: number; format?: 'f32' | 'ogg' }
+  | { fromHostTimeMs: number; toHostTimeMs: number; format?: 'f32' | 'ogg' };
+
+/** Where a pause or gap begins a new contiguous run */
+export interface HistorySegment {
+  offsetMs: number;
+  hostTimeMs: number;
+  timestamp: number;
+}
+
+export interface HistoryRange {
+  /** Opus's rate: the stream's, or 48000 when Opus does not take it */
+  sampleRate: number;
+  hostTimeMs: number;
+  timestamp: number;
+  durationMs: number;
+  segments: HistorySegment[];
+  /** Decoded, with format 'f32' */
+  samples?: Float32Array;
+  /** An Ogg Opus file of the range, with format 'ogg' */
+  data?: Buffer;
+}
+
+/**
+ * One stage of a native processing graph, run in order on 10ms frames.
+ * 'aec', 'ns' and 'agc' each run their own WebRTC APM (high-pass included)
+ * and take the AEC config fields (preset, enableNs, nsLevel, enableAgc...);
+ * one 'aec' stage with enableNs/enableAgc is cheaper than three. Each adds
+ * one frame of delay.
+ */
+export type ProcessingStageConfig =
+  | { type: 'resample'; outputSampleRate: number; enabled?: boolean }
+  /**
+   * Butterworth cascades of order / 2 biquads (order even, 2-8; default 2),
+   * e.g. { type: 'highpass', cutoffHz: 80 }
+   */
+  | { type: 'highpass' | 'lowpass'; cutoffHz?: number; order?: number; enabled?: boolean }
+  /**
+   * RBJ sections at frequencyHz; q and gainDb where the shape uses them.
+   * Telephone-band emphasis: a 300Hz 'highpass' and 3400Hz 'lowpass' with a
+   * 'peaking' boost around 2kHz
+   */
+  | {
+      type: 'biquad';
+      filter: 'lowpass' | 'highpass' | 'bandpass' | 'peaking' | 'lowshelf' | 'highshelf';
+      frequencyHz: number;
+      q?: number;
+      gainDb?: number;
+      order?: number;
+      enabled?: boolean;
+    }
+  /**
+   * SIMD FIR: the given coefficients (up to 255), or a windowed-sinc low-pass
+   * of `taps` (odd, default 63) at frequencyHz, e.g. 7600 ahead of a 'resample'
+   * to 16000
+   */
+  | { type: 'fir'; frequencyHz?: number; taps?: number; coefficients?: number[]; enabled?: boolean }
+  | ({ type: 'aec' | 'ns' | 'agc'; enabled?: boolean } & AECRuntimeConfig)
+  | { type: 'normalize'; targetDbfs?: number; enabled?: boolean }
+  /**
+   * RNNoise-class neural denoiser (see denoiseModel), at 48kHz; its stats'
+   * meanUs is the time per frame. Delays the output by one frame.
+   */
+  | { type: 'denoise'; model: string; enabled?: boolean }
+  /**
+   * Ducks keystrokes and clicks before the vad, with no added delay.
+   * threshold is the keystroke likelihood (0-1, default 0.5) that counts.
+   */
+  | { type: 'declick'; threshold?: number; enabled?: boolean }
+  | { type: 'vad'; enabled?: boolean }
+  /** Drops frames after hangoverMs below threshold; needs a vad stage before it */
+  | { type: 'gate'; threshold?: number; hangoverMs?: number; enabled?: boolean }
+  /** Output becomes Int16Array pcm16 from here */
+  | { type: 'encode'; enabled?: boolean }
+  /**
+   * Opus at 8/12/16/24/48kHz, 20ms packets; output becomes `encoded` from
+   * here. bitrate in bits/s (6000-128000, default 24000). With dtx (default
+   * on) and a vad stage before it, packets quiet below dtxThreshold for 200ms
+   * shrink to one byte. container 'ogg' (default) is Ogg Opus a streaming
+   * consumer such as Deepgram reads as-is; 'raw' is bare packets. Only in
+   * builds linked against libopus; elsewhere createProcessingGraph() fails.
+   */
+  | {
+      type: 'opus';
+      bitrate?: number;
+      dtx?: boolean;
+      dtxThreshold?: number;
+      container?: 'ogg' | 'raw';
+      enabled?: boolean;
+    };
+
+/**
+ * A tap on the graph: the stream partway along (e.g. before and after 'aec')
+ * in a form of its own, from the same pass as every other output. Taps at
+ * one point and rate share the conversion.
+ */
+export interface ProcessingGraphOutputConfig {
+  /** Key of its entry in ProcessingGraphResult.outputs */
+  name: string;
+  /** Stages run before the tap (0 = the input), or the type of the stage it follows (default: the end) */
+  after?: number | ProcessingStageConfig['type'];
+  /** Default: the rate at that point */
+  sampleRate?: number;
+  /** Default: 'f32'. 'opus' takes the opus stage's bitrate, dtx, dtxThreshold and container */
+  format?: 'f32' | 's16' | 'opus';
+  bitrate?: number;
+  dtx?: boolean;
+  dtxThreshold?: number;
+  container?: 'ogg' | 'raw';
+}
+
+/** A tap's share of one process() call; the arrays view native memory, not copies */
+export interface ProcessingGraphOutput {
+  samples?: Float32Array;
+  pcm16?: Int16Array;
+  encoded?: Uint8Array;
+  encodedSizes?: Uint32Array;
+  sampleRate: number;
+}
+
+export interface ProcessingGraphConfig {
+  /** Rate of the samples passed to process(), a multiple of 100Hz (default: 48000) */
+  sampleRate?: number;
+  stages: ProcessingStageConfig[];
+  outputs?: ProcessingGraphOutputConfig[];
+}
+
+/** What one process() call produced; a partial 10ms frame waits for the next call */
+export interface ProcessingGraphResult {
+  samples?: Float32Array;
+  pcm16?: Int16Array;
+  /** An opus stage's bytes; encodedSizes splits them into packets (raw) or page runs (ogg) */
+  encoded?: Buffer;
+  encodedSizes?: Uint32Array;
+  /** Speech probability per delivered frame, when a vad stage ran */
+  vad?: Float32Array;
+  /** One entry per configured output, by name */
+  outputs?: Record<string, ProcessingGraphOutput>;
+  droppedFrames: number;
+  sampleRate: number;
+}
+
+export interface ProcessingStageStats {
+  type: ProcessingStageConfig['type'];
+  enabled: boolean;
+  inputSampleRate: number;
+  outputSampleRate: number;
+  frames: number;
+  /** The calling thread's CPU time in the stage */
+  cpuMs: number;
+  /** Wall time in the stage; meanUs and maxUs are per frame of it */
+  wallMs: number;
+  meanUs: number;
+  maxUs: number;
+}
+
+/**
+ * A native chain of stages built once; each process() call crosses into
+ * native code once for all of them. Drive it from the thread that made it.
+ */
+export interface NativeProcessingGraph {
+  process(samples: Float32Array): ProcessingGraphResult;
+  /** Far-end reference for 'aec' stages ahead of any resample stage */
+  processRender(samples: Float32Array): void;
+  /** False for a stage that changes the rate */
+  setStageEnabled(index: number, enabled: boolean): boolean;
+  getStats(): ProcessingStageStats[];
+  reset(): void;
+}
+
+export type RecordedTrack = 'microphone' | 'system' | 'processed' | 'mix';
+
+/** The mix track: processed mic plus system audio, limited, written as mixed */
+export interface RecordingMixOptions {
+  /** -40 to 20 (default: 0) */
+  micGainDb?: number;
+  systemGainDb?: number;
+  /** Two channels with each source panned (default: mono) */
+  stereo?: boolean;
+  /** -1 (left) to 1 (right), stereo only (default: 0) */
+  micPan?: number;
+  systemPan?: number;
+}
+
+export interface RecordingOptions {
+  /** Existing directory the files go in */
+  directory: string;
+  /** File prefix: <name>.<track>.<n>.wav (default: 'recording') */
+  name?: string;
+  /** Default: all but 'mix'; 'processed' and 'mix' are written only while native AEC runs */
+  tracks?: RecordedTrack[];
+  /** 'pcm16' (default) or 'float32' WAV */
+  format?: 'pcm16' | 'float32';
+  /** Header patch + fsync period, 100-10000 (default: 1000) */
+  syncIntervalMs?: number;
+  /** A track starts a new file after this, 10s-3h (default: 600) */
+  chunkSeconds?: number;
+  /** Seek index granularity, 100-10000 (default: 1000) */
+  indexIntervalMs?: number;
+  /** Silence past this is marked in the index, not stored, 1000-60000; 0 stores it all (default: 2000) */
+  compactSilenceMs?: number;
+  /** Seal the samples with AES-256-GCM under the key installRecordingKey() set; the start fails without one */
+  encrypt?: boolean;
+  /** Records the mix track with these settings, whatever tracks says */
+  mix?: RecordingMixOptions;
+}
+
+export interface RecordedFile {
+  track: RecordedTrack;
+  path: string;
+  sampleRate: number;
+  /** 2 for a stereo mix */
+  channels: number;
+  /** Frames */
+  samples: number;
+}
+
+export interface RecordingSummary {
+  files: RecordedFile[];
+  /** <name>.<track>.idx per track that wrote audio; what openRecording() takes */
+  indexes: Partial<Record<RecordedTrack, string>>;
+  /** Samples lost to a full buffer or a failed write, per track */
+  droppedSamples: Record<RecordedTrack, number>;
+  /** Per track that wrote audio, as of its last sync; kept in its index too */
+  loudness: Partial<Record<RecordedTrack, { integratedLufs: number; peakDbfs: number }>>;
+  /** Silence left out of each track's files, in ms */
+  compactedMs: Partial<Record<RecordedTrack, number>>;
+}
+
+export interface RecordingStatus extends RecordingSummary {
+  recording: boolean;
+}
+
+export interface TalkAnalyticsOptions {
+  /** Speech probability of a voiced 10ms frame (default 0.5) */
+  threshold?: number;
+  /** Voiced run that starts an utterance (default 150) */
+  minSpeechMs?: number;
+  /** Silence that ends one (default 500) */
+  trailingSilenceMs?: number;
+  /** Prosody question likelihood that counts an utterance as a question (default 0.5) */
+  questionThreshold?: number;
+}
+
+export interface TalkPartyTotals {
+  talkMs: number;
+  utterances: number;
+  /** Times the party took the floor */
+  turns: number;
+  /** Longest monologue: the floor held, pauses included */
+  longestTurnMs: number;
+  /** Utterances begun while the other party spoke */
+  overlaps: number;
+  /** Of those, ones the other party stopped for */
+  interruptions: number;
+  questions: number;
+  /** The other party's questions answered by taking the floor */
+  responses: number;
+  meanResponseLatencyMs: number;
+  maxResponseLatencyMs: number;
+}
+
+export interface TalkAnalytics {
+  elapsedMs: number;
+  /** Frames voiced on both sides */
+  overlapMs: number;
+  /** The microphone */
+  local: TalkPartyTotals;
+  /** System audio: every remote participant together */
+  remote: TalkPartyTotals;
+}
+
+export interface TalkAnalyticsStatus extends TalkAnalytics {
+  running: boolean;
+}
+
+export interface RecordingLoudness {
+  /** EBU R128 integrated loudness of the track; -70 when silent */
+  integratedLufs: number;
+  /** Sample peak */
+  peakDbfs: number;
+  /** What playback applies to reach the target getInfo() was given */
+  gainDb: number;
+}
+
+export interface RecordingInfo {
+  /** Unix epoch ms of recording time 0 */
+  startedAt: number;
+  intervalMs: number;
+  entries: number;
+  durationMs: number;
+  /** Compacted silence within durationMs; 0 for older recordings */
+  silenceMs: number;
+  /** Metered by the recorder as it wrote; null for older recordings */
+  loudness: RecordingLoudness | null;
+}
+
+export interface RecordingRange {
+  /** Float32Array for float32 recordings; Int16Array for pcm16. Interleaved when stereo */
+  samples: Float32Array | Int16Array;
+  sampleRate: number;
+  channels: number;
+  /** Recording time of samples[0]; later than asked across a gap */
+  startMs: number;
+  /** Compacted silence, played back as zeros */
+  silent: boolean;
+}
+
+export interface RecordingSilences {
+  /** Compacted silence within the span asked for */
+  totalMs: number;
+  runs: Array<{ startMs: number; durationMs: number }>;
+}
+
+export interface RecordingPeaks {
+  /** 10, 100 or 1000: the coarsest that still gives the points asked for */
+  bucketMs: number;
+  /** Recording time of the first bucket */
+  startMs: number;
+  /** min, max, rms per bucket, full scale 32767; zeros where nothing was recorded */
+  peaks: Int16Array;
+}
+
+/**
+ * One track of a recording, opened by its seek index. Opening reads the
+ * index only and a read touches just its range, so seeking in a two-hour
+ * meeting costs the same as in a short one.
+ */
+export interface NativeRecordingReader {
+  /** Loudness gain towards targetLufs (default: -16) */
+  getInfo(targetLufs?: number): RecordingInfo;
+  /**
+   * Stops at a file boundary and at compacted silence (read on from startMs
+   * + what came back); null at the end. skipSilence jumps silence instead of
+   * returning it as zeros.
+   */
+  read(startMs: number, durationMs: number, options?: { skipSilence?: boolean }): RecordingRange | null;
+  /** Waveform for a timeline showing [startMs, endMs) across about `points` pixels */
+  getPeaks(startMs: number, endMs: number, points: number): RecordingPeaks;
+  /** The silence runs a skip-silence player jumps in [startMs, endMs) */
+  getSilences(startMs: number, endMs: number): RecordingSilences;
+}
+
+export interface RecordingPlayerOptions {
+  /** Output rate, 8000 to 48000 (default: 48000) */
+  sampleRate?: number;
+  /** 0.5 to 3, at the recording's pitch (default: 1) */
+  speed?: number;
+  /** Jump compacted silence instead of playing it (default: false) */
+  skipSilence?: boolean;
+}
+
+export interface RecordingPlayerState {
+  positionMs: number;
+  durationMs: number;
+  speed: number;
+  skipSilence: boolean;
+  ended: boolean;
+  sampleRate: number;
+  channels: number;
+}
+
+/**
+ * One track of a recording played faster or slower for review. Nothing
+ * plays ahead of read(), so speed, skip-silence and seeks take effect on
+ * the next buffer.
+ */
+export interface NativeRecordingPlayer {
+  /**
+   * The next `frames` of output, interleaved when stereo; fewer only at the
+   * end. positionMs is the recording time the buffer starts at.
+   */
+  read(frames: number): {
+    samples: Float32Array;
+    channels: number;
+    sampleRate: number;
+    positionMs: number;
+    ended: boolean;
+  };
+  seek(ms: number): void;
+  setSpeed(speed: number): void;
+  setSkipSilence(skip: boolean): void;
+  getState(): RecordingPlayerState;
+}
+
+export interface EmbeddingIndexOptions {
+  dims: number;
+  /** 'float16' halves memory, 'int8' quarters it (default: 'float32') */
+  quantization?: 'float32' | 'float16' | 'int8';
+  /** Scale vectors to unit length so scores are cosine similarity (default: true) */
+  normalize?: boolean;
+  /** Flat scan below this many vectors, an HNSW graph from there (default: 4096) */
+  graphThreshold?: number;
+  m?: number;
+  efConstruction?: number;
+  /** Graph search breadth; higher trades speed for recall (default: 64) */
+  efSearch?: number;
+}
+
+export interface EmbeddingHit {
+  id: string;
+  score: number;
+}
+
+/** In-memory top-k search over knowledge-base and past-meeting embeddings */
+export interface NativeEmbeddingIndex {
+  /** Replaces the vector already under `id`; throws on a wrong length */
+  add(id: string, vector: Float32Array | number[]): void;
+  remove(id: string): boolean;
+  clear(): void;
+  /** Best first */
+  search(query: Float32Array | number[], k: number): EmbeddingHit[];
+  getStats(): { size: number; dims: number; graph: boolean; bytes: number };
+}
+
+/**
+ * Embeddings in a file (<name>.kkev) searched through a memory map: opening
+ * reads only the header, and nothing of the store lives in the JS heap.
+ */
+export interface NativeEmbeddingStore {
+  /** Ids are up to 63 bytes; an id is not checked for an earlier vector, remove() it first */
+  append(id: string, vector: Float32Array | number[]): void;
+  /** How many records were marked removed */
+  remove(id: string): number;
+  /** The same for every id starting with `prefix` */
+  removePrefix(prefix: string): number;
+  /** Best first */
+  search(query: Float32Array | number[], k: number): EmbeddingHit[];
+  /**
+   * This store's scan and the lexical index's BM25 at once, fused by
+   * reciprocal rank; a search still going at budgetMs (default: 20) is cut
+   * short and complete is false. Null vector: lexical only. Missing from
+   * older addons.
+   */
+  hybridSearch?(
+    query: Float32Array | number[] | null,
+    text: string,
+    lexical: NativeLexicalIndex,
+    options: { k: number; budgetMs?: number; rrfK?: number }
+  ): { hits: HybridHit[]; complete: boolean; elapsedMs: number };
+  /** records counts removed ones too */
+  getStats(): { records: number; dims: number; bytes: number };
+  close(): void;
+}
+
+/** A fused hit; ranks are 0-based in each search, -1 where it was not found */
+export interface HybridHit {
+  id: string;
+  score: number;
+  vectorRank: number;
+  lexicalRank: number;
+}
+
+/**
+ * BM25 over short texts (knowledge chunks), postings only, for the exact
+ * terms embeddings blur: product codes, names
+ */
+export interface NativeLexicalIndex {
+  /** Replaces what `id` had */
+  add(id: string, text: string): void;
+  remove(id: string): boolean;
+  removePrefix(prefix: string): number;
+  /** Best first */
+  search(text: string, k: number): EmbeddingHit[];
+  getStats(): { documents: number; terms: number; bytes: number };
+}
+
+/** A window of the running meeting's transcript, from MeetingIndex.search */
+export interface MeetingWindowHit extends HybridHit {
+  text: string;
+  startMs: number;
+  endMs: number;
+}
+
+/**
+ * The running meeting's transcript in token-bounded windows of whole lines,
+ * each in BM25 postings once sealed and in a vector index once the caller
+ * embeds it, for callouts to pull back earlier discussion
+ */
+export interface NativeMeetingIndex {
+  /** One final line; true when it sealed the window before it */
+  append(timestampMs: number, line: string): boolean;
+  seal(): void;
+  clear(): void;
+  /** Sealed windows still without an embedding, oldest first; the same ones until embedded */
+  takeUnembedded(max: number): { id: string; text: string }[];
+  setEmbeddings(ids: string[], vectors: (Float32Array | number[])[]): void;
+  /** Fused by reciprocal rank, among windows ending before beforeMs; lexical only without a vector */
+  search(
+    text: string,
+    vector: Float32Array | number[] | null,
+    options: { k: number; beforeMs?: number; rrfK?: number }
+  ): MeetingWindowHit[];
+  getStats(): { lines: number; windows: number; embedded: number; tokens: number; bytes: number };
+}
+
+/**
+ * Embeddings by model and text (whitespace runs as one space) in a
+ * memory-mapped file, least recently used ones evicted past capacity, so a
+ * text embedded once is not sent to the API again.
+ */
+export interface NativeEmbeddingCache {
+  /** A vector per text found, null per miss; hits become the most recent */
+  lookup(model: string, texts: string[]): (Float32Array | null)[];
+  /** One vector per text */
+  store(model: string, texts: string[], vectors: (Float32Array | number[])[]): void;
+  getStats(): {
+    entries: number;
+    capacity: number;
+    hits: number;
+    misses: number;
+    evictions: number;
+    compactions: number;
+    bytes: number;
+  };
+  close(): void;
+}
+
+/**
+ * cl100k_base token counts for prompt budgets and embedding chunks. Exact
+ * when made with the encoding's ranks file, estimated otherwise.
+ */
+export interface NativeTokenizer {
+  count(text: string): number;
+  /** The longest prefix within maxTokens, or suffix when fromEnd */
+  truncate(text: string, maxTokens: number, fromEnd?: boolean): string;
+  /** Cut at sentences and lines where they fit, overlapping by about overlapTokens */
+  chunk(text: string, options: { maxTokens: number; overlapTokens?: number }): { text: string; tokens: number }[];
+  isExact(): boolean;
+}
+
+export interface TriggerPattern {
+  id: string;
+  /** Case-insensitive; whitespace runs match one space */
+  text: string;
+  /** 'start': the utterance's first words; 'end': its last characters (default: 'anywhere') */
+  anchor?: 'anywhere' | 'start' | 'end';
+  /** Not inside a longer word (default: true) */
+  wholeWord?: boolean;
+}
+
+export interface TriggerMatch {
+  id: string;
+  /** UTF-8 bytes into what the stream was fed since its last end() */
+  offset: number;
+  length: number;
+}
+
+/**
+ * Question openers and keyword triggers in one automaton, fed transcript
+ * text as it arrives; the cost per character does not grow with the
+ * number of triggers. Streams are named, e.g. by audio source.
+ */
+export interface NativeTriggerMatcher {
+  feed(stream: string, text: string): TriggerMatch[];
+  /** The utterance is over: matches that needed that ('end' anchors, a word at the very end) */
+  end(stream: string): TriggerMatch[];
+  /** Forget what the stream was fed, when earlier text was revised */
+  reset(stream: string): void;
+}
+
+export interface FuzzyEntry {
+  id: string;
+  /** Names, addresses: whatever the entry can be found by */
+  keys: string[];
+}
+
+export interface FuzzyHit {
+  id: string;
+  /** Index into the entry's keys of the one that matched */
+  key: number;
+  /** 0-1; 1 when equal ignoring case and punctuation */
+  score: number;
+}
+
+/**
+ * Native FuzzyIndex: approximate lookup over names and emails, with a
+ * trigram prefilter and bit-parallel Levenshtein / Jaro-Winkler scoring.
+ * Immutable; build a new one when the entries change.
+ */
+export interface NativeFuzzyIndex {
+  search(query: string, options?: { limit?: number; minScore?: number }): FuzzyHit[];
+}
+
+export interface KnowledgeChunk {
+  /** `<document prefix><n>`, at most 63 bytes */
+  id: string;
+  /** Relative to the root, '/'-separated */
+  path: string;
+  index: number;
+  text: string;
+}
+
+export interface KnowledgeIngestOptions {
+  /** The knowledge-base folder */
+  root: string;
+  /** Where the last run's documents are remembered (size, mtime, text hash) */
+  manifest: string;
+  /** Drop the stored chunks of a document that changed or went away */
+  onRemove: (prefix: string, path: string) => void;
+  /** Chunks to embed and store; the next batches wait on the promise */
+  onBatch: (batch: { id: number; chunks: KnowledgeChunk[] }) => Promise<void> | void;
+  /** Extraction workers (default: every core but one) */
+  threads?: number;
+  /** Chunks end at a paragraph, sentence or word near this (default: 1500) */
+  chunkBytes?: number;
+  overlapBytes?: number;
+  batchChunks?: number;
+  /** Batches handed to onBatch and not yet settled (default: 4) */
+  maxInFlight?: number;
+}
+
+export interface KnowledgeIngestStats {
+  documents: number;
+  /** Same size and mtime as last time, or the same text */
+  unchanged: number;
+  indexed: number;
+  removed: number;
+  /** Unreadable, or a batch of theirs failed; retried next run */
+  failed: number;
+  chunks: number;
+  batches: number;
+  elapsedMs: number;
+  cancelled: boolean;
+}
+
+export interface KnowledgeIngestHandle {
+  /** Rejects only when root is not a folder */
+  done: Promise<KnowledgeIngestStats>;
+  cancel(): void;
+}
+
+export interface CompressionOptions {
+  /** A finished (or cut-short) recording WAV */
+  input: string;
+  output: string;
+  /** 'flac' (default, lossless) or 'opus' (builds with libopus only) */
+  format?: 'flac' | 'opus';
+  /** Opus only, 6000-128000 (default: 32000) */
+  bitrate?: number;
+  /** Remove the WAV once the output is complete (default: false) */
+  deleteInput?: boolean;
+  /** Called with 0-1 as the job advances */
+  onProgress?: (fraction: number) => void;
+}
+
+export interface CompressionResult {
+  output: string;
+  inputBytes: number;
+  outputBytes: number;
+  audioSeconds: number;
+  elapsedMs: number;
+}
+
+export interface SegmentationOptions {
+  /** Seek index (<name>.<track>.idx) of the track to split */
+  index: string;
+  /** An existing directory; segments are written as <name>.<n>.flac */
+  outputDir: string;
+  name?: string;
+  /** Segments aim for this length, cut at the nearest pause (default: 60000) */
+  targetSegmentMs?: number;
+  /** How far a cut may move to land in a pause (default: a quarter of the target) */
+  maxShiftMs?: number;
+  /** The shortest pause a cut goes in (default: 300) */
+  minSilenceMs?: number;
+  /** VAD speech probability (default: 0.5) */
+  threshold?: number;
+  /** Of the segments written (default: 16000) */
+  sampleRate?: number;
+  /** Worker threads (default: half the cores) */
+  threads?: number;
+  /** Called as each segment is written, in any order */
+  onSegment?: (segment: RecordingSegmentFile) => void;
+}
+
+/** One segment of a split recording: 16-bit mono FLAC of [startMs, endMs) */
+export interface RecordingSegmentFile {
+  index: number;
+  path: string;
+  /** Recording time; times inside the file are startMs plus the offset */
+  startMs: number;
+  endMs: number;
+  speechMs: number;
+  bytes: number;
+}
+
+export interface SegmentationResult {
+  /** In order; segments without speech are left out */
+  segments: RecordingSegmentFile[];
+  audioMs: number;
+  speechMs: number;
+  vadMs: number;
+  encodeMs: number;
+  elapsedMs: number;
+}
+
+/** A transcript word where the provider put it, in recording time */
+export interface AlignmentWord {
+  text: string;
+  startMs: number;
+  endMs: number;
+}
+
+export interface AlignmentOptions {
+  /** Seek index of the track the words were heard on */
+  index: string;
+  /** In order */
+  words: AlignmentWord[];
+  /** How far a run of words may move as a whole (default: 3000) */
+  maxShiftMs?: number;
+  /** And each word within its run (default: 600) */
+  maxWordShiftMs?: number;
+  /** A longer pause between words starts a new run (default: 800) */
+  runGapMs?: number;
+}
+
+export interface AlignedWord {
+  /** Recording time */
+  startMs: number;
+  endMs: number;
+  /** The same in samples at sampleRate */
+  startSample: number;
+  endSample: number;
+  /** Mean speech evidence over the word, 0-1 */
+  confidence: number;
+}
+
+export interface AlignmentResult {
+  /** One per word given, in order */
+  words: AlignedWord[];
+  /** Of the track where the first word is */
+  sampleRate: number;
+  runs: number;
+  meanShiftMs: number;
+  maxShiftMs: number;
+  audioMs: number;
+  elapsedMs: number;
+}
+
+export type TranscriptAligner = (options: AlignmentOptions) => Promise<AlignmentResult>;
+
+export interface ClipOptions {
+  /** Seek indexes of the tracks to mix */
+  tracks: string[];
+  /** Recording time of the first track */
+  startMs: number;
+  /** Up to 10 minutes; shorter at the end of the recording */
+  durationMs: number;
+  /** Ogg Opus, in builds with libopus, or 16-bit WAV (default: 'opus') */
+  format?: 'opus' | 'wav';
+  /** Opus takes 8000, 12000, 16000, 24000 or 48000 (default: 48000) */
+  sampleRate?: number;
+  /** Opus, in bits per second (default: 48000) */
+  bitrate?: number;
+  /** Loudness the clip is brought to, under a -1dBFS peak (default: -16) */
+  targetLufs?: number;
+  /** A file to write; without one the clip comes back as data */
+  output?: string;
+}
+
+export interface ClipResult {
+  output?: string;
+  data?: Buffer;
+  bytes: number;
+  durationMs: number;
+  sampleRate: number;
+  /** Normalization applied; the first track's when measured */
+  gainDb: number;
+  /** Gains came from the loudness the recorder metered, not from the clip */
+  measured: boolean;
+  elapsedMs: number;
+}
+
+export interface ReprocessMeeting {
+  /** Seek index of the raw mic track */
+  microphone: string;
+  /** Of the system track, the echo reference; left out, the mic is only cleaned */
+  system?: string;
+  /** 16-bit mono FLAC of the reprocessed mic */
+  output: string;
+}
+
+export interface ReprocessOptions {
+  meetings: ReprocessMeeting[];
+  /** The chain to run, as the capture options take it (default: the stock config) */
+  aec?: AECConfig;
+  /** Both tracks are resampled to this and the output is at it (default: 16000) */
+  sampleRate?: number;
+  onEvent?: (event: ReprocessEvent) => void;
+}
+
+export type ReprocessMeetingResult =
+  | { meeting: number; output: string; ok: false; error: string }
+  | {
+      meeting: number;
+      output: string;
+      ok: true;
+      audioMs: number;
+      elapsedMs: number;
+      outputBytes: number;
+      metrics: AECMetrics;
+    };
+
+/** meeting indexes ReprocessOptions.meetings */
+export type ReprocessEvent =
+  | { type: 'progress'; meeting: number; fraction: number }
+  | ({ type: 'meeting' } & ReprocessMeetingResult);
+
+export interface ReprocessJob {
+  /** Every meeting's result in order, failed ones included */
+  done: Promise<ReprocessMeetingResult[]>;
+  /** Fails the meetings not yet finished */
+  cancel(): void;
+}
+
+export interface BundleEntry {
+  /** Path inside the archive: relative, '/'-separated */
+  name: string;
+  /** Stored as is; a string goes in as UTF-8 */
+  data: string | Buffer;
+}
+
+export interface BundleTrack {
+  /** Path inside the archive, e.g. 'audio/microphone.flac' */
+  name: string;
+  /** The track's seek index, <name>.<track>.idx */
+  index: string;
+}
+
+export interface BundleOptions {
+  /** The ZIP to write; appears only once complete */
+  output: string;
+  /** Written first, in order */
+  entries?: BundleEntry[];
+  /** Each as 16-bit mono FLAC, encoded from the recording files */
+  tracks?: BundleTrack[];
+  /** Path of every track mixed into one FLAC on their shared timeline */
+  mix?: string;
+  /** Every track is resampled to this, and so is the mix (default: 48000) */
+  sampleRate?: number;
+  onProgress?: (fraction: number) => void;
+}
+
+export interface BundleResult {
+  output: string;
+  outputBytes: number;
+  entries: number;
+  /** Of the longest track */
+  audioMs: number;
+  elapsedMs: number;
+}
+
+export interface BundleJob {
+  done: Promise<BundleResult>;
+  /** Rejects done and leaves no file */
+  cancel(): void;
+}
+
+export type TaskPriorityClass = 'realtime' | 'interactive' | 'background';
+
+/** The native scheduler compression, segmentation and reprocessing run on */
+export interface SchedulerStats {
+  threads: number;
+  /** Workers that take only realtime and interactive tasks */
+  interactiveThreads: number;
+  /** Tasks waiting, every class */
+  queueDepth: number;
+  queued: Record<TaskPriorityClass, number>;
+  running: Record<TaskPriorityClass, number>;
+  completed: Record<TaskPriorityClass, number>;
+  /** Tasks an idle worker took from another's deque */
+  steals: number;
+  /** Times background work paused for audio that was falling behind */
+  yields: number;
+  yieldMs: number;
+  /** Audio missed or nearly missed a deadline within the last half second */
+  audioAtRisk: boolean;
+}
+
+/** How often one kind of native thread woke; 0/s everywhere when idle */
+export interface WakeupStat {
+  /** e.g. 'aecDsp', 'captureConsumer', 'logForwarder' */
+  name: string;
+  /** Since the module loaded */
+  wakeups: number;
+  /** Since the previous getWakeupStats() */
+  perSecond: number;
+}
+
+export type MemoryPressureLevel = 'normal' | 'warning' | 'critical';
+
+/** Native memory: the process's resident set and what each component holds */
+export interface NativeMemoryUsage {
+  rssBytes: number;
+  pressure: MemoryPressureLevel;
+  /** One per open capture stream: rings, session arena and slab pool */
+  components: Array<{ name: string; bytes: number }>;
+}
+
+/** What native buffers shrink to under memory pressure */
+export interface MemoryMinimums {
+  /** Idle slabs a capture stream's pool keeps, beyond those on loan */
+  idleSlabs?: number;
+  /** Gate pre-roll of a stream opened under pressure */
+  prerollMs?: number;
+}
+
+export type SessionCaptureStream = 'microphone' | 'system';
+
+export interface SessionCaptureSummary {
+  buffers: Record<SessionCaptureStream, number>;
+  samples: Record<SessionCaptureStream, number>;
+  /** Buffers the capture had no room for; the session itself lost nothing */
+  dropped: Record<SessionCaptureStream, number>;
+  /** Pauses, gaps and device moves */
+  events: number;
+  bytes: number;
+}
+
+export interface TranscriptionSocketOptions {
+  /** wss:// endpoint, query string included */
+  url: string;
+  /** Sent with the upgrade request, e.g. Authorization */
+  headers?: Record<string, string>;
+  /** Of the PCM16 audio sent, to time audio positions (default: 16000) */
+  sampleRate?: number;
+  /** Interleaved per frame; 2 for a ChannelInterleaver's output (default: 1) */
+  channels?: number;
+  /** Audio held while connecting or stalled before the oldest drops (default: 1MiB, ~32s at 16kHz) */
+  maxQueuedBytes?: number;
+  /** Text frame sent after intervalMs without any other send */
+  keepAlive?: { message: string; intervalMs: number };
+  /** Text frame close() sends to ask the server for its last results */
+  closeMessage?: string;
+  /** How long close() waits for the server to hang up (default: 3000) */
+  closeTimeoutMs?: number;
+  /**
+   * Reconnect after a lost connection (not a deliberate close by the
+   * server): up to `attempts` in a row, delayMs doubling (default: 500)
+   */
+  reconnect?: { attempts: number; delayMs?: number };
+  /**
+   * Sent audio kept natively for a reconnect. The new session replays it
+   * from the last acknowledge(), so the transcript has no hole (default: 0)
+   */
+  replayMs?: number;
+  /** A replay or backlog goes out at this multiple of real time; 0 = unpaced (default: 2) */
+  replayRate?: number;
+  /**
+   * Parse this provider's result frames natively: they arrive as 'transcript'
+   * events, and only other frames as 'message'
+   */
+  parse?: 'assemblyai' | 'deepgram';
+  /**
+   * How far the transcript may run behind the audio. As the audio queued or
+   * the round trip to a first result nears it, sends are coalesced and a
+   * capture stream sending here gates silence harder, until the uplink
+   * recovers; 0 = no adapting (default: 1500)
+   */
+  latencyBudgetMs?: number;
+}
+
+export type TranscriptionSocketEvent =
+  /**
+   * Once per session, reconnects included. The provider's times are relative
+   * to the session, which starts audioOffsetMs into the audio sent; the
+   * first replayedMs of it were sent before
+   */
+  | { type: 'open'; audioOffsetMs: number; replayedMs: number }
+  | { type: 'reconnecting'; attempt: number; message: string }
+  /** One text frame, as received */
+  | { type: 'message'; data: string }
+  /**
+   * One result frame, with the parse option. Times are ms into the session;
+   * wordTimes holds start, end, confidence and final (0 or 1) per word
+   */
+  | {
+      type: 'transcript';
+      text: string;
+      isFinal: boolean;
+      endOfTurn: boolean;
+      formatted: boolean;
+      /** -1 when the provider has no turn order */
+      turn: number;
+      confidence: number;
+      startMs: number;
+      endMs: number;
+      words: string[];
+      wordTimes: Float64Array;
+    }
+  | { type: 'error'; message: string }
+  /** Always the last event */
+  | { type: 'close'; code: number; reason: string };
+
+export interface TranscriptionSocketStats {
+  state: 'idle' | 'connecting' | 'open' | 'closing' | 'closed';
+  sentBytes: number;
+  sentMessages: number;
+  receivedMessages: number;
+  /** Of those, delivered as 'transcript' events */
+  parsedMessages: number;
+  droppedBytes: number;
+  queuedBytes: number;
+  reconnects: number;
+  replayedBytes: number;
+  /** Sent audio held for a replay */
+  historyBytes: number;
+  /** Congestion, 0 (keeping up) to 3 */
+  pressure: number;
+  /** Smoothed round trip from sending audio to its first result */
+  rttMs: number;
+  /** Audio queued */
+  backlogMs: number;
+  /** The larger of rttMs and backlogMs over latencyBudgetMs */
+  budgetUtilization: number;
+  /** Audio messages sent as part of another */
+  coalescedMessages: number;
+}
+
+/** One instant of a transcription session on each of its axes */
+export interface TimelinePosition {
+  /** Provider time, into the session */
+  sessionMs: number;
+  /** Audio position, in frames from the first one queued on the socket */
+  streamSample: number;
+  /** When it was captured, as Date.now() */
+  captureTime: number;
+}
+
+/**
+ * A provider websocket run by the addon on its own I/O thread, over the OS
+ * TLS stack. Audio reaches it from a capture stream's transport option
+ * without passing through JS; JS only sees the provider's messages. Keep a
+ * reference while it is open: collecting it drops the connection.
+ */
+export interface NativeTranscriptionSocket {
+  /** False when already connected once */
+  connect(onEvent: (event: TranscriptionSocketEvent) => void): boolean;
+  /** A text frame, after the audio already queued */
+  send(text: string): void;
+  /** Audio that arrives in JS rather than from a native stream; timestamp as Date.now() */
+  sendAudio(samples: Int16Array, timestamp?: number): void;
+  /** Final results cover the session up to sessionMs; a replay starts there */
+  acknowledge(sessionMs: number): void;
+  /** When the audio sessionMs into the session was captured (Date.now()); 0 when unknown */
+  captureTime(sessionMs: number): number;
+  /**
+   * The current session's timeline from any of its axes, by binary search
+   * over its piecewise-linear segments. A stream sample or capture time in
+   * gated silence lands where the audio resumed; null before the session's
+   * audio.
+   */
+  locate(at: { sessionMs: number } | { streamSample: number } | { captureTime: number }): TimelinePosition | null;
+  /** Sends what is queued and closeMessage; a 'close' event follows */
+  close(code?: number): void;
+  getStats(): TranscriptionSocketStats;
+}
+
+export interface ChannelInterleaverOptions {
+  /** A socket created with channels: 2 at sampleRate */
+  output: NativeTranscriptionSocket;
+  /** Of both channels and the output (default: 16000) */
+  sampleRate?: number;
+  /** A channel this far behind the other is silence-filled (default: 200) */
+  maxLagMs?: number;
+}
+
+export interface ChannelInterleaverStats {
+  framesSent: number;
+  /** Per channel, filled in for gaps and lag */
+  silenceFrames: [number, number];
+  /** Per channel, overlapping what it had or too late */
+  droppedFrames: [number, number];
+  /** Silent on both for over a second, not sent */
+  skippedFrames: number;
+}
+
+/** One channel of a NativeChannelInterleaver, for MicCaptureOptions.transport */
+export interface NativeInterleaverChannel {
+  /** Audio that arrives in JS rather than from a native stream; timestamp as Date.now() */
+  sendAudio(samples: Int16Array, timestamp?: number): void;
+}
+
+/**
+ * Merges the mic (channel 0) and system audio (channel 1) into one
+ * sample-aligned stereo PCM16 stream on the output socket, placed by
+ * capture time with gaps silence-filled, for providers that transcribe
+ * channels separately over one connection.
+ */
+export interface NativeChannelInterleaver {
+  channel(index: 0 | 1): NativeInterleaverChannel;
+  /** Sends what either channel holds; before closing the output */
+  flush(): void;
+  getStats(): ChannelInterleaverStats;
+}
+
+export interface LocalTranscriberOptions {
+  /** A ggml whisper model file; quantized ones (q5_0, q8_0) decode fastest */
+  modelPath: string;
+  /** Spoken language, or 'auto' (default: 'en') */
+  language?: string;
+  /** Decode threads (default: half the cores, at most 8) */
+  threads?: number;
+  /** Metal where the library was built with it (default: true) */
+  useGpu?: boolean;
+  /** Of the PCM16 audio sent; resampled to the model's 16kHz (default: 16000) */
+  sampleRate?: number;
+  /** A partial after this much new audio in an utterance (default: 1000) */
+  stepMs?: number;
+  /** Longer utterances are cut and finalized here, at most 30000 (default: 15000) */
+  maxUtteranceMs?: number;
+  /** A jump in capture time this long, e.g. gated silence, ends the utterance (default: 1000) */
+  gapMs?: number;
+  /** Audio waiting for the decoder before the oldest drops (default: 30000) */
+  maxQueuedMs?: number;
+}
+
+export interface LocalTranscriberWord {
+  text: string;
+  /** Milliseconds into the audio sent */
+  start: number;
+  end: number;
+  confidence: number;
+}
+
+export type LocalTranscriberEvent =
+  | { type: 'ready'; loadMs: number }
+  /**
+   * One utterance so far, or all of it. startMs and endMs count the audio
+   * sent; timestamp is when startMs was captured (Date.now())
+   */
+  | {
+      type: 'partial' | 'final';
+      text: string;
+      startMs: number;
+      endMs: number;
+      timestamp: number;
+      words: LocalTranscriberWord[];
+    }
+  | { type: 'error'; message: string }
+  /** Always the last event */
+  | { type: 'close' };
+
+export interface LocalTranscriberStats {
+  state: 'idle' | 'loading' | 'running' | 'closing' | 'closed';
+  audioMs: number;
+  /** Of audioMs, taken by the decoder */
+  decodedMs: number;
+  /** Decoder time, partials included */
+  decodeMs: number;
+  /** decodeMs / decodedMs; below 1 keeps up with real time */
+  realTimeFactor: number;
+  /** Decoder time of the last final, from its utterance's end */
+  finalLagMs: number;
+  queuedMs: number;
+  droppedMs: number;
+  partials: number;
+  finals: number;
+}
+
+/**
+ * An on-device streaming transcriber: a whisper model decoding on a native
+ * thread pool, fed from a capture stream's transport option or sendAudio().
+ * Streams on the same model share its weights. Keep a reference while it
+ * runs: collecting it stops the decoder.
+ */
+export interface NativeLocalTranscriber {
+  /** False when already connected once or the addon was built without whisper */
+  connect(onEvent: (event: LocalTranscriberEvent) => void): boolean;
+  /** Audio that arrives in JS rather than from a native stream; timestamp as Date.now() */
+  sendAudio(samples: Int16Array, timestamp?: number): void;
+  /** Finalize the open utterance, e.g. on a gate silence marker */
+  endUtterance(): void;
+  /** Finalizes what was sent; a 'close' event follows */
+  close(): void;
+  getStats(): LocalTranscriberStats;
+}
+
+/** The addon reads a ring through a Uint8Array; it cannot see a bare SharedArrayBuffer */
+function nativeCaptureOptions(options: MicCaptureOptions): object {
+  return options.sharedRing instanceof SharedArrayBuffer
+    ? { ...options, sharedRing: new Uint8Array(options.sharedRing) }
+    : options;
+}
+
+const DEFAULT_CONFIG: Required<AECConfig> = {
+  preset: 'aggressive',
+  enableAec: true,
+  enableNs: true,
+  nsLevel: 'moderate',
+  enableAgc: false,
+  disableAecOnHeadphones: true,
+  adaptiveSuppression: false,
+  cpuGovernor: false,
+  normalizeSpeech: false,
+  normalizeTargetDbfs: -20,
+  frameDurationMs: 10,
+  sampleRate: 48000,
+  processingSampleRate: 48000,
+  renderChannels: 1,
+};
+
+/**
+ * TypeScript wrapper for the native WebRTC AEC module.
+ * Manages render/capture processing and native mic capture.
+ */
+export class AECProcessor {
+  private nativeModule: any = null;
+  private nativeInstance: any = null;
+  private config: Required<AECConfig>;
+  private isInitialized = false;
+  private isDestroyed = false;
+  private micCapturing = false;
+  private micAudioCallback?: MicAudioCallback<CaptureSamples>;
+  private micProcessed = false;
+  private micPaused = false;
+  // Pause and resume run one after the other, so a quick toggle lands as asked
+  private micPauseQueue: Promise<boolean> = Promise.resolve(true);
+  private systemCapturing = false;
+  private systemAudioCallback?: SystemAudioCallback<CaptureSamples>;
+  private asyncProcessing = false;
+  private asyncCallback?: MicAudioCallback<CaptureSamples>;
+
+  constructor(config: AECConfig = {}) {
+    this.config = { ...DEFAULT_CONFIG, ...config };
+
+    try {
+      // Load the native module (exports a class AudioCaptureAddon)
+      let nativeModule;
+      
+      try {
+        // First try: use bindings module (works in dev/unbundled)
+        logger.debug('Attempting to load native addon via bindings module...');
+          logger.debug('DEBUG:', { __dirname, cwd: process.cwd() });
+        nativeModule = bindings('audio_capture_native');
+        logger.debug('Loaded native addon via bindings module');
+      } catch (bindingsError) {
+        // Fallback: try to require directly at runtime using multiple possible paths
+        // eslint-disable-next-line @typescript-eslint/no-require-imports
+        const fs = require('fs');
+        // eslint-disable-next-line @typescript-eslint/no-require-imports
+        const path = require('path');
+        
+        const errorMsg = bindingsError instanceof Error ? bindingsError.message : String(bindingsError);
+        logger.debug('bindings() failed, trying direct require paths', { error: errorMsg.substring(0, 100) });
+        
+        const possiblePaths: string[] = [];
+        
+        // Try same directory as the bundled code (after build copy)
+        possiblePaths.push(
+          path.join(__dirname, 'audio_capture_native.node')
+        );
+        
+        // Try absolute dev paths
+        possiblePaths.push(
+          path.resolve('/Users/moxo/Desktop/kakarot-master/native/build/Release/audio_capture_native.node'),
+          path.resolve('/Users/moxo/Desktop/kakarot-master/build/Release/audio_capture_native.node')
+        );
+        
+        // Try cwd-relative paths
+        possiblePaths.push(
+          path.join(process.cwd(), 'native/build/Release/audio_capture_native.node'),
+          path.join(process.cwd(), 'build/Release/audio_capture_native.node'),
+          path.join(process.cwd(), 'audio_capture_native.node')
+        );
+        
+        // Try relative to app directory (for production)
+        if (process.resourcesPath) {
+          possiblePaths.push(
+            path.join(process.resourcesPath, 'app/native/build/Release/audio_capture_native.node'),
+            path.join(process.resourcesPath, 'native/build/Release/audio_capture_native.node'),
+            path.join(process.resourcesPath, 'app/audio_capture_native.node'),
+            path.join(process.resourcesPath, 'audio_capture_native.node')
+          );
+        }
+
+        let foundPath: string | null = null;
+        const checkedPaths: string[] = [];
+        
+        for (const testPath of possiblePaths) {
+          checkedPaths.push(testPath);
+          try {
+            if (fs.existsSync(testPath)) {
+              logger.info('Found native addon', { path: testPath });
+              foundPath = testPath;
+              break;
+            }
+          } catch (e) {
+            logger.debug('Path check failed', { path: testPath, error: String(e).substring(0, 50) });
+          }
+        }
+
+        if (!foundPath) {
+          const checkedStr = checkedPaths.slice(0, 2).join(' OR ');
+          throw new Error(
+            `Could not find native audio_capture_native module. Checked: ${checkedStr}`
+          );
+        }
+
+        logger.debug('Loading native addon using require()', { path: foundPath });
+        // eslint-disable-next-line @typescript-eslint/no-require-imports
+        nativeModule = require(foundPath);
+        logger.debug('Loaded native addon via direct require()');
+      }
+
+      if (!nativeModule || typeof nativeModule.AudioCaptureAddon !== 'function') {
+        logger.error('Invalid native module structure', { hasModule: !!nativeModule, hasAudioCaptureAddon: !!nativeModule?.AudioCaptureAddon });
+        throw new Error('Failed to load native audio_capture_native module');
+      }
+
+      this.nativeModule = nativeModule;
+      installNativeLogHandler(nativeModule);
+
+      // Create native instance with config (init occurs in constructor)
+      logger.debug('Creating native AudioCaptureAddon instance...');
+      // Only caller-specified switches are passed, so the preset's defaults
+      // apply to the rest
+      this.nativeInstance = new this.nativeModule.AudioCaptureAddon({
+        preset: this.config.preset,
+        enableAec: config.enableAec,
+        enableNs: config.enableNs,
+        nsLevel: config.nsLevel,
+        enableAgc: config.enableAgc,
+        processingSampleRate: this.config.processingSampleRate,
+        renderChannels: this.config.renderChannels,
+        adaptiveSuppression: this.config.adaptiveSuppression,
+        cpuGovernor: this.config.cpuGovernor,
+        normalizeSpeech: this.config.normalizeSpeech,
+        normalizeTargetDbfs: this.config.normalizeTargetDbfs,
+      });
+
+      this.isInitialized = true;
+      logger.info('AEC initialized successfully', {
+        preset: this.config.preset,
+        enableAec: this.config.enableAec,
+        enableNs: this.config.enableNs,
+        enableAgc: this.config.enableAgc,
+        sampleRate: this.config.sampleRate,
+        processingSampleRate: this.config.processingSampleRate,
+        renderChannels: this.config.renderChannels,
+        frameDurationMs: this.config.frameDurationMs,
+      });
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('AEC initialization failed', { errorMessage: message, errorType: error instanceof Error ? 'Error' : 'Other' });
+      throw new Error(`AEC initialization failed: ${message}`);
+    }
+  }
+
+  /**
+   * Process render (system/speaker) audio through the AEC reference path.
+   * During processed mic capture or async processing the addon queues it and aligns it with the mic
+   * by `timestamp` (Date.now() domain, first sample). Omit it for audio stamped only by its arrival:
+   * the addon then places it on a steady frame clock through an adaptive jitter buffer, so bursty
+   * delivery reaches the canceller evenly paced.
+   * Otherwise it must be called BEFORE the corresponding processCaptureAudio() call.
+   * `channels` gives the interleaved layout (default: config.renderChannels);
+   * other layouts are averaged onto it. PCM input is converted natively,
+   * downmixed in the same pass when its layout differs; `format` reads a
+   * Buffer as 's16le' (default) or 'f32'.
+   */
+  public processRenderAudio(
+    renderBuffer: RenderSamples,
+    timestamp?: number,
+    channels?: number,
+    format?: 'f32' | 's16le'
+  ): boolean {
+    if (this.isDestroyed) {
+      logger.warn('Cannot process render audio: AEC processor is destroyed');
+      return false;
+    }
+
+    if (!this.isInitialized) {
+      logger.warn('Cannot process render audio: AEC not initialized');
+      return false;
+    }
+
+    if (!renderBuffer || renderBuffer.length === 0) {
+      logger.warn('Render buffer is empty, skipping');
+      return false;
+    }
+
+    try {
+      // The native module copies the samples; nothing is retained here
+      if (this.nativeInstance && typeof this.nativeInstance.processRenderAudio === 'function') {
+        this.nativeInstance.processRenderAudio(renderBuffer, timestamp, channels, format);
+      }
+
+      return true;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error processing render audio', { error: message });
+      return false;
+    }
+  }
+
+  /**
+   * Process capture (microphone) audio through the AEC to remove echo.
+   * Returns echo-cancelled audio, or null on error. Runs synchronously on the
+   * calling thread; see startAsyncProcessing() to move it off the main thread.
+   *
+   * Pass `output` (at least captureBuffer.length samples) to reuse a buffer
+   * instead of allocating one per call, or captureBuffer itself to clean it in
+   * place; the result is then `output`. An Int16Array or Buffer output, or
+   * 's16le', gets 16-bit PCM converted natively. Output is one 10ms frame
+   * behind input.
+   */
+  public processCaptureAudio(
+    captureBuffer: Float32Array,
+    output?: CaptureOutput
+  ): Float32Array | Int16Array | Buffer | null {
+    if (this.isDestroyed) {
+      logger.warn('Cannot process capture audio: AEC processor is destroyed');
+      return null;
+    }
+
+    if (!this.isInitialized) {
+      logger.warn('Cannot process capture audio: AEC not initialized');
+      return null;
+    }
+
+    if (this.asyncProcessing) {
+      logger.warn('Async processing is active; use enqueueCaptureAudio()');
+      return null;
+    }
+
+    if (!captureBuffer || captureBuffer.length === 0) {
+      logger.warn('Capture buffer is empty, returning null');
+      return null;
+    }
+
+    try {
+      // Call the native module to process capture audio and return echo-cancelled result
+      if (this.nativeInstance && typeof this.nativeInstance.processCaptureAudio === 'function') {
+        const result = output
+          ? this.nativeInstance.processCaptureAudio(captureBuffer, output)
+          : this.nativeInstance.processCaptureAudio(captureBuffer);
+        return result as Float32Array | Int16Array | Buffer;
+      }
+
+      logger.warn('processCaptureAudio not available in native module');
+      return null;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error processing capture audio', { error: message });
+      return null;
+    }
+  }
+
+  /**
+   * Feed a render chunk and clean the matching capture chunk in one native
+   * call, render first. With both timestamps (Date.now() of each first
+   * sample) their offset plus playback latency becomes the APM's stream
+   * delay. `output` works as in processCaptureAudio(). Returns null on error.
+   */
+  public processSyncedPair(
+    renderBuffer: Float32Array,
+    captureBuffer: Float32Array,
+    renderTimestamp?: number,
+    captureTimestamp?: number,
+    output?: CaptureOutput
+  ): SyncedPairResult | null {
+    if (!this.isInitialized || this.isDestroyed || this.asyncProcessing) {
+      logger.warn('Cannot process synced pair: AEC not ready for synchronous processing');
+      return null;
+    }
+
+    if (!captureBuffer || captureBuffer.length === 0) {
+      return null;
+    }
+
+    try {
+      return this.nativeInstance.processSyncedPair(
+        renderBuffer,
+        captureBuffer,
+        renderTimestamp,
+        captureTimestamp,
+        output
+      ) as SyncedPairResult | null;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error processing synced pair', { error: message });
+      return null;
+    }
+  }
+
+  /**
+   * Move echo cancellation onto the native DSP thread. From here on
+   * enqueueCaptureAudio() and processRenderAudio() only queue buffers; the
+   * DSP thread owns the APM, aligns render and capture by timestamp and
+   * delivers cleaned capture to `callback` (same arguments and delivery
+   * options as startMicrophoneCapture). Unavailable while processed mic
+   * capture runs, since that already owns the pipeline.
+   */
+  public startAsyncProcessing<T extends CaptureSamples = Float32Array>(
+    callback: MicAudioCallback<T>,
+    options: Omit<MicCaptureOptions, 'processed'> = {}
+  ): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      logger.warn('Cannot start async processing: AEC not ready');
+      return false;
+    }
+
+    if (this.asyncProcessing) {
+      return true;
+    }
+
+    if (this.micProcessed) {
+      logger.warn('Cannot start async processing while processed mic capture runs');
+      return false;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.startAsyncProcessing === 'function') {
+        this.asyncCallback = callback as MicAudioCallback<CaptureSamples>;
+        const started: boolean = this.nativeInstance.startAsyncProcessing(
+          (
+            samples: CaptureSamples,
+            timestamp: number,
+            sampleIndex: number,
+            hostTimeMs: number,
+            vad?: Float32Array,
+            silenceMs?: number,
+            levels?: Float32Array,
+            endpoint?: EndpointType,
+            talk?: Uint8Array,
+            prosody?: UtteranceProsody,
+            classes?: Uint8Array,
+            speakers?: Uint8Array,
+            metadata?: Float64Array
+          ) => {
+            if (this.asyncCallback) {
+              this.asyncCallback(
+                samples,
+                timestamp,
+                sampleIndex,
+                hostTimeMs,
+                vad,
+                silenceMs,
+                levels,
+                endpoint,
+                talk,
+                prosody,
+                classes,
+                speakers,
+                metadata
+              );
+            }
+          },
+          nativeCaptureOptions(options)
+        );
+        if (started) {
+          this.asyncProcessing = true;
+          logger.info('Async AEC processing started', {
+            outputSampleRate: options.outputSampleRate,
+            format: options.format ?? 'float32',
+          });
+          return true;
+        }
+        this.asyncCallback = undefined;
+      }
+      return false;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error starting async AEC processing', { error: message });
+      this.asyncCallback = undefined;
+      return false;
+    }
+  }
+
+  /**
+   * Stop async processing. Queued capture is flushed through the AEC and
+   * delivered before this returns.
+   */
+  public stopAsyncProcessing(): boolean {
+    if (!this.asyncProcessing) {
+      return true;
+    }
+
+    try {
+      this.nativeInstance?.stopAsyncProcessing?.();
+      logger.info('Async AEC processing stopped');
+      return true;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error stopping async AEC processing', { error: message });
+      return false;
+    } finally {
+      this.asyncProcessing = false;
+      this.asyncCallback = undefined;
+    }
+  }
+
+  /**
+   * Queue capture audio for the DSP thread (async mode only). `timestamp` is
+   * the first sample's Date.now() time (default: "just ended"). Returns false
+   * when the buffer was dropped because the queue is full.
+   */
+  public enqueueCaptureAudio(captureBuffer: Float32Array, timestamp?: number): boolean {
+    if (!this.asyncProcessing || !captureBuffer || captureBuffer.length === 0) {
+      return false;
+    }
+
+    try {
+      // Copied into the native queue; nothing is retained here
+      return this.nativeInstance.processCaptureAudio(captureBuffer, timestamp) === true;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error queueing capture audio', { error: message });
+      return false;
+    }
+  }
+
+  /**
+   * Build the microphone's AudioUnit and IOProc ahead of time (macOS), so a
+   * later startMicrophoneCapture() only has to start the device. The device
+   * is not opened for IO, so the microphone indicator stays off. Takes the
+   * ioBufferFrames and engine the start will use (with 'auhal', also its
+   * outputSampleRate and processed); a start with others, or after the
+   * input device or its sample rate changed, sets up from scratch.
+   * Resolves false while capture is running or where unsupported.
+   */
+  public async prepareMicrophoneCapture(
+    options: Pick<
+      MicCaptureOptions,
+      'ioBufferFrames' | 'engine' | 'ducking' | 'outputSampleRate' | 'processed' | 'inputChannels'
+    > = {}
+  ): Promise<boolean> {
+    if (this.isDestroyed || !this.isInitialized || this.micCapturing) {
+      return false;
+    }
+    if (!this.nativeInstance || typeof this.nativeInstance.prepareMicrophoneCapture !== 'function') {
+      return false;
+    }
+
+    try {
+      const prepared: boolean = await this.nativeInstance.prepareMicrophoneCapture(options);
+      if (prepared) {
+        logger.info('Native microphone capture prepared', {
+          ioBufferFrames: options.ioBufferFrames,
+          engine: options.engine ?? 'hal',
+        });
+      }
+      return prepared;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.warn('Error preparing native microphone capture', { error: message });
+      return false;
+    }
+  }
+
+  /**
+   * Release what prepareMicrophoneCapture() built without starting capture.
+   * Returns false when nothing was prepared.
+   */
+  public unprepareMicrophoneCapture(): boolean {
+    if (!this.nativeInstance || typeof this.nativeInstance.unprepareMicrophoneCapture !== 'function') {
+      return false;
+    }
+    return this.nativeInstance.unprepareMicrophoneCapture() === true;
+  }
+
+  /**
+   * Start native microphone capture using AudioUnit.
+   * Timestamps use the same monotonic clock as system audio for AEC sync.
+   * CoreAudio setup runs on a native worker thread; resolves once the device is running.
+   * After prepareMicrophoneCapture() that setup is already done; a start made
+   * while the prepare is still running waits for it.
+   */
+  public async startMicrophoneCapture<T extends CaptureSamples = Float32Array>(
+    callback: MicAudioCallback<T>,
+    options: MicCaptureOptions = {}
+  ): Promise<boolean> {
+    if (this.isDestroyed) {
+      logger.warn('Cannot start mic capture: AEC processor is destroyed');
+      return false;
+    }
+
+    if (!this.isInitialized) {
+      logger.warn('Cannot start mic capture: AEC not initialized');
+      return false;
+    }
+
+    if (this.micCapturing) {
+      logger.warn('Microphone capture already running');
+      return true;
+    }
+
+    if (!callback || typeof callback !== 'function') {
+      logger.error('Invalid callback provided to startMicrophoneCapture');
+      return false;
+    }
+
+    try {
+      this.micAudioCallback = callback as MicAudioCallback<CaptureSamples>;
+
+      if (this.nativeInstance && typeof this.nativeInstance.startMicrophoneCapture === 'function') {
+        const success: boolean = await this.nativeInstance.startMicrophoneCapture(
+          (
+            samples: CaptureSamples,
+            timestamp: number,
+            sampleIndex: number,
+            hostTimeMs: number,
+            vad?: Float32Array,
+            silenceMs?: number,
+            levels?: Float32Array,
+            endpoint?: EndpointType,
+            talk?: Uint8Array,
+            prosody?: UtteranceProsody,
+            classes?: Uint8Array,
+            speakers?: Uint8Array,
+            metadata?: Float64Array
+          ) => {
+            if (this.micAudioCallback) {
+              this.micAudioCallback(
+                samples,
+                timestamp,
+                sampleIndex,
+                hostTimeMs,
+                vad,
+                silenceMs,
+                levels,
+                endpoint,
+                talk,
+                prosody,
+                classes,
+                speakers,
+                metadata
+              );
+            }
+          },
+          nativeCaptureOptions(options)
+        );
+
+        if (success) {
+          this.micCapturing = true;
+          // The addon takes a Bluetooth hands-free headset as captured, at
+          // its own rate: it is also the output, so there is no echo to cancel
+          this.micProcessed = typeof this.nativeInstance.isMicrophoneProcessed === 'function'
+            ? this.nativeInstance.isMicrophoneProcessed()
+            : !!options.processed && options.engine !== 'voiceProcessing';
+          logger.info('Native microphone capture started', {
+            zeroCopy: !!options.zeroCopy,
+            deliveryIntervalMs: options.deliveryIntervalMs ?? 0,
+            processed: this.micProcessed,
+            outputSampleRate: options.outputSampleRate,
+            format: options.format ?? 'float32',
+            chunkMs: options.chunkMs ?? 0,
+            ioBufferFrames: this.getCaptureStats()?.mic.ioBufferFrames,
+            engine: options.engine ?? 'hal',
+          });
+          return true;
+        } else {
+          logger.error('Native module failed to start microphone capture');
+          this.micAudioCallback = undefined;
+          return false;
+        }
+      } else {
+        logger.error('startMicrophoneCapture not available in native module');
+        this.micAudioCallback = undefined;
+        return false;
+      }
+    } catch (error) {
+      // Better error extraction for debugging
+      let errorMsg = 'Unknown error';
+      let errorStack = '';
+      if (error instanceof Error) {
+        errorMsg = error.message;
+        errorStack = error.stack || '';
+      } else if (typeof error === 'object' && error !== null) {
+        errorMsg = JSON.stringify(error);
+      } else {
+        errorMsg = String(error);
+      }
+      
+      logger.error('Error starting native microphone capture', { 
+        error: errorMsg,
+        stack: errorStack,
+        errorType: typeof error,
+        errorKeys: error && typeof error === 'object' ? Object.keys(error) : []
+      });
+      this.micAudioCallback = undefined;
+      return false;
+    }
+  }
+
+  /**
+   * Stop native microphone capture. Resolves after the device has stopped
+   * and the pending samples have been flushed to the callback.
+   */
+  public async stopMicrophoneCapture(): Promise<boolean> {
+    if (!this.micCapturing) {
+      return true;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.stopMicrophoneCapture === 'function') {
+        const success: boolean = await this.nativeInstance.stopMicrophoneCapture();
+        
+        if (success) {
+          this.micCapturing = false;
+          this.micProcessed = false;
+          this.micPaused = false;
+          this.micAudioCallback = undefined;
+          logger.info('Native microphone capture stopped');
+          return true;
+        } else {
+          logger.warn('Native module failed to stop microphone capture');
+          return false;
+        }
+      } else {
+        logger.warn('stopMicrophoneCapture not available in native module');
+        return false;
+      }
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error stopping native microphone capture', { error: message });
+      return false;
+    }
+  }
+
+  /**
+   * Current CoreAudio devices. Served from a native table kept up to date by
+   * HAL listeners, so this is cheap enough to call from UI polling.
+   */
+  public getDevices(): AudioDeviceInfo[] {
+    if (!this.isInitialized || this.isDestroyed) {
+      return [];
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getDevices === 'function') {
+        return this.nativeInstance.getDevices() as AudioDeviceInfo[];
+      }
+      return [];
+    } catch (error) {
+      logger.warn('Failed to get audio devices', { error });
+      return [];
+    }
+  }
+
+  /**
+   * Receive the full device list whenever devices or defaults change.
+   * Pass null to stop listening. Only one listener is kept.
+   */
+  public onDevicesChanged(callback: ((devices: AudioDeviceInfo[]) => void) | null): void {
+    if (!this.isInitialized || this.isDestroyed) {
+      return;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.onDevicesChanged === 'function') {
+        this.nativeInstance.onDevicesChanged(callback);
+      }
+    } catch (error) {
+      logger.warn('Failed to register devicesChanged listener', { error });
+    }
+  }
+
+  /**
+   * Pin native mic capture to a device id (as returned by the native getDevices()),
+   * or pass null to follow the system default input. Takes effect immediately
+   * while capturing: the IOProc moves to the new device without restarting the
+   * stream, so the callback, ring buffer and AEC state carry over.
+   */
+  public setInputDevice(deviceId: string | null): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      return false;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.setInputDevice === 'function') {
+        return this.nativeInstance.setInputDevice(deviceId) as boolean;
+      }
+      logger.warn('setInputDevice not available in native module');
+      return false;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Failed to set input device', { deviceId, error: message });
+      return false;
+    }
+  }
+
+  /**
+   * Device native mic capture uses (or would use on the next start).
+   */
+  public getInputDevice(): { id: string; followsDefault: boolean } | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getInputDevice === 'function') {
+        return this.nativeInstance.getInputDevice() as { id: string; followsDefault: boolean } | null;
+      }
+      return null;
+    } catch (error) {
+      logger.warn('Failed to read input device', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Whether the native module can capture system audio through a process tap
+   * (macOS 14.2+). When false, callers should fall back to the audiotee helper.
+   */
+  public isSystemAudioCaptureSupported(): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      return false;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.isSystemAudioCaptureSupported === 'function') {
+        return this.nativeInstance.isSystemAudioCaptureSupported() as boolean;
+      }
+      return false;
+    } catch (error) {
+      logger.warn('Failed to query system audio capture support', { error });
+      return false;
+    }
+  }
+
+  /**
+   * Start native system audio capture. Samples arrive on the same host clock as
+   * the microphone, so render/capture alignment needs no wall-clock guesswork.
+   * Throws if the tap cannot be created (e.g. missing audio capture permission).
+   */
+  public startSystemAudioCapture<T extends CaptureSamples = Float32Array>(
+    callback: SystemAudioCallback<T>,
+    options: MicCaptureOptions = {}
+  ): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      logger.warn('Cannot start system capture: AEC processor not ready');
+      return false;
+    }
+
+    if (this.systemCapturing) {
+      logger.warn('System audio capture already running');
+      return true;
+    }
+
+    if (!this.nativeInstance || typeof this.nativeInstance.startSystemAudioCapture !== 'function') {
+      logger.error('startSystemAudioCapture not available in native module');
+      return false;
+    }
+
+    this.systemAudioCallback = callback as SystemAudioCallback<CaptureSamples>;
+    const success = this.nativeInstance.startSystemAudioCapture(
+      (
+        samples: CaptureSamples,
+        timestamp: number,
+        sampleIndex: number,
+        hostTimeMs: number,
+        vad?: Float32Array,
+        silenceMs?: number,
+        levels?: Float32Array,
+        endpoint?: EndpointType,
+        talk?: Uint8Array,
+        prosody?: UtteranceProsody,
+        classes?: Uint8Array,
+        speakers?: Uint8Array,
+        metadata?: Float64Array
+      ) => {
+        if (this.systemAudioCallback) {
+          this.systemAudioCallback(
+            samples,
+            timestamp,
+            sampleIndex,
+            hostTimeMs,
+            vad,
+            silenceMs,
+            levels,
+            endpoint,
+            talk,
+            prosody,
+            classes,
+            speakers,
+            metadata
+          );
+        }
+      },
+      nativeCaptureOptions(options)
+    ) as boolean;
+
+    if (success) {
+      this.systemCapturing = true;
+      logger.info('Native system audio capture started', {
+        zeroCopy: !!options.zeroCopy,
+        deliveryIntervalMs: options.deliveryIntervalMs ?? 0,
+        sharedClock: !!options.sharedClock,
+        enhance: !!options.enhance,
+      });
+    } else {
+      this.systemAudioCallback = undefined;
+      logger.error('Native module failed to start system audio capture');
+    }
+    return success;
+  }
+
+  /**
+   * Stop native system audio capture. Pending samples are flushed first.
+   */
+  public stopSystemAudioCapture(): boolean {
+    if (!this.systemCapturing) {
+      return true;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.stopSystemAudioCapture === 'function') {
+        this.nativeInstance.stopSystemAudioCapture();
+      }
+      this.systemCapturing = false;
+      this.systemAudioCallback = undefined;
+      logger.info('Native system audio capture stopped');
+      return true;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error stopping native system audio capture', { error: message });
+      return false;
+    }
+  }
+
+  /**
+   * Format of the running system tap (delivered samples are always mono at this rate).
+   */
+  public getSystemAudioFormat(): { sampleRate: number; channels: number } | null {
+    if (!this.systemCapturing) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getSystemAudioFormat === 'function') {
+        return this.nativeInstance.getSystemAudioFormat() as { sampleRate: number; channels: number } | null;
+      }
+      return null;
+    } catch (error) {
+      logger.warn('Failed to read system audio format', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Put the next microphone and system audio starts on one timeline: both
+   * count sampleIndex from this instant and drop anything captured before
+   * it, so render and capture positions compare directly from the first
+   * frame (index / rate is the time since the shared start). Applies to the
+   * next start of each; armSharedStart(false) disarms what is left.
+   */
+  public armSharedStart(arm = true): SharedStart | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.armSharedStart === 'function') {
+        return (this.nativeInstance.armSharedStart(arm) as SharedStart | null) ?? null;
+      }
+    } catch (error) {
+      logger.warn('Failed to arm shared start', { error });
+    }
+    return null;
+  }
+
+  /**
+   * Start a named capture session: its own device and graph in this
+   * instance, for a mic preview during a recording or an overlapping
+   * meeting, run on the native DSP pool every session shares. False when
+   * it could not start (unknown device, a name already running, a bad
+   * stage); the error is logged.
+   */
+  public startSession(name: string, onData: CaptureSessionCallback, options: CaptureSessionOptions = {}): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      return false;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.startSession === 'function') {
+        this.nativeInstance.startSession(name, options, onData);
+        logger.info('Capture session started', { name, deviceId: options.deviceId ?? 'default' });
+        return true;
+      }
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error starting capture session', { name, error: message });
+    }
+    return false;
+  }
+
+  /** Stop a startSession() session; false when none of that name ran */
+  public stopSession(name: string): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      return false;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.stopSession === 'function') {
+        return this.nativeInstance.stopSession(name) as boolean;
+      }
+    } catch (error) {
+      logger.warn('Failed to stop capture session', { name, error });
+    }
+    return false;
+  }
+
+  public getSessions(): CaptureSessionsSnapshot | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getSessions === 'function') {
+        return this.nativeInstance.getSessions() as CaptureSessionsSnapshot;
+      }
+    } catch (error) {
+      logger.warn('Failed to read capture sessions', { error });
+    }
+    return null;
+  }
+
+  /**
+   * Start system audio, then the microphone, on a shared start (see
+   * armSharedStart). Either may fail on its own; the result says which ran.
+   */
+  public async startAll<M extends CaptureSamples = Float32Array, S extends CaptureSamples = Float32Array>(
+    micCallback: MicAudioCallback<M>,
+    systemCallback: SystemAudioCallback<S>,
+    options: { mic?: MicCaptureOptions; system?: MicCaptureOptions } = {}
+  ): Promise<{ mic: boolean; system: boolean; start: SharedStart | null }> {
+    const start = this.armSharedStart();
+    let system = false;
+    try {
+      system = this.startSystemAudioCapture(systemCallback, options.system);
+    } catch (error) {
+      logger.warn('System audio capture failed to start', { error });
+    }
+    const mic = await this.startMicrophoneCapture(micCallback, options.mic);
+    this.armSharedStart(false);
+    return { mic, system, start };
+  }
+
+  /**
+   * Check if native system audio capture is running.
+   */
+  public isSystemAudioCapturing(): boolean {
+    return this.systemCapturing;
+  }
+
+  /**
+   * Convert a native monotonic host time (ms) into the Date.now() domain.
+   * Returns null when the native module is unavailable.
+   */
+  public hostTimeToDateNow(hostTimeMs: number): number | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.hostTimeToDateNow === 'function') {
+        return this.nativeInstance.hostTimeToDateNow(hostTimeMs) as number;
+      }
+      return null;
+    } catch (error) {
+      logger.warn('Failed to convert host time', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Current native monotonic host time in ms, in the same domain as delivered hostTimeMs.
+   */
+  public getHostTime(): number | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getHostTime === 'function') {
+        return this.nativeInstance.getHostTime() as number;
+      }
+      return null;
+    } catch (error) {
+      logger.warn('Failed to read host time', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Capture-path health counters for the native mic and system streams.
+   */
+  public getCaptureStats(): CaptureStats | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getCaptureStats === 'function') {
+        return this.nativeInstance.getCaptureStats() as CaptureStats;
+      }
+      return null;
+    } catch (error) {
+      logger.warn('Failed to read capture stats', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Low power runs AEC at 16kHz on short filters with light NS, and batches
+   * deliveries to at least 100ms; leaving it restores the configured AEC.
+   * Each switch rebuilds the canceller, which re-converges. Returns whether
+   * low power is now in effect.
+   */
+  public setPowerProfile(profile: PowerProfile): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      return false;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.setPowerProfile === 'function') {
+        return this.nativeInstance.setPowerProfile(profile) as boolean;
+      }
+      return false;
+    } catch (error) {
+      logger.warn('Failed to set power profile', { error });
+      return false;
+    }
+  }
+
+  /**
+   * Per-stage latency of native deliveries since each stream started.
+   */
+  public getLatencyTrace(): LatencyTrace | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getLatencyTrace === 'function') {
+        return this.nativeInstance.getLatencyTrace() as LatencyTrace;
+      }
+      return null;
+    } catch (error) {
+      logger.warn('Failed to read latency trace', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Close the latency trace of the delivery that started at `sampleIndex`
+   * (the callback's third argument) once it has been written to the provider
+   * socket. Must be called from that delivery's callback or soon after; only
+   * the newest 64 deliveries per stream stay open.
+   */
+  public markAudioSent(stream: TracedStream, sampleIndex: number): boolean {
+    if (!this.nativeInstance || typeof this.nativeInstance.markAudioSent !== 'function') {
+      return false;
+    }
+    try {
+      return this.nativeInstance.markAudioSent(stream, sampleIndex) as boolean;
+    } catch (error) {
+      logger.warn('Failed to mark audio sent', { error });
+      return false;
+    }
+  }
+
+  /**
+   * Add a callback for a running stream's audio next to the one it was
+   * started with, e.g. a level meter beside the transcriber: all share the
+   * native buffers, and each subscriber's queue and overload policy are its
+   * own, so a slow one never stalls or copies for the rest. Returns the
+   * subscription's ID, or 0 when the stream is not running or the module
+   * predates it; the subscription ends with unsubscribeCapture() or the
+   * stream's stop.
+   */
+  public subscribeCapture<T extends CaptureSamples = Float32Array>(
+    stream: TracedStream,
+    callback: CaptureSubscriberCallback<T>,
+    options?: CaptureSubscriberOptions
+  ): number {
+    if (!this.nativeInstance || typeof this.nativeInstance.subscribeCapture !== 'function') {
+      return 0;
+    }
+    try {
+      return this.nativeInstance.subscribeCapture(stream, callback, options ?? {}) as number;
+    } catch (error) {
+      logger.warn('Failed to subscribe to capture', { error, stream });
+      return 0;
+    }
+  }
+
+  /** End a subscribeCapture() subscription; false when it already ended */
+  public unsubscribeCapture(id: number): boolean {
+    if (!this.nativeInstance || typeof this.nativeInstance.unsubscribeCapture !== 'function' || id === 0) {
+      return false;
+    }
+    try {
+      return this.nativeInstance.unsubscribeCapture(id) as boolean;
+    } catch (error) {
+      logger.warn('Failed to unsubscribe from capture', { error });
+      return false;
+    }
+  }
+
+  /**
+   * Read back part of a stream started with the history option, decoded or
+   * as Ogg Opus, e.g. `{ lastMs: 30000 }` for an instant replay. Null when
+   * the stream keeps no history, none of the range is held or the module
+   * predates it.
+   */
+  public readHistory(stream: TracedStream, range: HistoryRangeRequest): HistoryRange | null {
+    if (!this.nativeInstance || typeof this.nativeInstance.readHistory !== 'function') {
+      return null;
+    }
+    try {
+      return this.nativeInstance.readHistory(stream, range) as HistoryRange | null;
+    } catch (error) {
+      logger.warn('Failed to read capture history', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Start process-wide tracing of the native pipeline: IOProc callbacks, AEC
+   * chunks, JS deliveries and APM calls. 'chrome' writes a chrome://tracing /
+   * Perfetto JSON file to `path` (including the APM's own trace events);
+   * 'signpost' emits os_signpost intervals for Instruments. Returns false when
+   * a trace is already running or the output cannot be opened.
+   */
+  public startPipelineTrace(output: 'chrome' | 'signpost', path?: string): boolean {
+    if (!this.nativeModule || typeof this.nativeModule.startTrace !== 'function') {
+      return false;
+    }
+    try {
+      return this.nativeModule.startTrace(output, path) as boolean;
+    } catch (error) {
+      logger.warn('Failed to start pipeline trace', { error });
+      return false;
+    }
+  }
+
+  /** Stop the pipeline trace; a Chrome trace file is complete once this returns */
+  public stopPipelineTrace(): void {
+    if (this.nativeModule && typeof this.nativeModule.stopTrace === 'function') {
+      this.nativeModule.stopTrace();
+    }
+  }
+
+  /**
+   * Record meeting audio natively: each track streams to WAV files on a
+   * background thread, never through JS and never whole in memory. Headers
+   * are patched and fsynced every syncIntervalMs, so a crash loses at most
+   * that much. Returns false when already recording or the directory is not
+   * writable.
+   */
+  public startRecording(options: RecordingOptions): boolean {
+    if (!this.nativeModule || typeof this.nativeModule.startRecording !== 'function') {
+      return false;
+    }
+    try {
+      return this.nativeModule.startRecording(options) as boolean;
+    } catch (error) {
+      logger.warn('Failed to start recording', { error });
+      return false;
+    }
+  }
+
+  /** Close every file; null when the module has no recorder */
+  public stopRecording(): RecordingSummary | null {
+    if (!this.nativeModule || typeof this.nativeModule.stopRecording !== 'function') {
+      return null;
+    }
+    return this.nativeModule.stopRecording() as RecordingSummary;
+  }
+
+  /** Files so far, lengths as of the last sync */
+  public getRecordingStatus(): RecordingStatus | null {
+    if (!this.nativeModule || typeof this.nativeModule.getRecordingStatus !== 'function') {
+      return null;
+    }
+    return this.nativeModule.getRecordingStatus() as RecordingStatus;
+  }
+
+  /**
+   * Count talk time, turns, overlaps, interruptions and response latency
+   * natively from the microphone's and system audio's VAD frames until
+   * stopTalkAnalytics(). The streams need the vad, gate or endpoint option;
+   * questions need endpoint.prosody. Returns false when already running.
+   */
+  public startTalkAnalytics(options?: TalkAnalyticsOptions): boolean {
+    if (!this.nativeModule || typeof this.nativeModule.startTalkAnalytics !== 'function') {
+      return false;
+    }
+    return this.nativeModule.startTalkAnalytics(options) as boolean;
+  }
+
+  /** The final totals; null when the module has no talk analytics */
+  public stopTalkAnalytics(): TalkAnalytics | null {
+    if (!this.nativeModule || typeof this.nativeModule.stopTalkAnalytics !== 'function') {
+      return null;
+    }
+    return this.nativeModule.stopTalkAnalytics() as TalkAnalytics;
+  }
+
+  /** The totals so far, cheap enough to poll */
+  public getTalkAnalytics(): TalkAnalyticsStatus | null {
+    if (!this.nativeModule || typeof this.nativeModule.getTalkAnalytics !== 'function') {
+      return null;
+    }
+    return this.nativeModule.getTalkAnalytics() as TalkAnalyticsStatus;
+  }
+
+  /**
+   * Capture every buffer the addon receives, raw and with its timestamps,
+   * plus pauses, gaps and device moves, until stopSessionCapture(). The file
+   * replays through the native pipeline with `npm run replay` in native/,
+   * to reproduce a field stall or compare performance across builds.
+   * Returns false when already capturing or the file will not open.
+   */
+  public startSessionCapture(filePath: string): boolean {
+    if (!this.nativeModule || typeof this.nativeModule.startSessionCapture !== 'function') {
+      return false;
+    }
+    try {
+      return this.nativeModule.startSessionCapture(filePath) as boolean;
+    } catch (error) {
+      logger.warn('Failed to start session capture', { error });
+      return false;
+    }
+  }
+
+  /** Close the capture file; null when the module has no session capture */
+  public stopSessionCapture(): SessionCaptureSummary | null {
+    if (!this.nativeModule || typeof this.nativeModule.stopSessionCapture !== 'function') {
+      return null;
+    }
+    return this.nativeModule.stopSessionCapture() as SessionCaptureSummary;
+  }
+
+  /**
+   * Open a recorded track for playback from any point. Returns null when
+   * the module predates it or the index will not open; the reason is logged.
+   */
+  public openRecording(indexPath: string): NativeRecordingReader | null {
+    if (!this.nativeModule || typeof this.nativeModule.RecordingReader !== 'function') {
+      return null;
+    }
+    try {
+      return new this.nativeModule.RecordingReader(indexPath) as NativeRecordingReader;
+    } catch (error) {
+      logger.warn('Failed to open recording', { indexPath, error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /**
+   * Play a recorded track at 0.5x to 3x. Returns null when the module
+   * predates it or the index will not open; the reason is logged.
+   */
+  public openPlayer(indexPath: string, options: RecordingPlayerOptions = {}): NativeRecordingPlayer | null {
+    if (!this.nativeModule || typeof this.nativeModule.RecordingPlayer !== 'function') {
+      return null;
+    }
+    try {
+      return new this.nativeModule.RecordingPlayer(indexPath, options) as NativeRecordingPlayer;
+    } catch (error) {
+      logger.warn('Failed to open recording for playback', { indexPath, error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /**
+   * Map the shared memory ring a stream in another process (the audio
+   * engine) writes under |name|. Returns null when the module predates it or
+   * no such ring is open; the reason is logged.
+   */
+  public openSharedMemoryRing(name: string): NativeSharedMemoryRing | null {
+    if (!this.nativeModule || typeof this.nativeModule.SharedMemoryRing !== 'function') {
+      return null;
+    }
+    try {
+      return new this.nativeModule.SharedMemoryRing(name) as NativeSharedMemoryRing;
+    } catch (error) {
+      logger.warn('Failed to open shared memory ring', { name, error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /**
+   * An empty embedding index. Returns null when the module predates it or
+   * the options are invalid; the reason is logged.
+   */
+  public createEmbeddingIndex(options: EmbeddingIndexOptions): NativeEmbeddingIndex | null {
+    if (!this.nativeModule || typeof this.nativeModule.EmbeddingIndex !== 'function') {
+      return null;
+    }
+    try {
+      return new this.nativeModule.EmbeddingIndex(options) as NativeEmbeddingIndex;
+    } catch (error) {
+      logger.warn('Failed to create embedding index', { dims: options.dims, error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /**
+   * Open the embedding file at `path`, creating it when missing. Returns
+   * null when the module predates it, the file was written with other
+   * options or will not open; the reason is logged.
+   */
+  public openEmbeddingStore(
+    path: string,
+    options: Pick<EmbeddingIndexOptions, 'dims' | 'quantization' | 'normalize'>
+  ): NativeEmbeddingStore | null {
+    if (!this.nativeModule || typeof this.nativeModule.EmbeddingStore !== 'function') {
+      return null;
+    }
+    try {
+      return new this.nativeModule.EmbeddingStore(path, options) as NativeEmbeddingStore;
+    } catch (error) {
+      logger.warn('Failed to open embedding store', { path, error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /**
+   * A native websocket for a streaming transcription provider. Null when the
+   * module predates it, the platform has no native websocket (Linux) or the
+   * options are invalid; callers then stream from JS as before.
+   */
+  public createTranscriptionSocket(options: TranscriptionSocketOptions): NativeTranscriptionSocket | null {
+    if (!this.nativeModule || typeof this.nativeModule.TranscriptionSocket !== 'function' || process.platform === 'linux') {
+      return null;
+    }
+    try {
+      return new this.nativeModule.TranscriptionSocket(options) as NativeTranscriptionSocket;
+    } catch (error) {
+      logger.warn('Failed to create transcription socket', { error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /**
+   * An interleaver onto a two-channel native socket. Null when the module
+   * predates it or the options are invalid.
+   */
+  public createChannelInterleaver(options: ChannelInterleaverOptions): NativeChannelInterleaver | null {
+    if (!this.nativeModule || typeof this.nativeModule.ChannelInterleaver !== 'function') {
+      return null;
+    }
+    try {
+      return new this.nativeModule.ChannelInterleaver(options) as NativeChannelInterleaver;
+    } catch (error) {
+      logger.warn('Failed to create channel interleaver', { error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /**
+   * An on-device transcriber. Null when the module predates it or the
+   * options are invalid; connect() returns false when the addon was built
+   * without whisper.cpp.
+   */
+  public createLocalTranscriber(options: LocalTranscriberOptions): NativeLocalTranscriber | null {
+    if (!this.nativeModule || typeof this.nativeModule.LocalTranscriber !== 'function') {
+      return null;
+    }
+    try {
+      return new this.nativeModule.LocalTranscriber(options) as NativeLocalTranscriber;
+    } catch (error) {
+      logger.warn('Failed to create local transcriber', { error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /**
+   * Compress a recording as a background task on the native scheduler, off
+   * the JS thread and libuv's pool. Rejects when the module predates it, the input
+   * is not a WAV it reads, or the encode fails; no partial output is left.
+   */
+  public compressRecording(options: CompressionOptions): Promise<CompressionResult> {
+    if (!this.nativeModule || typeof this.nativeModule.compressRecording !== 'function') {
+      return Promise.reject(new Error('Native module has no recording compressor'));
+    }
+    try {
+      return this.nativeModule.compressRecording(options) as Promise<CompressionResult>;
+    } catch (error) {
+      logger.warn('Failed to start compression', { error });
+      return Promise.reject(error);
+    }
+  }
+
+  /**
+   * Split a recorded track at its pauses into balanced segments for batch
+   * transcription, as a background task on the native scheduler. The job runs on if this
+   * processor is destroyed meanwhile. Rejects when the module predates it,
+   * the index does not open or an encode fails.
+   */
+  public segmentRecording(options: SegmentationOptions): Promise<SegmentationResult> {
+    if (!this.nativeModule || typeof this.nativeModule.segmentRecording !== 'function') {
+      return Promise.reject(new Error('Native module has no recording segmenter'));
+    }
+    try {
+      return this.nativeModule.segmentRecording(options) as Promise<SegmentationResult>;
+    } catch (error) {
+      logger.warn('Failed to start segmentation', { error });
+      return Promise.reject(error);
+    }
+  }
+
+  /**
+   * Forced alignment of a track's transcript words to its audio, as a
+   * background task on the native scheduler: runs of words move onto the
+   * speech the VAD, energy and spectral onsets find, then each word is
+   * placed within its run. Returned as a function that keeps the module, so
+   * alignment can start after this processor is destroyed; null when the
+   * module predates it.
+   */
+  public transcriptAligner(): TranscriptAligner | null {
+    const nativeModule = this.nativeModule;
+    if (!nativeModule || typeof nativeModule.alignTranscript !== 'function') {
+      return null;
+    }
+    return (options) => {
+      try {
+        return nativeModule.alignTranscript(options) as Promise<AlignmentResult>;
+      } catch (error) {
+        logger.warn('Failed to start alignment', { error });
+        return Promise.reject(error);
+      }
+    };
+  }
+
+  /**
+   * Run stored meetings through the capture chain again, e.g. after the AEC
+   * or NS presets changed: each gets an AEC processor of its own, fed the
+   * system track as reference and the raw mic as capture, as background
+   * tasks on the native scheduler. Meetings run many times faster than real
+   * time, idle workers take queued meetings from busy ones, and all of them
+   * pause while live audio is falling behind. Returns null when the module
+   * predates it.
+   */
+  public reprocessRecordings(options: ReprocessOptions): ReprocessJob | null {
+    if (!this.nativeModule || typeof this.nativeModule.reprocessRecordings !== 'function') {
+      return null;
+    }
+    try {
+      return this.nativeModule.reprocessRecordings(options) as ReprocessJob;
+    } catch (error) {
+      logger.warn('Failed to start reprocessing', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Queue depth and per-class occupancy of the native scheduler. Null when
+   * the module predates it.
+   */
+  public getSchedulerStats(): SchedulerStats | null {
+    if (!this.nativeModule || typeof this.nativeModule.getSchedulerStats !== 'function') {
+      return null;
+    }
+    return this.nativeModule.getSchedulerStats() as SchedulerStats;
+  }
+
+  /**
+   * Wakeups per native thread kind, the rate over the time since the last
+   * call; stopped or paused, every rate should be zero. The recording and
+   * session capture writers drain 10 times a second while their session
+   * runs, so their rates are only zero once it stops. Null when the module
+   * predates it.
+   */
+  public getWakeupStats(): WakeupStat[] | null {
+    if (!this.nativeModule || typeof this.nativeModule.getWakeupStats !== 'function') {
+      return null;
+    }
+    return this.nativeModule.getWakeupStats() as WakeupStat[];
+  }
+
+  /**
+   * Resident bytes, the system's memory pressure and native usage per
+   * component. Null when the module predates it.
+   */
+  public getNativeMemory(): NativeMemoryUsage | null {
+    if (!this.nativeModule || typeof this.nativeModule.getNativeMemory !== 'function') {
+      return null;
+    }
+    return this.nativeModule.getNativeMemory() as NativeMemoryUsage;
+  }
+
+  /** Sets what native buffers shrink to under memory pressure */
+  public setMemoryMinimums(minimums: MemoryMinimums): boolean {
+    if (!this.nativeModule || typeof this.nativeModule.setMemoryMinimums !== 'function') {
+      return false;
+    }
+    try {
+      this.nativeModule.setMemoryMinimums(minimums);
+      return true;
+    } catch (error) {
+      logger.warn('Failed to set memory minimums', { error });
+      return false;
+    }
+  }
+
+  /**
+   * Assemble a native processing graph (e.g. highpass -> aec -> fir ->
+   * resample -> normalize -> vad -> gate -> encode) for audio that does not come from
+   * native capture. Returns null when the module predates it or a stage is
+   * invalid; the reason is logged.
+   */
+  public createProcessingGraph(config: ProcessingGraphConfig): NativeProcessingGraph | null {
+    if (!this.nativeModule || typeof this.nativeModule.ProcessingGraph !== 'function') {
+      return null;
+    }
+    try {
+      return new this.nativeModule.ProcessingGraph(config) as NativeProcessingGraph;
+    } catch (error) {
+      logger.warn('Failed to build processing graph', { error: (error as Error).message });
+      return null;
+    }
+  }
+
+  /**
+   * Check if native microphone capture is running.
+   */
+  public isMicrophoneCapturing(): boolean {
+    return this.micCapturing;
+  }
+
+  /**
+   * Stop the microphone's device IO but keep everything else: the callback,
+   * the native stream and, in processed mode, the echo canceller with its
+   * converged filters and delay estimate. Audio captured before the pause is
+   * still delivered. On macOS resuming is a device start; WASAPI and
+   * PipeWire reopen the endpoint.
+   */
+  public pauseMicrophoneCapture(): Promise<boolean> {
+    return this.queueMicPause(true);
+  }
+
+  /**
+   * Restart device IO stopped by pauseMicrophoneCapture(), on whichever
+   * input device the mic follows by then.
+   */
+  public resumeMicrophoneCapture(): Promise<boolean> {
+    return this.queueMicPause(false);
+  }
+
+  private queueMicPause(pause: boolean): Promise<boolean> {
+    const next = this.micPauseQueue.then(() => (pause ? this.pauseMicrophone() : this.resumeMicrophone()));
+    this.micPauseQueue = next.catch(() => false);
+    return next;
+  }
+
+  private async pauseMicrophone(): Promise<boolean> {
+    if (!this.micCapturing || this.micPaused) {
+      return false;
+    }
+    if (!this.nativeInstance || typeof this.nativeInstance.pauseMicrophoneCapture !== 'function') {
+      return false;
+    }
+
+    try {
+      const paused: boolean = await this.nativeInstance.pauseMicrophoneCapture();
+      if (paused) {
+        this.micPaused = true;
+        logger.info('Native microphone capture paused');
+      }
+      return paused;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error pausing native microphone capture', { error: message });
+      return false;
+    }
+  }
+
+  private async resumeMicrophone(): Promise<boolean> {
+    if (!this.micCapturing || !this.micPaused) {
+      return false;
+    }
+
+    try {
+      const resumed: boolean = await this.nativeInstance.resumeMicrophoneCapture();
+      if (resumed) {
+        this.micPaused = false;
+        logger.info('Native microphone capture resumed');
+      }
+      return resumed;
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.error('Error resuming native microphone capture', { error: message });
+      return false;
+    }
+  }
+
+  /**
+   * Check if native microphone capture is paused.
+   */
+  public isMicrophonePaused(): boolean {
+    return this.micPaused;
+  }
+
+  /**
+   * Check if the mic callback receives natively echo-cancelled audio.
+   */
+  public isNativeEchoCancelling(): boolean {
+    return this.micCapturing && this.micProcessed;
+  }
+
+  /**
+   * Get current AEC metrics (ERLE, residual echo level, convergence status).
+   */
+  public getMetrics(): AECMetrics {
+    if (!this.isInitialized || this.isDestroyed) {
+      return {};
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getMetrics === 'function') {
+        const m = this.nativeInstance.getMetrics() as any;
+        // Map native keys to AECMetrics interface
+        const mapped: AECMetrics = {
+          erle: typeof m.echoReturnLossEnhancement === 'number' ? m.echoReturnLossEnhancement : undefined,
+          rerl: typeof m.echoReturnLoss === 'number' ? m.echoReturnLoss : undefined,
+          renderDelayMs: typeof m.renderDelayMs === 'number' ? m.renderDelayMs : undefined,
+          converged: typeof m.aecConverged === 'boolean' ? m.aecConverged : undefined,
+          divergentFilterFraction:
+            typeof m.divergentFilterFraction === 'number' ? m.divergentFilterFraction : undefined,
+          residualEchoLikelihood:
+            typeof m.residualEchoLikelihood === 'number' ? m.residualEchoLikelihood : undefined,
+          residualEchoLikelihoodRecentMax:
+            typeof m.residualEchoLikelihoodRecentMax === 'number'
+              ? m.residualEchoLikelihoodRecentMax
+              : undefined,
+          delayMedianMs: typeof m.delayMedianMs === 'number' ? m.delayMedianMs : undefined,
+          delayStdMs: typeof m.delayStdMs === 'number' ? m.delayStdMs : undefined,
+          streamDelayMs: typeof m.streamDelayMs === 'number' ? m.streamDelayMs : undefined,
+          renderDriftPpm: typeof m.renderDriftPpm === 'number' ? m.renderDriftPpm : undefined,
+          processingSampleRate:
+            typeof m.processingSampleRate === 'number' ? m.processingSampleRate : undefined,
+          processingLoad: typeof m.processingLoad === 'number' ? m.processingLoad : undefined,
+          bypassed: typeof m.bypassed === 'boolean' ? m.bypassed : undefined,
+          suppressionLevel:
+            m.suppressionLevel === 'default' || m.suppressionLevel === 'aggressive' ? m.suppressionLevel : undefined,
+          governorLevel: typeof m.governorLevel === 'string' ? (m.governorLevel as GovernorLevel) : undefined,
+          governorTransitions: typeof m.governorTransitions === 'number' ? m.governorTransitions : undefined,
+          normalizerGainDb: typeof m.normalizerGainDb === 'number' ? m.normalizerGainDb : undefined,
+          speechLevelDbfs: typeof m.speechLevelDbfs === 'number' ? m.speechLevelDbfs : undefined,
+          clippingPredictions: typeof m.clippingPredictions === 'number' ? m.clippingPredictions : undefined,
+          echoPathResets: typeof m.echoPathResets === 'number' ? m.echoPathResets : undefined,
+          echoPathChange: typeof m.echoPathChange === 'string' ? (m.echoPathChange as EchoPathChange) : undefined,
+          echoPathReconverging:
+            typeof m.echoPathReconverging === 'boolean' ? m.echoPathReconverging : undefined,
+          echoPathReconvergeMs:
+            typeof m.echoPathReconvergeMs === 'number' ? m.echoPathReconvergeMs : undefined,
+          echoPathLeakageDb: typeof m.echoPathLeakageDb === 'number' ? m.echoPathLeakageDb : undefined,
+          outputLatencySamples:
+            typeof m.outputLatencySamples === 'number' ? m.outputLatencySamples : undefined,
+          outputLatencyMs: typeof m.outputLatencyMs === 'number' ? m.outputLatencyMs : undefined,
+          captureCalls: typeof m.captureCalls === 'object' && m.captureCalls ? m.captureCalls : undefined,
+          renderCalls: typeof m.renderCalls === 'object' && m.renderCalls ? m.renderCalls : undefined,
+          echoPower: typeof m.rmsLevel === 'number' ? m.rmsLevel : undefined,
+          residualEchoLevel: typeof m.peakLevel === 'number' ? m.peakLevel : undefined,
+          noiseFloor: typeof m.noiseFloor === 'number' ? m.noiseFloor : undefined,
+          speech: typeof m.speech === 'boolean' ? m.speech : undefined,
+        };
+        return mapped;
+      }
+      return {};
+    } catch (error) {
+      const message = error instanceof Error ? error.message : String(error);
+      logger.warn('Failed to get AEC metrics', { error: message });
+      return {};
+    }
+  }
+
+  /**
+   * The slot layout of readMetrics(); fixed for the life of the module.
+   * Null when the module predates it.
+   */
+  public getMetricsLayout(): MetricsLayout | null {
+    if (!this.isInitialized || this.isDestroyed || typeof this.nativeInstance?.getMetricsLayout !== 'function') {
+      return null;
+    }
+    return this.nativeInstance.getMetricsLayout() as MetricsLayout;
+  }
+
+  /**
+   * Every AEC, capture and stage metric into `out` at getMetricsLayout()'s
+   * offsets, without allocating: cheap enough to poll every frame. Returns
+   * the layout length (an `out` shorter than it is filled as far as it
+   * goes), or 0 when unavailable.
+   */
+  public readMetrics(out: Float64Array): number {
+    if (!this.isInitialized || this.isDestroyed || typeof this.nativeInstance?.readMetrics !== 'function') {
+      return 0;
+    }
+    try {
+      return this.nativeInstance.readMetrics(out) as number;
+    } catch (error) {
+      logger.warn('Failed to read metrics', { error: (error as Error).message });
+      return 0;
+    }
+  }
+
+  /**
+   * Check if headphones are currently connected.
+   */
+  public isHeadphonesConnected(): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      return false;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.isHeadphonesConnected === 'function') {
+        return this.nativeInstance.isHeadphonesConnected() as boolean;
+      }
+      return false;
+    } catch (error) {
+      logger.warn('Failed to check headphone status', { error });
+      return false;
+    }
+  }
+
+  /**
+   * Called with the new state whenever the default output switches between
+   * headphones (built-in jack, Bluetooth, USB headsets) and speakers. Pass
+   * null to stop listening. Only one listener is kept.
+   */
+  public onHeadphoneStatusChanged(callback: ((headphones: boolean) => void) | null): void {
+    if (!this.isInitialized || this.isDestroyed) {
+      return;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.onHeadphoneStatusChanged === 'function') {
+        this.nativeInstance.onHeadphoneStatusChanged(callback);
+      }
+    } catch (error) {
+      logger.warn('Failed to register headphoneStatusChanged listener', { error });
+    }
+  }
+
+  /**
+   * Called when mic capture resumes after its device went away (unplugged,
+   * Bluetooth dropped) or the system slept. Capture moves to the device it
+   * would follow now without a restart from JS. Pass null to stop
+   * listening. Only one listener is kept.
+   */
+  public onCaptureRecovered(callback: ((event: CaptureRecoveredEvent) => void) | null): void {
+    if (!this.isInitialized || this.isDestroyed) {
+      return;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.onCaptureRecovered === 'function') {
+        this.nativeInstance.onCaptureRecovered(callback);
+      }
+    } catch (error) {
+      logger.warn('Failed to register captureRecovered listener', { error });
+    }
+  }
+
+  /**
+   * Peak and RMS of every native stream at |rateHz| (1-120, default 30),
+   * computed natively as the audio is delivered, so UI meters cost one small
+   * message per tick rather than a pass over every buffer in JS. With
+   * `spectrum`, each level also carries the stream's band energies over the
+   * tick. Replaces a meter already running; false when the addon has none.
+   */
+  public startLevelMeter(callback: (levels: LevelMeterReading) => void, options: LevelMeterOptions = {}): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      return false;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.startLevelMeter === 'function') {
+        return this.nativeInstance.startLevelMeter(callback, options) as boolean;
+      }
+    } catch (error) {
+      logger.warn('Failed to start level meter', { error });
+    }
+    return false;
+  }
+
+  public stopLevelMeter(): void {
+    if (this.nativeInstance && typeof this.nativeInstance.stopLevelMeter === 'function') {
+      this.nativeInstance.stopLevelMeter();
+    }
+  }
+
+  /**
+   * Sample this instance's metrics every intervalMs (default 1000) on a
+   * native thread until stopPerformanceReport(), for a report stored with
+   * the meeting. Replaces a report already running; false when the addon
+   * has none.
+   */
+  public startPerformanceReport(options: { intervalMs?: number } = {}): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      return false;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.startPerformanceReport === 'function') {
+        this.nativeInstance.startPerformanceReport(options);
+        return true;
+      }
+    } catch (error) {
+      logger.warn('Failed to start performance report', { error });
+    }
+    return false;
+  }
+
+  /** CPU, deadlines, drops, JS overload, AEC and latency since startPerformanceReport(); null when none ran */
+  public stopPerformanceReport(): PerformanceReport | null {
+    if (this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.stopPerformanceReport === 'function') {
+        return this.nativeInstance.stopPerformanceReport() as PerformanceReport | null;
+      }
+    } catch (error) {
+      logger.warn('Failed to stop performance report', { error });
+    }
+    return null;
+  }
+
+  /**
+   * This session's converged AEC state and the devices it ran on, or null
+   * when unavailable. Fields AEC3 has not settled yet are absent.
+   */
+  public getAecProfile(): AECProfile | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getAecProfile === 'function') {
+        return this.nativeInstance.getAecProfile() as AECProfile | null;
+      }
+      return null;
+    } catch (error) {
+      logger.warn('Failed to read AEC profile', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Seeds AEC from a profile saved on the same devices, and the noise
+   * suppressor from the mic's stored noise when given. Best applied before
+   * audio flows: the APM is rebuilt (once for both) and re-converges from
+   * the seed.
+   */
+  public applyAecProfile(profile: AECWarmStart, noiseProfile?: NoiseProfile | null): boolean {
+    const { echoDelayMs, streamDelayMs, preset } = profile;
+    return this.configure({
+      warmStart: { echoDelayMs, streamDelayMs, preset },
+      ...(noiseProfile ? { noiseProfile } : {}),
+    });
+  }
+
+  /**
+   * The mic's noise as heard this session and the input it ran on, or null
+   * before a few seconds of it between speech and playback
+   */
+  public getNoiseProfile(): DeviceNoiseProfile | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getNoiseProfile === 'function') {
+        return this.nativeInstance.getNoiseProfile() as DeviceNoiseProfile | null;
+      }
+      return null;
+    } catch (error) {
+      logger.warn('Failed to read noise profile', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Hands the stored profiles to the native side, which seeds the canceller
+   * from the matching pair when the output or mic changes mid-session
+   * (macOS only)
+   */
+  public setAecProfiles(profiles: AECProfile[]): void {
+    if (!this.nativeInstance || typeof this.nativeInstance.setAecProfiles !== 'function') {
+      return;
+    }
+    try {
+      this.nativeInstance.setAecProfiles(profiles);
+    } catch (error) {
+      logger.warn('Failed to hand over AEC profiles', { error });
+    }
+  }
+
+  /**
+   * Replaces the adapted canceller with a fresh one after an echo path
+   * change the native listeners cannot see. Seeds it from |warmStart|, or
+   * on macOS the current devices' stored profile. Returns the change's
+   * sequence number for whenConfigApplied(), or 0.
+   */
+  public resetEchoPath(warmStart?: AECWarmStart): number {
+    if (!this.nativeInstance || typeof this.nativeInstance.resetEchoPath !== 'function') {
+      return 0;
+    }
+    try {
+      return this.nativeInstance.resetEchoPath(warmStart) as number;
+    } catch (error) {
+      logger.warn('Failed to reset the echo path', { error });
+      return 0;
+    }
+  }
+
+  /** The hardware part of the echo delay (macOS only), or null */
+  public getEchoPathLatency(): EchoPathLatency | null {
+    if (!this.nativeInstance || typeof this.nativeInstance.getEchoPathLatency !== 'function') {
+      return null;
+    }
+    try {
+      return this.nativeInstance.getEchoPathLatency() as EchoPathLatency;
+    } catch (error) {
+      logger.warn('Failed to read the echo path latency', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Standby watch on system output for a call starting without a calendar
+   * event: a capture of its own, decimated, VAD-only and woken once a
+   * second. On macOS only |bundleIds|' output is heard; elsewhere all of it.
+   */
+  public startMeetingMonitor(
+    options: { bundleIds?: string[] },
+    callback: (event: MeetingAudioEvent) => void
+  ): boolean {
+    if (!this.nativeInstance || typeof this.nativeInstance.startMeetingMonitor !== 'function') {
+      return false;
+    }
+    try {
+      this.nativeInstance.startMeetingMonitor(options, callback);
+      return true;
+    } catch (error) {
+      logger.warn('Failed to start the meeting monitor', { error });
+      return false;
+    }
+  }
+
+  public stopMeetingMonitor(): void {
+    if (!this.nativeInstance || typeof this.nativeInstance.stopMeetingMonitor !== 'function') {
+      return;
+    }
+    try {
+      this.nativeInstance.stopMeetingMonitor();
+    } catch (error) {
+      logger.warn('Failed to stop the meeting monitor', { error });
+    }
+  }
+
+  public getMeetingMonitorStats(): MeetingMonitorStats | null {
+    if (!this.nativeInstance || typeof this.nativeInstance.getMeetingMonitorStats !== 'function') {
+      return null;
+    }
+    try {
+      return this.nativeInstance.getMeetingMonitorStats() as MeetingMonitorStats;
+    } catch (error) {
+      logger.warn('Failed to read the meeting monitor stats', { error });
+      return null;
+    }
+  }
+
+  /**
+   * Spots |keywords| on the system stream with the KKKW acoustic model at
+   * |model|, over the stream's shared spectrum, whenever it is open. Events
+   * come within a couple of hundred ms of the audio, well ahead of finals.
+   */
+  public startKeywordSpotter(
+    options: { model: string; keywords: Array<string | { text: string; threshold?: number }> },
+    callback: (event: KeywordEvent) => void
+  ): boolean {
+    if (!this.nativeInstance || typeof this.nativeInstance.startKeywordSpotter !== 'function') {
+      return false;
+    }
+    try {
+      this.nativeInstance.startKeywordSpotter(options, callback);
+      return true;
+    } catch (error) {
+      logger.warn('Failed to start the keyword spotter', { error });
+      return false;
+    }
+  }
+
+  public stopKeywordSpotter(): void {
+    if (!this.nativeInstance || typeof this.nativeInstance.stopKeywordSpotter !== 'function') {
+      return;
+    }
+    try {
+      this.nativeInstance.stopKeywordSpotter();
     } catch (error) {
-      const message = error instanceof Error ? error.message : String(error);
-      logger.error('AEC initialization failed', { errorMessage: message, errorType: error instanceof Error ? 'Error' : 'Other' });
-      throw new Error(`AEC initialization failed: ${message}`);
+      logger.warn('Failed to stop the keyword spotter', { error });
+    }
+  }
+
+  public getKeywordSpotterStats(): KeywordSpotterStats | null {
+    if (!this.nativeInstance || typeof this.nativeInstance.getKeywordSpotterStats !== 'function') {
+      return null;
+    }
+    try {
+      return this.nativeInstance.getKeywordSpotterStats() as KeywordSpotterStats;
+    } catch (error) {
+      logger.warn('Failed to read the keyword spotter stats', { error });
+      return null;
     }
   }
 
   /**
-   * Process render (system/speaker) audio through the AEC reference path.
-   * Must be called BEFORE corresponding processCaptureAudio() call.
+   * Pools the user's speech on the mic stream (open with verifyVoice) into a
+   * voiceprint, until finishVoiceEnrollment() or cancelVoiceEnrollment()
    */
-  public processRenderAudio(renderBuffer: Float32Array): boolean {
-    if (this.isDestroyed) {
-      logger.warn('Cannot process render audio: AEC processor is destroyed');
+  public startVoiceEnrollment(): boolean {
+    if (!this.nativeInstance || typeof this.nativeInstance.startVoiceEnrollment !== 'function') {
       return false;
     }
-
-    if (!this.isInitialized) {
-      logger.warn('Cannot process render audio: AEC not initialized');
+    try {
+      this.nativeInstance.startVoiceEnrollment();
+      return true;
+    } catch (error) {
+      logger.warn('Failed to start voice enrollment', { error });
       return false;
     }
+  }
 
-    if (!renderBuffer || renderBuffer.length === 0) {
-      logger.warn('Render buffer is empty, skipping');
-      return false;
+  /**
+   * The enrolled voiceprint, already in effect on the mic stream; null
+   * before enough speech (VoiceVerifierStats.enrollmentSeconds)
+   */
+  public finishVoiceEnrollment(): { voiceprint: Buffer; speechSeconds: number } | null {
+    if (!this.nativeInstance || typeof this.nativeInstance.finishVoiceEnrollment !== 'function') {
+      return null;
+    }
+    try {
+      return this.nativeInstance.finishVoiceEnrollment() as { voiceprint: Buffer; speechSeconds: number };
+    } catch (error) {
+      logger.warn('Failed to finish voice enrollment', { error });
+      return null;
     }
+  }
 
+  public cancelVoiceEnrollment(): void {
+    if (!this.nativeInstance || typeof this.nativeInstance.cancelVoiceEnrollment !== 'function') {
+      return;
+    }
     try {
-      // Queue the render buffer for processing
-      // The native module will process it internally and use it as reference
-      // for the next processCaptureAudio call
-      if (this.nativeInstance && typeof this.nativeInstance.processRenderAudio === 'function') {
-        this.nativeInstance.processRenderAudio(renderBuffer);
-      }
+      this.nativeInstance.cancelVoiceEnrollment();
+    } catch (error) {
+      logger.warn('Failed to cancel voice enrollment', { error });
+    }
+  }
 
-      // Keep a reference for metrics if needed
-      if (this.renderBufferQueue.length >= this.MAX_RENDER_QUEUE) {
-        this.renderBufferQueue.shift();
-      }
-      this.renderBufferQueue.push(renderBuffer);
+  /** Replaces the open mic stream's voiceprint; null passes every voice */
+  public setVoiceprint(voiceprint: Uint8Array | null): boolean {
+    if (!this.nativeInstance || typeof this.nativeInstance.setVoiceprint !== 'function') {
+      return false;
+    }
+    try {
+      this.nativeInstance.setVoiceprint(voiceprint);
+      return true;
+    } catch (error) {
+      logger.warn('Failed to set the voiceprint', { error });
+      return false;
+    }
+  }
+
+  public getVoiceVerifierStats(): VoiceVerifierStats | null {
+    if (!this.nativeInstance || typeof this.nativeInstance.getVoiceVerifierStats !== 'function') {
+      return null;
+    }
+    try {
+      return this.nativeInstance.getVoiceVerifierStats() as VoiceVerifierStats | null;
+    } catch (error) {
+      logger.warn('Failed to read the voice verifier stats', { error });
+      return null;
+    }
+  }
 
+  /**
+   * Starts evaluating |candidate| (over the live configuration) on the
+   * native pipeline's frames at background priority, capped at |maxLoad|
+   * of one core (default 0.05). Nothing it produces reaches the output.
+   */
+  public startShadowEvaluation(candidate: AECConfig, maxLoad?: number): boolean {
+    if (!this.nativeInstance || typeof this.nativeInstance.startShadowAec !== 'function') {
+      return false;
+    }
+    try {
+      this.nativeInstance.startShadowAec(candidate, maxLoad);
       return true;
     } catch (error) {
-      const message = error instanceof Error ? error.message : String(error);
-      logger.error('Error processing render audio', { error: message });
+      logger.warn('Failed to start the shadow AEC', { error });
       return false;
     }
   }
 
+  public stopShadowEvaluation(): void {
+    if (!this.nativeInstance || typeof this.nativeInstance.stopShadowAec !== 'function') {
+      return;
+    }
+    try {
+      this.nativeInstance.stopShadowAec();
+    } catch (error) {
+      logger.warn('Failed to stop the shadow AEC', { error });
+    }
+  }
+
   /**
-   * Process capture (microphone) audio through the AEC to remove echo.
-   * Returns echo-cancelled audio, or null on error.
+   * The running or last evaluation's aggregate, with no audio in it; for
+   * the app to report only where the user opted in
    */
-  public processCaptureAudio(captureBuffer: Float32Array): Float32Array | null {
-    if (this.isDestroyed) {
-      logger.warn('Cannot process capture audio: AEC processor is destroyed');
+  public getShadowComparison(): ShadowAecComparison | null {
+    if (!this.nativeInstance || typeof this.nativeInstance.getShadowComparison !== 'function') {
       return null;
     }
-
-    if (!this.isInitialized) {
-      logger.warn('Cannot process capture audio: AEC not initialized');
+    try {
+      return this.nativeInstance.getShadowComparison() as ShadowAecComparison;
+    } catch (error) {
+      logger.warn('Failed to read the shadow AEC comparison', { error });
       return null;
     }
+  }
 
-    if (!captureBuffer || captureBuffer.length === 0) {
-      logger.warn('Capture buffer is empty, returning null');
+  /**
+   * Play a quiet quarter-second chirp and time it back through the mic to
+   * measure the acoustic round trip, which then replaces the playback
+   * latency estimate in the AEC delay (macOS only). Needs running mic
+   * capture and open speakers; null when the chirp was not heard.
+   */
+  public async calibrate(): Promise<CalibrationResult | null> {
+    if (!this.micCapturing || this.micPaused) {
+      return null;
+    }
+    if (!this.nativeInstance || typeof this.nativeInstance.calibrate !== 'function') {
       return null;
     }
 
     try {
-      // Call the native module to process capture audio and return echo-cancelled result
-      if (this.nativeInstance && typeof this.nativeInstance.processCaptureAudio === 'function') {
-        const result = this.nativeInstance.processCaptureAudio(captureBuffer);
-        return result as Float32Array;
-      }
-
-      logger.warn('processCaptureAudio not available in native module');
-      return null;
+      const result = (await this.nativeInstance.calibrate()) as CalibrationResult;
+      logger.info('AEC round trip calibrated', { ...result });
+      return result;
     } catch (error) {
       const message = error instanceof Error ? error.message : String(error);
-      logger.error('Error processing capture audio', { error: message });
+      logger.warn('AEC calibration failed', { error: message });
       return null;
     }
   }
 
   /**
-   * Start native microphone capture using AudioUnit.
-   * Timestamps use the same monotonic clock as system audio for AEC sync.
+   * Enable or disable echo cancellation at runtime.
    */
-  public startMicrophoneCapture(callback: (samples: Float32Array, timestamp: number) => void): boolean {
-    if (this.isDestroyed) {
-      logger.warn('Cannot start mic capture: AEC processor is destroyed');
-      return false;
+  public setEchoCancellationEnabled(enabled: boolean): void {
+    if (!this.isInitialized || this.isDestroyed) {
+      return;
     }
 
-    if (!this.isInitialized) {
-      logger.warn('Cannot start mic capture: AEC not initialized');
-      return false;
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.setEchoCancellationEnabled === 'function') {
+        this.nativeInstance.setEchoCancellationEnabled(enabled);
+        logger.info('AEC enabled set to:', { enabled });
+      }
+    } catch (error) {
+      logger.warn('Failed to set AEC enabled state', { error });
     }
+  }
 
-    if (this.micCapturing) {
-      logger.warn('Microphone capture already running');
-      return true;
+  /**
+   * Headphone fast path: while `bypass` is set, capture skips the APM (only a
+   * light high-pass and NS remain) and render is not fed. Unlike disabling
+   * AEC, the canceller keeps its adapted filter, so removing the headphones
+   * does not cost a full reconvergence. 'auto' follows the native output-route
+   * detection, switching within a capture frame of the route change.
+   */
+  public setHeadphoneBypass(bypass: boolean | 'auto'): void {
+    if (!this.isInitialized || this.isDestroyed) {
+      return;
     }
 
-    if (!callback || typeof callback !== 'function') {
-      logger.error('Invalid callback provided to startMicrophoneCapture');
-      return false;
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.setHeadphoneBypass === 'function') {
+        this.nativeInstance.setHeadphoneBypass(bypass);
+        logger.info('AEC headphone bypass set to:', { bypass });
+      }
+    } catch (error) {
+      logger.warn('Failed to set headphone bypass', { error });
+    }
+  }
+
+  /**
+   * With engine 'voiceProcessing': pass the mic through the voice unit
+   * unprocessed, without its echo cancellation, AGC or noise suppression.
+   * Applies at once to a running or prepared unit, else from the next start.
+   */
+  public setVoiceProcessingBypass(bypass: boolean): void {
+    if (!this.isInitialized || this.isDestroyed) {
+      return;
     }
 
     try {
-      this.micAudioCallback = callback;
+      if (this.nativeInstance && typeof this.nativeInstance.setVoiceProcessingBypass === 'function') {
+        this.nativeInstance.setVoiceProcessingBypass(bypass);
+        logger.info('Voice processing bypass set to:', { bypass });
+      }
+    } catch (error) {
+      logger.warn('Failed to set voice processing bypass', { error });
+    }
+  }
 
-      if (this.nativeInstance && typeof this.nativeInstance.startMicrophoneCapture === 'function') {
-        const success = this.nativeInstance.startMicrophoneCapture((samples: Float32Array, timestamp: number) => {
-          if (this.micAudioCallback) {
-            this.micAudioCallback(samples, timestamp);
-          }
-        });
+  /**
+   * Change the AEC preset or toggle submodules without restarting capture.
+   * Returns false when the native module rejected the change.
+   */
+  public configure(config: AECRuntimeConfig): boolean {
+    if (!this.isInitialized || this.isDestroyed) {
+      return false;
+    }
 
-        if (success) {
-          this.micCapturing = true;
-          logger.info('Native microphone capture started');
-          return true;
-        } else {
-          logger.error('Native module failed to start microphone capture');
-          this.micAudioCallback = undefined;
-          return false;
-        }
-      } else {
-        logger.error('startMicrophoneCapture not available in native module');
-        this.micAudioCallback = undefined;
-        return false;
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.configure === 'function') {
+        const applied = this.nativeInstance.configure(config) as boolean;
+        logger.info('AEC configured', { ...config, applied });
+        return applied;
       }
+      return false;
     } catch (error) {
-      // Better error extraction for debugging
-      let errorMsg = 'Unknown error';
-      let errorStack = '';
-      if (error instanceof Error) {
-        errorMsg = error.message;
-        errorStack = error.stack || '';
-      } else if (typeof error === 'object' && error !== null) {
-        errorMsg = JSON.stringify(error);
-      } else {
-        errorMsg = String(error);
-      }
-      
-      logger.error('Error starting native microphone capture', { 
-        error: errorMsg,
-        stack: errorStack,
-        errorType: typeof error,
-        errorKeys: error && typeof error === 'object' ? Object.keys(error) : []
-      });
-      this.micAudioCallback = undefined;
+      logger.warn('Failed to configure AEC', { error });
       return false;
     }
   }
 
   /**
-   * Stop native microphone capture.
+   * configure() without racing or blocking the processing threads: the change
+   * goes into a native mailbox and applies at the next capture frame boundary
+   * (a preset or rate change once its new APM is built). Returns the change's
+   * sequence number, 0 when unavailable; whenConfigApplied() waits for it.
    */
-  public stopMicrophoneCapture(): boolean {
-    if (!this.micCapturing) {
-      return true;
+  public postConfig(config: AECRuntimeConfig): number {
+    if (!this.isInitialized || this.isDestroyed) {
+      return 0;
     }
 
     try {
-      if (this.nativeInstance && typeof this.nativeInstance.stopMicrophoneCapture === 'function') {
-        const success = this.nativeInstance.stopMicrophoneCapture();
-        
-        if (success) {
-          this.micCapturing = false;
-          this.micAudioCallback = undefined;
-          logger.info('Native microphone capture stopped');
-          return true;
-        } else {
-          logger.warn('Native module failed to stop microphone capture');
-          return false;
-        }
-      } else {
-        logger.warn('stopMicrophoneCapture not available in native module');
-        return false;
+      if (this.nativeInstance && typeof this.nativeInstance.postConfig === 'function') {
+        const sequence = this.nativeInstance.postConfig(config) as number;
+        logger.info('AEC config posted', { ...config, sequence });
+        return sequence;
       }
+      // An addon without the mailbox applies it synchronously
+      this.configure(config);
+      return 0;
     } catch (error) {
-      const message = error instanceof Error ? error.message : String(error);
-      logger.error('Error stopping native microphone capture', { error: message });
-      return false;
+      logger.warn('Failed to post AEC config', { error });
+      return 0;
+    }
+  }
+
+  public getConfigStatus(): AECConfigStatus | null {
+    if (!this.isInitialized || this.isDestroyed) {
+      return null;
+    }
+
+    try {
+      if (this.nativeInstance && typeof this.nativeInstance.getConfigStatus === 'function') {
+        return this.nativeInstance.getConfigStatus() as AECConfigStatus;
+      }
+      return null;
+    } catch (error) {
+      logger.warn('Failed to read AEC config status', { error });
+      return null;
     }
   }
 
   /**
-   * Check if native microphone capture is running.
+   * Resolves once change `sequence` (or a later one) has taken effect or was
+   * rejected, polling each 10ms frame; null on timeout or without the mailbox.
    */
-  public isMicrophoneCapturing(): boolean {
-    return this.micCapturing;
+  public async whenConfigApplied(sequence: number, timeoutMs = 2000): Promise<AECConfigStatus | null> {
+    const deadline = Date.now() + timeoutMs;
+    for (;;) {
+      const status = this.getConfigStatus();
+      if (!status) return null;
+      if (status.applied >= sequence || status.rejected >= sequence) return status;
+      if (Date.now() >= deadline) return null;
+      await new Promise((resolve) => setTimeout(resolve, 10));
+    }
   }
 
   /**
-   * Get current AEC metrics (ERLE, residual echo level, convergence status).
+   * Effective native AEC settings (after preset defaults and configure()),
+   * or null when unavailable. getConfig() returns the constructor options.
    */
-  public getMetrics(): AECMetrics {
+  public getNativeConfig(): (Required<AECRuntimeConfig> & { processingSampleRate: number }) | null {
     if (!this.isInitialized || this.isDestroyed) {
-      return {};
+      return null;
     }
 
     try {
-      if (this.nativeInstance && typeof this.nativeInstance.getMetrics === 'function') {
-        const m = this.nativeInstance.getMetrics() as any;
-        // Map native keys to AECMetrics interface
-        const mapped: AECMetrics = {
-          erle: typeof m.echoReturnLossEnhancement === 'number' ? m.echoReturnLossEnhancement : undefined,
-          rerl: typeof m.echoReturnLoss === 'number' ? m.echoReturnLoss : undefined,
-          renderDelayMs: typeof m.renderDelayMs === 'number' ? m.renderDelayMs : undefined,
-          converged: typeof m.aecConverged === 'boolean' ? m.aecConverged : undefined,
-          echoPower: typeof m.rmsLevel === 'number' ? m.rmsLevel : undefined,
-          residualEchoLevel: typeof m.peakLevel === 'number' ? m.peakLevel : undefined,
-        };
-        return mapped;
+      if (this.nativeInstance && typeof this.nativeInstance.getConfig === 'function') {
+        return this.nativeInstance.getConfig();
       }
-      return {};
+      return null;
     } catch (error) {
-      const message = error instanceof Error ? error.message : String(error);
-      logger.warn('Failed to get AEC metrics', { error: message });
-      return {};
+      logger.warn('Failed to read AEC config', { error });
+      return null;
     }
   }
 
   /**
-   * Check if headphones are currently connected.
+   * Record the APM's config and render/capture streams to `path` for offline
+   * replay and tuning (WebRTC's audioproc_f). `maxBytes` caps the file
+   * (default: unlimited). Writes happen on a native background queue. Returns
+   * false when the WebRTC APM is not in use, the file cannot be opened, or
+   * the linked WebRTC build has AEC dump support compiled out. A preset
+   * change through configure() ends the dump.
    */
-  public isHeadphonesConnected(): boolean {
+  public startAecDump(path: string, maxBytes?: number): boolean {
     if (!this.isInitialized || this.isDestroyed) {
       return false;
     }
 
     try {
-      if (this.nativeInstance && typeof this.nativeInstance.isHeadphonesConnected === 'function') {
-        return this.nativeInstance.isHeadphonesConnected() as boolean;
+      if (this.nativeInstance && typeof this.nativeInstance.startAecDump === 'function') {
+        const started = this.nativeInstance.startAecDump(path, maxBytes) as boolean;
+        logger.info('AEC dump', { path, maxBytes, started });
+        return started;
       }
       return false;
     } catch (error) {
-      logger.warn('Failed to check headphone status', { error });
+      logger.warn('Failed to start AEC dump', { error });
       return false;
     }
   }
 
-  /**
-   * Enable or disable echo cancellation at runtime.
-   */
-  public setEchoCancellationEnabled(enabled: boolean): void {
-    if (!this.isInitialized || this.isDestroyed) {
+  /** Flush and close the AEC dump started by startAecDump() */
+  public stopAecDump(): void {
+    if (!this.nativeInstance || typeof this.nativeInstance.stopAecDump !== 'function') {
       return;
     }
-
     try {
-      if (this.nativeInstance && typeof this.nativeInstance.setEchoCancellationEnabled === 'function') {
-        this.nativeInstance.setEchoCancellationEnabled(enabled);
-        logger.info('AEC enabled set to:', { enabled });
-      }
+      this.nativeInstance.stopAecDump();
     } catch (error) {
-      logger.warn('Failed to set AEC enabled state', { error });
+      logger.warn('Failed to stop AEC dump', { error });
     }
   }
 
@@ -475,7 +4809,6 @@ export class AECProcessor {
       if (this.nativeInstance && typeof this.nativeInstance.resetAEC === 'function') {
         this.nativeInstance.resetAEC();
       }
-      this.renderBufferQueue = [];
       logger.info('AEC state reset');
     } catch (error) {
       logger.warn('Failed to reset AEC state', { error });
@@ -494,14 +4827,26 @@ export class AECProcessor {
     try {
       // Stop native mic capture if running
       if (this.micCapturing) {
-        this.stopMicrophoneCapture();
+        void this.stopMicrophoneCapture();
+      } else {
+        this.unprepareMicrophoneCapture();
+      }
+      if (this.systemCapturing) {
+        this.stopSystemAudioCapture();
+      }
+      if (this.asyncProcessing) {
+        this.stopAsyncProcessing();
       }
+      this.stopLevelMeter();
 
       // Native instance will be GC'd; just drop references
-      this.renderBufferQueue = [];
       this.isInitialized = false;
       this.isDestroyed = true;
       this.micAudioCallback = undefined;
+      this.systemAudioCallback = undefined;
+      this.nativeInstance?.onDevicesChanged?.(null);
+      this.nativeInstance?.onHeadphoneStatusChanged?.(null);
+      this.nativeInstance?.onCaptureRecovered?.(null);
       this.nativeInstance = null;
       this.nativeModule = null;
 
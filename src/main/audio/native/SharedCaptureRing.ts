@@ -0,0 +1,207 @@
+/**
+ * SharedArrayBuffer ring a native capture stream writes into instead of
+ * calling back (MicCaptureOptions.sharedRing), so a worker can consume audio
+ * without a main-thread hop per delivery. Layout matches native/src/shared_ring.h:
+ *
+ *   control  16 x Int32, read and written with Atomics (RingField)
+ *   frames   one 40-byte entry per delivery: f64 timestamp, f64 hostTimeMs,
+ *            f64 sampleIndex, f64 silenceMs, u32 sample position, u32 count
+ *   samples  float32 or int16, at the stream's output rate
+ *
+ * Positions are free-running u32 counters; the native side is the only writer
+ * of the write positions and the reader of the read ones.
+ */
+
+export const enum RingField {
+  Magic = 0,
+  Version = 1,
+  SampleCapacity = 2,
+  FrameCapacity = 3,
+  Format = 4,
+  SampleRate = 5,
+  SampleWrite = 6,
+  SampleRead = 7,
+  FrameWrite = 8,
+  FrameRead = 9,
+  Dropped = 10,
+  State = 11,
+}
+
+const RING_MAGIC = 0x52534b4b;
+const RING_VERSION = 1;
+const HEADER_BYTES = 64;
+const FRAME_BYTES = 40;
+
+export interface SharedCaptureRingOptions {
+  /** Output rate of the stream that will write it, to size the ring */
+  sampleRate: number;
+  /** Audio the ring holds before deliveries drop (default: 2) */
+  seconds?: number;
+  /** Must match what the stream would deliver otherwise (default: 'float32') */
+  format?: 'float32' | 'pcm16';
+  /** Deliveries the ring holds before they drop (default: 256) */
+  frames?: number;
+}
+
+/** One delivery, as the callback would have received it */
+export interface SharedRingDelivery<T extends Float32Array | Int16Array = Float32Array | Int16Array> {
+  /**
+   * Valid only during the handler call: it may be a view over the ring,
+   * whose slots are reused once read() returns
+   */
+  samples: T;
+  timestamp: number;
+  sampleIndex: number;
+  hostTimeMs: number;
+  /** Gated silence or a capture gap; samples is empty */
+  silenceMs: number;
+}
+
+/**
+ * Native waitSharedRing(control, index, value, timeoutMs). Atomics.wait is
+ * never woken by native stores, so workers that load the addon should pass it
+ */
+export type SharedRingWait = (
+  control: Int32Array,
+  index: number,
+  value: number,
+  timeoutMs?: number
+) => 'ok' | 'not-equal' | 'timed-out';
+
+export function createSharedCaptureRing(options: SharedCaptureRingOptions): SharedArrayBuffer {
+  const pcm16 = options.format === 'pcm16';
+  const sampleCapacity = Math.max(1, Math.ceil(options.sampleRate * (options.seconds ?? 2)));
+  const frameCapacity = Math.max(1, Math.floor(options.frames ?? 256));
+  const sampleBytes = pcm16 ? 2 : 4;
+  const ring = new SharedArrayBuffer(HEADER_BYTES + frameCapacity * FRAME_BYTES + sampleCapacity * sampleBytes);
+  const control = new Int32Array(ring, 0, HEADER_BYTES / 4);
+  control[RingField.Magic] = RING_MAGIC;
+  control[RingField.Version] = RING_VERSION;
+  control[RingField.SampleCapacity] = sampleCapacity;
+  control[RingField.FrameCapacity] = frameCapacity;
+  control[RingField.Format] = pcm16 ? 1 : 0;
+  return ring;
+}
+
+/** Consumer side, for exactly one thread at a time */
+export class SharedCaptureRingReader {
+  private readonly control: Int32Array;
+  private readonly frames: DataView;
+  private readonly samples: Float32Array | Int16Array;
+  private readonly sampleCapacity: number;
+  private readonly frameCapacity: number;
+
+  constructor(ring: SharedArrayBuffer, private readonly nativeWait?: SharedRingWait) {
+    this.control = new Int32Array(ring, 0, HEADER_BYTES / 4);
+    if (this.control[RingField.Magic] !== RING_MAGIC || this.control[RingField.Version] !== RING_VERSION) {
+      throw new Error('Not a shared capture ring');
+    }
+    this.sampleCapacity = this.control[RingField.SampleCapacity];
+    this.frameCapacity = this.control[RingField.FrameCapacity];
+    this.frames = new DataView(ring, HEADER_BYTES, this.frameCapacity * FRAME_BYTES);
+    const samplesOffset = HEADER_BYTES + this.frameCapacity * FRAME_BYTES;
+    this.samples =
+      this.control[RingField.Format] === 1
+        ? new Int16Array(ring, samplesOffset, this.sampleCapacity)
+        : new Float32Array(ring, samplesOffset, this.sampleCapacity);
+  }
+
+  /** A stream is writing; false before it starts and once it stopped */
+  public isOpen(): boolean {
+    return Atomics.load(this.control, RingField.State) === 1;
+  }
+
+  public sampleRate(): number {
+    return Atomics.load(this.control, RingField.SampleRate);
+  }
+
+  /** Deliveries the stream dropped because the ring was full */
+  public dropped(): number {
+    return Atomics.load(this.control, RingField.Dropped) >>> 0;
+  }
+
+  /** Hands every published delivery to |handler|, oldest first; returns the count */
+  public read(handler: (delivery: SharedRingDelivery) => void): number {
+    const frameWrite = Atomics.load(this.control, RingField.FrameWrite) >>> 0;
+    let frameRead = Atomics.load(this.control, RingField.FrameRead) >>> 0;
+    let count = 0;
+    while (frameRead !== frameWrite) {
+      const entry = (frameRead % this.frameCapacity) * FRAME_BYTES;
+      const position = this.frames.getUint32(entry + 32, true);
+      const length = this.frames.getUint32(entry + 36, true);
+      const slot = position % this.sampleCapacity;
+      let samples: Float32Array | Int16Array;
+      if (slot + length <= this.sampleCapacity) {
+        samples = this.samples.subarray(slot, slot + length);
+      } else {
+        // Wrapped: the one case that copies
+        const head = this.sampleCapacity - slot;
+        const whole = this.samples instanceof Int16Array ? new Int16Array(length) : new Float32Array(length);
+        whole.set(this.samples.subarray(slot));
+        whole.set(this.samples.subarray(0, length - head), head);
+        samples = whole;
+      }
+      handler({
+        samples,
+        timestamp: this.frames.getFloat64(entry, true),
+        hostTimeMs: this.frames.getFloat64(entry + 8, true),
+        sampleIndex: this.frames.getFloat64(entry + 16, true),
+        silenceMs: this.frames.getFloat64(entry + 24, true),
+      });
+      frameRead = (frameRead + 1) >>> 0;
+      Atomics.store(this.control, RingField.SampleRead, (position + length) | 0);
+      Atomics.store(this.control, RingField.FrameRead, frameRead | 0);
+      count++;
+    }
+    return count;
+  }
+
+  /**
+   * Blocks until a delivery is published, the stream stops or |timeoutMs|
+   * passes. Workers only. Waits are sliced to notice a stop: 250ms with the
+   * native wait, 10ms polling Atomics.wait, which native stores never wake.
+   */
+  public wait(timeoutMs = Infinity): 'ok' | 'timed-out' {
+    const seen = Atomics.load(this.control, RingField.FrameWrite);
+    const slice = this.nativeWait ? 250 : 10;
+    const deadline = Date.now() + timeoutMs;
+    while (
+      Atomics.load(this.control, RingField.FrameWrite) === seen &&
+      seen === Atomics.load(this.control, RingField.FrameRead) &&
+      this.isOpen()
+    ) {
+      const left = deadline - Date.now();
+      if (left <= 0) {
+        return 'timed-out';
+      }
+      if (this.nativeWait) {
+        this.nativeWait(this.control, RingField.FrameWrite, seen, Math.min(left, slice));
+      } else {
+        Atomics.wait(this.control, RingField.FrameWrite, seen, Math.min(left, slice));
+      }
+    }
+    return 'ok';
+  }
+}
+
+/**
+ * A ring in named OS shared memory (MicCaptureOptions.sharedRing) for a
+ * stream in another process: the stream makes it when it opens, laid out as
+ * above, and the app maps it by name with AECProcessor.openSharedMemoryRing().
+ * Native waits never cross processes, so that side polls read().
+ */
+export interface SharedMemoryRingOptions extends SharedCaptureRingOptions {
+  /** Short ASCII without slashes (30 bytes at most), unique per stream */
+  name: string;
+}
+
+/** The app's side of a shared memory ring; its samples are copies, kept past the handler call */
+export interface NativeSharedMemoryRing {
+  /** Hands every published delivery to |handler|, oldest first; returns the count */
+  read(handler: (delivery: SharedRingDelivery) => void): number;
+  isOpen(): boolean;
+  sampleRate(): number;
+  dropped(): number;
+  /** Unmaps it; read() then returns 0 */
+  close(): void;
+}
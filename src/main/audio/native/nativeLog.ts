@@ -0,0 +1,60 @@
+import { createLogger, getLogLevel, Logger } from '@main/core/logger';
+
+/** One record from the addon's log ring; level follows the JS logger's order */
+interface NativeLogRecord {
+  level: number;
+  source: string;
+  message: string;
+  /** Date.now() domain, when the native side wrote it */
+  time: number;
+}
+
+interface NativeLogModule {
+  setLogHandler?(handler: ((records: NativeLogRecord[]) => void) | null, level?: string): void;
+}
+
+const loggers = new Map<string, Logger>();
+let installedModule: NativeLogModule | null = null;
+
+function loggerFor(source: string): Logger {
+  let logger = loggers.get(source);
+  if (!logger) {
+    logger = createLogger(`native:${source}`);
+    loggers.set(source, logger);
+  }
+  return logger;
+}
+
+function forward(records: NativeLogRecord[]): void {
+  for (const record of records) {
+    const logger = loggerFor(record.source);
+    const data = { nativeTime: new Date(record.time).toISOString() };
+    switch (record.level) {
+      case 0:
+        logger.debug(record.message, data);
+        break;
+      case 1:
+        logger.info(record.message, data);
+        break;
+      case 2:
+        logger.warn(record.message, data);
+        break;
+      default:
+        logger.error(record.message, undefined, data);
+        break;
+    }
+  }
+}
+
+/**
+ * Routes the addon's native log (AEC, capture, device changes) into
+ * createLogger. The addon filters by level before formatting anything on its
+ * audio threads, so it gets the JS logger's level. Once per loaded module.
+ */
+export function installNativeLogHandler(nativeModule: NativeLogModule): void {
+  if (installedModule === nativeModule || typeof nativeModule.setLogHandler !== 'function') {
+    return;
+  }
+  nativeModule.setLogHandler(forward, getLogLevel());
+  installedModule = nativeModule;
+}
@@ -0,0 +1,67 @@
+import { app } from 'electron';
+import { join } from 'path';
+import { existsSync, mkdirSync, readFileSync, writeFileSync } from 'fs';
+import { createLogger } from '../core/logger';
+import { EXPORT_CONFIG } from '../config/constants';
+import type { DeviceNoiseProfile, NoiseProfile } from './native/AECProcessor';
+
+const logger = createLogger('NoiseProfiles');
+
+// The background noise each mic last heard, so a session on it starts with
+// noise suppression and the speech floor already settled
+const PROFILES_FILE = 'noise-profiles.json';
+
+type ProfileMap = Record<string, NoiseProfile & { updatedAt: number }>;
+
+function profilesPath(): string {
+  return join(app.getPath('userData'), EXPORT_CONFIG.DATA_DIR, PROFILES_FILE);
+}
+
+function readProfiles(): ProfileMap {
+  const path = profilesPath();
+  if (!existsSync(path)) {
+    return {};
+  }
+  try {
+    return JSON.parse(readFileSync(path, 'utf8')) as ProfileMap;
+  } catch (error) {
+    logger.warn('Ignoring unreadable noise profiles', { error: (error as Error).message });
+    return {};
+  }
+}
+
+export function loadNoiseProfile(inputDeviceUid: string): NoiseProfile | null {
+  const profile = readProfiles()[inputDeviceUid];
+  if (!profile) {
+    return null;
+  }
+  const { noiseFloor, bandsDb, frames } = profile;
+  return { noiseFloor, bandsDb, frames };
+}
+
+/**
+ * Replaces the mic's stored profile with what this session heard: the room
+ * may have changed since, and the latest is the best guess for the next
+ * session. Profiles without an input UID are not stored.
+ */
+export function saveNoiseProfile(profile: DeviceNoiseProfile): void {
+  const { inputDeviceUid, noiseFloor, bandsDb, frames } = profile;
+  if (!inputDeviceUid) {
+    return;
+  }
+
+  const profiles = readProfiles();
+  profiles[inputDeviceUid] = { noiseFloor, bandsDb, frames, updatedAt: Date.now() };
+
+  try {
+    const path = profilesPath();
+    const dir = join(app.getPath('userData'), EXPORT_CONFIG.DATA_DIR);
+    if (!existsSync(dir)) {
+      mkdirSync(dir, { recursive: true });
+    }
+    writeFileSync(path, JSON.stringify(profiles, null, 2));
+    logger.info('Saved noise profile', { inputDeviceUid, noiseFloor, frames });
+  } catch (error) {
+    logger.warn('Failed to save noise profile', { error: (error as Error).message });
+  }
+}
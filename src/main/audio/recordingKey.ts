@@ -0,0 +1,61 @@
+import { app, safeStorage } from 'electron';
+import { randomBytes } from 'crypto';
+import { join } from 'path';
+import { existsSync, mkdirSync, readFileSync, writeFileSync } from 'fs';
+import { createLogger } from '../core/logger';
+import { EXPORT_CONFIG } from '../config/constants';
+import { loadNativeAddon } from '../utils/nativeAddon';
+
+const logger = createLogger('RecordingKey');
+
+// The AES-256 key native recordings are sealed with, wrapped by the OS
+// keychain (Keychain, DPAPI or libsecret through safeStorage) so the file
+// alone opens nothing
+const RECORDING_KEY_FILE = 'recording.key';
+const RECORDING_KEY_BYTES = 32;
+
+function dataDir(): string {
+  return join(app.getPath('userData'), EXPORT_CONFIG.DATA_DIR);
+}
+
+// The key, made on first use; null without OS encryption or when the
+// wrapped key will not open (another user, a reset keychain)
+export function loadRecordingKey(): Buffer | null {
+  if (!safeStorage.isEncryptionAvailable()) {
+    return null;
+  }
+  const path = join(dataDir(), RECORDING_KEY_FILE);
+  try {
+    if (existsSync(path)) {
+      const key = Buffer.from(safeStorage.decryptString(readFileSync(path)), 'base64');
+      return key.length === RECORDING_KEY_BYTES ? key : null;
+    }
+    const key = randomBytes(RECORDING_KEY_BYTES);
+    if (!existsSync(dataDir())) {
+      mkdirSync(dataDir(), { recursive: true });
+    }
+    writeFileSync(path, safeStorage.encryptString(key.toString('base64')), { mode: 0o600 });
+    logger.info('Created recording key');
+    return key;
+  } catch (error) {
+    logger.warn('Recording key unavailable', { error: (error as Error).message });
+    return null;
+  }
+}
+
+// Hands the key to the native recorder and readers, once the app is ready
+// (safeStorage needs it); false when there is no key or the addon predates
+// encryption, and recordings are then stored in the clear
+export function installRecordingKey(): boolean {
+  const module = loadNativeAddon();
+  if (!module || typeof module.setRecordingKey !== 'function') {
+    return false;
+  }
+  const key = loadRecordingKey();
+  if (!key) {
+    return false;
+  }
+  (module.setRecordingKey as (key: Uint8Array | null) => void)(new Uint8Array(key));
+  key.fill(0);
+  return true;
+}
@@ -0,0 +1,41 @@
+import { app } from 'electron';
+import { join } from 'path';
+import { existsSync, mkdirSync, readFileSync, writeFileSync } from 'fs';
+import { createLogger } from '../core/logger';
+import { EXPORT_CONFIG } from '../config/constants';
+
+const logger = createLogger('Voiceprint');
+
+// The user's enrolled voice, from AECProcessor.finishVoiceEnrollment(), for
+// the mic stream's verifyVoice option
+const VOICEPRINT_FILE = 'voiceprint.kkvp';
+
+function dataDir(): string {
+  return join(app.getPath('userData'), EXPORT_CONFIG.DATA_DIR);
+}
+
+export function loadVoiceprint(): Buffer | null {
+  const path = join(dataDir(), VOICEPRINT_FILE);
+  if (!existsSync(path)) {
+    return null;
+  }
+  try {
+    return readFileSync(path);
+  } catch (error) {
+    logger.warn('Ignoring unreadable voiceprint', { error: (error as Error).message });
+    return null;
+  }
+}
+
+export function saveVoiceprint(voiceprint: Uint8Array): void {
+  try {
+    const dir = dataDir();
+    if (!existsSync(dir)) {
+      mkdirSync(dir, { recursive: true });
+    }
+    writeFileSync(join(dir, VOICEPRINT_FILE), voiceprint);
+    logger.info('Saved voiceprint', { bytes: voiceprint.length });
+  } catch (error) {
+    logger.warn('Failed to save voiceprint', { error: (error as Error).message });
+  }
+}
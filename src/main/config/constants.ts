@@ -30,11 +30,60 @@ export const QUESTION_PATTERNS = [
   /^(do you know|can you tell|could you explain)/i,
 ];
 
+// The same questions as plain phrases for the native trigger matcher:
+// openers at the start of an utterance, '?' at its end
+export const QUESTION_TRIGGERS = {
+  STARTS_WITH: [
+    'what', 'where', 'when', 'why', 'how', 'who', 'which', 'can', 'could', 'would', 'should', 'is', 'are',
+    'do', 'does', 'did', 'have', 'has', 'will', 'tell me', 'explain', 'describe', 'clarify',
+  ],
+  ENDS_WITH: ['?'],
+} as const;
+
+// Keyset-paged meeting and people lists
+export const PAGE_CONFIG = {
+  DEFAULT_SIZE: 50,
+  MAX_SIZE: 200,
+} as const;
+
 // Callout service configuration
 export const CALLOUT_CONFIG = {
   MAX_CONTEXT_SEGMENTS: 50,
   MAX_PAST_MEETINGS: 3,
   MAX_KNOWLEDGE_RESULTS: 3,
+  /** Earlier parts of the meeting, past the recent segments, are indexed in windows this long */
+  MEETING_WINDOW_TOKENS: 200,
+  /** Sealed windows embedded in one request */
+  MEETING_EMBED_BATCH: 4,
+  MAX_EARLIER_WINDOWS: 3,
+} as const;
+
+// Knowledge-base ingestion and search
+export const KNOWLEDGE_CONFIG = {
+  /** text-embedding-3-small; the store is recreated if this changes */
+  EMBEDDING_DIMS: 1536,
+  /** Half the disk and page cache of float32, no change in ranking */
+  QUANTIZATION: 'float16' as const,
+  STORE_FILE: 'knowledge.kkev',
+  MANIFEST_FILE: 'knowledge.manifest',
+  /** Embeddings by text, for prep and callouts that embed the same text again */
+  CACHE_FILE: 'embedding-cache.kkev',
+  CACHE_ENTRIES: 20000,
+  /** Hybrid (vector + BM25) retrieval gives up on a search still going after this */
+  RETRIEVAL_BUDGET_MS: 20,
+  /** One embeddings request per batch */
+  BATCH_CHUNKS: 64,
+  MAX_IN_FLIGHT: 4,
+} as const;
+
+// Prompt token budgets, counted with the cl100k_base tokenizer
+export const PROMPT_CONFIG = {
+  /** Looked for in the data directory; without it token counts are estimated */
+  TOKENIZER_RANKS_FILE: 'cl100k_base.tiktoken',
+  /** Note generation leaves room for the instructions and the 2000-token answer */
+  MAX_TRANSCRIPT_TOKENS: 100000,
+  /** The most recent conversation a callout sees */
+  MAX_CALLOUT_CONTEXT_TOKENS: 4000,
 } as const;
 
 // Callout timer configuration (attention detection)
@@ -48,10 +97,157 @@ export const CALLOUT_TIMER_CONFIG = {
 // Audio configuration
 export const AUDIO_CONFIG = {
   SAMPLE_RATE: 48000,
+  /** Native mic stream is resampled to this before transcription */
+  MIC_SAMPLE_RATE: 16000,
   CHUNK_DURATION_MS: 256,
   CHANNELS: 1 as const,
   BIT_DEPTH: 16 as const,
   PACKET_LOG_INTERVAL: 100, // Log every N packets
+  /**
+   * Native mic engine outside voice processing: 'hal' converts in the addon,
+   * 'auhal' in CoreAudio. The stop log's mic.cpuMsPerSecond compares them.
+   */
+  MIC_ENGINE: 'hal' as 'hal' | 'auhal',
+  /** Multi-mic input devices are beamformed natively ahead of AEC */
+  MIC_BEAMFORM: true,
+} as const;
+
+// Native silence gate on the mic stream (RNN VAD, 10ms frames)
+export const SILENCE_GATE_CONFIG = {
+  ENABLED: true,
+  /** VAD speech probability that opens the gate */
+  THRESHOLD: 0.5,
+  /** Non-speech kept after speech ends, so word tails are not clipped */
+  HANGOVER_MS: 500,
+  /** Audio replayed before each speech onset */
+  PREROLL_MS: 200,
+  /** While gated, a silence marker is delivered this often (keeps sockets alive) */
+  SILENCE_MARKER_MS: 2000,
+  /** Keystrokes are ducked ahead of the VAD, so typing neither opens the gate nor reaches ASR */
+  DECLICK: true,
+} as const;
+
+// Native utterance endpointing on system audio
+export const ENDPOINT_CONFIG = {
+  ENABLED: true,
+  /** VAD speech probability that counts as speech */
+  THRESHOLD: 0.5,
+  /** Speech needed to start an utterance; shorter bursts are ignored */
+  MIN_SPEECH_MS: 150,
+  /** Silence that ends an utterance */
+  TRAILING_SILENCE_MS: 500,
+  /** A final arriving later than this after an utterance end is not timed from it */
+  MAX_FINAL_LAG_MS: 3000,
+  /** Track pitch natively so 'end' markers carry the utterance's intonation */
+  PROSODY: true,
+  /** Rising-intonation likelihood at an utterance end that counts as a question */
+  QUESTION_LIKELIHOOD: 0.6,
+} as const;
+
+// Speech/music/noise classification of system audio, one label per second
+export const AUDIO_CLASS_CONFIG = {
+  ENABLED: true,
+  /** Withhold music and noise from transcription; the AEC and meters still get it */
+  GATE_UPLOAD: true,
+  /**
+   * Withheld audio kept to send ahead of speech resuming, since a second is
+   * labelled only once it ends
+   */
+  PREROLL_MS: 1000,
+} as const;
+
+// The macOS system tap: only meeting apps' output, so notification sounds and
+// music elsewhere stay out of the AEC reference and the transcript. Browsers
+// are listed for Meet and other web calls; Safari plays through WebKit.
+export const SYSTEM_TAP_CONFIG = {
+  MEETING_APPS_ONLY: true,
+  MEETING_APPS: [
+    'us.zoom.xos',
+    'com.microsoft.teams',
+    'com.cisco.webexmeetingsapp',
+    'com.apple.FaceTime',
+    'com.tinyspeck.slackmacgap',
+    'com.hnc.Discord',
+    'com.google.Chrome',
+    'com.microsoft.edgemac',
+    'company.thebrowser.Browser',
+    'com.brave.Browser',
+    'org.mozilla.firefox',
+    'com.apple.WebKit',
+  ],
+} as const;
+
+// Ad-hoc calls: a standby monitor on the meeting apps' output prompts to
+// record when sustained conversation starts without a calendar event
+export const MEETING_DETECTION_CONFIG = {
+  ENABLED: true,
+  /** Don't prompt again sooner than this after a dismissed prompt */
+  PROMPT_COOLDOWN_MS: 10 * 60 * 1000,
+} as const;
+
+// Native speaker turns on system audio: local IDs per second, ahead of any cloud diarization
+export const SPEAKER_CONFIG = {
+  ENABLED: true,
+  /** Seconds of speaker IDs kept for attributing late finals */
+  HISTORY_SECONDS: 300,
+} as const;
+
+// On-device transcription (the 'local' provider)
+export const LOCAL_ASR_CONFIG = {
+  /** Under userData when no model path is set */
+  MODELS_DIR: 'models',
+  DEFAULT_MODEL: 'ggml-base.en-q5_1.bin',
+  /** A partial after this much new audio in an utterance */
+  STEP_MS: 1000,
+  /** Longer utterances are cut and finalized */
+  MAX_UTTERANCE_MS: 15000,
+} as const;
+
+// Capture in a helper utilityProcess (AudioEngineHost, settings.isolatedCapture), delivering
+// through shared memory rings
+export const AUDIO_ENGINE_CONFIG = {
+  /** Built beside the main bundle from src/main/audio/engine/audioEngine.ts */
+  ENTRY: 'audioEngine.js',
+  /** Audio each stream's ring holds while the main process is busy */
+  RING_SECONDS: 4,
+  /** How often the main process drains the rings */
+  POLL_MS: 20,
+  /** A control request the engine has not answered by then fails */
+  REQUEST_TIMEOUT_MS: 10000,
+} as const;
+
+// Neural noise suppression on the mic (settings.neuralDenoise)
+export const LOCAL_DENOISE_CONFIG = {
+  /** Under userData's LOCAL_ASR_CONFIG.MODELS_DIR when no path is set */
+  DEFAULT_MODEL: 'denoise.kkdn',
+} as const;
+
+// On-device spotting of the callout keywords on system audio (settings.keywordSpotting)
+export const KEYWORD_SPOTTING_CONFIG = {
+  /** Under userData's LOCAL_ASR_CONFIG.MODELS_DIR */
+  DEFAULT_MODEL: 'keywords.kkkw',
+  /** Geometric mean of a keyword's token peaks it needs to fire */
+  THRESHOLD: 0.5,
+  /** Context prefetched for a spotted keyword waits this long for its callout */
+  CONTEXT_TTL_MS: 30000,
+} as const;
+
+// Mic speaker verification against the user's voiceprint (settings.verifyMicSpeaker)
+export const VOICE_VERIFY_CONFIG = {
+  /** Speech the first recording enrolls before it keeps the voiceprint (natively at least 15s) */
+  ENROLL_SECONDS: 20,
+  /** How often that recording checks on the enrollment */
+  ENROLL_POLL_MS: 5000,
+} as const;
+
+// Re-transcribing a stored recording once the meeting ends
+export const BATCH_TRANSCRIPTION_CONFIG = {
+  /** Segments, cut at pauses, aim for this length */
+  TARGET_SEGMENT_MS: 60000,
+  /** Uploads in flight at once; the native split runs ahead of them */
+  CONCURRENCY: 4,
+  /** Under userData, removed once the pass is done */
+  WORK_DIR: 'retranscribe',
 } as const;
 
 // Acoustic Echo Cancellation configuration (WebRTC AEC3)
@@ -66,10 +262,55 @@ export const AEC_CONFIG = {
   METRICS_INTERVAL_FRAMES: 100,
 } as const;
 
+// Native meeting recordings, one directory per meeting under userData
+export const RECORDING_CONFIG = {
+  DIR: 'recordings',
+  /** File prefix: <NAME>.<track>.<n>.wav and <NAME>.<track>.idx */
+  NAME: 'meeting',
+} as const;
+
 // Export configuration
 export const EXPORT_CONFIG = {
   EXPORT_DIR: 'exports',
   DATA_DIR: 'data',
+  /** Audio clips shared from a meeting, centred on the moment picked */
+  CLIP_DURATION_MS: 30_000,
+} as const;
+
+// Matching meeting participants to CRM contacts
+export const CRM_MATCH_CONFIG = {
+  /** Contacts fetched for name matching, and how long they are reused */
+  MAX_DIRECTORY_CONTACTS: 20000,
+  DIRECTORY_TTL_MS: 15 * 60 * 1000,
+  /** A name match must score this, and lead the runner-up by the margin */
+  MIN_NAME_SCORE: 0.9,
+  MIN_NAME_MARGIN: 0.03,
+} as const;
+
+// Native performance reports stored with each meeting
+export const PERFORMANCE_CONFIG = {
+  /** Metrics sampling period over a recording */
+  INTERVAL_MS: 1000,
+  /** A metric's mean this much worse than the baseline version's is a regression */
+  REGRESSION_THRESHOLD: 0.2,
+  /** Metrics (by name suffix) where higher is better */
+  HIGHER_IS_BETTER: ['echoReturnLossEnhancement', 'echoReturnLoss', 'aecConverged'],
+  /** Signed metrics whose size alone matters */
+  MAGNITUDE_ONLY: ['renderDriftPpm'],
+} as const;
+
+// Compressed archival of old transcripts
+export const ARCHIVE_CONFIG = {
+  /** Meetings created longer ago than this are archived at startup */
+  AFTER_DAYS: 90,
+  /** Segments needed before the first dictionary is trained */
+  MIN_TRAINING_SEGMENTS: 1000,
+  MAX_TRAINING_SEGMENTS: 20000,
+  /** zstd dictionary capacity; deflate's is its 32 KB window */
+  DICTIONARY_BYTES: 64 * 1024,
+  ZSTD_LEVEL: 19,
+  /** Meetings per transaction */
+  BATCH_MEETINGS: 20,
 } as const;
 
 export function matchesQuestionPattern(text: string): boolean {
@@ -1,4 +1,10 @@
-import { MeetingRepository, CalloutRepository, SettingsRepository, PeopleRepository } from '../data/repositories';
+import {
+  MeetingRepository,
+  CalloutRepository,
+  SettingsRepository,
+  PeopleRepository,
+  PerformanceRepository,
+} from '../data/repositories';
 import { OpenAIProvider } from '../providers/OpenAIProvider';
 import { GeminiProvider } from '../providers/GeminiProvider';
 import { createLogger } from './logger';
@@ -9,6 +15,8 @@ import { HubSpotService } from '../services/HubSpotService';
 import { SalesforceService } from '../services/SalesforceService';
 import { MeetingNotificationService } from '../services/MeetingNotificationService';
 import { PrepService } from '../services/PrepService';
+import { KnowledgeService } from '../services/KnowledgeService';
+import { TriggerService } from '../services/TriggerService';
 
 const logger = createLogger('Container');
 
@@ -17,6 +25,7 @@ export interface AppContainer {
   calloutRepo: CalloutRepository;
   settingsRepo: SettingsRepository;
   peopleRepo: PeopleRepository;
+  performanceRepo: PerformanceRepository;
   aiProvider: OpenAIProvider | GeminiProvider | null;
   calendarService: CalendarService;
   calloutService: CalloutService;
@@ -25,6 +34,8 @@ export interface AppContainer {
   salesforceService: SalesforceService;
   meetingNotificationService: MeetingNotificationService;
   prepService: PrepService;
+  knowledgeService: KnowledgeService;
+  triggerService: TriggerService;
 }
 
 let container: AppContainer | null = null;
@@ -35,6 +46,7 @@ export function initializeContainer(): AppContainer {
   const calloutRepo = new CalloutRepository();
   const settingsRepo = new SettingsRepository();
   const peopleRepo = new PeopleRepository();
+  const performanceRepo = new PerformanceRepository();
   const calendarService = new CalendarService(settingsRepo);
   
   // Inject peopleRepo into meetingRepo for attendee syncing
@@ -116,11 +128,18 @@ export function initializeContainer(): AppContainer {
   // Initialize prep service
   const prepService = new PrepService();
 
+  // Initialize knowledge base service; reads the OpenAI key at each use
+  const knowledgeService = new KnowledgeService(() => settingsRepo.getSettings());
+
+  // Initialize question and keyword detection; follows the keyword setting
+  const triggerService = new TriggerService(() => settingsRepo.getSettings());
+
   container = {
     meetingRepo,
     calloutRepo,
     settingsRepo,
     peopleRepo,
+    performanceRepo,
     aiProvider,
     calendarService,
     calloutService,
@@ -129,6 +148,8 @@ export function initializeContainer(): AppContainer {
     salesforceService,
     meetingNotificationService,
     prepService,
+    knowledgeService,
+    triggerService,
   };
 
   logger.info('Container initialized');
@@ -1,4 +1,5 @@
-import initSqlJs, { Database as SqlJsDatabase } from 'sql.js';
+import initSqlJs, { BindParams, Database as SqlJsDatabase, QueryExecResult } from 'sql.js';
+import bindings from 'bindings';
 import { app } from 'electron';
 import { join } from 'path';
 import { existsSync, mkdirSync, writeFileSync, readFileSync } from 'fs';
@@ -7,8 +8,91 @@ import { EXPORT_CONFIG } from '../config/constants';
 
 const logger = createLogger('Database');
 
-let db: SqlJsDatabase | null = null;
+/**
+ * The subset of sql.js's Database the repositories use. The native engine
+ * (native/src/sqlite_addon.cc) implements the same calls with the same
+ * result shapes, so either can sit behind getDatabase().
+ */
+export interface Database {
+  run(sql: string, params?: BindParams): unknown;
+  exec(sql: string, params?: BindParams): QueryExecResult[];
+  close(): void;
+}
+
+/** The native engine's calls beyond sql.js's */
+interface NativeDatabase extends Database {
+  upsertMany(updateSql: string, insertSql: string, rows: BindParams[]): UpsertCounts;
+}
+
+export interface UpsertCounts {
+  inserted: number;
+  updated: number;
+}
+
+interface NativeWriteQueue {
+  enqueue(sql: string, params?: BindParams): void;
+  flush(): Promise<void>;
+  getStats(): { queued: number; committed: number; failed: number; pending: number; lastError?: string };
+  close(): void;
+}
+
+export interface NativeTranscriptCodec {
+  compress(data: Uint8Array): Uint8Array;
+  decompress(data: Uint8Array): Uint8Array;
+}
+
+/** zstd for archived transcripts; hasZstd is false in builds without libzstd */
+export interface NativeTranscriptCodecModule {
+  hasZstd: boolean;
+  TranscriptCodec: new (dictionary?: Uint8Array, level?: number) => NativeTranscriptCodec;
+  trainTranscriptDictionary(samples: string[], capacity: number): Uint8Array;
+}
+
+interface NativeSqliteModule extends Partial<NativeTranscriptCodecModule> {
+  Database: new (path: string) => NativeDatabase;
+  WriteQueue: new (path: string, options?: { intervalMs?: number; maxRows?: number }) => NativeWriteQueue;
+}
+
+// Write-behind batching for rows the live meeting path appends
+const WRITE_QUEUE_INTERVAL_MS = 250;
+const WRITE_QUEUE_MAX_ROWS = 64;
+
+let db: Database | null = null;
 let dbPath: string = '';
+// True when db is the native WAL engine: every statement is already on
+// disk, and saveDatabase() has nothing to do
+let isNative = false;
+let writeQueue: NativeWriteQueue | null = null;
+let nativeModule: NativeSqliteModule | null = null;
+
+function loadNativeSqlite(): NativeSqliteModule | null {
+  try {
+    return bindings('kakarot_sqlite') as NativeSqliteModule;
+  } catch {
+    // bindings() looks under the app's root; the addon builds in native/
+  }
+  const candidates = [
+    join(__dirname, 'kakarot_sqlite.node'),
+    join(process.cwd(), 'native/build/Release/kakarot_sqlite.node'),
+  ];
+  if (process.resourcesPath) {
+    candidates.push(
+      join(process.resourcesPath, 'app/native/build/Release/kakarot_sqlite.node'),
+      join(process.resourcesPath, 'native/build/Release/kakarot_sqlite.node'),
+      join(process.resourcesPath, 'kakarot_sqlite.node')
+    );
+  }
+  for (const candidate of candidates) {
+    if (!existsSync(candidate)) continue;
+    try {
+      // eslint-disable-next-line @typescript-eslint/no-require-imports
+      return require(candidate) as NativeSqliteModule;
+    } catch (error) {
+      logger.warn('Failed to load native SQLite', { path: candidate, error: (error as Error).message });
+    }
+  }
+  return null;
+}
 
 export async function initializeDatabase(): Promise<void> {
   const userDataPath = app.getPath('userData');
@@ -21,40 +105,144 @@ export async function initializeDatabase(): Promise<void> {
 
   dbPath = join(dataDir, 'meetings.db');
 
-  const SQL = await initSqlJs();
-
-  if (existsSync(dbPath)) {
-    const fileBuffer = readFileSync(dbPath);
-    db = new SQL.Database(fileBuffer);
-    logger.info('Loaded existing database', { path: dbPath });
+  // The native engine opens the file sql.js wrote as it is and switches it
+  // to WAL; sql.js remains for builds without the addon
+  const native = loadNativeSqlite();
+  nativeModule = native;
+  if (native) {
+    const existed = existsSync(dbPath);
+    db = new native.Database(dbPath);
+    isNative = true;
+    writeQueue = new native.WriteQueue(dbPath, {
+      intervalMs: WRITE_QUEUE_INTERVAL_MS,
+      maxRows: WRITE_QUEUE_MAX_ROWS,
+    });
+    logger.info(existed ? 'Loaded existing database' : 'Created new database', { path: dbPath, engine: 'native' });
   } else {
-    db = new SQL.Database();
-    logger.info('Created new database', { path: dbPath });
+    const SQL = await initSqlJs();
+
+    if (existsSync(dbPath)) {
+      const fileBuffer = readFileSync(dbPath);
+      db = new SQL.Database(fileBuffer);
+      logger.info('Loaded existing database', { path: dbPath, engine: 'sql.js' });
+    } else {
+      db = new SQL.Database();
+      logger.info('Created new database', { path: dbPath, engine: 'sql.js' });
+    }
   }
 
   createTables();
   saveDatabase();
 }
 
-export function getDatabase(): SqlJsDatabase {
+export function getDatabase(): Database {
   if (!db) {
     throw new Error('Database not initialized. Call initializeDatabase() first.');
   }
   return db;
 }
 
+/**
+ * Persists pending writes. The native engine commits each statement, or
+ * each transaction, to its write-ahead log as it runs, so this is a no-op
+ * there; under sql.js it exports and rewrites the whole file.
+ */
 export function saveDatabase(): void {
-  if (!db) return;
-  const data = db.export();
+  if (!db || isNative) return;
+  const data = (db as SqlJsDatabase).export();
   const buffer = Buffer.from(data);
   writeFileSync(dbPath, buffer);
 }
 
+/**
+ * Queues a write for the background writer, which commits it with its
+ * neighbours in one transaction within WRITE_QUEUE_INTERVAL_MS. The caller
+ * never waits on disk; reads see the row once it commits, so anything that
+ * must read it back calls flushWrites() first. Runs at once under sql.js.
+ */
+export function enqueueWrite(sql: string, params?: BindParams): void {
+  if (writeQueue) {
+    writeQueue.enqueue(sql, params);
+    return;
+  }
+  getDatabase().run(sql, params);
+  saveDatabase();
+}
+
+/**
+ * Each row through `updateSql` and, where that matched nothing, through
+ * `insertSql`, all in one transaction with each statement prepared once.
+ * Rows bind by name (`{ ':email': ... }`), so both statements take the
+ * same row. The native engine runs the whole batch in one call; sql.js
+ * steps prepared statements and exports the file once at the end.
+ */
+export function upsertMany(updateSql: string, insertSql: string, rows: BindParams[]): UpsertCounts {
+  const database = getDatabase();
+  if (rows.length === 0) return { inserted: 0, updated: 0 };
+  if (isNative) {
+    return (database as NativeDatabase).upsertMany(updateSql, insertSql, rows);
+  }
+
+  const sqlJs = database as SqlJsDatabase;
+  const update = sqlJs.prepare(updateSql);
+  const insert = sqlJs.prepare(insertSql);
+  const counts = { inserted: 0, updated: 0 };
+  beginTransaction();
+  try {
+    for (const row of rows) {
+      update.run(row);
+      if (sqlJs.getRowsModified() > 0) {
+        counts.updated++;
+        continue;
+      }
+      insert.run(row);
+      if (sqlJs.getRowsModified() > 0) counts.inserted++;
+    }
+    commitTransaction();
+  } catch (error) {
+    rollbackTransaction();
+    throw error;
+  } finally {
+    update.free();
+    insert.free();
+  }
+  return counts;
+}
+
+/** The native zstd codec, when the engine is native and was built with it */
+export function getTranscriptCodecModule(): NativeTranscriptCodecModule | null {
+  if (!nativeModule?.hasZstd || !nativeModule.TranscriptCodec || !nativeModule.trainTranscriptDictionary) {
+    return null;
+  }
+  return nativeModule as NativeTranscriptCodecModule;
+}
+
+/** Resolves once every write queued so far is committed */
+export async function flushWrites(): Promise<void> {
+  if (!writeQueue) return;
+  try {
+    await writeQueue.flush();
+  } catch (error) {
+    logger.error('Queued writes failed to commit', { error: (error as Error).message });
+    return;
+  }
+  const stats = writeQueue.getStats();
+  if (stats.failed > 0) {
+    logger.warn('Queued writes were rejected', { failed: stats.failed, lastError: stats.lastError });
+  }
+}
+
 export function closeDatabase(): void {
+  if (writeQueue) {
+    // Commits what is still queued before the main connection closes
+    writeQueue.close();
+    writeQueue = null;
+  }
   if (db) {
     saveDatabase();
     db.close();
     db = null;
+    isNative = false;
     logger.info('Database closed');
   }
 }
@@ -95,6 +283,8 @@ function createTables(): void {
     { name: 'people', def: "TEXT DEFAULT '[]'" },
     { name: 'note_entries', def: "TEXT DEFAULT '[]'" },
     { name: 'attendee_emails', def: "TEXT DEFAULT '[]'" },
+    { name: 'recording_index', def: 'TEXT' },
+    { name: 'recording_started_at', def: 'INTEGER' },
   ];
   for (const col of newCols) {
     if (!existingCols.includes(col.name)) {
@@ -117,6 +307,13 @@ function createTables(): void {
     )
   `);
 
+  // Migration: per-word timings, from the provider and forced alignment
+  const segmentColumns = db.exec('PRAGMA table_info(transcript_segments)');
+  if (segmentColumns.length > 0 && !segmentColumns[0].values.some((row) => row[1] === 'words')) {
+    db.run(`ALTER TABLE transcript_segments ADD COLUMN words TEXT DEFAULT '[]'`);
+    logger.info('Added column to transcript_segments table', { column: 'words' });
+  }
+
   db.run(`
     CREATE TABLE IF NOT EXISTS people (
       email TEXT PRIMARY KEY,
@@ -152,12 +349,164 @@ function createTables(): void {
     )
   `);
 
+  // Text of the knowledge-base chunks whose vectors are in the embedding store
+  db.run(`
+    CREATE TABLE IF NOT EXISTS knowledge_chunks (
+      id TEXT PRIMARY KEY,
+      path TEXT NOT NULL,
+      chunk_index INTEGER NOT NULL,
+      text TEXT NOT NULL
+    )
+  `);
+
+  // Transcripts of old meetings, compressed one blob per meeting; their
+  // transcript_segments rows are deleted (see transcriptArchive.ts)
+  db.run(`
+    CREATE TABLE IF NOT EXISTS transcript_dictionaries (
+      id INTEGER PRIMARY KEY,
+      codec TEXT NOT NULL,
+      dictionary BLOB NOT NULL,
+      created_at INTEGER NOT NULL
+    )
+  `);
+  db.run(`
+    CREATE TABLE IF NOT EXISTS transcript_archives (
+      id INTEGER PRIMARY KEY,
+      meeting_id TEXT NOT NULL UNIQUE,
+      dictionary_id INTEGER NOT NULL,
+      segment_count INTEGER NOT NULL,
+      raw_bytes INTEGER NOT NULL,
+      data BLOB NOT NULL,
+      archived_at INTEGER NOT NULL,
+      FOREIGN KEY (meeting_id) REFERENCES meetings(id) ON DELETE CASCADE
+    )
+  `);
+
+  // A meeting's native performance report, whole, and its metrics one row
+  // each so meetings and app versions compare in SQL
+  db.run(`
+    CREATE TABLE IF NOT EXISTS meeting_performance (
+      meeting_id TEXT PRIMARY KEY,
+      app_version TEXT NOT NULL,
+      platform TEXT NOT NULL,
+      recorded_at INTEGER NOT NULL,
+      report TEXT NOT NULL,
+      FOREIGN KEY (meeting_id) REFERENCES meetings(id) ON DELETE CASCADE
+    )
+  `);
+  db.run(`
+    CREATE TABLE IF NOT EXISTS meeting_performance_metrics (
+      meeting_id TEXT NOT NULL,
+      metric TEXT NOT NULL,
+      value REAL NOT NULL,
+      PRIMARY KEY (meeting_id, metric),
+      FOREIGN KEY (meeting_id) REFERENCES meetings(id) ON DELETE CASCADE
+    )
+  `);
+
   db.run(`CREATE INDEX IF NOT EXISTS idx_segments_meeting ON transcript_segments(meeting_id)`);
   db.run(`CREATE INDEX IF NOT EXISTS idx_callouts_meeting ON callouts(meeting_id)`);
+  // List pages walk these in order from a cursor. The meetings one holds
+  // every column a list row shows, so a page never reads the table's notes
+  // and summaries; people rows are small enough to read whole.
+  db.run(
+    `CREATE INDEX IF NOT EXISTS idx_meetings_list
+       ON meetings(created_at, id, title, ended_at, duration, attendee_emails)`
+  );
+  db.run(`CREATE INDEX IF NOT EXISTS idx_people_last_seen ON people(last_meeting_at, email)`);
+  db.run(`CREATE INDEX IF NOT EXISTS idx_performance_version ON meeting_performance(app_version, recorded_at)`);
+  db.run(`CREATE INDEX IF NOT EXISTS idx_performance_metric ON meeting_performance_metrics(metric, meeting_id, value)`);
+
+  createSearchIndex();
 
   logger.debug('Database tables created/verified');
 }
 
+let fullTextSearch = false;
+
+/** Whether the FTS5 search index exists; search falls back to LIKE without it */
+export function hasFullTextSearch(): boolean {
+  return fullTextSearch;
+}
+
+/**
+ * FTS5 indexes over transcript text and meeting titles. They are external
+ * content tables, so the text is stored once, and triggers keep them in step
+ * with every insert, update and delete. INSERT OR REPLACE does not fire
+ * delete triggers (recursive_triggers stays off), so a BEFORE INSERT trigger
+ * drops the row being replaced. An index created over existing data is
+ * rebuilt once.
+ */
+function createSearchIndex(): void {
+  if (!db) throw new Error('Database not initialized');
+
+  const existing = db.exec(
+    "SELECT name FROM sqlite_master WHERE type = 'table' AND name IN ('transcript_fts', 'meeting_fts')"
+  );
+  const existingNames = existing.length > 0 ? existing[0].values.map((row) => row[0] as string) : [];
+
+  try {
+    db.run(`
+      CREATE VIRTUAL TABLE IF NOT EXISTS transcript_fts USING fts5(
+        text, content='transcript_segments', content_rowid='rowid',
+        tokenize='unicode61 remove_diacritics 2'
+      )
+    `);
+    db.run(`
+      CREATE VIRTUAL TABLE IF NOT EXISTS meeting_fts USING fts5(
+        title, content='meetings', content_rowid='rowid',
+        tokenize='unicode61 remove_diacritics 2'
+      )
+    `);
+    // Archived segments, indexed without their text (which is only in the
+    // archive blob); rowid is archive id * ARCHIVE_ROWID_STRIDE + segment
+    db.run(`
+      CREATE VIRTUAL TABLE IF NOT EXISTS archive_fts USING fts5(
+        text, content='',
+        tokenize='unicode61 remove_diacritics 2'
+      )
+    `);
+  } catch (error) {
+    logger.warn('FTS5 unavailable; search scans transcripts', { error: (error as Error).message });
+    fullTextSearch = false;
+    return;
+  }
+
+  const triggers: Array<[table: string, index: string, column: string, key: string]> = [
+    ['transcript_segments', 'transcript_fts', 'text', 'id'],
+    ['meetings', 'meeting_fts', 'title', 'id'],
+  ];
+  for (const [table, index, column, key] of triggers) {
+    db.run(`
+      CREATE TRIGGER IF NOT EXISTS ${index}_replace BEFORE INSERT ON ${table} BEGIN
+        INSERT INTO ${index}(${index}, rowid, ${column})
+          SELECT 'delete', rowid, ${column} FROM ${table} WHERE ${key} = new.${key};
+      END
+    `);
+    db.run(`
+      CREATE TRIGGER IF NOT EXISTS ${index}_insert AFTER INSERT ON ${table} BEGIN
+        INSERT INTO ${index}(rowid, ${column}) VALUES (new.rowid, new.${column});
+      END
+    `);
+    db.run(`
+      CREATE TRIGGER IF NOT EXISTS ${index}_delete AFTER DELETE ON ${table} BEGIN
+        INSERT INTO ${index}(${index}, rowid, ${column}) VALUES ('delete', old.rowid, old.${column});
+      END
+    `);
+    db.run(`
+      CREATE TRIGGER IF NOT EXISTS ${index}_update AFTER UPDATE OF ${column} ON ${table} BEGIN
+        INSERT INTO ${index}(${index}, rowid, ${column}) VALUES ('delete', old.rowid, old.${column});
+        INSERT INTO ${index}(rowid, ${column}) VALUES (new.rowid, new.${column});
+      END
+    `);
+    if (!existingNames.includes(index)) {
+      db.run(`INSERT INTO ${index}(${index}) VALUES ('rebuild')`);
+      logger.info('Built search index', { index });
+    }
+  }
+  fullTextSearch = true;
+}
+
 // Transaction management
 let transactionDepth = 0;
 
@@ -1,13 +1,13 @@
-import { getDatabase, saveDatabase } from '../database';
+import { enqueueWrite, getDatabase, resultToObjectByIndex } from '../database';
 import type { Callout } from '@shared/types';
 import { createLogger } from '../../core/logger';
 
 const logger = createLogger('CalloutRepository');
 
 export class CalloutRepository {
+  /** Queued with the transcript; see enqueueWrite() */
   save(callout: Callout): void {
-    const db = getDatabase();
-    db.run(
+    enqueueWrite(
       `INSERT INTO callouts
        (id, meeting_id, triggered_at, question, context, suggested_response, sources, dismissed)
        VALUES (?, ?, ?, ?, ?, ?, ?, ?)`,
@@ -22,14 +22,34 @@ export class CalloutRepository {
         callout.dismissed ? 1 : 0,
       ]
     );
-    saveDatabase();
     logger.debug('Saved callout', { id: callout.id, question: callout.question.slice(0, 50) });
   }
 
+  /** The meeting's callouts, oldest first */
+  findByMeeting(meetingId: string): Callout[] {
+    const result = getDatabase().exec('SELECT * FROM callouts WHERE meeting_id = ? ORDER BY triggered_at', [
+      meetingId,
+    ]);
+    if (result.length === 0) return [];
+
+    return result[0].values.map((_, i) => {
+      const row = resultToObjectByIndex(result[0], i);
+      return {
+        id: row.id as string,
+        meetingId: row.meeting_id as string,
+        triggeredAt: new Date(row.triggered_at as number),
+        question: row.question as string,
+        context: row.context as string,
+        suggestedResponse: row.suggested_response as string,
+        sources: JSON.parse((row.sources as string) || '[]'),
+        dismissed: row.dismissed === 1,
+      };
+    });
+  }
+
   dismiss(id: string): void {
-    const db = getDatabase();
-    db.run('UPDATE callouts SET dismissed = 1 WHERE id = ?', [id]);
-    saveDatabase();
+    // Behind the callout's own insert, which may still be queued
+    enqueueWrite('UPDATE callouts SET dismissed = 1 WHERE id = ?', [id]);
     logger.debug('Dismissed callout', { id });
   }
 }
@@ -1,7 +1,25 @@
 import { v4 as uuidv4 } from 'uuid';
-import { getDatabase, saveDatabase, resultToObject, resultToObjectByIndex } from '../database';
-import type { Meeting, TranscriptSegment, CalendarAttendee } from '@shared/types';
+import {
+  getDatabase,
+  saveDatabase,
+  enqueueWrite,
+  flushWrites,
+  hasFullTextSearch,
+  resultToObject,
+  resultToObjectByIndex,
+} from '../database';
+import type {
+  Meeting,
+  MeetingListPage,
+  MeetingPageCursor,
+  MeetingSearchHit,
+  SearchSnippet,
+  TranscriptSegment,
+  CalendarAttendee,
+} from '@shared/types';
 import { createLogger } from '../../core/logger';
+import { PAGE_CONFIG } from '../../config/constants';
+import { ARCHIVE_ROWID_STRIDE, dropArchive, readArchiveById, readArchivedSegments } from '../transcriptArchive';
 import { PeopleRepository } from './PeopleRepository';
 
 const logger = createLogger('MeetingRepository');
@@ -10,6 +28,59 @@ const logger = createLogger('MeetingRepository');
 let currentMeetingId: string | null = null;
 let meetingStartTime: number | null = null;
 
+// Full-text search: how many matching segments are ranked at most, how many
+// are kept per meeting, and how much a title match outweighs one in speech
+const SEARCH_MAX_SEGMENT_HITS = 5000;
+const SEARCH_SNIPPETS_PER_MEETING = 3;
+const SEARCH_TITLE_WEIGHT = 2;
+// Markers highlight() and snippet() put around matched terms
+const MATCH_OPEN = '\u0002';
+const MATCH_CLOSE = '\u0003';
+
+/** Every word of |query| as a prefix term, all required; null when it has none */
+function toFtsQuery(query: string): string | null {
+  const terms = query.match(/[\p{L}\p{N}_]+/gu);
+  if (!terms) return null;
+  return terms.map((term) => `"${term}"*`).join(' ');
+}
+
+// snippet() for an archived segment, whose text the contentless index lacks:
+// a window of words around the first that starts with a query term
+function markTerms(text: string, query: string): string {
+  const terms = (query.match(/[\p{L}\p{N}_]+/gu) ?? []).map((term) => term.toLowerCase());
+  const words = text.split(/(\s+)/);
+  const isHit = (word: string): boolean => {
+    const bare = word.replace(/^[^\p{L}\p{N}_]+/u, '').toLowerCase();
+    return terms.some((term) => bare.startsWith(term));
+  };
+  const first = words.findIndex((word, i) => i % 2 === 0 && isHit(word));
+  // Even indexes are words, odd ones the whitespace between
+  const from = Math.max(0, first - 2 * 8) & ~1;
+  const to = Math.min(words.length, from + 2 * 24 - 1);
+  let marked = from > 0 ? '…' : '';
+  for (let i = from; i < to; i++) {
+    marked += i % 2 === 0 && isHit(words[i]) ? `${MATCH_OPEN}${words[i]}${MATCH_CLOSE}` : words[i];
+  }
+  return to < words.length ? `${marked}…` : marked;
+}
+
+function unmark(marked: string): SearchSnippet {
+  const highlights: Array<[number, number]> = [];
+  let text = '';
+  let start = -1;
+  for (const ch of marked) {
+    if (ch === MATCH_OPEN) {
+      start = text.length;
+    } else if (ch === MATCH_CLOSE) {
+      if (start >= 0) highlights.push([start, text.length]);
+      start = -1;
+    } else {
+      text += ch;
+    }
+  }
+  return { text, highlights };
+}
+
 export class MeetingRepository {
   private peopleRepo?: PeopleRepository;
   private peopleApiFetcher?: (email: string) => Promise<string | null>;
@@ -77,29 +148,11 @@ export class MeetingRepository {
 
     logger.info('Starting background attendee upsert', { count: attendees.length });
 
-    for (const attendee of attendees) {
-      if (typeof attendee === 'object') {
-        try {
-          await this.peopleRepo.upsertFromCalendarAttendee(
-            attendee.email,
-            attendee.name,
-            undefined,
-            this.peopleApiFetcher
-          );
-          logger.debug('Upserted attendee in background', {
-            email: attendee.email,
-            name: attendee.name,
-          });
-        } catch (error) {
-          logger.warn('Failed to upsert attendee', {
-            email: attendee.email,
-            error: (error as Error).message,
-          });
-        }
-      }
-    }
+    // Plain emails carry no name to store; endCurrentMeeting() records them
+    const named = attendees.filter((attendee): attendee is CalendarAttendee => typeof attendee === 'object');
+    const counts = await this.peopleRepo.upsertFromCalendarAttendees(named, this.peopleApiFetcher);
 
-    logger.info('Completed background attendee upsert');
+    logger.info('Completed background attendee upsert', { ...counts });
   }
 
   getCurrentMeetingId(): string | null {
@@ -110,6 +163,9 @@ export class MeetingRepository {
     const db = getDatabase();
     if (!currentMeetingId) return null;
 
+    // The meeting is read back below with its transcript
+    await flushWrites();
+
     const now = Date.now();
     const duration = meetingStartTime ? Math.floor((now - meetingStartTime) / 1000) : 0;
 
@@ -125,48 +181,27 @@ export class MeetingRepository {
     meetingStartTime = null;
     saveDatabase();
 
-    if (meeting && meeting.attendeeEmails && meeting.attendeeEmails.length > 0) {
-      const durationMinutes = Math.floor(duration / 60);
-      for (const email of meeting.attendeeEmails) {
-        if (!email) continue;
-        try {
-          const existing = db.exec('SELECT * FROM people WHERE email = ?', [email]);
-          if (existing.length > 0 && existing[0].values.length > 0) {
-            db.run(
-              `UPDATE people SET 
-                last_meeting_at = ?,
-                meeting_count = meeting_count + 1,
-                total_duration = total_duration + ?,
-                updated_at = ?
-              WHERE email = ?`,
-              [now, durationMinutes, now, email]
-            );
-          } else {
-            db.run(
-              `INSERT INTO people (email, last_meeting_at, meeting_count, total_duration, created_at, updated_at)
-              VALUES (?, ?, 1, ?, ?, ?)`,
-              [email, now, durationMinutes, now, now]
-            );
-          }
-        } catch (err) {
-          logger.error('Failed to update person record', { email, error: (err as Error).message });
-        }
+    if (meeting && meeting.attendeeEmails && meeting.attendeeEmails.length > 0 && this.peopleRepo) {
+      try {
+        const counts = this.peopleRepo.recordMeeting(meeting.attendeeEmails, now, Math.floor(duration / 60));
+        logger.debug('Updated people for meeting', { id: endedId, ...counts });
+      } catch (err) {
+        logger.error('Failed to update person records', { id: endedId, error: (err as Error).message });
       }
-      saveDatabase();
     }
 
     logger.info('Ended meeting', { id: endedId, duration, attendeeCount: meeting?.attendeeEmails?.length || 0 });
     return meeting;
   }
 
+  /** Queued behind the live meeting; endCurrentMeeting() flushes it */
   addTranscriptSegment(segment: TranscriptSegment): void {
-    const db = getDatabase();
     if (!currentMeetingId) return;
 
-    db.run(
+    enqueueWrite(
       `INSERT OR REPLACE INTO transcript_segments
-       (id, meeting_id, text, timestamp, source, confidence, is_final, speaker_id)
-       VALUES (?, ?, ?, ?, ?, ?, ?, ?)`,
+       (id, meeting_id, text, timestamp, source, confidence, is_final, speaker_id, words)
+       VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)`,
       [
         segment.id,
         currentMeetingId,
@@ -176,9 +211,65 @@ export class MeetingRepository {
         segment.confidence,
         segment.isFinal ? 1 : 0,
         segment.speakerId || null,
+        JSON.stringify(segment.words ?? []),
       ]
     );
+  }
+
+  /** Swaps a meeting's transcript for another, e.g. a batch re-transcription */
+  replaceTranscript(meetingId: string, segments: TranscriptSegment[]): void {
+    const db = getDatabase();
+    dropArchive(meetingId);
+    db.run('DELETE FROM transcript_segments WHERE meeting_id = ?', [meetingId]);
+    for (const segment of segments) {
+      db.run(
+        `INSERT OR REPLACE INTO transcript_segments
+         (id, meeting_id, text, timestamp, source, confidence, is_final, speaker_id, words)
+         VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)`,
+        [
+          segment.id,
+          meetingId,
+          segment.text,
+          segment.timestamp,
+          segment.source,
+          segment.confidence,
+          segment.isFinal ? 1 : 0,
+          segment.speakerId || null,
+          JSON.stringify(segment.words ?? []),
+        ]
+      );
+    }
     saveDatabase();
+    logger.info('Replaced transcript', { id: meetingId, segmentCount: segments.length });
+  }
+
+  /**
+   * Stores re-timed words, e.g. from forced alignment, for the segments
+   * given; archived segments are left as they are.
+   */
+  updateWordTimings(meetingId: string, segments: Pick<TranscriptSegment, 'id' | 'words'>[]): void {
+    const db = getDatabase();
+    for (const segment of segments) {
+      db.run('UPDATE transcript_segments SET words = ? WHERE id = ? AND meeting_id = ?', [
+        JSON.stringify(segment.words),
+        segment.id,
+        meetingId,
+      ]);
+    }
+    saveDatabase();
+    logger.info('Updated word timings', { id: meetingId, segmentCount: segments.length });
+  }
+
+  // Live segments, or the archived transcript decompressed once they are gone
+  private loadSegments(meetingId: string): Record<string, unknown>[] {
+    const result = getDatabase().exec(
+      'SELECT * FROM transcript_segments WHERE meeting_id = ? ORDER BY timestamp',
+      [meetingId]
+    );
+    if (result.length > 0 && result[0].values.length > 0) {
+      return result[0].values.map((_, i) => resultToObjectByIndex(result[0], i));
+    }
+    return readArchivedSegments(meetingId).map((row) => ({ ...row, meeting_id: meetingId }));
   }
 
   findById(id: string): Meeting | null {
@@ -187,16 +278,7 @@ export class MeetingRepository {
     if (meetingResult.length === 0 || meetingResult[0].values.length === 0) return null;
 
     const row = resultToObject(meetingResult[0]);
-    const segmentsResult = db.exec(
-      'SELECT * FROM transcript_segments WHERE meeting_id = ? ORDER BY timestamp',
-      [id]
-    );
-    const segments =
-      segmentsResult.length > 0
-        ? segmentsResult[0].values.map((_, i) => resultToObjectByIndex(segmentsResult[0], i))
-        : [];
-
-    return this.rowToMeeting(row, segments);
+    return this.rowToMeeting(row, this.loadSegments(id));
   }
 
   findAll(): Meeting[] {
@@ -206,20 +288,67 @@ export class MeetingRepository {
 
     return result[0].values.map((_, i) => {
       const row = resultToObjectByIndex(result[0], i);
-      const segmentsResult = db.exec(
-        'SELECT * FROM transcript_segments WHERE meeting_id = ? ORDER BY timestamp',
-        [row.id as string]
-      );
-      const segments =
-        segmentsResult.length > 0
-          ? segmentsResult[0].values.map((__, j) => resultToObjectByIndex(segmentsResult[0], j))
-          : [];
-      return this.rowToMeeting(row, segments);
+      return this.rowToMeeting(row, this.loadSegments(row.id as string));
     });
   }
 
+  /**
+   * One page of meetings, newest first, from just past `after`. Read from
+   * idx_meetings_list alone: rows carry what a list shows plus segmentCount,
+   * and meetings.get loads the rest when one is opened.
+   */
+  listPage(after: MeetingPageCursor | null = null, limit: number = PAGE_CONFIG.DEFAULT_SIZE): MeetingListPage {
+    const db = getDatabase();
+    const size = Math.min(Math.max(1, Math.floor(limit) || 1), PAGE_CONFIG.MAX_SIZE);
+    const columns = 'id, title, created_at, ended_at, duration, attendee_emails';
+    const result = after
+      ? db.exec(
+          `SELECT ${columns} FROM meetings WHERE (created_at, id) < (?, ?)
+           ORDER BY created_at DESC, id DESC LIMIT ?`,
+          [after.createdAt, after.id, size]
+        )
+      : db.exec(`SELECT ${columns} FROM meetings ORDER BY created_at DESC, id DESC LIMIT ?`, [size]);
+    if (result.length === 0) return { meetings: [], next: null };
+
+    const rows = result[0].values.map((_, i) => resultToObjectByIndex(result[0], i));
+    const counts = this.segmentCounts(rows.map((row) => row.id as string));
+    const meetings = rows.map((row) => ({
+      ...this.rowToMeeting(row, []),
+      segmentCount: counts.get(row.id as string) ?? 0,
+    }));
+    const last = rows[rows.length - 1];
+    return {
+      meetings,
+      next: rows.length === size ? { createdAt: last.created_at as number, id: last.id as string } : null,
+    };
+  }
+
+  // Live segments counted on idx_segments_meeting; archived ones as recorded
+  private segmentCounts(meetingIds: string[]): Map<string, number> {
+    const counts = new Map<string, number>();
+    if (meetingIds.length === 0) return counts;
+    const db = getDatabase();
+    const placeholders = meetingIds.map(() => '?').join(', ');
+    const queries = [
+      `SELECT meeting_id, COUNT(*) FROM transcript_segments WHERE meeting_id IN (${placeholders}) GROUP BY meeting_id`,
+      `SELECT meeting_id, segment_count FROM transcript_archives WHERE meeting_id IN (${placeholders})`,
+    ];
+    for (const sql of queries) {
+      for (const [id, count] of db.exec(sql, meetingIds)[0]?.values ?? []) {
+        counts.set(id as string, (counts.get(id as string) ?? 0) + (count as number));
+      }
+    }
+    return counts;
+  }
+
   search(query: string): Meeting[] {
     const db = getDatabase();
+    if (hasFullTextSearch() && toFtsQuery(query)) {
+      return this.searchHits(query)
+        .map((hit) => this.findById(hit.meetingId))
+        .filter((meeting): meeting is Meeting => meeting !== null);
+    }
+
     const searchPattern = `%${query}%`;
     const result = db.exec(
       `SELECT DISTINCT m.* FROM meetings m
@@ -233,21 +362,134 @@ export class MeetingRepository {
 
     return result[0].values.map((_, i) => {
       const row = resultToObjectByIndex(result[0], i);
-      const segmentsResult = db.exec(
-        'SELECT * FROM transcript_segments WHERE meeting_id = ? ORDER BY timestamp',
-        [row.id as string]
-      );
-      const segments =
-        segmentsResult.length > 0
-          ? segmentsResult[0].values.map((__, j) => resultToObjectByIndex(segmentsResult[0], j))
-          : [];
-      return this.rowToMeeting(row, segments);
+      return this.rowToMeeting(row, this.loadSegments(row.id as string));
     });
   }
 
+  /**
+   * Ranked full-text search over titles and transcripts through the FTS5
+   * index, with each meeting's best-matching snippets. Every word of the
+   * query must appear, as a prefix. Empty without the index.
+   */
+  searchHits(query: string, limit = 20): MeetingSearchHit[] {
+    const match = toFtsQuery(query);
+    if (!hasFullTextSearch() || !match) return [];
+    const db = getDatabase();
+
+    const hits = new Map<string, MeetingSearchHit>();
+    const hitFor = (row: Record<string, unknown>): MeetingSearchHit => {
+      const id = row.meeting_id as string;
+      let hit = hits.get(id);
+      if (!hit) {
+        hit = {
+          meetingId: id,
+          title: { text: row.title as string, highlights: [] },
+          createdAt: new Date(row.created_at as number),
+          score: 0,
+          snippets: [],
+        };
+        hits.set(id, hit);
+      }
+      return hit;
+    };
+
+    // bm25() is lower for better matches; scores are flipped on the way out.
+    // The inner LIMIT keeps SQLite from flattening the FTS functions into
+    // the window query, which it cannot evaluate there.
+    const segments = db.exec(
+      `SELECT meeting_id, title, created_at, segment_id, timestamp, marked, score FROM (
+         SELECT hits.*, ROW_NUMBER() OVER (PARTITION BY meeting_id ORDER BY score) AS rn FROM (
+           SELECT s.meeting_id, m.title, m.created_at, s.id AS segment_id, s.timestamp,
+                  snippet(transcript_fts, 0, char(2), char(3), '…', 24) AS marked,
+                  bm25(transcript_fts) AS score
+           FROM transcript_fts
+           JOIN transcript_segments s ON s.rowid = transcript_fts.rowid
+           JOIN meetings m ON m.id = s.meeting_id
+           WHERE transcript_fts MATCH ?
+           ORDER BY score LIMIT ?
+         ) AS hits
+       ) WHERE rn <= ? ORDER BY score`,
+      [match, SEARCH_MAX_SEGMENT_HITS, SEARCH_SNIPPETS_PER_MEETING]
+    );
+    if (segments.length > 0) {
+      for (let i = 0; i < segments[0].values.length; i++) {
+        const row = resultToObjectByIndex(segments[0], i);
+        const hit = hitFor(row);
+        hit.score = Math.max(hit.score, -(row.score as number));
+        hit.snippets.push({
+          ...unmark(row.marked as string),
+          segmentId: row.segment_id as string,
+          timestamp: row.timestamp as number,
+        });
+      }
+    }
+
+    // Archived transcripts: the index gives archive and segment, and each
+    // archive hit is decompressed once for its snippets
+    const archived = db.exec(
+      `SELECT rowid, bm25(archive_fts) AS score FROM archive_fts
+       WHERE archive_fts MATCH ? ORDER BY score LIMIT ?`,
+      [match, SEARCH_MAX_SEGMENT_HITS]
+    );
+    const byArchive = new Map<number, Array<{ index: number; score: number }>>();
+    for (const [rowid, score] of archived[0]?.values ?? []) {
+      const archiveId = Math.floor((rowid as number) / ARCHIVE_ROWID_STRIDE);
+      const best = byArchive.get(archiveId) ?? [];
+      if (best.length < SEARCH_SNIPPETS_PER_MEETING) {
+        best.push({ index: (rowid as number) % ARCHIVE_ROWID_STRIDE, score: score as number });
+        byArchive.set(archiveId, best);
+      }
+    }
+    for (const [archiveId, best] of byArchive) {
+      const archive = readArchiveById(archiveId);
+      const meeting = archive && db.exec('SELECT title, created_at FROM meetings WHERE id = ?', [archive.meetingId]);
+      if (!archive || !meeting?.[0]?.values[0]) continue;
+      const hit = hitFor({
+        meeting_id: archive.meetingId,
+        title: meeting[0].values[0][0],
+        created_at: meeting[0].values[0][1],
+      });
+      for (const { index, score } of best) {
+        const segment = archive.rows[index];
+        if (!segment) continue;
+        hit.score = Math.max(hit.score, -score);
+        hit.snippets.push({
+          ...unmark(markTerms(segment.text, query)),
+          segmentId: segment.id,
+          timestamp: segment.timestamp,
+        });
+      }
+    }
+
+    const titles = db.exec(
+      `SELECT m.id AS meeting_id, m.title, m.created_at,
+              highlight(meeting_fts, 0, char(2), char(3)) AS marked,
+              bm25(meeting_fts) AS score
+       FROM meeting_fts
+       JOIN meetings m ON m.rowid = meeting_fts.rowid
+       WHERE meeting_fts MATCH ?`,
+      [match]
+    );
+    if (titles.length > 0) {
+      for (let i = 0; i < titles[0].values.length; i++) {
+        const row = resultToObjectByIndex(titles[0], i);
+        const hit = hitFor(row);
+        hit.title = unmark(row.marked as string);
+        hit.score = Math.max(hit.score, -(row.score as number) * SEARCH_TITLE_WEIGHT);
+      }
+    }
+
+    return [...hits.values()]
+      .sort((a, b) => b.score - a.score || b.createdAt.getTime() - a.createdAt.getTime())
+      .slice(0, limit);
+  }
+
   delete(id: string): void {
     const db = getDatabase();
+    dropArchive(id);
     db.run('DELETE FROM transcript_segments WHERE meeting_id = ?', [id]);
+    db.run('DELETE FROM meeting_performance_metrics WHERE meeting_id = ?', [id]);
+    db.run('DELETE FROM meeting_performance WHERE meeting_id = ?', [id]);
     db.run('DELETE FROM meetings WHERE id = ?', [id]);
     saveDatabase();
     logger.info('Deleted meeting', { id });
@@ -293,6 +535,27 @@ export class MeetingRepository {
     saveDatabase();
   }
 
+  setRecording(id: string, indexPath: string, startedAt: number): void {
+    const db = getDatabase();
+    db.run('UPDATE meetings SET recording_index = ?, recording_started_at = ? WHERE id = ?', [
+      indexPath,
+      startedAt,
+      id,
+    ]);
+    saveDatabase();
+  }
+
+  /**
+   * Where a transcript segment starts in the meeting's recording, in ms of
+   * recording time (what RecordingReader.read() takes), or null without a
+   * recording. Segment timestamps count from transcription start, which is
+   * taken as the meeting's creation.
+   */
+  getRecordingOffset(meeting: Meeting, segment: TranscriptSegment): number | null {
+    if (!meeting.recordingIndex || meeting.recordingStartedAt == null) return null;
+    return Math.max(0, meeting.createdAt.getTime() + segment.timestamp - meeting.recordingStartedAt);
+  }
+
   updateNoteEntries(id: string, noteEntries: any[]): void {
     const db = getDatabase();
     db.run('UPDATE meetings SET note_entries = ? WHERE id = ?', [JSON.stringify(noteEntries), id]);
@@ -313,7 +576,7 @@ export class MeetingRepository {
         source: s.source as 'mic' | 'system',
         confidence: s.confidence as number,
         isFinal: (s.is_final as number) === 1,
-        words: [],
+        words: s.words ? JSON.parse(s.words as string) : [],
         speakerId: s.speaker_id as string | undefined,
       })),
       noteEntries: row.note_entries ? JSON.parse(row.note_entries as string) : [],
@@ -327,6 +590,8 @@ export class MeetingRepository {
       actionItems: JSON.parse((row.action_items as string) || '[]'),
       participants: JSON.parse((row.participants as string) || '[]'),
       attendeeEmails: JSON.parse((row.attendee_emails as string) || '[]'),
+      recordingIndex: (row.recording_index as string) || null,
+      recordingStartedAt: (row.recording_started_at as number) ?? null,
     };
   }
 }
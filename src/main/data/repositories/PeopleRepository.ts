@@ -1,10 +1,20 @@
-import { Person } from '@shared/types';
-import { getDatabase, saveDatabase } from '../database';
+import { Person, PeopleListPage, PeoplePageCursor } from '@shared/types';
+import { getDatabase, saveDatabase, upsertMany, type UpsertCounts } from '../database';
 import { createLogger } from '../../core/logger';
+import { PAGE_CONFIG } from '../../config/constants';
+import { createFuzzyMatcher, emailKeys, type FuzzyMatcher } from '../../utils/fuzzy';
 
 const logger = createLogger('PeopleRepository');
 
+// However many substring matches search() finds, fuzzy ones fill it to this
+const SEARCH_FUZZY_FILL = 10;
+
 export class PeopleRepository {
+  // Over every person's name and email, rebuilt when people are added or
+  // updated, wherever from
+  private fuzzy: FuzzyMatcher | null = null;
+  private fuzzyVersion = '';
+
   listAll(): Person[] {
     const db = getDatabase();
     const rows = db.exec(
@@ -14,6 +24,27 @@ export class PeopleRepository {
     return rows.map(this.rowToPerson);
   }
 
+  /** One page, most recently met first, from just past `after`, walking idx_people_last_seen */
+  listPage(after: PeoplePageCursor | null = null, limit: number = PAGE_CONFIG.DEFAULT_SIZE): PeopleListPage {
+    const db = getDatabase();
+    const size = Math.min(Math.max(1, Math.floor(limit) || 1), PAGE_CONFIG.MAX_SIZE);
+    const rows =
+      (after
+        ? db.exec(
+            `SELECT * FROM people WHERE (last_meeting_at, email) < (?, ?)
+             ORDER BY last_meeting_at DESC, email DESC LIMIT ?`,
+            [after.lastMeetingAt, after.email, size]
+          )
+        : db.exec('SELECT * FROM people ORDER BY last_meeting_at DESC, email DESC LIMIT ?', [size])
+      )[0]?.values || [];
+
+    const last = rows[rows.length - 1];
+    return {
+      people: rows.map(this.rowToPerson),
+      next: rows.length === size ? { lastMeetingAt: last[2] as number, email: last[0] as string } : null,
+    };
+  }
+
   search(query: string): Person[] {
     const db = getDatabase();
     const searchPattern = `%${query.toLowerCase()}%`;
@@ -24,7 +55,33 @@ export class PeopleRepository {
       [searchPattern, searchPattern]
     )[0]?.values || [];
 
-    return rows.map(this.rowToPerson);
+    const people = rows.map(this.rowToPerson);
+    if (people.length >= SEARCH_FUZZY_FILL) return people;
+    const found = new Set(people.map((person) => person.email));
+    const similar = this.findSimilar(query, SEARCH_FUZZY_FILL).filter((person) => !found.has(person.email));
+    return people.concat(similar.slice(0, SEARCH_FUZZY_FILL - people.length));
+  }
+
+  /**
+   * People whose name or email is close to |query|, best first: misspelt
+   * names, nicknames a letter or two off, an address read out as words.
+   */
+  findSimilar(query: string, limit = 10, minScore = 0.75): Person[] {
+    const db = getDatabase();
+    const version = JSON.stringify(db.exec('SELECT COUNT(*), MAX(updated_at) FROM people')[0]?.values[0] ?? []);
+    if (!this.fuzzy || version !== this.fuzzyVersion) {
+      this.fuzzyVersion = version;
+      this.fuzzy = createFuzzyMatcher(
+        this.listAll().map((person) => ({
+          id: person.email,
+          keys: [person.name ?? '', ...emailKeys(person.email)],
+        }))
+      );
+    }
+    return this.fuzzy
+      .search(query, { limit, minScore })
+      .map((hit) => this.getByEmail(hit.id))
+      .filter((person): person is Person => person !== null);
   }
 
   getByEmail(email: string): Person | null {
@@ -55,6 +112,7 @@ export class PeopleRepository {
       [name, email]
     );
     saveDatabase();
+    this.fuzzy = null;  // updated_at is left alone
     logger.info('Updated person name', { email, name });
   }
 
@@ -122,11 +180,56 @@ export class PeopleRepository {
     organization?: string,
     peopleApiFetcher?: (email: string) => Promise<string | null>
   ): Promise<void> {
-    if (!email) return;
+    await this.upsertFromCalendarAttendees([{ email, name: calendarDisplayName, organization }], peopleApiFetcher);
+  }
 
-    const db = getDatabase();
+  /**
+   * Many attendees at once, names resolved as upsertFromCalendarAttendee
+   * does, then written in one bulk upsert. An existing person keeps the
+   * name and organization they have.
+   */
+  async upsertFromCalendarAttendees(
+    attendees: { email: string; name?: string; organization?: string }[],
+    peopleApiFetcher?: (email: string) => Promise<string | null>
+  ): Promise<UpsertCounts> {
     const now = Date.now();
+    const rows: Record<string, string | number | null>[] = [];
+    for (const attendee of attendees) {
+      if (!attendee.email) continue;
+      const name = await this.resolveName(attendee.email, attendee.name, peopleApiFetcher);
+      rows.push({ ':email': attendee.email, ':name': name, ':organization': attendee.organization || null, ':now': now });
+    }
+
+    const counts = upsertMany(
+      `UPDATE people SET name = COALESCE(name, :name), organization = COALESCE(organization, :organization),
+         updated_at = :now WHERE email = :email`,
+      `INSERT INTO people (email, name, last_meeting_at, meeting_count, total_duration, organization, created_at, updated_at)
+       VALUES (:email, :name, :now, 0, 0, :organization, :now, :now)`,
+      rows
+    );
+    logger.info('Upserted people from calendar', { ...counts });
+    return counts;
+  }
 
+  /** A meeting that ended at `endedAt` counted to each attendee, created where new */
+  recordMeeting(emails: string[], endedAt: number, durationMinutes: number): UpsertCounts {
+    const rows = emails
+      .filter((email) => email)
+      .map((email) => ({ ':email': email, ':at': endedAt, ':minutes': durationMinutes }));
+    return upsertMany(
+      `UPDATE people SET last_meeting_at = :at, meeting_count = meeting_count + 1,
+         total_duration = total_duration + :minutes, updated_at = :at WHERE email = :email`,
+      `INSERT INTO people (email, last_meeting_at, meeting_count, total_duration, created_at, updated_at)
+       VALUES (:email, :at, 1, :minutes, :at, :at)`,
+      rows
+    );
+  }
+
+  private async resolveName(
+    email: string,
+    calendarDisplayName?: string,
+    peopleApiFetcher?: (email: string) => Promise<string | null>
+  ): Promise<string> {
     let name = calendarDisplayName;
 
     if (!name && peopleApiFetcher) {
@@ -146,24 +249,7 @@ export class PeopleRepository {
       logger.debug('Using email-extracted name', { email, name });
     }
 
-    const existing = db.exec('SELECT * FROM people WHERE email = ?', [email]);
-
-    if (existing[0]?.values.length > 0) {
-      db.run(
-        'UPDATE people SET name = COALESCE(name, ?), organization = COALESCE(organization, ?), updated_at = ? WHERE email = ?',
-        [name, organization || null, now, email]
-      );
-      logger.info('Updated person from calendar', { email, name, source: calendarDisplayName ? 'calendar' : 'fallback' });
-    } else {
-      db.run(
-        `INSERT INTO people (email, name, last_meeting_at, meeting_count, total_duration, organization, created_at, updated_at)
-         VALUES (?, ?, ?, ?, ?, ?, ?, ?)`,
-        [email, name, now, 0, 0, organization || null, now, now]
-      );
-      logger.info('Created person from calendar', { email, name, source: calendarDisplayName ? 'calendar' : 'fallback' });
-    }
-
-    saveDatabase();
+    return name;
   }
 
   private rowToPerson(row: unknown[]): Person {
@@ -0,0 +1,182 @@
+import {
+  beginTransaction,
+  commitTransaction,
+  getDatabase,
+  resultToObjectByIndex,
+  rollbackTransaction,
+} from '../database';
+import type {
+  MeetingPerformance,
+  PerformanceRegression,
+  PerformanceReport,
+  PerformanceVersionStats,
+} from '@shared/types';
+import { PERFORMANCE_CONFIG } from '../../config/constants';
+import { createLogger } from '../../core/logger';
+
+const logger = createLogger('PerformanceRepository');
+
+/** How much worse `candidate` is than `baseline` for this metric; 0 when it is not */
+function worseBy(metric: string, baseline: number, candidate: number): number {
+  const suffix = metric.slice(metric.lastIndexOf('.') + 1);
+  if ((PERFORMANCE_CONFIG.MAGNITUDE_ONLY as readonly string[]).includes(suffix)) {
+    baseline = Math.abs(baseline);
+    candidate = Math.abs(candidate);
+  }
+  const rise = (PERFORMANCE_CONFIG.HIGHER_IS_BETTER as readonly string[]).includes(suffix)
+    ? baseline - candidate
+    : candidate - baseline;
+  if (rise <= 0) return 0;
+  return baseline === 0 ? Infinity : rise / Math.abs(baseline);
+}
+
+/** ` AND <column> IN (?, ...)` for `metrics`, or nothing for every metric */
+function metricFilter(column: string, metrics?: string[]): string {
+  return metrics && metrics.length > 0 ? ` AND ${column} IN (${metrics.map(() => '?').join(', ')})` : '';
+}
+
+export class PerformanceRepository {
+  /** Replaces the meeting's report; its metrics are indexed for compare() */
+  save(meetingId: string, report: PerformanceReport, appVersion: string, platform: string): void {
+    const db = getDatabase();
+    beginTransaction();
+    try {
+      db.run('DELETE FROM meeting_performance_metrics WHERE meeting_id = ?', [meetingId]);
+      db.run(
+        `INSERT OR REPLACE INTO meeting_performance (meeting_id, app_version, platform, recorded_at, report)
+         VALUES (?, ?, ?, ?, ?)`,
+        [meetingId, appVersion, platform, Date.now(), JSON.stringify(report)]
+      );
+      for (const [metric, value] of Object.entries(report.metrics)) {
+        if (!Number.isFinite(value)) continue;
+        db.run('INSERT INTO meeting_performance_metrics (meeting_id, metric, value) VALUES (?, ?, ?)', [
+          meetingId,
+          metric,
+          value,
+        ]);
+      }
+      commitTransaction();
+    } catch (error) {
+      rollbackTransaction();
+      throw error;
+    }
+    logger.debug('Saved performance report', { meetingId, appVersion, metrics: Object.keys(report.metrics).length });
+  }
+
+  findByMeeting(meetingId: string): MeetingPerformance | null {
+    const result = getDatabase().exec('SELECT * FROM meeting_performance WHERE meeting_id = ?', [meetingId]);
+    if (result.length === 0 || result[0].values.length === 0) return null;
+    const row = resultToObjectByIndex(result[0], 0);
+    return {
+      meetingId: row.meeting_id as string,
+      appVersion: row.app_version as string,
+      platform: row.platform as string,
+      recordedAt: new Date(row.recorded_at as number),
+      report: JSON.parse(row.report as string) as PerformanceReport,
+    };
+  }
+
+  /** The meetings' metrics side by side, in the order asked; meetings without a report are left out */
+  compare(
+    meetingIds: string[],
+    metrics?: string[]
+  ): Array<{ meetingId: string; appVersion: string; recordedAt: Date; metrics: Record<string, number> }> {
+    if (meetingIds.length === 0) return [];
+    const result = getDatabase().exec(
+      `SELECT p.meeting_id, p.app_version, p.recorded_at, m.metric, m.value
+         FROM meeting_performance p
+         JOIN meeting_performance_metrics m ON m.meeting_id = p.meeting_id
+        WHERE p.meeting_id IN (${meetingIds.map(() => '?').join(', ')})${metricFilter('m.metric', metrics)}`,
+      [...meetingIds, ...(metrics ?? [])]
+    );
+    const byMeeting = new Map<
+      string,
+      { meetingId: string; appVersion: string; recordedAt: Date; metrics: Record<string, number> }
+    >();
+    if (result.length > 0) {
+      for (const [meetingId, appVersion, recordedAt, metric, value] of result[0].values) {
+        let entry = byMeeting.get(meetingId as string);
+        if (!entry) {
+          entry = {
+            meetingId: meetingId as string,
+            appVersion: appVersion as string,
+            recordedAt: new Date(recordedAt as number),
+            metrics: {},
+          };
+          byMeeting.set(entry.meetingId, entry);
+        }
+        entry.metrics[metric as string] = value as number;
+      }
+    }
+    return meetingIds.flatMap((id) => {
+      const entry = byMeeting.get(id);
+      return entry ? [entry] : [];
+    });
+  }
+
+  /** Every app version with a report, oldest first, each metric's mean and max over its meetings */
+  summarizeByVersion(metrics?: string[]): PerformanceVersionStats[] {
+    const db = getDatabase();
+    const versions = db.exec(
+      `SELECT app_version, COUNT(*) FROM meeting_performance
+        GROUP BY app_version ORDER BY MIN(recorded_at)`
+    );
+    if (versions.length === 0) return [];
+    const byVersion = new Map<string, PerformanceVersionStats>();
+    for (const [appVersion, meetings] of versions[0].values) {
+      byVersion.set(appVersion as string, {
+        appVersion: appVersion as string,
+        meetings: meetings as number,
+        metrics: {},
+      });
+    }
+
+    const result = db.exec(
+      `SELECT p.app_version, m.metric, AVG(m.value), MAX(m.value), COUNT(*)
+         FROM meeting_performance_metrics m
+         JOIN meeting_performance p ON p.meeting_id = m.meeting_id
+        WHERE 1 = 1${metricFilter('m.metric', metrics)}
+        GROUP BY p.app_version, m.metric`,
+      metrics ?? []
+    );
+    if (result.length > 0) {
+      for (const [appVersion, metric, mean, max, meetings] of result[0].values) {
+        const stats = byVersion.get(appVersion as string);
+        if (stats) {
+          stats.metrics[metric as string] = {
+            mean: mean as number,
+            max: max as number,
+            meetings: meetings as number,
+          };
+        }
+      }
+    }
+    return [...byVersion.values()];
+  }
+
+  /**
+   * Metrics whose mean over `candidateVersion`'s meetings is worse than over
+   * `baselineVersion`'s by at least `threshold` (0.2 = 20%), worst first
+   */
+  findRegressions(
+    baselineVersion: string,
+    candidateVersion: string,
+    threshold: number = PERFORMANCE_CONFIG.REGRESSION_THRESHOLD
+  ): PerformanceRegression[] {
+    const stats = this.summarizeByVersion();
+    const baseline = stats.find((entry) => entry.appVersion === baselineVersion);
+    const candidate = stats.find((entry) => entry.appVersion === candidateVersion);
+    if (!baseline || !candidate) return [];
+
+    const regressions: PerformanceRegression[] = [];
+    for (const [metric, after] of Object.entries(candidate.metrics)) {
+      const before = baseline.metrics[metric];
+      if (!before) continue;
+      const change = worseBy(metric, before.mean, after.mean);
+      if (change >= threshold && change > 0) {
+        regressions.push({ metric, baseline: before.mean, candidate: after.mean, change });
+      }
+    }
+    return regressions.sort((a, b) => b.change - a.change);
+  }
+}
@@ -2,3 +2,4 @@ export { MeetingRepository } from './MeetingRepository';
 export { CalloutRepository } from './CalloutRepository';
 export { SettingsRepository } from './SettingsRepository';
 export { PeopleRepository } from './PeopleRepository';
+export { PerformanceRepository } from './PerformanceRepository';
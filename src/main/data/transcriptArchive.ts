@@ -0,0 +1,293 @@
+import { deflateRawSync, inflateRawSync } from 'zlib';
+import { createLogger } from '../core/logger';
+import { ARCHIVE_CONFIG } from '../config/constants';
+import {
+  getDatabase,
+  getTranscriptCodecModule,
+  hasFullTextSearch,
+  saveDatabase,
+  withTransaction,
+} from './database';
+
+const logger = createLogger('TranscriptArchive');
+
+/** archive_fts rowids: archive id * stride + the segment's index in it */
+export const ARCHIVE_ROWID_STRIDE = 2 ** 20;
+
+// deflate's window: a preset dictionary longer than this is never reached
+const DEFLATE_DICTIONARY_BYTES = 32 * 1024;
+
+type Codec = 'zstd' | 'deflate';
+
+interface Dictionary {
+  id: number;
+  compress(data: Buffer): Buffer;
+  decompress(data: Buffer): Buffer;
+}
+
+/** A transcript_segments row, as the repositories read them */
+export interface ArchivedSegmentRow {
+  id: string;
+  text: string;
+  timestamp: number;
+  source: string;
+  confidence: number;
+  is_final: number;
+  speaker_id: string | null;
+}
+
+const dictionaries = new Map<number, Dictionary | null>();
+
+function preferredCodec(): Codec {
+  return getTranscriptCodecModule() ? 'zstd' : 'deflate';
+}
+
+function makeDictionary(id: number, codec: Codec, dictionary: Buffer): Dictionary | null {
+  if (codec === 'deflate') {
+    const options = dictionary.length > 0 ? { dictionary } : {};
+    return {
+      id,
+      compress: (data) => deflateRawSync(data, { ...options, level: 9 }),
+      decompress: (data) => inflateRawSync(data, options),
+    };
+  }
+  const native = getTranscriptCodecModule();
+  if (!native) return null;
+  const engine = new native.TranscriptCodec(dictionary.length > 0 ? dictionary : undefined, ARCHIVE_CONFIG.ZSTD_LEVEL);
+  return {
+    id,
+    compress: (data) => Buffer.from(engine.compress(data)),
+    decompress: (data) => Buffer.from(engine.decompress(data)),
+  };
+}
+
+function loadDictionary(id: number): Dictionary | null {
+  if (dictionaries.has(id)) return dictionaries.get(id) ?? null;
+  const result = getDatabase().exec('SELECT codec, dictionary FROM transcript_dictionaries WHERE id = ?', [id]);
+  const row = result[0]?.values[0];
+  const dictionary = row ? makeDictionary(id, row[0] as Codec, Buffer.from(row[1] as Uint8Array)) : null;
+  if (!dictionary) {
+    logger.warn('Archive dictionary unusable in this build', { id, codec: row?.[0] });
+  }
+  dictionaries.set(id, dictionary);
+  return dictionary;
+}
+
+// deflate has no trainer: the most frequent words and JSON fragments, worth
+// most at the end of the window, where the nearest matches are cheapest
+function trainDeflateDictionary(samples: string[]): Buffer {
+  const counts = new Map<string, number>();
+  for (const sample of samples) {
+    for (const piece of sample.match(/[^\s"]+|"[a-z]*",?/gi) ?? []) {
+      counts.set(piece, (counts.get(piece) ?? 0) + 1);
+    }
+  }
+  const ranked = [...counts.entries()]
+    .filter(([, count]) => count > 1)
+    .sort((a, b) => b[1] * b[0].length - a[1] * a[0].length);
+  const chosen: string[] = [];
+  let bytes = 0;
+  for (const [piece] of ranked) {
+    const size = Buffer.byteLength(piece) + 1;
+    if (bytes + size > DEFLATE_DICTIONARY_BYTES) break;
+    chosen.push(piece);
+    bytes += size;
+  }
+  return Buffer.from(chosen.reverse().join(' '));
+}
+
+// The newest dictionary for this build's codec, trained from |samples| the
+// first time
+function currentDictionary(samples: string[]): Dictionary | null {
+  const codec = preferredCodec();
+  const db = getDatabase();
+  const latest = db.exec('SELECT id FROM transcript_dictionaries WHERE codec = ? ORDER BY id DESC LIMIT 1', [codec]);
+  if (latest[0]?.values[0]) {
+    return loadDictionary(latest[0].values[0][0] as number);
+  }
+
+  let trained: Buffer;
+  const native = getTranscriptCodecModule();
+  if (codec === 'zstd' && native) {
+    try {
+      trained = Buffer.from(native.trainTranscriptDictionary(samples, ARCHIVE_CONFIG.DICTIONARY_BYTES));
+    } catch (error) {
+      logger.warn('Dictionary training failed; compressing without one', { error: (error as Error).message });
+      trained = Buffer.alloc(0);
+    }
+  } else {
+    trained = trainDeflateDictionary(samples);
+  }
+  db.run('INSERT INTO transcript_dictionaries (codec, dictionary, created_at) VALUES (?, ?, ?)', [
+    codec,
+    trained,
+    Date.now(),
+  ]);
+  const id = db.exec('SELECT MAX(id) FROM transcript_dictionaries')[0].values[0][0] as number;
+  saveDatabase();
+  logger.info('Trained transcript dictionary', { id, codec, bytes: trained.length, samples: samples.length });
+  return loadDictionary(id);
+}
+
+function toTuple(row: ArchivedSegmentRow): unknown[] {
+  return [row.id, row.text, row.timestamp, row.source, row.confidence, row.is_final, row.speaker_id];
+}
+
+function decodeSegments(dictionaryId: number, data: Uint8Array): ArchivedSegmentRow[] | null {
+  const dictionary = loadDictionary(dictionaryId);
+  if (!dictionary) return null;
+  try {
+    const tuples = JSON.parse(dictionary.decompress(Buffer.from(data)).toString('utf8')) as unknown[][];
+    return tuples.map(([id, text, timestamp, source, confidence, isFinal, speakerId]) => ({
+      id: id as string,
+      text: text as string,
+      timestamp: timestamp as number,
+      source: source as string,
+      confidence: confidence as number,
+      is_final: isFinal as number,
+      speaker_id: (speakerId as string | null) ?? null,
+    }));
+  } catch (error) {
+    logger.error('Failed to decode archived transcript', { dictionaryId, error: (error as Error).message });
+    return null;
+  }
+}
+
+function readArchive(where: string, key: string | number): { id: number; meetingId: string; rows: ArchivedSegmentRow[] } | null {
+  const result = getDatabase().exec(
+    `SELECT id, meeting_id, dictionary_id, data FROM transcript_archives WHERE ${where} = ?`,
+    [key]
+  );
+  const row = result[0]?.values[0];
+  if (!row) return null;
+  const rows = decodeSegments(row[2] as number, row[3] as Uint8Array);
+  return rows ? { id: row[0] as number, meetingId: row[1] as string, rows } : null;
+}
+
+/** A meeting's archived segments in timestamp order; empty when it has none */
+export function readArchivedSegments(meetingId: string): ArchivedSegmentRow[] {
+  return readArchive('meeting_id', meetingId)?.rows ?? [];
+}
+
+/** The segments of archive |id|, for search hits; null when it is gone */
+export function readArchiveById(id: number): { meetingId: string; rows: ArchivedSegmentRow[] } | null {
+  return readArchive('id', id);
+}
+
+/**
+ * Removes a meeting's archive and its search entries, before the meeting or
+ * its transcript is deleted or replaced. The caller saves.
+ */
+export function dropArchive(meetingId: string): void {
+  const archive = readArchive('meeting_id', meetingId);
+  const db = getDatabase();
+  if (archive && hasFullTextSearch()) {
+    // A contentless index forgets a row only given the text it indexed
+    archive.rows.forEach((row, i) => {
+      db.run(`INSERT INTO archive_fts(archive_fts, rowid, text) VALUES ('delete', ?, ?)`, [
+        archive.id * ARCHIVE_ROWID_STRIDE + i,
+        row.text,
+      ]);
+    });
+  }
+  db.run('DELETE FROM transcript_archives WHERE meeting_id = ?', [meetingId]);
+}
+
+/**
+ * Moves the transcripts of meetings created more than |olderThanDays| ago
+ * into compressed per-meeting archives, with zstd and a trained dictionary
+ * where the native engine has it and deflate otherwise. Search keeps
+ * finding them through archive_fts; the repositories decompress a
+ * transcript only when its meeting is read. Work is split into
+ * transactions of a few meetings, yielding in between.
+ */
+export async function archiveOldMeetings(
+  olderThanDays: number = ARCHIVE_CONFIG.AFTER_DAYS
+): Promise<{ meetings: number; rawBytes: number; storedBytes: number }> {
+  const db = getDatabase();
+  const cutoff = Date.now() - olderThanDays * 24 * 60 * 60 * 1000;
+  const candidates = db.exec(
+    `SELECT m.id FROM meetings m
+     WHERE m.created_at < ? AND m.ended_at IS NOT NULL
+       AND EXISTS (SELECT 1 FROM transcript_segments s WHERE s.meeting_id = m.id)
+       AND NOT EXISTS (SELECT 1 FROM transcript_archives a WHERE a.meeting_id = m.id)
+     ORDER BY m.created_at`,
+    [cutoff]
+  );
+  const meetingIds = (candidates[0]?.values ?? []).map((row) => row[0] as string);
+  const totals = { meetings: 0, rawBytes: 0, storedBytes: 0 };
+  if (meetingIds.length === 0) return totals;
+
+  const segmentsOf = (meetingId: string): ArchivedSegmentRow[] => {
+    const result = db.exec(
+      `SELECT id, text, timestamp, source, confidence, is_final, speaker_id
+       FROM transcript_segments WHERE meeting_id = ? ORDER BY timestamp`,
+      [meetingId]
+    );
+    return (result[0]?.values ?? []).map(([id, text, timestamp, source, confidence, isFinal, speakerId]) => ({
+      id: id as string,
+      text: text as string,
+      timestamp: timestamp as number,
+      source: source as string,
+      confidence: confidence as number,
+      is_final: isFinal as number,
+      speaker_id: (speakerId as string | null) ?? null,
+    }));
+  };
+
+  // Training wants many short samples: one per segment
+  const samples: string[] = [];
+  for (const meetingId of meetingIds) {
+    for (const row of segmentsOf(meetingId)) {
+      samples.push(JSON.stringify(toTuple(row)));
+      if (samples.length >= ARCHIVE_CONFIG.MAX_TRAINING_SEGMENTS) break;
+    }
+    if (samples.length >= ARCHIVE_CONFIG.MAX_TRAINING_SEGMENTS) break;
+  }
+  const hasDictionary =
+    (db.exec('SELECT 1 FROM transcript_dictionaries WHERE codec = ? LIMIT 1', [preferredCodec()])[0]?.values
+      .length ?? 0) > 0;
+  if (!hasDictionary && samples.length < ARCHIVE_CONFIG.MIN_TRAINING_SEGMENTS) {
+    logger.debug('Too little old transcript to train on yet', { segments: samples.length });
+    return totals;
+  }
+  const dictionary = currentDictionary(samples);
+  if (!dictionary) return totals;
+
+  for (let start = 0; start < meetingIds.length; start += ARCHIVE_CONFIG.BATCH_MEETINGS) {
+    const batch = meetingIds.slice(start, start + ARCHIVE_CONFIG.BATCH_MEETINGS);
+    await withTransaction(() => {
+      for (const meetingId of batch) {
+        const rows = segmentsOf(meetingId);
+        if (rows.length === 0 || rows.length >= ARCHIVE_ROWID_STRIDE) continue;
+        const raw = Buffer.from(JSON.stringify(rows.map(toTuple)));
+        const data = dictionary.compress(raw);
+        const id = ((db.exec('SELECT MAX(id) FROM transcript_archives')[0]?.values[0][0] as number | null) ?? 0) + 1;
+        db.run(
+          `INSERT INTO transcript_archives
+           (id, meeting_id, dictionary_id, segment_count, raw_bytes, data, archived_at)
+           VALUES (?, ?, ?, ?, ?, ?, ?)`,
+          [id, meetingId, dictionary.id, rows.length, raw.length, data, Date.now()]
+        );
+        if (hasFullTextSearch()) {
+          rows.forEach((row, i) => {
+            db.run('INSERT INTO archive_fts(rowid, text) VALUES (?, ?)', [id * ARCHIVE_ROWID_STRIDE + i, row.text]);
+          });
+        }
+        db.run('DELETE FROM transcript_segments WHERE meeting_id = ?', [meetingId]);
+        totals.meetings++;
+        totals.rawBytes += raw.length;
+        totals.storedBytes += data.length;
+      }
+    });
+    await new Promise((resolve) => setImmediate(resolve));
+  }
+
+  if (totals.meetings > 0) {
+    // Give the freed pages back to the file (and, under sql.js, the heap)
+    db.run('VACUUM');
+    saveDatabase();
+  }
+  logger.info('Archived old transcripts', totals);
+  return totals;
+}
@@ -9,6 +9,7 @@ import { registerCRMHandlers, setCRMHandlersMainWindow } from './crmHandlers';
 import { registerChatHandlers } from './chatHandlers';
 import { registerPrepHandlers } from './prepHandlers';
 import { registerDialogHandlers } from './dialogHandlers';
+import { registerKnowledgeHandlers } from './knowledgeHandlers';
 import { createLogger } from '../core/logger';
 
 const logger = createLogger('Handlers');
@@ -28,6 +29,7 @@ export function registerAllHandlers(
   registerChatHandlers();
   registerPrepHandlers();
   registerDialogHandlers();
+  registerKnowledgeHandlers();
 
   logger.info('All IPC handlers registered');
 }
@@ -0,0 +1,36 @@
+import { ipcMain } from 'electron';
+import { IPC_CHANNELS } from '@shared/ipcChannels';
+import { getContainer } from '../core/container';
+import { createLogger } from '../core/logger';
+import type { KnowledgeSearchResult } from '@shared/types';
+
+const logger = createLogger('KnowledgeHandlers');
+
+export function registerKnowledgeHandlers(): void {
+  ipcMain.handle(IPC_CHANNELS.KNOWLEDGE_INDEX, async (_event, path: string): Promise<void> => {
+    try {
+      const { knowledgeService } = getContainer();
+      await knowledgeService.index(path);
+    } catch (error) {
+      const errorMessage = error instanceof Error ? error.message : 'Unknown error';
+      logger.error('Failed to index knowledge base', { path, error: errorMessage });
+      throw error;
+    }
+  });
+
+  ipcMain.handle(
+    IPC_CHANNELS.KNOWLEDGE_SEARCH,
+    async (_event, query: string): Promise<KnowledgeSearchResult[]> => {
+      try {
+        const { knowledgeService } = getContainer();
+        return await knowledgeService.search(query);
+      } catch (error) {
+        const errorMessage = error instanceof Error ? error.message : 'Unknown error';
+        logger.error('Failed to search knowledge base', { error: errorMessage });
+        throw error;
+      }
+    }
+  );
+
+  logger.info('Knowledge handlers registered');
+}
@@ -3,17 +3,22 @@ import { IPC_CHANNELS } from '@shared/ipcChannels';
 import { getContainer } from '../core/container';
 import { ExportService } from '../services/ExportService';
 import { createLogger } from '../core/logger';
+import type { MeetingPageCursor } from '@shared/types';
 
 const logger = createLogger('MeetingHandlers');
 
 export function registerMeetingHandlers(): void {
-  const { meetingRepo, calloutService } = getContainer();
+  const { meetingRepo, calloutRepo, calloutService } = getContainer();
   const exportService = new ExportService();
 
   ipcMain.handle(IPC_CHANNELS.MEETINGS_LIST, () => {
     return meetingRepo.findAll();
   });
 
+  ipcMain.handle(IPC_CHANNELS.MEETINGS_LIST_PAGE, (_, after?: MeetingPageCursor | null, limit?: number) => {
+    return meetingRepo.listPage(after ?? null, limit);
+  });
+
   ipcMain.handle(IPC_CHANNELS.MEETINGS_GET, (_, id: string) => {
     return meetingRepo.findById(id);
   });
@@ -26,6 +31,10 @@ export function registerMeetingHandlers(): void {
     return meetingRepo.search(query);
   });
 
+  ipcMain.handle(IPC_CHANNELS.MEETINGS_SEARCH_HITS, (_, query: string, limit?: number) => {
+    return meetingRepo.searchHits(query, limit);
+  });
+
   ipcMain.handle(
     IPC_CHANNELS.MEETINGS_CREATE_DISMISSED,
     (_, title: string, attendeeEmails?: string[]) => {
@@ -68,6 +77,27 @@ export function registerMeetingHandlers(): void {
     }
   );
 
+  ipcMain.handle(
+    IPC_CHANNELS.MEETING_EXPORT_CLIP,
+    async (_, id: string, timestamp: number, durationMs?: number) => {
+      const meeting = meetingRepo.findById(id);
+      if (!meeting) throw new Error('Meeting not found');
+
+      return exportService.exportClip(meeting, timestamp, durationMs);
+    }
+  );
+
+  ipcMain.handle(IPC_CHANNELS.MEETING_EXPORT_BUNDLE, async (event, id: string) => {
+    const meeting = meetingRepo.findById(id);
+    if (!meeting) throw new Error('Meeting not found');
+
+    return exportService.exportBundle(meeting, calloutRepo.findByMeeting(id), (fraction) => {
+      if (!event.sender.isDestroyed()) {
+        event.sender.send(IPC_CHANNELS.MEETING_EXPORT_PROGRESS, { meetingId: id, fraction });
+      }
+    });
+  });
+
   ipcMain.handle(
     IPC_CHANNELS.MEETING_ASK_NOTES,
     async (_, meetingId: string, query: string) => {
@@ -2,6 +2,7 @@ import { ipcMain } from 'electron';
 import { IPC_CHANNELS } from '@shared/ipcChannels';
 import { getContainer } from '../core/container';
 import { createLogger } from '../core/logger';
+import type { PeoplePageCursor } from '@shared/types';
 
 const logger = createLogger('PeopleHandlers');
 
@@ -21,6 +22,16 @@ export function registerPeopleHandlers(): void {
     }
   });
 
+  // One page of people, from a cursor
+  ipcMain.handle(IPC_CHANNELS.PEOPLE_LIST_PAGE, async (_, after?: PeoplePageCursor | null, limit?: number) => {
+    try {
+      return peopleRepo.listPage(after ?? null, limit);
+    } catch (error) {
+      logger.error('Failed to list people page', { error: (error as Error).message });
+      throw error;
+    }
+  });
+
   // Search people
   ipcMain.handle(IPC_CHANNELS.PEOPLE_SEARCH, async (_, query: string) => {
     logger.debug('Searching people', { query });
@@ -1,23 +1,48 @@
-import { ipcMain, BrowserWindow } from 'electron';
+import { app, ipcMain, BrowserWindow } from 'electron';
+import { mkdirSync } from 'fs';
+import { join } from 'path';
 import { IPC_CHANNELS } from '@shared/ipcChannels';
 import { getContainer } from '../core/container';
 import { createLogger } from '../core/logger';
-import { createTranscriptionProvider, ITranscriptionProvider } from '../services/transcription';
+import {
+  alignMeetingWords,
+  BatchTranscriber,
+  batchWorkDir,
+  createTranscriptionProvider,
+  ITranscriptionProvider,
+  recordingTracks,
+} from '../services/transcription';
 import { SystemAudioService } from '../services/SystemAudioService';
 import { CalloutService } from '../services/CalloutService';
-import { AECProcessor } from '../audio/native/AECProcessor';
-import { AECSync } from '../audio/AECSync';
+import { AECConfig, AECProcessor, MicEngine, StreamLevel } from '../audio/native/AECProcessor';
+import { AudioEngineHost } from '../audio/engine/AudioEngineHost';
+import type { EngineCaptureOptions } from '../audio/engine/protocol';
+import { listAecProfiles, loadAecProfile, saveAecProfile } from '../audio/aecProfiles';
+import { loadNoiseProfile, saveNoiseProfile } from '../audio/noiseProfiles';
+import { loadVoiceprint, saveVoiceprint } from '../audio/voiceprint';
 import { showCalloutWindow } from '../windows/calloutWindow';
-import { AUDIO_CONFIG, matchesQuestionPattern } from '../config/constants';
+import {
+  AUDIO_CONFIG,
+  LOCAL_ASR_CONFIG,
+  ENDPOINT_CONFIG,
+  KEYWORD_SPOTTING_CONFIG,
+  LOCAL_DENOISE_CONFIG,
+  PERFORMANCE_CONFIG,
+  RECORDING_CONFIG,
+  SILENCE_GATE_CONFIG,
+  VOICE_VERIFY_CONFIG,
+} from '../config/constants';
 import { getDatabase, saveDatabase } from '../data/database';
-import type { CalendarAttendee } from '@shared/types';
+import type { AppSettings, CalendarAttendee, TranscriptSegment } from '@shared/types';
 
 const logger = createLogger('RecordingHandlers');
 
 let transcriptionProvider: ITranscriptionProvider | null = null;
 let systemAudioService: SystemAudioService | null = null;
 let aecProcessor: AECProcessor | null = null;
-let aecSync: AECSync | null = null;
+// Set while settings.isolatedCapture has the mic and system streams in the
+// audio engine process; aecProcessor then only serves the module itself
+let audioEngine: AudioEngineHost | null = null;
 let activeCalendarContext: {
   calendarEventId: string;
   calendarEventTitle: string;
@@ -28,11 +53,103 @@ let activeCalendarContext: {
 } | null = null;
 let isPaused = false;
 
-// NEW: Audio buffering for mic capture
-let micAudioBuffer: Int16Array = new Int16Array(0);
-const MIN_BUFFER_SAMPLES = 2400; // 50ms at 48kHz (AssemblyAI minimum)
+// Mic audio is chunked natively; 50ms is the AssemblyAI minimum
+const MIC_CHUNK_MS = 50;
 let micAudioDataCount = 0;
 
+// Polls the first verifying recording's voice enrollment until it keeps one
+let voiceEnrollmentTimer: ReturnType<typeof setInterval> | null = null;
+
+function stopVoiceEnrollment(): void {
+  if (voiceEnrollmentTimer) {
+    clearInterval(voiceEnrollmentTimer);
+    voiceEnrollmentTimer = null;
+    aecProcessor?.cancelVoiceEnrollment();
+  }
+}
+
+// The mic engine for the captureEngine setting; each system's own canceller
+// only on its platform
+function micEngineFor(captureEngine: AppSettings['captureEngine']): MicEngine {
+  if (process.platform === 'darwin' && captureEngine === 'voiceProcessing') return 'voiceProcessing';
+  if (process.platform === 'win32' && captureEngine === 'communications') return 'communications';
+  return AUDIO_CONFIG.MIC_ENGINE;
+}
+
+// Same scaling SystemAudioService applies to its JS RMS
+function meterLevel(level: StreamLevel | undefined): number {
+  return Math.min(1, (level?.rms ?? 0) * 3);
+}
+
+// The same, over a delivery's PCM16, for streams the native meter cannot see
+function pcm16Level(samples: Int16Array): number {
+  if (samples.length === 0) return 0;
+  let sum = 0;
+  for (let i = 0; i < samples.length; i++) {
+    const s = samples[i] / 32768;
+    sum += s * s;
+  }
+  return Math.min(1, Math.sqrt(sum / samples.length) * 3);
+}
+
+/**
+ * Forks the audio engine with the recording's AEC config; null, leaving
+ * capture in-process, when it does not come up with the addon loaded
+ */
+async function startAudioEngine(config: AECConfig, processor: AECProcessor): Promise<AudioEngineHost | null> {
+  const host = new AudioEngineHost({
+    aec: config,
+    openRing: (name) => processor.openSharedMemoryRing(name),
+    onExit: (code) => {
+      logger.error('Audio engine exited mid-meeting; capture has stopped', { code });
+    },
+  });
+  if (await host.start()) {
+    return host;
+  }
+  await host.stop();
+  logger.warn('Audio engine unavailable; capturing in-process');
+  return null;
+}
+
+/**
+ * Starts re-transcribing the meeting's recording with the provider's batch
+ * API; null when there is no recording or no batch API. Resolves null if it
+ * fails, which keeps the live transcript.
+ */
+function startRetranscription(
+  processor: AECProcessor | null,
+  meetingId: string | null
+): Promise<TranscriptSegment[] | null> | null {
+  if (!processor || !meetingId) return null;
+  const { meetingRepo, settingsRepo } = getContainer();
+  const meeting = meetingRepo.findById(meetingId);
+  if (!meeting?.recordingIndex || meeting.recordingStartedAt == null) return null;
+
+  const settings = settingsRepo.getSettings();
+  const apiKey = settings.transcriptionProvider === 'deepgram'
+    ? settings.deepgramApiKey
+    : settings.assemblyAiApiKey;
+  const batch = new BatchTranscriber(settings.transcriptionProvider, apiKey);
+  const tracks = recordingTracks(meeting.recordingIndex);
+  if (!batch.isAvailable() || tracks.length === 0) return null;
+
+  logger.info('Batch re-transcription started', { meetingId, tracks: tracks.map((t) => t.source) });
+  return batch
+    .transcribe((options) => processor.segmentRecording(options), {
+      tracks,
+      recordingStartedAt: meeting.recordingStartedAt,
+      transcriptStartedAt: meeting.createdAt.getTime(),
+      workDir: batchWorkDir(app.getPath('userData'), meetingId),
+    })
+    .catch((error) => {
+      logger.warn('Batch re-transcription failed; keeping the live transcript', {
+        error: (error as Error).message,
+      });
+      return null;
+    });
+}
+
 export function registerRecordingHandlers(
   mainWindow: BrowserWindow,
   calloutWindow: BrowserWindow
@@ -41,7 +158,8 @@ export function registerRecordingHandlers(
 
   ipcMain.handle(IPC_CHANNELS.RECORDING_START, async (_, calendarContext?: any) => {
     logger.info('Recording start requested', { hasCalendarContext: !!calendarContext });
-    const { meetingRepo, settingsRepo } = getContainer();
+    const { meetingRepo, settingsRepo, triggerService, meetingNotificationService } = getContainer();
+    meetingNotificationService.setRecordingActive(true);
     const settings = settingsRepo.getSettings();
     logger.debug('Transcription provider', { provider: settings.transcriptionProvider });
 
@@ -70,27 +188,65 @@ export function registerRecordingHandlers(
 
     // Initialize AEC processor for echo cancellation
     try {
-      aecProcessor = new AECProcessor({
+      const aecConfig: AECConfig = {
         enableAec: true,
         enableNs: true,
         enableAgc: false,
         frameDurationMs: 10,
         sampleRate: AUDIO_CONFIG.SAMPLE_RATE,
-      });
+        // The cleaned mic only feeds transcription at 16kHz
+        processingSampleRate: AUDIO_CONFIG.MIC_SAMPLE_RATE,
+        // audiotee chunks are handed over interleaved, without a JS downmix
+        renderChannels: AUDIO_CONFIG.CHANNELS,
+      };
+      aecProcessor = new AECProcessor(aecConfig);
       logger.info('✅ AEC processor initialized for recording session');
-
-      // Initialize AECSync for render/capture synchronization
-      try {
-        aecSync = new AECSync(aecProcessor);
-        logger.info('✅ AECSync initialized for recording session');
-      } catch (error) {
-        logger.error('Failed to initialize AECSync', { error: (error as Error).message });
-        aecSync = null;
+      // The engine runs its own AEC from this config, without the profiles
+      // below, which read and tune the in-process capture
+      audioEngine = settings.isolatedCapture ? await startAudioEngine(aecConfig, aecProcessor) : null;
+      if (!audioEngine) {
+        // Known hardware: start AEC3 where the last meeting on it converged
+        const devices = aecProcessor.getAecProfile();
+        const warmStart = devices?.inputDeviceUid && devices.outputDeviceUid
+          ? loadAecProfile(devices.inputDeviceUid, devices.outputDeviceUid)
+          : null;
+        // And with the mic's noise already known, so the first seconds are
+        // neither under-suppressed nor taken for speech
+        const noiseProfile = devices?.inputDeviceUid ? loadNoiseProfile(devices.inputDeviceUid) : null;
+        if (warmStart || noiseProfile) {
+          aecProcessor.applyAecProfile(warmStart ?? {}, noiseProfile);
+        }
+        // And where a device switch mid-meeting lands
+        aecProcessor.setAecProfiles(listAecProfiles());
+        // Long meetings on battery: lighter AEC and fewer wake-ups
+        aecProcessor.setPowerProfile('auto');
+        // Mic capture only starts once transcription and system audio are up;
+        // build its AudioUnit meanwhile so the start itself is near-instant
+        void aecProcessor.prepareMicrophoneCapture({
+          engine: micEngineFor(settings.captureEngine),
+          outputSampleRate: AUDIO_CONFIG.MIC_SAMPLE_RATE,
+          processed: aecProcessor.isReady(),
+        });
+        aecProcessor.onCaptureRecovered((event) => {
+          logger.warn('Microphone capture recovered', { ...event });
+        });
+      }
+      // Keep the meeting's audio for playback; tracks fill in as capture
+      // starts, in whichever process captures
+      const recordingDir = join(app.getPath('userData'), RECORDING_CONFIG.DIR, meetingId);
+      mkdirSync(recordingDir, { recursive: true });
+      const recordingOptions = { directory: recordingDir, name: RECORDING_CONFIG.NAME };
+      const recording = audioEngine
+        ? await audioEngine.startRecording(recordingOptions)
+        : aecProcessor.startRecording(recordingOptions);
+      if (!recording) {
+        logger.warn('Native recording unavailable; the meeting will have no audio');
       }
     } catch (error) {
       logger.error('Failed to initialize AEC processor', { error: (error as Error).message });
       aecProcessor = null;
-      aecSync = null;
+      void audioEngine?.stop();
+      audioEngine = null;
       // Continue without AEC if initialization fails
     }
 
@@ -99,9 +255,27 @@ export function registerRecordingHandlers(
       settings.assemblyAiApiKey,
       settings.deepgramApiKey,
       undefined,
-      settings.useHostedTokens
+      settings.useHostedTokens,
+      settings.localModelPath ||
+        join(app.getPath('userData'), LOCAL_ASR_CONFIG.MODELS_DIR, LOCAL_ASR_CONFIG.DEFAULT_MODEL),
+      settings.transcriptionLanguage
     );
     logger.info('Using transcription provider', { name: transcriptionProvider.name });
+    // Providers that speak their protocol natively stream the mic from the
+    // capture thread; the rest keep sendAudio()
+    if (aecProcessor) {
+      transcriptionProvider.useNativeTransport?.(
+        (options) => aecProcessor?.createTranscriptionSocket(options) ?? null,
+        (options) => aecProcessor?.createChannelInterleaver(options) ?? null
+      );
+      transcriptionProvider.useLocalEngine?.((options) => aecProcessor?.createLocalTranscriber(options) ?? null);
+    }
+
+    // The system utterance so far, for prefetching its callout at the native
+    // end, and its native boundaries, for naming its speaker
+    let systemInterimText = '';
+    let systemUtteranceStart = 0;
+    let systemUtteranceEnd = 0;
 
     // Set up transcript forwarding
     transcriptionProvider.onTranscript((segment, isFinal) => {
@@ -111,6 +285,16 @@ export function registerRecordingHandlers(
         textPreview: segment.text.slice(0, 30),
       });
 
+      // Finals from system audio go to whoever the native speaker IDs heard
+      // most in their utterance, unless the provider diarized them already
+      if (isFinal && segment.source === 'system' && !segment.speakerId && systemUtteranceStart > 0) {
+        const end = systemUtteranceEnd > systemUtteranceStart ? systemUtteranceEnd : Date.now();
+        const speaker = systemAudioService?.speakerBetween(systemUtteranceStart, end) ?? null;
+        if (speaker !== null) {
+          segment.speakerId = String(speaker);
+        }
+      }
+
       const channel = isFinal ? IPC_CHANNELS.TRANSCRIPT_FINAL : IPC_CHANNELS.TRANSCRIPT_UPDATE;
 
       mainWindow.webContents.send(channel, {
@@ -118,6 +302,14 @@ export function registerRecordingHandlers(
         meetingId: meetingRepo.getCurrentMeetingId(),
       });
 
+      // Questions and keywords from system audio (other speakers); interim
+      // text is scanned as it grows, hits come with the final
+      const hits =
+        segment.source === 'system' ? triggerService.scan(segment.source, segment.text, isFinal) : null;
+      if (segment.source === 'system') {
+        systemInterimText = isFinal ? '' : segment.text;
+      }
+
       // Store final segments and process callout logic
       if (isFinal) {
         meetingRepo.addTranscriptSegment(segment);
@@ -125,12 +317,17 @@ export function registerRecordingHandlers(
         // Add to callout service sliding window for context
         calloutService.addTranscriptSegment(segment);
 
-        // Check for questions from system audio (other speakers)
-        if (segment.source === 'system' && matchesQuestionPattern(segment.text)) {
-          calloutService.scheduleCallout(segment.text, (callout) => {
-            calloutWindow.webContents.send(IPC_CHANNELS.CALLOUT_SHOW, callout);
-            showCalloutWindow();
-          });
+        // A question by intonation alone counts when the text says statement
+        const question = hits && (hits.question || calloutService.endedAsQuestion());
+        if (hits && ((question && settings.autoDetectQuestions) || hits.keywords.length > 0)) {
+          calloutService.scheduleCallout(
+            segment.text,
+            (callout) => {
+              calloutWindow.webContents.send(IPC_CHANNELS.CALLOUT_SHOW, callout);
+              showCalloutWindow();
+            },
+            hits.keywords
+          );
         }
 
         // Check if mic response should cancel pending callout
@@ -148,35 +345,96 @@ export function registerRecordingHandlers(
         if (transcriptionProvider) {
           systemAudioService = new SystemAudioService();
 
-          // Pass shared AEC processor
-          if (aecProcessor) {
+          // Pass shared AEC processor; it receives system audio as the render reference
+          // (the engine's tap is its own AEC's reference)
+          if (audioEngine) {
+            systemAudioService.setAudioEngine(audioEngine);
+          } else if (aecProcessor) {
             systemAudioService.setAECProcessor(aecProcessor);
           }
 
-          // Feed system audio to AECSync for synchronization
-          if (aecSync) {
-            systemAudioService.onSystemAudio((samples, timestamp) => {
-              // Null-safety check: aecSync might be cleaned up during shutdown
-              if (aecSync) {
-                aecSync.addRenderAudio(samples, timestamp);
-              }
-            });
-          }
-
           systemAudioService.onAudioLevel((level) => {
             mainWindow.webContents.send(IPC_CHANNELS.AUDIO_LEVELS, { system: level });
           });
 
+          // Native utterance ends time callouts from when the question was asked
+          systemAudioService.onEndpoint((endpoint) => {
+            if (endpoint.type === 'start') {
+              systemUtteranceStart = endpoint.timestamp;
+            }
+            if (endpoint.type === 'end') {
+              systemUtteranceEnd = endpoint.timestamp;
+              calloutService.noteUtteranceEnd(endpoint.timestamp);
+              const likelihood = endpoint.prosody?.questionLikelihood ?? -1;
+              if (settings.autoDetectQuestions && likelihood >= ENDPOINT_CONFIG.QUESTION_LIKELIHOOD) {
+                calloutService.noteProsodicQuestion(endpoint.timestamp, systemInterimText);
+              }
+              transcriptionProvider?.notifyUtteranceEnd?.('system');
+            }
+          });
+
+          // Native meters at display rate: the mic always, system audio once
+          // the addon captures it too, in place of JS RMS over every chunk.
+          // The engine's streams are metered from their deliveries instead.
+          let nativeSystemLevels = false;
+          const inProcess = audioEngine ? null : aecProcessor;
+          const nativeMeters = inProcess?.startLevelMeter((levels) => {
+            const update: { mic: number; system?: number } = { mic: meterLevel(levels.mic) };
+            if (nativeSystemLevels) {
+              update.system = meterLevel(levels.system);
+            }
+            mainWindow.webContents.send(IPC_CHANNELS.AUDIO_LEVELS, update);
+          }, { rateHz: 30 }) ?? false;
+
+          // Pipeline health over the meeting, stored with it at stop
+          inProcess?.startPerformanceReport({ intervalMs: PERFORMANCE_CONFIG.INTERVAL_MS });
+
+          // Native mic and tap count sample positions from one instant, so
+          // render and capture line up from the first frame
+          const sharedStart = inProcess?.armSharedStart() ?? null;
+
           systemAudioService
             .start(transcriptionProvider)
-            .then(() => {
+            .then(async () => {
               logger.info('System audio capture started');
+              if (nativeMeters && aecProcessor?.isSystemAudioCapturing()) {
+                nativeSystemLevels = true;
+                systemAudioService?.onAudioLevel(null);
+              }
+
+              // Keywords heard on-device start their context lookup before
+              // the transcript that will bring up the callout arrives
+              const keywords = (settings.calloutKeywords ?? []).map((k) => k.trim()).filter((k) => k.length > 0);
+              if (settings.keywordSpotting && keywords.length > 0 && aecProcessor?.isSystemAudioCapturing()) {
+                const spotting = aecProcessor.startKeywordSpotter({
+                  model: join(app.getPath('userData'), LOCAL_ASR_CONFIG.MODELS_DIR, KEYWORD_SPOTTING_CONFIG.DEFAULT_MODEL),
+                  keywords: keywords.map((text) => ({ text, threshold: KEYWORD_SPOTTING_CONFIG.THRESHOLD })),
+                }, (event) => {
+                  logger.debug('Keyword spotted', {
+                    keyword: event.keyword,
+                    confidence: event.confidence,
+                    latencyMs: Math.round(event.detectedMs - event.endMs),
+                  });
+                  calloutService.noteSpokenKeyword(event.keyword, event.endMs);
+                });
+                logger.info('Keyword spotting', { started: spotting, keywords: keywords.length });
+              }
 
               // NEW: Start native microphone capture AFTER system audio is ready
               if (aecProcessor && transcriptionProvider) {
                 const tp = transcriptionProvider; // Capture in closure
+                // AEC runs in the addon: render comes from the native tap or, with
+                // audiotee, from SystemAudioService and is aligned natively by timestamp
+                // Apple's voice unit cancels in coreaudiod instead, so AEC3 stays off
+                // The endpoint's AEC ('communications') is only known at start,
+                // so processed stays on and the addon bypasses AEC3 if it runs
+                const micEngine = micEngineFor(settings.captureEngine);
+                const nativeAec = aecProcessor.isReady() && micEngine !== 'voiceProcessing';
+                const verifyVoice = (settings.verifyMicSpeaker ?? false) && SILENCE_GATE_CONFIG.ENABLED;
+                const voiceprint = verifyVoice ? loadVoiceprint() : null;
                 
-                const success = aecProcessor.startMicrophoneCapture((samples, timestamp) => {
+                // Both capture paths hand their deliveries here
+                const sendMic = (samples: Int16Array, timestamp: number, sampleIndex: number, silenceMs?: number) => {
                   // This callback runs in main process with native timestamps!
                   micAudioDataCount++;
                   if (micAudioDataCount % AUDIO_CONFIG.PACKET_LOG_INTERVAL === 1) {
@@ -192,109 +450,106 @@ export function registerRecordingHandlers(
                     return;
                   }
 
-                  // Process mic audio through AEC with synchronized timestamps
-                  let cleanFloat32: Float32Array | null = null;
-
-                  if (aecSync) {
-                    // Use synchronized AEC processing with native timestamp!
-                    cleanFloat32 = aecSync.processCaptureWithSync(samples, timestamp);
-                    
-                    // Log sync stats occasionally
-                    if (micAudioDataCount % 100 === 0) {
-                      const stats = aecSync.getStats();
-                      logger.debug('AEC sync performance', {
-                        syncRate: `${stats.syncRate.toFixed(1)}%`,
-                        bufferSize: stats.bufferSize,
-                        packet: micAudioDataCount
-                      });
-                    }
-                  } else if (aecProcessor && aecProcessor.isReady()) {
-                    // Fallback: direct AEC without sync
-                    cleanFloat32 = aecProcessor.processCaptureAudio(samples);
+                  // Gate marker: the speech run before it was already
+                  // delivered natively, partial last chunk included
+                  if (silenceMs !== undefined) {
+                    tp.notifySilence?.(silenceMs, 'mic');
+                    return;
                   }
 
-                  if (cleanFloat32 && cleanFloat32.length > 0) {
-                    // Convert echo-cancelled audio to Int16
-                    const cleanInt16 = new Int16Array(cleanFloat32.length);
-                    for (let i = 0; i < cleanFloat32.length; i++) {
-                      cleanInt16[i] = Math.max(-32768, Math.min(32767, cleanFloat32[i] * 32768));
-                    }
-                    
-                    // Buffer the audio
-                    const newBuffer = new Int16Array(micAudioBuffer.length + cleanInt16.length);
-                    newBuffer.set(micAudioBuffer);
-                    newBuffer.set(cleanInt16, micAudioBuffer.length);
-                    micAudioBuffer = newBuffer;
-                    
-                    // Debug: Check buffer status
-                    if (micAudioDataCount === 5 || micAudioDataCount === 10 || micAudioDataCount === 15) {
-                      logger.info('🔍 Buffer check (AEC path)', {
-                        bufferSize: micAudioBuffer.length,
-                        needed: MIN_BUFFER_SAMPLES,
-                        chunk: micAudioDataCount,
-                        justAdded: cleanInt16.length
-                      });
-                    }
-                    
-                    // Send if buffer is large enough (50ms minimum for AssemblyAI)
-                    if (micAudioBuffer.length >= MIN_BUFFER_SAMPLES) {
-                      logger.info('📤 Sending mic audio to AssemblyAI (AEC)', { 
-                        samples: micAudioBuffer.length, 
-                        bytes: micAudioBuffer.buffer.byteLength,
-                        firstSample: micAudioBuffer[0],
-                        maxSample: Math.max(...Array.from(micAudioBuffer))
-                      });
-                      tp.sendAudio(micAudioBuffer.buffer as ArrayBuffer, 'mic');
-                      micAudioBuffer = new Int16Array(0); // Reset buffer
-                    }
-                  } else {
-                    // Fallback to raw audio if AEC processing fails
-                    if (micAudioDataCount % 100 === 1) {
-                      logger.warn('AEC processing returned empty, using raw mic audio', { micAudioDataCount });
-                    }
-                    const rawInt16 = new Int16Array(samples.length);
-                    for (let i = 0; i < samples.length; i++) {
-                      rawInt16[i] = Math.max(-32768, Math.min(32767, samples[i] * 32768));
-                    }
-                    
-                    // Buffer the raw audio
-                    const newBuffer = new Int16Array(micAudioBuffer.length + rawInt16.length);
-                    newBuffer.set(micAudioBuffer);
-                    newBuffer.set(rawInt16, micAudioBuffer.length);
-                    micAudioBuffer = newBuffer;
-                    
-                    // Debug: Check buffer status
-                    if (micAudioDataCount === 5 || micAudioDataCount === 10 || micAudioDataCount === 15) {
-                      logger.info('🔍 Buffer check', {
-                        bufferSize: micAudioBuffer.length,
-                        needed: MIN_BUFFER_SAMPLES,
-                        chunk: micAudioDataCount,
-                        justAdded: rawInt16.length
-                      });
-                    }
-                    
-                    // Send if buffer is large enough
-                    if (micAudioBuffer.length >= MIN_BUFFER_SAMPLES) {
-                      logger.info('📤 Sending mic audio to AssemblyAI', { 
-                        samples: micAudioBuffer.length, 
-                        bytes: micAudioBuffer.buffer.byteLength,
-                        firstSample: micAudioBuffer[0],
-                        maxSample: Math.max(...Array.from(micAudioBuffer))
-                      });
-                      tp.sendAudio(micAudioBuffer.buffer as ArrayBuffer, 'mic');
-                      micAudioBuffer = new Int16Array(0);
-                    }
+                  // Native delivery is already transcription-ready: 16kHz PCM16
+                  // in MIC_CHUNK_MS chunks that own their ArrayBuffer,
+                  // echo-cancelled on the DSP thread when nativeAec is set
+                  if (tp.sendAudio(samples.buffer as ArrayBuffer, 'mic') && !audioEngine) {
+                    aecProcessor?.markAudioSent('mic', sampleIndex);
                   }
-                });
+                };
+                const micOptions: EngineCaptureOptions = {
+                  processed: nativeAec,
+                  engine: micEngine,
+                  beamform: AUDIO_CONFIG.MIC_BEAMFORM,
+                  outputSampleRate: AUDIO_CONFIG.MIC_SAMPLE_RATE,
+                  format: 'pcm16',
+                  chunkMs: MIC_CHUNK_MS,
+                  // The canceller tells echo of the far end from our own
+                  // speech, so leaked remote audio never opens the gate
+                  talk: nativeAec,
+                  // Bystanders near the mic are held from the gate like echo
+                  verifyVoice,
+                  voiceprint: voiceprint ?? undefined,
+                  // Typing during the call is ducked before the gate's VAD
+                  declick: SILENCE_GATE_CONFIG.DECLICK,
+                  // Opt-in; without the model file the stream is delivered as captured
+                  denoiseModel: settings.neuralDenoise
+                    ? join(app.getPath('userData'), LOCAL_ASR_CONFIG.MODELS_DIR, LOCAL_DENOISE_CONFIG.DEFAULT_MODEL)
+                    : undefined,
+                  // Dead air is dropped natively instead of streamed and billed
+                  gate: SILENCE_GATE_CONFIG.ENABLED && {
+                    threshold: SILENCE_GATE_CONFIG.THRESHOLD,
+                    hangoverMs: SILENCE_GATE_CONFIG.HANGOVER_MS,
+                    prerollMs: SILENCE_GATE_CONFIG.PREROLL_MS,
+                    silenceMarkerMs: SILENCE_GATE_CONFIG.SILENCE_MARKER_MS,
+                  },
+                };
+
+                // The engine's mic reaches the provider through sendAudio()
+                // only; its ring carries the gate's markers as silenceMs
+                const success = audioEngine
+                  ? await audioEngine.startCapture('mic', micOptions, (delivery) => {
+                      const samples = delivery.samples as Int16Array;
+                      if (delivery.silenceMs > 0) {
+                        sendMic(samples, delivery.timestamp, delivery.sampleIndex, delivery.silenceMs);
+                        return;
+                      }
+                      mainWindow.webContents.send(IPC_CHANNELS.AUDIO_LEVELS, { mic: pcm16Level(samples) });
+                      sendMic(samples, delivery.timestamp, delivery.sampleIndex);
+                    })
+                  : await aecProcessor.startMicrophoneCapture((
+                      samples: Int16Array,
+                      timestamp: number,
+                      sampleIndex: number,
+                      _hostTimeMs: number,
+                      _vad?: Float32Array,
+                      silenceMs?: number
+                    ) => sendMic(samples, timestamp, sampleIndex, silenceMs), {
+                      ...micOptions,
+                      // Chunks then go to the provider without this callback
+                      transport: tp.getNativeTransport?.('mic') ?? undefined,
+                    });
 
+                inProcess?.armSharedStart(false);
                 if (success) {
-                  logger.info('✅ Native microphone capture started (perfect sync with system audio!)');
+                  logger.info('✅ Native microphone capture started (perfect sync with system audio!)', {
+                    sharedStart: sharedStart?.timestamp,
+                    engine: micEngine,
+                    audioEngine: !!audioEngine,
+                  });
+                  // No voiceprint yet: this recording's own speech makes one,
+                  // on an in-process verifier
+                  if (verifyVoice && !voiceprint && inProcess?.startVoiceEnrollment()) {
+                    voiceEnrollmentTimer = setInterval(() => {
+                      const stats = aecProcessor?.getVoiceVerifierStats();
+                      if (!stats || stats.enrollmentSeconds < VOICE_VERIFY_CONFIG.ENROLL_SECONDS) {
+                        return;
+                      }
+                      const enrolled = aecProcessor?.finishVoiceEnrollment();
+                      if (voiceEnrollmentTimer) {
+                        clearInterval(voiceEnrollmentTimer);
+                        voiceEnrollmentTimer = null;
+                      }
+                      if (enrolled) {
+                        saveVoiceprint(enrolled.voiceprint);
+                        logger.info('Voice enrolled', { speechSeconds: enrolled.speechSeconds });
+                      }
+                    }, VOICE_VERIFY_CONFIG.ENROLL_POLL_MS);
+                  }
                 } else {
                   logger.error('❌ Failed to start native microphone capture');
                 }
               }
             })
             .catch((error) => {
+              inProcess?.armSharedStart(false);
               logger.error('System audio capture failed', error);
             });
         }
@@ -308,7 +563,14 @@ export function registerRecordingHandlers(
 
   ipcMain.handle(IPC_CHANNELS.RECORDING_STOP, async () => {
     logger.info('Recording stop requested');
-    const { meetingRepo, noteGenerationService, calendarService } = getContainer();
+    const {
+      meetingRepo,
+      performanceRepo,
+      noteGenerationService,
+      calendarService,
+      triggerService,
+      meetingNotificationService,
+    } = getContainer();
     const meetingId = meetingRepo.getCurrentMeetingId();
     const calendContext = activeCalendarContext;
     activeCalendarContext = null;
@@ -317,6 +579,10 @@ export function registerRecordingHandlers(
 
     // Cancel any pending callouts immediately to prevent timer firing during cleanup
     calloutService.reset();
+    triggerService.reset();
+    meetingNotificationService.setRecordingActive(false);
+    aecProcessor?.stopKeywordSpotter();
+    stopVoiceEnrollment();
 
     // CRITICAL: Stop audio capture FIRST before cleaning up AEC resources
     // This prevents race conditions where callbacks try to access null AEC objects
@@ -329,24 +595,82 @@ export function registerRecordingHandlers(
       logger.info('System audio capture stopped');
     }
 
+    aecProcessor?.stopLevelMeter();
+
     // Step 2: Stop native mic capture
-    if (aecProcessor && aecProcessor.isMicrophoneCapturing()) {
+    if (audioEngine) {
+      logger.info('Stopping audio engine microphone capture');
+      await audioEngine.stopCapture('mic');
+    } else if (aecProcessor && aecProcessor.isMicrophoneCapturing()) {
       logger.info('Stopping native microphone capture');
-      aecProcessor.stopMicrophoneCapture();
+      await aecProcessor.stopMicrophoneCapture();
+    }
+
+    const voiceStats = aecProcessor?.getVoiceVerifierStats();
+    if (voiceStats) {
+      logger.info('Mic voice verification', voiceStats);
+    }
+
+    // Capture-side health for this session, to line up against transcription gaps
+    const captureStats = audioEngine ? (await audioEngine.getStats())?.capture : aecProcessor?.getCaptureStats();
+    if (captureStats) {
+      // mic.cpuMsPerSecond by micEngine compares the engines
+      logger.info('Native capture stats', {
+        micEngine: captureStats.micEngine,
+        beamLagsMs: captureStats.beamLagsMs,
+        mic: captureStats.mic,
+        system: captureStats.system,
+        voiceProcessing: captureStats.voiceProcessing,
+        endpointAec: captureStats.endpointAec,
+      });
+    }
+    const aecMetrics = aecProcessor?.getMetrics();
+    if (aecMetrics?.processingLoad !== undefined) {
+      logger.info('AEC processing load', {
+        processingSampleRate: aecMetrics.processingSampleRate,
+        loadPercent: (aecMetrics.processingLoad * 100).toFixed(2),
+      });
+    }
+    const performanceReport = aecProcessor?.stopPerformanceReport() ?? null;
+    // Only the in-process capture tunes these; the engine's is gone with it
+    const aecProfile = audioEngine ? null : aecProcessor?.getAecProfile();
+    if (aecProfile) {
+      saveAecProfile(aecProfile);
+    }
+    const noiseProfile = audioEngine ? null : aecProcessor?.getNoiseProfile();
+    if (noiseProfile) {
+      saveNoiseProfile(noiseProfile);
+    }
+
+    // Close the recording and point the meeting at it; any track's index
+    // finds the others, and its header holds the recording's time 0
+    const recording = audioEngine ? await audioEngine.stopRecording() : aecProcessor?.stopRecording();
+    const recordingIndex =
+      recording?.indexes.processed ?? recording?.indexes.microphone ?? recording?.indexes.system;
+    const recordingInfo = recordingIndex ? aecProcessor?.openRecording(recordingIndex)?.getInfo() : null;
+    if (meetingId && recordingIndex && recordingInfo) {
+      meetingRepo.setRecording(meetingId, recordingIndex, recordingInfo.startedAt);
+      logger.info('Recording stored', { meetingId, durationMs: recordingInfo.durationMs });
+    }
+
+    // The engine has nothing left to capture or record
+    if (audioEngine) {
+      const engine = audioEngine;
+      audioEngine = null;
+      await engine.stop().catch((error) => logger.error('Audio engine stop error', error));
+      logger.info('Audio engine stopped');
     }
 
     // Step 3: Wait for any in-flight audio callbacks to complete
     await new Promise((resolve) => setTimeout(resolve, 100));
 
-    // Step 4: Now safe to clean up AEC resources
-    // Clean up AEC sync
-    if (aecSync) {
-      const finalStats = aecSync.getStats();
-      logger.info('Final AEC sync stats', finalStats);
-      aecSync.clear();
-      aecSync = null;
-    }
+    // Split the recording for the batch pass while the native module is
+    // loaded; the job runs on through destroy()
+    const retranscription = startRetranscription(aecProcessor, meetingId);
+    // Word alignment starts once the transcript is final, after destroy()
+    const aligner = aecProcessor?.transcriptAligner() ?? null;
 
+    // Step 4: Now safe to clean up AEC resources
     // Clean up AEC processor
     if (aecProcessor) {
       try {
@@ -357,9 +681,8 @@ export function registerRecordingHandlers(
       aecProcessor = null;
     }
 
-    // Reset mic audio counter and buffer
+    // Reset mic audio counter
     micAudioDataCount = 0;
-    micAudioBuffer = new Int16Array(0);
 
     // Disconnect transcription and wait for it to flush
     if (transcriptionProvider) {
@@ -377,12 +700,36 @@ export function registerRecordingHandlers(
     const meeting = await meetingRepo.endCurrentMeeting();
     logger.info('Meeting ended', { id: meeting?.id, transcriptCount: meeting?.transcript.length });
 
+    // Kept with the meeting, to look back on when its transcript was poor
+    if (meeting && performanceReport) {
+      try {
+        performanceRepo.save(meeting.id, performanceReport, app.getVersion(), process.platform);
+      } catch (error) {
+        logger.warn('Failed to store performance report', { meetingId: meeting.id, error: (error as Error).message });
+      }
+    }
+
     // Auto-generate notes in background
     if (meeting && meetingId) {
       mainWindow.webContents.send(IPC_CHANNELS.MEETING_NOTES_GENERATING, { meetingId: meeting.id });
 
+      // The batch transcript is the more accurate one to write notes from
+      const batchTranscript = retranscription ? await retranscription : null;
+      if (batchTranscript && batchTranscript.length > 0) {
+        meetingRepo.replaceTranscript(meeting.id, batchTranscript);
+      }
+
       // Re-fetch meeting to get all transcript segments
       const fullMeeting = meetingRepo.findById(meeting.id);
+
+      // Click-to-seek wants word times on the recording; notes do not wait
+      if (aligner && fullMeeting) {
+        alignMeetingWords(aligner, fullMeeting, meetingRepo).catch((error) => {
+          logger.warn('Word alignment failed; keeping provider word times', {
+            error: (error as Error).message,
+          });
+        });
+      }
       if (fullMeeting && fullMeeting.transcript.length > 0) {
         // Generate notes safely with try/catch
         try {
@@ -470,6 +817,8 @@ export function registerRecordingHandlers(
     if (systemAudioService) {
       systemAudioService.pause();
     }
+    // Device IO stops; the AEC keeps its convergence for the resume
+    void (audioEngine ? audioEngine.setMicrophonePaused(true) : aecProcessor?.pauseMicrophoneCapture());
     mainWindow.webContents.send(IPC_CHANNELS.RECORDING_STATE, 'paused');
   });
 
@@ -478,12 +827,9 @@ export function registerRecordingHandlers(
     if (systemAudioService) {
       systemAudioService.resume();
     }
+    void (audioEngine ? audioEngine.setMicrophonePaused(false) : aecProcessor?.resumeMicrophoneCapture());
     mainWindow.webContents.send(IPC_CHANNELS.RECORDING_STATE, 'recording');
   });
-
-  // REMOVED: Audio data handler for renderer mic capture
-  // Now using native microphone capture in the main process!
-  // The IPC_CHANNELS.AUDIO_DATA handler is no longer needed for mic audio.
 }
 
 // Expose transcription state for other handlers (e.g., audioHandlers)
@@ -4,6 +4,8 @@ import { app, BrowserWindow, systemPreferences, globalShortcut } from 'electron'
 import { createMainWindow } from './windows/mainWindow';
 import { createCalloutWindow } from './windows/calloutWindow';
 import { initializeDatabase, closeDatabase } from './data/database';
+import { archiveOldMeetings } from './data/transcriptArchive';
+import { installRecordingKey } from './audio/recordingKey';
 import { initializeContainer, getContainer } from './core/container';
 import { registerAllHandlers } from './handlers';
 import { createLogger } from './core/logger';
@@ -47,6 +49,8 @@ async function createWindows() {
 
   await initializeDatabase();
   initializeContainer();
+  // Before any native recording starts or opens
+  installRecordingKey();
 
   mainWindow = createMainWindow();
   calloutWindow = createCalloutWindow();
@@ -60,6 +64,20 @@ async function createWindows() {
   const container = getContainer();
   container.meetingNotificationService.start();
 
+  // Catch the knowledge base up with edits made while the app was closed;
+  // only changed documents are embedded again
+  const { knowledgeBasePath } = container.settingsRepo.getSettings();
+  if (knowledgeBasePath) {
+    container.knowledgeService.index(knowledgeBasePath).catch((error) => {
+      logger.warn('Knowledge base indexing failed', { error: (error as Error).message });
+    });
+  }
+
+  // Compress transcripts of meetings past ARCHIVE_CONFIG.AFTER_DAYS
+  archiveOldMeetings().catch((error) => {
+    logger.warn('Transcript archival failed', { error: (error as Error).message });
+  });
+
   // Dev-only: Start performance logging and register keyboard shortcuts
   if (process.env.NODE_ENV === 'development' || !app.isPackaged) {
     startPerformanceLogging(60000); // Log every 60 seconds
@@ -112,6 +130,7 @@ app.on('before-quit', () => {
   stopPerformanceLogging();
   const container = getContainer();
   container.meetingNotificationService.stop();
+  container.knowledgeService.close();
   closeDatabase();
   logger.info('Application closing');
 });
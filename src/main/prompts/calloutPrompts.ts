@@ -31,7 +31,17 @@ Respond in JSON format:
   "relevantInfo": ["key point 1", "key point 2"] | null
 }`;
 
-export function buildCalloutMessages(question: string, context: string, userProfile?: UserProfile): ChatMessage[] {
+export function buildCalloutMessages(
+  question: string,
+  context: string,
+  userProfile?: UserProfile,
+  keywords: string[] = []
+): ChatMessage[] {
+  // A keyword trigger wants a note on what was mentioned, question or not
+  const keywordInfo =
+    keywords.length > 0
+      ? `\n\nThis came up because it mentions: ${keywords.join(', ')}. Even if it is not a question, return isQuestion: true with a brief note the user should know about it.`
+      : '';
   const userInfo = userProfile
     ? `User info: ${userProfile.name || 'Unknown'}${userProfile.position ? `, ${userProfile.position}` : ''}${userProfile.company ? ` at ${userProfile.company}` : ''}`
     : '';
@@ -45,7 +55,7 @@ export function buildCalloutMessages(question: string, context: string, userProf
 Available context:
 ${context || 'No additional context available.'}
 
-Is this a question I should respond to, and if so, what's a helpful response?`,
+Is this a question I should respond to, and if so, what's a helpful response?${keywordInfo}`,
     },
   ];
 }
@@ -89,6 +89,21 @@ export class OpenAIProvider implements AIProvider {
     }
   }
 
+  /** One vector per text, in order */
+  async embed(texts: string[], model: string = AI_MODELS.EMBEDDING_SMALL): Promise<number[][]> {
+    const timingId = startTiming('openai.embed', { model, count: texts.length });
+
+    try {
+      const client = await this.getClient();
+      const response = await client.embeddings.create({ model, input: texts });
+      endTiming(timingId);
+      return [...response.data].sort((a, b) => a.index - b.index).map((item) => item.embedding);
+    } catch (error) {
+      endTiming(timingId);
+      throw error;
+    }
+  }
+
   async complete(prompt: string, model?: string): Promise<string> {
     return this.chat([{ role: 'user', content: prompt }], { model: model || this.defaultModel });
   }
@@ -2,9 +2,26 @@ import { SalesforceOAuthToken } from '../providers/SalesforceOAuthProvider';
 import { HubSpotOAuthToken } from '../providers/HubSpotOAuthProvider';
 import { createLogger } from '../core/logger';
 import { getContainer } from '../core/container';
+import { CRM_MATCH_CONFIG } from '../config/constants';
+import { createFuzzyMatcher, emailKeys, type FuzzyMatcher } from '../utils/fuzzy';
 
 const logger = createLogger('CRMEmailMatcher');
 
+interface DirectoryContact {
+  id: string;
+  email: string;
+  name?: string;
+}
+
+interface ContactDirectory {
+  fetchedAt: number;
+  contacts: Map<string, DirectoryContact>;
+  matcher: FuzzyMatcher;
+}
+
+// Shared by every matcher, per provider: listing a large org takes a while
+const directories = new Map<string, ContactDirectory>();
+
 export interface ContactMatch {
   email: string;
   crmId: string;
@@ -72,17 +89,78 @@ export class CRMEmailMatcher {
   }
 
   /**
-   * Match multiple emails against a CRM
+   * Match multiple emails against a CRM: exactly by address, then, for
+   * participants whose address the CRM lacks (a personal one, an alias),
+   * by a clear best match on their name
    */
   async matchEmailsToCRM(
     emails: string[],
     provider: 'salesforce' | 'hubspot',
     token: SalesforceOAuthToken | HubSpotOAuthToken
   ): Promise<ContactMatch[]> {
-    if (provider === 'salesforce') {
-      return this.findSalesforceContacts(emails, token as SalesforceOAuthToken);
-    } else {
-      return this.findHubSpotContacts(emails, token as HubSpotOAuthToken);
+    const matches =
+      provider === 'salesforce'
+        ? await this.findSalesforceContacts(emails, token as SalesforceOAuthToken)
+        : await this.findHubSpotContacts(emails, token as HubSpotOAuthToken);
+
+    const matched = new Set(matches.map((match) => match.email.toLowerCase()));
+    const unmatched = emails.filter((email) => !matched.has(email.toLowerCase()));
+    if (unmatched.length === 0) return matches;
+    try {
+      return matches.concat(await this.matchByName(unmatched, provider, token));
+    } catch (error) {
+      logger.warn('Name matching against CRM failed', { provider, error: (error as Error).message });
+      return matches;
     }
   }
+
+  private async matchByName(
+    emails: string[],
+    provider: 'salesforce' | 'hubspot',
+    token: SalesforceOAuthToken | HubSpotOAuthToken
+  ): Promise<ContactMatch[]> {
+    const { peopleRepo } = getContainer();
+    const directory = await this.getDirectory(provider, token);
+    const matches: ContactMatch[] = [];
+    for (const email of emails) {
+      const name = peopleRepo.getByEmail(email)?.name;
+      if (!name) continue;
+      const [best, runnerUp] = directory.matcher.search(name, { limit: 2, minScore: CRM_MATCH_CONFIG.MIN_NAME_SCORE });
+      if (!best || (runnerUp && best.score - runnerUp.score < CRM_MATCH_CONFIG.MIN_NAME_MARGIN)) continue;
+      const contact = directory.contacts.get(best.id);
+      if (!contact) continue;
+      matches.push({ email, crmId: contact.id, crmName: contact.name || contact.email, provider });
+      logger.info('Matched CRM contact by name', { email, contactId: contact.id, score: best.score });
+    }
+    return matches;
+  }
+
+  private async getDirectory(
+    provider: 'salesforce' | 'hubspot',
+    token: SalesforceOAuthToken | HubSpotOAuthToken
+  ): Promise<ContactDirectory> {
+    const cached = directories.get(provider);
+    if (cached && Date.now() - cached.fetchedAt < CRM_MATCH_CONFIG.DIRECTORY_TTL_MS) return cached;
+
+    const { salesforceService, hubSpotService } = getContainer();
+    const listed =
+      provider === 'salesforce'
+        ? await salesforceService.listContacts(
+            token.accessToken,
+            (token as SalesforceOAuthToken).instanceUrl,
+            CRM_MATCH_CONFIG.MAX_DIRECTORY_CONTACTS
+          )
+        : await hubSpotService.listContacts(token.accessToken, CRM_MATCH_CONFIG.MAX_DIRECTORY_CONTACTS);
+
+    const contacts = new Map(listed.map((contact) => [contact.id, contact]));
+    const directory: ContactDirectory = {
+      fetchedAt: Date.now(),
+      contacts,
+      matcher: createFuzzyMatcher(
+        listed.map((contact) => ({ id: contact.id, keys: [contact.name ?? '', ...emailKeys(contact.email)] }))
+      ),
+    };
+    directories.set(provider, directory);
+    return directory;
+  }
 }
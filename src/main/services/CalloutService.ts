@@ -1,10 +1,20 @@
 import { v4 as uuidv4 } from 'uuid';
 import { getContainer } from '../core/container';
 import { createLogger } from '../core/logger';
-import { CALLOUT_CONFIG, CALLOUT_TIMER_CONFIG } from '../config/constants';
+import {
+  CALLOUT_CONFIG,
+  CALLOUT_TIMER_CONFIG,
+  ENDPOINT_CONFIG,
+  KEYWORD_SPOTTING_CONFIG,
+  KNOWLEDGE_CONFIG,
+  PROMPT_CONFIG,
+} from '../config/constants';
 import { buildCalloutMessages, parseCalloutResponse } from '../prompts/calloutPrompts';
 import { buildSummaryMessages } from '../prompts/summaryPrompts';
 import { getSpeakerLabel } from '@shared/utils/formatters';
+import { truncateTokens } from '../utils/tokens';
+import { loadNativeAddon } from '../utils/nativeAddon';
+import type { NativeMeetingIndex } from '../audio/native/AECProcessor';
 import type { Meeting, Callout, CalloutSource, TranscriptSegment } from '@shared/types';
 
 const logger = createLogger('CalloutService');
@@ -15,9 +25,38 @@ interface PendingCallout {
   onCallout: (callout: Callout) => void;
 }
 
+// A callout requested at the utterance end on its interim text, ahead of the final
+interface PrefetchedCallout {
+  text: string;
+  endedAt: number;
+  request: Promise<Callout | null>;
+}
+
+// Past-meeting context looked up when a keyword was spotted in the audio
+interface SpottedKeyword {
+  heardAt: number;
+  context: Promise<string>;
+}
+
+// Case, punctuation and spacing are what a final usually changes in the interim
+function normalizeText(text: string): string {
+  return text.toLowerCase().replace(/[^\p{L}\p{N}]+/gu, ' ').trim();
+}
+
 export class CalloutService {
   private recentTranscripts: TranscriptSegment[] = [];
   private pendingCallout: PendingCallout | null = null;
+  // When system speech last ended (Date.now()), from native endpointing
+  private lastUtteranceEnd = 0;
+  // When system speech last ended with question intonation, and its prefetch
+  private lastProsodicQuestion = 0;
+  private prefetched: PrefetchedCallout | null = null;
+  private spotted = new Map<string, SpottedKeyword>();
+  // The whole meeting so far, for what has slid out of recentTranscripts
+  private meetingIndex: NativeMeetingIndex | null | undefined;
+  // Bumped on reset, so a batch embedded for the last meeting is dropped
+  private meetingGeneration = 0;
+  private embeddingWindows = false;
 
   /**
    * Add a transcript segment to the sliding window for context.
@@ -28,35 +67,98 @@ export class CalloutService {
     if (this.recentTranscripts.length > CALLOUT_CONFIG.MAX_CONTEXT_SEGMENTS) {
       this.recentTranscripts.shift();
     }
+    const index = this.getMeetingIndex();
+    if (index) {
+      index.append(segment.timestamp, `${getSpeakerLabel(segment.source, segment.speakerId)}: ${segment.text}`);
+      this.embedWindows(index);
+    }
+  }
+
+  /**
+   * Note the end of an utterance on system audio. The next question's delay
+   * then counts from there rather than from its final, which the provider
+   * sends some hundreds of ms later.
+   */
+  noteUtteranceEnd(timestamp: number): void {
+    this.lastUtteranceEnd = timestamp;
+  }
+
+  /**
+   * Note a system utterance that ended with rising intonation, from native
+   * pitch tracking. The callout for `interimText` is requested now, so the
+   * model runs while the provider finalizes; a scheduled callout whose final
+   * text matches takes that request instead of starting its own.
+   */
+  noteProsodicQuestion(timestamp: number, interimText: string): void {
+    this.lastProsodicQuestion = timestamp;
+    if (!interimText.trim()) return;
+    const request = this.generateCallout(interimText, []).catch((error) => {
+      logger.error('Failed to prefetch callout', error);
+      return null;
+    });
+    this.prefetched = { text: normalizeText(interimText), endedAt: timestamp, request };
+    logger.debug('Prefetching callout', { question: interimText.slice(0, 50) });
+  }
+
+  /**
+   * Note a keyword spotted on-device in system audio at `timestamp`. Its
+   * past-meeting context is looked up now, so the callout the transcript
+   * brings up for it has that ready.
+   */
+  noteSpokenKeyword(keyword: string, timestamp: number): void {
+    const previous = this.spotted.get(keyword);
+    if (previous && timestamp - previous.heardAt <= KEYWORD_SPOTTING_CONFIG.CONTEXT_TTL_MS) return;
+    this.spotted.set(keyword, { heardAt: timestamp, context: this.getPastMeetingContext(keyword) });
+    logger.debug('Prefetching keyword context', { keyword });
+  }
+
+  /**
+   * Whether the latest system utterance ended as a question by intonation,
+   * for finals the text trigger misses ("you're coming tomorrow?")
+   */
+  endedAsQuestion(): boolean {
+    return (
+      this.lastProsodicQuestion > 0 &&
+      this.lastProsodicQuestion === this.lastUtteranceEnd &&
+      Date.now() - this.lastProsodicQuestion <= ENDPOINT_CONFIG.MAX_FINAL_LAG_MS
+    );
   }
 
   /**
-   * Schedule a callout for a detected question.
+   * Schedule a callout for a detected question, or for `keywords` heard in it.
    * Starts a timer; if no mic response cancels it, generates callout after delay.
    * If a new question arrives, replaces the pending one.
    */
-  scheduleCallout(question: string, onCallout: (callout: Callout) => void): void {
+  scheduleCallout(question: string, onCallout: (callout: Callout) => void, keywords: string[] = []): void {
     // Cancel existing pending callout
     if (this.pendingCallout) {
       clearTimeout(this.pendingCallout.timerId);
       logger.debug('Replaced pending callout with new question');
     }
 
+    // Time already waited since the question was spoken; a stale end
+    // belongs to some earlier utterance
+    const lag = Date.now() - this.lastUtteranceEnd;
+    const elapsed = lag >= 0 && lag <= ENDPOINT_CONFIG.MAX_FINAL_LAG_MS ? lag : 0;
+    const prefetched = this.takePrefetched(question, keywords);
+
     const timerId = setTimeout(async () => {
-      logger.debug('Callout timer expired, generating response');
+      logger.debug('Callout timer expired, generating response', { prefetched: !!prefetched });
       try {
-        const callout = await this.generateCallout(question);
+        const callout = await (prefetched ?? this.generateCallout(question, keywords));
         if (callout) {
+          getContainer().calloutRepo.save(callout);
+          logger.info('Generated callout', { id: callout.id });
           onCallout(callout);
         }
       } catch (error) {
         logger.error('Failed to generate callout', error);
       }
       this.pendingCallout = null;
-    }, CALLOUT_TIMER_CONFIG.DELAY_MS);
+    }, CALLOUT_TIMER_CONFIG.DELAY_MS - elapsed);
 
     this.pendingCallout = { question, timerId, onCallout };
-    logger.debug('Scheduled callout', { question: question.slice(0, 50) });
+    logger.debug('Scheduled callout', { question: question.slice(0, 50), keywords, elapsed });
   }
 
   /**
@@ -89,19 +191,79 @@ export class CalloutService {
   reset(): void {
     this.cancelPendingCallout();
     this.recentTranscripts = [];
+    this.lastUtteranceEnd = 0;
+    this.lastProsodicQuestion = 0;
+    this.prefetched = null;
+    this.spotted.clear();
+    this.meetingIndex?.clear();
+    this.meetingGeneration++;
   }
 
-  private async generateCallout(question: string): Promise<Callout | null> {
-    const { aiProvider, calloutRepo, meetingRepo, settingsRepo } = getContainer();
+  private getMeetingIndex(): NativeMeetingIndex | null {
+    if (this.meetingIndex !== undefined) return this.meetingIndex;
+    this.meetingIndex = null;
+    const module = loadNativeAddon();
+    if (!module || typeof module.MeetingIndex !== 'function') {
+      logger.warn('Native meeting index unavailable - callouts see recent segments only');
+      return null;
+    }
+    const MeetingIndex = module.MeetingIndex as new (options: {
+      dims: number;
+      windowTokens: number;
+    }) => NativeMeetingIndex;
+    this.meetingIndex = new MeetingIndex({
+      dims: KNOWLEDGE_CONFIG.EMBEDDING_DIMS,
+      windowTokens: CALLOUT_CONFIG.MEETING_WINDOW_TOKENS,
+    });
+    return this.meetingIndex;
+  }
+
+  // One batch of sealed windows at a time, once a full batch is waiting;
+  // without an OpenAI key they stay lexical only
+  private embedWindows(index: NativeMeetingIndex): void {
+    if (this.embeddingWindows) return;
+    const windows = index.takeUnembedded(CALLOUT_CONFIG.MEETING_EMBED_BATCH);
+    if (windows.length < CALLOUT_CONFIG.MEETING_EMBED_BATCH) return;
+    const generation = this.meetingGeneration;
+    this.embeddingWindows = true;
+    getContainer()
+      .knowledgeService.embedTexts(windows.map((window) => window.text))
+      .then((vectors) => {
+        if (vectors && generation === this.meetingGeneration) {
+          index.setEmbeddings(windows.map((window) => window.id), vectors);
+        }
+      })
+      .catch((error) => logger.warn('Failed to embed meeting windows', { error: (error as Error).message }))
+      .finally(() => {
+        this.embeddingWindows = false;
+      });
+  }
+
+  // The prefetch for this final, when it is of the same utterance and text;
+  // keyword callouts are prompted differently and never match
+  private takePrefetched(question: string, keywords: string[]): Promise<Callout | null> | null {
+    const prefetched = this.prefetched;
+    this.prefetched = null;
+    if (!prefetched || keywords.length > 0 || prefetched.endedAt !== this.lastUtteranceEnd) return null;
+    return prefetched.text === normalizeText(question) ? prefetched.request : null;
+  }
+
+  // Not saved here: a prefetched callout may never be shown
+  private async generateCallout(question: string, keywords: string[]): Promise<Callout | null> {
+    const { aiProvider, meetingRepo, settingsRepo } = getContainer();
     if (!aiProvider) {
       logger.warn('AI provider not configured - skipping callout generation');
       return null;
     }
 
     const conversationContext = this.getConversationContext();
-    const pastMeetingContext = await this.getPastMeetingContext(question);
+    const [earlierContext, pastMeetingContext, ...keywordContexts] = await Promise.all([
+      this.getEarlierContext(question),
+      this.getPastMeetingContext(question),
+      ...this.takeSpottedContexts(keywords),
+    ]);
 
-    const allContext = [conversationContext, pastMeetingContext]
+    const allContext = [earlierContext, conversationContext, pastMeetingContext, ...keywordContexts]
       .filter(Boolean)
       .join('\n\n');
 
@@ -109,7 +271,7 @@ export class CalloutService {
     const settings = settingsRepo.getSettings();
     const userProfile = settings.userProfile;
 
-    const messages = buildCalloutMessages(question, allContext, userProfile);
+    const messages = buildCalloutMessages(question, allContext, userProfile, keywords);
     const response = await aiProvider.chat(messages, {
       responseFormat: 'json',
       maxTokens: 2000,
@@ -142,18 +304,52 @@ export class CalloutService {
       dismissed: false,
     };
 
-    calloutRepo.save(callout);
-    logger.info('Generated callout', { id: callout.id });
-
     return callout;
   }
 
+  // Lookups started when these keywords were spotted, while still fresh
+  private takeSpottedContexts(keywords: string[]): Promise<string>[] {
+    const now = Date.now();
+    const contexts: Promise<string>[] = [];
+    for (const keyword of keywords) {
+      const spotted = this.spotted.get(keyword);
+      this.spotted.delete(keyword);
+      if (spotted && now - spotted.heardAt <= KEYWORD_SPOTTING_CONFIG.CONTEXT_TTL_MS) {
+        contexts.push(spotted.context);
+      }
+    }
+    return contexts;
+  }
+
   private getConversationContext(): string {
     if (this.recentTranscripts.length === 0) return '';
 
-    return this.recentTranscripts
-      .map((seg) => `${getSpeakerLabel(seg.source)}: ${seg.text}`)
+    const context = this.recentTranscripts
+      .map((seg) => `${getSpeakerLabel(seg.source, seg.speakerId)}: ${seg.text}`)
       .join('\n');
+    return truncateTokens(context, PROMPT_CONFIG.MAX_CALLOUT_CONTEXT_TOKENS, true);
+  }
+
+  // Windows of this meeting from before the recent segments that match the
+  // question, by its terms and, with an OpenAI key, its embedding
+  private async getEarlierContext(question: string): Promise<string> {
+    const index = this.meetingIndex;
+    if (!index || this.recentTranscripts.length < CALLOUT_CONFIG.MAX_CONTEXT_SEGMENTS) return '';
+
+    let vector: Float32Array | number[] | null = null;
+    try {
+      vector = (await getContainer().knowledgeService.embedTexts([question]))?.[0] ?? null;
+    } catch (error) {
+      logger.debug('Question embedding failed - matching terms only', { error: (error as Error).message });
+    }
+    const hits = index.search(question, vector, {
+      k: CALLOUT_CONFIG.MAX_EARLIER_WINDOWS,
+      beforeMs: this.recentTranscripts[0].timestamp,
+    });
+    if (hits.length === 0) return '';
+    // In meeting order, as they were said
+    const windows = hits.sort((a, b) => a.startMs - b.startMs).map((hit) => hit.text);
+    return 'Earlier in this meeting:\n' + windows.join('\n...\n');
   }
 
   private async getPastMeetingContext(query: string): Promise<string> {
@@ -189,9 +385,10 @@ export class CalloutService {
       throw new Error('AI provider not configured');
     }
 
-    const transcript = meeting.transcript
-      .map((seg) => `${getSpeakerLabel(seg.source)}: ${seg.text}`)
-      .join('\n');
+    const transcript = truncateTokens(
+      meeting.transcript.map((seg) => `${getSpeakerLabel(seg.source, seg.speakerId)}: ${seg.text}`).join('\n'),
+      PROMPT_CONFIG.MAX_TRANSCRIPT_TOKENS
+    );
 
     const messages = buildSummaryMessages(transcript);
     const response = await aiProvider.chat(messages, { maxTokens: 1000 });
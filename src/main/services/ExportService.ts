@@ -4,21 +4,24 @@ import { existsSync, mkdirSync, writeFileSync } from 'fs';
 import { createLogger } from '../core/logger';
 import { EXPORT_CONFIG } from '../config/constants';
 import { getSpeakerLabel, formatTime } from '@shared/utils/formatters';
-import type { Meeting } from '@shared/types';
+import type { Callout, Meeting } from '@shared/types';
+import type {
+  BundleEntry,
+  BundleJob,
+  BundleOptions,
+  BundleTrack,
+  ClipOptions,
+  ClipResult,
+} from '../audio/native/AECProcessor';
+import { loadNativeAddon } from '../utils/nativeAddon';
+import { recordingTracks } from './transcription/BatchTranscriber';
 
 const logger = createLogger('ExportService');
 
 export class ExportService {
   exportMeeting(meeting: Meeting, format: 'markdown' | 'pdf'): string {
-    const userDataPath = app.getPath('userData');
-    const exportDir = join(userDataPath, EXPORT_CONFIG.EXPORT_DIR);
-
-    if (!existsSync(exportDir)) {
-      mkdirSync(exportDir, { recursive: true });
-    }
-
-    const safeTitle = meeting.title.replace(/[^a-z0-9]/gi, '_');
-    const filename = `${safeTitle}_${meeting.id.slice(0, 8)}`;
+    const exportDir = this.exportDir();
+    const filename = this.baseName(meeting);
 
     if (format === 'markdown') {
       const md = this.toMarkdown(meeting);
@@ -36,6 +39,122 @@ export class ExportService {
     return filePath;
   }
 
+  /**
+   * An audio clip of the meeting's recording around `timestamp` (ms into
+   * the meeting, as a transcript segment's), both tracks mixed and
+   * normalized. The addon reads just that range through the seek index and
+   * encodes it on its worker pool, so the recording never passes through
+   * JS. Resolves the clip's path: Ogg Opus, or WAV in builds without libopus.
+   */
+  async exportClip(
+    meeting: Meeting,
+    timestamp: number,
+    durationMs: number = EXPORT_CONFIG.CLIP_DURATION_MS
+  ): Promise<string> {
+    if (!meeting.recordingIndex || meeting.recordingStartedAt == null) {
+      throw new Error('Meeting has no recording');
+    }
+    const native = loadNativeAddon();
+    if (!native || typeof native.extractClip !== 'function') {
+      throw new Error('Clip export needs the native addon');
+    }
+    const extractClip = native.extractClip as (options: ClipOptions) => Promise<ClipResult>;
+    const tracks = recordingTracks(meeting.recordingIndex).map((track) => track.index);
+    if (tracks.length === 0) {
+      throw new Error('Recording files are missing');
+    }
+
+    const at = meeting.createdAt.getTime() + timestamp - meeting.recordingStartedAt;
+    const startMs = Math.max(0, at - durationMs / 2);
+    const base = join(this.exportDir(), `${this.baseName(meeting)}_${Math.round(startMs / 1000)}s`);
+    let result: ClipResult;
+    try {
+      result = await extractClip({ tracks, startMs, durationMs, output: `${base}.ogg` });
+    } catch (error) {
+      if (!/no Opus/.test((error as Error).message)) throw error;
+      result = await extractClip({ tracks, startMs, durationMs, format: 'wav', output: `${base}.wav` });
+    }
+    logger.info('Exported clip', {
+      path: result.output,
+      durationMs: Math.round(result.durationMs),
+      gainDb: Math.round(result.gainDb * 10) / 10,
+      elapsedMs: Math.round(result.elapsedMs),
+    });
+    return result.output as string;
+  }
+
+  /**
+   * The whole meeting as one ZIP: the markdown, transcript, notes and
+   * callouts, each recorded track as FLAC and the tracks mixed into one.
+   * The text is small and goes over as strings; the audio never enters JS:
+   * the addon encodes each track straight from the recording files on its
+   * worker pool, in parallel, and streams them into the archive, so memory
+   * stays flat however long the meeting. Resolves the archive's path.
+   */
+  async exportBundle(
+    meeting: Meeting,
+    callouts: Callout[],
+    onProgress?: (fraction: number) => void
+  ): Promise<string> {
+    const native = loadNativeAddon();
+    if (!native || typeof native.exportBundle !== 'function') {
+      throw new Error('Bundle export needs the native addon');
+    }
+    const exportBundle = native.exportBundle as (options: BundleOptions) => BundleJob;
+
+    const base = this.baseName(meeting);
+    const entries: BundleEntry[] = [
+      { name: `${base}/meeting.md`, data: this.toMarkdown(meeting) },
+      { name: `${base}/transcript.json`, data: JSON.stringify(meeting.transcript, null, 2) },
+    ];
+    const notes = meeting.notesMarkdown ?? meeting.notesPlain;
+    if (notes) {
+      entries.push({ name: `${base}/notes.md`, data: notes });
+    }
+    if (meeting.noteEntries.length > 0) {
+      entries.push({ name: `${base}/note-entries.json`, data: JSON.stringify(meeting.noteEntries, null, 2) });
+    }
+    if (callouts.length > 0) {
+      entries.push({ name: `${base}/callouts.json`, data: JSON.stringify(callouts, null, 2) });
+    }
+
+    const tracks: BundleTrack[] = meeting.recordingIndex
+      ? recordingTracks(meeting.recordingIndex).map((track) => ({
+          name: `${base}/audio/${track.source === 'mic' ? 'microphone' : 'system'}.flac`,
+          index: track.index,
+        }))
+      : [];
+    const output = join(this.exportDir(), `${base}.zip`);
+    const result = await exportBundle({
+      output,
+      entries,
+      tracks,
+      mix: tracks.length > 1 ? `${base}/audio/mixed.flac` : undefined,
+      onProgress,
+    }).done;
+    logger.info('Exported meeting bundle', {
+      path: result.output,
+      entries: result.entries,
+      outputBytes: result.outputBytes,
+      audioMs: Math.round(result.audioMs),
+      elapsedMs: Math.round(result.elapsedMs),
+    });
+    return result.output;
+  }
+
+  private exportDir(): string {
+    const exportDir = join(app.getPath('userData'), EXPORT_CONFIG.EXPORT_DIR);
+    if (!existsSync(exportDir)) {
+      mkdirSync(exportDir, { recursive: true });
+    }
+    return exportDir;
+  }
+
+  private baseName(meeting: Meeting): string {
+    const safeTitle = meeting.title.replace(/[^a-z0-9]/gi, '_');
+    return `${safeTitle}_${meeting.id.slice(0, 8)}`;
+  }
+
   private toMarkdown(meeting: Meeting): string {
     let md = `# ${meeting.title}\n\n`;
     md += `**Date**: ${new Date(meeting.createdAt).toLocaleString()}\n`;
@@ -55,7 +174,7 @@ export class ExportService {
 
     md += `## Transcript\n\n`;
     for (const seg of meeting.transcript) {
-      const speaker = getSpeakerLabel(seg.source);
+      const speaker = getSpeakerLabel(seg.source, seg.speakerId);
       const time = formatTime(seg.timestamp);
       md += `**[${time}] ${speaker}**: ${seg.text}\n\n`;
     }
@@ -259,6 +259,40 @@ export class HubSpotService {
     return results;
   }
 
+  /**
+   * List contacts with an email, up to |max|, for matching by name
+   */
+  public async listContacts(accessToken: string, max: number): Promise<ContactSearchResult[]> {
+    try {
+      const results: ContactSearchResult[] = [];
+      let after: string | undefined;
+      do {
+        const response = await axios.get('https://api.hubapi.com/crm/v3/objects/contacts', {
+          params: { limit: 100, properties: 'firstname,lastname,email', ...(after ? { after } : {}) },
+          headers: { Authorization: `Bearer ${accessToken}` },
+        });
+        for (const contact of response.data.results ?? []) {
+          if (!contact.properties?.email) continue;
+          results.push({
+            id: contact.id,
+            email: contact.properties.email,
+            firstName: contact.properties.firstname,
+            lastName: contact.properties.lastname,
+            name: [contact.properties.firstname, contact.properties.lastname].filter(Boolean).join(' ') || undefined,
+          });
+        }
+        after = response.data.paging?.next?.after;
+      } while (after && results.length < max);
+
+      logger.info('Listed HubSpot contacts', { count: results.length });
+      return results.slice(0, max);
+    } catch (error) {
+      const message = error instanceof Error ? error.message : 'Unknown error';
+      logger.error('Failed to list HubSpot contacts', { error: message });
+      throw new Error(`Failed to list HubSpot contacts: ${message}`);
+    }
+  }
+
   /**
    * Create or get a note object
    */
@@ -0,0 +1,270 @@
+import { app } from 'electron';
+import { existsSync, mkdirSync, unlinkSync } from 'fs';
+import { join } from 'path';
+import { createLogger } from '../core/logger';
+import { AI_MODELS, EXPORT_CONFIG, KNOWLEDGE_CONFIG, CALLOUT_CONFIG } from '../config/constants';
+import { getDatabase, saveDatabase, withTransaction } from '../data/database';
+import { OpenAIProvider } from '../providers/OpenAIProvider';
+import { loadNativeAddon } from '../utils/nativeAddon';
+import type {
+  EmbeddingIndexOptions,
+  KnowledgeIngestHandle,
+  KnowledgeIngestOptions,
+  KnowledgeIngestStats,
+  NativeEmbeddingCache,
+  NativeEmbeddingStore,
+  NativeLexicalIndex,
+} from '../audio/native/AECProcessor';
+import type { AppSettings, KnowledgeSearchResult } from '@shared/types';
+
+const logger = createLogger('KnowledgeService');
+
+interface NativeKnowledgeModule {
+  EmbeddingStore: new (
+    path: string,
+    options: Pick<EmbeddingIndexOptions, 'dims' | 'quantization' | 'normalize'>
+  ) => NativeEmbeddingStore;
+  /** Missing from older addons */
+  EmbeddingCache?: new (
+    path: string,
+    options: Pick<EmbeddingIndexOptions, 'dims' | 'quantization'> & { capacity?: number }
+  ) => NativeEmbeddingCache;
+  /** Missing from older addons */
+  LexicalIndex?: new () => NativeLexicalIndex;
+  ingestKnowledge: (options: KnowledgeIngestOptions) => KnowledgeIngestHandle;
+}
+
+function loadNativeKnowledge(): NativeKnowledgeModule | null {
+  const module = loadNativeAddon();
+  if (!module || typeof module.ingestKnowledge !== 'function' || typeof module.EmbeddingStore !== 'function') {
+    return null;
+  }
+  return module as unknown as NativeKnowledgeModule;
+}
+
+/**
+ * The knowledge-base folder, embedded chunk by chunk. Ingestion runs in the
+ * native addon: only documents that changed since the last run are read,
+ * and their chunks come back in batches for the embeddings API. Vectors go
+ * to a memory-mapped embedding store, chunk text to knowledge_chunks. Every
+ * embedding goes through a native cache by text, so only texts not seen
+ * before reach the API. Search fuses the vector scan with BM25 over the
+ * chunk text, so exact terms (product codes, names) still match.
+ */
+export class KnowledgeService {
+  private native: NativeKnowledgeModule | null | undefined;
+  private store: NativeEmbeddingStore | null = null;
+  private cache: NativeEmbeddingCache | null | undefined;
+  private lexical: NativeLexicalIndex | null | undefined;
+  private running: KnowledgeIngestHandle | null = null;
+
+  constructor(private getSettings: () => AppSettings) {}
+
+  private dataPath(file: string): string {
+    const dir = join(app.getPath('userData'), EXPORT_CONFIG.DATA_DIR);
+    if (!existsSync(dir)) {
+      mkdirSync(dir, { recursive: true });
+    }
+    return join(dir, file);
+  }
+
+  private embedder(): OpenAIProvider | null {
+    const settings = this.getSettings();
+    if (!settings.openAiApiKey) return null;
+    return new OpenAIProvider({ apiKey: settings.openAiApiKey, baseURL: settings.openAiBaseUrl || undefined });
+  }
+
+  private openStore(): NativeEmbeddingStore | null {
+    if (this.store) return this.store;
+    if (this.native === undefined) {
+      this.native = loadNativeKnowledge();
+    }
+    if (!this.native) return null;
+    const path = this.dataPath(KNOWLEDGE_CONFIG.STORE_FILE);
+    const options = { dims: KNOWLEDGE_CONFIG.EMBEDDING_DIMS, quantization: KNOWLEDGE_CONFIG.QUANTIZATION };
+    try {
+      this.store = new this.native.EmbeddingStore(path, options);
+    } catch (error) {
+      // Written with other dims or quantization: start over, manifest too,
+      // so every document is embedded again
+      logger.warn('Recreating knowledge store', { error: (error as Error).message });
+      for (const file of [path, this.dataPath(KNOWLEDGE_CONFIG.MANIFEST_FILE)]) {
+        if (existsSync(file)) unlinkSync(file);
+      }
+      getDatabase().run('DELETE FROM knowledge_chunks');
+      saveDatabase();
+      this.store = new this.native.EmbeddingStore(path, options);
+    }
+    return this.store;
+  }
+
+  private openCache(): NativeEmbeddingCache | null {
+    if (this.cache !== undefined) return this.cache;
+    this.cache = null;
+    if (!this.openStore() || !this.native?.EmbeddingCache) return null;
+    const path = this.dataPath(KNOWLEDGE_CONFIG.CACHE_FILE);
+    const options = {
+      dims: KNOWLEDGE_CONFIG.EMBEDDING_DIMS,
+      quantization: KNOWLEDGE_CONFIG.QUANTIZATION,
+      capacity: KNOWLEDGE_CONFIG.CACHE_ENTRIES,
+    };
+    try {
+      this.cache = new this.native.EmbeddingCache(path, options);
+    } catch (error) {
+      // Written with other dims or quantization: a cache is safe to drop
+      logger.warn('Recreating embedding cache', { error: (error as Error).message });
+      if (existsSync(path)) unlinkSync(path);
+      try {
+        this.cache = new this.native.EmbeddingCache(path, options);
+      } catch (retryError) {
+        logger.warn('Embedding cache unavailable', { error: (retryError as Error).message });
+      }
+    }
+    return this.cache;
+  }
+
+  /** In memory only, rebuilt from knowledge_chunks on first use */
+  private openLexical(): NativeLexicalIndex | null {
+    if (this.lexical !== undefined) return this.lexical;
+    this.lexical = null;
+    if (!this.openStore() || !this.native?.LexicalIndex) return null;
+    const lexical = new this.native.LexicalIndex();
+    const result = getDatabase().exec('SELECT id, text FROM knowledge_chunks');
+    for (const [id, text] of result[0]?.values ?? []) {
+      lexical.add(id as string, text as string);
+    }
+    logger.info('Lexical index built', { ...lexical.getStats() });
+    this.lexical = lexical;
+    return lexical;
+  }
+
+  /** One vector per text, in order; one batched lookup, and only misses go to the API */
+  private async embed(embedder: OpenAIProvider, texts: string[]): Promise<(Float32Array | number[])[]> {
+    const model = AI_MODELS.EMBEDDING_SMALL;
+    const cache = this.openCache();
+    if (!cache) return embedder.embed(texts, model);
+
+    const vectors: (Float32Array | number[] | null)[] = cache.lookup(model, texts);
+    const misses = texts.filter((_, i) => !vectors[i]);
+    if (misses.length > 0) {
+      const embedded = await embedder.embed(misses, model);
+      cache.store(model, misses, embedded);
+      let next = 0;
+      for (let i = 0; i < vectors.length; i++) {
+        if (!vectors[i]) vectors[i] = embedded[next++];
+      }
+    }
+    return vectors as (Float32Array | number[])[];
+  }
+
+  /** Embeddings for other callers, through the same cache; null without an OpenAI key */
+  async embedTexts(texts: string[]): Promise<(Float32Array | number[])[] | null> {
+    const embedder = this.embedder();
+    if (!embedder) return null;
+    return texts.length > 0 ? this.embed(embedder, texts) : [];
+  }
+
+  /**
+   * Brings the index in line with `root`. A run already going is cancelled
+   * first. Null when the addon or an OpenAI key is missing.
+   */
+  async index(root: string): Promise<KnowledgeIngestStats | null> {
+    if (this.running) {
+      this.running.cancel();
+      await this.running.done.catch(() => undefined);
+    }
+    const embedder = this.embedder();
+    const store = this.openStore();
+    if (!embedder || !store || !this.native) {
+      logger.warn('Knowledge base not indexed', { native: !!store, embeddings: !!embedder });
+      return null;
+    }
+    const lexical = this.openLexical();
+
+    const handle = this.native.ingestKnowledge({
+      root,
+      manifest: this.dataPath(KNOWLEDGE_CONFIG.MANIFEST_FILE),
+      batchChunks: KNOWLEDGE_CONFIG.BATCH_CHUNKS,
+      maxInFlight: KNOWLEDGE_CONFIG.MAX_IN_FLIGHT,
+      onRemove: (prefix) => {
+        store.removePrefix(prefix);
+        lexical?.removePrefix(prefix);
+        getDatabase().run('DELETE FROM knowledge_chunks WHERE id LIKE ?', [`${prefix}%`]);
+        saveDatabase();
+      },
+      onBatch: async ({ chunks }) => {
+        const vectors = await this.embed(embedder, chunks.map((chunk) => chunk.text));
+        await withTransaction(() => {
+          const database = getDatabase();
+          chunks.forEach((chunk, i) => {
+            store.append(chunk.id, vectors[i]);
+            lexical?.add(chunk.id, chunk.text);
+            database.run(
+              'INSERT OR REPLACE INTO knowledge_chunks (id, path, chunk_index, text) VALUES (?, ?, ?, ?)',
+              [chunk.id, chunk.path, chunk.index, chunk.text]
+            );
+          });
+        });
+      },
+    });
+    this.running = handle;
+    try {
+      const stats = await handle.done;
+      logger.info('Knowledge base indexed', { root, ...stats });
+      return stats;
+    } finally {
+      if (this.running === handle) this.running = null;
+    }
+  }
+
+  /**
+   * The chunks closest to `query`, in meaning and in terms, fused by rank
+   * within the retrieval budget; empty when nothing is indexed
+   */
+  async search(query: string, limit: number = CALLOUT_CONFIG.MAX_KNOWLEDGE_RESULTS): Promise<KnowledgeSearchResult[]> {
+    const embedder = this.embedder();
+    const store = this.openStore();
+    if (!embedder || !store || !query.trim()) return [];
+
+    const [vector] = await this.embed(embedder, [query]);
+    const lexical = this.openLexical();
+    let hits: { id: string; score: number }[];
+    if (lexical && store.hybridSearch) {
+      const result = store.hybridSearch(vector, query, lexical, {
+        k: limit,
+        budgetMs: KNOWLEDGE_CONFIG.RETRIEVAL_BUDGET_MS,
+      });
+      if (!result.complete) {
+        logger.debug('Knowledge search cut short', { elapsedMs: result.elapsedMs });
+      }
+      hits = result.hits;
+    } else {
+      hits = store.search(vector, limit);
+    }
+    if (hits.length === 0) return [];
+
+    const result = getDatabase().exec(
+      `SELECT id, path, text FROM knowledge_chunks WHERE id IN (${hits.map(() => '?').join(', ')})`,
+      hits.map((hit) => hit.id)
+    );
+    const rows = new Map<string, { path: string; text: string }>();
+    for (const [id, path, text] of result[0]?.values ?? []) {
+      rows.set(id as string, { path: path as string, text: text as string });
+    }
+    return hits
+      .filter((hit) => rows.has(hit.id))
+      .map((hit) => ({ id: hit.id, ...rows.get(hit.id)!, score: hit.score }));
+  }
+
+  close(): void {
+    this.running?.cancel();
+    this.store?.close();
+    this.store = null;
+    if (this.cache) {
+      logger.info('Embedding cache closed', { ...this.cache.getStats() });
+      this.cache.close();
+    }
+    this.cache = undefined;
+    this.lexical = undefined;
+  }
+}
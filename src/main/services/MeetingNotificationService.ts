@@ -1,6 +1,9 @@
 import { Notification, shell } from 'electron';
 import { CalendarService } from './CalendarService';
 import { createLogger } from '../core/logger';
+import { preloadDsp } from '../utils/nativeAddon';
+import { AECProcessor, MeetingAudioEvent } from '../audio/native/AECProcessor';
+import { MEETING_DETECTION_CONFIG, SYSTEM_TAP_CONFIG } from '../config/constants';
 
 const logger = createLogger('MeetingNotificationService');
 
@@ -13,6 +16,10 @@ export class MeetingNotificationService {
   private calendarService: CalendarService;
   private pendingNotifications: Map<string, PendingNotification> = new Map();
   private checkInterval: NodeJS.Timeout | null = null;
+  // Standby audio monitor for calls with no calendar event; paused while recording
+  private audioMonitor: AECProcessor | null = null;
+  private recording = false;
+  private lastAudioPromptAt = 0;
 
   constructor(calendarService: CalendarService) {
     this.calendarService = calendarService;
@@ -36,6 +43,7 @@ export class MeetingNotificationService {
 
     // Check immediately on start
     this.checkUpcomingMeetings();
+    this.startAudioMonitor();
     
     logger.info('Meeting notification service started - checking every 10 seconds');
   }
@@ -54,10 +62,101 @@ export class MeetingNotificationService {
       clearTimeout(notification.timeout);
     }
     this.pendingNotifications.clear();
+    this.stopAudioMonitor();
 
     logger.info('Stopped meeting notification service');
   }
 
+  /**
+   * Recording taps the same audio; the monitor stands down meanwhile and
+   * starts afresh once it ends
+   */
+  setRecordingActive(active: boolean): void {
+    this.recording = active;
+    if (active) {
+      this.stopAudioMonitor();
+    } else if (this.checkInterval) {
+      this.startAudioMonitor();
+    }
+  }
+
+  private startAudioMonitor(): void {
+    if (!MEETING_DETECTION_CONFIG.ENABLED || this.recording || this.audioMonitor) {
+      return;
+    }
+    try {
+      // No echo canceller runs on this instance; it only hosts the monitor
+      const monitor = new AECProcessor({ enableAec: false, enableNs: false });
+      const started = monitor.startMeetingMonitor({ bundleIds: [...SYSTEM_TAP_CONFIG.MEETING_APPS] }, (event) =>
+        this.handleMeetingAudio(event)
+      );
+      if (!started) {
+        monitor.destroy();
+        return;
+      }
+      this.audioMonitor = monitor;
+      logger.info('Meeting audio monitor started');
+    } catch (err) {
+      logger.warn('Meeting audio monitor unavailable', { error: (err as Error).message });
+    }
+  }
+
+  private stopAudioMonitor(): void {
+    if (!this.audioMonitor) {
+      return;
+    }
+    const stats = this.audioMonitor.getMeetingMonitorStats();
+    this.audioMonitor.stopMeetingMonitor();
+    this.audioMonitor.destroy();
+    this.audioMonitor = null;
+    logger.info('Meeting audio monitor stopped', { ...stats });
+  }
+
+  /**
+   * Sustained conversation from a meeting app with no recording running:
+   * get the DSP module mapped and offer to record
+   */
+  private handleMeetingAudio(event: MeetingAudioEvent): void {
+    const now = Date.now();
+    if (this.recording || now - this.lastAudioPromptAt < MEETING_DETECTION_CONFIG.PROMPT_COOLDOWN_MS) {
+      return;
+    }
+    this.lastAudioPromptAt = now;
+    logger.info('Meeting audio detected', { ...event });
+    void preloadDsp();
+
+    const notification = new Notification({
+      title: 'Meeting in progress?',
+      subtitle: 'Sounds like a call started',
+      body: 'Record and transcribe it',
+      urgency: 'normal',
+      actions: [
+        {
+          type: 'button',
+          text: 'Record',
+        },
+        {
+          type: 'button',
+          text: 'Dismiss',
+        },
+      ],
+    });
+    const startRecording = (): void => {
+      if (global.mainWindow && !global.mainWindow.isDestroyed()) {
+        global.mainWindow.webContents.send('notification:start-recording', {});
+      }
+    };
+    notification.on('action', (index: any) => {
+      if (index === 0) {
+        startRecording();
+      } else {
+        notification.close();
+      }
+    });
+    notification.on('click', startRecording);
+    notification.show();
+  }
+
   /**
    * Check for meetings starting soon and schedule notifications
    */
@@ -150,6 +249,8 @@ export class MeetingNotificationService {
    * Show a native notification for the meeting
    */
   private showMeetingNotification(meeting: any): void {
+    // Recording is likely a minute away; have echo cancellation ready for it
+    void preloadDsp();
     const startDate = meeting.start instanceof Date ? meeting.start : new Date(meeting.start);
     const startTime = startDate.toLocaleTimeString([], { 
       hour: '2-digit', 
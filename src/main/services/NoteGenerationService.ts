@@ -1,6 +1,8 @@
 import { buildNoteGenerationMessages } from '../prompts/summaryPrompts';
 import { createLogger } from '../core/logger';
 import { getSpeakerLabel } from '@shared/utils/formatters';
+import { PROMPT_CONFIG } from '../config/constants';
+import { countTokens, truncateTokens } from '../utils/tokens';
 import type { AIProvider } from '../providers/OpenAIProvider';
 import type { Meeting, TranscriptSegment } from '@shared/types';
 
@@ -27,8 +29,13 @@ export class NoteGenerationService {
       return null;
     }
 
-    const transcriptText = this.formatTranscript(meeting.transcript);
-    logger.info('Generating notes', { meetingId: meeting.id, transcriptLength: transcriptText.length });
+    const fullTranscript = this.formatTranscript(meeting.transcript);
+    const transcriptText = truncateTokens(fullTranscript, PROMPT_CONFIG.MAX_TRANSCRIPT_TOKENS);
+    logger.info('Generating notes', {
+      meetingId: meeting.id,
+      transcriptTokens: countTokens(transcriptText),
+      truncated: transcriptText.length < fullTranscript.length,
+    });
 
     try {
       const messages = buildNoteGenerationMessages(transcriptText);
@@ -59,7 +66,7 @@ export class NoteGenerationService {
   private formatTranscript(segments: TranscriptSegment[]): string {
     return segments
       .filter((s) => s.isFinal)
-      .map((s) => `[${getSpeakerLabel(s.source)}]: ${s.text}`)
+      .map((s) => `[${getSpeakerLabel(s.source, s.speakerId)}]: ${s.text}`)
       .join('\n');
   }
 }
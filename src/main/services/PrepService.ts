@@ -1,5 +1,6 @@
 import { getContainer } from '../core/container';
 import { createLogger } from '../core/logger';
+import { truncateTokens } from '../utils/tokens';
 import { Meeting } from '@shared/types';
 
 const logger = createLogger('PrepService');
@@ -232,7 +233,7 @@ export class PrepService {
           // Take first meaningful segment from other participants
           const meaningful = systemSegments.find((s) => s.text.length > 20);
           if (meaningful) {
-            keyPoints.add(meaningful.text.substring(0, 100));
+            keyPoints.add(truncateTokens(meaningful.text, 25));
           }
         }
       }
@@ -330,6 +330,43 @@ export class SalesforceService {
     return results;
   }
 
+  /**
+   * List contacts with an email, up to |max|, for matching by name
+   */
+  public async listContacts(accessToken: string, instanceUrl: string, max: number): Promise<ContactSearchResult[]> {
+    try {
+      const conn = new jsforce.Connection({
+        accessToken,
+        instanceUrl,
+      });
+
+      const contacts = await conn.sobject('Contact').find<{
+        Id: string;
+        Email: string;
+        FirstName?: string;
+        LastName?: string;
+        Name?: string;
+      }>(
+        { Email: { $ne: null } },
+        { Id: 1, Email: 1, FirstName: 1, LastName: 1, Name: 1 }
+      ).limit(max).execute({ autoFetch: true, maxFetch: max });
+
+      logger.info('Listed Salesforce contacts', { count: contacts.length });
+      return contacts.map((contact) => ({
+        id: contact.Id,
+        email: contact.Email,
+        firstName: contact.FirstName,
+        lastName: contact.LastName,
+        name: contact.Name,
+        type: 'Contact' as const,
+      }));
+    } catch (error) {
+      const message = error instanceof Error ? error.message : 'Unknown error';
+      logger.error('Failed to list Salesforce contacts', { error: message });
+      throw new Error(`Failed to list Salesforce contacts: ${message}`);
+    }
+  }
+
   /**
    * Create a Task (note) in Salesforce
    */
@@ -1,25 +1,54 @@
 import type { ITranscriptionProvider } from '@main/services/transcription';
 import { createLogger } from '@main/core/logger';
-import { AudioBackendFactory, IAudioCaptureBackend, AudioChunk } from '@main/services/audio';
-import { AECProcessor } from '@main/audio/native/AECProcessor';
-import { AUDIO_CONFIG } from '@main/config/constants';
+import { AudioBackendFactory, IAudioCaptureBackend, AudioChunk, AudioEndpoint } from '@main/services/audio';
+import { AECProcessor, AudioClass, METADATA_FIELDS, MetadataField } from '@main/audio/native/AECProcessor';
+import type { AudioEngineHost } from '@main/audio/engine/AudioEngineHost';
+import { AUDIO_CLASS_CONFIG, AUDIO_CONFIG, SPEAKER_CONFIG } from '@main/config/constants';
 
 const logger = createLogger('SystemAudio');
 
 type AudioLevelCallback = (level: number) => void;
+type EndpointCallback = (endpoint: AudioEndpoint) => void;
+
+// A native speaker ID and when (Date.now()) its second ended
+interface SpeakerSecond {
+  at: number;
+  speaker: number;
+}
+
+// Audio held back from transcription while the stream is music or noise
+interface WithheldAudio {
+  buffer: ArrayBuffer;
+  durationMs: number;
+}
 
 export class SystemAudioService {
   private backend: IAudioCaptureBackend | null = null;
   private transcriptionProvider: ITranscriptionProvider | null = null;
   private audioLevelCallback: AudioLevelCallback | null = null;
+  private endpointCallback: EndpointCallback | null = null;
   private capturing: boolean = false;
   private aecProcessor: AECProcessor | null = null;
+  private audioEngine: AudioEngineHost | null = null;
   private onSystemAudioCallback: ((samples: Float32Array, timestamp: number) => void) | null = null;
-
-  onAudioLevel(callback: AudioLevelCallback): void {
+  // Upload gate: the latest native AudioClass, and what it has withheld
+  private audioClass: AudioClass = AudioClass.SPEECH;
+  private withheld: WithheldAudio[] = [];
+  private withheldMs = 0;
+  private gatedMs = 0;
+  private speakerSeconds: SpeakerSecond[] = [];
+
+  onAudioLevel(callback: AudioLevelCallback | null): void {
     this.audioLevelCallback = callback;
   }
 
+  /**
+   * Utterance boundaries from native taps; audiotee and pw-record have none
+   */
+  onEndpoint(callback: EndpointCallback | null): void {
+    this.endpointCallback = callback;
+  }
+
   /**
  * Set callback to receive system audio for AEC synchronization
  */
@@ -34,6 +63,13 @@ setAECProcessor(processor: AECProcessor | null): void {
   this.aecProcessor = processor;
 }
 
+/**
+ * Tap system audio in the audio engine process (shared with recording handlers)
+ */
+setAudioEngine(host: AudioEngineHost | null): void {
+  this.audioEngine = host;
+}
+
   async start(transcriptionProvider: ITranscriptionProvider): Promise<void> {
     if (this.capturing) {
       logger.warn('Already capturing');
@@ -48,6 +84,8 @@ setAECProcessor(processor: AECProcessor | null): void {
       sampleRate: AUDIO_CONFIG.SAMPLE_RATE,
       chunkDurationMs: AUDIO_CONFIG.CHUNK_DURATION_MS,
       channels: AUDIO_CONFIG.CHANNELS,
+      engine: this.aecProcessor,
+      engineHost: this.audioEngine,
     });
 
     let chunkCount = 0;
@@ -61,17 +99,27 @@ setAECProcessor(processor: AECProcessor | null): void {
         return;
       }
 
-      // Convert Node.js Buffer to Float32Array for AEC processing
-      const float32Samples = this.bufferToFloat32(chunk.data);
-      // Send to AECSync for timestamp-based synchronization (using absolute time)
+      // Native taps deliver float samples with a host-clock timestamp;
+      // audiotee/pw-record give s16 only, which the addon converts itself
+      const renderSamples = chunk.samples ?? chunk.data;
+      // audiotee chunks carry no capture time; approximate the first sample as
+      // one chunk before arrival
+      const channels = chunk.samples ? 1 : AUDIO_CONFIG.CHANNELS;
+      const sampleCount = chunk.samples ? chunk.samples.length : chunk.data.length / 2;
+      const durationMs = (sampleCount / channels / AUDIO_CONFIG.SAMPLE_RATE) * 1000;
+      const timestamp = chunk.timestamp ?? Date.now() - durationMs;
+      if (chunk.speakers && chunk.speakers.length > 0) {
+        this.noteSpeakers(chunk.speakers, timestamp + durationMs);
+      }
       if (this.onSystemAudioCallback) {
-      const timestamp = Date.now();
-      this.onSystemAudioCallback(float32Samples, timestamp);
+        this.onSystemAudioCallback(chunk.samples ?? this.bufferToFloat32(chunk.data), timestamp);
       }
-      // Feed system audio (render path) through AEC as reference
+      // Feed system audio (render path) as the AEC reference; the addon aligns
+      // it with the mic by timestamp. Chunks without a capture time of their
+      // own go without one, and the addon paces them through its jitter buffer.
       if (this.aecProcessor && this.aecProcessor.isReady()) {
         try {
-          const success = this.aecProcessor.processRenderAudio(float32Samples);
+          const success = this.aecProcessor.processRenderAudio(renderSamples, chunk.timestamp, channels);
           if (!success) {
             logger.warn('AEC render processing returned false');
           }
@@ -89,14 +137,27 @@ setAECProcessor(processor: AECProcessor | null): void {
         uint8Array.byteOffset + uint8Array.byteLength
       );
 
-      // Calculate RMS level for UI visualization
-      const level = this.calculateRmsLevel(chunk.data);
-
+      // RMS level for UI visualization, from the native frame metadata when
+      // the tap carries it
       if (this.audioLevelCallback) {
-        this.audioLevelCallback(level);
+        this.audioLevelCallback(
+          chunk.metadata ? this.metadataRmsLevel(chunk.metadata) : this.calculateRmsLevel(chunk.data)
+        );
+      }
+
+      if (!this.admitUpload(chunk, arrayBuffer, durationMs)) {
+        return;
       }
 
-      this.transcriptionProvider.sendAudio(arrayBuffer, 'system');
+      if (this.transcriptionProvider.sendAudio(arrayBuffer, 'system') && chunk.sampleIndex !== undefined) {
+        this.aecProcessor?.markAudioSent('system', chunk.sampleIndex);
+      }
+    });
+
+    this.backend.on('endpoint', (endpoint: AudioEndpoint) => {
+      if (this.capturing) {
+        this.endpointCallback?.(endpoint);
+      }
     });
 
     this.backend.on('start', () => {
@@ -128,11 +189,17 @@ setAECProcessor(processor: AECProcessor | null): void {
       return;
     }
 
-    logger.info('Stopping system audio capture');
+    logger.info('Stopping system audio capture', { nonSpeechWithheldMs: Math.round(this.gatedMs) });
     this.capturing = false;
+    this.audioClass = AudioClass.SPEECH;
+    this.withheld = [];
+    this.withheldMs = 0;
+    this.gatedMs = 0;
+    this.speakerSeconds = [];
 
     // Don't destroy shared AEC processor - it's owned by recordingHandlers
    this.aecProcessor = null;
+   this.audioEngine = null;
 
     try {
       await this.backend.stop();
@@ -159,6 +226,88 @@ setAECProcessor(processor: AECProcessor | null): void {
     return this.capturing;
   }
 
+  /**
+   * The local speaker heard most between `start` and `end` (Date.now()), by
+   * the native per-second IDs; null when none spoke enough to tell
+   */
+  speakerBetween(start: number, end: number): number | null {
+    const counts = new Map<number, number>();
+    for (const { at, speaker } of this.speakerSeconds) {
+      if (speaker === 0 || at <= start || at - 1000 >= end) continue;
+      counts.set(speaker, (counts.get(speaker) ?? 0) + 1);
+    }
+    let best: number | null = null;
+    let bestCount = 0;
+    for (const [speaker, count] of counts) {
+      if (count > bestCount) {
+        best = speaker;
+        bestCount = count;
+      }
+    }
+    return best;
+  }
+
+  // The chunk's last second ends with it, those before a second apart
+  private noteSpeakers(speakers: Uint8Array, endTime: number): void {
+    for (let i = 0; i < speakers.length; i++) {
+      this.speakerSeconds.push({ at: endTime - (speakers.length - 1 - i) * 1000, speaker: speakers[i] });
+    }
+    const cutoff = endTime - SPEAKER_CONFIG.HISTORY_SECONDS * 1000;
+    while (this.speakerSeconds.length > 0 && this.speakerSeconds[0].at < cutoff) {
+      this.speakerSeconds.shift();
+    }
+  }
+
+  /**
+   * Upload gate on the native per-second labels: while the stream is music
+   * or noise its audio is withheld from transcription (the provider is kept
+   * alive instead), keeping the last PREROLL_MS. A second is labelled only
+   * once it ends, so when speech resumes what was withheld goes out first.
+   * Backends without labels always pass.
+   */
+  private admitUpload(chunk: AudioChunk, buffer: ArrayBuffer, durationMs: number): boolean {
+    if (!AUDIO_CLASS_CONFIG.GATE_UPLOAD || !chunk.classes || !this.transcriptionProvider) {
+      return true;
+    }
+    if (chunk.classes.length > 0) {
+      this.audioClass = chunk.classes[chunk.classes.length - 1] as AudioClass;
+    }
+
+    if (this.audioClass === AudioClass.MUSIC || this.audioClass === AudioClass.NOISE) {
+      this.withheld.push({ buffer, durationMs });
+      this.withheldMs += durationMs;
+      this.gatedMs += durationMs;
+      while (this.withheld.length > 1 && this.withheldMs - this.withheld[0].durationMs >= AUDIO_CLASS_CONFIG.PREROLL_MS) {
+        this.withheldMs -= this.withheld.shift()!.durationMs;
+      }
+      this.transcriptionProvider.notifySilence?.(durationMs, 'system');
+      return false;
+    }
+
+    // Not marked sent: the latency trace times live audio only
+    for (const audio of this.withheld) {
+      this.transcriptionProvider.sendAudio(audio.buffer, 'system');
+      this.gatedMs -= audio.durationMs;
+    }
+    this.withheld = [];
+    this.withheldMs = 0;
+    return true;
+  }
+
+  // The chunk's RMS from its frames' native RMS row, scaled as calculateRmsLevel
+  private metadataRmsLevel(metadata: Float64Array): number {
+    const frames = metadata.length / METADATA_FIELDS;
+    if (frames === 0) {
+      return 0;
+    }
+    const row = MetadataField.RMS * frames;
+    let sumSquares = 0;
+    for (let i = 0; i < frames; i++) {
+      sumSquares += metadata[row + i] * metadata[row + i];
+    }
+    return Math.min(1, Math.sqrt(sumSquares / frames) * 3);
+  }
+
   // Calculate RMS level from 16-bit signed integer PCM data
   private calculateRmsLevel(buffer: Buffer): number {
     const samples = new Int16Array(
@@ -179,7 +328,7 @@ setAECProcessor(processor: AECProcessor | null): void {
     return Math.min(1, rms * 3);
   }
 
-  // Convert 16-bit PCM buffer to Float32Array for AEC processing
+  // Convert 16-bit PCM buffer to Float32Array for onSystemAudio listeners
   private bufferToFloat32(buffer: Buffer): Float32Array {
     const samples = new Int16Array(
       buffer.buffer,
@@ -0,0 +1,124 @@
+import { createLogger } from '../core/logger';
+import { QUESTION_TRIGGERS, matchesQuestionPattern } from '../config/constants';
+import { loadNativeAddon } from '../utils/nativeAddon';
+import type { NativeTriggerMatcher, TriggerMatch, TriggerPattern } from '../audio/native/AECProcessor';
+import type { AppSettings } from '@shared/types';
+
+const logger = createLogger('TriggerService');
+
+const QUESTION_ID = 'question';
+const KEYWORD_PREFIX = 'keyword:';
+
+export interface TriggerHits {
+  question: boolean;
+  /** The configured keywords heard, as configured */
+  keywords: string[];
+}
+
+function escapeRegExp(text: string): string {
+  return text.replace(/[.*+?^${}()|[\]\\]/g, '\\$&');
+}
+
+/**
+ * Question and keyword detection over live transcripts. Interim text is fed
+ * to the native matcher as it grows, so a final only scans what is new;
+ * hits are reported once the utterance is final.
+ */
+export class TriggerService {
+  private matcher: NativeTriggerMatcher | null = null;
+  private keywords: string[] = [];
+  private keywordKey: string | null = null;
+  private fed = new Map<string, string>();
+  private matches = new Map<string, TriggerMatch[]>();
+
+  constructor(private getSettings: () => AppSettings) {}
+
+  // Rebuilt when the keyword list changes
+  private getMatcher(): NativeTriggerMatcher | null {
+    const keywords = (this.getSettings().calloutKeywords ?? [])
+      .map((keyword) => keyword.trim())
+      .filter((keyword) => keyword.length > 0 && Buffer.byteLength(keyword) <= 200);
+    const key = keywords.join('\n');
+    if (key === this.keywordKey) return this.matcher;
+
+    this.keywordKey = key;
+    this.keywords = keywords;
+    this.matcher = null;
+    this.fed.clear();
+    this.matches.clear();
+    const module = loadNativeAddon();
+    if (!module || typeof module.TriggerMatcher !== 'function') {
+      logger.warn('Native trigger matcher unavailable - using regex patterns');
+      return null;
+    }
+    const patterns: TriggerPattern[] = [
+      ...QUESTION_TRIGGERS.STARTS_WITH.map((text) => ({ id: QUESTION_ID, text, anchor: 'start' as const })),
+      ...QUESTION_TRIGGERS.ENDS_WITH.map((text) => ({ id: QUESTION_ID, text, anchor: 'end' as const })),
+      ...keywords.map((text, i) => ({ id: `${KEYWORD_PREFIX}${i}`, text })),
+    ];
+    const TriggerMatcher = module.TriggerMatcher as new (patterns: TriggerPattern[]) => NativeTriggerMatcher;
+    try {
+      this.matcher = new TriggerMatcher(patterns);
+      logger.info('Trigger matcher built', { keywords: keywords.length });
+    } catch (error) {
+      logger.warn('Failed to build trigger matcher', { error: (error as Error).message });
+    }
+    return this.matcher;
+  }
+
+  /**
+   * The utterance so far on `stream`. Returns its hits once `isFinal`, null
+   * before that.
+   */
+  scan(stream: string, text: string, isFinal: boolean): TriggerHits | null {
+    const matcher = this.getMatcher();
+    if (!matcher) {
+      return isFinal ? this.scanWithRegex(text) : null;
+    }
+
+    // Providers revise interim text; only an extension can be fed on
+    const fed = this.fed.get(stream) ?? '';
+    let found = this.matches.get(stream) ?? [];
+    if (text.startsWith(fed)) {
+      found = found.concat(matcher.feed(stream, text.slice(fed.length)));
+    } else {
+      matcher.reset(stream);
+      found = matcher.feed(stream, text);
+    }
+
+    if (!isFinal) {
+      this.fed.set(stream, text);
+      this.matches.set(stream, found);
+      return null;
+    }
+    found = found.concat(matcher.end(stream));
+    this.fed.delete(stream);
+    this.matches.delete(stream);
+
+    const keywords = new Set<string>();
+    for (const match of found) {
+      if (match.id.startsWith(KEYWORD_PREFIX)) {
+        keywords.add(this.keywords[Number(match.id.slice(KEYWORD_PREFIX.length))]);
+      }
+    }
+    return { question: found.some((match) => match.id === QUESTION_ID), keywords: Array.from(keywords) };
+  }
+
+  private scanWithRegex(text: string): TriggerHits {
+    const lower = text.toLowerCase();
+    return {
+      question: matchesQuestionPattern(text),
+      keywords: this.keywords.filter((keyword) =>
+        new RegExp(`(^|\\W)${escapeRegExp(keyword.toLowerCase())}($|\\W)`).test(lower)
+      ),
+    };
+  }
+
+  reset(): void {
+    for (const stream of this.fed.keys()) {
+      this.matcher?.reset(stream);
+    }
+    this.fed.clear();
+    this.matches.clear();
+  }
+}
@@ -13,7 +13,12 @@ export class AudioBackendFactory {
   static async create(config: AudioCaptureConfig): Promise<IAudioCaptureBackend> {
     const platform = process.platform;
 
-    logger.info('Creating audio backend', { platform });
+    logger.info('Creating audio backend', { platform, audioEngine: !!config.engineHost?.isRunning() });
+
+    if (config.engineHost?.isRunning()) {
+      const { EngineAudioBackend } = await import('./providers/EngineAudioBackend');
+      return new EngineAudioBackend(config, config.engineHost);
+    }
 
     if (!isPlatform(platform)) {
       throw new Error(
@@ -1,13 +1,62 @@
 import { EventEmitter } from 'events';
+import type { AECProcessor, EndpointOptions, EndpointType, UtteranceProsody } from '@main/audio/native/AECProcessor';
+import type { AudioEngineHost } from '@main/audio/engine/AudioEngineHost';
+import { AUDIO_CLASS_CONFIG, ENDPOINT_CONFIG, SPEAKER_CONFIG, SYSTEM_TAP_CONFIG } from '@main/config/constants';
 
 export interface AudioChunk {
+  /** 16-bit signed PCM */
   data: Buffer;
+  /** Float samples, when the backend produces them natively (skips the s16 round trip) */
+  samples?: Float32Array;
+  /** Capture time of the first sample in the Date.now() domain, when known */
+  timestamp?: number;
+  /** Native stream position of the first sample; closes the latency trace once sent */
+  sampleIndex?: number;
+  /** AudioClass of each second completed in this chunk, from native taps */
+  classes?: Uint8Array;
+  /** Local speaker ID of each second completed in this chunk (0: too little speech), from native taps */
+  speakers?: Uint8Array;
+  /** Per-10ms frame metadata block (AECProcessor MetadataField rows), from native taps */
+  metadata?: Float64Array;
 }
 
+/** Utterance boundary marked natively on the captured audio */
+export interface AudioEndpoint {
+  type: EndpointType;
+  /** Date.now() domain */
+  timestamp: number;
+  sampleIndex: number;
+  /** On 'end', with ENDPOINT_CONFIG.PROSODY: how the utterance's intonation ended */
+  prosody?: UtteranceProsody;
+}
+
+/** endpoint option for native system taps */
+export const SYSTEM_ENDPOINT_OPTIONS: false | EndpointOptions = ENDPOINT_CONFIG.ENABLED && {
+  threshold: ENDPOINT_CONFIG.THRESHOLD,
+  minSpeechMs: ENDPOINT_CONFIG.MIN_SPEECH_MS,
+  trailingSilenceMs: ENDPOINT_CONFIG.TRAILING_SILENCE_MS,
+  prosody: ENDPOINT_CONFIG.PROSODY,
+};
+
+/** classify option for native system taps */
+export const SYSTEM_CLASSIFY: boolean = AUDIO_CLASS_CONFIG.ENABLED;
+
+/** speakers option for native system taps */
+export const SYSTEM_SPEAKERS: boolean = SPEAKER_CONFIG.ENABLED;
+
+/** processes option for the macOS system tap */
+export const SYSTEM_TAP_PROCESSES: string[] | undefined = SYSTEM_TAP_CONFIG.MEETING_APPS_ONLY
+  ? [...SYSTEM_TAP_CONFIG.MEETING_APPS]
+  : undefined;
+
 export interface AudioCaptureConfig {
   sampleRate: number;
   chunkDurationMs: number;
   channels?: 1 | 2;
+  /** Native engine; lets backends capture in-process on the shared host clock */
+  engine?: AECProcessor | null;
+  /** Audio engine process; when running, the tap runs there instead (EngineAudioBackend) */
+  engineHost?: AudioEngineHost | null;
 }
 
 export interface IAudioCaptureBackend extends EventEmitter {
@@ -16,11 +65,13 @@ export interface IAudioCaptureBackend extends EventEmitter {
   isCapturing(): boolean;
 
   on(event: 'data', listener: (chunk: AudioChunk) => void): this;
+  on(event: 'endpoint', listener: (endpoint: AudioEndpoint) => void): this;
   on(event: 'start', listener: () => void): this;
   on(event: 'stop', listener: () => void): this;
   on(event: 'error', listener: (error: Error) => void): this;
 
   emit(event: 'data', chunk: AudioChunk): boolean;
+  emit(event: 'endpoint', endpoint: AudioEndpoint): boolean;
   emit(event: 'start'): boolean;
   emit(event: 'stop'): boolean;
   emit(event: 'error', error: Error): boolean;
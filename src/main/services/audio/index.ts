@@ -1,4 +1,4 @@
-export type { IAudioCaptureBackend, AudioCaptureConfig, AudioChunk } from './IAudioCaptureBackend';
+export type { IAudioCaptureBackend, AudioCaptureConfig, AudioChunk, AudioEndpoint } from './IAudioCaptureBackend';
 export { BaseAudioBackend } from './IAudioCaptureBackend';
 export { AudioBackendFactory } from './AudioBackendFactory';
 export type { Platform } from './AudioBackendFactory';
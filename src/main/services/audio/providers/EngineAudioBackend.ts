@@ -0,0 +1,107 @@
+import {
+  BaseAudioBackend,
+  AudioCaptureConfig,
+  AudioChunk,
+  IAudioCaptureBackend,
+  SYSTEM_TAP_PROCESSES,
+} from '@main/services/audio/IAudioCaptureBackend';
+import { AudioBackendFactory } from '@main/services/audio/AudioBackendFactory';
+import type { AudioEngineHost } from '@main/audio/engine/AudioEngineHost';
+import { createLogger } from '@main/core/logger';
+
+const logger = createLogger('EngineAudio');
+
+// Float [-1, 1] to 16-bit signed PCM
+function floatToInt16Buffer(samples: Float32Array): Buffer {
+  const buffer = Buffer.alloc(samples.length * 2);
+  for (let i = 0; i < samples.length; i++) {
+    const s = Math.max(-1, Math.min(1, samples[i]));
+    buffer.writeInt16LE(Math.round(s * 32767), i * 2);
+  }
+  return buffer;
+}
+
+/**
+ * The platform's native system tap, run in the audio engine process and
+ * drained from its shared memory ring. The ring carries samples only, so
+ * chunks come without endpoints, classes, speakers or metadata. When the
+ * engine cannot tap, the platform backend's external capture (audiotee,
+ * pw-record, FFmpeg) stands in; the engine's AEC then has no reference.
+ */
+export class EngineAudioBackend extends BaseAudioBackend {
+  private fallback: IAudioCaptureBackend | null = null;
+
+  constructor(config: AudioCaptureConfig, private readonly host: AudioEngineHost) {
+    super(config);
+  }
+
+  async start(): Promise<void> {
+    if (this.capturing) {
+      logger.warn('Already capturing');
+      return;
+    }
+
+    logger.info('Starting system audio capture in the audio engine');
+    const started = await this.host.startCapture(
+      'system',
+      {
+        deliveryIntervalMs: this.config.chunkDurationMs,
+        enhance: true,
+        // The tap runs at the output device rate; the stream resamples
+        outputSampleRate: this.config.sampleRate,
+        processes: process.platform === 'darwin' ? SYSTEM_TAP_PROCESSES : undefined,
+      },
+      (delivery) => {
+        if (!this.capturing || delivery.silenceMs > 0) return;
+        const samples = delivery.samples as Float32Array;
+        const audioChunk: AudioChunk = {
+          data: floatToInt16Buffer(samples),
+          samples,
+          timestamp: delivery.timestamp,
+          sampleIndex: delivery.sampleIndex,
+        };
+        this.emit('data', audioChunk);
+      }
+    );
+    if (started) {
+      logger.info('Audio engine system tap started');
+      this.capturing = true;
+      this.emit('start');
+      return;
+    }
+
+    logger.warn('Audio engine system tap unavailable; capturing without an echo reference');
+    const backend = await AudioBackendFactory.create({ ...this.config, engine: null, engineHost: null });
+    backend.on('data', (chunk) => this.emit('data', chunk));
+    backend.on('endpoint', (endpoint) => this.emit('endpoint', endpoint));
+    backend.on('start', () => {
+      this.capturing = true;
+      this.emit('start');
+    });
+    backend.on('stop', () => {
+      this.capturing = false;
+      this.emit('stop');
+    });
+    backend.on('error', (error) => this.emit('error', error));
+    this.fallback = backend;
+    await backend.start();
+  }
+
+  async stop(): Promise<void> {
+    if (this.fallback) {
+      const backend = this.fallback;
+      this.fallback = null;
+      await backend.stop();
+      return;
+    }
+    if (!this.capturing) {
+      return;
+    }
+
+    logger.info('Stopping audio engine system tap');
+    // Its ring's last deliveries still arrive as data
+    await this.host.stopCapture('system');
+    this.capturing = false;
+    this.emit('stop');
+  }
+}
@@ -1,11 +1,28 @@
 import { spawn, ChildProcess } from 'child_process';
-import { BaseAudioBackend } from '@main/services/audio/IAudioCaptureBackend';
+import {
+  BaseAudioBackend,
+  AudioChunk,
+  SYSTEM_CLASSIFY,
+  SYSTEM_ENDPOINT_OPTIONS,
+  SYSTEM_SPEAKERS,
+} from '@main/services/audio/IAudioCaptureBackend';
 import { createLogger } from '@main/core/logger';
 
 const logger = createLogger('LinuxAudio');
 
+// Float [-1, 1] to 16-bit signed PCM
+function floatToInt16Buffer(samples: Float32Array): Buffer {
+  const buffer = Buffer.alloc(samples.length * 2);
+  for (let i = 0; i < samples.length; i++) {
+    const s = Math.max(-1, Math.min(1, samples[i]));
+    buffer.writeInt16LE(Math.round(s * 32767), i * 2);
+  }
+  return buffer;
+}
+
 export class LinuxAudioBackend extends BaseAudioBackend {
   private process: ChildProcess | null = null;
+  private nativeCapture = false;
 
   async start(): Promise<void> {
     if (this.capturing) {
@@ -13,7 +30,87 @@ export class LinuxAudioBackend extends BaseAudioBackend {
       return;
     }
 
-    logger.info('Starting Linux system audio capture via PipeWire');
+    if (this.startNativeCapture()) {
+      return;
+    }
+
+    await this.startPwRecord();
+  }
+
+  /**
+   * In-process PipeWire capture of the default sink's monitor. Returns false
+   * when the native engine is unavailable so start() can fall back to
+   * pw-record.
+   */
+  private startNativeCapture(): boolean {
+    const engine = this.config.engine;
+    if (!engine || !engine.isSystemAudioCaptureSupported()) {
+      return false;
+    }
+
+    try {
+      // PipeWire converts to 48kHz; the stream resamples to the requested rate
+      const started = engine.startSystemAudioCapture(
+        (
+          samples,
+          timestamp,
+          sampleIndex,
+          _hostTimeMs,
+          _vad,
+          _silenceMs,
+          _levels,
+          endpoint,
+          _talk,
+          prosody,
+          classes,
+          speakers,
+          metadata,
+        ) => {
+          if (!this.capturing) return;
+          if (endpoint) {
+            this.emit('endpoint', { type: endpoint, timestamp, sampleIndex, prosody });
+            return;
+          }
+          const audioChunk: AudioChunk = {
+            data: floatToInt16Buffer(samples),
+            samples,
+            timestamp,
+            sampleIndex,
+            classes,
+            speakers,
+            metadata,
+          };
+          this.emit('data', audioChunk);
+        },
+        {
+          deliveryIntervalMs: this.config.chunkDurationMs,
+          outputSampleRate: this.config.sampleRate,
+          enhance: true,
+          endpoint: SYSTEM_ENDPOINT_OPTIONS,
+          classify: SYSTEM_CLASSIFY,
+          speakers: SYSTEM_SPEAKERS,
+          metadata: true,
+        }
+      );
+      if (!started) {
+        return false;
+      }
+    } catch (error) {
+      logger.warn('Native PipeWire capture unavailable, falling back to pw-record', {
+        error: (error as Error).message,
+      });
+      return false;
+    }
+
+    logger.info('Native PipeWire monitor capture started');
+    this.nativeCapture = true;
+    this.capturing = true;
+    this.emit('start');
+    return true;
+  }
+
+  private async startPwRecord(): Promise<void> {
+    logger.info('Starting Linux system audio capture via pw-record');
 
     // Check if pw-record is available
     const checkProcess = spawn('which', ['pw-record']);
@@ -110,6 +207,15 @@ export class LinuxAudioBackend extends BaseAudioBackend {
   }
 
   async stop(): Promise<void> {
+    if (this.nativeCapture) {
+      logger.info('Stopping native PipeWire capture');
+      this.capturing = false;
+      this.config.engine?.stopSystemAudioCapture();
+      this.nativeCapture = false;
+      this.emit('stop');
+      return;
+    }
+
     if (!this.process) {
       return;
     }
@@ -1,7 +1,15 @@
 import { app } from 'electron';
 import { join } from 'path';
 import { existsSync } from 'fs';
-import { BaseAudioBackend, AudioCaptureConfig, AudioChunk } from '@main/services/audio/IAudioCaptureBackend';
+import {
+  BaseAudioBackend,
+  AudioCaptureConfig,
+  AudioChunk,
+  SYSTEM_CLASSIFY,
+  SYSTEM_ENDPOINT_OPTIONS,
+  SYSTEM_SPEAKERS,
+  SYSTEM_TAP_PROCESSES,
+} from '@main/services/audio/IAudioCaptureBackend';
 import { createLogger } from '@main/core/logger';
 
 const logger = createLogger('MacOSAudio');
@@ -53,8 +61,19 @@ function getAudioTeeBinaryPath(): string {
   return candidates[candidates.length - 1];
 }
 
+// Float [-1, 1] to 16-bit signed PCM
+function floatToInt16Buffer(samples: Float32Array): Buffer {
+  const buffer = Buffer.alloc(samples.length * 2);
+  for (let i = 0; i < samples.length; i++) {
+    const s = Math.max(-1, Math.min(1, samples[i]));
+    buffer.writeInt16LE(Math.round(s * 32767), i * 2);
+  }
+  return buffer;
+}
+
 export class MacOSAudioBackend extends BaseAudioBackend {
   private audiotee: AudioTeeInstance | null = null;
+  private nativeCapture = false;
 
   constructor(config: AudioCaptureConfig) {
     super(config);
@@ -68,6 +87,95 @@ export class MacOSAudioBackend extends BaseAudioBackend {
 
     logger.info('Starting macOS system audio capture');
 
+    if (this.startNativeCapture()) {
+      return;
+    }
+
+    await this.startAudioTee();
+  }
+
+  /**
+   * In-process capture through a Core Audio process tap (macOS 14.2+).
+   * Returns false when the tap is unavailable so start() can fall back to audiotee.
+   */
+  private startNativeCapture(): boolean {
+    const engine = this.config.engine;
+    if (!engine || !engine.isSystemAudioCaptureSupported()) {
+      return false;
+    }
+
+    try {
+      const started = engine.startSystemAudioCapture(
+        (
+          samples,
+          timestamp,
+          sampleIndex,
+          _hostTimeMs,
+          _vad,
+          _silenceMs,
+          _levels,
+          endpoint,
+          _talk,
+          prosody,
+          classes,
+          speakers,
+          metadata,
+        ) => {
+          if (!this.capturing) return;
+          if (endpoint) {
+            this.emit('endpoint', { type: endpoint, timestamp, sampleIndex, prosody });
+            return;
+          }
+          const audioChunk: AudioChunk = {
+            data: floatToInt16Buffer(samples),
+            samples,
+            timestamp,
+            sampleIndex,
+            classes,
+            speakers,
+            metadata,
+          };
+          this.emit('data', audioChunk);
+        },
+        {
+          deliveryIntervalMs: this.config.chunkDurationMs,
+          enhance: true,
+          endpoint: SYSTEM_ENDPOINT_OPTIONS,
+          classify: SYSTEM_CLASSIFY,
+          speakers: SYSTEM_SPEAKERS,
+          metadata: true,
+          processes: SYSTEM_TAP_PROCESSES,
+        }
+      );
+      if (!started) {
+        return false;
+      }
+
+      // The tap runs at the output device rate; audiotee resamples, we do not
+      const format = engine.getSystemAudioFormat();
+      if (format && format.sampleRate !== this.config.sampleRate) {
+        logger.warn('System tap rate differs from requested rate, falling back to AudioTee', {
+          tapRate: format.sampleRate,
+          requestedRate: this.config.sampleRate,
+        });
+        engine.stopSystemAudioCapture();
+        return false;
+      }
+    } catch (error) {
+      logger.warn('Native system tap unavailable, falling back to AudioTee', {
+        error: (error as Error).message,
+      });
+      return false;
+    }
+
+    logger.info('Native system audio tap started');
+    this.nativeCapture = true;
+    this.capturing = true;
+    this.emit('start');
+    return true;
+  }
+
+  private async startAudioTee(): Promise<void> {
     const binaryPath = getAudioTeeBinaryPath();
     logger.debug('AudioTee binary path', { path: binaryPath });
 
@@ -116,6 +224,15 @@ export class MacOSAudioBackend extends BaseAudioBackend {
   }
 
   async stop(): Promise<void> {
+    if (this.nativeCapture) {
+      logger.info('Stopping native system audio tap');
+      this.capturing = false;
+      this.config.engine?.stopSystemAudioCapture();
+      this.nativeCapture = false;
+      this.emit('stop');
+      return;
+    }
+
     if (!this.audiotee) {
       return;
     }
@@ -1,7 +1,13 @@
 import { app } from 'electron';
 import { spawn, ChildProcess } from 'child_process';
 import { join } from 'path';
-import { BaseAudioBackend } from '@main/services/audio/IAudioCaptureBackend';
+import {
+  BaseAudioBackend,
+  AudioChunk,
+  SYSTEM_CLASSIFY,
+  SYSTEM_ENDPOINT_OPTIONS,
+  SYSTEM_SPEAKERS,
+} from '@main/services/audio/IAudioCaptureBackend';
 import { createLogger } from '@main/core/logger';
 
 const logger = createLogger('WindowsAudio');
@@ -15,8 +21,19 @@ function getFFmpegPath(): string {
   }
 }
 
+// Float [-1, 1] to 16-bit signed PCM
+function floatToInt16Buffer(samples: Float32Array): Buffer {
+  const buffer = Buffer.alloc(samples.length * 2);
+  for (let i = 0; i < samples.length; i++) {
+    const s = Math.max(-1, Math.min(1, samples[i]));
+    buffer.writeInt16LE(Math.round(s * 32767), i * 2);
+  }
+  return buffer;
+}
+
 export class WindowsAudioBackend extends BaseAudioBackend {
   private process: ChildProcess | null = null;
+  private nativeCapture = false;
 
   async start(): Promise<void> {
     if (this.capturing) {
@@ -24,6 +41,85 @@ export class WindowsAudioBackend extends BaseAudioBackend {
       return;
     }
 
+    if (this.startNativeCapture()) {
+      return;
+    }
+
+    await this.startFFmpeg();
+  }
+
+  /**
+   * In-process WASAPI loopback of the default render endpoint. Returns false
+   * when the native engine is unavailable so start() can fall back to FFmpeg.
+   */
+  private startNativeCapture(): boolean {
+    const engine = this.config.engine;
+    if (!engine || !engine.isSystemAudioCaptureSupported()) {
+      return false;
+    }
+
+    try {
+      // WASAPI converts to 48kHz; the stream resamples to the requested rate
+      const started = engine.startSystemAudioCapture(
+        (
+          samples,
+          timestamp,
+          sampleIndex,
+          _hostTimeMs,
+          _vad,
+          _silenceMs,
+          _levels,
+          endpoint,
+          _talk,
+          prosody,
+          classes,
+          speakers,
+          metadata,
+        ) => {
+          if (!this.capturing) return;
+          if (endpoint) {
+            this.emit('endpoint', { type: endpoint, timestamp, sampleIndex, prosody });
+            return;
+          }
+          const audioChunk: AudioChunk = {
+            data: floatToInt16Buffer(samples),
+            samples,
+            timestamp,
+            sampleIndex,
+            classes,
+            speakers,
+            metadata,
+          };
+          this.emit('data', audioChunk);
+        },
+        {
+          deliveryIntervalMs: this.config.chunkDurationMs,
+          outputSampleRate: this.config.sampleRate,
+          enhance: true,
+          endpoint: SYSTEM_ENDPOINT_OPTIONS,
+          classify: SYSTEM_CLASSIFY,
+          speakers: SYSTEM_SPEAKERS,
+          metadata: true,
+        }
+      );
+      if (!started) {
+        return false;
+      }
+    } catch (error) {
+      logger.warn('Native WASAPI loopback unavailable, falling back to FFmpeg', {
+        error: (error as Error).message,
+      });
+      return false;
+    }
+
+    logger.info('Native WASAPI loopback started');
+    this.nativeCapture = true;
+    this.capturing = true;
+    this.emit('start');
+    return true;
+  }
+
+  private async startFFmpeg(): Promise<void> {
     logger.info('Starting Windows system audio capture via FFmpeg WASAPI');
 
     const ffmpegPath = getFFmpegPath();
@@ -121,6 +217,15 @@ export class WindowsAudioBackend extends BaseAudioBackend {
   }
 
   async stop(): Promise<void> {
+    if (this.nativeCapture) {
+      logger.info('Stopping native WASAPI loopback');
+      this.capturing = false;
+      this.config.engine?.stopSystemAudioCapture();
+      this.nativeCapture = false;
+      this.emit('stop');
+      return;
+    }
+
     if (!this.process) {
       return;
     }
@@ -1,15 +1,46 @@
 import { AssemblyAI } from 'assemblyai';
 import type { StreamingTranscriber } from 'assemblyai';
 import type { TranscriptSegment } from '@shared/types';
-import type { ITranscriptionProvider, TranscriptCallback } from './TranscriptionProvider';
+import type { ITranscriptionProvider, TranscriptCallback, TranscriptionSocketFactory } from './TranscriptionProvider';
+import type { NativeTranscriptionSocket } from '../../audio/native/AECProcessor';
 import { createLogger } from '../../core/logger';
+import { AUDIO_CONFIG } from '../../config/constants';
 
 const logger = createLogger('AssemblyAI');
 
+/** Universal Streaming v3, the endpoint the SDK's transcriber uses */
+const STREAMING_URL = 'wss://streaming.assemblyai.com/v3/ws';
+
+/** The fields of a v3 Turn message (the SDK's 'turn' event) we read */
+interface StreamingTurn {
+  transcript: string;
+  end_of_turn: boolean;
+  turn_is_formatted?: boolean;
+  turn_order: number;
+  words?: Array<{ text: string; confidence: number; start: number; end: number; word_is_final: boolean }>;
+}
+
+/** One connection of a native socket; a reconnect starts the next */
+interface NativeSession {
+  socket: NativeTranscriptionSocket;
+  index: number;
+  /** Where in the audio sent the session starts; its word times count from here */
+  audioOffsetMs: number;
+}
+
+/** What the socket keeps to replay after a dropped connection */
+const NATIVE_REPLAY_MS = 30000;
+const NATIVE_RECONNECT_ATTEMPTS = 5;
+
 export class AssemblyAIProvider implements ITranscriptionProvider {
   readonly name = 'AssemblyAI';
 
   private client: AssemblyAI;
+  protected apiKey: string;
+  private socketFactory: TranscriptionSocketFactory | null = null;
+  private micSocket: NativeTranscriptionSocket | null = null;
+  private micSocketClosed: Promise<void> | null = null;
+  private micSession: NativeSession | null = null;
   private micTranscriber: StreamingTranscriber | null = null;
   private systemTranscriber: StreamingTranscriber | null = null;
   private transcriptCallback: TranscriptCallback | null = null;
@@ -20,9 +51,19 @@ export class AssemblyAIProvider implements ITranscriptionProvider {
 
   constructor(apiKey: string) {
     logger.debug('Initializing', { keyPresent: !!apiKey });
+    this.apiKey = apiKey;
     this.client = new AssemblyAI({ apiKey });
   }
 
+  /** The mic then streams from the capture thread, off the JS thread entirely */
+  useNativeTransport(createSocket: TranscriptionSocketFactory): void {
+    this.socketFactory = createSocket;
+  }
+
+  getNativeTransport(source: 'mic' | 'system'): NativeTranscriptionSocket | null {
+    return source === 'mic' && this.micConnected ? this.micSocket : null;
+  }
+
   onTranscript(callback: TranscriptCallback): void {
     this.transcriptCallback = callback;
   }
@@ -31,22 +72,24 @@ export class AssemblyAIProvider implements ITranscriptionProvider {
     logger.info('Connecting');
     this.startTime = Date.now();
 
-    this.micTranscriber = this.client.streaming.transcriber({
-      sampleRate: 48000,
-      formatTurns: true,
-    });
+    this.micSocket = this.createNativeSocket(AUDIO_CONFIG.MIC_SAMPLE_RATE);
+    if (!this.micSocket) {
+      this.micTranscriber = this.client.streaming.transcriber({
+        sampleRate: AUDIO_CONFIG.MIC_SAMPLE_RATE,
+        formatTurns: true,
+      });
+      this.setupTranscriberHandlers(this.micTranscriber, 'mic');
+    }
 
     this.systemTranscriber = this.client.streaming.transcriber({
-      sampleRate: 48000,
+      sampleRate: AUDIO_CONFIG.SAMPLE_RATE,
       formatTurns: true,
     });
-
-    this.setupTranscriberHandlers(this.micTranscriber, 'mic');
     this.setupTranscriberHandlers(this.systemTranscriber, 'system');
 
     try {
       await Promise.all([
-        this.micTranscriber.connect(),
+        this.micSocket ? this.connectNativeSocket(this.micSocket) : this.micTranscriber!.connect(),
         this.systemTranscriber.connect(),
       ]);
       logger.info('Connected to both transcribers');
@@ -69,24 +112,7 @@ export class AssemblyAIProvider implements ITranscriptionProvider {
       }
     });
 
-    transcriber.on('turn', (turn) => {
-      if (this.isDisconnected) return;
-      if (!this.transcriptCallback) return;
-      if (!turn.transcript || turn.transcript.trim() === '') return;
-
-      const turnData = turn as typeof turn & { turn_is_formatted?: boolean };
-      if (turn.end_of_turn && turnData.turn_is_formatted === false) return;
-
-      const isFinal = turn.end_of_turn && turnData.turn_is_formatted === true;
-      const segmentId = `${source}-${turn.turn_order}`;
-
-      if (isFinal) {
-        logger.debug('Final transcript', { source, text: turn.transcript.slice(0, 30) });
-      }
-
-      const segment = this.createSegment(segmentId, turn.transcript, source, isFinal, turn.words);
-      this.transcriptCallback(segment, isFinal);
-    });
+    transcriber.on('turn', (turn) => this.handleTurn(turn, source));
 
     transcriber.on('error', (error) => {
       logger.error('Transcriber error', error, { source });
@@ -102,12 +128,173 @@ export class AssemblyAIProvider implements ITranscriptionProvider {
     });
   }
 
+  private handleTurn(turn: StreamingTurn, source: 'mic' | 'system', session?: NativeSession): void {
+    if (this.isDisconnected) return;
+    if (!this.transcriptCallback) return;
+    if (!turn.transcript || turn.transcript.trim() === '') return;
+    if (turn.end_of_turn && turn.turn_is_formatted === false) return;
+
+    const isFinal = turn.end_of_turn && turn.turn_is_formatted === true;
+    // A reconnected session numbers its turns from 0 again
+    const segmentId = session && session.index > 0
+      ? `${source}-s${session.index}-${turn.turn_order}`
+      : `${source}-${turn.turn_order}`;
+
+    if (isFinal) {
+      logger.debug('Final transcript', { source, text: turn.transcript.slice(0, 30) });
+    }
+
+    let words = turn.words;
+    let timestamp: number | undefined;
+    if (session && words?.length) {
+      // A replay after a reconnect starts where final results end
+      if (isFinal) {
+        session.socket.acknowledge(words[words.length - 1].end);
+      }
+      // Time the turn and its words by capture through the session's
+      // timeline: exact across gated silence and the late transcription of
+      // a replay, and on one axis across sessions
+      const captured = session.socket.captureTime(words[0].start);
+      if (captured > 0) {
+        timestamp = captured - this.startTime;
+        words = words.map((w) => ({
+          ...w,
+          start: session.socket.captureTime(w.start) - this.startTime,
+          end: session.socket.captureTime(w.end) - this.startTime,
+        }));
+      } else if (session.index > 0) {
+        words = words.map((w) => ({
+          ...w,
+          start: w.start + session.audioOffsetMs,
+          end: w.end + session.audioOffsetMs,
+        }));
+      }
+    }
+
+    const segment = this.createSegment(segmentId, turn.transcript, source, isFinal, words, timestamp);
+    this.transcriptCallback(segment, isFinal);
+  }
+
+  /** The v3 protocol the SDK speaks, on a native socket; null without one */
+  private createNativeSocket(sampleRate: number): NativeTranscriptionSocket | null {
+    if (!this.socketFactory) {
+      return null;
+    }
+    const query = new URLSearchParams({
+      sample_rate: String(sampleRate),
+      encoding: 'pcm_s16le',
+      format_turns: 'true',
+    });
+    return this.socketFactory({
+      url: `${STREAMING_URL}?${query.toString()}`,
+      headers: { Authorization: this.apiKey },
+      sampleRate,
+      closeMessage: JSON.stringify({ type: 'Terminate' }),
+      reconnect: { attempts: NATIVE_RECONNECT_ATTEMPTS },
+      replayMs: NATIVE_REPLAY_MS,
+      parse: 'assemblyai',
+    });
+  }
+
+  /** Resolves once the mic socket is open. Only transcript JSON comes back here. */
+  private connectNativeSocket(socket: NativeTranscriptionSocket): Promise<void> {
+    return new Promise((resolve, reject) => {
+      let opened = false;
+      let closed: () => void = () => {};
+      this.micSocketClosed = new Promise((resolveClosed) => {
+        closed = resolveClosed;
+      });
+      const started = socket.connect((event) => {
+        switch (event.type) {
+          case 'open':
+            if (opened) {
+              logger.info('Transcriber reconnected', {
+                source: 'mic',
+                audioOffsetMs: event.audioOffsetMs,
+                replayedMs: event.replayedMs,
+              });
+            } else {
+              logger.debug('Transcriber opened', { source: 'mic', native: true });
+            }
+            this.micSession = {
+              socket,
+              index: opened && this.micSession ? this.micSession.index + 1 : 0,
+              audioOffsetMs: event.audioOffsetMs,
+            };
+            opened = true;
+            this.micConnected = true;
+            resolve();
+            break;
+          case 'reconnecting':
+            // Audio keeps queueing natively meanwhile
+            logger.warn('Transcriber reconnecting', { source: 'mic', attempt: event.attempt, reason: event.message });
+            break;
+          case 'message': {
+            let message: { type?: string } & Partial<StreamingTurn>;
+            try {
+              message = JSON.parse(event.data);
+            } catch {
+              return;
+            }
+            if (message.type === 'Turn' && this.micSession) {
+              this.handleTurn(message as StreamingTurn, 'mic', this.micSession);
+            }
+            break;
+          }
+          case 'transcript':
+            // Parsed natively: only the fields a turn needs cross into JS
+            if (this.micSession) {
+              this.handleTurn(
+                {
+                  transcript: event.text,
+                  end_of_turn: event.endOfTurn,
+                  turn_is_formatted: event.formatted,
+                  turn_order: event.turn,
+                  words: event.words.map((text, i) => ({
+                    text,
+                    start: event.wordTimes[i * 4],
+                    end: event.wordTimes[i * 4 + 1],
+                    confidence: event.wordTimes[i * 4 + 2],
+                    word_is_final: event.wordTimes[i * 4 + 3] !== 0,
+                  })),
+                },
+                'mic',
+                this.micSession
+              );
+            }
+            break;
+          case 'error':
+            logger.error('Transcriber error', new Error(event.message), { source: 'mic', native: true });
+            break;
+          case 'close':
+            logger.warn('Transcriber closed', {
+              source: 'mic',
+              code: event.code,
+              reason: event.reason,
+              ...socket.getStats(),
+            });
+            this.micConnected = false;
+            closed();
+            if (!opened) {
+              reject(new Error(`Native transcription socket closed (${event.code})`));
+            }
+            break;
+        }
+      });
+      if (!started) {
+        closed();
+        reject(new Error('Native transcription socket did not start'));
+      }
+    });
+  }
+
   private createSegment(
     id: string,
     text: string,
     source: 'mic' | 'system',
     isFinal: boolean,
-    words?: Array<{ text: string; confidence: number; start: number; end: number; word_is_final: boolean }>
+    words?: Array<{ text: string; confidence: number; start: number; end: number; word_is_final: boolean }>,
+    timestamp: number = Date.now() - this.startTime
   ): TranscriptSegment {
     const mappedWords = (words || []).map((w) => ({
       text: w.text,
@@ -120,7 +307,7 @@ export class AssemblyAIProvider implements ITranscriptionProvider {
     return {
       id,
       text,
-      timestamp: Date.now() - this.startTime,
+      timestamp,
       source,
       confidence: 0.95,
       isFinal,
@@ -128,13 +315,21 @@ export class AssemblyAIProvider implements ITranscriptionProvider {
     };
   }
 
-  sendAudio(audioData: ArrayBuffer, source: 'mic' | 'system'): void {
+  sendAudio(audioData: ArrayBuffer, source: 'mic' | 'system'): boolean {
+    // Audio that was not routed to the socket natively still goes out on it
+    if (source === 'mic' && this.micSocket) {
+      if (!this.micConnected) return false;
+      this.micSocket.sendAudio(new Int16Array(audioData));
+      return true;
+    }
     const transcriber = source === 'mic' ? this.micTranscriber : this.systemTranscriber;
     const isConnected = source === 'mic' ? this.micConnected : this.systemConnected;
 
     if (transcriber && isConnected) {
       transcriber.sendAudio(audioData);
+      return true;
     }
+    return false;
   }
 
   async disconnect(): Promise<void> {
@@ -145,6 +340,16 @@ export class AssemblyAIProvider implements ITranscriptionProvider {
     this.micConnected = false;
     this.systemConnected = false;
 
+    if (this.micSocket) {
+      this.micSocket.close();
+      if (this.micSocketClosed) {
+        closePromises.push(this.micSocketClosed);
+      }
+      this.micSocket = null;
+      this.micSocketClosed = null;
+      this.micSession = null;
+    }
+
     if (this.micTranscriber) {
       closePromises.push(this.micTranscriber.close());
       this.micTranscriber = null;
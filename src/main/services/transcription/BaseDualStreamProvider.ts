@@ -24,12 +24,15 @@ export abstract class BaseDualStreamProvider implements ITranscriptionProvider {
    * Send audio to the appropriate stream based on source.
    * Subclasses must implement sendToMic and sendToSystem.
    */
-  sendAudio(audioData: ArrayBuffer, source: 'mic' | 'system'): void {
+  sendAudio(audioData: ArrayBuffer, source: 'mic' | 'system'): boolean {
     if (source === 'mic' && this.micConnected) {
       this.sendToMic(audioData);
+      return true;
     } else if (source === 'system' && this.systemConnected) {
       this.sendToSystem(audioData);
+      return true;
     }
+    return false;
   }
 
   protected abstract sendToMic(audioData: ArrayBuffer): void;
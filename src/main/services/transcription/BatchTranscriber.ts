@@ -0,0 +1,226 @@
+import { existsSync, mkdirSync, rmSync } from 'fs';
+import { readFile } from 'fs/promises';
+import { join } from 'path';
+import { createClient } from '@deepgram/sdk';
+import { v4 as uuidv4 } from 'uuid';
+import type { TranscriptSegment, TranscriptionProvider } from '@shared/types';
+import type {
+  RecordingSegmentFile,
+  SegmentationOptions,
+  SegmentationResult,
+} from '../../audio/native/AECProcessor';
+import { createLogger } from '../../core/logger';
+import { BATCH_TRANSCRIPTION_CONFIG } from '../../config/constants';
+
+const logger = createLogger('BatchTranscriber');
+
+export type RecordingSegmenter = (options: SegmentationOptions) => Promise<SegmentationResult>;
+
+export interface BatchTrack {
+  source: 'mic' | 'system';
+  /** Seek index of the track */
+  index: string;
+}
+
+export interface BatchRecording {
+  tracks: BatchTrack[];
+  /** Epoch ms of recording time 0 */
+  recordingStartedAt: number;
+  /** Epoch ms transcript timestamps count from */
+  transcriptStartedAt: number;
+  /** Scratch directory for the segments; removed when done */
+  workDir: string;
+}
+
+interface BatchResult {
+  text: string;
+  /** ms into the segment */
+  start: number;
+  end: number;
+  confidence: number;
+  words: { text: string; start: number; end: number; confidence: number }[];
+}
+
+/** The tracks of a recording by the index of any one of them */
+export function recordingTracks(index: string): BatchTrack[] {
+  const base = index.replace(/\.[^.]+\.idx$/, '');
+  // The echo-cancelled mic if it was recorded, else the raw one
+  const mic = [`${base}.processed.idx`, `${base}.microphone.idx`].find((path) => existsSync(path));
+  const system = `${base}.system.idx`;
+  const tracks: BatchTrack[] = [];
+  if (mic) tracks.push({ source: 'mic', index: mic });
+  if (existsSync(system)) tracks.push({ source: 'system', index: system });
+  return tracks;
+}
+
+/**
+ * Re-transcribes a finished recording with the provider's prerecorded API,
+ * which is more accurate than its streaming one. The native segmenter
+ * splits each track at pauses on its worker pool and hands segments over
+ * as they are written; up to CONCURRENCY of them upload at once, so the
+ * split and the uploads overlap and an hour-long meeting takes minutes.
+ */
+export class BatchTranscriber {
+  private provider: TranscriptionProvider;
+  private apiKey: string;
+
+  constructor(provider: TranscriptionProvider, apiKey: string) {
+    this.provider = provider;
+    this.apiKey = apiKey;
+  }
+
+  /** Whether the provider has a batch API and a key for it */
+  isAvailable(): boolean {
+    return (this.provider === 'deepgram' || this.provider === 'assemblyai') && !!this.apiKey;
+  }
+
+  /** Final segments of every track, ordered by timestamp; rejects if any segment fails */
+  async transcribe(segment: RecordingSegmenter, recording: BatchRecording): Promise<TranscriptSegment[]> {
+    const startedAt = Date.now();
+    mkdirSync(recording.workDir, { recursive: true });
+
+    const results: TranscriptSegment[] = [];
+    const uploads: Promise<void>[] = [];
+    const waiting: (() => void)[] = [];
+    let active = 0;
+    let failed: Error | null = null;
+
+    // A finished upload hands its slot straight to the next one waiting
+    const acquire = (): Promise<void> => {
+      if (active < BATCH_TRANSCRIPTION_CONFIG.CONCURRENCY) {
+        active++;
+        return Promise.resolve();
+      }
+      return new Promise((resolve) => waiting.push(resolve));
+    };
+    const release = (): void => {
+      const next = waiting.shift();
+      if (next) next();
+      else active--;
+    };
+
+    const upload = async (track: BatchTrack, file: RecordingSegmentFile): Promise<void> => {
+      await acquire();
+      try {
+        if (failed) return;
+        const transcribed = await this.transcribeFile(file.path);
+        for (const result of transcribed) {
+          results.push(this.toSegment(track.source, file, result, recording));
+        }
+      } catch (error) {
+        failed = failed ?? (error as Error);
+      } finally {
+        rmSync(file.path, { force: true });
+        release();
+      }
+    };
+
+    try {
+      const tracks = await Promise.all(
+        recording.tracks.map((track) =>
+          segment({
+            index: track.index,
+            outputDir: recording.workDir,
+            name: track.source,
+            targetSegmentMs: BATCH_TRANSCRIPTION_CONFIG.TARGET_SEGMENT_MS,
+            onSegment: (file) => uploads.push(upload(track, file)),
+          })
+        )
+      );
+      await Promise.all(uploads);
+      if (failed) throw failed;
+
+      results.sort((a, b) => a.timestamp - b.timestamp);
+      logger.info('Recording re-transcribed', {
+        segments: tracks.reduce((sum, t) => sum + t.segments.length, 0),
+        audioMs: Math.round(tracks.reduce((sum, t) => sum + t.audioMs, 0)),
+        speechMs: Math.round(tracks.reduce((sum, t) => sum + t.speechMs, 0)),
+        results: results.length,
+        elapsedMs: Date.now() - startedAt,
+      });
+      return results;
+    } finally {
+      await Promise.allSettled(uploads);
+      rmSync(recording.workDir, { recursive: true, force: true });
+    }
+  }
+
+  private async transcribeFile(path: string): Promise<BatchResult[]> {
+    return this.provider === 'deepgram' ? this.transcribeDeepgram(path) : this.transcribeAssemblyAI(path);
+  }
+
+  private async transcribeDeepgram(path: string): Promise<BatchResult[]> {
+    const client = createClient(this.apiKey);
+    const { result, error } = await client.listen.prerecorded.transcribeFile(await readFile(path), {
+      model: 'nova-3',
+      language: 'en',
+      smart_format: true,
+      utterances: true,
+      mimetype: 'audio/flac',
+    });
+    if (error) throw error;
+
+    // Seconds into the segment
+    return (result?.results?.utterances ?? []).map((u) => ({
+      text: u.transcript,
+      start: u.start * 1000,
+      end: u.end * 1000,
+      confidence: u.confidence,
+      words: u.words.map((w) => ({
+        text: w.punctuated_word ?? w.word,
+        start: w.start * 1000,
+        end: w.end * 1000,
+        confidence: w.confidence,
+      })),
+    }));
+  }
+
+  private async transcribeAssemblyAI(path: string): Promise<BatchResult[]> {
+    const { AssemblyAI } = await import('assemblyai');
+    const client = new AssemblyAI({ apiKey: this.apiKey });
+    const transcript = await client.transcripts.transcribe({ audio: path });
+    if (transcript.status === 'error') {
+      throw new Error(transcript.error || 'AssemblyAI transcription failed');
+    }
+    if (!transcript.text) return [];
+
+    const { sentences } = await client.transcripts.sentences(transcript.id);
+    return sentences.map((s) => ({
+      text: s.text,
+      start: s.start,
+      end: s.end,
+      confidence: s.confidence,
+      words: s.words.map((w) => ({ text: w.text, start: w.start, end: w.end, confidence: w.confidence })),
+    }));
+  }
+
+  private toSegment(
+    source: 'mic' | 'system',
+    file: RecordingSegmentFile,
+    result: BatchResult,
+    recording: BatchRecording
+  ): TranscriptSegment {
+    // Segment offsets are recording time; the transcript counts from its own start
+    const toTimestamp = (ms: number) =>
+      Math.max(0, Math.round(recording.recordingStartedAt + file.startMs + ms - recording.transcriptStartedAt));
+    return {
+      id: uuidv4(),
+      text: result.text,
+      timestamp: toTimestamp(result.start),
+      source,
+      confidence: result.confidence,
+      isFinal: true,
+      words: result.words.map((w) => ({
+        text: w.text,
+        confidence: w.confidence,
+        isFinal: true,
+        start: toTimestamp(w.start),
+        end: toTimestamp(w.end),
+      })),
+    };
+  }
+}
+
+export function batchWorkDir(userData: string, meetingId: string): string {
+  return join(userData, BATCH_TRANSCRIPTION_CONFIG.WORK_DIR, meetingId);
+}
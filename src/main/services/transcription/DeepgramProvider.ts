@@ -2,6 +2,7 @@ import { createClient, LiveTranscriptionEvents, LiveClient } from '@deepgram/sdk
 import { v4 as uuidv4 } from 'uuid';
 import { BaseDualStreamProvider } from './BaseDualStreamProvider';
 import { createLogger } from '../../core/logger';
+import { AUDIO_CONFIG } from '../../config/constants';
 
 const logger = createLogger('Deepgram');
 
@@ -30,13 +31,13 @@ export class DeepgramProvider extends BaseDualStreamProvider {
       smart_format: true,
       interim_results: true,
       encoding: 'linear16',
-      sample_rate: 48000,
+      sample_rate: AUDIO_CONFIG.SAMPLE_RATE,
       channels: 1,
       diarize: false,
       endpointing: 100,
     };
 
-    this.micConnection = client.listen.live(liveOptions);
+    this.micConnection = client.listen.live({ ...liveOptions, sample_rate: AUDIO_CONFIG.MIC_SAMPLE_RATE });
     this.systemConnection = client.listen.live(liveOptions);
 
     const micPromise = this.setupConnectionHandlers(this.micConnection, 'mic');
@@ -126,6 +127,15 @@ export class DeepgramProvider extends BaseDualStreamProvider {
     this.systemConnection?.send(audioData);
   }
 
+  // Deepgram closes a stream after ~10s without audio unless it sees KeepAlive
+  notifySilence(_durationMs: number, source: 'mic' | 'system'): void {
+    const connection = source === 'mic' ? this.micConnection : this.systemConnection;
+    const connected = source === 'mic' ? this.micConnected : this.systemConnected;
+    if (connected) {
+      connection?.keepAlive();
+    }
+  }
+
   async disconnect(): Promise<void> {
     logger.info('Disconnecting');
 
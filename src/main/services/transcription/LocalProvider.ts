@@ -0,0 +1,184 @@
+import type { TranscriptSegment } from '@shared/types';
+import { BaseDualStreamProvider } from './BaseDualStreamProvider';
+import type { LocalTranscriberFactory } from './TranscriptionProvider';
+import type { LocalTranscriberEvent, NativeLocalTranscriber } from '../../audio/native/AECProcessor';
+import { createLogger } from '../../core/logger';
+import { AUDIO_CONFIG, LOCAL_ASR_CONFIG } from '../../config/constants';
+
+const logger = createLogger('Local');
+
+type LocalResult = Extract<LocalTranscriberEvent, { type: 'partial' | 'final' }>;
+
+/**
+ * Transcribes on this machine with the addon's whisper engine: no network,
+ * no per-minute billing. The mic streams to its transcriber from the
+ * capture thread; system audio arrives through sendAudio().
+ */
+export class LocalProvider extends BaseDualStreamProvider {
+  readonly name = 'Local';
+
+  private modelPath: string;
+  private language: string;
+  private createTranscriber: LocalTranscriberFactory | null = null;
+  private micTranscriber: NativeLocalTranscriber | null = null;
+  private systemTranscriber: NativeLocalTranscriber | null = null;
+  private closed: Promise<void>[] = [];
+
+  constructor(modelPath: string, language: string = 'en') {
+    super();
+    logger.debug('Initializing', { modelPath });
+    this.modelPath = modelPath;
+    this.language = language;
+  }
+
+  useLocalEngine(createTranscriber: LocalTranscriberFactory): void {
+    this.createTranscriber = createTranscriber;
+  }
+
+  getNativeTransport(source: 'mic' | 'system'): NativeLocalTranscriber | null {
+    return source === 'mic' && this.micConnected ? this.micTranscriber : null;
+  }
+
+  async connect(): Promise<void> {
+    logger.info('Connecting');
+    this.startTime = Date.now();
+    if (!this.createTranscriber) {
+      throw new Error('On-device transcription is unavailable');
+    }
+
+    this.micTranscriber = this.create(AUDIO_CONFIG.MIC_SAMPLE_RATE);
+    this.systemTranscriber = this.create(AUDIO_CONFIG.SAMPLE_RATE);
+    if (!this.micTranscriber || !this.systemTranscriber) {
+      throw new Error('On-device transcription is unavailable');
+    }
+
+    try {
+      // Both load the same model, so the second waits on the first and shares it
+      await Promise.all([
+        this.start(this.micTranscriber, 'mic'),
+        this.start(this.systemTranscriber, 'system'),
+      ]);
+      logger.info('Model loaded for both streams');
+    } catch (error) {
+      logger.error('Failed to connect', error as Error);
+      throw error;
+    }
+  }
+
+  private create(sampleRate: number): NativeLocalTranscriber | null {
+    return this.createTranscriber!({
+      modelPath: this.modelPath,
+      language: this.language,
+      sampleRate,
+      stepMs: LOCAL_ASR_CONFIG.STEP_MS,
+      maxUtteranceMs: LOCAL_ASR_CONFIG.MAX_UTTERANCE_MS,
+    });
+  }
+
+  /** Resolves once the model is loaded */
+  private start(transcriber: NativeLocalTranscriber, source: 'mic' | 'system'): Promise<void> {
+    return new Promise((resolve, reject) => {
+      let ready = false;
+      let closed: () => void = () => {};
+      this.closed.push(new Promise((resolveClosed) => {
+        closed = resolveClosed;
+      }));
+      const started = transcriber.connect((event) => {
+        switch (event.type) {
+          case 'ready':
+            logger.debug('Transcriber ready', { source, loadMs: Math.round(event.loadMs) });
+            ready = true;
+            this.setConnectionState(source, true);
+            resolve();
+            break;
+          case 'partial':
+          case 'final':
+            this.handleResult(event, source);
+            break;
+          case 'error':
+            logger.error('Transcriber error', new Error(event.message), { source });
+            break;
+          case 'close':
+            logger.info('Transcriber closed', { source, ...transcriber.getStats() });
+            this.setConnectionState(source, false);
+            closed();
+            if (!ready) {
+              reject(new Error('Local transcriber closed before its model loaded'));
+            }
+            break;
+        }
+      });
+      if (!started) {
+        closed();
+        reject(new Error('Local transcriber did not start (addon built without whisper?)'));
+      }
+    });
+  }
+
+  private handleResult(result: LocalResult, source: 'mic' | 'system'): void {
+    if (!this.transcriptCallback || !result.text.trim()) return;
+
+    const isFinal = result.type === 'final';
+    if (isFinal) {
+      logger.debug('Final transcript', { source, text: result.text.slice(0, 30) });
+    }
+
+    const words: TranscriptSegment['words'] = result.words.map((w) => ({
+      text: w.text,
+      confidence: w.confidence,
+      isFinal,
+      start: Math.round(w.start),
+      end: Math.round(w.end),
+    }));
+    const confidence = words.length
+      ? words.reduce((sum, w) => sum + w.confidence, 0) / words.length
+      : 0;
+
+    // A partial and the final of one utterance share its start
+    const segment = this.createBaseSegment(
+      `${source}-${Math.round(result.startMs)}`,
+      result.text,
+      source,
+      isFinal,
+      confidence,
+      words
+    );
+    if (result.timestamp > 0) {
+      segment.timestamp = result.timestamp - this.startTime;
+    }
+    this.transcriptCallback(segment, isFinal);
+  }
+
+  protected sendToMic(audioData: ArrayBuffer): void {
+    this.micTranscriber?.sendAudio(new Int16Array(audioData));
+  }
+
+  protected sendToSystem(audioData: ArrayBuffer): void {
+    this.systemTranscriber?.sendAudio(new Int16Array(audioData));
+  }
+
+  // The mic gate withholds silence: whatever was said before it is done
+  notifySilence(_durationMs: number, source: 'mic' | 'system'): void {
+    this.notifyUtteranceEnd(source);
+  }
+
+  notifyUtteranceEnd(source: 'mic' | 'system'): void {
+    const transcriber = source === 'mic' ? this.micTranscriber : this.systemTranscriber;
+    transcriber?.endUtterance();
+  }
+
+  async disconnect(): Promise<void> {
+    logger.info('Disconnecting');
+
+    // Close finalizes the open utterances; wait for their results
+    this.micTranscriber?.close();
+    this.systemTranscriber?.close();
+    await Promise.all(this.closed);
+    this.closed = [];
+    this.micTranscriber = null;
+    this.systemTranscriber = null;
+
+    this.resetState();
+    logger.info('Disconnected');
+  }
+}
@@ -1,7 +1,25 @@
 import type { TranscriptSegment } from '@shared/types';
+import type {
+  ChannelInterleaverOptions,
+  LocalTranscriberOptions,
+  NativeChannelInterleaver,
+  NativeInterleaverChannel,
+  NativeLocalTranscriber,
+  NativeTranscriptionSocket,
+  TranscriptionSocketOptions,
+} from '../../audio/native/AECProcessor';
 
 export type TranscriptCallback = (segment: TranscriptSegment, isFinal: boolean) => void;
 
+/** AECProcessor.createTranscriptionSocket, or null where the addon has none */
+export type TranscriptionSocketFactory = (options: TranscriptionSocketOptions) => NativeTranscriptionSocket | null;
+
+/** AECProcessor.createChannelInterleaver, or null where the addon has none */
+export type ChannelInterleaverFactory = (options: ChannelInterleaverOptions) => NativeChannelInterleaver | null;
+
+/** AECProcessor.createLocalTranscriber, or null where the addon has none */
+export type LocalTranscriberFactory = (options: LocalTranscriberOptions) => NativeLocalTranscriber | null;
+
 /**
  * Interface for transcription service providers.
  * Supports dual audio streams (mic + system) with separate transcribers.
@@ -13,8 +31,46 @@ export interface ITranscriptionProvider {
   /** Connect to the transcription service */
   connect(): Promise<void>;
 
-  /** Send audio data to the appropriate transcriber */
-  sendAudio(audioData: ArrayBuffer, source: 'mic' | 'system'): void;
+  /**
+   * Send audio data to the appropriate transcriber. Returns true when it was
+   * written to the socket, false when that stream is not connected.
+   */
+  sendAudio(audioData: ArrayBuffer, source: 'mic' | 'system'): boolean;
+
+  /**
+   * The capture gate withheld `durationMs` of non-speech on `source`.
+   * Providers that drop idle sockets keep them alive here.
+   */
+  notifySilence?(durationMs: number, source: 'mic' | 'system'): void;
+
+  /**
+   * Before connect(): carry audio over native sockets from `createSocket`
+   * where the provider knows its wire protocol, and for a multichannel
+   * provider both streams over one socket through `createInterleaver`.
+   * Others ignore it.
+   */
+  useNativeTransport?(createSocket: TranscriptionSocketFactory, createInterleaver?: ChannelInterleaverFactory): void;
+
+  /**
+   * A native endpointer closed an utterance on `source`. Providers that
+   * decide utterances themselves finalize here.
+   */
+  notifyUtteranceEnd?(source: 'mic' | 'system'): void;
+
+  /**
+   * Before connect(): on-device transcribers from `createTranscriber`, for
+   * the providers that run locally. Others ignore it.
+   */
+  useLocalEngine?(createTranscriber: LocalTranscriberFactory): void;
+
+  /**
+   * After connect(): the socket or transcriber a native capture stream
+   * should send `source` to (MicCaptureOptions.transport); null to keep
+   * sendAudio()
+   */
+  getNativeTransport?(
+    source: 'mic' | 'system'
+  ): NativeTranscriptionSocket | NativeLocalTranscriber | NativeInterleaverChannel | null;
 
   /** Disconnect from the transcription service */
   disconnect(): Promise<void>;
@@ -0,0 +1,72 @@
+import type { Meeting, TranscriptSegment, TranscriptWord } from '@shared/types';
+import type { AlignmentWord, TranscriptAligner } from '../../audio/native/AECProcessor';
+import type { MeetingRepository } from '../../data/repositories/MeetingRepository';
+import { createLogger } from '../../core/logger';
+import { recordingTracks } from './BatchTranscriber';
+
+const logger = createLogger('WordAligner');
+
+/**
+ * Re-times a finished meeting's transcript words against its recording and
+ * stores them, sample offsets included, through the repository. Provider
+ * word times drift, restart at reconnects and lose their place across
+ * gated silence; only their spacing within a segment is trusted here, from
+ * where the segment sits in the recording, and the native aligner finds
+ * the rest. Each track is aligned on its own; resolves the number of
+ * segments updated, 0 without a recording or words.
+ */
+export async function alignMeetingWords(
+  align: TranscriptAligner,
+  meeting: Meeting,
+  meetingRepo: MeetingRepository
+): Promise<number> {
+  if (!meeting.recordingIndex || meeting.recordingStartedAt == null) return 0;
+  const recordingStartedAt = meeting.recordingStartedAt;
+  const transcriptStartedAt = meeting.createdAt.getTime();
+  const updated: TranscriptSegment[] = [];
+
+  for (const track of recordingTracks(meeting.recordingIndex)) {
+    const segments = meeting.transcript.filter((s) => s.source === track.source && s.words.length > 0);
+    const words: AlignmentWord[] = [];
+    for (const segment of segments) {
+      const offset = meetingRepo.getRecordingOffset(meeting, segment) ?? 0;
+      const first = segment.words[0].start;
+      for (const word of segment.words) {
+        words.push({ text: word.text, startMs: offset + word.start - first, endMs: offset + word.end - first });
+      }
+    }
+    if (words.length === 0) continue;
+
+    const result = await align({ index: track.index, words });
+    // Back from recording time to the transcript's
+    const toTimestamp = (ms: number) => Math.max(0, Math.round(recordingStartedAt + ms - transcriptStartedAt));
+    let at = 0;
+    for (const segment of segments) {
+      const aligned: TranscriptWord[] = segment.words.map((word, i) => {
+        const timing = result.words[at + i];
+        return {
+          ...word,
+          start: toTimestamp(timing.startMs),
+          end: toTimestamp(timing.endMs),
+          startSample: timing.startSample,
+          endSample: timing.endSample,
+        };
+      });
+      at += segment.words.length;
+      updated.push({ ...segment, words: aligned });
+    }
+    logger.info('Aligned words', {
+      meetingId: meeting.id,
+      source: track.source,
+      words: words.length,
+      runs: result.runs,
+      meanShiftMs: Math.round(result.meanShiftMs),
+      elapsedMs: Math.round(result.elapsedMs),
+    });
+  }
+
+  if (updated.length > 0) {
+    meetingRepo.updateWordTimings(meeting.id, updated);
+  }
+  return updated.length;
+}
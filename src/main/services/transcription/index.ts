@@ -1,21 +1,40 @@
-export type { ITranscriptionProvider, TranscriptCallback } from './TranscriptionProvider';
+export type {
+  ChannelInterleaverFactory,
+  ITranscriptionProvider,
+  LocalTranscriberFactory,
+  TranscriptCallback,
+  TranscriptionSocketFactory,
+} from './TranscriptionProvider';
 export { BaseDualStreamProvider } from './BaseDualStreamProvider';
 export { AssemblyAIProvider } from './AssemblyAIProvider';
 export { DeepgramProvider } from './DeepgramProvider';
+export { LocalProvider } from './LocalProvider';
+export { BatchTranscriber, batchWorkDir, recordingTracks } from './BatchTranscriber';
+export type { BatchRecording, BatchTrack, RecordingSegmenter } from './BatchTranscriber';
+export { alignMeetingWords } from './WordAligner';
 
 import type { TranscriptionProvider } from '@shared/types';
 import type { ITranscriptionProvider } from './TranscriptionProvider';
 import { AssemblyAIProvider } from './AssemblyAIProvider';
 import { DeepgramProvider } from './DeepgramProvider';
+import { LocalProvider } from './LocalProvider';
 
 export function createTranscriptionProvider(
   provider: TranscriptionProvider,
   assemblyAiKey: string,
   deepgramKey: string,
   hostedTokenManager?: { getAssemblyAIToken: () => Promise<string | null> },
-  useHostedTokens?: boolean
+  useHostedTokens?: boolean,
+  localModelPath?: string,
+  language?: string
 ): ITranscriptionProvider {
   switch (provider) {
+    case 'local':
+      if (!localModelPath) {
+        throw new Error('Local transcription model not configured');
+      }
+      return new LocalProvider(localModelPath, language);
+
     case 'deepgram':
       if (!deepgramKey) {
         throw new Error('Deepgram API key not configured');
@@ -51,6 +70,7 @@ class AssemblyAIProviderWithHostedTokens extends AssemblyAIProvider {
     // Reinitialize client with fresh token before connecting
     const { AssemblyAI } = await import('assemblyai');
     (this as any).client = new AssemblyAI({ apiKey: token });
+    this.apiKey = token;
     return super.connect();
   }
 }
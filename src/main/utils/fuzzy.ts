@@ -0,0 +1,102 @@
+import { createLogger } from '../core/logger';
+import { loadNativeAddon } from './nativeAddon';
+import type { FuzzyEntry, FuzzyHit, NativeFuzzyIndex } from '../audio/native/AECProcessor';
+
+const logger = createLogger('Fuzzy');
+
+export type { FuzzyEntry, FuzzyHit };
+
+export interface FuzzySearchOptions {
+  limit?: number;
+  /** 0-1, default 0.75 */
+  minScore?: number;
+}
+
+export interface FuzzyMatcher {
+  search(query: string, options?: FuzzySearchOptions): FuzzyHit[];
+}
+
+let warned = false;
+
+// The addon's folding: ASCII lowercase, punctuation runs to one space
+function normalize(text: string): string {
+  return text
+    .toLowerCase()
+    .replace(/[^a-z0-9\u0080-\uffff]+/g, ' ')
+    .trim()
+    .slice(0, 64);
+}
+
+function levenshtein(a: string, b: string): number {
+  let row = Array.from({ length: b.length + 1 }, (_, j) => j);
+  for (let i = 1; i <= a.length; i++) {
+    const next = [i];
+    for (let j = 1; j <= b.length; j++) {
+      next[j] = Math.min(row[j] + 1, next[j - 1] + 1, row[j - 1] + (a[i - 1] === b[j - 1] ? 0 : 1));
+    }
+    row = next;
+  }
+  return row[b.length];
+}
+
+function similarity(a: string, b: string): number {
+  const longest = Math.max(a.length, b.length);
+  return longest === 0 ? 1 : 1 - levenshtein(a, b) / longest;
+}
+
+// What the native index scores, minus Jaro-Winkler and the trigram
+// prefilter: every key is compared
+class ScanMatcher implements FuzzyMatcher {
+  private keys: Array<{ id: string; key: number; text: string }> = [];
+
+  constructor(entries: FuzzyEntry[]) {
+    for (const entry of entries) {
+      entry.keys.forEach((key, i) => {
+        const text = normalize(key);
+        if (text) this.keys.push({ id: entry.id, key: i, text });
+      });
+    }
+  }
+
+  search(query: string, options: FuzzySearchOptions = {}): FuzzyHit[] {
+    const text = normalize(query);
+    if (!text) return [];
+    const oneWord = !text.includes(' ');
+    const best = new Map<string, FuzzyHit>();
+    for (const key of this.keys) {
+      let score = similarity(text, key.text);
+      if (oneWord) {
+        for (const word of key.text.split(' ')) {
+          score = Math.max(score, 0.95 * similarity(text, word));
+        }
+      }
+      if (score < (options.minScore ?? 0.75)) continue;
+      const seen = best.get(key.id);
+      if (!seen || score > seen.score) best.set(key.id, { id: key.id, key: key.key, score });
+    }
+    return [...best.values()].sort((a, b) => b.score - a.score).slice(0, options.limit ?? 10);
+  }
+}
+
+/**
+ * An index for approximate name and email lookup: the native FuzzyIndex,
+ * or a linear scan where the addon is missing. Build a new one when the
+ * entries change.
+ */
+export function createFuzzyMatcher(entries: FuzzyEntry[]): FuzzyMatcher {
+  const module = loadNativeAddon();
+  if (module && typeof module.FuzzyIndex === 'function') {
+    const FuzzyIndex = module.FuzzyIndex as new (entries: FuzzyEntry[]) => NativeFuzzyIndex;
+    return new FuzzyIndex(entries);
+  }
+  if (!warned) {
+    warned = true;
+    logger.warn('Native fuzzy index unavailable - scanning every key');
+  }
+  return new ScanMatcher(entries);
+}
+
+/** An address as keys: whole, and its local part without the domain's words */
+export function emailKeys(email: string): string[] {
+  return [email, email.split('@')[0] ?? ''];
+}
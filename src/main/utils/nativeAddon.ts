@@ -0,0 +1,116 @@
+import bindings from 'bindings';
+import { existsSync } from 'fs';
+import { join } from 'path';
+import { createLogger } from '../core/logger';
+
+const logger = createLogger('NativeAddon');
+
+let cached: Record<string, unknown> | null | undefined;
+
+export interface CpuKernelDispatch {
+  name: string;
+  level: 'accelerate' | 'avx2' | 'sse2' | 'neon' | 'aesni' | 'armv8' | 'scalar';
+  specialized: boolean;
+}
+
+// The addon's build and the SIMD path each of its kernel families runs
+export interface CpuFeatures {
+  arch: 'arm64' | 'x86_64' | 'x86' | 'unknown';
+  translated: boolean;
+  sse2: boolean;
+  avx2: boolean;
+  fma: boolean;
+  neon: boolean;
+  kernels: CpuKernelDispatch[];
+}
+
+// CPU time of the addon's named threads and of its processing graph stages
+export interface NativeThreadCpu {
+  /** Running threads, e.g. 'aecDsp', 'captureConsumer', 'schedulerWorker' */
+  threads: Array<{ name: string; tid: number; cpuMs: number }>;
+  /** Exited threads, summed per name since load */
+  exited: Array<{ name: string; threads: number; cpuMs: number }>;
+  /** This thread's live ProcessingGraph stages, summed by type */
+  stages: Array<{ type: string; graphs: number; frames: number; cpuMs: number }>;
+}
+
+// The audio addon for its module functions and classes, without making a
+// capture instance; null when it cannot be loaded
+export function loadNativeAddon(): Record<string, unknown> | null {
+  if (cached !== undefined) return cached;
+  cached = null;
+  try {
+    cached = bindings('audio_capture_native') as Record<string, unknown>;
+  } catch {
+    const candidates = [
+      join(__dirname, 'audio_capture_native.node'),
+      join(process.cwd(), 'native/build/Release/audio_capture_native.node'),
+    ];
+    if (process.resourcesPath) {
+      candidates.push(
+        join(process.resourcesPath, 'app/native/build/Release/audio_capture_native.node'),
+        join(process.resourcesPath, 'native/build/Release/audio_capture_native.node')
+      );
+    }
+    const found = candidates.find((candidate) => existsSync(candidate));
+    if (found) {
+      try {
+        // eslint-disable-next-line @typescript-eslint/no-require-imports
+        cached = require(found) as Record<string, unknown>;
+      } catch (error) {
+        logger.warn('Failed to load native addon', { path: found, error: (error as Error).message });
+      }
+    }
+  }
+  if (cached) reportCpuFeatures(cached);
+  return cached;
+}
+
+// The addon's SIMD dispatch; null when it cannot be loaded or predates it
+export function getCpuFeatures(): CpuFeatures | null {
+  const module = loadNativeAddon();
+  if (!module || typeof module.getCpuFeatures !== 'function') return null;
+  return (module.getCpuFeatures as () => CpuFeatures)();
+}
+
+// Per-thread and per-stage CPU; null when the addon cannot be loaded or
+// predates it
+export function getNativeThreadCpu(): NativeThreadCpu | null {
+  const module = loadNativeAddon();
+  if (!module || typeof module.getThreadCpu !== 'function') return null;
+  return (module.getThreadCpu as () => NativeThreadCpu)();
+}
+
+// Once per load, so a translated build or a lost vector path is in the field logs
+function reportCpuFeatures(module: Record<string, unknown>): void {
+  if (typeof module.getCpuFeatures !== 'function') return;
+  const features = (module.getCpuFeatures as () => CpuFeatures)();
+  const scalar = features.kernels
+    .filter((kernel) => kernel.level === 'scalar')
+    .map((kernel) => kernel.name);
+  logger.info('Native DSP dispatch', {
+    arch: features.arch,
+    translated: features.translated,
+    kernels: Object.fromEntries(features.kernels.map((kernel) => [kernel.name, kernel.level])),
+  });
+  if (features.translated) {
+    logger.warn('Native addon is running translated; the native slice was not loaded', { arch: features.arch });
+  }
+  if (scalar.length > 0 && (features.sse2 || features.neon)) {
+    logger.warn('Native kernels fell back to scalar', { kernels: scalar });
+  }
+}
+
+// Maps the addon's DSP module (WebRTC's APM) in the background ahead of the
+// first echo canceller, which would otherwise load it at capture start.
+// Resolves false when it is missing or the addon predates the split.
+export async function preloadDsp(): Promise<boolean> {
+  const module = loadNativeAddon();
+  if (!module || typeof module.preloadDsp !== 'function') return false;
+  try {
+    return await (module.preloadDsp as () => Promise<boolean>)();
+  } catch (error) {
+    logger.warn('Failed to preload the DSP module', { error: (error as Error).message });
+    return false;
+  }
+}
@@ -1,4 +1,5 @@
 import { createLogger } from '../core/logger';
+import { getNativeThreadCpu } from './nativeAddon';
 
 const logger = createLogger('Performance');
 
@@ -21,6 +22,7 @@ const completedTimings: TimingEntry[] = [];
 const MAX_COMPLETED_TIMINGS = 100;
 
 let lastCpuUsage: NodeJS.CpuUsage | null = null;
+let lastNativeCpu: { threads: Map<string, number>; stages: Map<string, number> } | null = null;
 
 // Start timing an operation
 export function startTiming(name: string, metadata?: Record<string, unknown>): string {
@@ -106,6 +108,39 @@ export function getCpuUsage(): { user: number; system: number } {
   };
 }
 
+// Native CPU since last call, in ms: per thread name (running and exited
+// threads of the name together) and per graph stage type. otherMs is the
+// rest of the process's CPU: V8, libuv and the OS's audio IO threads.
+export function getNativeCpuUsage(processCpuMs: number): {
+  threads: Record<string, number>;
+  stages: Record<string, number>;
+  otherMs: number;
+} | null {
+  const snapshot = getNativeThreadCpu();
+  if (!snapshot) return null;
+
+  const threads = new Map<string, number>();
+  for (const entry of [...snapshot.threads, ...snapshot.exited]) {
+    threads.set(entry.name, (threads.get(entry.name) ?? 0) + entry.cpuMs);
+  }
+  const stages = new Map(snapshot.stages.map((stage) => [stage.type, stage.cpuMs]));
+  const previous = lastNativeCpu;
+  lastNativeCpu = { threads, stages };
+
+  // Graphs can be freed between calls, so a stage never reads below zero
+  const since = (current: Map<string, number>, before?: Map<string, number>) =>
+    Object.fromEntries(
+      [...current].map(([name, ms]) => [name, Math.max(0, ms - (before?.get(name) ?? 0))])
+    );
+  const threadMs = since(threads, previous?.threads);
+  const nativeMs = Object.values(threadMs).reduce((sum, ms) => sum + ms, 0);
+  return {
+    threads: threadMs,
+    stages: since(stages, previous?.stages),
+    otherMs: Math.max(0, processCpuMs - nativeMs),
+  };
+}
+
 // Get all performance metrics
 export function getPerformanceMetrics(): PerformanceMetrics {
   return {
@@ -147,7 +182,10 @@ export function getTimingsSummary(): Record<string, { count: number; avgMs: numb
 export function logPerformanceSnapshot(): void {
   const memory = getMemoryStats();
   const cpu = getCpuUsage();
+  const native = getNativeCpuUsage(cpu.user + cpu.system);
   const uptime = process.uptime();
+  const formatMs = (values: Record<string, number>) =>
+    Object.fromEntries(Object.entries(values).map(([name, ms]) => [name, ms.toFixed(2)]));
 
   logger.info('Performance snapshot', {
     uptime: `${Math.round(uptime)}s`,
@@ -156,6 +194,13 @@ export function logPerformanceSnapshot(): void {
       userMs: cpu.user.toFixed(2),
       systemMs: cpu.system.toFixed(2),
     },
+    ...(native && {
+      nativeCpuMs: {
+        threads: formatMs(native.threads),
+        stages: formatMs(native.stages),
+        otherMs: native.otherMs.toFixed(2),
+      },
+    }),
   });
 }
 
@@ -0,0 +1,66 @@
+import { app } from 'electron';
+import { existsSync } from 'fs';
+import { join } from 'path';
+import { createLogger } from '../core/logger';
+import { EXPORT_CONFIG, PROMPT_CONFIG } from '../config/constants';
+import { loadNativeAddon } from './nativeAddon';
+import type { NativeTokenizer } from '../audio/native/AECProcessor';
+
+const logger = createLogger('Tokens');
+
+// Rough cl100k ratio for English, when the addon is missing
+const CHARS_PER_TOKEN = 4;
+
+let tokenizer: NativeTokenizer | null | undefined;
+
+function getTokenizer(): NativeTokenizer | null {
+  if (tokenizer !== undefined) return tokenizer;
+  tokenizer = null;
+  const module = loadNativeAddon();
+  if (!module || typeof module.Tokenizer !== 'function') {
+    logger.warn('Native tokenizer unavailable - estimating tokens from length');
+    return tokenizer;
+  }
+  const Tokenizer = module.Tokenizer as new (ranksPath?: string) => NativeTokenizer;
+  const ranks = [
+    join(app.getPath('userData'), EXPORT_CONFIG.DATA_DIR, PROMPT_CONFIG.TOKENIZER_RANKS_FILE),
+    ...(process.resourcesPath ? [join(process.resourcesPath, PROMPT_CONFIG.TOKENIZER_RANKS_FILE)] : []),
+  ].find((candidate) => existsSync(candidate));
+  try {
+    tokenizer = ranks ? new Tokenizer(ranks) : new Tokenizer();
+  } catch (error) {
+    logger.warn('Failed to load tokenizer ranks', { path: ranks, error: (error as Error).message });
+    tokenizer = new Tokenizer();
+  }
+  logger.info('Tokenizer ready', { exact: tokenizer.isExact() });
+  return tokenizer;
+}
+
+export function countTokens(text: string): number {
+  const native = getTokenizer();
+  return native ? native.count(text) : Math.ceil(text.length / CHARS_PER_TOKEN);
+}
+
+/** `text` cut to `maxTokens`, keeping the end rather than the start when `fromEnd` */
+export function truncateTokens(text: string, maxTokens: number, fromEnd = false): string {
+  const native = getTokenizer();
+  if (native) return native.truncate(text, maxTokens, fromEnd);
+  const chars = maxTokens * CHARS_PER_TOKEN;
+  if (text.length <= chars) return text;
+  return fromEnd ? text.slice(text.length - chars) : text.slice(0, chars);
+}
+
+/** Token-bounded chunks cut at sentence and line boundaries */
+export function chunkTokens(text: string, maxTokens: number, overlapTokens = 0): { text: string; tokens: number }[] {
+  const native = getTokenizer();
+  if (native) return native.chunk(text, { maxTokens, overlapTokens });
+  const chars = maxTokens * CHARS_PER_TOKEN;
+  const step = Math.max(1, chars - overlapTokens * CHARS_PER_TOKEN);
+  const chunks: { text: string; tokens: number }[] = [];
+  for (let start = 0; start < text.length; start += step) {
+    const chunk = text.slice(start, start + chars).trim();
+    if (chunk) chunks.push({ text: chunk, tokens: Math.ceil(chunk.length / CHARS_PER_TOKEN) });
+    if (start + chars >= text.length) break;
+  }
+  return chunks;
+}
@@ -2,6 +2,9 @@ import { contextBridge, ipcRenderer } from 'electron';
 import { IPC_CHANNELS } from '@shared/ipcChannels';
 import type {
   Meeting,
+  MeetingListPage,
+  MeetingPageCursor,
+  MeetingSearchHit,
   AppSettings,
   RecordingState,
   AudioLevels,
@@ -11,6 +14,9 @@ import type {
   CalendarAttendee,
   CalendarConnections,
   Person,
+  PeopleListPage,
+  PeoplePageCursor,
+  KnowledgeSearchResult,
 } from '@shared/types';
 
 // Expose protected methods to the renderer process
@@ -52,10 +58,6 @@ contextBridge.exposeInMainWorld('kakarot', {
       ipcRenderer.on(IPC_CHANNELS.AUDIO_LEVELS, handler);
       return () => ipcRenderer.removeListener(IPC_CHANNELS.AUDIO_LEVELS, handler);
     },
-    // Send microphone audio data (system audio handled by main process via AudioTee)
-    sendData: (audioData: ArrayBuffer, source: 'mic' | 'system') => {
-      ipcRenderer.send(IPC_CHANNELS.AUDIO_DATA, audioData, source);
-    },
   },
 
   // Transcription
@@ -75,16 +77,28 @@ contextBridge.exposeInMainWorld('kakarot', {
   // Meetings
   meetings: {
     list: (): Promise<Meeting[]> => ipcRenderer.invoke(IPC_CHANNELS.MEETINGS_LIST),
+    listPage: (after?: MeetingPageCursor | null, limit?: number): Promise<MeetingListPage> =>
+      ipcRenderer.invoke(IPC_CHANNELS.MEETINGS_LIST_PAGE, after, limit),
     get: (id: string): Promise<Meeting | null> =>
       ipcRenderer.invoke(IPC_CHANNELS.MEETINGS_GET, id),
     delete: (id: string): Promise<void> =>
       ipcRenderer.invoke(IPC_CHANNELS.MEETINGS_DELETE, id),
     search: (query: string): Promise<Meeting[]> =>
       ipcRenderer.invoke(IPC_CHANNELS.MEETINGS_SEARCH, query),
+    searchHits: (query: string, limit?: number): Promise<MeetingSearchHit[]> =>
+      ipcRenderer.invoke(IPC_CHANNELS.MEETINGS_SEARCH_HITS, query, limit),
     summarize: (id: string): Promise<string> =>
       ipcRenderer.invoke(IPC_CHANNELS.MEETING_SUMMARIZE, id),
     export: (id: string, format: 'markdown' | 'pdf'): Promise<string> =>
       ipcRenderer.invoke(IPC_CHANNELS.MEETING_EXPORT, id, format),
+    exportClip: (id: string, timestamp: number, durationMs?: number): Promise<string> =>
+      ipcRenderer.invoke(IPC_CHANNELS.MEETING_EXPORT_CLIP, id, timestamp, durationMs),
+    exportBundle: (id: string): Promise<string> => ipcRenderer.invoke(IPC_CHANNELS.MEETING_EXPORT_BUNDLE, id),
+    onExportProgress: (callback: (data: { meetingId: string; fraction: number }) => void) => {
+      const handler = (_: unknown, data: { meetingId: string; fraction: number }) => callback(data);
+      ipcRenderer.on(IPC_CHANNELS.MEETING_EXPORT_PROGRESS, handler);
+      return () => ipcRenderer.removeListener(IPC_CHANNELS.MEETING_EXPORT_PROGRESS, handler);
+    },
     saveManualNotes: (id: string, content: string): Promise<void> =>
       ipcRenderer.invoke(IPC_CHANNELS.MEETING_NOTES_SAVE_MANUAL, id, content),
     askNotes: (id: string, query: string): Promise<string> =>
@@ -129,7 +143,7 @@ contextBridge.exposeInMainWorld('kakarot', {
   knowledge: {
     index: (path: string): Promise<void> =>
       ipcRenderer.invoke(IPC_CHANNELS.KNOWLEDGE_INDEX, path),
-    search: (query: string): Promise<unknown[]> =>
+    search: (query: string): Promise<KnowledgeSearchResult[]> =>
       ipcRenderer.invoke(IPC_CHANNELS.KNOWLEDGE_SEARCH, query),
   },
 
@@ -137,6 +151,8 @@ contextBridge.exposeInMainWorld('kakarot', {
   people: {
     list: (): Promise<Person[]> =>
       ipcRenderer.invoke(IPC_CHANNELS.PEOPLE_LIST),
+    listPage: (after?: PeoplePageCursor | null, limit?: number): Promise<PeopleListPage> =>
+      ipcRenderer.invoke(IPC_CHANNELS.PEOPLE_LIST_PAGE, after, limit),
     search: (query: string): Promise<Person[]> =>
       ipcRenderer.invoke(IPC_CHANNELS.PEOPLE_SEARCH, query),
     get: (email: string): Promise<Person | null> =>
@@ -230,7 +246,6 @@ declare global {
       };
       audio: {
         onLevels: (callback: (levels: AudioLevels) => void) => () => void;
-        sendData: (audioData: ArrayBuffer, source: 'mic' | 'system') => void;
       };
       transcript: {
         onUpdate: (callback: (update: TranscriptUpdate) => void) => () => void;
@@ -238,11 +253,16 @@ declare global {
       };
       meetings: {
         list: () => Promise<Meeting[]>;
+        listPage: (after?: MeetingPageCursor | null, limit?: number) => Promise<MeetingListPage>;
         get: (id: string) => Promise<Meeting | null>;
         delete: (id: string) => Promise<void>;
         search: (query: string) => Promise<Meeting[]>;
+        searchHits: (query: string, limit?: number) => Promise<MeetingSearchHit[]>;
         summarize: (id: string) => Promise<string>;
         export: (id: string, format: 'markdown' | 'pdf') => Promise<string>;
+        exportClip: (id: string, timestamp: number, durationMs?: number) => Promise<string>;
+        exportBundle: (id: string) => Promise<string>;
+        onExportProgress: (callback: (data: { meetingId: string; fraction: number }) => void) => () => void;
         saveManualNotes: (id: string, content: string) => Promise<void>;
         askNotes: (id: string, query: string) => Promise<string>;
         updateTitle: (id: string, title: string) => Promise<Meeting | null>;
@@ -264,10 +284,11 @@ declare global {
       };
       knowledge: {
         index: (path: string) => Promise<void>;
-        search: (query: string) => Promise<unknown[]>;
+        search: (query: string) => Promise<KnowledgeSearchResult[]>;
       };
       people: {
         list: () => Promise<Person[]>;
+        listPage: (after?: PeoplePageCursor | null, limit?: number) => Promise<PeopleListPage>;
         search: (query: string) => Promise<Person[]>;
         get: (email: string) => Promise<Person | null>;
         updateNotes: (email: string, notes: string) => Promise<Person | null>;
@@ -2,7 +2,6 @@
  * Audio Module Exports
  */
 
-export { useMicStream } from "./useMicStream";
 export { useSystemAudioStream, type SystemAudioSourcePreference } from "./useSystemAudioStream";
 export { PcmChunker, type PcmChunk, type ChunkCallback } from "./pcmChunker";
 export { NoiseEstimator } from "./noiseEstimator";
@@ -14,14 +14,17 @@ export interface PcmChunk {
 export type ChunkCallback = (chunk: PcmChunk) => void;
 
 export class PcmChunker {
-  private buffer: Float32Array[] = [];
-  private totalSamples: number = 0;
+  private readonly chunk: Float32Array;
+  private fill: number = 0;
   private readonly targetSampleRate: number;
   private readonly chunkDurationMs: number;
   private readonly targetSamplesPerChunk: number;
-  private chunkStartTime: number = Date.now();
   private source: "mic" | "system";
 
+  // Chunk times come from the sample counter, anchored at the first frame
+  private anchorTime: number | null = null;
+  private samplesEmitted: number = 0;
+
   constructor(
     private onChunk: ChunkCallback,
     source: "mic" | "system",
@@ -31,20 +34,33 @@ export class PcmChunker {
     this.source = source;
     this.targetSampleRate = targetSampleRate;
     this.chunkDurationMs = chunkDurationMs;
-    this.targetSamplesPerChunk = this.targetSampleRate * (this.chunkDurationMs / 1000);
+    this.targetSamplesPerChunk = Math.round(this.targetSampleRate * (this.chunkDurationMs / 1000));
+    this.chunk = new Float32Array(this.targetSamplesPerChunk);
   }
 
   /**
    * Add a frame of PCM audio data
    */
   addFrame(pcm: Float32Array, inputSampleRate: number): void {
-    const resampled = this.resamplePcm(pcm, inputSampleRate, this.targetSampleRate);
-    this.buffer.push(resampled);
-    this.totalSamples += resampled.length;
+    if (this.anchorTime === null) {
+      this.anchorTime = Date.now() - (pcm.length / inputSampleRate) * 1000;
+    }
 
-    // Emit chunks when we have enough samples
-    while (this.totalSamples >= this.targetSamplesPerChunk) {
-      this.emitChunk();
+    const resampled =
+      inputSampleRate === this.targetSampleRate
+        ? pcm
+        : this.resamplePcm(pcm, inputSampleRate, this.targetSampleRate);
+
+    // Copy straight into the chunk buffer, emitting each time it fills
+    let offset = 0;
+    while (offset < resampled.length) {
+      const count = Math.min(this.targetSamplesPerChunk - this.fill, resampled.length - offset);
+      this.chunk.set(resampled.subarray(offset, offset + count), this.fill);
+      this.fill += count;
+      offset += count;
+      if (this.fill === this.targetSamplesPerChunk) {
+        this.emitChunk();
+      }
     }
   }
 
@@ -56,10 +72,6 @@ export class PcmChunker {
     inputRate: number,
     outputRate: number
   ): Float32Array {
-    if (inputRate === outputRate) {
-      return input.slice();
-    }
-
     const ratio = inputRate / outputRate;
     const outputLength = Math.floor(input.length / ratio);
     const output = new Float32Array(outputLength);
@@ -81,44 +93,19 @@ export class PcmChunker {
   }
 
   /**
-   * Emit a chunk from the buffer
+   * Emit the filled part of the chunk buffer; consumers get their own copy
    */
   private emitChunk(): void {
-    if (this.totalSamples < this.targetSamplesPerChunk) return;
-
-    const chunkSamples = new Float32Array(this.targetSamplesPerChunk);
-    let samplesTaken = 0;
-    const newBuffer: Float32Array[] = [];
-
-    for (const frame of this.buffer) {
-      const remaining = this.targetSamplesPerChunk - samplesTaken;
-
-      if (remaining <= 0) {
-        newBuffer.push(frame);
-        continue;
-      }
-
-      if (frame.length <= remaining) {
-        chunkSamples.set(frame, samplesTaken);
-        samplesTaken += frame.length;
-      } else {
-        chunkSamples.set(frame.subarray(0, remaining), samplesTaken);
-        samplesTaken += remaining;
-        newBuffer.push(frame.subarray(remaining));
-      }
-
-      if (samplesTaken >= this.targetSamplesPerChunk) break;
-    }
+    if (this.fill === 0 || this.anchorTime === null) return;
 
-    this.buffer = newBuffer;
-    this.totalSamples -= this.targetSamplesPerChunk;
-
-    const timestampStart = this.chunkStartTime;
-    const timestampEnd = Date.now();
-    this.chunkStartTime = timestampEnd;
+    const samples = this.chunk.slice(0, this.fill);
+    const timestampStart = this.anchorTime + (this.samplesEmitted / this.targetSampleRate) * 1000;
+    this.samplesEmitted += this.fill;
+    const timestampEnd = this.anchorTime + (this.samplesEmitted / this.targetSampleRate) * 1000;
+    this.fill = 0;
 
     const chunk: PcmChunk = {
-      samples: chunkSamples,
+      samples,
       timestampStart,
       timestampEnd,
       source: this.source,
@@ -129,7 +116,7 @@ export class PcmChunker {
     console.log(
       `[pcm-chunker] Chunk emitted: ${this.source}, ` +
         `${((timestampEnd - timestampStart) / 1000).toFixed(2)}s, ` +
-        `${chunkSamples.length} samples`
+        `${samples.length} samples`
     );
   }
 
@@ -137,39 +124,17 @@ export class PcmChunker {
    * Flush remaining buffer as a partial chunk
    */
   flush(): void {
-    if (this.totalSamples === 0) return;
-
-    // Combine remaining buffer
-    const totalLength = this.buffer.reduce((acc, f) => acc + f.length, 0);
-    const samples = new Float32Array(totalLength);
-    let offset = 0;
-    for (const frame of this.buffer) {
-      samples.set(frame, offset);
-      offset += frame.length;
-    }
-
-    const timestampStart = this.chunkStartTime;
-    const timestampEnd = Date.now();
-
-    const chunk: PcmChunk = {
-      samples,
-      timestampStart,
-      timestampEnd,
-      source: this.source,
-    };
-
-    this.onChunk(chunk);
-    console.log(`[pcm-chunker] Partial chunk flushed: ${samples.length} samples`);
-
-    this.buffer = [];
-    this.totalSamples = 0;
+    if (this.fill === 0) return;
+    console.log(`[pcm-chunker] Partial chunk flushed: ${this.fill} samples`);
+    this.emitChunk();
   }
 
   /**
    * Clean up resources
    */
   destroy(): void {
-    this.buffer = [];
-    this.totalSamples = 0;
+    this.fill = 0;
+    this.anchorTime = null;
+    this.samplesEmitted = 0;
   }
 }
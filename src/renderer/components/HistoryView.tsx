@@ -1,6 +1,6 @@
 import React, { useEffect, useState, useCallback, useRef } from 'react';
 import { useAppStore } from '../stores/appStore';
-import type { Meeting } from '@shared/types';
+import type { Meeting, MeetingPageCursor } from '@shared/types';
 import { Search, Trash2, Folder, Calendar as CalendarIcon, Users, Share2, Copy, Link, Mail, MessageCircle, Send, X } from 'lucide-react';
 import { formatDuration, formatTimestamp, getSpeakerLabel, getAvatarColor, getInitials } from '../lib/formatters';
 import { MeetingListSkeleton } from './Skeleton';
@@ -26,16 +26,35 @@ export default function HistoryView() {
   const shareRef = useRef<HTMLDivElement | null>(null);
   const chatInputRef = useRef<HTMLInputElement | null>(null);
 
+  // Where the next page starts; null once the last is in, or while searching
+  const [nextPage, setNextPage] = useState<MeetingPageCursor | null>(null);
+  const loadingPage = useRef(false);
+
   const loadMeetings = useCallback(async () => {
     setIsLoading(true);
     try {
-      const meetingsList = await window.kakarot.meetings.list();
-      setMeetings(meetingsList);
+      const page = await window.kakarot.meetings.listPage();
+      setMeetings(page.meetings);
+      setNextPage(page.next);
     } finally {
       setIsLoading(false);
     }
   }, [setMeetings]);
 
+  // The next page once the list is scrolled near its end
+  const handleListScroll = useCallback(async (e: React.UIEvent<HTMLDivElement>) => {
+    const list = e.currentTarget;
+    if (!nextPage || loadingPage.current || list.scrollHeight - list.scrollTop - list.clientHeight > 200) return;
+    loadingPage.current = true;
+    try {
+      const page = await window.kakarot.meetings.listPage(nextPage);
+      setMeetings([...useAppStore.getState().meetings, ...page.meetings]);
+      setNextPage(page.next);
+    } finally {
+      loadingPage.current = false;
+    }
+  }, [nextPage, setMeetings]);
+
   const handleSendMessage = useCallback(async () => {
     if (!chatInput.trim() || isChatLoading) return;
 
@@ -78,6 +97,7 @@ export default function HistoryView() {
     if (searchQuery.trim()) {
       const results = await window.kakarot.meetings.search(searchQuery);
       setMeetings(results);
+      setNextPage(null);
     } else {
       loadMeetings();
     }
@@ -236,7 +256,7 @@ export default function HistoryView() {
         </div>
 
         {/* Meeting list */}
-        <div className="flex-1 overflow-y-auto">
+        <div className="flex-1 overflow-y-auto" onScroll={handleListScroll}>
           {isLoading ? (
             <MeetingListSkeleton count={6} />
           ) : meetings.length === 0 ? (
@@ -460,7 +480,7 @@ export default function HistoryView() {
                         }`}
                       >
                         <div className="text-xs opacity-80 mb-1">
-                          {getSpeakerLabel(segment.source)} -{' '}
+                          {getSpeakerLabel(segment.source, segment.speakerId)} -{' '}
                           {formatTimestamp(segment.timestamp)}
                         </div>
                         <p className="text-sm leading-relaxed">{segment.text}</p>
@@ -60,7 +60,7 @@ export default function LiveTranscript({ segments, currentPartials }: LiveTransc
             }`}
           >
             <div className="text-xs opacity-70 mb-1">
-              {getSpeakerLabel(segment.source)} -{' '}
+              {getSpeakerLabel(segment.source, segment.speakerId)} -{' '}
               {formatTimestamp(segment.timestamp)}
             </div>
             <p className="text-sm leading-relaxed">{segment.text}</p>
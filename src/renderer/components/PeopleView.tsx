@@ -1,6 +1,6 @@
-import React, { useEffect, useState, useCallback } from 'react';
+import React, { useEffect, useState, useCallback, useRef } from 'react';
 import { Search, Mail, Building2, Calendar, Clock, FileText, Edit2, X, Check } from 'lucide-react';
-import type { Person } from '@shared/types';
+import type { Person, PeoplePageCursor } from '@shared/types';
 import { formatDuration, getAvatarColor, getInitials, formatLastMeeting } from '../lib/formatters';
 import { PersonListSkeleton } from './Skeleton';
 
@@ -12,16 +12,35 @@ export default function PeopleView() {
   const [editingField, setEditingField] = useState<'name' | 'organization' | 'notes' | null>(null);
   const [editValue, setEditValue] = useState('');
 
+  // Where the next page starts; null once the last is in, or while searching
+  const [nextPage, setNextPage] = useState<PeoplePageCursor | null>(null);
+  const loadingPage = useRef(false);
+
   const loadPeople = useCallback(async () => {
     setIsLoading(true);
     try {
-      const peopleList = await window.kakarot.people.list();
-      setPeople(peopleList);
+      const page = await window.kakarot.people.listPage();
+      setPeople(page.people);
+      setNextPage(page.next);
     } finally {
       setIsLoading(false);
     }
   }, []);
 
+  // The next page once the list is scrolled near its end
+  const handleListScroll = useCallback(async (e: React.UIEvent<HTMLDivElement>) => {
+    const list = e.currentTarget;
+    if (!nextPage || loadingPage.current || list.scrollHeight - list.scrollTop - list.clientHeight > 200) return;
+    loadingPage.current = true;
+    try {
+      const page = await window.kakarot.people.listPage(nextPage);
+      setPeople((current) => [...current, ...page.people]);
+      setNextPage(page.next);
+    } finally {
+      loadingPage.current = false;
+    }
+  }, [nextPage]);
+
   useEffect(() => {
     loadPeople();
   }, [loadPeople]);
@@ -30,6 +49,7 @@ export default function PeopleView() {
     if (searchQuery.trim()) {
       const results = await window.kakarot.people.search(searchQuery);
       setPeople(results);
+      setNextPage(null);
     } else {
       loadPeople();
     }
@@ -110,7 +130,7 @@ export default function PeopleView() {
         </div>
 
         {/* People list */}
-        <div className="flex-1 overflow-y-auto">
+        <div className="flex-1 overflow-y-auto" onScroll={handleListScroll}>
           {isLoading ? (
             <PersonListSkeleton count={6} />
           ) : people.length === 0 ? (
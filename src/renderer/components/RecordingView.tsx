@@ -1,6 +1,5 @@
 import React from 'react';
 import { useAppStore } from '../stores/appStore';
-import { useAudioCapture } from '../hooks/useAudioCapture';
 import AudioLevelMeter from './AudioLevelMeter';
 import LiveTranscript from './LiveTranscript';
 import BentoDashboard from './bento/BentoDashboard';
@@ -27,7 +26,6 @@ type LiveCalloutEntry = {
 
 export default function RecordingView({ onSelectTab }: RecordingViewProps) {
   const { recordingState, audioLevels, liveTranscript, currentPartials, clearLiveTranscript, calendarContext, setCalendarContext, activeCalendarContext, setActiveCalendarContext, setLastCompletedNoteId, setSelectedMeeting, setView, currentMeetingId, setCurrentMeetingId, showRecordingHome, setShowRecordingHome } = useAppStore();
-  const { startCapture, stopCapture } = useAudioCapture();
   const [pillarTab, setPillarTab] = React.useState<'notes' | 'prep' | 'interact'>('notes');
   const [recordingTitle, setRecordingTitle] = React.useState<string>(''); // Title to display during recording
   const [upcomingMeetingId, setUpcomingMeetingId] = React.useState<string | null>(null); // Meeting ID for upcoming notes
@@ -258,6 +256,11 @@ export default function RecordingView({ onSelectTab }: RecordingViewProps) {
     console.log('[RecordingView] Setting up notification listener');
     const unsubscribe = window.kakarot.recording.onNotificationStartRecording?.((context) => {
       console.log('[RecordingView] Notification triggered recording start with context:', context);
+      // Detected meeting audio: an ad-hoc call, no calendar event to attach
+      if (!context?.calendarEventId) {
+        handleStartRecording();
+        return;
+      }
       // Convert notification context to CalendarEvent format
       const calendarEvent: CalendarEvent = {
         id: context.calendarEventId,
@@ -329,9 +332,8 @@ export default function RecordingView({ onSelectTab }: RecordingViewProps) {
       console.log('[RecordingView] Calendar context being sent:', calendarContextData);
       const meetingId = await window.kakarot.recording.start(calendarContextData);
       setCurrentMeetingId(meetingId);
-      console.log('[RecordingView] recording.start() completed, calling startCapture()...');
-      await startCapture();
-      console.log('[RecordingView] startCapture() completed');
+      // Both streams are captured natively in the main process
+      console.log('[RecordingView] recording.start() completed');
       setPhase('recording');
       
       // Clear the preview modal now that recording has started
@@ -345,7 +347,6 @@ export default function RecordingView({ onSelectTab }: RecordingViewProps) {
   const handleStopRecording = async () => {
     setPhase('processing');
     setErrorMessage('');
-    await stopCapture();
     const meeting = await window.kakarot.recording.stop();
     console.log('Meeting ended:', meeting);
     
@@ -899,8 +900,8 @@ export default function RecordingView({ onSelectTab }: RecordingViewProps) {
                             className="px-3 py-1.5 bg-slate-200 dark:bg-slate-700 text-slate-900 dark:text-gray-100 rounded-md text-xs"
                             onClick={async () => {
                               try {
-                                const meetingsList = await window.kakarot.meetings.list();
-                                const last = meetingsList[0];
+                                const { meetings: newest } = await window.kakarot.meetings.listPage(null, 1);
+                                const last = newest[0];
                                 if (last) {
                                   const full = await window.kakarot.meetings.get(last.id);
                                   setSelectedMeeting(full);
@@ -68,7 +68,7 @@ export default function SettingsView() {
     loadCalendars();
   }, [connectedCalendars.google]);
 
-  const handleChange = (key: keyof AppSettings, value: string | boolean) => {
+  const handleChange = (key: keyof AppSettings, value: string | boolean | string[]) => {
     if (!localSettings) return;
     setLocalSettings({ ...localSettings, [key]: value });
   };
@@ -375,6 +375,51 @@ export default function SettingsView() {
             />
           </div>
 
+          <div>
+            <label className="block text-sm text-gray-300 mb-2">Callout Keywords</label>
+            <input
+              type="text"
+              value={(localSettings.calloutKeywords ?? []).join(', ')}
+              onChange={(e) =>
+                handleChange(
+                  'calloutKeywords',
+                  e.target.value.split(',').map((keyword) => keyword.trimStart())
+                )
+              }
+              placeholder="Competitor names, pricing terms"
+              className="w-full bg-gray-800 text-white rounded-lg px-4 py-2.5 text-sm focus:outline-none focus:ring-2 focus:ring-primary-500"
+            />
+            <p className="text-xs text-gray-500 mt-1">
+              Comma-separated words and phrases that bring up a callout when someone says them
+            </p>
+          </div>
+
+          <div className="flex items-center justify-between">
+            <div>
+              <p className="text-sm text-gray-300">Spot Keywords On-Device</p>
+              <p className="text-xs text-gray-500">
+                Hears the keywords in meeting audio before the transcript arrives, so callouts come sooner
+              </p>
+            </div>
+            <ToggleSwitch
+              enabled={localSettings.keywordSpotting ?? false}
+              onChange={(enabled) => handleChange('keywordSpotting', enabled)}
+            />
+          </div>
+
+          <div className="flex items-center justify-between">
+            <div>
+              <p className="text-sm text-gray-300">Transcribe Only My Voice</p>
+              <p className="text-xs text-gray-500">
+                Keeps people talking near your mic out of your transcript; learns your voice during your first recording
+              </p>
+            </div>
+            <ToggleSwitch
+              enabled={localSettings.verifyMicSpeaker ?? false}
+              onChange={(enabled) => handleChange('verifyMicSpeaker', enabled)}
+            />
+          </div>
+
           <div className="flex items-center justify-between">
             <div>
               <p className="text-sm text-gray-300">Show Floating Callout</p>
@@ -404,12 +449,29 @@ export default function SettingsView() {
             >
               <option value="assemblyai">AssemblyAI</option>
               <option value="deepgram">Deepgram</option>
+              <option value="local">On-device (whisper)</option>
             </select>
             <p className="text-xs text-gray-500 mt-1">
               Select which transcription service to use
             </p>
           </div>
 
+          {localSettings.transcriptionProvider === 'local' && (
+            <div>
+              <label className="block text-sm text-gray-300 mb-2">Model File</label>
+              <input
+                type="text"
+                value={localSettings.localModelPath ?? ''}
+                onChange={(e) => handleChange('localModelPath', e.target.value)}
+                placeholder="models/ggml-base.en-q5_1.bin in the app data folder"
+                className="w-full bg-gray-800 text-white rounded-lg px-4 py-2.5 text-sm focus:outline-none focus:ring-2 focus:ring-primary-500"
+              />
+              <p className="text-xs text-gray-500 mt-1">
+                A ggml whisper model; quantized ones run fastest. Audio never leaves this machine.
+              </p>
+            </div>
+          )}
+
           <div>
             <label className="block text-sm text-gray-300 mb-2">Language</label>
             <select
@@ -466,6 +528,50 @@ export default function SettingsView() {
               Language availability depends on transcription provider
             </p>
           </div>
+
+          <div>
+            <label className="block text-sm text-gray-300 mb-2">Echo Cancellation</label>
+            <select
+              value={localSettings.captureEngine ?? 'aec3'}
+              onChange={(e) => handleChange('captureEngine', e.target.value)}
+              className="w-full bg-gray-800 text-white rounded-lg px-4 py-2.5 text-sm focus:outline-none focus:ring-2 focus:ring-primary-500"
+            >
+              <option value="aec3">Built-in (WebRTC AEC3)</option>
+              <option value="voiceProcessing">Apple Voice Processing (macOS)</option>
+              <option value="communications">Device Echo Cancellation (Windows)</option>
+            </select>
+            <p className="text-xs text-gray-500 mt-1">
+              Apple's runs in the system and uses less CPU, but ducks other audio while recording.
+              On Windows, the device's own canceller is used where the driver has one
+            </p>
+          </div>
+
+          <div className="flex items-center justify-between">
+            <div>
+              <p className="text-sm text-gray-300">Neural Noise Suppression</p>
+              <p className="text-xs text-gray-500">
+                Removes babble and fan noise from your mic for cleaner transcripts, at some extra CPU
+              </p>
+            </div>
+            <ToggleSwitch
+              enabled={localSettings.neuralDenoise ?? false}
+              onChange={(enabled) => handleChange('neuralDenoise', enabled)}
+            />
+          </div>
+
+          <div className="flex items-center justify-between">
+            <div>
+              <p className="text-sm text-gray-300">Isolated Audio Engine</p>
+              <p className="text-xs text-gray-500">
+                Captures in a separate process, so a busy or crashed app window never drops audio.
+                Keyword spotting and voice enrollment are off while it is on
+              </p>
+            </div>
+            <ToggleSwitch
+              enabled={localSettings.isolatedCapture ?? false}
+              onChange={(enabled) => handleChange('isolatedCapture', enabled)}
+            />
+          </div>
         </section>
 
         {/* Calendar Integrations */}
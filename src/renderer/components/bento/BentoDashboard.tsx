@@ -32,7 +32,8 @@ export default function BentoDashboard({ isRecording, hideCompactBarWhenNoEvents
 
   const loadPreviousMeetings = useCallback(async () => {
     try {
-      const meetings = await window.kakarot.meetings.list();
+      // Enough of the newest to find the last five completed among them
+      const { meetings } = await window.kakarot.meetings.listPage(null, 20);
       const completed = meetings
         .filter((m): m is CompletedMeeting => m.endedAt !== null)
         .sort((a, b) => new Date(b.createdAt).getTime() - new Date(a.createdAt).getTime())
@@ -217,7 +218,7 @@ export default function BentoDashboard({ isRecording, hideCompactBarWhenNoEvents
       title: m.title,
       start: new Date(m.createdAt),
       end: new Date(m.endedAt),
-      hasTranscript: m.transcript.length > 0,
+      hasTranscript: (m.segmentCount ?? m.transcript.length) > 0,
       isCalendarEvent: false,
     }))
     .sort((a, b) => b.start.getTime() - a.start.getTime())
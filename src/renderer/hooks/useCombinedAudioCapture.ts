@@ -6,8 +6,6 @@
 
 import { useState, useEffect, useCallback, useRef } from "react";
 import { useNativeAudioCapture } from "./useNativeAudioCapture";
-// DISABLED: Using native mic capture instead of renderer mic
-// import { useMicStream } from "@renderer/audio/useMicStream";
 import { useSystemAudioStream, type SystemAudioSourcePreference } from "@renderer/audio/useSystemAudioStream";
 import { PcmChunker, type PcmChunk } from "@renderer/audio/pcmChunker";
 import { NoiseEstimator } from "@renderer/audio/noiseEstimator";
@@ -26,6 +24,8 @@ export interface CombinedAudioCaptureOptions {
   onMicLevel?: (rms: number) => void;
   /** Callback for system audio RMS level */
   onSystemLevel?: (rms: number) => void;
+  /** Starting noise floor for silence detection, e.g. the mic's stored noise profile's */
+  initialNoiseFloor?: number;
 }
 
 export interface CombinedAudioCaptureResult {
@@ -60,6 +60,7 @@ export function useCombinedAudioCapture(
     onAudioChunk,
     onMicLevel,
     onSystemLevel,
+    initialNoiseFloor,
   } = options;
 
   const [isCapturing, setIsCapturing] = useState(false);
@@ -96,7 +97,7 @@ export function useCombinedAudioCapture(
 
   // Initialize processing pipeline
   useEffect(() => {
-    noiseEstimatorRef.current = new NoiseEstimator();
+    noiseEstimatorRef.current = new NoiseEstimator(initialNoiseFloor);
     silenceDetectorRef.current = new SilenceDetector(noiseEstimatorRef.current);
 
     const handleChunk = (chunk: PcmChunk) => {
@@ -113,7 +114,7 @@ export function useCombinedAudioCapture(
       micChunkerRef.current?.destroy();
       systemChunkerRef.current?.destroy();
     };
-  }, [targetSampleRate, chunkDurationMs]);
+  }, [targetSampleRate, chunkDurationMs, initialNoiseFloor]);
 
   // Web audio callbacks (reserved for fallback mode)
   const _handleMicPcm = useCallback((pcm: Float32Array, sampleRate: number) => {
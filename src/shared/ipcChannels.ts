@@ -16,7 +16,6 @@ export const IPC_CHANNELS = {
   AUDIO_GET_STATE: 'audio:get-state',
   AUDIO_MIC_DATA: 'audio:mic-data',
   AUDIO_LEVELS: 'audio:levels',
-  AUDIO_DATA: 'audio:data',
   AUDIO_GET_SOURCES: 'audio:getSources',
 
   // Transcription
@@ -25,9 +24,11 @@ export const IPC_CHANNELS = {
 
   // Meetings
   MEETINGS_LIST: 'meetings:list',
+  MEETINGS_LIST_PAGE: 'meetings:listPage',
   MEETINGS_GET: 'meetings:get',
   MEETINGS_DELETE: 'meetings:delete',
   MEETINGS_SEARCH: 'meetings:search',
+  MEETINGS_SEARCH_HITS: 'meetings:searchHits',
   MEETINGS_CREATE_DISMISSED: 'meetings:createDismissed',
 
   // Callout
@@ -41,6 +42,9 @@ export const IPC_CHANNELS = {
   // Post-processing
   MEETING_SUMMARIZE: 'meeting:summarize',
   MEETING_EXPORT: 'meeting:export',
+  MEETING_EXPORT_CLIP: 'meeting:exportClip',
+  MEETING_EXPORT_BUNDLE: 'meeting:exportBundle',
+  MEETING_EXPORT_PROGRESS: 'meeting:exportProgress',
   MEETING_NOTES_GENERATING: 'meeting:notesGenerating',
   MEETING_NOTES_COMPLETE: 'meeting:notesComplete',
   MEETING_NOTES_SAVE_MANUAL: 'meeting:saveManualNotes',
@@ -59,6 +63,7 @@ export const IPC_CHANNELS = {
 
   // People/Contacts
   PEOPLE_LIST: 'people:list',
+  PEOPLE_LIST_PAGE: 'people:listPage',
   PEOPLE_SEARCH: 'people:search',
   PEOPLE_GET: 'people:get',
   PEOPLE_UPDATE_NOTES: 'people:updateNotes',
@@ -38,6 +38,34 @@ export interface Meeting {
   notes: unknown | null;
   chapters: unknown[];
   people: unknown[];
+  // Native recording: the seek index of the track to play, and the epoch ms
+  // its time 0 corresponds to
+  recordingIndex?: string | null;
+  recordingStartedAt?: number | null;
+  // Set on list pages, which leave the transcript, notes and summary out
+  // until the meeting is opened with meetings.get
+  segmentCount?: number;
+}
+
+// Where the next page of a keyset-paged list starts: just past this row
+export interface MeetingPageCursor {
+  createdAt: number; // epoch ms
+  id: string;
+}
+
+export interface MeetingListPage {
+  meetings: Meeting[]; // newest first
+  next: MeetingPageCursor | null; // null on the last page
+}
+
+export interface PeoplePageCursor {
+  lastMeetingAt: number; // epoch ms
+  email: string;
+}
+
+export interface PeopleListPage {
+  people: Person[]; // most recently met first
+  next: PeoplePageCursor | null;
 }
 
 export interface TranscriptWord {
@@ -46,6 +74,10 @@ export interface TranscriptWord {
   isFinal: boolean;
   start: number; // ms
   end: number; // ms
+  // Set by forced alignment against the recording: where the word is in its
+  // track, in samples at the track's rate
+  startSample?: number;
+  endSample?: number;
 }
 
 export interface TranscriptSegment {
@@ -59,6 +91,29 @@ export interface TranscriptSegment {
   speakerId?: string; // for future diarization
 }
 
+// Matched text with the [start, end) character ranges of the query's terms
+export interface SearchSnippet {
+  text: string;
+  highlights: Array<[number, number]>;
+}
+
+// One meeting from a full-text search, best first
+export interface MeetingSearchHit {
+  meetingId: string;
+  title: SearchSnippet;
+  createdAt: Date;
+  score: number; // higher is better
+  snippets: Array<SearchSnippet & { segmentId: string; timestamp: number }>;
+}
+
+// One knowledge-base chunk from a semantic search, best first
+export interface KnowledgeSearchResult {
+  id: string;
+  path: string; // relative to the knowledge-base folder
+  text: string;
+  score: number; // cosine similarity
+}
+
 export interface Callout {
   id: string;
   meetingId: string;
@@ -78,6 +133,53 @@ export interface CalloutSource {
   filePath?: string;
 }
 
+/**
+ * A meeting's native pipeline health, from the capture addon's metrics.
+ * Counters are what they rose by over the meeting, rates and gauges their
+ * mean, worst cases their peak and latency percentiles as of the end.
+ */
+export interface PerformanceReport {
+  durationMs: number;
+  intervalMs: number;
+  samples: number;
+  /** By readMetrics() name, e.g. 'mic.buffersDropped', 'aec.delayMedianMs' */
+  metrics: Record<string, number>;
+  /** min, mean and max per bucketMs; null (NaN before it is stored) where nothing was measured */
+  series: Record<string, PerformanceSeries>;
+}
+
+export interface PerformanceSeries {
+  bucketMs: number;
+  min: (number | null)[];
+  mean: (number | null)[];
+  max: (number | null)[];
+}
+
+/** A PerformanceReport as stored with its meeting */
+export interface MeetingPerformance {
+  meetingId: string;
+  appVersion: string;
+  platform: string;
+  recordedAt: Date;
+  report: PerformanceReport;
+}
+
+/** One app version's reports, metric by metric */
+export interface PerformanceVersionStats {
+  appVersion: string;
+  meetings: number;
+  metrics: Record<string, { mean: number; max: number; meetings: number }>;
+}
+
+export interface PerformanceRegression {
+  metric: string;
+  /** Means over each version's meetings */
+  baseline: number;
+  candidate: number;
+  /** How much worse the candidate is, relative to the baseline; Infinity from a baseline of 0 */
+  change: number;
+}
+
 // Recording state
 export type RecordingState = 'idle' | 'recording' | 'paused' | 'processing';
 
@@ -113,7 +215,7 @@ export interface CalendarConnections {
   icloud?: ICloudCredentials;
 }
 
-export type TranscriptionProvider = 'assemblyai' | 'deepgram';
+export type TranscriptionProvider = 'assemblyai' | 'deepgram' | 'local';
 
 export type CRMProvider = 'salesforce' | 'hubspot';
 export type CRMNotesBehavior = 'always' | 'ask';
@@ -146,9 +248,25 @@ export interface AppSettings {
   openAiModel: string;
   knowledgeBasePath: string;
   autoDetectQuestions: boolean;
+  // Words and phrases (competitors, pricing terms) that bring up a callout when heard
+  calloutKeywords?: string[];
+  // Spot those keywords in the system audio on-device, ahead of the transcript
+  keywordSpotting?: boolean;
+  // Hold mic speech that is not the user's voice (enrolled during the first recording) from transcription
+  verifyMicSpeaker?: boolean;
   showFloatingCallout: boolean;
   transcriptionLanguage: string;
   transcriptionProvider: TranscriptionProvider;
+  // On-device model for the 'local' provider; empty = the default model in userData
+  localModelPath?: string;
+  // Mic echo cancellation: the addon's AEC3, Apple's VoiceProcessingIO (macOS),
+  // or the endpoint's own AEC in communications mode (Windows; AEC3 where it has none)
+  captureEngine?: 'aec3' | 'voiceProcessing' | 'communications';
+  // Run the mic through the neural denoiser: cleaner input for more CPU
+  neuralDenoise?: boolean;
+  // Capture in the audio engine process, out of reach of main-process stalls
+  // and crashes; keyword spotting, voice enrollment and native meters stay in-process only
+  isolatedCapture?: boolean;
   // Hosted token support
   useHostedTokens: boolean;
   authApiBaseUrl: string;
@@ -19,8 +19,10 @@ export function formatDateTime(date: Date): string {
   return date.toLocaleString();
 }
 
-export function getSpeakerLabel(source: 'mic' | 'system'): string {
-  return source === 'mic' ? 'You' : 'Other';
+// System audio splits by local speaker ID once one is known ("Other 2")
+export function getSpeakerLabel(source: 'mic' | 'system', speakerId?: string): string {
+  if (source === 'mic') return 'You';
+  return speakerId ? `Other ${speakerId}` : 'Other';
 }
 
 export function formatDateShort(date: Date): string {
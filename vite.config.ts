@@ -45,6 +45,21 @@ export default defineConfig({
           options.startup();
         },
       },
+      {
+        // Audio engine utilityProcess (AudioEngineHost), beside the main bundle
+        entry: resolve(__dirname, 'src/main/audio/engine/audioEngine.ts'),
+        vite: {
+          resolve: { alias: sharedAlias },
+          build: {
+            outDir: resolve(__dirname, 'dist/main'),
+            rollupOptions: {
+              external: ['electron', 'bindings'],
+            },
+          },
+        },
+        // AudioEngineHost forks it on demand; a restart of the main entry picks up a rebuild
+        onstart() {},
+      },
       {
         entry: resolve(__dirname, 'src/preload/index.ts'),
         vite: {